@@ -0,0 +1,732 @@
+/**
+ * @file bench_parking.c
+ * @brief 数据层与服务层的微基准测试程序
+ * @details
+ * 依次在 1k/10k/100k/1M 个车位的停车场上测量核心操作的耗时与内存分配次数：
+ * 按编号查找、按车牌查找、入场/出场循环、空闲车位列表、按停车时长列表、
+ * 已占用访客车位的列扫描计数、文本格式与二进制快照的保存与加载。
+ * 每个停车场一半车位有车，车牌均为标准号牌。
+ *
+ * 结果以每行一个 JSON 对象的形式写到标准输出，便于脚本比较两次运行：
+ * `{"benchmark":"find_slot_by_id","slots":1000,"iterations":200000,
+ *   "ns_per_op":31.4,"allocs_per_op":0.000}`。
+ * 进度信息写到标准错误，不影响结果解析。
+ *
+ * 分配次数通过链接器的 --wrap 选项包装 malloc/calloc/realloc 统计，
+ * 由 CMake 在支持的平台上定义 BENCH_COUNT_ALLOCS；
+ * 不支持的平台上 allocs_per_op 输出为 null。
+ *
+ * 给出 `--baseline` 时，每项结果与基线文件（格式与输出相同，可由一次运行的
+ * 输出直接生成）中同名同规模的记录比较：耗时超过基线的 `--tolerance` 倍，
+ * 或每次操作的分配次数明显多于基线，即判为性能回归，程序以 2 退出。
+ * CTest 以带 perf 标签的 Perf 配置注册这些预算测试，`ctest -C Perf -L perf`
+ * 单独运行，日常的 `ctest` 不受机器快慢影响。
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/parking_data.h"
+#include "../src/parking_query.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define BENCH_LOOKUP_ITERATIONS 200000L /**< 查找类操作的迭代次数。 */
+#define BENCH_CYCLE_ITERATIONS 100000L  /**< 入场/出场循环的迭代次数。 */
+#define BENCH_SCAN_BUDGET 20000000L     /**< 全量扫描类操作的总访问车位数。 */
+#define BENCH_FILE_BUDGET 1000000L      /**< 保存/加载类操作的总读写车位数。 */
+#define BENCH_KEY_COUNT 4096            /**< 预先生成的随机查找键个数。 */
+#define BENCH_MAX_SIZES 16              /**< --sizes 最多接受的规模个数。 */
+#define BENCH_ENTRY_WINDOW 25200L       /**< 构造数据时入场时间的分布跨度（秒）。 */
+#define BENCH_MAX_BASELINE 256          /**< 基线文件最多读取的记录数。 */
+#define BENCH_DEFAULT_TOLERANCE 3.0     /**< 默认允许的耗时倍数。 */
+#define BENCH_ALLOC_SLACK 0.1           /**< 每次操作分配次数允许多出的余量。 */
+#define BENCH_DATA_FILE "bench_parking_data.txt" /**< 保存/加载使用的临时文件。 */
+#define BENCH_SNAPSHOT_FILE "bench_parking_data.bin" /**< 快照使用的临时文件。 */
+
+/* ========================================================================== */
+/*                                   分配计数                                 */
+/* ========================================================================== */
+
+static unsigned long bench_alloc_count = 0; /**< 累计的内存分配次数。 */
+
+#ifdef BENCH_COUNT_ALLOCS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t count, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+
+/**
+ * @brief 链接器包装的 malloc：计数后转发给真正的实现。
+ * @param size 请求的字节数。
+ * @return 分配得到的内存。
+ */
+void *__wrap_malloc(size_t size) {
+  bench_alloc_count++;
+  return __real_malloc(size);
+}
+
+/**
+ * @brief 链接器包装的 calloc：计数后转发给真正的实现。
+ * @param count 元素个数。
+ * @param size 每个元素的字节数。
+ * @return 分配得到的内存。
+ */
+void *__wrap_calloc(size_t count, size_t size) {
+  bench_alloc_count++;
+  return __real_calloc(count, size);
+}
+
+/**
+ * @brief 链接器包装的 realloc：计数后转发给真正的实现。
+ * @param ptr 原内存块。
+ * @param size 新的字节数。
+ * @return 调整后的内存。
+ */
+void *__wrap_realloc(void *ptr, size_t size) {
+  bench_alloc_count++;
+  return __real_realloc(ptr, size);
+}
+#endif
+
+/* ========================================================================== */
+/*                                   计时                                     */
+/* ========================================================================== */
+
+/**
+ * @brief 一项基准测试的累计测量值。
+ */
+typedef struct BenchMeasure {
+  double elapsed_ns;          /**< 计时区间内累计的纳秒数。 */
+  unsigned long allocs;       /**< 计时区间内累计的分配次数。 */
+  long operations;            /**< 累计的操作次数。 */
+  double started_ns;          /**< 当前计时区间的起点。 */
+  unsigned long started_allocs; /**< 当前计时区间开始时的分配计数。 */
+} BenchMeasure;
+
+/**
+ * @brief (静态辅助函数) 读取单调时钟。
+ * @return 当前时刻（纳秒）。
+ */
+static double bench_now_ns(void) {
+#ifdef _WIN32
+  LARGE_INTEGER counter;
+  LARGE_INTEGER frequency;
+
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 开始一个计时区间。
+ * @param m 目标测量值。
+ */
+static void bench_begin(BenchMeasure *m) {
+  m->started_allocs = bench_alloc_count;
+  m->started_ns = bench_now_ns();
+}
+
+/**
+ * @brief (静态辅助函数) 结束计时区间并累计。
+ * @param m 目标测量值。
+ * @param operations 本区间内完成的操作次数。
+ */
+static void bench_end(BenchMeasure *m, long operations) {
+  double now = bench_now_ns();
+
+  m->elapsed_ns += now - m->started_ns;
+  m->allocs += bench_alloc_count - m->started_allocs;
+  m->operations += operations;
+}
+
+/* ========================================================================== */
+/*                                   基线比较                                 */
+/* ========================================================================== */
+
+/**
+ * @brief 基线文件中的一条记录。
+ */
+typedef struct BenchBaseline {
+  char name[64];        /**< 基准测试名。 */
+  int slots;            /**< 停车场规模。 */
+  double ns_per_op;     /**< 基线耗时（纳秒/次）。 */
+  double allocs_per_op; /**< 基线分配次数，小于 0 表示基线中没有。 */
+} BenchBaseline;
+
+/**
+ * @brief 命令行选项与基线比较的状态。
+ */
+typedef struct BenchOptions {
+  const char *only;   /**< 逗号分隔的基准测试名，NULL 表示全部运行。 */
+  double tolerance;   /**< 允许的耗时倍数。 */
+  BenchBaseline baseline[BENCH_MAX_BASELINE]; /**< 基线记录。 */
+  int baseline_count; /**< 基线记录数，0 表示不比较。 */
+  int regressions;    /**< 已发现的回归项数。 */
+} BenchOptions;
+
+static BenchOptions bench_options; /**< 全局选项，main 中初始化。 */
+
+/**
+ * @brief (静态辅助函数) 读取基线文件。
+ * @details 每行一个 bench_report 输出的 JSON 对象，无法解析的行被跳过。
+ * @param path 基线文件路径。
+ * @return 成功返回读到的记录数，文件无法打开或没有记录返回 0。
+ */
+static int bench_load_baseline(const char *path) {
+  FILE *file = fopen(path, "r");
+  char line[512];
+  int count = 0;
+
+  if (file == NULL) {
+    return 0;
+  }
+  while (count < BENCH_MAX_BASELINE && fgets(line, sizeof(line), file)) {
+    BenchBaseline *entry = &bench_options.baseline[count];
+    long iterations;
+    int fields = sscanf(line,
+                        "{\"benchmark\":\"%63[^\"]\",\"slots\":%d,"
+                        "\"iterations\":%ld,\"ns_per_op\":%lf,"
+                        "\"allocs_per_op\":%lf",
+                        entry->name, &entry->slots, &iterations,
+                        &entry->ns_per_op, &entry->allocs_per_op);
+
+    if (fields >= 4) {
+      if (fields == 4) {
+        entry->allocs_per_op = -1.0; /* 基线中为 null */
+      }
+      count++;
+    }
+  }
+  fclose(file);
+  bench_options.baseline_count = count;
+  return count;
+}
+
+/**
+ * @brief (静态辅助函数) 与基线比较一项结果，回归时写到标准错误并计数。
+ * @param name 基准测试名。
+ * @param slots 停车场规模。
+ * @param ns_per_op 本次耗时（纳秒/次）。
+ * @param allocs_per_op 本次分配次数，小于 0 表示未统计。
+ */
+static void bench_check(const char *name, int slots, double ns_per_op,
+                        double allocs_per_op) {
+  int i;
+
+  for (i = 0; i < bench_options.baseline_count; i++) {
+    const BenchBaseline *entry = &bench_options.baseline[i];
+    double limit = entry->ns_per_op * bench_options.tolerance;
+
+    if (entry->slots != slots || strcmp(entry->name, name) != 0) {
+      continue;
+    }
+    if (ns_per_op > limit) {
+      fprintf(stderr, "性能回归: %s (%d 个车位) %.1f ns/op，"
+              "基线 %.1f ns/op，上限 %.1f ns/op\n",
+              name, slots, ns_per_op, entry->ns_per_op, limit);
+      bench_options.regressions++;
+    }
+    if (allocs_per_op >= 0.0 && entry->allocs_per_op >= 0.0 &&
+        allocs_per_op > entry->allocs_per_op * 2.0 + BENCH_ALLOC_SLACK) {
+      fprintf(stderr, "分配回归: %s (%d 个车位) %.3f 次/op，基线 %.3f 次/op\n",
+              name, slots, allocs_per_op, entry->allocs_per_op);
+      bench_options.regressions++;
+    }
+    return;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 判断某项基准测试是否在 --only 列表中。
+ * @param name 基准测试名。
+ * @return 需要运行返回 1，否则返回 0。
+ */
+static int bench_selected(const char *name) {
+  const char *p = bench_options.only;
+  size_t length = strlen(name);
+
+  if (p == NULL) {
+    return 1;
+  }
+  while (*p != '\0') {
+    const char *end = strchr(p, ',');
+    size_t item = end != NULL ? (size_t)(end - p) : strlen(p);
+
+    if (item == length && strncmp(p, name, length) == 0) {
+      return 1;
+    }
+    if (end == NULL) {
+      break;
+    }
+    p = end + 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 以一行 JSON 输出测量结果，并与基线比较。
+ * @param name 基准测试名。
+ * @param slots 停车场规模。
+ * @param m 测量值。
+ */
+static void bench_report(const char *name, int slots, const BenchMeasure *m) {
+  double ops = m->operations > 0 ? (double)m->operations : 1.0;
+  double allocs = -1.0;
+
+  printf("{\"benchmark\":\"%s\",\"slots\":%d,\"iterations\":%ld,"
+         "\"ns_per_op\":%.1f,\"allocs_per_op\":",
+         name, slots, m->operations, m->elapsed_ns / ops);
+#ifdef BENCH_COUNT_ALLOCS
+  allocs = (double)m->allocs / ops;
+  printf("%.3f}\n", allocs);
+#else
+  printf("null}\n");
+#endif
+  fflush(stdout);
+  bench_check(name, slots, m->elapsed_ns / ops, allocs);
+}
+
+/**
+ * @brief (静态辅助函数) 按总工作量计算迭代次数。
+ * @param budget 总工作量（访问的车位数）。
+ * @param slots 每次操作访问的车位数。
+ * @param min_iter 最少迭代次数。
+ * @param max_iter 最多迭代次数。
+ * @return 迭代次数。
+ */
+static long bench_iterations(long budget, int slots, long min_iter,
+                             long max_iter) {
+  long iterations = budget / (slots > 0 ? slots : 1);
+
+  if (iterations < min_iter) {
+    return min_iter;
+  }
+  return iterations > max_iter ? max_iter : iterations;
+}
+
+/* ========================================================================== */
+/*                                   测试数据                                 */
+/* ========================================================================== */
+
+/**
+ * @brief 一次规模下的测试上下文。
+ */
+typedef struct BenchContext {
+  ParkingLot *lot;                 /**< 被测停车场。 */
+  int slots;                       /**< 车位数。 */
+  int ids[BENCH_KEY_COUNT];        /**< 随机的车位编号（全部车位）。 */
+  int free_ids[BENCH_KEY_COUNT];   /**< 随机的空闲车位编号。 */
+  char plates[BENCH_KEY_COUNT][MAX_LICENSE_LEN]; /**< 随机的在场车牌。 */
+  unsigned long rng;               /**< 伪随机数状态。 */
+} BenchContext;
+
+/**
+ * @brief (静态辅助函数) 线性同余伪随机数，结果与平台的 rand() 无关。
+ * @param state 生成器状态。
+ * @param bound 上界（不含），必须为正。
+ * @return [0, bound) 内的整数。
+ */
+static int bench_random(unsigned long *state, int bound) {
+  *state = (*state * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+  return (int)((*state >> 8) % (unsigned long)bound);
+}
+
+/**
+ * @brief (静态辅助函数) 生成第 index 辆车的车牌（京A + 6 位数字）。
+ * @param index 车辆序号，小于 1000000。
+ * @param[out] plate 接收车牌的缓冲区，至少 MAX_LICENSE_LEN 字节。
+ */
+static void bench_plate(int index, char *plate) {
+  sprintf(plate, "京A%06d", index % 1000000);
+}
+
+/**
+ * @brief (静态辅助函数) 构造规模为 slots 的停车场：偶数编号车位有车。
+ * @details 停车场使用虚拟时钟，车辆按编号顺序在某日 10:00 起的
+ *          BENCH_ENTRY_WINDOW 秒内均匀入场，保证访客全部在允许时段内入场；
+ *          入场时间随编号单调不减，与真实停车场按时间先后入场的情形一致。
+ * @param ctx 测试上下文，成功后 ctx->lot 指向新停车场。
+ * @param slots 车位数。
+ * @return 成功返回 1，失败返回 0。
+ */
+static int bench_setup(BenchContext *ctx, int slots) {
+  char location[32];
+  char owner[32];
+  char contact[32];
+  char plate[MAX_LICENSE_LEN];
+  struct tm morning;
+  time_t opening;
+  int id;
+  int i;
+
+  ctx->slots = slots;
+  ctx->rng = 20240601UL;
+  ctx->lot = init_parking_lot(slots);
+  if (!ctx->lot) {
+    return 0;
+  }
+  memset(&morning, 0, sizeof(morning));
+  morning.tm_year = 2024 - 1900;
+  morning.tm_mon = 5;
+  morning.tm_mday = 1;
+  morning.tm_hour = 10;
+  morning.tm_isdst = -1;
+  opening = mktime(&morning);
+  configure_parking_clock(ctx->lot, PARKING_CLOCK_VIRTUAL, opening);
+  for (id = 1; id <= slots; id++) {
+    sprintf(location, "%c区-%d层", 'A' + (id - 1) / 1000 % 26,
+            (id - 1) / 100 % 10 + 1);
+    if (create_and_add_slot(ctx->lot, id, location) != 0) {
+      return 0;
+    }
+  }
+  for (id = 2; id <= slots; id += 2) {
+    set_parking_clock(ctx->lot,
+                      opening + (time_t)((double)id / (slots + 1) *
+                                         BENCH_ENTRY_WINDOW));
+    bench_plate(id, plate);
+    sprintf(owner, "车主%d", id);
+    sprintf(contact, "138%08d", id);
+    if (allocate_slot(ctx->lot, id, owner, plate, contact,
+                      id % 4 == 0 ? RESIDENT_TYPE : VISITOR_TYPE) != 0) {
+      return 0;
+    }
+  }
+
+  for (i = 0; i < BENCH_KEY_COUNT; i++) {
+    int occupied = slots >= 2 ? 2 * (bench_random(&ctx->rng, slots / 2) + 1)
+                              : 1;
+    ctx->ids[i] = bench_random(&ctx->rng, slots) + 1;
+    ctx->free_ids[i] = 2 * bench_random(&ctx->rng, (slots + 1) / 2) + 1;
+    bench_plate(occupied, ctx->plates[i]);
+  }
+  return 1;
+}
+
+/* ========================================================================== */
+/*                                   基准测试                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 测量 find_slot_by_id。
+ * @param ctx 测试上下文。
+ */
+static void bench_find_by_id(BenchContext *ctx) {
+  BenchMeasure m;
+  long found = 0;
+  long i;
+
+  memset(&m, 0, sizeof(m));
+  bench_begin(&m);
+  for (i = 0; i < BENCH_LOOKUP_ITERATIONS; i++) {
+    found += find_slot_by_id(ctx->lot, ctx->ids[i % BENCH_KEY_COUNT]) != NULL;
+  }
+  bench_end(&m, BENCH_LOOKUP_ITERATIONS);
+  if (found != BENCH_LOOKUP_ITERATIONS) {
+    fprintf(stderr, "find_slot_by_id: 只找到 %ld 次\n", found);
+  }
+  bench_report("find_slot_by_id", ctx->slots, &m);
+}
+
+/**
+ * @brief (静态辅助函数) 测量 find_slot_by_license。
+ * @param ctx 测试上下文。
+ */
+static void bench_find_by_license(BenchContext *ctx) {
+  BenchMeasure m;
+  long found = 0;
+  long i;
+
+  memset(&m, 0, sizeof(m));
+  bench_begin(&m);
+  for (i = 0; i < BENCH_LOOKUP_ITERATIONS; i++) {
+    found += find_slot_by_license(ctx->lot,
+                                  ctx->plates[i % BENCH_KEY_COUNT]) != NULL;
+  }
+  bench_end(&m, BENCH_LOOKUP_ITERATIONS);
+  if (found != BENCH_LOOKUP_ITERATIONS) {
+    fprintf(stderr, "find_slot_by_license: 只找到 %ld 次\n", found);
+  }
+  bench_report("find_slot_by_license", ctx->slots, &m);
+}
+
+/**
+ * @brief (静态辅助函数) 测量一次 allocate_slot + deallocate_slot 循环。
+ * @param ctx 测试上下文。
+ */
+static void bench_allocate_cycle(BenchContext *ctx) {
+  BenchMeasure m;
+  long failures = 0;
+  long i;
+
+  memset(&m, 0, sizeof(m));
+  bench_begin(&m);
+  for (i = 0; i < BENCH_CYCLE_ITERATIONS; i++) {
+    int id = ctx->free_ids[i % BENCH_KEY_COUNT];
+    if (allocate_slot(ctx->lot, id, "基准车主", "沪B12345", "13900000000",
+                      VISITOR_TYPE) != 0 ||
+        deallocate_slot(ctx->lot, id) != 0) {
+      failures++;
+    }
+  }
+  bench_end(&m, BENCH_CYCLE_ITERATIONS);
+  if (failures) {
+    fprintf(stderr, "allocate/deallocate: 失败 %ld 次\n", failures);
+  }
+  bench_report("allocate_deallocate_cycle", ctx->slots, &m);
+}
+
+/**
+ * @brief (静态辅助函数) 测量返回数组的列表查询。
+ * @param ctx 测试上下文。
+ * @param name 基准测试名。
+ * @param by_duration 非 0 时测量 get_slots_by_duration，否则测量 get_free_slots。
+ */
+static void bench_list(BenchContext *ctx, const char *name, int by_duration) {
+  BenchMeasure m;
+  long iterations =
+      bench_iterations(BENCH_SCAN_BUDGET, ctx->slots, 3, 10000);
+  long i;
+
+  memset(&m, 0, sizeof(m));
+  for (i = 0; i < iterations; i++) {
+    ParkingSlot **list;
+    int count = 0;
+
+    bench_begin(&m);
+    list = by_duration ? get_slots_by_duration(ctx->lot, &count, 1)
+                       : get_free_slots(ctx->lot, &count);
+    bench_end(&m, 1);
+    free(list);
+  }
+  bench_report(name, ctx->slots, &m);
+}
+
+/**
+ * @brief (静态辅助函数) 测量已占用访客车位的组合条件计数。
+ * @details 状态取自空闲位图，类型列用向量内核比较，不访问车位节点。
+ * @param ctx 测试上下文。
+ */
+static void bench_count_query(BenchContext *ctx) {
+  BenchMeasure m;
+  SlotQuery query;
+  long iterations =
+      bench_iterations(BENCH_SCAN_BUDGET, ctx->slots, 3, 100000);
+  long i;
+
+  slot_query_init(&query);
+  slot_query_where_status(&query, OCCUPIED_STATUS);
+  slot_query_where_type(&query, VISITOR_TYPE);
+  memset(&m, 0, sizeof(m));
+  for (i = 0; i < iterations; i++) {
+    bench_begin(&m);
+    if (count_query_slots(ctx->lot, &query) < 0) {
+      break;
+    }
+    bench_end(&m, 1);
+  }
+  bench_report("count_occupied_visitors", ctx->slots, &m);
+}
+
+/**
+ * @brief (静态辅助函数) 测量 save_parking_data 与 load_parking_data。
+ * @param ctx 测试上下文。
+ */
+static void bench_persistence(BenchContext *ctx) {
+  BenchMeasure save;
+  BenchMeasure load;
+  long iterations = bench_iterations(BENCH_FILE_BUDGET, ctx->slots, 1, 50);
+  long i;
+
+  memset(&save, 0, sizeof(save));
+  memset(&load, 0, sizeof(load));
+  for (i = 0; i < iterations; i++) {
+    ParkingLot *loaded;
+
+    bench_begin(&save);
+    if (save_parking_data(ctx->lot, BENCH_DATA_FILE) != 0) {
+      fprintf(stderr, "save_parking_data 失败\n");
+      break;
+    }
+    bench_end(&save, 1);
+
+    bench_begin(&load);
+    loaded = load_parking_data(BENCH_DATA_FILE);
+    bench_end(&load, 1);
+    if (!loaded) {
+      fprintf(stderr, "load_parking_data 失败\n");
+      break;
+    }
+    free_parking_lot(loaded);
+  }
+  remove(BENCH_DATA_FILE);
+  bench_report("save_parking_data", ctx->slots, &save);
+  bench_report("load_parking_data", ctx->slots, &load);
+}
+
+/**
+ * @brief (静态辅助函数) 测量 save_parking_snapshot 与 load_parking_data（快照）。
+ * @param ctx 测试上下文。
+ */
+static void bench_snapshot(BenchContext *ctx) {
+  BenchMeasure save;
+  BenchMeasure load;
+  long iterations = bench_iterations(BENCH_FILE_BUDGET, ctx->slots, 1, 50);
+  long i;
+
+  memset(&save, 0, sizeof(save));
+  memset(&load, 0, sizeof(load));
+  for (i = 0; i < iterations; i++) {
+    ParkingLot *loaded;
+
+    bench_begin(&save);
+    if (save_parking_snapshot(ctx->lot, BENCH_SNAPSHOT_FILE) != 0) {
+      fprintf(stderr, "save_parking_snapshot 失败\n");
+      break;
+    }
+    bench_end(&save, 1);
+
+    bench_begin(&load);
+    loaded = load_parking_data(BENCH_SNAPSHOT_FILE);
+    bench_end(&load, 1);
+    if (!loaded) {
+      fprintf(stderr, "快照加载失败\n");
+      break;
+    }
+    free_parking_lot(loaded);
+  }
+  remove(BENCH_SNAPSHOT_FILE);
+  bench_report("save_parking_snapshot", ctx->slots, &save);
+  bench_report("load_parking_snapshot", ctx->slots, &load);
+}
+
+/* ========================================================================== */
+/*                                   主程序                                   */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 解析逗号分隔的规模列表。
+ * @param text 形如 "1000,10000" 的字符串。
+ * @param[out] sizes 接收规模的数组，至少 BENCH_MAX_SIZES 个元素。
+ * @return 解析出的规模个数；格式错误返回 0。
+ */
+static int parse_sizes(const char *text, int *sizes) {
+  int count = 0;
+
+  while (*text != '\0' && count < BENCH_MAX_SIZES) {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value <= 0 || value > 1000000L ||
+        (*end != ',' && *end != '\0')) {
+      return 0;
+    }
+    sizes[count++] = (int)value;
+    text = *end == ',' ? end + 1 : end;
+  }
+  return count;
+}
+
+/**
+ * @brief 主函数，依次运行各规模下的全部基准测试。
+ * @details 用法：`bench_parking [--sizes 1000,10000,...] [--only 名称,...]
+ *          [--baseline 文件] [--tolerance 倍数]`，
+ *          默认规模为 1000、10000、100000、1000000，默认运行全部基准测试。
+ * @param argc 参数个数。
+ * @param argv 参数数组。
+ * @return 全部规模运行完成返回 0，参数错误或构造失败返回 1，
+ *         与基线相比出现回归返回 2。
+ */
+int main(int argc, char **argv) {
+  static BenchContext ctx;
+  int sizes[BENCH_MAX_SIZES] = {1000, 10000, 100000, 1000000};
+  int size_count = 4;
+  int i;
+
+  bench_options.tolerance = BENCH_DEFAULT_TOLERANCE;
+  for (i = 1; i + 1 < argc && size_count > 0; i += 2) {
+    if (strcmp(argv[i], "--sizes") == 0) {
+      size_count = parse_sizes(argv[i + 1], sizes);
+    } else if (strcmp(argv[i], "--only") == 0) {
+      bench_options.only = argv[i + 1];
+    } else if (strcmp(argv[i], "--baseline") == 0) {
+      if (bench_load_baseline(argv[i + 1]) == 0) {
+        fprintf(stderr, "无法读取基线文件 %s\n", argv[i + 1]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--tolerance") == 0) {
+      bench_options.tolerance = atof(argv[i + 1]);
+      if (bench_options.tolerance < 1.0) {
+        size_count = 0;
+      }
+    } else {
+      size_count = 0;
+    }
+  }
+  if (i != argc) {
+    size_count = 0;
+  }
+  if (size_count == 0) {
+    fprintf(stderr,
+            "用法: %s [--sizes 1000,10000,...] [--only 名称,...] "
+            "[--baseline 文件] [--tolerance 倍数]\n",
+            argv[0]);
+    return 1;
+  }
+
+  for (i = 0; i < size_count; i++) {
+    fprintf(stderr, "构造 %d 个车位的停车场...\n", sizes[i]);
+    if (!bench_setup(&ctx, sizes[i])) {
+      fprintf(stderr, "停车场构造失败\n");
+      free_parking_lot(ctx.lot);
+      return 1;
+    }
+    if (bench_selected("find_slot_by_id")) {
+      bench_find_by_id(&ctx);
+    }
+    if (bench_selected("find_slot_by_license")) {
+      bench_find_by_license(&ctx);
+    }
+    if (bench_selected("allocate_deallocate_cycle")) {
+      bench_allocate_cycle(&ctx);
+    }
+    if (bench_selected("get_free_slots")) {
+      bench_list(&ctx, "get_free_slots", 0);
+    }
+    if (bench_selected("get_slots_by_duration")) {
+      bench_list(&ctx, "get_slots_by_duration", 1);
+    }
+    if (bench_selected("count_occupied_visitors")) {
+      bench_count_query(&ctx);
+    }
+    if (bench_selected("save_parking_data") ||
+        bench_selected("load_parking_data")) {
+      bench_persistence(&ctx);
+    }
+    if (bench_selected("save_parking_snapshot") ||
+        bench_selected("load_parking_snapshot")) {
+      bench_snapshot(&ctx);
+    }
+    free_parking_lot(ctx.lot);
+    ctx.lot = NULL;
+  }
+  if (bench_options.regressions > 0) {
+    fprintf(stderr, "%d 项结果超出基线预算\n", bench_options.regressions);
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,748 @@
+/**
+ * @file load_parking.c
+ * @brief 大规模停车场生成器与多线程负载测试程序
+ * @details
+ * 按给定规模生成停车场：车位分布在多栋楼、多层、多个分区中，
+ * 位置描述形如 "2号楼-B1层-C区-017"；按给定比例预先停入居民与访客车辆。
+ * 随后启动若干工作线程，按配置的比例混合执行四类操作：
+ * - entry：自动选位入场（parking_service_fast_allocate_any_slot）；
+ * - exit：按车牌查找后出场计费（find_slot_by_license + deallocate_slot）；
+ * - lookup：按车牌或车位编号查找；
+ * - stats：读取统计信息。
+ * 每个线程只让自己停入的车辆出场，线程之间不会争抢同一辆车，
+ * 但所有线程共享同一个停车场与同一把读写锁。
+ *
+ * 每次操作的耗时记入线程私有的对数线性直方图（每个 2 的幂区间 16 个子桶，
+ * 相对误差不超过 6.25%），结束后合并，按操作类型输出次数、失败次数、
+ * 吞吐量与 p50/p99/p999 延迟。
+ *
+ * 停车场使用固定在某日 10:00 的虚拟时钟，访客入场规则在任何时刻运行都成立。
+ * 报告末尾按类别列出停车场的内存占用与每车位的平均字节数。
+ * 指定 --metrics-port 时，负载运行期间在该端口提供 OpenMetrics /metrics 端点。
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/parking_service.h"
+#include "../src/parking_thread.h"
+#ifdef PARKING_EXPORTER
+#include "../src/parking_exporter.h"
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define LOAD_MAX_THREADS 64       /**< 最多的工作线程数。 */
+#define LOAD_SUB_BUCKET_BITS 4    /**< 每个 2 的幂区间细分的位数。 */
+#define LOAD_SUB_BUCKETS (1 << LOAD_SUB_BUCKET_BITS) /**< 每个区间的子桶数。 */
+#define LOAD_BUCKETS (40 * LOAD_SUB_BUCKETS) /**< 直方图桶数，覆盖约 2^40 纳秒。 */
+#define LOAD_CONTACT "13800000000" /**< 生成车辆使用的联系方式。 */
+
+/**
+ * @brief 负载中的操作类型。
+ */
+typedef enum {
+  LOAD_OP_ENTRY = 0,  /**< 车辆入场。 */
+  LOAD_OP_EXIT = 1,   /**< 车辆出场。 */
+  LOAD_OP_LOOKUP = 2, /**< 查找车位。 */
+  LOAD_OP_STATS = 3,  /**< 读取统计。 */
+  LOAD_OP_COUNT = 4   /**< 操作类型数。 */
+} LoadOp;
+
+/** 各操作类型的名称，下标为 LoadOp。 */
+static const char *const load_op_names[LOAD_OP_COUNT] = {"entry", "exit",
+                                                         "lookup", "stats"};
+
+/**
+ * @brief 负载参数。
+ */
+typedef struct LoadOptions {
+  int slots;                 /**< 车位数量。 */
+  double occupancy;          /**< 预先停入车辆的比例。 */
+  double visitor_ratio;      /**< 车辆中访客所占比例。 */
+  int threads;               /**< 工作线程数。 */
+  long ops_per_thread;       /**< 每个线程执行的操作数。 */
+  int mix[LOAD_OP_COUNT];    /**< 各操作类型的权重。 */
+  unsigned long seed;        /**< 随机数种子。 */
+  int metrics_port;          /**< 指标端点端口，-1 表示不启动。 */
+} LoadOptions;
+
+/**
+ * @brief 对数线性延迟直方图。
+ */
+typedef struct LatencyHistogram {
+  unsigned long buckets[LOAD_BUCKETS]; /**< 各桶的计数。 */
+  unsigned long count;                 /**< 样本总数。 */
+  double max_ns;                       /**< 最大样本。 */
+} LatencyHistogram;
+
+/**
+ * @brief 一个工作线程的状态与结果。
+ */
+typedef struct LoadWorker {
+  ParkingLot *lot;                   /**< 共享的停车场。 */
+  const LoadOptions *options;        /**< 负载参数。 */
+  int index;                         /**< 线程序号，决定车牌前缀。 */
+  unsigned long rng;                 /**< 线程私有的随机数状态。 */
+  long *fleet;                       /**< 本线程停在场内的车辆序号。 */
+  long fleet_count;                  /**< 场内车辆数。 */
+  long fleet_capacity;               /**< fleet 数组容量。 */
+  long next_serial;                  /**< 下一辆新车的序号。 */
+  unsigned long ops[LOAD_OP_COUNT];  /**< 各类型完成的操作数。 */
+  unsigned long failures[LOAD_OP_COUNT]; /**< 各类型失败的操作数。 */
+  LatencyHistogram latency[LOAD_OP_COUNT]; /**< 各类型的延迟直方图。 */
+} LoadWorker;
+
+/* ========================================================================== */
+/*                                   工具函数                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 读取单调时钟。
+ * @return 当前时刻（纳秒）。
+ */
+static double load_now_ns(void) {
+#ifdef _WIN32
+  LARGE_INTEGER counter;
+  LARGE_INTEGER frequency;
+
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 线性同余伪随机数，结果与平台的 rand() 无关。
+ * @param state 生成器状态。
+ * @param bound 上界（不含），必须为正。
+ * @return [0, bound) 内的整数。
+ */
+static long load_random(unsigned long *state, long bound) {
+  *state = (*state * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+  return (long)((*state >> 8) % (unsigned long)bound);
+}
+
+/**
+ * @brief (静态辅助函数) 生成车辆的车牌号。
+ * @details 线程序号决定省份与发牌机关字母，序号占尾部 6 位数字，
+ *          因此不同线程、同一线程的不同车辆之间车牌都不重复。
+ * @param thread 线程序号，小于 LOAD_MAX_THREADS。
+ * @param serial 车辆序号，小于 1000000。
+ * @param[out] plate 接收车牌的缓冲区，至少 MAX_LICENSE_LEN 字节。
+ */
+static void load_plate(int thread, long serial, char *plate) {
+  static const char provinces[][4] = {"京", "沪", "粤"};
+
+  sprintf(plate, "%s%c%06ld", provinces[thread / 26 % 3], 'A' + thread % 26,
+          serial % 1000000L);
+}
+
+/**
+ * @brief (静态辅助函数) 计算延迟样本所在的桶。
+ * @details 小于 LOAD_SUB_BUCKETS 纳秒的样本线性分桶；更大的样本按最高位
+ *          所在的 2 的幂区间分组，每组再按紧随其后的 4 位细分。
+ * @param ns 延迟（纳秒）。
+ * @return 桶下标。
+ */
+static int histogram_bucket(double ns) {
+  unsigned long value;
+  int magnitude = 0;
+  int bucket;
+
+  if (ns < (double)LOAD_SUB_BUCKETS) {
+    return ns < 0.0 ? 0 : (int)ns;
+  }
+  if (ns >= 1099511627776.0) {
+    return LOAD_BUCKETS - 1;
+  }
+  /* 先把值缩到 [2^SUB, 2^(SUB+1)) 区间，记录缩放的位数 */
+  while (ns >= (double)(2 * LOAD_SUB_BUCKETS)) {
+    ns /= 2.0;
+    magnitude++;
+  }
+  value = (unsigned long)ns;
+  bucket = (magnitude + 1) * LOAD_SUB_BUCKETS +
+           (int)(value - LOAD_SUB_BUCKETS);
+  return bucket < LOAD_BUCKETS ? bucket : LOAD_BUCKETS - 1;
+}
+
+/**
+ * @brief (静态辅助函数) 计算桶的上界。
+ * @param bucket 桶下标。
+ * @return 该桶内样本的上界（纳秒）。
+ */
+static double histogram_bucket_upper(int bucket) {
+  int magnitude = bucket / LOAD_SUB_BUCKETS - 1;
+  double upper;
+
+  if (magnitude < 0) {
+    return (double)(bucket + 1);
+  }
+  upper = (double)(LOAD_SUB_BUCKETS + bucket % LOAD_SUB_BUCKETS + 1);
+  while (magnitude-- > 0) {
+    upper *= 2.0;
+  }
+  return upper;
+}
+
+/**
+ * @brief (静态辅助函数) 记录一个延迟样本。
+ * @param h 目标直方图。
+ * @param ns 延迟（纳秒）。
+ */
+static void histogram_record(LatencyHistogram *h, double ns) {
+  h->buckets[histogram_bucket(ns)]++;
+  h->count++;
+  if (ns > h->max_ns) {
+    h->max_ns = ns;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 把直方图 src 合并到 dst。
+ * @param dst 目标直方图。
+ * @param src 源直方图。
+ */
+static void histogram_merge(LatencyHistogram *dst, const LatencyHistogram *src) {
+  int i;
+
+  for (i = 0; i < LOAD_BUCKETS; i++) {
+    dst->buckets[i] += src->buckets[i];
+  }
+  dst->count += src->count;
+  if (src->max_ns > dst->max_ns) {
+    dst->max_ns = src->max_ns;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 估算直方图的分位数。
+ * @param h 目标直方图。
+ * @param quantile 分位点，取值 (0, 1]。
+ * @return 分位数所在桶的上界（纳秒），不超过最大样本；没有样本时返回 0。
+ */
+static double histogram_quantile(const LatencyHistogram *h, double quantile) {
+  unsigned long target = (unsigned long)(quantile * (double)h->count);
+  unsigned long seen = 0;
+  int i;
+
+  if (h->count == 0) {
+    return 0.0;
+  }
+  if (target == 0) {
+    target = 1;
+  }
+  for (i = 0; i < LOAD_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= target) {
+      double upper = histogram_bucket_upper(i);
+      return upper < h->max_ns ? upper : h->max_ns;
+    }
+  }
+  return h->max_ns;
+}
+
+/* ========================================================================== */
+/*                                   停车场生成                               */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 生成车位的位置描述。
+ * @details 每栋楼 4 层，每层 6 个分区，每区 40 个车位；
+ *          地下层与地上层各半，与常见的住宅区地库相似。
+ * @param slot_id 车位编号，从 1 开始。
+ * @param[out] location 接收位置描述的缓冲区，至少 MAX_LOCATION_LEN 字节。
+ */
+static void load_location(int slot_id, char *location) {
+  static const char *const floors[] = {"B2层", "B1层", "1层", "2层"};
+  int n = slot_id - 1;
+  int number = n % 40 + 1;
+  int zone = n / 40 % 6;
+  int floor = n / 240 % 4;
+  int building = n / 960 + 1;
+
+  sprintf(location, "%d号楼-%s-%c区-%03d", building, floors[floor],
+          'A' + zone, number);
+}
+
+/**
+ * @brief (静态辅助函数) 确保线程的车辆数组还能再放一辆车。
+ * @param worker 目标线程。
+ * @return 成功返回 1，内存不足返回 0。
+ */
+static int fleet_reserve(LoadWorker *worker) {
+  long *grown;
+  long capacity;
+
+  if (worker->fleet_count < worker->fleet_capacity) {
+    return 1;
+  }
+  capacity = worker->fleet_capacity ? worker->fleet_capacity * 2 : 256;
+  grown = (long *)realloc(worker->fleet, (size_t)capacity * sizeof(long));
+  if (!grown) {
+    return 0;
+  }
+  worker->fleet = grown;
+  worker->fleet_capacity = capacity;
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 生成停车场并按比例预先停入车辆。
+ * @details 预先停入的车辆轮流分给各工作线程，之后由其负责出场。
+ * @param options 负载参数。
+ * @param workers 工作线程数组，车辆登记到其 fleet。
+ * @return 新停车场；失败返回 NULL。
+ */
+static ParkingLot *generate_lot(const LoadOptions *options,
+                                LoadWorker *workers) {
+  ParkingLot *lot = init_parking_lot(options->slots);
+  char location[MAX_LOCATION_LEN];
+  char plate[MAX_LICENSE_LEN];
+  unsigned long rng = options->seed;
+  struct tm morning;
+  long parked = (long)(options->occupancy * options->slots);
+  long i;
+  int id;
+
+  if (!lot) {
+    return NULL;
+  }
+  memset(&morning, 0, sizeof(morning));
+  morning.tm_year = 2024 - 1900;
+  morning.tm_mon = 5;
+  morning.tm_mday = 1;
+  morning.tm_hour = 10;
+  morning.tm_isdst = -1;
+  parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL,
+                                  mktime(&morning));
+
+  for (id = 1; id <= options->slots; id++) {
+    load_location(id, location);
+    if (parking_service_fast_add_slot(lot, id, location) !=
+        PARKING_SERVICE_SUCCESS) {
+      free_parking_lot(lot);
+      return NULL;
+    }
+  }
+
+  for (i = 0; i < parked; i++) {
+    LoadWorker *owner = &workers[i % options->threads];
+    ParkingType type = load_random(&rng, 1000) < options->visitor_ratio * 1000
+                           ? VISITOR_TYPE
+                           : RESIDENT_TYPE;
+
+    load_plate(owner->index, owner->next_serial, plate);
+    if (!fleet_reserve(owner) ||
+        parking_service_fast_allocate_any_slot(lot, "预置车主", plate,
+                                               LOAD_CONTACT, type, NULL) !=
+            PARKING_SERVICE_SUCCESS) {
+      free_parking_lot(lot);
+      return NULL;
+    }
+    owner->fleet[owner->fleet_count++] = owner->next_serial++;
+  }
+  return lot;
+}
+
+/* ========================================================================== */
+/*                                   工作线程                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 按权重随机选择操作类型。
+ * @param worker 当前线程。
+ * @param total 权重之和，必须为正。
+ * @return 操作类型。
+ */
+static LoadOp pick_op(LoadWorker *worker, int total) {
+  long roll = load_random(&worker->rng, total);
+  int op;
+
+  for (op = 0; op < LOAD_OP_COUNT - 1; op++) {
+    roll -= worker->options->mix[op];
+    if (roll < 0) {
+      break;
+    }
+  }
+  return (LoadOp)op;
+}
+
+/**
+ * @brief (静态辅助函数) 执行一次入场。
+ * @param worker 当前线程。
+ * @return 成功返回 1，失败（如车位已满）返回 0。
+ */
+static int do_entry(LoadWorker *worker) {
+  char plate[MAX_LICENSE_LEN];
+  ParkingType type =
+      load_random(&worker->rng, 1000) < worker->options->visitor_ratio * 1000
+          ? VISITOR_TYPE
+          : RESIDENT_TYPE;
+
+  if (!fleet_reserve(worker)) {
+    return 0;
+  }
+  load_plate(worker->index, worker->next_serial, plate);
+  if (parking_service_fast_allocate_any_slot(worker->lot, "压测车主", plate,
+                                             LOAD_CONTACT, type, NULL) !=
+      PARKING_SERVICE_SUCCESS) {
+    return 0;
+  }
+  worker->fleet[worker->fleet_count++] = worker->next_serial++;
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 让本线程的一辆随机车辆出场。
+ * @details 车辆只由停入它的线程出场，查找到的车位在出场前不会被其他线程改动。
+ * @param worker 当前线程，调用者保证 fleet 非空。
+ * @return 成功返回 1，否则返回 0。
+ */
+static int do_exit(LoadWorker *worker) {
+  char plate[MAX_LICENSE_LEN];
+  ParkingSlot *slot = NULL;
+  ExitReceipt receipt;
+  long pick = load_random(&worker->rng, worker->fleet_count);
+
+  load_plate(worker->index, worker->fleet[pick], plate);
+  worker->fleet[pick] = worker->fleet[--worker->fleet_count];
+  if (parking_service_fast_find_slot_by_license(worker->lot, plate, &slot) !=
+          PARKING_SERVICE_SUCCESS ||
+      !slot) {
+    return 0;
+  }
+  return parking_service_fast_deallocate_slot(worker->lot, slot->slot_id,
+                                              &receipt) ==
+         PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief (静态辅助函数) 执行一次查找：一半按本线程车辆的车牌，一半按随机编号。
+ * @param worker 当前线程。
+ * @return 找到返回 1，否则返回 0。
+ */
+static int do_lookup(LoadWorker *worker) {
+  char plate[MAX_LICENSE_LEN];
+  ParkingSlot *slot = NULL;
+
+  if (worker->fleet_count > 0 && load_random(&worker->rng, 2) == 0) {
+    load_plate(worker->index,
+               worker->fleet[load_random(&worker->rng, worker->fleet_count)],
+               plate);
+    return parking_service_fast_find_slot_by_license(worker->lot, plate,
+                                                     &slot) ==
+           PARKING_SERVICE_SUCCESS;
+  }
+  return parking_service_fast_find_slot_by_id(
+             worker->lot,
+             (int)load_random(&worker->rng, worker->options->slots) + 1,
+             &slot) == PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief (静态辅助函数) 工作线程入口：按权重执行 ops_per_thread 次操作。
+ * @details 车队为空时抽到的出场操作改为入场，保证负载持续进行。
+ * @param arg 指向 LoadWorker 的指针。
+ */
+static void load_worker(void *arg) {
+  LoadWorker *worker = (LoadWorker *)arg;
+  const LoadOptions *options = worker->options;
+  ParkingStatistics stats;
+  int total = 0;
+  long n;
+  int i;
+
+  for (i = 0; i < LOAD_OP_COUNT; i++) {
+    total += options->mix[i];
+  }
+  for (n = 0; n < options->ops_per_thread; n++) {
+    LoadOp op = pick_op(worker, total);
+    double started;
+    int ok;
+
+    if (op == LOAD_OP_EXIT && worker->fleet_count == 0) {
+      op = LOAD_OP_ENTRY;
+    }
+    started = load_now_ns();
+    switch (op) {
+    case LOAD_OP_ENTRY:
+      ok = do_entry(worker);
+      break;
+    case LOAD_OP_EXIT:
+      ok = do_exit(worker);
+      break;
+    case LOAD_OP_LOOKUP:
+      ok = do_lookup(worker);
+      break;
+    default:
+      ok = parking_service_fast_get_statistics(worker->lot, &stats) ==
+           PARKING_SERVICE_SUCCESS;
+      break;
+    }
+    histogram_record(&worker->latency[op], load_now_ns() - started);
+    worker->ops[op]++;
+    if (!ok) {
+      worker->failures[op]++;
+    }
+  }
+}
+
+/* ========================================================================== */
+/*                                   参数与报告                               */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 打印命令行用法。
+ * @param program 程序名。
+ */
+static void print_usage(const char *program) {
+  fprintf(stderr,
+          "用法: %s [--slots N] [--occupancy 比例] [--visitors 比例]\n"
+          "       [--threads N] [--ops 每线程操作数]\n"
+          "       [--mix 入场:出场:查找:统计] [--seed 种子]\n"
+          "       [--metrics-port 端口]\n",
+          program);
+}
+
+/**
+ * @brief (静态辅助函数) 解析 "a:b:c:d" 形式的操作权重。
+ * @param text 权重字符串。
+ * @param[out] mix 接收 LOAD_OP_COUNT 个权重。
+ * @return 格式正确且权重之和为正返回 1，否则返回 0。
+ */
+static int parse_mix(const char *text, int *mix) {
+  int total = 0;
+  int i;
+
+  for (i = 0; i < LOAD_OP_COUNT; i++) {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value < 0 || value > 10000 ||
+        (i < LOAD_OP_COUNT - 1 ? *end != ':' : *end != '\0')) {
+      return 0;
+    }
+    mix[i] = (int)value;
+    total += mix[i];
+    text = end + 1;
+  }
+  return total > 0;
+}
+
+/**
+ * @brief (静态辅助函数) 解析命令行参数。
+ * @param argc 参数个数。
+ * @param argv 参数数组。
+ * @param[out] options 接收解析结果。
+ * @return 参数合法返回 1，否则返回 0。
+ */
+static int parse_options(int argc, char **argv, LoadOptions *options) {
+  int i;
+
+  options->slots = 50000;
+  options->occupancy = 0.6;
+  options->visitor_ratio = 0.3;
+  options->threads = 4;
+  options->ops_per_thread = 200000;
+  options->mix[LOAD_OP_ENTRY] = 25;
+  options->mix[LOAD_OP_EXIT] = 25;
+  options->mix[LOAD_OP_LOOKUP] = 45;
+  options->mix[LOAD_OP_STATS] = 5;
+  options->seed = 20240601UL;
+  options->metrics_port = -1;
+
+  for (i = 1; i + 1 < argc; i += 2) {
+    const char *value = argv[i + 1];
+
+    if (strcmp(argv[i], "--slots") == 0) {
+      options->slots = atoi(value);
+    } else if (strcmp(argv[i], "--occupancy") == 0) {
+      options->occupancy = atof(value);
+    } else if (strcmp(argv[i], "--visitors") == 0) {
+      options->visitor_ratio = atof(value);
+    } else if (strcmp(argv[i], "--threads") == 0) {
+      options->threads = atoi(value);
+    } else if (strcmp(argv[i], "--ops") == 0) {
+      options->ops_per_thread = atol(value);
+    } else if (strcmp(argv[i], "--mix") == 0) {
+      if (!parse_mix(value, options->mix)) {
+        return 0;
+      }
+    } else if (strcmp(argv[i], "--seed") == 0) {
+      options->seed = strtoul(value, NULL, 10);
+    } else if (strcmp(argv[i], "--metrics-port") == 0) {
+      options->metrics_port = atoi(value);
+    } else {
+      return 0;
+    }
+  }
+  return i == argc && options->slots > 0 &&
+         options->slots <= VALIDATE_MAX_SLOT_ID && options->occupancy >= 0.0 &&
+         options->occupancy <= 1.0 && options->visitor_ratio >= 0.0 &&
+         options->visitor_ratio <= 1.0 && options->threads > 0 &&
+         options->threads <= LOAD_MAX_THREADS && options->ops_per_thread > 0 &&
+         options->ops_per_thread <= 1000000L - options->slots &&
+         options->metrics_port >= -1 && options->metrics_port <= 65535;
+}
+
+/**
+ * @brief (静态辅助函数) 合并各线程结果并打印报告。
+ * @param lot 目标停车场。
+ * @param options 负载参数。
+ * @param workers 工作线程数组。
+ * @param wall_ns 负载阶段的墙钟耗时（纳秒）。
+ */
+static void print_report(const ParkingLot *lot, const LoadOptions *options,
+                         const LoadWorker *workers, double wall_ns) {
+  static LatencyHistogram merged[LOAD_OP_COUNT];
+  unsigned long ops[LOAD_OP_COUNT];
+  unsigned long failures[LOAD_OP_COUNT];
+  unsigned long total_ops = 0;
+  ParkingStatistics stats;
+  ParkingMemoryStats memory;
+  double seconds = wall_ns / 1e9;
+  int op;
+  int t;
+
+  memset(merged, 0, sizeof(merged));
+  memset(ops, 0, sizeof(ops));
+  memset(failures, 0, sizeof(failures));
+  for (t = 0; t < options->threads; t++) {
+    for (op = 0; op < LOAD_OP_COUNT; op++) {
+      histogram_merge(&merged[op], &workers[t].latency[op]);
+      ops[op] += workers[t].ops[op];
+      failures[op] += workers[t].failures[op];
+    }
+  }
+
+  parking_service_fast_get_statistics(lot, &stats);
+  printf("slots=%d threads=%d ops_per_thread=%ld mix=%d:%d:%d:%d "
+         "final_occupied=%d elapsed_s=%.3f\n",
+         options->slots, options->threads, options->ops_per_thread,
+         options->mix[0], options->mix[1], options->mix[2], options->mix[3],
+         stats.occupied_slots, seconds);
+  printf("%-8s %10s %9s %12s %10s %10s %10s %10s\n", "op", "count",
+         "failed", "ops/s", "p50_ns", "p99_ns", "p999_ns", "max_ns");
+  for (op = 0; op < LOAD_OP_COUNT; op++) {
+    total_ops += ops[op];
+    printf("%-8s %10lu %9lu %12.0f %10.0f %10.0f %10.0f %10.0f\n",
+           load_op_names[op], ops[op], failures[op],
+           seconds > 0.0 ? (double)ops[op] / seconds : 0.0,
+           histogram_quantile(&merged[op], 0.50),
+           histogram_quantile(&merged[op], 0.99),
+           histogram_quantile(&merged[op], 0.999), merged[op].max_ns);
+  }
+  printf("%-8s %10lu %9s %12.0f\n", "total", total_ops, "",
+         seconds > 0.0 ? (double)total_ops / seconds : 0.0);
+
+  parking_service_get_memory_stats(lot, &memory);
+  printf("%-8s %14s %10s\n", "memory", "bytes", "objects");
+  for (op = 0; op < PARKING_MEMORY_CATEGORY_COUNT; op++) {
+    printf("%-8s %14ld %10ld\n",
+           parking_memory_category_name((ParkingMemoryCategory)op),
+           memory.bytes[op], memory.objects[op]);
+  }
+  printf("%-8s %14ld %10ld peak=%ld overhead=%ld bytes_per_slot=%.1f\n",
+         "total", memory.total_bytes, memory.total_objects, memory.peak_bytes,
+         memory.overhead_bytes,
+         (double)(memory.total_bytes + memory.overhead_bytes) /
+             (double)options->slots);
+}
+
+/**
+ * @brief 主函数：生成停车场，运行多线程负载并输出报告。
+ * @param argc 参数个数。
+ * @param argv 参数数组。
+ * @return 成功返回 0，参数错误或初始化失败返回 1。
+ */
+int main(int argc, char **argv) {
+  static LoadWorker workers[LOAD_MAX_THREADS];
+  ParkingThread *threads[LOAD_MAX_THREADS];
+  LoadOptions options;
+  ParkingLot *lot;
+#ifdef PARKING_EXPORTER
+  ParkingExporter *exporter = NULL;
+#endif
+  double started;
+  double wall_ns;
+  int status = 0;
+  int t;
+
+  if (!parse_options(argc, argv, &options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  for (t = 0; t < options.threads; t++) {
+    workers[t].options = &options;
+    workers[t].index = t;
+    workers[t].rng = options.seed + 7919UL * (unsigned long)(t + 1);
+  }
+  fprintf(stderr, "生成 %d 个车位的停车场...\n", options.slots);
+  lot = generate_lot(&options, workers);
+  if (!lot) {
+    fprintf(stderr, "停车场生成失败\n");
+    status = 1;
+  }
+
+#ifdef PARKING_EXPORTER
+  if (lot && options.metrics_port >= 0) {
+    exporter = parking_exporter_start(lot, "0.0.0.0", options.metrics_port);
+    if (exporter) {
+      fprintf(stderr, "指标端点: http://0.0.0.0:%d/metrics\n",
+              parking_exporter_port(exporter));
+    } else {
+      fprintf(stderr, "指标端点启动失败\n");
+    }
+  }
+#else
+  if (options.metrics_port >= 0) {
+    fprintf(stderr, "未编入指标导出模块，忽略 --metrics-port\n");
+  }
+#endif
+
+  if (lot) {
+    for (t = 0; t < options.threads; t++) {
+      workers[t].lot = lot;
+    }
+    fprintf(stderr, "运行 %d 个线程的负载...\n", options.threads);
+    started = load_now_ns();
+    for (t = 0; t < options.threads; t++) {
+      threads[t] = parking_thread_start(load_worker, &workers[t]);
+    }
+    for (t = 0; t < options.threads; t++) {
+      if (threads[t]) {
+        parking_thread_join(threads[t]);
+      } else {
+        status = 1;
+      }
+    }
+    wall_ns = load_now_ns() - started;
+    if (status == 0) {
+      print_report(lot, &options, workers, wall_ns);
+    } else {
+      fprintf(stderr, "线程创建失败\n");
+    }
+  }
+
+#ifdef PARKING_EXPORTER
+  parking_exporter_stop(exporter);
+#endif
+  for (t = 0; t < options.threads; t++) {
+    free(workers[t].fleet);
+  }
+  free_parking_lot(lot);
+  return status;
+}
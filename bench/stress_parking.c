@@ -0,0 +1,789 @@
+/**
+ * @file stress_parking.c
+ * @brief 多线程并发压力测试程序
+ * @details
+ * 多个工作线程共享同一个停车场，按种子确定的操作序列混合执行：
+ * - entry：从共享车牌池中随机取一个车牌自动选位入场；
+ * - exit：按车牌查到车位后出场；
+ * - lookup：按车牌或车位编号查找，并核对查到的车位内容；
+ * - stats：不加锁读取统计信息，检查计数的取值范围；
+ * - save：保存二进制快照（与其他线程的修改并发进行写时复制）；
+ * - check：在读锁内全量核对停车场的不变量。
+ * 与 load_parking 不同，所有线程从同一个车牌池取车牌，会争抢同一辆车与
+ * 同一个车位：重复入场、出场时车辆已被其他线程放走等情况都是预期的
+ * 拒绝，记入 rejected 而不算错误。
+ *
+ * 不变量：已占用车位数、按类型的占用数与空闲车位数等于逐个车位数出的值；
+ * 在场车牌互不重复，且按车牌查找能找回停放它的车位；查找返回的车位
+ * 与查找条件一致。任何一项不成立都记为 violation，程序以状态 2 退出。
+ *
+ * 每个线程的操作序列只由 --seed 与线程序号决定；线程之间的交错
+ * 由调度器决定，单线程运行时整个过程完全可复现。--threads 接受以逗号
+ * 分隔的线程数列表，每个线程数各运行一轮（每轮重新生成停车场），
+ * 报告每轮的吞吐量与相对第一轮的加速比，用于观察随核数的扩展曲线。
+ *
+ * 以 ThreadSanitizer 构建（cmake -DPARKING_SANITIZER=thread）后运行
+ * 本程序，可检查数据层与服务层的加锁是否完整。
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/parking_service.h"
+#include "../src/parking_thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define STRESS_MAX_THREADS 64 /**< 每轮最多的工作线程数。 */
+#define STRESS_MAX_ROUNDS 16  /**< --threads 列表中最多的线程数个数。 */
+#define STRESS_DETAIL_LEN 160 /**< 第一条违规描述的最大长度。 */
+#define STRESS_PATH_LEN 256   /**< 快照文件路径的最大长度。 */
+#define STRESS_CONTACT "13800000000" /**< 生成车辆使用的联系方式。 */
+
+/**
+ * @brief 压力测试中的操作类型。
+ */
+typedef enum {
+  STRESS_OP_ENTRY = 0,  /**< 车辆入场。 */
+  STRESS_OP_EXIT = 1,   /**< 车辆出场。 */
+  STRESS_OP_LOOKUP = 2, /**< 查找车位。 */
+  STRESS_OP_STATS = 3,  /**< 读取统计。 */
+  STRESS_OP_SAVE = 4,   /**< 保存快照。 */
+  STRESS_OP_CHECK = 5,  /**< 核对不变量。 */
+  STRESS_OP_COUNT = 6   /**< 操作类型数。 */
+} StressOp;
+
+/** 各操作类型的名称，下标为 StressOp。 */
+static const char *const stress_op_names[STRESS_OP_COUNT] = {
+    "entry", "exit", "lookup", "stats", "save", "check"};
+
+/**
+ * @brief 压力测试参数。
+ */
+typedef struct StressOptions {
+  int slots;                          /**< 车位数量。 */
+  int plates;                         /**< 共享车牌池的大小。 */
+  long ops_per_thread;                /**< 每个线程执行的操作数。 */
+  int rounds[STRESS_MAX_ROUNDS];      /**< 每轮的线程数。 */
+  int round_count;                    /**< 轮数。 */
+  int mix[STRESS_OP_COUNT];           /**< 各操作类型的权重。 */
+  unsigned long seed;                 /**< 随机数种子。 */
+  const char *save_prefix;            /**< 快照文件路径前缀。 */
+} StressOptions;
+
+/**
+ * @brief 一个工作线程的状态与结果。
+ */
+typedef struct StressWorker {
+  ParkingLot *lot;                         /**< 共享的停车场。 */
+  const StressOptions *options;            /**< 测试参数。 */
+  int index;                               /**< 线程序号。 */
+  unsigned long rng;                       /**< 线程私有的随机数状态。 */
+  char save_path[STRESS_PATH_LEN];         /**< 本线程的快照文件路径。 */
+  unsigned long ops[STRESS_OP_COUNT];      /**< 各类型完成的操作数。 */
+  unsigned long rejected[STRESS_OP_COUNT]; /**< 各类型预期内被拒绝的次数。 */
+  unsigned long violations;                /**< 发现的违规次数。 */
+  char detail[STRESS_DETAIL_LEN];          /**< 第一条违规的描述。 */
+} StressWorker;
+
+/**
+ * @brief 查找操作的核对上下文。
+ */
+typedef struct StressLookup {
+  int slot_id;       /**< 按编号查找时的车位编号，按车牌查找时为 0。 */
+  const char *plate; /**< 按车牌查找时的车牌号，按编号查找时为 NULL。 */
+  int found_id;      /**< 查到的车位编号。 */
+  int mismatch;      /**< 查到的车位与查找条件不一致时为 1。 */
+} StressLookup;
+
+/* ========================================================================== */
+/*                                   工具函数                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 读取单调时钟。
+ * @return 当前时刻（秒）。
+ */
+static double stress_now_seconds(void) {
+#ifdef _WIN32
+  LARGE_INTEGER counter;
+  LARGE_INTEGER frequency;
+
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 线性同余伪随机数，结果与平台的 rand() 无关。
+ * @param state 生成器状态。
+ * @param bound 上界（不含），必须为正。
+ * @return [0, bound) 内的整数。
+ */
+static long stress_random(unsigned long *state, long bound) {
+  *state = (*state * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+  return (long)((*state >> 8) % (unsigned long)bound);
+}
+
+/**
+ * @brief (静态辅助函数) 生成车牌池中第 n 个车牌。
+ * @param n 车牌序号，小于 1000000。
+ * @param[out] plate 接收车牌的缓冲区，至少 MAX_LICENSE_LEN 字节。
+ */
+static void stress_plate(long n, char *plate) {
+  sprintf(plate, "苏E%06ld", n);
+}
+
+/**
+ * @brief (静态辅助函数) 记录一次违规，只保留第一条的描述。
+ * @param worker 当前线程。
+ * @param detail 违规描述。
+ */
+static void stress_violation(StressWorker *worker, const char *detail) {
+  if (worker->violations++ == 0) {
+    strncpy(worker->detail, detail, sizeof(worker->detail) - 1);
+    worker->detail[sizeof(worker->detail) - 1] = '\0';
+  }
+}
+
+/**
+ * @brief (静态辅助函数) qsort 比较函数：按车牌字典序比较两个车牌指针。
+ * @param a 指向 const char * 的指针。
+ * @param b 指向 const char * 的指针。
+ * @return strcmp 的结果。
+ */
+static int compare_plates(const void *a, const void *b) {
+  return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* ========================================================================== */
+/*                                   不变量核对                               */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 在读锁内逐个车位核对停车场的不变量。
+ * @details 读锁内没有写者，计数器与车位表应精确一致。
+ * @param lot 目标停车场。
+ * @param[out] detail 不一致时接收描述，至少 STRESS_DETAIL_LEN 字节。
+ * @return 全部成立返回 0，发现不一致返回 -1。
+ */
+static int check_invariants(ParkingLot *lot, char *detail) {
+  const char **plates;
+  SlotCursor cursor;
+  ParkingSlot *slot;
+  int occupied = 0;
+  int residents = 0;
+  int visitors = 0;
+  int total = 0;
+  int status = 0;
+  int i;
+
+  parking_lot_read_lock(lot);
+  plates = (const char **)malloc(
+      (size_t)(lot->slot_count > 0 ? lot->slot_count : 1) * sizeof(char *));
+  if (!plates) {
+    parking_lot_read_unlock(lot);
+    sprintf(detail, "核对时内存不足");
+    return -1;
+  }
+
+  slot_cursor_init(&cursor, lot, SLOT_FILTER_ALL);
+  while ((slot = slot_cursor_next(&cursor)) != NULL) {
+    total++;
+    if (slot->status != OCCUPIED_STATUS) {
+      continue;
+    }
+    plates[occupied++] = slot->license_plate;
+    if (slot->type == RESIDENT_TYPE) {
+      residents++;
+    } else {
+      visitors++;
+    }
+    if (status == 0 && find_slot_by_license(lot, slot->license_plate) != slot) {
+      sprintf(detail, "车牌 %s 查不回车位 %d", slot->license_plate,
+              slot->slot_id);
+      status = -1;
+    }
+  }
+
+  if (status == 0 && (lot->occupied_slots != occupied ||
+                      lot->occupied_resident_count != residents ||
+                      lot->occupied_visitor_count != visitors ||
+                      lot->free_slot_count != total - occupied)) {
+    sprintf(detail,
+            "计数不一致: occupied=%d/%d resident=%d/%d visitor=%d/%d "
+            "free=%d/%d",
+            lot->occupied_slots, occupied, lot->occupied_resident_count,
+            residents, lot->occupied_visitor_count, visitors,
+            lot->free_slot_count, total - occupied);
+    status = -1;
+  }
+
+  qsort((void *)plates, (size_t)occupied, sizeof(char *), compare_plates);
+  for (i = 1; status == 0 && i < occupied; i++) {
+    if (strcmp(plates[i - 1], plates[i]) == 0) {
+      sprintf(detail, "车牌 %s 同时停在两个车位", plates[i]);
+      status = -1;
+    }
+  }
+  parking_lot_read_unlock(lot);
+  free((void *)plates);
+  return status;
+}
+
+/* ========================================================================== */
+/*                                   工作线程                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 查找回调：在读锁内核对查到的车位。
+ * @param slot 查到的车位。
+ * @param ctx 指向 StressLookup 的指针。
+ * @return 始终返回 0。
+ */
+static int verify_lookup(ParkingSlot *slot, void *ctx) {
+  StressLookup *lookup = (StressLookup *)ctx;
+
+  lookup->found_id = slot->slot_id;
+  if (lookup->plate) {
+    lookup->mismatch = slot->status != OCCUPIED_STATUS ||
+                       strcmp(slot->license_plate, lookup->plate) != 0;
+  } else {
+    lookup->mismatch = slot->slot_id != lookup->slot_id;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 按车牌查找车位并核对。
+ * @param worker 当前线程。
+ * @param plate 车牌号。
+ * @return 找到返回车位编号，车辆不在场返回 0。
+ */
+static int lookup_plate(StressWorker *worker, const char *plate) {
+  StressLookup lookup;
+  char detail[STRESS_DETAIL_LEN];
+
+  memset(&lookup, 0, sizeof(lookup));
+  lookup.plate = plate;
+  if (parking_service_fast_visit_slot_by_license(
+          worker->lot, plate, verify_lookup, &lookup) !=
+      PARKING_SERVICE_SUCCESS) {
+    return 0;
+  }
+  if (lookup.mismatch) {
+    sprintf(detail, "按车牌 %s 查到的车位 %d 不符", plate, lookup.found_id);
+    stress_violation(worker, detail);
+  }
+  return lookup.found_id;
+}
+
+/**
+ * @brief (静态辅助函数) 执行一次入场：车牌已在场或车位已满属于预期拒绝。
+ * @param worker 当前线程。
+ * @param plate 车牌号。
+ * @return 成功返回 1，预期内被拒绝返回 0。
+ */
+static int do_entry(StressWorker *worker, const char *plate) {
+  ParkingType type =
+      stress_random(&worker->rng, 3) == 0 ? VISITOR_TYPE : RESIDENT_TYPE;
+  ParkingServiceResultCode code = parking_service_fast_allocate_any_slot(
+      worker->lot, "压测车主", plate, STRESS_CONTACT, type, NULL);
+  char detail[STRESS_DETAIL_LEN];
+
+  if (code == PARKING_SERVICE_SUCCESS) {
+    return 1;
+  }
+  if (code != PARKING_SERVICE_LICENSE_EXISTS &&
+      code != PARKING_SERVICE_SLOT_NOT_FOUND) {
+    sprintf(detail, "车牌 %s 入场失败: %.100s", plate,
+            parking_service_code_message(code));
+    stress_violation(worker, detail);
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 执行一次出场。
+ * @details 查找与出场之间其他线程可能已放走这辆车，甚至让另一辆车停进了
+ *          同一个车位；前者返回车位空闲，后者放走的是另一辆车，
+ *          都不破坏不变量。
+ * @param worker 当前线程。
+ * @param plate 车牌号。
+ * @return 成功返回 1，预期内被拒绝返回 0。
+ */
+static int do_exit(StressWorker *worker, const char *plate) {
+  int slot_id = lookup_plate(worker, plate);
+  ParkingServiceResultCode code;
+  ExitReceipt receipt;
+  char detail[STRESS_DETAIL_LEN];
+
+  if (slot_id == 0) {
+    return 0;
+  }
+  code = parking_service_fast_deallocate_slot(worker->lot, slot_id, &receipt);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    return 1;
+  }
+  if (code != PARKING_SERVICE_SLOT_FREE) {
+    sprintf(detail, "车位 %d 出场失败: %.100s", slot_id,
+            parking_service_code_message(code));
+    stress_violation(worker, detail);
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 执行一次查找：一半按车牌，一半按车位编号。
+ * @param worker 当前线程。
+ * @param plate 按车牌查找时使用的车牌号。
+ * @return 找到返回 1，否则返回 0。
+ */
+static int do_lookup(StressWorker *worker, const char *plate) {
+  StressLookup lookup;
+  char detail[STRESS_DETAIL_LEN];
+
+  if (stress_random(&worker->rng, 2) == 0) {
+    return lookup_plate(worker, plate) != 0;
+  }
+  memset(&lookup, 0, sizeof(lookup));
+  lookup.slot_id =
+      (int)stress_random(&worker->rng, worker->options->slots) + 1;
+  if (parking_service_fast_visit_slot_by_id(worker->lot, lookup.slot_id,
+                                            verify_lookup, &lookup) !=
+      PARKING_SERVICE_SUCCESS) {
+    sprintf(detail, "车位 %d 查找失败", lookup.slot_id);
+    stress_violation(worker, detail);
+    return 0;
+  }
+  if (lookup.mismatch) {
+    sprintf(detail, "按编号 %d 查到车位 %d", lookup.slot_id,
+            lookup.found_id);
+    stress_violation(worker, detail);
+  }
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 不加锁读取统计并检查取值范围。
+ * @details 各计数器分别原子更新，不加锁时彼此之间可能相差正在进行的
+ *          一次修改，因此只检查各自的范围。
+ * @param worker 当前线程。
+ * @return 始终返回 1。
+ */
+static int do_stats(StressWorker *worker) {
+  ParkingStatistics stats;
+  char detail[STRESS_DETAIL_LEN];
+
+  parking_service_fast_get_statistics(worker->lot, &stats);
+  if (stats.occupied_slots < 0 || stats.occupied_slots > stats.total_slots ||
+      stats.free_slots < 0 || stats.free_slots > stats.total_slots) {
+    sprintf(detail, "统计越界: total=%d occupied=%d free=%d",
+            stats.total_slots, stats.occupied_slots, stats.free_slots);
+    stress_violation(worker, detail);
+  }
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 保存一次快照。
+ * @param worker 当前线程。
+ * @return 始终返回 1。
+ */
+static int do_save(StressWorker *worker) {
+  ServiceResult result =
+      parking_service_save_snapshot(worker->lot, worker->save_path);
+  char detail[STRESS_DETAIL_LEN];
+
+  if (result.code != PARKING_SERVICE_SUCCESS) {
+    sprintf(detail, "快照保存失败: %.100s", result.message);
+    stress_violation(worker, detail);
+  }
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 按权重随机选择操作类型。
+ * @param worker 当前线程。
+ * @param total 权重之和，必须为正。
+ * @return 操作类型。
+ */
+static StressOp pick_op(StressWorker *worker, int total) {
+  long roll = stress_random(&worker->rng, total);
+  int op;
+
+  for (op = 0; op < STRESS_OP_COUNT - 1; op++) {
+    roll -= worker->options->mix[op];
+    if (roll < 0) {
+      break;
+    }
+  }
+  return (StressOp)op;
+}
+
+/**
+ * @brief (静态辅助函数) 工作线程入口：按权重执行 ops_per_thread 次操作。
+ * @param arg 指向 StressWorker 的指针。
+ */
+static void stress_worker(void *arg) {
+  StressWorker *worker = (StressWorker *)arg;
+  const StressOptions *options = worker->options;
+  char plate[MAX_LICENSE_LEN];
+  char detail[STRESS_DETAIL_LEN];
+  int total = 0;
+  long n;
+  int i;
+
+  for (i = 0; i < STRESS_OP_COUNT; i++) {
+    total += options->mix[i];
+  }
+  for (n = 0; n < options->ops_per_thread; n++) {
+    StressOp op = pick_op(worker, total);
+    int done;
+
+    stress_plate(stress_random(&worker->rng, options->plates), plate);
+    switch (op) {
+    case STRESS_OP_ENTRY:
+      done = do_entry(worker, plate);
+      break;
+    case STRESS_OP_EXIT:
+      done = do_exit(worker, plate);
+      break;
+    case STRESS_OP_LOOKUP:
+      done = do_lookup(worker, plate);
+      break;
+    case STRESS_OP_STATS:
+      done = do_stats(worker);
+      break;
+    case STRESS_OP_SAVE:
+      done = do_save(worker);
+      break;
+    default:
+      done = 1;
+      if (check_invariants(worker->lot, detail) != 0) {
+        stress_violation(worker, detail);
+      }
+      break;
+    }
+    worker->ops[op]++;
+    if (!done) {
+      worker->rejected[op]++;
+    }
+  }
+}
+
+/* ========================================================================== */
+/*                                   单轮运行                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 生成停车场：全部车位空闲，使用固定在 10:00 的虚拟时钟。
+ * @details 虚拟时钟让访客入场规则在任何时刻运行都成立。
+ * @param options 测试参数。
+ * @return 新停车场；失败返回 NULL。
+ */
+static ParkingLot *generate_lot(const StressOptions *options) {
+  ParkingLot *lot = init_parking_lot(options->slots);
+  char location[MAX_LOCATION_LEN];
+  struct tm morning;
+  int id;
+
+  if (!lot) {
+    return NULL;
+  }
+  memset(&morning, 0, sizeof(morning));
+  morning.tm_year = 2024 - 1900;
+  morning.tm_mon = 5;
+  morning.tm_mday = 1;
+  morning.tm_hour = 10;
+  morning.tm_isdst = -1;
+  parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL,
+                                  mktime(&morning));
+  for (id = 1; id <= options->slots; id++) {
+    sprintf(location, "S区-%05d", id);
+    if (parking_service_fast_add_slot(lot, id, location) !=
+        PARKING_SERVICE_SUCCESS) {
+      free_parking_lot(lot);
+      return NULL;
+    }
+  }
+  return lot;
+}
+
+/**
+ * @brief (静态辅助函数) 以指定线程数运行一轮并打印一行结果。
+ * @param options 测试参数。
+ * @param threads 本轮的线程数。
+ * @param[in,out] base_rate 第一轮的吞吐量；为 0 时写入本轮的吞吐量。
+ * @return 没有违规返回 0，发现违规返回 2，初始化失败返回 1。
+ */
+static int run_round(const StressOptions *options, int threads,
+                     double *base_rate) {
+  static StressWorker workers[STRESS_MAX_THREADS];
+  ParkingThread *handles[STRESS_MAX_THREADS];
+  unsigned long ops[STRESS_OP_COUNT];
+  unsigned long rejected = 0;
+  unsigned long violations = 0;
+  unsigned long total_ops = 0;
+  char detail[STRESS_DETAIL_LEN];
+  char final_detail[STRESS_DETAIL_LEN];
+  ParkingLot *lot = generate_lot(options);
+  double started;
+  double seconds;
+  double rate;
+  int status = 0;
+  int op;
+  int t;
+
+  if (!lot) {
+    fprintf(stderr, "停车场生成失败\n");
+    return 1;
+  }
+  memset(workers, 0, sizeof(workers));
+  memset(ops, 0, sizeof(ops));
+  for (t = 0; t < threads; t++) {
+    workers[t].lot = lot;
+    workers[t].options = options;
+    workers[t].index = t;
+    workers[t].rng = options->seed + 7919UL * (unsigned long)(t + 1);
+    sprintf(workers[t].save_path, "%.200s-%d.snap", options->save_prefix, t);
+  }
+
+  started = stress_now_seconds();
+  for (t = 0; t < threads; t++) {
+    handles[t] = parking_thread_start(stress_worker, &workers[t]);
+  }
+  for (t = 0; t < threads; t++) {
+    if (handles[t]) {
+      parking_thread_join(handles[t]);
+    } else {
+      status = 1;
+    }
+  }
+  seconds = stress_now_seconds() - started;
+  if (status != 0) {
+    fprintf(stderr, "线程创建失败\n");
+    free_parking_lot(lot);
+    return status;
+  }
+
+  for (t = 0; t < threads; t++) {
+    for (op = 0; op < STRESS_OP_COUNT; op++) {
+      ops[op] += workers[t].ops[op];
+      rejected += workers[t].rejected[op];
+      total_ops += workers[t].ops[op];
+    }
+    if (workers[t].violations > 0) {
+      if (violations == 0) {
+        strcpy(detail, workers[t].detail);
+      }
+      violations += workers[t].violations;
+    }
+    remove(workers[t].save_path);
+    strcat(workers[t].save_path, INDEX_IMAGE_SUFFIX);
+    remove(workers[t].save_path);
+  }
+  if (check_invariants(lot, final_detail) != 0) {
+    if (violations == 0) {
+      strcpy(detail, final_detail);
+    }
+    violations++;
+  }
+
+  rate = seconds > 0.0 ? (double)total_ops / seconds : 0.0;
+  if (*base_rate == 0.0) {
+    *base_rate = rate;
+  }
+  printf("%7d %10lu %9lu %7lu %7lu %10d %10.3f %12.0f %8.2f %10lu\n", threads,
+         total_ops, rejected, ops[STRESS_OP_SAVE], ops[STRESS_OP_CHECK],
+         lot->occupied_slots, seconds, rate,
+         *base_rate > 0.0 ? rate / *base_rate : 0.0, violations);
+  if (violations > 0) {
+    fprintf(stderr, "threads=%d 违规: %s\n", threads, detail);
+    status = 2;
+  }
+  free_parking_lot(lot);
+  return status;
+}
+
+/* ========================================================================== */
+/*                                   参数解析                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 打印命令行用法。
+ * @param program 程序名。
+ */
+static void print_usage(const char *program) {
+  fprintf(stderr,
+          "用法: %s [--slots N] [--plates N] [--threads N,N,...]\n"
+          "       [--ops 每线程操作数] [--seed 种子]\n"
+          "       [--mix 入场:出场:查找:统计:保存:核对] [--save-prefix 路径]\n",
+          program);
+}
+
+/**
+ * @brief (静态辅助函数) 解析以冒号分隔的操作权重。
+ * @param text 权重字符串。
+ * @param[out] mix 接收 STRESS_OP_COUNT 个权重。
+ * @return 格式正确且权重之和为正返回 1，否则返回 0。
+ */
+static int parse_mix(const char *text, int *mix) {
+  int total = 0;
+  int i;
+
+  for (i = 0; i < STRESS_OP_COUNT; i++) {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value < 0 || value > 10000 ||
+        (i < STRESS_OP_COUNT - 1 ? *end != ':' : *end != '\0')) {
+      return 0;
+    }
+    mix[i] = (int)value;
+    total += mix[i];
+    text = end + 1;
+  }
+  return total > 0;
+}
+
+/**
+ * @brief (静态辅助函数) 解析以逗号分隔的线程数列表。
+ * @param text 列表字符串。
+ * @param[out] options 接收 rounds 与 round_count。
+ * @return 格式正确返回 1，否则返回 0。
+ */
+static int parse_rounds(const char *text, StressOptions *options) {
+  options->round_count = 0;
+  for (;;) {
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value <= 0 || value > STRESS_MAX_THREADS ||
+        options->round_count == STRESS_MAX_ROUNDS) {
+      return 0;
+    }
+    options->rounds[options->round_count++] = (int)value;
+    if (*end == '\0') {
+      return 1;
+    }
+    if (*end != ',') {
+      return 0;
+    }
+    text = end + 1;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 解析命令行参数。
+ * @details 未指定 --threads 时依次运行 1、2、4…… 直到 CPU 核数。
+ * @param argc 参数个数。
+ * @param argv 参数数组。
+ * @param[out] options 接收解析结果。
+ * @return 参数合法返回 1，否则返回 0。
+ */
+static int parse_options(int argc, char **argv, StressOptions *options) {
+  int cpus = parking_cpu_count();
+  int threads;
+  int i;
+
+  options->slots = 2000;
+  options->plates = 3000;
+  options->ops_per_thread = 100000;
+  options->round_count = 0;
+  for (threads = 1; options->round_count < STRESS_MAX_ROUNDS &&
+                    threads <= STRESS_MAX_THREADS;
+       threads *= 2) {
+    options->rounds[options->round_count++] = threads < cpus ? threads : cpus;
+    if (threads >= cpus) {
+      break;
+    }
+  }
+  options->mix[STRESS_OP_ENTRY] = 300;
+  options->mix[STRESS_OP_EXIT] = 300;
+  options->mix[STRESS_OP_LOOKUP] = 340;
+  options->mix[STRESS_OP_STATS] = 50;
+  options->mix[STRESS_OP_SAVE] = 1;
+  options->mix[STRESS_OP_CHECK] = 9;
+  options->seed = 20240601UL;
+  options->save_prefix = "stress_parking";
+
+  for (i = 1; i + 1 < argc; i += 2) {
+    const char *value = argv[i + 1];
+
+    if (strcmp(argv[i], "--slots") == 0) {
+      options->slots = atoi(value);
+    } else if (strcmp(argv[i], "--plates") == 0) {
+      options->plates = atoi(value);
+    } else if (strcmp(argv[i], "--threads") == 0) {
+      if (!parse_rounds(value, options)) {
+        return 0;
+      }
+    } else if (strcmp(argv[i], "--ops") == 0) {
+      options->ops_per_thread = atol(value);
+    } else if (strcmp(argv[i], "--seed") == 0) {
+      options->seed = strtoul(value, NULL, 10);
+    } else if (strcmp(argv[i], "--mix") == 0) {
+      if (!parse_mix(value, options->mix)) {
+        return 0;
+      }
+    } else if (strcmp(argv[i], "--save-prefix") == 0) {
+      options->save_prefix = value;
+    } else {
+      return 0;
+    }
+  }
+  return i == argc && options->slots > 0 &&
+         options->slots <= VALIDATE_MAX_SLOT_ID && options->plates > 0 &&
+         options->plates <= 1000000 && options->ops_per_thread > 0 &&
+         options->save_prefix[0] != '\0';
+}
+
+/**
+ * @brief 主函数：按线程数列表逐轮运行压力测试并输出扩展曲线。
+ * @param argc 参数个数。
+ * @param argv 参数数组。
+ * @return 全部通过返回 0，参数错误或初始化失败返回 1，发现违规返回 2。
+ */
+int main(int argc, char **argv) {
+  StressOptions options;
+  double base_rate = 0.0;
+  int status = 0;
+  int round;
+  int op;
+
+  if (!parse_options(argc, argv, &options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  printf("slots=%d plates=%d ops_per_thread=%ld seed=%lu mix=", options.slots,
+         options.plates, options.ops_per_thread, options.seed);
+  for (op = 0; op < STRESS_OP_COUNT; op++) {
+    printf("%s%s=%d", op ? "," : "", stress_op_names[op], options.mix[op]);
+  }
+  printf("\n%7s %10s %9s %7s %7s %10s %10s %12s %8s %10s\n", "threads",
+         "ops", "rejected", "saves", "checks", "occupied", "elapsed_s",
+         "ops/s", "speedup", "violations");
+  for (round = 0; round < options.round_count; round++) {
+    int result = run_round(&options, options.rounds[round], &base_rate);
+
+    if (result > status) {
+      status = result;
+    }
+    if (result == 1) {
+      break;
+    }
+  }
+  return status;
+}
@@ -7,6 +7,7 @@
  * 它不涉及任何服务层或UI层的逻辑，旨在提供一个纯粹的数据层API使用范例。
  */
 
+#include <locale.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,7 +16,6 @@
 #include "../src/parking_data.h"
 
 #ifdef _WIN32
-#include <locale.h>
 #include <windows.h>
 #endif
 
@@ -124,13 +124,10 @@ void demo_statistics(void) {
 
   slot = create_parking_slot(3, "B-1");
   add_parking_slot(lot, slot);
-  /* 手动设置访客数据以绕过服务层的时间检查 */
-  slot->status = OCCUPIED_STATUS;
+  /* 先以居民身份入场，再手动改为访客以绕过访客时段检查 */
+  allocate_slot(lot, 3, "访客C", "V001", "333", RESIDENT_TYPE);
   slot->type = VISITOR_TYPE;
-  strcpy(slot->owner_name, "访客C");
-  strcpy(slot->license_plate, "V001");
-  slot->entry_time = time(NULL);
-  lot->occupied_slots++;
+  sync_slot_hot_fields(lot, slot); /* 同步热字段列并更新占用计数 */
 
   today = time(NULL);
   resident_count = count_daily_parking(lot, today, RESIDENT_TYPE);
@@ -0,0 +1,687 @@
+/**
+ * @file parking_simulator.c
+ * @brief 停车场容量规划模拟程序
+ * @details
+ * 该程序在虚拟时钟下回放一段出入场事件，用于评估车位数量是否够用。
+ * 事件来源有两种：
+ * - 事件轨迹文件（--trace）：每行一个事件，格式为
+ *   `<unix时间> E <车牌> <R|V> [车主] [联系方式]` 或 `<unix时间> X <车牌>`，
+ *   时间必须非递减，以 '#' 开头的行为注释；
+ * - 合成负载（--poisson）：按泊松过程生成到达，停车时长服从指数分布。
+ * 每个事件发生前把停车场的虚拟时钟拨到事件时刻，然后调用快速服务接口
+ * 完成入场或出场，因此计费、访客时段校验等规则与线上一致，
+ * 而一天的业务量可以在毫秒级内跑完。
+ * 结束时输出逐小时的占用曲线、按原因统计的拒绝次数、总收入与每秒事件数。
+ */
+
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/parking_service.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define SIM_SECONDS_PER_HOUR 3600L  /**< 每小时的秒数，用于占用曲线采样。 */
+#define SIM_MAX_SAMPLES (24 * 366) /**< 占用曲线最多记录的小时数。 */
+#define SIM_PLATE_LEN 32            /**< 模拟程序内部车牌缓冲区长度。 */
+#define SIM_LINE_LEN 256            /**< 事件轨迹文件单行的最大长度。 */
+#define SIM_DEFAULT_OWNER "模拟车主"  /**< 轨迹未给出车主时使用的姓名。 */
+#define SIM_DEFAULT_CONTACT "13800000000" /**< 轨迹未给出联系方式时使用的号码。 */
+
+/**
+ * @brief 模拟参数。
+ */
+typedef struct SimOptions {
+  int slots;                /**< 车位数量。 */
+  const char *trace_path;   /**< 事件轨迹文件，为 NULL 时使用合成负载。 */
+  double arrivals_per_hour; /**< 合成负载的平均到达率（辆/小时）。 */
+  double hours;             /**< 合成负载的模拟时长（小时）。 */
+  double mean_stay_minutes; /**< 合成负载的平均停车时长（分钟）。 */
+  double visitor_ratio;     /**< 合成负载中访客车辆所占比例。 */
+  unsigned long seed;       /**< 随机数种子。 */
+  time_t start;             /**< 模拟的起始时刻。 */
+} SimOptions;
+
+/**
+ * @brief 一个尚未发生的出场事件（合成负载使用）。
+ */
+typedef struct PendingExit {
+  time_t when;                /**< 出场时刻。 */
+  char plate[SIM_PLATE_LEN];  /**< 车牌号。 */
+} PendingExit;
+
+/**
+ * @brief 按出场时刻排序的最小堆。
+ */
+typedef struct ExitHeap {
+  PendingExit *items; /**< 堆数组。 */
+  size_t count;       /**< 元素个数。 */
+  size_t capacity;    /**< 数组容量。 */
+} ExitHeap;
+
+/**
+ * @brief 模拟过程中累计的结果。
+ */
+typedef struct SimReport {
+  long entries;               /**< 成功入场次数。 */
+  long exits;                 /**< 成功出场次数。 */
+  long rejected_full;         /**< 因车位已满被拒绝的入场次数。 */
+  long rejected_time;         /**< 因访客时段不符被拒绝的入场次数。 */
+  long rejected_duplicate;    /**< 因车牌已在场内被拒绝的入场次数。 */
+  long rejected_other;        /**< 其他原因失败的事件数。 */
+  long unknown_exits;         /**< 车牌不在场内的出场事件数。 */
+  long events;                /**< 处理的事件总数。 */
+  int peak_occupied;          /**< 占用车位数的峰值。 */
+  double revenue;             /**< 出场收取的费用合计（元）。 */
+  time_t first_time;          /**< 第一个事件的时刻。 */
+  time_t last_time;           /**< 最后一个事件的时刻。 */
+  time_t next_sample;         /**< 下一个占用采样时刻。 */
+  int samples[SIM_MAX_SAMPLES]; /**< 每个整点的占用车位数。 */
+  int sample_count;           /**< 已记录的采样数。 */
+} SimReport;
+
+void setup_console_encoding(void);
+void print_separator(const char *title);
+static void print_usage(const char *program);
+static int parse_options(int argc, char **argv, SimOptions *options);
+static ParkingLot *create_lot(const SimOptions *options);
+static int run_trace(ParkingLot *lot, const SimOptions *options,
+                     SimReport *report);
+static int run_poisson(ParkingLot *lot, const SimOptions *options,
+                       SimReport *report);
+static void print_report(const ParkingLot *lot, const SimReport *report,
+                         double wall_seconds);
+
+/**
+ * @brief 主函数，解析参数并运行一次模拟。
+ * @param argc 参数个数。
+ * @param argv 参数数组。
+ * @return 模拟成功返回 0，参数错误或运行失败返回 1。
+ */
+int main(int argc, char **argv) {
+  SimOptions options;
+  SimReport *report;
+  ParkingLot *lot;
+  clock_t started;
+  double wall_seconds;
+  int status;
+
+  setup_console_encoding();
+  if (!parse_options(argc, argv, &options)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  lot = create_lot(&options);
+  report = (SimReport *)calloc(1, sizeof(SimReport));
+  if (!lot || !report) {
+    printf("停车场初始化失败！\n");
+    free(report);
+    free_parking_lot(lot);
+    return 1;
+  }
+
+  started = clock();
+  status = options.trace_path ? run_trace(lot, &options, report)
+                              : run_poisson(lot, &options, report);
+  wall_seconds = (double)(clock() - started) / CLOCKS_PER_SEC;
+
+  if (status) {
+    print_report(lot, report, wall_seconds);
+  }
+  free(report);
+  free_parking_lot(lot);
+  return status ? 0 : 1;
+}
+
+/* ========================================================================== */
+/*                                   参数与初始化                             */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 打印命令行用法。
+ * @param program 程序名。
+ */
+static void print_usage(const char *program) {
+  printf("用法: %s [--slots N] [--trace 文件]\n", program);
+  printf("       [--poisson 每小时到达数] [--hours 小时] [--stay 平均分钟]\n");
+  printf("       [--visitors 访客比例] [--seed 种子] [--start unix时间]\n");
+}
+
+/**
+ * @brief (静态辅助函数) 解析命令行参数。
+ * @details 未指定 --start 时从当天 00:00（本地时间）开始，
+ *          使访客时段校验在合成负载中也能按真实钟点生效。
+ * @param argc 参数个数。
+ * @param argv 参数数组。
+ * @param[out] options 接收解析结果。
+ * @return 参数合法返回 1，否则返回 0。
+ */
+static int parse_options(int argc, char **argv, SimOptions *options) {
+  struct tm *midnight;
+  time_t now = time(NULL);
+  int i;
+
+  options->slots = 200;
+  options->trace_path = NULL;
+  options->arrivals_per_hour = 60.0;
+  options->hours = 24.0;
+  options->mean_stay_minutes = 180.0;
+  options->visitor_ratio = 0.3;
+  options->seed = 20240601UL;
+  midnight = localtime(&now);
+  if (midnight) {
+    midnight->tm_hour = 0;
+    midnight->tm_min = 0;
+    midnight->tm_sec = 0;
+    options->start = mktime(midnight);
+  } else {
+    options->start = now;
+  }
+
+  for (i = 1; i < argc; i++) {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (strcmp(argv[i], "--help") == 0) {
+      return 0;
+    }
+    if (value == NULL) {
+      printf("参数 %s 缺少取值\n", argv[i]);
+      return 0;
+    }
+    if (strcmp(argv[i], "--slots") == 0) {
+      options->slots = atoi(value);
+    } else if (strcmp(argv[i], "--trace") == 0) {
+      options->trace_path = value;
+    } else if (strcmp(argv[i], "--poisson") == 0) {
+      options->arrivals_per_hour = atof(value);
+    } else if (strcmp(argv[i], "--hours") == 0) {
+      options->hours = atof(value);
+    } else if (strcmp(argv[i], "--stay") == 0) {
+      options->mean_stay_minutes = atof(value);
+    } else if (strcmp(argv[i], "--visitors") == 0) {
+      options->visitor_ratio = atof(value);
+    } else if (strcmp(argv[i], "--seed") == 0) {
+      options->seed = strtoul(value, NULL, 10);
+    } else if (strcmp(argv[i], "--start") == 0) {
+      options->start = (time_t)atol(value);
+    } else {
+      printf("未知参数: %s\n", argv[i]);
+      return 0;
+    }
+    i++;
+  }
+
+  if (options->slots <= 0 || options->slots > VALIDATE_MAX_SLOT_ID ||
+      options->arrivals_per_hour <= 0.0 || options->hours <= 0.0 ||
+      options->mean_stay_minutes <= 0.0 || options->visitor_ratio < 0.0 ||
+      options->visitor_ratio > 1.0) {
+    printf("参数取值超出范围\n");
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 创建模拟用的停车场并切换到虚拟时钟。
+ * @param options 模拟参数。
+ * @return 新停车场；失败返回 NULL。
+ */
+static ParkingLot *create_lot(const SimOptions *options) {
+  ParkingLot *lot = init_parking_lot(options->slots);
+  ServiceResult result;
+  char location[32];
+  int id;
+
+  if (!lot) {
+    return NULL;
+  }
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL,
+                                           options->start);
+  if (!parking_service_is_success(result)) {
+    free_parking_lot(lot);
+    return NULL;
+  }
+  for (id = 1; id <= options->slots; id++) {
+    sprintf(location, "模拟区-%d", (id - 1) / 100 + 1);
+    if (parking_service_fast_add_slot(lot, id, location) !=
+        PARKING_SERVICE_SUCCESS) {
+      free_parking_lot(lot);
+      return NULL;
+    }
+  }
+  return lot;
+}
+
+/* ========================================================================== */
+/*                                   事件处理                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 把占用曲线采样推进到给定时刻。
+ * @details 对 (上次采样, when] 之间的每个整点，记录当时的占用车位数。
+ *          事件之间占用数不变，因此用处理该事件前的值即可。
+ * @param lot 目标停车场。
+ * @param report 模拟结果。
+ * @param when 即将处理的事件时刻。
+ */
+static void sample_until(const ParkingLot *lot, SimReport *report,
+                         time_t when) {
+  ParkingStatistics stats;
+
+  if (report->events == 0) {
+    report->first_time = when;
+    report->next_sample = when;
+  }
+  if (when < report->next_sample || report->sample_count >= SIM_MAX_SAMPLES) {
+    return;
+  }
+  parking_service_fast_get_statistics(lot, &stats);
+  while (report->next_sample <= when &&
+         report->sample_count < SIM_MAX_SAMPLES) {
+    report->samples[report->sample_count++] = stats.occupied_slots;
+    report->next_sample += SIM_SECONDS_PER_HOUR;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 在虚拟时刻 when 处理一次入场。
+ * @param lot 目标停车场。
+ * @param report 模拟结果。
+ * @param when 事件时刻。
+ * @param plate 车牌号。
+ * @param type 停车类型。
+ * @param owner 车主姓名。
+ * @param contact 联系方式。
+ * @return 入场成功返回 1，否则返回 0。
+ */
+static int simulate_entry(ParkingLot *lot, SimReport *report, time_t when,
+                          const char *plate, ParkingType type,
+                          const char *owner, const char *contact) {
+  ParkingServiceResultCode code;
+  ParkingStatistics stats;
+
+  sample_until(lot, report, when);
+  set_parking_clock(lot, when);
+  report->events++;
+  report->last_time = when;
+
+  code = parking_service_fast_allocate_any_slot(lot, owner, plate, contact,
+                                                type, NULL);
+  switch (code) {
+  case PARKING_SERVICE_SUCCESS:
+    report->entries++;
+    parking_service_fast_get_statistics(lot, &stats);
+    if (stats.occupied_slots > report->peak_occupied) {
+      report->peak_occupied = stats.occupied_slots;
+    }
+    return 1;
+  case PARKING_SERVICE_SLOT_NOT_FOUND:
+    report->rejected_full++;
+    break;
+  case PARKING_SERVICE_TIME_INVALID:
+    report->rejected_time++;
+    break;
+  case PARKING_SERVICE_LICENSE_EXISTS:
+    report->rejected_duplicate++;
+    break;
+  default:
+    report->rejected_other++;
+    break;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 在虚拟时刻 when 处理一次出场并累计收入。
+ * @param lot 目标停车场。
+ * @param report 模拟结果。
+ * @param when 事件时刻。
+ * @param plate 车牌号。
+ */
+static void simulate_exit(ParkingLot *lot, SimReport *report, time_t when,
+                          const char *plate) {
+  ExitReceipt receipt;
+  ParkingSlot *slot = NULL;
+
+  sample_until(lot, report, when);
+  set_parking_clock(lot, when);
+  report->events++;
+  report->last_time = when;
+
+  if (parking_service_fast_find_slot_by_license(lot, plate, &slot) !=
+          PARKING_SERVICE_SUCCESS ||
+      !slot) {
+    report->unknown_exits++;
+    return;
+  }
+  if (parking_service_fast_deallocate_slot(lot, slot->slot_id, &receipt) !=
+      PARKING_SERVICE_SUCCESS) {
+    report->rejected_other++;
+    return;
+  }
+  report->exits++;
+  report->revenue += receipt.amount;
+}
+
+/* ========================================================================== */
+/*                                   事件轨迹回放                             */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 回放事件轨迹文件。
+ * @param lot 目标停车场。
+ * @param options 模拟参数。
+ * @param report 模拟结果。
+ * @return 成功返回 1；文件无法打开或格式错误返回 0。
+ */
+static int run_trace(ParkingLot *lot, const SimOptions *options,
+                     SimReport *report) {
+  char line[SIM_LINE_LEN];
+  char format[64];
+  char plate[SIM_LINE_LEN];
+  char owner[SIM_LINE_LEN];
+  char contact[SIM_LINE_LEN];
+  char kind;
+  char type;
+  long when;
+  long previous = 0;
+  long line_no = 0;
+  int fields;
+  FILE *fp = fopen(options->trace_path, "r");
+
+  if (!fp) {
+    printf("无法打开事件轨迹文件: %s\n", options->trace_path);
+    return 0;
+  }
+  /* 字段缓冲区与整行一样长，任何字段都不会写越界；超长的字段随后按格式
+   * 错误拒绝，而不是截断后把剩余部分当作下一个字段 */
+  sprintf(format, "%%ld %%c %%%ds %%c %%%ds %%%ds", SIM_LINE_LEN - 1,
+          SIM_LINE_LEN - 1, SIM_LINE_LEN - 1);
+
+  while (fgets(line, sizeof(line), fp)) {
+    line_no++;
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' ||
+        line[0] == '\0') {
+      continue;
+    }
+    strcpy(owner, SIM_DEFAULT_OWNER);
+    strcpy(contact, SIM_DEFAULT_CONTACT);
+    type = 'V';
+    fields = sscanf(line, format, &when, &kind, plate, &type, owner, contact);
+    if (fields < 3 || (kind != 'E' && kind != 'X') ||
+        strlen(plate) >= SIM_PLATE_LEN || strlen(owner) >= MAX_NAME_LEN ||
+        strlen(contact) >= MAX_CONTACT_LEN ||
+        (kind == 'E' && fields < 4) || (type != 'R' && type != 'V') ||
+        (report->events > 0 && when < previous)) {
+      printf("事件轨迹第 %ld 行格式错误\n", line_no);
+      fclose(fp);
+      return 0;
+    }
+    previous = when;
+    if (kind == 'E') {
+      simulate_entry(lot, report, (time_t)when, plate,
+                     type == 'R' ? RESIDENT_TYPE : VISITOR_TYPE, owner,
+                     contact);
+    } else {
+      simulate_exit(lot, report, (time_t)when, plate);
+    }
+  }
+  fclose(fp);
+  return 1;
+}
+
+/* ========================================================================== */
+/*                                   合成负载                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) xorshift32 伪随机数生成器。
+ * @details 不依赖 rand() 的实现与 RAND_MAX，同一种子在各平台给出同一序列。
+ * @param state 生成器状态，不能为 0。
+ * @return [0, 1) 内的均匀随机数。
+ */
+static double next_uniform(unsigned long *state) {
+  unsigned long x = *state;
+
+  x ^= (x << 13) & 0xFFFFFFFFUL;
+  x ^= x >> 17;
+  x ^= (x << 5) & 0xFFFFFFFFUL;
+  *state = x & 0xFFFFFFFFUL;
+  return (double)(*state >> 8) / 16777216.0;
+}
+
+/**
+ * @brief (静态辅助函数) 生成均值为 mean 的指数分布随机数。
+ * @param state 生成器状态。
+ * @param mean 分布均值。
+ * @return 随机数。
+ */
+static double next_exponential(unsigned long *state, double mean) {
+  return -log(1.0 - next_uniform(state)) * mean;
+}
+
+/**
+ * @brief (静态辅助函数) 向出场堆插入一个事件。
+ * @param heap 目标堆。
+ * @param when 出场时刻。
+ * @param plate 车牌号。
+ * @return 成功返回 1，内存不足返回 0。
+ */
+static int heap_push(ExitHeap *heap, time_t when, const char *plate) {
+  size_t i;
+
+  if (heap->count == heap->capacity) {
+    size_t capacity = heap->capacity ? heap->capacity * 2 : 64;
+    PendingExit *items = (PendingExit *)realloc(
+        heap->items, capacity * sizeof(PendingExit));
+    if (!items) {
+      return 0;
+    }
+    heap->items = items;
+    heap->capacity = capacity;
+  }
+
+  i = heap->count++;
+  while (i > 0 && heap->items[(i - 1) / 2].when > when) {
+    heap->items[i] = heap->items[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap->items[i].when = when;
+  strcpy(heap->items[i].plate, plate);
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 弹出最早的出场事件。
+ * @param heap 目标堆，调用者保证非空。
+ * @param[out] out 接收弹出的事件。
+ */
+static void heap_pop(ExitHeap *heap, PendingExit *out) {
+  PendingExit last;
+  size_t i = 0;
+
+  *out = heap->items[0];
+  last = heap->items[--heap->count];
+  for (;;) {
+    size_t child = i * 2 + 1;
+    if (child >= heap->count) {
+      break;
+    }
+    if (child + 1 < heap->count &&
+        heap->items[child + 1].when < heap->items[child].when) {
+      child++;
+    }
+    if (heap->items[child].when >= last.when) {
+      break;
+    }
+    heap->items[i] = heap->items[child];
+    i = child;
+  }
+  if (heap->count > 0) {
+    heap->items[i] = last;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 处理所有不晚于 until 的待出场车辆。
+ * @param lot 目标停车场。
+ * @param report 模拟结果。
+ * @param heap 出场堆。
+ * @param until 截止时刻。
+ * @param all 为非 0 时忽略 until，处理堆中全部车辆。
+ */
+static void drain_exits(ParkingLot *lot, SimReport *report, ExitHeap *heap,
+                        time_t until, int all) {
+  PendingExit next;
+
+  while (heap->count > 0 && (all || heap->items[0].when <= until)) {
+    heap_pop(heap, &next);
+    simulate_exit(lot, report, next.when, next.plate);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 运行泊松到达的合成负载。
+ * @details 到达间隔与停车时长都服从指数分布；车辆入场成功后
+ *          把其出场事件压入按时刻排序的最小堆，并在下一次到达前
+ *          处理所有已到期的出场。模拟时长结束后不再有新到达，
+ *          场内剩余车辆全部按各自的出场时刻离场，以便收入完整结算。
+ * @param lot 目标停车场。
+ * @param options 模拟参数。
+ * @param report 模拟结果。
+ * @return 成功返回 1，内存不足返回 0。
+ */
+static int run_poisson(ParkingLot *lot, const SimOptions *options,
+                       SimReport *report) {
+  ExitHeap heap = {NULL, 0, 0};
+  unsigned long state = options->seed ? options->seed : 1UL;
+  double mean_gap = 3600.0 / options->arrivals_per_hour;
+  double mean_stay = options->mean_stay_minutes * 60.0;
+  double offset = 0.0;
+  double horizon = options->hours * 3600.0;
+  char plate[SIM_PLATE_LEN];
+  unsigned long serial = 0;
+  int status = 1;
+
+  for (;;) {
+    time_t when;
+    ParkingType type;
+
+    offset += next_exponential(&state, mean_gap);
+    if (offset >= horizon) {
+      break;
+    }
+    when = options->start + (time_t)offset;
+    drain_exits(lot, report, &heap, when, 0);
+
+    /* 车牌由序号生成，尾部 5 位数字保证连续十万辆内不重复 */
+    sprintf(plate, "京A%05lu", serial % 100000UL);
+    serial++;
+    type = next_uniform(&state) < options->visitor_ratio ? VISITOR_TYPE
+                                                         : RESIDENT_TYPE;
+    if (simulate_entry(lot, report, when, plate, type, SIM_DEFAULT_OWNER,
+                       SIM_DEFAULT_CONTACT) &&
+        !heap_push(&heap,
+                   when + 1 + (time_t)next_exponential(&state, mean_stay),
+                   plate)) {
+      status = 0;
+      break;
+    }
+  }
+
+  if (status) {
+    drain_exits(lot, report, &heap, 0, 1);
+  }
+  free(heap.items);
+  return status;
+}
+
+/* ========================================================================== */
+/*                                   结果输出                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 打印模拟报告。
+ * @param lot 目标停车场。
+ * @param report 模拟结果。
+ * @param wall_seconds 模拟耗费的处理器时间（秒）。
+ */
+static void print_report(const ParkingLot *lot, const SimReport *report,
+                         double wall_seconds) {
+  ParkingStatistics stats;
+  int i;
+  int j;
+
+  parking_service_fast_get_statistics(lot, &stats);
+
+  print_separator("占用曲线（整点）");
+  for (i = 0; i < report->sample_count; i++) {
+    double rate = stats.total_slots > 0
+                      ? 100.0 * report->samples[i] / stats.total_slots
+                      : 0.0;
+    printf("第 %4d 小时  占用 %6d  %6.2f%%  ", i, report->samples[i], rate);
+    for (j = 0; j < (int)(rate / 2.5); j++) {
+      putchar('#');
+    }
+    putchar('\n');
+  }
+
+  print_separator("事件统计");
+  printf("模拟跨度:       %.2f 小时\n",
+         (double)(report->last_time - report->first_time) / 3600.0);
+  printf("事件总数:       %ld\n", report->events);
+  printf("成功入场:       %ld\n", report->entries);
+  printf("成功出场:       %ld\n", report->exits);
+  printf("峰值占用:       %d / %d\n", report->peak_occupied,
+         stats.total_slots);
+  printf("拒绝-车位已满:  %ld\n", report->rejected_full);
+  printf("拒绝-访客时段:  %ld\n", report->rejected_time);
+  printf("拒绝-车牌在场:  %ld\n", report->rejected_duplicate);
+  printf("其他失败:       %ld\n", report->rejected_other);
+  printf("未知车辆出场:   %ld\n", report->unknown_exits);
+  printf("期末在场:       %d\n", stats.occupied_slots);
+  printf("总收入:         %.2f 元\n", report->revenue);
+
+  print_separator("吞吐");
+  printf("耗时:           %.3f 秒\n", wall_seconds);
+  if (wall_seconds > 0.0) {
+    printf("事件/秒:        %.0f\n", (double)report->events / wall_seconds);
+  } else {
+    printf("事件/秒:        (耗时过短，无法测量)\n");
+  }
+}
+
+/**
+ * @brief 打印格式化的分隔线。
+ * @param title 要在分隔线中显示的标题文本。
+ */
+void print_separator(const char *title) {
+  printf("\n========== %s ==========\n", title);
+}
+
+/**
+ * @brief 设置控制台编码以支持中文显示。
+ * @details 与 service_demo 相同：Windows 下切换到 UTF-8 代码页，
+ *          其他系统使用 setlocale 设置中文 UTF-8 环境。
+ */
+void setup_console_encoding(void) {
+#ifdef _WIN32
+  SetConsoleOutputCP(CP_UTF8);
+  SetConsoleCP(CP_UTF8);
+  setlocale(LC_ALL, "zh_CN.UTF-8");
+  if (SetConsoleOutputCP(CP_UTF8) == 0) {
+    SetConsoleOutputCP(936);
+    SetConsoleCP(936);
+    setlocale(LC_ALL, "zh_CN.GBK");
+  }
+#else
+  setlocale(LC_ALL, "zh_CN.UTF-8");
+#endif
+}
@@ -8,6 +8,7 @@
  * 并演示了如何正确处理返回的 ServiceResult 对象。
  */
 
+#include <locale.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -18,7 +19,6 @@
 #define SECONDS_PER_MONTH (30 * 24 * 60 * 60)
 
 #ifdef _WIN32
-#include <locale.h>
 #include <windows.h>
 #endif
 
@@ -53,13 +53,14 @@ int main(void) {
  * 3. 为居民和访客分配车位 (`parking_service_allocate_slot`)。
  * 4. 查询并打印停车场统计信息 (`parking_service_get_statistics`)。
  * 5. 模拟车辆出场并计算费用
- * (`parking_service_deallocate_slot`)，包括居民欠费和访客正常计费两种情况。
+ * (`parking_service_checkout_slot`)，包括居民欠费和访客正常计费两种情况。
  * 6. 将最终的停车场数据保存到文件 (`parking_service_save_data`)。
  * 7. 清理所有分配的资源。
  */
 void demonstrate_service_layer(void) {
   ParkingLot *lot;
   ServiceResult result;
+  ExitReceipt receipt;
 
   lot = init_parking_lot(10);
   if (!lot) {
@@ -116,12 +117,12 @@ void demonstrate_service_layer(void) {
   if (resident_slot) {
     /* 模拟欠费1个月 */
     resident_slot->resident_due_date = time(NULL) - (SECONDS_PER_MONTH + 1);
+    sync_slot_hot_fields(lot, resident_slot);
   }
-  result = parking_service_deallocate_slot(lot, 101);
+  result = parking_service_checkout_slot(lot, 101, &receipt);
   if (parking_service_is_success(result)) {
-    double fee = result.data ? *((double *)result.data) : 0.0;
-    printf("✓ 居民车辆出场成功。补缴费用: %.2f元\n", fee);
-    parking_service_free_result(&result);
+    printf("✓ 居民车辆出场成功。补缴 %d 个月，费用: %.2f元\n",
+           receipt.overdue_months, receipt.amount);
   } else {
     parking_service_print_error(result);
   }
@@ -130,12 +131,12 @@ void demonstrate_service_layer(void) {
   ParkingSlot *visitor_slot = find_slot_by_id(lot, 102);
   if (visitor_slot) {
     visitor_slot->entry_time = time(NULL) - (time_t)(2.5 * 3600);
+    sync_slot_hot_fields(lot, visitor_slot);
   }
-  result = parking_service_deallocate_slot(lot, 102);
+  result = parking_service_checkout_slot(lot, 102, &receipt);
   if (parking_service_is_success(result)) {
-    double fee = result.data ? *((double *)result.data) : 0.0;
-    printf("✓ 访客车辆出场成功。停车费用: %.2f元\n", fee);
-    parking_service_free_result(&result);
+    printf("✓ 访客车辆出场成功。计费 %d 小时，停车费用: %.2f元\n",
+           receipt.billed_hours, receipt.amount);
   } else {
     parking_service_print_error(result);
   }
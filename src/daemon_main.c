@@ -0,0 +1,91 @@
+/**
+ * @file daemon_main.c
+ * @brief 网络服务程序入口文件
+ * @details
+ * 以网络服务方式运行停车管理系统，供闸机控制器等程序调用，协议见
+ * parking_daemon.h。用法：
+ *
+ *     Parking-Daemon [端口 [数据文件 [监听地址]]]
+ *
+ * 启动时从数据文件加载停车场（文件不存在时新建）并启用请求去重表，
+ * 收到 SIGINT 或 SIGTERM 后停止服务并把停车场保存回数据文件。
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "parking_daemon.h"
+#include "parking_dedup.h"
+#include "parking_service.h"
+#include "parking_thread.h"
+
+#define DAEMON_DEFAULT_PORT 7070               /**< 默认监听端口 */
+#define DAEMON_DEFAULT_FILE "parking_data.txt" /**< 默认数据文件 */
+#define DAEMON_DEFAULT_HOST "0.0.0.0"          /**< 默认监听地址 */
+#define DAEMON_DEFAULT_CAPACITY 100            /**< 新建停车场的容量 */
+#define DAEMON_STOP_POLL_MS 200                /**< 检查停止请求的间隔 */
+
+/** 收到停止信号后置 1。 */
+static volatile sig_atomic_t stop_requested = 0;
+
+/**
+ * @brief (静态辅助函数) 信号处理函数：请求停止。
+ * @param sig 信号编号。
+ */
+static void request_stop(int sig) {
+  (void)sig;
+  stop_requested = 1;
+}
+
+/**
+ * @brief 主函数
+ * @param argc 参数个数。
+ * @param argv 参数列表。
+ * @return 正常退出返回 0，启动失败返回 1。
+ */
+int main(int argc, char **argv) {
+  int port = argc > 1 ? atoi(argv[1]) : DAEMON_DEFAULT_PORT;
+  const char *filename = argc > 2 ? argv[2] : DAEMON_DEFAULT_FILE;
+  const char *host = argc > 3 ? argv[3] : DAEMON_DEFAULT_HOST;
+  ServiceResult result = parking_service_load_data(filename);
+  ParkingLot *lot = result.code == PARKING_SERVICE_SUCCESS
+                        ? (ParkingLot *)result.data
+                        : init_parking_lot(DAEMON_DEFAULT_CAPACITY);
+  ParkingDaemon *daemon;
+  ParkingSignal *idle;
+
+  if (lot == NULL) {
+    fprintf(stderr, "停车场初始化失败\n");
+    return 1;
+  }
+  /* 闸机超时重发时返回第一次的结果；去重表不可用时照常服务，只是不去重 */
+  parking_service_configure_request_log(lot, REQUEST_LOG_DEFAULT_CAPACITY);
+  daemon = parking_daemon_start(lot, host, port);
+  idle = parking_signal_create();
+  if (daemon == NULL || idle == NULL) {
+    fprintf(stderr, "无法在 %s:%d 上启动网络服务\n", host, port);
+    parking_daemon_stop(daemon);
+    parking_signal_destroy(idle);
+    free_parking_lot(lot);
+    return 1;
+  }
+
+  signal(SIGINT, request_stop);
+  signal(SIGTERM, request_stop);
+  printf("网络服务已启动：%s:%d，共 %d 个车位\n", host,
+         parking_daemon_port(daemon), lot->slot_count);
+  fflush(stdout);
+  while (!stop_requested) {
+    parking_signal_wait(idle, DAEMON_STOP_POLL_MS);
+  }
+
+  parking_daemon_stop(daemon);
+  parking_signal_destroy(idle);
+  result = parking_service_save_data(lot, filename);
+  if (result.code != PARKING_SERVICE_SUCCESS) {
+    parking_service_print_error(result);
+  }
+  free_parking_lot(lot);
+  return 0;
+}
@@ -3,19 +3,26 @@
  * @brief 主程序入口文件
  * @details
  * 这是整个停车管理系统的入口点。
- * 它的唯一职责是调用UI层的启动函数 `ui_run_parking_system()` 来运行程序。
+ * 不带参数时调用UI层的启动函数 `ui_run_parking_system()` 进入交互菜单；
+ * 带参数时交给 `parking_cli_main()` 以非交互命令模式运行（见 parking_cli.h）。
  * 所有的业务逻辑、数据管理和用户交互都由其他模块处理。
  */
 
+#include "parking_cli.h"
 #include "parking_ui.h"
 
 /**
  * @brief 主函数
  * @details
  * 程序从这里开始执行。
- * @return 程序正常退出时返回0。
+ * @param argc 参数个数。
+ * @param argv 参数列表。
+ * @return 交互模式正常退出时返回0；命令模式返回 parking_cli_main 的退出码。
  */
-int main(void) {
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    return parking_cli_main(argc, argv);
+  }
   /* 调用UI层来启动和管理整个应用程序 */
   ui_run_parking_system();
   return 0;
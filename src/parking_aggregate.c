@@ -0,0 +1,379 @@
+/**
+ * @file parking_aggregate.c
+ * @brief 三级汇总树实现文件
+ * @details
+ * 该文件实现了 parking_aggregate.h 中声明的节点登记、差值传播与读取。
+ * 节点数组在创建时一次分配，登记节点只在末尾追加，读者无需加锁即可
+ * 按编号访问已登记的节点。
+ */
+
+#include <string.h>
+
+#include "parking_aggregate.h"
+#include "parking_calendar.h"
+#include "parking_thread.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 获取汇总树的自旋锁。
+ * @param tree 目标汇总树。
+ */
+static void tree_lock(ParkingAggregate *tree) {
+  while (parking_atomic_exchange_int(&tree->lock, 1) != 0) {
+    while (parking_atomic_load_int(&tree->lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放汇总树的自旋锁。
+ * @param tree 目标汇总树。
+ */
+static void tree_unlock(ParkingAggregate *tree) {
+  parking_atomic_store_int(&tree->lock, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 在树中查找名称（须持有锁，或节点不再增加）。
+ * @param tree 目标汇总树。
+ * @param name 节点名称。
+ * @return 节点编号，找不到返回 -1。
+ */
+static int find_node(const ParkingAggregate *tree, const char *name) {
+  int i;
+
+  for (i = 0; i < tree->count; i++) {
+    if (strcmp(tree->nodes[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief (静态辅助函数) 在 parent 下追加一个节点。
+ * @param tree 目标汇总树。
+ * @param parent 父节点编号。
+ * @param level 新节点的层级。
+ * @param name 新节点的名称。
+ * @return 节点编号；名称无效或已存在返回 -1，节点已满返回 -3。
+ */
+static int add_node(ParkingAggregate *tree, int parent, AggregateLevel level,
+                    const char *name) {
+  AggregateNode *node;
+  int index;
+
+  if (name == NULL || name[0] == '\0' || strlen(name) > AGGREGATE_MAX_NAME) {
+    return -1;
+  }
+  tree_lock(tree);
+  if (find_node(tree, name) >= 0) {
+    tree_unlock(tree);
+    return -1;
+  }
+  if (tree->count == tree->capacity) {
+    tree_unlock(tree);
+    return -3;
+  }
+  index = tree->count;
+  node = &tree->nodes[index];
+  memset(node, 0, sizeof(*node));
+  strcpy(node->name, name);
+  node->level = level;
+  node->parent = parent;
+  if (level == AGGREGATE_SITE) {
+    int ancestor;
+
+    for (ancestor = index; ancestor >= 0;
+         ancestor = tree->nodes[ancestor].parent) {
+      tree->nodes[ancestor].site_count++;
+    }
+  }
+  /* 节点填写完毕后再公开，读者按 count 访问 */
+  parking_atomic_store_int(&tree->count, index + 1);
+  tree_unlock(tree);
+  return index;
+}
+
+/**
+ * @brief (静态辅助函数) 把某一周期的收入差值计入节点。
+ * @details 节点的周期较早时先切换到 key 再累加；较晚时忽略差值。
+ * @param[in,out] cents 节点的周期收入。
+ * @param[in,out] period 节点的周期键。
+ * @param key 差值所属的周期键，0 表示没有收入。
+ * @param delta 差值（分）。
+ */
+static void add_period(volatile long *cents, volatile long *period, long key,
+                       long delta) {
+  long current = parking_atomic_load_long(period);
+
+  if (key == 0 || current > key) {
+    return;
+  }
+  if (current < key) {
+    parking_atomic_store_long(cents, 0);
+    parking_atomic_store_long(period, key);
+  }
+  parking_atomic_add_long(cents, delta);
+}
+
+/**
+ * @brief (静态辅助函数) 把差值从站点逐级累加到公司（须持有锁）。
+ * @param tree 目标汇总树。
+ * @param site 站点节点编号。
+ * @param delta 车位数与收入的差值，周期键取自 revenue_day 与 revenue_month。
+ */
+static void propagate(ParkingAggregate *tree, int site,
+                      const AggregateTotals *delta) {
+  int index;
+
+  for (index = site; index >= 0; index = tree->nodes[index].parent) {
+    AggregateTotals *totals = &tree->nodes[index].totals;
+
+    parking_atomic_add_long(&totals->total_slots, delta->total_slots);
+    parking_atomic_add_long(&totals->occupied_slots, delta->occupied_slots);
+    add_period(&totals->today_cents, &totals->revenue_day, delta->revenue_day,
+               delta->today_cents);
+    add_period(&totals->month_cents, &totals->revenue_month,
+               delta->revenue_month, delta->month_cents);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 求停车场当前值相对站点小计的差值。
+ * @details 周期相同时取收入之差；停车场进入新周期时整笔计入新周期。
+ * @param seen 站点的小计（上次同步的值）。
+ * @param values 停车场的当前值。
+ * @param[out] delta 接收差值。
+ */
+static void diff_totals(const AggregateTotals *seen,
+                        const AggregateTotals *values,
+                        AggregateTotals *delta) {
+  delta->total_slots = values->total_slots - seen->total_slots;
+  delta->occupied_slots = values->occupied_slots - seen->occupied_slots;
+  delta->revenue_day = values->revenue_day;
+  delta->today_cents = values->revenue_day == seen->revenue_day
+                           ? values->today_cents - seen->today_cents
+                           : values->today_cents;
+  delta->revenue_month = values->revenue_month;
+  delta->month_cents = values->revenue_month == seen->revenue_month
+                           ? values->month_cents - seen->month_cents
+                           : values->month_cents;
+}
+
+/**
+ * @brief (静态辅助函数) 判断编号是否为已登记的站点。
+ * @param tree 目标汇总树。
+ * @param site 节点编号。
+ * @return 是站点返回 1，否则返回 0。
+ */
+static int is_site(ParkingAggregate *tree, int site) {
+  return tree != NULL && site > 0 &&
+         site < parking_atomic_load_int(&tree->count) &&
+         tree->nodes[site].level == AGGREGATE_SITE;
+}
+
+/* ========================================================================== */
+/*                                汇总树API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 创建只有公司节点的汇总树。
+ * @param memory 分配来源，NULL 表示 C 堆。
+ * @param company 公司节点的名称。
+ * @param capacity 节点数上限。
+ * @return 成功返回汇总树；参数无效或内存不足返回 NULL。
+ */
+ParkingAggregate *aggregate_create(ParkingMemory *memory, const char *company,
+                                   int capacity) {
+  ParkingAggregate *tree;
+
+  if (company == NULL || company[0] == '\0' ||
+      strlen(company) > AGGREGATE_MAX_NAME || capacity <= 1) {
+    return NULL;
+  }
+  tree = (ParkingAggregate *)parking_memory_calloc(
+      memory, PARKING_MEMORY_INDEX, 1, sizeof(ParkingAggregate));
+  if (tree == NULL) {
+    return NULL;
+  }
+  tree->nodes = (AggregateNode *)parking_memory_calloc(
+      memory, PARKING_MEMORY_INDEX, (size_t)capacity, sizeof(AggregateNode));
+  if (tree->nodes == NULL) {
+    parking_memory_free(memory, tree);
+    return NULL;
+  }
+  strcpy(tree->nodes[AGGREGATE_ROOT].name, company);
+  tree->nodes[AGGREGATE_ROOT].level = AGGREGATE_COMPANY;
+  tree->nodes[AGGREGATE_ROOT].parent = -1;
+  tree->count = 1;
+  tree->capacity = capacity;
+  tree->memory = memory;
+  return tree;
+}
+
+/**
+ * @brief 释放汇总树。
+ * @param tree 要释放的汇总树，可以为 NULL。
+ */
+void aggregate_free(ParkingAggregate *tree) {
+  if (tree == NULL) {
+    return;
+  }
+  parking_memory_free(tree->memory, tree->nodes);
+  parking_memory_free(tree->memory, tree);
+}
+
+/**
+ * @brief 在公司下登记一个区域。
+ * @param tree 目标汇总树。
+ * @param name 区域名称。
+ * @return 节点编号；参数无效或名称已存在返回 -1，节点已满返回 -3。
+ */
+int aggregate_add_region(ParkingAggregate *tree, const char *name) {
+  if (tree == NULL) {
+    return -1;
+  }
+  return add_node(tree, AGGREGATE_ROOT, AGGREGATE_REGION, name);
+}
+
+/**
+ * @brief 在区域下登记一个站点。
+ * @param tree 目标汇总树。
+ * @param region 区域节点编号。
+ * @param name 站点名称。
+ * @return 节点编号；参数无效或名称已存在返回 -1，节点已满返回 -3。
+ */
+int aggregate_add_site(ParkingAggregate *tree, int region, const char *name) {
+  if (tree == NULL || region <= 0 ||
+      region >= parking_atomic_load_int(&tree->count) ||
+      tree->nodes[region].level != AGGREGATE_REGION) {
+    return -1;
+  }
+  return add_node(tree, region, AGGREGATE_SITE, name);
+}
+
+/**
+ * @brief 按名称查找节点。
+ * @param tree 目标汇总树。
+ * @param name 节点名称。
+ * @return 节点编号，找不到返回 -1。
+ */
+int aggregate_find(ParkingAggregate *tree, const char *name) {
+  int index;
+
+  if (tree == NULL || name == NULL) {
+    return -1;
+  }
+  tree_lock(tree);
+  index = find_node(tree, name);
+  tree_unlock(tree);
+  return index;
+}
+
+/**
+ * @brief 让站点挂接一个停车场并计入它的当前值。
+ * @param tree 目标汇总树。
+ * @param site 站点节点编号。
+ * @param lot 停车场。
+ * @param values 停车场的当前值。
+ * @return 成功返回 0，参数无效返回 -1，站点已挂接返回 -2。
+ */
+int aggregate_attach(ParkingAggregate *tree, int site, const void *lot,
+                     const AggregateTotals *values) {
+  AggregateTotals delta;
+
+  if (!is_site(tree, site) || lot == NULL || values == NULL) {
+    return -1;
+  }
+  tree_lock(tree);
+  if (tree->nodes[site].lot != NULL) {
+    tree_unlock(tree);
+    return -2;
+  }
+  tree->nodes[site].lot = lot;
+  diff_totals(&tree->nodes[site].totals, values, &delta);
+  propagate(tree, site, &delta);
+  tree_unlock(tree);
+  return 0;
+}
+
+/**
+ * @brief 把停车场的当前值同步到站点，差值逐级累加到区域与公司。
+ * @param tree 目标汇总树。
+ * @param site 已挂接的站点节点编号。
+ * @param values 停车场的当前值。
+ */
+void aggregate_sync(ParkingAggregate *tree, int site,
+                    const AggregateTotals *values) {
+  AggregateTotals delta;
+
+  if (!is_site(tree, site) || values == NULL) {
+    return;
+  }
+  tree_lock(tree);
+  diff_totals(&tree->nodes[site].totals, values, &delta);
+  propagate(tree, site, &delta);
+  tree_unlock(tree);
+}
+
+/**
+ * @brief 解除站点的挂接，从区域与公司中扣除它的值。
+ * @param tree 目标汇总树。
+ * @param site 站点节点编号。
+ */
+void aggregate_detach(ParkingAggregate *tree, int site) {
+  AggregateTotals *seen;
+  AggregateTotals delta;
+
+  if (!is_site(tree, site)) {
+    return;
+  }
+  tree_lock(tree);
+  seen = &tree->nodes[site].totals;
+  delta.total_slots = -seen->total_slots;
+  delta.occupied_slots = -seen->occupied_slots;
+  delta.today_cents = -seen->today_cents;
+  delta.revenue_day = seen->revenue_day;
+  delta.month_cents = -seen->month_cents;
+  delta.revenue_month = seen->revenue_month;
+  propagate(tree, site, &delta);
+  tree->nodes[site].lot = NULL;
+  tree_unlock(tree);
+}
+
+/**
+ * @brief 读取节点的合计（不加锁）。
+ * @param tree 目标汇总树。
+ * @param node 节点编号。
+ * @param now 读取时刻。
+ * @param[out] reading 接收合计。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int aggregate_read(ParkingAggregate *tree, int node, time_t now,
+                   AggregateReading *reading) {
+  const AggregateTotals *totals;
+  long day;
+  long month;
+
+  if (tree == NULL || reading == NULL || node < 0 ||
+      node >= parking_atomic_load_int(&tree->count)) {
+    return -1;
+  }
+  totals = &tree->nodes[node].totals;
+  parking_calendar_convert(now, &day, &month);
+  reading->total_slots = parking_atomic_load_long(&totals->total_slots);
+  reading->occupied_slots = parking_atomic_load_long(&totals->occupied_slots);
+  reading->today_cents = parking_atomic_load_long(&totals->revenue_day) == day
+                             ? parking_atomic_load_long(&totals->today_cents)
+                             : 0;
+  reading->month_cents =
+      parking_atomic_load_long(&totals->revenue_month) == month
+          ? parking_atomic_load_long(&totals->month_cents)
+          : 0;
+  reading->site_count = tree->nodes[node].site_count;
+  return 0;
+}
@@ -0,0 +1,185 @@
+#ifndef PARKING_AGGREGATE_H
+#define PARKING_AGGREGATE_H
+
+#include <time.h>
+
+#include "parking_memory.h"
+
+/**
+ * @file parking_aggregate.h
+ * @brief 站点、区域、公司三级汇总树的声明。
+ * @details
+ * 各停车场的统计只覆盖自己；区域与全公司的占用、收入若每次都逐个站点
+ * 读取，查询代价随站点数增长（见 parking_registry_report）。汇总树为
+ * 公司、每个区域与每个站点各保存一份小计：停车场的占用或收入变化时，
+ * 数据层在写锁内把差值沿站点、区域、公司逐级累加，只涉及三个节点；
+ * 读取任一节点的合计只需读取该节点，是 O(1) 的，不访问任何停车场。
+ *
+ * 站点节点保存的是上次同步时停车场的值，差值即停车场当前值与它之差。
+ * 收入按日期（月份）分周期：差值带上所属日期，节点的日期较早时先清零
+ * 再累加，较晚时忽略（那是已过去一天的收入）；读取时节点日期不是当日
+ * 即视为 0。
+ *
+ * 节点数在创建时确定，节点只增不删。更新在树的自旋锁内进行；读取不加
+ * 锁，只做原子读，合计可能与各站点之和短暂不一致，但很快收敛。
+ * 汇总树须比挂接在其上的停车场存活得久（或先解除挂接）。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define AGGREGATE_MAX_NAME 32 /**< 节点名称的最大长度（不含结尾的 NUL） */
+#define AGGREGATE_ROOT 0      /**< 公司（根）节点的编号 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 汇总树节点的层级。
+ */
+typedef enum AggregateLevel {
+  AGGREGATE_COMPANY = 0, /**< 公司（根节点）。 */
+  AGGREGATE_REGION = 1,  /**< 区域。 */
+  AGGREGATE_SITE = 2     /**< 站点，挂接一个停车场。 */
+} AggregateLevel;
+
+/**
+ * @brief 一个节点的小计。
+ */
+typedef struct AggregateTotals {
+  volatile long total_slots;    /**< 总车位数。 */
+  volatile long occupied_slots; /**< 已占用车位数。 */
+  volatile long today_cents;    /**< 当日收入（分）。 */
+  volatile long revenue_day;    /**< 当日收入所属日期（YYYYMMDD），0 表示无。 */
+  volatile long month_cents;    /**< 当月收入（分）。 */
+  volatile long revenue_month;  /**< 当月收入所属月份（YYYYMM），0 表示无。 */
+} AggregateTotals;
+
+/**
+ * @brief 汇总树的一个节点。
+ */
+typedef struct AggregateNode {
+  char name[AGGREGATE_MAX_NAME + 1]; /**< 节点名称，在树中唯一。 */
+  AggregateLevel level;              /**< 层级。 */
+  int parent;              /**< 父节点编号，根节点为 -1。 */
+  int site_count;          /**< 子树中的站点数（含自身）。 */
+  const void *lot;         /**< 站点挂接的停车场，NULL 表示未挂接。 */
+  AggregateTotals totals;  /**< 子树的小计。 */
+} AggregateNode;
+
+/**
+ * @brief 站点、区域、公司三级汇总树。
+ */
+typedef struct ParkingAggregate {
+  AggregateNode *nodes;  /**< 节点数组，nodes[0] 为公司。 */
+  volatile int count;    /**< 已有的节点数。 */
+  int capacity;          /**< 节点数上限。 */
+  volatile int lock;     /**< 保护节点登记与小计更新的自旋锁。 */
+  ParkingMemory *memory; /**< 分配来源，NULL 表示 C 堆。 */
+} ParkingAggregate;
+
+/**
+ * @brief 某一时刻读取的节点合计。
+ */
+typedef struct AggregateReading {
+  long total_slots;    /**< 总车位数。 */
+  long occupied_slots; /**< 已占用车位数。 */
+  long today_cents;    /**< 读取时刻所在日期的收入（分）。 */
+  long month_cents;    /**< 读取时刻所在月份的收入（分）。 */
+  int site_count;      /**< 子树中的站点数。 */
+} AggregateReading;
+
+/**
+ *********************************************************************************
+ *                               汇总树API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建只有公司节点的汇总树。
+ * @param memory 分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @param company 公司节点的名称。
+ * @param capacity 节点数上限（含公司节点），必须大于 1。
+ * @return 成功返回汇总树；参数无效或内存不足返回 NULL。
+ */
+ParkingAggregate *aggregate_create(ParkingMemory *memory, const char *company,
+                                   int capacity);
+
+/**
+ * @brief 释放汇总树。
+ * @details 调用者须保证已没有停车场挂接在树上。
+ * @param tree 要释放的汇总树，可以为 NULL。
+ */
+void aggregate_free(ParkingAggregate *tree);
+
+/**
+ * @brief 在公司下登记一个区域。
+ * @param tree 目标汇总树。
+ * @param name 区域名称。
+ * @return 成功返回节点编号；参数无效或名称已存在返回 -1，节点已满返回 -3。
+ */
+int aggregate_add_region(ParkingAggregate *tree, const char *name);
+
+/**
+ * @brief 在区域下登记一个站点。
+ * @param tree 目标汇总树。
+ * @param region 区域节点编号。
+ * @param name 站点名称。
+ * @return 成功返回节点编号；参数无效、region 不是区域或名称已存在返回 -1，
+ *         节点已满返回 -3。
+ */
+int aggregate_add_site(ParkingAggregate *tree, int region, const char *name);
+
+/**
+ * @brief 按名称查找节点。
+ * @param tree 目标汇总树。
+ * @param name 节点名称。
+ * @return 节点编号，找不到返回 -1。
+ */
+int aggregate_find(ParkingAggregate *tree, const char *name);
+
+/**
+ * @brief 让站点挂接一个停车场并计入它的当前值。
+ * @param tree 目标汇总树。
+ * @param site 站点节点编号。
+ * @param lot 停车场（仅作标识）。
+ * @param values 停车场的当前值。
+ * @return 成功返回 0；参数无效或 site 不是站点返回 -1；站点已挂接返回 -2。
+ */
+int aggregate_attach(ParkingAggregate *tree, int site, const void *lot,
+                     const AggregateTotals *values);
+
+/**
+ * @brief 把停车场的当前值同步到站点，差值逐级累加到区域与公司。
+ * @param tree 目标汇总树。
+ * @param site 已挂接的站点节点编号。
+ * @param values 停车场的当前值。
+ */
+void aggregate_sync(ParkingAggregate *tree, int site,
+                    const AggregateTotals *values);
+
+/**
+ * @brief 解除站点的挂接，从区域与公司中扣除它的值。
+ * @param tree 目标汇总树。
+ * @param site 站点节点编号。
+ */
+void aggregate_detach(ParkingAggregate *tree, int site);
+
+/**
+ * @brief 读取节点的合计（不加锁）。
+ * @param tree 目标汇总树。
+ * @param node 节点编号。
+ * @param now 读取时刻，决定当日与当月收入所属的周期。
+ * @param[out] reading 接收合计。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int aggregate_read(ParkingAggregate *tree, int node, time_t now,
+                   AggregateReading *reading);
+
+#endif /* PARKING_AGGREGATE_H */
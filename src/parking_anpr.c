@@ -0,0 +1,751 @@
+/**
+ * @file parking_anpr.c
+ * @brief 车牌识别流水线实现文件
+ * @details
+ * 该文件实现了 parking_anpr.h 中声明的五阶段流水线。每个阶段队列只有
+ * 一个生产者（上一阶段或持有提交锁的提交者）和一个消费者，读写下标各由
+ * 一方写入，靠原子读写即可同步；下标在 [0, 2 * capacity) 内循环，
+ * 以区分队列满与空。等待的一方先声明等待再检查一次队列，
+ * 另一方只在读到等待标记时才触发信号。
+ * 上游阶段退出前关闭下游队列，下游取完剩余读数后随之退出，
+ * 停止时只需关闭第一个队列并按顺序等待各线程。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_anpr.h"
+#include "parking_plate.h"
+#include "parking_thread.h"
+#include "parking_validate.h"
+
+#define ANPR_DEDUPE_SETS 256 /**< 去重表的组数（2 的幂） */
+#define ANPR_DEDUPE_WAYS 4   /**< 去重表每组的路数 */
+
+/**
+ * @brief 在阶段之间传递的一条读数。
+ */
+typedef struct AnprRead {
+  char message[ANPR_MAX_MESSAGE]; /**< 原始消息。 */
+  char camera[ANPR_MAX_CAMERA];   /**< 相机编号。 */
+  char plate[MAX_LICENSE_LEN];    /**< 车牌号，规范化阶段之后为规范形式。 */
+  int confidence;                 /**< 置信度。 */
+  time_t read_time;               /**< 识别时间。 */
+  int dropped;                    /**< 非 0 表示已被丢弃，action 为原因。 */
+  AnprAction action;              /**< 丢弃原因或查表得到的处理方式。 */
+  PlateCode code;                 /**< 车牌编码。 */
+  int slot_id;                    /**< 查表得到的车位（出场）。 */
+  int returning;                  /**< 入场车辆是否有常客资料。 */
+} AnprRead;
+
+/**
+ * @brief 两个阶段之间的定长环形队列。
+ */
+typedef struct AnprQueue {
+  AnprRead *items;               /**< 读数数组。 */
+  int capacity;                  /**< 容量（2 的幂）。 */
+  volatile int head;             /**< 下一条待取的位置（仅消费者写入）。 */
+  volatile int tail;             /**< 下一条写入的位置（仅生产者写入）。 */
+  volatile int closed;           /**< 非 0 表示生产者不再写入。 */
+  volatile int consumer_waiting; /**< 消费者即将或正在等待 ready。 */
+  volatile int producer_waiting; /**< 生产者即将或正在等待 space。 */
+  ParkingSignal *ready;          /**< 有新读数或队列关闭时触发。 */
+  ParkingSignal *space;          /**< 有空位时触发。 */
+} AnprQueue;
+
+/**
+ * @brief 去重表中的一项。
+ */
+typedef struct AnprSeen {
+  int used;                    /**< 是否有值。 */
+  PlateCode code;              /**< 车牌编码。 */
+  char plate[MAX_LICENSE_LEN]; /**< 车牌号，非标准车牌比较时使用。 */
+  time_t last_read;            /**< 最近一次读到的时间。 */
+} AnprSeen;
+
+struct ParkingAnpr;
+
+/**
+ * @brief 一个工作线程的参数。
+ */
+typedef struct AnprWorker {
+  struct ParkingAnpr *anpr; /**< 所属流水线。 */
+  int stage;                /**< 阶段序号。 */
+} AnprWorker;
+
+/**
+ * @brief 正在运行的流水线。
+ */
+struct ParkingAnpr {
+  ParkingLot *lot;                          /**< 目标停车场。 */
+  AnprConfig config;                        /**< 配置，字符串指向下面的副本。 */
+  char owner_name[MAX_NAME_LEN];            /**< 首次入场登记的车主姓名。 */
+  char contact[MAX_CONTACT_LEN];            /**< 首次入场登记的联系方式。 */
+  ParkingAnprDoneFn done;                   /**< 完成通知函数，可以为 NULL。 */
+  void *ctx;                                /**< 通知函数的上下文指针。 */
+  AnprQueue queues[ANPR_STAGE_COUNT];       /**< 各阶段的输入队列。 */
+  ParkingThread *threads[ANPR_STAGE_COUNT]; /**< 各阶段的工作线程。 */
+  AnprWorker workers[ANPR_STAGE_COUNT];     /**< 各工作线程的参数。 */
+  volatile int submit_lock;                 /**< 提交者之间的自旋锁。 */
+  volatile int stopping;                    /**< 非 0 时拒绝新的提交。 */
+  /** 去重表（仅去重线程访问）。 */
+  AnprSeen seen[ANPR_DEDUPE_SETS * ANPR_DEDUPE_WAYS];
+  volatile long submitted;                  /**< 已接受的消息数。 */
+  volatile long busy;                       /**< 因队列已满被拒绝的消息数。 */
+  volatile long malformed;                  /**< 格式或车牌无效的读数。 */
+  volatile long low_confidence;             /**< 置信度不足的读数。 */
+  volatile long duplicates;                 /**< 去重丢弃的读数。 */
+  volatile long entries;                    /**< 成功入场的读数。 */
+  volatile long exits;                      /**< 成功出场的读数。 */
+  volatile long failed;                     /**< 入场或出场失败的读数。 */
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 计算队列中的读数个数。
+ * @param queue 目标队列。
+ * @param head 读下标。
+ * @param tail 写下标。
+ * @return 读数个数。
+ */
+static int queue_count(const AnprQueue *queue, int head, int tail) {
+  return (tail - head + 2 * queue->capacity) % (2 * queue->capacity);
+}
+
+/**
+ * @brief (静态辅助函数) 把一条读数写入队列，不等待，仅生产者调用。
+ * @param queue 目标队列。
+ * @param read 要写入的读数。
+ * @return 写入返回 1，队列已满返回 0。
+ */
+static int queue_push(AnprQueue *queue, const AnprRead *read) {
+  int tail = parking_atomic_load_int(&queue->tail);
+  int head = parking_atomic_load_int(&queue->head);
+
+  if (queue_count(queue, head, tail) == queue->capacity) {
+    return 0;
+  }
+  queue->items[tail % queue->capacity] = *read;
+  parking_atomic_store_int(&queue->tail, (tail + 1) % (2 * queue->capacity));
+  if (parking_atomic_load_int(&queue->consumer_waiting)) {
+    parking_signal_notify(queue->ready);
+  }
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 从队列取出一条读数，不等待，仅消费者调用。
+ * @param queue 目标队列。
+ * @param[out] read 接收读数。
+ * @return 取出返回 1，队列为空返回 0。
+ */
+static int queue_pop(AnprQueue *queue, AnprRead *read) {
+  int head = parking_atomic_load_int(&queue->head);
+  int tail = parking_atomic_load_int(&queue->tail);
+
+  if (head == tail) {
+    return 0;
+  }
+  *read = queue->items[head % queue->capacity];
+  parking_atomic_store_int(&queue->head, (head + 1) % (2 * queue->capacity));
+  if (parking_atomic_load_int(&queue->producer_waiting)) {
+    parking_signal_notify(queue->space);
+  }
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 把一条读数写入队列，队列已满时等待空位。
+ * @param queue 目标队列。
+ * @param read 要写入的读数。
+ */
+static void queue_put(AnprQueue *queue, const AnprRead *read) {
+  while (!queue_push(queue, read)) {
+    int pushed;
+
+    /* 先声明要等待再试一次：消费者取走读数后读到标记才会触发信号 */
+    parking_atomic_store_int(&queue->producer_waiting, 1);
+    pushed = queue_push(queue, read);
+    if (!pushed) {
+      parking_signal_wait(queue->space, 0);
+    }
+    parking_atomic_store_int(&queue->producer_waiting, 0);
+    if (pushed) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 从队列取出一条读数，队列为空时等待。
+ * @param queue 目标队列。
+ * @param[out] read 接收读数。
+ * @return 取出返回 1；队列已关闭且已取完返回 0。
+ */
+static int queue_take(AnprQueue *queue, AnprRead *read) {
+  for (;;) {
+    int taken;
+
+    if (queue_pop(queue, read)) {
+      return 1;
+    }
+    parking_atomic_store_int(&queue->consumer_waiting, 1);
+    taken = queue_pop(queue, read);
+    if (!taken && parking_atomic_load_int(&queue->closed)) {
+      /* 关闭前写入的读数此时都已可见 */
+      taken = queue_pop(queue, read);
+      parking_atomic_store_int(&queue->consumer_waiting, 0);
+      return taken;
+    }
+    if (!taken) {
+      parking_signal_wait(queue->ready, 0);
+    }
+    parking_atomic_store_int(&queue->consumer_waiting, 0);
+    if (taken) {
+      return 1;
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 关闭队列并唤醒消费者。
+ * @param queue 目标队列。
+ */
+static void queue_close(AnprQueue *queue) {
+  parking_atomic_store_int(&queue->closed, 1);
+  parking_signal_notify(queue->ready);
+}
+
+/**
+ * @brief (静态辅助函数) 标记读数已被丢弃。
+ * @param read 目标读数。
+ * @param action 丢弃原因。
+ */
+static void drop_read(AnprRead *read, AnprAction action) {
+  read->dropped = 1;
+  read->action = action;
+}
+
+/**
+ * @brief (静态辅助函数) 复制消息中的一个字段。
+ * @param dest 目标缓冲区。
+ * @param size 缓冲区大小。
+ * @param start 字段起点。
+ * @param length 字段长度。
+ * @return 成功返回 0；字段为空或过长返回 -1。
+ */
+static int copy_token(char *dest, size_t size, const char *start,
+                      size_t length) {
+  if (length == 0 || length >= size) {
+    return -1;
+  }
+  memcpy(dest, start, length);
+  dest[length] = '\0';
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 解析十进制非负整数字段。
+ * @param start 字段起点。
+ * @param length 字段长度。
+ * @param[out] value 接收数值。
+ * @return 成功返回 0；为空、含非数字字符或超过 long 的范围返回 -1。
+ */
+static int parse_number(const char *start, size_t length, long *value) {
+  size_t i;
+
+  *value = 0;
+  if (length == 0) {
+    return -1;
+  }
+  for (i = 0; i < length; i++) {
+    if (start[i] < '0' || start[i] > '9' ||
+        *value > (0x7fffffffL - (start[i] - '0')) / 10) {
+      return -1;
+    }
+    *value = *value * 10 + (start[i] - '0');
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 解析阶段：拆分“相机,车牌,置信度,时间”四个字段。
+ * @param anpr 所属流水线。
+ * @param read 目标读数。
+ */
+static void stage_parse(ParkingAnpr *anpr, AnprRead *read) {
+  const char *fields[4];
+  size_t lengths[4];
+  const char *p = read->message;
+  const char *end = read->message + strlen(read->message);
+  long confidence;
+  long when;
+  int count = 0;
+
+  while (end > p && (end[-1] == '\n' || end[-1] == '\r')) {
+    end--;
+  }
+  for (;;) {
+    const char *comma = p;
+
+    while (comma < end && *comma != ',') {
+      comma++;
+    }
+    if (count == 4) {
+      /* 多出的字段 */
+      count++;
+      break;
+    }
+    fields[count] = p;
+    lengths[count] = (size_t)(comma - p);
+    count++;
+    if (comma == end) {
+      break;
+    }
+    p = comma + 1;
+  }
+  if (count != 4 ||
+      copy_token(read->camera, sizeof(read->camera), fields[0],
+                 lengths[0]) != 0 ||
+      copy_token(read->plate, sizeof(read->plate), fields[1], lengths[1]) !=
+          0 ||
+      parse_number(fields[2], lengths[2], &confidence) != 0 ||
+      confidence > 100 || parse_number(fields[3], lengths[3], &when) != 0) {
+    drop_read(read, ANPR_ACTION_MALFORMED);
+    return;
+  }
+  read->confidence = (int)confidence;
+  read->read_time = (time_t)when;
+  if (read->confidence < anpr->config.min_confidence) {
+    drop_read(read, ANPR_ACTION_LOW_CONFIDENCE);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 规范化阶段：去掉分隔符、转大写并计算编码。
+ * @param anpr 所属流水线（未使用）。
+ * @param read 目标读数。
+ */
+static void stage_normalize(ParkingAnpr *anpr, AnprRead *read) {
+  unsigned char *src = (unsigned char *)read->plate;
+  char *dest = read->plate;
+
+  (void)anpr;
+  while (*src != '\0') {
+    if (*src == ' ' || *src == '\t' || *src == '-' || *src == '.') {
+      src++;
+    } else if (src[0] == 0xC2 && src[1] == 0xB7) {
+      /* UTF-8 的间隔点“·” */
+      src += 2;
+    } else if (*src >= 'a' && *src <= 'z') {
+      *dest++ = (char)(*src++ - 'a' + 'A');
+    } else {
+      *dest++ = (char)*src++;
+    }
+  }
+  *dest = '\0';
+  if (validate_plate_text(read->plate) != VALIDATION_OK) {
+    drop_read(read, ANPR_ACTION_MALFORMED);
+    return;
+  }
+  plate_encode(read->plate, &read->code);
+}
+
+/**
+ * @brief (静态辅助函数) 判断去重表的一项是否记录着该读数的车牌。
+ * @param seen 去重表的一项。
+ * @param read 目标读数。
+ * @return 是返回 1，否则返回 0。
+ */
+static int seen_matches(const AnprSeen *seen, const AnprRead *read) {
+  return seen->used && plate_code_equal(&seen->code, &read->code) &&
+         (plate_code_is_standard(&read->code) ||
+          strcmp(seen->plate, read->plate) == 0);
+}
+
+/**
+ * @brief (静态辅助函数) 去重阶段：窗口内再次读到同一车牌时丢弃。
+ * @details 每组按最近读到的时间淘汰最早的一项；车辆停在闸前持续被读到时，
+ *          窗口从最近一次读到起算。
+ * @param anpr 所属流水线。
+ * @param read 目标读数。
+ */
+static void stage_dedupe(ParkingAnpr *anpr, AnprRead *read) {
+  long window = anpr->config.dedupe_seconds;
+  AnprSeen *set;
+  AnprSeen *victim;
+  int i;
+
+  if (window == 0) {
+    return;
+  }
+  set = &anpr->seen[(plate_code_hash(&read->code) & (ANPR_DEDUPE_SETS - 1)) *
+                    ANPR_DEDUPE_WAYS];
+  victim = &set[0];
+  for (i = 0; i < ANPR_DEDUPE_WAYS; i++) {
+    if (seen_matches(&set[i], read)) {
+      double gap = difftime(read->read_time, set[i].last_read);
+
+      if (gap > 0) {
+        set[i].last_read = read->read_time;
+      }
+      if (gap <= (double)window && gap >= -(double)window) {
+        drop_read(read, ANPR_ACTION_DUPLICATE);
+      }
+      return;
+    }
+    if (victim->used &&
+        (!set[i].used || set[i].last_read < victim->last_read)) {
+      victim = &set[i];
+    }
+  }
+  victim->used = 1;
+  victim->code = read->code;
+  memcpy(victim->plate, read->plate, strlen(read->plate) + 1);
+  victim->last_read = read->read_time;
+}
+
+/**
+ * @brief (静态辅助函数) 查表阶段：在读锁内查车牌索引与常客资料。
+ * @param anpr 所属流水线。
+ * @param read 目标读数。
+ */
+static void stage_lookup(ParkingAnpr *anpr, AnprRead *read) {
+  ParkingSlot *slot;
+  VehicleSession session;
+
+  parking_lot_read_lock(anpr->lot);
+  slot = find_slot_by_license(anpr->lot, read->plate);
+  if (slot != NULL) {
+    read->action = ANPR_ACTION_EXIT;
+    read->slot_id = slot->slot_id;
+  } else {
+    read->action = ANPR_ACTION_ENTRY;
+    read->returning =
+        find_vehicle_session(anpr->lot, read->plate, &session) == 0;
+  }
+  parking_lot_read_unlock(anpr->lot);
+}
+
+/**
+ * @brief (静态辅助函数) 核对车位上停的仍是读数中的车辆。
+ * @param slot 车位。
+ * @param ctx 指向读数的指针；不匹配时把其 slot_id 清零。
+ * @return 始终返回 0。
+ */
+static int confirm_plate(ParkingSlot *slot, void *ctx) {
+  AnprRead *read = (AnprRead *)ctx;
+
+  if (slot->status != OCCUPIED_STATUS || slot->license_plate == NULL ||
+      strcmp(slot->license_plate, read->plate) != 0) {
+    read->slot_id = 0;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 路由阶段：执行入场或出场，并发出完成通知。
+ * @param anpr 所属流水线。
+ * @param read 目标读数。
+ */
+static void stage_route(ParkingAnpr *anpr, AnprRead *read) {
+  AnprOutcome outcome;
+  volatile long *counter = NULL;
+
+  memset(&outcome, 0, sizeof(outcome));
+  outcome.code = PARKING_SERVICE_SUCCESS;
+  if (read->dropped && read->action == ANPR_ACTION_DUPLICATE) {
+    counter = &anpr->duplicates;
+  } else if (read->dropped && read->action == ANPR_ACTION_LOW_CONFIDENCE) {
+    counter = &anpr->low_confidence;
+  } else if (read->dropped) {
+    counter = &anpr->malformed;
+  } else if (read->action == ANPR_ACTION_EXIT) {
+    /* 查表之后车位可能已被人工处理，出场前再核对一次车牌 */
+    outcome.code = parking_service_fast_visit_slot_by_id(
+        anpr->lot, read->slot_id, confirm_plate, read);
+    if (outcome.code == PARKING_SERVICE_SUCCESS && read->slot_id == 0) {
+      outcome.code = PARKING_SERVICE_SLOT_NOT_FOUND;
+    }
+    if (outcome.code == PARKING_SERVICE_SUCCESS) {
+      outcome.code = parking_service_fast_deallocate_slot(
+          anpr->lot, read->slot_id, &outcome.receipt);
+      outcome.slot_id = read->slot_id;
+    }
+    counter = outcome.code == PARKING_SERVICE_SUCCESS ? &anpr->exits
+                                                      : &anpr->failed;
+  } else {
+    outcome.code = PARKING_SERVICE_SLOT_NOT_FOUND;
+    if (read->returning) {
+      ServiceResult result =
+          parking_service_allocate_returning_vehicle(anpr->lot, read->plate);
+
+      outcome.code = result.code;
+      if (result.code == PARKING_SERVICE_SUCCESS) {
+        outcome.slot_id = ((ParkingSlot *)result.data)->slot_id;
+      }
+    }
+    if (outcome.code == PARKING_SERVICE_SLOT_NOT_FOUND) {
+      /* 没有常客资料（或刚被淘汰）时按配置登记 */
+      outcome.code = parking_service_fast_allocate_any_slot(
+          anpr->lot, anpr->owner_name, read->plate, anpr->contact,
+          anpr->config.entry_type, &outcome.slot_id);
+    }
+    counter = outcome.code == PARKING_SERVICE_SUCCESS ? &anpr->entries
+                                                      : &anpr->failed;
+  }
+  parking_atomic_add_long(counter, 1);
+
+  if (anpr->done != NULL) {
+    outcome.message = read->message;
+    outcome.camera = read->camera;
+    outcome.license_plate = read->plate;
+    outcome.confidence = read->confidence;
+    outcome.read_time = read->read_time;
+    outcome.action = read->action;
+    anpr->done(&outcome, anpr->ctx);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 工作线程入口：取读数、处理、交给下一阶段。
+ * @details 已丢弃的读数在中间阶段原样传递，由路由阶段统一通知。
+ * @param arg 工作线程的参数。
+ */
+static void anpr_thread_main(void *arg) {
+  AnprWorker *worker = (AnprWorker *)arg;
+  ParkingAnpr *anpr = worker->anpr;
+  AnprQueue *input = &anpr->queues[worker->stage];
+  AnprQueue *output = worker->stage + 1 < ANPR_STAGE_COUNT
+                          ? &anpr->queues[worker->stage + 1]
+                          : NULL;
+  AnprRead read;
+
+  while (queue_take(input, &read)) {
+    switch (worker->stage) {
+    case 0:
+      stage_parse(anpr, &read);
+      break;
+    case 1:
+      if (!read.dropped) {
+        stage_normalize(anpr, &read);
+      }
+      break;
+    case 2:
+      if (!read.dropped) {
+        stage_dedupe(anpr, &read);
+      }
+      break;
+    case 3:
+      if (!read.dropped) {
+        stage_lookup(anpr, &read);
+      }
+      break;
+    default:
+      stage_route(anpr, &read);
+      break;
+    }
+    if (output != NULL) {
+      queue_put(output, &read);
+    }
+  }
+  if (output != NULL) {
+    queue_close(output);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 关闭第一个队列，等待已启动的线程退出并释放句柄。
+ * @param anpr 目标流水线。
+ * @param started 已启动的线程数（从第一阶段起连续）。
+ */
+static void anpr_shutdown(ParkingAnpr *anpr, int started) {
+  int i;
+
+  queue_close(&anpr->queues[0]);
+  for (i = 0; i < started; i++) {
+    parking_thread_join(anpr->threads[i]);
+  }
+  for (i = 0; i < ANPR_STAGE_COUNT; i++) {
+    parking_signal_destroy(anpr->queues[i].ready);
+    parking_signal_destroy(anpr->queues[i].space);
+    free(anpr->queues[i].items);
+  }
+  free(anpr);
+}
+
+/* ========================================================================== */
+/*                             相机接入API实现                                */
+/* ========================================================================== */
+
+/**
+ * @brief 以默认值填写流水线配置。
+ * @param[out] config 接收默认配置。
+ */
+void parking_anpr_default_config(AnprConfig *config) {
+  if (config == NULL) {
+    return;
+  }
+  config->queue_capacity = ANPR_DEFAULT_QUEUE;
+  config->min_confidence = ANPR_DEFAULT_MIN_CONFIDENCE;
+  config->dedupe_seconds = ANPR_DEFAULT_DEDUPE_SECONDS;
+  config->entry_type = VISITOR_TYPE;
+  config->owner_name = "";
+  config->contact = "00000000";
+}
+
+/**
+ * @brief 为停车场启动车牌识别流水线的五个工作线程。
+ * @param lot 目标停车场。
+ * @param config 配置，NULL 表示默认配置。
+ * @param done 完成通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 成功返回句柄，失败返回 NULL。
+ */
+ParkingAnpr *parking_anpr_start(ParkingLot *lot, const AnprConfig *config,
+                                ParkingAnprDoneFn done, void *ctx) {
+  ParkingAnpr *anpr;
+  AnprConfig defaults;
+  int capacity = 1;
+  int i;
+
+  if (config == NULL) {
+    parking_anpr_default_config(&defaults);
+    config = &defaults;
+  }
+  if (lot == NULL || config->queue_capacity <= 0 ||
+      config->queue_capacity > 0x100000 || config->min_confidence < 0 ||
+      config->min_confidence > 100 || config->dedupe_seconds < 0 ||
+      validate_owner_text(config->owner_name) != VALIDATION_OK ||
+      validate_contact_text(config->contact) != VALIDATION_OK) {
+    return NULL;
+  }
+  while (capacity < config->queue_capacity) {
+    capacity *= 2;
+  }
+  anpr = (ParkingAnpr *)calloc(1, sizeof(ParkingAnpr));
+  if (anpr == NULL) {
+    return NULL;
+  }
+  anpr->lot = lot;
+  anpr->config = *config;
+  anpr->config.queue_capacity = capacity;
+  memcpy(anpr->owner_name, config->owner_name, strlen(config->owner_name) + 1);
+  memcpy(anpr->contact, config->contact, strlen(config->contact) + 1);
+  anpr->config.owner_name = anpr->owner_name;
+  anpr->config.contact = anpr->contact;
+  anpr->done = done;
+  anpr->ctx = ctx;
+  for (i = 0; i < ANPR_STAGE_COUNT; i++) {
+    AnprQueue *queue = &anpr->queues[i];
+
+    queue->capacity = capacity;
+    queue->items = (AnprRead *)malloc((size_t)capacity * sizeof(AnprRead));
+    queue->ready = parking_signal_create();
+    queue->space = parking_signal_create();
+    if (queue->items == NULL || queue->ready == NULL || queue->space == NULL) {
+      anpr_shutdown(anpr, 0);
+      return NULL;
+    }
+  }
+  for (i = 0; i < ANPR_STAGE_COUNT; i++) {
+    anpr->workers[i].anpr = anpr;
+    anpr->workers[i].stage = i;
+    anpr->threads[i] =
+        parking_thread_start(anpr_thread_main, &anpr->workers[i]);
+    if (anpr->threads[i] == NULL) {
+      anpr_shutdown(anpr, i);
+      return NULL;
+    }
+  }
+  return anpr;
+}
+
+/**
+ * @brief 提交一条相机消息，不等待处理。
+ * @param anpr 流水线句柄。
+ * @param message 相机消息。
+ * @return 已入队返回 0；参数无效、消息过长或正在停止返回 -1；
+ *         第一个队列已满返回 -3。
+ */
+int parking_anpr_submit(ParkingAnpr *anpr, const char *message) {
+  AnprRead read;
+  size_t length;
+  int status = 0;
+
+  if (anpr == NULL || message == NULL) {
+    return -1;
+  }
+  length = strlen(message);
+  if (length >= sizeof(read.message)) {
+    return -1;
+  }
+  memset(&read, 0, sizeof(read));
+  memcpy(read.message, message, length + 1);
+
+  while (parking_atomic_exchange_int(&anpr->submit_lock, 1) != 0) {
+  }
+  if (parking_atomic_load_int(&anpr->stopping)) {
+    status = -1;
+  } else if (!queue_push(&anpr->queues[0], &read)) {
+    status = -3;
+  }
+  parking_atomic_store_int(&anpr->submit_lock, 0);
+
+  if (status == 0) {
+    parking_atomic_add_long(&anpr->submitted, 1);
+  } else if (status == -3) {
+    parking_atomic_add_long(&anpr->busy, 1);
+  }
+  return status;
+}
+
+/**
+ * @brief 读取流水线的累计统计。
+ * @param anpr 流水线句柄。
+ * @param[out] stats 接收统计。
+ */
+void parking_anpr_stats(ParkingAnpr *anpr, AnprStats *stats) {
+  int i;
+
+  if (stats == NULL) {
+    return;
+  }
+  memset(stats, 0, sizeof(*stats));
+  if (anpr == NULL) {
+    return;
+  }
+  stats->submitted = parking_atomic_load_long(&anpr->submitted);
+  stats->busy = parking_atomic_load_long(&anpr->busy);
+  stats->malformed = parking_atomic_load_long(&anpr->malformed);
+  stats->low_confidence = parking_atomic_load_long(&anpr->low_confidence);
+  stats->duplicates = parking_atomic_load_long(&anpr->duplicates);
+  stats->entries = parking_atomic_load_long(&anpr->entries);
+  stats->exits = parking_atomic_load_long(&anpr->exits);
+  stats->failed = parking_atomic_load_long(&anpr->failed);
+  for (i = 0; i < ANPR_STAGE_COUNT; i++) {
+    AnprQueue *queue = &anpr->queues[i];
+
+    stats->queued[i] = queue_count(queue, parking_atomic_load_int(&queue->head),
+                                   parking_atomic_load_int(&queue->tail));
+  }
+}
+
+/**
+ * @brief 停止流水线并释放句柄。
+ * @param anpr 流水线句柄，可以为 NULL。
+ */
+void parking_anpr_stop(ParkingAnpr *anpr) {
+  if (anpr == NULL) {
+    return;
+  }
+  /* 在提交锁内置位，之后不会再有读数写入第一个队列 */
+  while (parking_atomic_exchange_int(&anpr->submit_lock, 1) != 0) {
+  }
+  parking_atomic_store_int(&anpr->stopping, 1);
+  parking_atomic_store_int(&anpr->submit_lock, 0);
+  anpr_shutdown(anpr, ANPR_STAGE_COUNT);
+}
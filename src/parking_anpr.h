@@ -0,0 +1,173 @@
+#ifndef PARKING_ANPR_H
+#define PARKING_ANPR_H
+
+#include <time.h>
+
+#include "parking_service.h"
+
+/**
+ * @file parking_anpr.h
+ * @brief 车牌识别相机读数的流水线接入声明。
+ * @details
+ * 出入口相机每识别一次车牌就发出一条文本消息，同一辆车停在闸前会连续
+ * 发出多条。流水线把每条消息依次交给五个阶段，每个阶段一个工作线程，
+ * 相邻阶段之间是定长的单生产者单消费者环形队列：
+ * 1. 解析：拆分消息字段，丢弃格式错误或置信度不足的读数；
+ * 2. 规范化：去掉空格、连字符与间隔点，小写字母转大写，计算车牌编码；
+ * 3. 去重：同一车牌在去重窗口内的重复读数只保留第一条；
+ * 4. 查表：在读锁内查车牌索引，在场内的车辆判为出场，否则判为入场；
+ * 5. 路由：出场按车位计费释放，入场优先沿用常客资料，否则自动选位。
+ *
+ * 每条消息无论在哪一阶段被丢弃，都会流到路由阶段，由它按提交顺序调用
+ * 完成通知函数，因此通知总在同一个线程中、按顺序发出。
+ * 阶段之间只传递定长记录，整条流水线不分配内存。
+ * 后面的阶段较慢时，前面的阶段在出队前等待空位；第一个队列已满时
+ * parking_anpr_submit 立即返回 -3，由相机网关稍后重发。
+ *
+ * 消息格式为“相机编号,车牌号,置信度,识别时间”：置信度取 0～100，
+ * 识别时间为 Unix 秒数，例如 "gate-1,京A 12345,96,1760000000"。
+ * 去重以车牌为键、不区分相机，同一出入口的两台相机读到同一辆车只算一次；
+ * 代价是车辆在去重窗口内入场又出场时，出场读数会被当作重复丢弃。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define ANPR_MAX_MESSAGE 128 /**< 一条相机消息的最大长度（含结尾的 NUL） */
+#define ANPR_MAX_CAMERA 24   /**< 相机编号的最大长度（含结尾的 NUL） */
+#define ANPR_STAGE_COUNT 5   /**< 流水线的阶段数 */
+#define ANPR_DEFAULT_QUEUE 256          /**< 默认每个阶段队列的容量 */
+#define ANPR_DEFAULT_MIN_CONFIDENCE 80  /**< 默认接受读数的最低置信度 */
+#define ANPR_DEFAULT_DEDUPE_SECONDS 30L /**< 默认的去重窗口（秒） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一条读数的处理结果。
+ */
+typedef enum AnprAction {
+  ANPR_ACTION_MALFORMED = 0,      /**< 消息格式或车牌无效，已丢弃。 */
+  ANPR_ACTION_LOW_CONFIDENCE = 1, /**< 置信度低于阈值，已丢弃。 */
+  ANPR_ACTION_DUPLICATE = 2,      /**< 去重窗口内的重复读数，已丢弃。 */
+  ANPR_ACTION_ENTRY = 3,          /**< 按入场处理。 */
+  ANPR_ACTION_EXIT = 4            /**< 按出场处理。 */
+} AnprAction;
+
+/**
+ * @brief 流水线的配置。
+ * @details 相机无法得知车主资料，首次入场的车辆以 owner_name 与 contact
+ *          登记；有常客资料的车辆沿用缓存中的资料。
+ */
+typedef struct AnprConfig {
+  int queue_capacity;   /**< 每个阶段队列的容量，向上取整为 2 的幂。 */
+  int min_confidence;   /**< 接受读数的最低置信度（0～100）。 */
+  long dedupe_seconds;  /**< 去重窗口（秒），0 表示不去重。 */
+  ParkingType entry_type; /**< 首次入场车辆的停车类型。 */
+  const char *owner_name; /**< 首次入场车辆登记的车主姓名，启动时复制。 */
+  const char *contact;    /**< 首次入场车辆登记的联系方式，启动时复制。 */
+} AnprConfig;
+
+/**
+ * @brief 通知函数收到的一条读数及其结果。
+ * @details 字符串字段只在通知期间有效。
+ */
+typedef struct AnprOutcome {
+  const char *message;       /**< 原始消息。 */
+  const char *camera;        /**< 相机编号，格式错误时可能为空串。 */
+  const char *license_plate; /**< 规范化后的车牌号，格式错误时可能为空串。 */
+  int confidence;            /**< 置信度，格式错误时为 0。 */
+  time_t read_time;          /**< 识别时间，格式错误时为 0。 */
+  AnprAction action;         /**< 处理结果。 */
+  ParkingServiceResultCode code; /**< 入场或出场的状态码，丢弃时为成功。 */
+  int slot_id;               /**< 入场分配到或出场释放的车位，否则为 0。 */
+  ExitReceipt receipt;       /**< 出场成功时的计费明细，否则清零。 */
+} AnprOutcome;
+
+/**
+ * @brief 一条读数处理完毕后的通知函数。
+ * @details 在路由线程中按提交顺序调用，不持有停车场的锁；
+ *          不应长时间阻塞，否则整条流水线会随之停顿。
+ * @param outcome 读数及其结果。
+ * @param ctx 启动流水线时传入的上下文指针。
+ */
+typedef void (*ParkingAnprDoneFn)(const AnprOutcome *outcome, void *ctx);
+
+/**
+ * @brief 流水线的累计统计。
+ */
+typedef struct AnprStats {
+  long submitted;      /**< 已接受的消息数。 */
+  long busy;           /**< 因第一个队列已满被拒绝的消息数。 */
+  long malformed;      /**< 格式或车牌无效的读数。 */
+  long low_confidence; /**< 置信度不足的读数。 */
+  long duplicates;     /**< 去重丢弃的读数。 */
+  long entries;        /**< 成功入场的读数。 */
+  long exits;          /**< 成功出场的读数。 */
+  long failed;         /**< 入场或出场失败的读数。 */
+  int queued[ANPR_STAGE_COUNT]; /**< 各阶段队列中等待的读数。 */
+} AnprStats;
+
+/**
+ * @brief 不透明的流水线句柄。
+ */
+typedef struct ParkingAnpr ParkingAnpr;
+
+/**
+ *********************************************************************************
+ *                             相机接入API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 以默认值填写流水线配置。
+ * @details 首次入场按访客登记，车主姓名为空串、联系方式为 "00000000"；
+ *          实际部署应改为停车场的服务电话等可联系的号码。
+ * @param[out] config 接收默认配置。
+ */
+void parking_anpr_default_config(AnprConfig *config);
+
+/**
+ * @brief 为停车场启动车牌识别流水线的五个工作线程。
+ * @param lot 目标停车场，须比流水线存活得久。
+ * @param config 配置，NULL 表示默认配置。
+ * @param done 完成通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 成功返回句柄；参数无效（含首次入场资料不合格）、内存不足或
+ *         无法创建线程时返回 NULL。
+ */
+ParkingAnpr *parking_anpr_start(ParkingLot *lot, const AnprConfig *config,
+                                ParkingAnprDoneFn done, void *ctx);
+
+/**
+ * @brief 提交一条相机消息，不等待处理。
+ * @details 可以从任意线程并发调用，消息在返回前复制。
+ * @param anpr 流水线句柄。
+ * @param message 相机消息。
+ * @return 已入队返回 0；参数无效、消息过长或正在停止返回 -1；
+ *         第一个队列已满返回 -3。
+ */
+int parking_anpr_submit(ParkingAnpr *anpr, const char *message);
+
+/**
+ * @brief 读取流水线的累计统计。
+ * @param anpr 流水线句柄。
+ * @param[out] stats 接收统计；anpr 为 NULL 时清零。
+ */
+void parking_anpr_stats(ParkingAnpr *anpr, AnprStats *stats);
+
+/**
+ * @brief 停止流水线并释放句柄。
+ * @details 已入队的消息会先全部处理并通知；调用者须保证此后不再提交，
+ *          且不持有停车场的锁。
+ * @param anpr 流水线句柄，可以为 NULL。
+ */
+void parking_anpr_stop(ParkingAnpr *anpr);
+
+#endif /* PARKING_ANPR_H */
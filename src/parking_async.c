@@ -0,0 +1,404 @@
+/**
+ * @file parking_async.c
+ * @brief 异步提交服务操作的实现文件
+ * @details
+ * 该文件实现了 parking_async.h 中声明的属主线程。提交队列与完成队列都是
+ * 以操作自身的 next 字段串起的单链表，由同一把自旋锁保护；临界区内只
+ * 改几个指针与计数，操作的执行与完成通知都在锁外进行。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_async.h"
+#include "parking_thread.h"
+
+/**
+ * @brief 以 next 字段串起的先进先出队列。
+ */
+typedef struct AsyncQueue {
+  ParkingAsyncOp *head; /**< 最早入队的操作，NULL 表示队列为空。 */
+  ParkingAsyncOp *tail; /**< 最晚入队的操作。 */
+  int length;           /**< 队列中的操作数。 */
+} AsyncQueue;
+
+/**
+ * @brief 正在运行的属主线程。
+ */
+struct ParkingAsync {
+  ParkingLot *lot;          /**< 目标停车场。 */
+  ParkingThread *thread;    /**< 属主线程。 */
+  ParkingSignal *submitted; /**< 有新操作或需要停止时触发。 */
+  ParkingSignal *completed; /**< 完成队列有新操作时触发。 */
+  volatile int lock;        /**< 保护以下字段的自旋锁。 */
+  int stopping;             /**< 非 0 时执行完排队的操作后退出。 */
+  AsyncQueue pending[PARKING_ASYNC_PRIORITIES]; /**< 各类已提交的操作。 */
+  int limits[PARKING_ASYNC_PRIORITIES];         /**< 各类队列的长度上限。 */
+  long rejected[PARKING_ASYNC_PRIORITIES];      /**< 各类被拒绝的次数。 */
+  AsyncQueue done;         /**< 已完成、尚未取回的操作。 */
+  volatile long in_flight; /**< 已提交、尚未执行完的操作数。 */
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 获取属主线程的自旋锁。
+ * @param async 目标属主线程。
+ */
+static void async_lock(ParkingAsync *async) {
+  while (parking_atomic_exchange_int(&async->lock, 1) != 0) {
+    while (parking_atomic_load_int(&async->lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放属主线程的自旋锁。
+ * @param async 目标属主线程。
+ */
+static void async_unlock(ParkingAsync *async) {
+  parking_atomic_store_int(&async->lock, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 把操作追加到队列末尾。
+ * @param queue 目标队列。
+ * @param op 操作。
+ */
+static void queue_push(AsyncQueue *queue, ParkingAsyncOp *op) {
+  op->next = NULL;
+  if (queue->tail != NULL) {
+    queue->tail->next = op;
+  } else {
+    queue->head = op;
+  }
+  queue->tail = op;
+  queue->length++;
+}
+
+/**
+ * @brief (静态辅助函数) 从队列头部取下至多 max 个操作。
+ * @param queue 目标队列。
+ * @param max 最多取下的操作数。
+ * @return 取下的操作组成的链表（以 NULL 结尾），队列为空时返回 NULL。
+ */
+static ParkingAsyncOp *queue_take(AsyncQueue *queue, int max) {
+  ParkingAsyncOp *head = queue->head;
+  ParkingAsyncOp *last = head;
+  int count = 1;
+
+  if (head == NULL) {
+    return NULL;
+  }
+  while (count < max && last->next != NULL) {
+    last = last->next;
+    count++;
+  }
+  queue->head = last->next;
+  if (queue->head == NULL) {
+    queue->tail = NULL;
+  }
+  queue->length -= count;
+  last->next = NULL;
+  return head;
+}
+
+/**
+ * @brief (静态辅助函数) 执行一个操作，把结果写回操作。
+ * @param lot 目标停车场。
+ * @param op 操作。
+ */
+static void run_op(ParkingLot *lot, ParkingAsyncOp *op) {
+  switch (op->kind) {
+  case PARKING_ASYNC_ADD_SLOT:
+    op->code = parking_service_fast_add_slot(lot, op->slot_id, op->location);
+    break;
+  case PARKING_ASYNC_ALLOCATE_SLOT:
+    op->code = parking_service_fast_allocate_slot(
+        lot, op->slot_id, op->owner_name, op->license_plate, op->contact,
+        op->type);
+    break;
+  case PARKING_ASYNC_ALLOCATE_ANY_SLOT:
+    op->code = parking_service_fast_allocate_any_slot(
+        lot, op->owner_name, op->license_plate, op->contact, op->type,
+        &op->slot_id);
+    break;
+  case PARKING_ASYNC_DEALLOCATE_SLOT:
+    op->code =
+        parking_service_fast_deallocate_slot(lot, op->slot_id, &op->receipt);
+    break;
+  default:
+    op->code = parking_service_fast_get_statistics(lot, &op->stats);
+    break;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 属主线程的主循环。
+ * @details 每次从优先级最高的非空队列取下至多 PARKING_ASYNC_BATCH 个
+ *          操作，按提交顺序执行并逐个完成；执行完一批后重新挑选队列，
+ *          新到的出场因此不会排在大量入场或查询之后。启用了只读视图时
+ *          每批之后刷新视图。全部队列为空时等待信号，停止时先执行完
+ *          排队的操作。
+ * @param arg 对应的 ParkingAsync 对象。
+ */
+static void async_loop(void *arg) {
+  ParkingAsync *async = (ParkingAsync *)arg;
+  ParkingAsyncOp *batch;
+  int stopping;
+  int i;
+
+  for (;;) {
+    batch = NULL;
+    async_lock(async);
+    for (i = 0; i < PARKING_ASYNC_PRIORITIES && batch == NULL; i++) {
+      batch = queue_take(&async->pending[i], PARKING_ASYNC_BATCH);
+    }
+    stopping = async->stopping;
+    async_unlock(async);
+
+    if (batch == NULL) {
+      if (stopping) {
+        break;
+      }
+      parking_signal_wait(async->submitted, 0);
+      continue;
+    }
+    while (batch != NULL) {
+      ParkingAsyncOp *op = batch;
+
+      /* 通知函数可能立即重新提交 op，先取下一个 */
+      batch = op->next;
+      run_op(async->lot, op);
+      parking_atomic_add_long(&async->in_flight, -1);
+      if (op->done != NULL) {
+        op->done(op, op->ctx);
+        continue;
+      }
+      async_lock(async);
+      queue_push(&async->done, op);
+      async_unlock(async);
+      parking_signal_notify(async->completed);
+    }
+    if (async->lot->view != NULL) {
+      parking_service_refresh_read_view(async->lot);
+    }
+    if (async->lot->shm != NULL) {
+      parking_service_publish_shared_memory(async->lot);
+    }
+  }
+}
+
+/* ========================================================================== */
+/*                              异步操作API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 初始化一个操作：清零全部字段并设置种类。
+ * @param op 目标操作。
+ * @param kind 操作种类。
+ */
+void parking_async_op_init(ParkingAsyncOp *op, ParkingAsyncKind kind) {
+  if (op == NULL) {
+    return;
+  }
+  memset(op, 0, sizeof(*op));
+  op->kind = kind;
+}
+
+/**
+ * @brief 为停车场启动属主线程。
+ * @param lot 目标停车场。
+ * @return 成功返回句柄，失败返回 NULL。
+ */
+ParkingAsync *parking_async_start(ParkingLot *lot) {
+  ParkingAsync *async;
+  int i;
+
+  if (lot == NULL) {
+    return NULL;
+  }
+  async = (ParkingAsync *)calloc(1, sizeof(ParkingAsync));
+  if (async == NULL) {
+    return NULL;
+  }
+  async->lot = lot;
+  for (i = 0; i < PARKING_ASYNC_PRIORITIES; i++) {
+    async->limits[i] = PARKING_ASYNC_DEFAULT_LIMIT;
+  }
+  async->submitted = parking_signal_create();
+  async->completed = parking_signal_create();
+  if (async->submitted == NULL || async->completed == NULL) {
+    parking_signal_destroy(async->submitted);
+    parking_signal_destroy(async->completed);
+    free(async);
+    return NULL;
+  }
+  async->thread = parking_thread_start(async_loop, async);
+  if (async->thread == NULL) {
+    parking_signal_destroy(async->submitted);
+    parking_signal_destroy(async->completed);
+    free(async);
+    return NULL;
+  }
+  return async;
+}
+
+/**
+ * @brief 提交一个操作，立即返回。
+ * @param async 属主线程。
+ * @param op 要执行的操作。
+ * @return 已排队返回 0，参数无效返回 -1，属主线程正在停止返回 -2，
+ *         队列已满返回 -3。
+ */
+int parking_async_submit(ParkingAsync *async, ParkingAsyncOp *op) {
+  ParkingAsyncPriority priority;
+
+  if (async == NULL || op == NULL ||
+      (unsigned int)op->kind >= PARKING_ASYNC_KINDS) {
+    return -1;
+  }
+  priority = parking_async_priority(op->kind);
+  async_lock(async);
+  if (async->stopping) {
+    async_unlock(async);
+    return -2;
+  }
+  if (async->pending[priority].length >= async->limits[priority]) {
+    async->rejected[priority]++;
+    async_unlock(async);
+    op->code = PARKING_SERVICE_BUSY;
+    return -3;
+  }
+  parking_atomic_add_long(&async->in_flight, 1);
+  queue_push(&async->pending[priority], op);
+  async_unlock(async);
+  parking_signal_notify(async->submitted);
+  return 0;
+}
+
+/**
+ * @brief 取得操作种类所属的优先级。
+ * @param kind 操作种类。
+ * @return 优先级。
+ */
+ParkingAsyncPriority parking_async_priority(ParkingAsyncKind kind) {
+  switch (kind) {
+  case PARKING_ASYNC_DEALLOCATE_SLOT:
+    return PARKING_ASYNC_PRIORITY_EXIT;
+  case PARKING_ASYNC_ADD_SLOT:
+  case PARKING_ASYNC_ALLOCATE_SLOT:
+  case PARKING_ASYNC_ALLOCATE_ANY_SLOT:
+    return PARKING_ASYNC_PRIORITY_ENTRY;
+  default:
+    return PARKING_ASYNC_PRIORITY_LOOKUP;
+  }
+}
+
+/**
+ * @brief 设置某类提交队列的长度上限。
+ * @param async 属主线程。
+ * @param priority 优先级。
+ * @param limit 长度上限。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int parking_async_set_limit(ParkingAsync *async, ParkingAsyncPriority priority,
+                            int limit) {
+  if (async == NULL || (unsigned int)priority >= PARKING_ASYNC_PRIORITIES ||
+      limit <= 0) {
+    return -1;
+  }
+  async_lock(async);
+  async->limits[priority] = limit;
+  async_unlock(async);
+  return 0;
+}
+
+/**
+ * @brief 读取属主线程的统计快照。
+ * @param async 属主线程。
+ * @param[out] stats 接收快照。
+ */
+void parking_async_stats(ParkingAsync *async, ParkingAsyncStats *stats) {
+  int i;
+
+  if (stats == NULL) {
+    return;
+  }
+  memset(stats, 0, sizeof(*stats));
+  if (async == NULL) {
+    return;
+  }
+  async_lock(async);
+  for (i = 0; i < PARKING_ASYNC_PRIORITIES; i++) {
+    stats->queued[i] = async->pending[i].length;
+    stats->limits[i] = async->limits[i];
+    stats->rejected[i] = async->rejected[i];
+  }
+  async_unlock(async);
+}
+
+/**
+ * @brief 从完成队列取回已完成的操作。
+ * @param async 属主线程。
+ * @param[out] ops 接收已完成的操作。
+ * @param max ops 的容量。
+ * @param timeout_ms 完成队列为空时最长等待的毫秒数，0 表示不等待。
+ * @return 取回的操作数，参数无效返回 -1。
+ */
+int parking_async_poll(ParkingAsync *async, ParkingAsyncOp **ops, int max,
+                       unsigned long timeout_ms) {
+  int count = 0;
+  int attempt;
+
+  if (async == NULL || ops == NULL || max <= 0) {
+    return -1;
+  }
+  for (attempt = 0; attempt < 2; attempt++) {
+    async_lock(async);
+    while (count < max && async->done.head != NULL) {
+      ops[count++] = async->done.head;
+      async->done.head = async->done.head->next;
+      async->done.length--;
+    }
+    if (async->done.head == NULL) {
+      async->done.tail = NULL;
+    }
+    async_unlock(async);
+
+    if (count > 0 || timeout_ms == 0 || attempt > 0) {
+      break;
+    }
+    parking_signal_wait(async->completed, timeout_ms);
+  }
+  return count;
+}
+
+/**
+ * @brief 查询已提交、尚未执行完的操作数。
+ * @param async 属主线程。
+ * @return 操作数；async 为 NULL 时返回 0。
+ */
+long parking_async_in_flight(ParkingAsync *async) {
+  return async != NULL ? parking_atomic_load_long(&async->in_flight) : 0;
+}
+
+/**
+ * @brief 执行完已排队的操作后停止属主线程并释放句柄。
+ * @param async 属主线程，可以为 NULL。
+ */
+void parking_async_stop(ParkingAsync *async) {
+  if (async == NULL) {
+    return;
+  }
+  async_lock(async);
+  async->stopping = 1;
+  async_unlock(async);
+  parking_signal_notify(async->submitted);
+  parking_thread_join(async->thread);
+  parking_signal_destroy(async->submitted);
+  parking_signal_destroy(async->completed);
+  free(async);
+}
@@ -0,0 +1,196 @@
+#ifndef PARKING_ASYNC_H
+#define PARKING_ASYNC_H
+
+#include "parking_service.h"
+
+/**
+ * @file parking_async.h
+ * @brief 异步提交服务操作的接口声明。
+ * @details
+ * parking_service_* 都是同步调用：启用预写日志、主备复制后，一次入场
+ * 可能要等日志落盘，调用线程在此期间什么也做不了。异步接口把操作交给
+ * 停车场的属主线程执行，提交后立即返回；前端只需少量线程即可同时挂起
+ * 成千上万个操作。
+ *
+ * 每个操作由调用者提供的 ParkingAsyncOp 描述，从提交到完成都由调用者
+ * 保持有效（异步接口不为操作分配内存）。操作完成后：
+ * - 设置了 done 的，在属主线程中调用 done（不持有停车场的锁，可以在
+ *   其中再提交操作）；
+ * - 没有设置 done 的，放入完成队列，由 parking_async_poll 取回。
+ *
+ * 交接班时几秒内会涌入数百个出入场请求。提交队列因此按优先级分为三类，
+ * 每类有长度上限：出场（释放车位）最优先，其次是入场与添加车位，
+ * 最后是查询。属主线程总是先执行优先级最高的非空队列，每次最多取
+ * PARKING_ASYNC_BATCH 个操作，新到的出场至多等待一批；某类队列已满时
+ * 提交被拒绝，操作的 code 为 PARKING_SERVICE_BUSY，由调用者稍后重试。
+ * 过载时队列不会无限增长，出场的等待时间也有上界。同一类操作按提交
+ * 顺序执行；提交者与属主线程只在入队、出队时短暂争用锁。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_ASYNC_BATCH 32 /**< 属主线程每次最多取出的操作数 */
+#define PARKING_ASYNC_DEFAULT_LIMIT 1024 /**< 每类队列的默认长度上限 */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 异步操作的种类。
+ * @details 依次对应 parking_service_fast_add_slot、fast_allocate_slot、
+ *          fast_allocate_any_slot、fast_deallocate_slot 与
+ *          fast_get_statistics。
+ */
+typedef enum ParkingAsyncKind {
+  PARKING_ASYNC_ADD_SLOT = 0,          /**< 添加车位。 */
+  PARKING_ASYNC_ALLOCATE_SLOT = 1,     /**< 在指定车位入场。 */
+  PARKING_ASYNC_ALLOCATE_ANY_SLOT = 2, /**< 在任意空闲车位入场。 */
+  PARKING_ASYNC_DEALLOCATE_SLOT = 3,   /**< 出场并计费。 */
+  PARKING_ASYNC_GET_STATISTICS = 4,    /**< 读取车位统计。 */
+  PARKING_ASYNC_KINDS = 5              /**< 操作种类数。 */
+} ParkingAsyncKind;
+
+/**
+ * @brief 提交队列的优先级，数值越小越优先。
+ */
+typedef enum ParkingAsyncPriority {
+  PARKING_ASYNC_PRIORITY_EXIT = 0,   /**< 出场：释放车位，最优先。 */
+  PARKING_ASYNC_PRIORITY_ENTRY = 1,  /**< 入场与添加车位。 */
+  PARKING_ASYNC_PRIORITY_LOOKUP = 2, /**< 查询。 */
+  PARKING_ASYNC_PRIORITIES = 3       /**< 优先级数。 */
+} ParkingAsyncPriority;
+
+/**
+ * @brief 属主线程的统计快照。
+ */
+typedef struct ParkingAsyncStats {
+  int queued[PARKING_ASYNC_PRIORITIES];    /**< 各类队列中排队的操作数。 */
+  int limits[PARKING_ASYNC_PRIORITIES];    /**< 各类队列的长度上限。 */
+  long rejected[PARKING_ASYNC_PRIORITIES]; /**< 因队列已满被拒绝的次数。 */
+} ParkingAsyncStats;
+
+struct ParkingAsyncOp;
+
+/**
+ * @brief 操作完成后的通知函数。
+ * @details 在属主线程中调用，不持有停车场的锁；返回后 op 归还调用者。
+ *          可以在其中提交操作，但不得调用 parking_async_stop。
+ * @param op 完成的操作，code 与输出字段已经写好。
+ * @param ctx 操作的 ctx 字段。
+ */
+typedef void (*ParkingAsyncDoneFn)(struct ParkingAsyncOp *op, void *ctx);
+
+/**
+ * @brief 一个异步操作。
+ * @details 以 parking_async_op_init 初始化后按种类填写输入字段。
+ *          字符串字段只保存指针，须与操作本身一样保持到完成。
+ */
+typedef struct ParkingAsyncOp {
+  ParkingAsyncKind kind; /**< 操作种类。 */
+  int slot_id; /**< 输入：车位编号；ALLOCATE_ANY_SLOT 时为输出。 */
+  const char *location;      /**< 输入：ADD_SLOT 的位置描述。 */
+  const char *owner_name;    /**< 输入：入场的车主姓名。 */
+  const char *license_plate; /**< 输入：入场的车牌号。 */
+  const char *contact;       /**< 输入：入场的联系方式。 */
+  ParkingType type;          /**< 输入：入场的停车类型。 */
+  ParkingAsyncDoneFn done;   /**< 完成通知函数，NULL 表示放入完成队列。 */
+  void *ctx;                 /**< 透传给通知函数的上下文指针。 */
+  ParkingServiceResultCode code; /**< 输出：操作的状态码。 */
+  ExitReceipt receipt;           /**< 输出：DEALLOCATE_SLOT 的计费明细。 */
+  ParkingStatistics stats;       /**< 输出：GET_STATISTICS 的统计。 */
+  struct ParkingAsyncOp *next;   /**< 内部使用：队列中的下一个操作。 */
+} ParkingAsyncOp;
+
+/**
+ * @brief 正在运行的属主线程（不透明类型）。
+ */
+typedef struct ParkingAsync ParkingAsync;
+
+/**
+ *********************************************************************************
+ *                              异步操作API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 初始化一个操作：清零全部字段并设置种类。
+ * @param op 目标操作。
+ * @param kind 操作种类。
+ */
+void parking_async_op_init(ParkingAsyncOp *op, ParkingAsyncKind kind);
+
+/**
+ * @brief 为停车场启动属主线程。
+ * @param lot 目标停车场，须比属主线程存活得久。
+ * @return 成功返回句柄；参数无效、内存不足或无法创建线程时返回 NULL。
+ */
+ParkingAsync *parking_async_start(ParkingLot *lot);
+
+/**
+ * @brief 提交一个操作，立即返回。
+ * @param async 属主线程。
+ * @param op 要执行的操作，提交后到完成前不得修改或释放。
+ * @return 已排队返回 0；参数无效（含未知种类）返回 -1；
+ *         属主线程正在停止返回 -2；所属类别的队列已满返回 -3，
+ *         此时 op->code 为 PARKING_SERVICE_BUSY，操作不会完成也不会通知。
+ */
+int parking_async_submit(ParkingAsync *async, ParkingAsyncOp *op);
+
+/**
+ * @brief 取得操作种类所属的优先级。
+ * @param kind 操作种类。
+ * @return 优先级；种类无效时返回 PARKING_ASYNC_PRIORITY_LOOKUP。
+ */
+ParkingAsyncPriority parking_async_priority(ParkingAsyncKind kind);
+
+/**
+ * @brief 设置某类提交队列的长度上限。
+ * @details 调低上限不影响已排队的操作，只拒绝之后的提交。
+ * @param async 属主线程。
+ * @param priority 优先级。
+ * @param limit 长度上限，必须大于 0。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int parking_async_set_limit(ParkingAsync *async, ParkingAsyncPriority priority,
+                            int limit);
+
+/**
+ * @brief 读取属主线程的统计快照。
+ * @param async 属主线程。
+ * @param[out] stats 接收快照；async 为 NULL 时清零。
+ */
+void parking_async_stats(ParkingAsync *async, ParkingAsyncStats *stats);
+
+/**
+ * @brief 从完成队列取回已完成的操作（按完成顺序）。
+ * @param async 属主线程。
+ * @param[out] ops 接收已完成的操作。
+ * @param max ops 的容量。
+ * @param timeout_ms 完成队列为空时最长等待的毫秒数，0 表示不等待。
+ * @return 取回的操作数，参数无效返回 -1。
+ */
+int parking_async_poll(ParkingAsync *async, ParkingAsyncOp **ops, int max,
+                       unsigned long timeout_ms);
+
+/**
+ * @brief 查询已提交、尚未执行完的操作数。
+ * @param async 属主线程。
+ * @return 操作数；async 为 NULL 时返回 0。
+ */
+long parking_async_in_flight(ParkingAsync *async);
+
+/**
+ * @brief 执行完已排队的操作后停止属主线程并释放句柄。
+ * @details 完成队列中尚未取回的操作不再通知，仍归调用者所有。
+ * @param async 属主线程，可以为 NULL。
+ */
+void parking_async_stop(ParkingAsync *async);
+
+#endif /* PARKING_ASYNC_H */
@@ -0,0 +1,213 @@
+/**
+ * @file parking_bitmap.c
+ * @brief 数据层位图实现文件
+ * @details
+ * 该文件实现了 parking_bitmap.h 中声明的位图操作。
+ * 查找最低置位时优先使用编译器内建函数，其他编译器退化为逐位移位。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_bitmap.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_BitScanForward)
+#endif
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 计算非零字中最低置位的下标。
+ * @param word 非零的位图字。
+ * @return 最低置位的下标（0 起）。
+ */
+static int lowest_set_bit(unsigned long word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzl(word);
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, word);
+  return (int)index;
+#else
+  int index = 0;
+  while ((word & 1UL) == 0) {
+    word >>= 1;
+    index++;
+  }
+  return index;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 计算一个字中置 1 的位数。
+ * @param word 位图字。
+ * @return 置位数。
+ */
+static int count_set_bits(unsigned long word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountl(word);
+#else
+  int count = 0;
+  while (word != 0) {
+    word &= word - 1;
+    count++;
+  }
+  return count;
+#endif
+}
+
+/* ========================================================================== */
+/*                              位图操作函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 将位图初始化为空状态（不分配内存）。
+ * @param bitmap 要初始化的位图。
+ * @param memory 之后分配位图字使用的内存对象，NULL 表示 C 堆。
+ */
+void slot_bitmap_init(SlotBitmap *bitmap, ParkingMemory *memory) {
+  bitmap->words = NULL;
+  bitmap->word_count = 0;
+  bitmap->memory = memory;
+}
+
+/**
+ * @brief 释放位图占用的内存，并将其恢复为空状态。
+ * @param bitmap 要释放的位图。
+ */
+void slot_bitmap_free(SlotBitmap *bitmap) {
+  parking_memory_free(bitmap->memory, bitmap->words);
+  slot_bitmap_init(bitmap, bitmap->memory);
+}
+
+/**
+ * @brief 确保位图至少能容纳指定数量的位。
+ * @details 新增的字全部清零。
+ * @param bitmap 目标位图。
+ * @param bit_count 需要容纳的位数。
+ * @return 成功返回 0，内存不足返回 -1（此时原位图保持不变）。
+ */
+int slot_bitmap_reserve(SlotBitmap *bitmap, size_t bit_count) {
+  size_t needed =
+      (bit_count + SLOT_BITMAP_WORD_BITS - 1) / SLOT_BITMAP_WORD_BITS;
+  unsigned long *new_words;
+
+  if (needed <= bitmap->word_count) {
+    return 0;
+  }
+
+  new_words = (unsigned long *)parking_memory_realloc(
+      bitmap->memory, PARKING_MEMORY_TABLE, bitmap->words,
+      needed * sizeof(unsigned long));
+  if (new_words == NULL) {
+    return -1;
+  }
+  memset(new_words + bitmap->word_count, 0,
+         (needed - bitmap->word_count) * sizeof(unsigned long));
+  bitmap->words = new_words;
+  bitmap->word_count = needed;
+  return 0;
+}
+
+/**
+ * @brief 将指定位置 1。
+ * @param bitmap 目标位图。
+ * @param bit 位下标。
+ */
+void slot_bitmap_set(SlotBitmap *bitmap, size_t bit) {
+  bitmap->words[bit / SLOT_BITMAP_WORD_BITS] |=
+      1UL << (bit % SLOT_BITMAP_WORD_BITS);
+}
+
+/**
+ * @brief 将指定位清 0。
+ * @param bitmap 目标位图。
+ * @param bit 位下标。
+ */
+void slot_bitmap_clear(SlotBitmap *bitmap, size_t bit) {
+  bitmap->words[bit / SLOT_BITMAP_WORD_BITS] &=
+      ~(1UL << (bit % SLOT_BITMAP_WORD_BITS));
+}
+
+/**
+ * @brief 测试指定位是否为 1。
+ * @param bitmap 目标位图。
+ * @param bit 位下标。
+ * @return 该位为 1 返回 1，否则返回 0。
+ */
+int slot_bitmap_test(const SlotBitmap *bitmap, size_t bit) {
+  return (int)((bitmap->words[bit / SLOT_BITMAP_WORD_BITS] >>
+                (bit % SLOT_BITMAP_WORD_BITS)) &
+               1UL);
+}
+
+/**
+ * @brief 查找下标最小的置 1 位。
+ * @param bitmap 目标位图。
+ * @param bit_count 只在前 bit_count 位中查找。
+ * @return 找到时返回位下标，否则返回 -1。
+ */
+long slot_bitmap_find_first(const SlotBitmap *bitmap, size_t bit_count) {
+  size_t words =
+      (bit_count + SLOT_BITMAP_WORD_BITS - 1) / SLOT_BITMAP_WORD_BITS;
+  size_t i;
+  size_t bit;
+
+  if (words > bitmap->word_count) {
+    words = bitmap->word_count;
+  }
+
+  for (i = 0; i < words; i++) {
+    if (bitmap->words[i] != 0) {
+      bit = i * SLOT_BITMAP_WORD_BITS +
+            (size_t)lowest_set_bit(bitmap->words[i]);
+      return bit < bit_count ? (long)bit : -1;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief 查找第 rank 个取值为 value 的位。
+ * @param bitmap 目标位图。
+ * @param bit_count 只在前 bit_count 位中查找。
+ * @param rank 目标位的序号（0 起）。
+ * @param value 非 0 查找置 1 的位，0 查找为 0 的位。
+ * @return 找到时返回位下标，否则返回 -1。
+ */
+long slot_bitmap_select(const SlotBitmap *bitmap, size_t bit_count,
+                        size_t rank, int value) {
+  size_t words =
+      (bit_count + SLOT_BITMAP_WORD_BITS - 1) / SLOT_BITMAP_WORD_BITS;
+  size_t i;
+  size_t bit;
+  size_t matches;
+  unsigned long word;
+
+  for (i = 0; i < words; i++) {
+    word = i < bitmap->word_count ? bitmap->words[i] : 0UL;
+    if (!value) {
+      word = ~word;
+    }
+    /* 末尾不足一个字时屏蔽 bit_count 之后的位 */
+    if ((i + 1) * SLOT_BITMAP_WORD_BITS > bit_count) {
+      word &= (1UL << (bit_count - i * SLOT_BITMAP_WORD_BITS)) - 1UL;
+    }
+    matches = (size_t)count_set_bits(word);
+    if (rank >= matches) {
+      rank -= matches;
+      continue;
+    }
+    while (rank > 0) {
+      word &= word - 1;
+      rank--;
+    }
+    bit = i * SLOT_BITMAP_WORD_BITS + (size_t)lowest_set_bit(word);
+    return (long)bit;
+  }
+  return -1;
+}
@@ -0,0 +1,118 @@
+#ifndef PARKING_BITMAP_H
+#define PARKING_BITMAP_H
+
+#include <stddef.h>
+
+#include "parking_memory.h"
+
+/**
+ * @file parking_bitmap.h
+ * @brief 数据层使用的定长位图结构声明。
+ * @details
+ * 位图按机器字（unsigned long）存放，每一位对应稠密车位表中的一行。
+ * 停车场用它记录空闲车位，查找任意空闲车位时按字扫描并使用
+ * “查找最低置位”指令，而不必逐个检查车位状态。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define SLOT_BITMAP_WORD_BITS                                                  \
+  (sizeof(unsigned long) * 8) /**< 每个位图字包含的位数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 可扩容的位图。
+ * @details 新扩出的字全部清零；位图不记录逻辑长度，越界位由调用者保证为 0。
+ */
+typedef struct SlotBitmap {
+  unsigned long *words; /**< 位图字数组，未分配时为 NULL。 */
+  size_t word_count;    /**< 已分配的字数。 */
+  ParkingMemory *memory; /**< 位图字数组的分配来源，NULL 表示 C 堆。 */
+} SlotBitmap;
+
+/**
+ *********************************************************************************
+ *                            位图操作API声明
+ *********************************************************************************
+ */
+
+/** @name 位图操作 */
+/** @{ */
+
+/**
+ * @brief 将位图初始化为空状态（不分配内存）。
+ * @param bitmap 要初始化的位图。
+ * @param memory 之后分配位图字使用的内存对象，NULL 表示 C 堆。
+ */
+void slot_bitmap_init(SlotBitmap *bitmap, ParkingMemory *memory);
+
+/**
+ * @brief 释放位图占用的内存，并将其恢复为空状态。
+ * @param bitmap 要释放的位图。
+ */
+void slot_bitmap_free(SlotBitmap *bitmap);
+
+/**
+ * @brief 确保位图至少能容纳指定数量的位。
+ * @param bitmap 目标位图。
+ * @param bit_count 需要容纳的位数。
+ * @return 成功返回 0，内存不足返回 -1（此时原位图保持不变）。
+ */
+int slot_bitmap_reserve(SlotBitmap *bitmap, size_t bit_count);
+
+/**
+ * @brief 将指定位置 1。
+ * @param bitmap 目标位图。
+ * @param bit 位下标，必须小于已容纳的位数。
+ */
+void slot_bitmap_set(SlotBitmap *bitmap, size_t bit);
+
+/**
+ * @brief 将指定位清 0。
+ * @param bitmap 目标位图。
+ * @param bit 位下标，必须小于已容纳的位数。
+ */
+void slot_bitmap_clear(SlotBitmap *bitmap, size_t bit);
+
+/**
+ * @brief 测试指定位是否为 1。
+ * @param bitmap 目标位图。
+ * @param bit 位下标，必须小于已容纳的位数。
+ * @return 该位为 1 返回 1，否则返回 0。
+ */
+int slot_bitmap_test(const SlotBitmap *bitmap, size_t bit);
+
+/**
+ * @brief 查找下标最小的置 1 位。
+ * @details 逐字跳过全 0 的字，再对首个非零字取最低置位。
+ * @param bitmap 目标位图。
+ * @param bit_count 只在前 bit_count 位中查找。
+ * @return 找到时返回位下标，否则返回 -1。
+ */
+long slot_bitmap_find_first(const SlotBitmap *bitmap, size_t bit_count);
+
+/**
+ * @brief 查找第 rank 个取值为 value 的位。
+ * @details 逐字统计置位数跳过不含目标位的字，只在目标所在的字内逐位查找，
+ *          分页时可以直接定位到第 rank 个空闲（或已占用）车位。
+ * @param bitmap 目标位图。
+ * @param bit_count 只在前 bit_count 位中查找；超出已分配字数的位视为 0。
+ * @param rank 目标位的序号（0 起）。
+ * @param value 要查找的取值，非 0 表示置 1 的位，0 表示为 0 的位。
+ * @return 找到时返回位下标，否则返回 -1。
+ */
+long slot_bitmap_select(const SlotBitmap *bitmap, size_t bit_count,
+                        size_t rank, int value);
+
+/** @} */
+
+#endif /* PARKING_BITMAP_H */
@@ -0,0 +1,302 @@
+/**
+ * @file parking_calendar.c
+ * @brief 本地日历换算与当日边界缓存的实现文件
+ * @details
+ * 该文件实现了 parking_calendar.h 中声明的日历函数。
+ * 日期边界通过 mktime 求得，因此夏令时切换日的 23/25 小时同样正确。
+ * 可重入的 localtime_r 需要在包含系统头文件前开启 _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <string.h>
+#include <time.h>
+
+#include "parking_calendar.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 以可重入方式把时间戳转换为本地时间。
+ * @param when 时间戳。
+ * @param[out] local 接收本地时间。
+ */
+static void local_time(time_t when, struct tm *local) {
+#ifdef _WIN32
+  localtime_s(local, &when);
+#else
+  localtime_r(&when, local);
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 求本地日期中某一小时整点对应的时间戳。
+ * @param date 该日期的本地时间（只使用年、月、日）。
+ * @param day_offset 相对该日期的天数偏移。
+ * @param hour 小时。
+ * @return 对应的时间戳。
+ */
+static time_t local_moment(const struct tm *date, int day_offset, int hour) {
+  struct tm moment = *date;
+
+  moment.tm_mday += day_offset;
+  moment.tm_hour = hour;
+  moment.tm_min = 0;
+  moment.tm_sec = 0;
+  moment.tm_isdst = -1;
+  return mktime(&moment);
+}
+
+/**
+ * @brief (静态辅助函数) 重新计算并缓存某一时刻所在日期的边界。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ */
+static void calendar_refresh(ParkingCalendar *calendar, time_t when) {
+  struct tm local;
+
+  local_time(when, &local);
+  calendar->month_key = (long)(local.tm_year + 1900) * 100 + local.tm_mon + 1;
+  calendar->day_key = calendar->month_key * 100 + local.tm_mday;
+  calendar->day_start = local_moment(&local, 0, 0);
+  calendar->day_end = local_moment(&local, 1, 0);
+  calendar->window_start = local_moment(&local, 0, calendar->start_hour);
+  calendar->window_end = local_moment(&local, 0, calendar->end_hour);
+
+  /* mktime 失败（返回 -1）或结果异常时不保留缓存，下次重新计算 */
+  if (calendar->day_start == (time_t)-1 || calendar->day_end == (time_t)-1 ||
+      when < calendar->day_start || when >= calendar->day_end) {
+    calendar->day_end = calendar->day_start;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 取得某一时刻所在日期的边界。
+ * @details 与 parking_calendar_lookup 相同，只有时间向前推进时才替换缓存；
+ *          早于缓存日期的时刻在 scratch 中计算。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @param scratch 缓存不适用时使用的临时日历。
+ * @return 含有该日期边界的日历；mktime 失败时返回 NULL。
+ */
+static const ParkingCalendar *calendar_day_of(ParkingCalendar *calendar,
+                                              time_t when,
+                                              ParkingCalendar *scratch) {
+  if (when >= calendar->day_end) {
+    calendar_refresh(calendar, when);
+  }
+  if (when >= calendar->day_start && when < calendar->day_end) {
+    return calendar;
+  }
+  *scratch = *calendar;
+  calendar_refresh(scratch, when);
+  return when >= scratch->day_start && when < scratch->day_end ? scratch
+                                                               : NULL;
+}
+
+/* ========================================================================== */
+/*                                 日历函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 计算某一时刻所在的本地日期与月份编号（不使用缓存）。
+ * @param when 时间戳。
+ * @param[out] day 日期编号（YYYYMMDD），可以为 NULL。
+ * @param[out] month 月份编号（YYYYMM），可以为 NULL。
+ */
+void parking_calendar_convert(time_t when, long *day, long *month) {
+  struct tm local;
+  long month_key;
+
+  local_time(when, &local);
+  month_key = (long)(local.tm_year + 1900) * 100 + local.tm_mon + 1;
+  if (month) {
+    *month = month_key;
+  }
+  if (day) {
+    *day = month_key * 100 + local.tm_mday;
+  }
+}
+
+/**
+ * @brief 初始化日历缓存。
+ * @param calendar 要初始化的日历。
+ * @param start_hour 每日允许时段的开始小时。
+ * @param end_hour 每日允许时段的结束小时（不含）。
+ */
+void parking_calendar_init(ParkingCalendar *calendar, int start_hour,
+                           int end_hour) {
+  if (calendar == NULL) {
+    return;
+  }
+  calendar->day_start = 0;
+  calendar->day_end = 0;
+  calendar->window_start = 0;
+  calendar->window_end = 0;
+  calendar->day_key = 0;
+  calendar->month_key = 0;
+  calendar->start_hour = start_hour;
+  calendar->end_hour = end_hour;
+}
+
+/**
+ * @brief 取得某一时刻所在的本地日期与月份编号。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @param[out] day 日期编号（YYYYMMDD），可以为 NULL。
+ * @param[out] month 月份编号（YYYYMM），可以为 NULL。
+ */
+void parking_calendar_lookup(ParkingCalendar *calendar, time_t when, long *day,
+                             long *month) {
+  if (when < calendar->day_start || when >= calendar->day_end) {
+    /* 只有时间向前推进时才替换缓存，查询历史日期不会挤掉“当日” */
+    if (when >= calendar->day_end) {
+      calendar_refresh(calendar, when);
+    }
+    if (when < calendar->day_start || when >= calendar->day_end) {
+      parking_calendar_convert(when, day, month);
+      return;
+    }
+  }
+  if (day) {
+    *day = calendar->day_key;
+  }
+  if (month) {
+    *month = calendar->month_key;
+  }
+}
+
+/**
+ * @brief 判断某一时刻是否处于当天的允许时段内。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @return 处于允许时段内返回 1，否则返回 0。
+ */
+int parking_calendar_in_window(ParkingCalendar *calendar, time_t when) {
+  if (when < calendar->day_start || when >= calendar->day_end) {
+    calendar_refresh(calendar, when);
+  }
+  return when >= calendar->window_start && when < calendar->window_end;
+}
+
+/**
+ * @brief 求某一时刻之后的第一个本地 0 点。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @return 晚于 when 的第一个本地 0 点；mktime 失败时退化为 when 之后 24 小时。
+ */
+time_t parking_calendar_next_day(ParkingCalendar *calendar, time_t when) {
+  ParkingCalendar scratch;
+  const ParkingCalendar *day = calendar_day_of(calendar, when, &scratch);
+
+  return day != NULL ? day->day_end : when + 24 * 3600;
+}
+
+/**
+ * @brief 求某一时刻之后允许时段的第一个结束时刻。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @return 晚于 when 的第一个允许时段结束时刻；mktime 失败时退化为
+ *         when 之后 24 小时。
+ */
+time_t parking_calendar_next_window_end(ParkingCalendar *calendar,
+                                        time_t when) {
+  ParkingCalendar scratch;
+  const ParkingCalendar *day = calendar_day_of(calendar, when, &scratch);
+
+  if (day == NULL) {
+    return when + 24 * 3600;
+  }
+  if (when < day->window_end) {
+    return day->window_end;
+  }
+  /* 次日的边界不写入缓存，避免把“当日”提前挤掉 */
+  scratch = *calendar;
+  calendar_refresh(&scratch, day->day_end);
+  return scratch.day_end > scratch.day_start ? scratch.window_end
+                                             : when + 24 * 3600;
+}
+
+/**
+ * @brief 求某一时刻所在的本地小时。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @return 本地小时（0-23）；mktime 失败时返回 0。
+ */
+int parking_calendar_hour(ParkingCalendar *calendar, time_t when) {
+  ParkingCalendar scratch;
+  const ParkingCalendar *day = calendar_day_of(calendar, when, &scratch);
+  long hour;
+
+  if (day == NULL) {
+    return 0;
+  }
+  hour = (long)(when - day->day_start) / 3600;
+  return hour > 23 ? 23 : (int)hour;
+}
+
+/**
+ * @brief 求某一时刻之后（或之前）若干个自然月的同一本地时刻。
+ * @param when 时间戳。
+ * @param months 月数，可以为负。
+ * @return 对应的时间戳；mktime 失败时返回 (time_t)-1。
+ */
+time_t parking_calendar_add_months(time_t when, int months) {
+  struct tm local;
+  struct tm month_end;
+  long ordinal;
+  int day;
+
+  local_time(when, &local);
+  ordinal = (long)local.tm_year * 12 + local.tm_mon + months;
+  day = local.tm_mday;
+  local.tm_year = (int)(ordinal >= 0 ? ordinal / 12 : (ordinal - 11) / 12);
+  local.tm_mon = (int)(ordinal - (long)local.tm_year * 12);
+
+  /* 下个月的第 0 天即目标月份的最后一天 */
+  memset(&month_end, 0, sizeof(month_end));
+  month_end.tm_year = local.tm_year;
+  month_end.tm_mon = local.tm_mon + 1;
+  month_end.tm_mday = 0;
+  month_end.tm_hour = 12;
+  month_end.tm_isdst = -1;
+  if (mktime(&month_end) == (time_t)-1) {
+    return (time_t)-1;
+  }
+  local.tm_mday = day < month_end.tm_mday ? day : month_end.tm_mday;
+  local.tm_isdst = -1;
+  return mktime(&local);
+}
+
+/**
+ * @brief 把日期编号换算为连续的日序号。
+ * @param day_key 日期编号（YYYYMMDD）。
+ * @return 日序号。
+ */
+long parking_calendar_day_number(long day_key) {
+  long year = day_key / 10000;
+  long month = day_key / 100 % 100;
+  long day = day_key % 100;
+
+  /* 从 3 月起算，闰日落在一年的最后 */
+  if (month <= 2) {
+    year--;
+    month += 12;
+  }
+  return 365 * year + year / 4 - year / 100 + year / 400 +
+         (153 * (month - 3) + 2) / 5 + day;
+}
+
+/**
+ * @brief 求日期所在的周（周一至周日）的序号。
+ * @param day_key 日期编号（YYYYMMDD）。
+ * @return 周序号。
+ */
+long parking_calendar_week_number(long day_key) {
+  /* 日序号模 7 余 6 的日期是周一 */
+  return (parking_calendar_day_number(day_key) + 1) / 7;
+}
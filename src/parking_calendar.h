@@ -0,0 +1,139 @@
+#ifndef PARKING_CALENDAR_H
+#define PARKING_CALENDAR_H
+
+#include <time.h>
+
+/**
+ * @file parking_calendar.h
+ * @brief 本地日历换算与当日边界缓存。
+ * @details
+ * 停车场的日/月统计、收入周期与访客入场时段都需要把时间戳换算成本地日期。
+ * 该模块提供可重入的换算函数，以及缓存“当日”起止时间的 ParkingCalendar：
+ * 缓存命中时，同日、同月与访客时段的判断都只是整数比较，
+ * 每天只在第一次遇到新日期时调用一次 localtime_r/mktime。
+ * ParkingCalendar 本身不加锁，由持有者负责同步（例如在停车场写锁内使用）。
+ */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 缓存了一个本地日期边界的日历。
+ */
+typedef struct ParkingCalendar {
+  time_t day_start;    /**< 缓存日期的 0 点，未缓存时与 day_end 相等。 */
+  time_t day_end;      /**< 缓存日期次日的 0 点。 */
+  time_t window_start; /**< 缓存日期内允许时段的开始时刻。 */
+  time_t window_end;   /**< 缓存日期内允许时段的结束时刻（不含）。 */
+  long day_key;        /**< 缓存日期的编号（YYYYMMDD）。 */
+  long month_key;      /**< 缓存日期所在月份的编号（YYYYMM）。 */
+  int start_hour;      /**< 允许时段的开始小时（24 小时制）。 */
+  int end_hour;        /**< 允许时段的结束小时（不含）。 */
+} ParkingCalendar;
+
+/**
+ *********************************************************************************
+ *                                 日历API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 计算某一时刻所在的本地日期与月份编号（不使用缓存）。
+ * @details 使用可重入的 localtime_r/localtime_s，可在多个线程中同时调用。
+ * @param when 时间戳。
+ * @param[out] day 日期编号（YYYYMMDD），可以为 NULL。
+ * @param[out] month 月份编号（YYYYMM），可以为 NULL。
+ */
+void parking_calendar_convert(time_t when, long *day, long *month);
+
+/**
+ * @brief 初始化日历缓存。
+ * @param calendar 要初始化的日历。
+ * @param start_hour 每日允许时段的开始小时。
+ * @param end_hour 每日允许时段的结束小时（不含）。
+ */
+void parking_calendar_init(ParkingCalendar *calendar, int start_hour,
+                           int end_hour);
+
+/**
+ * @brief 取得某一时刻所在的本地日期与月份编号。
+ * @details 时刻落在缓存日期内时直接返回缓存的编号；晚于缓存日期时
+ *          重新计算并缓存新日期，早于缓存日期时只做一次不缓存的换算。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @param[out] day 日期编号（YYYYMMDD），可以为 NULL。
+ * @param[out] month 月份编号（YYYYMM），可以为 NULL。
+ */
+void parking_calendar_lookup(ParkingCalendar *calendar, time_t when, long *day,
+                             long *month);
+
+/**
+ * @brief 判断某一时刻是否处于当天的允许时段内。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @return 处于允许时段内返回 1，否则返回 0。
+ */
+int parking_calendar_in_window(ParkingCalendar *calendar, time_t when);
+
+/**
+ * @brief 求某一时刻之后的第一个本地 0 点。
+ * @details 时刻落在缓存日期内时直接返回缓存的次日 0 点。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @return 晚于 when 的第一个本地 0 点。
+ */
+time_t parking_calendar_next_day(ParkingCalendar *calendar, time_t when);
+
+/**
+ * @brief 求某一时刻之后允许时段的第一个结束时刻。
+ * @details when 早于当日允许时段的结束时刻时返回当日的结束时刻，
+ *          否则返回次日的结束时刻；只有前者会使用并更新缓存。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @return 晚于 when 的第一个允许时段结束时刻。
+ */
+time_t parking_calendar_next_window_end(ParkingCalendar *calendar,
+                                        time_t when);
+
+/**
+ * @brief 求某一时刻所在的本地小时。
+ * @details 按当日 0 点起经过的整小时数计算；夏令时切换日多出的小时
+ *          归入 23 点。
+ * @param calendar 日历缓存。
+ * @param when 时间戳。
+ * @return 本地小时（0-23）；mktime 失败时返回 0。
+ */
+int parking_calendar_hour(ParkingCalendar *calendar, time_t when);
+
+/**
+ * @brief 求某一时刻之后（或之前）若干个自然月的同一本地时刻。
+ * @details 保持本地日期中的日与时分秒不变；目标月份没有该日时取该月最后
+ *          一天（例如 1 月 31 日加一个月为 2 月 28 日或 29 日）。
+ *          不使用缓存，可在多个线程中同时调用。
+ * @param when 时间戳。
+ * @param months 月数，可以为负。
+ * @return 对应的时间戳；mktime 失败时返回 (time_t)-1。
+ */
+time_t parking_calendar_add_months(time_t when, int months);
+
+/**
+ * @brief 把日期编号换算为连续的日序号。
+ * @details 按公历从公元 0 年 3 月 1 日起计天数，不调用 mktime；
+ *          相邻日期的序号相差 1，且始终大于 0，适合作为按日环形桶的键。
+ * @param day_key 日期编号（YYYYMMDD）。
+ * @return 日序号。
+ */
+long parking_calendar_day_number(long day_key);
+
+/**
+ * @brief 求日期所在的周（周一至周日）的序号。
+ * @details 相邻两周的序号相差 1。
+ * @param day_key 日期编号（YYYYMMDD）。
+ * @return 周序号。
+ */
+long parking_calendar_week_number(long day_key);
+
+#endif /* PARKING_CALENDAR_H */
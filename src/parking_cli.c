@@ -0,0 +1,589 @@
+/**
+ * @file parking_cli.c
+ * @brief 非交互命令模式实现文件
+ * @details
+ * 该文件实现了 parking_cli.h 中声明的命令表、脚本执行与命令行入口。
+ * 每个命令解析参数后直接调用一个服务函数，结果字段先写入定长的响应
+ * 缓冲区，再连同状态码一次写出；整段脚本只加载与保存一次数据文件。
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_cli.h"
+
+/* ========================================================================== */
+/*                                 内部类型定义                               */
+/* ========================================================================== */
+
+#define CLI_MAX_REPLY 1024 /**< 一行结果字段的最大字节数 */
+
+/**
+ * @brief 一条命令的结果字段。
+ */
+typedef struct CliReply {
+  char data[CLI_MAX_REPLY]; /**< 以制表符开头的各字段，以 '\0' 结尾。 */
+  size_t used;              /**< 已写入的字节数。 */
+} CliReply;
+
+/**
+ * @brief 命令处理函数。
+ * @param lot 目标停车场。
+ * @param args 命令名之后的参数。
+ * @param argc 参数个数。
+ * @param out 接收结果字段。
+ * @return 操作的状态码。
+ */
+typedef ParkingServiceResultCode (*CliHandler)(ParkingLot *lot, char **args,
+                                               int argc, CliReply *out);
+
+/**
+ * @brief 命令表的一项。
+ */
+typedef struct CliCommand {
+  const char *name;   /**< 命令名。 */
+  int min_args;       /**< 最少参数个数。 */
+  int max_args;       /**< 最多参数个数。 */
+  int mutates;        /**< 成功时是否修改了停车场。 */
+  CliHandler handler; /**< 处理函数。 */
+} CliCommand;
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 追加一个以制表符开头的文本字段，超出上限的部分截断。
+ * @param out 目标位置。
+ * @param text 字段文本，NULL 视为空串。
+ */
+static void reply_field(CliReply *out, const char *text) {
+  size_t length;
+  size_t room = CLI_MAX_REPLY - 1 - out->used;
+
+  if (text == NULL) {
+    text = "";
+  }
+  if (room == 0) {
+    return;
+  }
+  out->data[out->used++] = '\t';
+  room--;
+  length = strlen(text);
+  if (length > room) {
+    length = room;
+  }
+  memcpy(out->data + out->used, text, length);
+  out->used += length;
+  out->data[out->used] = '\0';
+}
+
+/**
+ * @brief (静态辅助函数) 追加一个以制表符开头的整数字段。
+ * @param out 目标位置。
+ * @param value 字段值。
+ */
+static void reply_long(CliReply *out, long value) {
+  char digits[24];
+
+  sprintf(digits, "%ld", value);
+  reply_field(out, digits);
+}
+
+/**
+ * @brief (静态辅助函数) 追加一个以制表符开头、保留两位小数的金额字段。
+ * @param out 目标位置。
+ * @param value 金额（元）。
+ */
+static void reply_amount(CliReply *out, double value) {
+  char digits[48];
+
+  sprintf(digits, "%.2f", value);
+  reply_field(out, digits);
+}
+
+/**
+ * @brief (静态辅助函数) 解析十进制车位编号。
+ * @param text 字段文本。
+ * @param[out] value 接收编号。
+ * @return 整个字段都是整数时返回 1，否则返回 0（范围由服务层校验）。
+ */
+static int parse_slot_id(const char *text, int *value) {
+  char *end;
+  long parsed;
+
+  errno = 0;
+  parsed = strtol(text, &end, 10);
+  if (end == text || *end != '\0' || errno != 0 || parsed < 0 ||
+      parsed > 2147483647L) {
+    return 0;
+  }
+  *value = (int)parsed;
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 解析停车类型。
+ * @param text "resident" 或 "visitor"。
+ * @param[out] type 接收停车类型。
+ * @return 有效返回 1，否则返回 0。
+ */
+static int parse_type(const char *text, ParkingType *type) {
+  if (strcmp(text, "resident") == 0) {
+    *type = RESIDENT_TYPE;
+    return 1;
+  }
+  if (strcmp(text, "visitor") == 0) {
+    *type = VISITOR_TYPE;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 车位访问函数：在查找所在的读锁内写出车位的全部字段。
+ * @param slot 找到的车位。
+ * @param ctx 目标 CliReply。
+ * @return 始终返回 0。
+ */
+static int reply_slot(ParkingSlot *slot, void *ctx) {
+  CliReply *out = (CliReply *)ctx;
+
+  reply_long(out, slot->slot_id);
+  reply_field(out, slot->location);
+  reply_field(out, slot->status == OCCUPIED_STATUS ? "occupied" : "free");
+  reply_field(out, slot->type == VISITOR_TYPE ? "visitor" : "resident");
+  reply_field(out, slot->owner_name);
+  reply_field(out, slot->license_plate);
+  reply_field(out, slot->contact);
+  reply_long(out, (long)slot->entry_time);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) add：对应 parking_service_fast_add_slot。
+ */
+static ParkingServiceResultCode handle_add(ParkingLot *lot, char **args,
+                                           int argc, CliReply *out) {
+  int slot_id;
+
+  (void)argc;
+  (void)out;
+  if (!parse_slot_id(args[0], &slot_id)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  return parking_service_fast_add_slot(lot, slot_id, args[1]);
+}
+
+/**
+ * @brief (静态辅助函数) allocate：对应 parking_service_fast_allocate_slot。
+ */
+static ParkingServiceResultCode handle_allocate(ParkingLot *lot, char **args,
+                                                int argc, CliReply *out) {
+  ParkingType type;
+  int slot_id;
+
+  (void)argc;
+  (void)out;
+  if (!parse_slot_id(args[0], &slot_id) || !parse_type(args[4], &type)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  return parking_service_fast_allocate_slot(lot, slot_id, args[1], args[2],
+                                            args[3], type);
+}
+
+/**
+ * @brief (静态辅助函数) allocate_any：对应
+ *        parking_service_fast_allocate_any_slot，结果为分到的车位编号。
+ */
+static ParkingServiceResultCode handle_allocate_any(ParkingLot *lot,
+                                                    char **args, int argc,
+                                                    CliReply *out) {
+  ParkingServiceResultCode code;
+  ParkingType type;
+  int slot_id;
+
+  (void)argc;
+  if (!parse_type(args[3], &type)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  code = parking_service_fast_allocate_any_slot(lot, args[0], args[1], args[2],
+                                                type, &slot_id);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    reply_long(out, slot_id);
+  }
+  return code;
+}
+
+/**
+ * @brief (静态辅助函数) exit：对应 parking_service_fast_deallocate_slot，
+ *        结果为应缴金额（分）与停车秒数。
+ */
+static ParkingServiceResultCode handle_exit(ParkingLot *lot, char **args,
+                                            int argc, CliReply *out) {
+  ParkingServiceResultCode code;
+  ExitReceipt receipt;
+  int slot_id;
+
+  (void)argc;
+  if (!parse_slot_id(args[0], &slot_id)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  code = parking_service_fast_deallocate_slot(lot, slot_id, &receipt);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    reply_long(out, receipt.amount_cents);
+    reply_long(out, receipt.duration_seconds);
+  }
+  return code;
+}
+
+/**
+ * @brief (静态辅助函数) find：对应 parking_service_fast_visit_slot_by_id。
+ */
+static ParkingServiceResultCode handle_find(ParkingLot *lot, char **args,
+                                            int argc, CliReply *out) {
+  int slot_id;
+
+  (void)argc;
+  if (!parse_slot_id(args[0], &slot_id)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  return parking_service_fast_visit_slot_by_id(lot, slot_id, reply_slot, out);
+}
+
+/**
+ * @brief (静态辅助函数) find_plate：对应
+ *        parking_service_fast_visit_slot_by_license。
+ */
+static ParkingServiceResultCode handle_find_plate(ParkingLot *lot,
+                                                  char **args, int argc,
+                                                  CliReply *out) {
+  (void)argc;
+  return parking_service_fast_visit_slot_by_license(lot, args[0], reply_slot,
+                                                    out);
+}
+
+/**
+ * @brief (静态辅助函数) stats：对应 parking_service_fast_get_statistics。
+ */
+static ParkingServiceResultCode handle_stats(ParkingLot *lot, char **args,
+                                             int argc, CliReply *out) {
+  ParkingServiceResultCode code;
+  ParkingStatistics stats;
+
+  (void)args;
+  (void)argc;
+  code = parking_service_fast_get_statistics(lot, &stats);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    reply_long(out, stats.total_slots);
+    reply_long(out, stats.occupied_slots);
+    reply_long(out, stats.free_slots);
+    reply_amount(out, stats.today_revenue);
+    reply_amount(out, stats.month_revenue);
+  }
+  return code;
+}
+
+/**
+ * @brief (静态辅助函数) export：对应 parking_service_export_slots，
+ *        格式默认为 csv，筛选条件默认为 all。
+ */
+static ParkingServiceResultCode handle_export(ParkingLot *lot, char **args,
+                                              int argc, CliReply *out) {
+  SlotExportFormat format = SLOT_EXPORT_CSV;
+  SlotFilter filter = SLOT_FILTER_ALL;
+  ParkingServiceResultCode code;
+  ServiceResult result;
+
+  (void)out;
+  if (argc > 1) {
+    if (strcmp(args[1], "ndjson") == 0) {
+      format = SLOT_EXPORT_NDJSON;
+    } else if (strcmp(args[1], "csv") != 0) {
+      return PARKING_SERVICE_INVALID_PARAM;
+    }
+  }
+  if (argc > 2) {
+    if (strcmp(args[2], "free") == 0) {
+      filter = SLOT_FILTER_FREE;
+    } else if (strcmp(args[2], "occupied") == 0) {
+      filter = SLOT_FILTER_OCCUPIED;
+    } else if (strcmp(args[2], "all") != 0) {
+      return PARKING_SERVICE_INVALID_PARAM;
+    }
+  }
+  result = parking_service_export_slots(lot, args[0], filter, format);
+  code = result.code;
+  parking_service_free_result(&result);
+  return code;
+}
+
+/**
+ * @brief (静态辅助函数) save：对应 parking_service_save_data。
+ */
+static ParkingServiceResultCode handle_save(ParkingLot *lot, char **args,
+                                            int argc, CliReply *out) {
+  ParkingServiceResultCode code;
+  ServiceResult result;
+
+  (void)argc;
+  (void)out;
+  result = parking_service_save_data(lot, args[0]);
+  code = result.code;
+  parking_service_free_result(&result);
+  return code;
+}
+
+/** 命令表。 */
+static const CliCommand cli_commands[] = {
+    {"add", 2, 2, 1, handle_add},
+    {"allocate", 5, 5, 1, handle_allocate},
+    {"allocate_any", 4, 4, 1, handle_allocate_any},
+    {"exit", 1, 1, 1, handle_exit},
+    {"find", 1, 1, 0, handle_find},
+    {"find_plate", 1, 1, 0, handle_find_plate},
+    {"stats", 0, 0, 0, handle_stats},
+    {"export", 1, 3, 0, handle_export},
+    {"save", 1, 1, 0, handle_save}};
+
+/**
+ * @brief (静态辅助函数) 按空格与制表符切分脚本行。
+ * @param line 脚本行，在原处切分。
+ * @param[out] fields 接收各字段的起始位置，至少 PARKING_CLI_MAX_FIELDS + 1 项。
+ * @return 字段数；超过 PARKING_CLI_MAX_FIELDS 个时返回
+ *         PARKING_CLI_MAX_FIELDS + 1。
+ */
+static int split_words(char *line, char **fields) {
+  int count = 0;
+  char *p = line;
+
+  for (;;) {
+    p += strspn(p, " \t\r\n");
+    if (*p == '\0') {
+      return count;
+    }
+    if (count == PARKING_CLI_MAX_FIELDS) {
+      return PARKING_CLI_MAX_FIELDS + 1;
+    }
+    fields[count++] = p;
+    p += strcspn(p, " \t\r\n");
+    if (*p != '\0') {
+      *p++ = '\0';
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 打开数据文件对应的停车场。
+ * @details 文件不存在时新建停车场；文件存在但无法加载时报错，
+ *          避免随后把空停车场保存回去覆盖原有数据。
+ * @param filename 数据文件名。
+ * @return 成功返回停车场，失败返回 NULL（已向标准错误输出原因）。
+ */
+static ParkingLot *open_lot(const char *filename) {
+  ServiceResult result;
+  ParkingLot *lot;
+  FILE *probe = fopen(filename, "rb");
+
+  if (probe == NULL) {
+    lot = init_parking_lot(PARKING_CLI_DEFAULT_CAPACITY);
+    if (lot == NULL) {
+      fprintf(stderr, "停车场初始化失败\n");
+    }
+    return lot;
+  }
+  fclose(probe);
+
+  result = parking_service_load_data(filename);
+  if (result.code != PARKING_SERVICE_SUCCESS) {
+    parking_service_print_error(result);
+    return NULL;
+  }
+  return (ParkingLot *)result.data;
+}
+
+/**
+ * @brief (静态辅助函数) 输出命令行用法。
+ * @param stream 输出流。
+ * @param program 程序名。
+ */
+static void print_usage(FILE *stream, const char *program) {
+  fprintf(stream,
+          "用法: %s [--data 数据文件] <命令> [参数...]\n"
+          "      %s [--data 数据文件] --exec <脚本文件|->\n"
+          "不带参数时进入交互菜单。\n"
+          "命令: add allocate allocate_any exit find find_plate stats "
+          "export save\n",
+          program, program);
+}
+
+/* ========================================================================== */
+/*                               命令模式API实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 执行一个已切分为字段的命令，并把结果行写到 out。
+ * @param lot 目标停车场。
+ * @param argc 字段数，第一个字段为命令名。
+ * @param argv 各字段。
+ * @param out 结果行的输出流。
+ * @param[out] modified 命令修改了停车场时置 1；可以为 NULL。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode parking_cli_execute(ParkingLot *lot, int argc,
+                                             char **argv, FILE *out,
+                                             int *modified) {
+  ParkingServiceResultCode code = PARKING_SERVICE_INVALID_PARAM;
+  CliReply reply;
+  size_t i;
+
+  reply.used = 0;
+  reply.data[0] = '\0';
+  if (lot != NULL && argc > 0) {
+    for (i = 0; i < sizeof(cli_commands) / sizeof(cli_commands[0]); i++) {
+      const CliCommand *command = &cli_commands[i];
+
+      if (strcmp(argv[0], command->name) != 0) {
+        continue;
+      }
+      if (argc - 1 >= command->min_args && argc - 1 <= command->max_args) {
+        code = command->handler(lot, argv + 1, argc - 1, &reply);
+        if (code == PARKING_SERVICE_SUCCESS && command->mutates &&
+            modified != NULL) {
+          *modified = 1;
+        }
+      }
+      break;
+    }
+  }
+  if (code != PARKING_SERVICE_SUCCESS) {
+    reply.data[0] = '\0';
+  }
+  fprintf(out, "%d%s\n", (int)code, reply.data);
+  return code;
+}
+
+/**
+ * @brief 逐行执行脚本中的命令。
+ * @param lot 目标停车场。
+ * @param script 脚本输入流。
+ * @param out 结果行的输出流。
+ * @param[out] modified 有命令修改了停车场时置 1；可以为 NULL。
+ * @return 失败的命令数。
+ */
+int parking_cli_run_script(ParkingLot *lot, FILE *script, FILE *out,
+                           int *modified) {
+  char line[PARKING_CLI_MAX_LINE + 2];
+  char *fields[PARKING_CLI_MAX_FIELDS + 1];
+  ParkingServiceResultCode code;
+  int line_number = 0;
+  int failed = 0;
+  int count;
+  int c;
+
+  while (fgets(line, sizeof(line), script) != NULL) {
+    line_number++;
+    if (strchr(line, '\n') == NULL && !feof(script)) {
+      /* 行过长：丢弃剩余部分，按参数错误报告 */
+      while ((c = fgetc(script)) != '\n' && c != EOF) {
+      }
+      code = PARKING_SERVICE_INVALID_PARAM;
+      fprintf(out, "%d\n", (int)code);
+    } else {
+      count = split_words(line, fields);
+      if (count == 0 || fields[0][0] == '#') {
+        continue;
+      }
+      if (count > PARKING_CLI_MAX_FIELDS) {
+        count = 0;
+      }
+      code = parking_cli_execute(lot, count, fields, out, modified);
+    }
+    if (code != PARKING_SERVICE_SUCCESS) {
+      fprintf(stderr, "第 %d 行: %s\n", line_number,
+              parking_service_code_message(code));
+      failed++;
+    }
+  }
+  return failed;
+}
+
+/**
+ * @brief 命令模式的入口：解析命令行、加载数据文件、执行命令并保存。
+ * @param argc main 的参数个数。
+ * @param argv main 的参数列表。
+ * @return 进程退出码：0 全部成功，1 有命令失败，2 用法错误或文件错误。
+ */
+int parking_cli_main(int argc, char **argv) {
+  const char *program = argc > 0 ? argv[0] : "Parking-System";
+  const char *data_file = PARKING_CLI_DEFAULT_FILE;
+  const char *script_name = NULL;
+  ParkingServiceResultCode code;
+  ServiceResult result;
+  ParkingLot *lot;
+  FILE *script;
+  int first = 1;
+  int modified = 0;
+  int failed;
+  int status;
+
+  if (argc > 2 && strcmp(argv[1], "--data") == 0) {
+    data_file = argv[2];
+    first = 3;
+  }
+  if (first < argc &&
+      (strcmp(argv[first], "--help") == 0 || strcmp(argv[first], "-h") == 0)) {
+    print_usage(stdout, program);
+    return 0;
+  }
+  if (first < argc && strcmp(argv[first], "--exec") == 0) {
+    if (argc != first + 2) {
+      print_usage(stderr, program);
+      return 2;
+    }
+    script_name = argv[first + 1];
+  } else if (first >= argc || argv[first][0] == '-') {
+    print_usage(stderr, program);
+    return 2;
+  }
+
+  lot = open_lot(data_file);
+  if (lot == NULL) {
+    return 2;
+  }
+
+  if (script_name != NULL) {
+    script = strcmp(script_name, "-") == 0 ? stdin : fopen(script_name, "r");
+    if (script == NULL) {
+      fprintf(stderr, "无法打开脚本文件 %s\n", script_name);
+      free_parking_lot(lot);
+      return 2;
+    }
+    failed = parking_cli_run_script(lot, script, stdout, &modified);
+    if (script != stdin) {
+      fclose(script);
+    }
+  } else {
+    code = parking_cli_execute(lot, argc - first, argv + first, stdout,
+                               &modified);
+    failed = code != PARKING_SERVICE_SUCCESS;
+    if (failed) {
+      fprintf(stderr, "%s: %s\n", argv[first],
+              parking_service_code_message(code));
+    }
+  }
+
+  status = failed > 0 ? 1 : 0;
+  if (modified) {
+    result = parking_service_save_data(lot, data_file);
+    if (result.code != PARKING_SERVICE_SUCCESS) {
+      parking_service_print_error(result);
+      status = 2;
+    }
+    parking_service_free_result(&result);
+  }
+  free_parking_lot(lot);
+  return status;
+}
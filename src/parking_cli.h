@@ -0,0 +1,100 @@
+#ifndef PARKING_CLI_H
+#define PARKING_CLI_H
+
+#include <stdio.h>
+
+#include "parking_data.h"
+#include "parking_service.h"
+
+/**
+ * @file parking_cli.h
+ * @brief 非交互命令模式接口声明。
+ * @details
+ * Parking-System 带参数启动时不进入菜单，而是对数据文件执行命令后退出，
+ * 供定时任务与批量维护脚本使用：
+ *
+ *     Parking-System [--data 数据文件] <命令> [参数...]
+ *     Parking-System [--data 数据文件] --exec 脚本文件
+ *
+ * 数据文件默认为 parking_data.txt，不存在时新建一个容量为
+ * PARKING_CLI_DEFAULT_CAPACITY 的停车场；执行过修改停车场的命令后保存回
+ * 数据文件。脚本每行一个命令，字段以空格或制表符分隔，空行与以 '#'
+ * 开头的行被忽略；脚本文件为 "-" 时从标准输入读取。
+ *
+ * 每个命令向标准输出写一行结果，格式与 parking_daemon.h 的响应相同
+ * （去掉 id）：<状态码> [结果字段...]，字段以制表符分隔，0 表示成功；
+ * 失败的命令另向标准错误输出一行可读消息（脚本模式带行号）。
+ * 全部命令成功时进程返回 0，有命令失败时返回 1，用法错误或数据文件
+ * 无法读写时返回 2。
+ *
+ * 命令与结果字段：
+ * | 命令         | 参数                             | 结果字段 |
+ * |--------------|----------------------------------|----------|
+ * | add          | 车位编号 位置                    |          |
+ * | allocate     | 车位编号 车主 车牌 联系方式 类型 |          |
+ * | allocate_any | 车主 车牌 联系方式 类型          | 车位编号 |
+ * | exit         | 车位编号                         | 应缴金额（分） 停车秒数 |
+ * | find         | 车位编号                         | 车位     |
+ * | find_plate   | 车牌                             | 车位     |
+ * | stats        |                                  | 总数 已占用 空闲 今日 本月 |
+ * | export       | 文件名 [格式 [筛选]]             |          |
+ * | save         | 文件名                           |          |
+ *
+ * 类型为 resident 或 visitor；"车位" 的字段与 parking_daemon.h 相同；
+ * stats 的今日、本月为收入（元，两位小数）。export 的格式为 csv（默认）或
+ * ndjson，筛选为 all（默认）、free 或 occupied。
+ * 命令直接调用 parking_service_fast_* 等不分配结果的服务函数。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_CLI_MAX_LINE 1024                 /**< 脚本行的最大字节数 */
+#define PARKING_CLI_MAX_FIELDS 8                  /**< 一个命令的最多字段数 */
+#define PARKING_CLI_DEFAULT_FILE "parking_data.txt" /**< 默认数据文件 */
+#define PARKING_CLI_DEFAULT_CAPACITY 100          /**< 新建停车场的容量 */
+
+/**
+ *********************************************************************************
+ *                              命令模式API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 执行一个已切分为字段的命令，并把结果行写到 out。
+ * @param lot 目标停车场。
+ * @param argc 字段数，第一个字段为命令名。
+ * @param argv 各字段。
+ * @param out 结果行的输出流。
+ * @param[out] modified 命令修改了停车场时置 1，否则不变；可以为 NULL。
+ * @return 操作的状态码；未知命令或参数个数不符时返回
+ *         PARKING_SERVICE_INVALID_PARAM。
+ */
+ParkingServiceResultCode parking_cli_execute(ParkingLot *lot, int argc,
+                                             char **argv, FILE *out,
+                                             int *modified);
+
+/**
+ * @brief 逐行执行脚本中的命令。
+ * @details 某个命令失败后继续执行后面的行；过长的行视为失败的命令。
+ * @param lot 目标停车场。
+ * @param script 脚本输入流。
+ * @param out 结果行的输出流。
+ * @param[out] modified 有命令修改了停车场时置 1，否则不变；可以为 NULL。
+ * @return 失败的命令数。
+ */
+int parking_cli_run_script(ParkingLot *lot, FILE *script, FILE *out,
+                           int *modified);
+
+/**
+ * @brief 命令模式的入口：解析命令行、加载数据文件、执行命令并保存。
+ * @param argc main 的参数个数。
+ * @param argv main 的参数列表。
+ * @return 进程退出码：0 全部成功，1 有命令失败，2 用法错误或文件错误。
+ */
+int parking_cli_main(int argc, char **argv);
+
+#endif /* PARKING_CLI_H */
@@ -0,0 +1,98 @@
+/**
+ * @file parking_clock.c
+ * @brief 停车场时间源实现文件
+ * @details
+ * 该文件实现了 parking_clock.h 中声明的实时、缓存与虚拟三种时间源。
+ * 工作方式与当前时刻都通过 parking_thread 的原子操作读写。
+ */
+
+#include "parking_clock.h"
+#include "parking_thread.h"
+
+/**
+ * @brief 将时间源初始化为实时时钟。
+ * @param clock 目标时间源。
+ */
+void parking_clock_init(ParkingClock *clock) {
+  clock->mode = PARKING_CLOCK_REAL;
+  clock->now = 0;
+}
+
+/**
+ * @brief 切换时间源的工作方式。
+ * @details 先写入时刻再发布工作方式，并发读者不会读到未初始化的时刻。
+ * @param clock 目标时间源。
+ * @param mode 新的工作方式。
+ * @param start 虚拟时钟的起始时刻。
+ * @return 成功返回 0，工作方式无效返回 -1。
+ */
+int parking_clock_set_mode(ParkingClock *clock, ParkingClockMode mode,
+                           time_t start) {
+  switch (mode) {
+  case PARKING_CLOCK_REAL:
+    break;
+  case PARKING_CLOCK_CACHED:
+    parking_atomic_store_long(&clock->now, (long)time(NULL));
+    break;
+  case PARKING_CLOCK_VIRTUAL:
+    parking_atomic_store_long(&clock->now, (long)start);
+    break;
+  default:
+    return -1;
+  }
+  parking_atomic_store_int(&clock->mode, (int)mode);
+  return 0;
+}
+
+/**
+ * @brief 读取时间源的当前时刻。
+ * @param clock 目标时间源。
+ * @return 当前时刻。
+ */
+time_t parking_clock_now(const ParkingClock *clock) {
+  if (parking_atomic_load_int(&clock->mode) == PARKING_CLOCK_REAL) {
+    return time(NULL);
+  }
+  return (time_t)parking_atomic_load_long(&clock->now);
+}
+
+/**
+ * @brief 刷新缓存时钟；其他工作方式下不做任何事。
+ * @param clock 目标时间源。
+ * @return 刷新后的当前时刻。
+ */
+time_t parking_clock_tick(ParkingClock *clock) {
+  if (parking_atomic_load_int(&clock->mode) == PARKING_CLOCK_CACHED) {
+    parking_atomic_store_long(&clock->now, (long)time(NULL));
+  }
+  return parking_clock_now(clock);
+}
+
+/**
+ * @brief 设置虚拟时钟的当前时刻。
+ * @param clock 目标时间源。
+ * @param now 新的当前时刻。
+ * @return 成功返回 0，时间源不是虚拟时钟返回 -1。
+ */
+int parking_clock_set(ParkingClock *clock, time_t now) {
+  if (parking_atomic_load_int(&clock->mode) != PARKING_CLOCK_VIRTUAL) {
+    return -1;
+  }
+  parking_atomic_store_long(&clock->now, (long)now);
+  return 0;
+}
+
+/**
+ * @brief 将虚拟时钟向前推进若干秒。
+ * @param clock 目标时间源。
+ * @param seconds 推进的秒数，不能为负。
+ * @return 成功返回 0，参数无效或时间源不是虚拟时钟返回 -1。
+ */
+int parking_clock_advance(ParkingClock *clock, long seconds) {
+  if (seconds < 0 ||
+      parking_atomic_load_int(&clock->mode) != PARKING_CLOCK_VIRTUAL) {
+    return -1;
+  }
+  parking_atomic_add_long(&clock->now, seconds);
+  return 0;
+}
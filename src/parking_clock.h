@@ -0,0 +1,83 @@
+#ifndef PARKING_CLOCK_H
+#define PARKING_CLOCK_H
+
+#include <time.h>
+
+/**
+ * @file parking_clock.h
+ * @brief 停车场时间源声明。
+ * @details
+ * 入场、出场与统计不再各自调用 time(NULL)，而是读取停车场持有的时间源：
+ * - 实时时钟：每次读取调用 time(NULL)，与原先行为相同；
+ * - 缓存时钟：只在 parking_clock_tick 时调用 time(NULL)，事件循环每轮刷新一次，
+ *   热路径上的读取只是一次原子加载；
+ * - 虚拟时钟：完全由调用者设置和推进，用于回放、模拟和基准测试。
+ * 当前时刻以 long 保存并原子读写，统计等无锁读者可以并发读取。
+ * @note 时间源只驱动业务时间（入场、出场、计费、统计），
+ *       预写日志的批量同步计时仍使用系统时间。
+ */
+
+/**
+ * @brief 时间源的工作方式。
+ */
+typedef enum {
+  PARKING_CLOCK_REAL = 0,   /**< 每次读取系统时间。 */
+  PARKING_CLOCK_CACHED = 1, /**< 读取最近一次 tick 时缓存的系统时间。 */
+  PARKING_CLOCK_VIRTUAL = 2 /**< 读取调用者设置的虚拟时间。 */
+} ParkingClockMode;
+
+/**
+ * @brief 停车场的时间源。
+ */
+typedef struct ParkingClock {
+  volatile int mode;  /**< 工作方式（ParkingClockMode），原子读写。 */
+  volatile long now;  /**< 缓存时钟或虚拟时钟的当前时刻，原子读写。 */
+} ParkingClock;
+
+/**
+ * @brief 将时间源初始化为实时时钟。
+ * @param clock 目标时间源。
+ */
+void parking_clock_init(ParkingClock *clock);
+
+/**
+ * @brief 切换时间源的工作方式。
+ * @param clock 目标时间源。
+ * @param mode 新的工作方式。
+ * @param start 虚拟时钟的起始时刻；缓存时钟忽略该参数并立即 tick 一次。
+ * @return 成功返回 0，工作方式无效返回 -1。
+ */
+int parking_clock_set_mode(ParkingClock *clock, ParkingClockMode mode,
+                           time_t start);
+
+/**
+ * @brief 读取时间源的当前时刻。
+ * @param clock 目标时间源。
+ * @return 当前时刻。
+ */
+time_t parking_clock_now(const ParkingClock *clock);
+
+/**
+ * @brief 刷新缓存时钟；其他工作方式下不做任何事。
+ * @param clock 目标时间源。
+ * @return 刷新后的当前时刻。
+ */
+time_t parking_clock_tick(ParkingClock *clock);
+
+/**
+ * @brief 设置虚拟时钟的当前时刻。
+ * @param clock 目标时间源。
+ * @param now 新的当前时刻。
+ * @return 成功返回 0，时间源不是虚拟时钟返回 -1。
+ */
+int parking_clock_set(ParkingClock *clock, time_t now);
+
+/**
+ * @brief 将虚拟时钟向前推进若干秒。
+ * @param clock 目标时间源。
+ * @param seconds 推进的秒数，不能为负。
+ * @return 成功返回 0，参数无效或时间源不是虚拟时钟返回 -1。
+ */
+int parking_clock_advance(ParkingClock *clock, long seconds);
+
+#endif /* PARKING_CLOCK_H */
@@ -0,0 +1,1155 @@
+/**
+ * @file parking_cluster.c
+ * @brief 一致性哈希集群实现文件
+ * @details
+ * 该文件实现了 parking_cluster.h 中声明的哈希环、重新均衡与集群客户端。
+ * 虚拟节点的位置是 "<节点名>#<序号>" 的哈希值，站点的位置是站点编号的
+ * 哈希值；两者都先做 FNV-1a，再经过一轮混合，使相似的字符串也能均匀地
+ * 散布在环上。成员变化时整体重建并排序虚拟节点数组，查找只做二分查找。
+ * 客户端使用阻塞套接字，一次只有一个请求在途；套接字接口需要 POSIX
+ * 声明，因此与 parking_replica.c 一样在包含系统头文件前开启
+ * _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_cluster.h"
+#include "parking_durable_file.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#ifdef _WIN32
+typedef SOCKET ClusterSocket;                 /**< 平台套接字类型 */
+#define CLUSTER_INVALID_SOCKET INVALID_SOCKET /**< 无效套接字 */
+#define CLUSTER_SEND_FLAGS 0                  /**< send 的附加标志 */
+#else
+typedef int ClusterSocket;          /**< 平台套接字类型 */
+#define CLUSTER_INVALID_SOCKET (-1) /**< 无效套接字 */
+#ifdef MSG_NOSIGNAL
+#define CLUSTER_SEND_FLAGS MSG_NOSIGNAL /**< 对端关闭时不触发 SIGPIPE */
+#else
+#define CLUSTER_SEND_FLAGS 0 /**< send 的附加标志 */
+#endif
+#endif
+
+#define CLUSTER_COPY_CHUNK 65536 /**< 复制快照时每次读写的字节数 */
+#define CLUSTER_IDX_PATH                                                       \
+  (PARKING_REGISTRY_MAX_PATH + sizeof(INDEX_IMAGE_SUFFIX)) /**< 索引映像路径 */
+
+/**
+ * @brief 客户端与一个节点之间的连接。
+ */
+typedef struct ClusterConnection {
+  char name[CLUSTER_MAX_NODE_NAME + 1]; /**< 节点名，空串表示未使用。 */
+  char host[CLUSTER_MAX_HOST];          /**< 连接时的节点地址。 */
+  int port;                             /**< 连接时的节点端口。 */
+  ClusterSocket socket; /**< 连接，CLUSTER_INVALID_SOCKET 表示尚未连接。 */
+} ClusterConnection;
+
+/**
+ * @brief 按环路由请求的集群客户端。
+ */
+struct ClusterClient {
+  const ClusterRing *ring;                        /**< 路由使用的环。 */
+  ClusterConnection connections[CLUSTER_MAX_NODES]; /**< 各节点的连接。 */
+  unsigned long next_id; /**< 便捷接口生成请求 id 用的计数器。 */
+};
+
+/**
+ * @brief 重新均衡时收集的一个节点上的站点编号。
+ */
+typedef struct ClusterSiteList {
+  char (*ids)[PARKING_REGISTRY_MAX_SITE_ID + 1]; /**< 站点编号数组。 */
+  int count;    /**< 站点数。 */
+  int capacity; /**< ids 的容量。 */
+  int failed;   /**< 非 0 表示收集时内存不足。 */
+} ClusterSiteList;
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/* -------------------------------------------------------------------------- */
+/*                                  哈希环                                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 计算字符串在环上的位置。
+ * @details FNV-1a 之后再做 MurmurHash3 的 32 位收尾混合，
+ *          "node-a#1" 与 "node-a#2" 这样只差一个字符的键也会相距很远。
+ * @param text 字符串。
+ * @return 32 位位置。
+ */
+static unsigned long ring_hash(const char *text) {
+  unsigned long hash = 2166136261UL;
+
+  for (; *text != '\0'; text++) {
+    hash = ((hash ^ (unsigned char)*text) * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  hash ^= hash >> 16;
+  hash = (hash * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+  hash ^= hash >> 13;
+  hash = (hash * 0xC2B2AE35UL) & 0xFFFFFFFFUL;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+/**
+ * @brief (静态辅助函数) 按位置排序虚拟节点，位置相同时按节点下标。
+ * @param a 第一个虚拟节点。
+ * @param b 第二个虚拟节点。
+ * @return 比较结果。
+ */
+static int compare_points(const void *a, const void *b) {
+  const ClusterPoint *left = (const ClusterPoint *)a;
+  const ClusterPoint *right = (const ClusterPoint *)b;
+
+  if (left->hash != right->hash) {
+    return left->hash < right->hash ? -1 : 1;
+  }
+  return left->node - right->node;
+}
+
+/**
+ * @brief (静态辅助函数) 统计未在离开的节点的虚拟节点总数。
+ * @param ring 目标环。
+ * @return 虚拟节点总数。
+ */
+static size_t live_point_count(const ClusterRing *ring) {
+  size_t count = 0;
+  int i;
+
+  for (i = 0; i < ring->node_count; i++) {
+    if (!ring->nodes[i].draining) {
+      count += (size_t)ring->nodes[i].vnodes;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief (静态辅助函数) 按节点表重建并排序虚拟节点数组。
+ * @details 调用者已保证 points 的容量足够。
+ * @param ring 目标环。
+ */
+static void rebuild_points(ClusterRing *ring) {
+  char key[CLUSTER_MAX_NODE_NAME + 16];
+  size_t count = 0;
+  int i;
+  int v;
+
+  for (i = 0; i < ring->node_count; i++) {
+    const ClusterNode *node = &ring->nodes[i];
+
+    if (node->draining) {
+      continue;
+    }
+    for (v = 0; v < node->vnodes; v++) {
+      sprintf(key, "%s#%d", node->name, v);
+      ring->points[count].hash = ring_hash(key);
+      ring->points[count].node = i;
+      count++;
+    }
+  }
+  if (count > 1) {
+    qsort(ring->points, count, sizeof(ClusterPoint), compare_points);
+  }
+  ring->point_count = count;
+  ring->version++;
+}
+
+/**
+ * @brief (静态辅助函数) 按节点名查找节点下标。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @return 节点下标，不存在返回 -1。
+ */
+static int find_node(const ClusterRing *ring, const char *name) {
+  int i;
+
+  if (ring == NULL || name == NULL) {
+    return -1;
+  }
+  for (i = 0; i < ring->node_count; i++) {
+    if (strcmp(ring->nodes[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 重新均衡                                   */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 站点遍历回调：记下站点编号。
+ * @param site_id 站点编号。
+ * @param lot 该站点的停车场（未使用）。
+ * @param ctx 目标 ClusterSiteList。
+ * @return 内存不足时返回 1 停止遍历，否则返回 0。
+ */
+static int collect_site(const char *site_id, ParkingLot *lot, void *ctx) {
+  ClusterSiteList *list = (ClusterSiteList *)ctx;
+
+  (void)lot;
+  if (list->count == list->capacity) {
+    int capacity = list->capacity > 0 ? list->capacity * 2 : 16;
+    char(*ids)[PARKING_REGISTRY_MAX_SITE_ID + 1] =
+        (char(*)[PARKING_REGISTRY_MAX_SITE_ID + 1])realloc(
+            list->ids, (size_t)capacity * sizeof(*ids));
+
+    if (ids == NULL) {
+      list->failed = 1;
+      return 1;
+    }
+    list->ids = ids;
+    list->capacity = capacity;
+  }
+  strcpy(list->ids[list->count++], site_id);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 拼出快照对应的索引映像路径。
+ * @param snapshot 快照路径。
+ * @param[out] path 接收路径（CLUSTER_IDX_PATH 字节）。
+ */
+static void index_image_path(const char *snapshot, char *path) {
+  sprintf(path, "%s%s", snapshot, INDEX_IMAGE_SUFFIX);
+}
+
+/**
+ * @brief (静态辅助函数) 删除快照及其索引映像。
+ * @param snapshot 快照路径。
+ */
+static void remove_snapshot(const char *snapshot) {
+  char index_path[CLUSTER_IDX_PATH];
+
+  index_image_path(snapshot, index_path);
+  remove(index_path);
+  remove(snapshot);
+}
+
+/**
+ * @brief (静态辅助函数) 把快照复制到另一个目录，原子地替换目标文件。
+ * @details 目标目录中残留的索引映像同时删除，以免加载时套用旧的索引。
+ * @param from 源快照路径。
+ * @param to 目标快照路径。
+ * @return 成功返回 0，失败返回 -1（目标文件保持原样）。
+ */
+static int copy_snapshot(const char *from, const char *to) {
+  char index_path[CLUSTER_IDX_PATH];
+  DurableFile target;
+  unsigned char *buffer;
+  FILE *source;
+  size_t got;
+  int result = 0;
+
+  source = fopen(from, "rb");
+  if (source == NULL) {
+    return -1;
+  }
+  buffer = (unsigned char *)malloc(CLUSTER_COPY_CHUNK);
+  if (buffer == NULL || durable_file_open(&target, to, "wb") != 0) {
+    free(buffer);
+    fclose(source);
+    return -1;
+  }
+  while ((got = fread(buffer, 1, CLUSTER_COPY_CHUNK, source)) > 0) {
+    if (fwrite(buffer, 1, got, target.stream) != got) {
+      result = -1;
+      break;
+    }
+  }
+  if (ferror(source)) {
+    result = -1;
+  }
+  fclose(source);
+  free(buffer);
+  if (result != 0) {
+    durable_file_abort(&target);
+    return -1;
+  }
+  index_image_path(to, index_path);
+  remove(index_path);
+  return durable_file_commit(&target);
+}
+
+/**
+ * @brief (静态辅助函数) 把一个站点从原节点迁移到新主节点。
+ * @param from 原节点的注册表。
+ * @param to 新主节点的注册表。
+ * @param site_id 站点编号。
+ * @return 成功返回 0；失败返回 -1，此时站点仍在原节点打开（原节点关闭
+ *         站点失败时保持打开，重新打开失败时站点的快照仍在原目录）。
+ */
+static int migrate_site(ParkingRegistry *from, ParkingRegistry *to,
+                        const char *site_id) {
+  char from_path[PARKING_REGISTRY_MAX_PATH];
+  char to_path[PARKING_REGISTRY_MAX_PATH];
+  ParkingLot *lot;
+  int total_slots;
+  int shared;
+
+  /* 新主节点上已打开同名站点时不覆盖它 */
+  if (parking_registry_get(to, site_id) != NULL ||
+      parking_registry_site_path(from, site_id, from_path) != 0 ||
+      parking_registry_site_path(to, site_id, to_path) != 0 ||
+      parking_registry_acquire(from, site_id, &lot) != 0) {
+    return -1;
+  }
+  total_slots = lot->total_slots;
+  parking_registry_release(from, site_id);
+  /* 关闭时等网络服务正在执行的该站点请求结束，之后的请求被拒绝 */
+  if (parking_registry_close(from, site_id) != 0) {
+    return -1;
+  }
+
+  /* 两个注册表共用一个目录时快照已经就位，不必复制 */
+  shared = strcmp(from_path, to_path) == 0;
+  if ((shared || copy_snapshot(from_path, to_path) == 0) &&
+      parking_registry_open(to, site_id, total_slots) != NULL) {
+    if (!shared) {
+      remove_snapshot(from_path);
+    }
+    return 0;
+  }
+  if (!shared) {
+    remove_snapshot(to_path);
+  }
+  parking_registry_open(from, site_id, total_slots);
+  return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  客户端                                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 关闭套接字。
+ * @param socket_fd 套接字。
+ */
+static void close_socket(ClusterSocket socket_fd) {
+#ifdef _WIN32
+  closesocket(socket_fd);
+#else
+  close(socket_fd);
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 在超时内等待套接字可读。
+ * @param socket_fd 套接字。
+ * @param timeout_ms 超时（毫秒）。
+ * @return 可读返回 1，超时或出错返回 0。
+ */
+static int wait_readable(ClusterSocket socket_fd, int timeout_ms) {
+  fd_set readable;
+  struct timeval timeout;
+
+  FD_ZERO(&readable);
+  FD_SET(socket_fd, &readable);
+  timeout.tv_sec = timeout_ms / 1000;
+  timeout.tv_usec = (timeout_ms % 1000) * 1000;
+  return select((int)socket_fd + 1, &readable, NULL, NULL, &timeout) > 0;
+}
+
+/**
+ * @brief (静态辅助函数) 连接节点的网络服务。
+ * @param host IPv4 地址。
+ * @param port 端口。
+ * @return 成功返回连接，失败返回 CLUSTER_INVALID_SOCKET。
+ */
+static ClusterSocket connect_node(const char *host, int port) {
+  struct sockaddr_in address;
+  ClusterSocket socket_fd;
+  int nodelay = 1;
+
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons((unsigned short)port);
+  if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+    return CLUSTER_INVALID_SOCKET;
+  }
+  socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (socket_fd == CLUSTER_INVALID_SOCKET) {
+    return CLUSTER_INVALID_SOCKET;
+  }
+  if (connect(socket_fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    close_socket(socket_fd);
+    return CLUSTER_INVALID_SOCKET;
+  }
+  setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay,
+             sizeof(nodelay));
+  return socket_fd;
+}
+
+/**
+ * @brief (静态辅助函数) 断开一条连接，保留连接项。
+ * @param connection 连接项。
+ */
+static void drop_connection(ClusterConnection *connection) {
+  if (connection->socket != CLUSTER_INVALID_SOCKET) {
+    close_socket(connection->socket);
+    connection->socket = CLUSTER_INVALID_SOCKET;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 取节点对应的连接项。
+ * @details 节点地址变了时断开旧连接；连接项用完时复用已不在环上的节点的
+ *          连接项。
+ * @param client 集群客户端。
+ * @param node 目标节点。
+ * @return 连接项（可能尚未连接）。
+ */
+static ClusterConnection *connection_for(ClusterClient *client,
+                                         const ClusterNode *node) {
+  ClusterConnection *connection = NULL;
+  int i;
+
+  for (i = 0; i < CLUSTER_MAX_NODES; i++) {
+    if (strcmp(client->connections[i].name, node->name) == 0) {
+      connection = &client->connections[i];
+      break;
+    }
+  }
+  for (i = 0; connection == NULL && i < CLUSTER_MAX_NODES; i++) {
+    if (client->connections[i].name[0] == '\0' ||
+        find_node(client->ring, client->connections[i].name) < 0) {
+      connection = &client->connections[i];
+    }
+  }
+  if (connection == NULL) {
+    connection = &client->connections[0];
+  }
+  if (strcmp(connection->name, node->name) != 0 ||
+      strcmp(connection->host, node->host) != 0 ||
+      connection->port != node->port) {
+    drop_connection(connection);
+    strcpy(connection->name, node->name);
+    strcpy(connection->host, node->host);
+    connection->port = node->port;
+  }
+  return connection;
+}
+
+/**
+ * @brief (静态辅助函数) 发出一行请求并读取一行响应。
+ * @param socket_fd 连接。
+ * @param line 以 "\n" 结尾的请求行。
+ * @param length 请求行的字节数。
+ * @param[out] reply 接收不含行尾的响应行（PARKING_DAEMON_MAX_REPLY 字节）。
+ * @param[out] received 接收是否已读到响应的任何字节。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int exchange_line(ClusterSocket socket_fd, const char *line,
+                         size_t length, char *reply, int *received) {
+  size_t used = 0;
+
+  *received = 0;
+  while (length > 0) {
+    int sent = (int)send(socket_fd, line, (int)length, CLUSTER_SEND_FLAGS);
+
+    if (sent <= 0) {
+      return -1;
+    }
+    line += sent;
+    length -= (size_t)sent;
+  }
+  for (;;) {
+    char *end;
+    int got;
+
+    if (!wait_readable(socket_fd, CLUSTER_IO_TIMEOUT_MS)) {
+      return -1;
+    }
+    got = (int)recv(socket_fd, reply + used,
+                    (int)(PARKING_DAEMON_MAX_REPLY - 1 - used), 0);
+    if (got <= 0) {
+      return -1;
+    }
+    *received = 1;
+    end = (char *)memchr(reply + used, '\n', (size_t)got);
+    used += (size_t)got;
+    if (end != NULL) {
+      *end = '\0';
+      return 0;
+    }
+    if (used >= PARKING_DAEMON_MAX_REPLY - 1) {
+      return -1;
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 追加一个以制表符开头的文本字段。
+ * @param buffer 请求行缓冲区（PARKING_DAEMON_MAX_LINE + 1 字节）。
+ * @param[in,out] used 已写入的字节数。
+ * @param text 字段文本，不得含有制表符或换行。
+ * @return 成功返回 0，字段无效或请求行超长返回 -1。
+ */
+static int append_field(char *buffer, size_t *used, const char *text) {
+  size_t length;
+
+  if (text == NULL || strpbrk(text, "\t\r\n") != NULL) {
+    return -1;
+  }
+  length = strlen(text);
+  if (*used + 1 + length > PARKING_DAEMON_MAX_LINE) {
+    return -1;
+  }
+  buffer[(*used)++] = '\t';
+  memcpy(buffer + *used, text, length + 1);
+  *used += length;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 以新的请求 id 开始一行请求。
+ * @param client 集群客户端。
+ * @param command 命令名。
+ * @param[out] buffer 请求行缓冲区（PARKING_DAEMON_MAX_LINE + 1 字节）。
+ * @return 已写入的字节数。
+ */
+static size_t begin_request(ClusterClient *client, const char *command,
+                            char *buffer) {
+  client->next_id++;
+  return (size_t)sprintf(buffer, "c%lu\t%s", client->next_id, command);
+}
+
+/**
+ * @brief (静态辅助函数) 发出请求并取出响应的状态码与结果字段。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param request 请求行。
+ * @param[out] reply 接收响应行（PARKING_DAEMON_MAX_REPLY 字节）。
+ * @param[out] fields 接收结果字段的起点（指向 '\t' 或 '\0'），可以为 NULL。
+ * @return 节点返回的状态码；请求无效返回 PARKING_SERVICE_INVALID_PARAM，
+ *         无法与节点通信或响应无法解析返回 PARKING_SERVICE_BUSY。
+ */
+static ParkingServiceResultCode call_code(ClusterClient *client,
+                                          const char *site_id,
+                                          const char *request, char *reply,
+                                          const char **fields) {
+  const char *code_text;
+  char *end;
+  long code;
+  int result = cluster_client_call(client, site_id, request, reply);
+
+  if (result == -1) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  if (result != 0 || (code_text = strchr(reply, '\t')) == NULL) {
+    return PARKING_SERVICE_BUSY;
+  }
+  code = strtol(code_text + 1, &end, 10);
+  if (end == code_text + 1 || (*end != '\0' && *end != '\t')) {
+    return PARKING_SERVICE_BUSY;
+  }
+  if (fields != NULL) {
+    *fields = end;
+  }
+  return (ParkingServiceResultCode)code;
+}
+
+/**
+ * @brief (静态辅助函数) 依次读出结果字段中的整数。
+ * @param fields 结果字段的起点（指向 '\t' 或 '\0'）。
+ * @param[out] values 接收各整数。
+ * @param count 要读出的个数。
+ * @return 字段足够时返回 0，否则返回 -1。
+ */
+static int parse_longs(const char *fields, long *values, int count) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    char *end;
+
+    if (*fields != '\t') {
+      return -1;
+    }
+    values[i] = strtol(fields + 1, &end, 10);
+    if (end == fields + 1) {
+      return -1;
+    }
+    fields = end;
+  }
+  return 0;
+}
+
+/* ========================================================================== */
+/*                             一致性哈希环API实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个没有节点的环。
+ * @return 成功返回环，内存不足返回 NULL。
+ */
+ClusterRing *cluster_ring_create(void) {
+  return (ClusterRing *)calloc(1, sizeof(ClusterRing));
+}
+
+/**
+ * @brief 释放环。
+ * @param ring 要释放的环，可以为 NULL。
+ */
+void cluster_ring_free(ClusterRing *ring) {
+  if (ring == NULL) {
+    return;
+  }
+  free(ring->points);
+  free(ring);
+}
+
+/**
+ * @brief 向环中加入一个节点。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @param host 节点地址，NULL 表示 127.0.0.1。
+ * @param port 节点端口。
+ * @param vnodes 虚拟节点数，0 表示默认值。
+ * @return 成功返回 0；参数无效或重名返回 -1；内存不足返回 -2；节点已满返回 -3。
+ */
+int cluster_ring_add_node(ClusterRing *ring, const char *name,
+                          const char *host, int port, int vnodes) {
+  ClusterNode *node;
+  size_t needed;
+
+  if (host == NULL) {
+    host = "127.0.0.1";
+  }
+  if (ring == NULL || name == NULL || name[0] == '\0' ||
+      strlen(name) > CLUSTER_MAX_NODE_NAME ||
+      strlen(host) >= CLUSTER_MAX_HOST || port <= 0 || port > 65535 ||
+      vnodes < 0 || find_node(ring, name) >= 0) {
+    return -1;
+  }
+  if (ring->node_count == CLUSTER_MAX_NODES) {
+    return -3;
+  }
+  if (vnodes == 0) {
+    vnodes = CLUSTER_DEFAULT_VNODES;
+  } else if (vnodes > CLUSTER_MAX_VNODES) {
+    vnodes = CLUSTER_MAX_VNODES;
+  }
+
+  needed = live_point_count(ring) + (size_t)vnodes;
+  if (needed > ring->point_capacity) {
+    ClusterPoint *points = (ClusterPoint *)realloc(
+        ring->points, needed * sizeof(ClusterPoint));
+
+    if (points == NULL) {
+      return -2;
+    }
+    ring->points = points;
+    ring->point_capacity = needed;
+  }
+
+  node = &ring->nodes[ring->node_count++];
+  memset(node, 0, sizeof(*node));
+  strcpy(node->name, name);
+  strcpy(node->host, host);
+  node->port = port;
+  node->vnodes = vnodes;
+  rebuild_points(ring);
+  return 0;
+}
+
+/**
+ * @brief 登记托管在本进程中的节点的注册表。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @param registry 节点的注册表，NULL 表示取消登记。
+ * @return 成功返回 0，节点不存在返回 -1。
+ */
+int cluster_ring_bind_registry(ClusterRing *ring, const char *name,
+                               ParkingRegistry *registry) {
+  int index = find_node(ring, name);
+
+  if (index < 0) {
+    return -1;
+  }
+  ring->nodes[index].registry = registry;
+  return 0;
+}
+
+/**
+ * @brief 使节点不再拥有任何站点。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @return 成功返回 0，节点不存在返回 -1。
+ */
+int cluster_ring_drain_node(ClusterRing *ring, const char *name) {
+  int index = find_node(ring, name);
+
+  if (index < 0) {
+    return -1;
+  }
+  if (!ring->nodes[index].draining) {
+    ring->nodes[index].draining = 1;
+    rebuild_points(ring);
+  }
+  return 0;
+}
+
+/**
+ * @brief 从环中移除一个节点。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @return 成功返回 0，节点不存在返回 -1。
+ */
+int cluster_ring_remove_node(ClusterRing *ring, const char *name) {
+  int index = find_node(ring, name);
+
+  if (index < 0) {
+    return -1;
+  }
+  /* 虚拟节点只会变少，沿用原数组即可 */
+  memmove(&ring->nodes[index], &ring->nodes[index + 1],
+          (size_t)(ring->node_count - index - 1) * sizeof(ClusterNode));
+  ring->node_count--;
+  rebuild_points(ring);
+  return 0;
+}
+
+/**
+ * @brief 按节点名查找节点。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @return 找到返回节点，否则返回 NULL。
+ */
+const ClusterNode *cluster_ring_find(const ClusterRing *ring,
+                                     const char *name) {
+  int index = find_node(ring, name);
+
+  return index >= 0 ? &ring->nodes[index] : NULL;
+}
+
+/**
+ * @brief 查找站点的主节点。
+ * @param ring 目标环。
+ * @param site_id 站点编号。
+ * @return 主节点；环上没有节点或参数无效时返回 NULL。
+ */
+const ClusterNode *cluster_ring_owner(const ClusterRing *ring,
+                                      const char *site_id) {
+  unsigned long hash;
+  size_t low = 0;
+  size_t high;
+
+  if (ring == NULL || site_id == NULL || ring->point_count == 0) {
+    return NULL;
+  }
+  hash = ring_hash(site_id);
+  high = ring->point_count;
+  /* 找第一个位置不小于 hash 的虚拟节点，越过末尾时回到环首 */
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+
+    if (ring->points[middle].hash < hash) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low == ring->point_count) {
+    low = 0;
+  }
+  return &ring->nodes[ring->points[low].node];
+}
+
+/**
+ * @brief 把本进程节点上已打开的站点迁移到各自的主节点。
+ * @param ring 目标环。
+ * @param[out] summary 接收迁移结果，可以为 NULL。
+ * @return 全部成功返回 0；参数无效返回 -1；内存不足返回 -2；有站点迁移失败
+ *         返回 -3。
+ */
+int cluster_rebalance(ClusterRing *ring, ClusterRebalanceSummary *summary) {
+  ClusterRebalanceSummary totals;
+  ClusterSiteList *lists;
+  int result = 0;
+  int i;
+  int s;
+
+  memset(&totals, 0, sizeof(totals));
+  if (summary != NULL) {
+    *summary = totals;
+  }
+  if (ring == NULL) {
+    return -1;
+  }
+  lists = (ClusterSiteList *)calloc(CLUSTER_MAX_NODES,
+                                    sizeof(ClusterSiteList));
+  if (lists == NULL) {
+    return -2;
+  }
+
+  /* 先收集全部节点的站点编号：遍历时持有站点表的读锁，不能关闭站点；
+   * 迁入新主节点的站点也不会在本轮再被检查一次 */
+  for (i = 0; i < ring->node_count && result == 0; i++) {
+    if (ring->nodes[i].registry != NULL) {
+      parking_registry_foreach(ring->nodes[i].registry, collect_site,
+                               &lists[i]);
+      if (lists[i].failed) {
+        result = -2;
+      }
+    }
+  }
+  for (i = 0; i < ring->node_count && result == 0; i++) {
+    ParkingRegistry *source = ring->nodes[i].registry;
+
+    for (s = 0; s < lists[i].count; s++) {
+      const char *site_id = lists[i].ids[s];
+      const ClusterNode *owner = cluster_ring_owner(ring, site_id);
+
+      totals.checked++;
+      if (owner == &ring->nodes[i] ||
+          (owner != NULL && owner->registry == source)) {
+        continue;
+      }
+      if (owner == NULL || owner->registry == NULL) {
+        totals.stranded++;
+      } else if (migrate_site(source, owner->registry, site_id) == 0) {
+        totals.moved++;
+      } else {
+        totals.failed++;
+      }
+    }
+  }
+  for (i = 0; i < CLUSTER_MAX_NODES; i++) {
+    free(lists[i].ids);
+  }
+  free(lists);
+
+  if (summary != NULL) {
+    *summary = totals;
+  }
+  if (result == 0 && totals.failed > 0) {
+    result = -3;
+  }
+  return result;
+}
+
+/* ========================================================================== */
+/*                                集群客户端API实现                           */
+/* ========================================================================== */
+
+/**
+ * @brief 创建集群客户端。
+ * @param ring 路由使用的环。
+ * @return 成功返回客户端，参数无效或内存不足返回 NULL。
+ */
+ClusterClient *cluster_client_create(const ClusterRing *ring) {
+  ClusterClient *client;
+  int i;
+#ifdef _WIN32
+  WSADATA wsa;
+#endif
+
+  if (ring == NULL) {
+    return NULL;
+  }
+#ifdef _WIN32
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+    return NULL;
+  }
+#endif
+  client = (ClusterClient *)calloc(1, sizeof(ClusterClient));
+  if (client == NULL) {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return NULL;
+  }
+  client->ring = ring;
+  for (i = 0; i < CLUSTER_MAX_NODES; i++) {
+    client->connections[i].socket = CLUSTER_INVALID_SOCKET;
+  }
+  return client;
+}
+
+/**
+ * @brief 关闭全部连接并释放客户端。
+ * @param client 要释放的客户端，可以为 NULL。
+ */
+void cluster_client_free(ClusterClient *client) {
+  int i;
+
+  if (client == NULL) {
+    return;
+  }
+  for (i = 0; i < CLUSTER_MAX_NODES; i++) {
+    drop_connection(&client->connections[i]);
+  }
+  free(client);
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
+
+/**
+ * @brief 把一行请求发往站点的主节点并等待响应。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param request 请求行 <id> <命令> [参数...]。
+ * @param[out] reply 接收以 NUL 结尾的响应行。
+ * @return 成功返回 0；参数无效返回 -1；没有节点返回 -2；通信失败返回 -3。
+ */
+int cluster_client_call(ClusterClient *client, const char *site_id,
+                        const char *request, char *reply) {
+  char line[PARKING_DAEMON_MAX_LINE + 2];
+  const ClusterNode *node;
+  ClusterConnection *connection;
+  const char *rest;
+  size_t id_length;
+  size_t site_length;
+  size_t length;
+  int attempt;
+
+  if (client == NULL || site_id == NULL || request == NULL || reply == NULL ||
+      strpbrk(site_id, "\t\r\n") != NULL || strpbrk(request, "\r\n") != NULL) {
+    return -1;
+  }
+  rest = strchr(request, '\t');
+  id_length = rest != NULL ? (size_t)(rest - request) : strlen(request);
+  site_length = strlen(site_id);
+  length = strlen(request) + 1 + site_length;
+  if (site_length == 0 || site_length > PARKING_REGISTRY_MAX_SITE_ID ||
+      length > PARKING_DAEMON_MAX_LINE) {
+    return -1;
+  }
+  node = cluster_ring_owner(client->ring, site_id);
+  if (node == NULL) {
+    return -2;
+  }
+
+  /* <id>\t<站点><其余部分>\n */
+  memcpy(line, request, id_length);
+  line[id_length] = '\t';
+  memcpy(line + id_length + 1, site_id, site_length);
+  strcpy(line + id_length + 1 + site_length, request + id_length);
+  line[length++] = '\n';
+
+  connection = connection_for(client, node);
+  for (attempt = 0; attempt < 2; attempt++) {
+    int reused = connection->socket != CLUSTER_INVALID_SOCKET;
+    int received;
+
+    if (!reused) {
+      connection->socket = connect_node(connection->host, connection->port);
+      if (connection->socket == CLUSTER_INVALID_SOCKET) {
+        return -3;
+      }
+    }
+    if (exchange_line(connection->socket, line, length, reply, &received) ==
+        0) {
+      return 0;
+    }
+    drop_connection(connection);
+    /* 只有沿用的连接在收到任何响应之前失效时才重连重发 */
+    if (!reused || received) {
+      break;
+    }
+  }
+  return -3;
+}
+
+/**
+ * @brief 在站点的主节点上打开站点。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param total_slots 新建时的总车位数。
+ * @return 节点返回的状态码。
+ */
+ParkingServiceResultCode cluster_client_open_site(ClusterClient *client,
+                                                  const char *site_id,
+                                                  int total_slots) {
+  char request[PARKING_DAEMON_MAX_LINE + 1];
+  char reply[PARKING_DAEMON_MAX_REPLY];
+  size_t used;
+
+  if (client == NULL || total_slots < 0) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  used = begin_request(client, "open_site", request);
+  sprintf(request + used, "\t%d", total_slots);
+  return call_code(client, site_id, request, reply, NULL);
+}
+
+/**
+ * @brief 在站点的主节点上调用 parking_service_fast_add_slot。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param slot_id 车位编号。
+ * @param location 车位位置。
+ * @return 节点返回的状态码。
+ */
+ParkingServiceResultCode cluster_client_add_slot(ClusterClient *client,
+                                                 const char *site_id,
+                                                 int slot_id,
+                                                 const char *location) {
+  char request[PARKING_DAEMON_MAX_LINE + 1];
+  char reply[PARKING_DAEMON_MAX_REPLY];
+  size_t used;
+
+  if (client == NULL || slot_id < 0) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  used = begin_request(client, "add_slot", request);
+  used += (size_t)sprintf(request + used, "\t%d", slot_id);
+  if (append_field(request, &used, location) != 0) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  return call_code(client, site_id, request, reply, NULL);
+}
+
+/**
+ * @brief 在站点的主节点上调用 parking_service_fast_allocate_any_slot。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型。
+ * @param[out] slot_id 接收分到的车位编号，可以为 NULL。
+ * @return 节点返回的状态码。
+ */
+ParkingServiceResultCode
+cluster_client_allocate_any_slot(ClusterClient *client, const char *site_id,
+                                 const char *owner_name,
+                                 const char *license_plate,
+                                 const char *contact, ParkingType type,
+                                 int *slot_id) {
+  char request[PARKING_DAEMON_MAX_LINE + 1];
+  char reply[PARKING_DAEMON_MAX_REPLY];
+  ParkingServiceResultCode code;
+  const char *fields;
+  size_t used;
+  long chosen;
+
+  if (slot_id != NULL) {
+    *slot_id = 0;
+  }
+  if (client == NULL) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  used = begin_request(client, "allocate_any_slot", request);
+  if (append_field(request, &used, owner_name) != 0 ||
+      append_field(request, &used, license_plate) != 0 ||
+      append_field(request, &used, contact) != 0 ||
+      append_field(request, &used,
+                   type == VISITOR_TYPE ? "visitor" : "resident") != 0) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  code = call_code(client, site_id, request, reply, &fields);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    if (parse_longs(fields, &chosen, 1) != 0) {
+      return PARKING_SERVICE_BUSY;
+    }
+    if (slot_id != NULL) {
+      *slot_id = (int)chosen;
+    }
+  }
+  return code;
+}
+
+/**
+ * @brief 在站点的主节点上调用 parking_service_fast_deallocate_slot。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param slot_id 车位编号。
+ * @param[out] amount_cents 接收应缴金额（分），可以为 NULL。
+ * @return 节点返回的状态码。
+ */
+ParkingServiceResultCode cluster_client_deallocate_slot(ClusterClient *client,
+                                                        const char *site_id,
+                                                        int slot_id,
+                                                        long *amount_cents) {
+  char request[PARKING_DAEMON_MAX_LINE + 1];
+  char reply[PARKING_DAEMON_MAX_REPLY];
+  ParkingServiceResultCode code;
+  const char *fields;
+  size_t used;
+  long amount;
+
+  if (amount_cents != NULL) {
+    *amount_cents = 0;
+  }
+  if (client == NULL || slot_id < 0) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  used = begin_request(client, "deallocate_slot", request);
+  sprintf(request + used, "\t%d", slot_id);
+  code = call_code(client, site_id, request, reply, &fields);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    if (parse_longs(fields, &amount, 1) != 0) {
+      return PARKING_SERVICE_BUSY;
+    }
+    if (amount_cents != NULL) {
+      *amount_cents = amount;
+    }
+  }
+  return code;
+}
+
+/**
+ * @brief 在站点的主节点上调用 parking_service_fast_get_statistics。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param[out] stats 接收统计信息。
+ * @return 节点返回的状态码。
+ */
+ParkingServiceResultCode
+cluster_client_get_statistics(ClusterClient *client, const char *site_id,
+                              ParkingStatistics *stats) {
+  char request[PARKING_DAEMON_MAX_LINE + 1];
+  char reply[PARKING_DAEMON_MAX_REPLY];
+  ParkingServiceResultCode code;
+  const char *fields;
+  long counts[3];
+
+  if (client == NULL || stats == NULL) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  memset(stats, 0, sizeof(*stats));
+  begin_request(client, "get_statistics", request);
+  code = call_code(client, site_id, request, reply, &fields);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    if (parse_longs(fields, counts, 3) != 0) {
+      return PARKING_SERVICE_BUSY;
+    }
+    stats->total_slots = (int)counts[0];
+    stats->occupied_slots = (int)counts[1];
+    stats->free_slots = (int)counts[2];
+    if (counts[0] > 0) {
+      stats->occupancy_rate = (double)counts[1] * 100.0 / (double)counts[0];
+    }
+  }
+  return code;
+}
@@ -0,0 +1,302 @@
+#ifndef PARKING_CLUSTER_H
+#define PARKING_CLUSTER_H
+
+#include <stddef.h>
+
+#include "parking_daemon.h"
+#include "parking_registry.h"
+#include "parking_service.h"
+
+/**
+ * @file parking_cluster.h
+ * @brief 按一致性哈希把站点分布到多个节点的集群接口声明。
+ * @details
+ * 每个节点是一个以 parking_daemon_start_registry 启动的网络服务，托管
+ * 一个注册表中的若干站点。站点编号到节点的映射由一致性哈希环决定：每个
+ * 节点按权重在环上放置若干虚拟节点，站点编号哈希后顺时针找到的第一个
+ * 虚拟节点所属的节点即为该站点的主节点。节点加入或离开时只有环上相邻
+ * 区间内的站点换主节点，约为站点总数的 1/节点数，其余站点保持不动。
+ *
+ * - 环（ClusterRing）是纯内存结构，不加锁；成员变化与查询须由调用者串行，
+ *   各客户端与节点使用同样的成员列表即可得到同样的映射。
+ * - 客户端（ClusterClient）按环把请求发往主节点，每个节点保持一条阻塞的
+ *   TCP 连接，请求格式见 parking_daemon.h 的按站点服务部分。
+ * - 重新均衡（cluster_rebalance）只能迁移托管在本进程中的节点之间的站点
+ *   （节点登记了注册表，例如各节点的快照目录在共享存储上由同一个进程
+ *   管理）：在原节点关闭站点（写出快照），把快照复制到新主节点的目录，
+ *   再在新主节点打开。注册表托管的站点不启用预写日志，关闭时写出的快照
+ *   即是站点的全部状态。
+ *
+ * 节点离开的顺序：cluster_ring_drain_node 使其不再拥有任何站点，
+ * cluster_rebalance 把它的站点迁走，最后 cluster_ring_remove_node。
+ * 迁移期间发往原节点的该站点请求返回 PARKING_SERVICE_BUSY，已在执行的
+ * 请求执行完后站点才被关闭；迁移完成后按新的环路由即可。
+ * 该模块由 CMake 选项 PARKING_CLUSTER 控制是否编入核心库，依赖网络服务模块。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define CLUSTER_MAX_NODES 64          /**< 环上节点数的上限 */
+#define CLUSTER_MAX_NODE_NAME 32      /**< 节点名的最大长度 */
+#define CLUSTER_MAX_HOST 64           /**< 节点地址的最大长度（含 NUL） */
+#define CLUSTER_DEFAULT_VNODES 128    /**< 每个节点默认的虚拟节点数 */
+#define CLUSTER_MAX_VNODES 1024       /**< 每个节点虚拟节点数的上限 */
+#define CLUSTER_IO_TIMEOUT_MS 5000    /**< 客户端等待响应的超时（毫秒） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 环上的一个节点。
+ */
+typedef struct ClusterNode {
+  char name[CLUSTER_MAX_NODE_NAME + 1]; /**< 节点名，决定虚拟节点的位置。 */
+  char host[CLUSTER_MAX_HOST];          /**< 节点网络服务的 IPv4 地址。 */
+  int port;                             /**< 节点网络服务的端口。 */
+  int vnodes;   /**< 虚拟节点数，即节点的权重。 */
+  int draining; /**< 非 0 表示节点正在离开，不再拥有任何站点。 */
+  ParkingRegistry *registry; /**< 节点托管在本进程时的注册表，否则为 NULL。 */
+} ClusterNode;
+
+/**
+ * @brief 环上的一个虚拟节点。
+ */
+typedef struct ClusterPoint {
+  unsigned long hash; /**< 在环上的位置（32 位）。 */
+  int node;           /**< 所属节点在 ClusterRing.nodes 中的下标。 */
+} ClusterPoint;
+
+/**
+ * @brief 一致性哈希环。
+ */
+typedef struct ClusterRing {
+  ClusterNode nodes[CLUSTER_MAX_NODES]; /**< 节点表。 */
+  int node_count;                       /**< 节点数。 */
+  ClusterPoint *points; /**< 按位置升序排列的虚拟节点。 */
+  size_t point_count;   /**< 虚拟节点数（不含正在离开的节点）。 */
+  size_t point_capacity; /**< points 已分配的项数。 */
+  unsigned long version; /**< 成员变化的次数。 */
+} ClusterRing;
+
+/**
+ * @brief 一次重新均衡的结果。
+ */
+typedef struct ClusterRebalanceSummary {
+  int checked;  /**< 检查的站点数（本进程节点上已打开的站点）。 */
+  int moved;    /**< 迁移到新主节点的站点数。 */
+  int stranded; /**< 新主节点不在本进程、只能留在原处的站点数。 */
+  int failed;   /**< 迁移失败、已在原节点重新打开的站点数。 */
+} ClusterRebalanceSummary;
+
+/**
+ * @brief 按环路由请求的集群客户端（不透明类型）。
+ */
+typedef struct ClusterClient ClusterClient;
+
+/**
+ *********************************************************************************
+ *                             一致性哈希环API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个没有节点的环。
+ * @return 成功返回环，内存不足返回 NULL。
+ */
+ClusterRing *cluster_ring_create(void);
+
+/**
+ * @brief 释放环，不释放节点登记的注册表。
+ * @param ring 要释放的环，可以为 NULL。
+ */
+void cluster_ring_free(ClusterRing *ring);
+
+/**
+ * @brief 向环中加入一个节点。
+ * @param ring 目标环。
+ * @param name 节点名，非空、不超过 CLUSTER_MAX_NODE_NAME 字节且不与已有节点
+ *             重名；各客户端须使用相同的节点名。
+ * @param host 节点网络服务的 IPv4 地址，NULL 表示 127.0.0.1。
+ * @param port 节点网络服务的端口。
+ * @param vnodes 虚拟节点数，0 表示 CLUSTER_DEFAULT_VNODES，
+ *               超过 CLUSTER_MAX_VNODES 时按上限处理。
+ * @return 成功返回 0；参数无效或重名返回 -1；内存不足返回 -2；
+ *         节点数已达 CLUSTER_MAX_NODES 返回 -3。
+ */
+int cluster_ring_add_node(ClusterRing *ring, const char *name,
+                          const char *host, int port, int vnodes);
+
+/**
+ * @brief 登记托管在本进程中的节点的注册表，供 cluster_rebalance 迁移站点。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @param registry 节点的注册表，NULL 表示取消登记。
+ * @return 成功返回 0，节点不存在返回 -1。
+ */
+int cluster_ring_bind_registry(ClusterRing *ring, const char *name,
+                               ParkingRegistry *registry);
+
+/**
+ * @brief 使节点不再拥有任何站点，它的站点由其余节点接手。
+ * @details 节点仍留在节点表中（注册表登记不变），供 cluster_rebalance
+ *          把它的站点迁走。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @return 成功返回 0，节点不存在返回 -1。
+ */
+int cluster_ring_drain_node(ClusterRing *ring, const char *name);
+
+/**
+ * @brief 从环中移除一个节点。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @return 成功返回 0，节点不存在返回 -1。
+ */
+int cluster_ring_remove_node(ClusterRing *ring, const char *name);
+
+/**
+ * @brief 按节点名查找节点。
+ * @param ring 目标环。
+ * @param name 节点名。
+ * @return 找到返回节点，否则返回 NULL。
+ */
+const ClusterNode *cluster_ring_find(const ClusterRing *ring,
+                                     const char *name);
+
+/**
+ * @brief 查找站点的主节点。
+ * @details 对站点编号哈希后在虚拟节点数组中二分查找，代价为
+ *          O(log 虚拟节点数)，不分配内存。
+ * @param ring 目标环。
+ * @param site_id 站点编号。
+ * @return 主节点；环上没有（未在离开的）节点或参数无效时返回 NULL。
+ */
+const ClusterNode *cluster_ring_owner(const ClusterRing *ring,
+                                      const char *site_id);
+
+/**
+ * @brief 把本进程节点上已打开的站点迁移到各自的主节点。
+ * @details 逐个站点在原节点关闭（写出快照），把快照复制到新主节点的目录，
+ *          再在新主节点以原来的总车位数打开，最后删除原节点的快照与索引
+ *          映像。任何一步失败都会在原节点重新打开站点。
+ *          原节点的网络服务可以继续运行：关闭站点时等正在执行的请求
+ *          结束，之后的请求返回 PARKING_SERVICE_BUSY。
+ * @param ring 目标环。
+ * @param[out] summary 接收迁移结果，可以为 NULL。
+ * @return 全部成功返回 0；参数无效返回 -1；内存不足返回 -2；
+ *         有站点迁移失败返回 -3。
+ */
+int cluster_rebalance(ClusterRing *ring, ClusterRebalanceSummary *summary);
+
+/**
+ *********************************************************************************
+ *                                集群客户端API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建集群客户端。
+ * @details 客户端只引用环，环须比客户端存活得久；环的成员变化与客户端
+ *          调用须由调用者串行。连接在第一次向某个节点发送请求时建立。
+ * @param ring 路由使用的环。
+ * @return 成功返回客户端，参数无效或内存不足返回 NULL。
+ */
+ClusterClient *cluster_client_create(const ClusterRing *ring);
+
+/**
+ * @brief 关闭全部连接并释放客户端。
+ * @param client 要释放的客户端，可以为 NULL。
+ */
+void cluster_client_free(ClusterClient *client);
+
+/**
+ * @brief 把一行请求发往站点的主节点并等待响应。
+ * @details 请求为单个停车场的格式 <id> <命令> [参数...]（不含行尾），
+ *          客户端在 id 之后插入站点编号。连接失效时重连一次；
+ *          发送后未收到响应时不重发，调用者可以同一 id 重试
+ *          （节点启用请求去重表时不会重复执行）。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param request 请求行。
+ * @param[out] reply 接收不含行尾、以 NUL 结尾的响应行，
+ *                   至少 PARKING_DAEMON_MAX_REPLY 字节。
+ * @return 成功返回 0；参数无效或请求过长返回 -1；环上没有节点返回 -2；
+ *         无法连接、发送或接收超时返回 -3。
+ */
+int cluster_client_call(ClusterClient *client, const char *site_id,
+                        const char *request, char *reply);
+
+/**
+ * @brief 在站点的主节点上打开站点，站点不存在时以 total_slots 新建。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param total_slots 新建时的总车位数。
+ * @return 节点返回的状态码；无法与节点通信时返回 PARKING_SERVICE_BUSY。
+ */
+ParkingServiceResultCode cluster_client_open_site(ClusterClient *client,
+                                                  const char *site_id,
+                                                  int total_slots);
+
+/**
+ * @brief 在站点的主节点上调用 parking_service_fast_add_slot。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param slot_id 车位编号。
+ * @param location 车位位置。
+ * @return 节点返回的状态码；无法与节点通信时返回 PARKING_SERVICE_BUSY。
+ */
+ParkingServiceResultCode cluster_client_add_slot(ClusterClient *client,
+                                                 const char *site_id,
+                                                 int slot_id,
+                                                 const char *location);
+
+/**
+ * @brief 在站点的主节点上调用 parking_service_fast_allocate_any_slot。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型。
+ * @param[out] slot_id 接收分到的车位编号，失败时写入 0；可以为 NULL。
+ * @return 节点返回的状态码；无法与节点通信时返回 PARKING_SERVICE_BUSY。
+ */
+ParkingServiceResultCode
+cluster_client_allocate_any_slot(ClusterClient *client, const char *site_id,
+                                 const char *owner_name,
+                                 const char *license_plate,
+                                 const char *contact, ParkingType type,
+                                 int *slot_id);
+
+/**
+ * @brief 在站点的主节点上调用 parking_service_fast_deallocate_slot。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param slot_id 车位编号。
+ * @param[out] amount_cents 接收应缴金额（分），失败时写入 0；可以为 NULL。
+ * @return 节点返回的状态码；无法与节点通信时返回 PARKING_SERVICE_BUSY。
+ */
+ParkingServiceResultCode cluster_client_deallocate_slot(ClusterClient *client,
+                                                        const char *site_id,
+                                                        int slot_id,
+                                                        long *amount_cents);
+
+/**
+ * @brief 在站点的主节点上调用 parking_service_fast_get_statistics。
+ * @param client 集群客户端。
+ * @param site_id 站点编号。
+ * @param[out] stats 接收总车位、已占用与空闲车位数，占用率由此算出，营收清零。
+ * @return 节点返回的状态码；无法与节点通信时返回 PARKING_SERVICE_BUSY。
+ */
+ParkingServiceResultCode
+cluster_client_get_statistics(ClusterClient *client, const char *site_id,
+                              ParkingStatistics *stats);
+
+#endif /* PARKING_CLUSTER_H */
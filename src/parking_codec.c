@@ -0,0 +1,144 @@
+/**
+ * @file parking_codec.c
+ * @brief 持久化格式共用的字节编解码与校验实现文件
+ * @details
+ * 该文件实现了 parking_codec.h 中声明的小端序编解码函数和 FNV-1a 校验和，
+ * 供二进制快照与预写日志共同使用。
+ */
+
+#include "parking_codec.h"
+
+/**
+ * @brief 以小端序写入 16 位无符号整数。
+ * @param p 目标缓冲区。
+ * @param value 要写入的值。
+ */
+void codec_put_u16(unsigned char *p, unsigned int value) {
+  p[0] = (unsigned char)(value & 0xFFU);
+  p[1] = (unsigned char)((value >> 8) & 0xFFU);
+}
+
+/**
+ * @brief 以小端序读取 16 位无符号整数。
+ * @param p 源缓冲区。
+ * @return 读取到的值。
+ */
+unsigned int codec_get_u16(const unsigned char *p) {
+  return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
+
+/**
+ * @brief 以小端序写入 32 位无符号整数。
+ * @param p 目标缓冲区。
+ * @param value 要写入的值。
+ */
+void codec_put_u32(unsigned char *p, unsigned long value) {
+  p[0] = (unsigned char)(value & 0xFFUL);
+  p[1] = (unsigned char)((value >> 8) & 0xFFUL);
+  p[2] = (unsigned char)((value >> 16) & 0xFFUL);
+  p[3] = (unsigned char)((value >> 24) & 0xFFUL);
+}
+
+/**
+ * @brief 以小端序读取 32 位无符号整数。
+ * @param p 源缓冲区。
+ * @return 读取到的值。
+ */
+unsigned long codec_get_u32(const unsigned char *p) {
+  return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+         ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+/**
+ * @brief 以 32 位补码写入有符号整数。
+ * @param p 目标缓冲区。
+ * @param value 要写入的值。
+ */
+void codec_put_i32(unsigned char *p, int value) {
+  codec_put_u32(p, (unsigned long)value);
+}
+
+/**
+ * @brief 读取以 32 位补码存放的有符号整数。
+ * @details 按补码显式还原符号，避免依赖实现定义的窄化转换。
+ * @param p 源缓冲区。
+ * @return 读取到的值。
+ */
+int codec_get_i32(const unsigned char *p) {
+  unsigned long raw = codec_get_u32(p);
+
+  return raw < 0x80000000UL ? (int)raw : -(int)(0xFFFFFFFFUL - raw) - 1;
+}
+
+/**
+ * @brief (静态辅助函数) 将时间戳向负无穷方向除以 65536。
+ * @details C90 中负数除法的取整方向由实现定义，这里显式修正为向下取整，
+ * 分两次调用即得到高 32 位，32 位的 time_t 上也不会移出类型宽度。
+ * @param value 时间戳。
+ * @return value / 65536 向下取整的结果。
+ */
+static time_t time_shift16(time_t value) {
+  time_t q = value / 65536;
+
+  if (q * 65536 > value) {
+    q--;
+  }
+  return q;
+}
+
+/**
+ * @brief 以小端序 64 位有符号整数写入时间戳。
+ * @details 拆成低、高两个 32 位补码分别写入，不依赖 C90 没有的 long long。
+ * @param p 目标缓冲区。
+ * @param value 要写入的时间戳。
+ */
+void codec_put_time(unsigned char *p, time_t value) {
+  time_t high = time_shift16(time_shift16(value));
+
+  codec_put_u32(p, (unsigned long)value & 0xFFFFFFFFUL);
+  codec_put_u32(p + 4, (unsigned long)high & 0xFFFFFFFFUL);
+}
+
+/**
+ * @brief 读取以小端序 64 位有符号整数存放的时间戳。
+ * @details 高 32 位按补码还原符号后逐 16 位拼回低位，中间结果不超出 time_t。
+ * @param p 源缓冲区。
+ * @return 读取到的时间戳。
+ */
+time_t codec_get_time(const unsigned char *p) {
+  unsigned long low = codec_get_u32(p);
+  time_t v = (time_t)codec_get_i32(p + 4);
+
+  v = v * 65536 + (time_t)(low >> 16);
+  v = v * 65536 + (time_t)(low & 0xFFFFUL);
+  return v;
+}
+
+/**
+ * @brief 计算数据块的 32 位 FNV-1a 校验和。
+ * @param data 数据块。
+ * @param size 数据块字节数。
+ * @return 32 位校验和。
+ */
+unsigned long codec_checksum(const unsigned char *data, size_t size) {
+  return codec_checksum_update(2166136261UL, data, size);
+}
+
+/**
+ * @brief 在已有校验和的基础上继续累加数据块。
+ * @param seed 前面各段的校验和。
+ * @param data 数据块。
+ * @param size 数据块字节数。
+ * @return 累加后的 32 位校验和。
+ */
+unsigned long codec_checksum_update(unsigned long seed,
+                                    const unsigned char *data, size_t size) {
+  unsigned long h = seed;
+  size_t i;
+
+  for (i = 0; i < size; i++) {
+    h ^= data[i];
+    h = (h * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  return h;
+}
@@ -0,0 +1,107 @@
+#ifndef PARKING_CODEC_H
+#define PARKING_CODEC_H
+
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * @file parking_codec.h
+ * @brief 持久化格式共用的字节编解码与校验函数声明。
+ * @details
+ * 二进制快照与预写日志都按小端序逐字节编码整数和时间戳，
+ * 以保证文件与结构体填充、time_t 宽度和主机字节序无关。
+ */
+
+/**
+ *********************************************************************************
+ *                            编解码API声明
+ *********************************************************************************
+ */
+
+/** @name 整数与时间戳编解码 */
+/** @{ */
+
+/**
+ * @brief 以小端序写入 16 位无符号整数。
+ * @param p 目标缓冲区（至少 2 字节）。
+ * @param value 要写入的值（只取低 16 位）。
+ */
+void codec_put_u16(unsigned char *p, unsigned int value);
+
+/**
+ * @brief 以小端序读取 16 位无符号整数。
+ * @param p 源缓冲区（至少 2 字节）。
+ * @return 读取到的值。
+ */
+unsigned int codec_get_u16(const unsigned char *p);
+
+/**
+ * @brief 以小端序写入 32 位无符号整数。
+ * @param p 目标缓冲区（至少 4 字节）。
+ * @param value 要写入的值（只取低 32 位）。
+ */
+void codec_put_u32(unsigned char *p, unsigned long value);
+
+/**
+ * @brief 以小端序读取 32 位无符号整数。
+ * @param p 源缓冲区（至少 4 字节）。
+ * @return 读取到的值。
+ */
+unsigned long codec_get_u32(const unsigned char *p);
+
+/**
+ * @brief 以 32 位补码写入有符号整数。
+ * @param p 目标缓冲区（至少 4 字节）。
+ * @param value 要写入的值。
+ */
+void codec_put_i32(unsigned char *p, int value);
+
+/**
+ * @brief 读取以 32 位补码存放的有符号整数。
+ * @param p 源缓冲区（至少 4 字节）。
+ * @return 读取到的值。
+ */
+int codec_get_i32(const unsigned char *p);
+
+/**
+ * @brief 以小端序 64 位有符号整数写入时间戳。
+ * @param p 目标缓冲区（至少 8 字节）。
+ * @param value 要写入的时间戳。
+ */
+void codec_put_time(unsigned char *p, time_t value);
+
+/**
+ * @brief 读取以小端序 64 位有符号整数存放的时间戳。
+ * @param p 源缓冲区（至少 8 字节）。
+ * @return 读取到的时间戳。
+ */
+time_t codec_get_time(const unsigned char *p);
+
+/** @} */
+
+/** @name 校验 */
+/** @{ */
+
+/**
+ * @brief 计算数据块的 32 位 FNV-1a 校验和。
+ * @param data 数据块。
+ * @param size 数据块字节数。
+ * @return 32 位校验和。
+ */
+unsigned long codec_checksum(const unsigned char *data, size_t size);
+
+/**
+ * @brief 在已有校验和的基础上继续累加数据块。
+ * @details 用于对不连续的多段数据计算同一个校验和；
+ *          首段应以 codec_checksum 计算，后续各段依次调用本函数。
+ * @param seed 前面各段的校验和。
+ * @param data 数据块。
+ * @param size 数据块字节数。
+ * @return 累加后的 32 位校验和。
+ */
+unsigned long codec_checksum_update(unsigned long seed,
+                                    const unsigned char *data, size_t size);
+
+/** @} */
+
+#endif /* PARKING_CODEC_H */
@@ -0,0 +1,254 @@
+/**
+ * @file parking_column.c
+ * @brief 热字段列的字节比较扫描内核实现文件
+ * @details
+ * 该文件实现了 parking_column.h 中声明的扫描内核。
+ * 每个内核先按 16 字节一组用向量指令处理，不足一组的尾部交给标量循环；
+ * 没有可用向量指令集时整段走标量循环。
+ */
+
+#include "parking_column.h"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLUMN_SSE2 1
+#include <emmintrin.h>
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+#define COLUMN_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define COLUMN_LANES 16 /**< 一条向量指令处理的字节数 */
+#define COLUMN_COUNT_BATCH 255 /**< 字节累加器溢出前最多累加的组数 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+#if defined(COLUMN_SSE2) || defined(COLUMN_NEON)
+/**
+ * @brief (静态辅助函数) 计算非零掩码中最低置位的下标。
+ * @param mask 非零的 16 位掩码。
+ * @return 最低置位的下标（0 起）。
+ */
+static int lowest_lane(unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctz(mask);
+#else
+  int index = 0;
+  while ((mask & 1U) == 0) {
+    mask >>= 1;
+    index++;
+  }
+  return index;
+#endif
+}
+#endif
+
+#if defined(COLUMN_SSE2)
+/**
+ * @brief (静态辅助函数) 比较 16 字节并提取相等掩码。
+ * @param bytes 16 字节的起点，不要求对齐。
+ * @param needle 每个字节都等于比较值的向量。
+ * @return 第 i 位为 1 表示第 i 个字节相等。
+ */
+static unsigned int lanes_equal(const unsigned char *bytes, __m128i needle) {
+  __m128i data = _mm_loadu_si128((const __m128i *)(const void *)bytes);
+
+  return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(data, needle));
+}
+#elif defined(COLUMN_NEON)
+/**
+ * @brief (静态辅助函数) 比较 16 字节并提取相等掩码。
+ * @details NEON 没有 movemask，先把每个相等字节换成所在位的权重再横向求和。
+ * @param bytes 16 字节的起点，不要求对齐。
+ * @param needle 每个字节都等于比较值的向量。
+ * @return 第 i 位为 1 表示第 i 个字节相等。
+ */
+static unsigned int lanes_equal(const unsigned char *bytes, uint8x16_t needle) {
+  static const unsigned char weights[COLUMN_LANES] = {
+      1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t bits =
+      vandq_u8(vceqq_u8(vld1q_u8(bytes), needle), vld1q_u8(weights));
+
+  return (unsigned int)vaddv_u8(vget_low_u8(bits)) |
+         ((unsigned int)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+#endif
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 比较一段字节列，返回等于 value 的行掩码。
+ * @param column 列的起点。
+ * @param rows 行数，不能超过 unsigned long 的位数。
+ * @param value 要比较的值。
+ * @return 第 i 位为 1 表示 column[i] == value。
+ */
+unsigned long column_match_u8(const unsigned char *column, size_t rows,
+                              unsigned char value) {
+  unsigned long mask = 0;
+  size_t i = 0;
+#if defined(COLUMN_SSE2)
+  __m128i needle = _mm_set1_epi8((char)value);
+
+  for (; i + COLUMN_LANES <= rows; i += COLUMN_LANES) {
+    mask |= (unsigned long)lanes_equal(column + i, needle) << i;
+  }
+#elif defined(COLUMN_NEON)
+  uint8x16_t needle = vdupq_n_u8(value);
+
+  for (; i + COLUMN_LANES <= rows; i += COLUMN_LANES) {
+    mask |= (unsigned long)lanes_equal(column + i, needle) << i;
+  }
+#endif
+  for (; i < rows; i++) {
+    mask |= (unsigned long)(column[i] == value) << i;
+  }
+  return mask;
+}
+
+/**
+ * @brief 统计一段字节列中等于 value 的行数。
+ * @details 向量版本把比较结果（相等为 0xFF）逐组减到字节累加器上，
+ *          每 COLUMN_COUNT_BATCH 组横向求和一次，避免字节溢出。
+ * @param column 列的起点。
+ * @param rows 行数。
+ * @param value 要比较的值。
+ * @return 相等的行数。
+ */
+size_t column_count_u8(const unsigned char *column, size_t rows,
+                       unsigned char value) {
+  size_t count = 0;
+  size_t i = 0;
+#if defined(COLUMN_SSE2)
+  __m128i needle = _mm_set1_epi8((char)value);
+  __m128i zero = _mm_setzero_si128();
+
+  while (i + COLUMN_LANES <= rows) {
+    __m128i acc = _mm_setzero_si128();
+    __m128i sums;
+    int batch;
+
+    for (batch = 0; batch < COLUMN_COUNT_BATCH && i + COLUMN_LANES <= rows;
+         batch++, i += COLUMN_LANES) {
+      __m128i data =
+          _mm_loadu_si128((const __m128i *)(const void *)(column + i));
+
+      acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(data, needle));
+    }
+    sums = _mm_sad_epu8(acc, zero);
+    count += (size_t)_mm_cvtsi128_si32(sums) +
+             (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+  }
+#elif defined(COLUMN_NEON)
+  uint8x16_t needle = vdupq_n_u8(value);
+
+  while (i + COLUMN_LANES <= rows) {
+    uint8x16_t acc = vdupq_n_u8(0);
+    int batch;
+
+    for (batch = 0; batch < COLUMN_COUNT_BATCH && i + COLUMN_LANES <= rows;
+         batch++, i += COLUMN_LANES) {
+      acc = vsubq_u8(acc, vceqq_u8(vld1q_u8(column + i), needle));
+    }
+    count += (size_t)vaddlvq_u8(acc);
+  }
+#endif
+  for (; i < rows; i++) {
+    count += column[i] == value;
+  }
+  return count;
+}
+
+/**
+ * @brief 查找第一个等于 value 的行。
+ * @param column 列的起点。
+ * @param from 开始查找的行号。
+ * @param rows 列的总行数。
+ * @param value 要比较的值。
+ * @return 找到时返回行号，否则返回 rows。
+ */
+size_t column_find_u8(const unsigned char *column, size_t from, size_t rows,
+                      unsigned char value) {
+  size_t i = from;
+#if defined(COLUMN_SSE2) || defined(COLUMN_NEON)
+  unsigned int mask;
+#if defined(COLUMN_SSE2)
+  __m128i needle = _mm_set1_epi8((char)value);
+#else
+  uint8x16_t needle = vdupq_n_u8(value);
+#endif
+
+  for (; i + COLUMN_LANES <= rows; i += COLUMN_LANES) {
+    mask = lanes_equal(column + i, needle);
+    if (mask != 0) {
+      return i + (size_t)lowest_lane(mask);
+    }
+  }
+#endif
+  for (; i < rows; i++) {
+    if (column[i] == value) {
+      return i;
+    }
+  }
+  return rows;
+}
+
+/**
+ * @brief 比较一段时间戳列，返回落在 [from, to) 内的行掩码。
+ * @details 两次比较用按位与合并，循环体没有分支。
+ * @param column 列的起点。
+ * @param rows 行数，不能超过 unsigned long 的位数。
+ * @param from 下界（含）。
+ * @param to 上界（不含）。
+ * @return 命中掩码。
+ */
+unsigned long column_match_time(const time_t *column, size_t rows, time_t from,
+                                time_t to) {
+  unsigned long mask = 0;
+  size_t i;
+
+  for (i = 0; i < rows; i++) {
+    mask |= (unsigned long)((column[i] >= from) & (column[i] < to)) << i;
+  }
+  return mask;
+}
+
+/**
+ * @brief 计算非零字中最低置位的下标。
+ * @param word 非零的字。
+ * @return 最低置位的下标（0 起）。
+ */
+int column_lowest_bit(unsigned long word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzl(word);
+#else
+  int index = 0;
+  while ((word & 1UL) == 0) {
+    word >>= 1;
+    index++;
+  }
+  return index;
+#endif
+}
+
+/**
+ * @brief 统计一个字中置 1 的位数。
+ * @param word 任意字。
+ * @return 置位数。
+ */
+int column_popcount(unsigned long word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountl(word);
+#else
+  int count = 0;
+  while (word != 0) {
+    word &= word - 1;
+    count++;
+  }
+  return count;
+#endif
+}
@@ -0,0 +1,80 @@
+#ifndef PARKING_COLUMN_H
+#define PARKING_COLUMN_H
+
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * @file parking_column.h
+ * @brief 热字段列的字节比较扫描内核声明。
+ * @details
+ * 状态列与类型列每行一个字节，按值比较、计数和查找都可以一次处理 16 字节：
+ * 编译目标支持 SSE2（x86-64 默认具备）时使用 SSE2 字节比较与掩码提取，
+ * AArch64 上使用 NEON，其余平台退化为逐字节的标量循环。
+ * 选择在编译期完成，结果与标量实现逐位一致。
+ * 时间戳列（time_t）的区间比较没有分支，逐行写成掩码，由编译器自行向量化。
+ */
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 比较一段字节列，返回等于 value 的行掩码。
+ * @param column 列的起点。
+ * @param rows 行数，不能超过 unsigned long 的位数。
+ * @param value 要比较的值。
+ * @return 第 i 位为 1 表示 column[i] == value。
+ */
+unsigned long column_match_u8(const unsigned char *column, size_t rows,
+                              unsigned char value);
+
+/**
+ * @brief 统计一段字节列中等于 value 的行数。
+ * @param column 列的起点。
+ * @param rows 行数。
+ * @param value 要比较的值。
+ * @return 相等的行数。
+ */
+size_t column_count_u8(const unsigned char *column, size_t rows,
+                       unsigned char value);
+
+/**
+ * @brief 查找第一个等于 value 的行。
+ * @param column 列的起点。
+ * @param from 开始查找的行号。
+ * @param rows 列的总行数。
+ * @param value 要比较的值。
+ * @return 找到时返回行号（不小于 from），否则返回 rows。
+ */
+size_t column_find_u8(const unsigned char *column, size_t from, size_t rows,
+                      unsigned char value);
+
+/**
+ * @brief 比较一段时间戳列，返回落在 [from, to) 内的行掩码。
+ * @param column 列的起点。
+ * @param rows 行数，不能超过 unsigned long 的位数。
+ * @param from 下界（含）。
+ * @param to 上界（不含）。
+ * @return 第 i 位为 1 表示 from <= column[i] < to。
+ */
+unsigned long column_match_time(const time_t *column, size_t rows, time_t from,
+                                time_t to);
+
+/**
+ * @brief 计算非零字中最低置位的下标。
+ * @param word 非零的字。
+ * @return 最低置位的下标（0 起）。
+ */
+int column_lowest_bit(unsigned long word);
+
+/**
+ * @brief 统计一个字中置 1 的位数。
+ * @param word 任意字。
+ * @return 置位数。
+ */
+int column_popcount(unsigned long word);
+
+#endif /* PARKING_COLUMN_H */
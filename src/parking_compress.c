@@ -0,0 +1,268 @@
+/**
+ * @file parking_compress.c
+ * @brief 持久化文件使用的块压缩实现文件
+ * @details
+ * 该文件实现了 parking_compress.h 中声明的 LZ4 块格式编码器与带边界检查的
+ * 解码器。
+ */
+
+#include <string.h>
+
+#include "parking_compress.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define COMPRESS_HASH_BITS 12        /**< 匹配哈希表的位数 */
+#define COMPRESS_MIN_MATCH 4         /**< 最短匹配长度 */
+#define COMPRESS_LAST_LITERALS 5     /**< 块末尾必须保留为字面量的字节数 */
+#define COMPRESS_MATCH_MARGIN 12     /**< 匹配起点距块末尾的最小距离 */
+#define COMPRESS_MAX_OFFSET 65535    /**< 匹配偏移的最大值 */
+#define COMPRESS_RUN_MASK 15         /**< 标记字节中一个长度字段的最大值 */
+#define COMPRESS_SKIP_SHIFT 6        /**< 连续未命中时加速前进的步长移位 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 以小端序读取 4 个字节。
+ * @param p 源地址。
+ * @return 32 位值。
+ */
+static unsigned long read_u32(const unsigned char *p) {
+  return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+         ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+/**
+ * @brief (静态辅助函数) 计算 4 字节序列在匹配哈希表中的位置。
+ * @param value read_u32 读出的值。
+ * @return 哈希表下标。
+ */
+static size_t hash_sequence(unsigned long value) {
+  return (size_t)(((value * 2654435761UL) & 0xFFFFFFFFUL) >>
+                  (32 - COMPRESS_HASH_BITS));
+}
+
+/**
+ * @brief (静态辅助函数) 写出超过标记字节所能表示的长度余量。
+ * @param op 输出位置。
+ * @param length 长度减去 COMPRESS_RUN_MASK 之后的余量。
+ * @return 写完之后的输出位置。
+ */
+static unsigned char *put_length(unsigned char *op, size_t length) {
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (unsigned char)length;
+  return op;
+}
+
+/**
+ * @brief (静态辅助函数) 写出一个序列：字面量，以及可选的回溯匹配。
+ * @param op 输出位置。
+ * @param end 输出缓冲区末尾。
+ * @param literals 字面量起始地址。
+ * @param literal_length 字面量字节数。
+ * @param offset 匹配偏移，0 表示只有字面量（块的最后一个序列）。
+ * @param match_length 匹配长度（至少 COMPRESS_MIN_MATCH）。
+ * @return 写完之后的输出位置；输出缓冲区放不下时返回 NULL。
+ */
+static unsigned char *put_sequence(unsigned char *op, const unsigned char *end,
+                                   const unsigned char *literals,
+                                   size_t literal_length, size_t offset,
+                                   size_t match_length) {
+  unsigned char *token = op;
+  size_t need = 1 + literal_length / 255 + 1 + literal_length;
+
+  if (offset != 0) {
+    need += 2 + match_length / 255 + 1;
+  }
+  if (need > (size_t)(end - op)) {
+    return NULL;
+  }
+
+  op++;
+  if (literal_length >= COMPRESS_RUN_MASK) {
+    *token = (unsigned char)(COMPRESS_RUN_MASK << 4);
+    op = put_length(op, literal_length - COMPRESS_RUN_MASK);
+  } else {
+    *token = (unsigned char)(literal_length << 4);
+  }
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+  if (offset == 0) {
+    return op;
+  }
+
+  *op++ = (unsigned char)(offset & 0xFFU);
+  *op++ = (unsigned char)((offset >> 8) & 0xFFU);
+  match_length -= COMPRESS_MIN_MATCH;
+  if (match_length >= COMPRESS_RUN_MASK) {
+    *token |= COMPRESS_RUN_MASK;
+    op = put_length(op, match_length - COMPRESS_RUN_MASK);
+  } else {
+    *token |= (unsigned char)match_length;
+  }
+  return op;
+}
+
+/**
+ * @brief (静态辅助函数) 读取标记字节之后的长度余量并累加到长度上。
+ * @param src 压缩数据。
+ * @param size 压缩数据字节数。
+ * @param[in,out] ip 读取位置。
+ * @param[in,out] length 标记字节给出的长度，返回时加上余量。
+ * @return 成功返回 0，数据提前结束返回 -1。
+ */
+static int get_length(const unsigned char *src, size_t size, size_t *ip,
+                      size_t *length) {
+  unsigned int byte;
+
+  do {
+    if (*ip >= size) {
+      return -1;
+    }
+    byte = src[(*ip)++];
+    *length += byte;
+  } while (byte == 255);
+  return 0;
+}
+
+/* ========================================================================== */
+/*                                块压缩API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 取压缩一块数据时输出缓冲区需要的最大字节数。
+ * @param size 原始数据字节数。
+ * @return 最坏情况下压缩结果的字节数。
+ */
+size_t compress_bound(size_t size) { return size + size / 255 + 16; }
+
+/**
+ * @brief 压缩一块数据。
+ * @details 贪心匹配：哈希表记录每个 4 字节序列最近出现的位置，命中后向后
+ *          延伸匹配并向前吸收相同的字面量；连续未命中时步长逐渐增大，
+ *          不可压缩的数据很快扫过。
+ * @param src 原始数据。
+ * @param size 原始数据字节数。
+ * @param dst 输出缓冲区。
+ * @param capacity 输出缓冲区字节数。
+ * @return 压缩后的字节数，输出缓冲区放不下时返回 0。
+ */
+size_t compress_block(const unsigned char *src, size_t size,
+                      unsigned char *dst, size_t capacity) {
+  unsigned int table[1 << COMPRESS_HASH_BITS];
+  const unsigned char *end = dst + capacity;
+  unsigned char *op = dst;
+  size_t anchor = 0;
+  size_t ip = 0;
+  size_t misses = 0;
+
+  memset(table, 0, sizeof(table));
+  if (size > COMPRESS_MATCH_MARGIN) {
+    size_t match_start_limit = size - COMPRESS_MATCH_MARGIN;
+    size_t match_end_limit = size - COMPRESS_LAST_LITERALS;
+
+    while (ip < match_start_limit) {
+      unsigned long sequence = read_u32(src + ip);
+      size_t h = hash_sequence(sequence);
+      size_t ref = table[h];
+      size_t length;
+
+      table[h] = (unsigned int)ip;
+      if (ref >= ip || ip - ref > COMPRESS_MAX_OFFSET ||
+          read_u32(src + ref) != sequence) {
+        ip += 1 + (misses++ >> COMPRESS_SKIP_SHIFT);
+        continue;
+      }
+
+      misses = 0;
+      while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+        ip--;
+        ref--;
+      }
+      length = COMPRESS_MIN_MATCH;
+      while (ip + length < match_end_limit &&
+             src[ip + length] == src[ref + length]) {
+        length++;
+      }
+      op = put_sequence(op, end, src + anchor, ip - anchor, ip - ref, length);
+      if (op == NULL) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+      if (ip < match_start_limit) {
+        table[hash_sequence(read_u32(src + ip - 2))] = (unsigned int)(ip - 2);
+      }
+    }
+  }
+
+  op = put_sequence(op, end, src + anchor, size - anchor, 0, 0);
+  return op != NULL ? (size_t)(op - dst) : 0;
+}
+
+/**
+ * @brief 解压一块由 compress_block 得到的数据。
+ * @param src 压缩数据。
+ * @param size 压缩数据字节数。
+ * @param dst 输出缓冲区。
+ * @param capacity 输出缓冲区字节数。
+ * @param[out] out_size 接收解压后的字节数。
+ * @return 成功返回 0，数据损坏或输出缓冲区放不下时返回 -1。
+ */
+int decompress_block(const unsigned char *src, size_t size, unsigned char *dst,
+                     size_t capacity, size_t *out_size) {
+  size_t ip = 0;
+  size_t op = 0;
+
+  while (ip < size) {
+    unsigned int token = src[ip++];
+    size_t length = token >> 4;
+    size_t offset;
+    size_t i;
+
+    if (length == COMPRESS_RUN_MASK && get_length(src, size, &ip, &length)) {
+      return -1;
+    }
+    if (length > size - ip || length > capacity - op) {
+      return -1;
+    }
+    memcpy(dst + op, src + ip, length);
+    ip += length;
+    op += length;
+    if (ip == size) {
+      break; /* 最后一个序列只有字面量 */
+    }
+
+    if (size - ip < 2) {
+      return -1;
+    }
+    offset = (size_t)src[ip] | ((size_t)src[ip + 1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op) {
+      return -1;
+    }
+    length = token & COMPRESS_RUN_MASK;
+    if (length == COMPRESS_RUN_MASK && get_length(src, size, &ip, &length)) {
+      return -1;
+    }
+    length += COMPRESS_MIN_MATCH;
+    if (length > capacity - op) {
+      return -1;
+    }
+    /* 匹配可以与正在写出的数据重叠，须逐字节复制 */
+    for (i = 0; i < length; i++) {
+      dst[op + i] = dst[op - offset + i];
+    }
+    op += length;
+  }
+
+  *out_size = op;
+  return 0;
+}
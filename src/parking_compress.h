@@ -0,0 +1,59 @@
+#ifndef PARKING_COMPRESS_H
+#define PARKING_COMPRESS_H
+
+#include <stddef.h>
+
+/**
+ * @file parking_compress.h
+ * @brief 持久化文件使用的块压缩函数声明。
+ * @details
+ * 压缩格式与 LZ4 的块格式（block format）相同：一串"字面量 + 回溯匹配"的
+ * 序列，每个序列以一个标记字节开头，高 4 位为字面量长度、低 4 位为匹配长度
+ * 减 4，取值 15 时后面跟若干扩展字节；匹配以 2 字节小端偏移引用前 64KB 内
+ * 已解出的数据，最后一个序列只有字面量。
+ *
+ * 编码器使用 4 字节哈希的单表贪心匹配，只求快、不求压缩率；每次调用都
+ * 独立压缩一块数据，不引用其他块，因此各块可以各自并行或单独解压。
+ * 快照的车位记录与停车记录的定宽列中大量重复的 NUL 填充与时间戳高位
+ * 都能被有效压缩。
+ */
+
+/**
+ *********************************************************************************
+ *                              块压缩API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 取压缩一块数据时输出缓冲区需要的最大字节数。
+ * @param size 原始数据字节数。
+ * @return 最坏情况（数据不可压缩）下压缩结果的字节数。
+ */
+size_t compress_bound(size_t size);
+
+/**
+ * @brief 压缩一块数据。
+ * @param src 原始数据。
+ * @param size 原始数据字节数。
+ * @param dst 输出缓冲区。
+ * @param capacity 输出缓冲区字节数。
+ * @return 压缩后的字节数；输出缓冲区放不下时返回 0，
+ *         调用者可以改为原样保存这块数据。
+ */
+size_t compress_block(const unsigned char *src, size_t size,
+                      unsigned char *dst, size_t capacity);
+
+/**
+ * @brief 解压一块由 compress_block 得到的数据。
+ * @details 对输入逐项检查边界，损坏或伪造的数据不会越界读写。
+ * @param src 压缩数据。
+ * @param size 压缩数据字节数。
+ * @param dst 输出缓冲区。
+ * @param capacity 输出缓冲区字节数。
+ * @param[out] out_size 接收解压后的字节数。
+ * @return 成功返回 0；数据损坏或输出缓冲区放不下时返回 -1。
+ */
+int decompress_block(const unsigned char *src, size_t size, unsigned char *dst,
+                     size_t capacity, size_t *out_size);
+
+#endif /* PARKING_COMPRESS_H */
@@ -0,0 +1,312 @@
+/**
+ * @file parking_config.c
+ * @brief 停车场运行时配置实现文件
+ * @details
+ * 该文件实现了 parking_config.h 中声明的配置默认值、校验与文本解析。
+ * 文本与文件共用同一个逐行解析函数；所有值都是十进制整数，
+ * 金额以分为单位，解析过程不涉及浮点数与区域设置。
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_config.h"
+
+#define CONFIG_MAX_CENTS 100000000L /**< 单项价格的上限（分），防止累计溢出 */
+#define CONFIG_MAX_PERIOD_DAYS 366  /**< 居民月费计费周期的上限（天） */
+
+/**
+ * @brief 配置键的取值类型。
+ */
+typedef enum {
+  CONFIG_FIELD_INT = 0, /**< int 字段。 */
+  CONFIG_FIELD_LONG = 1 /**< long 字段。 */
+} ConfigFieldKind;
+
+/**
+ * @brief 配置键与字段的对应关系。
+ */
+typedef struct ConfigField {
+  const char *key;      /**< 键名。 */
+  ConfigFieldKind kind; /**< 字段类型。 */
+  size_t offset;        /**< 字段在 ParkingConfig 中的偏移。 */
+  long min_value;       /**< 允许的最小值。 */
+  long max_value;       /**< 允许的最大值。 */
+} ConfigField;
+
+#define CONFIG_FIELD(key, kind, member, min_value, max_value)                  \
+  {key, kind, offsetof(ParkingConfig, member), min_value, max_value}
+
+/** 支持的键；resident_period_days 按天读入，单独处理。 */
+static const ConfigField config_fields[] = {
+    CONFIG_FIELD("visitor_start_hour", CONFIG_FIELD_INT, visitor_start_hour, 0,
+                 23),
+    CONFIG_FIELD("visitor_end_hour", CONFIG_FIELD_INT, visitor_end_hour, 1, 24),
+    CONFIG_FIELD("first_hour_cents", CONFIG_FIELD_LONG,
+                 tariff.first_hour_cents, 0, CONFIG_MAX_CENTS),
+    CONFIG_FIELD("hourly_cents", CONFIG_FIELD_LONG, tariff.hourly_cents, 0,
+                 CONFIG_MAX_CENTS),
+    CONFIG_FIELD("night_hourly_cents", CONFIG_FIELD_LONG,
+                 tariff.night_hourly_cents, 0, CONFIG_MAX_CENTS),
+    CONFIG_FIELD("night_start_hour", CONFIG_FIELD_INT, tariff.night_start_hour,
+                 0, 23),
+    CONFIG_FIELD("night_end_hour", CONFIG_FIELD_INT, tariff.night_end_hour, 0,
+                 23),
+    CONFIG_FIELD("daily_cap_cents", CONFIG_FIELD_LONG, tariff.daily_cap_cents,
+                 0, CONFIG_MAX_CENTS),
+    CONFIG_FIELD("resident_monthly_cents", CONFIG_FIELD_LONG,
+                 tariff.resident_monthly_cents, 0, CONFIG_MAX_CENTS)};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 判断字符是否为空白。
+ * @param c 字符。
+ * @return 是空白返回 1，否则返回 0。
+ */
+static int is_blank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' ||
+         c == '\v';
+}
+
+/**
+ * @brief (静态辅助函数) 原地去掉字符串首尾的空白。
+ * @param text 可修改的字符串。
+ * @return 去掉前导空白后的起点。
+ */
+static char *trim(char *text) {
+  size_t length;
+
+  while (is_blank(*text)) {
+    text++;
+  }
+  length = strlen(text);
+  while (length > 0 && is_blank(text[length - 1])) {
+    text[--length] = '\0';
+  }
+  return text;
+}
+
+/**
+ * @brief (静态辅助函数) 解析一个有范围限制的十进制整数。
+ * @param value 文本，允许首尾空白。
+ * @param min_value 允许的最小值。
+ * @param max_value 允许的最大值。
+ * @param[out] out 接收解析结果。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int parse_bounded(const char *value, long min_value, long max_value,
+                         long *out) {
+  char *end;
+  long number;
+
+  while (is_blank(*value)) {
+    value++;
+  }
+  if (*value == '\0') {
+    return -1;
+  }
+  number = strtol(value, &end, 10);
+  while (is_blank(*end)) {
+    end++;
+  }
+  if (*end != '\0' || number < min_value || number > max_value) {
+    return -1;
+  }
+  *out = number;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 解析一行配置文本。
+ * @param config 目标配置。
+ * @param line 可修改的一行文本，不含换行符。
+ * @return 成功（含空行与注释行）返回 0，无法解析返回 -1。
+ */
+static int apply_line(ParkingConfig *config, char *line) {
+  char *separator;
+
+  line = trim(line);
+  if (*line == '\0' || *line == '#') {
+    return 0;
+  }
+  separator = strchr(line, '=');
+  if (separator == NULL) {
+    return -1;
+  }
+  *separator = '\0';
+  return parking_config_set(config, trim(line), separator + 1) == 0 ? 0 : -1;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 把配置设为默认值并编译费率表。
+ * @param config 目标配置。
+ */
+void parking_config_default(ParkingConfig *config) {
+  if (config == NULL) {
+    return;
+  }
+  config->visitor_start_hour = PARKING_CONFIG_DEFAULT_START_HOUR;
+  config->visitor_end_hour = PARKING_CONFIG_DEFAULT_END_HOUR;
+  tariff_config_default(&config->tariff);
+  tariff_compile(&config->fees, &config->tariff);
+  config->retired_next = NULL;
+}
+
+/**
+ * @brief 校验配置并按 tariff 重新编译费率表。
+ * @param config 目标配置。
+ * @return 成功返回 0，配置无效返回 -1。
+ */
+int parking_config_compile(ParkingConfig *config) {
+  if (config == NULL || config->visitor_start_hour < 0 ||
+      config->visitor_end_hour > 24 ||
+      config->visitor_start_hour >= config->visitor_end_hour) {
+    return -1;
+  }
+  return tariff_compile(&config->fees, &config->tariff);
+}
+
+/**
+ * @brief 按键名设置一项配置。
+ * @param config 目标配置。
+ * @param key 键名。
+ * @param value 十进制整数文本。
+ * @return 成功返回 0，未知的键返回 -1，值无效返回 -2。
+ */
+int parking_config_set(ParkingConfig *config, const char *key,
+                       const char *value) {
+  size_t i;
+  long number;
+
+  if (config == NULL || key == NULL || value == NULL) {
+    return -1;
+  }
+  if (strcmp(key, "resident_period_days") == 0) {
+    if (parse_bounded(value, 1, CONFIG_MAX_PERIOD_DAYS, &number) != 0) {
+      return -2;
+    }
+    config->tariff.resident_period_seconds = number * 24 * 3600;
+    config->tariff.resident_calendar_months = 0;
+    return 0;
+  }
+  for (i = 0; i < sizeof(config_fields) / sizeof(config_fields[0]); i++) {
+    const ConfigField *field = &config_fields[i];
+    char *target = (char *)config + field->offset;
+
+    if (strcmp(key, field->key) != 0) {
+      continue;
+    }
+    if (parse_bounded(value, field->min_value, field->max_value, &number) !=
+        0) {
+      return -2;
+    }
+    if (field->kind == CONFIG_FIELD_INT) {
+      *(int *)(void *)target = (int)number;
+    } else {
+      *(long *)(void *)target = number;
+    }
+    return 0;
+  }
+  return -1;
+}
+
+/**
+ * @brief 解析配置文本并覆盖对应的配置项，最后编译费率表。
+ * @param config 目标配置。
+ * @param text 以换行符分隔的配置文本。
+ * @param[out] error_line 出错时接收行号，可以为 NULL。
+ * @return 成功返回 0，参数无效返回 -1，行无法解析返回 -2，组合无效返回 -3。
+ */
+int parking_config_parse(ParkingConfig *config, const char *text,
+                         int *error_line) {
+  char line[PARKING_CONFIG_MAX_LINE];
+  int number = 0;
+
+  if (error_line) {
+    *error_line = 0;
+  }
+  if (config == NULL || text == NULL) {
+    return -1;
+  }
+  while (*text != '\0') {
+    const char *end = strchr(text, '\n');
+    size_t length = end != NULL ? (size_t)(end - text) : strlen(text);
+
+    number++;
+    if (length >= sizeof(line)) {
+      if (error_line) {
+        *error_line = number;
+      }
+      return -2;
+    }
+    memcpy(line, text, length);
+    line[length] = '\0';
+    if (apply_line(config, line) != 0) {
+      if (error_line) {
+        *error_line = number;
+      }
+      return -2;
+    }
+    text += end != NULL ? length + 1 : length;
+  }
+  return parking_config_compile(config) == 0 ? 0 : -3;
+}
+
+/**
+ * @brief 从默认值出发读取配置文件。
+ * @param config 接收配置。
+ * @param path 配置文件路径。
+ * @param[out] error_line 出错时接收行号，可以为 NULL。
+ * @return 成功返回 0，参数无效返回 -1，行无法解析返回 -2，组合无效返回 -3，
+ *         文件错误返回 -4。
+ */
+int parking_config_load(ParkingConfig *config, const char *path,
+                        int *error_line) {
+  char line[PARKING_CONFIG_MAX_LINE];
+  FILE *file;
+  int number = 0;
+  int result = 0;
+
+  if (error_line) {
+    *error_line = 0;
+  }
+  if (config == NULL || path == NULL) {
+    return -1;
+  }
+  file = fopen(path, "r");
+  if (file == NULL) {
+    return -4;
+  }
+
+  parking_config_default(config);
+  while (result == 0 && fgets(line, sizeof(line), file) != NULL) {
+    number++;
+    /* 没有读到换行符且未到文件末尾，说明这一行超长 */
+    if (strchr(line, '\n') == NULL && !feof(file)) {
+      result = -2;
+    } else if (apply_line(config, line) != 0) {
+      result = -2;
+    }
+  }
+  if (result == 0 && ferror(file)) {
+    result = -4;
+  }
+  fclose(file);
+
+  if (result == -2 && error_line) {
+    *error_line = number;
+  }
+  if (result == 0 && parking_config_compile(config) != 0) {
+    result = -3;
+  }
+  return result;
+}
@@ -0,0 +1,108 @@
+#ifndef PARKING_CONFIG_H
+#define PARKING_CONFIG_H
+
+#include "parking_tariff.h"
+
+/**
+ * @file parking_config.h
+ * @brief 停车场运行时配置的声明。
+ * @details
+ * 运行时配置汇集了原先只能在编译期修改的场地参数：访客允许入场的时段
+ * 与费率表。配置文件为逐行的 `键 = 值` 文本，`#` 开头的行与空行忽略，
+ * 未出现的键保持默认值。支持的键：
+ *
+ * - visitor_start_hour：访客允许入场的最早小时，默认 9；
+ * - visitor_end_hour：访客允许入场的最晚小时（不含），默认 17；
+ * - first_hour_cents、hourly_cents、night_hourly_cents：访客首小时、
+ *   日间与夜间每小时价格（分），默认均为 1000；
+ * - night_start_hour、night_end_hour：夜间时段，默认 0 与 0（无夜间时段）；
+ * - daily_cap_cents：每日封顶价格（分），默认 0（不封顶）；
+ * - resident_monthly_cents：居民月费（分），默认 20000；
+ * - resident_period_days：居民月费改为按固定天数的周期计费；
+ *   未设置时按自然月计费。
+ *
+ * 配置经 parking_config_compile 校验并编译费率表后即为只读对象，
+ * 由数据层整体发布到停车场上，见 publish_parking_config。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_CONFIG_MAX_LINE 256 /**< 配置文件单行的最大字节数 */
+#define PARKING_CONFIG_DEFAULT_START_HOUR 9 /**< 默认访客入场最早小时 */
+#define PARKING_CONFIG_DEFAULT_END_HOUR 17  /**< 默认访客入场最晚小时（不含） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 停车场的运行时配置。
+ * @details 发布到停车场后不再修改；需要改动时复制一份、修改后重新发布。
+ */
+typedef struct ParkingConfig {
+  int visitor_start_hour; /**< 访客允许入场的最早小时（24 小时制）。 */
+  int visitor_end_hour;   /**< 访客允许入场的最晚小时（不含）。 */
+  TariffConfig tariff;    /**< 费率配置。 */
+  ParkingTariff fees;     /**< 由 tariff 编译得到的费率表。 */
+  struct ParkingConfig *retired_next; /**< 被替换后在待回收链表中的下一项。 */
+} ParkingConfig;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 把配置设为默认值并编译费率表。
+ * @param config 目标配置。
+ */
+void parking_config_default(ParkingConfig *config);
+
+/**
+ * @brief 校验配置并按 tariff 重新编译费率表。
+ * @param config 目标配置。
+ * @return 成功返回 0；访客时段或费率配置无效返回 -1，此时 fees 不变。
+ */
+int parking_config_compile(ParkingConfig *config);
+
+/**
+ * @brief 按键名设置一项配置。
+ * @details 只修改对应字段，不重新编译费率表。
+ * @param config 目标配置。
+ * @param key 键名。
+ * @param value 十进制整数文本，允许首尾空白。
+ * @return 成功返回 0，未知的键返回 -1，值不是整数或超出范围返回 -2。
+ */
+int parking_config_set(ParkingConfig *config, const char *key,
+                       const char *value);
+
+/**
+ * @brief 解析配置文本并覆盖对应的配置项，最后编译费率表。
+ * @param config 目标配置，未出现的键保持原值。
+ * @param text 以换行符分隔的配置文本。
+ * @param[out] error_line 出错时接收行号（1 起），可以为 NULL。
+ * @return 成功返回 0；参数无效返回 -1；某一行无法解析返回 -2；
+ *         各项单独有效但组合无效返回 -3（error_line 为 0）。
+ */
+int parking_config_parse(ParkingConfig *config, const char *text,
+                         int *error_line);
+
+/**
+ * @brief 从默认值出发读取配置文件。
+ * @param config 接收配置。
+ * @param path 配置文件路径。
+ * @param[out] error_line 出错时接收行号（1 起），可以为 NULL。
+ * @return 成功返回 0；参数无效返回 -1；某一行无法解析返回 -2；
+ *         组合无效返回 -3；文件无法打开或读取失败返回 -4。
+ */
+int parking_config_load(ParkingConfig *config, const char *path,
+                        int *error_line);
+
+#endif /* PARKING_CONFIG_H */
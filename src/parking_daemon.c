@@ -0,0 +1,1306 @@
+/**
+ * @file parking_daemon.c
+ * @brief 网络服务实现文件
+ * @details
+ * 该文件实现了 parking_daemon.h 中声明的行协议与事件循环。
+ * 所有连接由同一个线程服务：套接字为非阻塞模式，读到的数据中每一个完整的
+ * 请求行立即执行，响应直接写入该连接的输出缓冲区；每轮事件处理完毕后
+ * 每个连接只 send 一次，流水线上的多个请求因此合并为一次写出。
+ * 车位记录在查找所在的读锁内直接从存储序列化到输出缓冲区。
+ * 事件等待在 Linux 上使用 epoll，其他平台退回 select；两者只在
+ * backend_* 几个函数中有区别。
+ */
+
+#ifdef _WIN32
+#define FD_SETSIZE (PARKING_DAEMON_MAX_CLIENTS + 1)
+#else
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_daemon.h"
+#include "parking_dedup.h"
+#include "parking_service.h"
+#include "parking_thread.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#define DAEMON_USE_EPOLL 1
+#include <sys/epoll.h>
+#endif
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#ifdef _WIN32
+typedef SOCKET DaemonSocket;                 /**< 平台套接字类型 */
+typedef int DaemonSocklen;                   /**< 地址长度类型 */
+#define DAEMON_INVALID_SOCKET INVALID_SOCKET /**< 无效套接字 */
+#define DAEMON_SEND_FLAGS 0                  /**< send 的附加标志 */
+#else
+typedef int DaemonSocket;          /**< 平台套接字类型 */
+typedef socklen_t DaemonSocklen;   /**< 地址长度类型 */
+#define DAEMON_INVALID_SOCKET (-1) /**< 无效套接字 */
+#ifdef MSG_NOSIGNAL
+#define DAEMON_SEND_FLAGS MSG_NOSIGNAL /**< 对端关闭时不触发 SIGPIPE */
+#else
+#define DAEMON_SEND_FLAGS 0 /**< send 的附加标志 */
+#endif
+#endif
+
+#define DAEMON_MAX_FIELDS 8        /**< 一行请求中 id 之后的最多字段数 */
+#define DAEMON_INPUT_BYTES 16384   /**< 每个连接的输入缓冲区字节数 */
+#define DAEMON_OUTPUT_INITIAL 4096 /**< 输出缓冲区的初始字节数 */
+#define DAEMON_MAX_EVENTS 64       /**< 每次等待最多取回的事件数 */
+#define DAEMON_POLL_MS 200         /**< 等待事件时检查停止标志的间隔 */
+
+/**
+ * @brief 一行响应的构造位置。
+ */
+typedef struct DaemonReply {
+  char *data;  /**< 目标缓冲区（PARKING_DAEMON_MAX_REPLY 字节）。 */
+  size_t used; /**< 已写入的字节数。 */
+} DaemonReply;
+
+/**
+ * @brief 命令处理函数。
+ * @param lot 目标停车场。
+ * @param args 命令之后的参数，个数与命令表一致。
+ * @param out 追加结果字段的位置。
+ * @return 状态码。
+ */
+typedef ParkingServiceResultCode (*DaemonHandler)(ParkingLot *lot,
+                                                  char **args,
+                                                  DaemonReply *out);
+
+/**
+ * @brief 命令表中的一项。
+ */
+typedef struct DaemonCommand {
+  const char *name;      /**< 命令名，与服务层函数名去掉前缀后相同。 */
+  int argc;              /**< 参数个数。 */
+  int mutates;           /**< 非 0 表示修改停车场，按请求 id 去重。 */
+  DaemonHandler handler; /**< 处理函数。 */
+} DaemonCommand;
+
+/**
+ * @brief 一个客户端连接。
+ */
+typedef struct DaemonClient {
+  DaemonSocket socket;            /**< 连接的套接字。 */
+  int index;                      /**< 在连接表中的位置。 */
+  int closed;                     /**< 非 0 表示本轮事件处理后关闭。 */
+  int eof;                        /**< 非 0 表示对端已关闭写方向。 */
+  unsigned int interest;          /**< 已登记的关注事件（epoll）。 */
+  char input[DAEMON_INPUT_BYTES]; /**< 尚未处理的输入。 */
+  size_t input_used;              /**< input 中的字节数。 */
+  char *output;                   /**< 尚未发出的响应。 */
+  size_t output_used;             /**< output 中的字节数。 */
+  size_t output_sent;             /**< output 中已发出的字节数。 */
+  size_t output_capacity;         /**< output 的容量。 */
+} DaemonClient;
+
+/**
+ * @brief 一次等待取回的事件。
+ */
+typedef struct DaemonEvent {
+  DaemonClient *client; /**< 发生事件的连接，为 NULL 表示监听套接字可读。 */
+  int readable;         /**< 非 0 表示可读。 */
+  int writable;         /**< 非 0 表示可写。 */
+} DaemonEvent;
+
+/**
+ * @brief 正在运行的网络服务。
+ */
+struct ParkingDaemon {
+  ParkingLot *lot;       /**< 服务的停车场，按站点服务时为 NULL。 */
+  ParkingRegistry *registry; /**< 按站点服务时的注册表，否则为 NULL。 */
+  DaemonSocket listener; /**< 监听套接字。 */
+  int port;              /**< 实际监听的端口。 */
+  ParkingThread *thread; /**< 事件循环线程。 */
+  volatile int stopping; /**< 非 0 时事件循环退出。 */
+  volatile int client_count; /**< 当前的连接数。 */
+#ifdef DAEMON_USE_EPOLL
+  int epoll_fd; /**< epoll 实例。 */
+#endif
+  DaemonClient *clients[PARKING_DAEMON_MAX_CLIENTS]; /**< 连接表。 */
+};
+
+#define DAEMON_WANT_READ 1u  /**< 关注可读 */
+#define DAEMON_WANT_WRITE 2u /**< 关注可写 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/* -------------------------------------------------------------------------- */
+/*                                  行协议                                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 追加一段文本，超出响应上限的部分截断。
+ * @param out 目标位置。
+ * @param text 文本。
+ */
+static void reply_put(DaemonReply *out, const char *text) {
+  size_t length = strlen(text);
+  size_t room = PARKING_DAEMON_MAX_REPLY - 1 - out->used;
+
+  if (length > room) {
+    length = room;
+  }
+  memcpy(out->data + out->used, text, length);
+  out->used += length;
+}
+
+/**
+ * @brief (静态辅助函数) 追加一个以制表符开头的文本字段。
+ * @param out 目标位置。
+ * @param text 字段文本。
+ */
+static void reply_field(DaemonReply *out, const char *text) {
+  reply_put(out, "\t");
+  reply_put(out, text);
+}
+
+/**
+ * @brief (静态辅助函数) 追加一个以制表符开头的整数字段。
+ * @param out 目标位置。
+ * @param value 字段值。
+ */
+static void reply_long(DaemonReply *out, long value) {
+  char digits[24];
+
+  sprintf(digits, "\t%ld", value);
+  reply_put(out, digits);
+}
+
+/**
+ * @brief (静态辅助函数) 追加一个以制表符开头的时间戳字段。
+ * @details 直接对 time_t 逐位取余，time_t 为 64 位而 long 为 32 位时也不截断。
+ * @param out 目标位置。
+ * @param value 时间戳。
+ */
+static void reply_time(DaemonReply *out, time_t value) {
+  char digits[24];
+  char text[26];
+  int count = 0;
+  int length = 0;
+  int negative = value < 0;
+
+  do {
+    int digit = (int)(value % 10);
+
+    digits[count++] = (char)('0' + (digit < 0 ? -digit : digit));
+    value /= 10;
+  } while (value != 0);
+  text[length++] = '\t';
+  if (negative) {
+    text[length++] = '-';
+  }
+  while (count > 0) {
+    text[length++] = digits[--count];
+  }
+  text[length] = '\0';
+  reply_put(out, text);
+}
+
+/**
+ * @brief (静态辅助函数) 解析十进制车位编号。
+ * @param text 字段文本。
+ * @param[out] value 接收编号。
+ * @return 整个字段都是整数时返回 1，否则返回 0（范围由服务层校验）。
+ */
+static int parse_slot_id(const char *text, int *value) {
+  char *end;
+  long parsed;
+
+  errno = 0;
+  parsed = strtol(text, &end, 10);
+  if (end == text || *end != '\0' || errno != 0 || parsed < 0 ||
+      parsed > 2147483647L) {
+    return 0;
+  }
+  *value = (int)parsed;
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 解析停车类型。
+ * @param text "resident" 或 "visitor"。
+ * @param[out] type 接收停车类型。
+ * @return 有效返回 1，否则返回 0。
+ */
+static int parse_type(const char *text, ParkingType *type) {
+  if (strcmp(text, "resident") == 0) {
+    *type = RESIDENT_TYPE;
+    return 1;
+  }
+  if (strcmp(text, "visitor") == 0) {
+    *type = VISITOR_TYPE;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 车位访问函数：直接从车位记录写出全部字段。
+ * @details 由 parking_service_fast_visit_slot_by_* 在查找所在的读锁内调用，
+ *          查找与序列化只加锁一次，也不经过中间副本。
+ * @param slot 找到的车位。
+ * @param ctx 目标 DaemonReply。
+ * @return 始终返回 0。
+ */
+static int reply_slot(ParkingSlot *slot, void *ctx) {
+  DaemonReply *out = (DaemonReply *)ctx;
+
+  reply_long(out, slot->slot_id);
+  reply_field(out, slot->location);
+  reply_field(out, slot->status == OCCUPIED_STATUS ? "occupied" : "free");
+  reply_field(out, slot->type == VISITOR_TYPE ? "visitor" : "resident");
+  reply_field(out, slot->owner_name);
+  reply_field(out, slot->license_plate);
+  reply_field(out, slot->contact);
+  reply_time(out, slot->entry_time);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) ping：不访问停车场，用于探测连接与测量往返时间。
+ */
+static ParkingServiceResultCode handle_ping(ParkingLot *lot, char **args,
+                                            DaemonReply *out) {
+  (void)lot;
+  (void)args;
+  (void)out;
+  return PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief (静态辅助函数) add_slot：对应 parking_service_fast_add_slot。
+ */
+static ParkingServiceResultCode handle_add_slot(ParkingLot *lot, char **args,
+                                                DaemonReply *out) {
+  int slot_id;
+
+  (void)out;
+  if (!parse_slot_id(args[0], &slot_id)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  return parking_service_fast_add_slot(lot, slot_id, args[1]);
+}
+
+/**
+ * @brief (静态辅助函数) allocate_slot：对应 parking_service_fast_allocate_slot。
+ */
+static ParkingServiceResultCode
+handle_allocate_slot(ParkingLot *lot, char **args, DaemonReply *out) {
+  ParkingType type;
+  int slot_id;
+
+  (void)out;
+  if (!parse_slot_id(args[0], &slot_id) || !parse_type(args[4], &type)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  return parking_service_fast_allocate_slot(lot, slot_id, args[1], args[2],
+                                            args[3], type);
+}
+
+/**
+ * @brief (静态辅助函数) allocate_any_slot：对应
+ *        parking_service_fast_allocate_any_slot，结果为分到的车位编号。
+ */
+static ParkingServiceResultCode
+handle_allocate_any_slot(ParkingLot *lot, char **args, DaemonReply *out) {
+  ParkingServiceResultCode code;
+  ParkingType type;
+  int slot_id;
+
+  if (!parse_type(args[3], &type)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  code = parking_service_fast_allocate_any_slot(lot, args[0], args[1], args[2],
+                                                type, &slot_id);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    reply_long(out, slot_id);
+  }
+  return code;
+}
+
+/**
+ * @brief (静态辅助函数) deallocate_slot：对应
+ *        parking_service_fast_deallocate_slot，结果为计费明细。
+ */
+static ParkingServiceResultCode
+handle_deallocate_slot(ParkingLot *lot, char **args, DaemonReply *out) {
+  ParkingServiceResultCode code;
+  ExitReceipt receipt;
+  int slot_id;
+
+  if (!parse_slot_id(args[0], &slot_id)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  code = parking_service_fast_deallocate_slot(lot, slot_id, &receipt);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    reply_long(out, receipt.amount_cents);
+    reply_long(out, receipt.duration_seconds);
+    reply_long(out, receipt.billed_hours);
+    reply_long(out, receipt.overdue_months);
+  }
+  return code;
+}
+
+/**
+ * @brief (静态辅助函数) find_slot_by_id：对应
+ *        parking_service_fast_visit_slot_by_id，结果为车位的全部字段。
+ */
+static ParkingServiceResultCode
+handle_find_slot_by_id(ParkingLot *lot, char **args, DaemonReply *out) {
+  int slot_id;
+
+  if (!parse_slot_id(args[0], &slot_id)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  return parking_service_fast_visit_slot_by_id(lot, slot_id, reply_slot, out);
+}
+
+/**
+ * @brief (静态辅助函数) find_slot_by_license：对应
+ *        parking_service_fast_visit_slot_by_license，结果为车位的全部字段。
+ */
+static ParkingServiceResultCode
+handle_find_slot_by_license(ParkingLot *lot, char **args, DaemonReply *out) {
+  return parking_service_fast_visit_slot_by_license(lot, args[0], reply_slot,
+                                                    out);
+}
+
+/**
+ * @brief (静态辅助函数) get_statistics：对应
+ *        parking_service_fast_get_statistics，结果为总车位、已占用与空闲数。
+ */
+static ParkingServiceResultCode
+handle_get_statistics(ParkingLot *lot, char **args, DaemonReply *out) {
+  ParkingServiceResultCode code;
+  ParkingStatistics stats;
+
+  (void)args;
+  code = parking_service_fast_get_statistics(lot, &stats);
+  if (code == PARKING_SERVICE_SUCCESS) {
+    reply_long(out, stats.total_slots);
+    reply_long(out, stats.occupied_slots);
+    reply_long(out, stats.free_slots);
+  }
+  return code;
+}
+
+/** 命令表。 */
+static const DaemonCommand daemon_commands[] = {
+    {"ping", 0, 0, handle_ping},
+    {"add_slot", 2, 1, handle_add_slot},
+    {"allocate_slot", 5, 1, handle_allocate_slot},
+    {"allocate_any_slot", 4, 1, handle_allocate_any_slot},
+    {"deallocate_slot", 1, 1, handle_deallocate_slot},
+    {"find_slot_by_id", 1, 0, handle_find_slot_by_id},
+    {"find_slot_by_license", 1, 0, handle_find_slot_by_license},
+    {"get_statistics", 0, 0, handle_get_statistics}};
+
+/**
+ * @brief (静态辅助函数) 按制表符切分请求行。
+ * @param line 请求行，去掉结尾的 '\r' 后在原处切分。
+ * @param[out] fields 接收各字段的起始位置。
+ * @return 字段数；超过 DAEMON_MAX_FIELDS + 2 个时返回 DAEMON_MAX_FIELDS + 3。
+ */
+static int split_fields(char *line, char **fields) {
+  size_t length = strlen(line);
+  int count = 0;
+  char *p = line;
+
+  if (length > 0 && line[length - 1] == '\r') {
+    line[length - 1] = '\0';
+  }
+  if (*line == '\0') {
+    return 0;
+  }
+  for (;;) {
+    char *tab = strchr(p, '\t');
+
+    if (count == DAEMON_MAX_FIELDS + 2) {
+      return DAEMON_MAX_FIELDS + 3;
+    }
+    fields[count++] = p;
+    if (tab == NULL) {
+      return count;
+    }
+    *tab = '\0';
+    p = tab + 1;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 计算请求内容（命令与参数）的指纹（FNV-1a）。
+ * @details 字段之间计入一个分隔符，"a\tbc" 与 "ab\tc" 的指纹不同。
+ * @param fields 命令及其参数。
+ * @param count 字段数。
+ * @return 32 位指纹。
+ */
+static unsigned long request_fingerprint(char **fields, int count) {
+  unsigned long hash = 2166136261UL;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    const char *p = fields[i];
+
+    for (; *p != '\0'; p++) {
+      hash ^= (unsigned char)*p;
+      hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    hash ^= (unsigned char)'\t';
+    hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  return hash;
+}
+
+/**
+ * @brief (静态辅助函数) 执行一个命令；修改类命令先查请求去重表。
+ * @details 去重表中有同一 id、同一内容的请求时直接取回第一次的结果，
+ *          否则执行命令并把结果记入去重表。out 须为空，记录的是其全部内容。
+ * @param lot 目标停车场。
+ * @param command 命令。
+ * @param id 请求 id，NULL 表示请求没有可用的 id（不去重）。
+ * @param fields 命令及其参数。
+ * @param count 字段数。
+ * @param out 追加结果字段的位置。
+ * @return 状态码。
+ */
+static ParkingServiceResultCode run_command(ParkingLot *lot,
+                                            const DaemonCommand *command,
+                                            const char *id, char **fields,
+                                            int count, DaemonReply *out) {
+  ParkingServiceResultCode code;
+  unsigned long fingerprint;
+  int recorded;
+
+  if (!command->mutates || id == NULL || lot->request_log == NULL) {
+    return command->handler(lot, fields + 1, out);
+  }
+  fingerprint = request_fingerprint(fields, count);
+  if (request_log_find(lot->request_log, id, fingerprint, &recorded,
+                       out->data, &out->used)) {
+    return (ParkingServiceResultCode)recorded;
+  }
+  code = command->handler(lot, fields + 1, out);
+  request_log_record(lot->request_log, id, fingerprint, (int)code, out->data,
+                     out->used);
+  return code;
+}
+
+/**
+ * @brief (静态辅助函数) 生成只有状态码的响应行。
+ * @param id 请求 id，为空或过长时以 "-" 代替。
+ * @param code 状态码。
+ * @param[out] reply 接收响应行（PARKING_DAEMON_MAX_REPLY 字节）。
+ * @return 响应行的字节数。
+ */
+static size_t reply_status(const char *id, ParkingServiceResultCode code,
+                           char *reply) {
+  DaemonReply out;
+
+  out.data = reply;
+  out.used = 0;
+  reply_put(&out, id[0] == '\0' || strlen(id) > PARKING_DAEMON_MAX_ID ? "-"
+                                                                      : id);
+  reply_long(&out, (long)code);
+  out.data[out.used++] = '\n';
+  return out.used;
+}
+
+/**
+ * @brief (静态辅助函数) open_site：打开本节点上的站点，快照不存在时新建。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @param line 去掉站点字段之后的请求行。
+ * @param[out] reply 接收响应行。
+ * @return 响应行的字节数。
+ */
+static size_t open_site(ParkingRegistry *registry, const char *site_id,
+                        char *line, char *reply) {
+  char *fields[DAEMON_MAX_FIELDS + 3];
+  char path[PARKING_REGISTRY_MAX_PATH];
+  int count = split_fields(line, fields);
+  ParkingLot *lot;
+  int total_slots;
+
+  if (count != 3 || !parse_slot_id(fields[2], &total_slots) ||
+      parking_registry_site_path(registry, site_id, path) != 0) {
+    return reply_status(fields[0], PARKING_SERVICE_INVALID_PARAM, reply);
+  }
+  /* 正在迁走的站点不在原节点重新打开 */
+  switch (parking_registry_acquire(registry, site_id, &lot)) {
+  case 0:
+    parking_registry_release(registry, site_id);
+    return reply_status(fields[0], PARKING_SERVICE_SUCCESS, reply);
+  case -2:
+    return reply_status(fields[0], PARKING_SERVICE_BUSY, reply);
+  default:
+    break;
+  }
+  return reply_status(fields[0],
+                      parking_registry_open(registry, site_id, total_slots)
+                          ? PARKING_SERVICE_SUCCESS
+                          : PARKING_SERVICE_FILE_ERROR,
+                      reply);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  套接字                                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 关闭套接字。
+ * @param socket_fd 套接字。
+ */
+static void close_socket(DaemonSocket socket_fd) {
+#ifdef _WIN32
+  closesocket(socket_fd);
+#else
+  close(socket_fd);
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 把套接字设为非阻塞模式。
+ * @param socket_fd 套接字。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int set_nonblocking(DaemonSocket socket_fd) {
+#ifdef _WIN32
+  u_long mode = 1;
+
+  return ioctlsocket(socket_fd, FIONBIO, &mode) == 0 ? 0 : -1;
+#else
+  int flags = fcntl(socket_fd, F_GETFL, 0);
+
+  return flags >= 0 && fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK) == 0
+             ? 0
+             : -1;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 判断上一次套接字调用是否只是暂时无法完成。
+ * @return 需要稍后重试返回 1，否则返回 0。
+ */
+static int would_block(void) {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 创建、绑定并监听非阻塞套接字。
+ * @param host 监听地址。
+ * @param port 监听端口。
+ * @param[out] bound_port 接收实际端口。
+ * @return 成功返回监听套接字，失败返回 DAEMON_INVALID_SOCKET。
+ */
+static DaemonSocket open_listener(const char *host, int port,
+                                  int *bound_port) {
+  struct sockaddr_in address;
+  DaemonSocklen address_length = (DaemonSocklen)sizeof(address);
+  DaemonSocket listener;
+  int reuse = 1;
+
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons((unsigned short)port);
+  if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+    return DAEMON_INVALID_SOCKET;
+  }
+  listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener == DAEMON_INVALID_SOCKET) {
+    return DAEMON_INVALID_SOCKET;
+  }
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse,
+             sizeof(reuse));
+  if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(listener, 128) != 0 ||
+      getsockname(listener, (struct sockaddr *)&address, &address_length) !=
+          0 ||
+      set_nonblocking(listener) != 0) {
+    close_socket(listener);
+    return DAEMON_INVALID_SOCKET;
+  }
+  *bound_port = ntohs(address.sin_port);
+  return listener;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 事件等待                                   */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 计算连接当前应关注的事件。
+ * @details 有未发出的响应时关注可写；未发出的响应未达上限时才关注可读，
+ *          以此对只发不收的客户端施加背压。
+ * @param client 连接。
+ * @return DAEMON_WANT_READ 与 DAEMON_WANT_WRITE 的组合。
+ */
+static unsigned int client_interest(const DaemonClient *client) {
+  size_t pending = client->output_used - client->output_sent;
+  unsigned int interest = 0;
+
+  if (!client->eof && pending < PARKING_DAEMON_OUTPUT_LIMIT) {
+    interest |= DAEMON_WANT_READ;
+  }
+  if (pending > 0) {
+    interest |= DAEMON_WANT_WRITE;
+  }
+  return interest;
+}
+
+/**
+ * @brief (静态辅助函数) 初始化事件等待机制并登记监听套接字。
+ * @param daemon 网络服务。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int backend_open(ParkingDaemon *daemon) {
+#ifdef DAEMON_USE_EPOLL
+  struct epoll_event event;
+
+  daemon->epoll_fd = epoll_create(PARKING_DAEMON_MAX_CLIENTS);
+  if (daemon->epoll_fd < 0) {
+    return -1;
+  }
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.ptr = NULL;
+  if (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, daemon->listener, &event) !=
+      0) {
+    close(daemon->epoll_fd);
+    return -1;
+  }
+#else
+  (void)daemon;
+#endif
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 释放事件等待机制。
+ * @param daemon 网络服务。
+ */
+static void backend_close(ParkingDaemon *daemon) {
+#ifdef DAEMON_USE_EPOLL
+  close(daemon->epoll_fd);
+#else
+  (void)daemon;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 登记或更新连接关注的事件。
+ * @details select 每轮按 client_interest 重新构造集合，无需登记。
+ * @param daemon 网络服务。
+ * @param client 连接。
+ * @param added 非 0 表示新连接。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int backend_watch(ParkingDaemon *daemon, DaemonClient *client,
+                         int added) {
+  unsigned int interest = client_interest(client);
+#ifdef DAEMON_USE_EPOLL
+  struct epoll_event event;
+
+  if (!added && interest == client->interest) {
+    return 0;
+  }
+  memset(&event, 0, sizeof(event));
+  event.events = ((interest & DAEMON_WANT_READ) ? EPOLLIN : 0u) |
+                 ((interest & DAEMON_WANT_WRITE) ? EPOLLOUT : 0u);
+  event.data.ptr = client;
+  if (epoll_ctl(daemon->epoll_fd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                client->socket, &event) != 0) {
+    return -1;
+  }
+#else
+  (void)daemon;
+  (void)added;
+#endif
+  client->interest = interest;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 等待事件。
+ * @param daemon 网络服务。
+ * @param[out] events 接收事件，至少 DAEMON_MAX_EVENTS 项。
+ * @return 事件数；超时或被打断返回 0。
+ */
+static int backend_wait(ParkingDaemon *daemon, DaemonEvent *events) {
+#ifdef DAEMON_USE_EPOLL
+  struct epoll_event ready[DAEMON_MAX_EVENTS];
+  int count = epoll_wait(daemon->epoll_fd, ready, DAEMON_MAX_EVENTS,
+                         DAEMON_POLL_MS);
+  int i;
+
+  for (i = 0; i < count; i++) {
+    events[i].client = (DaemonClient *)ready[i].data.ptr;
+    events[i].readable =
+        (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
+    events[i].writable = (ready[i].events & EPOLLOUT) != 0;
+  }
+  return count < 0 ? 0 : count;
+#else
+  fd_set readable;
+  fd_set writable;
+  struct timeval timeout;
+  DaemonSocket highest = daemon->listener;
+  int count = 0;
+  int i;
+
+  FD_ZERO(&readable);
+  FD_ZERO(&writable);
+  FD_SET(daemon->listener, &readable);
+  for (i = 0; i < PARKING_DAEMON_MAX_CLIENTS; i++) {
+    DaemonClient *client = daemon->clients[i];
+
+    if (client == NULL) {
+      continue;
+    }
+    if (client->interest & DAEMON_WANT_READ) {
+      FD_SET(client->socket, &readable);
+    }
+    if (client->interest & DAEMON_WANT_WRITE) {
+      FD_SET(client->socket, &writable);
+    }
+    if (client->socket > highest) {
+      highest = client->socket;
+    }
+  }
+  timeout.tv_sec = DAEMON_POLL_MS / 1000;
+  timeout.tv_usec = (DAEMON_POLL_MS % 1000) * 1000;
+  if (select((int)highest + 1, &readable, &writable, NULL, &timeout) <= 0) {
+    return 0;
+  }
+
+  if (FD_ISSET(daemon->listener, &readable)) {
+    events[count].client = NULL;
+    events[count].readable = 1;
+    events[count].writable = 0;
+    count++;
+  }
+  for (i = 0; i < PARKING_DAEMON_MAX_CLIENTS && count < DAEMON_MAX_EVENTS;
+       i++) {
+    DaemonClient *client = daemon->clients[i];
+
+    if (client == NULL) {
+      continue;
+    }
+    events[count].client = client;
+    events[count].readable = FD_ISSET(client->socket, &readable) != 0;
+    events[count].writable = FD_ISSET(client->socket, &writable) != 0;
+    if (events[count].readable || events[count].writable) {
+      count++;
+    }
+  }
+  return count;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  连接处理                                  */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 执行输入缓冲区中的完整请求行。
+ * @details 待发送的响应达到 PARKING_DAEMON_OUTPUT_LIMIT 时停止，
+ *          剩余的请求留在输入缓冲区，等响应发出后继续。
+ * @param daemon 网络服务。
+ * @param client 连接。
+ * @return 成功返回 0；请求行过长或内存不足返回 -1。
+ */
+static int client_process(ParkingDaemon *daemon, DaemonClient *client) {
+  size_t offset = 0;
+
+  if (client->output_sent > 0) {
+    memmove(client->output, client->output + client->output_sent,
+            client->output_used - client->output_sent);
+    client->output_used -= client->output_sent;
+    client->output_sent = 0;
+  }
+
+  while (client->output_used < PARKING_DAEMON_OUTPUT_LIMIT) {
+    char *line = client->input + offset;
+    char *end = (char *)memchr(line, '\n', client->input_used - offset);
+
+    if (end == NULL) {
+      if (client->input_used - offset > PARKING_DAEMON_MAX_LINE + 1) {
+        return -1;
+      }
+      break;
+    }
+    if ((size_t)(end - line) > PARKING_DAEMON_MAX_LINE + 1) {
+      return -1;
+    }
+    if (client->output_used + PARKING_DAEMON_MAX_REPLY >
+        client->output_capacity) {
+      size_t capacity = client->output_capacity * 2;
+      char *grown = (char *)realloc(client->output, capacity);
+
+      if (grown == NULL) {
+        return -1;
+      }
+      client->output = grown;
+      client->output_capacity = capacity;
+    }
+    *end = '\0';
+    client->output_used +=
+        daemon->registry != NULL
+            ? parking_daemon_execute_site(daemon->registry, line,
+                                          client->output + client->output_used)
+            : parking_daemon_execute(daemon->lot, line,
+                                     client->output + client->output_used);
+    offset = (size_t)(end - client->input) + 1;
+  }
+
+  memmove(client->input, client->input + offset, client->input_used - offset);
+  client->input_used -= offset;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 尽量写出待发送的响应。
+ * @param client 连接。
+ * @return 成功（含暂时写不出）返回 0，连接失效返回 -1。
+ */
+static int client_flush(DaemonClient *client) {
+  while (client->output_sent < client->output_used) {
+    int sent = (int)send(client->socket, client->output + client->output_sent,
+                         (int)(client->output_used - client->output_sent),
+                         DAEMON_SEND_FLAGS);
+
+    if (sent < 0) {
+      return would_block() ? 0 : -1;
+    }
+    client->output_sent += (size_t)sent;
+  }
+  client->output_used = 0;
+  client->output_sent = 0;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 读取连接上已到达的全部数据并执行其中的请求。
+ * @details 反复 recv 直到暂时无数据、输入缓冲区已满或待发送的响应达到上限，
+ *          每读一次就执行其中的完整请求行；响应留在输出缓冲区，
+ *          由 client_finish 在本轮末尾统一写出。
+ *          对端关闭写方向后已收到的请求仍会执行并回复。
+ * @param daemon 网络服务。
+ * @param client 连接。
+ * @return 成功返回 0；连接出错、请求行过长或内存不足返回 -1。
+ */
+static int client_receive(ParkingDaemon *daemon, DaemonClient *client) {
+  while (!client->eof && client->input_used < DAEMON_INPUT_BYTES &&
+         client->output_used - client->output_sent <
+             PARKING_DAEMON_OUTPUT_LIMIT) {
+    int got = (int)recv(client->socket, client->input + client->input_used,
+                        (int)(DAEMON_INPUT_BYTES - client->input_used), 0);
+
+    if (got < 0) {
+      return would_block() ? 0 : -1;
+    }
+    if (got == 0) {
+      client->eof = 1;
+    }
+    client->input_used += (size_t)got;
+    if (client_process(daemon, client) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 本轮末尾写出连接的全部响应，并更新关注的事件。
+ * @details 每个连接每轮只调用一次，一轮中执行的全部请求的响应合并为一次
+ *          send。写出后若不再受背压限制，继续执行此前留下的请求，
+ *          它们的响应在下一轮写出。
+ * @param daemon 网络服务。
+ * @param client 连接。
+ * @return 连接仍然有效返回 0；需要关闭（出错，或对端已关闭且响应已全部
+ *         写出）返回 -1。
+ */
+static int client_finish(ParkingDaemon *daemon, DaemonClient *client) {
+  if (client_flush(client) != 0) {
+    return -1;
+  }
+  if (client->output_used == 0 && client_process(daemon, client) != 0) {
+    return -1;
+  }
+  if (client->eof && client->output_used == 0 &&
+      memchr(client->input, '\n', client->input_used) == NULL) {
+    return -1;
+  }
+  return backend_watch(daemon, client, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 接受一个新连接。
+ * @param daemon 网络服务。
+ * @return 取到了连接（无论是否接受）返回 1，暂无新连接返回 0。
+ */
+static int accept_client(ParkingDaemon *daemon) {
+  DaemonSocket socket_fd = accept(daemon->listener, NULL, NULL);
+  DaemonClient *client = NULL;
+  int nodelay = 1;
+  int i;
+
+  if (socket_fd == DAEMON_INVALID_SOCKET) {
+    return 0;
+  }
+  for (i = 0; i < PARKING_DAEMON_MAX_CLIENTS; i++) {
+    if (daemon->clients[i] == NULL) {
+      break;
+    }
+  }
+  if (i < PARKING_DAEMON_MAX_CLIENTS && set_nonblocking(socket_fd) == 0) {
+    client = (DaemonClient *)malloc(sizeof(DaemonClient));
+  }
+  if (client != NULL) {
+    client->output = (char *)malloc(DAEMON_OUTPUT_INITIAL);
+    if (client->output == NULL) {
+      free(client);
+      client = NULL;
+    }
+  }
+  if (client == NULL) {
+    close_socket(socket_fd);
+    return 1;
+  }
+  setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay,
+             sizeof(nodelay));
+  client->socket = socket_fd;
+  client->index = i;
+  client->closed = 0;
+  client->eof = 0;
+  client->interest = 0;
+  client->input_used = 0;
+  client->output_used = 0;
+  client->output_sent = 0;
+  client->output_capacity = DAEMON_OUTPUT_INITIAL;
+  if (backend_watch(daemon, client, 1) != 0) {
+    free(client->output);
+    free(client);
+    close_socket(socket_fd);
+    return 1;
+  }
+  daemon->clients[i] = client;
+  parking_atomic_add_int(&daemon->client_count, 1);
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 关闭连接并释放其资源。
+ * @details 关闭套接字会自动把它从 epoll 中移除。
+ * @param daemon 网络服务。
+ * @param client 连接。
+ */
+static void close_client(ParkingDaemon *daemon, DaemonClient *client) {
+  daemon->clients[client->index] = NULL;
+  close_socket(client->socket);
+  free(client->output);
+  free(client);
+  parking_atomic_add_int(&daemon->client_count, -1);
+}
+
+/**
+ * @brief (静态辅助函数) 事件循环线程入口。
+ * @details 每轮先读取并执行所有就绪连接上的请求，再逐个连接写出响应；
+ *          失效的连接先只做标记，本轮结束时再关闭，
+ *          同一批中后面的事件因此不会访问已释放的连接。
+ * @param arg 网络服务。
+ */
+static void daemon_loop(void *arg) {
+  ParkingDaemon *daemon = (ParkingDaemon *)arg;
+  DaemonEvent events[DAEMON_MAX_EVENTS];
+  int count;
+  int i;
+
+  while (!parking_atomic_load_int(&daemon->stopping)) {
+    count = backend_wait(daemon, events);
+    for (i = 0; i < count; i++) {
+      DaemonClient *client = events[i].client;
+
+      if (client == NULL) {
+        while (accept_client(daemon)) {
+        }
+      } else if (events[i].readable && client_receive(daemon, client) != 0) {
+        client->closed = 1;
+      }
+    }
+    for (i = 0; i < count; i++) {
+      DaemonClient *client = events[i].client;
+
+      if (client != NULL && !client->closed &&
+          client_finish(daemon, client) != 0) {
+        client->closed = 1;
+      }
+    }
+    for (i = 0; i < count; i++) {
+      if (events[i].client != NULL && events[i].client->closed &&
+          daemon->clients[events[i].client->index] == events[i].client) {
+        close_client(daemon, events[i].client);
+      }
+    }
+  }
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 执行一行请求并生成响应行。
+ * @param lot 目标停车场。
+ * @param line 请求行（不含行尾），函数会在原处切分字段。
+ * @param[out] reply 接收以 "\n" 结尾的响应行，至少 PARKING_DAEMON_MAX_REPLY 字节。
+ * @return 响应行的字节数。
+ */
+size_t parking_daemon_execute(ParkingLot *lot, char *line, char *reply) {
+  char *fields[DAEMON_MAX_FIELDS + 3];
+  char results[PARKING_DAEMON_MAX_REPLY];
+  DaemonReply out;
+  DaemonReply extra;
+  ParkingServiceResultCode code = PARKING_SERVICE_INVALID_PARAM;
+  int count = split_fields(line, fields);
+  const char *id;
+  size_t i;
+
+  out.data = reply;
+  out.used = 0;
+  extra.data = results;
+  extra.used = 0;
+
+  if (count == 0 || fields[0][0] == '\0' ||
+      strlen(fields[0]) > PARKING_DAEMON_MAX_ID) {
+    reply_put(&out, "-");
+    id = NULL;
+  } else {
+    reply_put(&out, fields[0]);
+    id = fields[0];
+  }
+  if (count >= 2 && lot != NULL) {
+    for (i = 0; i < sizeof(daemon_commands) / sizeof(daemon_commands[0]);
+         i++) {
+      if (strcmp(fields[1], daemon_commands[i].name) == 0) {
+        if (count - 2 == daemon_commands[i].argc) {
+          code = run_command(lot, &daemon_commands[i], id, fields + 1,
+                             count - 1, &extra);
+        }
+        break;
+      }
+    }
+  }
+
+  reply_long(&out, (long)code);
+  results[extra.used] = '\0';
+  reply_put(&out, results);
+  out.data[out.used++] = '\n';
+  return out.used;
+}
+
+/**
+ * @brief 按站点执行一行请求并生成响应行。
+ * @param registry 注册表。
+ * @param line 请求行（不含行尾），函数会在原处去掉站点字段并切分。
+ * @param[out] reply 接收以 "\n" 结尾的响应行。
+ * @return 响应行的字节数。
+ */
+size_t parking_daemon_execute_site(ParkingRegistry *registry, char *line,
+                                   char *reply) {
+  char site_id[PARKING_REGISTRY_MAX_SITE_ID + 1];
+  char *site = strchr(line, '\t');
+  char *command = site != NULL ? strchr(site + 1, '\t') : NULL;
+  ParkingLot *lot;
+  size_t length;
+  int pinned;
+
+  length = command != NULL ? (size_t)(command - site - 1) : 0;
+  if (registry == NULL || length == 0 ||
+      length > PARKING_REGISTRY_MAX_SITE_ID) {
+    if (site != NULL) {
+      *site = '\0'; /* 只留下 id，按缺少命令回复 */
+    }
+    return parking_daemon_execute(NULL, line, reply);
+  }
+  memcpy(site_id, site + 1, length);
+  site_id[length] = '\0';
+  /* 去掉站点字段，其余部分就是单个停车场的请求行 */
+  memmove(site + 1, command + 1, strlen(command + 1) + 1);
+
+  if (strncmp(site + 1, "open_site", 9) == 0 &&
+      (site[10] == '\t' || site[10] == '\0' || site[10] == '\r')) {
+    return open_site(registry, site_id, line, reply);
+  }
+  /* 执行期间借出站点，迁移站点的线程等本次请求结束后才释放停车场 */
+  pinned = parking_registry_acquire(registry, site_id, &lot);
+  if (pinned != 0) {
+    *site = '\0';
+    return reply_status(line,
+                        pinned == -2 ? PARKING_SERVICE_BUSY
+                                     : PARKING_SERVICE_SLOT_NOT_FOUND,
+                        reply);
+  }
+  length = parking_daemon_execute(lot, line, reply);
+  parking_registry_release(registry, site_id);
+  return length;
+}
+
+/**
+ * @brief (静态辅助函数) 启动网络服务，在后台线程中运行事件循环。
+ * @param lot 要服务的停车场，按站点服务时为 NULL。
+ * @param registry 按站点服务时的注册表，否则为 NULL。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配。
+ * @return 成功返回服务句柄，失败返回 NULL。
+ */
+static ParkingDaemon *start_daemon(ParkingLot *lot, ParkingRegistry *registry,
+                                   const char *host, int port) {
+  ParkingDaemon *daemon;
+#ifdef _WIN32
+  WSADATA wsa;
+#endif
+
+  if ((lot == NULL && registry == NULL) || port < 0 || port > 65535) {
+    return NULL;
+  }
+#ifdef _WIN32
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+    return NULL;
+  }
+#endif
+  daemon = (ParkingDaemon *)calloc(1, sizeof(ParkingDaemon));
+  if (daemon != NULL) {
+    daemon->lot = lot;
+    daemon->registry = registry;
+    daemon->listener =
+        open_listener(host ? host : "127.0.0.1", port, &daemon->port);
+    if (daemon->listener == DAEMON_INVALID_SOCKET) {
+      free(daemon);
+      daemon = NULL;
+    } else if (backend_open(daemon) != 0) {
+      close_socket(daemon->listener);
+      free(daemon);
+      daemon = NULL;
+    }
+  }
+  if (daemon != NULL) {
+    daemon->thread = parking_thread_start(daemon_loop, daemon);
+    if (daemon->thread == NULL) {
+      backend_close(daemon);
+      close_socket(daemon->listener);
+      free(daemon);
+      daemon = NULL;
+    }
+  }
+#ifdef _WIN32
+  if (daemon == NULL) {
+    WSACleanup();
+  }
+#endif
+  return daemon;
+}
+
+/**
+ * @brief 启动网络服务，在后台线程中运行事件循环。
+ * @param lot 要服务的停车场。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配。
+ * @return 成功返回服务句柄，失败返回 NULL。
+ */
+ParkingDaemon *parking_daemon_start(ParkingLot *lot, const char *host,
+                                    int port) {
+  if (lot == NULL) {
+    return NULL;
+  }
+  return start_daemon(lot, NULL, host, port);
+}
+
+/**
+ * @brief 启动按站点服务注册表的网络服务。
+ * @param registry 要服务的注册表。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配。
+ * @return 成功返回服务句柄，失败返回 NULL。
+ */
+ParkingDaemon *parking_daemon_start_registry(ParkingRegistry *registry,
+                                             const char *host, int port) {
+  if (registry == NULL) {
+    return NULL;
+  }
+  return start_daemon(NULL, registry, host, port);
+}
+
+/**
+ * @brief 查询网络服务实际监听的端口。
+ * @param daemon 服务句柄。
+ * @return 端口号；daemon 为 NULL 时返回 0。
+ */
+int parking_daemon_port(const ParkingDaemon *daemon) {
+  return daemon != NULL ? daemon->port : 0;
+}
+
+/**
+ * @brief 查询当前的连接数。
+ * @param daemon 服务句柄。
+ * @return 连接数；daemon 为 NULL 时返回 0。
+ */
+int parking_daemon_clients(const ParkingDaemon *daemon) {
+  return daemon != NULL ? parking_atomic_load_int(&daemon->client_count) : 0;
+}
+
+/**
+ * @brief 停止网络服务、断开全部连接并释放句柄。
+ * @param daemon 服务句柄，可以为 NULL。
+ */
+void parking_daemon_stop(ParkingDaemon *daemon) {
+  int i;
+
+  if (daemon == NULL) {
+    return;
+  }
+  parking_atomic_store_int(&daemon->stopping, 1);
+  parking_thread_join(daemon->thread);
+  for (i = 0; i < PARKING_DAEMON_MAX_CLIENTS; i++) {
+    if (daemon->clients[i] != NULL) {
+      close_client(daemon, daemon->clients[i]);
+    }
+  }
+  backend_close(daemon);
+  close_socket(daemon->listener);
+  free(daemon);
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
@@ -0,0 +1,158 @@
+#ifndef PARKING_DAEMON_H
+#define PARKING_DAEMON_H
+
+#include <stddef.h>
+
+#include "parking_data.h"
+#include "parking_registry.h"
+
+/**
+ * @file parking_daemon.h
+ * @brief 面向闸机控制器的网络服务接口声明。
+ * @details
+ * 服务以单线程事件循环（Linux 上为 epoll，其他平台为 select）接受 TCP
+ * 连接，按行读取请求，每个命令一一对应一个 parking_service_fast_* 调用。
+ *
+ * 请求与响应各占一行，字段以制表符分隔，行尾为 "\n"（请求也可以是 "\r\n"）：
+ * - 请求：<id> <命令> [参数...]
+ * - 响应：<id> <状态码> [结果字段...]
+ *
+ * id 由客户端任取（不含制表符，至多 PARKING_DAEMON_MAX_ID 字节），原样回显；
+ * 状态码为 ParkingServiceResultCode 的十进制值，0 表示成功。
+ * 一个连接可以连续发送多个请求而不必等待响应（流水线），
+ * 服务按收到的顺序执行并按同样的顺序回复；事件循环每一轮先读完每个就绪
+ * 连接上已到达的全部请求，再把同一连接的响应合并为一次写出。
+ * 某个连接未发出的响应超过 PARKING_DAEMON_OUTPUT_LIMIT 字节时暂停读取
+ * 该连接，直到对端取走响应。对端关闭写方向后，已收到的请求仍会回复。
+ *
+ * 命令与结果字段：
+ * | 命令                 | 参数                                   | 结果字段 |
+ * |----------------------|----------------------------------------|----------|
+ * | ping                 |                                        |          |
+ * | add_slot             | 车位编号 位置                          |          |
+ * | allocate_slot        | 车位编号 车主 车牌 联系方式 类型       |          |
+ * | allocate_any_slot    | 车主 车牌 联系方式 类型                | 车位编号 |
+ * | deallocate_slot      | 车位编号                               | 应缴金额（分） 停车秒数 计费小时 补缴月数 |
+ * | find_slot_by_id      | 车位编号                               | 车位     |
+ * | find_slot_by_license | 车牌                                   | 车位     |
+ * | get_statistics       |                                        | 总车位 已占用 空闲 |
+ *
+ * 类型为 resident 或 visitor。"车位" 依次为编号、位置、状态（free /
+ * occupied）、类型、车主、车牌、联系方式与入场时间（Unix 时间）。
+ * 未知命令或参数个数不符时返回 PARKING_SERVICE_INVALID_PARAM；
+ * 超过 PARKING_DAEMON_MAX_LINE 字节的请求行视为协议错误并断开连接。
+ *
+ * 停车场启用请求去重表（parking_service_configure_request_log）后，
+ * add_slot、allocate_slot、allocate_any_slot 与 deallocate_slot 按 id
+ * 记住结果：超时后以同一 id 重发同一请求，返回第一次执行的状态码与结果
+ * 字段，不会重复入场或出场。此时客户端须为每个新请求取不同的 id；
+ * 同一 id 的请求内容不同时按新请求执行。
+ *
+ * 以 parking_daemon_start_registry 启动时，一个服务托管注册表中的全部站点，
+ * 请求在 id 之后多一个站点编号字段：<id> <站点> <命令> [参数...]，响应格式
+ * 不变。站点未在本节点打开时返回 PARKING_SERVICE_SLOT_NOT_FOUND，正在
+ * 关闭（迁往其他节点）时返回 PARKING_SERVICE_BUSY，客户端稍后按新的环重试；
+ * 额外的 open_site 命令（参数为新建时的总车位数）打开站点，快照不存在时
+ * 新建。集群客户端（见 parking_cluster.h）按一致性哈希把请求发往站点
+ * 所在的节点。
+ * 该模块由 CMake 选项 PARKING_DAEMON 控制是否编入核心库。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_DAEMON_MAX_LINE 1024 /**< 请求行的最大字节数（不含行尾） */
+#define PARKING_DAEMON_MAX_REPLY 1024 /**< 响应行的最大字节数（含行尾） */
+#define PARKING_DAEMON_MAX_ID 32     /**< 请求 id 的最大字节数 */
+#define PARKING_DAEMON_MAX_CLIENTS 512 /**< 同时服务的连接数 */
+#define PARKING_DAEMON_OUTPUT_LIMIT                                            \
+  (256 * 1024) /**< 单个连接待发送响应的上限，超过后暂停读取（字节） */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 正在运行的网络服务（不透明类型）。
+ */
+typedef struct ParkingDaemon ParkingDaemon;
+
+/**
+ *********************************************************************************
+ *                              网络服务API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 执行一行请求并生成响应行。
+ * @details 事件循环对每个请求调用它，也可以直接用于测试或其他传输方式。
+ * @param lot 目标停车场。
+ * @param line 请求行（不含行尾），函数会在原处切分字段。
+ * @param[out] reply 接收以 "\n" 结尾的响应行，至少 PARKING_DAEMON_MAX_REPLY
+ *                   字节；不以 NUL 结尾。
+ * @return 响应行的字节数；line 中没有可用的 id 时仍返回以 "-" 为 id 的响应。
+ */
+size_t parking_daemon_execute(ParkingLot *lot, char *line, char *reply);
+
+/**
+ * @brief 按站点执行一行请求并生成响应行。
+ * @details 请求行为 <id> <站点> <命令> [参数...]；去掉站点字段后交给该站点
+ *          停车场的 parking_daemon_execute。执行期间以
+ *          parking_registry_acquire 借出站点，关闭站点的线程等请求执行完
+ *          才释放停车场；站点正在关闭时不执行，返回 PARKING_SERVICE_BUSY。
+ * @param registry 注册表。
+ * @param line 请求行（不含行尾），函数会在原处修改。
+ * @param[out] reply 接收以 "\n" 结尾的响应行，至少 PARKING_DAEMON_MAX_REPLY
+ *                   字节；不以 NUL 结尾。
+ * @return 响应行的字节数。
+ */
+size_t parking_daemon_execute_site(ParkingRegistry *registry, char *line,
+                                   char *reply);
+
+/**
+ * @brief 启动网络服务，在后台线程中运行事件循环。
+ * @param lot 要服务的停车场，须比网络服务存活得久。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配，可用 parking_daemon_port 查询。
+ * @return 成功返回服务句柄；参数无效、端口被占用或资源不足时返回 NULL。
+ */
+ParkingDaemon *parking_daemon_start(ParkingLot *lot, const char *host,
+                                    int port);
+
+/**
+ * @brief 启动按站点服务注册表的网络服务，在后台线程中运行事件循环。
+ * @param registry 要服务的注册表，须比网络服务存活得久。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配，可用 parking_daemon_port 查询。
+ * @return 成功返回服务句柄；参数无效、端口被占用或资源不足时返回 NULL。
+ */
+ParkingDaemon *parking_daemon_start_registry(ParkingRegistry *registry,
+                                             const char *host, int port);
+
+/**
+ * @brief 查询网络服务实际监听的端口。
+ * @param daemon 服务句柄。
+ * @return 端口号；daemon 为 NULL 时返回 0。
+ */
+int parking_daemon_port(const ParkingDaemon *daemon);
+
+/**
+ * @brief 查询当前的连接数。
+ * @param daemon 服务句柄。
+ * @return 连接数；daemon 为 NULL 时返回 0。
+ */
+int parking_daemon_clients(const ParkingDaemon *daemon);
+
+/**
+ * @brief 停止网络服务、断开全部连接并释放句柄。
+ * @details 已读到但尚未发出的响应会被丢弃。
+ * @param daemon 服务句柄，可以为 NULL。
+ */
+void parking_daemon_stop(ParkingDaemon *daemon);
+
+#endif /* PARKING_DAEMON_H */
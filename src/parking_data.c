@@ -8,835 +8,7529 @@
  * 这是系统的核心数据管理模块，不包含任何业务逻辑或用户界面代码。
  */
 
-#include <math.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "parking_aggregate.h"
+#include "parking_codec.h"
+#include "parking_column.h"
+#include "parking_compress.h"
 #include "parking_data.h"
+#include "parking_dedup.h"
+#include "parking_durable_file.h"
+#include "parking_feed.h"
+#include "parking_file_map.h"
+#include "parking_history.h"
+#include "parking_home.h"
+#include "parking_journal.h"
+#include "parking_layout.h"
+#include "parking_plate.h"
+#include "parking_ledger.h"
+#include "parking_reservation.h"
+#include "parking_saver.h"
+#include "parking_session.h"
+#include "parking_shm.h"
+#include "parking_slot_schema.h"
+#include "parking_strings.h"
+#include "parking_thread.h"
+#include "parking_timeline.h"
+#include "parking_trace.h"
+#include "parking_view.h"
+#include "parking_zone.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define SEARCH_REBUILD_SLACK 4096 /**< 三元组索引允许的失效项余量 */
+#define LOT_PRESIZE_MAX_SLOTS 16384 /**< 按设计容量预分配的车位数上限 */
+
+/**
+ * @brief 一次 run_parking_timers 调用的上下文。
+ */
+typedef struct {
+  ParkingLot *lot; /**< 正在推进定时器的停车场。 */
+  time_t now;      /**< 推进到的时刻。 */
+} TimerRun;
+
+/**
+ * @brief 查找最近空闲车位时的预约检查上下文。
+ */
+typedef struct {
+  const ParkingLot *lot; /**< 目标停车场。 */
+  time_t now;            /**< 查找时刻。 */
+} HoldCheck;
+
+/* ========================================================================== */
+/*                              文本格式定义                                  */
+/* ========================================================================== */
+
+#define TEXT_LINE_MAX 512    /**< 文本格式单行的最大字节数 */
+#define TEXT_FORMAT_VERSION 2 /**< 带 END 尾行的文本格式版本，写在 LOT 行 */
+
+/* ========================================================================== */
+/*                              二进制快照布局定义                            */
+/* ========================================================================== */
+
+#define SNAP_OFF_SLOT_ID 0    /**< 记录内：车位编号（u32） */
+#define SNAP_OFF_TYPE 4       /**< 记录内：停车类型（u8） */
+#define SNAP_OFF_STATUS 5     /**< 记录内：占用状态（u8） */
+#define SNAP_OFF_ENTRY 8      /**< 记录内：入场时间（i64） */
+#define SNAP_OFF_EXIT 16      /**< 记录内：出场时间（i64） */
+#define SNAP_OFF_DUE 24       /**< 记录内：居民月费到期时间（i64） */
+#define SNAP_OFF_LOCATION 32  /**< 记录内：位置描述（MAX_LOCATION_LEN 字节） */
+#define SNAP_OFF_OWNER 132    /**< 记录内：车主姓名（MAX_NAME_LEN 字节） */
+#define SNAP_OFF_LICENSE 182  /**< 记录内：车牌号（MAX_LICENSE_LEN 字节） */
+#define SNAP_OFF_CONTACT 232  /**< 记录内：联系方式（MAX_CONTACT_LEN 字节） */
+
+#define SNAP_HDR_VERSION 8       /**< 文件头：格式版本 */
+#define SNAP_HDR_HEADER_SIZE 12  /**< 文件头：文件头字节数 */
+#define SNAP_HDR_RECORD_SIZE 16  /**< 文件头：单条记录字节数 */
+#define SNAP_HDR_TOTAL_SLOTS 20  /**< 文件头：停车场总车位数 */
+#define SNAP_HDR_SLOT_COUNT 24   /**< 文件头：记录条数 */
+#define SNAP_HDR_RECORD_SUM 28   /**< 文件头：记录区校验和 */
+#define SNAP_HDR_HEADER_SUM 32   /**< 文件头：前 32 字节的校验和 */
+
+#define SNAP_PAGE_SUM_SIZE 4     /**< 页表中每页校验和的字节数 */
+#define SNAP_VERSION_FLAT 1      /**< 无页表、整个记录区一个校验和的旧版本 */
+#define SNAP_VERSION_PACKED 3    /**< 各页独立压缩的版本 */
+#define SNAP_PACKED_ENTRY_SIZE 8 /**< 压缩版本页表每项的字节数 */
+#define SNAP_LOAD_MAX_THREADS 8  /**< 加载快照时最多使用的线程数 */
+#define SNAP_LOAD_MIN_PAGES 64   /**< 每个加载线程至少分到的页数 */
+
+#define DELTA_HDR_VERSION 8       /**< 增量文件头：格式版本 */
+#define DELTA_HDR_BASE_SUM 12     /**< 增量文件头：基准文件头的校验和 */
+#define DELTA_HDR_TOTAL_SLOTS 16  /**< 增量文件头：停车场总车位数 */
+#define DELTA_HDR_SLOT_COUNT 20   /**< 增量文件头：记录条数 */
+#define DELTA_HDR_PAGE_COUNT 24   /**< 增量文件头：清单项数 */
+#define DELTA_HDR_MANIFEST_SUM 28 /**< 增量文件头：清单校验和 */
+#define DELTA_HDR_HEADER_SUM 32   /**< 增量文件头：前 32 字节的校验和 */
+#define DELTA_ENTRY_SIZE 8        /**< 清单每项（页号、校验和）的字节数 */
+
+#define IMAGE_HDR_VERSION 8         /**< 映像文件头：格式版本 */
+#define IMAGE_HDR_HEADER_SIZE 12    /**< 映像文件头：文件头字节数 */
+#define IMAGE_HDR_SNAPSHOT_SUM 16   /**< 映像文件头：快照代号 */
+#define IMAGE_HDR_SLOT_COUNT 20     /**< 映像文件头：记录条数 */
+#define IMAGE_HDR_ID_CAPACITY 24    /**< 映像文件头：编号索引桶数 */
+#define IMAGE_HDR_PLATE_CAPACITY 28 /**< 映像文件头：车牌索引桶数 */
+#define IMAGE_HDR_PLATE_COUNT 32    /**< 映像文件头：车牌数 */
+#define IMAGE_HDR_ORDER_COUNT 36    /**< 映像文件头：入场顺序项数 */
+#define IMAGE_HDR_BODY_SUM 40       /**< 映像文件头：映像体校验和 */
+#define IMAGE_HDR_HEADER_SUM 44     /**< 映像文件头：前 44 字节的校验和 */
+#define IMAGE_ORDER_ENTRY 4         /**< 入场顺序每项（记录下标）的字节数 */
+
+/**
+ * @brief 编译期检查：文本字段长度变化时必须同步调整快照记录布局。
+ */
+typedef char snapshot_layout_check
+    [(SNAP_OFF_CONTACT + MAX_CONTACT_LEN <= SNAPSHOT_RECORD_SIZE &&
+      SNAP_OFF_OWNER == SNAP_OFF_LOCATION + MAX_LOCATION_LEN &&
+      SNAP_OFF_LICENSE == SNAP_OFF_OWNER + MAX_NAME_LEN &&
+      SNAP_OFF_CONTACT == SNAP_OFF_LICENSE + MAX_LICENSE_LEN)
+         ? 1
+         : -1];
+
+/**
+ * @brief (静态辅助函数) 替换车位的位置描述。
+ * @details 新文本先驻留再释放旧引用，位置不变时引用计数保持平衡。
+ * @param slot 目标车位。
+ * @param location 新的位置描述。
+ * @return 成功返回 0，内存不足返回 -1（保持原值）。
+ */
+static int slot_set_location(ParkingSlot *slot, const char *location) {
+  const char *text = string_store_intern(slot->strings, location,
+                                         MAX_LOCATION_LEN);
+
+  if (text == NULL) {
+    return -1;
+  }
+  string_store_release_interned(slot->strings, slot->location);
+  slot->location = text;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 替换车位的一个车主文本字段。
+ * @param slot 目标车位。
+ * @param field 指向 owner_name、license_plate 或 contact 成员。
+ * @param value 新文本。
+ * @param max_len 该字段的长度上限（含结尾 NUL）。
+ * @return 成功返回 0，内存不足返回 -1（保持原值）。
+ */
+static int slot_set_text(ParkingSlot *slot, const char **field,
+                         const char *value, size_t max_len) {
+  const char *text = string_store_copy(slot->strings, value, max_len);
+
+  if (text == NULL) {
+    return -1;
+  }
+  string_store_release_copy(slot->strings, *field);
+  *field = text;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 以行缓冲区中的一段字段替换车位的位置描述。
+ * @param slot 目标车位。
+ * @param value 字段起始地址，不必以 NUL 结尾。
+ * @param len 字段的字节数。
+ * @return 成功返回 0，内存不足返回 -1（保持原值）。
+ */
+static int slot_set_location_span(ParkingSlot *slot, const char *value,
+                                  size_t len) {
+  const char *text = string_store_intern_span(slot->strings, value, len,
+                                              MAX_LOCATION_LEN);
+
+  if (text == NULL) {
+    return -1;
+  }
+  string_store_release_interned(slot->strings, slot->location);
+  slot->location = text;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 以行缓冲区中的一段字段替换车位的一个车主文本字段。
+ * @param slot 目标车位。
+ * @param field 指向 owner_name、license_plate 或 contact 成员。
+ * @param value 字段起始地址，不必以 NUL 结尾。
+ * @param len 字段的字节数。
+ * @param max_len 该字段的长度上限（含结尾 NUL）。
+ * @return 成功返回 0，内存不足返回 -1（保持原值）。
+ */
+static int slot_set_text_span(ParkingSlot *slot, const char **field,
+                              const char *value, size_t len, size_t max_len) {
+  const char *text = string_store_copy_span(slot->strings, value, len,
+                                            max_len);
+
+  if (text == NULL) {
+    return -1;
+  }
+  string_store_release_copy(slot->strings, *field);
+  *field = text;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 清空车位的车主、车牌和联系方式。
+ * @param slot 目标车位。
+ */
+static void slot_clear_occupant(ParkingSlot *slot) {
+  string_store_release_copy(slot->strings, slot->owner_name);
+  string_store_release_copy(slot->strings, slot->license_plate);
+  string_store_release_copy(slot->strings, slot->contact);
+  slot->owner_name = string_store_empty;
+  slot->license_plate = string_store_empty;
+  slot->contact = string_store_empty;
+}
+
+/**
+ * @brief (静态辅助函数) 释放车位引用的全部文本。
+ * @param slot 目标车位。
+ */
+static void slot_release_strings(ParkingSlot *slot) {
+  slot_clear_occupant(slot);
+  string_store_release_interned(slot->strings, slot->location);
+  slot->location = string_store_empty;
+}
+
+/**
+ * @brief (静态辅助函数) 将车位的全部文本迁入指定存储。
+ * @details 单独创建的车位加入停车场时调用，原先单独 malloc 的文本随即释放。
+ * @param slot 目标车位。
+ * @param strings 目标存储。
+ * @return 成功返回 0，内存不足返回 -1（车位保持原存储不变）。
+ */
+static int slot_move_strings(ParkingSlot *slot, StringStore *strings) {
+  ParkingSlot moved = *slot;
+
+  moved.strings = strings;
+  moved.location = string_store_empty;
+  moved.owner_name = string_store_empty;
+  moved.license_plate = string_store_empty;
+  moved.contact = string_store_empty;
+  if (slot_set_location(&moved, slot->location) != 0 ||
+      slot_set_text(&moved, &moved.owner_name, slot->owner_name,
+                    MAX_NAME_LEN) != 0 ||
+      slot_set_text(&moved, &moved.license_plate, slot->license_plate,
+                    MAX_LICENSE_LEN) != 0 ||
+      slot_set_text(&moved, &moved.contact, slot->contact,
+                    MAX_CONTACT_LEN) != 0) {
+    slot_release_strings(&moved);
+    return -1;
+  }
+
+  slot_release_strings(slot);
+  slot->strings = strings;
+  slot->location = moved.location;
+  slot->owner_name = moved.owner_name;
+  slot->license_plate = moved.license_plate;
+  slot->contact = moved.contact;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 取文本行中一个字段的长度。
+ * @param field 字段起始地址。
+ * @return 到下一个分隔符、换行或行尾之前的字节数。
+ */
+static size_t text_field_length(const char *field) {
+  const char *p = field;
+
+  while (*p != '|' && *p != '\0' && *p != '\n' && *p != '\r') {
+    p++;
+  }
+  return (size_t)(p - field);
+}
+
+/* 文本行各种类字段的解码：文本字段按长度复制一次，数值在分隔符处停止 */
+#define TEXT_LOAD_INT(slot, member, value, len, width)                         \
+  (slot)->member = atoi(value)
+#define TEXT_LOAD_TYPE(slot, member, value, len, width)                        \
+  (slot)->member = (ParkingType)atoi(value)
+#define TEXT_LOAD_STATUS(slot, member, value, len, width)                      \
+  (slot)->member = (ParkingStatus)atoi(value)
+#define TEXT_LOAD_TIME(slot, member, value, len, width)                        \
+  (slot)->member = (time_t)atoll(value)
+#define TEXT_LOAD_LOCATION(slot, member, value, len, width)                    \
+  slot_set_location_span(slot, value, len)
+#define TEXT_LOAD_TEXT(slot, member, value, len, width)                        \
+  slot_set_text_span(slot, &(slot)->member, value, len, width)
+
+/** (展开辅助宏) 解码一个字段；行在该字段处结束时不再解码后续字段。 */
+#define TEXT_LOAD_FIELD(member, kind, width, tag, occupant)                    \
+  if (more) {                                                                  \
+    len = text_field_length(p);                                                \
+    TEXT_LOAD_##kind(slot, member, p, len, width);                             \
+    more = p[len] == '|';                                                      \
+    p += len + 1;                                                              \
+  }
+
+/**
+ * @brief (静态辅助函数) 把一行 `SLOT|` 记录的字段解码到车位节点。
+ * @details 由 parking_slot_schema.h 的字段表逐字段展开，字段直接位于行缓冲区
+ *          中，不改写分隔符；缺少的尾部字段保持初始值，多余的字段被忽略。
+ * @param slot 目标车位节点（已初始化为空闲）。
+ * @param fields `SLOT|` 之后的行内容。
+ */
+static void text_decode_slot(ParkingSlot *slot, const char *fields) {
+  const char *p = fields;
+  size_t len;
+  int more = 1;
+
+  PARKING_SLOT_FIELDS(TEXT_LOAD_FIELD)
+}
+
+/**
+ * @brief (静态辅助函数) 以空闲状态初始化车位节点的各个字段。
+ * @param slot 要初始化的车位节点。
+ * @param slot_id 车位编号。
+ * @param location 车位的物理位置描述。
+ * @param storage 车位节点的内存来源。
+ * @param strings 文本字段所在的存储，单独创建的车位为 NULL。
+ * @return 成功返回 0，位置描述无法存储时返回 -1（位置为空串）。
+ */
+static int init_slot_fields(ParkingSlot *slot, int slot_id,
+                            const char *location, SlotStorage storage,
+                            StringStore *strings) {
+  slot->slot_id = slot_id;
+  slot->strings = strings;
+  slot->location = string_store_empty;
+
+  /* 初始化为空状态 */
+  slot->owner_name = string_store_empty;
+  slot->license_plate = string_store_empty;
+  slot->contact = string_store_empty;
+  slot->type = RESIDENT_TYPE; /* 默认为居民类型 */
+  slot->entry_time = 0;
+  slot->exit_time = 0;
+  slot->resident_due_date = 0;
+  slot->status = FREE_STATUS;
+  slot->next = NULL;
+  slot->table_index = -1;
+  slot->storage = storage;
+  slot->entry_prev = NULL;
+  slot->entry_next = NULL;
+  slot->search_stamp = 0;
+  slot->search_entries = 0;
+  slot->due_heap_index = -1;
+  slot->handle_index = SLOT_HANDLE_NO_ENTRY;
+  timer_init(&slot->timer);
+  slot->pool = SLOT_POOL_SHARED;
+  slot->has_home = 0;
+  return slot_set_location(slot, location);
+}
+
+static volatile int handle_seed_lock = 0; /**< 保护 handle_seed 的自旋锁 */
+static unsigned long handle_seed = 0;     /**< 已创建的停车场数 */
+
+/**
+ * @brief (静态辅助函数) 取新停车场句柄表的初始代号。
+ * @details 以停车场的创建序号乘黄金分割常数，使各停车场的代号起点
+ *          在 32 位空间中彼此远离。
+ * @return 初始代号，可能为 0（句柄表会按 1 处理）。
+ */
+static unsigned int next_handle_generation(void) {
+  unsigned long serial;
+
+  while (parking_atomic_exchange_int(&handle_seed_lock, 1) != 0) {
+    while (parking_atomic_load_int(&handle_seed_lock) != 0) {
+    }
+  }
+  serial = ++handle_seed;
+  parking_atomic_store_int(&handle_seed_lock, 0);
+  return (unsigned int)((serial * 0x9E3779B1UL) & 0xFFFFFFFFUL);
+}
+
+/**
+ * @brief (静态辅助函数) 计算车位内存池下一个区块的车位数。
+ * @details 第一个区块按尚未加入的设计车位数分配，托管上百个小停车场时
+ *          不必每个都占一整块 SLOT_ARENA_CHUNK_SLOTS；之后的区块至少是
+ *          上一个的两倍，超出设计容量后也只需对数个区块。
+ * @param lot 目标停车场。
+ * @return 介于 SLOT_ARENA_MIN_CHUNK_SLOTS 与 SLOT_ARENA_CHUNK_SLOTS 之间的车位数。
+ */
+static int arena_chunk_capacity(const ParkingLot *lot) {
+  int capacity = lot->total_slots - lot->slot_count;
+
+  if (lot->arena_chunks != NULL &&
+      capacity < lot->arena_chunks->capacity * 2) {
+    capacity = lot->arena_chunks->capacity * 2;
+  }
+  if (capacity < SLOT_ARENA_MIN_CHUNK_SLOTS) {
+    capacity = SLOT_ARENA_MIN_CHUNK_SLOTS;
+  }
+  if (capacity > SLOT_ARENA_CHUNK_SLOTS) {
+    capacity = SLOT_ARENA_CHUNK_SLOTS;
+  }
+  return capacity;
+}
+
+/**
+ * @brief (静态辅助函数) 查找车位节点所在的内存池区块。
+ * @details 逐个比较区块的地址范围，耗时与区块数成正比，
+ *          区块数约为车位数的 1/SLOT_ARENA_CHUNK_SLOTS。
+ * @param lot 目标停车场。
+ * @param slot 来自该停车场内存池的车位节点。
+ * @return 所在区块；节点不属于内存池时返回 NULL。
+ */
+static SlotArenaChunk *arena_chunk_of(const ParkingLot *lot,
+                                      const ParkingSlot *slot) {
+  SlotArenaChunk *chunk;
+
+  for (chunk = lot->arena_chunks; chunk != NULL; chunk = chunk->next) {
+    if (slot >= chunk->slots && slot < chunk->slots + chunk->capacity) {
+      return chunk;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 从停车场的车位内存池中取出一个车位节点。
+ * @details 优先复用已删除车位留下的节点，其次从当前区块切分，
+ *          区块用尽时再分配一个新区块。
+ * @param lot 目标停车场。
+ * @return 成功返回未初始化的车位节点（storage 已设为 SLOT_STORAGE_ARENA），
+ * 内存不足返回 NULL。
+ */
+static ParkingSlot *arena_alloc_slot(ParkingLot *lot) {
+  ParkingSlot *slot;
+  SlotArenaChunk *chunk;
+  int capacity;
+
+  if (lot->arena_free_list != NULL) {
+    slot = lot->arena_free_list;
+    lot->arena_free_list = slot->next;
+    arena_chunk_of(lot, slot)->live++;
+  } else {
+    chunk = lot->arena_chunks;
+    if (chunk == NULL || chunk->used == chunk->capacity) {
+      capacity = arena_chunk_capacity(lot);
+      chunk = (SlotArenaChunk *)parking_memory_alloc(
+          &lot->memory, PARKING_MEMORY_SLOTS,
+          offsetof(SlotArenaChunk, slots) +
+              (size_t)capacity * sizeof(ParkingSlot));
+      if (chunk == NULL) {
+        return NULL;
+      }
+      chunk->used = 0;
+      chunk->capacity = capacity;
+      chunk->live = 0;
+      chunk->evacuating = 0;
+      chunk->next = lot->arena_chunks;
+      lot->arena_chunks = chunk;
+    }
+    slot = &chunk->slots[chunk->used++];
+    chunk->live++;
+  }
+
+  slot->storage = SLOT_STORAGE_ARENA;
+  slot->table_index = -1;
+  return slot;
+}
+
+/**
+ * @brief (静态辅助函数) 将车位节点归还给停车场的内存池以便复用。
+ * @details 节点引用的文本一并归还文本存储。所在区块正在被整理腾空时
+ *          节点不再进入空闲链表，随区块一起释放。
+ * @param lot 目标停车场。
+ * @param slot 来自该停车场内存池的车位节点。
+ */
+static void arena_release_slot(ParkingLot *lot, ParkingSlot *slot) {
+  SlotArenaChunk *chunk = arena_chunk_of(lot, slot);
+
+  slot_release_strings(slot);
+  chunk->live--;
+  if (chunk->evacuating) {
+    return;
+  }
+  slot->next = lot->arena_free_list;
+  lot->arena_free_list = slot;
+}
+
+/**
+ * @brief (静态辅助函数) 将热字段列扩容到指定行数。
+ * @details 各列分别 realloc；某一列失败时已扩容的列仍然有效，
+ *          只是比 slot_capacity 大，不影响后续使用或释放。
+ * @param memory 分配来源。
+ * @param hot 目标热字段列。
+ * @param capacity 新的行数。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int hot_table_reserve(ParkingMemory *memory, SlotHotTable *hot,
+                             int capacity) {
+  size_t rows = (size_t)capacity;
+  int *ids;
+  unsigned char *statuses;
+  unsigned char *types;
+  time_t *entries;
+  time_t *dues;
+
+  ids = (int *)parking_memory_realloc(memory, PARKING_MEMORY_TABLE,
+                                      hot->slot_id, rows * sizeof(int));
+  if (ids == NULL) {
+    return -1;
+  }
+  hot->slot_id = ids;
+
+  statuses = (unsigned char *)parking_memory_realloc(
+      memory, PARKING_MEMORY_TABLE, hot->status, rows);
+  if (statuses == NULL) {
+    return -1;
+  }
+  hot->status = statuses;
+
+  types = (unsigned char *)parking_memory_realloc(
+      memory, PARKING_MEMORY_TABLE, hot->type, rows);
+  if (types == NULL) {
+    return -1;
+  }
+  hot->type = types;
+
+  entries = (time_t *)parking_memory_realloc(
+      memory, PARKING_MEMORY_TABLE, hot->entry_time, rows * sizeof(time_t));
+  if (entries == NULL) {
+    return -1;
+  }
+  hot->entry_time = entries;
+
+  dues = (time_t *)parking_memory_realloc(
+      memory, PARKING_MEMORY_TABLE, hot->due_date, rows * sizeof(time_t));
+  if (dues == NULL) {
+    return -1;
+  }
+  hot->due_date = dues;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 释放热字段列的全部内存。
+ * @param hot 目标热字段列。
+ */
+static void hot_table_free(ParkingMemory *memory, SlotHotTable *hot) {
+  parking_memory_free(memory, hot->slot_id);
+  parking_memory_free(memory, hot->status);
+  parking_memory_free(memory, hot->type);
+  parking_memory_free(memory, hot->entry_time);
+  parking_memory_free(memory, hot->due_date);
+  hot->slot_id = NULL;
+  hot->status = NULL;
+  hot->type = NULL;
+  hot->entry_time = NULL;
+  hot->due_date = NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 按车位的状态、分配池与固定车位标记更新分配池位图。
+ * @details 行只出现在所属分配池的位图中，且只在车位空闲、不是固定车位时置位。
+ * @param lot 目标停车场。
+ * @param row 行号。
+ * @param slot 该行的车位节点。
+ */
+static void pool_row_store(ParkingLot *lot, int row, const ParkingSlot *slot) {
+  int pool;
+
+  for (pool = 0; pool < SLOT_POOL_KINDS; pool++) {
+    if (pool == slot->pool && slot->status == FREE_STATUS && !slot->has_home) {
+      slot_bitmap_set(&lot->pool_free[pool], (size_t)row);
+    } else {
+      slot_bitmap_clear(&lot->pool_free[pool], (size_t)row);
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 将车位节点的热字段写入热字段列的指定行。
+ * @details 同时按车位状态更新空闲车位位图与分配池位图的对应位。
+ * @param lot 目标停车场。
+ * @param row 行号，即车位在稠密车位表中的下标。
+ * @param slot 数据来源的车位节点。
+ */
+static void hot_row_store(ParkingLot *lot, int row, const ParkingSlot *slot) {
+  lot->hot.slot_id[row] = slot->slot_id;
+  lot->hot.status[row] = (unsigned char)slot->status;
+  lot->hot.type[row] = (unsigned char)slot->type;
+  lot->hot.entry_time[row] = slot->entry_time;
+  lot->hot.due_date[row] = slot->resident_due_date;
+
+  if (slot->status == FREE_STATUS) {
+    slot_bitmap_set(&lot->free_map, (size_t)row);
+  } else {
+    slot_bitmap_clear(&lot->free_map, (size_t)row);
+  }
+  pool_row_store(lot, row, slot);
+}
+
+/**
+ * @brief (静态辅助函数) 按车位的状态和类型调整停车场的计数器。
+ * @param lot 目标停车场。
+ * @param status 车位状态。
+ * @param type 停车类型，仅对已占用车位有意义。
+ * @param delta 调整量（+1 表示计入，-1 表示移出）。
+ */
+static void slot_counters_apply(ParkingLot *lot, int status, int type,
+                                int delta) {
+  if (status == FREE_STATUS) {
+    parking_atomic_add_int(&lot->free_slot_count, delta);
+    return;
+  }
+  parking_atomic_add_int(&lot->occupied_slots, delta);
+  if (type == VISITOR_TYPE) {
+    parking_atomic_add_int(&lot->occupied_visitor_count, delta);
+  } else {
+    parking_atomic_add_int(&lot->occupied_resident_count, delta);
+  }
+  if (lot->aggregate != NULL) {
+    sync_parking_aggregate(lot);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 按入场时间和类型调整按日、按月的入场计数与滚动汇总。
+ * @details 计数表扩容失败时本次入场不计入统计，不影响入场本身。
+ * @param lot 目标停车场。
+ * @param entry_time 入场时间，为 0 时忽略。
+ * @param type 停车类型。
+ * @param delta 调整量（+1 表示一次入场，-1 表示撤销一次入场）。
+ */
+static void entry_counts_apply(ParkingLot *lot, time_t entry_time, int type,
+                               int delta) {
+  long day;
+  long month;
+  int category = type == VISITOR_TYPE ? 1 : 0;
+
+  if (entry_time <= 0) {
+    return;
+  }
+  parking_calendar_lookup(&lot->calendar, entry_time, &day, &month);
+  calendar_count_add(&lot->daily_entries, day, category, delta);
+  calendar_count_add(&lot->monthly_entries, month, category, delta);
+  rollup_add(&lot->rollup, entry_time, day, month, type, ROLLUP_ENTRIES, delta);
+}
+
+/**
+ * @brief (静态辅助函数) 把一次出场计入滚动汇总。
+ * @param lot 目标停车场。
+ * @param exit_time 出场时间，为 0 时忽略。
+ * @param type 出场车辆的停车类型。
+ */
+static void exit_counts_apply(ParkingLot *lot, time_t exit_time, int type) {
+  long day;
+  long month;
+
+  if (exit_time <= 0) {
+    return;
+  }
+  parking_calendar_lookup(&lot->calendar, exit_time, &day, &month);
+  rollup_add(&lot->rollup, exit_time, day, month, type, ROLLUP_EXITS, 1);
+}
+
+/**
+ * @brief (静态辅助函数) 计算车位在月费到期堆中的排序键。
+ * @param slot 车位节点。
+ * @return 居民车位的到期时间；访客车位或未设置到期时间时返回 0（不登记）。
+ */
+static time_t due_heap_key(const ParkingSlot *slot) {
+  return slot->type == RESIDENT_TYPE ? slot->resident_due_date : 0;
+}
+
+/**
+ * @brief (静态辅助函数) 取访客时段与当前配置一致的日历缓存。
+ * @details 配置发布后第一次用到访客时段时按新的小时重建缓存。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @return 停车场的日历缓存。
+ */
+static ParkingCalendar *visitor_calendar(ParkingLot *lot) {
+  const ParkingConfig *config = parking_lot_config(lot);
+
+  if (lot->calendar.start_hour != config->visitor_start_hour ||
+      lot->calendar.end_hour != config->visitor_end_hour) {
+    parking_calendar_init(&lot->calendar, config->visitor_start_hour,
+                          config->visitor_end_hour);
+  }
+  return &lot->calendar;
+}
+
+/**
+ * @brief (静态辅助函数) 按车位的状态、类型与到期时间重新登记其定时器。
+ * @details 在场访客登记入场后第一个允许时段结束时刻，设置了到期时间的
+ *          居民车位登记到期时刻，其余车位撤销定时器。
+ * @param lot 车位所属的停车场。
+ * @param node 定时器所在的车位节点。
+ * @param slot 字段来源的车位节点。
+ */
+static void slot_timer_sync(ParkingLot *lot, ParkingSlot *node,
+                            const ParkingSlot *slot) {
+  time_t expires = 0;
+
+  if (slot->type == VISITOR_TYPE) {
+    if (slot->status == OCCUPIED_STATUS) {
+      expires = parking_calendar_next_window_end(visitor_calendar(lot),
+                                                 slot->entry_time);
+    }
+  } else {
+    expires = slot->resident_due_date;
+  }
+  if (expires > 0) {
+    timer_wheel_add(&lot->timers, &node->timer, expires);
+  } else {
+    timer_wheel_cancel(&lot->timers, &node->timer);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 用车位节点的当前字段替换热字段列中已有的一行。
+ * @details 按旧行与新值的状态和类型差异调整计数器，并同步入场时间链表、
+ *          月费到期堆、车位定时器与按日、按月的入场计数，因此任何状态转换
+ *          都只需调用这一个函数；空闲与否有变化时还会同步空间索引与
+ *          分区计数表中的空闲计数。
+ *          出场不会减少入场计数，只计入滚动汇总的出场次数；已占用车位的
+ *          入场时间或类型被修正时，计数从旧日期移到新日期。
+ * @param lot 目标停车场。
+ * @param row 已存在的行号。
+ * @param slot 数据来源的车位节点。
+ */
+static void hot_row_replace(ParkingLot *lot, int row, const ParkingSlot *slot) {
+  ParkingSlot *node = lot->slot_table[row];
+  int old_status = lot->hot.status[row];
+  int old_type = lot->hot.type[row];
+  int was_listed = old_status != FREE_STATUS;
+  int listed = slot->status != FREE_STATUS;
+
+  /* 热字段列中的旧入场时间即该车位在链表中的排序键 */
+  if (was_listed && (!listed || lot->hot.entry_time[row] != slot->entry_time)) {
+    entry_order_remove(&lot->entry_order, node);
+    was_listed = 0;
+  }
+  if (old_status != FREE_STATUS && listed &&
+      (lot->hot.entry_time[row] != slot->entry_time ||
+       old_type != (int)slot->type)) {
+    entry_counts_apply(lot, lot->hot.entry_time[row], old_type, -1);
+    entry_counts_apply(lot, slot->entry_time, slot->type, 1);
+  } else if (old_status == FREE_STATUS && listed) {
+    entry_counts_apply(lot, slot->entry_time, slot->type, 1);
+  } else if (old_status != FREE_STATUS && !listed) {
+    exit_counts_apply(lot, slot->exit_time, old_type);
+  }
+  if (listed && !was_listed) {
+    entry_order_insert(&lot->entry_order, node);
+  }
+  /* 堆容量已随稠密车位表预留，登记不会失败 */
+  if (lot->hot.due_date[row] != slot->resident_due_date ||
+      old_type != (int)slot->type) {
+    due_heap_update(&lot->due_heap, node, due_heap_key(slot));
+  }
+  if (old_status != (int)slot->status || old_type != (int)slot->type ||
+      lot->hot.entry_time[row] != slot->entry_time ||
+      lot->hot.due_date[row] != slot->resident_due_date) {
+    slot_timer_sync(lot, node, slot);
+  }
+
+  parking_atomic_add_long(&lot->mutation_count, 1);
+  hot_row_store(lot, row, slot);
+  /* 状态与类型都没变时不触碰计数器，避免无谓的原子写 */
+  if (old_status != (int)slot->status || old_type != (int)slot->type) {
+    /* 先计入新状态再扣减旧状态，无锁读者看到的占用数不会短暂偏低 */
+    slot_counters_apply(lot, slot->status, slot->type, 1);
+    slot_counters_apply(lot, old_status, old_type, -1);
+  }
+  if (lot->layout != NULL &&
+      (old_status == FREE_STATUS) != (slot->status == FREE_STATUS)) {
+    layout_mark_free(lot->layout, node->slot_id, slot->status == FREE_STATUS);
+  }
+  if (lot->zones != NULL &&
+      (old_status == FREE_STATUS) != (slot->status == FREE_STATUS)) {
+    zone_table_apply(lot->zones, lot, node->location, 0,
+                     slot->status == FREE_STATUS ? 1 : -1);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 初始化一条日志记录。
+ * @param record 要初始化的记录。
+ * @param op 操作类型。
+ * @param slot_id 车位编号。
+ */
+static void journal_record_init(JournalRecord *record, JournalOp op,
+                                int slot_id) {
+  memset(record, 0, sizeof(*record));
+  record->op = op;
+  record->slot_id = slot_id;
+}
+
+/**
+ * @brief (静态辅助函数) 判断修改是否需要生成日志记录。
+ * @param lot 目标停车场。
+ * @return 启用了日志、旁路接收者或变更订阅返回 1，否则返回 0。
+ */
+static int journal_wanted(const ParkingLot *lot) {
+  return lot->journal != NULL || lot->mutation_tap != NULL ||
+         lot->timeline != NULL || (lot->feed != NULL && lot->feed->count > 0);
+}
+
+/**
+ * @brief (静态辅助函数) 把一条日志记录转成紧凑的变更事件发给订阅者。
+ * @details 记录在修改完成后生成，状态与类型从车位的热字段读取。
+ * @param lot 目标停车场。
+ * @param record 刚产生的记录。
+ */
+static void publish_slot_change(ParkingLot *lot, const JournalRecord *record) {
+  ParkingChange change;
+  ParkingSlot *slot = find_slot_by_id(lot, record->slot_id);
+
+  change.seq = 0;
+  change.kind = (ParkingChangeKind)record->op;
+  change.slot_id = record->slot_id;
+  change.status = FREE_STATUS;
+  change.type = record->type;
+  if (slot != NULL && slot->table_index >= 0) {
+    change.status = lot->hot.status[slot->table_index];
+    change.type = lot->hot.type[slot->table_index];
+  }
+  if (record->op == JOURNAL_OP_ALLOCATE) {
+    change.when = record->entry_time;
+  } else if (record->op == JOURNAL_OP_DEALLOCATE) {
+    change.when = record->exit_time;
+  } else {
+    change.when = parking_lot_now(lot);
+  }
+  change_feed_publish(lot->feed, &change);
+}
+
+/**
+ * @brief (静态辅助函数) 以停车场的当前状态开始时间线的新分段。
+ * @param lot 已启用时间线的停车场（调用者已持有写锁）。
+ * @return 成功返回 0，有进行中的快照返回 -2，内存不足返回 -3。
+ */
+static int timeline_checkpoint(ParkingLot *lot) {
+  ParkingSnapshot snapshot;
+  const unsigned char *bytes;
+  size_t size;
+  int result;
+
+  result = begin_parking_snapshot(lot, &snapshot);
+  if (result != 0) {
+    return result == -1 ? -2 : -3;
+  }
+  fill_parking_snapshot(lot, &snapshot, 0);
+  bytes = parking_snapshot_bytes(&snapshot, &size);
+  result = bytes != NULL ? timeline_begin_segment(lot->timeline,
+                                                  parking_lot_now(lot), bytes,
+                                                  size)
+                         : -3;
+  end_parking_snapshot(lot, &snapshot);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 把一条记录带上业务时间记入时间线。
+ * @details 分段已满时顺带写下一个检查点；保存线程的快照正在进行时
+ *          推迟到下一条记录。记录写不进去时关闭时间线并丢弃全部历史，
+ *          缺了这条记录的历史回溯出来的状态是错的。
+ * @param lot 已启用时间线的停车场。
+ * @param record 刚产生的记录。
+ */
+static void timeline_log(ParkingLot *lot, const JournalRecord *record) {
+  time_t when;
+
+  if (record->op == JOURNAL_OP_ALLOCATE) {
+    when = record->entry_time;
+  } else if (record->op == JOURNAL_OP_DEALLOCATE) {
+    when = record->exit_time;
+  } else {
+    when = parking_lot_now(lot);
+  }
+  if (timeline_append(lot->timeline, when, record) != 0) {
+    timeline_free(lot->timeline);
+    lot->timeline = NULL;
+    return;
+  }
+  if (timeline_segment_full(lot->timeline)) {
+    timeline_checkpoint(lot);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 把一条记录交给旁路接收者与变更订阅者，
+ *        并在启用了日志时追加。
+ * @details 记录数达到压缩阈值时顺带完成一次压缩。
+ *          写入失败不会回滚内存中的修改，而是由日志的 error 标志报告。
+ * @param lot 目标停车场。
+ * @param record 要追加的记录。
+ */
+static void journal_log(ParkingLot *lot, const JournalRecord *record) {
+  ParkingJournal *journal = lot->journal;
+
+  if (lot->mutation_tap != NULL) {
+    lot->mutation_tap(record, lot->mutation_tap_ctx);
+  }
+  if (lot->feed != NULL && lot->feed->count > 0) {
+    publish_slot_change(lot, record);
+  }
+  if (lot->timeline != NULL) {
+    timeline_log(lot, record);
+  }
+  if (journal == NULL) {
+    return;
+  }
+  if (journal_append(journal, record) == 0 && journal->compact_threshold > 0 &&
+      journal->record_count >= journal->compact_threshold) {
+    compact_parking_journal(lot);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 将稠密车位表扩容到指定行数。
+ * @details 热字段列、空闲位图与月费到期堆随车位表同步扩容；
+ *          容量已足够时什么也不做。
+ * @param lot 目标停车场。
+ * @param capacity 新的行数。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int slot_table_reserve(ParkingLot *lot, int capacity) {
+  ParkingSlot **new_table;
+  int pool;
+
+  if (capacity <= lot->slot_capacity) {
+    return 0;
+  }
+  for (pool = 0; pool < SLOT_POOL_KINDS; pool++) {
+    if (slot_bitmap_reserve(&lot->pool_free[pool], (size_t)capacity) != 0) {
+      return -1;
+    }
+  }
+  if (hot_table_reserve(&lot->memory, &lot->hot, capacity) != 0 ||
+      slot_handle_table_reserve(&lot->handles, (size_t)capacity) != 0 ||
+      slot_bitmap_reserve(&lot->free_map, (size_t)capacity) != 0 ||
+      due_heap_reserve(&lot->due_heap, (size_t)capacity) != 0) {
+    return -1;
+  }
+  new_table = (ParkingSlot **)parking_memory_realloc(
+      &lot->memory, PARKING_MEMORY_TABLE, lot->slot_table,
+      (size_t)capacity * sizeof(ParkingSlot *));
+  if (new_table == NULL) {
+    return -1;
+  }
+  lot->slot_table = new_table;
+  lot->slot_capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 把稠密车位表某一行所在的快照页记为脏页。
+ * @details 尚无完整检查点作为基准时什么也不做。记录脏页的内存不足时
+ *          放弃基准，下一次检查点改写完整快照。
+ * @param lot 目标停车场。
+ * @param table_index 稠密车位表中的行号。
+ */
+static void snapshot_mark_dirty(ParkingLot *lot, int table_index) {
+  SnapshotDirtySet *dirty = &lot->checkpoint;
+  int page = table_index / SNAPSHOT_PAGE_ROWS;
+
+  if (!dirty->has_base) {
+    return;
+  }
+  if (page >= dirty->capacity) {
+    int capacity = dirty->capacity > 0 ? dirty->capacity : 16;
+    unsigned char *pages;
+
+    while (capacity <= page) {
+      capacity *= 2;
+    }
+    pages = (unsigned char *)parking_memory_realloc(
+        &lot->memory, PARKING_MEMORY_TABLE, dirty->pages, (size_t)capacity);
+    if (pages == NULL) {
+      dirty->has_base = 0;
+      return;
+    }
+    memset(pages + dirty->capacity, 0, (size_t)(capacity - dirty->capacity));
+    dirty->pages = pages;
+    dirty->capacity = capacity;
+  }
+  if (!dirty->pages[page]) {
+    dirty->pages[page] = 1;
+    dirty->dirty_count++;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 将车位追加到停车场的稠密车位表末尾。
+ * @details 容量不足时按两倍扩容，并写入热字段列的新行。
+ * @param lot 目标停车场。
+ * @param slot 要追加的车位节点。
+ * @param order_entries 非 0 时把在场车位插入入场时间链表；
+ *        为 0 时由调用者随后批量链接。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int slot_table_append(ParkingLot *lot, ParkingSlot *slot,
+                             int order_entries) {
+  if (lot->slot_count == lot->slot_capacity &&
+      slot_table_reserve(lot, lot->slot_capacity ? lot->slot_capacity * 2
+                                                 : 16) != 0) {
+    return -1;
+  }
+
+  /* 车位表的容量已为句柄表预留，分配项不会失败 */
+  slot_handle_table_acquire(&lot->handles, slot, &slot->handle_index);
+  slot->table_index = lot->slot_count;
+  lot->slot_table[lot->slot_count] = slot;
+  hot_row_store(lot, lot->slot_count, slot);
+  snapshot_mark_dirty(lot, lot->slot_count);
+  slot_counters_apply(lot, slot->status, slot->type, 1);
+  if (slot->status != FREE_STATUS) {
+    if (order_entries) {
+      entry_order_insert(&lot->entry_order, slot);
+    }
+    entry_counts_apply(lot, slot->entry_time, slot->type, 1);
+  }
+  due_heap_update(&lot->due_heap, slot, due_heap_key(slot));
+  slot_timer_sync(lot, slot, slot);
+  if (lot->zones != NULL) {
+    zone_table_apply(lot->zones, lot, slot->location, 1,
+                     slot->status == FREE_STATUS ? 1 : 0);
+  }
+  lot->slot_count++;
+  parking_atomic_add_long(&lot->mutation_count, 1);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 从稠密车位表中移除车位。
+ * @details 用表尾车位填补空位（swap-remove），保持车位表和热字段列连续，
+ *          并清除原表尾行在空闲位图中的位，同时将被移除的车位移出计数器。
+ * @param lot 目标停车场。
+ * @param slot 要移除的车位节点。
+ */
+static void slot_table_remove(ParkingLot *lot, ParkingSlot *slot) {
+  int index = slot->table_index;
+  ParkingSlot *last = lot->slot_table[lot->slot_count - 1];
+  int pool;
+
+  /* 两个车位在快照中的位置都将改变，先保全它们所在的页 */
+  preserve_slot_snapshot(lot, slot);
+  preserve_slot_snapshot(lot, last);
+  slot_counters_apply(lot, lot->hot.status[index], lot->hot.type[index], -1);
+  if (lot->hot.status[index] != FREE_STATUS) {
+    entry_order_remove(&lot->entry_order, slot);
+  }
+  if (lot->zones != NULL) {
+    zone_table_apply(lot->zones, lot, slot->location, -1,
+                     lot->hot.status[index] == FREE_STATUS ? -1 : 0);
+  }
+  due_heap_remove(&lot->due_heap, slot);
+  timer_wheel_cancel(&lot->timers, &slot->timer);
+  lot->slot_table[index] = last;
+  last->table_index = index;
+  hot_row_store(lot, index, last);
+  lot->slot_count--;
+  slot_bitmap_clear(&lot->free_map, (size_t)lot->slot_count);
+  for (pool = 0; pool < SLOT_POOL_KINDS; pool++) {
+    slot_bitmap_clear(&lot->pool_free[pool], (size_t)lot->slot_count);
+  }
+  slot_handle_table_release(&lot->handles, slot->handle_index);
+  slot->handle_index = SLOT_HANDLE_NO_ENTRY;
+  slot->table_index = -1;
+  parking_atomic_add_long(&lot->mutation_count, 1);
+}
+
+/**
+ * @brief (静态辅助函数) 按设计容量预先分配车位表与编号、车牌索引。
+ * @details 避免车位陆续加入、车辆陆续入场时反复扩容；失败时不报错，
+ *          各结构之后照常按需扩容。容量过大时只预分配
+ *          LOT_PRESIZE_MAX_SLOTS 个，其余交给渐进扩容。
+ * @param lot 刚建立的停车场。
+ * @param total_slots 设计容量。
+ */
+static void presize_parking_lot(ParkingLot *lot, int total_slots) {
+  int count = total_slots < LOT_PRESIZE_MAX_SLOTS ? total_slots
+                                                  : LOT_PRESIZE_MAX_SLOTS;
+
+  if (count <= 0) {
+    return;
+  }
+  slot_table_reserve(lot, count);
+  slot_id_index_reserve(&lot->id_index, (size_t)count);
+  plate_index_reserve(&lot->plate_index, (size_t)count);
+}
+
+/**
+ * @brief 初始化一个新的停车场对象。
+ * @details 为停车场分配内存并设置其初始状态，包括总车位数、占用数和链表头。
+ * @param total_slots 停车场的总容量。
+ * @return 成功时返回指向新分配的 ParkingLot 对象的指针，若内存分配失败则返回
+ * NULL。
+ */
+ParkingLot *init_parking_lot(int total_slots) {
+  return init_parking_lot_with_allocator(total_slots, NULL);
+}
+
+/**
+ * @brief 使用指定的分配函数初始化一个新的停车场对象。
+ * @details 先在栈上的内存对象中分配停车场本身，再把计数连同分配函数
+ *          一起复制进停车场，此后全部内部结构都从 lot->memory 分配。
+ * @param total_slots 停车场的总容量。
+ * @param allocator 分配函数，NULL 表示 C 标准库。
+ * @return 成功返回新停车场，内存分配失败返回 NULL。
+ */
+ParkingLot *init_parking_lot_with_allocator(int total_slots,
+                                            const ParkingAllocator *allocator) {
+  ParkingMemory memory;
+  ParkingLot *lot;
+  int i;
+
+  parking_memory_init(&memory, allocator);
+  lot = (ParkingLot *)parking_memory_alloc(&memory, PARKING_MEMORY_LOT,
+                                           sizeof(ParkingLot));
+  if (lot == NULL) {
+    return NULL;
+  }
+  lot->memory = memory;
+  lot->total_slots = total_slots;
+  lot->occupied_slots = 0;
+  lot->free_slot_count = 0;
+  lot->occupied_resident_count = 0;
+  lot->occupied_visitor_count = 0;
+  lot->slot_head = NULL;
+  lot->today_revenue_cents = 0;
+  lot->month_revenue_cents = 0;
+  lot->revenue_day = 0;
+  lot->revenue_month = 0;
+  rollup_init(&lot->rollup);
+  distinct_counter_init(&lot->distinct_plates);
+  forecast_init(&lot->forecast);
+  slot_id_index_init(&lot->id_index, &lot->memory);
+  slot_handle_table_init(&lot->handles, &lot->memory,
+                         next_handle_generation());
+  plate_index_init(&lot->plate_index, &lot->memory);
+  entry_order_init(&lot->entry_order);
+  due_heap_init(&lot->due_heap, &lot->memory);
+  trigram_index_init(&lot->search_index, &lot->memory);
+  calendar_count_init(&lot->daily_entries, &lot->memory);
+  calendar_count_init(&lot->monthly_entries, &lot->memory);
+  parking_config_default(&lot->base_config);
+  lot->config = &lot->base_config;
+  lot->retired_configs = NULL;
+  lot->config_lock = 0;
+  memset((void *)lot->plate_lists, 0, sizeof(lot->plate_lists));
+  lot->retired_plate_lists = NULL;
+  parking_calendar_init(&lot->calendar, lot->base_config.visitor_start_hour,
+                        lot->base_config.visitor_end_hour);
+  lot->slot_table = NULL;
+  lot->slot_count = 0;
+  lot->slot_capacity = 0;
+  lot->hot.slot_id = NULL;
+  lot->hot.status = NULL;
+  lot->hot.type = NULL;
+  lot->hot.entry_time = NULL;
+  lot->hot.due_date = NULL;
+  slot_bitmap_init(&lot->free_map, &lot->memory);
+  for (i = 0; i < SLOT_POOL_KINDS; i++) {
+    slot_bitmap_init(&lot->pool_free[i], &lot->memory);
+  }
+  lot->arena_chunks = NULL;
+  lot->arena_free_list = NULL;
+  memset(&lot->compaction, 0, sizeof(lot->compaction));
+  lot->heap_slot_count = 0;
+  lot->journal = NULL;
+  lot->mutation_tap = NULL;
+  lot->mutation_tap_ctx = NULL;
+  lot->ledger = NULL;
+  lot->snapshot = NULL;
+  memset(&lot->checkpoint, 0, sizeof(lot->checkpoint));
+  lot->saver = NULL;
+  lot->mutation_count = 0;
+  lot->history = NULL;
+  lot->query_pool = NULL;
+  lot->reservations = NULL;
+  lot->layout = NULL;
+  lot->zones = NULL;
+  lot->homes = NULL;
+  lot->sessions = NULL;
+  lot->session_capacity = SESSION_CACHE_DEFAULT_CAPACITY;
+  lot->request_log = NULL;
+  lot->view = NULL;
+  lot->shm = NULL;
+  lot->timeline = NULL;
+  lot->aggregate = NULL;
+  lot->aggregate_site = 0;
+  lot->zone_handler = NULL;
+  lot->zone_ctx = NULL;
+  lot->feed = NULL;
+  lot->text_mapping = NULL;
+  string_store_init(&lot->strings, &lot->memory);
+  parking_clock_init(&lot->clock);
+  timer_wheel_init(&lot->timers, parking_lot_now(lot));
+  timer_init(&lot->rollover_timer);
+  timer_wheel_add(&lot->timers, &lot->rollover_timer,
+                  parking_calendar_next_day(&lot->calendar,
+                                            lot->timers.current));
+  lot->event_handler = NULL;
+  lot->event_ctx = NULL;
+  lot->lock = parking_rwlock_create();
+  if (lot->lock == NULL) {
+    parking_memory_free(&lot->memory, lot);
+    return NULL;
+  }
+  presize_parking_lot(lot, total_slots);
+  return lot;
+}
+
+/**
+ * @brief 读取停车场按类别的内存统计。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收统计快照；lot 为 NULL 时清零。
+ */
+void get_parking_memory_stats(const ParkingLot *lot, ParkingMemoryStats *stats) {
+  if (stats == NULL) {
+    return;
+  }
+  if (lot == NULL) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+  parking_memory_read(&lot->memory, stats);
+}
+
+/**
+ * @brief 创建一个新的停车位对象。
+ * @details 为单个停车位分配内存并初始化其属性。新创建的车位状态默认为空闲。
+ * @param slot_id 要创建的车位的唯一编号。
+ * @param location 车位的物理位置描述。
+ * @return 成功时返回指向新分配的 ParkingSlot 对象的指针，若内存分配失败则返回
+ * NULL。
+ */
+ParkingSlot *create_parking_slot(int slot_id, const char *location) {
+  ParkingSlot *slot = (ParkingSlot *)malloc(sizeof(ParkingSlot));
+  if (slot == NULL) {
+    return NULL;
+  }
+
+  if (init_slot_fields(slot, slot_id, location, SLOT_STORAGE_HEAP, NULL) != 0) {
+    free(slot);
+    return NULL;
+  }
+  return slot;
+}
+
+/**
+ * @brief (静态辅助函数) 把已在编号索引中的车位登记到稠密车位表和车位链表。
+ * @details 失败时编号索引中的登记保持不变，由调用者撤销。
+ * @param lot 目标停车场。
+ * @param slot 要添加的停车位节点。
+ * @param order_entries 转交 slot_table_append，见其说明。
+ * @return 成功返回 0，文本存储或车位表扩容失败返回 -3。
+ */
+static int attach_indexed_slot(ParkingLot *lot, ParkingSlot *slot,
+                               int order_entries) {
+  if ((slot->strings != &lot->strings &&
+       slot_move_strings(slot, &lot->strings) != 0) ||
+      slot_table_append(lot, slot, order_entries) != 0) {
+    return -3;
+  }
+  if (slot->storage == SLOT_STORAGE_HEAP) {
+    lot->heap_slot_count++;
+  }
+
+  /* 头插法，新车位成为新的头节点 */
+  slot->next = lot->slot_head;
+  lot->slot_head = slot;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 把车位登记到编号索引、稠密车位表和车位链表。
+ * @param lot 目标停车场。
+ * @param slot 要添加的停车位节点。
+ * @param order_entries 转交 slot_table_append，见其说明。
+ * @return 成功返回 0，若车位ID已存在返回 -2，若内存分配失败返回 -3。
+ */
+static int attach_slot(ParkingLot *lot, ParkingSlot *slot, int order_entries) {
+  int index_result;
+
+  index_result = slot_id_index_insert(&lot->id_index, slot->slot_id, slot);
+  if (index_result == -2) {
+    return -2; /* ID already exists */
+  }
+  if (index_result != 0) {
+    return -3; /* 索引扩容失败 */
+  }
+  if (attach_indexed_slot(lot, slot, order_entries) != 0) {
+    slot_id_index_remove(&lot->id_index, slot->slot_id);
+    return -3; /* 文本存储或车位表扩容失败 */
+  }
+  return 0;
+}
+
+/**
+ * @brief 将一个已创建的停车位添加到停车场链表中。
+ * @details
+ * 使用头插法将车位节点添加到链表，并登记到车位编号索引和稠密车位表。
+ * 重复ID检查由索引插入一次完成，无需遍历链表。
+ * 单独创建的车位在登记时把文本迁入停车场的文本存储。
+ * @param lot 目标停车场。
+ * @param slot 要添加的停车位节点。
+ * @return 成功返回 0，若参数无效返回 -1，若车位ID已存在返回 -2，
+ * 若索引内存分配失败返回 -3。
+ */
+int add_parking_slot(ParkingLot *lot, ParkingSlot *slot) {
+  int result;
+
+  if (!lot || !slot) {
+    return -1;
+  }
+
+  result = attach_slot(lot, slot, 1);
+  if (result == 0 && journal_wanted(lot)) {
+    JournalRecord record;
+    journal_record_init(&record, JOURNAL_OP_ADD_SLOT, slot->slot_id);
+    strcpy(record.location, slot->location);
+    journal_log(lot, &record);
+  }
+  return result;
+}
+
+/**
+ * @brief 从停车场自有的内存池中创建一个车位并加入停车场。
+ * @details 重复ID在取用内存池之前就会被拒绝，失败时节点立即归还内存池。
+ * @param lot 目标停车场。
+ * @param slot_id 要创建的车位的唯一编号。
+ * @param location 车位的物理位置描述。
+ * @return 成功返回 0，若参数无效返回 -1，若车位ID已存在返回 -2，
+ * 若内存分配失败返回 -3。
+ */
+int create_and_add_slot(ParkingLot *lot, int slot_id, const char *location) {
+  ParkingSlot *slot;
+  int add_result;
+
+  if (lot == NULL || location == NULL) {
+    return -1;
+  }
+  if (find_slot_by_id(lot, slot_id) != NULL) {
+    return -2;
+  }
+
+  slot = arena_alloc_slot(lot);
+  if (slot == NULL) {
+    return -3;
+  }
+  if (init_slot_fields(slot, slot_id, location, SLOT_STORAGE_ARENA,
+                       &lot->strings) != 0) {
+    arena_release_slot(lot, slot);
+    return -3;
+  }
+
+  add_result = add_parking_slot(lot, slot);
+  if (add_result != 0) {
+    arena_release_slot(lot, slot);
+  }
+  return add_result;
+}
+
+/**
+ * @brief (静态辅助函数) qsort 比较函数：按车位编号升序。
+ * @param a 指向 int 的指针。
+ * @param b 指向 int 的指针。
+ * @return 比较结果。
+ */
+static int compare_slot_ids(const void *a, const void *b) {
+  int left = *(const int *)a;
+  int right = *(const int *)b;
+
+  return left < right ? -1 : left > right ? 1 : 0;
+}
+
+/**
+ * @brief (静态辅助函数) 检查一批车位编号是否彼此重复或与已有车位重复。
+ * @param lot 目标停车场。
+ * @param slot_ids 车位编号数组。
+ * @param count 编号个数。
+ * @param[out] conflict_id 发现重复时接收该编号，可以为 NULL。
+ * @return 没有重复返回 0，有重复返回 -2，内存不足返回 -3。
+ */
+static int check_new_slot_ids(ParkingLot *lot, const int *slot_ids,
+                              int count, int *conflict_id) {
+  ParkingMemory *memory = &lot->memory;
+  int *sorted;
+  int result = 0;
+  int i;
+
+  sorted = (int *)parking_memory_alloc(memory, PARKING_MEMORY_IO,
+                                       (size_t)count * sizeof(int));
+  if (sorted == NULL) {
+    return -3;
+  }
+  memcpy(sorted, slot_ids, (size_t)count * sizeof(int));
+  qsort(sorted, (size_t)count, sizeof(int), compare_slot_ids);
+  for (i = 0; i < count && result == 0; i++) {
+    if ((i > 0 && sorted[i] == sorted[i - 1]) ||
+        slot_id_index_find(&lot->id_index, sorted[i]) != NULL) {
+      if (conflict_id != NULL) {
+        *conflict_id = sorted[i];
+      }
+      result = -2;
+    }
+  }
+  parking_memory_free(memory, sorted);
+  return result;
+}
+
+/**
+ * @brief 从停车场自有的内存池中批量创建车位并加入停车场。
+ * @details
+ * 先对编号排序，一次找出批内重复和与已有车位重复的编号；再按最终规模
+ * 预留车位表和编号索引，取出并初始化全部节点；最后逐个登记，
+ * 登记过程中不再扩容，也不再有失败路径。
+ * 任何检查或分配失败时不添加任何车位。
+ * @param lot 目标停车场。
+ * @param slot_ids 车位编号数组。
+ * @param locations 与编号一一对应的位置描述数组。
+ * @param count 车位个数。
+ * @param[out] conflict_id 返回 -2 时接收重复的编号，可以为 NULL。
+ * @return 成功返回 0，若参数无效返回 -1，若有重复编号返回 -2，
+ * 若内存分配失败返回 -3。
+ */
+int create_and_add_slots(ParkingLot *lot, const int *slot_ids,
+                         const char *const *locations, int count,
+                         int *conflict_id) {
+  ParkingSlot **nodes;
+  int result;
+  int i;
+
+  if (lot == NULL || slot_ids == NULL || locations == NULL || count < 0) {
+    return -1;
+  }
+  for (i = 0; i < count; i++) {
+    if (locations[i] == NULL) {
+      return -1;
+    }
+  }
+  if (count == 0) {
+    return 0;
+  }
+  result = check_new_slot_ids(lot, slot_ids, count, conflict_id);
+  if (result != 0) {
+    return result;
+  }
+  if (slot_table_reserve(lot, lot->slot_count + count) != 0 ||
+      slot_id_index_reserve(&lot->id_index,
+                            (size_t)lot->slot_count + (size_t)count) != 0) {
+    return -3;
+  }
+
+  nodes = (ParkingSlot **)parking_memory_alloc(
+      &lot->memory, PARKING_MEMORY_IO, (size_t)count * sizeof(ParkingSlot *));
+  if (nodes == NULL) {
+    return -3;
+  }
+  for (i = 0; i < count; i++) {
+    nodes[i] = arena_alloc_slot(lot);
+    if (nodes[i] == NULL ||
+        init_slot_fields(nodes[i], slot_ids[i], locations[i],
+                         SLOT_STORAGE_ARENA, &lot->strings) != 0) {
+      if (nodes[i] != NULL) {
+        arena_release_slot(lot, nodes[i]);
+      }
+      while (i-- > 0) {
+        arena_release_slot(lot, nodes[i]);
+      }
+      parking_memory_free(&lot->memory, nodes);
+      return -3;
+    }
+  }
+
+  /* 容量已经预留，编号已经查重，登记不会失败 */
+  for (i = 0; i < count; i++) {
+    add_parking_slot(lot, nodes[i]);
+  }
+  parking_memory_free(&lot->memory, nodes);
+  return 0;
+}
+
+/**
+ * @brief 将车位节点的热字段同步到停车场的热字段列。
+ * @param lot 车位所属的停车场。
+ * @param slot 已加入该停车场的车位节点。
+ * @details 计数器会随之按新旧状态调整。
+ * @return 成功返回 0，若参数无效或车位不属于该停车场返回 -1。
+ */
+int sync_slot_hot_fields(ParkingLot *lot, const ParkingSlot *slot) {
+  if (lot == NULL || slot == NULL || slot->table_index < 0 ||
+      slot->table_index >= lot->slot_count ||
+      lot->slot_table[slot->table_index] != slot) {
+    return -1;
+  }
+  hot_row_replace(lot, slot->table_index, slot);
+  snapshot_mark_dirty(lot, slot->table_index);
+
+  if (journal_wanted(lot)) {
+    JournalRecord record;
+    journal_record_init(&record, JOURNAL_OP_SYNC_SLOT, slot->slot_id);
+    record.status = slot->status;
+    record.type = slot->type;
+    record.entry_time = slot->entry_time;
+    record.exit_time = slot->exit_time;
+    record.due_date = slot->resident_due_date;
+    journal_log(lot, &record);
+  }
+  return 0;
+}
+
+/**
+ * @brief 根据车位编号查找停车位。
+ * @details 通过停车场持有的车位编号哈希索引查找，时间复杂度为常数级。
+ * @param lot 目标停车场。
+ * @param slot_id 要查找的车位编号。
+ * @return 若找到，返回对应的 ParkingSlot 指针；否则返回 NULL。
+ */
+ParkingSlot *find_slot_by_id(ParkingLot *lot, int slot_id) {
+  if (!lot) {
+    return NULL;
+  }
+  return slot_id_index_find(&lot->id_index, slot_id);
+}
+
+/**
+ * @brief 取车位的带代号句柄。
+ * @param lot 车位所属的停车场。
+ * @param slot 已加入该停车场的车位。
+ * @return 车位的句柄；参数无效或车位不在停车场中时返回全零句柄。
+ */
+SlotHandle get_slot_handle(const ParkingLot *lot, const ParkingSlot *slot) {
+  SlotHandle none;
+
+  if (lot == NULL || slot == NULL || slot->table_index < 0 ||
+      slot->table_index >= lot->slot_count ||
+      lot->slot_table[slot->table_index] != slot) {
+    none.index = 0;
+    none.generation = 0;
+    return none;
+  }
+  return slot_handle_table_get(&lot->handles, slot->handle_index);
+}
+
+/**
+ * @brief 按句柄查找车位。
+ * @param lot 目标停车场。
+ * @param handle 由 get_slot_handle 取得的句柄。
+ * @return 句柄仍然有效时返回车位，车位已被删除或句柄不属于该停车场时返回 NULL。
+ */
+ParkingSlot *find_slot_by_handle(const ParkingLot *lot, SlotHandle handle) {
+  if (lot == NULL) {
+    return NULL;
+  }
+  return slot_handle_table_resolve(&lot->handles, handle);
+}
+
+/**
+ * @brief 根据车牌号查找停车位。
+ * @details 通过在场车牌号哈希索引查找，不再遍历车位链表。
+ * @note 索引只登记状态为 OCCUPIED_STATUS 的车位，因此结果必然是已占用车位。
+ * @param lot 目标停车场。
+ * @param license_plate 要查找的车牌号。
+ * @return 若找到，返回对应的 ParkingSlot 指针；否则返回 NULL。
+ */
+ParkingSlot *find_slot_by_license(ParkingLot *lot, const char *license_plate) {
+  if (lot == NULL || license_plate == NULL) {
+    return NULL;
+  }
+  return plate_index_find(&lot->plate_index, license_plate);
+}
+
+/**
+ * @brief (静态辅助函数) 取出车位中参与子串检索的字段。
+ * @param slot 车位节点。
+ * @param field 检索的字段。
+ * @return 字段字符串。
+ */
+static const char *search_field_text(const ParkingSlot *slot,
+                                     SlotSearchField field) {
+  return field == SLOT_SEARCH_OWNER ? slot->owner_name : slot->license_plate;
+}
+
+/**
+ * @brief 按车牌号或车主姓名的子串检索全部在场车辆。
+ * @details 候选来自查询串各三元组中最短的倒排表，逐个核对登记戳、
+ *          占用状态与字段内容；查询串不足三个字节或索引不完整时扫描在场车位。
+ * @param lot 目标停车场。
+ * @param field 检索的字段。
+ * @param query 要查找的子串。
+ * @param[out] slots 接收匹配车位的数组，可以为 NULL。
+ * @param capacity slots 数组的容量。
+ * @return 匹配的车位总数；参数无效时返回 -1。
+ */
+int search_slots(ParkingLot *lot, SlotSearchField field, const char *query,
+                 ParkingSlot **slots, int capacity) {
+  const TrigramEntry *entries;
+  size_t count;
+  size_t i;
+  int found = 0;
+
+  if (lot == NULL || query == NULL ||
+      (field != SLOT_SEARCH_PLATE && field != SLOT_SEARCH_OWNER)) {
+    return -1;
+  }
+  if (slots == NULL) {
+    capacity = 0;
+  }
+
+  if (lot->search_index.degraded ||
+      trigram_index_candidates(&lot->search_index, field, query, &entries,
+                               &count) != 0) {
+    int row;
+
+    for (row = 0; row < lot->slot_count; row++) {
+      ParkingSlot *slot = lot->slot_table[row];
+
+      if (lot->hot.status[row] == OCCUPIED_STATUS &&
+          strstr(search_field_text(slot, field), query) != NULL) {
+        if (found < capacity) {
+          slots[found] = slot;
+        }
+        found++;
+      }
+    }
+    return found;
+  }
+
+  for (i = 0; i < count; i++) {
+    ParkingSlot *slot = find_slot_by_handle(lot, entries[i].handle);
+
+    if (slot == NULL || entries[i].stamp != slot->search_stamp ||
+        slot->status != OCCUPIED_STATUS ||
+        strstr(search_field_text(slot, field), query) == NULL) {
+      continue;
+    }
+    if (found < capacity) {
+      slots[found] = slot;
+    }
+    found++;
+  }
+  return found;
+}
+
+/**
+ * @brief 根据车主姓名查找停车位（模糊查找）。
+ * @details 使用 search_slots 的子串检索，只取第一个匹配。
+ * @note 只在状态为 OCCUPIED_STATUS 的车位中进行查找。
+ * @param lot 目标停车场。
+ * @param owner_name 要查找的车主姓名（或姓名的一部分）。
+ * @return 若找到，返回一个匹配的 ParkingSlot 指针；否则返回 NULL。
+ */
+ParkingSlot *find_slot_by_owner(ParkingLot *lot, const char *owner_name) {
+  ParkingSlot *slot = NULL;
+
+  if (search_slots(lot, SLOT_SEARCH_OWNER, owner_name, &slot, 1) <= 0) {
+    return NULL;
+  }
+  return slot;
+}
+
+/**
+ * @brief (静态辅助函数) 查找此时保留着车位的预约。
+ * @details 预约从开始前 RESERVATION_HOLD_LEAD_SECONDS 秒到结束为止保留车位。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param now 当前时间。
+ * @return 保留着该车位的预约，没有时返回 NULL。
+ */
+static const Reservation *slot_hold(const ParkingLot *lot, int slot_id,
+                                    time_t now) {
+  if (lot->reservations == NULL) {
+    return NULL;
+  }
+  return reservation_book_overlap(lot->reservations, slot_id, now,
+                                  now + RESERVATION_HOLD_LEAD_SECONDS + 1);
+}
+
+/**
+ * @brief (静态辅助函数) 检查车位的分配池与固定车位是否接纳某辆车。
+ * @param lot 目标停车场。
+ * @param slot 目标车位。
+ * @param type 停车类型。
+ * @param license_plate 车牌号，可以为 NULL。
+ * @return 接纳返回 1，否则返回 0。
+ */
+static int slot_admits(const ParkingLot *lot, const ParkingSlot *slot,
+                       ParkingType type, const char *license_plate) {
+  if (slot->has_home) {
+    return home_table_find(lot->homes, license_plate) == slot->slot_id;
+  }
+  if (slot->pool == SLOT_POOL_RESIDENT) {
+    return type == RESIDENT_TYPE;
+  }
+  if (slot->pool == SLOT_POOL_VISITOR) {
+    return type == VISITOR_TYPE;
+  }
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 检查车位是否正为其他车牌的预约保留。
+ * @param lot 目标停车场。
+ * @param slot 目标车位。
+ * @param license_plate 入场的车牌号，可以为 NULL。
+ * @param[in,out] now 当前时刻的缓存，0 表示尚未读取。
+ * @return 为其他车牌保留返回 1，否则返回 0。
+ */
+static int slot_held_for_other(const ParkingLot *lot, const ParkingSlot *slot,
+                               const char *license_plate, time_t *now) {
+  const Reservation *hold;
+
+  if (lot->reservations == NULL || lot->reservations->reservation_count == 0) {
+    return 0;
+  }
+  if (*now == 0) {
+    *now = parking_lot_now(lot);
+  }
+  hold = slot_hold(lot, slot->slot_id, *now);
+  return hold != NULL && (license_plate == NULL ||
+                          strcmp(hold->license_plate, license_plate) != 0);
+}
+
+/**
+ * @brief (静态辅助函数) 在一个分配池中查找可以入场的空闲车位。
+ * @details 位图中第一个车位正为其他车牌保留时，再逐行检查其后的车位。
+ * @param lot 目标停车场。
+ * @param pool 分配池。
+ * @param license_plate 入场的车牌号，可以为 NULL。
+ * @param[in,out] now 当前时刻的缓存，0 表示尚未读取。
+ * @return 空闲车位，没有时返回 NULL。
+ */
+static ParkingSlot *pool_pick(ParkingLot *lot, SlotPool pool,
+                              const char *license_plate, time_t *now) {
+  const SlotBitmap *bitmap = &lot->pool_free[pool];
+  long row = slot_bitmap_find_first(bitmap, (size_t)lot->slot_count);
+
+  if (row < 0) {
+    return NULL;
+  }
+  for (; row < lot->slot_count; row++) {
+    if (slot_bitmap_test(bitmap, (size_t)row) &&
+        !slot_held_for_other(lot, lot->slot_table[row], license_plate, now)) {
+      return lot->slot_table[row];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief 按停车类型查找一个可以入场的空闲车位。
+ * @details 固定车位不在任何分配池的位图中，只有登记的车牌能通过
+ *          固定车位表取到；其余车位按所属池分别登记，选位不逐个检查类型。
+ * @param lot 目标停车场。
+ * @param type 停车类型。
+ * @param license_plate 入场的车牌号，可以为 NULL。
+ * @return 若存在可用车位，返回其 ParkingSlot 指针；否则返回 NULL。
+ */
+ParkingSlot *find_free_slot_for(ParkingLot *lot, ParkingType type,
+                                const char *license_plate) {
+  ParkingSlot *slot;
+  time_t now = 0;
+
+  if (lot == NULL) {
+    return NULL;
+  }
+  if (type == RESIDENT_TYPE) {
+    slot = find_slot_by_id(lot, home_table_find(lot->homes, license_plate));
+    if (slot != NULL && slot->status == FREE_STATUS &&
+        !slot_held_for_other(lot, slot, license_plate, &now)) {
+      return slot;
+    }
+  }
+  slot = pool_pick(lot,
+                   type == RESIDENT_TYPE ? SLOT_POOL_RESIDENT
+                                         : SLOT_POOL_VISITOR,
+                   license_plate, &now);
+  if (slot == NULL) {
+    slot = pool_pick(lot, SLOT_POOL_SHARED, license_plate, &now);
+  }
+  return slot;
+}
+
+/**
+ * @brief 查找任意一个空闲车位。
+ * @details 空闲车位位图由入场、出场和增删车位同步维护，
+ * 查找时一次比较可跳过一整个机器字（64 位平台上为 64 个车位）的已占用车位。
+ * 位图中第一个空闲车位正被预约保留时，再用游标逐个检查其余空闲车位。
+ * @param lot 目标停车场。
+ * @return 若存在空闲车位，返回其 ParkingSlot 指针；否则返回 NULL。
+ */
+ParkingSlot *find_first_free_slot(ParkingLot *lot) {
+  SlotCursor cursor;
+  ParkingSlot *slot;
+  time_t now;
+  long row;
+
+  if (lot == NULL) {
+    return NULL;
+  }
+
+  row = slot_bitmap_find_first(&lot->free_map, (size_t)lot->slot_count);
+  if (row < 0) {
+    return NULL;
+  }
+  if (lot->reservations == NULL || lot->reservations->reservation_count == 0) {
+    return lot->slot_table[row];
+  }
+
+  now = parking_lot_now(lot);
+  slot_cursor_init(&cursor, lot, SLOT_FILTER_FREE);
+  cursor.next_row = (int)row;
+  while ((slot = slot_cursor_next(&cursor)) != NULL) {
+    if (slot_hold(lot, slot->slot_id, now) == NULL) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 检查访客车辆的入场时间是否在允许的时间段内。
+ * @details 与停车场日历缓存的当日访客时段（来自运行时配置）
+ *          时段比较，同一天内不再调用 localtime。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param entry_time 车辆的入场时间戳。
+ * @return 如果在允许时段内返回 1，否则返回 0。
+ */
+static int is_valid_visitor_time(ParkingLot *lot, time_t entry_time) {
+  return parking_calendar_in_window(visitor_calendar(lot), entry_time);
+}
+
+/**
+ * @brief (静态辅助函数) 把在场车位的车牌号与车主姓名登记到三元组索引。
+ * @details 内存不足时索引被标记为不完整，之后的检索退化为扫描，直到下次重建。
+ * @param lot 目标停车场。
+ * @param slot 已写入车主信息的车位。
+ */
+static void search_index_add(ParkingLot *lot, ParkingSlot *slot) {
+  SlotHandle handle = get_slot_handle(lot, slot);
+
+  if (trigram_index_insert(&lot->search_index, slot, handle,
+                           SLOT_SEARCH_PLATE, slot->license_plate) == 0) {
+    trigram_index_insert(&lot->search_index, slot, handle, SLOT_SEARCH_OWNER,
+                         slot->owner_name);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 按当前在场车位重建三元组索引，清除全部失效项。
+ * @param lot 目标停车场。
+ * @param skip 不重新登记的车位（正在注销的车位），可以为 NULL。
+ */
+static void search_index_rebuild(ParkingLot *lot, const ParkingSlot *skip) {
+  int i;
+
+  trigram_index_clear(&lot->search_index);
+  for (i = 0; i < lot->slot_count; i++) {
+    ParkingSlot *slot = lot->slot_table[i];
+
+    slot->search_entries = 0;
+    if (lot->hot.status[i] == OCCUPIED_STATUS && slot != skip) {
+      search_index_add(lot, slot);
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 注销在场车位在三元组索引中的登记。
+ * @details 注销只使登记失效；失效项比有效项多出 SEARCH_REBUILD_SLACK 时整体重建，
+ *          重建代价由此前的多次注销分摊。
+ * @param lot 目标停车场。
+ * @param slot 即将清空车主信息的车位。
+ */
+static void search_index_remove(ParkingLot *lot, ParkingSlot *slot) {
+  trigram_index_retire(&lot->search_index, slot);
+  if (lot->search_index.stale_entries >
+      lot->search_index.live_entries + SEARCH_REBUILD_SLACK) {
+    search_index_rebuild(lot, slot);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 更新车位信息，车主姓名变化时重新登记三元组索引。
+ * @details 修改信息与日志重放共用。
+ * @param lot 目标停车场。
+ * @param slot 目标车位。
+ * @param location 新的位置描述 (如果为NULL则不更新)。
+ * @param owner_name 新的车主姓名 (如果为NULL则不更新)。
+ * @param contact 新的联系方式 (如果为NULL则不更新)。
+ * @return 返回值同 update_slot_info。
+ */
+static int update_indexed_slot_info(ParkingLot *lot, ParkingSlot *slot,
+                                    const char *location,
+                                    const char *owner_name,
+                                    const char *contact) {
+  int result;
+
+  char old_location[MAX_LOCATION_LEN];
+  int zoned = lot->zones != NULL && location != NULL;
+
+  preserve_slot_snapshot(lot, slot);
+  if (zoned) {
+    string_copy_bounded(old_location, slot->location, MAX_LOCATION_LEN);
+  }
+  if (owner_name != NULL && slot->status == OCCUPIED_STATUS) {
+    search_index_remove(lot, slot);
+    result = update_slot_info(slot, location, owner_name, contact);
+    search_index_add(lot, slot);
+  } else {
+    result = update_slot_info(slot, location, owner_name, contact);
+  }
+  /* 位置改变后车位可能换了分区 */
+  if (zoned) {
+    zone_table_move(lot->zones, lot, old_location, slot->location,
+                    slot->status == FREE_STATUS);
+  }
+  parking_atomic_add_long(&lot->mutation_count, 1);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 把入场车牌计入当周与当月的不同车辆草图。
+ * @param lot 目标停车场。
+ * @param license_plate 入场的车牌号。
+ * @param entry_time 入场时间。
+ */
+static void count_distinct_plate(ParkingLot *lot, const char *license_plate,
+                                 time_t entry_time) {
+  PlateCode code;
+  long day;
+  long month;
+
+  if (entry_time <= 0) {
+    return;
+  }
+  plate_encode(license_plate, &code);
+  parking_calendar_lookup(&lot->calendar, entry_time, &day, &month);
+  distinct_counter_add(&lot->distinct_plates, day, month,
+                       plate_code_hash(&code));
+}
+
+/**
+ * @brief (静态辅助函数) 把停车场与各分区当前的占用数记入占用画像。
+ * @details 刻钟切换时各画像随之更新预测缓存，未切换时只记下占用率。
+ * @param lot 目标停车场（调用者持有写锁）。
+ * @param when 观测时刻。
+ */
+static void observe_forecasts(ParkingLot *lot, time_t when) {
+  ForecastTime at;
+  long day;
+
+  if (when <= 0) {
+    return;
+  }
+  parking_calendar_lookup(&lot->calendar, when, &day, NULL);
+  /* 周一为 0；时区偏移为整小时时，整点内的刻钟与本地一致 */
+  at.quarter = (long)(when / FORECAST_QUARTER_SECONDS);
+  at.cell = (int)((parking_calendar_day_number(day) + 1) % 7) *
+                FORECAST_QUARTERS_PER_DAY +
+            parking_calendar_hour(&lot->calendar, when) * 4 +
+            (int)(when % 3600 / FORECAST_QUARTER_SECONDS);
+  forecast_observe(&lot->forecast, &at, lot->occupied_slots, lot->slot_count);
+  if (lot->zones != NULL) {
+    zone_table_observe(lot->zones, &at);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 将车主信息写入空闲车位并标记为占用。
+ * @details 入场与日志重放共用，调用者负责事先完成业务检查。
+ * @param lot 目标停车场。
+ * @param slot 空闲车位。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号（调用者保证未在场内）。
+ * @param contact 联系方式，可以为 NULL。
+ * @param type 停车类型。
+ * @param entry_time 入场时间。
+ * @return 成功返回 0；文本内存不足或车牌号索引无法扩容返回 -1，
+ * 此时车位保持空闲。
+ */
+static int occupy_slot(ParkingLot *lot, ParkingSlot *slot,
+                       const char *owner_name, const char *license_plate,
+                       const char *contact, ParkingType type,
+                       time_t entry_time) {
+  preserve_slot_snapshot(lot, slot);
+  if (slot_set_text(slot, &slot->owner_name, owner_name, MAX_NAME_LEN) != 0 ||
+      slot_set_text(slot, &slot->license_plate, license_plate,
+                    MAX_LICENSE_LEN) != 0 ||
+      (contact != NULL && slot_set_text(slot, &slot->contact, contact,
+                                        MAX_CONTACT_LEN) != 0) ||
+      plate_index_insert(&lot->plate_index, slot) != 0) {
+    /* 文本或索引无法分配时回滚已写入的车主信息，车位保持空闲 */
+    slot_clear_occupant(slot);
+    return -1;
+  }
+
+  slot->type = type;
+  slot->entry_time = entry_time;
+  slot->exit_time = 0; /* 清除上一次的出场时间 */
+  slot->status = OCCUPIED_STATUS;
+  hot_row_replace(lot, slot->table_index, slot);
+  search_index_add(lot, slot);
+  count_distinct_plate(lot, slot->license_plate, entry_time);
+  observe_forecasts(lot, entry_time);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 记录出场时间并清空车位的占用信息。
+ * @details 出场与日志重放共用，调用者保证车位处于占用状态。
+ * @param lot 目标停车场。
+ * @param slot 已占用的车位。
+ * @param exit_time 出场时间。
+ */
+static void vacate_slot(ParkingLot *lot, ParkingSlot *slot, time_t exit_time) {
+  preserve_slot_snapshot(lot, slot);
+  slot->exit_time = exit_time;
+
+  /* 必须在清空车牌号之前注销索引 */
+  plate_index_remove(&lot->plate_index, slot);
+  search_index_remove(lot, slot);
+
+  /* 清空车位占用信息 */
+  slot_clear_occupant(slot);
+  slot->status = FREE_STATUS;
+  hot_row_replace(lot, slot->table_index, slot);
+  observe_forecasts(lot, exit_time);
+}
+
+/**
+ * @brief 分配一个停车位给车辆（车辆入场）。
+ * @details
+ * 为指定车位分配车辆。此函数会执行一系列检查：
+ * 1. 参数有效性。
+ * 2. 车位是否存在且空闲。
+ * 3. 该车牌号是否已在场内。
+ * 4. 车位是否正为其他车牌的预约保留。
+ * 5. 车位的分配池与固定车位是否接纳该车辆。
+ * 6. 对于访客车辆，入场时间是否在允许时段内。
+ * 检查通过后，更新车位信息、登记车牌号索引并调整停车场的计数器。
+ * @param lot 目标停车场。
+ * @param slot_id 要分配的车位编号。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 返回码：0 成功, -1 参数无效, -2 车位不存在, -3 车位已被占用, -4
+ * 该车牌号已在场内, -5 访客车辆在非允许时段入场, -6 车牌索引内存分配失败,
+ * -7 车位此时为其他车牌保留, -8 车牌在禁止入场名单中, -9 车位属于其他类型的
+ * 专用池或是其他车牌的固定车位。
+ */
+int allocate_slot(ParkingLot *lot, int slot_id, const char *owner_name,
+                  const char *license_plate, const char *contact,
+                  ParkingType type) {
+  const Reservation *hold;
+  ParkingSlot *slot;
+  time_t current_time;
+
+  if (lot == NULL || owner_name == NULL || license_plate == NULL) {
+    return -1; /* 参数无效 */
+  }
+
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot == NULL) {
+    return -2; /* 车位不存在 */
+  }
+
+  if (slot->status == OCCUPIED_STATUS) {
+    return -3; /* 车位已被占用 */
+  }
+
+  /* 检查车牌号是否已在其他车位 */
+  if (plate_index_find(&lot->plate_index, license_plate) != NULL) {
+    return -4; /* 车牌号已存在 */
+  }
+
+  if (parking_lot_plate_listed(lot, PLATE_LIST_BLOCKED, license_plate)) {
+    return -8; /* 车牌在禁止入场名单中 */
+  }
+
+  current_time = parking_lot_now(lot);
+
+  /* 车位正为预约保留时，只有预约的车辆可以入场 */
+  hold = slot_hold(lot, slot_id, current_time);
+  if (hold != NULL && strcmp(hold->license_plate, license_plate) != 0) {
+    return -7; /* 车位已为其他车牌保留 */
+  }
+
+  if (!slot_admits(lot, slot, type, license_plate)) {
+    return -9; /* 车位为其他类型或其他车牌专用 */
+  }
+
+  /* 对于访客车辆，检查入场时间；VIP 车辆不受时段限制 */
+  if (type == VISITOR_TYPE && !is_valid_visitor_time(lot, current_time) &&
+      !parking_lot_plate_listed(lot, PLATE_LIST_VIP, license_plate)) {
+    return -5; /* 访客车辆在非允许时段入场 */
+  }
+
+  /* 分配车位并填充信息 */
+  if (occupy_slot(lot, slot, owner_name, license_plate, contact, type,
+                  current_time) != 0) {
+    return -6;
+  }
+  if (hold != NULL) {
+    /* 预约的车辆已入场，预约就此兑现 */
+    reservation_book_remove(lot->reservations, slot_id, hold->id);
+  }
+
+  if (journal_wanted(lot)) {
+    JournalRecord record;
+    journal_record_init(&record, JOURNAL_OP_ALLOCATE, slot_id);
+    record.type = type;
+    record.entry_time = current_time;
+    strcpy(record.owner_name, slot->owner_name);
+    strcpy(record.license_plate, slot->license_plate);
+    strcpy(record.contact, slot->contact);
+    journal_log(lot, &record);
+  }
+
+  return 0; /* 成功 */
+}
+
+/**
+ * @brief 释放一个停车位（车辆出场）。
+ * @details
+ * 检查车位是否存在且状态为已占用。成功后，记录出场时间，注销车牌号索引，
+ * 清空车主相关信息，将车位状态设置为空闲，并调整停车场的计数器。
+ * @param lot 目标停车场。
+ * @param slot_id 要释放的车位编号。
+ * @return 返回码：0 成功, -1 停车场对象为空, -2 车位不存在, -3
+ * 车位本就是空闲状态。
+ */
+int deallocate_slot(ParkingLot *lot, int slot_id) {
+  return deallocate_slot_at(lot, slot_id, parking_lot_now(lot));
+}
+
+/**
+ * @brief (静态辅助函数) 在车辆出场前把车位上的车辆资料记入缓存。
+ * @details 缓存在第一次出场时创建；创建失败时本次不缓存，不影响出场。
+ * @param lot 目标停车场。
+ * @param slot 即将清空的已占用车位。
+ * @param exit_time 出场时间。
+ */
+static void remember_session(ParkingLot *lot, const ParkingSlot *slot,
+                             time_t exit_time) {
+  VehicleSession session;
+  const char *zone;
+
+  if (lot->session_capacity <= 0 || slot->license_plate == NULL) {
+    return;
+  }
+  if (lot->sessions == NULL) {
+    lot->sessions = session_cache_create(&lot->memory, lot->session_capacity);
+    if (lot->sessions == NULL) {
+      return;
+    }
+  }
+
+  memset(&session, 0, sizeof(session));
+  string_copy_bounded(session.license_plate, slot->license_plate,
+                      MAX_LICENSE_LEN);
+  string_copy_bounded(session.owner_name, slot->owner_name, MAX_NAME_LEN);
+  string_copy_bounded(session.contact, slot->contact, MAX_CONTACT_LEN);
+  zone = zone_table_match(lot->zones, slot->location);
+  string_copy_bounded(session.zone, zone, MAX_LOCATION_LEN);
+  session.type = slot->type;
+  session.last_exit = exit_time;
+  session_cache_put(lot->sessions, &session);
+}
+
+/**
+ * @brief 以指定的出场时间释放一个停车位。
+ * @param lot 目标停车场。
+ * @param slot_id 要释放的车位编号。
+ * @param exit_time 出场时间。
+ * @return 返回码同 deallocate_slot。
+ */
+int deallocate_slot_at(ParkingLot *lot, int slot_id, time_t exit_time) {
+  ParkingSlot *slot;
+
+  if (lot == NULL) {
+    return -1; /* 停车场对象为空 */
+  }
+
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot == NULL) {
+    return -2; /* 车位不存在 */
+  }
+
+  if (slot->status == FREE_STATUS) {
+    return -3; /* 车位本就是空闲状态 */
+  }
+
+  remember_session(lot, slot, exit_time);
+  vacate_slot(lot, slot, exit_time);
+
+  if (journal_wanted(lot)) {
+    JournalRecord record;
+    journal_record_init(&record, JOURNAL_OP_DEALLOCATE, slot_id);
+    record.exit_time = slot->exit_time;
+    journal_log(lot, &record);
+  }
+
+  return 0; /* 成功 */
+}
+
+/**
+ * @brief (静态辅助函数) 判断车位是否属于位置前缀表示的分区。
+ * @param slot 车位。
+ * @param zone 位置描述前缀。
+ * @param length 前缀长度，0 表示整个停车场。
+ * @return 属于返回 1，否则返回 0。
+ */
+static int slot_in_zone(const ParkingSlot *slot, const char *zone,
+                        size_t length) {
+  return length == 0 ||
+         (slot->location != NULL && strncmp(slot->location, zone, length) == 0);
+}
+
+/**
+ * @brief (静态辅助函数) 判断车位在 [start, end) 内能否预约。
+ * @param lot 目标停车场。
+ * @param slot 车位。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @param now 当前时间。
+ * @return 能预约返回 1，否则返回 0。
+ */
+static int slot_available(const ParkingLot *lot, const ParkingSlot *slot,
+                          time_t start, time_t end, time_t now) {
+  if (slot->status == OCCUPIED_STATUS && start <= now) {
+    return 0; /* 时段已经开始，车位上还停着车 */
+  }
+  return lot->reservations == NULL ||
+         reservation_book_overlap(lot->reservations, slot->slot_id, start,
+                                  end) == NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 检查预约参数。
+ * @param license_plate 车牌号。
+ * @param start 开始时间。
+ * @param end 结束时间。
+ * @param now 当前时间。
+ * @return 有效返回 1，否则返回 0。
+ */
+static int valid_reservation(const char *license_plate, time_t start,
+                             time_t end, time_t now) {
+  return license_plate != NULL && license_plate[0] != '\0' &&
+         strlen(license_plate) < MAX_LICENSE_LEN && start < end && end > now;
+}
+
+/**
+ * @brief (静态辅助函数) 在已检查过的车位上登记预约。
+ * @param lot 目标停车场。
+ * @param slot 车位。
+ * @param license_plate 车牌号。
+ * @param start 开始时间。
+ * @param end 结束时间。
+ * @param now 当前时间。
+ * @param[out] reservation 接收新预约，可以为 NULL。
+ * @return 0 成功, -3 与已有预约重叠, -6 内存分配失败。
+ */
+static int book_reservation(ParkingLot *lot, const ParkingSlot *slot,
+                            const char *license_plate, time_t start,
+                            time_t end, time_t now, Reservation *reservation) {
+  Reservation entry;
+  long id;
+
+  if (lot->reservations == NULL) {
+    lot->reservations = reservation_book_create(&lot->memory);
+    if (lot->reservations == NULL) {
+      return -6;
+    }
+  }
+
+  memset(&entry, 0, sizeof(entry));
+  entry.slot_id = slot->slot_id;
+  entry.start = start;
+  entry.end = end;
+  strcpy(entry.license_plate, license_plate);
+  id = reservation_book_add(lot->reservations, &entry, now);
+  if (id == -1) {
+    return -3;
+  }
+  if (id < 0) {
+    return -6;
+  }
+  entry.id = id;
+  if (reservation != NULL) {
+    *reservation = entry;
+  }
+  return 0;
+}
+
+/**
+ * @brief 为车牌预约一个车位的一段时间。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param license_plate 预约的车牌号。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @param[out] reservation 接收新预约，可以为 NULL。
+ * @return 0 成功, -1 参数无效, -2 车位不存在, -3 该时段已被预约或车位正被占用,
+ * -6 内存分配失败。
+ */
+int reserve_slot(ParkingLot *lot, int slot_id, const char *license_plate,
+                 time_t start, time_t end, Reservation *reservation) {
+  ParkingSlot *slot;
+  time_t now;
+
+  if (lot == NULL) {
+    return -1;
+  }
+  now = parking_lot_now(lot);
+  if (!valid_reservation(license_plate, start, end, now)) {
+    return -1;
+  }
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot == NULL) {
+    return -2;
+  }
+  if (!slot_available(lot, slot, start, end, now)) {
+    return -3;
+  }
+  return book_reservation(lot, slot, license_plate, start, end, now,
+                          reservation);
+}
+
+/**
+ * @brief 在一个分区内预约任意一个该时段空闲的车位。
+ * @param lot 目标停车场。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param license_plate 预约的车牌号。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @param[out] reservation 接收新预约，可以为 NULL。
+ * @return 0 成功, -1 参数无效, -2 分区内没有可用车位, -6 内存分配失败。
+ */
+int reserve_zone_slot(ParkingLot *lot, const char *zone,
+                      const char *license_plate, time_t start, time_t end,
+                      Reservation *reservation) {
+  ParkingSlot *slot;
+  time_t now;
+
+  if (lot == NULL) {
+    return -1;
+  }
+  now = parking_lot_now(lot);
+  if (!valid_reservation(license_plate, start, end, now)) {
+    return -1;
+  }
+  slot = find_available_slot(lot, zone, start, end);
+  if (slot == NULL) {
+    return -2;
+  }
+  return book_reservation(lot, slot, license_plate, start, end, now,
+                          reservation);
+}
+
+/**
+ * @brief 取消一条预约。
+ * @param lot 目标停车场。
+ * @param slot_id 预约的车位编号。
+ * @param reservation_id 预约编号。
+ * @return 0 成功, -1 参数无效, -2 预约不存在。
+ */
+int cancel_reservation(ParkingLot *lot, int slot_id, long reservation_id) {
+  if (lot == NULL || reservation_id <= 0) {
+    return -1;
+  }
+  if (lot->reservations == NULL ||
+      reservation_book_remove(lot->reservations, slot_id, reservation_id) !=
+          0) {
+    return -2;
+  }
+  return 0;
+}
+
+/**
+ * @brief 查找分区内在 [start, end) 可以预约的第一个车位。
+ * @param lot 目标停车场。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @return 可用的车位；没有或参数无效时返回 NULL。
+ */
+ParkingSlot *find_available_slot(ParkingLot *lot, const char *zone,
+                                 time_t start, time_t end) {
+  size_t length;
+  time_t now;
+  int row;
+
+  if (lot == NULL || start >= end) {
+    return NULL;
+  }
+  length = zone != NULL ? strlen(zone) : 0;
+  now = parking_lot_now(lot);
+  for (row = 0; row < lot->slot_count; row++) {
+    ParkingSlot *slot = lot->slot_table[row];
+
+    if (slot_in_zone(slot, zone, length) &&
+        slot_available(lot, slot, start, end, now)) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief 统计分区内在 [start, end) 可以预约的车位数。
+ * @param lot 目标停车场。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @return 可用车位数；参数无效时返回 -1。
+ */
+int count_available_slots(ParkingLot *lot, const char *zone, time_t start,
+                          time_t end) {
+  size_t length;
+  time_t now;
+  int count = 0;
+  int row;
+
+  if (lot == NULL || start >= end) {
+    return -1;
+  }
+  length = zone != NULL ? strlen(zone) : 0;
+  now = parking_lot_now(lot);
+  for (row = 0; row < lot->slot_count; row++) {
+    ParkingSlot *slot = lot->slot_table[row];
+
+    count += slot_in_zone(slot, zone, length) &&
+             slot_available(lot, slot, start, end, now);
+  }
+  return count;
+}
+
+/**
+ * @brief 设置车位所属的分配池。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param pool 分配池。
+ * @return 0 成功, -1 参数无效, -2 车位不存在, -3 车位是固定车位。
+ */
+int set_slot_pool(ParkingLot *lot, int slot_id, SlotPool pool) {
+  ParkingSlot *slot;
+
+  if (lot == NULL || (int)pool < 0 || pool >= SLOT_POOL_KINDS) {
+    return -1;
+  }
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot == NULL) {
+    return -2;
+  }
+  if (slot->has_home && pool != SLOT_POOL_RESIDENT) {
+    return -3;
+  }
+  slot->pool = (unsigned char)pool;
+  pool_row_store(lot, slot->table_index, slot);
+  return 0;
+}
+
+/**
+ * @brief 为居民车牌登记固定车位。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @param slot_id 车位编号。
+ * @return 0 成功, -1 参数无效, -2 车位不存在, -3 车位是其他车牌的固定车位
+ * 或正被其他车辆占用, -6 内存分配失败。
+ */
+int assign_home_slot(ParkingLot *lot, const char *license_plate, int slot_id) {
+  ParkingSlot *previous;
+  ParkingSlot *slot;
+  int current;
+  int result;
+
+  if (lot == NULL || license_plate == NULL || license_plate[0] == '\0') {
+    return -1;
+  }
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot == NULL) {
+    return -2;
+  }
+  current = home_table_find(lot->homes, license_plate);
+  if (current == slot_id) {
+    return 0;
+  }
+  if (slot->has_home || (slot->status == OCCUPIED_STATUS &&
+                         strcmp(slot->license_plate, license_plate) != 0)) {
+    return -3;
+  }
+  if (lot->homes == NULL) {
+    lot->homes = home_table_create(&lot->memory);
+    if (lot->homes == NULL) {
+      return -6;
+    }
+  }
+  result = home_table_set(lot->homes, license_plate, slot_id);
+  if (result != 0) {
+    return result == -1 ? -1 : -6;
+  }
+
+  previous = find_slot_by_id(lot, current);
+  if (previous != NULL) {
+    /* 原固定车位留在居民池，重新出现在居民池的空闲位图中 */
+    previous->has_home = 0;
+    pool_row_store(lot, previous->table_index, previous);
+  }
+  slot->pool = SLOT_POOL_RESIDENT;
+  slot->has_home = 1;
+  pool_row_store(lot, slot->table_index, slot);
+  return 0;
+}
+
+/**
+ * @brief 撤销居民车牌的固定车位，车位留在居民池。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @return 原固定车位的编号；参数无效或未登记返回 0。
+ */
+int release_home_slot(ParkingLot *lot, const char *license_plate) {
+  ParkingSlot *slot;
+  int slot_id;
+
+  if (lot == NULL) {
+    return 0;
+  }
+  slot_id = home_table_remove(lot->homes, license_plate);
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot != NULL) {
+    slot->has_home = 0;
+    pool_row_store(lot, slot->table_index, slot);
+  }
+  return slot_id;
+}
+
+/**
+ * @brief 查找居民车牌的固定车位。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @return 固定车位的编号；参数无效或未登记返回 0。
+ */
+int find_home_slot(const ParkingLot *lot, const char *license_plate) {
+  if (lot == NULL) {
+    return 0;
+  }
+  return home_table_find(lot->homes, license_plate);
+}
+
+/**
+ * @brief 登记或修改车位的平面坐标。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 0 成功, -1 参数无效, -2 车位不存在, -3 内存分配失败。
+ */
+int set_slot_position(ParkingLot *lot, int slot_id, long x, long y) {
+  if (lot == NULL) {
+    return -1;
+  }
+  if (find_slot_by_id(lot, slot_id) == NULL) {
+    return -2;
+  }
+  if (lot->layout == NULL) {
+    lot->layout = layout_create(&lot->memory);
+    if (lot->layout == NULL) {
+      return -3;
+    }
+  }
+  return layout_set_point(lot->layout, slot_id, x, y) == 0 ? 0 : -3;
+}
+
+/**
+ * @brief 清除车位的平面坐标。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @return 0 成功, -1 参数无效, -2 车位没有登记坐标。
+ */
+int clear_slot_position(ParkingLot *lot, int slot_id) {
+  if (lot == NULL) {
+    return -1;
+  }
+  if (lot->layout == NULL || layout_clear_point(lot->layout, slot_id) != 0) {
+    return -2;
+  }
+  return 0;
+}
+
+/**
+ * @brief 读取车位的平面坐标。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param[out] x 接收横坐标。
+ * @param[out] y 接收纵坐标。
+ * @return 0 成功, -1 参数无效, -2 车位没有登记坐标。
+ */
+int get_slot_position(const ParkingLot *lot, int slot_id, long *x, long *y) {
+  if (lot == NULL || x == NULL || y == NULL) {
+    return -1;
+  }
+  if (lot->layout == NULL ||
+      layout_get_point(lot->layout, slot_id, x, y) != 0) {
+    return -2;
+  }
+  return 0;
+}
+
+/**
+ * @brief 登记或修改一个命名地标的坐标。
+ * @param lot 目标停车场。
+ * @param name 地标名称。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 0 成功, -1 参数无效, -3 内存分配失败。
+ */
+int set_parking_landmark(ParkingLot *lot, const char *name, long x, long y) {
+  int result;
+
+  if (lot == NULL) {
+    return -1;
+  }
+  if (lot->layout == NULL) {
+    lot->layout = layout_create(&lot->memory);
+    if (lot->layout == NULL) {
+      return -3;
+    }
+  }
+  result = layout_set_landmark(lot->layout, name, x, y);
+  if (result == -1) {
+    return -1;
+  }
+  return result == 0 ? 0 : -3;
+}
+
+/**
+ * @brief 查询空间索引是否需要在查找前重建。
+ * @param lot 目标停车场。
+ * @return 需要重建返回 1，否则返回 0。
+ */
+int slot_layout_stale(const ParkingLot *lot) {
+  return lot != NULL && lot->layout != NULL && lot->layout->stale;
+}
+
+/**
+ * @brief 坐标有变化时重建空间索引。
+ * @param lot 目标停车场。
+ * @return 0 成功或无需重建, -1 参数无效, -3 内存分配失败。
+ */
+int refresh_slot_layout(ParkingLot *lot) {
+  if (lot == NULL) {
+    return -1;
+  }
+  if (!slot_layout_stale(lot)) {
+    return 0;
+  }
+  return layout_rebuild(lot->layout, lot) == 0 ? 0 : -3;
+}
+
+/**
+ * @brief (静态辅助函数) 判断候选车位此时没有被预约保留。
+ * @param slot_id 候选的空闲车位编号。
+ * @param ctx 指向 HoldCheck 的指针。
+ * @return 没有被保留返回 1，否则返回 0。
+ */
+static int slot_not_held(int slot_id, void *ctx) {
+  const HoldCheck *check = (const HoldCheck *)ctx;
+
+  return slot_hold(check->lot, slot_id, check->now) == NULL;
+}
+
+/**
+ * @brief 查找离某一点最近的空闲车位。
+ * @param lot 目标停车场。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 最近的空闲车位；没有时返回 NULL。
+ */
+ParkingSlot *find_nearest_free_slot(ParkingLot *lot, long x, long y) {
+  HoldCheck check;
+  int slot_id;
+  int found;
+
+  if (lot == NULL || lot->layout == NULL || refresh_slot_layout(lot) != 0) {
+    return NULL;
+  }
+
+  if (lot->reservations != NULL && lot->reservations->reservation_count > 0) {
+    check.lot = lot;
+    check.now = parking_lot_now(lot);
+    found = layout_nearest_free(lot->layout, x, y, slot_not_held, &check,
+                                &slot_id);
+  } else {
+    found = layout_nearest_free(lot->layout, x, y, NULL, NULL, &slot_id);
+  }
+  return found == 0 ? find_slot_by_id(lot, slot_id) : NULL;
+}
+
+/**
+ * @brief 查找离命名地标最近的空闲车位。
+ * @param lot 目标停车场。
+ * @param landmark 地标名称。
+ * @return 最近的空闲车位；地标不存在或没有空闲车位时返回 NULL。
+ */
+ParkingSlot *find_nearest_free_slot_to(ParkingLot *lot, const char *landmark) {
+  const ParkingLandmark *point;
+
+  if (lot == NULL || lot->layout == NULL || landmark == NULL) {
+    return NULL;
+  }
+  point = layout_find_landmark(lot->layout, landmark);
+  if (point == NULL) {
+    return NULL;
+  }
+  return find_nearest_free_slot(lot, point->x, point->y);
+}
+
+/**
+ * @brief 登记一个分区，此后增量维护其车位总数与空闲数。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @return 0 成功, -1 参数无效, -3 内存分配失败。
+ */
+int add_parking_zone(ParkingLot *lot, const char *prefix) {
+  int result;
+
+  if (lot == NULL || prefix == NULL) {
+    return -1;
+  }
+  if (lot->zones == NULL) {
+    lot->zones = zone_table_create(&lot->memory);
+    if (lot->zones == NULL) {
+      return -3;
+    }
+  }
+  result = zone_table_add(lot->zones, lot, prefix);
+  if (result == -1) {
+    return -1;
+  }
+  return result == 0 ? 0 : -3;
+}
+
+/**
+ * @brief 撤销一个分区。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @return 0 成功, -1 参数无效, -2 分区未登记。
+ */
+int remove_parking_zone(ParkingLot *lot, const char *prefix) {
+  if (lot == NULL || prefix == NULL) {
+    return -1;
+  }
+  if (lot->zones == NULL || zone_table_remove(lot->zones, prefix) != 0) {
+    return -2;
+  }
+  return 0;
+}
+
+/**
+ * @brief 读取一个分区的计数。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @param[out] stats 接收分区计数。
+ * @return 0 成功, -1 参数无效, -2 分区未登记。
+ */
+int get_parking_zone_stats(const ParkingLot *lot, const char *prefix,
+                           ParkingZoneStats *stats) {
+  const ParkingZoneStats *found;
+
+  if (lot == NULL || prefix == NULL || stats == NULL) {
+    return -1;
+  }
+  found = lot->zones != NULL ? zone_table_find(lot->zones, prefix) : NULL;
+  if (found == NULL) {
+    return -2;
+  }
+  *stats = *found;
+  return 0;
+}
+
+/**
+ * @brief 按登记顺序读取全部分区的计数。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收分区计数的数组。
+ * @param max 数组容量。
+ * @return 已登记的分区数，参数无效返回 -1。
+ */
+int list_parking_zone_stats(const ParkingLot *lot, ParkingZoneStats *stats,
+                            int max) {
+  int count;
+  int i;
+
+  if (lot == NULL || max < 0 || (stats == NULL && max > 0)) {
+    return -1;
+  }
+  count = lot->zones != NULL ? lot->zones->count : 0;
+  for (i = 0; i < count && i < max; i++) {
+    stats[i] = lot->zones->zones[i].stats;
+  }
+  return count;
+}
+
+/**
+ * @brief 读取一个分区（或整个停车场）15、30、60 分钟后的预测占用数。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀，NULL 或空串表示整个停车场。
+ * @param[out] forecast 接收预测结果。
+ * @return 0 成功, -1 参数无效, -2 分区未登记。
+ */
+int get_parking_forecast(const ParkingLot *lot, const char *prefix,
+                         ParkingForecast *forecast) {
+  const OccupancyForecast *profile;
+  int i;
+
+  if (lot == NULL || forecast == NULL) {
+    return -1;
+  }
+  memset(forecast, 0, sizeof(*forecast));
+  profile = &lot->forecast;
+  if (prefix != NULL && prefix[0] != '\0') {
+    const ParkingZoneStats *stats;
+
+    stats = lot->zones != NULL ? zone_table_find(lot->zones, prefix) : NULL;
+    if (stats == NULL) {
+      return -2;
+    }
+    profile = zone_table_forecast(lot->zones, prefix);
+    forecast->total_slots = stats->total_slots;
+    forecast->occupied_slots = stats->occupied_slots;
+  } else {
+    forecast->total_slots = lot->slot_count;
+    forecast->occupied_slots = parking_atomic_load_int(&lot->occupied_slots);
+  }
+  for (i = 0; i < FORECAST_HORIZONS; i++) {
+    forecast->predicted_occupied[i] =
+        forecast_predict(profile, i, forecast->occupied_slots,
+                         forecast->total_slots);
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 为车牌选一个可以入场的空闲车位。
+ * @details 先在分区内按稠密车位表顺序查找，跳过为其他车牌保留的车位与
+ *          不接纳该车辆的专用车位；分区内没有时退回 find_free_slot_for。
+ * @param lot 目标停车场。
+ * @param zone 优先的分区前缀，空串表示不限分区。
+ * @param license_plate 车牌号。
+ * @param type 停车类型。
+ * @return 空闲车位，没有时返回 NULL。
+ */
+static ParkingSlot *pick_returning_slot(ParkingLot *lot, const char *zone,
+                                        const char *license_plate,
+                                        ParkingType type) {
+  size_t length = strlen(zone);
+  SlotCursor cursor;
+  ParkingSlot *slot;
+  time_t now;
+
+  if (length > 0) {
+    now = parking_lot_now(lot);
+    slot_cursor_init(&cursor, lot, SLOT_FILTER_FREE);
+    while ((slot = slot_cursor_next(&cursor)) != NULL) {
+      const Reservation *hold;
+
+      if (!slot_in_zone(slot, zone, length) ||
+          !slot_admits(lot, slot, type, license_plate)) {
+        continue;
+      }
+      hold = slot_hold(lot, slot->slot_id, now);
+      if (hold == NULL || strcmp(hold->license_plate, license_plate) == 0) {
+        return slot;
+      }
+    }
+  }
+  return find_free_slot_for(lot, type, license_plate);
+}
+
+/**
+ * @brief 只凭车牌号为常客车辆分配车位（车辆入场）。
+ * @param lot 目标停车场。
+ * @param license_plate 车牌号。
+ * @param[out] slot_id 成功时接收分配到的车位编号，可以为 NULL。
+ * @return 0 成功, -1 参数无效, -2 缓存中没有该车牌, -3 没有空闲车位；
+ * 其余返回码同 allocate_slot。
+ */
+int allocate_returning_vehicle(ParkingLot *lot, const char *license_plate,
+                               int *slot_id) {
+  const VehicleSession *session;
+  ParkingSlot *slot;
+  int result;
+
+  if (lot == NULL || license_plate == NULL) {
+    return -1;
+  }
+  session = session_cache_use(lot->sessions, license_plate);
+  if (session == NULL) {
+    return -2;
+  }
+  slot = pick_returning_slot(lot, session->zone, license_plate,
+                             session->type);
+  if (slot == NULL) {
+    return -3;
+  }
+  result = allocate_slot(lot, slot->slot_id, session->owner_name,
+                         session->license_plate, session->contact,
+                         session->type);
+  if (result == 0 && slot_id != NULL) {
+    *slot_id = slot->slot_id;
+  }
+  return result;
+}
+
+/**
+ * @brief 读取缓存中某辆车的资料，不改变缓存的淘汰顺序。
+ * @param lot 目标停车场。
+ * @param license_plate 车牌号。
+ * @param[out] session 接收车辆资料。
+ * @return 0 成功, -1 参数无效, -2 缓存中没有该车牌。
+ */
+int find_vehicle_session(const ParkingLot *lot, const char *license_plate,
+                         VehicleSession *session) {
+  const VehicleSession *cached;
+
+  if (lot == NULL || license_plate == NULL || session == NULL) {
+    return -1;
+  }
+  cached = session_cache_find(lot->sessions, license_plate);
+  if (cached == NULL) {
+    return -2;
+  }
+  *session = *cached;
+  return 0;
+}
+
+/**
+ * @brief 设置车辆资料缓存的容量。
+ * @param lot 目标停车场。
+ * @param capacity 最多缓存的车牌数，0 表示不再缓存。
+ * @return 0 成功, -1 参数无效。
+ */
+int configure_session_cache(ParkingLot *lot, int capacity) {
+  if (lot == NULL || capacity < 0) {
+    return -1;
+  }
+  if (capacity != lot->session_capacity) {
+    session_cache_free(lot->sessions);
+    lot->sessions = NULL;
+    lot->session_capacity = capacity;
+  }
+  return 0;
+}
+
+/**
+ * @brief 设置请求去重表的容量。
+ * @param lot 目标停车场。
+ * @param capacity 记住的请求数，0 表示不再去重。
+ * @return 0 成功, -1 参数无效, -3 内存分配失败。
+ */
+int configure_request_log(ParkingLot *lot, int capacity) {
+  RequestLog *log = NULL;
+
+  if (lot == NULL || capacity < 0) {
+    return -1;
+  }
+  if (lot->request_log != NULL && lot->request_log->capacity == capacity) {
+    return 0;
+  }
+  if (capacity > 0) {
+    log = request_log_create(&lot->memory, capacity);
+    if (log == NULL) {
+      return -3;
+    }
+  }
+  request_log_free(lot->request_log);
+  lot->request_log = log;
+  return 0;
+}
+
+/**
+ * @brief 启用或停用只读视图。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param enabled 非 0 表示启用。
+ * @return 0 成功, -1 参数无效, -2 仍有读者 attach, -3 内存分配失败。
+ */
+int configure_read_view(ParkingLot *lot, int enabled) {
+  ViewHub *hub;
+
+  if (lot == NULL) {
+    return -1;
+  }
+  if (!enabled) {
+    if (lot->view != NULL && lot->view->reader_count > 0) {
+      return -2;
+    }
+    view_hub_free(lot->view);
+    lot->view = NULL;
+    return 0;
+  }
+  if (lot->view != NULL) {
+    return 0;
+  }
+  hub = view_hub_create(&lot->memory);
+  if (hub == NULL) {
+    return -3;
+  }
+  lot->view = hub;
+  if (refresh_read_view(lot) < 0) {
+    view_hub_free(hub);
+    lot->view = NULL;
+    return -3;
+  }
+  return 0;
+}
+
+/**
+ * @brief 把停车场的当前状态复制并发布为新的只读视图。
+ * @param lot 目标停车场（调用者持有读锁或写锁）。
+ * @return 已发布返回 0，视图已是最新返回 1，未启用视图或参数无效返回 -1，
+ *         内存分配失败返回 -3。
+ */
+int refresh_read_view(ParkingLot *lot) {
+  ParkingView *view;
+
+  if (lot == NULL || lot->view == NULL) {
+    return -1;
+  }
+  if (view_hub_mutations(lot->view) ==
+      parking_atomic_load_long(&lot->mutation_count)) {
+    return 1;
+  }
+  view = parking_view_build(lot, &lot->memory);
+  if (view == NULL) {
+    return -3;
+  }
+  return view_hub_publish(lot->view, view);
+}
+
+/**
+ * @brief 启用或停用共享内存发布。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param path 共享内存文件的路径，NULL 表示停用。
+ * @param capacity 行数上限，0 表示按车位数确定。
+ * @return 0 成功, -1 参数无效, -2 无法创建或映射文件。
+ */
+int configure_shared_memory(ParkingLot *lot, const char *path, int capacity) {
+  ParkingShmPublisher *publisher;
+
+  if (lot == NULL || capacity < 0) {
+    return -1;
+  }
+  if (path == NULL) {
+    shm_publisher_free(lot->shm);
+    lot->shm = NULL;
+    return 0;
+  }
+  if (capacity == 0) {
+    capacity = lot->total_slots > lot->slot_count ? lot->total_slots
+                                                  : lot->slot_count;
+    if (capacity == 0) {
+      capacity = 1;
+    }
+  }
+  publisher = shm_publisher_create(&lot->memory, path, capacity);
+  if (publisher == NULL) {
+    return -2;
+  }
+  shm_publisher_free(lot->shm);
+  lot->shm = publisher;
+  shm_publisher_publish(publisher, lot);
+  return 0;
+}
+
+/**
+ * @brief 把停车场的热字段列与计数器发布到共享内存。
+ * @param lot 目标停车场（调用者持有读锁或写锁）。
+ * @return 已发布返回 0，没有修改返回 1，未启用或参数无效返回 -1。
+ */
+int refresh_shared_memory(ParkingLot *lot) {
+  if (lot == NULL || lot->shm == NULL) {
+    return -1;
+  }
+  return shm_publisher_publish(lot->shm, lot);
+}
+
+/**
+ * @brief (静态辅助函数) 读取停车场计入汇总树的当前值。
+ * @param lot 目标停车场。
+ * @param[out] values 接收当前值。
+ */
+static void aggregate_values(const ParkingLot *lot, AggregateTotals *values) {
+  values->total_slots = parking_atomic_load_int(&lot->total_slots);
+  values->occupied_slots = parking_atomic_load_int(&lot->occupied_slots);
+  values->today_cents = parking_atomic_load_long(&lot->today_revenue_cents);
+  values->revenue_day = parking_atomic_load_long(&lot->revenue_day);
+  values->month_cents = parking_atomic_load_long(&lot->month_revenue_cents);
+  values->revenue_month = parking_atomic_load_long(&lot->revenue_month);
+}
+
+/**
+ * @brief 把停车场挂接到汇总树的一个站点。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param tree 汇总树，NULL 表示解除挂接。
+ * @param site 站点节点编号。
+ * @return 0 成功, -1 参数无效, -2 站点已挂接其他停车场。
+ */
+int attach_parking_aggregate(ParkingLot *lot, ParkingAggregate *tree,
+                             int site) {
+  AggregateTotals values;
+  int result;
+
+  if (lot == NULL) {
+    return -1;
+  }
+  if (lot->aggregate == tree && (tree == NULL || lot->aggregate_site == site)) {
+    return 0;
+  }
+  if (tree != NULL) {
+    aggregate_values(lot, &values);
+    result = aggregate_attach(tree, site, lot, &values);
+    if (result != 0) {
+      return result;
+    }
+  }
+  if (lot->aggregate != NULL) {
+    aggregate_detach(lot->aggregate, lot->aggregate_site);
+  }
+  lot->aggregate = tree;
+  lot->aggregate_site = tree != NULL ? site : 0;
+  return 0;
+}
+
+/**
+ * @brief 把停车场的当前值同步到所属的汇总树。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ */
+void sync_parking_aggregate(ParkingLot *lot) {
+  AggregateTotals values;
+
+  if (lot == NULL || lot->aggregate == NULL) {
+    return;
+  }
+  aggregate_values(lot, &values);
+  aggregate_sync(lot->aggregate, lot->aggregate_site, &values);
+}
+
+/**
+ * @brief 注册分区计数变化的处理函数。
+ * @param lot 目标停车场。
+ * @param handler 处理函数，NULL 表示不再通知。
+ * @param ctx 透传给处理函数的上下文指针。
+ */
+void set_parking_zone_handler(ParkingLot *lot, ParkingZoneHandler handler,
+                              void *ctx) {
+  if (lot == NULL) {
+    return;
+  }
+  lot->zone_handler = handler;
+  lot->zone_ctx = ctx;
+}
+
+/**
+ * @brief 新增一个车位变更的订阅者。
+ * @param lot 目标停车场。
+ * @param capacity 队列至少能容纳的事件数，0 表示默认容量。
+ * @return 成功返回订阅者，参数无效或内存不足返回 NULL。
+ */
+struct ChangeSubscription *subscribe_slot_changes(ParkingLot *lot,
+                                                  size_t capacity) {
+  if (lot == NULL) {
+    return NULL;
+  }
+  if (lot->feed == NULL) {
+    lot->feed = change_feed_create(&lot->memory);
+    if (lot->feed == NULL) {
+      return NULL;
+    }
+  }
+  return change_feed_subscribe(lot->feed, capacity);
+}
+
+/**
+ * @brief 撤销一个订阅者并释放其队列。
+ * @param lot 目标停车场。
+ * @param subscription 要撤销的订阅者。
+ * @return 0 成功, -1 参数无效, -2 订阅者不属于该停车场。
+ */
+int unsubscribe_slot_changes(ParkingLot *lot,
+                             struct ChangeSubscription *subscription) {
+  if (lot == NULL || subscription == NULL) {
+    return -1;
+  }
+  if (lot->feed == NULL ||
+      change_feed_unsubscribe(lot->feed, subscription) != 0) {
+    return -2;
+  }
+  return 0;
+}
+
+/**
+ * @brief 按顺序取出订阅者队列中的事件。
+ * @param subscription 订阅者。
+ * @param[out] changes 接收事件的数组。
+ * @param max 数组容量。
+ * @return 取出的事件数，参数无效返回 -1。
+ */
+int poll_slot_changes(struct ChangeSubscription *subscription,
+                      ParkingChange *changes, int max) {
+  if (subscription == NULL || changes == NULL || max < 0) {
+    return -1;
+  }
+  return change_feed_poll(subscription, changes, max);
+}
+
+/**
+ * @brief 取走并清零订阅者因队列满丢弃的事件数。
+ * @param subscription 订阅者。
+ * @return 上次调用以来丢弃的事件数，参数无效返回 -1。
+ */
+int take_dropped_slot_changes(struct ChangeSubscription *subscription) {
+  if (subscription == NULL) {
+    return -1;
+  }
+  return change_feed_take_dropped(subscription);
+}
+
+/**
+ * @brief 获取满足筛选条件的车位数量。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @return 满足条件的车位数量；若 `lot` 为 NULL 返回 0。
+ */
+int count_slots(const ParkingLot *lot, SlotFilter filter) {
+  if (lot == NULL) {
+    return 0;
+  }
+  switch (filter) {
+  case SLOT_FILTER_FREE:
+    return lot->free_slot_count;
+  case SLOT_FILTER_OCCUPIED:
+    return lot->occupied_slots;
+  default:
+    return lot->slot_count;
+  }
+}
+
+/**
+ * @brief 初始化车位游标。
+ * @param cursor 要初始化的游标。
+ * @param lot 要遍历的停车场。
+ * @param filter 筛选条件。
+ */
+void slot_cursor_init(SlotCursor *cursor, ParkingLot *lot, SlotFilter filter) {
+  if (cursor == NULL) {
+    return;
+  }
+  cursor->lot = lot;
+  cursor->filter = filter;
+  cursor->next_row = 0;
+}
+
+/**
+ * @brief 取出游标的下一个匹配车位。
+ * @details 用 column_find_u8 按 16 字节一组扫描状态列，命中后才访问车位节点。
+ * @param cursor 已初始化的游标。
+ * @return 下一个匹配的车位；遍历结束时返回 NULL。
+ */
+ParkingSlot *slot_cursor_next(SlotCursor *cursor) {
+  ParkingLot *lot;
+  unsigned char want;
+  int row;
+
+  if (cursor == NULL || cursor->lot == NULL) {
+    return NULL;
+  }
+
+  lot = cursor->lot;
+  row = cursor->next_row;
+  want = cursor->filter == SLOT_FILTER_FREE ? (unsigned char)FREE_STATUS
+                                            : (unsigned char)OCCUPIED_STATUS;
+  /* 先看紧邻的一行，连续命中时不必进入向量扫描 */
+  if (cursor->filter != SLOT_FILTER_ALL && row < lot->slot_count &&
+      lot->hot.status[row] != want) {
+    row = (int)column_find_u8(lot->hot.status, (size_t)row + 1,
+                              (size_t)lot->slot_count, want);
+  }
+  if (row < lot->slot_count) {
+    cursor->next_row = row + 1;
+    return lot->slot_table[row];
+  }
+
+  cursor->next_row = lot->slot_count;
+  return NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 从指定行起复制满足筛选条件的车位指针。
+ * @details 全部车位直接整段复制稠密车位表；空闲与已占用车位逐字读取
+ *          空闲位图（已占用取反），用“查找最低置位”逐个取出命中行，
+ *          不逐行检查状态列。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param row 起始行。
+ * @param[out] slots 接收车位指针的数组。
+ * @param limit 最多复制的车位数。
+ * @return 实际复制的车位数。
+ */
+static int copy_matching_rows(ParkingLot *lot, SlotFilter filter, int row,
+                              ParkingSlot **slots, int limit) {
+  const size_t word_bits = SLOT_BITMAP_WORD_BITS;
+  size_t word_index = (size_t)row / word_bits;
+  size_t bit_count = (size_t)lot->slot_count;
+  unsigned long word;
+  size_t bit;
+  int count = 0;
+
+  if (filter == SLOT_FILTER_ALL) {
+    count = lot->slot_count - row < limit ? lot->slot_count - row : limit;
+    if (count > 0) {
+      memcpy(slots, lot->slot_table + row, (size_t)count * sizeof(*slots));
+    }
+    return count < 0 ? 0 : count;
+  }
+
+  for (; word_index * word_bits < bit_count && count < limit; word_index++) {
+    word = word_index < lot->free_map.word_count
+               ? lot->free_map.words[word_index]
+               : 0UL;
+    if (filter == SLOT_FILTER_OCCUPIED) {
+      word = ~word;
+    }
+    if (word_index * word_bits < (size_t)row) {
+      word &= ~0UL << ((size_t)row - word_index * word_bits);
+    }
+    if ((word_index + 1) * word_bits > bit_count) {
+      word &= (1UL << (bit_count - word_index * word_bits)) - 1UL;
+    }
+    while (word != 0 && count < limit) {
+      bit = word_index * word_bits + (size_t)column_lowest_bit(word);
+      word &= word - 1;
+      slots[count++] = lot->slot_table[bit];
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief 把游标定位到第 offset 个匹配车位。
+ * @param cursor 已初始化的游标。
+ * @param offset 要跳过的匹配车位数。
+ * @return 成功返回 0；offset 超出范围时返回 -1。
+ */
+int slot_cursor_seek(SlotCursor *cursor, int offset) {
+  ParkingLot *lot;
+  long row;
+
+  if (cursor == NULL || cursor->lot == NULL) {
+    return -1;
+  }
+
+  lot = cursor->lot;
+  if (offset < 0 || offset >= count_slots(lot, cursor->filter)) {
+    cursor->next_row = lot->slot_count;
+    return -1;
+  }
+  if (cursor->filter == SLOT_FILTER_ALL) {
+    row = offset;
+  } else {
+    /* 空闲位图的置位即空闲车位，已占用车位对应前 slot_count 位中的 0 */
+    row = slot_bitmap_select(&lot->free_map, (size_t)lot->slot_count,
+                             (size_t)offset,
+                             cursor->filter == SLOT_FILTER_FREE);
+  }
+  cursor->next_row = row < 0 ? lot->slot_count : (int)row;
+  return row < 0 ? -1 : 0;
+}
+
+/**
+ * @brief 分页读取满足筛选条件的车位。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param offset 跳过的匹配车位数。
+ * @param[out] slots 调用者提供的数组。
+ * @param limit 最多读取的车位数。
+ * @return 实际写入的车位数。
+ */
+int get_slots_page(ParkingLot *lot, SlotFilter filter, int offset,
+                   ParkingSlot **slots, int limit) {
+  SlotCursor cursor;
+
+  if (lot == NULL || slots == NULL || limit <= 0) {
+    return 0;
+  }
+
+  slot_cursor_init(&cursor, lot, filter);
+  if (slot_cursor_seek(&cursor, offset) != 0) {
+    return 0;
+  }
+  return copy_matching_rows(lot, filter, cursor.next_row, slots, limit);
+}
+
+/**
+ * @brief 按稠密车位表顺序对每个匹配车位调用回调函数。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param visitor 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 已调用回调的次数；若参数无效返回 -1。
+ */
+int parking_lot_foreach(ParkingLot *lot, SlotFilter filter,
+                        SlotVisitor visitor, void *ctx) {
+  SlotCursor cursor;
+  ParkingSlot *slot;
+  int visited = 0;
+
+  if (lot == NULL || visitor == NULL) {
+    return -1;
+  }
+
+  slot_cursor_init(&cursor, lot, filter);
+  while ((slot = slot_cursor_next(&cursor)) != NULL) {
+    visited++;
+    if (visitor(slot, ctx) != 0) {
+      break;
+    }
+  }
+  return visited;
+}
+
+/**
+ * @brief (静态辅助函数) 将满足筛选条件的车位收集到新分配的指针数组中。
+ * @details 数组大小由计数器确定，再由 copy_matching_rows 按位图单遍填充。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param[out] count 用于接收车位数量的指针。
+ * @return 动态分配的指针数组；无匹配车位或内存分配失败时返回 NULL。
+ */
+static ParkingSlot **collect_slots(ParkingLot *lot, SlotFilter filter,
+                                   int *count) {
+  ParkingSlot **slots;
+  int expected;
+
+  if (lot == NULL || count == NULL) {
+    return NULL;
+  }
+
+  expected = count_slots(lot, filter);
+  *count = expected;
+  if (expected == 0) {
+    return NULL;
+  }
+
+  slots = (ParkingSlot **)malloc((size_t)expected * sizeof(ParkingSlot *));
+  if (slots == NULL) {
+    *count = 0;
+    return NULL;
+  }
+
+  copy_matching_rows(lot, filter, 0, slots, expected);
+  return slots;
+}
+
+/**
+ * @brief 获取所有空闲车位的列表。
+ * @details 基于车位游标实现的数组包装，数组大小取自空闲计数器。
+ * @note 返回的数组需要调用者手动 `free()` 释放。
+ * @param lot 目标停车场。
+ * @param[out] count 用于接收空闲车位数量的指针。
+ * @return 返回一个动态分配的 ParkingSlot
+ * 指针数组。如果无空闲车位或内存分配失败，返回 NULL。
+ */
+ParkingSlot **get_free_slots(ParkingLot *lot, int *count) {
+  return collect_slots(lot, SLOT_FILTER_FREE, count);
+}
+
+/**
+ * @brief 获取所有已占用车位的列表。
+ * @details 实现方式与 `get_free_slots` 相同，数组大小取自 occupied_slots。
+ * @note 返回的数组需要调用者手动 `free()` 释放。
+ * @param lot 目标停车场。
+ * @param[out] count 用于接收已占用车位的数量。
+ * @return 返回一个动态分配的 ParkingSlot
+ * 指针数组。如果无已占用车位或内存分配失败，返回 NULL。
+ */
+ParkingSlot **get_occupied_slots(ParkingLot *lot, int *count) {
+  return collect_slots(lot, SLOT_FILTER_OCCUPIED, count);
+}
+
+/**
+ * @brief 获取所有车位的列表。
+ * @details 实现方式与 `get_free_slots` 相同，筛选条件为全部车位。
+ * @note 返回的数组需要调用者手动 `free()` 释放。
+ * @param lot 目标停车场。
+ * @param[out] count 用于接收找到的车位数量。
+ * @return 返回一个动态分配的 ParkingSlot
+ * 指针数组。如果停车场为空或内存分配失败，返回 NULL。
+ */
+ParkingSlot **get_all_slots(ParkingLot *lot, int *count) {
+  return collect_slots(lot, SLOT_FILTER_ALL, count);
+}
+
+/**
+ * @brief 按停车时长排序后，获取已占用车辆列表。
+ * @details 停车时长顺序即入场时间的逆序，因此直接按入场时间链表的顺序
+ *          输出：升序从最近入场的车位开始，降序从最早入场的车位开始。
+ *          不做排序，也不在排序过程中反复读取当前时间。
+ * @note 返回的数组需要调用者手动 `free()` 释放。
+ * @param lot 目标停车场。
+ * @param[out] count 用于接收已占用车位的数量。
+ * @param ascending 是否按升序排列 (1: 升序, 0: 降序)。
+ * @return 返回排序后的 ParkingSlot 指针数组。数组使用后需要调用 free() 释放。
+ */
+ParkingSlot **get_slots_by_duration(ParkingLot *lot, int *count,
+                                    int ascending) {
+  ParkingSlot **slots;
+  int total;
+
+  if (count) {
+    *count = 0;
+  }
+  if (lot == NULL || count == NULL || lot->entry_order.count == 0) {
+    return NULL;
+  }
+
+  total = (int)lot->entry_order.count;
+  slots = (ParkingSlot **)malloc((size_t)total * sizeof(ParkingSlot *));
+  if (slots == NULL) {
+    return NULL;
+  }
+  *count = get_slots_by_entry_order(lot, slots, total, !ascending);
+  return slots;
+}
+
+/**
+ * @brief 取出停车时长最长（或最短）的前 k 个在场车位。
+ * @param lot 目标停车场。
+ * @param[out] slots 调用者提供的数组，至少能容纳 limit 个指针。
+ * @param limit 最多取出的车位数。
+ * @param longest_first 非 0 时从停得最久的车位开始，否则从最近入场的开始。
+ * @return 实际写入的车位数；参数无效时返回 0。
+ */
+int get_slots_by_entry_order(ParkingLot *lot, ParkingSlot **slots, int limit,
+                             int longest_first) {
+  ParkingSlot *current;
+  int written = 0;
+
+  if (lot == NULL || slots == NULL || limit <= 0) {
+    return 0;
+  }
+
+  current = longest_first ? lot->entry_order.oldest : lot->entry_order.newest;
+  while (current != NULL && written < limit) {
+    slots[written++] = current;
+    current = longest_first ? current->entry_next : current->entry_prev;
+  }
+  return written;
+}
+
+/**
+ * @brief 取出停车时长最长的前 k 辆车及其停车时长。
+ * @param lot 目标停车场。
+ * @param k 最多取出的车辆数。
+ * @param[out] out 调用者提供的数组，至少能容纳 k 项。
+ * @return 实际写入的项数；参数无效时返回 0。
+ */
+int get_longest_parked(ParkingLot *lot, int k, ParkedVehicle *out) {
+  ParkingSlot *current;
+  time_t now;
+  int written = 0;
+
+  if (lot == NULL || out == NULL || k <= 0) {
+    return 0;
+  }
+
+  now = parking_lot_now(lot);
+  for (current = lot->entry_order.oldest; current != NULL && written < k;
+       current = current->entry_next) {
+    out[written].slot = current;
+    out[written].duration_seconds =
+        now > current->entry_time ? (long)(now - current->entry_time) : 0;
+    written++;
+  }
+  return written;
+}
+
+/**
+ * @brief 按月费到期时间从早到晚取出到期时间落在 [from, to) 内的居民车位。
+ * @param lot 目标停车场。
+ * @param from 到期时间下界（含）。
+ * @param to 到期时间上界（不含），小于等于 0 表示不设上界。
+ * @param[out] slots 调用者提供的数组。
+ * @param limit 最多取出的车位数。
+ * @return 实际写入的车位数；参数无效返回 -1，内存不足返回 -3。
+ */
+int get_slots_by_due_date(ParkingLot *lot, time_t from, time_t to,
+                          ParkingSlot **slots, int limit) {
+  if (lot == NULL || slots == NULL || limit < 0) {
+    return -1;
+  }
+  return due_heap_collect(&lot->due_heap, from, to, slots, limit);
+}
+
+/**
+ * @brief 获取登记在月费到期堆中的居民车位数。
+ * @param lot 目标停车场。
+ * @return 车位数；lot 为 NULL 时返回 0。
+ */
+int count_due_slots(const ParkingLot *lot) {
+  return lot != NULL ? (int)lot->due_heap.count : 0;
+}
+
+/**
+ * @brief 按默认费率计算访客车辆的停车费用。
+ * @details 停车时长按小时向上取整，然后乘以默认小时费率；全程按整数分计算。
+ * @param entry_time 车辆入场时间戳。
+ * @param exit_time 车辆出场时间戳。
+ * @return 停车费用（元）。如果出场时间早于或等于入场时间，返回0.0。
+ */
+double calculate_visitor_fee(time_t entry_time, time_t exit_time) {
+  long hours;
+
+  if (exit_time <= entry_time) {
+    return 0.0;
+  }
+
+  /* 不足1小时按1小时计费 */
+  hours = ((long)(exit_time - entry_time) + 3599) / 3600;
+  return (hours * TARIFF_DEFAULT_HOURLY_CENTS) / 100.0;
+}
+
+/**
+ * @brief 只替换停车场运行时配置中的费率表。
+ * @param lot 目标停车场。
+ * @param config 费率配置，NULL 表示恢复默认费率。
+ * @return 成功返回 0，配置无效返回 -1，内存不足返回 -2。
+ */
+int configure_parking_tariff(ParkingLot *lot, const TariffConfig *config) {
+  ParkingConfig next;
+
+  if (lot == NULL) {
+    return -1;
+  }
+  next = *parking_lot_config(lot);
+  if (config != NULL) {
+    next.tariff = *config;
+  } else {
+    tariff_config_default(&next.tariff);
+  }
+  return publish_parking_config(lot, &next);
+}
+
+/**
+ * @brief 按停车场的费率表计算访客车辆的停车费用。
+ * @param lot 目标停车场。
+ * @param entry_time 车辆入场时间戳。
+ * @param exit_time 车辆出场时间戳。
+ * @param[out] billed_hours 接收计费小时数，可以为 NULL。
+ * @return 停车费用（分）。
+ */
+long calculate_visitor_fee_cents(ParkingLot *lot, time_t entry_time,
+                                 time_t exit_time, int *billed_hours) {
+  if (billed_hours) {
+    *billed_hours = 0;
+  }
+  if (lot == NULL || exit_time <= entry_time) {
+    return 0;
+  }
+  return tariff_visitor_fee(&parking_lot_config(lot)->fees,
+                            parking_calendar_hour(&lot->calendar, entry_time),
+                            (long)(exit_time - entry_time), billed_hours);
+}
+
+/**
+ * @brief 按停车场的费率表计算居民逾期补缴的月费。
+ * @param lot 目标停车场。
+ * @param due_date 月费到期时间。
+ * @param now 当前时刻。
+ * @param[out] periods 接收补缴的周期数，可以为 NULL。
+ * @return 补缴费用（分）。
+ */
+long calculate_resident_fee_cents(const ParkingLot *lot, time_t due_date,
+                                  time_t now, int *periods) {
+  if (periods) {
+    *periods = 0;
+  }
+  if (lot == NULL || now <= due_date) {
+    return 0;
+  }
+  return tariff_resident_charge(&parking_lot_config(lot)->fees, due_date, now,
+                                periods, NULL);
+}
+
+/**
+ * @brief 更新一个停车位的信息。
+ * @details 根据传入的非 NULL 参数更新车位信息。
+ * @note `location` 字段可以随时更新。`owner_name` 和 `contact`
+ * 字段只有在车位被占用时才能更新。
+ * @param slot 要更新的停车位。
+ * @param location 新的位置描述 (如果为NULL则不更新)。
+ * @param owner_name 新的车主姓名 (如果为NULL则不更新)。
+ * @param contact 新的联系方式 (如果为NULL则不更新)。
+ * @return 成功返回 0，如果 `slot` 参数为 NULL 则返回 -1。
+ */
+int update_slot_info(ParkingSlot *slot, const char *location,
+                     const char *owner_name, const char *contact) {
+  int result = 0;
+
+  if (slot == NULL) {
+    return -1;
+  }
+
+  if (location != NULL && slot_set_location(slot, location) != 0) {
+    result = -2;
+  }
+
+  if (owner_name != NULL && slot->status == OCCUPIED_STATUS &&
+      slot_set_text(slot, &slot->owner_name, owner_name, MAX_NAME_LEN) != 0) {
+    result = -2;
+  }
+
+  if (contact != NULL && slot->status == OCCUPIED_STATUS &&
+      slot_set_text(slot, &slot->contact, contact, MAX_CONTACT_LEN) != 0) {
+    result = -2;
+  }
+
+  return result;
+}
+
+/**
+ * @brief 按编号更新停车场中一个车位的信息，并写入预写日志。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param location 新的位置描述 (如果为NULL则不更新)。
+ * @param owner_name 新的车主姓名 (如果为NULL则不更新)。
+ * @param contact 新的联系方式 (如果为NULL则不更新)。
+ * @return 成功返回 0，参数无效返回 -1，车位不存在返回 -2，文本内存不足返回 -3。
+ */
+int update_slot_info_in_lot(ParkingLot *lot, int slot_id, const char *location,
+                            const char *owner_name, const char *contact) {
+  ParkingSlot *slot;
+
+  if (lot == NULL) {
+    return -1;
+  }
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot == NULL) {
+    return -2;
+  }
+
+  if (update_indexed_slot_info(lot, slot, location, owner_name, contact) != 0) {
+    return -3;
+  }
+
+  if (journal_wanted(lot)) {
+    JournalRecord record;
+    journal_record_init(&record, JOURNAL_OP_UPDATE_INFO, slot_id);
+    if (location != NULL) {
+      record.fields |= JOURNAL_FIELD_LOCATION;
+      strcpy(record.location, slot->location);
+    }
+    if (owner_name != NULL) {
+      record.fields |= JOURNAL_FIELD_OWNER;
+      strcpy(record.owner_name, slot->owner_name);
+    }
+    if (contact != NULL) {
+      record.fields |= JOURNAL_FIELD_CONTACT;
+      strcpy(record.contact, slot->contact);
+    }
+    journal_log(lot, &record);
+  }
+  return 0;
+}
+
+/**
+ * @brief 从停车场中删除一个车位。
+ * @details
+ * 先通过索引确认车位存在且空闲，再从链表中摘除节点并注销索引，
+ * 最后释放其内存。
+ * @note 只有空闲车位才能被删除。
+ * @param lot 目标停车场。
+ * @param slot_id 要删除的车位编号。
+ * @return 返回码：0 成功, -1 停车场对象为空, -2 车位正在被使用，无法删除, -3
+ * 车位不存在。
+ */
+int delete_slot(ParkingLot *lot, int slot_id) {
+  ParkingSlot *current;
+  ParkingSlot *prev = NULL;
+
+  if (lot == NULL) {
+    return -1; /* 停车场对象为空 */
+  }
+
+  current = find_slot_by_id(lot, slot_id);
+  if (current == NULL) {
+    return -3; /* 车位不存在 */
+  }
+
+  /* 检查车位是否为空闲状态 */
+  if (current->status == OCCUPIED_STATUS) {
+    return -2; /* 车位正在被使用，无法删除 */
+  }
+
+  current = lot->slot_head;
+  while (current != NULL) {
+    if (current->slot_id == slot_id) {
+      /* 从链表中移除节点并注销索引 */
+      if (prev == NULL) { /* 如果是头节点 */
+        lot->slot_head = current->next;
+      } else {
+        prev->next = current->next;
+      }
+      if (lot->compaction.cursor == current) {
+        lot->compaction.cursor = prev; /* 整理进度停在被删除的车位上 */
+      }
+      slot_id_index_remove(&lot->id_index, slot_id);
+      slot_table_remove(lot, current);
+      if (lot->reservations != NULL) {
+        reservation_book_clear_slot(lot->reservations, slot_id);
+      }
+      if (lot->layout != NULL) {
+        layout_clear_point(lot->layout, slot_id);
+      }
+      if (current->has_home) {
+        home_table_remove_slot(lot->homes, slot_id);
+      }
+      if (lot->search_index.stale_entries > 0) {
+        /* 该车位的失效项随句柄一起作废，趁删除时一并清除 */
+        search_index_rebuild(lot, NULL);
+      }
+
+      /* 释放内存（或归还内存池）并更新总数 */
+      if (current->storage == SLOT_STORAGE_ARENA) {
+        arena_release_slot(lot, current);
+      } else {
+        lot->heap_slot_count--;
+        free_parking_slot(current);
+      }
+      parking_atomic_add_int(&lot->total_slots, -1);
+      if (lot->aggregate != NULL) {
+        sync_parking_aggregate(lot);
+      }
+
+      if (journal_wanted(lot)) {
+        JournalRecord record;
+        journal_record_init(&record, JOURNAL_OP_DELETE_SLOT, slot_id);
+        journal_log(lot, &record);
+      }
+      return 0; /* 成功 */
+    }
+    prev = current;
+    current = current->next;
+  }
+
+  return -3; /* 车位不存在 */
+}
+
+/**
+ * @brief (静态辅助函数) 查找车位节点所在的、本轮要腾空的区块。
+ * @param lot 目标停车场。
+ * @param slot 车位节点。
+ * @return 所在的待腾空区块；节点不在其中时返回 NULL。
+ */
+static SlotArenaChunk *compact_victim_of(const ParkingLot *lot,
+                                         const ParkingSlot *slot) {
+  int i;
+
+  for (i = 0; i < lot->compaction.victim_count; i++) {
+    SlotArenaChunk *chunk = lot->compaction.victims[i];
+
+    if (slot >= chunk->slots && slot < chunk->slots + chunk->capacity) {
+      return chunk;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 选出本轮要腾空的区块。
+ * @details 仍在切分的当前区块（链表头）不参与。其余区块按在用节点数
+ *          从少到多选取，使用率超过 SLOT_COMPACT_SPARSE_PERCENT 的不选；
+ *          所选区块的在用节点总数不超过其余区块的空闲节点数，
+ *          迁移时通常不必分配新区块。
+ * @param lot 目标停车场。
+ * @return 选出的区块数。
+ */
+static int compact_select_victims(ParkingLot *lot) {
+  SlotCompaction *state = &lot->compaction;
+  SlotArenaChunk *chunk;
+  long spare = 0;
+  long moving = 0;
+
+  state->victim_count = 0;
+  if (lot->arena_chunks == NULL) {
+    return 0;
+  }
+  for (chunk = lot->arena_chunks; chunk != NULL; chunk = chunk->next) {
+    spare += chunk->capacity - chunk->live;
+  }
+
+  while (state->victim_count < SLOT_COMPACT_MAX_VICTIMS) {
+    SlotArenaChunk *best = NULL;
+
+    for (chunk = lot->arena_chunks->next; chunk != NULL; chunk = chunk->next) {
+      if (!chunk->evacuating &&
+          (long)chunk->live * 100 <=
+              (long)chunk->capacity * SLOT_COMPACT_SPARSE_PERCENT &&
+          (best == NULL || chunk->live < best->live)) {
+        best = chunk;
+      }
+    }
+    /* 被腾空区块自己的空闲节点不能再用来接收迁出的车位 */
+    if (best == NULL ||
+        moving + best->live > spare - (best->capacity - best->live)) {
+      break;
+    }
+    spare -= best->capacity - best->live;
+    moving += best->live;
+    best->evacuating = 1;
+    state->victims[state->victim_count++] = best;
+  }
+  return state->victim_count;
+}
+
+/**
+ * @brief (静态辅助函数) 把车位迁到新节点，并改写所有指向旧节点的引用。
+ * @details 车位链表、稠密车位表、编号索引、句柄表、车牌号索引、
+ *          入场时间链表、月费到期堆与定时器都改为指向新节点；
+ *          三元组索引保存的是句柄，不必改写。文本的所有权随节点转移，
+ *          旧节点不再释放任何文本。
+ * @param lot 目标停车场。
+ * @param prev 车位链表中旧节点的前一个节点，NULL 表示旧节点是表头。
+ * @param from 旧节点。
+ * @param to 从内存池取出的新节点。
+ */
+static void compact_move_slot(ParkingLot *lot, ParkingSlot *prev,
+                              ParkingSlot *from, ParkingSlot *to) {
+  int timer_armed = timer_pending(&from->timer);
+  time_t expires = from->timer.expires;
+
+  if (timer_armed) {
+    timer_wheel_cancel(&lot->timers, &from->timer);
+  }
+  *to = *from;
+  timer_init(&to->timer);
+
+  if (prev == NULL) {
+    lot->slot_head = to;
+  } else {
+    prev->next = to;
+  }
+  lot->slot_table[to->table_index] = to;
+  slot_id_index_relocate(&lot->id_index, to->slot_id, to);
+  slot_handle_table_relocate(&lot->handles, to->handle_index, to);
+  if (to->status == OCCUPIED_STATUS) {
+    plate_index_relocate(&lot->plate_index, from, to);
+    entry_order_relocate(&lot->entry_order, from, to);
+  }
+  due_heap_relocate(&lot->due_heap, to);
+  if (timer_armed) {
+    timer_wheel_add(&lot->timers, &to->timer, expires);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放本轮已经腾空的区块，结束本轮整理。
+ * @param lot 目标停车场。
+ */
+static void compact_release_victims(ParkingLot *lot) {
+  SlotCompaction *state = &lot->compaction;
+  int i;
+
+  for (i = 0; i < state->victim_count; i++) {
+    SlotArenaChunk *victim = state->victims[i];
+    SlotArenaChunk **link = &lot->arena_chunks;
+
+    if (victim->live > 0) {
+      /* 仍有节点未迁出时保留区块，已丢弃的空闲节点不再找回 */
+      victim->evacuating = 0;
+      continue;
+    }
+    while (*link != victim) {
+      link = &(*link)->next;
+    }
+    *link = victim->next;
+    parking_memory_free(&lot->memory, victim);
+    state->freed_chunks++;
+  }
+  state->victim_count = 0;
+  state->pending = NULL;
+  state->cursor = NULL;
+  state->phase = SLOT_COMPACT_IDLE;
+}
+
+/**
+ * @brief (静态辅助函数) 按车位数收缩稠密车位表与热字段列。
+ * @details 容量超过所需容量（车位数的两倍，不少于 SLOT_COMPACT_MIN_TABLE）
+ *          的两倍时才收缩。收缩的 realloc 失败时该列保持原大小，
+ *          仍不小于新容量，不影响后续使用。
+ * @param lot 目标停车场。
+ */
+static void slot_table_shrink(ParkingLot *lot) {
+  int capacity = lot->slot_count * 2;
+  ParkingSlot **table;
+
+  if (capacity < SLOT_COMPACT_MIN_TABLE) {
+    capacity = SLOT_COMPACT_MIN_TABLE;
+  }
+  if (lot->slot_capacity <= capacity * 2) {
+    return;
+  }
+  hot_table_reserve(&lot->memory, &lot->hot, capacity);
+  table = (ParkingSlot **)parking_memory_realloc(
+      &lot->memory, PARKING_MEMORY_TABLE, lot->slot_table,
+      (size_t)capacity * sizeof(ParkingSlot *));
+  if (table != NULL) {
+    lot->slot_table = table;
+  }
+  lot->slot_capacity = capacity;
+}
+
+/**
+ * @brief 分步整理车位内存池，把稀疏区块中的车位迁走并释放这些区块。
+ * @details
+ * 空闲时先选出本轮要腾空的区块，并把空闲链表整体摘下；
+ * PURGE 阶段逐个筛选摘下的节点，不在这些区块中的放回空闲链表；
+ * MOVE 阶段沿车位链表逐个检查，这些区块中的车位迁到内存池取出的新节点
+ * （此时空闲链表中已没有待腾空区块的节点）；走到表尾后释放腾空的区块。
+ * 两步之间删除的车位若在待腾空区块中，其节点直接丢弃；
+ * 删除的恰是进度所在车位时，delete_slot 把进度退回前一个车位。
+ * @param lot 目标停车场。
+ * @param budget 本次最多检查的节点数。
+ * @return 还有剩余工作返回 1，整理完毕返回 0，参数无效返回 -1，
+ *         快照进行中返回 -2，内存不足返回 -3。
+ */
+int compact_parking_slots(ParkingLot *lot, int budget) {
+  SlotCompaction *state;
+
+  if (lot == NULL || budget <= 0) {
+    return -1;
+  }
+  if (lot->snapshot != NULL) {
+    return -2; /* 快照的行数组仍引用车位节点，此时不能迁移 */
+  }
+
+  state = &lot->compaction;
+  if (state->phase == SLOT_COMPACT_IDLE) {
+    if (compact_select_victims(lot) == 0) {
+      slot_table_shrink(lot);
+      return 0;
+    }
+    state->pending = lot->arena_free_list;
+    lot->arena_free_list = NULL;
+    state->cursor = NULL;
+    state->phase = SLOT_COMPACT_PURGE;
+  }
+
+  while (budget > 0 && state->phase == SLOT_COMPACT_PURGE) {
+    ParkingSlot *slot = state->pending;
+
+    if (slot == NULL) {
+      state->phase = SLOT_COMPACT_MOVE;
+      break;
+    }
+    state->pending = slot->next;
+    if (compact_victim_of(lot, slot) == NULL) {
+      slot->next = lot->arena_free_list;
+      lot->arena_free_list = slot;
+    }
+    budget--;
+  }
+
+  while (budget > 0 && state->phase == SLOT_COMPACT_MOVE) {
+    ParkingSlot *prev = state->cursor;
+    ParkingSlot *slot = prev != NULL ? prev->next : lot->slot_head;
+    SlotArenaChunk *victim;
+
+    if (slot == NULL) {
+      compact_release_victims(lot);
+      break;
+    }
+    victim = slot->storage == SLOT_STORAGE_ARENA ? compact_victim_of(lot, slot)
+                                                 : NULL;
+    if (victim != NULL) {
+      ParkingSlot *target = arena_alloc_slot(lot);
+
+      if (target == NULL) {
+        return -3;
+      }
+      compact_move_slot(lot, prev, slot, target);
+      victim->live--;
+      state->moved_slots++;
+      slot = target;
+    }
+    state->cursor = slot;
+    budget--;
+  }
+  return 1;
+}
+
+/**
+ * @brief 统计指定日期内某类型车辆的入场总数。
+ * @details 直接读取按日累计的入场计数，耗时 O(1)。
+ *          计数在入场时累加，已出场的车辆同样计入。
+ * @param lot 目标停车场。
+ * @param date 指定的日期 (time_t)。
+ * @param type 车辆类型 (居民/访客)。
+ * @return 指定日期和类型的车辆入场总数。若 `lot` 为 NULL 返回 -1。
+ */
+int count_daily_parking(ParkingLot *lot, time_t date, ParkingType type) {
+  long day;
+
+  if (lot == NULL) {
+    return -1;
+  }
+
+  /* 查询可能与其他读者并发，不能修改停车场的日历缓存 */
+  parking_calendar_convert(date, &day, NULL);
+  return calendar_count_get(&lot->daily_entries, day,
+                            type == VISITOR_TYPE ? 1 : 0);
+}
+
+/**
+ * @brief 统计指定月份内某类型车辆的入场总数。
+ * @details 直接读取按月累计的入场计数，耗时 O(1)。
+ * @param lot 目标停车场。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @param type 车辆类型 (居民/访客)。
+ * @return 指定月份和类型的车辆入场总数。若参数无效返回 -1。
+ */
+int count_monthly_parking(ParkingLot *lot, int year, int month,
+                          ParkingType type) {
+  if (lot == NULL || month < 1 || month > 12) {
+    return -1;
+  }
+
+  return calendar_count_get(&lot->monthly_entries, (long)year * 100 + month,
+                            type == VISITOR_TYPE ? 1 : 0);
+}
+
+/**
+ * @brief 获取指定月份的总收入。
+ * @details 读取收费台账的月表，耗时 O(1)。
+ * @param lot 目标停车场。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @return 当月的总收入；未启用台账时返回 0.0，参数无效返回 -1.0。
+ */
+double get_monthly_payment_total(ParkingLot *lot, int year, int month) {
+  if (lot == NULL || month < 1 || month > 12) {
+    return -1.0;
+  }
+  if (lot->ledger == NULL) {
+    return 0.0;
+  }
+  return ledger_month_total(lot->ledger, year, month, -1) / 100.0;
+}
+
+/**
+ * @brief 使当日与当月收入进入 now 所在的周期。
+ * @param lot 目标停车场。
+ * @param now 当前时刻。
+ */
+void update_revenue_cycle(ParkingLot *lot, time_t now) {
+  long day;
+  long month;
+
+  if (lot == NULL) {
+    return;
+  }
+  parking_calendar_lookup(&lot->calendar, now, &day, &month);
+  if (parking_atomic_load_long(&lot->revenue_month) != month) {
+    parking_atomic_store_long(&lot->month_revenue_cents, 0);
+    parking_atomic_store_long(&lot->revenue_month, month);
+  }
+  if (parking_atomic_load_long(&lot->revenue_day) != day) {
+    parking_atomic_store_long(&lot->today_revenue_cents, 0);
+    parking_atomic_store_long(&lot->revenue_day, day);
+  }
+}
+
+/**
+ * @brief 把停车场某个周期的不同车辆草图合并进另一个草图。
+ * @param lot 目标停车场。
+ * @param period 周期。
+ * @param now 作为基准的时刻。
+ * @param[in,out] into 接收合并结果的草图。
+ * @return 有入场记录返回 1，没有返回 0，参数无效返回 -1。
+ */
+int merge_distinct_vehicles(const ParkingLot *lot, DistinctPeriod period,
+                            time_t now, HyperLogLog *into) {
+  const HyperLogLog *sketch;
+  long day;
+
+  if (lot == NULL || into == NULL) {
+    return -1;
+  }
+  /* 读锁内不能更新日历缓存 */
+  parking_calendar_convert(now, &day, NULL);
+  sketch = distinct_counter_sketch(&lot->distinct_plates, period, day);
+  if (sketch == NULL) {
+    return 0;
+  }
+  hll_merge(into, sketch);
+  return 1;
+}
+
+/**
+ * @brief 把一笔收入计入滚动汇总的小时桶与日桶。
+ * @param lot 目标停车场（调用者持有写锁）。
+ * @param type 付费车辆的停车类型。
+ * @param when 收费时刻。
+ * @param cents 金额（分）。
+ */
+void record_revenue_rollup(ParkingLot *lot, ParkingType type, time_t when,
+                           long cents) {
+  long day;
+  long month;
+
+  if (lot == NULL || cents == 0) {
+    return;
+  }
+  parking_calendar_lookup(&lot->calendar, when, &day, &month);
+  rollup_add(&lot->rollup, when, day, month, (int)type, ROLLUP_REVENUE, cents);
+}
+
+/**
+ * @brief (静态辅助函数) 把文本文件的一行累加进校验和。
+ * @details 行尾的 CR/LF 统一按一个 LF 计算，在不同平台以文本模式读写的
+ *          同一文件得到相同的校验和。
+ * @param checksum 之前各行的校验和。
+ * @param line 读到或写出的一行。
+ * @return 累加本行后的校验和。
+ */
+static unsigned long text_line_checksum(unsigned long checksum,
+                                        const char *line) {
+  size_t length = strlen(line);
+  int newline = length > 0 && line[length - 1] == '\n';
+
+  while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+    length--;
+  }
+  checksum =
+      codec_checksum_update(checksum, (const unsigned char *)line, length);
+  return newline ? codec_checksum_update(checksum,
+                                         (const unsigned char *)"\n", 1)
+                 : checksum;
+}
+
+/**
+ * @brief 从文本文件中加载停车场数据。
+ * @details
+ * 解析与 `save_parking_data` 函数格式兼容的文件，重建停车场对象。
+ * 若文件以二进制快照魔数开头，则改由 `load_parking_snapshot` 加载。
+ * 首先读取 `LOT` 行初始化停车场，然后逐行读取 `SLOT`
+ * 行，在停车场内存池中创建车位并加入停车场。
+ * 计数器在每个车位加入停车场时同步累计，加载完成后无需重新统计。
+ * `LOT` 行带有格式版本的文件必须以 `END` 尾行结束，尾行记录的车位行数
+ * 与校验和不一致、或缺少尾行（写到一半被截断）即视为残缺文件；
+ * 没有格式版本的旧格式文件不做校验，照常加载。
+ * @param filename 源文件名。
+ * @return 成功时返回重建的 ParkingLot 指针；失败（文件不存在、格式错误或
+ * 校验失败）时返回 NULL。
+ */
+ParkingLot *load_parking_data(const char *filename) {
+  FILE *file;
+  char line[TEXT_LINE_MAX];
+  ParkingLot *lot = NULL;
+  ParkingSlot *slot;
+  unsigned long checksum = codec_checksum(NULL, 0);
+  int slot_lines = 0;
+  int format = 0;
+  int intact = 1;
+
+  file = fopen(filename, "r");
+  if (!file) {
+    return NULL;
+  }
+
+  /* 二进制快照以魔数开头，优先映射加载，映射不可用时退回普通读取 */
+  if (fread(line, 1, 8, file) == 8 && memcmp(line, SNAPSHOT_MAGIC, 8) == 0) {
+    fclose(file);
+    lot = load_parking_snapshot_mapped(filename);
+    return lot != NULL ? lot : load_parking_snapshot(filename);
+  }
+  rewind(file);
+
+  /* 读取并解析LOT行 */
+  if (fgets(line, sizeof(line), file)) {
+    int total = 0;
+    checksum = text_line_checksum(checksum, line);
+    /* 总车位数可能因删除车位而不为正，与二进制快照一样照原值加载 */
+    if (sscanf(line, "LOT|%d|%d", &total, &format) >= 1) {
+      lot = init_parking_lot(total);
+    }
+    /* 带格式版本的文件在读到 END 尾行之前都视为不完整 */
+    intact = format < TEXT_FORMAT_VERSION;
+  }
+
+  if (!lot) {
+    fclose(file);
+    return NULL;
+  }
+
+  /* 读取并解析所有SLOT行 */
+  while (fgets(line, sizeof(line), file)) {
+    if (strncmp(line, "END|", 4) == 0) {
+      int expected_lines;
+      unsigned long expected_sum;
+
+      intact = sscanf(line, "END|%d|%lx", &expected_lines, &expected_sum) == 2;
+      intact = intact && expected_lines == slot_lines &&
+               expected_sum == checksum;
+      break;
+    }
+    checksum = text_line_checksum(checksum, line);
+    if (strncmp(line, "SLOT|", 5) != 0) {
+      continue;
+    }
+    slot_lines++;
+
+    slot = arena_alloc_slot(lot);
+    if (!slot) {
+      continue;
+    }
+    init_slot_fields(slot, 0, "", SLOT_STORAGE_ARENA, &lot->strings);
+    text_decode_slot(slot, line + 5);
+    if (add_parking_slot(lot, slot) != 0) {
+      /* 重复或无法登记的车位记录直接丢弃，节点归还内存池 */
+      arena_release_slot(lot, slot);
+    } else if (slot->status == OCCUPIED_STATUS) {
+      plate_index_insert(&lot->plate_index, slot);
+      search_index_add(lot, slot);
+    }
+  }
+
+  fclose(file);
+  if (!intact) {
+    free_parking_lot(lot);
+    return NULL;
+  }
+  return lot;
+}
+
+/* 快照记录各种类字段的编码：文本以 NUL 填充，时间为 64 位 */
+#define SNAP_ENCODE_INT(field, value, width) codec_put_i32(field, value)
+#define SNAP_ENCODE_TYPE(field, value, width) *(field) = (unsigned char)(value)
+#define SNAP_ENCODE_STATUS(field, value, width)                                \
+  *(field) = (unsigned char)(value)
+#define SNAP_ENCODE_TIME(field, value, width) codec_put_time(field, value)
+#define SNAP_ENCODE_LOCATION(field, value, width)                              \
+  string_copy_bounded((char *)(field), value, width)
+#define SNAP_ENCODE_TEXT(field, value, width)                                  \
+  string_copy_bounded((char *)(field), value, width)
+
+/** (展开辅助宏) 编码一个字段；仅在场有效的字段只为已占用车位写出。 */
+#define SNAP_ENCODE_FIELD(member, kind, width, tag, occupant)                  \
+  if (occupied || !(occupant)) {                                               \
+    SNAP_ENCODE_##kind(record + SNAP_OFF_##tag, slot->member, width);          \
+  }
+
+/**
+ * @brief (静态辅助函数) 将车位节点编码为一条定长快照记录。
+ * @details 空闲车位的车主、车牌、联系方式和时间戳一律写为 0，
+ *          与文本格式的保存规则保持一致。
+ * @param record 目标记录缓冲区（SNAPSHOT_RECORD_SIZE 字节，需预先清零）。
+ * @param slot 要编码的车位。
+ */
+static void snap_encode_slot(unsigned char *record, const ParkingSlot *slot) {
+  int occupied = slot->status == OCCUPIED_STATUS;
+
+  PARKING_SLOT_FIELDS(SNAP_ENCODE_FIELD)
+}
+
+/**
+ * @brief (静态辅助函数) 解码快照记录中的一个文本字段。
+ * @details 借用时，字段在宽度之内以 NUL 结尾就直接指向记录本身；
+ *          否则（或不借用时）按宽度截断后复制到 text 中。
+ * @param text 复制使用的存储。
+ * @param field 记录中的字段。
+ * @param width 字段宽度（含结尾 NUL）。
+ * @param borrow 非 0 表示可以直接引用记录。
+ * @return 解码得到的文本，内存不足返回 NULL。
+ */
+static const char *snap_decode_text(StringStore *text, const char *field,
+                                    size_t width, int borrow) {
+  if (borrow && field[0] != '\0' && memchr(field, '\0', width) != NULL) {
+    return field;
+  }
+  return string_store_copy(text, field, width);
+}
+
+/* 快照记录各种类字段的解码；位置描述由调用者单线程驻留，这里跳过 */
+#define SNAP_DECODE_INT(slot, member, field, width)                            \
+  (slot)->member = codec_get_i32(field)
+#define SNAP_DECODE_TYPE(slot, member, field, width)                           \
+  (slot)->member = (ParkingType)*(field)
+#define SNAP_DECODE_STATUS(slot, member, field, width)                         \
+  (slot)->member = *(field) == OCCUPIED_STATUS ? OCCUPIED_STATUS : FREE_STATUS
+#define SNAP_DECODE_TIME(slot, member, field, width)                           \
+  (slot)->member = codec_get_time(field)
+#define SNAP_DECODE_LOCATION(slot, member, field, width) (void)0
+#define SNAP_DECODE_TEXT(slot, member, field, width)                           \
+  (slot)->member = snap_decode_text(text, (const char *)(field), width,       \
+                                    borrow);                                   \
+  if ((slot)->member == NULL) {                                                \
+    (slot)->member = string_store_empty;                                       \
+    return -1;                                                                 \
+  }
+
+/** (展开辅助宏) 解码一个字段。 */
+#define SNAP_DECODE_FIELD(member, kind, width, tag, occupant)                  \
+  SNAP_DECODE_##kind(slot, member, record + SNAP_OFF_##tag, width);
+
+/**
+ * @brief (静态辅助函数) 将一条定长快照记录中位置描述以外的字段解码到车位节点。
+ * @details 文本字段在记录中以 NUL 填充，按字段上限截断后复制到 text 中；
+ *          borrow 非 0 时改为直接引用记录，记录须在停车场释放前一直有效。
+ *          位置描述需要驻留到停车场的存储，由调用者单线程设置。
+ * @param slot 目标车位节点（已初始化为空闲）。
+ * @param record 源记录。
+ * @param text 复制车主、车牌、联系方式使用的存储。
+ * @param borrow 非 0 表示文本字段直接引用记录。
+ * @return 成功返回 0，文本内存不足返回 -1（已复制的字段保留在车位上）。
+ */
+static int snap_decode_fields(ParkingSlot *slot, const unsigned char *record,
+                              StringStore *text, int borrow) {
+  PARKING_SLOT_FIELDS(SNAP_DECODE_FIELD)
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 取快照文件中记录区的起始偏移。
+ * @param page_count 页数。
+ * @return 文件头与页表之后的字节偏移。
+ */
+static size_t snap_records_offset(int page_count) {
+  return SNAPSHOT_HEADER_SIZE + (size_t)page_count * SNAP_PAGE_SUM_SIZE;
+}
+
+/**
+ * @brief (静态辅助函数) 取容纳若干条记录所需的页数。
+ * @param slot_count 记录条数。
+ * @return 页数。
+ */
+static int snap_page_count(int slot_count) {
+  return (slot_count + SNAPSHOT_PAGE_ROWS - 1) / SNAPSHOT_PAGE_ROWS;
+}
+
+/**
+ * @brief (静态辅助函数) 取某一页记录的字节数。
+ * @param page 页号。
+ * @param slot_count 记录条数。
+ * @return 该页记录的字节数（最后一页可能不满）。
+ */
+static size_t snap_page_bytes(int page, int slot_count) {
+  int rows = slot_count - page * SNAPSHOT_PAGE_ROWS;
+
+  if (rows > SNAPSHOT_PAGE_ROWS) {
+    rows = SNAPSHOT_PAGE_ROWS;
+  }
+  return (size_t)rows * SNAPSHOT_RECORD_SIZE;
+}
+
+/**
+ * @brief (静态辅助函数) 为快照分配缓冲区并复制稠密车位表。
+ * @details 只做分配与复制，不编码记录，也不登记到停车场。
+ * @param lot 目标停车场。
+ * @param snapshot 接收快照的对象。
+ * @return 成功返回 0，内存不足返回 -2。
+ */
+static int snapshot_init(ParkingLot *lot, ParkingSnapshot *snapshot) {
+  size_t total_size;
+
+  memset(snapshot, 0, sizeof(*snapshot));
+  snapshot->memory = &lot->memory;
+  snapshot->total_slots = lot->total_slots;
+  snapshot->slot_count = lot->slot_count;
+  snapshot->page_count = snap_page_count(lot->slot_count);
+  snapshot->pages_left = snapshot->page_count;
+
+  total_size = snap_records_offset(snapshot->page_count) +
+               (size_t)lot->slot_count * SNAPSHOT_RECORD_SIZE;
+  snapshot->buffer = (unsigned char *)parking_memory_calloc(
+      &lot->memory, PARKING_MEMORY_IO, total_size, 1);
+  if (snapshot->buffer == NULL) {
+    return -2;
+  }
+  if (lot->slot_count > 0) {
+    snapshot->rows = (ParkingSlot **)parking_memory_alloc(
+        &lot->memory, PARKING_MEMORY_IO,
+        (size_t)lot->slot_count * sizeof(ParkingSlot *));
+    snapshot->page_done = (unsigned char *)parking_memory_calloc(
+        &lot->memory, PARKING_MEMORY_IO, (size_t)snapshot->page_count, 1);
+    if (snapshot->rows == NULL || snapshot->page_done == NULL) {
+      parking_memory_free(&lot->memory, snapshot->page_done);
+      parking_memory_free(&lot->memory, snapshot->rows);
+      parking_memory_free(&lot->memory, snapshot->buffer);
+      snapshot->buffer = NULL;
+      return -2;
+    }
+    memcpy(snapshot->rows, lot->slot_table,
+           (size_t)lot->slot_count * sizeof(ParkingSlot *));
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 释放快照的全部缓冲区。
+ * @param snapshot 目标快照。
+ */
+static void snapshot_release(ParkingSnapshot *snapshot) {
+  if (snapshot->memory == NULL) {
+    return;
+  }
+  parking_memory_free(snapshot->memory, snapshot->page_done);
+  parking_memory_free(snapshot->memory, snapshot->rows);
+  parking_memory_free(snapshot->memory, snapshot->buffer);
+  snapshot->page_done = NULL;
+  snapshot->rows = NULL;
+  snapshot->buffer = NULL;
+  snapshot->memory = NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 编码快照的一页记录。
+ * @details 页中的车位此时必须仍保持开始快照时的内容。
+ * @param snapshot 目标快照。
+ * @param page 尚未编码的页号。
+ */
+static void snapshot_encode_page(ParkingSnapshot *snapshot, int page) {
+  unsigned char *records =
+      snapshot->buffer + snap_records_offset(snapshot->page_count);
+  int first = page * SNAPSHOT_PAGE_ROWS;
+  int last = first + SNAPSHOT_PAGE_ROWS;
+  int i;
+
+  if (last > snapshot->slot_count) {
+    last = snapshot->slot_count;
+  }
+  for (i = first; i < last; i++) {
+    snap_encode_slot(records + (size_t)i * SNAPSHOT_RECORD_SIZE,
+                     snapshot->rows[i]);
+  }
+  codec_put_u32(snapshot->buffer + SNAPSHOT_HEADER_SIZE +
+                    (size_t)page * SNAP_PAGE_SUM_SIZE,
+                codec_checksum(records + (size_t)first * SNAPSHOT_RECORD_SIZE,
+                               (size_t)(last - first) * SNAPSHOT_RECORD_SIZE));
+  snapshot->page_done[page] = 1;
+  snapshot->pages_left--;
+}
+
+/**
+ * @brief 开始一次写时复制快照。
+ * @param lot 目标停车场。
+ * @param[out] snapshot 调用者提供的快照对象。
+ * @return 成功返回 0，参数无效或已有进行中的快照返回 -1，内存不足返回 -2。
+ */
+int begin_parking_snapshot(ParkingLot *lot, ParkingSnapshot *snapshot) {
+  int result;
+
+  if (lot == NULL || snapshot == NULL || lot->snapshot != NULL) {
+    return -1;
+  }
+  result = snapshot_init(lot, snapshot);
+  if (result != 0) {
+    return result;
+  }
+  lot->snapshot = snapshot;
+  return 0;
+}
+
+/**
+ * @brief 编码快照中尚未编码的页。
+ * @param lot 快照所属的停车场。
+ * @param snapshot 进行中的快照。
+ * @param max_pages 本次最多编码的页数，不为正表示全部。
+ * @return 仍未编码的页数，参数无效返回 -1。
+ */
+int fill_parking_snapshot(ParkingLot *lot, ParkingSnapshot *snapshot,
+                          int max_pages) {
+  TraceSpan span;
+  int page;
+  int done = 0;
+
+  if (lot == NULL || snapshot == NULL || snapshot->buffer == NULL) {
+    return -1;
+  }
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_IO, "snapshot_encode");
+  for (page = 0; page < snapshot->page_count; page++) {
+    if (max_pages > 0 && done >= max_pages) {
+      break;
+    }
+    if (!snapshot->page_done[page]) {
+      snapshot_encode_page(snapshot, page);
+      done++;
+    }
+  }
+  PARKING_TRACE_END(span);
+  return snapshot->pages_left;
+}
+
+/**
+ * @brief 在修改车位字段之前，把车位所在页按修改前的内容编码进快照。
+ * @param lot 车位所属的停车场。
+ * @param slot 即将被修改的车位。
+ */
+void preserve_slot_snapshot(ParkingLot *lot, const ParkingSlot *slot) {
+  ParkingSnapshot *snapshot;
+  int page;
+
+  if (lot == NULL || slot == NULL) {
+    return;
+  }
+  if (slot->table_index >= 0) {
+    snapshot_mark_dirty(lot, slot->table_index);
+  }
+  if (lot->snapshot == NULL) {
+    return;
+  }
+  snapshot = lot->snapshot;
+  /* 开始快照之后才加入的车位排在快照范围之外 */
+  if (slot->table_index < 0 || slot->table_index >= snapshot->slot_count) {
+    return;
+  }
+  page = slot->table_index / SNAPSHOT_PAGE_ROWS;
+  if (!snapshot->page_done[page]) {
+    snapshot_encode_page(snapshot, page);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 写出快照文件头，页表须已紧随文件头写好。
+ * @param buffer 文件内容的起始地址。
+ * @param version 格式版本。
+ * @param snapshot 快照，提供总车位数与记录条数。
+ * @param table_size 页表字节数。
+ */
+static void snap_put_header(unsigned char *buffer, int version,
+                            const ParkingSnapshot *snapshot,
+                            size_t table_size) {
+  memcpy(buffer, SNAPSHOT_MAGIC, 8);
+  codec_put_u32(buffer + SNAP_HDR_VERSION, (unsigned long)version);
+  codec_put_u32(buffer + SNAP_HDR_HEADER_SIZE, SNAPSHOT_HEADER_SIZE);
+  codec_put_u32(buffer + SNAP_HDR_RECORD_SIZE, SNAPSHOT_RECORD_SIZE);
+  codec_put_i32(buffer + SNAP_HDR_TOTAL_SLOTS, snapshot->total_slots);
+  codec_put_u32(buffer + SNAP_HDR_SLOT_COUNT,
+                (unsigned long)snapshot->slot_count);
+  codec_put_u32(buffer + SNAP_HDR_RECORD_SUM,
+                codec_checksum(buffer + SNAPSHOT_HEADER_SIZE, table_size));
+  codec_put_u32(buffer + SNAP_HDR_HEADER_SUM,
+                codec_checksum(buffer, SNAP_HDR_HEADER_SUM));
+}
+
+/**
+ * @brief 补全快照的文件头，取得与二进制快照文件逐字节相同的内容。
+ * @param snapshot 全部页已编码的快照。
+ * @param[out] size 接收字节数。
+ * @return 成功返回快照内容；参数无效或仍有未编码的页返回 NULL。
+ */
+const unsigned char *parking_snapshot_bytes(ParkingSnapshot *snapshot,
+                                            size_t *size) {
+  if (snapshot == NULL || snapshot->buffer == NULL || size == NULL ||
+      snapshot->pages_left != 0) {
+    return NULL;
+  }
+
+  snap_put_header(snapshot->buffer, SNAPSHOT_VERSION, snapshot,
+                  (size_t)snapshot->page_count * SNAP_PAGE_SUM_SIZE);
+  *size = snap_records_offset(snapshot->page_count) +
+          (size_t)snapshot->slot_count * SNAPSHOT_RECORD_SIZE;
+  return snapshot->buffer;
+}
+
+/**
+ * @brief 把编码完成的快照写成二进制快照文件。
+ * @param snapshot 全部页已编码的快照。
+ * @param filename 目标文件名。
+ * @return 成功返回 0，参数无效、仍有未编码的页或文件写入失败返回 -1。
+ */
+int write_parking_snapshot(ParkingSnapshot *snapshot, const char *filename) {
+  DurableFile file;
+  TraceSpan span;
+  const unsigned char *bytes;
+  size_t total_size;
+  int result;
+
+  if (filename == NULL) {
+    return -1;
+  }
+  bytes = parking_snapshot_bytes(snapshot, &total_size);
+  if (bytes == NULL) {
+    return -1;
+  }
+
+  if (durable_file_open(&file, filename, "wb") != 0) {
+    return -1;
+  }
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_IO, "snapshot_write");
+  if (fwrite(bytes, 1, total_size, file.stream) != total_size) {
+    PARKING_TRACE_END(span);
+    durable_file_abort(&file);
+    return -1;
+  }
+  result = durable_file_commit(&file);
+  PARKING_TRACE_END(span);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 把编码完成的快照逐页压缩成压缩版本的文件内容。
+ * @details 页表每项依次是该页压缩后的字节数与压缩前记录的校验和；
+ *          压缩后不比原文小的页原样存放，此时长度等于原始字节数。
+ * @param snapshot 全部页已编码的快照。
+ * @param[out] size 接收文件内容的字节数。
+ * @return 成功返回新分配的文件内容（由快照的内存对象分配），
+ *         内存不足返回 NULL。
+ */
+static unsigned char *snap_pack_pages(const ParkingSnapshot *snapshot,
+                                      size_t *size) {
+  const unsigned char *records =
+      snapshot->buffer + snap_records_offset(snapshot->page_count);
+  size_t table_size =
+      (size_t)snapshot->page_count * SNAP_PACKED_ENTRY_SIZE;
+  size_t capacity = SNAPSHOT_HEADER_SIZE + table_size;
+  unsigned char *packed;
+  size_t offset;
+  int page;
+
+  for (page = 0; page < snapshot->page_count; page++) {
+    capacity += compress_bound(snap_page_bytes(page, snapshot->slot_count));
+  }
+  packed = (unsigned char *)parking_memory_alloc(snapshot->memory,
+                                                 PARKING_MEMORY_IO, capacity);
+  if (packed == NULL) {
+    return NULL;
+  }
+
+  offset = SNAPSHOT_HEADER_SIZE + table_size;
+  for (page = 0; page < snapshot->page_count; page++) {
+    const unsigned char *raw =
+        records + (size_t)page * SNAPSHOT_PAGE_ROWS * SNAPSHOT_RECORD_SIZE;
+    size_t raw_size = snap_page_bytes(page, snapshot->slot_count);
+    size_t packed_size =
+        compress_block(raw, raw_size, packed + offset, capacity - offset);
+    unsigned char *entry = packed + SNAPSHOT_HEADER_SIZE +
+                           (size_t)page * SNAP_PACKED_ENTRY_SIZE;
+
+    if (packed_size == 0 || packed_size >= raw_size) {
+      memcpy(packed + offset, raw, raw_size);
+      packed_size = raw_size;
+    }
+    codec_put_u32(entry, (unsigned long)packed_size);
+    codec_put_u32(entry + 4,
+                  codec_get_u32(snapshot->buffer + SNAPSHOT_HEADER_SIZE +
+                                (size_t)page * SNAP_PAGE_SUM_SIZE));
+    offset += packed_size;
+  }
+  snap_put_header(packed, SNAP_VERSION_PACKED, snapshot, table_size);
+  *size = offset;
+  return packed;
+}
+
+/**
+ * @brief 把编码完成的快照逐页压缩后写成二进制快照文件。
+ * @param snapshot 全部页已编码的快照。
+ * @param filename 目标文件名。
+ * @return 成功返回 0；参数无效、仍有未编码的页或文件写入失败返回 -1；
+ *         内存不足返回 -2。
+ */
+int write_parking_snapshot_compressed(ParkingSnapshot *snapshot,
+                                      const char *filename) {
+  DurableFile file;
+  unsigned char *packed;
+  size_t size;
+  int result;
+
+  if (snapshot == NULL || snapshot->buffer == NULL || filename == NULL ||
+      snapshot->pages_left != 0) {
+    return -1;
+  }
+  packed = snap_pack_pages(snapshot, &size);
+  if (packed == NULL) {
+    return -2;
+  }
+
+  if (durable_file_open(&file, filename, "wb") != 0) {
+    result = -1;
+  } else if (fwrite(packed, 1, size, file.stream) != size) {
+    durable_file_abort(&file);
+    result = -1;
+  } else {
+    result = durable_file_commit(&file);
+  }
+  parking_memory_free(snapshot->memory, packed);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 写出文本文件的一行并累加校验和。
+ * @param file 正在写入的文件。
+ * @param line 以换行符结尾的一行。
+ * @param checksum 之前各行的校验和。
+ * @return 累加本行后的校验和。
+ */
+static unsigned long text_line_put(DurableFile *file, const char *line,
+                                   unsigned long checksum) {
+  fwrite(line, 1, strlen(line), file->stream);
+  return text_line_checksum(checksum, line);
+}
+
+/**
+ * @brief (静态辅助函数) 以十进制写出一个整数。
+ * @details 直接对 time_t 逐位取余，time_t 为 32 位或 64 位时都不会截断；
+ *          负数按每一位的余数取绝对值，最小值也不会溢出。
+ * @param out 输出位置。
+ * @param value 要写出的值。
+ * @return 写出的数字之后的位置。
+ */
+static char *text_put_decimal(char *out, time_t value) {
+  char digits[24];
+  int count = 0;
+
+  if (value < 0) {
+    *out++ = '-';
+  }
+  do {
+    int digit = (int)(value % 10);
+
+    digits[count++] = (char)('0' + (digit < 0 ? -digit : digit));
+    value /= 10;
+  } while (value != 0);
+  while (count > 0) {
+    *out++ = digits[--count];
+  }
+  return out;
+}
+
+/**
+ * @brief (静态辅助函数) 写出记录中一个以 NUL 填充的文本字段。
+ * @param out 输出位置。
+ * @param field 记录中的字段。
+ * @param width 字段宽度（含结尾 NUL）。
+ * @return 写出的文本之后的位置。
+ */
+static char *text_put_field(char *out, const unsigned char *field,
+                            size_t width) {
+  size_t len = 0;
+
+  while (len + 1 < width && field[len] != '\0') {
+    out[len] = (char)field[len];
+    len++;
+  }
+  return out + len;
+}
+
+/* 快照记录各种类字段的文本输出 */
+#define TEXT_PUT_INT(out, field, width)                                        \
+  text_put_decimal(out, (time_t)codec_get_i32(field))
+#define TEXT_PUT_TYPE(out, field, width) text_put_decimal(out, (time_t)*(field))
+#define TEXT_PUT_STATUS(out, field, width)                                     \
+  text_put_decimal(out, (time_t)*(field))
+#define TEXT_PUT_TIME(out, field, width)                                       \
+  text_put_decimal(out, codec_get_time(field))
+#define TEXT_PUT_LOCATION(out, field, width) text_put_field(out, field, width)
+#define TEXT_PUT_TEXT(out, field, width) text_put_field(out, field, width)
+
+/** (展开辅助宏) 写出分隔符与一个字段。 */
+#define TEXT_PUT_RECORD_FIELD(member, kind, width, tag, occupant)              \
+  *out++ = '|';                                                                \
+  out = TEXT_PUT_##kind(out, record + SNAP_OFF_##tag, width);
+
+/** 编译期检查：一行 `SLOT|` 记录总能放进 TEXT_LINE_MAX 字节。 */
+typedef char text_line_check
+    [PARKING_SLOT_TEXT_WIDTH + PARKING_SLOT_FIELD_COUNT * 24 + 8 <=
+             TEXT_LINE_MAX
+         ? 1
+         : -1];
+
+/**
+ * @brief (静态辅助函数) 把一条快照记录写成一行 `SLOT|` 文本。
+ * @details 由 parking_slot_schema.h 的字段表逐字段展开，不经过 printf。
+ * @param line 输出缓冲区（TEXT_LINE_MAX 字节）。
+ * @param record 源记录。
+ */
+static void text_encode_record(char *line, const unsigned char *record) {
+  char *out = line;
+
+  memcpy(out, "SLOT", 4);
+  out += 4;
+  PARKING_SLOT_FIELDS(TEXT_PUT_RECORD_FIELD)
+  *out++ = '\n';
+  *out = '\0';
+}
+
+/**
+ * @brief 把编码完成的快照写成 `LOT|` 文本文件。
+ * @details
+ * 文件格式如下：
+ * - 停车场信息: `LOT|<total_slots>|<格式版本>`
+ * - 车位信息:
+ * `SLOT|id|location|owner|license|contact|type|entry|exit|status|due_date`
+ *   空闲车位的车主、车牌等信息为空。
+ * - 尾行: `END|<车位行数>|<之前全部字节的校验和（8 位十六进制）>`
+ *
+ * 文件先写入临时文件，落盘后原子地替换目标文件。
+ * @param snapshot 全部页已编码的快照。
+ * @param filename 目标文件名。
+ * @return 成功返回 0，参数无效、仍有未编码的页或文件写入失败返回 -1。
+ */
+int write_parking_snapshot_text(const ParkingSnapshot *snapshot,
+                                const char *filename) {
+  DurableFile file;
+  TraceSpan span;
+  char line[TEXT_LINE_MAX];
+  const unsigned char *record;
+  unsigned long checksum;
+  int result;
+  int i;
+
+  if (snapshot == NULL || snapshot->buffer == NULL || filename == NULL ||
+      snapshot->pages_left != 0) {
+    return -1;
+  }
+  if (durable_file_open(&file, filename, "w") != 0) {
+    return -1;
+  }
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_IO, "text_write");
+
+  /* 核心修复：只保存总车位数，与 load_parking_data 的解析逻辑同步 */
+  sprintf(line, "LOT|%d|%d\n", snapshot->total_slots, TEXT_FORMAT_VERSION);
+  checksum = text_line_put(&file, line, codec_checksum(NULL, 0));
+
+  /* 空闲车位的记录中仅在场有效的字段已是 0，逐字段写出即可 */
+  for (i = 0; i < snapshot->slot_count; i++) {
+    record = snapshot->buffer + snap_records_offset(snapshot->page_count) +
+             (size_t)i * SNAPSHOT_RECORD_SIZE;
+    text_encode_record(line, record);
+    checksum = text_line_put(&file, line, checksum);
+  }
+
+  /* 尾行记录车位行数与之前全部字节的校验和，加载时据此识别残缺文件 */
+  fprintf(file.stream, "END|%d|%08lx\n", snapshot->slot_count, checksum);
+  result = durable_file_commit(&file);
+  PARKING_TRACE_END(span);
+  return result;
+}
+
+/**
+ * @brief 结束快照并释放其缓冲区。
+ * @param lot 快照所属的停车场。
+ * @param snapshot 要结束的快照。
+ */
+void end_parking_snapshot(ParkingLot *lot, ParkingSnapshot *snapshot) {
+  if (snapshot == NULL) {
+    return;
+  }
+  if (lot != NULL && lot->snapshot == snapshot) {
+    lot->snapshot = NULL;
+  }
+  snapshot_release(snapshot);
+}
+
+/**
+ * @brief 将停车场的所有数据保存到文本文件。
+ * @details
+ * 编码一份不登记到停车场的快照后按文本格式写出，格式见
+ * write_parking_snapshot_text。需要在保存期间继续修改停车场时，
+ * 改用 begin_parking_snapshot 系列函数。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 成功返回 0，若参数无效或文件无法写入则返回 -1，内存不足返回 -2。
+ */
+int save_parking_data(ParkingLot *lot, const char *filename) {
+  ParkingSnapshot snapshot;
+  int result;
+
+  if (lot == NULL || filename == NULL) {
+    return -1;
+  }
+  result = snapshot_init(lot, &snapshot);
+  if (result != 0) {
+    return result;
+  }
+  fill_parking_snapshot(lot, &snapshot, 0);
+  result = write_parking_snapshot_text(&snapshot, filename);
+  snapshot_release(&snapshot);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) qsort 比较函数：按入场时间、再按车位表行号排序。
+ * @param a 指向 ParkingSlot * 的指针。
+ * @param b 指向 ParkingSlot * 的指针。
+ * @return 比较结果。
+ */
+static int compare_entry_order(const void *a, const void *b) {
+  const ParkingSlot *left = *(ParkingSlot *const *)a;
+  const ParkingSlot *right = *(ParkingSlot *const *)b;
+
+  if (left->entry_time != right->entry_time) {
+    return left->entry_time < right->entry_time ? -1 : 1;
+  }
+  return left->table_index < right->table_index ? -1
+         : left->table_index > right->table_index ? 1
+                                                  : 0;
+}
+
+/**
+ * @brief 索引映像中各段在内存（通常是文件映射）中的位置。
+ */
+typedef struct IndexImage {
+  const unsigned char *ids;    /**< 编号索引桶。 */
+  size_t id_capacity;          /**< 编号索引桶数。 */
+  const unsigned char *plates; /**< 车牌索引桶。 */
+  size_t plate_capacity;       /**< 车牌索引桶数。 */
+  size_t plate_count;          /**< 车牌索引登记的车牌数。 */
+  const unsigned char *order;  /**< 在场车位的记录下标，从最早入场起。 */
+  size_t order_count;          /**< 入场顺序项数。 */
+} IndexImage;
+
+/**
+ * @brief (静态辅助函数) 由快照文件名得到索引映像的文件名。
+ * @param filename 快照文件名。
+ * @param[out] path 接收文件名，至少 DURABLE_FILE_MAX_PATH 字节。
+ * @return 成功返回 0，文件名过长返回 -1。
+ */
+static int index_image_path(const char *filename, char *path) {
+  size_t length = strlen(filename);
+
+  if (length + sizeof(INDEX_IMAGE_SUFFIX) > DURABLE_FILE_MAX_PATH) {
+    return -1;
+  }
+  memcpy(path, filename, length);
+  memcpy(path + length, INDEX_IMAGE_SUFFIX, sizeof(INDEX_IMAGE_SUFFIX));
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 把停车场的索引写成与刚写出的快照配对的索引映像。
+ * @details 桶布局按车位表顺序（即快照的记录顺序）重新排布，与停车场当前的
+ *          索引是否处于渐进扩容无关；入场顺序与加载时的排序规则相同。
+ * @param lot 刚保存快照的停车场，车位表在此期间未被修改。
+ * @param snapshot_sum 快照文件头的校验和，作为快照代号。
+ * @param filename 快照文件名。
+ * @return 成功返回 0，文件写入失败返回 -1，内存不足返回 -2。
+ */
+static int write_index_image(ParkingLot *lot, unsigned long snapshot_sum,
+                             const char *filename) {
+  char path[DURABLE_FILE_MAX_PATH];
+  DurableFile file;
+  ParkingSlot **occupied;
+  unsigned char *image;
+  unsigned char *order;
+  size_t row_count = (size_t)lot->slot_count;
+  size_t occupied_count = 0;
+  size_t id_capacity;
+  size_t plate_capacity;
+  size_t plate_count;
+  size_t size;
+  size_t i;
+  int sorted = 1;
+  int result;
+
+  if (index_image_path(filename, path) != 0) {
+    return -1;
+  }
+  for (i = 0; i < row_count; i++) {
+    occupied_count += lot->slot_table[i]->status == OCCUPIED_STATUS;
+  }
+  id_capacity = index_image_capacity(row_count);
+  plate_capacity = index_image_capacity(occupied_count);
+  size = INDEX_IMAGE_HEADER_SIZE + id_capacity * SLOT_ID_IMAGE_BUCKET +
+         plate_capacity * PLATE_IMAGE_BUCKET +
+         occupied_count * IMAGE_ORDER_ENTRY;
+  image = (unsigned char *)parking_memory_alloc(&lot->memory,
+                                                PARKING_MEMORY_IO, size);
+  occupied = (ParkingSlot **)parking_memory_alloc(
+      &lot->memory, PARKING_MEMORY_IO,
+      (occupied_count ? occupied_count : 1) * sizeof(ParkingSlot *));
+  if (image == NULL || occupied == NULL) {
+    parking_memory_free(&lot->memory, occupied);
+    parking_memory_free(&lot->memory, image);
+    return -2;
+  }
+
+  slot_id_index_write_image(lot->slot_table, row_count, id_capacity,
+                            image + INDEX_IMAGE_HEADER_SIZE);
+  plate_count = plate_index_write_image(
+      lot->slot_table, row_count, plate_capacity,
+      image + INDEX_IMAGE_HEADER_SIZE + id_capacity * SLOT_ID_IMAGE_BUCKET);
+  order = image + INDEX_IMAGE_HEADER_SIZE +
+          id_capacity * SLOT_ID_IMAGE_BUCKET +
+          plate_capacity * PLATE_IMAGE_BUCKET;
+  occupied_count = 0;
+  for (i = 0; i < row_count; i++) {
+    ParkingSlot *slot = lot->slot_table[i];
+
+    if (slot->status == OCCUPIED_STATUS) {
+      if (occupied_count > 0 &&
+          occupied[occupied_count - 1]->entry_time > slot->entry_time) {
+        sorted = 0;
+      }
+      occupied[occupied_count++] = slot;
+    }
+  }
+  if (!sorted) {
+    qsort(occupied, occupied_count, sizeof(ParkingSlot *),
+          compare_entry_order);
+  }
+  for (i = 0; i < occupied_count; i++) {
+    codec_put_u32(order + i * IMAGE_ORDER_ENTRY,
+                  (unsigned long)occupied[i]->table_index);
+  }
+  parking_memory_free(&lot->memory, occupied);
+
+  memcpy(image, INDEX_IMAGE_MAGIC, 8);
+  codec_put_u32(image + IMAGE_HDR_VERSION, INDEX_IMAGE_VERSION);
+  codec_put_u32(image + IMAGE_HDR_HEADER_SIZE, INDEX_IMAGE_HEADER_SIZE);
+  codec_put_u32(image + IMAGE_HDR_SNAPSHOT_SUM, snapshot_sum);
+  codec_put_u32(image + IMAGE_HDR_SLOT_COUNT, (unsigned long)row_count);
+  codec_put_u32(image + IMAGE_HDR_ID_CAPACITY, (unsigned long)id_capacity);
+  codec_put_u32(image + IMAGE_HDR_PLATE_CAPACITY,
+                (unsigned long)plate_capacity);
+  codec_put_u32(image + IMAGE_HDR_PLATE_COUNT, (unsigned long)plate_count);
+  codec_put_u32(image + IMAGE_HDR_ORDER_COUNT, (unsigned long)occupied_count);
+  codec_put_u32(image + IMAGE_HDR_BODY_SUM,
+                codec_checksum(image + INDEX_IMAGE_HEADER_SIZE,
+                               size - INDEX_IMAGE_HEADER_SIZE));
+  codec_put_u32(image + IMAGE_HDR_HEADER_SUM,
+                codec_checksum(image, IMAGE_HDR_HEADER_SUM));
+
+  result = durable_file_open(&file, path, "wb");
+  if (result == 0) {
+    if (fwrite(image, 1, size, file.stream) != size) {
+      durable_file_abort(&file);
+      result = -1;
+    } else {
+      result = durable_file_commit(&file);
+    }
+  }
+  parking_memory_free(&lot->memory, image);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 映射并校验与快照配对的索引映像。
+ * @details 映像的快照代号与记录条数必须与快照文件头一致，
+ *          各段长度之和必须恰好等于文件长度，映像体校验和必须正确。
+ * @param filename 快照文件名。
+ * @param header 已校验的快照文件头。
+ * @param[out] map 接收映像文件的映射，成功时由调用者关闭。
+ * @param[out] image 接收各段的位置。
+ * @return 映像可用返回 0，不存在或无效返回 -1（映射已关闭）。
+ */
+static int snap_open_index_image(const char *filename,
+                                 const unsigned char *header,
+                                 FileMapping *map, IndexImage *image) {
+  char path[DURABLE_FILE_MAX_PATH];
+  const unsigned char *data;
+  size_t rest;
+  int valid;
+
+  if (index_image_path(filename, path) != 0 ||
+      file_mapping_open(map, path) != 0) {
+    return -1;
+  }
+  data = map->data;
+  if (map->size < INDEX_IMAGE_HEADER_SIZE ||
+      memcmp(data, INDEX_IMAGE_MAGIC, 8) != 0 ||
+      codec_get_u32(data + IMAGE_HDR_HEADER_SUM) !=
+          codec_checksum(data, IMAGE_HDR_HEADER_SUM) ||
+      codec_get_u32(data + IMAGE_HDR_VERSION) != INDEX_IMAGE_VERSION ||
+      codec_get_u32(data + IMAGE_HDR_HEADER_SIZE) != INDEX_IMAGE_HEADER_SIZE ||
+      codec_get_u32(data + IMAGE_HDR_SNAPSHOT_SUM) !=
+          codec_get_u32(header + SNAP_HDR_HEADER_SUM) ||
+      codec_get_u32(data + IMAGE_HDR_SLOT_COUNT) !=
+          codec_get_u32(header + SNAP_HDR_SLOT_COUNT)) {
+    file_mapping_close(map);
+    return -1;
+  }
+
+  image->id_capacity = (size_t)codec_get_u32(data + IMAGE_HDR_ID_CAPACITY);
+  image->plate_capacity =
+      (size_t)codec_get_u32(data + IMAGE_HDR_PLATE_CAPACITY);
+  image->plate_count = (size_t)codec_get_u32(data + IMAGE_HDR_PLATE_COUNT);
+  image->order_count = (size_t)codec_get_u32(data + IMAGE_HDR_ORDER_COUNT);
+  /* 逐段扣减剩余长度，避免乘积溢出 */
+  rest = map->size - INDEX_IMAGE_HEADER_SIZE;
+  valid = image->id_capacity <= rest / SLOT_ID_IMAGE_BUCKET;
+  if (valid) {
+    rest -= image->id_capacity * SLOT_ID_IMAGE_BUCKET;
+    valid = image->plate_capacity <= rest / PLATE_IMAGE_BUCKET;
+  }
+  if (valid) {
+    rest -= image->plate_capacity * PLATE_IMAGE_BUCKET;
+    valid = rest % IMAGE_ORDER_ENTRY == 0 &&
+            rest / IMAGE_ORDER_ENTRY == image->order_count;
+  }
+  if (!valid || codec_get_u32(data + IMAGE_HDR_BODY_SUM) !=
+                    codec_checksum(data + INDEX_IMAGE_HEADER_SIZE,
+                                   map->size - INDEX_IMAGE_HEADER_SIZE)) {
+    file_mapping_close(map);
+    return -1;
+  }
+  image->ids = data + INDEX_IMAGE_HEADER_SIZE;
+  image->plates = image->ids + image->id_capacity * SLOT_ID_IMAGE_BUCKET;
+  image->order = image->plates + image->plate_capacity * PLATE_IMAGE_BUCKET;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 按索引映像建立新停车场的编号索引与车牌索引。
+ * @details 先核对入场顺序：项数等于在场车位数，各项都是在场车位，且按
+ *          入场时间、再按记录下标严格递增，因此恰好覆盖每个在场车位一次。
+ *          之后依次读入车牌索引和编号索引，任何一步不通过都恢复为空索引。
+ * @param lot 新建的停车场，索引为空。
+ * @param image 已校验的索引映像。
+ * @param nodes 与记录一一对应、已解码的车位节点。
+ * @param slot_count 记录条数。
+ * @param occupied_count 在场车位数。
+ * @return 成功返回 0，映像与记录不符或内存不足返回 -1。
+ */
+static int snap_adopt_index_image(ParkingLot *lot, const IndexImage *image,
+                                  ParkingSlot **nodes, int slot_count,
+                                  size_t occupied_count) {
+  const ParkingSlot *previous = NULL;
+  unsigned long last_row = 0;
+  size_t i;
+
+  if (image->order_count != occupied_count) {
+    return -1;
+  }
+  for (i = 0; i < image->order_count; i++) {
+    unsigned long row = codec_get_u32(image->order + i * IMAGE_ORDER_ENTRY);
+    const ParkingSlot *slot;
+
+    if (row >= (unsigned long)slot_count) {
+      return -1;
+    }
+    slot = nodes[row];
+    if (slot->status != OCCUPIED_STATUS ||
+        (previous != NULL &&
+         (slot->entry_time < previous->entry_time ||
+          (slot->entry_time == previous->entry_time && row <= last_row)))) {
+      return -1;
+    }
+    previous = slot;
+    last_row = row;
+  }
+
+  if (plate_index_read_image(&lot->plate_index, image->plates,
+                             image->plate_capacity, nodes, (size_t)slot_count,
+                             image->plate_count) != 0) {
+    return -1;
+  }
+  if (slot_id_index_read_image(&lot->id_index, image->ids, image->id_capacity,
+                               nodes, (size_t)slot_count) != 0) {
+    plate_index_free(&lot->plate_index);
+    plate_index_init(&lot->plate_index, &lot->memory);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief 将停车场的所有数据保存为二进制快照。
+ * @details
+ * 先在一块连续缓冲区中编码文件头和全部记录，再一次 fwrite 写出。
+ * 记录按稠密车位表顺序排列。快照写出后再写出配对的索引映像。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 成功返回 0，若参数无效或文件写入失败返回 -1，内存不足返回 -2。
+ */
+int save_parking_snapshot(ParkingLot *lot, const char *filename) {
+  ParkingSnapshot snapshot;
+  int result;
+
+  if (lot == NULL || filename == NULL) {
+    return -1;
+  }
+  result = snapshot_init(lot, &snapshot);
+  if (result != 0) {
+    return result;
+  }
+  fill_parking_snapshot(lot, &snapshot, 0);
+  result = write_parking_snapshot(&snapshot, filename);
+  if (result == 0) {
+    /* 映像写不出时旧映像的代号对不上新快照，加载时被忽略 */
+    write_index_image(lot,
+                      codec_get_u32(snapshot.buffer + SNAP_HDR_HEADER_SUM),
+                      filename);
+  }
+  snapshot_release(&snapshot);
+  return result;
+}
+
+/**
+ * @brief 将停车场的所有数据保存为各页压缩的二进制快照。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 成功返回 0，若参数无效或文件写入失败返回 -1，内存不足返回 -2。
+ */
+int save_parking_snapshot_compressed(ParkingLot *lot, const char *filename) {
+  ParkingSnapshot snapshot;
+  int result;
+
+  if (lot == NULL || filename == NULL) {
+    return -1;
+  }
+  result = snapshot_init(lot, &snapshot);
+  if (result != 0) {
+    return result;
+  }
+  fill_parking_snapshot(lot, &snapshot, 0);
+  result = write_parking_snapshot_compressed(&snapshot, filename);
+  snapshot_release(&snapshot);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 把快照中已编码的脏页写成增量文件。
+ * @param snapshot 脏页已编码的快照。
+ * @param dirty 停车场的脏页集合。
+ * @param filename 增量文件路径。
+ * @return 成功返回 0，文件写入失败返回 -1，内存不足返回 -2。
+ */
+static int snap_write_delta(const ParkingSnapshot *snapshot,
+                            const SnapshotDirtySet *dirty,
+                            const char *filename) {
+  const unsigned char *records =
+      snapshot->buffer + snap_records_offset(snapshot->page_count);
+  unsigned char header[SNAPSHOT_DELTA_HEADER_SIZE];
+  unsigned char *manifest;
+  unsigned long entries = 0;
+  unsigned long i;
+  DurableFile file;
+  int page;
+  int result = 0;
+
+  manifest = (unsigned char *)parking_memory_alloc(
+      snapshot->memory, PARKING_MEMORY_IO,
+      (size_t)snapshot->page_count * DELTA_ENTRY_SIZE + 1);
+  if (manifest == NULL) {
+    return -2;
+  }
+  for (page = 0; page < snapshot->page_count && page < dirty->capacity;
+       page++) {
+    if (dirty->pages[page]) {
+      codec_put_u32(manifest + entries * DELTA_ENTRY_SIZE,
+                    (unsigned long)page);
+      codec_put_u32(manifest + entries * DELTA_ENTRY_SIZE + 4,
+                    codec_get_u32(snapshot->buffer + SNAPSHOT_HEADER_SIZE +
+                                  (size_t)page * SNAP_PAGE_SUM_SIZE));
+      entries++;
+    }
+  }
+
+  memcpy(header, SNAPSHOT_DELTA_MAGIC, 8);
+  codec_put_u32(header + DELTA_HDR_VERSION, SNAPSHOT_DELTA_VERSION);
+  codec_put_u32(header + DELTA_HDR_BASE_SUM, dirty->base_sum);
+  codec_put_i32(header + DELTA_HDR_TOTAL_SLOTS, snapshot->total_slots);
+  codec_put_u32(header + DELTA_HDR_SLOT_COUNT,
+                (unsigned long)snapshot->slot_count);
+  codec_put_u32(header + DELTA_HDR_PAGE_COUNT, entries);
+  codec_put_u32(header + DELTA_HDR_MANIFEST_SUM,
+                codec_checksum(manifest, entries * DELTA_ENTRY_SIZE));
+  codec_put_u32(header + DELTA_HDR_HEADER_SUM,
+                codec_checksum(header, DELTA_HDR_HEADER_SUM));
+
+  if (durable_file_open(&file, filename, "wb") != 0) {
+    parking_memory_free(snapshot->memory, manifest);
+    return -1;
+  }
+  if (fwrite(header, 1, sizeof(header), file.stream) != sizeof(header) ||
+      fwrite(manifest, 1, entries * DELTA_ENTRY_SIZE, file.stream) !=
+          entries * DELTA_ENTRY_SIZE) {
+    result = -1;
+  }
+  for (i = 0; i < entries && result == 0; i++) {
+    size_t bytes;
+
+    page = (int)codec_get_u32(manifest + i * DELTA_ENTRY_SIZE);
+    bytes = snap_page_bytes(page, snapshot->slot_count);
+    if (fwrite(records + (size_t)page * SNAPSHOT_PAGE_ROWS *
+                              SNAPSHOT_RECORD_SIZE,
+               1, bytes, file.stream) != bytes) {
+      result = -1;
+    }
+  }
+  parking_memory_free(snapshot->memory, manifest);
+  if (result != 0) {
+    durable_file_abort(&file);
+    return result;
+  }
+  return durable_file_commit(&file);
+}
+
+/**
+ * @brief 写出增量检查点：只保存自上次完整检查点以来被修改过的页。
+ * @details 只编码脏页即可写出增量；完整检查点成功之后才清空脏页并更换基准，
+ *          写入失败时原基准与脏页保持不变。
+ * @param lot 要保存的停车场。
+ * @param base_path 完整快照的路径。
+ * @param delta_path 增量文件的路径。
+ * @return 写出完整快照返回 0，写出增量返回 1；参数无效或文件写入失败返回 -1，
+ *         内存不足返回 -2。
+ */
+int save_parking_checkpoint(ParkingLot *lot, const char *base_path,
+                            const char *delta_path) {
+  SnapshotDirtySet *dirty;
+  ParkingSnapshot snapshot;
+  int page;
+  int result;
+
+  if (lot == NULL || base_path == NULL || delta_path == NULL) {
+    return -1;
+  }
+  dirty = &lot->checkpoint;
+  result = snapshot_init(lot, &snapshot);
+  if (result != 0) {
+    return result;
+  }
+
+  if (dirty->has_base && (long)dirty->dirty_count * 100 <=
+                             (long)snapshot.page_count *
+                                 SNAPSHOT_DELTA_MAX_PERCENT) {
+    for (page = 0; page < snapshot.page_count && page < dirty->capacity;
+         page++) {
+      if (dirty->pages[page]) {
+        snapshot_encode_page(&snapshot, page);
+      }
+    }
+    result = snap_write_delta(&snapshot, dirty, delta_path);
+    snapshot_release(&snapshot);
+    return result == 0 ? 1 : result;
+  }
+
+  fill_parking_snapshot(lot, &snapshot, 0);
+  result = write_parking_snapshot(&snapshot, base_path);
+  if (result == 0) {
+    /* 删除失败也无妨：旧增量的基准校验和对不上新快照，加载时被忽略 */
+    remove(delta_path);
+    if (dirty->pages != NULL) {
+      memset(dirty->pages, 0, (size_t)dirty->capacity);
+    }
+    dirty->dirty_count = 0;
+    dirty->has_base = 1;
+    dirty->base_sum = codec_get_u32(snapshot.buffer + SNAP_HDR_HEADER_SUM);
+  }
+  snapshot_release(&snapshot);
+  return result;
+}
+
+/**
+ * @brief 一个加载线程负责的页范围及其结果。
+ */
+typedef struct SnapLoadWorker {
+  const unsigned char *records;   /**< 记录区起始地址。 */
+  const unsigned char *page_sums; /**< 页表，NULL 表示记录区已整体校验。 */
+  ParkingSlot **nodes;            /**< 与记录一一对应的车位节点。 */
+  int slot_count;                 /**< 记录总条数。 */
+  int first_page;                 /**< 负责的第一页。 */
+  int last_page;                  /**< 负责的最后一页之后。 */
+  StringStore text;               /**< 私有的文本存储，汇合后并入停车场。 */
+  int borrow_text;                /**< 非 0 表示文本字段直接引用记录区。 */
+  int result; /**< 0 成功，-1 页校验失败，-2 内存不足。 */
+} SnapLoadWorker;
+
+/**
+ * @brief (静态辅助函数) 校验快照文件头并取出停车场参数。
+ * @param header 文件头（SNAPSHOT_HEADER_SIZE 字节）。
+ * @param[out] version 格式版本。
+ * @param[out] total_slots 停车场总车位数。
+ * @param[out] slot_count 记录条数。
+ * @param[out] record_sum 页表校验和（旧版本为记录区校验和）。
+ * @return 文件头有效返回 0，否则返回 -1。
+ */
+static int snap_parse_header(const unsigned char *header, int *version,
+                             int *total_slots, int *slot_count,
+                             unsigned long *record_sum) {
+  if (memcmp(header, SNAPSHOT_MAGIC, 8) != 0 ||
+      codec_get_u32(header + SNAP_HDR_HEADER_SUM) !=
+          codec_checksum(header, SNAP_HDR_HEADER_SUM) ||
+      codec_get_u32(header + SNAP_HDR_HEADER_SIZE) != SNAPSHOT_HEADER_SIZE ||
+      codec_get_u32(header + SNAP_HDR_RECORD_SIZE) != SNAPSHOT_RECORD_SIZE) {
+    return -1;
+  }
+
+  *version = (int)codec_get_u32(header + SNAP_HDR_VERSION);
+  *total_slots = codec_get_i32(header + SNAP_HDR_TOTAL_SLOTS);
+  *slot_count = (int)codec_get_u32(header + SNAP_HDR_SLOT_COUNT);
+  *record_sum = codec_get_u32(header + SNAP_HDR_RECORD_SUM);
+  /* 删除车位会使总车位数减到 0 以下，保存时照写，加载时同样接受 */
+  if ((*version != SNAPSHOT_VERSION && *version != SNAP_VERSION_FLAT &&
+       *version != SNAP_VERSION_PACKED) ||
+      *slot_count < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 取文件头之后页表与记录区的总字节数。
+ * @details 压缩版本各页长度不定，只返回页表的字节数（文件体的下限）。
+ * @param version 格式版本。
+ * @param slot_count 记录条数。
+ * @return 字节数。
+ */
+static size_t snap_body_size(int version, int slot_count) {
+  size_t records_size = (size_t)slot_count * SNAPSHOT_RECORD_SIZE;
+
+  if (version == SNAP_VERSION_FLAT) {
+    return records_size;
+  }
+  if (version == SNAP_VERSION_PACKED) {
+    return (size_t)snap_page_count(slot_count) * SNAP_PACKED_ENTRY_SIZE;
+  }
+  return snap_records_offset(snap_page_count(slot_count)) -
+         SNAPSHOT_HEADER_SIZE + records_size;
+}
+
+/**
+ * @brief (静态辅助函数) 在文件头之后的数据中定位页表与记录区。
+ * @details 当前版本只校验页表本身，各页由加载线程分别校验；
+ *          旧版本在这里整体校验记录区。
+ * @param version 格式版本。
+ * @param body 文件头之后的数据（snap_body_size 字节）。
+ * @param slot_count 记录条数。
+ * @param record_sum 文件头中的校验和。
+ * @param[out] page_sums 页表，旧版本为 NULL。
+ * @param[out] records 记录区起始地址。
+ * @return 校验通过返回 0，否则返回 -1。
+ */
+static int snap_locate_body(int version, const unsigned char *body,
+                            int slot_count, unsigned long record_sum,
+                            const unsigned char **page_sums,
+                            const unsigned char **records) {
+  size_t table_size;
+
+  if (version == SNAP_VERSION_FLAT) {
+    *page_sums = NULL;
+    *records = body;
+    return codec_checksum(body, snap_body_size(version, slot_count)) ==
+                   record_sum
+               ? 0
+               : -1;
+  }
+  table_size = (size_t)snap_page_count(slot_count) * SNAP_PAGE_SUM_SIZE;
+  *page_sums = body;
+  *records = body + table_size;
+  return codec_checksum(body, table_size) == record_sum ? 0 : -1;
+}
+
+/**
+ * @brief (静态辅助函数) 加载线程的入口：校验并解码一段页。
+ * @details 只写自己负责的车位节点和私有文本存储，与其他线程不共享可变状态。
+ * @param arg 对应的 SnapLoadWorker 对象。
+ */
+static void snap_load_worker(void *arg) {
+  SnapLoadWorker *worker = (SnapLoadWorker *)arg;
+  int page;
+  int first;
+  int last;
+  int i;
+
+  for (page = worker->first_page; page < worker->last_page; page++) {
+    first = page * SNAPSHOT_PAGE_ROWS;
+    last = first + SNAPSHOT_PAGE_ROWS;
+    if (last > worker->slot_count) {
+      last = worker->slot_count;
+    }
+    if (worker->page_sums != NULL &&
+        codec_get_u32(worker->page_sums + (size_t)page * SNAP_PAGE_SUM_SIZE) !=
+            codec_checksum(
+                worker->records + (size_t)first * SNAPSHOT_RECORD_SIZE,
+                (size_t)(last - first) * SNAPSHOT_RECORD_SIZE)) {
+      worker->result = -1;
+      return;
+    }
+    for (i = first; i < last; i++) {
+      if (snap_decode_fields(worker->nodes[i],
+                             worker->records +
+                                 (size_t)i * SNAPSHOT_RECORD_SIZE,
+                             &worker->text, worker->borrow_text) != 0) {
+        worker->result = -2;
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 取并行加载使用的线程数。
+ * @details 取处理器数，但不超过 SNAP_LOAD_MAX_THREADS，
+ *          且每个线程至少分到 SNAP_LOAD_MIN_PAGES 页。
+ * @param page_count 页数。
+ * @return 线程数（至少为 1）。
+ */
+static int snap_worker_count(int page_count) {
+  int worker_count = parking_cpu_count();
+
+  if (worker_count > SNAP_LOAD_MAX_THREADS) {
+    worker_count = SNAP_LOAD_MAX_THREADS;
+  }
+  if (worker_count > page_count / SNAP_LOAD_MIN_PAGES) {
+    worker_count = page_count / SNAP_LOAD_MIN_PAGES;
+  }
+  return worker_count < 1 ? 1 : worker_count;
+}
+
+/**
+ * @brief (静态辅助函数) 在若干线程上运行同一个加载函数并等待全部结束。
+ * @details 第一段在调用线程上运行，无法创建线程时该段同样在调用线程上完成。
+ * @param fn 加载函数。
+ * @param workers 各线程参数组成的数组。
+ * @param stride 数组中每个元素的字节数。
+ * @param worker_count 线程数。
+ */
+static void snap_run_workers(ParkingThreadFn fn, void *workers, size_t stride,
+                             int worker_count) {
+  ParkingThread *threads[SNAP_LOAD_MAX_THREADS];
+  char *base = (char *)workers;
+  int i;
+
+  threads[0] = NULL;
+  for (i = 1; i < worker_count; i++) {
+    threads[i] = parking_thread_start(fn, base + (size_t)i * stride);
+  }
+  fn(base);
+  for (i = 1; i < worker_count; i++) {
+    if (threads[i] != NULL) {
+      parking_thread_join(threads[i]);
+    } else {
+      fn(base + (size_t)i * stride);
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 把各页分给若干线程并行校验、解码。
+ * @details 线程数由 snap_worker_count 决定。
+ *          结束后各线程的文本存储并入停车场，之后只能由单线程访问。
+ * @param lot 新建的停车场。
+ * @param records 记录区。
+ * @param page_sums 页表，NULL 表示记录区已整体校验。
+ * @param nodes 与记录一一对应、已初始化为空闲的车位节点。
+ * @param slot_count 记录条数。
+ * @param borrow_text 非 0 表示文本字段直接引用记录区。
+ * @return 成功返回 0，页校验失败返回 -1，内存不足返回 -2。
+ */
+static int snap_decode_pages(ParkingLot *lot, const unsigned char *records,
+                             const unsigned char *page_sums,
+                             ParkingSlot **nodes, int slot_count,
+                             int borrow_text) {
+  SnapLoadWorker workers[SNAP_LOAD_MAX_THREADS];
+  int page_count = snap_page_count(slot_count);
+  int worker_count = snap_worker_count(page_count);
+  int result = 0;
+  int i;
+
+  for (i = 0; i < worker_count; i++) {
+    workers[i].records = records;
+    workers[i].page_sums = page_sums;
+    workers[i].nodes = nodes;
+    workers[i].slot_count = slot_count;
+    workers[i].first_page = (int)((long)page_count * i / worker_count);
+    workers[i].last_page = (int)((long)page_count * (i + 1) / worker_count);
+    workers[i].result = 0;
+    workers[i].borrow_text = borrow_text;
+    string_store_init(&workers[i].text, &lot->memory);
+  }
+  snap_run_workers(snap_load_worker, workers, sizeof(SnapLoadWorker),
+                   worker_count);
+
+  for (i = 0; i < worker_count; i++) {
+    string_store_adopt_text(&lot->strings, &workers[i].text);
+    if (result == 0) {
+      result = workers[i].result;
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 把解码完成的车位一次性登记到停车场的各个索引。
+ * @details 车位表、编号索引和车牌索引先按记录数预留容量，登记中不再扩容；
+ *          重复编号由编号索引的插入在 O(1) 内发现并丢弃。
+ *          入场时间链表不逐个插入，而是把在场车位排序后整体接上，
+ *          记录顺序与入场顺序无关时也不会退化为 O(n²)。
+ *          有可用的索引映像时，编号索引、车牌索引与入场顺序直接按映像建立，
+ *          不再散列、排序；映像与记录对不上时照常重建。
+ * @param lot 新建的停车场。
+ * @param records 记录区（用于读取位置描述）。
+ * @param nodes 与记录一一对应的车位节点；被丢弃的重复车位置为 NULL。
+ * @param slot_count 记录条数。
+ * @param image 与快照配对的索引映像，NULL 表示没有。
+ * @return 成功返回 0，内存不足返回 -2。
+ */
+static int snap_index_slots(ParkingLot *lot, const unsigned char *records,
+                            ParkingSlot **nodes, int slot_count,
+                            const IndexImage *image) {
+  ParkingSlot **occupied;
+  size_t occupied_count = 0;
+  int indexed;
+  int sorted = 1;
+  int i;
+
+  for (i = 0; i < slot_count; i++) {
+    if (nodes[i]->status == OCCUPIED_STATUS) {
+      occupied_count++;
+    }
+  }
+  indexed = image != NULL &&
+            snap_adopt_index_image(lot, image, nodes, slot_count,
+                                   occupied_count) == 0;
+  if (slot_table_reserve(lot, slot_count) != 0 ||
+      (!indexed &&
+       (slot_id_index_reserve(&lot->id_index, (size_t)slot_count) != 0 ||
+        plate_index_reserve(&lot->plate_index, occupied_count) != 0))) {
+    return -2;
+  }
+  occupied = (ParkingSlot **)parking_memory_alloc(
+      &lot->memory, PARKING_MEMORY_IO,
+      (occupied_count ? occupied_count : 1) * sizeof(ParkingSlot *));
+  if (occupied == NULL) {
+    return -2;
+  }
+
+  occupied_count = 0;
+  for (i = 0; i < slot_count; i++) {
+    ParkingSlot *slot = nodes[i];
+    int add_result;
+
+    if (slot_set_location(slot, (const char *)records +
+                                    (size_t)i * SNAPSHOT_RECORD_SIZE +
+                                    SNAP_OFF_LOCATION) != 0) {
+      parking_memory_free(&lot->memory, occupied);
+      return -2;
+    }
+    add_result = indexed ? attach_indexed_slot(lot, slot, 0)
+                         : attach_slot(lot, slot, 0);
+    if (add_result == -2) {
+      arena_release_slot(lot, slot);
+      nodes[i] = NULL;
+      continue;
+    }
+    if (add_result != 0) {
+      parking_memory_free(&lot->memory, occupied);
+      return -2;
+    }
+    if (slot->status == OCCUPIED_STATUS) {
+      if (!indexed) {
+        if (occupied_count > 0 &&
+            occupied[occupied_count - 1]->entry_time > slot->entry_time) {
+          sorted = 0;
+        }
+        occupied[occupied_count++] = slot;
+        plate_index_insert(&lot->plate_index, slot);
+      }
+      search_index_add(lot, slot);
+    }
+  }
+
+  if (indexed) {
+    for (occupied_count = 0; occupied_count < image->order_count;
+         occupied_count++) {
+      occupied[occupied_count] = nodes[codec_get_u32(
+          image->order + occupied_count * IMAGE_ORDER_ENTRY)];
+    }
+  } else if (!sorted) {
+    qsort(occupied, occupied_count, sizeof(ParkingSlot *),
+          compare_entry_order);
+  }
+  entry_order_append_sorted(&lot->entry_order, occupied, occupied_count);
+  parking_memory_free(&lot->memory, occupied);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 由已定位的记录区重建停车场。
+ * @details
+ * 分三步进行：先在调用线程上从新停车场的内存池取出全部车位节点；
+ * 再由 snap_decode_pages 多线程校验各页并解码定长字段与车主文本；
+ * 最后由 snap_index_slots 单线程驻留位置描述并批量登记索引。
+ * 重复编号的记录被丢弃。borrow_text 非 0 时记录区登记为停车场文本存储的
+ * 借用区间，车主、车牌、联系方式直接引用记录而不复制。
+ * @param total_slots 停车场总车位数。
+ * @param records 记录区起始地址。
+ * @param page_sums 页表，NULL 表示记录区已整体校验。
+ * @param slot_count 记录条数。
+ * @param allocator 新停车场的分配函数，NULL 表示 C 标准库。
+ * @param borrow_text 非 0 表示文本字段直接引用记录区。
+ * @param image 与快照配对的索引映像，NULL 表示没有。
+ * @return 成功返回新停车场，校验失败或内存不足返回 NULL。
+ */
+static ParkingLot *snap_build_lot(int total_slots,
+                                  const unsigned char *records,
+                                  const unsigned char *page_sums,
+                                  int slot_count,
+                                  const ParkingAllocator *allocator,
+                                  int borrow_text, const IndexImage *image) {
+  ParkingLot *lot;
+  ParkingSlot **nodes;
+  int result = 0;
+  int allocated;
+  int i;
+
+  lot = init_parking_lot_with_allocator(total_slots, allocator);
+  if (lot == NULL) {
+    return NULL;
+  }
+  if (borrow_text) {
+    string_store_borrow(&lot->strings, (const char *)records,
+                        (size_t)slot_count * SNAPSHOT_RECORD_SIZE);
+  }
+  nodes = (ParkingSlot **)parking_memory_alloc(
+      &lot->memory, PARKING_MEMORY_IO,
+      (slot_count ? (size_t)slot_count : 1) * sizeof(ParkingSlot *));
+  if (nodes == NULL) {
+    free_parking_lot(lot);
+    return NULL;
+  }
+
+  for (allocated = 0; allocated < slot_count; allocated++) {
+    nodes[allocated] = arena_alloc_slot(lot);
+    if (nodes[allocated] == NULL) {
+      result = -2;
+      break;
+    }
+    init_slot_fields(nodes[allocated], 0, "", SLOT_STORAGE_ARENA,
+                     &lot->strings);
+  }
+  if (result == 0) {
+    result = snap_decode_pages(lot, records, page_sums, nodes, slot_count,
+                               borrow_text);
+  }
+  if (result == 0) {
+    result = snap_index_slots(lot, records, nodes, slot_count, image);
+  }
+
+  if (result != 0) {
+    /* 尚未登记的节点不在车位链表上，须单独归还 */
+    for (i = 0; i < allocated; i++) {
+      if (nodes[i] != NULL && nodes[i]->table_index < 0) {
+        arena_release_slot(lot, nodes[i]);
+      }
+    }
+    parking_memory_free(&lot->memory, nodes);
+    free_parking_lot(lot);
+    return NULL;
+  }
+  parking_memory_free(&lot->memory, nodes);
+  return lot;
+}
+
+/**
+ * @brief 一个解压线程负责的页范围及其结果。
+ */
+typedef struct SnapInflateWorker {
+  const unsigned char *body;    /**< 文件头之后的数据，以页表开头。 */
+  const size_t *offsets;        /**< 各页压缩数据在 body 中的偏移。 */
+  unsigned char *records;       /**< 解压目标：完整的记录区。 */
+  int slot_count;               /**< 记录总条数。 */
+  int first_page;               /**< 负责的第一页。 */
+  int last_page;                /**< 负责的最后一页之后。 */
+  int result;                   /**< 0 成功，-1 数据损坏或页校验失败。 */
+} SnapInflateWorker;
+
+/**
+ * @brief (静态辅助函数) 线程函数：解压并校验一段连续的页。
+ * @param arg 对应的 SnapInflateWorker 对象。
+ */
+static void snap_inflate_worker(void *arg) {
+  SnapInflateWorker *worker = (SnapInflateWorker *)arg;
+  int page;
+
+  for (page = worker->first_page; page < worker->last_page; page++) {
+    const unsigned char *entry =
+        worker->body + (size_t)page * SNAP_PACKED_ENTRY_SIZE;
+    size_t packed_size = (size_t)codec_get_u32(entry);
+    size_t raw_size = snap_page_bytes(page, worker->slot_count);
+    unsigned char *raw = worker->records + (size_t)page * SNAPSHOT_PAGE_ROWS *
+                                               SNAPSHOT_RECORD_SIZE;
+    size_t out_size;
+
+    if (packed_size == raw_size) {
+      memcpy(raw, worker->body + worker->offsets[page], raw_size);
+    } else if (decompress_block(worker->body + worker->offsets[page],
+                                packed_size, raw, raw_size, &out_size) != 0 ||
+               out_size != raw_size) {
+      worker->result = -1;
+      return;
+    }
+    if (codec_get_u32(entry + 4) != codec_checksum(raw, raw_size)) {
+      worker->result = -1;
+      return;
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 由压缩版本的文件体重建停车场。
+ * @details 先按页表算出各页的偏移并检查越界，再由 snap_worker_count 个
+ *          线程并行解压、校验各页到一块完整的记录区，最后照常由
+ *          snap_build_lot 解码（各页已校验，不再重复校验）。
+ * @param body 文件头之后的数据。
+ * @param body_size body 的字节数。
+ * @param total_slots 停车场总车位数。
+ * @param slot_count 记录条数。
+ * @param table_sum 文件头中的页表校验和。
+ * @param allocator 新停车场的分配函数，NULL 表示 C 标准库。
+ * @param image 与快照配对的索引映像，NULL 表示没有。
+ * @return 成功返回新停车场，数据损坏或内存不足返回 NULL。
+ */
+static ParkingLot *snap_load_packed(const unsigned char *body,
+                                    size_t body_size, int total_slots,
+                                    int slot_count, unsigned long table_sum,
+                                    const ParkingAllocator *allocator,
+                                    const IndexImage *image) {
+  SnapInflateWorker workers[SNAP_LOAD_MAX_THREADS];
+  int page_count = snap_page_count(slot_count);
+  size_t table_size = (size_t)page_count * SNAP_PACKED_ENTRY_SIZE;
+  size_t *offsets;
+  unsigned char *records;
+  size_t offset = table_size;
+  ParkingLot *lot = NULL;
+  int worker_count;
+  int result = 0;
+  int page;
+  int i;
+
+  if (body_size < table_size || codec_checksum(body, table_size) != table_sum) {
+    return NULL;
+  }
+  offsets = (size_t *)malloc((size_t)(page_count + 1) * sizeof(size_t));
+  records = (unsigned char *)malloc(
+      slot_count ? (size_t)slot_count * SNAPSHOT_RECORD_SIZE : 1);
+  if (offsets == NULL || records == NULL) {
+    free(offsets);
+    free(records);
+    return NULL;
+  }
+
+  for (page = 0; page < page_count; page++) {
+    size_t packed_size =
+        (size_t)codec_get_u32(body + (size_t)page * SNAP_PACKED_ENTRY_SIZE);
+
+    if (packed_size > snap_page_bytes(page, slot_count) ||
+        packed_size > body_size - offset) {
+      result = -1;
+      break;
+    }
+    offsets[page] = offset;
+    offset += packed_size;
+  }
+
+  if (result == 0) {
+    worker_count = snap_worker_count(page_count);
+    for (i = 0; i < worker_count; i++) {
+      workers[i].body = body;
+      workers[i].offsets = offsets;
+      workers[i].records = records;
+      workers[i].slot_count = slot_count;
+      workers[i].first_page = (int)((long)page_count * i / worker_count);
+      workers[i].last_page = (int)((long)page_count * (i + 1) / worker_count);
+      workers[i].result = 0;
+    }
+    snap_run_workers(snap_inflate_worker, workers, sizeof(SnapInflateWorker),
+                     worker_count);
+    for (i = 0; i < worker_count; i++) {
+      if (workers[i].result != 0) {
+        result = -1;
+      }
+    }
+  }
+  if (result == 0) {
+    lot = snap_build_lot(total_slots, records, NULL, slot_count, allocator, 0,
+                         image);
+  }
+  free(offsets);
+  free(records);
+  return lot;
+}
+
+/**
+ * @brief 从二进制快照中加载停车场数据。
+ * @details 有配对的索引映像时按映像建立索引。
+ * @param filename 源文件名。
+ * @return 成功时返回重建的 ParkingLot 指针；文件不存在、版本不支持、
+ * 校验失败或内存不足时返回 NULL。
+ */
+ParkingLot *load_parking_snapshot(const char *filename) {
+  FILE *file;
+  FileMapping image_map;
+  IndexImage image;
+  const IndexImage *use_image;
+  unsigned char header[SNAPSHOT_HEADER_SIZE];
+  unsigned char *body;
+  const unsigned char *page_sums;
+  const unsigned char *records;
+  size_t body_size;
+  unsigned long record_sum;
+  int version;
+  int total_slots;
+  int slot_count;
+  ParkingLot *lot = NULL;
+
+  if (filename == NULL) {
+    return NULL;
+  }
+  file = fopen(filename, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+
+  if (fread(header, 1, SNAPSHOT_HEADER_SIZE, file) != SNAPSHOT_HEADER_SIZE ||
+      snap_parse_header(header, &version, &total_slots, &slot_count,
+                        &record_sum) != 0) {
+    fclose(file);
+    return NULL;
+  }
+
+  /* 压缩版本的文件体长度由页表决定，整个读入 */
+  body_size = snap_body_size(version, slot_count);
+  if (version == SNAP_VERSION_PACKED) {
+    long end;
+
+    if (fseek(file, 0, SEEK_END) != 0 || (end = ftell(file)) < 0 ||
+        fseek(file, SNAPSHOT_HEADER_SIZE, SEEK_SET) != 0 ||
+        (size_t)end < SNAPSHOT_HEADER_SIZE + body_size) {
+      fclose(file);
+      return NULL;
+    }
+    body_size = (size_t)end - SNAPSHOT_HEADER_SIZE;
+  }
+  body = (unsigned char *)malloc(body_size ? body_size : 1);
+  if (body == NULL) {
+    fclose(file);
+    return NULL;
+  }
+  use_image = snap_open_index_image(filename, header, &image_map, &image) == 0
+                  ? &image
+                  : NULL;
+  if (fread(body, 1, body_size, file) != body_size) {
+    lot = NULL;
+  } else if (version == SNAP_VERSION_PACKED) {
+    lot = snap_load_packed(body, body_size, total_slots, slot_count,
+                           record_sum, NULL, use_image);
+  } else if (snap_locate_body(version, body, slot_count, record_sum,
+                              &page_sums, &records) == 0) {
+    lot = snap_build_lot(total_slots, records, page_sums, slot_count, NULL, 0,
+                         use_image);
+  }
+  if (use_image != NULL) {
+    file_mapping_close(&image_map);
+  }
+  fclose(file);
+  free(body);
+  return lot;
+}
 
 /**
- * @brief (静态辅助函数) 解析并赋值单个字段。
- * @details 从文件加载数据时，根据字段索引将字符串值解析并赋给 ParkingSlot
- * 对象的相应成员。
- * @param slot 指向要修改的 ParkingSlot 对象的指针。
- * @param index 字段的索引 (0-9)。
- * @param value 要解析的字符串值。
+ * @brief (静态辅助函数) 校验内存中的快照内容并由它重建停车场。
+ * @param data 快照内容。
+ * @param size 字节数。
+ * @param allocator 新停车场的分配函数，NULL 表示 C 标准库。
+ * @param borrow_text 非 0 表示文本字段直接引用 data。
+ * @param filename 快照文件名，用于查找配对的索引映像；NULL 表示不使用映像。
+ * @return 成功时返回重建的 ParkingLot 指针，失败返回 NULL。
  */
-static void parse_and_assign_field(ParkingSlot *slot, int index,
-                                   const char *value) {
-  if (!value) {
-    return;
+static ParkingLot *snap_load_memory(const unsigned char *data, size_t size,
+                                    const ParkingAllocator *allocator,
+                                    int borrow_text, const char *filename) {
+  FileMapping image_map;
+  IndexImage image;
+  const IndexImage *use_image = NULL;
+  const unsigned char *page_sums;
+  const unsigned char *records;
+  unsigned long record_sum;
+  ParkingLot *lot = NULL;
+  int version;
+  int total_slots;
+  int slot_count;
+
+  if (data == NULL || size < SNAPSHOT_HEADER_SIZE ||
+      snap_parse_header(data, &version, &total_slots, &slot_count,
+                        &record_sum) != 0 ||
+      size - SNAPSHOT_HEADER_SIZE < snap_body_size(version, slot_count)) {
+    return NULL;
   }
-  switch (index) {
-  case 0:
-    slot->slot_id = atoi(value);
-    break;
-  case 1:
-    strncpy(slot->location, value, MAX_LOCATION_LEN - 1);
-    break;
-  case 2:
-    strncpy(slot->owner_name, value, MAX_NAME_LEN - 1);
-    break;
-  case 3:
-    strncpy(slot->license_plate, value, MAX_LICENSE_LEN - 1);
-    break;
-  case 4:
-    strncpy(slot->contact, value, MAX_CONTACT_LEN - 1);
-    break;
-  case 5:
-    slot->type = (ParkingType)atoi(value);
+  if (filename != NULL &&
+      snap_open_index_image(filename, data, &image_map, &image) == 0) {
+    use_image = &image;
+  }
+  if (version == SNAP_VERSION_PACKED) {
+    lot = snap_load_packed(data + SNAPSHOT_HEADER_SIZE,
+                           size - SNAPSHOT_HEADER_SIZE, total_slots,
+                           slot_count, record_sum, allocator, use_image);
+  } else if (snap_locate_body(version, data + SNAPSHOT_HEADER_SIZE,
+                              slot_count, record_sum, &page_sums,
+                              &records) == 0) {
+    lot = snap_build_lot(total_slots, records, page_sums, slot_count,
+                         allocator, borrow_text, use_image);
+  }
+  if (use_image != NULL) {
+    file_mapping_close(&image_map);
+  }
+  return lot;
+}
+
+/**
+ * @brief 通过内存映射加载二进制快照。
+ * @details 文件头、页表和各页都直接在映射内存上校验，记录随解码按需调页。
+ * @param filename 源文件名。
+ * @return 成功时返回重建的 ParkingLot 指针；映射失败、文件不是有效快照
+ * 或内存不足时返回 NULL。
+ */
+ParkingLot *load_parking_snapshot_mapped(const char *filename) {
+  return load_parking_snapshot_with_allocator(filename, NULL);
+}
+
+/**
+ * @brief 通过内存映射加载二进制快照，新停车场使用指定的分配函数。
+ * @param filename 源文件名。
+ * @param allocator 分配函数，NULL 表示 C 标准库。
+ * @return 成功时返回重建的 ParkingLot 指针，失败返回 NULL。
+ */
+ParkingLot *load_parking_snapshot_with_allocator(
+    const char *filename, const ParkingAllocator *allocator) {
+  FileMapping map;
+  ParkingLot *lot;
+
+  if (file_mapping_open(&map, filename) != 0) {
+    return NULL;
+  }
+  lot = snap_load_memory(map.data, map.size, allocator, 0, filename);
+  file_mapping_close(&map);
+  return lot;
+}
+
+/**
+ * @brief 延迟加载二进制快照：冷文本字段留在文件映射中。
+ * @details 映射由停车场持有，free_parking_lot 时才解除。
+ * @param filename 源文件名。
+ * @return 成功时返回重建的 ParkingLot 指针，失败返回 NULL。
+ */
+ParkingLot *load_parking_snapshot_lazy(const char *filename) {
+  FileMapping map;
+  ParkingLot *lot;
+
+  if (file_mapping_open(&map, filename) != 0) {
+    return NULL;
+  }
+  lot = snap_load_memory(map.data, map.size, NULL, 1, filename);
+  /* 压缩的快照无法借用文本，解压后照常复制，映射不必保留 */
+  if (lot != NULL && lot->strings.borrowed != NULL) {
+    lot->text_mapping = (FileMapping *)parking_memory_alloc(
+        &lot->memory, PARKING_MEMORY_STRINGS, sizeof(FileMapping));
+    if (lot->text_mapping == NULL) {
+      free_parking_lot(lot);
+      lot = NULL;
+    } else {
+      *lot->text_mapping = map;
+      return lot;
+    }
+  }
+  file_mapping_close(&map);
+  return lot;
+}
+
+/**
+ * @brief (静态辅助函数) 把增量中的页覆盖到完整快照上，合成一份快照内容。
+ * @details 清单必须按页号严格递增，且增量中没有的页必须在完整快照中
+ *          有相同的长度；各页校验和随页一起搬运，由加载时校验。
+ * @param base 完整快照的内容。
+ * @param base_size 完整快照的字节数。
+ * @param delta 增量文件的内容，文件头已校验。
+ * @param delta_size 增量文件的字节数。
+ * @param[out] size 接收合成内容的字节数。
+ * @return 成功返回 malloc 分配的合成内容，文件无效或内存不足返回 NULL。
+ */
+static unsigned char *snap_apply_delta(const unsigned char *base,
+                                       size_t base_size,
+                                       const unsigned char *delta,
+                                       size_t delta_size, size_t *size) {
+  ParkingSnapshot shape;
+  const unsigned char *base_sums;
+  const unsigned char *base_records;
+  const unsigned char *manifest = delta + SNAPSHOT_DELTA_HEADER_SIZE;
+  const unsigned char *pages;
+  unsigned char *image;
+  unsigned long record_sum;
+  unsigned long entries;
+  unsigned long used = 0;
+  size_t page_data;
+  size_t offset = 0;
+  int version;
+  int base_total;
+  int base_count;
+  int page;
+
+  if (base_size < SNAPSHOT_HEADER_SIZE ||
+      snap_parse_header(base, &version, &base_total, &base_count,
+                        &record_sum) != 0 ||
+      version != SNAPSHOT_VERSION ||
+      base_size - SNAPSHOT_HEADER_SIZE < snap_body_size(version, base_count) ||
+      snap_locate_body(version, base + SNAPSHOT_HEADER_SIZE, base_count,
+                       record_sum, &base_sums, &base_records) != 0) {
+    return NULL;
+  }
+
+  memset(&shape, 0, sizeof(shape));
+  shape.total_slots = codec_get_i32(delta + DELTA_HDR_TOTAL_SLOTS);
+  shape.slot_count = (int)codec_get_u32(delta + DELTA_HDR_SLOT_COUNT);
+  shape.page_count = snap_page_count(shape.slot_count);
+  entries = codec_get_u32(delta + DELTA_HDR_PAGE_COUNT);
+  if (shape.slot_count < 0 ||
+      entries > (unsigned long)shape.page_count ||
+      (delta_size - SNAPSHOT_DELTA_HEADER_SIZE) / DELTA_ENTRY_SIZE <
+          entries ||
+      codec_checksum(manifest, entries * DELTA_ENTRY_SIZE) !=
+          codec_get_u32(delta + DELTA_HDR_MANIFEST_SUM)) {
+    return NULL;
+  }
+  pages = manifest + entries * DELTA_ENTRY_SIZE;
+  page_data = delta_size - SNAPSHOT_DELTA_HEADER_SIZE -
+              entries * DELTA_ENTRY_SIZE;
+
+  *size = snap_records_offset(shape.page_count) +
+          (size_t)shape.slot_count * SNAPSHOT_RECORD_SIZE;
+  image = (unsigned char *)malloc(*size);
+  if (image == NULL) {
+    return NULL;
+  }
+  for (page = 0; page < shape.page_count; page++) {
+    size_t bytes = snap_page_bytes(page, shape.slot_count);
+    size_t at = (size_t)page * SNAPSHOT_PAGE_ROWS * SNAPSHOT_RECORD_SIZE;
+    unsigned char *sum =
+        image + SNAPSHOT_HEADER_SIZE + (size_t)page * SNAP_PAGE_SUM_SIZE;
+
+    if (used < entries &&
+        codec_get_u32(manifest + used * DELTA_ENTRY_SIZE) ==
+            (unsigned long)page) {
+      if (page_data - offset < bytes) {
+        break;
+      }
+      memcpy(image + snap_records_offset(shape.page_count) + at,
+             pages + offset, bytes);
+      memcpy(sum, manifest + used * DELTA_ENTRY_SIZE + 4, SNAP_PAGE_SUM_SIZE);
+      offset += bytes;
+      used++;
+    } else if (page < snap_page_count(base_count) &&
+               snap_page_bytes(page, base_count) == bytes) {
+      memcpy(image + snap_records_offset(shape.page_count) + at,
+             base_records + at, bytes);
+      memcpy(sum, base_sums + (size_t)page * SNAP_PAGE_SUM_SIZE,
+             SNAP_PAGE_SUM_SIZE);
+    } else {
+      break;
+    }
+  }
+  if (page < shape.page_count || used != entries || offset != page_data) {
+    free(image);
+    return NULL;
+  }
+  snap_put_header(image, SNAPSHOT_VERSION, &shape,
+                  (size_t)shape.page_count * SNAP_PAGE_SUM_SIZE);
+  return image;
+}
+
+/**
+ * @brief 从完整快照与增量文件加载停车场数据。
+ * @param base_path 完整快照的路径。
+ * @param delta_path 增量文件的路径，可以为 NULL。
+ * @return 成功时返回重建的 ParkingLot 指针，失败返回 NULL。
+ */
+ParkingLot *load_parking_checkpoint(const char *base_path,
+                                    const char *delta_path) {
+  FileMapping base;
+  FileMapping delta;
+  ParkingLot *lot = NULL;
+  unsigned long base_sum;
+  unsigned long entries = 0;
+  unsigned long i;
+  int has_delta;
+
+  if (base_path == NULL || file_mapping_open(&base, base_path) != 0) {
+    return NULL;
+  }
+  if (base.size < SNAPSHOT_HEADER_SIZE) {
+    file_mapping_close(&base);
+    return NULL;
+  }
+  base_sum = codec_get_u32(base.data + SNAP_HDR_HEADER_SUM);
+
+  has_delta = delta_path != NULL && file_mapping_open(&delta, delta_path) == 0;
+  if (has_delta &&
+      (delta.size < SNAPSHOT_DELTA_HEADER_SIZE ||
+       memcmp(delta.data, SNAPSHOT_DELTA_MAGIC, 8) != 0 ||
+       codec_get_u32(delta.data + DELTA_HDR_HEADER_SUM) !=
+           codec_checksum(delta.data, DELTA_HDR_HEADER_SUM) ||
+       codec_get_u32(delta.data + DELTA_HDR_VERSION) !=
+           SNAPSHOT_DELTA_VERSION)) {
+    file_mapping_close(&delta);
+    file_mapping_close(&base);
+    return NULL;
+  }
+  /* 旧增量属于被替换掉的基准，新基准已包含它的全部修改 */
+  if (has_delta && codec_get_u32(delta.data + DELTA_HDR_BASE_SUM) != base_sum) {
+    file_mapping_close(&delta);
+    has_delta = 0;
+  }
+
+  if (has_delta) {
+    size_t size;
+    unsigned char *image =
+        snap_apply_delta(base.data, base.size, delta.data, delta.size, &size);
+
+    if (image != NULL) {
+      lot = snap_load_memory(image, size, NULL, 0, NULL);
+      free(image);
+      entries = codec_get_u32(delta.data + DELTA_HDR_PAGE_COUNT);
+    }
+  } else {
+    lot = snap_load_memory(base.data, base.size, NULL, 0, NULL);
+  }
+
+  if (lot != NULL &&
+      codec_get_u32(base.data + SNAP_HDR_VERSION) == SNAPSHOT_VERSION) {
+    lot->checkpoint.has_base = 1;
+    lot->checkpoint.base_sum = base_sum;
+    for (i = 0; i < entries; i++) {
+      snapshot_mark_dirty(
+          lot, (int)codec_get_u32(delta.data + SNAPSHOT_DELTA_HEADER_SIZE +
+                                  i * DELTA_ENTRY_SIZE) *
+                   SNAPSHOT_PAGE_ROWS);
+    }
+  }
+  if (has_delta) {
+    file_mapping_close(&delta);
+  }
+  file_mapping_close(&base);
+  return lot;
+}
+
+/**
+ * @brief 从内存中的二进制快照内容加载停车场数据。
+ * @param data 快照内容。
+ * @param size 字节数。
+ * @return 成功时返回重建的 ParkingLot 指针，失败返回 NULL。
+ */
+ParkingLot *load_parking_snapshot_memory(const unsigned char *data,
+                                         size_t size) {
+  return snap_load_memory(data, size, NULL, 0, NULL);
+}
+
+/**
+ * @brief 以共享方式锁定停车场。
+ * @param lot 目标停车场，为 NULL 时不做任何事。
+ */
+void parking_lot_read_lock(ParkingLot *lot) {
+  if (lot != NULL) {
+    parking_rwlock_read_lock(lot->lock);
+  }
+}
+
+/**
+ * @brief 释放停车场的共享锁。
+ * @param lot 目标停车场，为 NULL 时不做任何事。
+ */
+void parking_lot_read_unlock(ParkingLot *lot) {
+  if (lot != NULL) {
+    parking_rwlock_read_unlock(lot->lock);
+  }
+}
+
+/**
+ * @brief 以独占方式锁定停车场。
+ * @param lot 目标停车场，为 NULL 时不做任何事。
+ */
+void parking_lot_write_lock(ParkingLot *lot) {
+  TraceSpan span;
+
+  if (lot != NULL) {
+    PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "lock_wait");
+    parking_rwlock_write_lock(lot->lock);
+    PARKING_TRACE_END(span);
+  }
+}
+
+/**
+ * @brief 释放停车场的独占锁。
+ * @param lot 目标停车场，为 NULL 时不做任何事。
+ */
+void parking_lot_write_unlock(ParkingLot *lot) {
+  if (lot != NULL) {
+    parking_rwlock_write_unlock(lot->lock);
+  }
+}
+
+/**
+ * @brief 把一条日志记录作用到停车场上，与日志重放的规则相同。
+ * @details 与当前状态矛盾的记录（例如对空闲车位出场）被跳过。
+ * @param lot 目标停车场。
+ * @param record 要应用的记录。
+ * @return 成功（含被跳过的记录）返回 0，参数无效返回 -1。
+ */
+int apply_parking_journal_record(ParkingLot *lot,
+                                 const JournalRecord *record) {
+  ParkingSlot *slot;
+
+  if (lot == NULL || record == NULL) {
+    return -1;
+  }
+
+  if (record->op == JOURNAL_OP_ADD_SLOT) {
+    create_and_add_slot(lot, record->slot_id, record->location);
+    return 0;
+  }
+  if (record->op == JOURNAL_OP_DELETE_SLOT) {
+    delete_slot(lot, record->slot_id);
+    return 0;
+  }
+
+  slot = find_slot_by_id(lot, record->slot_id);
+  if (slot == NULL) {
+    return 0;
+  }
+
+  switch (record->op) {
+  case JOURNAL_OP_ALLOCATE:
+    if (slot->status == FREE_STATUS &&
+        plate_index_find(&lot->plate_index, record->license_plate) == NULL) {
+      occupy_slot(lot, slot, record->owner_name, record->license_plate,
+                  record->contact, (ParkingType)record->type,
+                  record->entry_time);
+    }
     break;
-  case 6:
-    slot->entry_time = (time_t)atoll(value);
+  case JOURNAL_OP_DEALLOCATE:
+    if (slot->status == OCCUPIED_STATUS) {
+      vacate_slot(lot, slot, record->exit_time);
+    }
     break;
-  case 7:
-    slot->exit_time = (time_t)atoll(value);
+  case JOURNAL_OP_UPDATE_INFO:
+    update_indexed_slot_info(
+        lot, slot,
+        (record->fields & JOURNAL_FIELD_LOCATION) ? record->location : NULL,
+        (record->fields & JOURNAL_FIELD_OWNER) ? record->owner_name : NULL,
+        (record->fields & JOURNAL_FIELD_CONTACT) ? record->contact : NULL);
     break;
-  case 8:
-    slot->status = (ParkingStatus)atoi(value);
+  case JOURNAL_OP_SYNC_SLOT:
+    preserve_slot_snapshot(lot, slot);
+    slot->status = record->status == OCCUPIED_STATUS ? OCCUPIED_STATUS
+                                                     : FREE_STATUS;
+    slot->type = (ParkingType)record->type;
+    slot->entry_time = record->entry_time;
+    slot->exit_time = record->exit_time;
+    slot->resident_due_date = record->due_date;
+    hot_row_replace(lot, slot->table_index, slot);
     break;
-  case 9:
-    slot->resident_due_date = (time_t)atoll(value);
+  default:
     break;
   }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 日志重放回调：把一条记录作用到停车场上。
+ * @details 重放时停车场尚未挂接日志，因此不会产生新的日志记录。
+ * @param record 解码后的日志记录。
+ * @param ctx 目标停车场。
+ * @return 始终返回 0，继续重放。
+ */
+static int apply_journal_record(const JournalRecord *record, void *ctx) {
+  apply_parking_journal_record((ParkingLot *)ctx, record);
+  return 0;
+}
+
+/**
+ * @brief 设置或清除日志记录的旁路接收者。
+ * @param lot 目标停车场。
+ * @param tap 接收函数，NULL 表示清除。
+ * @param ctx 透传给接收函数的上下文指针。
+ */
+void set_parking_mutation_tap(ParkingLot *lot, ParkingMutationTap tap,
+                              void *ctx) {
+  if (lot == NULL) {
+    return;
+  }
+  lot->mutation_tap = tap;
+  lot->mutation_tap_ctx = tap != NULL ? ctx : NULL;
+}
+
+/**
+ * @brief 为停车场启用预写日志。
+ * @details 启用前写出的快照是日志重放的起点。
+ * @param lot 目标停车场。
+ * @param snapshot_path 快照文件路径。
+ * @param journal_path 日志文件路径。
+ * @return 成功返回 0，参数无效返回 -1，文件读写失败返回 -2。
+ */
+int enable_parking_journal(ParkingLot *lot, const char *snapshot_path,
+                           const char *journal_path) {
+  ParkingJournal *journal;
+
+  if (lot == NULL || snapshot_path == NULL || journal_path == NULL) {
+    return -1;
+  }
+
+  disable_parking_journal(lot);
+  if (save_parking_snapshot(lot, snapshot_path) != 0) {
+    return -2;
+  }
+  journal = journal_open(journal_path, snapshot_path, 1);
+  if (journal == NULL) {
+    return -2;
+  }
+  lot->journal = journal;
+  return 0;
+}
+
+/**
+ * @brief 关闭停车场的预写日志，之后的修改不再记录。
+ * @param lot 目标停车场。
+ */
+void disable_parking_journal(ParkingLot *lot) {
+  if (lot == NULL) {
+    return;
+  }
+  journal_close(lot->journal);
+  lot->journal = NULL;
+}
+
+/**
+ * @brief 将日志压缩进快照。
+ * @param lot 已启用日志的停车场。
+ * @return 成功返回 0，未启用日志返回 -1，文件读写失败返回 -2。
+ */
+int compact_parking_journal(ParkingLot *lot) {
+  if (lot == NULL || lot->journal == NULL) {
+    return -1;
+  }
+  if (save_parking_snapshot(lot, lot->journal->snapshot_path) != 0) {
+    lot->journal->error = 1;
+    return -2;
+  }
+  return journal_reset(lot->journal) == 0 ? 0 : -2;
+}
+
+/**
+ * @brief 从快照和日志恢复停车场，并继续以该日志记录后续修改。
+ * @param snapshot_path 快照文件路径。
+ * @param journal_path 日志文件路径。
+ * @return 成功返回恢复的停车场，失败返回 NULL。
+ */
+ParkingLot *load_parking_journaled(const char *snapshot_path,
+                                   const char *journal_path) {
+  ParkingLot *lot;
+
+  if (snapshot_path == NULL || journal_path == NULL) {
+    return NULL;
+  }
+
+  lot = load_parking_data(snapshot_path);
+  if (lot == NULL) {
+    return NULL;
+  }
+  if (journal_replay(journal_path, apply_journal_record, lot) < 0 ||
+      enable_parking_journal(lot, snapshot_path, journal_path) != 0) {
+    free_parking_lot(lot);
+    return NULL;
+  }
+  return lot;
+}
+
+/**
+ * @brief 启用、调整或关闭时间线。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param segment_records 每个检查点之后最多的记录数，0 表示关闭。
+ * @param max_segments 最多保留的检查点数。
+ * @return 0 成功, -1 参数无效, -2 有进行中的快照, -3 内存分配失败。
+ */
+int configure_parking_timeline(ParkingLot *lot, int segment_records,
+                               int max_segments) {
+  ParkingTimeline *old;
+  int result;
+
+  if (lot == NULL || segment_records < 0 ||
+      (segment_records > 0 && max_segments <= 0)) {
+    return -1;
+  }
+  old = lot->timeline;
+  lot->timeline = NULL;
+  if (segment_records > 0) {
+    lot->timeline =
+        timeline_create(&lot->memory, segment_records, max_segments);
+    if (lot->timeline == NULL) {
+      lot->timeline = old;
+      return -3;
+    }
+    result = timeline_checkpoint(lot);
+    if (result != 0) {
+      timeline_free(lot->timeline);
+      lot->timeline = old;
+      return result;
+    }
+  }
+  timeline_free(old);
+  return 0;
+}
+
+/**
+ * @brief 重建停车场在某一时刻的状态。
+ * @param lot 已启用时间线的停车场（调用者持有读锁或写锁）。
+ * @param when 回溯的时刻。
+ * @param[out] past 成功时接收重建的停车场。
+ * @return 0 成功, -1 参数无效或未启用时间线, -2 when 早于保留的历史,
+ *         -3 内存分配失败。
+ */
+int load_parking_at(const ParkingLot *lot, time_t when, ParkingLot **past) {
+  const TimelineSegment *segment;
+  ParkingLot *rebuilt;
+
+  if (lot == NULL || past == NULL || lot->timeline == NULL) {
+    return -1;
+  }
+  segment = timeline_find_segment(lot->timeline, when);
+  if (segment == NULL) {
+    return -2;
+  }
+  rebuilt = load_parking_snapshot_memory(segment->snapshot,
+                                         segment->snapshot_size);
+  if (rebuilt == NULL) {
+    return -3;
+  }
+  if (timeline_replay(segment, when, apply_journal_record, rebuilt) < 0) {
+    free_parking_lot(rebuilt);
+    return -3;
+  }
+  *past = rebuilt;
+  return 0;
+}
+
+/**
+ * @brief 查询某个车位在某一时刻的状态。
+ * @param lot 已启用时间线的停车场（调用者持有读锁或写锁）。
+ * @param slot_id 车位编号。
+ * @param when 回溯的时刻。
+ * @param[out] slot 接收车位当时的状态。
+ * @return 0 成功, -1 参数无效或未启用时间线, -2 when 早于保留的历史,
+ *         -3 内存分配失败, -4 当时没有该车位。
+ */
+int find_slot_at(const ParkingLot *lot, int slot_id, time_t when,
+                 HistoricalSlot *slot) {
+  ParkingLot *past;
+  const ParkingSlot *found;
+  int result;
+
+  if (slot == NULL) {
+    return -1;
+  }
+  result = load_parking_at(lot, when, &past);
+  if (result != 0) {
+    return result;
+  }
+  found = find_slot_by_id(past, slot_id);
+  if (found == NULL) {
+    free_parking_lot(past);
+    return -4;
+  }
+  memset(slot, 0, sizeof(*slot));
+  slot->slot_id = found->slot_id;
+  slot->status = found->status;
+  slot->type = found->type;
+  slot->entry_time = found->entry_time;
+  string_copy_bounded(slot->location, found->location, MAX_LOCATION_LEN);
+  string_copy_bounded(slot->owner_name, found->owner_name, MAX_NAME_LEN);
+  string_copy_bounded(slot->license_plate, found->license_plate,
+                      MAX_LICENSE_LEN);
+  string_copy_bounded(slot->contact, found->contact, MAX_CONTACT_LEN);
+  free_parking_lot(past);
+  return 0;
+}
+
+/**
+ * @brief 查询停车场的日志是否发生过写入失败。
+ * @param lot 目标停车场。
+ * @return 已启用日志且最近写入失败返回 1，否则返回 0。
+ */
+int parking_journal_failed(const ParkingLot *lot) {
+  return lot != NULL && lot->journal != NULL && lot->journal->error;
+}
+
+/**
+ * @brief 配置日志的批量提交（group commit）策略。
+ * @param lot 已启用日志的停车场。
+ * @param max_records 每批最多记录数，0 表示不按数量触发。
+ * @param window_seconds 每批最长等待秒数，0 表示不按时间触发。
+ * @param on_durable 落盘通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 成功返回 0；未启用日志或两个触发条件都为 0 时返回 -1。
+ */
+int configure_parking_journal_batch(ParkingLot *lot, unsigned long max_records,
+                                    unsigned int window_seconds,
+                                    JournalDurableFn on_durable, void *ctx) {
+  if (lot == NULL || lot->journal == NULL) {
+    return -1;
+  }
+  return journal_set_batch(lot->journal, max_records, window_seconds,
+                           on_durable, ctx);
 }
 
 /**
- * @brief 初始化一个新的停车场对象。
- * @details 为停车场分配内存并设置其初始状态，包括总车位数、占用数和链表头。
- * @param total_slots 停车场的总容量。
- * @return 成功时返回指向新分配的 ParkingLot 对象的指针，若内存分配失败则返回
- * NULL。
+ * @brief 立即同步日志中尚未落盘的记录。
+ * @param lot 已启用日志的停车场。
+ * @return 成功返回 0，未启用日志返回 -1，同步失败返回 -2。
  */
-ParkingLot *init_parking_lot(int total_slots) {
-  ParkingLot *lot = (ParkingLot *)malloc(sizeof(ParkingLot));
-  if (lot == NULL) {
-    return NULL;
+int flush_parking_journal(ParkingLot *lot) {
+  if (lot == NULL || lot->journal == NULL) {
+    return -1;
   }
-  lot->total_slots = total_slots;
-  lot->occupied_slots = 0;
-  lot->slot_head = NULL;
-  lot->today_revenue = 0.0;
-  lot->month_revenue = 0.0;
-  lot->last_update_time = 0;
-  return lot;
+  return journal_sync(lot->journal) == 0 ? 0 : -2;
 }
 
 /**
- * @brief 创建一个新的停车位对象。
- * @details 为单个停车位分配内存并初始化其属性。新创建的车位状态默认为空闲。
- * @param slot_id 要创建的车位的唯一编号。
- * @param location 车位的物理位置描述。
- * @return 成功时返回指向新分配的 ParkingSlot 对象的指针，若内存分配失败则返回
- * NULL。
+ * @brief 若当前批次的时间窗口已到，则同步日志。
+ * @param lot 已启用日志的停车场。
+ * @return 成功或无需同步返回 0，未启用日志返回 -1，同步失败返回 -2。
  */
-ParkingSlot *create_parking_slot(int slot_id, const char *location) {
-  ParkingSlot *slot = (ParkingSlot *)malloc(sizeof(ParkingSlot));
-  if (slot == NULL) {
-    return NULL;
+int poll_parking_journal(ParkingLot *lot) {
+  if (lot == NULL || lot->journal == NULL) {
+    return -1;
   }
-
-  slot->slot_id = slot_id;
-  strncpy(slot->location, location, MAX_LOCATION_LEN - 1);
-  slot->location[MAX_LOCATION_LEN - 1] = '\0';
-
-  /* 初始化为空状态 */
-  slot->owner_name[0] = '\0';
-  slot->license_plate[0] = '\0';
-  slot->contact[0] = '\0';
-  slot->type = RESIDENT_TYPE; /* 默认为居民类型 */
-  slot->entry_time = 0;
-  slot->exit_time = 0;
-  slot->resident_due_date = 0;
-  slot->status = FREE_STATUS;
-  slot->next = NULL;
-
-  return slot;
+  return journal_sync_if_due(lot->journal, time(NULL)) == 0 ? 0 : -2;
 }
 
 /**
- * @brief 将一个已创建的停车位添加到停车场链表中。
- * @details 使用头插法将车位节点添加到链表。在添加前会检查车位ID是否已存在。
+ * @brief 开始一段批量修改，期间的日志记录在结束时统一同步一次。
  * @param lot 目标停车场。
- * @param slot 要添加的停车位节点。
- * @return 成功返回 0，若参数无效返回 -1，若车位ID已存在返回 -2。
  */
-int add_parking_slot(ParkingLot *lot, ParkingSlot *slot) {
-  if (!lot || !slot) {
-    return -1;
+void begin_parking_journal_batch(ParkingLot *lot) {
+  if (lot != NULL) {
+    journal_begin_deferred(lot->journal);
   }
+}
 
-  /* 核心修复：添加重复ID检查 */
-  if (find_slot_by_id(lot, slot->slot_id) != NULL) {
-    return -2; /* ID already exists */
+/**
+ * @brief 结束一段批量修改，并同步期间追加的日志记录。
+ * @param lot 目标停车场。
+ * @return 成功或未启用日志返回 0，同步失败返回 -2。
+ */
+int end_parking_journal_batch(ParkingLot *lot) {
+  if (lot == NULL || lot->journal == NULL) {
+    return 0;
   }
-
-  /* 头插法，新车位成为新的头节点 */
-  slot->next = lot->slot_head;
-  lot->slot_head = slot;
-  return 0;
+  return journal_end_deferred(lot->journal) == 0 ? 0 : -2;
 }
 
 /**
- * @brief 根据车位编号查找停车位。
+ * @brief 查询日志的序号进度。
  * @param lot 目标停车场。
- * @param slot_id 要查找的车位编号。
- * @return 若找到，返回对应的 ParkingSlot 指针；否则返回 NULL。
+ * @param[out] appended_seq 最近追加的记录序号，可以为 NULL。
+ * @param[out] durable_seq 已确认落盘的最大记录序号，可以为 NULL。
+ * @return 已启用日志返回 0，否则返回 -1。
  */
-ParkingSlot *find_slot_by_id(ParkingLot *lot, int slot_id) {
-  if (!lot) {
-    return NULL;
+int parking_journal_progress(const ParkingLot *lot,
+                             unsigned long *appended_seq,
+                             unsigned long *durable_seq) {
+  if (lot == NULL || lot->journal == NULL) {
+    return -1;
   }
-  ParkingSlot *current = lot->slot_head;
-  while (current != NULL) {
-    if (current->slot_id == slot_id) {
-      return current;
-    }
-    current = current->next;
+  if (appended_seq != NULL) {
+    *appended_seq = lot->journal->next_seq - 1;
   }
-  return NULL;
+  if (durable_seq != NULL) {
+    *durable_seq = lot->journal->durable_seq;
+  }
+  return 0;
 }
 
 /**
- * @brief 根据车牌号查找停车位。
- * @details 遍历所有车位，查找与给定车牌号匹配的已占用车位。
- * @note 只在状态为 OCCUPIED_STATUS 的车位中进行查找。
+ * @brief 为停车场启用收费台账。
  * @param lot 目标停车场。
- * @param license_plate 要查找的车牌号。
- * @return 若找到，返回对应的 ParkingSlot 指针；否则返回 NULL。
+ * @param path 台账文件路径。
+ * @return 成功返回 0，参数无效返回 -1，文件无法打开或不是有效台账返回 -2。
  */
-ParkingSlot *find_slot_by_license(ParkingLot *lot, const char *license_plate) {
-  ParkingSlot *current;
+int enable_payment_ledger(ParkingLot *lot, const char *path) {
+  PaymentLedger *ledger;
 
-  if (lot == NULL || license_plate == NULL) {
-    return NULL;
+  if (lot == NULL || path == NULL) {
+    return -1;
   }
 
-  current = lot->slot_head;
-  while (current != NULL) {
-    if (current->status == OCCUPIED_STATUS &&
-        strcmp(current->license_plate, license_plate) == 0) {
-      return current;
-    }
-    current = current->next;
+  disable_payment_ledger(lot);
+  ledger = ledger_open(path);
+  if (ledger == NULL) {
+    return -2;
   }
+  lot->ledger = ledger;
+  return 0;
+}
 
-  return NULL;
+/**
+ * @brief 关闭停车场的收费台账，之后的收费不再记录。
+ * @param lot 目标停车场。
+ */
+void disable_payment_ledger(ParkingLot *lot) {
+  if (lot == NULL) {
+    return;
+  }
+  ledger_close(lot->ledger);
+  lot->ledger = NULL;
 }
 
 /**
- * @brief 根据车主姓名查找停车位（模糊查找）。
- * @details 使用子字符串匹配 (strstr) 在已占用的车位中查找车主姓名。
- * @note 只在状态为 OCCUPIED_STATUS 的车位中进行查找。
+ * @brief 向收费台账追加一笔出场收费。
  * @param lot 目标停车场。
- * @param owner_name 要查找的车主姓名（或姓名的一部分）。
- * @return 若找到，返回第一个匹配的 ParkingSlot 指针；否则返回 NULL。
+ * @param slot_id 出场的车位编号。
+ * @param type 停车类型。
+ * @param paid_at 收费时间。
+ * @param amount_cents 金额（分）。
+ * @return 成功或无需记录返回 0，参数无效返回 -1，写入失败返回 -2。
  */
-ParkingSlot *find_slot_by_owner(ParkingLot *lot, const char *owner_name) {
-  ParkingSlot *current;
+int record_parking_payment(ParkingLot *lot, int slot_id, ParkingType type,
+                           time_t paid_at, long amount_cents) {
+  PaymentRecord record;
 
-  if (lot == NULL || owner_name == NULL) {
-    return NULL;
+  if (lot == NULL) {
+    return -1;
   }
-
-  current = lot->slot_head;
-  while (current != NULL) {
-    if (current->status == OCCUPIED_STATUS &&
-        strstr(current->owner_name, owner_name) != NULL) {
-      return current;
-    }
-    current = current->next;
+  if (lot->ledger == NULL) {
+    return 0;
   }
 
-  return NULL;
+  record.slot_id = slot_id;
+  record.type = type;
+  record.paid_at = paid_at;
+  if (amount_cents <= 0) {
+    return 0;
+  }
+  record.amount_cents = amount_cents;
+  return ledger_append(lot->ledger, &record) == 0 ? 0 : -2;
 }
 
 /**
- * @brief (静态辅助函数) 检查访客车辆的入场时间是否在允许的时间段内。
- * @details 检查给定时间戳的小时部分是否在 VISITOR_START_HOUR 和
- * VISITOR_END_HOUR 之间。
- * @param entry_time 车辆的入场时间戳。
- * @return 如果在允许时段内返回 1，否则返回 0。
+ * @brief 查询停车场的收费台账是否发生过写入失败。
+ * @param lot 目标停车场。
+ * @return 已启用台账且写入失败过返回 1，否则返回 0。
  */
-static int is_valid_visitor_time(time_t entry_time) {
-  struct tm *tm_info = localtime(&entry_time);
-  int hour = tm_info->tm_hour;
-
-  return (hour >= VISITOR_START_HOUR && hour < VISITOR_END_HOUR);
+int parking_ledger_failed(const ParkingLot *lot) {
+  return lot != NULL && lot->ledger != NULL && lot->ledger->error;
 }
 
 /**
- * @brief 分配一个停车位给车辆（车辆入场）。
- * @details
- * 为指定车位分配车辆。此函数会执行一系列检查：
- * 1. 参数有效性。
- * 2. 车位是否存在且空闲。
- * 3. 该车牌号是否已在场内。
- * 4. 对于访客车辆，入场时间是否在允许时段内。
- * 检查通过后，更新车位信息并增加停车场的已占用计数。
+ * @brief (静态辅助函数) 把累积的收费记录批量追加到收费台账。
  * @param lot 目标停车场。
- * @param slot_id 要分配的车位编号。
- * @param owner_name 车主姓名。
- * @param license_plate 车牌号。
- * @param contact 联系方式。
- * @param type 停车类型 (居民/访客)。
- * @return 返回码：0 成功, -1 参数无效, -2 车位不存在, -3 车位已被占用, -4
- * 该车牌号已在场内, -5 访客车辆在非允许时段入场。
+ * @param payments 累积的收费记录。
+ * @param[in,out] pending 累积的记录数，追加后清零。
  */
-int allocate_slot(ParkingLot *lot, int slot_id, const char *owner_name,
-                  const char *license_plate, const char *contact,
-                  ParkingType type) {
-  ParkingSlot *slot;
-  time_t current_time;
-
-  if (lot == NULL || owner_name == NULL || license_plate == NULL) {
-    return -1; /* 参数无效 */
-  }
-
-  slot = find_slot_by_id(lot, slot_id);
-  if (slot == NULL) {
-    return -2; /* 车位不存在 */
+static void flush_payment_batch(ParkingLot *lot, const PaymentRecord *payments,
+                                int *pending) {
+  if (*pending > 0 && lot->ledger != NULL) {
+    ledger_append_batch(lot->ledger, payments, (size_t)*pending);
   }
+  *pending = 0;
+}
 
-  if (slot->status == OCCUPIED_STATUS) {
-    return -3; /* 车位已被占用 */
-  }
+/**
+ * @brief 为月费已到期的全部居民车位开出账单并顺延到期时间。
+ * @param lot 目标停车场（调用者持有写锁）。
+ * @param now 结算时刻。
+ * @param visitor 对每张账单调用的回调函数，可以为 NULL。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 开出的账单数；参数无效返回 -1。
+ */
+int bill_resident_subscriptions(ParkingLot *lot, time_t now,
+                                ResidentInvoiceVisitor visitor, void *ctx) {
+  const int block = (int)SLOT_BITMAP_WORD_BITS;
+  PaymentRecord payments[SLOT_BITMAP_WORD_BITS];
+  const ParkingTariff *fees;
+  int invoices = 0;
+  int pending = 0;
+  int base;
 
-  /* 检查车牌号是否已在其他车位 */
-  if (find_slot_by_license(lot, license_plate) != NULL) {
-    return -4; /* 车牌号已存在 */
+  if (lot == NULL) {
+    return -1;
   }
+  /* 整次结算只读取一次配置，与出场计费相同 */
+  fees = &parking_lot_config(lot)->fees;
 
-  current_time = time(NULL);
-
-  /* 对于访客车辆，检查入场时间 */
-  if (type == VISITOR_TYPE && !is_valid_visitor_time(current_time)) {
-    return -5; /* 访客车辆在非允许时段入场 */
-  }
+  for (base = 0; base < lot->slot_count; base += block) {
+    int rows = lot->slot_count - base < block ? lot->slot_count - base : block;
+    unsigned long mask;
 
-  /* 分配车位并填充信息 */
-  strncpy(slot->owner_name, owner_name, MAX_NAME_LEN - 1);
-  slot->owner_name[MAX_NAME_LEN - 1] = '\0';
+    /* 到期时间为 0 表示未设置，区间从 1 开始即可排除 */
+    mask = column_match_time(lot->hot.due_date + base, (size_t)rows, 1,
+                             now + 1);
+    if (mask != 0) {
+      mask &= column_match_u8(lot->hot.type + base, (size_t)rows,
+                              (unsigned char)RESIDENT_TYPE);
+    }
+    while (mask != 0) {
+      int bit = column_lowest_bit(mask);
+      ParkingSlot *slot = lot->slot_table[base + bit];
+      ResidentInvoice invoice;
 
-  strncpy(slot->license_plate, license_plate, MAX_LICENSE_LEN - 1);
-  slot->license_plate[MAX_LICENSE_LEN - 1] = '\0';
+      mask &= mask - 1UL;
+      invoice.slot_id = slot->slot_id;
+      invoice.period_start = slot->resident_due_date;
+      invoice.amount_cents =
+          tariff_resident_charge(fees, slot->resident_due_date, now,
+                                 &invoice.periods, &invoice.period_end);
+      if (invoice.periods == 0) {
+        continue;
+      }
+      preserve_slot_snapshot(lot, slot);
+      slot->resident_due_date = invoice.period_end;
+      sync_slot_hot_fields(lot, slot);
 
-  if (contact != NULL) {
-    strncpy(slot->contact, contact, MAX_CONTACT_LEN - 1);
-    slot->contact[MAX_CONTACT_LEN - 1] = '\0';
-  } else {
-    slot->contact[0] = '\0';
+      if (invoice.amount_cents > 0) {
+        payments[pending].slot_id = slot->slot_id;
+        payments[pending].type = RESIDENT_TYPE;
+        payments[pending].paid_at = now;
+        payments[pending].amount_cents = invoice.amount_cents;
+        pending++;
+      }
+      if (pending == block) {
+        flush_payment_batch(lot, payments, &pending);
+      }
+      invoices++;
+      if (visitor != NULL) {
+        visitor(&invoice, ctx);
+      }
+    }
   }
-
-  slot->type = type;
-  slot->entry_time = current_time;
-  slot->exit_time = 0; /* 清除上一次的出场时间 */
-  slot->status = OCCUPIED_STATUS;
-
-  lot->occupied_slots++;
-
-  return 0; /* 成功 */
+  flush_payment_batch(lot, payments, &pending);
+  return invoices;
 }
 
 /**
- * @brief 释放一个停车位（车辆出场）。
- * @details
- * 检查车位是否存在且状态为已占用。成功后，记录出场时间，
- * 清空车主相关信息，将车位状态设置为空闲，并减少停车场的已占用计数。
- * @param lot 目标停车场。
- * @param slot_id 要释放的车位编号。
- * @return 返回码：0 成功, -1 停车场对象为空, -2 车位不存在, -3
- * 车位本就是空闲状态。
+ * @brief 为全部在场访客车辆结算并释放车位。
+ * @param lot 目标停车场（调用者持有写锁）。
+ * @param now 出场时间。
+ * @param visitor 对每次出场调用的回调函数，可以为 NULL。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 释放的车位数；参数无效返回 -1。
  */
-int deallocate_slot(ParkingLot *lot, int slot_id) {
-  ParkingSlot *slot;
+int sweep_visitor_slots(ParkingLot *lot, time_t now,
+                        VisitorCheckoutVisitor visitor, void *ctx) {
+  const int block = (int)SLOT_BITMAP_WORD_BITS;
+  VisitorCheckout checkouts[SLOT_BITMAP_WORD_BITS];
+  PaymentRecord payments[SLOT_BITMAP_WORD_BITS];
+  int hit_rows[SLOT_BITMAP_WORD_BITS];
+  const ParkingTariff *fees;
+  int released = 0;
+  int base;
 
   if (lot == NULL) {
-    return -1; /* 停车场对象为空 */
+    return -1;
   }
+  /* 整次清场只读取一次配置，与出场计费相同 */
+  fees = &parking_lot_config(lot)->fees;
 
-  slot = find_slot_by_id(lot, slot_id);
-  if (slot == NULL) {
-    return -2; /* 车位不存在 */
-  }
+  for (base = 0; base < lot->slot_count; base += block) {
+    int rows = lot->slot_count - base < block ? lot->slot_count - base : block;
+    unsigned long mask;
+    int pending = 0;
+    int count = 0;
+    int i;
 
-  if (slot->status == FREE_STATUS) {
-    return -3; /* 车位本就是空闲状态 */
-  }
+    mask = column_match_u8(lot->hot.status + base, (size_t)rows,
+                           (unsigned char)OCCUPIED_STATUS);
+    if (mask != 0) {
+      mask &= column_match_u8(lot->hot.type + base, (size_t)rows,
+                              (unsigned char)VISITOR_TYPE);
+    }
 
-  slot->exit_time = time(NULL);
+    /* 第一遍只读热字段列，为整块命中的车位计费 */
+    while (mask != 0) {
+      int row = base + column_lowest_bit(mask);
+      VisitorCheckout *checkout = &checkouts[count];
+      time_t entry = lot->hot.entry_time[row];
 
-  /* 清空车位占用信息 */
-  slot->owner_name[0] = '\0';
-  slot->license_plate[0] = '\0';
-  slot->contact[0] = '\0';
-  slot->status = FREE_STATUS;
+      mask &= mask - 1UL;
+      checkout->slot_id = lot->hot.slot_id[row];
+      checkout->entry_time = entry;
+      checkout->duration_seconds = now > entry ? (long)(now - entry) : 0;
+      checkout->amount_cents = tariff_visitor_fee(
+          fees, parking_calendar_hour(&lot->calendar, entry),
+          checkout->duration_seconds, &checkout->billed_hours);
+      if (checkout->amount_cents > 0) {
+        payments[pending].slot_id = checkout->slot_id;
+        payments[pending].type = VISITOR_TYPE;
+        payments[pending].paid_at = now;
+        payments[pending].amount_cents = checkout->amount_cents;
+        pending++;
+      }
+      hit_rows[count++] = row;
+    }
+    flush_payment_batch(lot, payments, &pending);
 
-  lot->occupied_slots--;
+    /* 第二遍释放车位；释放只改写本行，不会移动其他行 */
+    for (i = 0; i < count; i++) {
+      ParkingSlot *slot = lot->slot_table[hit_rows[i]];
 
-  return 0; /* 成功 */
+      record_parking_session(lot, slot, now, checkouts[i].amount_cents);
+      remember_session(lot, slot, now);
+      vacate_slot(lot, slot, now);
+      if (journal_wanted(lot)) {
+        JournalRecord record;
+        journal_record_init(&record, JOURNAL_OP_DEALLOCATE, slot->slot_id);
+        record.exit_time = slot->exit_time;
+        journal_log(lot, &record);
+      }
+      released++;
+      if (visitor != NULL) {
+        visitor(&checkouts[i], ctx);
+      }
+    }
+  }
+  return released;
 }
 
 /**
- * @brief 获取所有空闲车位的列表。
- * @details 通过两次遍历实现：第一次统计空闲车位数量，第二次分配数组并填充指针。
- * @note 返回的数组需要调用者手动 `free()` 释放。
+ * @brief 为停车场启用停车记录存储。
  * @param lot 目标停车场。
- * @param[out] count 用于接收空闲车位数量的指针。
- * @return 返回一个动态分配的 ParkingSlot
- * 指针数组。如果无空闲车位或内存分配失败，返回 NULL。
+ * @param prefix 列文件路径前缀。
+ * @return 成功返回 0，参数无效返回 -1，文件无法打开或不是有效列文件返回 -2。
  */
-ParkingSlot **get_free_slots(ParkingLot *lot, int *count) {
-  ParkingSlot **free_slots;
-  ParkingSlot *current;
-  int free_count = 0;
-  int index = 0;
+int enable_session_history(ParkingLot *lot, const char *prefix) {
+  SessionHistory *history;
 
-  if (lot == NULL || count == NULL) {
-    return NULL;
+  if (lot == NULL || prefix == NULL) {
+    return -1;
   }
 
-  /* 第一遍：统计空闲车位数量 */
-  current = lot->slot_head;
-  while (current != NULL) {
-    if (current->status == FREE_STATUS) {
-      free_count++;
-    }
-    current = current->next;
+  disable_session_history(lot);
+  history = history_open(prefix);
+  if (history == NULL) {
+    return -2;
   }
+  lot->history = history;
+  return 0;
+}
 
-  *count = free_count;
+/**
+ * @brief 为停车场启用停车记录存储，新建的列文件使用压缩模式。
+ * @param lot 目标停车场。
+ * @param prefix 列文件路径前缀。
+ * @return 成功返回 0，参数无效返回 -1，文件无法打开或不是有效列文件返回 -2。
+ */
+int enable_compressed_session_history(ParkingLot *lot, const char *prefix) {
+  SessionHistory *history;
 
-  if (free_count == 0) {
-    return NULL;
+  if (lot == NULL || prefix == NULL) {
+    return -1;
   }
 
-  /* 分配指针数组内存 */
-  free_slots = (ParkingSlot **)malloc(free_count * sizeof(ParkingSlot *));
-  if (free_slots == NULL) {
-    *count = 0;
-    return NULL;
+  disable_session_history(lot);
+  history = history_open_compressed(prefix);
+  if (history == NULL) {
+    return -2;
   }
+  lot->history = history;
+  return 0;
+}
 
-  /* 第二遍：收集空闲车位指针 */
-  current = lot->slot_head;
-  while (current != NULL && index < free_count) {
-    if (current->status == FREE_STATUS) {
-      free_slots[index++] = current;
-    }
-    current = current->next;
+/**
+ * @brief 关闭停车场的停车记录存储，之后的出场不再记录。
+ * @param lot 目标停车场。
+ */
+void disable_session_history(ParkingLot *lot) {
+  if (lot == NULL) {
+    return;
   }
-
-  return free_slots;
+  history_close(lot->history);
+  lot->history = NULL;
 }
 
 /**
- * @brief 获取所有已占用车位的列表。
- * @details 实现方式与 `get_free_slots` 类似，但筛选条件为已占用状态。
- * @note 返回的数组需要调用者手动 `free()` 释放。
+ * @brief 为即将出场的车位追加一条停车记录。
  * @param lot 目标停车场。
- * @param[out] count 用于接收已占用车位的数量。
- * @return 返回一个动态分配的 ParkingSlot
- * 指针数组。如果无已占用车位或内存分配失败，返回 NULL。
+ * @param slot 已占用、即将出场的车位。
+ * @param exit_time 出场时间。
+ * @param fee_cents 本次收取的费用（分）。
+ * @return 成功或无需记录返回 0，参数无效返回 -1，写入失败返回 -2。
  */
-ParkingSlot **get_occupied_slots(ParkingLot *lot, int *count) {
-  ParkingSlot **occupied_slots;
-  ParkingSlot *current;
-  int occupied_count = 0;
-  int index = 0;
+int record_parking_session(ParkingLot *lot, const ParkingSlot *slot,
+                           time_t exit_time, long fee_cents) {
+  SessionRecord record;
 
-  if (lot == NULL || count == NULL) {
-    return NULL;
+  if (lot == NULL || slot == NULL) {
+    return -1;
   }
-
-  /* 第一遍：统计已占用车位数量 */
-  current = lot->slot_head;
-  while (current != NULL) {
-    if (current->status == OCCUPIED_STATUS) {
-      occupied_count++;
-    }
-    current = current->next;
+  if (lot->history == NULL) {
+    return 0;
   }
 
-  *count = occupied_count;
-
-  if (occupied_count == 0) {
-    return NULL;
-  }
+  record.plate_hash = history_plate_hash(slot->license_plate);
+  record.slot_id = slot->slot_id;
+  record.type = slot->type;
+  record.entry_time = slot->entry_time;
+  record.exit_time = exit_time;
+  record.fee_cents = fee_cents > 0 ? fee_cents : 0;
+  return history_append(lot->history, &record) == 0 ? 0 : -2;
+}
 
-  /* 分配指针数组内存 */
-  occupied_slots =
-      (ParkingSlot **)malloc(occupied_count * sizeof(ParkingSlot *));
-  if (occupied_slots == NULL) {
-    *count = 0;
-    return NULL;
-  }
+/**
+ * @brief 查询停车场的停车记录存储是否发生过写入失败。
+ * @param lot 目标停车场。
+ * @return 已启用存储且写入失败过返回 1，否则返回 0。
+ */
+int parking_history_failed(const ParkingLot *lot) {
+  return lot != NULL && lot->history != NULL && lot->history->error;
+}
 
-  /* 第二遍：收集已占用车位指针 */
-  current = lot->slot_head;
-  while (current != NULL && index < occupied_count) {
-    if (current->status == OCCUPIED_STATUS) {
-      occupied_slots[index++] = current;
-    }
-    current = current->next;
+/**
+ * @brief 按出场时间区间扫描已完成的停车记录。
+ * @param lot 已启用停车记录存储的停车场。
+ * @param from 区间起点（含）。
+ * @param to 区间终点（不含）。
+ * @param columns 需要读取的列掩码。
+ * @param visitor 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 访问的记录数；失败时返回 -1。
+ */
+long scan_parking_sessions(const ParkingLot *lot, time_t from, time_t to,
+                           unsigned int columns, SessionVisitor visitor,
+                           void *ctx) {
+  if (lot == NULL || lot->history == NULL) {
+    return -1;
   }
-
-  return occupied_slots;
+  return history_scan(lot->history, from, to, columns, visitor, ctx);
 }
 
 /**
- * @brief (静态辅助函数) 计算一个车位的停车时长（单位：秒）。
- * @details 如果车辆已出场，则计算 entry_time 和 exit_time 的差值。
- *          如果车辆仍在场，则计算 entry_time 和当前时间的差值。
- * @param slot 要计算时长的车位。
- * @return 停车时长（秒）。如果车位为空闲或无入场时间，返回0。
+ * @brief (静态辅助函数) 把一条停车记录计入汇总。
+ * @param record 当前记录。
+ * @param ctx 指向 SessionSummary 的指针。
+ * @return 始终返回 0，继续扫描。
  */
-static long calculate_parking_duration(ParkingSlot *slot) {
-  time_t current_time;
+static int accumulate_session(const SessionRecord *record, void *ctx) {
+  SessionSummary *summary = (SessionSummary *)ctx;
 
-  if (slot->status == FREE_STATUS || slot->entry_time == 0) {
-    return 0;
+  summary->sessions++;
+  if (record->type == VISITOR_TYPE) {
+    summary->visitor_sessions++;
+  } else {
+    summary->resident_sessions++;
   }
-
-  if (slot->exit_time > 0) {
-    return (long)(slot->exit_time - slot->entry_time);
+  summary->total_fee += record->fee_cents / 100.0;
+  if (record->exit_time > record->entry_time) {
+    summary->total_duration_seconds +=
+        difftime(record->exit_time, record->entry_time);
   }
-  current_time = time(NULL);
-  return (long)(current_time - slot->entry_time);
+  return 0;
 }
 
 /**
- * @brief (静态辅助函数) qsort 的比较函数，用于按停车时长升序排列。
- * @param a 指向 ParkingSlot* 的指针。
- * @param b 指向 ParkingSlot* 的指针。
- * @return -1 如果 a < b, 1 如果 a > b, 0 如果 a == b。
+ * @brief 汇总一段时间内已完成的停车次数、费用与时长。
+ * @param lot 已启用停车记录存储的停车场。
+ * @param from 区间起点（含）。
+ * @param to 区间终点（不含）。
+ * @param[out] summary 接收汇总结果。
+ * @return 成功返回 0，失败返回 -1。
  */
-static int compare_parking_duration_asc(const void *a, const void *b) {
-  ParkingSlot *slot_a = *(ParkingSlot **)a;
-  ParkingSlot *slot_b = *(ParkingSlot **)b;
+int summarize_parking_sessions(const ParkingLot *lot, time_t from, time_t to,
+                               SessionSummary *summary) {
+  long visited;
 
-  long duration_a = calculate_parking_duration(slot_a);
-  long duration_b = calculate_parking_duration(slot_b);
-
-  if (duration_a < duration_b) {
+  if (summary == NULL) {
     return -1;
   }
-  if (duration_a > duration_b) {
-    return 1;
-  }
-  return 0;
+  memset(summary, 0, sizeof(*summary));
+  visited = scan_parking_sessions(lot, from, to,
+                                  HISTORY_COLUMN_BIT(HISTORY_COL_TYPE) |
+                                      HISTORY_COLUMN_BIT(HISTORY_COL_ENTRY) |
+                                      HISTORY_COLUMN_BIT(HISTORY_COL_FEE),
+                                  accumulate_session, summary);
+  return visited < 0 ? -1 : 0;
 }
 
 /**
- * @brief (静态辅助函数) qsort 的比较函数，用于按停车时长降序排列。
- * @param a 指向 ParkingSlot* 的指针。
- * @param b 指向 ParkingSlot* 的指针。
- * @return 1 如果 a < b, -1 如果 a > b, 0 如果 a == b。
+ * @brief 读取停车场时间源的当前时刻。
+ * @param lot 目标停车场。
+ * @return 当前时刻；lot 为 NULL 时返回系统时间。
  */
-static int compare_parking_duration_desc(const void *a, const void *b) {
-  return -compare_parking_duration_asc(a, b);
+time_t parking_lot_now(const ParkingLot *lot) {
+  return lot != NULL ? parking_clock_now(&lot->clock) : time(NULL);
 }
 
 /**
- * @brief 按停车时长排序后，获取已占用车辆列表。
- * @details 首先获取所有已占用车位的列表，然后使用 `qsort`
- * 和自定义比较函数进行排序。
- * @note 返回的数组需要调用者手动 `free()` 释放。
+ * @brief (静态辅助函数) 获取保护配置发布的自旋锁。
  * @param lot 目标停车场。
- * @param[out] count 用于接收已占用车位的数量。
- * @param ascending 是否按升序排列 (1: 升序, 0: 降序)。
- * @return 返回排序后的 ParkingSlot 指针数组。数组使用后需要调用 free() 释放。
  */
-ParkingSlot **get_slots_by_duration(ParkingLot *lot, int *count,
-                                    int ascending) {
-  ParkingSlot **occupied_slots = get_occupied_slots(lot, count);
-
-  if (occupied_slots == NULL || *count == 0) {
-    return occupied_slots;
-  }
-
-  /* 使用 qsort 进行排序 */
-  if (ascending) {
-    qsort(occupied_slots, *count, sizeof(ParkingSlot *),
-          compare_parking_duration_asc);
-  } else {
-    qsort(occupied_slots, *count, sizeof(ParkingSlot *),
-          compare_parking_duration_desc);
+static void config_lock_acquire(ParkingLot *lot) {
+  while (parking_atomic_exchange_int(&lot->config_lock, 1) != 0) {
+    while (parking_atomic_load_int(&lot->config_lock) != 0) {
+    }
   }
-
-  return occupied_slots;
 }
 
 /**
- * @brief 计算访客车辆的停车费用。
- * @details 停车时长按小时向上取整，然后乘以小时费率。
- * @param entry_time 车辆入场时间戳。
- * @param exit_time 车辆出场时间戳。
- * @return 停车费用。如果出场时间早于或等于入场时间，返回0.0。
+ * @brief (静态辅助函数) 释放保护配置发布的自旋锁。
+ * @param lot 目标停车场。
  */
-double calculate_visitor_fee(time_t entry_time, time_t exit_time) {
-  double hours;
-  long duration_seconds;
+static void config_lock_release(ParkingLot *lot) {
+  parking_atomic_store_int(&lot->config_lock, 0);
+}
 
-  if (exit_time <= entry_time) {
-    return 0.0;
+/**
+ * @brief (静态辅助函数) 释放一份不再使用的配置。
+ * @details 初始配置内嵌在停车场中，不单独释放。
+ * @param lot 配置所属的停车场。
+ * @param config 要释放的配置。
+ */
+static void release_parking_config(ParkingLot *lot, ParkingConfig *config) {
+  if (config != &lot->base_config) {
+    parking_memory_free(&lot->memory, config);
   }
-
-  duration_seconds = (long)(exit_time - entry_time);
-  hours = duration_seconds / 3600.0;
-
-  /* 不足1小时按1小时计费 */
-  return ceil(hours) * VISITOR_HOURLY_FEE;
 }
 
 /**
- * @brief 更新一个停车位的信息。
- * @details 根据传入的非 NULL 参数更新车位信息。
- * @note `location` 字段可以随时更新。`owner_name` 和 `contact`
- * 字段只有在车位被占用时才能更新。
- * @param slot 要更新的停车位。
- * @param location 新的位置描述 (如果为NULL则不更新)。
- * @param owner_name 新的车主姓名 (如果为NULL则不更新)。
- * @param contact 新的联系方式 (如果为NULL则不更新)。
- * @return 成功返回 0，如果 `slot` 参数为 NULL 则返回 -1。
+ * @brief 读取停车场当前生效的运行时配置。
+ * @param lot 目标停车场。
+ * @return 当前配置；lot 为 NULL 时返回 NULL。
  */
-int update_slot_info(ParkingSlot *slot, const char *location,
-                     const char *owner_name, const char *contact) {
-  if (slot == NULL) {
-    return -1;
+const ParkingConfig *parking_lot_config(const ParkingLot *lot) {
+  if (lot == NULL) {
+    return NULL;
   }
+  return (const ParkingConfig *)parking_atomic_load_ptr(&lot->config);
+}
 
-  if (location != NULL) {
-    strncpy(slot->location, location, MAX_LOCATION_LEN - 1);
-    slot->location[MAX_LOCATION_LEN - 1] = '\0';
-  }
+/**
+ * @brief 复制、校验并发布一份新的运行时配置。
+ * @details 新配置在发布前完整写好，原子交换指针之后才对读者可见。
+ * @param lot 目标停车场。
+ * @param config 新配置。
+ * @return 成功返回 0，参数或配置无效返回 -1，内存不足返回 -2。
+ */
+int publish_parking_config(ParkingLot *lot, const ParkingConfig *config) {
+  ParkingConfig *copy;
+  ParkingConfig *old;
 
-  if (owner_name != NULL && slot->status == OCCUPIED_STATUS) {
-    strncpy(slot->owner_name, owner_name, MAX_NAME_LEN - 1);
-    slot->owner_name[MAX_NAME_LEN - 1] = '\0';
+  if (lot == NULL || config == NULL) {
+    return -1;
   }
-
-  if (contact != NULL && slot->status == OCCUPIED_STATUS) {
-    strncpy(slot->contact, contact, MAX_CONTACT_LEN - 1);
-    slot->contact[MAX_CONTACT_LEN - 1] = '\0';
+  copy = (ParkingConfig *)parking_memory_alloc(&lot->memory, PARKING_MEMORY_LOT,
+                                               sizeof(ParkingConfig));
+  if (copy == NULL) {
+    return -2;
+  }
+  *copy = *config;
+  copy->retired_next = NULL;
+  if (parking_config_compile(copy) != 0) {
+    parking_memory_free(&lot->memory, copy);
+    return -1;
   }
 
+  config_lock_acquire(lot);
+  old = (ParkingConfig *)parking_atomic_exchange_ptr(&lot->config, copy);
+  old->retired_next = lot->retired_configs;
+  lot->retired_configs = old;
+  config_lock_release(lot);
   return 0;
 }
 
 /**
- * @brief 从停车场中删除一个车位。
- * @details 从链表中找到并移除指定ID的车位节点，然后释放其内存。
- * @note 只有空闲车位才能被删除。
- * @param lot 目标停车场。
- * @param slot_id 要删除的车位编号。
- * @return 返回码：0 成功, -1 停车场对象为空, -2 车位正在被使用，无法删除, -3
- * 车位不存在。
+ * @brief 释放已被替换的运行时配置。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @return 释放的配置份数。
  */
-int delete_slot(ParkingLot *lot, int slot_id) {
-  ParkingSlot *current;
-  ParkingSlot *prev = NULL;
+int reclaim_parking_configs(ParkingLot *lot) {
+  ParkingConfig *retired;
+  int count = 0;
 
   if (lot == NULL) {
-    return -1; /* 停车场对象为空 */
+    return 0;
   }
+  config_lock_acquire(lot);
+  retired = lot->retired_configs;
+  lot->retired_configs = NULL;
+  config_lock_release(lot);
 
-  current = lot->slot_head;
-  while (current != NULL) {
-    if (current->slot_id == slot_id) {
-      /* 检查车位是否为空闲状态 */
-      if (current->status == OCCUPIED_STATUS) {
-        return -2; /* 车位正在被使用，无法删除 */
-      }
-
-      /* 从链表中移除节点 */
-      if (prev == NULL) { /* 如果是头节点 */
-        lot->slot_head = current->next;
-      } else {
-        prev->next = current->next;
-      }
+  while (retired != NULL) {
+    ParkingConfig *next = retired->retired_next;
 
-      /* 释放内存并更新总数 */
-      free_parking_slot(current);
-      lot->total_slots--;
-
-      return 0; /* 成功 */
-    }
-    prev = current;
-    current = current->next;
+    release_parking_config(lot, retired);
+    retired = next;
+    count++;
   }
-
-  return -3; /* 车位不存在 */
+  return count;
 }
 
 /**
- * @brief 统计指定日期内某类型车辆的入场总数。
- * @details 遍历所有已占用车位，比较其入场时间的年、月、日与指定日期是否匹配。
+ * @brief 以一份新名单整体替换停车场的某种车牌名单。
  * @param lot 目标停车场。
- * @param date 指定的日期 (time_t)。
- * @param type 车辆类型 (居民/访客)。
- * @return 指定日期和类型的车辆入场总数。若 `lot` 为 NULL 返回 -1。
+ * @param kind 名单种类。
+ * @param list 新名单，NULL 表示清空该名单。
+ * @return 成功返回 0；参数无效返回 -1；封存时内存不足返回 -2。
  */
-int count_daily_parking(ParkingLot *lot, time_t date, ParkingType type) {
-  ParkingSlot *current;
-  int count = 0;
-  struct tm *target_date;
-  struct tm *entry_date;
+int publish_plate_list(ParkingLot *lot, PlateListKind kind, PlateList *list) {
+  PlateList *old;
 
-  if (lot == NULL) {
+  if (lot == NULL || (unsigned int)kind >= PLATE_LIST_KINDS) {
     return -1;
   }
-
-  target_date = localtime(&date);
-
-  current = lot->slot_head;
-  while (current != NULL) {
-    if (current->status == OCCUPIED_STATUS && current->type == type &&
-        current->entry_time > 0) {
-
-      entry_date = localtime(&current->entry_time);
-
-      /* 比较年、月、日是否都相同 */
-      if (target_date->tm_year == entry_date->tm_year &&
-          target_date->tm_mon == entry_date->tm_mon &&
-          target_date->tm_mday == entry_date->tm_mday) {
-        count++;
-      }
-    }
-    current = current->next;
+  if (list != NULL && plate_list_seal(list) != 0) {
+    return -2;
   }
 
-  return count;
+  config_lock_acquire(lot);
+  old = (PlateList *)parking_atomic_exchange_ptr(&lot->plate_lists[kind],
+                                                 list);
+  if (old != NULL) {
+    old->retired_next = lot->retired_plate_lists;
+    lot->retired_plate_lists = old;
+  }
+  config_lock_release(lot);
+  return 0;
 }
 
 /**
- * @brief 统计指定月份内某类型车辆的入场总数。
- * @details 遍历所有已占用车位，比较其入场时间的年份和月份是否与指定年月匹配。
- * @param lot 目标停车场。
- * @param year 年份。
- * @param month 月份 (1-12)。
- * @param type 车辆类型 (居民/访客)。
- * @return 指定月份和类型的车辆入场总数。若参数无效返回 -1。
+ * @brief 释放已被替换的车牌名单。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @return 释放的名单份数。
  */
-int count_monthly_parking(ParkingLot *lot, int year, int month,
-                          ParkingType type) {
-  ParkingSlot *current;
+int reclaim_plate_lists(ParkingLot *lot) {
+  PlateList *retired;
   int count = 0;
-  struct tm *entry_date;
 
-  if (lot == NULL || month < 1 || month > 12) {
-    return -1;
+  if (lot == NULL) {
+    return 0;
   }
+  config_lock_acquire(lot);
+  retired = lot->retired_plate_lists;
+  lot->retired_plate_lists = NULL;
+  config_lock_release(lot);
 
-  current = lot->slot_head;
-  while (current != NULL) {
-    if (current->status == OCCUPIED_STATUS && current->type == type &&
-        current->entry_time > 0) {
-
-      entry_date = localtime(&current->entry_time);
+  while (retired != NULL) {
+    PlateList *next = retired->retired_next;
 
-      /* 比较年份和月份是否相同 */
-      if ((entry_date->tm_year + 1900) == year &&
-          (entry_date->tm_mon + 1) == month) {
-        count++;
-      }
-    }
-    current = current->next;
+    plate_list_free(retired);
+    retired = next;
+    count++;
   }
-
   return count;
 }
 
 /**
- * @brief 将停车场的所有数据保存到文本文件。
- * @details
- * 将停车场元数据和所有车位信息序列化到文本文件。文件格式如下：
- * - 停车场信息: `LOT|<total_slots>`
- * - 车位信息:
- * `SLOT|id|location|owner|license|contact|type|entry|exit|status|due_date`
- *   空闲车位的车主、车牌等信息为空。
- * @param lot 要保存的停车场。
- * @param filename 目标文件名。
- * @return 成功返回 0，若参数无效或文件无法打开则返回 -1。
+ * @brief 判断车牌是否在停车场的某种名单中。
+ * @param lot 目标停车场（调用者持有读锁或写锁）。
+ * @param kind 名单种类。
+ * @param plate 车牌号。
+ * @return 在名单中返回 1，否则返回 0。
  */
-int save_parking_data(ParkingLot *lot, const char *filename) {
-  FILE *file;
-  ParkingSlot *current;
-
-  if (lot == NULL || filename == NULL) {
-    return -1;
+int parking_lot_plate_listed(const ParkingLot *lot, PlateListKind kind,
+                             const char *plate) {
+  if (lot == NULL || (unsigned int)kind >= PLATE_LIST_KINDS) {
+    return 0;
   }
+  return plate_list_contains(
+      (const PlateList *)parking_atomic_load_ptr(&lot->plate_lists[kind]),
+      plate);
+}
 
-  file = fopen(filename, "w");
-  if (file == NULL) {
-    return -1;
+/**
+ * @brief 读取停车场某种名单的条数。
+ * @param lot 目标停车场（调用者持有读锁或写锁）。
+ * @param kind 名单种类。
+ * @return 名单条数。
+ */
+long parking_lot_plate_list_size(const ParkingLot *lot, PlateListKind kind) {
+  const PlateList *list;
+
+  if (lot == NULL || (unsigned int)kind >= PLATE_LIST_KINDS) {
+    return 0;
   }
+  list = (const PlateList *)parking_atomic_load_ptr(&lot->plate_lists[kind]);
+  return list != NULL ? (long)list->count : 0;
+}
 
-  /* 核心修复：只保存总车位数，与 load_parking_data 的解析逻辑同步 */
-  fprintf(file, "LOT|%d\n", lot->total_slots);
-
-  /* 遍历并保存每个车位的信息 */
-  for (current = lot->slot_head; current != NULL; current = current->next) {
-    if (current->status == OCCUPIED_STATUS) {
-      fprintf(file, "SLOT|%d|%s|%s|%s|%s|%d|%lld|%lld|%d|%lld\n",
-              current->slot_id, current->location, current->owner_name,
-              current->license_plate, current->contact, current->type,
-              (long long)current->entry_time, (long long)current->exit_time,
-              current->status, (long long)current->resident_due_date);
-    } else {
-      fprintf(file, "SLOT|%d|%s||||%d|0|0|%d|0\n", current->slot_id,
-              current->location, current->type, current->status);
-    }
+/**
+ * @brief 切换停车场时间源的工作方式。
+ * @param lot 目标停车场。
+ * @param mode 新的工作方式。
+ * @param start 虚拟时钟的起始时刻。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int configure_parking_clock(ParkingLot *lot, ParkingClockMode mode,
+                            time_t start) {
+  if (lot == NULL) {
+    return -1;
   }
+  return parking_clock_set_mode(&lot->clock, mode, start);
+}
 
-  fclose(file);
-  return 0;
+/**
+ * @brief 刷新缓存时钟。
+ * @param lot 目标停车场。
+ * @return 刷新后的当前时刻。
+ */
+time_t tick_parking_clock(ParkingLot *lot) {
+  return lot != NULL ? parking_clock_tick(&lot->clock) : time(NULL);
 }
 
 /**
- * @brief 从文本文件中加载停车场数据。
- * @details
- * 解析与 `save_parking_data` 函数格式兼容的文件，重建停车场对象。
- * 首先读取 `LOT` 行初始化停车场，然后逐行读取 `SLOT`
- * 行并创建/添加车位。
- * 加载完成后会重新计算已占用车位数以确保数据一致性。
- * @param filename 源文件名。
- * @return 成功时返回重建的 ParkingLot 指针；失败（文件不存在或格式错误）时返回
- * NULL。
+ * @brief 将虚拟时钟设置到指定时刻。
+ * @param lot 目标停车场。
+ * @param now 新的当前时刻。
+ * @return 成功返回 0，参数无效或不是虚拟时钟返回 -1。
  */
-ParkingLot *load_parking_data(const char *filename) {
-  FILE *file = fopen(filename, "r");
-  if (!file) {
-    return NULL;
-  }
+int set_parking_clock(ParkingLot *lot, time_t now) {
+  return lot != NULL ? parking_clock_set(&lot->clock, now) : -1;
+}
 
-  char line[512];
-  ParkingLot *lot = NULL;
+/**
+ * @brief 将虚拟时钟向前推进若干秒。
+ * @param lot 目标停车场。
+ * @param seconds 推进的秒数。
+ * @return 成功返回 0，参数无效或不是虚拟时钟返回 -1。
+ */
+int advance_parking_clock(ParkingLot *lot, long seconds) {
+  return lot != NULL ? parking_clock_advance(&lot->clock, seconds) : -1;
+}
 
-  /* 读取并解析LOT行 */
-  if (fgets(line, sizeof(line), file)) {
-    int total = 0;
-    if (sscanf(line, "LOT|%d", &total) == 1 && total > 0) {
-      lot = init_parking_lot(total);
-    }
-  }
+/**
+ * @brief (静态辅助函数) 把事件交给停车场注册的处理函数。
+ * @param lot 目标停车场。
+ * @param type 事件类型。
+ * @param when 事件的计划时刻。
+ * @param slot 相关车位，可以为 NULL。
+ */
+static void notify_parking_event(ParkingLot *lot, ParkingEventType type,
+                                 time_t when, ParkingSlot *slot) {
+  ParkingEvent event;
 
-  if (!lot) {
-    fclose(file);
-    return NULL;
+  if (lot->event_handler == NULL) {
+    return;
   }
+  event.type = type;
+  event.when = when;
+  event.slot = slot;
+  lot->event_handler(lot, &event, lot->event_ctx);
+}
 
-  /* 读取并解析所有SLOT行 */
-  while (fgets(line, sizeof(line), file)) {
-    if (strncmp(line, "SLOT|", 5) != 0) {
-      continue;
-    }
-
-    ParkingSlot *slot = (ParkingSlot *)malloc(sizeof(ParkingSlot));
-    if (!slot) {
-      continue;
-    }
-    memset(slot, 0, sizeof(ParkingSlot));
+/**
+ * @brief (静态辅助函数) 处理一个到期的定时器。
+ * @details 日切定时器清零收入并登记下一个 0 点；车位定时器按车位当前的
+ *          状态报告事件，仍在场的访客改到下一个允许时段结束时刻。
+ * @param timer 到期的定时器。
+ * @param ctx 指向 TimerRun 的指针。
+ */
+static void fire_parking_timer(ParkingTimer *timer, void *ctx) {
+  TimerRun *run = (TimerRun *)ctx;
+  ParkingLot *lot = run->lot;
+  ParkingSlot *slot;
 
-    char *p = line + 5;
-    char *field_start = p;
-    int field_index = 0;
+  if (timer == &lot->rollover_timer) {
+    update_revenue_cycle(lot, timer->expires);
+    timer_wheel_add(&lot->timers, timer,
+                    parking_calendar_next_day(&lot->calendar, run->now));
+    notify_parking_event(lot, PARKING_EVENT_DAY_ROLLOVER, timer->expires,
+                         NULL);
+    return;
+  }
 
-    for (;; ++p) {
-      if (*p == '|' || *p == '\0' || *p == '\n' || *p == '\r') {
-        char saved_char = *p;
-        *p = '\0';
-        parse_and_assign_field(slot, field_index, field_start);
-        *p = saved_char;
+  slot = (ParkingSlot *)(void *)((char *)timer - offsetof(ParkingSlot, timer));
+  if (slot->type == VISITOR_TYPE && slot->status == OCCUPIED_STATUS) {
+    time_t when = timer->expires;
 
-        field_index++;
-        field_start = p + 1;
+    timer_wheel_add(&lot->timers, timer,
+                    parking_calendar_next_window_end(visitor_calendar(lot),
+                                                     when));
+    notify_parking_event(lot, PARKING_EVENT_VISITOR_OVERSTAY, when, slot);
+  } else if (slot->type == RESIDENT_TYPE && slot->resident_due_date > 0) {
+    notify_parking_event(lot, PARKING_EVENT_RESIDENT_DUE, timer->expires,
+                         slot);
+  }
+}
 
-        if (saved_char == '\0' || saved_char == '\n' || saved_char == '\r' ||
-            field_index >= 10) {
-          break;
-        }
-      }
-    }
-    add_parking_slot(lot, slot);
+/**
+ * @brief 注册定时器事件的处理函数。
+ * @param lot 目标停车场。
+ * @param handler 处理函数，NULL 表示不再通知。
+ * @param ctx 透传给处理函数的上下文指针。
+ */
+void set_parking_event_handler(ParkingLot *lot, ParkingEventHandler handler,
+                               void *ctx) {
+  if (lot == NULL) {
+    return;
   }
+  lot->event_handler = handler;
+  lot->event_ctx = ctx;
+}
 
-  fclose(file);
+/**
+ * @brief 把定时器推进到停车场时间源的当前时刻。
+ * @details 时钟早于时间轮的当前位置（回拨或切换到更早的虚拟时钟）时，
+ *          先按新时刻重新归位，并把日切定时器改到新时刻之后的 0 点。
+ * @param lot 目标停车场。
+ * @return 触发的定时器数；lot 为 NULL 时返回 -1。
+ */
+int run_parking_timers(ParkingLot *lot) {
+  TimerRun run;
 
-  /* 为确保数据一致性，加载后重新计算已占用车位数 */
-  int occupied_count = 0;
-  ParkingSlot *current = lot->slot_head;
-  while (current) {
-    if (current->status == OCCUPIED_STATUS) {
-      occupied_count++;
-    }
-    current = current->next;
+  if (lot == NULL) {
+    return -1;
   }
-  lot->occupied_slots = occupied_count;
-
-  return lot;
+  run.lot = lot;
+  run.now = parking_lot_now(lot);
+  if (run.now + 1 < lot->timers.current) {
+    timer_wheel_rebase(&lot->timers, run.now);
+    timer_wheel_add(&lot->timers, &lot->rollover_timer,
+                    parking_calendar_next_day(&lot->calendar, run.now));
+  }
+  /* 没有出入场的时段也按刻钟计入占用画像 */
+  observe_forecasts(lot, run.now);
+  return timer_wheel_advance(&lot->timers, run.now, fire_parking_timer, &run);
 }
 
 /**
@@ -844,24 +7538,83 @@ ParkingLot *load_parking_data(const char *filename) {
  * @param slot 要释放的停车位。
  */
 void free_parking_slot(ParkingSlot *slot) {
-  if (slot != NULL) {
+  if (slot != NULL && slot->storage == SLOT_STORAGE_HEAP) {
+    slot_release_strings(slot);
     free(slot);
   }
 }
 
 /**
  * @brief 释放整个停车场（包括所有车位）占用的内存。
- * @details 遍历链表，逐个释放所有停车位节点，最后释放停车场本身。
+ * @details
+ * 内存池中的车位随所在区块一起释放，无需逐个处理；
+ * 只有存在单独分配的车位时，才扫描车位表逐个释放它们。
+ * 最后释放文本存储、索引、车位表和停车场本身。
  * @param lot 要释放的停车场。
  */
 void free_parking_lot(ParkingLot *lot) {
-  if (lot != NULL) {
-    ParkingSlot *current = lot->slot_head;
-    while (current != NULL) {
-      ParkingSlot *next = current->next;
-      free_parking_slot(current);
-      current = next;
+  SlotArenaChunk *chunk;
+  int i;
+
+  if (lot == NULL) {
+    return;
+  }
+
+  /* 后台保存线程先写完排队的请求再退出，之后才能释放车位 */
+  parking_saver_stop(lot->saver);
+  journal_close(lot->journal);
+  ledger_close(lot->ledger);
+  history_close(lot->history);
+  reservation_book_free(lot->reservations);
+  layout_free(lot->layout);
+  zone_table_free(lot->zones);
+  home_table_free(lot->homes);
+  session_cache_free(lot->sessions);
+  request_log_free(lot->request_log);
+  view_hub_free(lot->view);
+  shm_publisher_free(lot->shm);
+  timeline_free(lot->timeline);
+  attach_parking_aggregate(lot, NULL, 0);
+  change_feed_free(lot->feed);
+  if (lot->heap_slot_count > 0) {
+    for (i = 0; i < lot->slot_count; i++) {
+      free_parking_slot(lot->slot_table[i]);
     }
-    free(lot);
   }
+
+  chunk = lot->arena_chunks;
+  while (chunk != NULL) {
+    SlotArenaChunk *next = chunk->next;
+    parking_memory_free(&lot->memory, chunk);
+    chunk = next;
+  }
+
+  parking_memory_free(&lot->memory, lot->slot_table);
+  parking_memory_free(&lot->memory, lot->checkpoint.pages);
+  string_store_free(&lot->strings);
+  hot_table_free(&lot->memory, &lot->hot);
+  slot_bitmap_free(&lot->free_map);
+  for (i = 0; i < SLOT_POOL_KINDS; i++) {
+    slot_bitmap_free(&lot->pool_free[i]);
+  }
+  slot_id_index_free(&lot->id_index);
+  slot_handle_table_free(&lot->handles);
+  plate_index_free(&lot->plate_index);
+  due_heap_free(&lot->due_heap);
+  trigram_index_free(&lot->search_index);
+  calendar_count_free(&lot->daily_entries);
+  calendar_count_free(&lot->monthly_entries);
+  reclaim_parking_configs(lot);
+  release_parking_config(lot, (ParkingConfig *)lot->config);
+  reclaim_plate_lists(lot);
+  for (i = 0; i < PLATE_LIST_KINDS; i++) {
+    plate_list_free((PlateList *)lot->plate_lists[i]);
+  }
+  parking_rwlock_destroy(lot->lock);
+  /* 借用的文本指向映射，车位与文本存储都释放之后才能解除映射 */
+  if (lot->text_mapping != NULL) {
+    file_mapping_close(lot->text_mapping);
+    parking_memory_free(&lot->memory, lot->text_mapping);
+  }
+  parking_memory_free(&lot->memory, lot);
 }
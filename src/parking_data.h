@@ -3,6 +3,18 @@
 
 #include <time.h>
 
+#include "parking_bitmap.h"
+#include "parking_calendar.h"
+#include "parking_clock.h"
+#include "parking_config.h"
+#include "parking_forecast.h"
+#include "parking_hll.h"
+#include "parking_index.h"
+#include "parking_platelist.h"
+#include "parking_rollup.h"
+#include "parking_strings.h"
+#include "parking_timer.h"
+
 /**
  * @file parking_data.h
  * @brief 定义停车场管理系统的核心数据结构和数据层API。
@@ -22,10 +34,34 @@
 #define MAX_LICENSE_LEN 50   /**< 车牌号的最大长度 */
 #define MAX_CONTACT_LEN 50   /**< 联系方式的最大长度 */
 
-#define RESIDENT_MONTHLY_FEE 200.0 /**< 居民用户的月度固定费用（元） */
-#define VISITOR_HOURLY_FEE 10.0    /**< 访客用户的单位小时费率（元/小时） */
-#define VISITOR_START_HOUR 9       /**< 访客允许入场的最早小时（24小时制） */
-#define VISITOR_END_HOUR 17        /**< 访客允许入场的最晚小时（24小时制） */
+#define RESIDENT_MONTHLY_FEE                                                   \
+  (TARIFF_DEFAULT_RESIDENT_MONTHLY_CENTS / 100.0) /**< 默认居民月费（元） */
+#define VISITOR_HOURLY_FEE                                                     \
+  (TARIFF_DEFAULT_HOURLY_CENTS / 100.0) /**< 默认访客小时费率（元/小时） */
+#define VISITOR_START_HOUR                                                     \
+  PARKING_CONFIG_DEFAULT_START_HOUR /**< 默认访客入场最早小时（24小时制） */
+#define VISITOR_END_HOUR                                                       \
+  PARKING_CONFIG_DEFAULT_END_HOUR /**< 默认访客入场最晚小时（24小时制） */
+
+#define SLOT_ARENA_CHUNK_SLOTS 256 /**< 车位内存池每个区块最多容纳的车位数 */
+#define SLOT_ARENA_MIN_CHUNK_SLOTS 8 /**< 车位内存池区块的最少车位数 */
+#define SLOT_COMPACT_MAX_VICTIMS 16 /**< 一轮整理最多腾空的区块数 */
+#define SLOT_COMPACT_SPARSE_PERCENT 50 /**< 使用率不超过该比例的区块才被腾空 */
+#define SLOT_COMPACT_MIN_TABLE 64 /**< 整理后稠密车位表至少保留的容量 */
+
+#define SNAPSHOT_MAGIC "PARKSNAP" /**< 二进制快照文件头的 8 字节魔数 */
+#define SNAPSHOT_VERSION 2        /**< 当前写出的二进制快照格式版本（带页表） */
+#define SNAPSHOT_HEADER_SIZE 40   /**< 二进制快照文件头的字节数 */
+#define SNAPSHOT_RECORD_SIZE 288  /**< 二进制快照中每条车位记录的字节数 */
+#define SNAPSHOT_PAGE_ROWS 256    /**< 写时复制快照每页的车位数 */
+#define SNAPSHOT_DELTA_MAGIC "PARKDLT1" /**< 增量快照文件头的 8 字节魔数 */
+#define SNAPSHOT_DELTA_VERSION 1        /**< 增量快照的格式版本 */
+#define SNAPSHOT_DELTA_HEADER_SIZE 36   /**< 增量快照文件头的字节数 */
+#define SNAPSHOT_DELTA_MAX_PERCENT 50 /**< 脏页超过该百分比时改写完整快照 */
+#define INDEX_IMAGE_MAGIC "PARKIDX1" /**< 索引映像文件头的 8 字节魔数 */
+#define INDEX_IMAGE_VERSION 1        /**< 索引映像的格式版本 */
+#define INDEX_IMAGE_HEADER_SIZE 48   /**< 索引映像文件头的字节数 */
+#define INDEX_IMAGE_SUFFIX ".idx"    /**< 索引映像文件名：快照文件名加该后缀 */
 
 /**
  *********************************************************************************
@@ -49,6 +85,43 @@ typedef enum {
   OCCUPIED_STATUS = 1 /**< 车位当前已被占用。 */
 } ParkingStatus;
 
+/**
+ * @brief 定义停车位节点的内存来源。
+ */
+typedef enum {
+  SLOT_STORAGE_HEAP = 0, /**< 由 create_parking_slot 单独 malloc 分配。 */
+  SLOT_STORAGE_ARENA = 1 /**< 由所属停车场的车位内存池分配，随停车场整体释放。 */
+} SlotStorage;
+
+/**
+ * @brief 定义空闲车位所属的分配池。
+ * @details 自动选位时居民先取居民池、访客先取访客池，各自再退回共享池；
+ *          居民池的车位不接纳访客，访客池的车位不接纳居民。
+ */
+typedef enum SlotPool {
+  SLOT_POOL_SHARED = 0,   /**< 共享池，居民与访客都可以停放（默认）。 */
+  SLOT_POOL_RESIDENT = 1, /**< 居民专用池。 */
+  SLOT_POOL_VISITOR = 2,  /**< 访客专用池。 */
+  SLOT_POOL_KINDS = 3     /**< 分配池的种数。 */
+} SlotPool;
+
+/**
+ * @brief 定义遍历车位时的筛选条件。
+ */
+typedef enum {
+  SLOT_FILTER_ALL = 0,     /**< 全部车位。 */
+  SLOT_FILTER_FREE = 1,    /**< 仅空闲车位。 */
+  SLOT_FILTER_OCCUPIED = 2 /**< 仅已占用车位。 */
+} SlotFilter;
+
+/**
+ * @brief 定义子串检索的字段。
+ */
+typedef enum {
+  SLOT_SEARCH_PLATE = 0, /**< 按车牌号检索。 */
+  SLOT_SEARCH_OWNER = 1  /**< 按车主姓名检索。 */
+} SlotSearchField;
+
 /**
  *********************************************************************************
  *                                 结构体定义
@@ -57,37 +130,466 @@ typedef enum {
 
 /**
  * @brief 描述一个停车位的完整信息。
- * @details 此结构体是系统中管理车位信息的基本单元，通过单向链表组织。
+ * @details
+ * 此结构体是系统中管理车位信息的基本单元，通过单向链表组织，
+ * 同时登记在所属停车场的稠密车位表中，供全量扫描顺序访问。
+ * 文本字段只保存指针：位置描述驻留在停车场的位置驻留池中，
+ * 车主、车牌和联系方式来自停车场的文本内存池，空字段指向 string_store_empty。
+ * @note 文本字段只读，修改须通过 allocate_slot、update_slot_info 等数据层函数。
  */
 typedef struct ParkingSlot {
   int slot_id;                     /**< 车位的唯一数字标识符。 */
-  char location[MAX_LOCATION_LEN]; /**< 车位的物理位置描述字符串 (例如 "A-01")。
-                                    */
-  char owner_name[MAX_NAME_LEN];       /**< 当前占用该车位的车主姓名。 */
-  char license_plate[MAX_LICENSE_LEN]; /**< 当前停放车辆的车牌号码。 */
-  char contact[MAX_CONTACT_LEN];       /**< 车主的联系方式（电话号码等）。 */
+  const char *location;      /**< 车位的物理位置描述字符串 (例如 "A-01")。 */
+  const char *owner_name;    /**< 当前占用该车位的车主姓名。 */
+  const char *license_plate; /**< 当前停放车辆的车牌号码。 */
+  const char *contact;       /**< 车主的联系方式（电话号码等）。 */
+  StringStore *strings;      /**< 文本字段所在的存储，未加入停车场时为 NULL。 */
   ParkingType type;                    /**< 停车类型，区分居民或访客。 */
   time_t entry_time;                   /**< 车辆入场的时间戳。 */
   time_t exit_time;                    /**< 车辆出场的时间戳。 */
   time_t resident_due_date; /**< 若为居民车位，其月费的到期时间戳。 */
   ParkingStatus status;     /**< 车位当前的占用状态 (空闲/占用)。 */
   struct ParkingSlot *next; /**< 指向链表中下一个停车位节点的指针。 */
+  int table_index;     /**< 在停车场稠密车位表中的下标，未加入停车场时为 -1。 */
+  SlotStorage storage; /**< 车位节点的内存来源。 */
+  struct ParkingSlot *entry_prev; /**< 入场时间链表中的前一个（更早入场）车位。 */
+  struct ParkingSlot *entry_next; /**< 入场时间链表中的后一个（更晚入场）车位。 */
+  unsigned int search_stamp; /**< 三元组索引登记戳，每次注销后递增。 */
+  int search_entries;        /**< 以当前登记戳登记在三元组索引中的项数。 */
+  int due_heap_index; /**< 在月费到期堆中的下标，未登记时为 -1。 */
+  unsigned int handle_index; /**< 在句柄表中的下标，只在加入停车场后有效。 */
+  ParkingTimer timer; /**< 在场访客的时段结束提醒或居民的月费到期提醒。 */
+  unsigned char pool; /**< 车位所属的分配池（SlotPool），只保存在内存中。 */
+  unsigned char has_home; /**< 非 0 表示车位是某个居民车牌的固定车位。 */
 } ParkingSlot;
 
+/**
+ * @brief 车位内存池中的一个区块。
+ * @details 区块内的车位节点在内存中连续存放，区块之间通过链表串联。
+ *          区块只按 capacity 个车位分配，slots 中超出 capacity 的部分不存在：
+ *          小停车场的第一个区块按设计容量截短，之后的区块逐个加倍，
+ *          直到 SLOT_ARENA_CHUNK_SLOTS。
+ */
+typedef struct SlotArenaChunk {
+  struct SlotArenaChunk *next;              /**< 下一个区块。 */
+  int used;                                 /**< 已切分出去的车位数。 */
+  int capacity;                             /**< 区块实际容纳的车位数。 */
+  int live;       /**< 已取出、尚未归还的车位节点数。 */
+  int evacuating; /**< 非 0 表示正在被整理腾空，归还的节点不再复用。 */
+  ParkingSlot slots[SLOT_ARENA_CHUNK_SLOTS]; /**< 连续的车位节点存储。 */
+} SlotArenaChunk;
+
+/**
+ * @brief 车位内存池在线整理的阶段。
+ */
+typedef enum {
+  SLOT_COMPACT_IDLE = 0,  /**< 没有进行中的整理。 */
+  SLOT_COMPACT_PURGE = 1, /**< 正在筛选整理开始时摘下的空闲节点。 */
+  SLOT_COMPACT_MOVE = 2   /**< 正在沿车位链表把车位迁出被腾空的区块。 */
+} SlotCompactPhase;
+
+/**
+ * @brief 车位内存池在线整理的进度。
+ * @details 大批删除车位后，空闲节点散落在各个区块中。一轮整理先选出若干
+ *          稀疏区块，把空闲链表中落在这些区块里的节点丢弃，再沿车位链表
+ *          把其中的车位逐个迁到其他区块，最后释放已经腾空的区块。
+ *          每一步只处理有限个节点，步与步之间停车场可以照常修改。
+ */
+typedef struct SlotCompaction {
+  SlotCompactPhase phase; /**< 当前阶段。 */
+  SlotArenaChunk *victims[SLOT_COMPACT_MAX_VICTIMS]; /**< 本轮要腾空的区块。 */
+  int victim_count;       /**< 本轮要腾空的区块数。 */
+  ParkingSlot *pending;   /**< 尚未筛选的空闲节点链表（PURGE 阶段）。 */
+  ParkingSlot *cursor; /**< 已检查过的最后一个车位，NULL 表示从表头开始。 */
+  long moved_slots;    /**< 累计迁移的车位数。 */
+  long freed_chunks;   /**< 累计释放的区块数。 */
+} SlotCompaction;
+
+/**
+ * @brief 稠密车位表的热字段列（结构数组布局）。
+ * @details
+ * 统计与列表筛选只关心编号、状态、类型和时间戳，
+ * 因此这些字段按列连续存放，第 i 行对应 slot_table[i]。
+ * 车位节点本身作为冷记录保存位置、车主、车牌等文本字段，
+ * 扫描时只有命中的车位才会访问冷记录。
+ * @note 热字段列是车位节点对应字段的副本，由数据层在入场、出场、
+ *       加入和删除车位时同步维护；在数据层之外直接修改车位节点的
+ *       status/type/entry_time/resident_due_date 后必须调用
+ *       sync_slot_hot_fields()。
+ */
+typedef struct SlotHotTable {
+  int *slot_id;           /**< 车位编号列。 */
+  unsigned char *status;  /**< 占用状态列（ParkingStatus）。 */
+  unsigned char *type;    /**< 停车类型列（ParkingType）。 */
+  time_t *entry_time;     /**< 入场时间列。 */
+  time_t *due_date;       /**< 居民月费到期时间列。 */
+} SlotHotTable;
+
+/**
+ * @brief 停车场某一时刻的写时复制快照。
+ * @details
+ * 开始快照时只复制稠密车位表的指针，车位记录按 SNAPSHOT_PAGE_ROWS 行一页
+ * 延迟编码：保存线程逐页编码，修改车位的写者在修改前先把所在页按修改前的
+ * 内容编码进快照。因此每一页要么在任何修改之前编码，要么由第一次修改
+ * 抢先编码，最终得到开始快照那一刻的一致映像。
+ * 编码完成后写文件不需要持有停车场的锁。
+ */
+typedef struct ParkingSnapshot {
+  unsigned char *buffer;    /**< 文件头与全部定长记录，按快照文件布局存放。 */
+  ParkingSlot **rows;       /**< 开始快照时稠密车位表的副本。 */
+  unsigned char *page_done; /**< 每页是否已编码。 */
+  int total_slots;          /**< 开始快照时的总车位数。 */
+  int slot_count;           /**< 快照中的车位数。 */
+  int page_count;           /**< 页数。 */
+  int pages_left;           /**< 尚未编码的页数。 */
+  ParkingMemory *memory;    /**< 缓冲区所属的内存对象。 */
+} ParkingSnapshot;
+
+/**
+ * @brief 自上次完整检查点以来被修改过的快照页。
+ * @details 页的划分与写时复制快照相同（SNAPSHOT_PAGE_ROWS 行一页）。
+ *          只有写出过完整检查点（或由检查点加载）之后才开始记录，
+ *          此前修改车位不做任何登记。
+ */
+typedef struct SnapshotDirtySet {
+  unsigned char *pages; /**< 每页一个字节，非 0 表示该页被修改过。 */
+  int capacity;         /**< pages 已分配的页数。 */
+  int dirty_count;      /**< 被修改过的页数。 */
+  int has_base;         /**< 是否已有可作为增量基准的完整检查点。 */
+  unsigned long base_sum; /**< 基准检查点文件头的校验和。 */
+} SnapshotDirtySet;
+
+struct ParkingJournal;
+struct JournalRecord;
+struct ParkingSaver;
+struct ParkingRwLock;
+struct ParkingLot;
+struct ParkingAggregate;
+
+/**
+ * @brief 数据层每产生一条日志记录时调用的旁路接收函数。
+ * @details 在修改所在的写锁内调用，顺序与日志文件中的记录顺序相同；
+ *          不得再访问该停车场。
+ * @param record 刚产生的记录。
+ * @param ctx 设置时传入的上下文指针。
+ */
+typedef void (*ParkingMutationTap)(const struct JournalRecord *record,
+                                   void *ctx);
+
+/**
+ * @brief 停车场定时器触发的事件类型。
+ */
+typedef enum {
+  PARKING_EVENT_VISITOR_OVERSTAY = 0, /**< 访客允许时段结束时车辆仍在场。 */
+  PARKING_EVENT_RESIDENT_DUE = 1,     /**< 居民车位的月费到期。 */
+  PARKING_EVENT_DAY_ROLLOVER = 2      /**< 进入新的一天，当日收入已清零。 */
+} ParkingEventType;
+
+/**
+ * @brief 一次定时器事件。
+ */
+typedef struct ParkingEvent {
+  ParkingEventType type;     /**< 事件类型。 */
+  time_t when;               /**< 事件的计划时刻。 */
+  struct ParkingSlot *slot;  /**< 相关车位，日切事件为 NULL。 */
+} ParkingEvent;
+
+/**
+ * @brief 定时器事件的处理函数。
+ * @details 在 run_parking_timers 内调用，调用者持有停车场写锁；
+ *          处理函数可以读取停车场，但不能调用会再次加锁的服务层函数。
+ * @param lot 触发事件的停车场。
+ * @param event 事件内容，只在回调期间有效。
+ * @param ctx 注册时传入的上下文指针。
+ */
+typedef void (*ParkingEventHandler)(struct ParkingLot *lot,
+                                    const ParkingEvent *event, void *ctx);
+
+/**
+ * @brief 一个分区（按位置前缀划分）的车位计数。
+ */
+typedef struct ParkingZoneStats {
+  char zone[MAX_LOCATION_LEN]; /**< 分区的位置前缀。 */
+  int total_slots;             /**< 分区内的车位数。 */
+  int free_slots;              /**< 分区内的空闲车位数。 */
+  int occupied_slots;          /**< 分区内的已占用车位数。 */
+} ParkingZoneStats;
+
+/**
+ * @brief 一个分区（或整个停车场）的短时占用预测。
+ */
+typedef struct ParkingForecast {
+  int total_slots;    /**< 当前车位数。 */
+  int occupied_slots; /**< 当前占用数。 */
+  /** 15、30、60 分钟后的预测占用数（按 forecast_horizon_minutes 的顺序）。 */
+  int predicted_occupied[FORECAST_HORIZONS];
+} ParkingForecast;
+
+/**
+ * @brief 常客车辆上一次出场时记下的资料（见 allocate_returning_vehicle）。
+ */
+typedef struct VehicleSession {
+  char license_plate[MAX_LICENSE_LEN]; /**< 车牌号。 */
+  char owner_name[MAX_NAME_LEN];       /**< 车主姓名。 */
+  char contact[MAX_CONTACT_LEN];       /**< 联系方式。 */
+  char zone[MAX_LOCATION_LEN]; /**< 上次所停车位所属的分区，空串表示没有。 */
+  ParkingType type;            /**< 停车类型。 */
+  time_t last_exit;            /**< 上一次出场时间。 */
+} VehicleSession;
+
+/**
+ * @brief 回溯得到的某一时刻的车位状态（见 find_slot_at）。
+ */
+typedef struct HistoricalSlot {
+  int slot_id;                         /**< 车位编号。 */
+  ParkingStatus status;                /**< 当时的车位状态。 */
+  ParkingType type;                    /**< 当时的停车类型。 */
+  time_t entry_time;                   /**< 当时在场车辆的入场时间。 */
+  char location[MAX_LOCATION_LEN];     /**< 当时的位置描述。 */
+  char owner_name[MAX_NAME_LEN];       /**< 当时的车主姓名。 */
+  char license_plate[MAX_LICENSE_LEN]; /**< 当时的车牌号，空闲时为空串。 */
+  char contact[MAX_CONTACT_LEN];       /**< 当时的联系方式。 */
+} HistoricalSlot;
+
+/**
+ * @brief 分区计数变化的处理函数。
+ * @details 在引起变化的修改所在的写锁内调用，每个计数有变化的分区调用一次；
+ *          处理函数可以读取停车场，但不能调用会再次加锁的服务层函数。
+ * @param lot 计数变化的停车场。
+ * @param stats 变化后的分区计数，只在回调期间有效。
+ * @param ctx 注册时传入的上下文指针。
+ */
+typedef void (*ParkingZoneHandler)(struct ParkingLot *lot,
+                                   const ParkingZoneStats *stats, void *ctx);
+
+/**
+ * @brief 车位变更事件的类型，取值与预写日志的操作类型相同。
+ */
+typedef enum {
+  PARKING_CHANGE_ADD_SLOT = 1,    /**< 添加车位。 */
+  PARKING_CHANGE_DELETE_SLOT = 2, /**< 删除车位。 */
+  PARKING_CHANGE_ALLOCATE = 3,    /**< 车辆入场。 */
+  PARKING_CHANGE_DEALLOCATE = 4,  /**< 车辆出场。 */
+  PARKING_CHANGE_UPDATE_INFO = 5, /**< 修改车位信息。 */
+  PARKING_CHANGE_SYNC_SLOT = 6    /**< 热字段同步（状态、类型、时间戳）。 */
+} ParkingChangeKind;
+
+/**
+ * @brief 一条紧凑的车位变更事件。
+ * @details 只携带编号、状态与时间，订阅者需要文本字段时再按编号查询。
+ */
+typedef struct ParkingChange {
+  unsigned long seq;      /**< 事件序号，在停车场内从 1 起连续递增。 */
+  ParkingChangeKind kind; /**< 事件类型。 */
+  int slot_id;            /**< 车位编号。 */
+  int status;             /**< 变更后的车位状态，删除车位时为 FREE_STATUS。 */
+  int type;               /**< 变更后的停车类型。 */
+  time_t when;            /**< 入场、出场时间，其余事件为发生时的业务时间。 */
+} ParkingChange;
+
 /**
  * @brief 描述整个停车场的状态和统计信息。
  * @details
  * 此结构体是管理整个停车场的根对象，包含了所有车位数据和关键的统计指标。
+ * occupied_slots、free_slot_count 以及按类型的占用计数由数据层在每次
+ * 状态变化时增量维护，任何时刻都与车位表精确一致，调用者不应直接修改。
+ * 这些计数器、total_slots 与收入字段均以原子操作更新，统计查询可以不加锁，
+ * 用 parking_atomic_load_int/parking_atomic_load_long 读取。
+ * @note 数据层函数本身不加锁。多线程共享同一停车场时，读操作（查找、列表、
+ *       遍历、保存）须在 parking_lot_read_lock 内进行，修改须在
+ *       parking_lot_write_lock 内进行；服务层函数已按此规则自行加锁。
  */
 typedef struct ParkingLot {
   int total_slots;         /**< 停车场设计的总车位数。 */
   int occupied_slots;      /**< 当前已被占用的车位数。 */
+  int free_slot_count;     /**< 当前空闲的车位数（已加入停车场的车位）。 */
+  int occupied_resident_count; /**< 当前被居民车辆占用的车位数。 */
+  int occupied_visitor_count;  /**< 当前被访客车辆占用的车位数。 */
   ParkingSlot *slot_head;  /**< 指向车位信息链表的头节点。 */
-  double today_revenue;    /**< 当日产生的总收入。 */
-  double month_revenue;    /**< 当月产生的总收入。 */
-  time_t last_update_time; /**< 收入统计信息的最后更新时间戳。 */
+  long today_revenue_cents; /**< 当日收入（分），原子更新。 */
+  long month_revenue_cents; /**< 当月收入（分），原子更新。 */
+  long revenue_day;        /**< 当日收入所属日期（YYYYMMDD），0 表示尚无收入。 */
+  long revenue_month;      /**< 当月收入所属月份（YYYYMM），0 表示尚无收入。 */
+  RevenueRollup rollup; /**< 按小时、按日滚动汇总的收入与出入场计数。 */
+  DistinctCounter distinct_plates; /**< 按周、按月入场车牌的不同车辆草图。 */
+  OccupancyForecast forecast; /**< 整个停车场的占用画像与预测缓存。 */
+  SlotIdIndex id_index;    /**< 车位编号到车位节点的哈希索引，由数据层维护。 */
+  SlotHandleTable handles; /**< 车位句柄到车位节点的句柄表，由数据层维护。 */
+  PlateIndex plate_index;  /**< 在场车牌号到车位节点的哈希索引，由数据层维护。 */
+  EntryOrderList entry_order; /**< 在场车位按入场时间排列的链表，由数据层维护。 */
+  DueDateHeap due_heap; /**< 居民车位按月费到期时间排列的最小堆，由数据层维护。 */
+  TimerWheel timers; /**< 由业务时间驱动的定时器时间轮，由数据层维护。 */
+  ParkingTimer rollover_timer; /**< 下一个本地 0 点的日切定时器。 */
+  ParkingEventHandler event_handler; /**< 定时器事件的处理函数，可以为 NULL。 */
+  void *event_ctx; /**< 透传给事件处理函数的上下文指针。 */
+  TrigramIndex search_index; /**< 在场车牌号与车主姓名的三元组索引，由数据层维护。 */
+  CalendarCountIndex daily_entries;   /**< 按日期（YYYYMMDD）累计的入场次数。 */
+  CalendarCountIndex monthly_entries; /**< 按月份（YYYYMM）累计的入场次数。 */
+  ParkingCalendar calendar; /**< 当日边界缓存，只在写锁内（或单线程）使用。 */
+  ParkingConfig base_config; /**< 初始的默认配置，随停车场一起释放。 */
+  void *volatile config; /**< 当前生效的 ParkingConfig，经 parking_lot_config 读取。 */
+  ParkingConfig *retired_configs; /**< 已被替换、等待回收的配置链表。 */
+  volatile int config_lock; /**< 保护配置发布与待回收链表的自旋锁。 */
+  /** 当前生效的 PlateList（按 PlateListKind），NULL 表示名单为空。 */
+  void *volatile plate_lists[PLATE_LIST_KINDS];
+  PlateList *retired_plate_lists; /**< 已被替换、等待回收的名单链表。 */
+  ParkingSlot **slot_table;    /**< 稠密车位表，按加入顺序连续存放全部车位。 */
+  int slot_count;              /**< 稠密车位表中的车位数量。 */
+  int slot_capacity;           /**< 稠密车位表已分配的容量。 */
+  SlotHotTable hot;            /**< 与稠密车位表平行的热字段列。 */
+  SlotBitmap free_map; /**< 空闲车位位图，第 i 位对应 slot_table[i]。 */
+  /** 各分配池的空闲车位位图（按 SlotPool），不含固定车位。 */
+  SlotBitmap pool_free[SLOT_POOL_KINDS];
+  SlotArenaChunk *arena_chunks; /**< 车位内存池的区块链表。 */
+  ParkingSlot *arena_free_list; /**< 内存池中已删除、可复用的车位节点。 */
+  SlotCompaction compaction; /**< 车位内存池的在线整理进度。 */
+  int heap_slot_count; /**< 以 SLOT_STORAGE_HEAP 方式加入的车位数量。 */
+  struct ParkingJournal *journal; /**< 预写日志，NULL 表示未启用日志。 */
+  ParkingMutationTap mutation_tap; /**< 日志记录的旁路接收者，可以为 NULL。 */
+  void *mutation_tap_ctx; /**< 透传给旁路接收函数的上下文指针。 */
+  struct PaymentLedger *ledger; /**< 收费台账，NULL 表示未启用台账。 */
+  ParkingSnapshot *snapshot; /**< 进行中的写时复制快照，NULL 表示没有。 */
+  SnapshotDirtySet checkpoint; /**< 自上次完整检查点以来的脏页。 */
+  struct ParkingSaver *saver; /**< 后台保存线程，NULL 表示未启动。 */
+  volatile long mutation_count; /**< 车位修改次数，以原子操作递增。 */
+  struct SessionHistory *history; /**< 停车记录存储，NULL 表示未启用。 */
+  struct ParkingTaskPool *query_pool; /**< 并行查询的任务池，NULL 表示串行。 */
+  struct ReservationBook *reservations; /**< 车位预约簿，NULL 表示尚无预约。 */
+  struct ParkingLayout *layout; /**< 车位平面布局，NULL 表示未登记坐标。 */
+  struct ZoneTable *zones; /**< 分区计数表，NULL 表示未登记分区。 */
+  struct HomeSlotTable *homes; /**< 居民固定车位表，NULL 表示尚无登记。 */
+  struct SessionCache *sessions; /**< 常客车辆资料缓存，首次出场时创建。 */
+  int session_capacity; /**< 车辆资料缓存的容量，0 表示不缓存。 */
+  struct RequestLog *request_log; /**< 请求去重表，NULL 表示不去重。 */
+  struct ViewHub *view; /**< 只读视图的发布点，NULL 表示未启用。 */
+  struct ParkingShmPublisher *shm; /**< 共享内存发布者，NULL 表示未启用。 */
+  struct ParkingTimeline *timeline; /**< 时间线，NULL 表示不保留历史。 */
+  struct ParkingAggregate *aggregate; /**< 所属的汇总树，NULL 表示未挂接。 */
+  int aggregate_site; /**< 在汇总树中的站点节点编号。 */
+  ParkingZoneHandler zone_handler; /**< 分区计数的处理函数，可以为 NULL。 */
+  void *zone_ctx; /**< 透传给分区处理函数的上下文指针。 */
+  struct ChangeFeed *feed; /**< 车位变更的订阅者，NULL 表示没有订阅。 */
+  struct FileMapping *text_mapping; /**< 延迟加载时文本所在的映射或 NULL。 */
+  StringStore strings; /**< 车位文本字段的驻留池与文本内存池。 */
+  ParkingClock clock;  /**< 业务时间源，默认为实时时钟。 */
+  ParkingMemory memory; /**< 停车场内部结构的分配函数与内存统计。 */
+  struct ParkingRwLock *lock; /**< 保护整个停车场的读写锁。 */
 } ParkingLot;
 
+/**
+ * @brief 遍历车位时对每个匹配车位调用的回调函数。
+ * @param slot 当前匹配的车位。
+ * @param ctx 调用者传入的上下文指针。
+ * @return 返回 0 继续遍历，返回非 0 立即停止遍历。
+ */
+typedef int (*SlotVisitor)(ParkingSlot *slot, void *ctx);
+
+/**
+ * @brief 按筛选条件逐个取出车位的游标。
+ * @details 游标可直接在栈上声明，遍历过程不分配任何内存。
+ *          遍历期间可以入场、出场或修改车位信息，但不能增删车位，
+ *          否则稠密车位表的 swap-remove 会使游标跳过或重复车位。
+ */
+typedef struct SlotCursor {
+  ParkingLot *lot;   /**< 被遍历的停车场。 */
+  SlotFilter filter; /**< 筛选条件。 */
+  int next_row;      /**< 下一次检查的稠密车位表下标。 */
+} SlotCursor;
+
+/**
+ * @brief 停车时长排行中的一项。
+ */
+typedef struct ParkedVehicle {
+  ParkingSlot *slot;     /**< 在场车位。 */
+  long duration_seconds; /**< 截至查询时刻的停车时长（秒）。 */
+} ParkedVehicle;
+
+/**
+ * @brief 一次已完成的停车（从入场到出场）的记录。
+ * @details 车牌号只保存哈希值，查询某辆车时用 history_plate_hash 计算后比较。
+ */
+typedef struct SessionRecord {
+  unsigned long plate_hash; /**< 车牌号的 32 位哈希值。 */
+  int slot_id;              /**< 停放的车位编号。 */
+  ParkingType type;         /**< 停车类型。 */
+  time_t entry_time;        /**< 入场时间。 */
+  time_t exit_time;         /**< 出场时间。 */
+  long fee_cents;           /**< 出场时收取的费用（分）。 */
+} SessionRecord;
+
+/**
+ * @brief 扫描停车记录时对每条记录调用的回调函数。
+ * @param record 当前记录，未请求的列为 0。
+ * @param ctx 调用者传入的上下文指针。
+ * @return 返回 0 继续扫描，返回非 0 立即停止扫描。
+ */
+typedef int (*SessionVisitor)(const SessionRecord *record, void *ctx);
+
+/**
+ * @brief 一段时间内已完成停车的汇总。
+ */
+typedef struct SessionSummary {
+  long sessions;           /**< 停车次数。 */
+  long resident_sessions;  /**< 居民停车次数。 */
+  long visitor_sessions;   /**< 访客停车次数。 */
+  double total_fee;        /**< 收费总额（元）。 */
+  double total_duration_seconds; /**< 停车时长合计（秒）。 */
+} SessionSummary;
+
+/**
+ * @brief 月费结算为一个居民车位开出的账单。
+ */
+typedef struct ResidentInvoice {
+  int slot_id;         /**< 车位编号。 */
+  time_t period_start; /**< 账单覆盖的起点，即结算前的到期时间。 */
+  time_t period_end;   /**< 账单覆盖的终点，即顺延后的到期时间。 */
+  int periods;         /**< 账单包含的计费周期数。 */
+  long amount_cents;   /**< 金额（分）。 */
+} ResidentInvoice;
+
+/**
+ * @brief 月费结算时对每张账单调用的回调函数。
+ * @details 在结算所持有的写锁内调用，回调中不得修改停车场或再获取它的锁。
+ * @param invoice 刚开出的账单。
+ * @param ctx 调用者传入的上下文指针。
+ */
+typedef void (*ResidentInvoiceVisitor)(const ResidentInvoice *invoice,
+                                       void *ctx);
+
+/**
+ * @brief 访客清场为一辆在场访客车辆完成的出场结算。
+ */
+typedef struct VisitorCheckout {
+  int slot_id;           /**< 车位编号。 */
+  time_t entry_time;     /**< 入场时间。 */
+  long duration_seconds; /**< 停车时长（秒）。 */
+  int billed_hours;      /**< 计费小时数。 */
+  long amount_cents;     /**< 金额（分）。 */
+} VisitorCheckout;
+
+/**
+ * @brief 访客清场时对每次出场调用的回调函数。
+ * @details 在清场所持有的写锁内、车位释放之后调用，
+ *          回调中不得修改停车场或再获取它的锁。
+ * @param checkout 刚完成的出场结算。
+ * @param ctx 调用者传入的上下文指针。
+ */
+typedef void (*VisitorCheckoutVisitor)(const VisitorCheckout *checkout,
+                                       void *ctx);
+
+/**
+ * @brief 一条车位预约。
+ * @details 预约在 [start, end) 内为指定车牌保留车位，
+ *          从开始前 RESERVATION_HOLD_LEAD_SECONDS 秒起其他车辆不能占用。
+ */
+typedef struct Reservation {
+  long id;                             /**< 预约编号，由停车场分配。 */
+  int slot_id;                         /**< 预约的车位编号。 */
+  time_t start;                        /**< 开始时间（含）。 */
+  time_t end;                          /**< 结束时间（不含）。 */
+  char license_plate[MAX_LICENSE_LEN]; /**< 预约的车牌号。 */
+} Reservation;
+
 /**
  *********************************************************************************
  *                            数据层核心API声明
@@ -95,7 +597,7 @@ typedef struct ParkingLot {
  */
 
 /** @name 基础管理函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 初始化一个新的停车场对象。
@@ -106,6 +608,29 @@ typedef struct ParkingLot {
  */
 ParkingLot *init_parking_lot(int total_slots);
 
+/**
+ * @brief 使用指定的分配函数初始化一个新的停车场对象。
+ * @details 停车场对象本身以及车位内存池、稠密车位表、索引、文本存储和
+ *          保存快照时的缓冲区都经由 allocator 分配，并按类别计入统计；
+ *          交给调用者 free() 的查询数组仍使用 C 堆。
+ *          从文件加载得到的停车场使用默认分配函数，
+ *          load_parking_snapshot_with_allocator 除外。
+ * @param total_slots 停车场的总容量。
+ * @param allocator 分配函数，NULL 表示 C 标准库；内容会被复制。
+ * @return 成功返回新停车场，内存分配失败返回 NULL。
+ */
+ParkingLot *init_parking_lot_with_allocator(int total_slots,
+                                            const ParkingAllocator *allocator);
+
+/**
+ * @brief 读取停车场按类别的内存统计。
+ * @details 只读取原子计数，无需持有停车场的锁。单独创建后加入的车位节点
+ *          （SLOT_STORAGE_HEAP）本身不计入统计，其文本计入 strings 类别。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收统计快照；lot 为 NULL 时清零。
+ */
+void get_parking_memory_stats(const ParkingLot *lot, ParkingMemoryStats *stats);
+
 /**
  * @brief 创建一个新的停车位对象。
  * @details 为单个停车位分配内存并初始化其属性。新创建的车位状态默认为空闲。
@@ -120,14 +645,57 @@ ParkingSlot *create_parking_slot(int slot_id, const char *location);
  * @brief 将一个已创建的停车位添加到停车场链表中。
  * @param lot 目标停车场。
  * @param slot 要添加的停车位节点。
- * @return 成功返回 0，若参数无效则返回 -1。
+ * @return 成功返回 0，若参数无效则返回 -1，若车位ID已存在返回 -2，
+ * 若索引内存分配失败返回 -3。
  */
 int add_parking_slot(ParkingLot *lot, ParkingSlot *slot);
 
-///@}
+/**
+ * @brief 从停车场自有的内存池中创建一个车位并加入停车场。
+ * @details
+ * 与 create_parking_slot + add_parking_slot 等价，但车位节点取自停车场的
+ * 连续内存池，而不是单独 malloc，全量扫描时缓存局部性更好，
+ * 且 free_parking_lot 可以按区块整体释放。
+ * @param lot 目标停车场。
+ * @param slot_id 要创建的车位的唯一编号。
+ * @param location 车位的物理位置描述。
+ * @return 成功返回 0，若参数无效返回 -1，若车位ID已存在返回 -2，
+ * 若内存分配失败返回 -3。
+ */
+int create_and_add_slot(ParkingLot *lot, int slot_id, const char *location);
+
+/**
+ * @brief 从停车场自有的内存池中批量创建车位并加入停车场。
+ * @details
+ * 编号排序一次完成批内与已有车位的查重，车位表与编号索引按最终规模
+ * 一次预留，之后逐个登记时不再扩容。要么全部添加，要么一个也不添加。
+ * 启用日志时每个车位各记一条添加记录，与逐个添加相同。
+ * @param lot 目标停车场。
+ * @param slot_ids 车位编号数组。
+ * @param locations 与编号一一对应的位置描述数组。
+ * @param count 车位个数。
+ * @param[out] conflict_id 返回 -2 时接收重复的编号，可以为 NULL。
+ * @return 成功返回 0，若参数无效返回 -1，若有编号在批内重复或已存在返回 -2，
+ * 若内存分配失败返回 -3。
+ */
+int create_and_add_slots(ParkingLot *lot, const int *slot_ids,
+                         const char *const *locations, int count,
+                         int *conflict_id);
+
+/**
+ * @brief 将车位节点的热字段同步到停车场的热字段列。
+ * @details 数据层自身的修改已自动同步；只有在外部直接改写了车位节点的
+ * status、type、entry_time 或 resident_due_date 时才需要调用。
+ * @param lot 车位所属的停车场。
+ * @param slot 已加入该停车场的车位节点。
+ * @return 成功返回 0，若参数无效或车位不属于该停车场返回 -1。
+ */
+int sync_slot_hot_fields(ParkingLot *lot, const ParkingSlot *slot);
+
+/** @} */
 
 /** @name 查询函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 根据车位编号查找停车位。
@@ -137,6 +705,27 @@ int add_parking_slot(ParkingLot *lot, ParkingSlot *slot);
  */
 ParkingSlot *find_slot_by_id(ParkingLot *lot, int slot_id);
 
+/**
+ * @brief 取车位的带代号句柄。
+ * @details 句柄由句柄表下标与代号组成，可以长期保存、跨线程传递：
+ *          车位被删除后旧句柄解析为 NULL，而不是指向被复用的节点。
+ *          停车场整体替换（例如重新加载）后，旧句柄在新停车场上
+ *          也几乎不可能碰巧有效，见 SlotHandleTable。
+ * @param lot 车位所属的停车场。
+ * @param slot 已加入该停车场的车位。
+ * @return 车位的句柄；参数无效或车位不在停车场中时返回全零句柄。
+ */
+SlotHandle get_slot_handle(const ParkingLot *lot, const ParkingSlot *slot);
+
+/**
+ * @brief 按句柄查找车位，耗时 O(1)。
+ * @note 返回的指针只在持有停车场的锁期间有效；需要跨锁保存时保存句柄。
+ * @param lot 目标停车场。
+ * @param handle 由 get_slot_handle 取得的句柄。
+ * @return 句柄仍然有效时返回车位，车位已被删除或句柄不属于该停车场时返回 NULL。
+ */
+ParkingSlot *find_slot_by_handle(const ParkingLot *lot, SlotHandle handle);
+
 /**
  * @brief 根据车牌号查找停车位。
  * @param lot 目标停车场。
@@ -145,6 +734,21 @@ ParkingSlot *find_slot_by_id(ParkingLot *lot, int slot_id);
  */
 ParkingSlot *find_slot_by_license(ParkingLot *lot, const char *license_plate);
 
+/**
+ * @brief 按车牌号或车主姓名的子串检索全部在场车辆。
+ * @details 查询串不少于三个字节时使用三元组索引，只核对候选倒排表中的车位；
+ *          更短的查询串（例如单个汉字以外的一两个字符）退化为扫描在场车位。
+ * @param lot 目标停车场。
+ * @param field 检索的字段。
+ * @param query 要查找的子串。
+ * @param[out] slots 接收匹配车位的数组，可以为 NULL。
+ * @param capacity slots 数组的容量。
+ * @return 匹配的车位总数（可能大于 capacity，只写入前 capacity 个）；
+ * 参数无效时返回 -1。
+ */
+int search_slots(ParkingLot *lot, SlotSearchField field, const char *query,
+                 ParkingSlot **slots, int capacity);
+
 /**
  * @brief 根据车主姓名查找停车位（模糊查找）。
  * @param lot 目标停车场。
@@ -153,21 +757,49 @@ ParkingSlot *find_slot_by_license(ParkingLot *lot, const char *license_plate);
  */
 ParkingSlot *find_slot_by_owner(ParkingLot *lot, const char *owner_name);
 
-///@}
+/**
+ * @brief 查找任意一个空闲车位。
+ * @details 按字扫描空闲车位位图，返回稠密车位表中下标最小的空闲车位，
+ * 不分配内存、不访问其他车位节点。正为预约保留的车位（见 reserve_slot）
+ * 会被跳过。
+ * @param lot 目标停车场。
+ * @return 若存在空闲车位，返回其 ParkingSlot 指针；否则返回 NULL。
+ */
+ParkingSlot *find_first_free_slot(ParkingLot *lot);
+
+/**
+ * @brief 按停车类型查找一个可以入场的空闲车位。
+ * @details 居民先取自己空闲的固定车位，再依次取居民池与共享池；访客依次取
+ *          访客池与共享池。各池的空闲位图由数据层同步维护，查找是一次
+ *          按字扫描；不会返回其他类型专用的车位或其他车牌的固定车位，
+ *          为其他车牌预约保留的车位也会被跳过。
+ * @param lot 目标停车场。
+ * @param type 停车类型。
+ * @param license_plate 入场的车牌号，可以为 NULL（不匹配任何固定车位与预约）。
+ * @return 若存在可用车位，返回其 ParkingSlot 指针；否则返回 NULL。
+ */
+ParkingSlot *find_free_slot_for(ParkingLot *lot, ParkingType type,
+                                const char *license_plate);
+
+/** @} */
 
 /** @name 车辆出入场函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 分配一个停车位给车辆（车辆入场）。
+ * @details 入场时间取自停车场的时间源，只读取一次。
  * @param lot 目标停车场。
  * @param slot_id 要分配的车位编号。
  * @param owner_name 车主姓名。
  * @param license_plate 车牌号。
  * @param contact 联系方式。
  * @param type 停车类型 (居民/访客)。
+ * @details VIP 名单中的访客车辆不受访客入场时段限制。
  * @return 返回码：0 成功, -1 参数无效, -2 车位不存在, -3 车位已被占用, -4
- * 该车牌号已在场内, -5 访客车辆在非允许时段入场。
+ * 该车牌号已在场内, -5 访客车辆在非允许时段入场, -6 车牌索引或文本内存分配失败,
+ * -7 车位此时为其他车牌保留（见 reserve_slot）, -8 车牌在禁止入场名单中,
+ * -9 车位属于其他类型的专用池或是其他车牌的固定车位（见 set_slot_pool）。
  */
 int allocate_slot(ParkingLot *lot, int slot_id, const char *owner_name,
                   const char *license_plate, const char *contact,
@@ -182,161 +814,1577 @@ int allocate_slot(ParkingLot *lot, int slot_id, const char *owner_name,
  */
 int deallocate_slot(ParkingLot *lot, int slot_id);
 
-///@}
+/**
+ * @brief 以指定的出场时间释放一个停车位。
+ * @details 供已经读取过当前时刻的调用者（如服务层出场计费）使用，
+ *          保证计费与出场记录使用同一时刻。
+ * @param lot 目标停车场。
+ * @param slot_id 要释放的车位编号。
+ * @param exit_time 出场时间。
+ * @return 返回码同 deallocate_slot。
+ */
+int deallocate_slot_at(ParkingLot *lot, int slot_id, time_t exit_time);
 
-/** @name 列表查询函数 */
-///@{
+/**
+ * @brief 只凭车牌号为常客车辆分配车位（车辆入场）。
+ * @details 车辆出场时，其车主姓名、联系方式、停车类型与所停车位的分区
+ *          记入车辆资料缓存；再次入场时沿用这些资料，优先在上次的分区内
+ *          分配空闲车位，分区内没有空位时分配任意空闲车位。
+ * @param lot 目标停车场。
+ * @param license_plate 车牌号。
+ * @param[out] slot_id 成功时接收分配到的车位编号，可以为 NULL。
+ * @return 0 成功, -1 参数无效, -2 缓存中没有该车牌, -3 没有空闲车位；
+ * 其余返回码同 allocate_slot（-4 至 -8）。
+ */
+int allocate_returning_vehicle(ParkingLot *lot, const char *license_plate,
+                               int *slot_id);
 
 /**
- * @brief 获取所有空闲车位的列表。
+ * @brief 读取缓存中某辆车的资料，不改变缓存的淘汰顺序。
+ * @note 可以在读锁内调用。
  * @param lot 目标停车场。
- * @param[out] count 用于接收空闲车位数量的指针。
- * @return 返回一个动态分配的 ParkingSlot 指针数组。使用后需要调用 free()
- * 释放。如果无空闲车位或内存分配失败，返回 NULL。
+ * @param license_plate 车牌号。
+ * @param[out] session 接收车辆资料。
+ * @return 0 成功, -1 参数无效, -2 缓存中没有该车牌。
  */
-ParkingSlot **get_free_slots(ParkingLot *lot, int *count);
+int find_vehicle_session(const ParkingLot *lot, const char *license_plate,
+                         VehicleSession *session);
 
 /**
- * @brief 获取所有已占用车位的列表。
+ * @brief 设置车辆资料缓存的容量。
+ * @details 容量改变时丢弃已缓存的资料；0 表示不再缓存。
+ * @note 须在写锁内（或单线程）调用。
  * @param lot 目标停车场。
- * @param[out] count 用于接收已占用车位的数量。
- * @return 返回一个动态分配的 ParkingSlot 指针数组。使用后需要调用 free()
- * 释放。如果无已占用车位或内存分配失败，返回 NULL。
+ * @param capacity 最多缓存的车牌数。
+ * @return 0 成功, -1 参数无效。
  */
-ParkingSlot **get_occupied_slots(ParkingLot *lot, int *count);
+int configure_session_cache(ParkingLot *lot, int capacity);
 
 /**
- * @brief 获取所有车位的列表。
+ * @brief 设置请求去重表的容量（见 parking_dedup.h）。
+ * @details 容量改变时丢弃已记住的请求；0 表示不再去重。去重表由网络服务
+ *          在停车场锁之外使用，须在网络服务启动之前或停止之后调用。
  * @param lot 目标停车场。
- * @param[out] count 用于接收找到的车位数量。
- * @return 返回一个动态分配的 ParkingSlot 指针数组。使用后需要调用 free()
- * 释放。如果停车场为空或内存分配失败，返回 NULL。
+ * @param capacity 记住的请求数。
+ * @return 0 成功, -1 参数无效, -3 内存分配失败。
  */
-ParkingSlot **get_all_slots(ParkingLot *lot, int *count);
+int configure_request_log(ParkingLot *lot, int capacity);
 
 /**
- * @brief 按停车时长排序后，获取已占用车辆列表。
+ * @brief 启用或停用供报表线程无锁读取的只读视图（见 parking_view.h）。
+ * @details 启用时立即发布第一份视图；已启用时再次启用不做任何事。
+ *          停用时释放全部视图，须已没有读者 attach。
+ * @note 须在写锁内（或单线程）调用。
  * @param lot 目标停车场。
- * @param[out] count 用于接收已占用车位的数量。
- * @param ascending 是否按升序排列 (1: 升序, 0: 降序)。
- * @return 返回排序后的 ParkingSlot 指针数组。数组使用后需要调用 free() 释放。
+ * @param enabled 非 0 表示启用，0 表示停用。
+ * @return 0 成功, -1 参数无效, -2 仍有读者 attach, -3 内存分配失败。
  */
-ParkingSlot **get_slots_by_duration(ParkingLot *lot, int *count, int ascending);
+int configure_read_view(ParkingLot *lot, int enabled);
 
-///@}
+/**
+ * @brief 把停车场的当前状态复制并发布为新的只读视图。
+ * @details 自上次发布以来没有修改时不复制；多个线程在读锁内并发刷新时，
+ *          只有修改次数最新的一份会被发布。
+ * @note 须在读锁或写锁内调用。
+ * @param lot 目标停车场。
+ * @return 已发布返回 0，视图已是最新返回 1，未启用视图或参数无效返回 -1，
+ *         内存分配失败返回 -3。
+ */
+int refresh_read_view(ParkingLot *lot);
 
-/** @name 计费函数 */
-///@{
+/**
+ * @brief 启用或停用供同机其他进程读取的共享内存发布（见 parking_shm.h）。
+ * @details 启用时创建（或覆盖）共享内存文件并立即发布一次；已启用时改为
+ *          新的文件。停用时解除映射，文件保留最后一次发布的内容。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param path 共享内存文件的路径，NULL 表示停用。
+ * @param capacity 行数上限，0 表示取设计车位数与当前车位数中的较大者。
+ * @return 0 成功, -1 参数无效, -2 无法创建或映射文件。
+ */
+int configure_shared_memory(ParkingLot *lot, const char *path, int capacity);
 
 /**
- * @brief 计算访客车辆的停车费用。
- * @details 根据入场和出场时间计算访客的停车费用。计费规则为按小时向上取整。
- * @param entry_time 车辆入场时间戳。
- * @param exit_time 车辆出场时间戳。
- * @return 计算出的停车费用。
+ * @brief 把停车场的热字段列与计数器发布到共享内存。
+ * @details 自上次发布以来没有修改时不复制。
+ * @note 须在读锁或写锁内调用。
+ * @param lot 目标停车场。
+ * @return 已发布返回 0，没有修改返回 1，未启用或参数无效返回 -1。
  */
-double calculate_visitor_fee(time_t entry_time, time_t exit_time);
+int refresh_shared_memory(ParkingLot *lot);
 
-///@}
+/**
+ * @brief 把停车场挂接到汇总树的一个站点（见 parking_aggregate.h）。
+ * @details 挂接时计入当前的车位数、占用与收入，此后每次变化都在写锁内
+ *          同步到站点、区域与公司。已挂接到其他站点时先解除原挂接。
+ *          释放停车场时自动解除挂接。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param tree 汇总树，须比挂接存活得久；NULL 表示解除挂接。
+ * @param site 站点节点编号，tree 为 NULL 时忽略。
+ * @return 0 成功, -1 参数无效（含 site 不是站点）, -2 站点已挂接其他停车场。
+ */
+int attach_parking_aggregate(ParkingLot *lot, struct ParkingAggregate *tree,
+                             int site);
 
-/** @name 车位信息管理 */
-///@{
+/**
+ * @brief 把停车场的当前值同步到所属的汇总树。
+ * @details 数据层在车位数与占用变化时自动同步；在数据层之外修改收入后
+ *          （如出场计费）须调用本函数。未挂接时不做任何事。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ */
+void sync_parking_aggregate(ParkingLot *lot);
+
+/** @} */
+
+/** @name 预约函数 */
+/** @{ */
 
 /**
- * @brief 更新一个停车位的信息。
- * @param slot 要更新的停车位。
- * @param location 新的位置描述 (如果为NULL则不更新)。
- * @param owner_name 新的车主姓名 (如果为NULL则不更新, 仅在占用时可更新)。
- * @param contact 新的联系方式 (如果为NULL则不更新, 仅在占用时可更新)。
- * @return 成功返回 0，失败（参数为空）返回 -1。
+ * @brief 为车牌预约一个车位的一段时间。
+ * @details 同一车位的预约不能重叠；时段已经开始而车位正被占用时也不能预约。
+ *          预约只保存在内存中，不写入快照与预写日志。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param license_plate 预约的车牌号。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含），必须晚于 start 与当前时间。
+ * @param[out] reservation 接收新预约，可以为 NULL。
+ * @return 0 成功, -1 参数无效, -2 车位不存在, -3 该时段已被预约或车位正被占用,
+ * -6 内存分配失败。
  */
-int update_slot_info(ParkingSlot *slot, const char *location,
-                     const char *owner_name, const char *contact);
+int reserve_slot(ParkingLot *lot, int slot_id, const char *license_plate,
+                 time_t start, time_t end, Reservation *reservation);
 
 /**
- * @brief 从停车场中删除一个车位。
- * @details 只有空闲车位才能被删除。
+ * @brief 在一个分区内预约任意一个该时段空闲的车位。
+ * @details 分区按位置描述的前缀确定（与 slot_query_where_location 相同），
+ *          按稠密车位表顺序选取第一个可用车位。
  * @param lot 目标停车场。
- * @param slot_id 要删除的车位编号。
- * @return 返回码：0 成功, -1 停车场对象为空, -2 车位正在被使用，无法删除, -3
- * 车位不存在。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param license_plate 预约的车牌号。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含），必须晚于 start 与当前时间。
+ * @param[out] reservation 接收新预约（含选中的车位编号），可以为 NULL。
+ * @return 0 成功, -1 参数无效, -2 分区内没有可用车位, -6 内存分配失败。
  */
-int delete_slot(ParkingLot *lot, int slot_id);
+int reserve_zone_slot(ParkingLot *lot, const char *zone,
+                      const char *license_plate, time_t start, time_t end,
+                      Reservation *reservation);
 
-///@}
+/**
+ * @brief 取消一条预约。
+ * @param lot 目标停车场。
+ * @param slot_id 预约的车位编号。
+ * @param reservation_id 预约编号。
+ * @return 0 成功, -1 参数无效, -2 预约不存在（含已入场或已结束被清除的）。
+ */
+int cancel_reservation(ParkingLot *lot, int slot_id, long reservation_id);
 
-/** @name 统计分析函数 */
-///@{
+/**
+ * @brief 查找分区内在 [start, end) 可以预约的第一个车位。
+ * @details 只检查分区内的车位，每个车位只做一次哈希查找与二分查找，
+ *          不遍历其他车位的预约。时段已经开始时，正被占用的车位不可用。
+ * @param lot 目标停车场。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @return 可用的车位；没有或参数无效时返回 NULL。
+ */
+ParkingSlot *find_available_slot(ParkingLot *lot, const char *zone,
+                                 time_t start, time_t end);
 
 /**
- * @brief 统计指定日期内某类型车辆的入场总数。
+ * @brief 统计分区内在 [start, end) 可以预约的车位数。
  * @param lot 目标停车场。
- * @param date 指定的日期 (time_t)。
- * @param type 车辆类型 (居民/访客)。
- * @return 指定日期和类型的车辆入场总数。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @return 可用车位数；参数无效时返回 -1。
  */
-int count_daily_parking(ParkingLot *lot, time_t date, ParkingType type);
+int count_available_slots(ParkingLot *lot, const char *zone, time_t start,
+                          time_t end);
+
+/** @} */
+
+/** @name 分配池与固定车位函数 */
+/** @{ */
 
 /**
- * @brief 统计指定月份内某类型车辆的入场总数。
+ * @brief 设置车位所属的分配池。
+ * @details 分配池只保存在内存中，不写入快照与预写日志；固定车位始终属于
+ *          居民池，不能改为其他池。已在场的车辆不受影响。
  * @param lot 目标停车场。
- * @param year 年份。
- * @param month 月份 (1-12)。
- * @param type 车辆类型 (居民/访客)。
- * @return 指定月份和类型的车辆入场总数。
+ * @param slot_id 车位编号。
+ * @param pool 分配池。
+ * @return 0 成功, -1 参数无效, -2 车位不存在, -3 车位是固定车位。
  */
-int count_monthly_parking(ParkingLot *lot, int year, int month,
-                          ParkingType type);
+int set_slot_pool(ParkingLot *lot, int slot_id, SlotPool pool);
 
 /**
- * @brief 获取指定月份的总收入。
- * @note 此函数当前未实现，仅为示例。实际收入统计在ParkingLot结构体中。
+ * @brief 为居民车牌登记固定车位。
+ * @details 车位随之划入居民池，此后只接纳该车牌；车牌已有固定车位时改为
+ *          新车位，原车位回到居民池的空闲位图。只保存在内存中。
  * @param lot 目标停车场。
- * @param year 年份。
- * @param month 月份 (1-12)。
- * @return 当月的总收入。
+ * @param license_plate 居民车牌号。
+ * @param slot_id 车位编号。
+ * @return 0 成功, -1 参数无效, -2 车位不存在, -3 车位是其他车牌的固定车位
+ * 或正被其他车辆占用, -6 内存分配失败。
  */
-double get_monthly_payment_total(ParkingLot *lot, int year, int month);
+int assign_home_slot(ParkingLot *lot, const char *license_plate, int slot_id);
 
-///@}
+/**
+ * @brief 撤销居民车牌的固定车位，车位留在居民池。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @return 原固定车位的编号；参数无效或未登记返回 0。
+ */
+int release_home_slot(ParkingLot *lot, const char *license_plate);
 
-/** @name 数据持久化函数 */
-///@{
+/**
+ * @brief 查找居民车牌的固定车位。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @return 固定车位的编号；参数无效或未登记返回 0。
+ */
+int find_home_slot(const ParkingLot *lot, const char *license_plate);
+
+/** @} */
+
+/** @name 车位布局函数 */
+/** @{ */
 
 /**
- * @brief 将停车场的所有数据保存到文本文件。
- * @param lot 要保存的停车场。
- * @param filename 目标文件名。
- * @return 成功返回 0，失败（文件无法打开）返回 -1。
+ * @brief 登记或修改车位的平面坐标。
+ * @details 坐标单位由使用者约定（例如分米）。登记后空间索引在下一次
+ *          查找最近空闲车位前重建。布局只保存在内存中，不写入快照与预写日志。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 0 成功, -1 参数无效, -2 车位不存在, -3 内存分配失败。
  */
-int save_parking_data(ParkingLot *lot, const char *filename);
+int set_slot_position(ParkingLot *lot, int slot_id, long x, long y);
 
 /**
- * @brief 从文本文件中加载停车场数据。
- * @param filename 源文件名。
+ * @brief 清除车位的平面坐标，之后查找最近空闲车位时不再考虑它。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @return 0 成功, -1 参数无效, -2 车位没有登记坐标。
+ */
+int clear_slot_position(ParkingLot *lot, int slot_id);
+
+/**
+ * @brief 读取车位的平面坐标。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param[out] x 接收横坐标。
+ * @param[out] y 接收纵坐标。
+ * @return 0 成功, -1 参数无效, -2 车位没有登记坐标。
+ */
+int get_slot_position(const ParkingLot *lot, int slot_id, long *x, long *y);
+
+/**
+ * @brief 登记或修改一个命名地标（入口、电梯等）的坐标。
+ * @param lot 目标停车场。
+ * @param name 地标名称，长度须小于 LAYOUT_MAX_LANDMARK_NAME。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 0 成功, -1 参数无效, -3 内存分配失败。
+ */
+int set_parking_landmark(ParkingLot *lot, const char *name, long x, long y);
+
+/**
+ * @brief 查询空间索引是否需要在查找前重建。
+ * @param lot 目标停车场。
+ * @return 登记过坐标且有变化尚未重建返回 1，否则返回 0。
+ */
+int slot_layout_stale(const ParkingLot *lot);
+
+/**
+ * @brief 坐标有变化时重建空间索引。
+ * @details 须持有写锁。
+ * @param lot 目标停车场。
+ * @return 0 成功或无需重建, -1 参数无效, -3 内存分配失败。
+ */
+int refresh_slot_layout(ParkingLot *lot);
+
+/**
+ * @brief 查找离某一点最近的空闲车位。
+ * @details 只考虑登记了坐标的车位，距离相同时取编号较小的车位；
+ *          正为预约保留的车位会被跳过。空间索引记录每棵子树的空闲车位数，
+ *          入场出场时以 O(log n) 更新，查找通常只访问对数个车位。
+ *          索引过期时先重建，此时须持有写锁（服务层会先调用
+ *          refresh_slot_layout，再在读锁内查找）。
+ * @param lot 目标停车场。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 最近的空闲车位；没有、参数无效或重建索引内存不足时返回 NULL。
+ */
+ParkingSlot *find_nearest_free_slot(ParkingLot *lot, long x, long y);
+
+/**
+ * @brief 查找离命名地标最近的空闲车位。
+ * @param lot 目标停车场。
+ * @param landmark 地标名称。
+ * @return 最近的空闲车位；地标不存在或没有空闲车位时返回 NULL。
+ */
+ParkingSlot *find_nearest_free_slot_to(ParkingLot *lot, const char *landmark);
+
+/** @} */
+
+/** @name 分区统计函数 */
+/** @{ */
+
+/**
+ * @brief 登记一个分区，此后增量维护其车位总数与空闲数。
+ * @details 登记时扫描一遍车位表计算初始计数；分区已登记时什么也不做。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀（如 "B1-"）。
+ * @return 0 成功, -1 参数无效, -3 内存分配失败。
+ */
+int add_parking_zone(ParkingLot *lot, const char *prefix);
+
+/**
+ * @brief 撤销一个分区。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @return 0 成功, -1 参数无效, -2 分区未登记。
+ */
+int remove_parking_zone(ParkingLot *lot, const char *prefix);
+
+/**
+ * @brief 读取一个分区的计数，O(分区数)，不扫描车位。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @param[out] stats 接收分区计数。
+ * @return 0 成功, -1 参数无效, -2 分区未登记。
+ */
+int get_parking_zone_stats(const ParkingLot *lot, const char *prefix,
+                           ParkingZoneStats *stats);
+
+/**
+ * @brief 按登记顺序读取全部分区的计数。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收分区计数的数组，max 为 0 时可以为 NULL。
+ * @param max 数组容量。
+ * @return 已登记的分区数（可能大于 max，此时只写入前 max 个），
+ *         参数无效返回 -1。
+ */
+int list_parking_zone_stats(const ParkingLot *lot, ParkingZoneStats *stats,
+                            int max);
+
+/**
+ * @brief 读取一个分区（或整个停车场）15、30、60 分钟后的预测占用数。
+ * @details 预测的占用率变化在刻钟切换时已算好并缓存，本函数只做一次
+ *          乘加，不扫描画像与车位，可以在读锁内调用。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀，NULL 或空串表示整个停车场。
+ * @param[out] forecast 接收预测结果。
+ * @return 0 成功, -1 参数无效, -2 分区未登记。
+ */
+int get_parking_forecast(const ParkingLot *lot, const char *prefix,
+                         ParkingForecast *forecast);
+
+/**
+ * @brief 注册分区计数变化的处理函数。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param handler 处理函数，NULL 表示不再通知。
+ * @param ctx 透传给处理函数的上下文指针。
+ */
+void set_parking_zone_handler(ParkingLot *lot, ParkingZoneHandler handler,
+                              void *ctx);
+
+/** @} */
+
+/** @name 变更订阅函数 */
+/** @{ */
+
+/**
+ * @brief 新增一个车位变更的订阅者。
+ * @details 此后每次添加、删除车位，入场、出场，修改信息或同步热字段后，
+ *          数据层都向该订阅者的环形队列追加一条 ParkingChange；
+ *          队列满时丢弃新事件并计数，修改本身从不等待订阅者。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param capacity 队列至少能容纳的事件数，0 表示 CHANGE_FEED_DEFAULT_CAPACITY。
+ * @return 成功返回订阅者，参数无效或内存不足返回 NULL。
+ */
+struct ChangeSubscription *subscribe_slot_changes(ParkingLot *lot,
+                                                  size_t capacity);
+
+/**
+ * @brief 撤销一个订阅者并释放其队列。
+ * @note 须在写锁内调用，且该订阅者的消费者已停止取事件。
+ * @param lot 目标停车场。
+ * @param subscription 要撤销的订阅者。
+ * @return 0 成功, -1 参数无效, -2 订阅者不属于该停车场。
+ */
+int unsubscribe_slot_changes(ParkingLot *lot,
+                             struct ChangeSubscription *subscription);
+
+/**
+ * @brief 按顺序取出订阅者队列中的事件。
+ * @details 不需要停车场的锁，可以与修改并发进行；
+ *          每个订阅者同一时刻只能有一个线程调用。
+ * @param subscription 订阅者。
+ * @param[out] changes 接收事件的数组。
+ * @param max 数组容量。
+ * @return 取出的事件数，参数无效返回 -1。
+ */
+int poll_slot_changes(struct ChangeSubscription *subscription,
+                      ParkingChange *changes, int max);
+
+/**
+ * @brief 取走并清零订阅者因队列满丢弃的事件数。
+ * @details 返回值大于 0 时增量已不完整，消费者应重新读取完整列表。
+ * @param subscription 订阅者。
+ * @return 上次调用以来丢弃的事件数，参数无效返回 -1。
+ */
+int take_dropped_slot_changes(struct ChangeSubscription *subscription);
+
+/** @} */
+
+/** @name 列表查询函数 */
+/** @{ */
+
+/**
+ * @brief 获取所有空闲车位的列表。
+ * @param lot 目标停车场。
+ * @param[out] count 用于接收空闲车位数量的指针。
+ * @return 返回一个动态分配的 ParkingSlot 指针数组。使用后需要调用 free()
+ * 释放。如果无空闲车位或内存分配失败，返回 NULL。
+ */
+ParkingSlot **get_free_slots(ParkingLot *lot, int *count);
+
+/**
+ * @brief 获取所有已占用车位的列表。
+ * @param lot 目标停车场。
+ * @param[out] count 用于接收已占用车位的数量。
+ * @return 返回一个动态分配的 ParkingSlot 指针数组。使用后需要调用 free()
+ * 释放。如果无已占用车位或内存分配失败，返回 NULL。
+ */
+ParkingSlot **get_occupied_slots(ParkingLot *lot, int *count);
+
+/**
+ * @brief 获取所有车位的列表。
+ * @param lot 目标停车场。
+ * @param[out] count 用于接收找到的车位数量。
+ * @return 返回一个动态分配的 ParkingSlot 指针数组。使用后需要调用 free()
+ * 释放。如果停车场为空或内存分配失败，返回 NULL。
+ */
+ParkingSlot **get_all_slots(ParkingLot *lot, int *count);
+
+/**
+ * @brief 按停车时长排序后，获取已占用车辆列表。
+ * @details 直接按入场时间链表的顺序输出，不做排序。
+ * @param lot 目标停车场。
+ * @param[out] count 用于接收已占用车位的数量。
+ * @param ascending 是否按升序排列 (1: 升序, 0: 降序)。
+ * @return 返回排序后的 ParkingSlot 指针数组。数组使用后需要调用 free() 释放。
+ */
+ParkingSlot **get_slots_by_duration(ParkingLot *lot, int *count, int ascending);
+
+/**
+ * @brief 取出停车时长最长（或最短）的前 k 个在场车位。
+ * @details 从入场时间链表的一端顺序读取，耗时 O(k)，不分配内存。
+ * @param lot 目标停车场。
+ * @param[out] slots 调用者提供的数组，至少能容纳 limit 个指针。
+ * @param limit 最多取出的车位数。
+ * @param longest_first 非 0 时从停得最久的车位开始，否则从最近入场的开始。
+ * @return 实际写入的车位数；参数无效时返回 0。
+ */
+int get_slots_by_entry_order(ParkingLot *lot, ParkingSlot **slots, int limit,
+                             int longest_first);
+
+/**
+ * @brief 取出停车时长最长的前 k 辆车及其停车时长。
+ * @details 从入场时间链表的最早一端读取，耗时 O(k)；
+ *          整次查询只读取一次当前时间，所有时长都相对同一时刻计算。
+ * @param lot 目标停车场。
+ * @param k 最多取出的车辆数。
+ * @param[out] out 调用者提供的数组，至少能容纳 k 项。
+ * @return 实际写入的项数；参数无效时返回 0。
+ */
+int get_longest_parked(ParkingLot *lot, int k, ParkedVehicle *out);
+
+/**
+ * @brief 按月费到期时间从早到晚取出到期时间落在 [from, to) 内的居民车位。
+ * @details 读取数据层维护的月费到期最小堆，不扫描整个停车场：
+ *          “截至 T 已逾期的全部居民”即 from = 0、to = T；
+ *          “从现在起最近的 N 个到期日”即 from = 当前时间、to = 0、limit = N。
+ *          只有设置了到期时间的居民车位（无论是否在场）参与排序。
+ * @param lot 目标停车场。
+ * @param from 到期时间下界（含）。
+ * @param to 到期时间上界（不含），小于等于 0 表示不设上界。
+ * @param[out] slots 调用者提供的数组，至少能容纳 limit 个指针。
+ * @param limit 最多取出的车位数。
+ * @return 实际写入的车位数；参数无效返回 -1，内存不足返回 -3。
+ */
+int get_slots_by_due_date(ParkingLot *lot, time_t from, time_t to,
+                          ParkingSlot **slots, int limit);
+
+/**
+ * @brief 获取登记在月费到期堆中的居民车位数。
+ * @details 即设置了到期时间的居民车位数，可用于为 get_slots_by_due_date
+ *          分配结果数组。
+ * @param lot 目标停车场。
+ * @return 车位数；lot 为 NULL 时返回 0。
+ */
+int count_due_slots(const ParkingLot *lot);
+
+/** @} */
+
+/** @name 遍历函数 */
+/** @{ */
+
+/**
+ * @brief 获取满足筛选条件的车位数量。
+ * @details 直接读取停车场的计数器，时间复杂度为常数级。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @return 满足条件的车位数量；若 `lot` 为 NULL 返回 0。
+ */
+int count_slots(const ParkingLot *lot, SlotFilter filter);
+
+/**
+ * @brief 初始化车位游标。
+ * @param cursor 要初始化的游标（通常在栈上声明）。
+ * @param lot 要遍历的停车场。
+ * @param filter 筛选条件。
+ */
+void slot_cursor_init(SlotCursor *cursor, ParkingLot *lot, SlotFilter filter);
+
+/**
+ * @brief 取出游标的下一个匹配车位。
+ * @param cursor 已初始化的游标。
+ * @return 下一个匹配的车位；遍历结束时返回 NULL。
+ */
+ParkingSlot *slot_cursor_next(SlotCursor *cursor);
+
+/**
+ * @brief 把游标定位到第 offset 个匹配车位。
+ * @details 全部车位直接按下标定位；空闲与已占用车位借助空闲位图逐字统计
+ *          置位数跳过整字，不逐个检查车位状态。定位后 slot_cursor_next
+ *          返回第 offset 个（0 起）匹配车位。
+ * @param cursor 已初始化的游标。
+ * @param offset 要跳过的匹配车位数。
+ * @return 成功返回 0；offset 为负数或不小于匹配车位数时游标移到末尾并返回 -1。
+ */
+int slot_cursor_seek(SlotCursor *cursor, int offset);
+
+/**
+ * @brief 分页读取满足筛选条件的车位。
+ * @details 用 slot_cursor_seek 直接定位到第 offset 个匹配车位，
+ *          写满 limit 个后立即停止，不遍历整个停车场。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param offset 跳过的匹配车位数。
+ * @param[out] slots 调用者提供的数组，至少能容纳 limit 个指针。
+ * @param limit 最多读取的车位数。
+ * @return 实际写入的车位数；参数无效或 offset 超出范围时返回 0。
+ */
+int get_slots_page(ParkingLot *lot, SlotFilter filter, int offset,
+                   ParkingSlot **slots, int limit);
+
+/**
+ * @brief 按稠密车位表顺序对每个匹配车位调用回调函数。
+ * @details 不分配任何内存；回调返回非 0 时提前停止。
+ *          遍历期间的限制与 SlotCursor 相同。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param visitor 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 已调用回调的次数；若参数无效返回 -1。
+ */
+int parking_lot_foreach(ParkingLot *lot, SlotFilter filter,
+                        SlotVisitor visitor, void *ctx);
+
+/** @} */
+
+/** @name 计费函数 */
+/** @{ */
+
+/**
+ * @brief 按默认费率计算访客车辆的停车费用。
+ * @details 不考虑停车场配置的费率表，按小时向上取整后乘以默认小时费率。
+ *          出场计费请使用 calculate_visitor_fee_cents；缴费机报价（含居民
+ *          补缴）请使用服务层的 parking_service_quote_exit。
+ * @param entry_time 车辆入场时间戳。
+ * @param exit_time 车辆出场时间戳。
+ * @return 计算出的停车费用（元）。
+ */
+double calculate_visitor_fee(time_t entry_time, time_t exit_time);
+
+/**
+ * @brief 只替换停车场运行时配置中的费率表。
+ * @details 以当前配置为基础复制一份、换上新的费率配置并编译，
+ *          再经 publish_parking_config 发布；之后的出场计费只查表。
+ * @param lot 目标停车场。
+ * @param config 费率配置，NULL 表示恢复默认费率。
+ * @return 成功返回 0；参数无效或配置无效返回 -1，内存不足返回 -2，
+ *         此时原配置不变。
+ */
+int configure_parking_tariff(ParkingLot *lot, const TariffConfig *config);
+
+/**
+ * @brief 按停车场的费率表计算访客车辆的停车费用。
+ * @details 首小时、夜间时段按入场时刻所在的本地小时确定。
+ * @param lot 目标停车场。
+ * @param entry_time 车辆入场时间戳。
+ * @param exit_time 车辆出场时间戳。
+ * @param[out] billed_hours 接收计费小时数，可以为 NULL。
+ * @return 停车费用（分）；出场时间不晚于入场时间时返回 0。
+ */
+long calculate_visitor_fee_cents(ParkingLot *lot, time_t entry_time,
+                                 time_t exit_time, int *billed_hours);
+
+/**
+ * @brief 按停车场的费率表计算居民逾期补缴的月费。
+ * @param lot 目标停车场。
+ * @param due_date 月费到期时间。
+ * @param now 当前时刻。
+ * @param[out] periods 接收补缴的周期数，可以为 NULL。
+ * @return 补缴费用（分）；未逾期时返回 0。
+ */
+long calculate_resident_fee_cents(const ParkingLot *lot, time_t due_date,
+                                  time_t now, int *periods);
+
+/** @} */
+
+/** @name 车位信息管理 */
+/** @{ */
+
+/**
+ * @brief 更新一个停车位的信息。
+ * @param slot 要更新的停车位。
+ * @param location 新的位置描述 (如果为NULL则不更新)。
+ * @param owner_name 新的车主姓名 (如果为NULL则不更新, 仅在占用时可更新)。
+ * @param contact 新的联系方式 (如果为NULL则不更新, 仅在占用时可更新)。
+ * @return 成功返回 0，失败（参数为空）返回 -1，文本内存不足返回 -2
+ * （此时未能写入的字段保持原值）。
+ */
+int update_slot_info(ParkingSlot *slot, const char *location,
+                     const char *owner_name, const char *contact);
+
+/**
+ * @brief 按编号更新停车场中一个车位的信息，并写入预写日志。
+ * @details 字段规则与 update_slot_info 相同；启用日志的停车场应使用本函数，
+ * 直接调用 update_slot_info 的修改不会被记录。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param location 新的位置描述 (如果为NULL则不更新)。
+ * @param owner_name 新的车主姓名 (如果为NULL则不更新, 仅在占用时可更新)。
+ * @param contact 新的联系方式 (如果为NULL则不更新, 仅在占用时可更新)。
+ * @return 成功返回 0，参数无效返回 -1，车位不存在返回 -2，文本内存不足返回 -3。
+ */
+int update_slot_info_in_lot(ParkingLot *lot, int slot_id, const char *location,
+                            const char *owner_name, const char *contact);
+
+/**
+ * @brief 从停车场中删除一个车位。
+ * @details 只有空闲车位才能被删除。
+ * @param lot 目标停车场。
+ * @param slot_id 要删除的车位编号。
+ * @return 返回码：0 成功, -1 停车场对象为空, -2 车位正在被使用，无法删除, -3
+ * 车位不存在。
+ */
+int delete_slot(ParkingLot *lot, int slot_id);
+
+/**
+ * @brief 分步整理车位内存池，把稀疏区块中的车位迁走并释放这些区块。
+ * @details
+ * 每次调用最多检查 budget 个节点，调用者持有写锁，反复调用直到返回 0；
+ * 两次调用之间可以释放写锁，入场、出场与增删车位照常进行。
+ * 迁移后车位的编号、句柄与全部状态不变，但节点地址改变：
+ * 调用者此前取得的 ParkingSlot 指针随之失效，需要长期引用车位时
+ * 应使用 get_slot_handle。写时复制快照进行中时不迁移任何车位。
+ * 一轮整理结束、没有可腾空的区块时，稠密车位表与热字段列
+ * 也按车位数收缩。
+ * @param lot 目标停车场。
+ * @param budget 本次最多检查的节点数，须大于 0。
+ * @return 还有剩余工作返回 1，整理完毕返回 0，参数无效返回 -1，
+ *         快照进行中返回 -2（稍后重试），内存不足返回 -3（进度保留）。
+ */
+int compact_parking_slots(ParkingLot *lot, int budget);
+
+/** @} */
+
+/** @name 统计分析函数 */
+/** @{ */
+
+/**
+ * @brief 统计指定日期内某类型车辆的入场总数。
+ * @details 读取数据层在入场时累加的按日计数，耗时 O(1)，
+ *          已出场的车辆同样计入；计数只保存在内存中，
+ *          从文件加载后只包含加载时仍在场的车辆。
+ * @param lot 目标停车场。
+ * @param date 指定的日期 (time_t)。
+ * @param type 车辆类型 (居民/访客)。
+ * @return 指定日期和类型的车辆入场总数。
+ */
+int count_daily_parking(ParkingLot *lot, time_t date, ParkingType type);
+
+/**
+ * @brief 统计指定月份内某类型车辆的入场总数。
+ * @details 读取按月计数，规则与 count_daily_parking 相同。
+ * @param lot 目标停车场。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @param type 车辆类型 (居民/访客)。
+ * @return 指定月份和类型的车辆入场总数。
+ */
+int count_monthly_parking(ParkingLot *lot, int year, int month,
+                          ParkingType type);
+
+/**
+ * @brief 获取指定月份的总收入。
+ * @details 读取收费台账的月表，耗时 O(1)；台账在启用前的收费不计入。
+ * @param lot 目标停车场。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @return 当月的总收入；未启用台账时返回 0.0，参数无效返回 -1.0。
+ */
+double get_monthly_payment_total(ParkingLot *lot, int year, int month);
+
+/**
+ * @brief 使当日与当月收入进入 now 所在的周期。
+ * @details 记录的日期（月份）与 now 不同时先清零金额、再发布新的日期编号，
+ *          无锁读者按相反顺序读取，不会把旧周期的金额算进新周期。
+ *          出场计费前与每个本地 0 点的日切定时器都会调用。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param now 当前时刻。
+ */
+void update_revenue_cycle(ParkingLot *lot, time_t now);
+
+/**
+ * @brief 把一笔收入计入滚动汇总的小时桶与日桶。
+ * @details 入场与出场次数由数据层在车位状态变化时自动计入，收入则由
+ *          计费的调用者（服务层的出场与月费结算）计入；每次计入是 O(1) 的。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param type 付费车辆的停车类型。
+ * @param when 收费时刻。
+ * @param cents 金额（分），为 0 时忽略。
+ */
+void record_revenue_rollup(ParkingLot *lot, ParkingType type, time_t when,
+                           long cents);
+
+/**
+ * @brief 把停车场某个周期的不同车辆草图合并进另一个草图。
+ * @details 入场时车牌（与车牌索引相同，按车牌编码散列）计入当周与
+ *          当月的草图；把多个分区或停车场的草图合并进同一个
+ *          草图后估计，即得到它们合计的不同车辆数，同一辆车只计一次。
+ * @note 须在读锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param period 周期。
+ * @param now 作为“本周”“本月”基准的时刻。
+ * @param[in,out] into 接收合并结果的草图。
+ * @return 该周期有入场记录返回 1，没有返回 0，参数无效返回 -1。
+ */
+int merge_distinct_vehicles(const ParkingLot *lot, DistinctPeriod period,
+                            time_t now, HyperLogLog *into);
+
+/** @} */
+
+/** @name 数据持久化函数 */
+/** @{ */
+
+/**
+ * @brief 将停车场的所有数据保存到文本文件。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 成功返回 0，失败（文件无法打开）返回 -1。
+ */
+int save_parking_data(ParkingLot *lot, const char *filename);
+
+/**
+ * @brief 从文件中加载停车场数据。
+ * @details 根据文件开头的魔数自动识别二进制快照与 `LOT|` 文本格式；
+ * 快照优先通过内存映射加载，映射不可用时退回普通读取。
+ * @param filename 源文件名。
  * @return 成功时返回重建的 ParkingLot 指针；失败（文件不存在或格式错误）时返回
  * NULL。
  */
-ParkingLot *load_parking_data(const char *filename);
+ParkingLot *load_parking_data(const char *filename);
+
+/**
+ * @brief 将停车场的所有数据保存为二进制快照。
+ * @details
+ * 快照由固定 40 字节的文件头、页表和 slot_count 条定长记录组成，
+ * 所有整数按小端序写出。记录按 SNAPSHOT_PAGE_ROWS 条分页，
+ * 页表依次存放每页记录的校验和，文件头带有页表与文件头自身的校验和，
+ * 因此各页可以由不同线程独立校验、解码。
+ * 整个文件在内存中编码后一次 fwrite 写出。
+ *
+ * 快照写出后，另在文件名加 INDEX_IMAGE_SUFFIX 处写出索引映像：编号索引与
+ * 车牌索引的桶布局和在场车位的入场顺序，以记录下标代替节点指针保存。
+ * 映像的 48 字节文件头依次是魔数 INDEX_IMAGE_MAGIC、格式版本、文件头字节数、
+ * 快照代号（所属快照文件头的校验和）、记录条数、编号索引桶数、车牌索引桶数、
+ * 车牌数、入场顺序项数、映像体校验和与文件头自身的校验和；映像体依次是
+ * 编号索引桶（每桶 4 字节）、车牌索引桶（每桶 12 字节）与入场顺序（每项
+ * 4 字节）。加载快照时若映像的代号与快照相符且校验通过，就直接按映像
+ * 建立这些索引，不再逐个散列、排序；否则照常重建。映像只是加速用的
+ * 副本，写不出时不影响快照本身，本函数照常返回快照的写入结果。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 成功返回 0，若参数无效或文件写入失败返回 -1，内存不足返回 -2。
+ */
+int save_parking_snapshot(ParkingLot *lot, const char *filename);
+
+/**
+ * @brief 将停车场的所有数据保存为各页压缩的二进制快照。
+ * @details
+ * 文件头与 save_parking_snapshot 相同，只是格式版本为 3；页表每项 8 字节，
+ * 依次是该页压缩后的字节数与压缩前记录的校验和，之后各页的压缩数据首尾相接。
+ * 每页以 parking_compress.h 的块格式单独压缩，不引用其他页，
+ * 因此加载时各页仍由多个线程独立解压、校验；压缩后不比原文小的页原样存放。
+ * 各个加载函数自动识别该版本。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 成功返回 0，若参数无效或文件写入失败返回 -1，内存不足返回 -2。
+ */
+int save_parking_snapshot_compressed(ParkingLot *lot, const char *filename);
+
+/**
+ * @brief 写出增量检查点：只保存自上次完整检查点以来被修改过的页。
+ * @details
+ * 尚无基准、或脏页超过当前页数的 SNAPSHOT_DELTA_MAX_PERCENT% 时，
+ * 把完整快照（格式同 save_parking_snapshot）写到 base_path、删除 delta_path，
+ * 并以它作为新的基准；否则只把脏页写到 delta_path，基准文件不动。
+ *
+ * 增量文件由 36 字节的文件头、清单和各脏页的记录组成：文件头依次是魔数
+ * SNAPSHOT_DELTA_MAGIC、格式版本、基准文件头的校验和、总车位数、记录条数、
+ * 清单项数、清单校验和与文件头自身的校验和；清单每项 8 字节，依次是页号
+ * 与该页记录的校验和，页号严格递增；记录与快照文件中的记录格式相同。
+ * 增量相对于基准累计，每次覆盖上一个增量文件，因此检查点的写入量
+ * 只与两次完整检查点之间的修改量有关，与车位总数无关。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 要保存的停车场。
+ * @param base_path 完整快照的路径。
+ * @param delta_path 增量文件的路径。
+ * @return 写出完整快照返回 0，写出增量返回 1；参数无效或文件写入失败返回 -1，
+ *         内存不足返回 -2。
+ */
+int save_parking_checkpoint(ParkingLot *lot, const char *base_path,
+                            const char *delta_path);
+
+/**
+ * @brief 开始一次写时复制快照。
+ * @details 复制稠密车位表的指针并分配编码缓冲区，耗时与车位数成正比
+ *          但不编码任何记录。同一停车场同时只能有一个进行中的快照。
+ * @note 须在写锁内调用。
+ * @param lot 目标停车场。
+ * @param[out] snapshot 调用者提供的快照对象。
+ * @return 成功返回 0；参数无效或已有进行中的快照返回 -1；内存不足返回 -2。
+ */
+int begin_parking_snapshot(ParkingLot *lot, ParkingSnapshot *snapshot);
+
+/**
+ * @brief 编码快照中尚未编码的页。
+ * @details 保存线程可以分多次调用，每次之间释放读锁让写者继续工作。
+ * @note 须在读锁（或写锁）内调用。
+ * @param lot 快照所属的停车场。
+ * @param snapshot 进行中的快照。
+ * @param max_pages 本次最多编码的页数，不为正表示全部。
+ * @return 仍未编码的页数；参数无效返回 -1。
+ */
+int fill_parking_snapshot(ParkingLot *lot, ParkingSnapshot *snapshot,
+                          int max_pages);
+
+/**
+ * @brief 在修改车位字段之前，把车位所在页按修改前的内容编码进快照。
+ * @details 数据层的入场、出场、修改信息与删除车位已自动调用；
+ *          在数据层之外直接修改车位节点字段时，须在修改前调用。
+ *          同时把该页记为增量检查点的脏页；没有进行中的快照时只做这一步。
+ * @note 须在写锁内调用。
+ * @param lot 车位所属的停车场。
+ * @param slot 即将被修改的车位。
+ */
+void preserve_slot_snapshot(ParkingLot *lot, const ParkingSlot *slot);
+
+/**
+ * @brief 把编码完成的快照写成二进制快照文件。
+ * @details 文件格式与 save_parking_snapshot 相同。不访问停车场，无需加锁。
+ * @param snapshot 全部页已编码的快照。
+ * @param filename 目标文件名。
+ * @return 成功返回 0；参数无效、仍有未编码的页或文件写入失败返回 -1。
+ */
+int write_parking_snapshot(ParkingSnapshot *snapshot, const char *filename);
+
+/**
+ * @brief 把编码完成的快照逐页压缩后写成二进制快照文件。
+ * @details 文件格式与 save_parking_snapshot_compressed 相同。
+ *          压缩缓冲区取自快照的内存对象；不访问停车场，无需加锁。
+ * @param snapshot 全部页已编码的快照。
+ * @param filename 目标文件名。
+ * @return 成功返回 0；参数无效、仍有未编码的页或文件写入失败返回 -1；
+ *         内存不足返回 -2。
+ */
+int write_parking_snapshot_compressed(ParkingSnapshot *snapshot,
+                                      const char *filename);
+
+/**
+ * @brief 补全快照的文件头，取得与二进制快照文件逐字节相同的内容。
+ * @details 返回的字节属于快照，end_parking_snapshot 之后失效。
+ *          不访问停车场，无需加锁。
+ * @param snapshot 全部页已编码的快照。
+ * @param[out] size 接收字节数。
+ * @return 成功返回快照内容；参数无效或仍有未编码的页返回 NULL。
+ */
+const unsigned char *parking_snapshot_bytes(ParkingSnapshot *snapshot,
+                                            size_t *size);
+
+/**
+ * @brief 把编码完成的快照写成 `LOT|` 文本文件。
+ * @details 文件格式与 save_parking_data 相同。不访问停车场，无需加锁。
+ * @param snapshot 全部页已编码的快照。
+ * @param filename 目标文件名。
+ * @return 成功返回 0；参数无效、仍有未编码的页或文件写入失败返回 -1。
+ */
+int write_parking_snapshot_text(const ParkingSnapshot *snapshot,
+                                const char *filename);
+
+/**
+ * @brief 结束快照并释放其缓冲区。
+ * @note 须在写锁内调用；未注册到停车场的快照也可以用它释放。
+ * @param lot 快照所属的停车场。
+ * @param snapshot 要结束的快照。
+ */
+void end_parking_snapshot(ParkingLot *lot, ParkingSnapshot *snapshot);
+
+/**
+ * @brief 从二进制快照中加载停车场数据。
+ * @details 文件头与页表校验通过后，记录区一次 fread 读入缓冲区；
+ * 随后按处理器数（最多 8 个线程）分段并行校验各页并解码到车位内存池，
+ * 最后单线程按预留好的容量批量登记各个索引。
+ * 也接受没有页表、整个记录区一个校验和的版本 1 快照，以及各页压缩的
+ * 版本 3 快照（先并行解压各页，再照常解码）。
+ * @param filename 源文件名。
+ * @return 成功时返回重建的 ParkingLot 指针；文件不存在、版本不支持、
+ * 校验失败或内存不足时返回 NULL。
+ */
+ParkingLot *load_parking_snapshot(const char *filename);
+
+/**
+ * @brief 通过内存映射加载二进制快照。
+ * @details
+ * 将快照文件只读映射到内存（POSIX 使用 mmap，Windows 使用 MapViewOfFile），
+ * 在映射上直接校验并解码记录，省去读缓冲区的分配与整块复制，
+ * 由操作系统按需调页。加载完成后立即解除映射，返回的停车场不依赖该文件。
+ * @param filename 源文件名。
+ * @return 成功时返回重建的 ParkingLot 指针；映射失败、文件不是有效快照
+ * 或内存不足时返回 NULL。
+ */
+ParkingLot *load_parking_snapshot_mapped(const char *filename);
+
+/**
+ * @brief 通过内存映射加载二进制快照，新停车场使用指定的分配函数。
+ * @details 与 load_parking_snapshot_mapped 相同，只是重建的停车场经由
+ *          allocator 分配，供停车场注册表让托管的各停车场共用一组分配函数。
+ * @param filename 源文件名。
+ * @param allocator 分配函数，NULL 表示 C 标准库；内容会被复制。
+ * @return 成功时返回重建的 ParkingLot 指针；映射失败、文件不是有效快照
+ * 或内存不足时返回 NULL。
+ */
+ParkingLot *load_parking_snapshot_with_allocator(
+    const char *filename, const ParkingAllocator *allocator);
+
+/**
+ * @brief 延迟加载二进制快照：热字段立即解码，冷文本留在文件映射中。
+ * @details
+ * 车位编号、状态、时间等热字段与位置描述照常解码到车位内存池与热字段列；
+ * 车主姓名、车牌号、联系方式不再复制到文本内存池，而是直接指向只读映射中
+ * 的记录，由操作系统在第一次访问时调页，内存紧张时也可以直接丢弃这些
+ * 干净页而无需写回交换区。映射随停车场一起保留，free_parking_lot 时解除。
+ * 之后修改的字段照常复制到文本内存池，被替换的映射文本不会被归还。
+ *
+ * 记录是热、冷字段交错的定长行，页校验仍要读一遍记录区，因此节省的是
+ * 常驻的堆内存与逐字段复制，而不是读入的字节数；车牌号与车主姓名在登记
+ * 索引时就会被访问。各页压缩的快照没有可借用的原文，照常解压复制，
+ * 并且不保留映射。
+ * @note 停车场存活期间不得原地改写或截断该文件（本模块的各保存函数都先写
+ *       临时文件再替换，不受影响）；Windows 下映射中的文件不能被替换，
+ *       需要保存回同一路径时请使用 load_parking_snapshot_mapped。
+ * @param filename 源文件名。
+ * @return 成功时返回重建的 ParkingLot 指针；映射失败、文件不是有效快照
+ * 或内存不足时返回 NULL。
+ */
+ParkingLot *load_parking_snapshot_lazy(const char *filename);
+
+/**
+ * @brief 从完整快照与增量文件加载停车场数据。
+ * @details
+ * 增量文件不存在、或它记录的基准校验和与 base_path 不符（写出新的完整
+ * 检查点后来不及删除的旧增量）时只加载完整快照。否则把增量中的页覆盖到
+ * 完整快照的对应页上，再按 load_parking_snapshot 的方式校验、解码。
+ * 加载后的停车场以 base_path 为基准继续记录脏页，下一次
+ * save_parking_checkpoint 仍可以只写增量。
+ * @param base_path 完整快照的路径（save_parking_checkpoint 写出的版本）。
+ * @param delta_path 增量文件的路径，可以为 NULL。
+ * @return 成功时返回重建的 ParkingLot 指针；文件无效、增量损坏
+ *         或内存不足时返回 NULL。
+ */
+ParkingLot *load_parking_checkpoint(const char *base_path,
+                                    const char *delta_path);
+
+/**
+ * @brief 从内存中的二进制快照内容加载停车场数据。
+ * @details 校验与解码方式与 load_parking_snapshot 相同，
+ *          返回的停车场不引用 data。
+ * @param data 快照内容，例如 parking_snapshot_bytes 的结果。
+ * @param size 字节数。
+ * @return 成功时返回重建的 ParkingLot 指针；内容不是有效快照或内存不足时
+ * 返回 NULL。
+ */
+ParkingLot *load_parking_snapshot_memory(const unsigned char *data,
+                                         size_t size);
+
+/** @} */
+
+/** @name 并发访问函数 */
+/** @{ */
+
+/**
+ * @brief 以共享方式锁定停车场，允许多个读者并行。
+ * @details 锁不可重入：持有读锁时不得再获取写锁，也不得调用会加锁的服务层函数。
+ * @param lot 目标停车场。
+ */
+void parking_lot_read_lock(ParkingLot *lot);
+
+/**
+ * @brief 释放停车场的共享锁。
+ * @param lot 目标停车场。
+ */
+void parking_lot_read_unlock(ParkingLot *lot);
+
+/**
+ * @brief 以独占方式锁定停车场，用于任何修改。
+ * @param lot 目标停车场。
+ */
+void parking_lot_write_lock(ParkingLot *lot);
+
+/**
+ * @brief 释放停车场的独占锁。
+ * @param lot 目标停车场。
+ */
+void parking_lot_write_unlock(ParkingLot *lot);
+
+/** @} */
+
+/** @name 预写日志函数 */
+/** @{ */
+
+/**
+ * @brief 一批日志记录落盘后调用的通知函数。
+ * @param first_seq 本批第一条记录的序号（序号从 1 开始递增）。
+ * @param last_seq 本批最后一条记录的序号。
+ * @param durable_at 本批完成同步的时间。
+ * @param ctx 配置时传入的上下文指针。
+ */
+typedef void (*JournalDurableFn)(unsigned long first_seq,
+                                 unsigned long last_seq, time_t durable_at,
+                                 void *ctx);
+
+/**
+ * @brief 为停车场启用预写日志。
+ * @details
+ * 先把当前状态写成快照，再清空并打开日志文件。此后数据层的每次
+ * 增删车位、入场、出场、信息修改和热字段同步都会追加一条日志记录；
+ * 记录数达到阈值时自动压缩。已启用的日志会先被关闭。
+ * @param lot 目标停车场。
+ * @param snapshot_path 快照文件路径。
+ * @param journal_path 日志文件路径。
+ * @return 成功返回 0，参数无效返回 -1，文件读写失败返回 -2。
+ */
+int enable_parking_journal(ParkingLot *lot, const char *snapshot_path,
+                           const char *journal_path);
+
+/**
+ * @brief 关闭停车场的预写日志，之后的修改不再记录。
+ * @param lot 目标停车场。
+ */
+void disable_parking_journal(ParkingLot *lot);
+
+/**
+ * @brief 将日志压缩进快照。
+ * @details 把当前状态写入日志关联的快照文件，成功后清空日志。
+ * @param lot 已启用日志的停车场。
+ * @return 成功返回 0，未启用日志返回 -1，文件读写失败返回 -2。
+ */
+int compact_parking_journal(ParkingLot *lot);
+
+/**
+ * @brief 从快照和日志恢复停车场，并继续以该日志记录后续修改。
+ * @details
+ * 加载快照后按顺序重放日志中的有效记录（截断的尾部被忽略），
+ * 随后立即压缩一次，使快照反映恢复后的状态、日志从空开始。
+ * @param snapshot_path 快照文件路径（二进制快照或文本格式均可）。
+ * @param journal_path 日志文件路径，文件不存在时视为空日志。
+ * @return 成功返回恢复的停车场；快照无法加载、日志无效或无法重新
+ * 启用日志时返回 NULL。
+ */
+ParkingLot *load_parking_journaled(const char *snapshot_path,
+                                   const char *journal_path);
+
+/**
+ * @brief 把一条日志记录作用到停车场上，与日志重放的规则相同。
+ * @details 与当前状态矛盾的记录（例如对空闲车位出场）被跳过。
+ * @note 须在写锁内调用。
+ * @param lot 目标停车场。
+ * @param record 要应用的记录。
+ * @return 成功（含被跳过的记录）返回 0，参数无效返回 -1。
+ */
+int apply_parking_journal_record(ParkingLot *lot,
+                                 const struct JournalRecord *record);
+
+/**
+ * @brief 启用、调整或关闭时间线（见 parking_timeline.h）。
+ * @details 启用时以当前状态写下第一个检查点，此后每次修改都带业务时间
+ *          记入时间线，每 segment_records 条记录再写一个检查点。
+ *          不依赖预写日志。重新配置时丢弃已有的历史。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param segment_records 每个检查点之后最多的记录数，0 表示关闭时间线。
+ * @param max_segments 最多保留的检查点数。
+ * @return 0 成功, -1 参数无效, -2 有进行中的快照, -3 内存分配失败。
+ */
+int configure_parking_timeline(ParkingLot *lot, int segment_records,
+                               int max_segments);
+
+/**
+ * @brief 重建停车场在某一时刻的状态。
+ * @details 从 when 之前最近的检查点加载，再重放该检查点之后、不晚于
+ *          when 的记录。返回的停车场与 lot 相互独立，由调用者释放。
+ * @note 可以在读锁内调用。
+ * @param lot 已启用时间线的停车场。
+ * @param when 回溯的时刻。
+ * @param[out] past 成功时接收重建的停车场。
+ * @return 0 成功, -1 参数无效或未启用时间线, -2 when 早于保留的历史,
+ *         -3 内存分配失败。
+ */
+int load_parking_at(const ParkingLot *lot, time_t when, ParkingLot **past);
+
+/**
+ * @brief 查询某个车位在某一时刻的状态，例如当时停的是哪辆车。
+ * @note 可以在读锁内调用。
+ * @param lot 已启用时间线的停车场。
+ * @param slot_id 车位编号。
+ * @param when 回溯的时刻。
+ * @param[out] slot 接收车位当时的状态。
+ * @return 0 成功, -1 参数无效或未启用时间线, -2 when 早于保留的历史,
+ *         -3 内存分配失败, -4 当时没有该车位。
+ */
+int find_slot_at(const ParkingLot *lot, int slot_id, time_t when,
+                 HistoricalSlot *slot);
+
+/**
+ * @brief 设置或清除日志记录的旁路接收者。
+ * @details 接收者与预写日志相互独立：未启用日志时，数据层同样会为每次
+ *          修改生成记录并交给接收者。每个停车场只有一个接收者。
+ * @note 须在写锁内调用。
+ * @param lot 目标停车场。
+ * @param tap 接收函数，NULL 表示清除。
+ * @param ctx 透传给接收函数的上下文指针。
+ */
+void set_parking_mutation_tap(ParkingLot *lot, ParkingMutationTap tap,
+                              void *ctx);
+
+/**
+ * @brief 查询停车场的日志是否发生过写入失败。
+ * @param lot 目标停车场。
+ * @return 已启用日志且最近写入失败返回 1，否则返回 0。
+ */
+int parking_journal_failed(const ParkingLot *lot);
+
+/**
+ * @brief 配置日志的批量提交（group commit）策略。
+ * @details
+ * 记录追加后先留在缓冲区，累计 max_records 条或距本批第一条记录超过
+ * window_seconds 秒时统一同步到磁盘一次，之后调用 on_durable 报告
+ * 这一批记录的序号范围。时间窗口只在下一次追加或显式调用
+ * flush_parking_journal 时检查。max_records 为 1（默认）时每条记录单独同步。
+ * @param lot 已启用日志的停车场。
+ * @param max_records 每批最多记录数，0 表示不按数量触发。
+ * @param window_seconds 每批最长等待秒数，0 表示不按时间触发。
+ * @param on_durable 落盘通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 成功返回 0；未启用日志或两个触发条件都为 0 时返回 -1。
+ */
+int configure_parking_journal_batch(ParkingLot *lot, unsigned long max_records,
+                                    unsigned int window_seconds,
+                                    JournalDurableFn on_durable, void *ctx);
+
+/**
+ * @brief 立即同步日志中尚未落盘的记录。
+ * @param lot 已启用日志的停车场。
+ * @return 成功返回 0，未启用日志返回 -1，同步失败返回 -2。
+ */
+int flush_parking_journal(ParkingLot *lot);
+
+/**
+ * @brief 若当前批次的时间窗口已到，则同步日志。
+ * @details 供主循环在空闲时定期调用，避免高峰过后最后一批长时间停留在缓冲区。
+ * @param lot 已启用日志的停车场。
+ * @return 成功或无需同步返回 0，未启用日志返回 -1，同步失败返回 -2。
+ */
+int poll_parking_journal(ParkingLot *lot);
+
+/**
+ * @brief 开始一段批量修改，期间的日志记录在结束时统一同步一次。
+ * @details 未启用日志时什么也不做。必须与 end_parking_journal_batch 成对调用，
+ *          通常在持有写锁期间使用。
+ * @param lot 目标停车场。
+ */
+void begin_parking_journal_batch(ParkingLot *lot);
+
+/**
+ * @brief 结束一段批量修改，并同步期间追加的日志记录。
+ * @param lot 目标停车场。
+ * @return 成功或未启用日志返回 0，同步失败返回 -2。
+ */
+int end_parking_journal_batch(ParkingLot *lot);
+
+/**
+ * @brief 查询日志的序号进度。
+ * @param lot 目标停车场。
+ * @param[out] appended_seq 最近追加的记录序号，可以为 NULL。
+ * @param[out] durable_seq 已确认落盘的最大记录序号，可以为 NULL。
+ * @return 已启用日志返回 0，否则返回 -1。
+ */
+int parking_journal_progress(const ParkingLot *lot,
+                             unsigned long *appended_seq,
+                             unsigned long *durable_seq);
+
+/**
+ * @brief 为停车场启用收费台账。
+ * @details 打开（必要时创建）台账文件并按已有记录重建月表，
+ *          此后每笔出场收费都通过 record_parking_payment 追加一条记录。
+ *          已启用的台账会先被关闭。
+ * @param lot 目标停车场。
+ * @param path 台账文件路径。
+ * @return 成功返回 0，参数无效返回 -1，文件无法打开或不是有效台账返回 -2。
+ */
+int enable_payment_ledger(ParkingLot *lot, const char *path);
+
+/**
+ * @brief 关闭停车场的收费台账，之后的收费不再记录。
+ * @param lot 目标停车场。
+ */
+void disable_payment_ledger(ParkingLot *lot);
+
+/**
+ * @brief 向收费台账追加一笔出场收费。
+ * @details 未启用台账或金额不为正时什么也不做。
+ * @param lot 目标停车场。
+ * @param slot_id 出场的车位编号。
+ * @param type 停车类型。
+ * @param paid_at 收费时间。
+ * @param amount_cents 金额（分）。
+ * @return 成功或无需记录返回 0，参数无效返回 -1，写入失败返回 -2。
+ */
+int record_parking_payment(ParkingLot *lot, int slot_id, ParkingType type,
+                           time_t paid_at, long amount_cents);
+
+/**
+ * @brief 查询停车场的收费台账是否发生过写入失败。
+ * @param lot 目标停车场。
+ * @return 已启用台账且写入失败过返回 1，否则返回 0。
+ */
+int parking_ledger_failed(const ParkingLot *lot);
+
+/**
+ * @brief 为月费已到期的全部居民车位开出账单并顺延到期时间。
+ * @details 一次扫描热字段列：每 SLOT_BITMAP_WORD_BITS 行为一块，类型列与
+ *          到期时间列各比较出一个掩码，按位与之后只访问命中的车位。
+ *          到期时间不晚于 now 的居民车位按 tariff_resident_charge 计费，
+ *          到期时间顺延到 now 之后（按自然月或固定周期，取决于费率表），
+ *          热字段与月费到期堆随之更新并写入预写日志。启用收费台账时，
+ *          收费记录每累积 SLOT_BITMAP_WORD_BITS 笔以 ledger_append_batch
+ *          批量追加一次，写入失败由 parking_ledger_failed 报告。
+ *          无论车辆是否在场都会结算，
+ *          之后出场时不再重复收取已结算的周期。
+ * @param lot 目标停车场（调用者持有写锁）。
+ * @param now 结算时刻。
+ * @param visitor 对每张账单调用的回调函数，可以为 NULL。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 开出的账单数；参数无效返回 -1。
+ */
+int bill_resident_subscriptions(ParkingLot *lot, time_t now,
+                                ResidentInvoiceVisitor visitor, void *ctx);
+
+/**
+ * @brief 为全部在场访客车辆结算并释放车位（闭场清场）。
+ * @details 与月费结算相同，每 SLOT_BITMAP_WORD_BITS 行为一块，状态列与
+ *          类型列各比较出一个掩码，按位与得到在场访客。每块先只读热字段列
+ *          为全部命中的车位按 tariff_visitor_fee 计费，收费记录以
+ *          ledger_append_batch 一次追加，再逐个释放车位：停车记录、
+ *          出场缓存、索引、热字段与预写日志的处理与 deallocate_slot_at 相同。
+ *          收入统计不在这里计入，由调用者按回调累加的总额一次计入。
+ * @param lot 目标停车场（调用者持有写锁）。
+ * @param now 出场时间。
+ * @param visitor 对每次出场调用的回调函数，可以为 NULL。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 释放的车位数；参数无效返回 -1。
+ */
+int sweep_visitor_slots(ParkingLot *lot, time_t now,
+                        VisitorCheckoutVisitor visitor, void *ctx);
+
+/**
+ * @brief 为停车场启用停车记录存储。
+ * @details 打开（必要时创建）以 prefix 为前缀的一组列文件，
+ *          此后每次出场都通过 record_parking_session 追加一条记录。
+ *          已启用的存储会先被关闭。
+ * @param lot 目标停车场。
+ * @param prefix 列文件路径前缀。
+ * @return 成功返回 0，参数无效返回 -1，文件无法打开或不是有效列文件返回 -2。
+ */
+int enable_session_history(ParkingLot *lot, const char *prefix);
+
+/**
+ * @brief 为停车场启用停车记录存储，新建的列文件使用压缩模式。
+ * @details 与 enable_session_history 相同，只是列文件不存在时以
+ *          history_open_compressed 新建：写满的区块逐列压缩封存，
+ *          适合需要定期整体备份的长期记录。已有的列文件按原格式打开。
+ * @param lot 目标停车场。
+ * @param prefix 列文件路径前缀。
+ * @return 成功返回 0，参数无效返回 -1，文件无法打开或不是有效列文件返回 -2。
+ */
+int enable_compressed_session_history(ParkingLot *lot, const char *prefix);
+
+/**
+ * @brief 关闭停车场的停车记录存储，之后的出场不再记录。
+ * @param lot 目标停车场。
+ */
+void disable_session_history(ParkingLot *lot);
+
+/**
+ * @brief 为即将出场的车位追加一条停车记录。
+ * @details 必须在 deallocate_slot 清空车牌号之前调用；未启用存储时什么也不做。
+ * @param lot 目标停车场。
+ * @param slot 已占用、即将出场的车位。
+ * @param exit_time 出场时间。
+ * @param fee_cents 本次收取的费用（分）。
+ * @return 成功或无需记录返回 0，参数无效返回 -1，写入失败返回 -2。
+ */
+int record_parking_session(ParkingLot *lot, const ParkingSlot *slot,
+                           time_t exit_time, long fee_cents);
+
+/**
+ * @brief 查询停车场的停车记录存储是否发生过写入失败。
+ * @param lot 目标停车场。
+ * @return 已启用存储且写入失败过返回 1，否则返回 0。
+ */
+int parking_history_failed(const ParkingLot *lot);
+
+/**
+ * @brief 按出场时间区间扫描已完成的停车记录。
+ * @details 只读取 columns 指定的列（HISTORY_COLUMN_BIT 组合）以及出场时间列，
+ *          并跳过与区间不相交的记录区块。
+ * @param lot 已启用停车记录存储的停车场。
+ * @param from 区间起点（含）。
+ * @param to 区间终点（不含）。
+ * @param columns 需要读取的列掩码。
+ * @param visitor 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 访问的记录数；未启用存储、参数无效或读取失败时返回 -1。
+ */
+long scan_parking_sessions(const ParkingLot *lot, time_t from, time_t to,
+                           unsigned int columns, SessionVisitor visitor,
+                           void *ctx);
+
+/**
+ * @brief 汇总一段时间内已完成的停车次数、费用与时长。
+ * @details 只读取类型、入场时间、出场时间和费用四列。
+ * @param lot 已启用停车记录存储的停车场。
+ * @param from 区间起点（含）。
+ * @param to 区间终点（不含）。
+ * @param[out] summary 接收汇总结果。
+ * @return 成功返回 0，未启用存储、参数无效或读取失败时返回 -1。
+ */
+int summarize_parking_sessions(const ParkingLot *lot, time_t from, time_t to,
+                               SessionSummary *summary);
+
+/** @} */
+
+/** @name 运行时配置函数 */
+/** @{ */
+
+/**
+ * @brief 读取停车场当前生效的运行时配置。
+ * @details 只做一次原子读取，不加锁。返回的配置只读，
+ *          只能在调用者持有停车场读锁或写锁期间使用；
+ *          一次操作内应只读取一次，保证前后使用同一份配置。
+ * @param lot 目标停车场。
+ * @return 当前配置；lot 为 NULL 时返回 NULL。
+ */
+const ParkingConfig *parking_lot_config(const ParkingLot *lot);
+
+/**
+ * @brief 复制、校验并发布一份新的运行时配置。
+ * @details 新配置整体替换旧配置，读者要么看到旧配置、要么看到新配置。
+ *          发布不需要持有停车场的读写锁，不会阻塞正在进行的入场与出场；
+ *          被替换的配置挂到待回收链表，由 reclaim_parking_configs 释放。
+ *          访客入场时段对之后的入场生效，已登记的超时定时器不重新计算。
+ * @param lot 目标停车场。
+ * @param config 新配置，函数内部复制并重新编译费率表。
+ * @return 成功返回 0；参数无效或配置无效返回 -1；内存不足返回 -2。
+ */
+int publish_parking_config(ParkingLot *lot, const ParkingConfig *config);
+
+/**
+ * @brief 以一份新名单整体替换停车场的某种车牌名单。
+ * @details 与 publish_parking_config 相同，替换只是一次指针交换，不需要
+ *          持有停车场的读写锁，正在进行的入场要么查到旧名单、要么查到
+ *          新名单；被替换的名单挂到待回收链表，由 reclaim_plate_lists 释放。
+ *          名单应在锁外建好，发布时尚未封存的名单先行封存。
+ * @param lot 目标停车场。
+ * @param kind 名单种类。
+ * @param list 新名单，成功后归停车场所有；NULL 表示清空该名单。
+ * @return 成功返回 0；参数无效返回 -1；封存时内存不足返回 -2。
+ *         失败时名单仍归调用者所有，原名单不变。
+ */
+int publish_plate_list(ParkingLot *lot, PlateListKind kind, PlateList *list);
+
+/**
+ * @brief 释放已被替换的车牌名单。
+ * @note 须在写锁内调用，理由同 reclaim_parking_configs。
+ * @param lot 目标停车场。
+ * @return 释放的名单份数。
+ */
+int reclaim_plate_lists(ParkingLot *lot);
+
+/**
+ * @brief 判断车牌是否在停车场的某种名单中。
+ * @note 须在读锁或写锁内调用，保证读到的名单不会被回收。
+ * @param lot 目标停车场。
+ * @param kind 名单种类。
+ * @param plate 车牌号。
+ * @return 在名单中返回 1；不在名单中或参数无效返回 0。
+ */
+int parking_lot_plate_listed(const ParkingLot *lot, PlateListKind kind,
+                             const char *plate);
+
+/**
+ * @brief 读取停车场某种名单的条数。
+ * @note 须在读锁或写锁内调用。
+ * @param lot 目标停车场。
+ * @param kind 名单种类。
+ * @return 名单条数；名单为空或参数无效返回 0。
+ */
+long parking_lot_plate_list_size(const ParkingLot *lot, PlateListKind kind);
+
+/**
+ * @brief 释放已被替换的运行时配置。
+ * @details 持有写锁意味着此前读到旧配置的操作都已结束，
+ *          因此待回收链表中的配置都可以安全释放。
+ * @note 须在写锁内调用。
+ * @param lot 目标停车场。
+ * @return 释放的配置份数。
+ */
+int reclaim_parking_configs(ParkingLot *lot);
+
+/** @} */
+
+/** @name 时间源函数 */
+/** @{ */
+
+/**
+ * @brief 读取停车场时间源的当前时刻。
+ * @details 入场、出场、计费与统计都通过本函数取得当前时刻；
+ *          可以在锁外调用。
+ * @param lot 目标停车场。
+ * @return 当前时刻；lot 为 NULL 时返回系统时间。
+ */
+time_t parking_lot_now(const ParkingLot *lot);
+
+/**
+ * @brief 切换停车场时间源的工作方式。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param mode 新的工作方式。
+ * @param start 虚拟时钟的起始时刻，其他方式忽略。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int configure_parking_clock(ParkingLot *lot, ParkingClockMode mode,
+                            time_t start);
+
+/**
+ * @brief 刷新缓存时钟，事件循环每轮调用一次；其他方式下不做任何事。
+ * @details 原子写入，无需加锁。
+ * @param lot 目标停车场。
+ * @return 刷新后的当前时刻。
+ */
+time_t tick_parking_clock(ParkingLot *lot);
+
+/**
+ * @brief 将虚拟时钟设置到指定时刻。
+ * @details 原子写入，无需加锁。
+ * @param lot 目标停车场。
+ * @param now 新的当前时刻。
+ * @return 成功返回 0，参数无效或不是虚拟时钟返回 -1。
+ */
+int set_parking_clock(ParkingLot *lot, time_t now);
+
+/**
+ * @brief 将虚拟时钟向前推进若干秒。
+ * @details 原子写入，无需加锁。
+ * @param lot 目标停车场。
+ * @param seconds 推进的秒数，不能为负。
+ * @return 成功返回 0，参数无效或不是虚拟时钟返回 -1。
+ */
+int advance_parking_clock(ParkingLot *lot, long seconds);
+
+/**
+ * @brief 注册定时器事件的处理函数。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @param handler 处理函数，NULL 表示不再通知（定时器照常运行）。
+ * @param ctx 透传给处理函数的上下文指针。
+ */
+void set_parking_event_handler(ParkingLot *lot, ParkingEventHandler handler,
+                               void *ctx);
+
+/**
+ * @brief 把定时器推进到停车场时间源的当前时刻，触发其间到期的事件。
+ * @details 事件循环在 tick_parking_clock 之后调用一次即可，每个事件耗时 O(1)，
+ *          不扫描车位：
+ *          - 访客车辆入场即登记当日允许时段结束时刻的定时器，届时仍在场则
+ *            报告 PARKING_EVENT_VISITOR_OVERSTAY，并改到次日同一时刻；
+ *          - 设置了到期时间的居民车位登记到期时刻的定时器，届时报告
+ *            PARKING_EVENT_RESIDENT_DUE，顺延到期时间后重新登记；
+ *          - 每个本地 0 点把当日（及跨月时的当月）收入清零，报告
+ *            PARKING_EVENT_DAY_ROLLOVER。
+ *          时钟回拨时定时器按新的时刻重新归位。
+ * @note 须在写锁内（或单线程）调用。
+ * @param lot 目标停车场。
+ * @return 触发的定时器数；lot 为 NULL 时返回 -1。
+ */
+int run_parking_timers(ParkingLot *lot);
 
-///@}
+/** @} */
 
 /** @name 内存管理函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 释放单个停车位对象占用的内存。
+ * @note 来自停车场内存池（SLOT_STORAGE_ARENA）的车位由停车场统一回收，
+ *       对其调用本函数不会执行任何操作。
  * @param slot 要释放的停车位。
  */
 void free_parking_slot(ParkingSlot *slot);
 
 /**
  * @brief 释放整个停车场（包括所有车位）占用的内存。
- * @details 遍历车位链表，逐个释放所有停车位节点，最后释放停车场本身。
+ * @details 内存池中的车位按区块整体释放；只有单独分配的车位才需要逐个释放。
  * @param lot 要释放的停车场。
  */
 void free_parking_lot(ParkingLot *lot);
 
-///@}
+/** @} */
 
 #endif /* PARKING_DATA_H */
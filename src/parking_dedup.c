@@ -0,0 +1,202 @@
+/**
+ * @file parking_dedup.c
+ * @brief 请求去重表实现文件
+ * @details
+ * 该文件实现了 parking_dedup.h 中声明的去重表。记录数组按写入顺序循环
+ * 复用，覆盖一条旧记录前先把它从所在的哈希桶中摘下。
+ */
+
+#include <string.h>
+
+#include "parking_dedup.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 求请求 id 所在的哈希桶（FNV-1a）。
+ * @param log 目标去重表。
+ * @param id 请求 id。
+ * @return 哈希桶下标。
+ */
+static int bucket_of(const RequestLog *log, const char *id) {
+  unsigned long hash = 2166136261UL;
+
+  while (*id != '\0') {
+    hash ^= (unsigned char)*id++;
+    hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  return (int)(hash & (unsigned long)log->bucket_mask);
+}
+
+/**
+ * @brief (静态辅助函数) 按请求 id 查找记录下标。
+ * @param log 目标去重表。
+ * @param id 请求 id。
+ * @return 记录下标，没有时返回 -1。
+ */
+static int find_entry(const RequestLog *log, const char *id) {
+  int at = log->buckets[bucket_of(log, id)];
+
+  while (at >= 0 && strcmp(log->entries[at].id, id) != 0) {
+    at = log->entries[at].bucket_next;
+  }
+  return at;
+}
+
+/**
+ * @brief (静态辅助函数) 把记录从所在的哈希桶中摘下。
+ * @param log 目标去重表。
+ * @param at 记录下标。
+ */
+static void unlink_entry(RequestLog *log, int at) {
+  int *link = &log->buckets[bucket_of(log, log->entries[at].id)];
+
+  while (*link != at) {
+    link = &log->entries[*link].bucket_next;
+  }
+  *link = log->entries[at].bucket_next;
+}
+
+/* ========================================================================== */
+/*                               请求去重API实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一张空的去重表。
+ * @param memory 表的分配来源，NULL 表示 C 堆。
+ * @param capacity 记住的请求数。
+ * @return 成功返回去重表；参数无效或内存不足返回 NULL。
+ */
+RequestLog *request_log_create(ParkingMemory *memory, int capacity) {
+  RequestLog *log;
+  int buckets = 1;
+  int i;
+
+  if (capacity <= 0) {
+    return NULL;
+  }
+  while (buckets < capacity) {
+    buckets <<= 1;
+  }
+  log = (RequestLog *)parking_memory_calloc(memory, PARKING_MEMORY_INDEX, 1,
+                                            sizeof(RequestLog));
+  if (log == NULL) {
+    return NULL;
+  }
+  log->entries = (RequestLogEntry *)parking_memory_calloc(
+      memory, PARKING_MEMORY_INDEX, (size_t)capacity, sizeof(RequestLogEntry));
+  log->buckets = (int *)parking_memory_alloc(memory, PARKING_MEMORY_INDEX,
+                                             (size_t)buckets * sizeof(int));
+  log->lock = parking_rwlock_create();
+  if (log->entries == NULL || log->buckets == NULL || log->lock == NULL) {
+    parking_rwlock_destroy(log->lock);
+    parking_memory_free(memory, log->entries);
+    parking_memory_free(memory, log->buckets);
+    parking_memory_free(memory, log);
+    return NULL;
+  }
+  for (i = 0; i < buckets; i++) {
+    log->buckets[i] = -1;
+  }
+  log->capacity = capacity;
+  log->bucket_mask = buckets - 1;
+  log->memory = memory;
+  return log;
+}
+
+/**
+ * @brief 释放去重表。
+ * @param log 要释放的去重表，可以为 NULL。
+ */
+void request_log_free(RequestLog *log) {
+  if (log == NULL) {
+    return;
+  }
+  parking_rwlock_destroy(log->lock);
+  parking_memory_free(log->memory, log->entries);
+  parking_memory_free(log->memory, log->buckets);
+  parking_memory_free(log->memory, log);
+}
+
+/**
+ * @brief 查找同一请求第一次执行的结果。
+ * @param log 目标去重表，可以为 NULL。
+ * @param id 请求 id。
+ * @param fingerprint 请求内容的指纹。
+ * @param[out] code 命中时接收状态码。
+ * @param[out] result 命中时接收结果字段。
+ * @param[out] result_length 命中时接收结果字段的字节数。
+ * @return 命中返回 1，否则返回 0。
+ */
+int request_log_find(RequestLog *log, const char *id,
+                     unsigned long fingerprint, int *code, char *result,
+                     size_t *result_length) {
+  const RequestLogEntry *entry;
+  int at;
+
+  if (log == NULL || id == NULL || id[0] == '\0') {
+    return 0;
+  }
+  /* 命中时还要累计回放次数，因此取写锁 */
+  parking_rwlock_write_lock(log->lock);
+  at = find_entry(log, id);
+  if (at < 0 || log->entries[at].fingerprint != fingerprint) {
+    parking_rwlock_write_unlock(log->lock);
+    return 0;
+  }
+  entry = &log->entries[at];
+  *code = entry->code;
+  memcpy(result, entry->result, entry->result_length);
+  *result_length = entry->result_length;
+  log->replays++;
+  parking_rwlock_write_unlock(log->lock);
+  return 1;
+}
+
+/**
+ * @brief 记下一个请求的执行结果，表满时覆盖最早的记录。
+ * @param log 目标去重表，可以为 NULL。
+ * @param id 请求 id。
+ * @param fingerprint 请求内容的指纹。
+ * @param code 状态码。
+ * @param result 结果字段。
+ * @param result_length 结果字段的字节数。
+ */
+void request_log_record(RequestLog *log, const char *id,
+                        unsigned long fingerprint, int code,
+                        const char *result, size_t result_length) {
+  RequestLogEntry *entry;
+  size_t id_length;
+  int bucket;
+  int at;
+
+  if (log == NULL || id == NULL || result_length > REQUEST_LOG_MAX_RESULT) {
+    return;
+  }
+  id_length = strlen(id);
+  if (id_length == 0 || id_length > REQUEST_LOG_MAX_ID) {
+    return;
+  }
+
+  parking_rwlock_write_lock(log->lock);
+  at = find_entry(log, id);
+  if (at < 0) {
+    at = log->next;
+    log->next = (log->next + 1) % log->capacity;
+    if (log->entries[at].id[0] != '\0') {
+      unlink_entry(log, at); /* 覆盖最早的记录 */
+    }
+    memcpy(log->entries[at].id, id, id_length + 1);
+    bucket = bucket_of(log, id);
+    log->entries[at].bucket_next = log->buckets[bucket];
+    log->buckets[bucket] = at;
+  }
+  entry = &log->entries[at];
+  entry->fingerprint = fingerprint;
+  entry->code = code;
+  memcpy(entry->result, result, result_length);
+  entry->result_length = result_length;
+  parking_rwlock_write_unlock(log->lock);
+}
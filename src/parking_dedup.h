@@ -0,0 +1,116 @@
+#ifndef PARKING_DEDUP_H
+#define PARKING_DEDUP_H
+
+#include <stddef.h>
+
+#include "parking_memory.h"
+#include "parking_thread.h"
+
+/**
+ * @file parking_dedup.h
+ * @brief 按请求 id 记住近期请求结果的去重表声明。
+ * @details
+ * 闸机控制器的链路不稳定时，请求已经执行而响应丢失，控制器超时后重发，
+ * 重发的入场会得到“车牌已在场内”，重发的出场会得到“车位空闲”。
+ * 去重表按请求 id 记下每个修改类请求的状态码与结果字段，同一 id 的
+ * 重发直接返回第一次的结果而不再执行，客户端因此可以用较短的超时放心重发。
+ *
+ * 表的容量固定，按写入顺序循环复用条目，只记住最近 capacity 个请求；
+ * 以链式哈希表按 id 查找，查找与写入都是 O(1)。每条记录还保存请求内容的
+ * 指纹：同一 id 对应不同的请求内容时视为客户端复用了 id，按新请求执行。
+ * 表自带一把锁，可以在停车场锁之外使用。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define REQUEST_LOG_DEFAULT_CAPACITY 4096 /**< 默认记住的请求数 */
+#define REQUEST_LOG_MAX_ID 32             /**< 请求 id 的最大字节数 */
+#define REQUEST_LOG_MAX_RESULT 96         /**< 记录的结果字段的最大字节数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 去重表中的一条请求记录。
+ */
+typedef struct RequestLogEntry {
+  char id[REQUEST_LOG_MAX_ID + 1];       /**< 请求 id，空串表示未使用。 */
+  unsigned long fingerprint;             /**< 请求内容的指纹。 */
+  int code;                              /**< 第一次执行的状态码。 */
+  size_t result_length;                  /**< result 的字节数。 */
+  char result[REQUEST_LOG_MAX_RESULT];   /**< 第一次执行的结果字段。 */
+  int bucket_next; /**< 同一哈希桶中的下一条记录，-1 表示没有。 */
+} RequestLogEntry;
+
+/**
+ * @brief 按请求 id 记住近期请求结果的去重表。
+ */
+typedef struct RequestLog {
+  RequestLogEntry *entries; /**< 循环复用的记录数组。 */
+  int *buckets;             /**< 哈希桶中第一条记录的下标，-1 表示空桶。 */
+  int capacity;             /**< 记录数组的容量。 */
+  int bucket_mask;          /**< 哈希桶数减 1（桶数为 2 的幂）。 */
+  int next;                 /**< 下一条写入的位置。 */
+  long replays;             /**< 以记录的结果回复重发请求的次数。 */
+  ParkingRwLock *lock;      /**< 保护整张表的锁。 */
+  ParkingMemory *memory;    /**< 分配来源，NULL 表示 C 堆。 */
+} RequestLog;
+
+/**
+ *********************************************************************************
+ *                                请求去重API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一张空的去重表。
+ * @param memory 表的分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @param capacity 记住的请求数，必须大于 0。
+ * @return 成功返回去重表；参数无效或内存不足返回 NULL。
+ */
+RequestLog *request_log_create(ParkingMemory *memory, int capacity);
+
+/**
+ * @brief 释放去重表。
+ * @param log 要释放的去重表，可以为 NULL。
+ */
+void request_log_free(RequestLog *log);
+
+/**
+ * @brief 查找同一请求第一次执行的结果。
+ * @param log 目标去重表，可以为 NULL（视为空表）。
+ * @param id 请求 id。
+ * @param fingerprint 请求内容的指纹。
+ * @param[out] code 命中时接收状态码。
+ * @param[out] result 命中时接收结果字段，至少 REQUEST_LOG_MAX_RESULT 字节；
+ *                    不以 NUL 结尾。
+ * @param[out] result_length 命中时接收结果字段的字节数。
+ * @return 命中返回 1；没有记录或 id 对应其他请求内容时返回 0。
+ */
+int request_log_find(RequestLog *log, const char *id,
+                     unsigned long fingerprint, int *code, char *result,
+                     size_t *result_length);
+
+/**
+ * @brief 记下一个请求的执行结果，表满时覆盖最早的记录。
+ * @details 同一 id 已有记录时以新结果替换。id 为空、超过 REQUEST_LOG_MAX_ID
+ *          字节或结果字段超过 REQUEST_LOG_MAX_RESULT 字节时不记录。
+ * @param log 目标去重表，可以为 NULL（不记录）。
+ * @param id 请求 id。
+ * @param fingerprint 请求内容的指纹。
+ * @param code 状态码。
+ * @param result 结果字段。
+ * @param result_length 结果字段的字节数。
+ */
+void request_log_record(RequestLog *log, const char *id,
+                        unsigned long fingerprint, int code,
+                        const char *result, size_t result_length);
+
+#endif /* PARKING_DEDUP_H */
@@ -0,0 +1,185 @@
+/**
+ * @file parking_durable_file.c
+ * @brief 原子替换写入实现文件
+ * @details
+ * 该文件实现了 parking_durable_file.h 中声明的临时文件写入与提交。
+ * fsync 属于 POSIX 接口，需要在包含系统头文件前开启 _POSIX_C_SOURCE；
+ * Windows 下以 _commit 落盘，以 MoveFileEx 覆盖已存在的目标文件。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "parking_durable_file.h"
+#include "parking_trace.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 将 stdio 缓冲区和操作系统缓存写到磁盘。
+ * @param stream 已打开的文件。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int flush_to_disk(FILE *stream) {
+  TraceSpan span;
+  int result;
+
+  if (fflush(stream) != 0 || ferror(stream)) {
+    return -1;
+  }
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_IO, "fsync");
+#ifdef _WIN32
+  result = _commit(_fileno(stream)) == 0 ? 0 : -1;
+#else
+  result = fsync(fileno(stream)) == 0 ? 0 : -1;
+#endif
+  PARKING_TRACE_END(span);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 用临时文件替换目标文件。
+ * @param temp_path 已落盘的临时文件。
+ * @param path 目标路径。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int replace_target(const char *temp_path, const char *path) {
+#ifdef _WIN32
+  return MoveFileExA(temp_path, path,
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)
+             ? 0
+             : -1;
+#else
+  return rename(temp_path, path) == 0 ? 0 : -1;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 同步目标文件所在的目录，使重命名本身落盘。
+ * @details 只在 POSIX 下需要；目录无法打开时不视为失败，
+ *          此时文件内容已落盘，只是重命名可能在断电后回退到旧文件。
+ * @param path 目标路径。
+ */
+static void sync_parent_directory(const char *path) {
+#ifndef _WIN32
+  char directory[DURABLE_FILE_MAX_PATH];
+  const char *slash = strrchr(path, '/');
+  TraceSpan span;
+  int fd;
+
+  if (slash == NULL) {
+    strcpy(directory, ".");
+  } else if (slash == path) {
+    strcpy(directory, "/");
+  } else {
+    memcpy(directory, path, (size_t)(slash - path));
+    directory[slash - path] = '\0';
+  }
+  fd = open(directory, O_RDONLY);
+  if (fd >= 0) {
+    PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_IO, "fsync_dir");
+    fsync(fd);
+    PARKING_TRACE_END(span);
+    close(fd);
+  }
+#else
+  (void)path;
+#endif
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 打开目标文件对应的临时文件。
+ * @param file 接收打开结果。
+ * @param path 目标路径。
+ * @param mode fopen 的写入模式。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int durable_file_open(DurableFile *file, const char *path, const char *mode) {
+  size_t length;
+
+  if (file == NULL) {
+    return -1;
+  }
+  file->stream = NULL;
+  if (path == NULL || mode == NULL) {
+    return -1;
+  }
+  length = strlen(path);
+  if (length == 0 || length >= DURABLE_FILE_MAX_PATH) {
+    return -1;
+  }
+  memcpy(file->path, path, length + 1);
+  memcpy(file->temp_path, path, length);
+  memcpy(file->temp_path + length, DURABLE_FILE_SUFFIX,
+         sizeof(DURABLE_FILE_SUFFIX));
+
+  file->stream = fopen(file->temp_path, mode);
+  return file->stream != NULL ? 0 : -1;
+}
+
+/**
+ * @brief 把临时文件落盘并原子地替换目标文件。
+ * @param file 由 durable_file_open 打开的文件。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int durable_file_commit(DurableFile *file) {
+  int result;
+
+  if (file == NULL || file->stream == NULL) {
+    return -1;
+  }
+  result = flush_to_disk(file->stream);
+  if (fclose(file->stream) != 0) {
+    result = -1;
+  }
+  file->stream = NULL;
+  if (result == 0) {
+    result = replace_target(file->temp_path, file->path);
+  }
+  if (result != 0) {
+    remove(file->temp_path);
+    return -1;
+  }
+  sync_parent_directory(file->path);
+  return 0;
+}
+
+/**
+ * @brief 把已打开文件的 stdio 缓冲区与操作系统缓存写到磁盘。
+ * @param stream 已打开的文件。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int durable_file_sync(FILE *stream) {
+  return stream != NULL ? flush_to_disk(stream) : -1;
+}
+
+/**
+ * @brief 放弃写入：关闭并删除临时文件。
+ * @param file 由 durable_file_open 打开的文件。
+ */
+void durable_file_abort(DurableFile *file) {
+  if (file == NULL || file->stream == NULL) {
+    return;
+  }
+  fclose(file->stream);
+  file->stream = NULL;
+  remove(file->temp_path);
+}
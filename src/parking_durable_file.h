@@ -0,0 +1,78 @@
+#ifndef PARKING_DURABLE_FILE_H
+#define PARKING_DURABLE_FILE_H
+
+#include <stdio.h>
+
+/**
+ * @file parking_durable_file.h
+ * @brief 以临时文件加原子重命名替换目标文件的写入封装。
+ * @details
+ * 写入先进入同目录下的 `<目标>.tmp`，提交时依次 fflush、fsync、关闭，
+ * 再原子地重命名为目标文件（POSIX 下随后同步所在目录）。
+ * 写到一半崩溃或断电时，目标文件仍是上一次完整提交的内容，
+ * 最多留下一个没有被任何加载路径读取的临时文件。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define DURABLE_FILE_MAX_PATH 260   /**< 目标路径的最大长度 */
+#define DURABLE_FILE_SUFFIX ".tmp"  /**< 临时文件名的后缀 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个正在写入的替换文件。
+ */
+typedef struct DurableFile {
+  FILE *stream; /**< 写入临时文件的流，未打开时为 NULL。 */
+  char path[DURABLE_FILE_MAX_PATH]; /**< 目标路径。 */
+  /** 临时文件路径，即目标路径加上 DURABLE_FILE_SUFFIX。 */
+  char temp_path[DURABLE_FILE_MAX_PATH + sizeof(DURABLE_FILE_SUFFIX)];
+} DurableFile;
+
+/**
+ *********************************************************************************
+ *                            替换写入API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 打开目标文件对应的临时文件。
+ * @param file 接收打开结果。
+ * @param path 目标路径。
+ * @param mode fopen 的写入模式（"w" 或 "wb"）。
+ * @return 成功返回 0；路径过长或无法创建临时文件返回 -1。
+ */
+int durable_file_open(DurableFile *file, const char *path, const char *mode);
+
+/**
+ * @brief 把临时文件落盘并原子地替换目标文件。
+ * @details 任何一步失败都会删除临时文件，目标文件保持原样。
+ * @param file 由 durable_file_open 打开的文件，返回后关闭。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int durable_file_commit(DurableFile *file);
+
+/**
+ * @brief 把已打开文件的 stdio 缓冲区与操作系统缓存写到磁盘。
+ * @details 供原地追加的文件在后续步骤依赖其内容之前落盘使用。
+ * @param stream 已打开的文件。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int durable_file_sync(FILE *stream);
+
+/**
+ * @brief 放弃写入：关闭并删除临时文件，目标文件保持原样。
+ * @param file 由 durable_file_open 打开的文件，可以已关闭。
+ */
+void durable_file_abort(DurableFile *file);
+
+#endif /* PARKING_DURABLE_FILE_H */
@@ -0,0 +1,584 @@
+/**
+ * @file parking_exporter.c
+ * @brief OpenMetrics 指标导出模块的实现文件
+ * @details
+ * 该文件实现了 parking_exporter.h 中声明的渲染函数与最小 HTTP 服务。
+ * 服务线程用 select 带超时地等待连接，以便及时响应停止请求；
+ * 每个连接读取一次请求、写出完整响应后即关闭（HTTP/1.0 语义）。
+ * 套接字接口需要 POSIX 声明，因此与 parking_thread.c 一样
+ * 在包含系统头文件前显式开启 _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_exporter.h"
+#include "parking_service.h"
+#include "parking_thread.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#ifdef _WIN32
+typedef SOCKET ExporterSocket; /**< 平台套接字类型 */
+typedef int ExporterSocklen;   /**< 地址长度类型 */
+#define EXPORTER_INVALID_SOCKET INVALID_SOCKET /**< 无效套接字 */
+#define EXPORTER_SEND_FLAGS 0                  /**< send 的附加标志 */
+#else
+typedef int ExporterSocket;          /**< 平台套接字类型 */
+typedef socklen_t ExporterSocklen;   /**< 地址长度类型 */
+#define EXPORTER_INVALID_SOCKET (-1) /**< 无效套接字 */
+#ifdef MSG_NOSIGNAL
+#define EXPORTER_SEND_FLAGS MSG_NOSIGNAL /**< 对端关闭时不触发 SIGPIPE */
+#else
+#define EXPORTER_SEND_FLAGS 0 /**< send 的附加标志 */
+#endif
+#endif
+
+#define EXPORTER_LINE_SIZE 256          /**< 单行渲染的最大长度 */
+#define EXPORTER_REQUEST_SIZE 2048      /**< 读取请求头的最大长度 */
+#define EXPORTER_POLL_MS 200            /**< 等待连接时检查停止标志的间隔 */
+#define EXPORTER_CLIENT_TIMEOUT_MS 2000 /**< 等待客户端发送请求的超时 */
+#define EXPORTER_FIRST_POWER 7          /**< 最小的 le 边界：2^7 纳秒 */
+#define EXPORTER_LAST_POWER 32          /**< 最大的有限 le 边界：2^32 纳秒 */
+
+/**
+ * @brief 正在运行的 HTTP 导出服务。
+ */
+struct ParkingExporter {
+  const ParkingLot *lot;   /**< 要导出的停车场。 */
+  ExporterSocket listener; /**< 监听套接字。 */
+  int port;                /**< 实际监听的端口。 */
+  volatile int stopping;   /**< 非 0 时服务线程退出。 */
+  ParkingThread *thread;   /**< 服务线程。 */
+  char *body;              /**< 渲染缓冲区。 */
+  char request[EXPORTER_REQUEST_SIZE]; /**< 请求头缓冲区。 */
+};
+
+/**
+ * @brief 渲染过程中的输出游标。
+ */
+typedef struct {
+  char *buffer;  /**< 输出缓冲区。 */
+  size_t size;   /**< 缓冲区大小。 */
+  size_t length; /**< 已写入的字节数。 */
+  int overflow;  /**< 非 0 表示缓冲区不足。 */
+} ExporterWriter;
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 追加一段文本。
+ * @param writer 输出游标。
+ * @param text 要追加的文本。
+ */
+static void writer_append(ExporterWriter *writer, const char *text) {
+  size_t length = strlen(text);
+
+  if (writer->overflow || writer->length + length >= writer->size) {
+    writer->overflow = 1;
+    return;
+  }
+  memcpy(writer->buffer + writer->length, text, length + 1);
+  writer->length += length;
+}
+
+/**
+ * @brief (静态辅助函数) 获取服务层状态码在导出中使用的标签值。
+ * @param outcome 结果下标，即状态码取负。
+ * @return 指向静态字符串的指针。
+ */
+static const char *outcome_label(int outcome) {
+  static const char *const labels[] = {
+      "success",       "invalid_param",  "slot_exists",  "slot_not_found",
+      "slot_occupied", "slot_free",      "license_exists", "time_invalid",
+      "memory_error",  "file_error",     "system_error", "plate_blocked",
+      "busy"};
+
+  if (outcome < 0 || outcome >= (int)(sizeof(labels) / sizeof(labels[0]))) {
+    return "other";
+  }
+  return labels[outcome];
+}
+
+/**
+ * @brief (静态辅助函数) 渲染停车场的占用与收入。
+ * @param writer 输出游标。
+ * @param stats 统计快照。
+ */
+static void render_lot(ExporterWriter *writer, const ParkingStatistics *stats) {
+  char line[EXPORTER_LINE_SIZE];
+
+  writer_append(writer, "# TYPE parking_lot_slots gauge\n"
+                        "# HELP parking_lot_slots Parking slots by state.\n");
+  sprintf(line,
+          "parking_lot_slots{state=\"total\"} %d\n"
+          "parking_lot_slots{state=\"occupied\"} %d\n"
+          "parking_lot_slots{state=\"free\"} %d\n",
+          stats->total_slots, stats->occupied_slots, stats->free_slots);
+  writer_append(writer, line);
+
+  writer_append(writer, "# TYPE parking_lot_occupancy_ratio gauge\n"
+                        "# HELP parking_lot_occupancy_ratio Occupied share "
+                        "of slots.\n");
+  sprintf(line, "parking_lot_occupancy_ratio %.6f\n",
+          stats->occupancy_rate / 100.0);
+  writer_append(writer, line);
+
+  writer_append(writer, "# TYPE parking_lot_revenue_yuan gauge\n"
+                        "# UNIT parking_lot_revenue_yuan yuan\n"
+                        "# HELP parking_lot_revenue_yuan Fees collected in "
+                        "the current period.\n");
+  sprintf(line,
+          "parking_lot_revenue_yuan{period=\"today\"} %.2f\n"
+          "parking_lot_revenue_yuan{period=\"month\"} %.2f\n",
+          stats->today_revenue, stats->month_revenue);
+  writer_append(writer, line);
+}
+
+/**
+ * @brief (静态辅助函数) 渲染停车场按类别的内存占用。
+ * @param writer 输出游标。
+ * @param memory 内存统计快照。
+ */
+static void render_memory(ExporterWriter *writer,
+                          const ParkingMemoryStats *memory) {
+  char line[EXPORTER_LINE_SIZE];
+  PoolStats pool;
+  int i;
+
+  writer_append(writer, "# TYPE parking_lot_memory_bytes gauge\n"
+                        "# UNIT parking_lot_memory_bytes bytes\n"
+                        "# HELP parking_lot_memory_bytes Bytes in use by "
+                        "category, excluding allocation headers.\n");
+  for (i = 0; i < PARKING_MEMORY_CATEGORY_COUNT; i++) {
+    sprintf(line, "parking_lot_memory_bytes{category=\"%s\"} %ld\n",
+            parking_memory_category_name((ParkingMemoryCategory)i),
+            memory->bytes[i]);
+    writer_append(writer, line);
+  }
+  writer_append(writer, "# TYPE parking_lot_memory_objects gauge\n"
+                        "# HELP parking_lot_memory_objects Allocations in "
+                        "use by category.\n");
+  for (i = 0; i < PARKING_MEMORY_CATEGORY_COUNT; i++) {
+    sprintf(line, "parking_lot_memory_objects{category=\"%s\"} %ld\n",
+            parking_memory_category_name((ParkingMemoryCategory)i),
+            memory->objects[i]);
+    writer_append(writer, line);
+  }
+  writer_append(writer, "# TYPE parking_service_outstanding_results gauge\n"
+                        "# HELP parking_service_outstanding_results Result "
+                        "payloads not yet released.\n");
+  sprintf(line, "parking_service_outstanding_results %ld\n",
+          parking_service_outstanding_results());
+  writer_append(writer, line);
+  parking_service_get_pool_stats(&pool);
+  writer_append(writer, "# TYPE parking_service_result_pool_bytes gauge\n"
+                        "# UNIT parking_service_result_pool_bytes bytes\n"
+                        "# HELP parking_service_result_pool_bytes Free result "
+                        "blocks cached for reuse.\n");
+  sprintf(line, "parking_service_result_pool_bytes %ld\n", pool.cached_bytes);
+  writer_append(writer, line);
+}
+
+/**
+ * @brief (静态辅助函数) 渲染各操作按结果分类的调用次数。
+ * @param writer 输出游标。
+ * @param metrics 服务指标快照。
+ */
+static void render_calls(ExporterWriter *writer,
+                         const ServiceMetrics *metrics) {
+  char line[EXPORTER_LINE_SIZE];
+  int op;
+  int outcome;
+
+  writer_append(writer, "# TYPE parking_service_calls counter\n"
+                        "# HELP parking_service_calls Service calls by "
+                        "result code.\n");
+  for (op = 0; op < SERVICE_METRIC_COUNT; op++) {
+    const MetricsSnapshot *snapshot = &metrics->operations[op];
+
+    for (outcome = 0; outcome < METRICS_MAX_OUTCOMES; outcome++) {
+      if (snapshot->outcomes[outcome] == 0) {
+        continue;
+      }
+      sprintf(line,
+              "parking_service_calls_total{operation=\"%s\",code=\"%s\"} %ld\n",
+              parking_service_metric_name((ServiceMetric)op),
+              outcome_label(outcome), snapshot->outcomes[outcome]);
+      writer_append(writer, line);
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 渲染各操作的延迟直方图。
+ * @details 内部直方图按 2 的幂分组，导出时在每组的上界（2^7..2^32 纳秒）
+ *          各输出一个累计桶，最后一个内部桶同时收纳溢出值，只计入 +Inf。
+ * @param writer 输出游标。
+ * @param metrics 服务指标快照。
+ */
+static void render_latency(ExporterWriter *writer,
+                           const ServiceMetrics *metrics) {
+  char line[EXPORTER_LINE_SIZE];
+  int op;
+
+  writer_append(writer, "# TYPE parking_service_latency_seconds histogram\n"
+                        "# UNIT parking_service_latency_seconds seconds\n"
+                        "# HELP parking_service_latency_seconds Service call "
+                        "latency.\n");
+  for (op = 0; op < SERVICE_METRIC_COUNT; op++) {
+    const MetricsSnapshot *snapshot = &metrics->operations[op];
+    const char *name = parking_service_metric_name((ServiceMetric)op);
+    double bound = 1.0;
+    long cumulative = 0;
+    long total = 0;
+    int bucket = 0;
+    int power;
+
+    if (snapshot->calls == 0) {
+      continue;
+    }
+    for (power = 0; power < EXPORTER_FIRST_POWER; power++) {
+      bound *= 2.0;
+    }
+    for (power = EXPORTER_FIRST_POWER; power <= EXPORTER_LAST_POWER; power++) {
+      while (bucket < METRICS_LATENCY_BUCKETS - 1 &&
+             metrics_bucket_upper_ns(bucket) <= bound) {
+        cumulative += snapshot->latency[bucket++];
+      }
+      sprintf(line,
+              "parking_service_latency_seconds_bucket{operation=\"%s\","
+              "le=\"%.9g\"} %ld\n",
+              name, bound / 1e9, cumulative);
+      writer_append(writer, line);
+      bound *= 2.0;
+    }
+    for (bucket = 0; bucket < METRICS_LATENCY_BUCKETS; bucket++) {
+      total += snapshot->latency[bucket];
+    }
+    sprintf(line,
+            "parking_service_latency_seconds_bucket{operation=\"%s\","
+            "le=\"+Inf\"} %ld\n"
+            "parking_service_latency_seconds_count{operation=\"%s\"} %ld\n",
+            name, total, name, total);
+    writer_append(writer, line);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 关闭套接字。
+ * @param socket_fd 套接字。
+ */
+static void close_socket(ExporterSocket socket_fd) {
+#ifdef _WIN32
+  closesocket(socket_fd);
+#else
+  close(socket_fd);
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 等待套接字可读。
+ * @param socket_fd 套接字。
+ * @param timeout_ms 超时（毫秒）。
+ * @return 可读返回 1，超时或出错返回 0。
+ */
+static int wait_readable(ExporterSocket socket_fd, int timeout_ms) {
+  fd_set readable;
+  struct timeval timeout;
+
+  FD_ZERO(&readable);
+  FD_SET(socket_fd, &readable);
+  timeout.tv_sec = timeout_ms / 1000;
+  timeout.tv_usec = (timeout_ms % 1000) * 1000;
+  return select((int)socket_fd + 1, &readable, NULL, NULL, &timeout) > 0;
+}
+
+/**
+ * @brief (静态辅助函数) 写出全部数据。
+ * @param socket_fd 套接字。
+ * @param data 数据。
+ * @param length 数据长度。
+ * @return 成功返回 0，对端关闭或出错返回 -1。
+ */
+static int send_all(ExporterSocket socket_fd, const char *data,
+                    size_t length) {
+  while (length > 0) {
+    int chunk = length > 65536 ? 65536 : (int)length;
+    int sent = (int)send(socket_fd, data, chunk, EXPORTER_SEND_FLAGS);
+
+    if (sent <= 0) {
+      return -1;
+    }
+    data += sent;
+    length -= (size_t)sent;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 读取请求头并写出响应。
+ * @param exporter 服务句柄。
+ * @param client 客户端套接字。
+ */
+static void serve_client(ParkingExporter *exporter, ExporterSocket client) {
+  char header[EXPORTER_LINE_SIZE];
+  const char *status = "200 OK";
+  const char *content_type = PARKING_EXPORTER_CONTENT_TYPE;
+  const char *body = exporter->body;
+  size_t received = 0;
+  int length;
+
+  while (received < sizeof(exporter->request) - 1 &&
+         wait_readable(client, EXPORTER_CLIENT_TIMEOUT_MS)) {
+    int count = (int)recv(client, exporter->request + received,
+                          (int)(sizeof(exporter->request) - 1 - received), 0);
+
+    if (count <= 0) {
+      break;
+    }
+    received += (size_t)count;
+    exporter->request[received] = '\0';
+    if (strstr(exporter->request, "\r\n\r\n") ||
+        strstr(exporter->request, "\n\n")) {
+      break;
+    }
+  }
+  exporter->request[received] = '\0';
+
+  if (strncmp(exporter->request, "GET ", 4) != 0) {
+    status = "405 Method Not Allowed";
+    content_type = "text/plain; charset=utf-8";
+    body = "method not allowed\n";
+  } else if (strncmp(exporter->request + 4, "/metrics ", 9) != 0 &&
+             strncmp(exporter->request + 4, "/metrics?", 9) != 0) {
+    status = "404 Not Found";
+    content_type = "text/plain; charset=utf-8";
+    body = "not found\n";
+  } else if (parking_exporter_render(exporter->lot, exporter->body,
+                                     PARKING_EXPORTER_BUFFER_SIZE) < 0) {
+    status = "500 Internal Server Error";
+    content_type = "text/plain; charset=utf-8";
+    body = "render failed\n";
+  }
+
+  length = (int)strlen(body);
+  sprintf(header,
+          "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n"
+          "Connection: close\r\n\r\n",
+          status, content_type, length);
+  if (send_all(client, header, strlen(header)) == 0) {
+    send_all(client, body, (size_t)length);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 服务线程入口：循环接受并处理连接，直至收到停止请求。
+ * @param arg 服务句柄。
+ */
+static void exporter_loop(void *arg) {
+  ParkingExporter *exporter = (ParkingExporter *)arg;
+
+  while (!parking_atomic_load_int(&exporter->stopping)) {
+    ExporterSocket client;
+
+    if (!wait_readable(exporter->listener, EXPORTER_POLL_MS)) {
+      continue;
+    }
+    client = accept(exporter->listener, NULL, NULL);
+    if (client == EXPORTER_INVALID_SOCKET) {
+      continue;
+    }
+    serve_client(exporter, client);
+    close_socket(client);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 创建、绑定并监听套接字。
+ * @param host 监听地址。
+ * @param port 监听端口。
+ * @param[out] bound_port 接收实际端口。
+ * @return 成功返回监听套接字，失败返回 EXPORTER_INVALID_SOCKET。
+ */
+static ExporterSocket open_listener(const char *host, int port,
+                                    int *bound_port) {
+  struct sockaddr_in address;
+  ExporterSocklen address_length = (ExporterSocklen)sizeof(address);
+  ExporterSocket listener;
+  int reuse = 1;
+
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons((unsigned short)port);
+  if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+    return EXPORTER_INVALID_SOCKET;
+  }
+  listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener == EXPORTER_INVALID_SOCKET) {
+    return EXPORTER_INVALID_SOCKET;
+  }
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse,
+             sizeof(reuse));
+  if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(listener, 16) != 0 ||
+      getsockname(listener, (struct sockaddr *)&address, &address_length) !=
+          0) {
+    close_socket(listener);
+    return EXPORTER_INVALID_SOCKET;
+  }
+  *bound_port = ntohs(address.sin_port);
+  return listener;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 把停车场与服务层指标渲染为 OpenMetrics 文本。
+ * @param lot 停车场。
+ * @param[out] buffer 接收文本的缓冲区。
+ * @param size 缓冲区大小（字节）。
+ * @return 成功返回写入的字节数；参数无效或缓冲区不足时返回 -1。
+ */
+int parking_exporter_render(const ParkingLot *lot, char *buffer, size_t size) {
+  ExporterWriter writer;
+  ParkingStatistics stats;
+  ParkingMemoryStats memory;
+  ServiceMetrics *metrics;
+
+  if (!lot || !buffer || size == 0) {
+    return -1;
+  }
+  metrics = (ServiceMetrics *)malloc(sizeof(ServiceMetrics));
+  if (!metrics) {
+    return -1;
+  }
+  writer.buffer = buffer;
+  writer.size = size;
+  writer.length = 0;
+  writer.overflow = 0;
+  buffer[0] = '\0';
+
+  /* 先取服务指标，本次抓取读取统计的调用计入下一次抓取 */
+  parking_service_get_metrics(metrics);
+  parking_service_fast_get_statistics(lot, &stats);
+  parking_service_get_memory_stats(lot, &memory);
+  render_lot(&writer, &stats);
+  render_memory(&writer, &memory);
+  if (metrics->enabled) {
+    render_calls(&writer, metrics);
+    render_latency(&writer, metrics);
+  }
+  writer_append(&writer, "# EOF\n");
+  free(metrics);
+
+  if (writer.overflow) {
+    buffer[0] = '\0';
+    return -1;
+  }
+  return (int)writer.length;
+}
+
+/**
+ * @brief 在后台线程上启动 HTTP 导出服务。
+ * @param lot 要导出的停车场。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配。
+ * @return 成功返回服务句柄，失败返回 NULL。
+ */
+ParkingExporter *parking_exporter_start(const ParkingLot *lot,
+                                        const char *host, int port) {
+  ParkingExporter *exporter;
+#ifdef _WIN32
+  WSADATA wsa;
+#endif
+
+  if (!lot || port < 0 || port > 65535) {
+    return NULL;
+  }
+#ifdef _WIN32
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+    return NULL;
+  }
+#endif
+  exporter = (ParkingExporter *)calloc(1, sizeof(ParkingExporter));
+  if (exporter) {
+    exporter->body = (char *)malloc(PARKING_EXPORTER_BUFFER_SIZE);
+    exporter->lot = lot;
+    exporter->listener =
+        open_listener(host ? host : "127.0.0.1", port, &exporter->port);
+  }
+  if (!exporter || !exporter->body ||
+      exporter->listener == EXPORTER_INVALID_SOCKET) {
+    if (exporter) {
+      free(exporter->body);
+      free(exporter);
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return NULL;
+  }
+  exporter->thread = parking_thread_start(exporter_loop, exporter);
+  if (!exporter->thread) {
+    close_socket(exporter->listener);
+    free(exporter->body);
+    free(exporter);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return NULL;
+  }
+  return exporter;
+}
+
+/**
+ * @brief 查询导出服务实际监听的端口。
+ * @param exporter 服务句柄。
+ * @return 端口号；exporter 为 NULL 时返回 0。
+ */
+int parking_exporter_port(const ParkingExporter *exporter) {
+  return exporter ? exporter->port : 0;
+}
+
+/**
+ * @brief 停止导出服务并释放句柄。
+ * @param exporter 服务句柄，可以为 NULL。
+ */
+void parking_exporter_stop(ParkingExporter *exporter) {
+  if (!exporter) {
+    return;
+  }
+  parking_atomic_store_int(&exporter->stopping, 1);
+  parking_thread_join(exporter->thread);
+  close_socket(exporter->listener);
+  free(exporter->body);
+  free(exporter);
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
@@ -0,0 +1,83 @@
+#ifndef PARKING_EXPORTER_H
+#define PARKING_EXPORTER_H
+
+/**
+ * @file parking_exporter.h
+ * @brief OpenMetrics 指标导出模块的公共接口。
+ * @details
+ * 把停车场的占用、收入、内存占用和服务层各操作的调用计数与延迟直方图渲染为
+ * OpenMetrics 文本格式，并可在后台线程上以 HTTP 提供 /metrics 端点。
+ * 渲染只读取原子计数（parking_service_fast_get_statistics 与
+ * parking_service_get_metrics），不获取停车场的读写锁，抓取不会阻塞出入场操作。
+ * 该模块由 CMake 选项 PARKING_EXPORTER 控制是否编入核心库。
+ */
+
+#include <stddef.h>
+
+#include "parking_data.h"
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_EXPORTER_BUFFER_SIZE                                           \
+  (256 * 1024) /**< HTTP 服务渲染一次抓取内容的缓冲区大小（字节） */
+#define PARKING_EXPORTER_CONTENT_TYPE                                          \
+  "application/openmetrics-text; version=1.0.0; charset=utf-8" /**< 响应类型 */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 正在运行的 HTTP 导出服务（不透明类型）。
+ */
+typedef struct ParkingExporter ParkingExporter;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 把停车场与服务层指标渲染为 OpenMetrics 文本。
+ * @details 输出以 "# EOF" 行结尾；没有调用记录的操作不输出。
+ * @param lot 停车场。
+ * @param[out] buffer 接收文本的缓冲区，总是以 '\0' 结尾。
+ * @param size 缓冲区大小（字节）。
+ * @return 成功返回写入的字节数（不含 '\0'）；参数无效或缓冲区不足时返回 -1。
+ */
+int parking_exporter_render(const ParkingLot *lot, char *buffer, size_t size);
+
+/**
+ * @brief 在后台线程上启动 HTTP 导出服务。
+ * @details 服务只响应 GET /metrics，其余路径返回 404；一次处理一个连接。
+ *          停车场在服务停止前必须保持有效。
+ * @param lot 要导出的停车场。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配，可用 parking_exporter_port 查询。
+ * @return 成功返回服务句柄；地址无效、端口被占用或资源不足时返回 NULL。
+ */
+ParkingExporter *parking_exporter_start(const ParkingLot *lot,
+                                        const char *host, int port);
+
+/**
+ * @brief 查询导出服务实际监听的端口。
+ * @param exporter 服务句柄。
+ * @return 端口号；exporter 为 NULL 时返回 0。
+ */
+int parking_exporter_port(const ParkingExporter *exporter);
+
+/**
+ * @brief 停止导出服务并释放句柄。
+ * @details 等待后台线程处理完当前连接后返回。
+ * @param exporter 服务句柄，可以为 NULL。
+ */
+void parking_exporter_stop(ParkingExporter *exporter);
+
+#endif /* PARKING_EXPORTER_H */
@@ -0,0 +1,175 @@
+/**
+ * @file parking_feed.c
+ * @brief 车位变更订阅实现文件
+ * @details
+ * 该文件实现了 parking_feed.h 中声明的变更源：订阅者链表，
+ * 每个订阅者一个以原子下标同步的单生产者单消费者环形队列。
+ */
+
+#include "parking_feed.h"
+#include "parking_thread.h"
+
+/* ========================================================================== */
+/*                               订阅API实现                                  */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个没有订阅者的变更源。
+ * @param memory 分配来源，NULL 表示 C 堆。
+ * @return 成功返回变更源，内存不足返回 NULL。
+ */
+ChangeFeed *change_feed_create(ParkingMemory *memory) {
+  ChangeFeed *feed;
+
+  feed = (ChangeFeed *)parking_memory_calloc(memory, PARKING_MEMORY_INDEX, 1,
+                                             sizeof(ChangeFeed));
+  if (feed == NULL) {
+    return NULL;
+  }
+  feed->next_seq = 1;
+  feed->memory = memory;
+  return feed;
+}
+
+/**
+ * @brief 释放变更源及其全部订阅者的队列。
+ * @param feed 要释放的变更源，可以为 NULL。
+ */
+void change_feed_free(ChangeFeed *feed) {
+  ChangeSubscription *subscription;
+
+  if (feed == NULL) {
+    return;
+  }
+  subscription = feed->subscribers;
+  while (subscription != NULL) {
+    ChangeSubscription *next = subscription->next;
+
+    parking_memory_free(feed->memory, subscription->events);
+    parking_memory_free(feed->memory, subscription);
+    subscription = next;
+  }
+  parking_memory_free(feed->memory, feed);
+}
+
+/**
+ * @brief 新增一个订阅者。
+ * @param feed 目标变更源。
+ * @param capacity 队列至少能容纳的事件数，0 表示默认容量。
+ * @return 成功返回订阅者，内存不足返回 NULL。
+ */
+ChangeSubscription *change_feed_subscribe(ChangeFeed *feed, size_t capacity) {
+  ChangeSubscription *subscription;
+  long slots = 2;
+
+  if (capacity == 0) {
+    capacity = CHANGE_FEED_DEFAULT_CAPACITY;
+  }
+  while ((size_t)slots <= capacity) {
+    if (slots > 0x3FFFFFFFL) {
+      return NULL;
+    }
+    slots *= 2;
+  }
+
+  subscription = (ChangeSubscription *)parking_memory_calloc(
+      feed->memory, PARKING_MEMORY_INDEX, 1, sizeof(ChangeSubscription));
+  if (subscription == NULL) {
+    return NULL;
+  }
+  subscription->events = (ParkingChange *)parking_memory_alloc(
+      feed->memory, PARKING_MEMORY_INDEX,
+      (size_t)slots * sizeof(ParkingChange));
+  if (subscription->events == NULL) {
+    parking_memory_free(feed->memory, subscription);
+    return NULL;
+  }
+  subscription->capacity = slots;
+  subscription->next = feed->subscribers;
+  feed->subscribers = subscription;
+  feed->count++;
+  return subscription;
+}
+
+/**
+ * @brief 撤销一个订阅者并释放其队列。
+ * @param feed 目标变更源。
+ * @param subscription 要撤销的订阅者。
+ * @return 成功返回 0，订阅者不属于该变更源返回 -1。
+ */
+int change_feed_unsubscribe(ChangeFeed *feed,
+                            ChangeSubscription *subscription) {
+  ChangeSubscription **link = &feed->subscribers;
+
+  while (*link != NULL && *link != subscription) {
+    link = &(*link)->next;
+  }
+  if (*link == NULL) {
+    return -1;
+  }
+  *link = subscription->next;
+  feed->count--;
+  parking_memory_free(feed->memory, subscription->events);
+  parking_memory_free(feed->memory, subscription);
+  return 0;
+}
+
+/**
+ * @brief 为事件分配序号，并追加到每个订阅者的队列。
+ * @details 先写入事件再发布 head，消费者看到新的 head 时事件内容已经完整。
+ * @param feed 目标变更源。
+ * @param change 事件内容。
+ */
+void change_feed_publish(ChangeFeed *feed, const ParkingChange *change) {
+  ChangeSubscription *subscription;
+  unsigned long seq = feed->next_seq++;
+
+  for (subscription = feed->subscribers; subscription != NULL;
+       subscription = subscription->next) {
+    long mask = subscription->capacity - 1;
+    long head = subscription->head;
+    long next = (head + 1) & mask;
+
+    if (next == parking_atomic_load_long(&subscription->tail)) {
+      parking_atomic_add_int(&subscription->dropped, 1);
+      continue;
+    }
+    subscription->events[head] = *change;
+    subscription->events[head].seq = seq;
+    parking_atomic_store_long(&subscription->head, next);
+  }
+}
+
+/**
+ * @brief 从订阅者的队列中按顺序取出事件。
+ * @param subscription 订阅者。
+ * @param[out] changes 接收事件的数组。
+ * @param max 数组容量。
+ * @return 取出的事件数。
+ */
+int change_feed_poll(ChangeSubscription *subscription, ParkingChange *changes,
+                     int max) {
+  long mask = subscription->capacity - 1;
+  long tail = subscription->tail;
+  long head = parking_atomic_load_long(&subscription->head);
+  int count = 0;
+
+  while (count < max && tail != head) {
+    changes[count++] = subscription->events[tail];
+    tail = (tail + 1) & mask;
+  }
+  if (count > 0) {
+    /* 读完事件内容后才归还位置，生产者不会覆盖尚未读出的事件 */
+    parking_atomic_store_long(&subscription->tail, tail);
+  }
+  return count;
+}
+
+/**
+ * @brief 取走并清零订阅者因队列满丢弃的事件数。
+ * @param subscription 订阅者。
+ * @return 上次调用以来丢弃的事件数。
+ */
+int change_feed_take_dropped(ChangeSubscription *subscription) {
+  return parking_atomic_exchange_int(&subscription->dropped, 0);
+}
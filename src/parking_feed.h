@@ -0,0 +1,123 @@
+#ifndef PARKING_FEED_H
+#define PARKING_FEED_H
+
+#include <stddef.h>
+
+#include "parking_data.h"
+#include "parking_memory.h"
+
+/**
+ * @file parking_feed.h
+ * @brief 车位变更订阅（每个订阅者一个单生产者单消费者环形队列）的声明。
+ * @details
+ * 数据层每完成一次修改（添加、删除车位，入场、出场，修改信息，热字段同步）
+ * 就向每个订阅者的环形队列追加一条紧凑的 ParkingChange。修改总在停车场的
+ * 写锁内进行，因此每个队列只有一个生产者；消费者是订阅者自己的线程，
+ * 取事件不需要停车场的锁，也不会阻塞入场出场。
+ *
+ * 队列满时新事件被丢弃并计入 dropped，生产者从不等待消费者；
+ * 消费者发现有丢弃时应重新读取一次完整列表，再继续处理增量。
+ * 事件序号在停车场内连续递增，也可以据此发现缺口。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define CHANGE_FEED_DEFAULT_CAPACITY 1024 /**< 默认的队列容量（事件数） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个订阅者的环形队列。
+ * @details 队列保留一个空位区分满与空，可存放 capacity - 1 个事件。
+ *          head 只由生产者写，tail 只由消费者写，均以原子操作读写。
+ */
+typedef struct ChangeSubscription {
+  ParkingChange *events;            /**< 事件数组。 */
+  long capacity;                    /**< 数组容量（2 的幂）。 */
+  volatile long head;               /**< 下一个写入位置。 */
+  volatile long tail;               /**< 下一个读取位置。 */
+  volatile int dropped;             /**< 上次取走后因队列满丢弃的事件数。 */
+  struct ChangeSubscription *next;  /**< 订阅者链表的下一个。 */
+} ChangeSubscription;
+
+/**
+ * @brief 停车场的全部订阅者。
+ */
+typedef struct ChangeFeed {
+  ChangeSubscription *subscribers; /**< 订阅者链表。 */
+  int count;                       /**< 订阅者数。 */
+  unsigned long next_seq;          /**< 下一个事件的序号（从 1 开始）。 */
+  ParkingMemory *memory;           /**< 分配来源，NULL 表示 C 堆。 */
+} ChangeFeed;
+
+/**
+ *********************************************************************************
+ *                               订阅API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个没有订阅者的变更源。
+ * @param memory 分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @return 成功返回变更源，内存不足返回 NULL。
+ */
+ChangeFeed *change_feed_create(ParkingMemory *memory);
+
+/**
+ * @brief 释放变更源及其全部订阅者的队列。
+ * @param feed 要释放的变更源，可以为 NULL。
+ */
+void change_feed_free(ChangeFeed *feed);
+
+/**
+ * @brief 新增一个订阅者。
+ * @param feed 目标变更源。
+ * @param capacity 队列至少能容纳的事件数，向上取整为 2 的幂减 1；
+ *        为 0 时使用 CHANGE_FEED_DEFAULT_CAPACITY。
+ * @return 成功返回订阅者，内存不足返回 NULL。
+ */
+ChangeSubscription *change_feed_subscribe(ChangeFeed *feed, size_t capacity);
+
+/**
+ * @brief 撤销一个订阅者并释放其队列。
+ * @details 调用前消费者必须已停止取事件。
+ * @param feed 目标变更源。
+ * @param subscription 要撤销的订阅者。
+ * @return 成功返回 0，订阅者不属于该变更源返回 -1。
+ */
+int change_feed_unsubscribe(ChangeFeed *feed, ChangeSubscription *subscription);
+
+/**
+ * @brief 为事件分配序号，并追加到每个订阅者的队列。
+ * @param feed 目标变更源。
+ * @param change 事件内容，seq 字段被忽略。
+ */
+void change_feed_publish(ChangeFeed *feed, const ParkingChange *change);
+
+/**
+ * @brief 从订阅者的队列中按顺序取出事件。
+ * @details 只能由该订阅者的消费者线程调用，不需要停车场的锁。
+ * @param subscription 订阅者。
+ * @param[out] changes 接收事件的数组。
+ * @param max 数组容量。
+ * @return 取出的事件数。
+ */
+int change_feed_poll(ChangeSubscription *subscription, ParkingChange *changes,
+                     int max);
+
+/**
+ * @brief 取走并清零订阅者因队列满丢弃的事件数。
+ * @param subscription 订阅者。
+ * @return 上次调用以来丢弃的事件数。
+ */
+int change_feed_take_dropped(ChangeSubscription *subscription);
+
+#endif /* PARKING_FEED_H */
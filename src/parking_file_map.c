@@ -0,0 +1,211 @@
+/**
+ * @file parking_file_map.c
+ * @brief 只读文件内存映射实现文件
+ * @details
+ * 该文件实现了 parking_file_map.h 中声明的跨平台文件映射。
+ * 由于核心库按 C90 编译，POSIX 接口需要在包含系统头文件前
+ * 显式开启 _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stddef.h>
+
+#include "parking_file_map.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief 以只读方式将整个文件映射到内存。
+ * @param map 用于接收映射信息的结构体。
+ * @param filename 要映射的文件名。
+ * @return 成功返回 0；文件不存在、为空或平台不支持映射时返回 -1。
+ */
+int file_mapping_open(FileMapping *map, const char *filename) {
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+  LARGE_INTEGER size;
+  void *view;
+#else
+  int fd;
+  struct stat info;
+  void *view;
+#endif
+
+  if (map == NULL || filename == NULL) {
+    return -1;
+  }
+  map->data = NULL;
+  map->size = 0;
+  map->file_handle = NULL;
+  map->mapping_handle = NULL;
+
+#ifdef _WIN32
+  file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return -1;
+  }
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return -1;
+  }
+  mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL) {
+    CloseHandle(file);
+    return -1;
+  }
+  view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == NULL) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return -1;
+  }
+  map->data = (const unsigned char *)view;
+  map->size = (size_t)size.QuadPart;
+  map->file_handle = file;
+  map->mapping_handle = mapping;
+  return 0;
+#else
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    close(fd);
+    return -1;
+  }
+  view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); /* 映射建立后即可关闭文件描述符 */
+  if (view == MAP_FAILED) {
+    return -1;
+  }
+  map->data = (const unsigned char *)view;
+  map->size = (size_t)info.st_size;
+  return 0;
+#endif
+}
+
+/**
+ * @brief 以共享方式映射文件。
+ * @param map 用于接收映射信息的结构体。
+ * @param filename 要映射的文件名。
+ * @param size 可写映射的字节数，0 表示只读映射。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int file_mapping_open_shared(FileMapping *map, const char *filename,
+                             size_t size) {
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+  LARGE_INTEGER length;
+  void *view;
+#else
+  int fd;
+  struct stat info;
+  void *view;
+#endif
+
+  if (map == NULL || filename == NULL) {
+    return -1;
+  }
+  map->data = NULL;
+  map->size = 0;
+  map->file_handle = NULL;
+  map->mapping_handle = NULL;
+
+#ifdef _WIN32
+  file = CreateFileA(filename,
+                     size > 0 ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                     FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                     size > 0 ? OPEN_ALWAYS : OPEN_EXISTING,
+                     FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return -1;
+  }
+  if (size > 0) {
+    length.QuadPart = (LONGLONG)size;
+  } else if (!GetFileSizeEx(file, &length) || length.QuadPart == 0) {
+    CloseHandle(file);
+    return -1;
+  }
+  mapping = CreateFileMappingA(file, NULL,
+                               size > 0 ? PAGE_READWRITE : PAGE_READONLY,
+                               (DWORD)((ULONGLONG)length.QuadPart >> 32),
+                               (DWORD)(length.QuadPart & 0xFFFFFFFF), NULL);
+  if (mapping == NULL) {
+    CloseHandle(file);
+    return -1;
+  }
+  view = MapViewOfFile(mapping, size > 0 ? FILE_MAP_WRITE : FILE_MAP_READ, 0,
+                       0, 0);
+  if (view == NULL) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return -1;
+  }
+  map->data = (const unsigned char *)view;
+  map->size = (size_t)length.QuadPart;
+  map->file_handle = file;
+  map->mapping_handle = mapping;
+  return 0;
+#else
+  fd = size > 0 ? open(filename, O_RDWR | O_CREAT, 0644)
+                : open(filename, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+  if (size > 0 && ftruncate(fd, (off_t)size) != 0) {
+    close(fd);
+    return -1;
+  }
+  if (size == 0) {
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+      close(fd);
+      return -1;
+    }
+    size = (size_t)info.st_size;
+    view = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  } else {
+    view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (view == MAP_FAILED) {
+    return -1;
+  }
+  map->data = (const unsigned char *)view;
+  map->size = size;
+  return 0;
+#endif
+}
+
+/**
+ * @brief 解除文件映射并关闭相关句柄。
+ * @param map 由 file_mapping_open 成功打开的映射，可重复调用。
+ */
+void file_mapping_close(FileMapping *map) {
+  if (map == NULL || map->data == NULL) {
+    return;
+  }
+#ifdef _WIN32
+  UnmapViewOfFile((LPCVOID)map->data);
+  CloseHandle((HANDLE)map->mapping_handle);
+  CloseHandle((HANDLE)map->file_handle);
+#else
+  munmap((void *)map->data, map->size);
+#endif
+  map->data = NULL;
+  map->size = 0;
+  map->file_handle = NULL;
+  map->mapping_handle = NULL;
+}
@@ -0,0 +1,71 @@
+#ifndef PARKING_FILE_MAP_H
+#define PARKING_FILE_MAP_H
+
+#include <stddef.h>
+
+/**
+ * @file parking_file_map.h
+ * @brief 只读文件内存映射的跨平台封装。
+ * @details
+ * POSIX 平台使用 mmap，Windows 平台使用 CreateFileMapping/MapViewOfFile。
+ * 数据层通过它直接在映射内存上校验和解码快照，无需先把文件读入缓冲区，
+ * 操作系统只会调入实际访问到的页。
+ * 共享映射供同一台机器上的多个进程读写同一段内存（见 parking_shm.h），
+ * 文件放在 /dev/shm 等内存文件系统上时不产生磁盘读写。
+ */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个只读文件映射。
+ */
+typedef struct FileMapping {
+  const unsigned char *data; /**< 映射起始地址，未映射时为 NULL。 */
+  size_t size;               /**< 映射的字节数（即文件大小）。 */
+  void *file_handle;    /**< Windows 下的文件句柄，POSIX 下不使用。 */
+  void *mapping_handle; /**< Windows 下的映射对象句柄，POSIX 下不使用。 */
+} FileMapping;
+
+/**
+ *********************************************************************************
+ *                            文件映射API声明
+ *********************************************************************************
+ */
+
+/** @name 文件映射 */
+/** @{ */
+
+/**
+ * @brief 以只读方式将整个文件映射到内存。
+ * @param map 用于接收映射信息的结构体。
+ * @param filename 要映射的文件名。
+ * @return 成功返回 0；文件不存在、为空或平台不支持映射时返回 -1。
+ */
+int file_mapping_open(FileMapping *map, const char *filename);
+
+/**
+ * @brief 解除文件映射并关闭相关句柄。
+ * @param map 由 file_mapping_open 成功打开的映射，可重复调用。
+ */
+void file_mapping_close(FileMapping *map);
+
+/**
+ * @brief 以共享方式映射文件，修改对映射同一文件的其他进程立即可见。
+ * @details size 大于 0 时以读写方式打开，文件不存在则创建，并把文件长度
+ *          设为 size；size 为 0 时以只读方式映射已有的整个文件。
+ *          可写映射的 data 可以转换为非 const 指针写入。
+ * @param map 用于接收映射信息的结构体。
+ * @param filename 要映射的文件名。
+ * @param size 可写映射的字节数，0 表示只读映射。
+ * @return 成功返回 0；无法打开、创建、设置长度或映射时返回 -1。
+ */
+int file_mapping_open_shared(FileMapping *map, const char *filename,
+                             size_t size);
+
+/** @} */
+
+#endif /* PARKING_FILE_MAP_H */
@@ -0,0 +1,163 @@
+/**
+ * @file parking_forecast.c
+ * @brief 短时占用预测的实现文件
+ * @details
+ * 该文件实现了 parking_forecast.h 中声明的占用画像。画像格保存的是
+ * “平均占用率 + 1”，这样 memset 为 0 的画像即为“全部没有数据”，
+ * 不需要额外的标志位。
+ */
+
+#include <string.h>
+
+#include "parking_forecast.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+/** 各预测时长对应的刻钟数（15、30、60 分钟）。 */
+static const int forecast_steps[FORECAST_HORIZONS] = {1, 2, 4};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 把一个占用率样本计入画像格。
+ * @param forecast 目标画像。
+ * @param cell 画像格。
+ * @param rate 占用率（万分之一）。
+ */
+static void fold_sample(OccupancyForecast *forecast, int cell, int rate) {
+  int average;
+
+  if (forecast->profile[cell] == 0) {
+    forecast->profile[cell] = (unsigned short)(rate + 1);
+    return;
+  }
+  average = (int)forecast->profile[cell] - 1;
+  /* 右移对负数的取整方向由实现决定，这里对差值的绝对值移位 */
+  if (rate >= average) {
+    average += (rate - average) >> FORECAST_EWMA_SHIFT;
+  } else {
+    average -= (average - rate) >> FORECAST_EWMA_SHIFT;
+  }
+  forecast->profile[cell] = (unsigned short)(average + 1);
+}
+
+/**
+ * @brief (静态辅助函数) 按当前画像格重新计算各预测时长的占用率变化。
+ * @param forecast 目标画像。
+ */
+static void refresh_deltas(OccupancyForecast *forecast) {
+  int base = forecast->profile[forecast->cell];
+  int i;
+
+  for (i = 0; i < FORECAST_HORIZONS; i++) {
+    int target = forecast->profile[(forecast->cell + forecast_steps[i]) %
+                                   FORECAST_PROFILE_CELLS];
+
+    forecast->deltas[i] = base != 0 && target != 0 ? target - base : 0;
+  }
+}
+
+/* ========================================================================== */
+/*                              占用预测API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 取某个预测时长的分钟数。
+ * @param horizon 预测时长的下标。
+ * @return 分钟数，下标无效返回 0。
+ */
+int forecast_horizon_minutes(int horizon) {
+  if (horizon < 0 || horizon >= FORECAST_HORIZONS) {
+    return 0;
+  }
+  return forecast_steps[horizon] * (FORECAST_QUARTER_SECONDS / 60);
+}
+
+/**
+ * @brief 初始化（清空）占用画像。
+ * @param forecast 目标画像。
+ */
+void forecast_init(OccupancyForecast *forecast) {
+  memset(forecast, 0, sizeof(*forecast));
+}
+
+/**
+ * @brief 记录一次占用变化后的占用数。
+ * @param forecast 目标画像。
+ * @param when 观测所在的刻钟。
+ * @param occupied 当前占用数。
+ * @param total 车位总数。
+ */
+void forecast_observe(OccupancyForecast *forecast, const ForecastTime *when,
+                      int occupied, int total) {
+  int rate = 0;
+
+  if (forecast == NULL || when == NULL || when->quarter <= 0 ||
+      when->cell < 0 || when->cell >= FORECAST_PROFILE_CELLS) {
+    return;
+  }
+  if (total > 0 && occupied > 0) {
+    rate = occupied >= total
+               ? FORECAST_RATE_SCALE
+               : (int)((long)occupied * FORECAST_RATE_SCALE / total);
+  }
+
+  if (forecast->quarter == 0 || when->quarter < forecast->quarter) {
+    forecast->quarter = when->quarter;
+    forecast->cell = when->cell;
+    refresh_deltas(forecast);
+  } else if (when->quarter > forecast->quarter) {
+    long steps = when->quarter - forecast->quarter;
+    long k;
+
+    /* 跳过的刻钟里占用没有变化，都按上一次观测的占用率计入 */
+    if (steps > FORECAST_PROFILE_CELLS) {
+      steps = FORECAST_PROFILE_CELLS;
+    }
+    for (k = 1; k <= steps; k++) {
+      fold_sample(forecast,
+                  (int)((forecast->cell + k) % FORECAST_PROFILE_CELLS),
+                  forecast->last_rate);
+    }
+    forecast->quarter = when->quarter;
+    forecast->cell = when->cell;
+    refresh_deltas(forecast);
+  }
+  forecast->last_rate = rate;
+}
+
+/**
+ * @brief 预测若干分钟后的占用数。
+ * @param forecast 目标画像。
+ * @param horizon 预测时长的下标。
+ * @param occupied 当前占用数。
+ * @param total 车位总数。
+ * @return 预测的占用数。
+ */
+int forecast_predict(const OccupancyForecast *forecast, int horizon,
+                     int occupied, int total) {
+  long change;
+  long predicted;
+
+  if (forecast == NULL || horizon < 0 || horizon >= FORECAST_HORIZONS ||
+      total <= 0) {
+    return occupied;
+  }
+  change = (long)forecast->deltas[horizon] * total;
+  /* 四舍五入到整车位 */
+  change = change >= 0
+               ? (change + FORECAST_RATE_SCALE / 2) / FORECAST_RATE_SCALE
+               : -((-change + FORECAST_RATE_SCALE / 2) / FORECAST_RATE_SCALE);
+  predicted = (long)occupied + change;
+  if (predicted < 0) {
+    predicted = 0;
+  }
+  if (predicted > total) {
+    predicted = total;
+  }
+  return (int)predicted;
+}
@@ -0,0 +1,104 @@
+#ifndef PARKING_FORECAST_H
+#define PARKING_FORECAST_H
+
+/**
+ * @file parking_forecast.h
+ * @brief 短时占用预测的结构与接口声明。
+ * @details
+ * 引导屏与动态定价需要知道 15、30、60 分钟后大约会有多少车位被占用。
+ * 预测以“按星期几与一天中的刻钟”划分的占用率画像为依据：一周共
+ * FORECAST_PROFILE_CELLS 个刻钟格，每个格保存该刻钟开始时占用率的
+ * 指数加权平均。预测值为当前占用数加上画像中从当前刻钟到目标刻钟的
+ * 占用率变化，即“现状 + 历史上这段时间的典型变化”；画像中还没有数据的
+ * 格按占用不变处理。
+ *
+ * 画像只在刻钟切换时更新：每次占用变化时检查刻钟是否已切换，切换时把
+ * 上一时刻的占用率计入新刻钟的格（中间没有变化的刻钟一并计入），并重新
+ * 计算各预测时长的占用率变化缓存。查询只是一次乘加，不扫描画像。
+ * 画像只保存在内存中，不写入快照；结构本身不加锁，由停车场的锁保护。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define FORECAST_QUARTER_SECONDS 900 /**< 一个刻钟的秒数 */
+#define FORECAST_QUARTERS_PER_DAY 96 /**< 每天的刻钟数 */
+#define FORECAST_PROFILE_CELLS (7 * FORECAST_QUARTERS_PER_DAY) /**< 格数 */
+#define FORECAST_HORIZONS 3          /**< 预测时长数（15、30、60 分钟） */
+#define FORECAST_RATE_SCALE 10000    /**< 占用率的定点比例（万分之一） */
+#define FORECAST_EWMA_SHIFT 2        /**< 加权平均的新样本权重为 1/4 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一次观测所在的刻钟。
+ */
+typedef struct ForecastTime {
+  long quarter; /**< 自 Unix 纪元起的刻钟编号。 */
+  int cell;     /**< 画像格：星期几（周一为 0）× 96 + 当天的刻钟。 */
+} ForecastTime;
+
+/**
+ * @brief 一个分区（或整个停车场）的占用画像与预测缓存。
+ * @details 全部字段为 0 即为空画像，可以直接 memset 初始化。
+ */
+typedef struct OccupancyForecast {
+  /** 各格占用率的平均值加 1（万分之一），0 表示该格还没有数据。 */
+  unsigned short profile[FORECAST_PROFILE_CELLS];
+  long quarter;                  /**< 最近一次观测的刻钟编号，0 表示尚无。 */
+  int cell;                      /**< 最近一次观测的画像格。 */
+  int last_rate;                 /**< 最近一次观测的占用率（万分之一）。 */
+  int deltas[FORECAST_HORIZONS]; /**< 各预测时长的占用率变化缓存。 */
+} OccupancyForecast;
+
+/**
+ *********************************************************************************
+ *                              占用预测API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 取某个预测时长的分钟数。
+ * @param horizon 预测时长的下标（0 到 FORECAST_HORIZONS - 1）。
+ * @return 分钟数（15、30 或 60），下标无效返回 0。
+ */
+int forecast_horizon_minutes(int horizon);
+
+/**
+ * @brief 初始化（清空）占用画像。
+ * @param forecast 目标画像。
+ */
+void forecast_init(OccupancyForecast *forecast);
+
+/**
+ * @brief 记录一次占用变化后的占用数。
+ * @details 刻钟未切换时只记下占用率；切换时先把上一次观测的占用率计入
+ *          其后每个刻钟的格（最多一周），再更新预测缓存。时间倒退时
+ *          只重新对齐刻钟，不更新画像。
+ * @param forecast 目标画像。
+ * @param when 观测所在的刻钟。
+ * @param occupied 当前占用数。
+ * @param total 车位总数。
+ */
+void forecast_observe(OccupancyForecast *forecast, const ForecastTime *when,
+                      int occupied, int total);
+
+/**
+ * @brief 预测若干分钟后的占用数。
+ * @param forecast 目标画像。
+ * @param horizon 预测时长的下标。
+ * @param occupied 当前占用数。
+ * @param total 车位总数。
+ * @return 预测的占用数，限制在 [0, total] 内；下标无效时返回 occupied。
+ */
+int forecast_predict(const OccupancyForecast *forecast, int horizon,
+                     int occupied, int total);
+
+#endif /* PARKING_FORECAST_H */
@@ -0,0 +1,867 @@
+/**
+ * @file parking_history.c
+ * @brief 已完成停车记录的列式追加存储实现文件
+ * @details
+ * 该文件实现了 parking_history.h 中声明的列文件读写、区块索引维护、
+ * 压缩模式下的区块封存，以及按时间区间的列扫描。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_codec.h"
+#include "parking_compress.h"
+#include "parking_durable_file.h"
+#include "parking_history.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define HISTORY_HEADER_SIZE 8 /**< 列文件头（魔数）的字节数 */
+#define HISTORY_MAX_WIDTH 8   /**< 最宽一列的字节数 */
+#define HISTORY_TAIL_HEADER_SIZE 12  /**< 尾部文件头的字节数 */
+#define HISTORY_FRAME_HEADER_SIZE 12 /**< 帧头的字节数 */
+/** 一列一个区块的最大原始字节数。 */
+#define HISTORY_BLOCK_BYTES (HISTORY_BLOCK_RECORDS * HISTORY_MAX_WIDTH)
+/** 一帧压缩数据的最大字节数，与 compress_bound(HISTORY_BLOCK_BYTES) 相同。 */
+#define HISTORY_FRAME_MAX (HISTORY_BLOCK_BYTES + HISTORY_BLOCK_BYTES / 255 + 16)
+
+/** 各列值的字节数，按 HistoryColumn 顺序排列。 */
+static const size_t column_width[HISTORY_COLUMN_COUNT] = {4, 4, 1, 8, 8, 4};
+
+/** 各列文件名的后缀，按 HistoryColumn 顺序排列。 */
+static const char *const column_suffix[HISTORY_COLUMN_COUNT] = {
+    ".plate", ".slot", ".type", ".entry", ".exit", ".fee"};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 拼接某一列的文件路径。
+ * @param[out] path 接收路径的缓冲区（HISTORY_MAX_PATH 字节）。
+ * @param prefix 列文件路径前缀，长度已由调用者检查。
+ * @param column 列。
+ */
+static void column_path(char *path, const char *prefix, int column) {
+  strcpy(path, prefix);
+  strcat(path, column_suffix[column]);
+}
+
+/**
+ * @brief (静态辅助函数) 拼接某一列帧文件的路径。
+ * @param[out] path 接收路径的缓冲区（HISTORY_MAX_PATH 字节）。
+ * @param prefix 列文件路径前缀，长度已由调用者检查。
+ * @param column 列。
+ */
+static void frame_path(char *path, const char *prefix, int column) {
+  column_path(path, prefix, column);
+  strcat(path, HISTORY_FRAME_SUFFIX);
+}
+
+/**
+ * @brief (静态辅助函数) 计算第 index 条记录在某列（尾部）文件中的偏移。
+ * @details 压缩模式下尾部文件从 tail_base 区块开始，调用者保证记录不早于它。
+ * @param history 目标存储。
+ * @param index 记录序号。
+ * @param column 列。
+ * @return 文件偏移。
+ */
+static long column_offset(const SessionHistory *history, unsigned long index,
+                          int column) {
+  if (!history->compressed) {
+    return HISTORY_HEADER_SIZE + (long)(index * column_width[column]);
+  }
+  return HISTORY_TAIL_HEADER_SIZE +
+         (long)((index - history->tail_base[column] * HISTORY_BLOCK_RECORDS) *
+                column_width[column]);
+}
+
+/**
+ * @brief (静态辅助函数) 由已有的列文件判断存储是否为压缩模式。
+ * @param prefix 列文件路径前缀。
+ * @param compressed 没有任何列文件时采用的模式。
+ * @return 压缩模式返回 1，否则返回 0。
+ */
+static int detect_mode(const char *prefix, int compressed) {
+  char path[HISTORY_MAX_PATH];
+  char magic[HISTORY_HEADER_SIZE];
+  int column;
+
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    FILE *file;
+
+    column_path(path, prefix, column);
+    file = fopen(path, "rb");
+    if (file == NULL) {
+      continue;
+    }
+    if (fread(magic, 1, HISTORY_HEADER_SIZE, file) == HISTORY_HEADER_SIZE) {
+      fclose(file);
+      return memcmp(magic, HISTORY_TAIL_MAGIC, HISTORY_HEADER_SIZE) == 0;
+    }
+    fclose(file);
+  }
+  return compressed;
+}
+
+/**
+ * @brief (静态辅助函数) 打开（必要时创建）一个列文件并取得其中的值个数。
+ * @param path 列文件路径。
+ * @param column 列。
+ * @param compressed 非 0 表示压缩模式的尾部文件。
+ * @param[out] count 接收文件中完整的值个数。
+ * @param[out] base 接收尾部文件的起始区块号，普通模式为 0。
+ * @return 成功返回以读写方式打开的文件，不是有效列文件或无法打开时返回 NULL。
+ */
+static FILE *open_column(const char *path, int column, int compressed,
+                         unsigned long *count, unsigned long *base) {
+  unsigned char header[HISTORY_TAIL_HEADER_SIZE];
+  size_t header_size =
+      compressed ? HISTORY_TAIL_HEADER_SIZE : HISTORY_HEADER_SIZE;
+  const char *magic = compressed ? HISTORY_TAIL_MAGIC : HISTORY_MAGIC;
+  FILE *file = fopen(path, "r+b");
+  long size;
+
+  *base = 0;
+  if (file == NULL) {
+    file = fopen(path, "w+b");
+    if (file == NULL) {
+      return NULL;
+    }
+    memcpy(header, magic, HISTORY_HEADER_SIZE);
+    codec_put_u32(header + HISTORY_HEADER_SIZE, 0);
+    if (fwrite(header, 1, header_size, file) != header_size ||
+        fflush(file) != 0) {
+      fclose(file);
+      return NULL;
+    }
+    *count = 0;
+    return file;
+  }
+
+  if (fread(header, 1, header_size, file) != header_size ||
+      memcmp(header, magic, HISTORY_HEADER_SIZE) != 0 ||
+      fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0) {
+    fclose(file); /* 不是列文件，拒绝覆盖 */
+    return NULL;
+  }
+  if (compressed) {
+    *base = codec_get_u32(header + HISTORY_HEADER_SIZE);
+  }
+  *count = (unsigned long)(size - (long)header_size) / column_width[column];
+  return file;
+}
+
+/**
+ * @brief (静态辅助函数) 确保各列的帧偏移数组至少能容纳 entries 项。
+ * @param history 目标存储。
+ * @param entries 需要的项数。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int frames_reserve(SessionHistory *history, size_t entries) {
+  size_t capacity;
+  int column;
+
+  if (entries <= history->frame_capacity) {
+    return 0;
+  }
+  capacity = history->frame_capacity ? history->frame_capacity * 2 : 16;
+  while (capacity < entries) {
+    capacity *= 2;
+  }
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    long *offsets = (long *)realloc(history->frame_offsets[column],
+                                    capacity * sizeof(long));
+
+    if (offsets == NULL) {
+      return -1;
+    }
+    history->frame_offsets[column] = offsets;
+  }
+  history->frame_capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 打开（必要时创建）一个帧文件并登记其中完整的帧。
+ * @details 从头依次检查帧头，遇到区块号不连续或数据不完整的帧即停止，
+ *          崩溃留下的残帧由下一次封存覆盖。
+ * @param history 目标存储。
+ * @param path 帧文件路径。
+ * @param column 列。
+ * @param[out] count 接收完整的帧数。
+ * @return 成功返回以读写方式打开的文件；不是有效帧文件、无法打开或
+ *         内存不足时返回 NULL。
+ */
+static FILE *open_frames(SessionHistory *history, const char *path,
+                         int column, size_t *count) {
+  unsigned char header[HISTORY_FRAME_HEADER_SIZE];
+  FILE *file = fopen(path, "r+b");
+  long offset = HISTORY_HEADER_SIZE;
+  long size;
+
+  *count = 0;
+  if (file == NULL) {
+    file = fopen(path, "w+b");
+    if (file == NULL) {
+      return NULL;
+    }
+    if (fwrite(HISTORY_FRAME_MAGIC, 1, HISTORY_HEADER_SIZE, file) !=
+            HISTORY_HEADER_SIZE ||
+        fflush(file) != 0) {
+      fclose(file);
+      return NULL;
+    }
+  } else if (fread(header, 1, HISTORY_HEADER_SIZE, file) !=
+                 HISTORY_HEADER_SIZE ||
+             memcmp(header, HISTORY_FRAME_MAGIC, HISTORY_HEADER_SIZE) != 0) {
+    fclose(file);
+    return NULL;
+  }
+  if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 ||
+      frames_reserve(history, 1) != 0) {
+    fclose(file);
+    return NULL;
+  }
+
+  history->frame_offsets[column][0] = offset;
+  while (size - offset >= HISTORY_FRAME_HEADER_SIZE &&
+         fseek(file, offset, SEEK_SET) == 0 &&
+         fread(header, 1, HISTORY_FRAME_HEADER_SIZE, file) ==
+             HISTORY_FRAME_HEADER_SIZE) {
+    unsigned long packed_size = codec_get_u32(header + 4);
+
+    if (codec_get_u32(header) != (unsigned long)*count ||
+        packed_size > HISTORY_FRAME_MAX ||
+        (unsigned long)(size - offset - HISTORY_FRAME_HEADER_SIZE) <
+            packed_size) {
+      break;
+    }
+    if (frames_reserve(history, *count + 2) != 0) {
+      fclose(file);
+      return NULL;
+    }
+    offset += HISTORY_FRAME_HEADER_SIZE + (long)packed_size;
+    history->frame_offsets[column][++*count] = offset;
+  }
+  return file;
+}
+
+/**
+ * @brief (静态辅助函数) 读取某一列一个区块中的前 count 个值。
+ * @details 已封存的区块从帧文件解压并校验，其余区块从尾部文件直接读取。
+ * @param history 目标存储。
+ * @param tail 该列的尾部文件（普通模式即列文件）。
+ * @param frames 该列的帧文件，普通模式下不使用。
+ * @param column 列。
+ * @param block 区块号。
+ * @param count 要读取的值个数；已封存的区块必须为 HISTORY_BLOCK_RECORDS。
+ * @param[out] buffer 接收定宽的列值。
+ * @return 成功返回 0，读取失败或帧损坏返回 -1。
+ */
+static int read_column_block(const SessionHistory *history, FILE *tail,
+                             FILE *frames, int column, size_t block,
+                             unsigned long count, unsigned char *buffer) {
+  unsigned char frame[HISTORY_FRAME_HEADER_SIZE + HISTORY_FRAME_MAX];
+  size_t raw_size = (size_t)count * column_width[column];
+  size_t packed_size;
+  size_t out_size;
+
+  if (!history->compressed || block >= history->sealed_blocks) {
+    if (tail == NULL ||
+        fseek(tail,
+              column_offset(history,
+                            (unsigned long)block * HISTORY_BLOCK_RECORDS,
+                            column),
+              SEEK_SET) != 0 ||
+        fread(buffer, column_width[column], (size_t)count, tail) !=
+            (size_t)count) {
+      return -1;
+    }
+    return 0;
+  }
+
+  if (frames == NULL ||
+      fseek(frames, history->frame_offsets[column][block], SEEK_SET) != 0 ||
+      fread(frame, 1, HISTORY_FRAME_HEADER_SIZE, frames) !=
+          HISTORY_FRAME_HEADER_SIZE) {
+    return -1;
+  }
+  packed_size = (size_t)codec_get_u32(frame + 4);
+  if (codec_get_u32(frame) != (unsigned long)block ||
+      packed_size > HISTORY_FRAME_MAX ||
+      fread(frame + HISTORY_FRAME_HEADER_SIZE, 1, packed_size, frames) !=
+          packed_size) {
+    return -1;
+  }
+  if (packed_size == raw_size) {
+    memcpy(buffer, frame + HISTORY_FRAME_HEADER_SIZE, raw_size);
+  } else if (decompress_block(frame + HISTORY_FRAME_HEADER_SIZE, packed_size,
+                              buffer, raw_size, &out_size) != 0 ||
+             out_size != raw_size) {
+    return -1;
+  }
+  return codec_get_u32(frame + 8) == codec_checksum(buffer, raw_size) ? 0 : -1;
+}
+
+/**
+ * @brief (静态辅助函数) 把一条记录的出场时间计入区块索引。
+ * @param history 目标存储。
+ * @param index 记录序号。
+ * @param exit_time 出场时间。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int blocks_account(SessionHistory *history, unsigned long index,
+                          time_t exit_time) {
+  size_t block = (size_t)(index / HISTORY_BLOCK_RECORDS);
+  HistoryBlock *entry;
+
+  if (block == history->block_count) {
+    if (history->block_count == history->block_capacity) {
+      size_t capacity =
+          history->block_capacity ? history->block_capacity * 2 : 16;
+      HistoryBlock *blocks = (HistoryBlock *)realloc(
+          history->blocks, capacity * sizeof(HistoryBlock));
+
+      if (blocks == NULL) {
+        return -1;
+      }
+      history->blocks = blocks;
+      history->block_capacity = capacity;
+    }
+    entry = &history->blocks[history->block_count++];
+    entry->min_exit = exit_time;
+    entry->max_exit = exit_time;
+    return 0;
+  }
+
+  entry = &history->blocks[block];
+  if (exit_time < entry->min_exit) {
+    entry->min_exit = exit_time;
+  }
+  if (exit_time > entry->max_exit) {
+    entry->max_exit = exit_time;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 读取出场时间列，重建区块索引。
+ * @param history 目标存储，record_count 已确定。
+ * @return 成功返回 0，读取失败或内存不足返回 -1。
+ */
+static int load_blocks(SessionHistory *history) {
+  unsigned char buffer[HISTORY_BLOCK_RECORDS * 8];
+  unsigned long index = 0;
+
+  while (index < history->record_count) {
+    unsigned long batch = history->record_count - index;
+    unsigned long i;
+
+    if (batch > HISTORY_BLOCK_RECORDS) {
+      batch = HISTORY_BLOCK_RECORDS;
+    }
+    if (read_column_block(history, history->columns[HISTORY_COL_EXIT],
+                          history->frames[HISTORY_COL_EXIT], HISTORY_COL_EXIT,
+                          (size_t)(index / HISTORY_BLOCK_RECORDS), batch,
+                          buffer) != 0) {
+      return -1;
+    }
+    for (i = 0; i < batch; i++) {
+      if (blocks_account(history, index + i, codec_get_time(buffer + i * 8)) !=
+          0) {
+        return -1;
+      }
+    }
+    index += batch;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 把记录中某一列的值编码为定宽字节。
+ * @param buffer 目标缓冲区（至少 HISTORY_MAX_WIDTH 字节）。
+ * @param record 源记录。
+ * @param column 列。
+ */
+static void encode_column(unsigned char *buffer, const SessionRecord *record,
+                          int column) {
+  switch (column) {
+  case HISTORY_COL_PLATE:
+    codec_put_u32(buffer, record->plate_hash);
+    break;
+  case HISTORY_COL_SLOT:
+    codec_put_i32(buffer, record->slot_id);
+    break;
+  case HISTORY_COL_TYPE:
+    buffer[0] = (unsigned char)record->type;
+    break;
+  case HISTORY_COL_ENTRY:
+    codec_put_time(buffer, record->entry_time);
+    break;
+  case HISTORY_COL_EXIT:
+    codec_put_time(buffer, record->exit_time);
+    break;
+  default:
+    codec_put_i32(buffer, (int)record->fee_cents);
+    break;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 把定宽字节解码到记录中对应的字段。
+ * @param buffer 源字节。
+ * @param[out] record 目标记录。
+ * @param column 列。
+ */
+static void decode_column(const unsigned char *buffer, SessionRecord *record,
+                          int column) {
+  switch (column) {
+  case HISTORY_COL_PLATE:
+    record->plate_hash = codec_get_u32(buffer);
+    break;
+  case HISTORY_COL_SLOT:
+    record->slot_id = codec_get_i32(buffer);
+    break;
+  case HISTORY_COL_TYPE:
+    record->type = (ParkingType)buffer[0];
+    break;
+  case HISTORY_COL_ENTRY:
+    record->entry_time = codec_get_time(buffer);
+    break;
+  case HISTORY_COL_EXIT:
+    record->exit_time = codec_get_time(buffer);
+    break;
+  default:
+    record->fee_cents = codec_get_i32(buffer);
+    break;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 把第一个未封存的区块压缩追加到各列的帧文件。
+ * @details 每列的帧写完后落盘，全部列写完才计入 sealed_blocks。
+ * @param history 压缩模式的存储，该区块已经写满。
+ * @return 成功返回 0，读写失败或内存不足返回 -1。
+ */
+static int seal_block(SessionHistory *history) {
+  unsigned char raw[HISTORY_BLOCK_BYTES];
+  unsigned char frame[HISTORY_FRAME_HEADER_SIZE + HISTORY_FRAME_MAX];
+  size_t block = history->sealed_blocks;
+  int column;
+
+  if (frames_reserve(history, block + 2) != 0) {
+    return -1;
+  }
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    size_t raw_size = HISTORY_BLOCK_RECORDS * column_width[column];
+    long offset = history->frame_offsets[column][block];
+    size_t packed_size;
+
+    if (read_column_block(history, history->columns[column], NULL, column,
+                          block, HISTORY_BLOCK_RECORDS, raw) != 0) {
+      return -1;
+    }
+    packed_size = compress_block(raw, raw_size,
+                                 frame + HISTORY_FRAME_HEADER_SIZE,
+                                 HISTORY_FRAME_MAX);
+    if (packed_size == 0 || packed_size >= raw_size) {
+      memcpy(frame + HISTORY_FRAME_HEADER_SIZE, raw, raw_size);
+      packed_size = raw_size;
+    }
+    codec_put_u32(frame, (unsigned long)block);
+    codec_put_u32(frame + 4, (unsigned long)packed_size);
+    codec_put_u32(frame + 8, codec_checksum(raw, raw_size));
+    if (fseek(history->frames[column], offset, SEEK_SET) != 0 ||
+        fwrite(frame, 1, HISTORY_FRAME_HEADER_SIZE + packed_size,
+               history->frames[column]) !=
+            HISTORY_FRAME_HEADER_SIZE + packed_size ||
+        durable_file_sync(history->frames[column]) != 0) {
+      return -1;
+    }
+    history->frame_offsets[column][block + 1] =
+        offset + (long)(HISTORY_FRAME_HEADER_SIZE + packed_size);
+  }
+  history->sealed_blocks++;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 把一列的尾部文件换成从第一个未封存区块开始的新文件。
+ * @details 新文件先写入临时文件再原子替换，替换失败时旧文件保持可用。
+ *          Windows 下打开着的文件不能被替换，因此先关闭旧文件再提交。
+ * @param history 压缩模式的存储。
+ * @param column 列。
+ * @return 成功返回 0，读写失败或内存不足返回 -1。
+ */
+static int rebase_tail(SessionHistory *history, int column) {
+  char path[HISTORY_MAX_PATH];
+  unsigned char header[HISTORY_TAIL_HEADER_SIZE];
+  unsigned long first =
+      (unsigned long)history->sealed_blocks * HISTORY_BLOCK_RECORDS;
+  unsigned long keep = history->record_count - first;
+  size_t width = column_width[column];
+  unsigned char *values;
+  DurableFile file;
+  int result;
+
+  values = (unsigned char *)malloc(keep ? (size_t)keep * width : 1);
+  if (values == NULL) {
+    return -1;
+  }
+  if (keep > 0 &&
+      (fseek(history->columns[column], column_offset(history, first, column),
+             SEEK_SET) != 0 ||
+       fread(values, width, (size_t)keep, history->columns[column]) !=
+           (size_t)keep)) {
+    free(values);
+    return -1;
+  }
+
+  column_path(path, history->prefix, column);
+  memcpy(header, HISTORY_TAIL_MAGIC, HISTORY_HEADER_SIZE);
+  codec_put_u32(header + HISTORY_HEADER_SIZE,
+                (unsigned long)history->sealed_blocks);
+  if (durable_file_open(&file, path, "wb") != 0) {
+    free(values);
+    return -1;
+  }
+  if (fwrite(header, 1, HISTORY_TAIL_HEADER_SIZE, file.stream) !=
+          HISTORY_TAIL_HEADER_SIZE ||
+      fwrite(values, width, (size_t)keep, file.stream) != (size_t)keep) {
+    durable_file_abort(&file);
+    free(values);
+    return -1;
+  }
+  free(values);
+
+  fclose(history->columns[column]);
+  result = durable_file_commit(&file);
+  history->columns[column] = fopen(path, "r+b");
+  if (history->columns[column] == NULL) {
+    return -1;
+  }
+  if (result == 0) {
+    history->tail_base[column] = (unsigned long)history->sealed_blocks;
+  }
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 封存所有已写满的区块，并整理落后的尾部文件。
+ * @param history 压缩模式的存储。
+ * @return 成功返回 0，任一步失败返回 -1（已完成的步骤保留）。
+ */
+static int seal_blocks(SessionHistory *history) {
+  int column;
+
+  while (history->record_count >=
+         (unsigned long)(history->sealed_blocks + 1) * HISTORY_BLOCK_RECORDS) {
+    if (seal_block(history) != 0) {
+      return -1;
+    }
+  }
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    if (history->columns[column] == NULL ||
+        (history->tail_base[column] < history->sealed_blocks &&
+         rebase_tail(history, column) != 0)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* ========================================================================== */
+/*                               停车记录函数实现                             */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 打开（必要时创建）一组列文件并重建区块索引。
+ * @details 已有列文件时按其格式打开，否则按 compressed 新建。压缩模式下
+ *          以各列都已写完的帧数为封存区块数，起始区块晚于它的尾部文件
+ *          说明文件组不完整，拒绝打开。
+ * @param prefix 列文件路径前缀。
+ * @param compressed 新建时是否使用压缩模式。
+ * @return 成功返回新分配的存储对象，失败返回 NULL。
+ */
+static SessionHistory *open_history(const char *prefix, int compressed) {
+  char path[HISTORY_MAX_PATH];
+  size_t frame_counts[HISTORY_COLUMN_COUNT];
+  SessionHistory *history;
+  size_t length;
+  int column;
+
+  if (prefix == NULL ||
+      (length = strlen(prefix)) + strlen(".plate") >= HISTORY_MAX_PATH) {
+    return NULL;
+  }
+  compressed = detect_mode(prefix, compressed);
+  if (compressed && length + strlen(".plate") + strlen(HISTORY_FRAME_SUFFIX) >=
+                        HISTORY_MAX_PATH) {
+    return NULL;
+  }
+
+  history = (SessionHistory *)calloc(1, sizeof(SessionHistory));
+  if (history == NULL) {
+    return NULL;
+  }
+  memcpy(history->prefix, prefix, length + 1);
+  history->compressed = compressed;
+
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    unsigned long count;
+    unsigned long base;
+
+    column_path(path, prefix, column);
+    history->columns[column] =
+        open_column(path, column, compressed, &count, &base);
+    if (history->columns[column] == NULL) {
+      history_close(history);
+      return NULL;
+    }
+    history->tail_base[column] = base;
+    count += base * HISTORY_BLOCK_RECORDS;
+    /* 崩溃可能只写完了部分列，以最短的列为准 */
+    if (column == 0 || count < history->record_count) {
+      history->record_count = count;
+    }
+    if (compressed) {
+      frame_path(path, prefix, column);
+      history->frames[column] =
+          open_frames(history, path, column, &frame_counts[column]);
+      if (history->frames[column] == NULL) {
+        history_close(history);
+        return NULL;
+      }
+      if (column == 0 || frame_counts[column] < history->sealed_blocks) {
+        history->sealed_blocks = frame_counts[column];
+      }
+    }
+  }
+
+  if (compressed) {
+    if (history->record_count <
+        (unsigned long)history->sealed_blocks * HISTORY_BLOCK_RECORDS) {
+      history->sealed_blocks =
+          (size_t)(history->record_count / HISTORY_BLOCK_RECORDS);
+    }
+    for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+      if (history->tail_base[column] > history->sealed_blocks) {
+        history_close(history);
+        return NULL;
+      }
+    }
+  }
+
+  if (load_blocks(history) != 0) {
+    history_close(history);
+    return NULL;
+  }
+  return history;
+}
+
+/**
+ * @brief 打开（必要时创建）一组列文件，并读取出场时间列重建区块索引。
+ * @param prefix 列文件路径前缀。
+ * @return 成功返回新分配的存储对象，失败返回 NULL。
+ */
+SessionHistory *history_open(const char *prefix) {
+  return open_history(prefix, 0);
+}
+
+/**
+ * @brief 打开一组列文件，不存在时以压缩模式新建。
+ * @param prefix 列文件路径前缀。
+ * @return 成功返回新分配的存储对象，失败返回 NULL。
+ */
+SessionHistory *history_open_compressed(const char *prefix) {
+  return open_history(prefix, 1);
+}
+
+/**
+ * @brief 关闭列文件并释放存储对象。
+ * @param history 要关闭的存储，可以为 NULL。
+ */
+void history_close(SessionHistory *history) {
+  int column;
+
+  if (history == NULL) {
+    return;
+  }
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    if (history->columns[column] != NULL) {
+      fclose(history->columns[column]);
+    }
+    if (history->frames[column] != NULL) {
+      fclose(history->frames[column]);
+    }
+    free(history->frame_offsets[column]);
+  }
+  free(history->blocks);
+  free(history);
+}
+
+/**
+ * @brief 追加一条停车记录。
+ * @details 任一列写入失败时记录数不变，下一次追加从同一位置重新写入各列。
+ *          压缩模式下随后封存写满的区块，封存失败只置位 error。
+ * @param history 目标存储。
+ * @param record 要追加的记录。
+ * @return 成功返回 0，参数无效返回 -1，写入失败返回 -2，内存不足返回 -3。
+ */
+int history_append(SessionHistory *history, const SessionRecord *record) {
+  unsigned char buffer[HISTORY_MAX_WIDTH];
+  int column;
+
+  if (history == NULL || record == NULL) {
+    return -1;
+  }
+
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    FILE *file = history->columns[column];
+
+    encode_column(buffer, record, column);
+    if (file == NULL ||
+        fseek(file, column_offset(history, history->record_count, column),
+              SEEK_SET) != 0 ||
+        fwrite(buffer, 1, column_width[column], file) !=
+            column_width[column] ||
+        fflush(file) != 0) {
+      history->error = 1;
+      return -2;
+    }
+  }
+
+  if (blocks_account(history, history->record_count, record->exit_time) != 0) {
+    return -3;
+  }
+  history->record_count++;
+  if (history->compressed && seal_blocks(history) != 0) {
+    history->error = 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief 按出场时间区间扫描停车记录。
+ * @param history 目标存储。
+ * @param from 区间起点（含）。
+ * @param to 区间终点（不含）。
+ * @param columns 需要读取的列掩码。
+ * @param visitor 对每条落在区间内的记录调用的回调。
+ * @param ctx 透传给回调的上下文指针。
+ * @return 访问的记录数；失败时返回 -1。
+ */
+long history_scan(const SessionHistory *history, time_t from, time_t to,
+                  unsigned int columns, SessionVisitor visitor, void *ctx) {
+  char path[HISTORY_MAX_PATH];
+  FILE *files[HISTORY_COLUMN_COUNT];
+  FILE *frames[HISTORY_COLUMN_COUNT];
+  unsigned char *buffers[HISTORY_COLUMN_COUNT];
+  long visited = 0;
+  int stopped = 0;
+  int failed = 0;
+  size_t block;
+  int column;
+
+  if (history == NULL || visitor == NULL) {
+    return -1;
+  }
+
+  columns = (columns & HISTORY_ALL_COLUMNS) |
+            HISTORY_COLUMN_BIT(HISTORY_COL_EXIT);
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    files[column] = NULL;
+    frames[column] = NULL;
+    buffers[column] = NULL;
+    if (!(columns & HISTORY_COLUMN_BIT(column))) {
+      continue;
+    }
+    column_path(path, history->prefix, column);
+    files[column] = fopen(path, "rb");
+    buffers[column] = (unsigned char *)malloc(HISTORY_BLOCK_RECORDS *
+                                              column_width[column]);
+    if (files[column] == NULL || buffers[column] == NULL) {
+      failed = 1;
+    }
+    if (history->compressed) {
+      frame_path(path, history->prefix, column);
+      frames[column] = fopen(path, "rb");
+      if (frames[column] == NULL) {
+        failed = 1;
+      }
+    }
+  }
+
+  for (block = 0; !failed && !stopped && block < history->block_count;
+       block++) {
+    unsigned long first = (unsigned long)block * HISTORY_BLOCK_RECORDS;
+    unsigned long count = history->record_count - first;
+    unsigned long i;
+
+    /* 区块索引表明该区块没有落在区间内的记录时，不读取任何一列 */
+    if (history->blocks[block].max_exit < from ||
+        history->blocks[block].min_exit >= to) {
+      continue;
+    }
+    if (count > HISTORY_BLOCK_RECORDS) {
+      count = HISTORY_BLOCK_RECORDS;
+    }
+    for (column = 0; column < HISTORY_COLUMN_COUNT && !failed; column++) {
+      if (files[column] != NULL &&
+          read_column_block(history, files[column], frames[column], column,
+                            block, count, buffers[column]) != 0) {
+        failed = 1;
+      }
+    }
+
+    for (i = 0; !failed && i < count; i++) {
+      SessionRecord record;
+
+      memset(&record, 0, sizeof(record));
+      decode_column(buffers[HISTORY_COL_EXIT] + i * 8, &record,
+                    HISTORY_COL_EXIT);
+      if (record.exit_time < from || record.exit_time >= to) {
+        continue;
+      }
+      for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+        if (files[column] != NULL && column != HISTORY_COL_EXIT) {
+          decode_column(buffers[column] + i * column_width[column], &record,
+                        column);
+        }
+      }
+      visited++;
+      if (visitor(&record, ctx) != 0) {
+        stopped = 1;
+        break;
+      }
+    }
+  }
+
+  for (column = 0; column < HISTORY_COLUMN_COUNT; column++) {
+    if (files[column] != NULL) {
+      fclose(files[column]);
+    }
+    if (frames[column] != NULL) {
+      fclose(frames[column]);
+    }
+    free(buffers[column]);
+  }
+  return failed ? -1 : visited;
+}
+
+/**
+ * @brief 计算车牌号在停车记录中保存的哈希值。
+ * @param license_plate 车牌号。
+ * @return 32 位哈希值。
+ */
+unsigned long history_plate_hash(const char *license_plate) {
+  if (license_plate == NULL) {
+    return 0;
+  }
+  return codec_checksum((const unsigned char *)license_plate,
+                        strlen(license_plate));
+}
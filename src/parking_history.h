@@ -0,0 +1,163 @@
+#ifndef PARKING_HISTORY_H
+#define PARKING_HISTORY_H
+
+#include <stdio.h>
+#include <time.h>
+
+#include "parking_data.h"
+
+/**
+ * @file parking_history.h
+ * @brief 已完成停车记录的列式追加存储的结构与接口声明。
+ * @details
+ * 每次车辆出场都会追加一条停车记录（车牌哈希、车位、类型、入场时间、
+ * 出场时间、费用）。记录按列分别存放在同一前缀的六个文件中，
+ * 每个文件只保存一列的定宽值，第 i 条记录在每列中的位置都是 i。
+ * 统计查询只打开并读取它需要的列。
+ *
+ * 记录按追加顺序每 HISTORY_BLOCK_RECORDS 条划为一个区块，内存中为每个区块
+ * 保存出场时间的最小值与最大值（区块索引）。按出场时间区间查询时，
+ * 与区间不相交的区块整体跳过，不读取其中任何一列。
+ *
+ * 列文件格式：8 字节魔数 "PARKHIS1"，随后是定宽的列值（小端）。
+ * 打开时以最短的列为准确定记录数，崩溃留下的多余尾部由之后的追加覆盖。
+ *
+ * 压缩模式（history_open_compressed 新建的存储）下，每列由两个文件组成：
+ * - 尾部文件（列文件名本身）：魔数 "PARKHIT1"、4 字节起始区块号，随后是
+ *   从该区块开始、尚未封存的定宽列值，追加方式与普通模式相同；
+ * - 帧文件（列文件名加 ".lz"）：魔数 "PARKHIZ1"，随后每个已封存的区块一帧：
+ *   区块号、压缩后字节数、原始列值的校验和（各 4 字节）与压缩数据。
+ *   帧以 parking_compress.h 的块格式单独压缩，压缩后不比原文小时原样存放。
+ * 某个区块写满时，各列依次把它压缩追加到帧文件并落盘，然后以临时文件加
+ * 原子重命名的方式把尾部文件换成从下一个区块开始的新文件。每帧互不依赖，
+ * 扫描照常跳过区块索引之外的区块，只解压需要的列与区块。
+ * 崩溃发生在封存途中时，打开时以各列都已写完的帧为准，尾部文件中已经封存
+ * 的部分被跳过，下次封存时一并整理。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define HISTORY_MAGIC "PARKHIS1"  /**< 列文件开头的 8 字节魔数 */
+#define HISTORY_MAX_PATH 260      /**< 列文件路径（含后缀）的最大长度 */
+#define HISTORY_BLOCK_RECORDS 512 /**< 每个区块的记录数 */
+#define HISTORY_TAIL_MAGIC "PARKHIT1"  /**< 压缩模式尾部文件的 8 字节魔数 */
+#define HISTORY_FRAME_MAGIC "PARKHIZ1" /**< 压缩模式帧文件的 8 字节魔数 */
+#define HISTORY_FRAME_SUFFIX ".lz"     /**< 帧文件在列文件名之后追加的后缀 */
+
+/**
+ *********************************************************************************
+ *                                 枚举和结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 停车记录的列。
+ */
+typedef enum {
+  HISTORY_COL_PLATE = 0, /**< 车牌号哈希（4 字节）。 */
+  HISTORY_COL_SLOT = 1,  /**< 车位编号（4 字节）。 */
+  HISTORY_COL_TYPE = 2,  /**< 停车类型（1 字节）。 */
+  HISTORY_COL_ENTRY = 3, /**< 入场时间（8 字节）。 */
+  HISTORY_COL_EXIT = 4,  /**< 出场时间（8 字节）。 */
+  HISTORY_COL_FEE = 5,   /**< 费用（分，4 字节）。 */
+  HISTORY_COLUMN_COUNT = 6
+} HistoryColumn;
+
+#define HISTORY_COLUMN_BIT(column) (1U << (column)) /**< 列掩码中某一列的位 */
+#define HISTORY_ALL_COLUMNS ((1U << HISTORY_COLUMN_COUNT) - 1U) /**< 所有列 */
+
+/**
+ * @brief 区块索引中的一项。
+ */
+typedef struct HistoryBlock {
+  time_t min_exit; /**< 区块内最早的出场时间。 */
+  time_t max_exit; /**< 区块内最晚的出场时间。 */
+} HistoryBlock;
+
+/**
+ * @brief 一个已打开的停车记录存储。
+ */
+typedef struct SessionHistory {
+  FILE *columns[HISTORY_COLUMN_COUNT]; /**< 用于追加的各列文件。 */
+  char prefix[HISTORY_MAX_PATH];       /**< 列文件路径前缀。 */
+  unsigned long record_count;          /**< 已保存的记录数。 */
+  HistoryBlock *blocks;                /**< 区块索引。 */
+  size_t block_count;                  /**< 区块索引中的区块数。 */
+  size_t block_capacity;               /**< 区块索引已分配的容量。 */
+  int error;                           /**< 最近一次写入失败后置 1。 */
+  int compressed;                      /**< 非 0 表示压缩模式。 */
+  FILE *frames[HISTORY_COLUMN_COUNT];  /**< 压缩模式下各列的帧文件。 */
+  /** 压缩模式下各列的帧偏移：第 k 项为区块 k 的帧，最后一项为帧文件末尾。 */
+  long *frame_offsets[HISTORY_COLUMN_COUNT];
+  unsigned long tail_base[HISTORY_COLUMN_COUNT]; /**< 各列尾部起始区块。 */
+  size_t sealed_blocks;  /**< 已封存到帧文件的区块数。 */
+  size_t frame_capacity; /**< frame_offsets 各数组已分配的项数。 */
+} SessionHistory;
+
+/**
+ *********************************************************************************
+ *                            停车记录操作API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 打开（必要时创建）一组列文件，并读取出场时间列重建区块索引。
+ * @param prefix 列文件路径前缀，各列文件名为前缀加 ".plate"、".slot" 等后缀。
+ * @return 成功返回新分配的存储对象；路径过长、文件无法打开、
+ * 不是有效列文件或内存不足时返回 NULL。
+ */
+SessionHistory *history_open(const char *prefix);
+
+/**
+ * @brief 打开一组列文件，不存在时以压缩模式新建。
+ * @details 已存在的列文件按其自身的格式打开（普通或压缩），不做转换。
+ * @param prefix 列文件路径前缀。
+ * @return 成功返回新分配的存储对象，失败返回 NULL（同 history_open）。
+ */
+SessionHistory *history_open_compressed(const char *prefix);
+
+/**
+ * @brief 关闭列文件并释放存储对象。
+ * @param history 要关闭的存储，可以为 NULL。
+ */
+void history_close(SessionHistory *history);
+
+/**
+ * @brief 追加一条停车记录。
+ * @details 各列写入后立即 fflush；写入失败时置位 error。
+ *          压缩模式下区块写满时随即封存；封存失败不影响已写入的记录，
+ *          只置位 error，下一次追加时重试。
+ * @param history 目标存储。
+ * @param record 要追加的记录。
+ * @return 成功返回 0，参数无效返回 -1，写入失败返回 -2，内存不足返回 -3。
+ */
+int history_append(SessionHistory *history, const SessionRecord *record);
+
+/**
+ * @brief 按出场时间区间扫描停车记录。
+ * @details 只读取 columns 中指定的列（出场时间列总是读取），
+ *          未指定的列在传给回调的记录中为 0。扫描使用独立的只读文件句柄，
+ *          可以与其他扫描并发进行，但不能与追加并发。
+ * @param history 目标存储。
+ * @param from 区间起点（含）。
+ * @param to 区间终点（不含）。
+ * @param columns 需要读取的列掩码，由 HISTORY_COLUMN_BIT 组合而成。
+ * @param visitor 对每条落在区间内的记录调用的回调，返回非 0 时停止扫描。
+ * @param ctx 透传给回调的上下文指针。
+ * @return 访问的记录数；参数无效、文件无法读取或内存不足时返回 -1。
+ */
+long history_scan(const SessionHistory *history, time_t from, time_t to,
+                  unsigned int columns, SessionVisitor visitor, void *ctx);
+
+/**
+ * @brief 计算车牌号在停车记录中保存的哈希值。
+ * @param license_plate 车牌号。
+ * @return 32 位哈希值。
+ */
+unsigned long history_plate_hash(const char *license_plate);
+
+#endif /* PARKING_HISTORY_H */
@@ -0,0 +1,198 @@
+/**
+ * @file parking_hll.c
+ * @brief HyperLogLog 草图实现文件
+ * @details
+ * 该文件实现了 parking_hll.h 中声明的草图与按周、按月的计数器。
+ * 估计公式与偏差修正取自 Flajolet 等人的 HyperLogLog 原始论文：
+ * 小基数时使用线性计数，接近 32 位散列空间时做大基数修正。
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "parking_calendar.h"
+#include "parking_hll.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define HLL_RANK_BITS (32 - HLL_PRECISION) /**< 求秩使用的散列位数 */
+#define HLL_HASH_SPACE 4294967296.0        /**< 32 位散列空间的大小 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 求上一个月份。
+ * @param month_key 月份（YYYYMM）。
+ * @return 上一个月份（YYYYMM）。
+ */
+static long previous_month(long month_key) {
+  return month_key % 100 == 1 ? month_key - 100 + 11 : month_key - 1;
+}
+
+/**
+ * @brief (静态辅助函数) 取得键对应的草图槽，槽中是更早的周期时清空复用。
+ * @param keys 两个槽的键。
+ * @param sketches 两个槽的草图。
+ * @param key 周序号或月份。
+ * @return 对应的草图；key 早于槽中保存的周期时返回 NULL。
+ */
+static HyperLogLog *claim_sketch(long *keys, HyperLogLog *sketches, long key) {
+  int slot = (int)(key & 1L);
+
+  if (keys[slot] != key) {
+    if (keys[slot] > key) {
+      return NULL;
+    }
+    hll_clear(&sketches[slot]);
+    keys[slot] = key;
+  }
+  return &sketches[slot];
+}
+
+/* ========================================================================== */
+/*                              HyperLogLog API实现                           */
+/* ========================================================================== */
+
+/**
+ * @brief 清空草图。
+ * @param sketch 目标草图。
+ */
+void hll_clear(HyperLogLog *sketch) { memset(sketch, 0, sizeof(*sketch)); }
+
+/**
+ * @brief 把一个元素计入草图。
+ * @param sketch 目标草图。
+ * @param hash 元素的 32 位散列值。
+ */
+void hll_add(HyperLogLog *sketch, unsigned long hash) {
+  unsigned long rest;
+  size_t index;
+  unsigned char rank = 1;
+
+  hash &= 0xFFFFFFFFUL;
+  index = (size_t)(hash >> HLL_RANK_BITS);
+  rest = hash & ((1UL << HLL_RANK_BITS) - 1UL);
+  /* 秩为剩余位中第一个 1 的位置（从高位数起），全为 0 时取最大值 */
+  while (rank <= HLL_RANK_BITS &&
+         (rest & (1UL << (HLL_RANK_BITS - rank))) == 0) {
+    rank++;
+  }
+  if (sketch->registers[index] < rank) {
+    sketch->registers[index] = rank;
+  }
+}
+
+/**
+ * @brief 把一个草图合并进另一个草图（求并集）。
+ * @param into 目标草图。
+ * @param from 要合并的草图。
+ */
+void hll_merge(HyperLogLog *into, const HyperLogLog *from) {
+  size_t i;
+
+  for (i = 0; i < HLL_REGISTERS; i++) {
+    if (into->registers[i] < from->registers[i]) {
+      into->registers[i] = from->registers[i];
+    }
+  }
+}
+
+/**
+ * @brief 估计草图中不同元素的个数。
+ * @param sketch 目标草图。
+ * @return 估计值。
+ */
+double hll_estimate(const HyperLogLog *sketch) {
+  const double m = (double)HLL_REGISTERS;
+  double alpha = 0.7213 / (1.0 + 1.079 / m);
+  double sum = 0.0;
+  double estimate;
+  long zeros = 0;
+  size_t i;
+
+  for (i = 0; i < HLL_REGISTERS; i++) {
+    sum += ldexp(1.0, -(int)sketch->registers[i]);
+    if (sketch->registers[i] == 0) {
+      zeros++;
+    }
+  }
+  estimate = alpha * m * m / sum;
+  if (estimate <= 2.5 * m && zeros > 0) {
+    return m * log(m / (double)zeros);
+  }
+  if (estimate > HLL_HASH_SPACE / 30.0) {
+    return -HLL_HASH_SPACE * log(1.0 - estimate / HLL_HASH_SPACE);
+  }
+  return estimate;
+}
+
+/**
+ * @brief 初始化（清空）按周、按月的不同车辆草图。
+ * @param counter 目标计数器。
+ */
+void distinct_counter_init(DistinctCounter *counter) {
+  memset(counter, 0, sizeof(*counter));
+}
+
+/**
+ * @brief 把一次入场的车牌散列值计入当周与当月的草图。
+ * @param counter 目标计数器。
+ * @param day_key 入场的本地日期（YYYYMMDD）。
+ * @param month_key 入场的本地月份（YYYYMM）。
+ * @param hash 车牌的 32 位散列值。
+ */
+void distinct_counter_add(DistinctCounter *counter, long day_key,
+                          long month_key, unsigned long hash) {
+  HyperLogLog *sketch;
+
+  sketch = claim_sketch(counter->week_keys, counter->weeks,
+                        parking_calendar_week_number(day_key));
+  if (sketch != NULL) {
+    hll_add(sketch, hash);
+  }
+  sketch = claim_sketch(counter->month_keys, counter->months, month_key);
+  if (sketch != NULL) {
+    hll_add(sketch, hash);
+  }
+}
+
+/**
+ * @brief 取某个周期的草图。
+ * @param counter 目标计数器。
+ * @param period 周期。
+ * @param day_key 作为基准的本地日期（YYYYMMDD）。
+ * @return 该周期的草图，没有时返回 NULL。
+ */
+const HyperLogLog *distinct_counter_sketch(const DistinctCounter *counter,
+                                           DistinctPeriod period,
+                                           long day_key) {
+  const long *keys = counter->week_keys;
+  const HyperLogLog *sketches = counter->weeks;
+  long key;
+
+  switch (period) {
+  case DISTINCT_THIS_WEEK:
+    key = parking_calendar_week_number(day_key);
+    break;
+  case DISTINCT_LAST_WEEK:
+    key = parking_calendar_week_number(day_key) - 1;
+    break;
+  case DISTINCT_THIS_MONTH:
+    key = day_key / 100;
+    keys = counter->month_keys;
+    sketches = counter->months;
+    break;
+  case DISTINCT_LAST_MONTH:
+    key = previous_month(day_key / 100);
+    keys = counter->month_keys;
+    sketches = counter->months;
+    break;
+  default:
+    return NULL;
+  }
+  return keys[key & 1L] == key ? &sketches[key & 1L] : NULL;
+}
@@ -0,0 +1,127 @@
+#ifndef PARKING_HLL_H
+#define PARKING_HLL_H
+
+/**
+ * @file parking_hll.h
+ * @brief 估计不同车辆数的 HyperLogLog 草图声明。
+ * @details
+ * 精确统计一周或一个月内来过多少辆不同的车，需要保存期间出现过的全部
+ * 车牌。HyperLogLog 只保存 HLL_REGISTERS 个单字节寄存器：车牌的 32 位
+ * 散列值高 HLL_PRECISION 位选择寄存器，其余位中第一个 1 的位置决定
+ * 寄存器的取值，寄存器只取最大值。估计值的相对标准误差约为
+ * 1.04 / sqrt(HLL_REGISTERS)，即约 1.6%。
+ *
+ * 每次入场更新一个寄存器，是 O(1) 的；两个草图逐寄存器取最大值即得到
+ * 两个集合并集的草图，因此各分区、各停车场的草图可以合并后再估计。
+ *
+ * DistinctCounter 为本周、上周、本月与上月各保留一个草图（共约 16KB），
+ * 周期切换时复用更早的草图。草图只保存在内存中，不写入快照。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define HLL_PRECISION 12                   /**< 选择寄存器的散列位数 */
+#define HLL_REGISTERS (1 << HLL_PRECISION) /**< 寄存器数（4096） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个 HyperLogLog 草图。
+ */
+typedef struct HyperLogLog {
+  unsigned char registers[HLL_REGISTERS]; /**< 各寄存器的最大秩。 */
+} HyperLogLog;
+
+/**
+ * @brief 统计不同车辆数的周期。
+ */
+typedef enum DistinctPeriod {
+  DISTINCT_THIS_WEEK = 0,  /**< 本周（周一起）。 */
+  DISTINCT_LAST_WEEK = 1,  /**< 上周。 */
+  DISTINCT_THIS_MONTH = 2, /**< 本月。 */
+  DISTINCT_LAST_MONTH = 3  /**< 上月。 */
+} DistinctPeriod;
+
+/**
+ * @brief 按周、按月保留的不同车辆草图。
+ * @details 周草图以周序号为键、月草图以 YYYYMM 为键，各自按键的奇偶
+ *          存放在两个槽中，键为 0 表示空槽。
+ */
+typedef struct DistinctCounter {
+  long week_keys[2];     /**< 两个周草图所属的周序号。 */
+  long month_keys[2];    /**< 两个月草图所属的月份。 */
+  HyperLogLog weeks[2];  /**< 周草图。 */
+  HyperLogLog months[2]; /**< 月草图。 */
+} DistinctCounter;
+
+/**
+ *********************************************************************************
+ *                              HyperLogLog API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 清空草图。
+ * @param sketch 目标草图。
+ */
+void hll_clear(HyperLogLog *sketch);
+
+/**
+ * @brief 把一个元素计入草图。
+ * @param sketch 目标草图。
+ * @param hash 元素的 32 位散列值（只使用低 32 位，应已充分混合）。
+ */
+void hll_add(HyperLogLog *sketch, unsigned long hash);
+
+/**
+ * @brief 把一个草图合并进另一个草图（求并集）。
+ * @param into 目标草图。
+ * @param from 要合并的草图。
+ */
+void hll_merge(HyperLogLog *into, const HyperLogLog *from);
+
+/**
+ * @brief 估计草图中不同元素的个数。
+ * @details 元素较少时改用线性计数，减小小基数下的偏差。
+ * @param sketch 目标草图。
+ * @return 估计值。
+ */
+double hll_estimate(const HyperLogLog *sketch);
+
+/**
+ * @brief 初始化（清空）按周、按月的不同车辆草图。
+ * @param counter 目标计数器。
+ */
+void distinct_counter_init(DistinctCounter *counter);
+
+/**
+ * @brief 把一次入场的车牌散列值计入当周与当月的草图。
+ * @details 早于所保留两周（两月）的入场不计入对应的草图。
+ * @param counter 目标计数器。
+ * @param day_key 入场的本地日期（YYYYMMDD）。
+ * @param month_key 入场的本地月份（YYYYMM）。
+ * @param hash 车牌的 32 位散列值。
+ */
+void distinct_counter_add(DistinctCounter *counter, long day_key,
+                          long month_key, unsigned long hash);
+
+/**
+ * @brief 取某个周期的草图。
+ * @param counter 目标计数器。
+ * @param period 周期。
+ * @param day_key 作为“本周”“本月”基准的本地日期（YYYYMMDD）。
+ * @return 该周期的草图；该周期没有入场（或已移出保留范围）时返回 NULL。
+ */
+const HyperLogLog *distinct_counter_sketch(const DistinctCounter *counter,
+                                           DistinctPeriod period,
+                                           long day_key);
+
+#endif /* PARKING_HLL_H */
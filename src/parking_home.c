@@ -0,0 +1,264 @@
+/**
+ * @file parking_home.c
+ * @brief 居民固定车位表实现文件
+ * @details
+ * 该文件实现了 parking_home.h 中声明的固定车位表。探查方式与车牌名单
+ * 的哈希表相同；删除后从下一个槽起逐个检查同簇的项，凡是理想位置不在
+ * (空槽, 当前槽] 之间的都前移到空槽，使查找不必越过墓碑。
+ */
+
+#include <string.h>
+
+#include "parking_data.h"
+#include "parking_home.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 在哈希表中查找车牌所在的槽或应放入的空槽。
+ * @param entries 哈希表。
+ * @param capacity 哈希表容量（2 的幂）。
+ * @param code 车牌编码。
+ * @param text 非标准车牌的原文，标准车牌为 NULL。
+ * @return 已登记该车牌的槽，或探查到的第一个空槽的下标。
+ */
+static size_t probe_home(const HomeSlotEntry *entries, size_t capacity,
+                         const PlateCode *code, const char *text) {
+  size_t at = (size_t)plate_code_hash(code) & (capacity - 1);
+
+  while (entries[at].slot_id != 0) {
+    if (plate_code_equal(&entries[at].code, code) &&
+        (text == NULL || strcmp(entries[at].text, text) == 0)) {
+      break;
+    }
+    at = (at + 1) & (capacity - 1);
+  }
+  return at;
+}
+
+/**
+ * @brief (静态辅助函数) 把哈希表扩容为两倍。
+ * @param table 目标表。
+ * @return 成功返回 0，内存不足返回 -1（原表不变）。
+ */
+static int grow_homes(HomeSlotTable *table) {
+  size_t capacity = table->capacity * 2;
+  HomeSlotEntry *entries;
+  size_t i;
+
+  entries = (HomeSlotEntry *)parking_memory_calloc(
+      table->memory, PARKING_MEMORY_INDEX, capacity, sizeof(HomeSlotEntry));
+  if (entries == NULL) {
+    return -1;
+  }
+  for (i = 0; i < table->capacity; i++) {
+    const HomeSlotEntry *old = &table->entries[i];
+
+    if (old->slot_id != 0) {
+      entries[probe_home(entries, capacity, &old->code, old->text)] = *old;
+    }
+  }
+  parking_memory_free(table->memory, table->entries);
+  table->entries = entries;
+  table->capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 清空一个槽，并把其后同簇的项前移补位。
+ * @param table 目标表。
+ * @param hole 要清空的槽。
+ */
+static void erase_home(HomeSlotTable *table, size_t hole) {
+  size_t mask = table->capacity - 1;
+  size_t at = (hole + 1) & mask;
+
+  parking_memory_free(table->memory, table->entries[hole].text);
+  table->entries[hole].text = NULL;
+  table->entries[hole].slot_id = 0;
+  table->count--;
+
+  while (table->entries[at].slot_id != 0) {
+    size_t ideal =
+        (size_t)plate_code_hash(&table->entries[at].code) & mask;
+
+    /* 理想位置不在 (hole, at] 之间时，前移到空槽后仍能被探查到 */
+    if (((at - ideal) & mask) >= ((at - hole) & mask)) {
+      table->entries[hole] = table->entries[at];
+      table->entries[at].text = NULL;
+      table->entries[at].slot_id = 0;
+      hole = at;
+    }
+    at = (at + 1) & mask;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 编码车牌，非标准车牌同时给出比较用的原文。
+ * @param plate 车牌号。
+ * @param[out] code 接收编码。
+ * @return 非标准车牌返回 plate，标准车牌返回 NULL。
+ */
+static const char *home_key(const char *plate, PlateCode *code) {
+  return plate_encode(plate, code) ? NULL : plate;
+}
+
+/* ========================================================================== */
+/*                             固定车位表API实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个空的固定车位表。
+ * @param memory 表的分配来源，NULL 表示 C 堆。
+ * @return 成功返回表，内存不足返回 NULL。
+ */
+HomeSlotTable *home_table_create(ParkingMemory *memory) {
+  HomeSlotTable *table;
+
+  table = (HomeSlotTable *)parking_memory_calloc(memory, PARKING_MEMORY_INDEX,
+                                                 1, sizeof(HomeSlotTable));
+  if (table == NULL) {
+    return NULL;
+  }
+  table->entries = (HomeSlotEntry *)parking_memory_calloc(
+      memory, PARKING_MEMORY_INDEX, HOME_TABLE_INITIAL, sizeof(HomeSlotEntry));
+  if (table->entries == NULL) {
+    parking_memory_free(memory, table);
+    return NULL;
+  }
+  table->capacity = HOME_TABLE_INITIAL;
+  table->memory = memory;
+  return table;
+}
+
+/**
+ * @brief 释放固定车位表。
+ * @param table 要释放的表，可以为 NULL。
+ */
+void home_table_free(HomeSlotTable *table) {
+  size_t i;
+
+  if (table == NULL) {
+    return;
+  }
+  for (i = 0; i < table->capacity; i++) {
+    parking_memory_free(table->memory, table->entries[i].text);
+  }
+  parking_memory_free(table->memory, table->entries);
+  parking_memory_free(table->memory, table);
+}
+
+/**
+ * @brief 登记车牌的固定车位，车牌已登记时改为新的车位。
+ * @param table 目标表。
+ * @param plate 车牌号。
+ * @param slot_id 车位编号。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -2。
+ */
+int home_table_set(HomeSlotTable *table, const char *plate, int slot_id) {
+  HomeSlotEntry *entry;
+  const char *text;
+  PlateCode code;
+  size_t length;
+
+  if (table == NULL || plate == NULL || slot_id <= 0) {
+    return -1;
+  }
+  length = strlen(plate);
+  if (length == 0 || length >= MAX_LICENSE_LEN) {
+    return -1;
+  }
+  text = home_key(plate, &code);
+  if ((table->count + 1) * 2 > table->capacity && grow_homes(table) != 0) {
+    return -2;
+  }
+
+  entry = &table->entries[probe_home(table->entries, table->capacity, &code,
+                                     text)];
+  if (entry->slot_id != 0) {
+    entry->slot_id = slot_id;
+    return 0;
+  }
+  if (text != NULL) {
+    entry->text = (char *)parking_memory_alloc(
+        table->memory, PARKING_MEMORY_INDEX, length + 1);
+    if (entry->text == NULL) {
+      return -2;
+    }
+    memcpy(entry->text, text, length + 1);
+  }
+  entry->code = code;
+  entry->slot_id = slot_id;
+  table->count++;
+  return 0;
+}
+
+/**
+ * @brief 查找车牌的固定车位。
+ * @param table 目标表，可以为 NULL。
+ * @param plate 车牌号。
+ * @return 固定车位的编号；未登记返回 0。
+ */
+int home_table_find(const HomeSlotTable *table, const char *plate) {
+  const char *text;
+  PlateCode code;
+
+  if (table == NULL || table->count == 0 || plate == NULL) {
+    return 0;
+  }
+  text = home_key(plate, &code);
+  return table->entries[probe_home(table->entries, table->capacity, &code,
+                                   text)]
+      .slot_id;
+}
+
+/**
+ * @brief 撤销车牌的固定车位登记。
+ * @param table 目标表。
+ * @param plate 车牌号。
+ * @return 原固定车位的编号；未登记返回 0。
+ */
+int home_table_remove(HomeSlotTable *table, const char *plate) {
+  const char *text;
+  PlateCode code;
+  size_t at;
+  int slot_id;
+
+  if (table == NULL || table->count == 0 || plate == NULL) {
+    return 0;
+  }
+  text = home_key(plate, &code);
+  at = probe_home(table->entries, table->capacity, &code, text);
+  slot_id = table->entries[at].slot_id;
+  if (slot_id != 0) {
+    erase_home(table, at);
+  }
+  return slot_id;
+}
+
+/**
+ * @brief 撤销以某个车位为固定车位的登记。
+ * @param table 目标表，可以为 NULL。
+ * @param slot_id 车位编号。
+ * @return 撤销的登记条数。
+ */
+int home_table_remove_slot(HomeSlotTable *table, int slot_id) {
+  int removed = 0;
+  size_t at = 0;
+
+  if (table == NULL || slot_id <= 0) {
+    return 0;
+  }
+  /* 前移补位可能把未检查的项移到当前槽，因此清空后原地再检查一次 */
+  while (at < table->capacity) {
+    if (table->entries[at].slot_id == slot_id) {
+      erase_home(table, at);
+      removed++;
+    } else {
+      at++;
+    }
+  }
+  return removed;
+}
@@ -0,0 +1,106 @@
+#ifndef PARKING_HOME_H
+#define PARKING_HOME_H
+
+#include <stddef.h>
+
+#include "parking_memory.h"
+#include "parking_plate.h"
+
+/**
+ * @file parking_home.h
+ * @brief 居民固定车位表的结构与接口声明。
+ * @details
+ * 居民可以登记一个固定车位：该车位只接纳登记的车牌，登记的车辆自动选位
+ * 时也优先回到自己的车位。表以车牌编码为键、车位编号为值，采用开放寻址
+ * 与线性探查，删除时把后续同簇的项前移（backward shift），不留墓碑。
+ * 标准车牌只比较编码，非标准车牌（编码为字符串哈希）再比较字符串，
+ * 与车牌名单相同。表本身不加锁，由停车场的锁保护。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define HOME_TABLE_INITIAL 16 /**< 哈希表的初始容量（2 的幂） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 哈希表中的一条固定车位登记。
+ */
+typedef struct HomeSlotEntry {
+  PlateCode code; /**< 车牌编码。 */
+  char *text;     /**< 非标准车牌的原文，标准车牌为 NULL。 */
+  int slot_id;    /**< 固定车位的编号，0 表示空槽。 */
+} HomeSlotEntry;
+
+/**
+ * @brief 停车场的居民固定车位表。
+ */
+typedef struct HomeSlotTable {
+  HomeSlotEntry *entries; /**< 开放寻址哈希表。 */
+  size_t capacity;        /**< 哈希表容量（2 的幂），装载率不超过 1/2。 */
+  size_t count;           /**< 登记条数。 */
+  ParkingMemory *memory;  /**< 分配来源，NULL 表示 C 堆。 */
+} HomeSlotTable;
+
+/**
+ *********************************************************************************
+ *                             固定车位表API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个空的固定车位表。
+ * @param memory 表的分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @return 成功返回表，内存不足返回 NULL。
+ */
+HomeSlotTable *home_table_create(ParkingMemory *memory);
+
+/**
+ * @brief 释放固定车位表。
+ * @param table 要释放的表，可以为 NULL。
+ */
+void home_table_free(HomeSlotTable *table);
+
+/**
+ * @brief 登记车牌的固定车位，车牌已登记时改为新的车位。
+ * @param table 目标表。
+ * @param plate 车牌号，非空且长度小于 MAX_LICENSE_LEN。
+ * @param slot_id 车位编号，必须为正。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -2。
+ */
+int home_table_set(HomeSlotTable *table, const char *plate, int slot_id);
+
+/**
+ * @brief 查找车牌的固定车位。
+ * @param table 目标表，可以为 NULL。
+ * @param plate 车牌号。
+ * @return 固定车位的编号；未登记返回 0。
+ */
+int home_table_find(const HomeSlotTable *table, const char *plate);
+
+/**
+ * @brief 撤销车牌的固定车位登记。
+ * @param table 目标表。
+ * @param plate 车牌号。
+ * @return 原固定车位的编号；未登记返回 0。
+ */
+int home_table_remove(HomeSlotTable *table, const char *plate);
+
+/**
+ * @brief 撤销以某个车位为固定车位的登记（车位被删除时使用）。
+ * @details 需要扫描整个哈希表，代价与表容量成正比。
+ * @param table 目标表，可以为 NULL。
+ * @param slot_id 车位编号。
+ * @return 撤销的登记条数。
+ */
+int home_table_remove_slot(HomeSlotTable *table, int slot_id);
+
+#endif /* PARKING_HOME_H */
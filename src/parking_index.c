@@ -0,0 +1,2051 @@
+/**
+ * @file parking_index.c
+ * @brief 数据层哈希索引实现文件
+ * @details
+ * 该文件实现了 parking_index.h 中声明的开放寻址哈希索引。
+ * 索引由 ParkingLot 持有，并由数据层在增删车位时同步维护，
+ * 使按键查找不再需要遍历车位链表；同时实现按入场时间排列的在场车位链表、
+ * 按月费到期时间排列的最小堆与车位句柄表，以及编号、车牌索引的映像读写。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_codec.h"
+#include "parking_data.h"
+#include "parking_index.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define SLOT_INDEX_MIN_CAPACITY 16 /**< 首次分配时的桶数组容量 */
+#define SLOT_INDEX_LOAD_NUM 7      /**< 最大负载因子分子（7/10） */
+#define SLOT_INDEX_LOAD_DEN 10     /**< 最大负载因子分母 */
+#define DUE_HEAP_MIN_CAPACITY 16   /**< 月费到期堆首次分配的容量 */
+#define SLOT_HANDLE_MIN_CAPACITY 16 /**< 句柄表首次分配的容量 */
+#define SLOT_INDEX_MIGRATE_STEP 16 /**< 每次登记、删除顺带迁移的旧桶数 */
+
+/** 旧桶数组中已迁移或已删除的条目（墓碑），只比较地址，从不解引用。 */
+static char slot_index_moved_marker;
+#define SLOT_INDEX_MOVED                                                       \
+  ((struct ParkingSlot *)(void *)&slot_index_moved_marker)
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 计算车位编号的哈希值。
+ * @details 使用 MurmurHash3 的 32 位最终混合函数（fmix32）打散编号，
+ *          避免连续编号在低位聚集。
+ * @param slot_id 车位编号。
+ * @return 32 位哈希值。
+ */
+static unsigned long hash_slot_id(int slot_id) {
+  unsigned long h = (unsigned long)(unsigned int)slot_id & 0xFFFFFFFFUL;
+
+  h ^= h >> 16;
+  h = (h * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+  h ^= h >> 13;
+  h = (h * 0xC2B2AE35UL) & 0xFFFFFFFFUL;
+  h ^= h >> 16;
+  return h;
+}
+
+/**
+ * @brief (静态辅助函数) 计算容纳指定条目数所需的桶数组容量。
+ * @param capacity 当前容量（2 的幂或 0）。
+ * @param count 预期的条目数。
+ * @return 不小于当前容量、负载不超过上限的最小 2 的幂。
+ */
+static size_t reserve_capacity(size_t capacity, size_t count) {
+  if (capacity == 0) {
+    capacity = SLOT_INDEX_MIN_CAPACITY;
+  }
+  while (count * SLOT_INDEX_LOAD_DEN > capacity * SLOT_INDEX_LOAD_NUM) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+/**
+ * @brief (静态辅助函数) 判断车牌号索引的桶是否登记了指定车牌。
+ * @details 编码不同即不同；标准车牌编码相同即相同，
+ *          只有非标准车牌（编码为哈希）才需要比较字符串。
+ * @param entry 非空桶。
+ * @param code 目标车牌的编码。
+ * @param license_plate 目标车牌号字符串。
+ * @return 匹配返回 1，否则返回 0。
+ */
+static int plate_entry_matches(const PlateIndexEntry *entry,
+                               const PlateCode *code,
+                               const char *license_plate) {
+  if (!plate_code_equal(&entry->code, code)) {
+    return 0;
+  }
+  return plate_code_is_standard(code) ||
+         strcmp(entry->slot->license_plate, license_plate) == 0;
+}
+
+/**
+ * @brief (静态辅助函数) 把条目放入桶数组中第一个空桶（不检查重复）。
+ * @param entries 目标桶数组。
+ * @param capacity 桶数组容量（2 的幂）。
+ * @param entry 要放入的条目。
+ */
+static void slot_id_place(SlotIdIndexEntry *entries, size_t capacity,
+                          const SlotIdIndexEntry *entry) {
+  size_t mask = capacity - 1;
+  size_t pos = hash_slot_id(entry->slot_id) & mask;
+
+  while (entries[pos].slot != NULL) {
+    pos = (pos + 1) & mask;
+  }
+  entries[pos] = *entry;
+}
+
+/**
+ * @brief (静态辅助函数) 在一个桶数组中查找编号所在的桶，跳过墓碑。
+ * @param entries 桶数组。
+ * @param capacity 桶数组容量（2 的幂）。
+ * @param slot_id 车位编号。
+ * @return 找到返回该桶，否则返回 NULL。
+ */
+static SlotIdIndexEntry *slot_id_locate(SlotIdIndexEntry *entries,
+                                        size_t capacity, int slot_id) {
+  size_t mask = capacity - 1;
+  size_t pos = hash_slot_id(slot_id) & mask;
+
+  while (entries[pos].slot != NULL) {
+    if (entries[pos].slot != SLOT_INDEX_MOVED &&
+        entries[pos].slot_id == slot_id) {
+      return &entries[pos];
+    }
+    pos = (pos + 1) & mask;
+  }
+  return NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 把至多 buckets 个旧桶迁移到新桶数组。
+ * @details 搬走的旧桶留作墓碑；旧桶数组全部迁移完后释放。
+ * @param index 目标索引。
+ * @param buckets 本次迁移的旧桶数。
+ */
+static void slot_id_index_migrate(SlotIdIndex *index, size_t buckets) {
+  while (index->old_entries != NULL && buckets > 0) {
+    SlotIdIndexEntry *entry = &index->old_entries[index->migrate_pos];
+
+    if (entry->slot != NULL && entry->slot != SLOT_INDEX_MOVED) {
+      slot_id_place(index->entries, index->capacity, entry);
+      entry->slot = SLOT_INDEX_MOVED;
+    }
+    index->migrate_pos++;
+    buckets--;
+    if (index->migrate_pos == index->old_capacity) {
+      parking_memory_free(index->memory, index->old_entries);
+      index->old_entries = NULL;
+      index->old_capacity = 0;
+      index->migrate_pos = 0;
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 将桶数组扩容到指定容量并重新散列所有条目。
+ * @details 一次完成，先结束进行中的迁移；供预先扩容使用。
+ * @param index 目标索引。
+ * @param new_capacity 新容量，必须为 2 的幂。
+ * @return 成功返回 0，内存不足返回 -1（此时原索引保持不变）。
+ */
+static int slot_id_index_grow(SlotIdIndex *index, size_t new_capacity) {
+  SlotIdIndexEntry *new_entries;
+  size_t i;
+
+  new_entries = (SlotIdIndexEntry *)parking_memory_calloc(
+      index->memory, PARKING_MEMORY_INDEX, new_capacity,
+      sizeof(SlotIdIndexEntry));
+  if (new_entries == NULL) {
+    return -1;
+  }
+
+  slot_id_index_migrate(index, index->old_capacity);
+  for (i = 0; i < index->capacity; i++) {
+    if (index->entries[i].slot != NULL) {
+      slot_id_place(new_entries, new_capacity, &index->entries[i]);
+    }
+  }
+
+  parking_memory_free(index->memory, index->entries);
+  index->entries = new_entries;
+  index->capacity = new_capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 开始渐进扩容：分配两倍容量的新桶数组，
+ *        当前桶数组转为待迁移的旧桶数组。
+ * @details 上一次迁移尚未完成时先把它做完（正常负载下不会发生）。
+ * @param index 目标索引。
+ * @return 成功返回 0，内存不足返回 -1（此时原索引保持不变）。
+ */
+static int slot_id_index_begin_grow(SlotIdIndex *index) {
+  SlotIdIndexEntry *new_entries;
+  size_t new_capacity =
+      index->capacity ? index->capacity * 2 : SLOT_INDEX_MIN_CAPACITY;
+
+  new_entries = (SlotIdIndexEntry *)parking_memory_calloc(
+      index->memory, PARKING_MEMORY_INDEX, new_capacity,
+      sizeof(SlotIdIndexEntry));
+  if (new_entries == NULL) {
+    return -1;
+  }
+  slot_id_index_migrate(index, index->old_capacity);
+  if (index->capacity > 0) {
+    index->old_entries = index->entries;
+    index->old_capacity = index->capacity;
+    index->migrate_pos = 0;
+  }
+  index->entries = new_entries;
+  index->capacity = new_capacity;
+  return 0;
+}
+
+/* ========================================================================== */
+/*                            车位编号索引函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief 将索引初始化为空状态（不分配内存）。
+ * @param index 要初始化的索引。
+ * @param memory 之后分配桶数组使用的内存对象，NULL 表示 C 堆。
+ */
+void slot_id_index_init(SlotIdIndex *index, ParkingMemory *memory) {
+  if (index == NULL) {
+    return;
+  }
+  index->memory = memory;
+  index->entries = NULL;
+  index->capacity = 0;
+  index->count = 0;
+  index->old_entries = NULL;
+  index->old_capacity = 0;
+  index->migrate_pos = 0;
+}
+
+/**
+ * @brief 释放索引占用的桶数组，并将其恢复为空状态。
+ * @param index 要释放的索引。
+ */
+void slot_id_index_free(SlotIdIndex *index) {
+  if (index == NULL) {
+    return;
+  }
+  parking_memory_free(index->memory, index->entries);
+  parking_memory_free(index->memory, index->old_entries);
+  slot_id_index_init(index, index->memory);
+}
+
+/**
+ * @brief 按车位编号查找车位节点。
+ * @details 从哈希位置开始线性探测，遇到空桶即可判定不存在；
+ *          迁移期间新桶数组未命中时再查旧桶数组。
+ * @param index 目标索引。
+ * @param slot_id 要查找的车位编号。
+ * @return 找到时返回车位节点指针，否则返回 NULL。
+ */
+struct ParkingSlot *slot_id_index_find(const SlotIdIndex *index, int slot_id) {
+  SlotIdIndexEntry *entry;
+
+  if (index == NULL || index->capacity == 0) {
+    return NULL;
+  }
+
+  entry = slot_id_locate(index->entries, index->capacity, slot_id);
+  if (entry == NULL && index->old_entries != NULL) {
+    entry = slot_id_locate(index->old_entries, index->old_capacity, slot_id);
+  }
+  return entry != NULL ? entry->slot : NULL;
+}
+
+/**
+ * @brief 向索引登记一个车位节点。
+ * @details 先迁移一步；插入前若负载将超过上限则开始渐进扩容。
+ * @param index 目标索引。
+ * @param slot_id 车位编号。
+ * @param slot 车位节点指针，不能为 NULL。
+ * @return 成功返回 0，参数无效返回 -1，编号已存在返回 -2，内存不足返回 -3。
+ */
+int slot_id_index_insert(SlotIdIndex *index, int slot_id,
+                         struct ParkingSlot *slot) {
+  size_t mask;
+  size_t pos;
+
+  if (index == NULL || slot == NULL) {
+    return -1;
+  }
+
+  slot_id_index_migrate(index, SLOT_INDEX_MIGRATE_STEP);
+  if ((index->count + 1) * SLOT_INDEX_LOAD_DEN >
+      index->capacity * SLOT_INDEX_LOAD_NUM) {
+    if (slot_id_index_begin_grow(index) != 0) {
+      return -3;
+    }
+  }
+  if (index->old_entries != NULL &&
+      slot_id_locate(index->old_entries, index->old_capacity, slot_id) !=
+          NULL) {
+    return -2;
+  }
+
+  mask = index->capacity - 1;
+  pos = hash_slot_id(slot_id) & mask;
+  while (index->entries[pos].slot != NULL) {
+    if (index->entries[pos].slot_id == slot_id) {
+      return -2;
+    }
+    pos = (pos + 1) & mask;
+  }
+
+  index->entries[pos].slot_id = slot_id;
+  index->entries[pos].slot = slot;
+  index->count++;
+  return 0;
+}
+
+/**
+ * @brief 预先扩容，使索引登记 count 个车位的过程中不再重新散列。
+ * @param index 目标索引。
+ * @param count 预期的车位总数。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int slot_id_index_reserve(SlotIdIndex *index, size_t count) {
+  size_t capacity;
+
+  if (index == NULL) {
+    return -1;
+  }
+  capacity = reserve_capacity(index->capacity, count);
+  if (capacity != index->capacity &&
+      slot_id_index_grow(index, capacity) != 0) {
+    return -3;
+  }
+  return 0;
+}
+
+/**
+ * @brief 从索引中移除一个车位编号。
+ * @details
+ * 删除后将同一探测链上的后续条目前移回填空位（backward shift），
+ * 保证查找时“遇到空桶即结束”的规则依然成立。条目仍在旧桶数组中时
+ * 改为留下墓碑，以免回填把未迁移的条目移到已迁移的位置。
+ * @param index 目标索引。
+ * @param slot_id 要移除的车位编号。
+ * @return 成功移除返回 0，编号不存在返回 -1。
+ */
+int slot_id_index_remove(SlotIdIndex *index, int slot_id) {
+  SlotIdIndexEntry *old_entry;
+  size_t mask;
+  size_t pos;
+  size_t next;
+
+  if (index == NULL || index->capacity == 0) {
+    return -1;
+  }
+
+  slot_id_index_migrate(index, SLOT_INDEX_MIGRATE_STEP);
+  mask = index->capacity - 1;
+  pos = hash_slot_id(slot_id) & mask;
+  while (index->entries[pos].slot != NULL &&
+         index->entries[pos].slot_id != slot_id) {
+    pos = (pos + 1) & mask;
+  }
+  if (index->entries[pos].slot == NULL) {
+    old_entry = index->old_entries != NULL
+                    ? slot_id_locate(index->old_entries, index->old_capacity,
+                                     slot_id)
+                    : NULL;
+    if (old_entry == NULL) {
+      return -1;
+    }
+    old_entry->slot = SLOT_INDEX_MOVED;
+    index->count--;
+    return 0;
+  }
+
+  next = (pos + 1) & mask;
+  while (index->entries[next].slot != NULL) {
+    size_t home = hash_slot_id(index->entries[next].slot_id) & mask;
+    /* 若 home 不在 (pos, next] 的循环区间内，则该条目可以前移到 pos */
+    if (((next - home) & mask) >= ((next - pos) & mask)) {
+      index->entries[pos] = index->entries[next];
+      pos = next;
+    }
+    next = (next + 1) & mask;
+  }
+
+  index->entries[pos].slot = NULL;
+  index->entries[pos].slot_id = 0;
+  index->count--;
+  return 0;
+}
+
+/**
+ * @brief 车位节点换到别处存放后，改写索引中该编号对应的节点。
+ * @param index 目标索引。
+ * @param slot_id 车位编号。
+ * @param slot 新的车位节点。
+ * @return 成功返回 0，编号不存在返回 -1。
+ */
+int slot_id_index_relocate(SlotIdIndex *index, int slot_id,
+                           struct ParkingSlot *slot) {
+  SlotIdIndexEntry *entry;
+
+  if (index == NULL || slot == NULL || index->capacity == 0) {
+    return -1;
+  }
+
+  entry = slot_id_locate(index->entries, index->capacity, slot_id);
+  if (entry == NULL && index->old_entries != NULL) {
+    entry = slot_id_locate(index->old_entries, index->old_capacity, slot_id);
+  }
+  if (entry == NULL) {
+    return -1;
+  }
+  entry->slot = slot;
+  return 0;
+}
+
+/* ========================================================================== */
+/*                             车牌号索引函数实现                             */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 把条目放入车牌号桶数组中第一个空桶（不检查重复）。
+ * @details 桶中缓存了编码，重新散列时无需再次计算字符串哈希。
+ * @param entries 目标桶数组。
+ * @param capacity 桶数组容量（2 的幂）。
+ * @param entry 要放入的条目。
+ */
+static void plate_place(PlateIndexEntry *entries, size_t capacity,
+                        const PlateIndexEntry *entry) {
+  size_t mask = capacity - 1;
+  size_t pos = plate_code_hash(&entry->code) & mask;
+
+  while (entries[pos].slot != NULL) {
+    pos = (pos + 1) & mask;
+  }
+  entries[pos] = *entry;
+}
+
+/**
+ * @brief (静态辅助函数) 在一个桶数组中按车牌查找桶，跳过墓碑。
+ * @param entries 桶数组。
+ * @param capacity 桶数组容量（2 的幂）。
+ * @param code 车牌的编码。
+ * @param license_plate 车牌号字符串。
+ * @return 找到返回该桶，否则返回 NULL。
+ */
+static PlateIndexEntry *plate_locate(PlateIndexEntry *entries,
+                                     size_t capacity, const PlateCode *code,
+                                     const char *license_plate) {
+  size_t mask = capacity - 1;
+  size_t pos = plate_code_hash(code) & mask;
+
+  while (entries[pos].slot != NULL) {
+    if (entries[pos].slot != SLOT_INDEX_MOVED &&
+        plate_entry_matches(&entries[pos], code, license_plate)) {
+      return &entries[pos];
+    }
+    pos = (pos + 1) & mask;
+  }
+  return NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 在一个桶数组中查找指向指定车位节点的桶。
+ * @param entries 桶数组。
+ * @param capacity 桶数组容量（2 的幂）。
+ * @param code 车位车牌的编码。
+ * @param slot 车位节点。
+ * @return 找到返回该桶，否则返回 NULL。
+ */
+static PlateIndexEntry *plate_locate_slot(PlateIndexEntry *entries,
+                                          size_t capacity,
+                                          const PlateCode *code,
+                                          const struct ParkingSlot *slot) {
+  size_t mask = capacity - 1;
+  size_t pos = plate_code_hash(code) & mask;
+
+  while (entries[pos].slot != NULL) {
+    if (entries[pos].slot == slot) {
+      return &entries[pos];
+    }
+    pos = (pos + 1) & mask;
+  }
+  return NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 把至多 buckets 个旧桶迁移到新桶数组。
+ * @param index 目标索引。
+ * @param buckets 本次迁移的旧桶数。
+ */
+static void plate_index_migrate(PlateIndex *index, size_t buckets) {
+  while (index->old_entries != NULL && buckets > 0) {
+    PlateIndexEntry *entry = &index->old_entries[index->migrate_pos];
+
+    if (entry->slot != NULL && entry->slot != SLOT_INDEX_MOVED) {
+      plate_place(index->entries, index->capacity, entry);
+      entry->slot = SLOT_INDEX_MOVED;
+    }
+    index->migrate_pos++;
+    buckets--;
+    if (index->migrate_pos == index->old_capacity) {
+      parking_memory_free(index->memory, index->old_entries);
+      index->old_entries = NULL;
+      index->old_capacity = 0;
+      index->migrate_pos = 0;
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 将车牌号索引扩容到指定容量（一次完成）。
+ * @param index 目标索引。
+ * @param new_capacity 新容量，必须为 2 的幂。
+ * @return 成功返回 0，内存不足返回 -1（此时原索引保持不变）。
+ */
+static int plate_index_grow(PlateIndex *index, size_t new_capacity) {
+  PlateIndexEntry *new_entries;
+  size_t i;
+
+  new_entries = (PlateIndexEntry *)parking_memory_calloc(
+      index->memory, PARKING_MEMORY_INDEX, new_capacity,
+      sizeof(PlateIndexEntry));
+  if (new_entries == NULL) {
+    return -1;
+  }
+
+  plate_index_migrate(index, index->old_capacity);
+  for (i = 0; i < index->capacity; i++) {
+    if (index->entries[i].slot != NULL) {
+      plate_place(new_entries, new_capacity, &index->entries[i]);
+    }
+  }
+
+  parking_memory_free(index->memory, index->entries);
+  index->entries = new_entries;
+  index->capacity = new_capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 开始车牌号索引的渐进扩容。
+ * @param index 目标索引。
+ * @return 成功返回 0，内存不足返回 -1（此时原索引保持不变）。
+ */
+static int plate_index_begin_grow(PlateIndex *index) {
+  PlateIndexEntry *new_entries;
+  size_t new_capacity =
+      index->capacity ? index->capacity * 2 : SLOT_INDEX_MIN_CAPACITY;
+
+  new_entries = (PlateIndexEntry *)parking_memory_calloc(
+      index->memory, PARKING_MEMORY_INDEX, new_capacity,
+      sizeof(PlateIndexEntry));
+  if (new_entries == NULL) {
+    return -1;
+  }
+  plate_index_migrate(index, index->old_capacity);
+  if (index->capacity > 0) {
+    index->old_entries = index->entries;
+    index->old_capacity = index->capacity;
+    index->migrate_pos = 0;
+  }
+  index->entries = new_entries;
+  index->capacity = new_capacity;
+  return 0;
+}
+
+/**
+ * @brief 将车牌号索引初始化为空状态（不分配内存）。
+ * @param index 要初始化的索引。
+ * @param memory 之后分配桶数组使用的内存对象，NULL 表示 C 堆。
+ */
+void plate_index_init(PlateIndex *index, ParkingMemory *memory) {
+  if (index == NULL) {
+    return;
+  }
+  index->memory = memory;
+  index->entries = NULL;
+  index->capacity = 0;
+  index->count = 0;
+  index->old_entries = NULL;
+  index->old_capacity = 0;
+  index->migrate_pos = 0;
+}
+
+/**
+ * @brief 释放车牌号索引占用的桶数组，并将其恢复为空状态。
+ * @param index 要释放的索引。
+ */
+void plate_index_free(PlateIndex *index) {
+  if (index == NULL) {
+    return;
+  }
+  parking_memory_free(index->memory, index->entries);
+  parking_memory_free(index->memory, index->old_entries);
+  plate_index_init(index, index->memory);
+}
+
+/**
+ * @brief 按车牌号查找车位节点。
+ * @details 查询串只编码一次；标准车牌的探测只比较整数编码，
+ *          非标准车牌在编码相同时才比较字符串。
+ * @param index 目标索引。
+ * @param license_plate 要查找的车牌号。
+ * @return 找到时返回车位节点指针，否则返回 NULL。
+ */
+struct ParkingSlot *plate_index_find(const PlateIndex *index,
+                                     const char *license_plate) {
+  PlateIndexEntry *entry;
+  PlateCode code;
+
+  if (index == NULL || license_plate == NULL || index->capacity == 0) {
+    return NULL;
+  }
+
+  plate_encode(license_plate, &code);
+  entry = plate_locate(index->entries, index->capacity, &code, license_plate);
+  if (entry == NULL && index->old_entries != NULL) {
+    entry = plate_locate(index->old_entries, index->old_capacity, &code,
+                         license_plate);
+  }
+  return entry != NULL ? entry->slot : NULL;
+}
+
+/**
+ * @brief 预先扩容，使索引登记 count 个车牌的过程中不再重新散列。
+ * @param index 目标索引。
+ * @param count 预期的车牌总数。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int plate_index_reserve(PlateIndex *index, size_t count) {
+  size_t capacity;
+
+  if (index == NULL) {
+    return -1;
+  }
+  capacity = reserve_capacity(index->capacity, count);
+  if (capacity != index->capacity && plate_index_grow(index, capacity) != 0) {
+    return -3;
+  }
+  return 0;
+}
+
+/**
+ * @brief 以车位节点当前的 license_plate 为键登记车位。
+ * @param index 目标索引。
+ * @param slot 已填写车牌号的车位节点。
+ * @return 成功返回 0，参数无效返回 -1，车牌已存在返回 -2，内存不足返回 -3。
+ */
+int plate_index_insert(PlateIndex *index, struct ParkingSlot *slot) {
+  PlateIndexEntry entry;
+
+  if (index == NULL || slot == NULL) {
+    return -1;
+  }
+
+  plate_index_migrate(index, SLOT_INDEX_MIGRATE_STEP);
+  if ((index->count + 1) * SLOT_INDEX_LOAD_DEN >
+      index->capacity * SLOT_INDEX_LOAD_NUM) {
+    if (plate_index_begin_grow(index) != 0) {
+      return -3;
+    }
+  }
+
+  plate_encode(slot->license_plate, &entry.code);
+  if (plate_locate(index->entries, index->capacity, &entry.code,
+                   slot->license_plate) != NULL ||
+      (index->old_entries != NULL &&
+       plate_locate(index->old_entries, index->old_capacity, &entry.code,
+                    slot->license_plate) != NULL)) {
+    return -2;
+  }
+
+  entry.slot = slot;
+  plate_place(index->entries, index->capacity, &entry);
+  index->count++;
+  return 0;
+}
+
+/**
+ * @brief 从车牌号索引中注销一个车位节点。
+ * @details 按车位节点当前的车牌定位桶，然后使用与 SlotIdIndex 相同的
+ *          后移回填策略删除；条目仍在旧桶数组中时留下墓碑。
+ * @param index 目标索引。
+ * @param slot 要注销的车位节点。
+ * @return 成功移除返回 0，未登记返回 -1。
+ */
+int plate_index_remove(PlateIndex *index, struct ParkingSlot *slot) {
+  PlateIndexEntry *old_entry;
+  PlateCode code;
+  size_t mask;
+  size_t pos;
+  size_t next;
+
+  if (index == NULL || slot == NULL || index->capacity == 0) {
+    return -1;
+  }
+
+  plate_index_migrate(index, SLOT_INDEX_MIGRATE_STEP);
+  mask = index->capacity - 1;
+  plate_encode(slot->license_plate, &code);
+  pos = plate_code_hash(&code) & mask;
+  while (index->entries[pos].slot != NULL &&
+         index->entries[pos].slot != slot) {
+    pos = (pos + 1) & mask;
+  }
+  if (index->entries[pos].slot == NULL) {
+    old_entry = index->old_entries != NULL
+                    ? plate_locate_slot(index->old_entries,
+                                        index->old_capacity, &code, slot)
+                    : NULL;
+    if (old_entry == NULL) {
+      return -1;
+    }
+    old_entry->slot = SLOT_INDEX_MOVED;
+    index->count--;
+    return 0;
+  }
+
+  next = (pos + 1) & mask;
+  while (index->entries[next].slot != NULL) {
+    size_t home = plate_code_hash(&index->entries[next].code) & mask;
+    if (((next - home) & mask) >= ((next - pos) & mask)) {
+      index->entries[pos] = index->entries[next];
+      pos = next;
+    }
+    next = (next + 1) & mask;
+  }
+
+  index->entries[pos].slot = NULL;
+  index->entries[pos].code.high = 0;
+  index->entries[pos].code.low = 0;
+  index->count--;
+  return 0;
+}
+
+/**
+ * @brief 车位节点换到别处存放后，改写索引中指向旧节点的桶。
+ * @param index 目标索引。
+ * @param from 旧的车位节点。
+ * @param to 新的车位节点。
+ * @return 成功返回 0，旧节点未登记返回 -1。
+ */
+int plate_index_relocate(PlateIndex *index, const struct ParkingSlot *from,
+                         struct ParkingSlot *to) {
+  PlateIndexEntry *entry;
+  PlateCode code;
+
+  if (index == NULL || from == NULL || to == NULL || index->capacity == 0) {
+    return -1;
+  }
+
+  plate_encode(from->license_plate, &code);
+  entry = plate_locate_slot(index->entries, index->capacity, &code, from);
+  if (entry == NULL && index->old_entries != NULL) {
+    entry = plate_locate_slot(index->old_entries, index->old_capacity, &code,
+                              from);
+  }
+  if (entry == NULL) {
+    return -1;
+  }
+  entry->slot = to;
+  return 0;
+}
+
+/* ========================================================================== */
+/*                              索引映像函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 判断映像的桶数能否容纳指定条目数。
+ * @param capacity 映像的桶数。
+ * @param count 条目数。
+ * @return 是 2 的幂且负载不超过上限返回 1，否则返回 0。
+ */
+static int image_capacity_valid(size_t capacity, size_t count) {
+  return capacity >= SLOT_INDEX_MIN_CAPACITY &&
+         (capacity & (capacity - 1)) == 0 &&
+         count * SLOT_INDEX_LOAD_DEN <= capacity * SLOT_INDEX_LOAD_NUM;
+}
+
+/**
+ * @brief (静态辅助函数) 核对映像中各桶的行号并统计非空桶。
+ * @param image 映像。
+ * @param capacity 映像的桶数。
+ * @param stride 每个桶的字节数，行号位于桶首。
+ * @param row_count 行号的上限。
+ * @return 非空桶数；有行号越界时返回 row_count + 1。
+ */
+static size_t image_count_rows(const unsigned char *image, size_t capacity,
+                               size_t stride, size_t row_count) {
+  size_t used = 0;
+  size_t i;
+
+  for (i = 0; i < capacity; i++) {
+    unsigned long row = codec_get_u32(image + i * stride);
+
+    if (row > row_count) {
+      return row_count + 1;
+    }
+    used += row != 0;
+  }
+  return used;
+}
+
+/**
+ * @brief 取登记 count 个条目的索引映像使用的桶数。
+ * @param count 条目数。
+ * @return 桶数（2 的幂）。
+ */
+size_t index_image_capacity(size_t count) {
+  return reserve_capacity(0, count);
+}
+
+/**
+ * @brief 把一组车位的编号索引桶布局写成映像。
+ * @param rows 车位节点数组。
+ * @param count 车位数。
+ * @param capacity 桶数。
+ * @param[out] image 接收映像。
+ */
+void slot_id_index_write_image(struct ParkingSlot *const *rows, size_t count,
+                               size_t capacity, unsigned char *image) {
+  size_t mask = capacity - 1;
+  size_t i;
+
+  memset(image, 0, capacity * SLOT_ID_IMAGE_BUCKET);
+  for (i = 0; i < count; i++) {
+    size_t pos = hash_slot_id(rows[i]->slot_id) & mask;
+
+    while (codec_get_u32(image + pos * SLOT_ID_IMAGE_BUCKET) != 0) {
+      pos = (pos + 1) & mask;
+    }
+    codec_put_u32(image + pos * SLOT_ID_IMAGE_BUCKET, (unsigned long)i + 1);
+  }
+}
+
+/**
+ * @brief 由映像直接建立编号索引。
+ * @param index 目标索引，须为空。
+ * @param image 映像。
+ * @param capacity 映像的桶数。
+ * @param rows 车位节点数组。
+ * @param count 车位数。
+ * @return 成功返回 0，参数或映像无效返回 -1，内存不足返回 -3。
+ */
+int slot_id_index_read_image(SlotIdIndex *index, const unsigned char *image,
+                             size_t capacity, struct ParkingSlot *const *rows,
+                             size_t count) {
+  SlotIdIndexEntry *entries;
+  size_t i;
+
+  if (index == NULL || image == NULL || rows == NULL || index->count != 0 ||
+      !image_capacity_valid(capacity, count) ||
+      image_count_rows(image, capacity, SLOT_ID_IMAGE_BUCKET, count) != count) {
+    return -1;
+  }
+  entries = (SlotIdIndexEntry *)parking_memory_calloc(
+      index->memory, PARKING_MEMORY_INDEX, capacity, sizeof(SlotIdIndexEntry));
+  if (entries == NULL) {
+    return -3;
+  }
+  for (i = 0; i < capacity; i++) {
+    unsigned long row = codec_get_u32(image + i * SLOT_ID_IMAGE_BUCKET);
+
+    if (row != 0) {
+      entries[i].slot_id = rows[row - 1]->slot_id;
+      entries[i].slot = rows[row - 1];
+    }
+  }
+
+  parking_memory_free(index->memory, index->old_entries);
+  parking_memory_free(index->memory, index->entries);
+  index->old_entries = NULL;
+  index->old_capacity = 0;
+  index->migrate_pos = 0;
+  index->entries = entries;
+  index->capacity = capacity;
+  index->count = count;
+  return 0;
+}
+
+/**
+ * @brief 把一组车位中在场车辆的车牌索引桶布局写成映像。
+ * @param rows 车位节点数组。
+ * @param count 车位数。
+ * @param capacity 桶数。
+ * @param[out] image 接收映像。
+ * @return 映像中登记的车牌数。
+ */
+size_t plate_index_write_image(struct ParkingSlot *const *rows, size_t count,
+                               size_t capacity, unsigned char *image) {
+  size_t mask = capacity - 1;
+  size_t placed = 0;
+  size_t i;
+
+  memset(image, 0, capacity * PLATE_IMAGE_BUCKET);
+  for (i = 0; i < count; i++) {
+    PlateCode code;
+    size_t pos;
+    int duplicate = 0;
+
+    if (rows[i]->status != OCCUPIED_STATUS) {
+      continue;
+    }
+    plate_encode(rows[i]->license_plate, &code);
+    pos = plate_code_hash(&code) & mask;
+    while (!duplicate &&
+           codec_get_u32(image + pos * PLATE_IMAGE_BUCKET) != 0) {
+      const unsigned char *bucket = image + pos * PLATE_IMAGE_BUCKET;
+
+      duplicate = codec_get_u32(bucket + 4) == code.high &&
+                  codec_get_u32(bucket + 8) == code.low &&
+                  (plate_code_is_standard(&code) ||
+                   strcmp(rows[codec_get_u32(bucket) - 1]->license_plate,
+                          rows[i]->license_plate) == 0);
+      pos = (pos + 1) & mask;
+    }
+    if (!duplicate) {
+      codec_put_u32(image + pos * PLATE_IMAGE_BUCKET, (unsigned long)i + 1);
+      codec_put_u32(image + pos * PLATE_IMAGE_BUCKET + 4, code.high);
+      codec_put_u32(image + pos * PLATE_IMAGE_BUCKET + 8, code.low);
+      placed++;
+    }
+  }
+  return placed;
+}
+
+/**
+ * @brief 由映像直接建立车牌索引。
+ * @param index 目标索引，须为空。
+ * @param image 映像。
+ * @param capacity 映像的桶数。
+ * @param rows 车位节点数组。
+ * @param row_count 车位数。
+ * @param count 映像中应登记的车牌数。
+ * @return 成功返回 0，参数或映像无效返回 -1，内存不足返回 -3。
+ */
+int plate_index_read_image(PlateIndex *index, const unsigned char *image,
+                           size_t capacity, struct ParkingSlot *const *rows,
+                           size_t row_count, size_t count) {
+  PlateIndexEntry *entries;
+  size_t i;
+
+  if (index == NULL || image == NULL || rows == NULL || index->count != 0 ||
+      !image_capacity_valid(capacity, count) ||
+      image_count_rows(image, capacity, PLATE_IMAGE_BUCKET, row_count) !=
+          count) {
+    return -1;
+  }
+  entries = (PlateIndexEntry *)parking_memory_calloc(
+      index->memory, PARKING_MEMORY_INDEX, capacity, sizeof(PlateIndexEntry));
+  if (entries == NULL) {
+    return -3;
+  }
+  for (i = 0; i < capacity; i++) {
+    const unsigned char *bucket = image + i * PLATE_IMAGE_BUCKET;
+    unsigned long row = codec_get_u32(bucket);
+
+    if (row != 0) {
+      entries[i].code.high = codec_get_u32(bucket + 4);
+      entries[i].code.low = codec_get_u32(bucket + 8);
+      entries[i].slot = rows[row - 1];
+    }
+  }
+
+  parking_memory_free(index->memory, index->old_entries);
+  parking_memory_free(index->memory, index->entries);
+  index->old_entries = NULL;
+  index->old_capacity = 0;
+  index->migrate_pos = 0;
+  index->entries = entries;
+  index->capacity = capacity;
+  index->count = count;
+  return 0;
+}
+
+/* ========================================================================== */
+/*                            入场时间链表函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief 将入场时间链表初始化为空状态。
+ * @param list 要初始化的链表。
+ */
+void entry_order_init(EntryOrderList *list) {
+  if (list == NULL) {
+    return;
+  }
+  list->oldest = NULL;
+  list->newest = NULL;
+  list->count = 0;
+}
+
+/**
+ * @brief 按车位节点当前的 entry_time 将其插入链表。
+ * @details 从表尾向前跳过入场时间更晚的节点，按时间顺序入场时不发生跳过。
+ * @param list 目标链表。
+ * @param slot 不在链表中的车位节点。
+ */
+void entry_order_insert(EntryOrderList *list, struct ParkingSlot *slot) {
+  struct ParkingSlot *prev;
+
+  if (list == NULL || slot == NULL) {
+    return;
+  }
+
+  prev = list->newest;
+  while (prev != NULL && prev->entry_time > slot->entry_time) {
+    prev = prev->entry_prev;
+  }
+
+  slot->entry_prev = prev;
+  if (prev == NULL) {
+    slot->entry_next = list->oldest;
+    list->oldest = slot;
+  } else {
+    slot->entry_next = prev->entry_next;
+    prev->entry_next = slot;
+  }
+  if (slot->entry_next == NULL) {
+    list->newest = slot;
+  } else {
+    slot->entry_next->entry_prev = slot;
+  }
+  list->count++;
+}
+
+/**
+ * @brief 把一批已按入场时间排好序的车位节点依次接到表尾。
+ * @param list 目标链表。
+ * @param slots 车位节点数组，入场时间不减且不早于当前表尾。
+ * @param count 节点数。
+ */
+void entry_order_append_sorted(EntryOrderList *list,
+                               struct ParkingSlot *const *slots,
+                               size_t count) {
+  size_t i;
+
+  if (list == NULL || slots == NULL) {
+    return;
+  }
+  for (i = 0; i < count; i++) {
+    struct ParkingSlot *slot = slots[i];
+
+    slot->entry_prev = list->newest;
+    slot->entry_next = NULL;
+    if (list->newest == NULL) {
+      list->oldest = slot;
+    } else {
+      list->newest->entry_next = slot;
+    }
+    list->newest = slot;
+  }
+  list->count += count;
+}
+
+/**
+ * @brief 从链表中摘除一个车位节点。
+ * @param list 目标链表。
+ * @param slot 已在链表中的车位节点。
+ */
+void entry_order_remove(EntryOrderList *list, struct ParkingSlot *slot) {
+  if (list == NULL || slot == NULL) {
+    return;
+  }
+
+  if (slot->entry_prev == NULL) {
+    list->oldest = slot->entry_next;
+  } else {
+    slot->entry_prev->entry_next = slot->entry_next;
+  }
+  if (slot->entry_next == NULL) {
+    list->newest = slot->entry_prev;
+  } else {
+    slot->entry_next->entry_prev = slot->entry_prev;
+  }
+  slot->entry_prev = NULL;
+  slot->entry_next = NULL;
+  list->count--;
+}
+
+/**
+ * @brief 车位节点换到别处存放后，让前后节点与表头表尾改为指向新节点。
+ * @param list 目标链表。
+ * @param from 旧的车位节点。
+ * @param to 新的车位节点。
+ */
+void entry_order_relocate(EntryOrderList *list,
+                          const struct ParkingSlot *from,
+                          struct ParkingSlot *to) {
+  if (list == NULL || from == NULL || to == NULL ||
+      (from->entry_prev == NULL && list->oldest != from)) {
+    return; /* 旧节点不在链表中 */
+  }
+
+  if (to->entry_prev == NULL) {
+    list->oldest = to;
+  } else {
+    to->entry_prev->entry_next = to;
+  }
+  if (to->entry_next == NULL) {
+    list->newest = to;
+  } else {
+    to->entry_next->entry_prev = to;
+  }
+}
+
+/* ========================================================================== */
+/*                            月费到期堆函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 把一项写入堆的指定位置，并同步车位记录的下标。
+ * @param heap 目标堆。
+ * @param pos 目标位置。
+ * @param entry 要写入的项。
+ */
+static void due_heap_place(DueDateHeap *heap, size_t pos, DueHeapEntry entry) {
+  heap->entries[pos] = entry;
+  entry.slot->due_heap_index = (int)pos;
+}
+
+/**
+ * @brief (静态辅助函数) 把指定位置的项向根方向上浮到合适位置。
+ * @param heap 目标堆。
+ * @param pos 起始位置。
+ */
+static void due_heap_sift_up(DueDateHeap *heap, size_t pos) {
+  DueHeapEntry entry = heap->entries[pos];
+
+  while (pos > 0) {
+    size_t parent = (pos - 1) / 2;
+
+    if (heap->entries[parent].due <= entry.due) {
+      break;
+    }
+    due_heap_place(heap, pos, heap->entries[parent]);
+    pos = parent;
+  }
+  due_heap_place(heap, pos, entry);
+}
+
+/**
+ * @brief (静态辅助函数) 把指定位置的项向叶方向下沉到合适位置。
+ * @param heap 目标堆。
+ * @param pos 起始位置。
+ */
+static void due_heap_sift_down(DueDateHeap *heap, size_t pos) {
+  DueHeapEntry entry = heap->entries[pos];
+
+  for (;;) {
+    size_t child = pos * 2 + 1;
+
+    if (child >= heap->count) {
+      break;
+    }
+    if (child + 1 < heap->count &&
+        heap->entries[child + 1].due < heap->entries[child].due) {
+      child++;
+    }
+    if (heap->entries[child].due >= entry.due) {
+      break;
+    }
+    due_heap_place(heap, pos, heap->entries[child]);
+    pos = child;
+  }
+  due_heap_place(heap, pos, entry);
+}
+
+/**
+ * @brief (静态辅助函数) 向候选下标小堆中加入一个堆下标。
+ * @details 候选按所指堆项的到期时间排序，调用者保证数组还有空位。
+ * @param heap 被遍历的月费到期堆。
+ * @param candidates 候选下标数组。
+ * @param count 候选数，加入后递增。
+ * @param index 要加入的堆下标。
+ */
+static void due_candidates_push(const DueDateHeap *heap, size_t *candidates,
+                                size_t *count, size_t index) {
+  size_t pos = (*count)++;
+  time_t due = heap->entries[index].due;
+
+  while (pos > 0) {
+    size_t parent = (pos - 1) / 2;
+
+    if (heap->entries[candidates[parent]].due <= due) {
+      break;
+    }
+    candidates[pos] = candidates[parent];
+    pos = parent;
+  }
+  candidates[pos] = index;
+}
+
+/**
+ * @brief (静态辅助函数) 从候选下标小堆中取出到期时间最早的堆下标。
+ * @param heap 被遍历的月费到期堆。
+ * @param candidates 候选下标数组，至少有一项。
+ * @param count 候选数，取出后递减。
+ * @return 取出的堆下标。
+ */
+static size_t due_candidates_pop(const DueDateHeap *heap, size_t *candidates,
+                                 size_t *count) {
+  size_t top = candidates[0];
+  size_t last = candidates[--(*count)];
+  time_t due = heap->entries[last].due;
+  size_t pos = 0;
+
+  for (;;) {
+    size_t child = pos * 2 + 1;
+
+    if (child >= *count) {
+      break;
+    }
+    if (child + 1 < *count && heap->entries[candidates[child + 1]].due <
+                                  heap->entries[candidates[child]].due) {
+      child++;
+    }
+    if (heap->entries[candidates[child]].due >= due) {
+      break;
+    }
+    candidates[pos] = candidates[child];
+    pos = child;
+  }
+  if (*count > 0) {
+    candidates[pos] = last;
+  }
+  return top;
+}
+
+/**
+ * @brief 将月费到期堆初始化为空状态（不分配内存）。
+ * @param heap 要初始化的堆。
+ * @param memory 之后分配堆数组使用的内存对象，NULL 表示 C 堆。
+ */
+void due_heap_init(DueDateHeap *heap, ParkingMemory *memory) {
+  if (heap == NULL) {
+    return;
+  }
+  heap->memory = memory;
+  heap->entries = NULL;
+  heap->count = 0;
+  heap->capacity = 0;
+}
+
+/**
+ * @brief 释放月费到期堆占用的堆数组，并将其恢复为空状态。
+ * @param heap 要释放的堆。
+ */
+void due_heap_free(DueDateHeap *heap) {
+  if (heap == NULL) {
+    return;
+  }
+  parking_memory_free(heap->memory, heap->entries);
+  heap->entries = NULL;
+  heap->count = 0;
+  heap->capacity = 0;
+}
+
+/**
+ * @brief 预留至少 capacity 项的堆数组。
+ * @param heap 目标堆。
+ * @param capacity 需要的容量。
+ * @return 成功返回 0，内存不足返回 -3（此时原堆保持不变）。
+ */
+int due_heap_reserve(DueDateHeap *heap, size_t capacity) {
+  DueHeapEntry *entries;
+
+  if (heap == NULL) {
+    return -1;
+  }
+  if (capacity <= heap->capacity) {
+    return 0;
+  }
+  entries = (DueHeapEntry *)parking_memory_realloc(
+      heap->memory, PARKING_MEMORY_INDEX, heap->entries,
+      capacity * sizeof(DueHeapEntry));
+  if (entries == NULL) {
+    return -3;
+  }
+  heap->entries = entries;
+  heap->capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief 登记、修改或注销一个车位的到期时间。
+ * @param heap 目标堆。
+ * @param slot 车位节点。
+ * @param due 新的到期时间；小于等于 0 时把车位移出堆。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int due_heap_update(DueDateHeap *heap, struct ParkingSlot *slot, time_t due) {
+  size_t pos;
+  time_t old_due;
+
+  if (heap == NULL || slot == NULL) {
+    return -1;
+  }
+  if (due <= 0) {
+    due_heap_remove(heap, slot);
+    return 0;
+  }
+
+  if (slot->due_heap_index < 0) {
+    if (heap->count == heap->capacity &&
+        due_heap_reserve(heap, heap->capacity ? heap->capacity * 2
+                                              : DUE_HEAP_MIN_CAPACITY) != 0) {
+      return -3;
+    }
+    heap->entries[heap->count].due = due;
+    heap->entries[heap->count].slot = slot;
+    heap->count++;
+    due_heap_sift_up(heap, heap->count - 1);
+    return 0;
+  }
+
+  pos = (size_t)slot->due_heap_index;
+  old_due = heap->entries[pos].due;
+  heap->entries[pos].due = due;
+  if (due < old_due) {
+    due_heap_sift_up(heap, pos);
+  } else if (due > old_due) {
+    due_heap_sift_down(heap, pos);
+  }
+  return 0;
+}
+
+/**
+ * @brief 把车位移出堆；车位不在堆中时不做任何事。
+ * @details 用堆尾项填补空位，再按它与父节点的大小决定上浮或下沉。
+ * @param heap 目标堆。
+ * @param slot 车位节点。
+ */
+void due_heap_remove(DueDateHeap *heap, struct ParkingSlot *slot) {
+  size_t pos;
+
+  if (heap == NULL || slot == NULL || slot->due_heap_index < 0) {
+    return;
+  }
+  pos = (size_t)slot->due_heap_index;
+  slot->due_heap_index = -1;
+  heap->count--;
+  if (pos == heap->count) {
+    return;
+  }
+
+  due_heap_place(heap, pos, heap->entries[heap->count]);
+  if (pos > 0 && heap->entries[(pos - 1) / 2].due > heap->entries[pos].due) {
+    due_heap_sift_up(heap, pos);
+  } else {
+    due_heap_sift_down(heap, pos);
+  }
+}
+
+/**
+ * @brief 车位节点换到别处存放后，改写堆中对应项的节点。
+ * @param heap 目标堆。
+ * @param slot 新的车位节点。
+ */
+void due_heap_relocate(DueDateHeap *heap, struct ParkingSlot *slot) {
+  if (heap == NULL || slot == NULL || slot->due_heap_index < 0) {
+    return;
+  }
+  heap->entries[slot->due_heap_index].slot = slot;
+}
+
+/**
+ * @brief 按到期时间从早到晚取出到期时间落在 [from, to) 内的车位。
+ * @details 每取出一个候选最多放入两个子节点，因此候选数不超过已取出数加一；
+ *          候选数组先按 limit 分配，只有经过早于 from 的项时才需要扩容。
+ * @param heap 目标堆。
+ * @param from 到期时间下界（含）。
+ * @param to 到期时间上界（不含），小于等于 0 表示不设上界。
+ * @param[out] slots 接收车位的数组。
+ * @param limit 最多取出的车位数。
+ * @return 写入的车位数；参数无效返回 -1，候选数组内存不足返回 -3。
+ */
+int due_heap_collect(const DueDateHeap *heap, time_t from, time_t to,
+                     struct ParkingSlot **slots, int limit) {
+  size_t *candidates;
+  size_t capacity;
+  size_t pending = 0;
+  int found = 0;
+
+  if (heap == NULL || slots == NULL || limit < 0) {
+    return -1;
+  }
+  if (heap->count == 0 || limit == 0 ||
+      (to > 0 && heap->entries[0].due >= to)) {
+    return 0;
+  }
+
+  capacity = (size_t)limit + 2;
+  if (capacity > heap->count) {
+    capacity = heap->count;
+  }
+  candidates = (size_t *)parking_memory_alloc(
+      heap->memory, PARKING_MEMORY_INDEX, capacity * sizeof(size_t));
+  if (candidates == NULL) {
+    return -3;
+  }
+
+  due_candidates_push(heap, candidates, &pending, 0);
+  while (pending > 0 && found < limit) {
+    size_t index = due_candidates_pop(heap, candidates, &pending);
+    size_t child = index * 2 + 1;
+
+    if (heap->entries[index].due >= from) {
+      slots[found++] = heap->entries[index].slot;
+    }
+    if (pending + 2 > capacity && capacity < heap->count) {
+      size_t grown = capacity * 2 < heap->count ? capacity * 2 : heap->count;
+      size_t *larger = (size_t *)parking_memory_realloc(
+          heap->memory, PARKING_MEMORY_INDEX, candidates,
+          grown * sizeof(size_t));
+
+      if (larger == NULL) {
+        parking_memory_free(heap->memory, candidates);
+        return -3;
+      }
+      candidates = larger;
+      capacity = grown;
+    }
+    for (; child <= index * 2 + 2 && child < heap->count; child++) {
+      if (to <= 0 || heap->entries[child].due < to) {
+        due_candidates_push(heap, candidates, &pending, child);
+      }
+    }
+  }
+  parking_memory_free(heap->memory, candidates);
+  return found;
+}
+
+/* ========================================================================== */
+/*                            日历计数索引函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 将日历计数索引扩容到指定容量。
+ * @param index 目标索引。
+ * @param new_capacity 新容量，必须为 2 的幂。
+ * @return 成功返回 0，内存不足返回 -1（此时原索引保持不变）。
+ */
+static int calendar_count_grow(CalendarCountIndex *index,
+                               size_t new_capacity) {
+  CalendarCountEntry *new_entries;
+  size_t mask = new_capacity - 1;
+  size_t i;
+
+  new_entries = (CalendarCountEntry *)parking_memory_calloc(
+      index->memory, PARKING_MEMORY_INDEX, new_capacity,
+      sizeof(CalendarCountEntry));
+  if (new_entries == NULL) {
+    return -1;
+  }
+
+  for (i = 0; i < index->capacity; i++) {
+    if (index->entries[i].key != 0) {
+      size_t pos = hash_slot_id((int)index->entries[i].key) & mask;
+      while (new_entries[pos].key != 0) {
+        pos = (pos + 1) & mask;
+      }
+      new_entries[pos] = index->entries[i];
+    }
+  }
+
+  parking_memory_free(index->memory, index->entries);
+  index->entries = new_entries;
+  index->capacity = new_capacity;
+  return 0;
+}
+
+/**
+ * @brief 将日历计数索引初始化为空状态（不分配内存）。
+ * @param index 要初始化的索引。
+ * @param memory 之后分配桶数组使用的内存对象，NULL 表示 C 堆。
+ */
+void calendar_count_init(CalendarCountIndex *index, ParkingMemory *memory) {
+  if (index == NULL) {
+    return;
+  }
+  index->memory = memory;
+  index->entries = NULL;
+  index->capacity = 0;
+  index->count = 0;
+}
+
+/**
+ * @brief 释放日历计数索引占用的桶数组，并将其恢复为空状态。
+ * @param index 要释放的索引。
+ */
+void calendar_count_free(CalendarCountIndex *index) {
+  if (index == NULL) {
+    return;
+  }
+  parking_memory_free(index->memory, index->entries);
+  calendar_count_init(index, index->memory);
+}
+
+/**
+ * @brief 调整某个日历键下某一类别的计数。
+ * @details 键不存在时新建，计数不会被减到负数，也不会因归零而删除桶。
+ * @param index 目标索引。
+ * @param key 日历键（正数）。
+ * @param category 类别下标（0 到 CALENDAR_COUNT_CATEGORIES - 1）。
+ * @param delta 调整量。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int calendar_count_add(CalendarCountIndex *index, long key, int category,
+                       int delta) {
+  size_t mask;
+  size_t pos;
+
+  if (index == NULL || key <= 0 || category < 0 ||
+      category >= CALENDAR_COUNT_CATEGORIES) {
+    return -1;
+  }
+
+  if ((index->count + 1) * SLOT_INDEX_LOAD_DEN >
+      index->capacity * SLOT_INDEX_LOAD_NUM) {
+    size_t new_capacity = index->capacity ? index->capacity * 2
+                                          : SLOT_INDEX_MIN_CAPACITY;
+    if (calendar_count_grow(index, new_capacity) != 0) {
+      return -3;
+    }
+  }
+
+  mask = index->capacity - 1;
+  pos = hash_slot_id((int)key) & mask;
+  while (index->entries[pos].key != 0 && index->entries[pos].key != key) {
+    pos = (pos + 1) & mask;
+  }
+  if (index->entries[pos].key == 0) {
+    index->entries[pos].key = key;
+    index->count++;
+  }
+
+  index->entries[pos].counts[category] += delta;
+  if (index->entries[pos].counts[category] < 0) {
+    index->entries[pos].counts[category] = 0;
+  }
+  return 0;
+}
+
+/**
+ * @brief 读取某个日历键下某一类别的计数。
+ * @param index 目标索引。
+ * @param key 日历键。
+ * @param category 类别下标。
+ * @return 计数值；键不存在或参数无效时返回 0。
+ */
+int calendar_count_get(const CalendarCountIndex *index, long key,
+                       int category) {
+  size_t mask;
+  size_t pos;
+
+  if (index == NULL || index->capacity == 0 || key <= 0 || category < 0 ||
+      category >= CALENDAR_COUNT_CATEGORIES) {
+    return 0;
+  }
+
+  mask = index->capacity - 1;
+  pos = hash_slot_id((int)key) & mask;
+  while (index->entries[pos].key != 0) {
+    if (index->entries[pos].key == key) {
+      return index->entries[pos].counts[category];
+    }
+    pos = (pos + 1) & mask;
+  }
+  return 0;
+}
+
+/* ========================================================================== */
+/*                               三元组索引实现                               */
+/* ========================================================================== */
+
+#define TRIGRAM_MAX_TERMS 256 /**< 单段文本最多登记的三元组数 */
+
+/**
+ * @brief (静态辅助函数) 由字段与文本中的三个字节组成三元组键。
+ * @param field 字段下标。
+ * @param p 指向三个字节的指针。
+ * @return 非 0 的键值。
+ */
+static unsigned long trigram_key(int field, const char *p) {
+  const unsigned char *b = (const unsigned char *)p;
+
+  return (((unsigned long)field << 24) |
+          ((unsigned long)b[0] << 16) | ((unsigned long)b[1] << 8) |
+          (unsigned long)b[2]) +
+         1UL;
+}
+
+/**
+ * @brief (静态辅助函数) 计算三元组键的哈希值。
+ * @param key 三元组键。
+ * @return 哈希值。
+ */
+static unsigned long hash_trigram(unsigned long key) {
+  return (key * 2654435761UL) & 0xFFFFFFFFUL;
+}
+
+/**
+ * @brief (静态辅助函数) 将桶数组扩容到指定容量并重新散列所有倒排表。
+ * @param index 目标索引。
+ * @param new_capacity 新容量（2 的幂）。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int trigram_index_grow(TrigramIndex *index, size_t new_capacity) {
+  TrigramPosting *new_postings;
+  size_t mask = new_capacity - 1;
+  size_t i;
+
+  new_postings = (TrigramPosting *)parking_memory_calloc(
+      index->memory, PARKING_MEMORY_INDEX, new_capacity,
+      sizeof(TrigramPosting));
+  if (new_postings == NULL) {
+    return -1;
+  }
+
+  for (i = 0; i < index->capacity; i++) {
+    if (index->postings[i].key != 0) {
+      size_t pos = hash_trigram(index->postings[i].key) & mask;
+      while (new_postings[pos].key != 0) {
+        pos = (pos + 1) & mask;
+      }
+      new_postings[pos] = index->postings[i];
+    }
+  }
+
+  parking_memory_free(index->memory, index->postings);
+  index->postings = new_postings;
+  index->capacity = new_capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 按键查找倒排表，不存在时新建。
+ * @param index 目标索引。
+ * @param key 三元组键。
+ * @return 倒排表指针；内存不足时返回 NULL。
+ */
+static TrigramPosting *trigram_posting_find_or_add(TrigramIndex *index,
+                                                   unsigned long key) {
+  size_t mask;
+  size_t pos;
+
+  if ((index->count + 1) * SLOT_INDEX_LOAD_DEN >
+      index->capacity * SLOT_INDEX_LOAD_NUM) {
+    size_t new_capacity = index->capacity ? index->capacity * 2
+                                          : SLOT_INDEX_MIN_CAPACITY;
+    if (trigram_index_grow(index, new_capacity) != 0) {
+      return NULL;
+    }
+  }
+
+  mask = index->capacity - 1;
+  pos = hash_trigram(key) & mask;
+  while (index->postings[pos].key != 0 && index->postings[pos].key != key) {
+    pos = (pos + 1) & mask;
+  }
+  if (index->postings[pos].key == 0) {
+    index->postings[pos].key = key;
+    index->count++;
+  }
+  return &index->postings[pos];
+}
+
+/**
+ * @brief (静态辅助函数) 按键查找倒排表。
+ * @param index 目标索引。
+ * @param key 三元组键。
+ * @return 倒排表指针；不存在时返回 NULL。
+ */
+static const TrigramPosting *trigram_posting_find(const TrigramIndex *index,
+                                                  unsigned long key) {
+  size_t mask;
+  size_t pos;
+
+  if (index->capacity == 0) {
+    return NULL;
+  }
+  mask = index->capacity - 1;
+  pos = hash_trigram(key) & mask;
+  while (index->postings[pos].key != 0) {
+    if (index->postings[pos].key == key) {
+      return &index->postings[pos];
+    }
+    pos = (pos + 1) & mask;
+  }
+  return NULL;
+}
+
+/**
+ * @brief 将三元组索引初始化为空状态（不分配内存）。
+ * @param index 要初始化的索引。
+ * @param memory 之后分配桶数组使用的内存对象，NULL 表示 C 堆。
+ */
+void trigram_index_init(TrigramIndex *index, ParkingMemory *memory) {
+  if (index == NULL) {
+    return;
+  }
+  index->memory = memory;
+  index->postings = NULL;
+  index->capacity = 0;
+  index->count = 0;
+  index->live_entries = 0;
+  index->stale_entries = 0;
+  index->degraded = 0;
+}
+
+/**
+ * @brief 释放三元组索引占用的全部内存，并将其恢复为空状态。
+ * @param index 要释放的索引。
+ */
+void trigram_index_free(TrigramIndex *index) {
+  size_t i;
+
+  if (index == NULL) {
+    return;
+  }
+  for (i = 0; i < index->capacity; i++) {
+    parking_memory_free(index->memory, index->postings[i].entries);
+  }
+  parking_memory_free(index->memory, index->postings);
+  trigram_index_init(index, index->memory);
+}
+
+/**
+ * @brief 清空所有倒排表，保留已分配的内存供重建使用。
+ * @param index 目标索引。
+ */
+void trigram_index_clear(TrigramIndex *index) {
+  size_t i;
+
+  if (index == NULL) {
+    return;
+  }
+  for (i = 0; i < index->capacity; i++) {
+    index->postings[i].count = 0;
+  }
+  index->live_entries = 0;
+  index->stale_entries = 0;
+  index->degraded = 0;
+}
+
+/**
+ * @brief 以车位当前的 search_stamp 登记一段文本中的全部三元组。
+ * @param index 目标索引。
+ * @param slot 车位节点。
+ * @param handle 车位的句柄。
+ * @param field 字段下标。
+ * @param text 要登记的文本。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int trigram_index_insert(TrigramIndex *index, struct ParkingSlot *slot,
+                         SlotHandle handle, int field, const char *text) {
+  unsigned long seen[TRIGRAM_MAX_TERMS];
+  size_t terms = 0;
+  size_t length;
+  size_t i;
+
+  if (index == NULL || slot == NULL || text == NULL || field < 0 ||
+      field >= TRIGRAM_FIELD_COUNT) {
+    return -1;
+  }
+
+  length = strlen(text);
+  for (i = 0; i + 3 <= length && terms < TRIGRAM_MAX_TERMS; i++) {
+    unsigned long key = trigram_key(field, text + i);
+    TrigramPosting *posting;
+    size_t j;
+
+    for (j = 0; j < terms && seen[j] != key; j++) {
+    }
+    if (j < terms) {
+      continue; /* 同一文本中重复的三元组只登记一次 */
+    }
+    seen[terms++] = key;
+
+    posting = trigram_posting_find_or_add(index, key);
+    if (posting != NULL && posting->count == posting->capacity) {
+      size_t capacity = posting->capacity ? posting->capacity * 2 : 4;
+      TrigramEntry *entries = (TrigramEntry *)parking_memory_realloc(
+          index->memory, PARKING_MEMORY_INDEX, posting->entries,
+          capacity * sizeof(TrigramEntry));
+
+      if (entries == NULL) {
+        posting = NULL;
+      } else {
+        posting->entries = entries;
+        posting->capacity = capacity;
+      }
+    }
+    if (posting == NULL) {
+      index->degraded = 1;
+      return -3;
+    }
+
+    posting->entries[posting->count].handle = handle;
+    posting->entries[posting->count].stamp = slot->search_stamp;
+    posting->count++;
+    slot->search_entries++;
+    index->live_entries++;
+  }
+  return 0;
+}
+
+/**
+ * @brief 使车位的全部登记失效。
+ * @param index 目标索引。
+ * @param slot 车位节点。
+ */
+void trigram_index_retire(TrigramIndex *index, struct ParkingSlot *slot) {
+  if (index == NULL || slot == NULL) {
+    return;
+  }
+  index->live_entries -= (size_t)slot->search_entries;
+  index->stale_entries += (size_t)slot->search_entries;
+  slot->search_entries = 0;
+  slot->search_stamp++;
+}
+
+/**
+ * @brief 取出子串查询的候选倒排表。
+ * @param index 目标索引。
+ * @param field 字段下标。
+ * @param query 查询串。
+ * @param[out] entries 接收候选项数组。
+ * @param[out] count 接收候选项个数。
+ * @return 成功返回 0；查询串不足三个字节或参数无效返回 -1。
+ */
+int trigram_index_candidates(const TrigramIndex *index, int field,
+                             const char *query, const TrigramEntry **entries,
+                             size_t *count) {
+  const TrigramPosting *best = NULL;
+  size_t length;
+  size_t i;
+
+  if (index == NULL || query == NULL || entries == NULL || count == NULL ||
+      field < 0 || field >= TRIGRAM_FIELD_COUNT) {
+    return -1;
+  }
+  length = strlen(query);
+  if (length < 3) {
+    return -1;
+  }
+
+  *entries = NULL;
+  *count = 0;
+  for (i = 0; i + 3 <= length; i++) {
+    const TrigramPosting *posting =
+        trigram_posting_find(index, trigram_key(field, query + i));
+
+    if (posting == NULL || posting->count == 0) {
+      return 0; /* 有一个三元组从未出现，不可能匹配 */
+    }
+    if (best == NULL || posting->count < best->count) {
+      best = posting;
+    }
+  }
+  *entries = best->entries;
+  *count = best->count;
+  return 0;
+}
+
+/* ========================================================================== */
+/*                                车位句柄表实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 将句柄表初始化为空状态（不分配内存）。
+ * @param table 要初始化的句柄表。
+ * @param memory 之后分配项数组使用的内存对象，NULL 表示 C 堆。
+ * @param first_generation 新项的初始代号，为 0 时按 1 处理。
+ */
+void slot_handle_table_init(SlotHandleTable *table, ParkingMemory *memory,
+                            unsigned int first_generation) {
+  if (table == NULL) {
+    return;
+  }
+  table->entries = NULL;
+  table->count = 0;
+  table->capacity = 0;
+  table->free_head = SLOT_HANDLE_NO_ENTRY;
+  table->first_generation = first_generation != 0 ? first_generation : 1;
+  table->memory = memory;
+}
+
+/**
+ * @brief 释放句柄表的项数组。
+ * @param table 目标句柄表。
+ */
+void slot_handle_table_free(SlotHandleTable *table) {
+  if (table == NULL) {
+    return;
+  }
+  parking_memory_free(table->memory, table->entries);
+  slot_handle_table_init(table, table->memory, table->first_generation);
+}
+
+/**
+ * @brief 预留至少能同时容纳 count 个车位的项。
+ * @details 空闲项可以复用，因此只要容量不小于 count 加 1 就足够：
+ *          同时使用的项不超过 count 个时，要么有空闲项，要么 count 个项
+ *          全部在用而数组还剩一项。
+ * @param table 目标句柄表。
+ * @param count 车位数。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int slot_handle_table_reserve(SlotHandleTable *table, size_t count) {
+  SlotHandleEntry *entries;
+  size_t capacity;
+
+  if (table == NULL || count >= SLOT_HANDLE_NO_ENTRY) {
+    return -1;
+  }
+  if (count < table->capacity) {
+    return 0;
+  }
+  capacity = table->capacity > 0 ? table->capacity : SLOT_HANDLE_MIN_CAPACITY;
+  while (capacity <= count) {
+    capacity *= 2;
+  }
+  entries = (SlotHandleEntry *)parking_memory_realloc(
+      table->memory, PARKING_MEMORY_INDEX, table->entries,
+      capacity * sizeof(SlotHandleEntry));
+  if (entries == NULL) {
+    return -3;
+  }
+  table->entries = entries;
+  table->capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief 为车位分配一项，优先复用空闲项。
+ * @param table 目标句柄表。
+ * @param slot 车位节点。
+ * @param[out] index 接收该项的下标。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int slot_handle_table_acquire(SlotHandleTable *table, struct ParkingSlot *slot,
+                              unsigned int *index) {
+  SlotHandleEntry *entry;
+
+  if (table == NULL || slot == NULL || index == NULL) {
+    return -1;
+  }
+  if (table->free_head != SLOT_HANDLE_NO_ENTRY) {
+    *index = table->free_head;
+    entry = &table->entries[*index];
+    table->free_head = entry->next_free;
+  } else {
+    if (table->count == table->capacity &&
+        slot_handle_table_reserve(table, table->count) != 0) {
+      return -3;
+    }
+    *index = (unsigned int)table->count++;
+    entry = &table->entries[*index];
+    entry->generation = table->first_generation;
+  }
+  entry->slot = slot;
+  entry->next_free = SLOT_HANDLE_NO_ENTRY;
+  return 0;
+}
+
+/**
+ * @brief 归还车位占用的项，该项的代号递增。
+ * @param table 目标句柄表。
+ * @param index slot_handle_table_acquire 给出的下标。
+ */
+void slot_handle_table_release(SlotHandleTable *table, unsigned int index) {
+  SlotHandleEntry *entry;
+
+  if (table == NULL || index >= table->count) {
+    return;
+  }
+  entry = &table->entries[index];
+  if (entry->slot == NULL) {
+    return;
+  }
+  entry->slot = NULL;
+  /* 代号回绕时跳过 0，全零的句柄永远无效 */
+  entry->generation = (entry->generation + 1U) & 0xFFFFFFFFU;
+  if (entry->generation == 0) {
+    entry->generation = 1;
+  }
+  entry->next_free = table->free_head;
+  table->free_head = index;
+}
+
+/**
+ * @brief 车位节点换到别处存放后，改写该项指向的节点。
+ * @param table 目标句柄表。
+ * @param index 正在使用的项的下标。
+ * @param slot 新的车位节点。
+ */
+void slot_handle_table_relocate(SlotHandleTable *table, unsigned int index,
+                                struct ParkingSlot *slot) {
+  if (table == NULL || slot == NULL || index >= table->count ||
+      table->entries[index].slot == NULL) {
+    return;
+  }
+  table->entries[index].slot = slot;
+}
+
+/**
+ * @brief 取某一项当前的句柄。
+ * @param table 目标句柄表。
+ * @param index 正在使用的项的下标。
+ * @return 该项的句柄；下标无效时返回全零句柄。
+ */
+SlotHandle slot_handle_table_get(const SlotHandleTable *table,
+                                 unsigned int index) {
+  SlotHandle handle;
+
+  handle.index = 0;
+  handle.generation = 0;
+  if (table != NULL && index < table->count &&
+      table->entries[index].slot != NULL) {
+    handle.index = index;
+    handle.generation = table->entries[index].generation;
+  }
+  return handle;
+}
+
+/**
+ * @brief 解析句柄。
+ * @param table 目标句柄表。
+ * @param handle 要解析的句柄。
+ * @return 句柄仍然有效时返回车位节点，否则返回 NULL。
+ */
+struct ParkingSlot *slot_handle_table_resolve(const SlotHandleTable *table,
+                                              SlotHandle handle) {
+  const SlotHandleEntry *entry;
+
+  if (table == NULL || handle.index >= table->count) {
+    return NULL;
+  }
+  entry = &table->entries[handle.index];
+  if (entry->generation != handle.generation) {
+    return NULL;
+  }
+  return entry->slot;
+}
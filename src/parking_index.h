@@ -0,0 +1,728 @@
+#ifndef PARKING_INDEX_H
+#define PARKING_INDEX_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "parking_memory.h"
+#include "parking_plate.h"
+
+/**
+ * @file parking_index.h
+ * @brief 数据层内部使用的哈希索引结构声明。
+ * @details
+ * 该头文件定义了停车场对象所持有的各类开放寻址哈希索引，
+ * 用于将按车位编号、车牌号等键的查找从链表遍历降为常数时间；
+ * 以及按入场时间排列的在场车位链表，用于停车时长排行；
+ * 以及按月费到期时间排列的居民车位最小堆；
+ * 以及按日期、月份累计的入场计数；
+ * 以及按车牌号、车主姓名子串检索的三元组（trigram）倒排索引；
+ * 以及把带代号的车位句柄解析为车位节点的句柄表。
+ * 索引只保存指向车位节点的指针，不拥有车位内存。
+ *
+ * 编号索引与车牌索引还可以写成与地址无关的“映像”：桶布局原样保存，
+ * 桶中的节点指针换成车位在车位表中的行号，加载时按行号换回节点指针，
+ * 不必逐个重新散列。
+ */
+
+struct ParkingSlot;
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 车位编号索引中的单个桶。
+ */
+typedef struct SlotIdIndexEntry {
+  int slot_id;               /**< 桶中记录的车位编号。 */
+  struct ParkingSlot *slot;  /**< 对应的车位节点，为 NULL 表示空桶。 */
+} SlotIdIndexEntry;
+
+/**
+ * @brief 以车位编号为键的开放寻址（线性探测）哈希索引。
+ * @details 桶数组容量始终为 2 的幂，负载因子超过 0.7 时扩容一倍。
+ *          删除采用后移回填，不留墓碑，因此查找长度不会随删除退化。
+ *
+ *          扩容是渐进的：分配新桶数组后，旧桶数组暂时保留，之后每次登记
+ *          或删除顺带把 SLOT_INDEX_MIGRATE_STEP 个旧桶搬到新桶数组，
+ *          任何一次操作都不必一次性重新散列全部条目。迁移期间查找先查
+ *          新桶数组，未命中再查旧桶数组；旧桶中已搬走或已删除的条目
+ *          留作墓碑，保证旧桶数组的探测链不断开。新容量是旧容量的两倍，
+ *          迁移总能在负载再次达到上限之前完成。
+ */
+typedef struct SlotIdIndex {
+  SlotIdIndexEntry *entries; /**< 桶数组，未分配时为 NULL。 */
+  size_t capacity;           /**< 桶数组容量（2 的幂，0 表示未分配）。 */
+  size_t count;              /**< 当前已登记的车位数量（含尚未迁移的）。 */
+  SlotIdIndexEntry *old_entries; /**< 迁移中的旧桶数组，NULL 表示没有迁移。 */
+  size_t old_capacity;           /**< 旧桶数组的容量。 */
+  size_t migrate_pos;            /**< 下一个待迁移的旧桶下标。 */
+  ParkingMemory *memory;     /**< 桶数组的分配来源，NULL 表示 C 堆。 */
+} SlotIdIndex;
+
+/**
+ * @brief 车牌号索引中的单个桶。
+ * @details 车牌字符串本身存放在车位节点内，桶中缓存其整数编码：
+ *          标准车牌只比较两个字即可判定相等，不访问车位节点；
+ *          非标准车牌的编码是字符串哈希，编码相同时再回退到 strcmp。
+ */
+typedef struct PlateIndexEntry {
+  PlateCode code;            /**< 车牌号的整数编码（见 parking_plate.h）。 */
+  struct ParkingSlot *slot;  /**< 停放该车牌的车位节点，为 NULL 表示空桶。 */
+} PlateIndexEntry;
+
+/**
+ * @brief 以车牌号为键的开放寻址哈希索引。
+ * @details 只登记处于占用状态的车位，由车辆入场/出场同步维护。
+ *          容量、渐进扩容与删除策略与 SlotIdIndex 相同。
+ */
+typedef struct PlateIndex {
+  PlateIndexEntry *entries; /**< 桶数组，未分配时为 NULL。 */
+  size_t capacity;          /**< 桶数组容量（2 的幂，0 表示未分配）。 */
+  size_t count;             /**< 当前已登记的车牌数量（含尚未迁移的）。 */
+  PlateIndexEntry *old_entries; /**< 迁移中的旧桶数组，NULL 表示没有迁移。 */
+  size_t old_capacity;          /**< 旧桶数组的容量。 */
+  size_t migrate_pos;           /**< 下一个待迁移的旧桶下标。 */
+  ParkingMemory *memory;    /**< 桶数组的分配来源，NULL 表示 C 堆。 */
+} PlateIndex;
+
+/**
+ * @brief 按入场时间排列的在场车位链表。
+ * @details 侵入式双向链表，链接字段位于车位节点内（entry_prev/entry_next），
+ *          从最早入场排到最近入场。停车时长顺序即入场时间的逆序，
+ *          因此“停得最久”和“最近入场”的前 k 辆车都可以直接从两端取出。
+ *          车辆通常按时间先后入场，插入时从表尾向前寻找位置，
+ *          一般为 O(1)；删除为 O(1)。
+ */
+typedef struct EntryOrderList {
+  struct ParkingSlot *oldest; /**< 入场最早的车位，链表为空时为 NULL。 */
+  struct ParkingSlot *newest; /**< 入场最晚的车位，链表为空时为 NULL。 */
+  size_t count;               /**< 链表中的车位数量。 */
+} EntryOrderList;
+
+/**
+ * @brief 月费到期堆中的单项。
+ * @details 到期时间在堆中另存一份，比较时不必访问车位节点。
+ */
+typedef struct DueHeapEntry {
+  time_t due;               /**< 月费到期时间，即排序键。 */
+  struct ParkingSlot *slot; /**< 对应的居民车位。 */
+} DueHeapEntry;
+
+/**
+ * @brief 以月费到期时间为键的二叉最小堆。
+ * @details 只登记设置了到期时间的居民车位，车位节点的 due_heap_index
+ *          记录其在堆中的下标，因此修改与删除都是 O(log n)。
+ *          按时间顺序取出到期时间在某个上界之前的车位时，
+ *          根已不早于上界的子树整棵跳过，不必扫描全部车位。
+ */
+typedef struct DueDateHeap {
+  DueHeapEntry *entries; /**< 堆数组，未分配时为 NULL。 */
+  size_t count;          /**< 堆中的车位数量。 */
+  size_t capacity;       /**< 堆数组已分配的容量。 */
+  ParkingMemory *memory; /**< 堆数组的分配来源，NULL 表示 C 堆。 */
+} DueDateHeap;
+
+#define CALENDAR_COUNT_CATEGORIES 2 /**< 每个日历键下的计数类别数（居民/访客）。 */
+
+/**
+ * @brief 日历计数索引中的单个桶。
+ */
+typedef struct CalendarCountEntry {
+  long key; /**< 日历键（如 YYYYMMDD 或 YYYYMM），为 0 表示空桶。 */
+  int counts[CALENDAR_COUNT_CATEGORIES]; /**< 各类别的计数。 */
+} CalendarCountEntry;
+
+/**
+ * @brief 以日历键为键的开放寻址计数表。
+ * @details 用于按日、按月累计入场次数。桶只增不删，
+ *          容量与扩容策略与 SlotIdIndex 相同。
+ */
+typedef struct CalendarCountIndex {
+  CalendarCountEntry *entries; /**< 桶数组，未分配时为 NULL。 */
+  size_t capacity;             /**< 桶数组容量（2 的幂，0 表示未分配）。 */
+  size_t count;                /**< 已登记的日历键数量。 */
+  ParkingMemory *memory;       /**< 桶数组的分配来源，NULL 表示 C 堆。 */
+} CalendarCountIndex;
+
+/**
+ * @brief 指向车位的带代号句柄。
+ * @details index 是句柄表中的下标，generation 是发放句柄时该项的代号。
+ *          车位被删除后该项的代号递增，旧句柄随即失效；下标之后可能分给
+ *          新加入的车位，但代号已经不同。代号从不为 0，
+ *          全零的句柄不指向任何车位。
+ */
+typedef struct SlotHandle {
+  unsigned int index;      /**< 句柄表中的下标。 */
+  unsigned int generation; /**< 发放句柄时该项的代号。 */
+} SlotHandle;
+
+#define TRIGRAM_FIELD_COUNT 2 /**< 三元组索引覆盖的字段数（车牌/车主）。 */
+
+/**
+ * @brief 三元组倒排表中的一项。
+ * @details 车位每次登记都会换用新的登记戳，戳与车位当前的 search_stamp
+ *          不一致的项已经失效，查询时跳过，重建索引时清除。
+ *          项中保存车位句柄而不是节点指针：车位删除后句柄失效，
+ *          失效项不会指向已释放的节点；节点被整理迁移时倒排表也不必改写。
+ */
+typedef struct TrigramEntry {
+  SlotHandle handle;  /**< 登记时车位的句柄。 */
+  unsigned int stamp; /**< 登记时车位的 search_stamp。 */
+} TrigramEntry;
+
+/**
+ * @brief 一个三元组的倒排表。
+ */
+typedef struct TrigramPosting {
+  unsigned long key;     /**< 字段与三个字节组成的键，为 0 表示空桶。 */
+  TrigramEntry *entries; /**< 包含该三元组的车位。 */
+  size_t count;          /**< 倒排表中的项数（含已失效的项）。 */
+  size_t capacity;       /**< 倒排表已分配的容量。 */
+} TrigramPosting;
+
+/**
+ * @brief 以字节三元组为键、按字段区分的开放寻址倒排索引。
+ * @details 文本中每个不同的连续三字节都登记一项，按字节切分，
+ *          对 UTF-8 的中文车牌与姓名同样适用。子串查询取查询串中最短的
+ *          倒排表作为候选，再逐个核对。注销只使登记失效（延迟删除），
+ *          失效项过多时由数据层整体重建。桶只增不删，
+ *          容量与扩容策略与 SlotIdIndex 相同。
+ */
+typedef struct TrigramIndex {
+  TrigramPosting *postings; /**< 桶数组，未分配时为 NULL。 */
+  size_t capacity;          /**< 桶数组容量（2 的幂，0 表示未分配）。 */
+  size_t count;             /**< 已登记的三元组数量。 */
+  size_t live_entries;      /**< 仍然有效的倒排项总数。 */
+  size_t stale_entries;     /**< 已失效、尚未清除的倒排项总数。 */
+  int degraded; /**< 登记时内存不足后置 1，此时索引不完整，查询须全表扫描。 */
+  ParkingMemory *memory; /**< 桶数组与倒排表的分配来源，NULL 表示 C 堆。 */
+} TrigramIndex;
+
+#define SLOT_ID_IMAGE_BUCKET 4 /**< 编号索引映像每个桶的字节数（行号） */
+#define PLATE_IMAGE_BUCKET 12  /**< 车牌索引映像每个桶的字节数（行号与编码） */
+
+#define SLOT_HANDLE_NO_ENTRY 0xFFFFFFFFU /**< 句柄表空闲链表的结束标记。 */
+
+/**
+ * @brief 句柄表中的一项。
+ */
+typedef struct SlotHandleEntry {
+  struct ParkingSlot *slot; /**< 该项指向的车位，空闲项为 NULL。 */
+  unsigned int generation;  /**< 该项当前的代号。 */
+  unsigned int next_free;   /**< 空闲链表中的下一项。 */
+} SlotHandleEntry;
+
+/**
+ * @brief 把车位句柄解析为车位节点的句柄表。
+ * @details 每个加入停车场的车位占一项。删除车位时该项的代号递增并进入
+ *          空闲链表，供之后加入的车位复用；解析句柄只需一次数组访问与
+ *          一次代号比较。车位节点换到别处存放时只需改写该项的指针，
+ *          调用者手中的句柄保持有效。各停车场的新项从不同的代号开始，
+ *          旧停车场的句柄在替换后的停车场上几乎不可能碰巧有效。
+ */
+typedef struct SlotHandleTable {
+  SlotHandleEntry *entries; /**< 项数组，未分配时为 NULL。 */
+  size_t count;             /**< 用过的项数（含空闲项）。 */
+  size_t capacity;          /**< 项数组容量。 */
+  unsigned int free_head;   /**< 空闲链表头，SLOT_HANDLE_NO_ENTRY 表示空。 */
+  unsigned int first_generation; /**< 新项的初始代号（不为 0）。 */
+  ParkingMemory *memory; /**< 项数组的分配来源，NULL 表示 C 堆。 */
+} SlotHandleTable;
+
+/**
+ *********************************************************************************
+ *                            索引操作API声明
+ *********************************************************************************
+ */
+
+/** @name 车位编号索引 */
+/** @{ */
+
+/**
+ * @brief 将索引初始化为空状态（不分配内存）。
+ * @param index 要初始化的索引。
+ * @param memory 之后分配桶数组使用的内存对象，NULL 表示 C 堆。
+ */
+void slot_id_index_init(SlotIdIndex *index, ParkingMemory *memory);
+
+/**
+ * @brief 释放索引占用的桶数组，并将其恢复为空状态。
+ * @param index 要释放的索引。
+ */
+void slot_id_index_free(SlotIdIndex *index);
+
+/**
+ * @brief 按车位编号查找车位节点。
+ * @param index 目标索引。
+ * @param slot_id 要查找的车位编号。
+ * @return 找到时返回车位节点指针，否则返回 NULL。
+ */
+struct ParkingSlot *slot_id_index_find(const SlotIdIndex *index, int slot_id);
+
+/**
+ * @brief 向索引登记一个车位节点。
+ * @param index 目标索引。
+ * @param slot_id 车位编号。
+ * @param slot 车位节点指针，不能为 NULL。
+ * @return 成功返回 0，参数无效返回 -1，编号已存在返回 -2，内存不足返回 -3。
+ */
+int slot_id_index_insert(SlotIdIndex *index, int slot_id,
+                         struct ParkingSlot *slot);
+
+/**
+ * @brief 预先扩容，使索引登记 count 个车位的过程中不再重新散列。
+ * @details 用于建立停车场与批量加载；容量只增不减。与插入触发的渐进
+ *          扩容不同，本函数一次完成（包括结束进行中的迁移）。
+ * @param index 目标索引。
+ * @param count 预期的车位总数。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int slot_id_index_reserve(SlotIdIndex *index, size_t count);
+
+/**
+ * @brief 从索引中移除一个车位编号。
+ * @param index 目标索引。
+ * @param slot_id 要移除的车位编号。
+ * @return 成功移除返回 0，编号不存在返回 -1。
+ */
+int slot_id_index_remove(SlotIdIndex *index, int slot_id);
+
+/**
+ * @brief 车位节点换到别处存放后，改写索引中该编号对应的节点。
+ * @param index 目标索引。
+ * @param slot_id 车位编号。
+ * @param slot 新的车位节点。
+ * @return 成功返回 0，编号不存在返回 -1。
+ */
+int slot_id_index_relocate(SlotIdIndex *index, int slot_id,
+                           struct ParkingSlot *slot);
+
+/** @} */
+
+/** @name 车牌号索引 */
+/** @{ */
+
+/**
+ * @brief 将车牌号索引初始化为空状态（不分配内存）。
+ * @param index 要初始化的索引。
+ * @param memory 之后分配桶数组使用的内存对象，NULL 表示 C 堆。
+ */
+void plate_index_init(PlateIndex *index, ParkingMemory *memory);
+
+/**
+ * @brief 释放车牌号索引占用的桶数组，并将其恢复为空状态。
+ * @param index 要释放的索引。
+ */
+void plate_index_free(PlateIndex *index);
+
+/**
+ * @brief 按车牌号查找车位节点。
+ * @param index 目标索引。
+ * @param license_plate 要查找的车牌号。
+ * @return 找到时返回车位节点指针，否则返回 NULL。
+ */
+struct ParkingSlot *plate_index_find(const PlateIndex *index,
+                                     const char *license_plate);
+
+/**
+ * @brief 预先扩容，使索引登记 count 个车牌的过程中不再重新散列。
+ * @details 用于建立停车场与批量加载；容量只增不减，一次完成。
+ * @param index 目标索引。
+ * @param count 预期的车牌总数。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int plate_index_reserve(PlateIndex *index, size_t count);
+
+/**
+ * @brief 以车位节点当前的 license_plate 为键登记车位。
+ * @param index 目标索引。
+ * @param slot 已填写车牌号的车位节点。
+ * @return 成功返回 0，参数无效返回 -1，车牌已存在返回 -2，内存不足返回 -3。
+ */
+int plate_index_insert(PlateIndex *index, struct ParkingSlot *slot);
+
+/**
+ * @brief 从车牌号索引中注销一个车位节点。
+ * @details 必须在清空车位的 license_plate 之前调用。
+ * @param index 目标索引。
+ * @param slot 要注销的车位节点。
+ * @return 成功移除返回 0，未登记返回 -1。
+ */
+int plate_index_remove(PlateIndex *index, struct ParkingSlot *slot);
+
+/**
+ * @brief 车位节点换到别处存放后，改写索引中指向旧节点的桶。
+ * @param index 目标索引。
+ * @param from 旧的车位节点，其车牌号仍然有效。
+ * @param to 新的车位节点。
+ * @return 成功返回 0，旧节点未登记返回 -1。
+ */
+int plate_index_relocate(PlateIndex *index, const struct ParkingSlot *from,
+                         struct ParkingSlot *to);
+
+/** @} */
+
+/** @name 索引映像 */
+/** @{ */
+
+/**
+ * @brief 取登记 count 个条目的索引映像使用的桶数。
+ * @details 与对空索引 reserve 同样多的条目得到的容量相同。
+ * @param count 条目数。
+ * @return 桶数（2 的幂）。
+ */
+size_t index_image_capacity(size_t count);
+
+/**
+ * @brief 把一组车位的编号索引桶布局写成映像。
+ * @details 每个桶 SLOT_ID_IMAGE_BUCKET 字节，是车位在 rows 中的下标加 1
+ *          （小端序），0 表示空桶。编号须互不相同。
+ * @param rows 车位节点数组，下标即之后加载时的行号。
+ * @param count 车位数。
+ * @param capacity 桶数，取 index_image_capacity(count)。
+ * @param[out] image 接收映像，至少 capacity * SLOT_ID_IMAGE_BUCKET 字节。
+ */
+void slot_id_index_write_image(struct ParkingSlot *const *rows, size_t count,
+                               size_t capacity, unsigned char *image);
+
+/**
+ * @brief 由映像直接建立编号索引，不重新散列。
+ * @details 先完整核对映像（容量、负载与行号范围），不通过时索引保持不变。
+ * @param index 目标索引，须为空。
+ * @param image slot_id_index_write_image 写出的映像。
+ * @param capacity 映像的桶数。
+ * @param rows 与写出时行号一一对应的车位节点。
+ * @param count 车位数，映像中须恰好登记 count 个车位。
+ * @return 成功返回 0，参数或映像无效返回 -1，内存不足返回 -3。
+ */
+int slot_id_index_read_image(SlotIdIndex *index, const unsigned char *image,
+                             size_t capacity, struct ParkingSlot *const *rows,
+                             size_t count);
+
+/**
+ * @brief 把一组车位中在场车辆的车牌索引桶布局写成映像。
+ * @details 每个桶 PLATE_IMAGE_BUCKET 字节，依次是行号加 1 与车牌编码的
+ *          high、low（小端序），行号为 0 表示空桶。与逐个 plate_index_insert
+ *          相同，车牌重复时只登记行号最小的一个。
+ * @param rows 车位节点数组，下标即之后加载时的行号。
+ * @param count 车位数。
+ * @param capacity 桶数，取 index_image_capacity(在场车位数)。
+ * @param[out] image 接收映像，至少 capacity * PLATE_IMAGE_BUCKET 字节。
+ * @return 映像中登记的车牌数。
+ */
+size_t plate_index_write_image(struct ParkingSlot *const *rows, size_t count,
+                               size_t capacity, unsigned char *image);
+
+/**
+ * @brief 由映像直接建立车牌索引，不重新编码车牌、不重新散列。
+ * @details 先完整核对映像，不通过时索引保持不变。
+ * @param index 目标索引，须为空。
+ * @param image plate_index_write_image 写出的映像。
+ * @param capacity 映像的桶数。
+ * @param rows 与写出时行号一一对应的车位节点。
+ * @param row_count 车位数。
+ * @param count 映像中应登记的车牌数。
+ * @return 成功返回 0，参数或映像无效返回 -1，内存不足返回 -3。
+ */
+int plate_index_read_image(PlateIndex *index, const unsigned char *image,
+                           size_t capacity, struct ParkingSlot *const *rows,
+                           size_t row_count, size_t count);
+
+/** @} */
+
+/** @name 入场时间链表 */
+/** @{ */
+
+/**
+ * @brief 将入场时间链表初始化为空状态。
+ * @param list 要初始化的链表。
+ */
+void entry_order_init(EntryOrderList *list);
+
+/**
+ * @brief 按车位节点当前的 entry_time 将其插入链表。
+ * @details 入场时间相同的车位按插入先后排列。
+ * @param list 目标链表。
+ * @param slot 不在链表中的车位节点。
+ */
+void entry_order_insert(EntryOrderList *list, struct ParkingSlot *slot);
+
+/**
+ * @brief 把一批已按入场时间排好序的车位节点依次接到表尾。
+ * @details 用于批量加载，避免逐个插入时从表尾向前的查找；不检查顺序。
+ * @param list 目标链表。
+ * @param slots 车位节点数组，入场时间不减且不早于当前表尾。
+ * @param count 节点数。
+ */
+void entry_order_append_sorted(EntryOrderList *list,
+                               struct ParkingSlot *const *slots,
+                               size_t count);
+
+/**
+ * @brief 从链表中摘除一个车位节点。
+ * @param list 目标链表。
+ * @param slot 已在链表中的车位节点。
+ */
+void entry_order_remove(EntryOrderList *list, struct ParkingSlot *slot);
+
+/**
+ * @brief 车位节点换到别处存放后，让前后节点与表头表尾改为指向新节点。
+ * @details 旧节点不在链表中时不做任何事。
+ * @param list 目标链表。
+ * @param from 旧的车位节点，链接字段仍然有效。
+ * @param to 新的车位节点，链接字段已从旧节点复制。
+ */
+void entry_order_relocate(EntryOrderList *list,
+                          const struct ParkingSlot *from,
+                          struct ParkingSlot *to);
+
+/** @} */
+
+/** @name 月费到期堆 */
+/** @{ */
+
+/**
+ * @brief 将月费到期堆初始化为空状态（不分配内存）。
+ * @param heap 要初始化的堆。
+ * @param memory 之后分配堆数组使用的内存对象，NULL 表示 C 堆。
+ */
+void due_heap_init(DueDateHeap *heap, ParkingMemory *memory);
+
+/**
+ * @brief 释放月费到期堆占用的堆数组，并将其恢复为空状态。
+ * @details 不修改车位节点的 due_heap_index，只在停车场销毁时调用。
+ * @param heap 要释放的堆。
+ */
+void due_heap_free(DueDateHeap *heap);
+
+/**
+ * @brief 预留至少 capacity 项的堆数组。
+ * @details 数据层按稠密车位表的容量预留，之后的登记不会因内存不足失败。
+ * @param heap 目标堆。
+ * @param capacity 需要的容量。
+ * @return 成功返回 0，内存不足返回 -3（此时原堆保持不变）。
+ */
+int due_heap_reserve(DueDateHeap *heap, size_t capacity);
+
+/**
+ * @brief 登记、修改或注销一个车位的到期时间。
+ * @param heap 目标堆。
+ * @param slot 车位节点。
+ * @param due 新的到期时间；小于等于 0 时把车位移出堆。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int due_heap_update(DueDateHeap *heap, struct ParkingSlot *slot, time_t due);
+
+/**
+ * @brief 把车位移出堆；车位不在堆中时不做任何事。
+ * @param heap 目标堆。
+ * @param slot 车位节点。
+ */
+void due_heap_remove(DueDateHeap *heap, struct ParkingSlot *slot);
+
+/**
+ * @brief 车位节点换到别处存放后，改写堆中对应项的节点。
+ * @param heap 目标堆。
+ * @param slot 新的车位节点，due_heap_index 已从旧节点复制；
+ *        不在堆中时不做任何事。
+ */
+void due_heap_relocate(DueDateHeap *heap, struct ParkingSlot *slot);
+
+/**
+ * @brief 按到期时间从早到晚取出到期时间落在 [from, to) 内的车位。
+ * @details 以一个候选下标小堆做最佳优先遍历：每取出一项再把它的子节点
+ *          放入候选，到期时间不早于 to 的子树不再展开。
+ *          耗时 O((k + m) log(k + m))，k 为取出的车位数，
+ *          m 为遍历途中经过的、到期时间早于 from 的车位数。
+ * @param heap 目标堆。
+ * @param from 到期时间下界（含）。
+ * @param to 到期时间上界（不含），小于等于 0 表示不设上界。
+ * @param[out] slots 接收车位的数组。
+ * @param limit 最多取出的车位数。
+ * @return 写入的车位数；参数无效返回 -1，候选数组内存不足返回 -3。
+ */
+int due_heap_collect(const DueDateHeap *heap, time_t from, time_t to,
+                     struct ParkingSlot **slots, int limit);
+
+/** @} */
+
+/** @name 日历计数索引 */
+/** @{ */
+
+/**
+ * @brief 将日历计数索引初始化为空状态（不分配内存）。
+ * @param index 要初始化的索引。
+ * @param memory 之后分配桶数组使用的内存对象，NULL 表示 C 堆。
+ */
+void calendar_count_init(CalendarCountIndex *index, ParkingMemory *memory);
+
+/**
+ * @brief 释放日历计数索引占用的桶数组，并将其恢复为空状态。
+ * @param index 要释放的索引。
+ */
+void calendar_count_free(CalendarCountIndex *index);
+
+/**
+ * @brief 调整某个日历键下某一类别的计数。
+ * @param index 目标索引。
+ * @param key 日历键（正数）。
+ * @param category 类别下标。
+ * @param delta 调整量，计数最低减到 0。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int calendar_count_add(CalendarCountIndex *index, long key, int category,
+                       int delta);
+
+/**
+ * @brief 读取某个日历键下某一类别的计数。
+ * @param index 目标索引。
+ * @param key 日历键。
+ * @param category 类别下标。
+ * @return 计数值；键不存在时返回 0。
+ */
+int calendar_count_get(const CalendarCountIndex *index, long key,
+                       int category);
+
+/** @} */
+
+/** @name 三元组索引 */
+/** @{ */
+
+/**
+ * @brief 将三元组索引初始化为空状态（不分配内存）。
+ * @param index 要初始化的索引。
+ * @param memory 之后分配桶数组使用的内存对象，NULL 表示 C 堆。
+ */
+void trigram_index_init(TrigramIndex *index, ParkingMemory *memory);
+
+/**
+ * @brief 释放三元组索引占用的全部内存，并将其恢复为空状态。
+ * @param index 要释放的索引。
+ */
+void trigram_index_free(TrigramIndex *index);
+
+/**
+ * @brief 清空所有倒排表，保留已分配的内存供重建使用。
+ * @param index 目标索引。
+ */
+void trigram_index_clear(TrigramIndex *index);
+
+/**
+ * @brief 以车位当前的 search_stamp 登记一段文本中的全部三元组。
+ * @details 同一文本中重复出现的三元组只登记一次，并计入车位的 search_entries。
+ *          内存不足时置位 degraded。
+ * @param index 目标索引。
+ * @param slot 车位节点。
+ * @param handle 车位的句柄，随登记戳一起保存在倒排项中。
+ * @param field 字段下标（0 到 TRIGRAM_FIELD_COUNT - 1）。
+ * @param text 要登记的文本，不足三个字节时不登记任何项。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int trigram_index_insert(TrigramIndex *index, struct ParkingSlot *slot,
+                         SlotHandle handle, int field, const char *text);
+
+/**
+ * @brief 使车位的全部登记失效。
+ * @details 递增车位的 search_stamp 并把其 search_entries 计为失效项，耗时 O(1)。
+ * @param index 目标索引。
+ * @param slot 车位节点。
+ */
+void trigram_index_retire(TrigramIndex *index, struct ParkingSlot *slot);
+
+/**
+ * @brief 取出子串查询的候选倒排表。
+ * @details 返回查询串各三元组中最短的倒排表；某个三元组从未出现时
+ *          候选为空，说明没有任何匹配。候选中可能含有失效项或不匹配的车位，
+ *          调用者须核对登记戳与字段内容。
+ * @param index 目标索引。
+ * @param field 字段下标。
+ * @param query 查询串。
+ * @param[out] entries 接收候选项数组。
+ * @param[out] count 接收候选项个数。
+ * @return 成功返回 0；查询串不足三个字节或参数无效返回 -1，此时须全表扫描。
+ */
+int trigram_index_candidates(const TrigramIndex *index, int field,
+                             const char *query, const TrigramEntry **entries,
+                             size_t *count);
+
+/** @} */
+
+/** @name 车位句柄表 */
+/** @{ */
+
+/**
+ * @brief 将句柄表初始化为空状态（不分配内存）。
+ * @param table 要初始化的句柄表。
+ * @param memory 之后分配项数组使用的内存对象，NULL 表示 C 堆。
+ * @param first_generation 新项的初始代号，为 0 时按 1 处理。
+ */
+void slot_handle_table_init(SlotHandleTable *table, ParkingMemory *memory,
+                            unsigned int first_generation);
+
+/**
+ * @brief 释放句柄表的项数组，之前发放的句柄全部失效。
+ * @param table 目标句柄表。
+ */
+void slot_handle_table_free(SlotHandleTable *table);
+
+/**
+ * @brief 预留至少能同时容纳 count 个车位的项。
+ * @details 预留之后，车位数不超过 count 时
+ *          slot_handle_table_acquire 不会失败。
+ * @param table 目标句柄表。
+ * @param count 车位数。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int slot_handle_table_reserve(SlotHandleTable *table, size_t count);
+
+/**
+ * @brief 为车位分配一项，优先复用空闲项。
+ * @param table 目标句柄表。
+ * @param slot 车位节点。
+ * @param[out] index 接收该项的下标。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int slot_handle_table_acquire(SlotHandleTable *table, struct ParkingSlot *slot,
+                              unsigned int *index);
+
+/**
+ * @brief 归还车位占用的项，该项的代号递增，已发放的句柄随即失效。
+ * @param table 目标句柄表。
+ * @param index slot_handle_table_acquire 给出的下标。
+ */
+void slot_handle_table_release(SlotHandleTable *table, unsigned int index);
+
+/**
+ * @brief 车位节点换到别处存放后，改写该项指向的节点；代号不变。
+ * @param table 目标句柄表。
+ * @param index 正在使用的项的下标。
+ * @param slot 新的车位节点。
+ */
+void slot_handle_table_relocate(SlotHandleTable *table, unsigned int index,
+                                struct ParkingSlot *slot);
+
+/**
+ * @brief 取某一项当前的句柄。
+ * @param table 目标句柄表。
+ * @param index 正在使用的项的下标。
+ * @return 该项的句柄；下标无效时返回全零句柄。
+ */
+SlotHandle slot_handle_table_get(const SlotHandleTable *table,
+                                 unsigned int index);
+
+/**
+ * @brief 解析句柄。
+ * @param table 目标句柄表。
+ * @param handle 要解析的句柄。
+ * @return 句柄仍然有效时返回车位节点，否则返回 NULL。
+ */
+struct ParkingSlot *slot_handle_table_resolve(const SlotHandleTable *table,
+                                              SlotHandle handle);
+
+/** @} */
+
+#endif /* PARKING_INDEX_H */
@@ -0,0 +1,352 @@
+/**
+ * @file parking_ingest.c
+ * @brief 出入场指令无锁接入队列实现文件
+ * @details
+ * 该文件实现了 parking_ingest.h 中声明的接入队列。队列是带哨兵结点的
+ * 侵入式多生产者单消费者链表：生产者以原子交换取得并替换链尾，再把旧链尾
+ * 的 next 指向新结点；应用线程从链头逐个取出。生产者完成交换、尚未写入
+ * next 的短暂窗口内，应用线程会把队列视为暂时为空，等该生产者写入 next
+ * 并触发信号后继续。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_ingest.h"
+#include "parking_thread.h"
+
+/**
+ * @brief 队列中的一条指令。
+ */
+typedef struct IngestCommand {
+  void *volatile next;                 /**< 链表中的下一条指令。 */
+  GateEventKind kind;                  /**< 指令类型。 */
+  int slot_id;                         /**< 车位编号。 */
+  ParkingType type;                    /**< 停车类型（入场）。 */
+  int has_owner;                       /**< owner_name 是否有值。 */
+  int has_plate;                       /**< license_plate 是否有值。 */
+  int has_contact;                     /**< contact 是否有值。 */
+  char owner_name[MAX_NAME_LEN];       /**< 车主姓名（入场）。 */
+  char license_plate[MAX_LICENSE_LEN]; /**< 车牌号（入场）。 */
+  char contact[MAX_CONTACT_LEN];       /**< 联系方式（入场）。 */
+  ParkingIngestDoneFn done;            /**< 完成通知函数，可以为 NULL。 */
+  void *ctx;                           /**< 通知函数的上下文指针。 */
+} IngestCommand;
+
+/**
+ * @brief 正在运行的接入队列。
+ */
+struct ParkingIngest {
+  ParkingLot *lot;          /**< 目标停车场。 */
+  ParkingThread *thread;    /**< 应用线程。 */
+  ParkingSignal *signal;    /**< 应用线程等待时由生产者或停止请求触发。 */
+  void *volatile head;      /**< 最近入队的指令（生产者端）。 */
+  IngestCommand *tail;      /**< 下一条待取的指令（仅应用线程访问）。 */
+  IngestCommand stub;       /**< 哨兵结点，队列为空时位于链中。 */
+  volatile int sleeping;    /**< 应用线程即将或正在等待信号时为 1。 */
+  volatile int stopping;    /**< 非 0 时应用线程取完队列后退出。 */
+  int batch_max;            /**< 每批最多应用的指令数。 */
+  IngestCommand **commands; /**< 一批指令的缓冲区（仅应用线程访问）。 */
+  GateEvent *events;        /**< 一批事件的缓冲区（仅应用线程访问）。 */
+  ParkingServiceResultCode *codes; /**< 一批结果的缓冲区（仅应用线程访问）。 */
+  volatile long submitted;  /**< 已入队的指令数。 */
+  volatile long applied;    /**< 已应用的指令数。 */
+  volatile long batches;    /**< 已应用的批次数。 */
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 把一条指令接到队列末尾。
+ * @details 先发布新链尾再链接旧链尾；两步之间应用线程看到的是暂时断开的链。
+ * @param ingest 目标接入队列。
+ * @param command 要入队的指令。
+ */
+static void queue_push(ParkingIngest *ingest, IngestCommand *command) {
+  IngestCommand *prev;
+
+  command->next = NULL;
+  prev = (IngestCommand *)parking_atomic_exchange_ptr(&ingest->head, command);
+  parking_atomic_exchange_ptr(&prev->next, command);
+}
+
+/**
+ * @brief (静态辅助函数) 从队列头部取出一条指令，仅应用线程调用。
+ * @param ingest 目标接入队列。
+ * @return 取出的指令；队列为空或某个生产者尚未完成链接时返回 NULL。
+ */
+static IngestCommand *queue_pop(ParkingIngest *ingest) {
+  IngestCommand *tail = ingest->tail;
+  IngestCommand *next =
+      (IngestCommand *)parking_atomic_load_ptr(&tail->next);
+
+  if (tail == &ingest->stub) {
+    if (next == NULL) {
+      return NULL;
+    }
+    ingest->tail = next;
+    tail = next;
+    next = (IngestCommand *)parking_atomic_load_ptr(&tail->next);
+  }
+  if (next != NULL) {
+    ingest->tail = next;
+    return tail;
+  }
+  if ((void *)tail != parking_atomic_load_ptr(&ingest->head)) {
+    return NULL;
+  }
+  /* tail 是最后一条指令：把哨兵接到其后，才能在取走它后保持链不为空 */
+  queue_push(ingest, &ingest->stub);
+  next = (IngestCommand *)parking_atomic_load_ptr(&tail->next);
+  if (next != NULL) {
+    ingest->tail = next;
+    return tail;
+  }
+  return NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 复制一个可以为 NULL 的字符串字段。
+ * @param dest 目标缓冲区。
+ * @param size 缓冲区大小。
+ * @param src 源字符串，可以为 NULL。
+ * @param has_value 接收源字符串是否非 NULL。
+ * @return 成功返回 0，字符串过长返回 -1。
+ */
+static int copy_field(char *dest, size_t size, const char *src,
+                      int *has_value) {
+  size_t length;
+
+  *has_value = src != NULL;
+  dest[0] = '\0';
+  if (src == NULL) {
+    return 0;
+  }
+  length = strlen(src);
+  if (length >= size) {
+    return -1;
+  }
+  memcpy(dest, src, length + 1);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 把队列中的指令还原为出入场事件。
+ * @param command 指令。
+ * @param[out] event 接收事件，字符串字段指向指令内的缓冲区。
+ */
+static void command_event(const IngestCommand *command, GateEvent *event) {
+  event->kind = command->kind;
+  event->slot_id = command->slot_id;
+  event->type = command->type;
+  event->owner_name = command->has_owner ? command->owner_name : NULL;
+  event->license_plate = command->has_plate ? command->license_plate : NULL;
+  event->contact = command->has_contact ? command->contact : NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 应用一批指令，通知提交者并释放指令。
+ * @param ingest 目标接入队列，指令位于 ingest->commands 的前 count 项。
+ * @param count 指令数。
+ */
+static void apply_commands(ParkingIngest *ingest, int count) {
+  IngestCommand **commands = ingest->commands;
+  GateEvent *events = ingest->events;
+  ParkingServiceResultCode *codes = ingest->codes;
+  ServiceResult result;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    command_event(commands[i], &events[i]);
+  }
+  result = parking_service_apply_batch(ingest->lot, events, count, codes);
+  for (i = 0; i < count; i++) {
+    if (result.code == PARKING_SERVICE_MEMORY_ERROR ||
+        result.code == PARKING_SERVICE_INVALID_PARAM) {
+      /* 整批未执行 */
+      codes[i] = result.code;
+    } else if (result.code == PARKING_SERVICE_FILE_ERROR &&
+               codes[i] == PARKING_SERVICE_SUCCESS) {
+      /* 修改已在内存中生效，但日志未能落盘 */
+      codes[i] = PARKING_SERVICE_FILE_ERROR;
+    }
+    if (commands[i]->done != NULL) {
+      commands[i]->done(&events[i], codes[i], commands[i]->ctx);
+    }
+    free(commands[i]);
+  }
+  parking_atomic_add_long(&ingest->applied, count);
+  parking_atomic_add_long(&ingest->batches, 1);
+}
+
+/**
+ * @brief (静态辅助函数) 应用线程入口：取指令、成批应用，空闲时等待信号。
+ * @param arg 接入队列。
+ */
+static void ingest_thread_main(void *arg) {
+  ParkingIngest *ingest = (ParkingIngest *)arg;
+
+  for (;;) {
+    IngestCommand *command = queue_pop(ingest);
+    int count = 0;
+
+    while (command != NULL) {
+      ingest->commands[count++] = command;
+      if (count == ingest->batch_max) {
+        break;
+      }
+      command = queue_pop(ingest);
+    }
+    if (count > 0) {
+      apply_commands(ingest, count);
+      continue;
+    }
+    if (parking_atomic_load_int(&ingest->stopping) &&
+        parking_atomic_load_ptr(&ingest->head) == (void *)ingest->tail) {
+      break;
+    }
+
+    /* 先声明要等待再检查一次队列：生产者链接后读到 sleeping 才会触发信号 */
+    parking_atomic_store_int(&ingest->sleeping, 1);
+    command = queue_pop(ingest);
+    if (command == NULL) {
+      parking_signal_wait(ingest->signal, 0);
+    }
+    parking_atomic_store_int(&ingest->sleeping, 0);
+    if (command != NULL) {
+      ingest->commands[0] = command;
+      apply_commands(ingest, 1);
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放接入队列的信号、批缓冲区与句柄本身。
+ * @param ingest 目标接入队列，其应用线程已退出或从未启动。
+ */
+static void ingest_free(ParkingIngest *ingest) {
+  parking_signal_destroy(ingest->signal);
+  free(ingest->commands);
+  free(ingest->events);
+  free(ingest->codes);
+  free(ingest);
+}
+
+/* ========================================================================== */
+/*                              接入队列API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 为停车场启动接入队列与应用线程。
+ * @param lot 目标停车场。
+ * @param batch_max 每批最多应用的指令数，0 表示默认值。
+ * @return 成功返回句柄，失败返回 NULL。
+ */
+ParkingIngest *parking_ingest_start(ParkingLot *lot, int batch_max) {
+  ParkingIngest *ingest;
+
+  if (lot == NULL || batch_max < 0) {
+    return NULL;
+  }
+  ingest = (ParkingIngest *)calloc(1, sizeof(ParkingIngest));
+  if (ingest == NULL) {
+    return NULL;
+  }
+  ingest->lot = lot;
+  ingest->batch_max = batch_max > 0 ? batch_max : PARKING_INGEST_DEFAULT_BATCH;
+  ingest->stub.next = NULL;
+  ingest->head = &ingest->stub;
+  ingest->tail = &ingest->stub;
+  ingest->signal = parking_signal_create();
+  ingest->commands = (IngestCommand **)malloc((size_t)ingest->batch_max *
+                                              sizeof(IngestCommand *));
+  ingest->events =
+      (GateEvent *)malloc((size_t)ingest->batch_max * sizeof(GateEvent));
+  ingest->codes = (ParkingServiceResultCode *)malloc(
+      (size_t)ingest->batch_max * sizeof(ParkingServiceResultCode));
+  if (ingest->signal == NULL || ingest->commands == NULL ||
+      ingest->events == NULL || ingest->codes == NULL) {
+    ingest_free(ingest);
+    return NULL;
+  }
+  ingest->thread = parking_thread_start(ingest_thread_main, ingest);
+  if (ingest->thread == NULL) {
+    ingest_free(ingest);
+    return NULL;
+  }
+  return ingest;
+}
+
+/**
+ * @brief 提交一条出入场指令，不等待其应用。
+ * @param ingest 接入队列句柄。
+ * @param event 指令内容。
+ * @param done 完成通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 已入队返回 0；参数无效、字符串过长或正在停止返回 -1；
+ *         内存不足返回 -2。
+ */
+int parking_ingest_submit(ParkingIngest *ingest, const GateEvent *event,
+                          ParkingIngestDoneFn done, void *ctx) {
+  IngestCommand *command;
+
+  if (ingest == NULL || event == NULL ||
+      parking_atomic_load_int(&ingest->stopping)) {
+    return -1;
+  }
+  command = (IngestCommand *)malloc(sizeof(IngestCommand));
+  if (command == NULL) {
+    return -2;
+  }
+  command->kind = event->kind;
+  command->slot_id = event->slot_id;
+  command->type = event->type;
+  command->done = done;
+  command->ctx = ctx;
+  if (copy_field(command->owner_name, sizeof(command->owner_name),
+                 event->owner_name, &command->has_owner) != 0 ||
+      copy_field(command->license_plate, sizeof(command->license_plate),
+                 event->license_plate, &command->has_plate) != 0 ||
+      copy_field(command->contact, sizeof(command->contact), event->contact,
+                 &command->has_contact) != 0) {
+    free(command);
+    return -1;
+  }
+
+  parking_atomic_add_long(&ingest->submitted, 1);
+  queue_push(ingest, command);
+  if (parking_atomic_load_int(&ingest->sleeping)) {
+    parking_signal_notify(ingest->signal);
+  }
+  return 0;
+}
+
+/**
+ * @brief 读取接入队列的累计统计。
+ * @param ingest 接入队列句柄。
+ * @param[out] stats 接收统计。
+ */
+void parking_ingest_stats(ParkingIngest *ingest, ParkingIngestStats *stats) {
+  if (ingest == NULL || stats == NULL) {
+    return;
+  }
+  stats->submitted = parking_atomic_load_long(&ingest->submitted);
+  stats->applied = parking_atomic_load_long(&ingest->applied);
+  stats->batches = parking_atomic_load_long(&ingest->batches);
+}
+
+/**
+ * @brief 停止接入队列并释放句柄。
+ * @param ingest 接入队列句柄，可以为 NULL。
+ */
+void parking_ingest_stop(ParkingIngest *ingest) {
+  if (ingest == NULL) {
+    return;
+  }
+  parking_atomic_store_int(&ingest->stopping, 1);
+  parking_signal_notify(ingest->signal);
+  parking_thread_join(ingest->thread);
+  ingest_free(ingest);
+}
@@ -0,0 +1,105 @@
+#ifndef PARKING_INGEST_H
+#define PARKING_INGEST_H
+
+#include "parking_service.h"
+
+/**
+ * @file parking_ingest.h
+ * @brief 出入场指令无锁接入队列的接口声明。
+ * @details
+ * 闸机控制线程把入场、出场指令压入一个无锁的多生产者单消费者队列后立即
+ * 返回，不接触停车场的锁。一个专属的应用线程按到达顺序取出指令，
+ * 每批最多 batch_max 条交给 parking_service_apply_batch：整批只获取一次
+ * 写锁，日志记录合并为一次同步。每条指令的结果在锁外通过完成通知函数
+ * 交还给提交者。
+ *
+ * 队列是侵入式链表（Vyukov 算法）：入队只有一次原子交换和一次原子写，
+ * 没有重试循环，任意多个线程可以同时入队；出队只在应用线程中进行。
+ * 应用线程空闲时在信号上等待，生产者只在它等待时才触发信号。
+ * 查询等其他服务层函数照常使用停车场的读写锁，可以与接入队列并用。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_INGEST_DEFAULT_BATCH 64 /**< 默认每批应用的最多指令数 */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一条指令应用完成后的通知函数。
+ * @details 在应用线程中调用，不持有停车场的锁；处理函数可以调用服务层函数，
+ *          但不应长时间阻塞，否则会推迟后续批次。
+ * @param event 应用的指令，字符串字段只在回调期间有效。
+ * @param code 指令的结果，与 parking_service_apply_batch 中单个事件的结果相同；
+ *        日志同步失败时成功的指令报告 PARKING_SERVICE_FILE_ERROR。
+ * @param ctx 提交指令时传入的上下文指针。
+ */
+typedef void (*ParkingIngestDoneFn)(const GateEvent *event,
+                                    ParkingServiceResultCode code, void *ctx);
+
+/**
+ * @brief 接入队列的累计统计。
+ */
+typedef struct ParkingIngestStats {
+  long submitted; /**< 已入队的指令数。 */
+  long applied;   /**< 已应用（并通知）的指令数。 */
+  long batches;   /**< 已应用的批次数。 */
+} ParkingIngestStats;
+
+/**
+ * @brief 不透明的接入队列句柄。
+ */
+typedef struct ParkingIngest ParkingIngest;
+
+/**
+ *********************************************************************************
+ *                              接入队列API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 为停车场启动接入队列与应用线程。
+ * @param lot 目标停车场，须比接入队列存活得久。
+ * @param batch_max 每批最多应用的指令数，0 表示 PARKING_INGEST_DEFAULT_BATCH。
+ * @return 成功返回句柄，参数无效、内存不足或无法创建线程时返回 NULL。
+ */
+ParkingIngest *parking_ingest_start(ParkingLot *lot, int batch_max);
+
+/**
+ * @brief 提交一条出入场指令，不等待其应用。
+ * @details 可以从任意线程并发调用。字符串字段在函数返回前复制；
+ *          参数格式由应用线程在批处理中校验，不合格的指令同样会收到通知。
+ * @param ingest 接入队列句柄。
+ * @param event 指令内容。
+ * @param done 完成通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 已入队返回 0；参数无效、字符串过长或正在停止返回 -1；
+ *         内存不足返回 -2。
+ */
+int parking_ingest_submit(ParkingIngest *ingest, const GateEvent *event,
+                          ParkingIngestDoneFn done, void *ctx);
+
+/**
+ * @brief 读取接入队列的累计统计。
+ * @param ingest 接入队列句柄。
+ * @param[out] stats 接收统计。
+ */
+void parking_ingest_stats(ParkingIngest *ingest, ParkingIngestStats *stats);
+
+/**
+ * @brief 停止接入队列并释放句柄。
+ * @details 已入队的指令会先全部应用并通知；调用者须保证此后不再提交，
+ *          且不持有停车场的锁。
+ * @param ingest 接入队列句柄，可以为 NULL。
+ */
+void parking_ingest_stop(ParkingIngest *ingest);
+
+#endif /* PARKING_INGEST_H */
@@ -0,0 +1,579 @@
+/**
+ * @file parking_journal.c
+ * @brief 追加式预写日志实现文件
+ * @details
+ * 该文件实现了 parking_journal.h 中声明的日志文件管理、记录编解码与重放。
+ * 日志模块只负责字节层面的读写，记录如何作用于停车场由数据层决定。
+ * fsync 属于 POSIX 接口，需要在包含系统头文件前开启 _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_codec.h"
+#include "parking_journal.h"
+#include "parking_trace.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define JOURNAL_RECORD_HEADER 8   /**< 记录头字节数 */
+#define JOURNAL_FIXED_PAYLOAD 32  /**< 负载中定长部分的字节数 */
+#define JOURNAL_MAX_PAYLOAD                                                    \
+  (JOURNAL_FIXED_PAYLOAD + 4 + MAX_LOCATION_LEN + MAX_NAME_LEN +               \
+   MAX_LICENSE_LEN + MAX_CONTACT_LEN) /**< 负载的最大字节数 */
+
+/** 编译期检查：头文件公布的记录上限与实际编码格式一致。 */
+typedef char journal_record_size_check
+    [JOURNAL_RECORD_HEADER + JOURNAL_MAX_PAYLOAD == JOURNAL_MAX_RECORD_SIZE
+         ? 1
+         : -1];
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 安全复制路径字符串。
+ * @param dest 目标缓冲区（JOURNAL_MAX_PATH 字节）。
+ * @param src 源路径，可以为 NULL（视为空字符串）。
+ * @return 成功返回 0，路径过长返回 -1。
+ */
+static int copy_path(char *dest, const char *src) {
+  size_t length = src ? strlen(src) : 0;
+
+  if (length >= JOURNAL_MAX_PATH) {
+    return -1;
+  }
+  memcpy(dest, src ? src : "", length + 1);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 写入以 1 字节长度为前缀的字符串。
+ * @param p 目标位置。
+ * @param text 要写入的字符串。
+ * @param capacity 字符串字段的容量（含结尾 NUL）。
+ * @return 写入的字节数。
+ */
+static size_t put_string(unsigned char *p, const char *text, size_t capacity) {
+  size_t length = strlen(text);
+
+  if (length > capacity - 1) {
+    length = capacity - 1;
+  }
+  p[0] = (unsigned char)length;
+  memcpy(p + 1, text, length);
+  return length + 1;
+}
+
+/**
+ * @brief (静态辅助函数) 读取以 1 字节长度为前缀的字符串。
+ * @param p 当前读取位置。
+ * @param end 负载末尾。
+ * @param dest 目标缓冲区。
+ * @param capacity 目标缓冲区容量（含结尾 NUL）。
+ * @return 成功返回消耗的字节数，数据越界返回 0。
+ */
+static size_t get_string(const unsigned char *p, const unsigned char *end,
+                         char *dest, size_t capacity) {
+  size_t length;
+
+  if (p >= end) {
+    return 0;
+  }
+  length = p[0];
+  if (length > capacity - 1 || (size_t)(end - p) < length + 1) {
+    return 0;
+  }
+  memcpy(dest, p + 1, length);
+  dest[length] = '\0';
+  return length + 1;
+}
+
+/**
+ * @brief (静态辅助函数) 将记录编码为“记录头 + 负载”的字节序列。
+ * @param record 要编码的记录。
+ * @param buffer 目标缓冲区（至少 JOURNAL_RECORD_HEADER + JOURNAL_MAX_PAYLOAD）。
+ * @return 编码后的总字节数。
+ */
+static size_t encode_record(const JournalRecord *record,
+                            unsigned char *buffer) {
+  unsigned char *payload = buffer + JOURNAL_RECORD_HEADER;
+  size_t length = JOURNAL_FIXED_PAYLOAD;
+  unsigned long sum;
+
+  memset(buffer, 0, JOURNAL_RECORD_HEADER + JOURNAL_FIXED_PAYLOAD);
+  codec_put_i32(payload, record->slot_id);
+  payload[4] = (unsigned char)record->type;
+  payload[5] = (unsigned char)record->status;
+  codec_put_time(payload + 8, record->entry_time);
+  codec_put_time(payload + 16, record->exit_time);
+  codec_put_time(payload + 24, record->due_date);
+  length += put_string(payload + length, record->location, MAX_LOCATION_LEN);
+  length += put_string(payload + length, record->owner_name, MAX_NAME_LEN);
+  length +=
+      put_string(payload + length, record->license_plate, MAX_LICENSE_LEN);
+  length += put_string(payload + length, record->contact, MAX_CONTACT_LEN);
+
+  buffer[0] = (unsigned char)record->op;
+  buffer[1] = (unsigned char)record->fields;
+  codec_put_u16(buffer + 2, (unsigned int)length);
+  sum = codec_checksum(buffer, 4);
+  sum = codec_checksum_update(sum, payload, length);
+  codec_put_u32(buffer + 4, sum);
+  return JOURNAL_RECORD_HEADER + length;
+}
+
+/**
+ * @brief (静态辅助函数) 将负载解码为记录。
+ * @param header 记录头。
+ * @param payload 负载。
+ * @param length 负载字节数。
+ * @param[out] record 解码结果。
+ * @return 成功返回 0，负载格式错误返回 -1。
+ */
+static int decode_record(const unsigned char *header,
+                         const unsigned char *payload, size_t length,
+                         JournalRecord *record) {
+  const unsigned char *p = payload + JOURNAL_FIXED_PAYLOAD;
+  const unsigned char *end = payload + length;
+  size_t used;
+
+  if (length < JOURNAL_FIXED_PAYLOAD) {
+    return -1;
+  }
+
+  memset(record, 0, sizeof(*record));
+  record->op = (JournalOp)header[0];
+  record->fields = header[1];
+  record->slot_id = codec_get_i32(payload);
+  record->type = payload[4];
+  record->status = payload[5];
+  record->entry_time = codec_get_time(payload + 8);
+  record->exit_time = codec_get_time(payload + 16);
+  record->due_date = codec_get_time(payload + 24);
+
+  used = get_string(p, end, record->location, MAX_LOCATION_LEN);
+  if (used == 0) {
+    return -1;
+  }
+  p += used;
+  used = get_string(p, end, record->owner_name, MAX_NAME_LEN);
+  if (used == 0) {
+    return -1;
+  }
+  p += used;
+  used = get_string(p, end, record->license_plate, MAX_LICENSE_LEN);
+  if (used == 0) {
+    return -1;
+  }
+  p += used;
+  used = get_string(p, end, record->contact, MAX_CONTACT_LEN);
+  return used == 0 ? -1 : 0;
+}
+
+/**
+ * @brief (静态辅助函数) 创建只含文件头的空日志文件。
+ * @param path 日志文件路径。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int write_empty_journal(const char *path) {
+  FILE *file = fopen(path, "wb");
+  int ok;
+
+  if (file == NULL) {
+    return -1;
+  }
+  ok = fwrite(JOURNAL_MAGIC, 1, 8, file) == 8;
+  if (fclose(file) != 0) {
+    ok = 0;
+  }
+  return ok ? 0 : -1;
+}
+
+/**
+ * @brief (静态辅助函数) 将 stdio 缓冲区和操作系统缓存写到磁盘。
+ * @param file 已打开的文件。
+ * @return 成功返回 0，失败返回 -1。
+ */
+static int flush_to_disk(FILE *file) {
+  TraceSpan span;
+  int result;
+
+  if (fflush(file) != 0) {
+    return -1;
+  }
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_IO, "journal_fsync");
+#ifdef _WIN32
+  result = _commit(_fileno(file)) == 0 ? 0 : -1;
+#else
+  result = fsync(fileno(file)) == 0 ? 0 : -1;
+#endif
+  PARKING_TRACE_END(span);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 将当前批次标记为已落盘并通知调用者。
+ * @param journal 目标日志。
+ */
+static void mark_durable(ParkingJournal *journal) {
+  unsigned long first = journal->durable_seq + 1;
+  unsigned long last = journal->next_seq - 1;
+
+  if (last < first) {
+    return;
+  }
+  journal->durable_seq = last;
+  if (journal->on_durable != NULL) {
+    journal->on_durable(first, last, time(NULL), journal->durable_ctx);
+  }
+}
+
+/* ========================================================================== */
+/*                              日志操作函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 打开（必要时创建）日志文件用于追加。
+ * @details 文件不存在或为空时写入文件头；已存在的文件必须以日志魔数开头。
+ * @param path 日志文件路径。
+ * @param snapshot_path 压缩日志时写入的快照路径。
+ * @param truncate 非 0 时清空已有内容，重新写入文件头。
+ * @return 成功返回新分配的日志对象，失败返回 NULL。
+ */
+ParkingJournal *journal_open(const char *path, const char *snapshot_path,
+                             int truncate) {
+  ParkingJournal *journal;
+  FILE *probe;
+  char magic[8];
+  size_t got = 0;
+
+  if (path == NULL || snapshot_path == NULL) {
+    return NULL;
+  }
+
+  journal = (ParkingJournal *)malloc(sizeof(ParkingJournal));
+  if (journal == NULL) {
+    return NULL;
+  }
+  if (copy_path(journal->path, path) != 0 ||
+      copy_path(journal->snapshot_path, snapshot_path) != 0) {
+    free(journal);
+    return NULL;
+  }
+  journal->record_count = 0;
+  journal->compact_threshold = JOURNAL_DEFAULT_COMPACT;
+  journal->error = 0;
+  journal->next_seq = 1;
+  journal->durable_seq = 0;
+  journal->batch_max_records = JOURNAL_DEFAULT_BATCH;
+  journal->batch_window_seconds = 0;
+  journal->batch_started = 0;
+  journal->on_durable = NULL;
+  journal->durable_ctx = NULL;
+  journal->deferred = 0;
+
+  if (!truncate) {
+    probe = fopen(path, "rb");
+    if (probe != NULL) {
+      got = fread(magic, 1, 8, probe);
+      fclose(probe);
+      if (got != 0 && (got != 8 || memcmp(magic, JOURNAL_MAGIC, 8) != 0)) {
+        free(journal); /* 不是日志文件，拒绝覆盖 */
+        return NULL;
+      }
+    }
+  }
+  if ((truncate || got == 0) && write_empty_journal(path) != 0) {
+    free(journal);
+    return NULL;
+  }
+
+  journal->file = fopen(path, "ab");
+  if (journal->file == NULL) {
+    free(journal);
+    return NULL;
+  }
+  return journal;
+}
+
+/**
+ * @brief 关闭日志文件并释放日志对象。
+ * @details 关闭前同步当前批次。
+ * @param journal 要关闭的日志，可以为 NULL。
+ */
+void journal_close(ParkingJournal *journal) {
+  if (journal == NULL) {
+    return;
+  }
+  if (journal->file != NULL) {
+    journal_sync(journal);
+    fclose(journal->file);
+  }
+  free(journal);
+}
+
+/**
+ * @brief 清空日志内容，只保留文件头。
+ * @details 调用前新快照已包含当前批次的修改，因此重置成功即视为该批次落盘。
+ * @param journal 目标日志。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int journal_reset(ParkingJournal *journal) {
+  if (journal == NULL) {
+    return -1;
+  }
+  if (journal->file != NULL) {
+    fclose(journal->file);
+    journal->file = NULL;
+  }
+  if (write_empty_journal(journal->path) != 0) {
+    journal->error = 1;
+    return -1;
+  }
+  journal->file = fopen(journal->path, "ab");
+  if (journal->file == NULL) {
+    journal->error = 1;
+    return -1;
+  }
+  journal->record_count = 0;
+  journal->error = 0;
+  mark_durable(journal);
+  return 0;
+}
+
+/**
+ * @brief 设置批量提交策略。
+ * @param journal 目标日志。
+ * @param max_records 每批最多记录数，0 表示不按数量触发。
+ * @param window_seconds 每批最长等待秒数，0 表示不按时间触发。
+ * @param on_durable 落盘通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 成功返回 0；参数无效或同步失败返回 -1。
+ */
+int journal_set_batch(ParkingJournal *journal, unsigned long max_records,
+                      unsigned int window_seconds, JournalDurableFn on_durable,
+                      void *ctx) {
+  if (journal == NULL || (max_records == 0 && window_seconds == 0)) {
+    return -1;
+  }
+  if (journal_sync(journal) != 0) {
+    return -1;
+  }
+  journal->batch_max_records = max_records;
+  journal->batch_window_seconds = window_seconds;
+  journal->on_durable = on_durable;
+  journal->durable_ctx = ctx;
+  return 0;
+}
+
+/**
+ * @brief 编码一条记录并追加到日志末尾。
+ * @param journal 目标日志。
+ * @param record 要追加的记录。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int journal_append(ParkingJournal *journal, const JournalRecord *record) {
+  unsigned char buffer[JOURNAL_RECORD_HEADER + JOURNAL_MAX_PAYLOAD];
+  TraceSpan span;
+  size_t size;
+
+  if (journal == NULL || record == NULL || journal->file == NULL) {
+    return -1;
+  }
+
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_IO, "journal_append");
+  size = encode_record(record, buffer);
+  if (fwrite(buffer, 1, size, journal->file) != size) {
+    PARKING_TRACE_END(span);
+    journal->error = 1;
+    return -1;
+  }
+  PARKING_TRACE_END(span);
+  if (journal->next_seq - 1 == journal->durable_seq) {
+    journal->batch_started = time(NULL); /* 新批次的第一条记录 */
+  }
+  journal->next_seq++;
+  journal->record_count++;
+
+  if (journal->deferred > 0) {
+    return 0;
+  }
+  if (journal->batch_max_records > 0 &&
+      journal->next_seq - 1 - journal->durable_seq >=
+          journal->batch_max_records) {
+    return journal_sync(journal);
+  }
+  return journal_sync_if_due(journal, time(NULL));
+}
+
+/**
+ * @brief 将当前批次 fflush 并 fsync 到磁盘，然后报告落盘的序号区间。
+ * @param journal 目标日志。
+ * @return 成功（含无待同步记录）返回 0，失败返回 -1。
+ */
+int journal_sync(ParkingJournal *journal) {
+  if (journal == NULL || journal->file == NULL) {
+    return -1;
+  }
+  if (journal->next_seq - 1 == journal->durable_seq) {
+    return 0;
+  }
+  if (flush_to_disk(journal->file) != 0) {
+    journal->error = 1;
+    return -1;
+  }
+  mark_durable(journal);
+  return 0;
+}
+
+/**
+ * @brief 当前批次的时间窗口已到时执行同步。
+ * @param journal 目标日志。
+ * @param now 当前时间。
+ * @return 成功或无需同步返回 0，同步失败返回 -1。
+ */
+int journal_sync_if_due(ParkingJournal *journal, time_t now) {
+  if (journal == NULL) {
+    return -1;
+  }
+  if (journal->deferred > 0 || journal->batch_window_seconds == 0 ||
+      journal->next_seq - 1 == journal->durable_seq ||
+      difftime(now, journal->batch_started) <
+          (double)journal->batch_window_seconds) {
+    return 0;
+  }
+  return journal_sync(journal);
+}
+
+/**
+ * @brief 开始一段批量操作：期间追加的记录不按批量策略同步。
+ * @param journal 目标日志。
+ */
+void journal_begin_deferred(ParkingJournal *journal) {
+  if (journal != NULL) {
+    journal->deferred++;
+  }
+}
+
+/**
+ * @brief 结束一段批量操作，在最外层时同步期间追加的全部记录。
+ * @param journal 目标日志。
+ * @return 成功返回 0，同步失败返回 -1。
+ */
+int journal_end_deferred(ParkingJournal *journal) {
+  if (journal == NULL || journal->deferred == 0) {
+    return -1;
+  }
+  journal->deferred--;
+  return journal->deferred == 0 ? journal_sync(journal) : 0;
+}
+
+/**
+ * @brief 把一条记录编码为日志文件中的字节格式。
+ * @param record 要编码的记录。
+ * @param buffer 目标缓冲区（至少 JOURNAL_MAX_RECORD_SIZE 字节）。
+ * @return 编码后的字节数。
+ */
+size_t journal_encode_record(const JournalRecord *record,
+                             unsigned char *buffer) {
+  return encode_record(record, buffer);
+}
+
+/**
+ * @brief 从字节序列开头解码一条记录并校验。
+ * @param data 记录的起始位置。
+ * @param size 可用的字节数。
+ * @param[out] record 解码结果。
+ * @return 消耗的字节数；数据不足返回 0；校验失败或格式错误返回 -1。
+ */
+long journal_decode_record(const unsigned char *data, size_t size,
+                           JournalRecord *record) {
+  size_t length;
+  unsigned long sum;
+
+  if (size < JOURNAL_RECORD_HEADER) {
+    return 0;
+  }
+  length = codec_get_u16(data + 2);
+  if (length > JOURNAL_MAX_PAYLOAD) {
+    return -1;
+  }
+  if (size - JOURNAL_RECORD_HEADER < length) {
+    return 0;
+  }
+  sum = codec_checksum(data, 4);
+  sum = codec_checksum_update(sum, data + JOURNAL_RECORD_HEADER, length);
+  if (sum != codec_get_u32(data + 4) ||
+      decode_record(data, data + JOURNAL_RECORD_HEADER, length, record) != 0) {
+    return -1;
+  }
+  return (long)(JOURNAL_RECORD_HEADER + length);
+}
+
+/**
+ * @brief 顺序读取日志文件并对每条有效记录调用回调。
+ * @details 截断或校验失败的记录视为日志末尾，其后的内容被忽略。
+ * @param path 日志文件路径。
+ * @param replay 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 成功重放的记录数；文件不存在时返回 0，文件头无效时返回 -1。
+ */
+long journal_replay(const char *path, JournalReplayFn replay, void *ctx) {
+  FILE *file;
+  unsigned char header[JOURNAL_RECORD_HEADER];
+  unsigned char payload[JOURNAL_MAX_PAYLOAD];
+  char magic[8];
+  JournalRecord record;
+  size_t length;
+  unsigned long sum;
+  long replayed = 0;
+
+  if (path == NULL || replay == NULL) {
+    return -1;
+  }
+  file = fopen(path, "rb");
+  if (file == NULL) {
+    return 0;
+  }
+  if (fread(magic, 1, 8, file) != 8 || memcmp(magic, JOURNAL_MAGIC, 8) != 0) {
+    fclose(file);
+    return -1;
+  }
+
+  while (fread(header, 1, JOURNAL_RECORD_HEADER, file) ==
+         JOURNAL_RECORD_HEADER) {
+    length = codec_get_u16(header + 2);
+    if (length > JOURNAL_MAX_PAYLOAD ||
+        fread(payload, 1, length, file) != length) {
+      break; /* 崩溃时未写完的尾部 */
+    }
+    sum = codec_checksum(header, 4);
+    sum = codec_checksum_update(sum, payload, length);
+    if (sum != codec_get_u32(header + 4) ||
+        decode_record(header, payload, length, &record) != 0) {
+      break;
+    }
+    replayed++;
+    if (replay(&record, ctx) != 0) {
+      break;
+    }
+  }
+
+  fclose(file);
+  return replayed;
+}
@@ -0,0 +1,234 @@
+#ifndef PARKING_JOURNAL_H
+#define PARKING_JOURNAL_H
+
+#include <stdio.h>
+#include <time.h>
+
+#include "parking_data.h"
+
+/**
+ * @file parking_journal.h
+ * @brief 追加式预写日志（WAL）的结构与接口声明。
+ * @details
+ * 启用日志后，数据层每完成一次车位增删、入场、出场或信息修改，
+ * 就向日志文件末尾追加一条紧凑的二进制记录，持久化代价与停车场规模无关。
+ * 加载时先读取最近一次的快照，再按顺序重放日志；
+ * 日志增长到阈值后会被压缩进新的快照并清空。
+ *
+ * 日志文件格式：8 字节魔数 "PARKWAL1"，随后是若干条记录。
+ * 每条记录由 8 字节记录头（操作码、字段标志、负载长度、校验和）与负载组成。
+ * 重放遇到截断或校验失败的记录即视为日志末尾（通常是崩溃时未写完的尾部）。
+ *
+ * 同步到磁盘按批进行：追加只写入 stdio 缓冲区，达到批量策略的记录数
+ * 或时间窗口后才执行一次 fflush 加 fsync，并以序号区间报告落盘进度。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define JOURNAL_MAGIC "PARKWAL1"   /**< 日志文件开头的 8 字节魔数 */
+#define JOURNAL_MAX_PATH 260       /**< 日志与快照路径的最大长度 */
+#define JOURNAL_DEFAULT_COMPACT 4096 /**< 默认每累计多少条记录压缩一次 */
+#define JOURNAL_DEFAULT_BATCH 1      /**< 默认每批同步的记录数（逐条同步） */
+
+/** 一条编码后记录（记录头加负载）的最大字节数 */
+#define JOURNAL_MAX_RECORD_SIZE                                                \
+  (8 + 36 + MAX_LOCATION_LEN + MAX_NAME_LEN + MAX_LICENSE_LEN + MAX_CONTACT_LEN)
+
+#define JOURNAL_FIELD_LOCATION 0x01U /**< 信息修改记录包含位置描述 */
+#define JOURNAL_FIELD_OWNER 0x02U    /**< 信息修改记录包含车主姓名 */
+#define JOURNAL_FIELD_CONTACT 0x04U  /**< 信息修改记录包含联系方式 */
+
+/**
+ *********************************************************************************
+ *                                 枚举和结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 日志记录的操作类型。
+ */
+typedef enum {
+  JOURNAL_OP_ADD_SLOT = 1,    /**< 添加车位（编号、位置）。 */
+  JOURNAL_OP_DELETE_SLOT = 2, /**< 删除车位（编号）。 */
+  JOURNAL_OP_ALLOCATE = 3,    /**< 车辆入场（车主信息、类型、入场时间）。 */
+  JOURNAL_OP_DEALLOCATE = 4,  /**< 车辆出场（出场时间）。 */
+  JOURNAL_OP_UPDATE_INFO = 5, /**< 修改车位信息（按字段标志）。 */
+  JOURNAL_OP_SYNC_SLOT = 6    /**< 热字段同步（状态、类型、时间戳）。 */
+} JournalOp;
+
+/**
+ * @brief 解码后的一条日志记录。
+ * @details 所有操作共用同一结构，未用到的字段为 0 或空字符串。
+ */
+typedef struct JournalRecord {
+  JournalOp op;                        /**< 操作类型。 */
+  unsigned int fields;                 /**< 信息修改记录的字段标志。 */
+  int slot_id;                         /**< 车位编号。 */
+  int type;                            /**< 停车类型。 */
+  int status;                          /**< 车位状态（仅热字段同步使用）。 */
+  time_t entry_time;                   /**< 入场时间。 */
+  time_t exit_time;                    /**< 出场时间。 */
+  time_t due_date;                     /**< 居民月费到期时间。 */
+  char location[MAX_LOCATION_LEN];     /**< 位置描述。 */
+  char owner_name[MAX_NAME_LEN];       /**< 车主姓名。 */
+  char license_plate[MAX_LICENSE_LEN]; /**< 车牌号。 */
+  char contact[MAX_CONTACT_LEN];       /**< 联系方式。 */
+} JournalRecord;
+
+/**
+ * @brief 一个已打开的预写日志。
+ */
+typedef struct ParkingJournal {
+  FILE *file;                          /**< 以追加方式打开的日志文件。 */
+  char path[JOURNAL_MAX_PATH];         /**< 日志文件路径。 */
+  char snapshot_path[JOURNAL_MAX_PATH]; /**< 压缩时写入的快照路径。 */
+  unsigned long record_count; /**< 自上次压缩以来追加的记录数。 */
+  unsigned long compact_threshold; /**< 触发自动压缩的记录数，0 表示不自动压缩。 */
+  int error;                  /**< 最近一次写入失败后置 1，压缩成功后清除。 */
+  unsigned long next_seq;     /**< 下一条追加记录的序号（从 1 开始）。 */
+  unsigned long durable_seq;  /**< 已同步到磁盘的最大序号。 */
+  unsigned long batch_max_records; /**< 每批最多记录数，0 表示不限。 */
+  unsigned int batch_window_seconds; /**< 每批最长等待秒数，0 表示不限。 */
+  time_t batch_started;       /**< 当前批次第一条记录的追加时间。 */
+  JournalDurableFn on_durable; /**< 每批落盘后的通知函数，可以为 NULL。 */
+  void *durable_ctx;          /**< 透传给通知函数的上下文指针。 */
+  int deferred; /**< 大于 0 时暂停按策略同步，由批量操作结束时统一同步。 */
+} ParkingJournal;
+
+/**
+ * @brief 日志重放时对每条有效记录调用的回调函数。
+ * @param record 解码后的记录。
+ * @param ctx 调用者传入的上下文指针。
+ * @return 返回 0 继续重放，返回非 0 停止重放。
+ */
+typedef int (*JournalReplayFn)(const JournalRecord *record, void *ctx);
+
+/**
+ *********************************************************************************
+ *                            日志操作API声明
+ *********************************************************************************
+ */
+
+/** @name 日志文件管理 */
+/** @{ */
+
+/**
+ * @brief 打开（必要时创建）日志文件用于追加。
+ * @param path 日志文件路径。
+ * @param snapshot_path 压缩日志时写入的快照路径。
+ * @param truncate 非 0 时清空已有内容，重新写入文件头。
+ * @return 成功返回新分配的日志对象；路径过长、文件无法打开或不是
+ * 有效日志时返回 NULL。
+ */
+ParkingJournal *journal_open(const char *path, const char *snapshot_path,
+                             int truncate);
+
+/**
+ * @brief 关闭日志文件并释放日志对象。
+ * @param journal 要关闭的日志，可以为 NULL。
+ */
+void journal_close(ParkingJournal *journal);
+
+/**
+ * @brief 清空日志内容，只保留文件头。
+ * @details 在新快照写入成功后调用，完成一次压缩。
+ * @param journal 目标日志。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int journal_reset(ParkingJournal *journal);
+
+/**
+ * @brief 设置批量提交策略。
+ * @details 新策略生效前先同步当前批次。
+ * @param journal 目标日志。
+ * @param max_records 每批最多记录数，0 表示不按数量触发。
+ * @param window_seconds 每批最长等待秒数，0 表示不按时间触发。
+ * @param on_durable 落盘通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 成功返回 0；参数无效或同步失败返回 -1。
+ */
+int journal_set_batch(ParkingJournal *journal, unsigned long max_records,
+                      unsigned int window_seconds, JournalDurableFn on_durable,
+                      void *ctx);
+
+/** @} */
+
+/** @name 记录读写 */
+/** @{ */
+
+/**
+ * @brief 编码一条记录并追加到日志末尾。
+ * @details 记录进入当前批次；批次达到记录数或时间窗口时随即同步。
+ *          写入或同步失败时置位 error。
+ * @param journal 目标日志。
+ * @param record 要追加的记录。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int journal_append(ParkingJournal *journal, const JournalRecord *record);
+
+/**
+ * @brief 将当前批次 fflush 并 fsync 到磁盘，然后报告落盘的序号区间。
+ * @param journal 目标日志。
+ * @return 成功（含无待同步记录）返回 0，失败返回 -1。
+ */
+int journal_sync(ParkingJournal *journal);
+
+/**
+ * @brief 当前批次的时间窗口已到时执行同步。
+ * @param journal 目标日志。
+ * @param now 当前时间。
+ * @return 成功或无需同步返回 0，同步失败返回 -1。
+ */
+int journal_sync_if_due(ParkingJournal *journal, time_t now);
+
+/**
+ * @brief 开始一段批量操作：期间追加的记录不按批量策略同步。
+ * @details 可以嵌套，最外层 journal_end_deferred 时统一同步一次。
+ * @param journal 目标日志。
+ */
+void journal_begin_deferred(ParkingJournal *journal);
+
+/**
+ * @brief 结束一段批量操作，在最外层时同步期间追加的全部记录。
+ * @param journal 目标日志。
+ * @return 成功返回 0，同步失败返回 -1。
+ */
+int journal_end_deferred(ParkingJournal *journal);
+
+/**
+ * @brief 把一条记录编码为日志文件中的字节格式。
+ * @details 供复制等需要在文件之外传输记录的模块使用。
+ * @param record 要编码的记录。
+ * @param buffer 目标缓冲区（至少 JOURNAL_MAX_RECORD_SIZE 字节）。
+ * @return 编码后的字节数。
+ */
+size_t journal_encode_record(const JournalRecord *record,
+                             unsigned char *buffer);
+
+/**
+ * @brief 从字节序列开头解码一条记录并校验。
+ * @param data 记录的起始位置。
+ * @param size 可用的字节数。
+ * @param[out] record 解码结果。
+ * @return 成功返回消耗的字节数；数据不足一条记录返回 0；
+ *         校验失败或格式错误返回 -1。
+ */
+long journal_decode_record(const unsigned char *data, size_t size,
+                           JournalRecord *record);
+
+/**
+ * @brief 顺序读取日志文件并对每条有效记录调用回调。
+ * @param path 日志文件路径。
+ * @param replay 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 成功重放的记录数；文件不存在时返回 0，文件头无效时返回 -1。
+ */
+long journal_replay(const char *path, JournalReplayFn replay, void *ctx);
+
+/** @} */
+
+#endif /* PARKING_JOURNAL_H */
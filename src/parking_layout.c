@@ -0,0 +1,519 @@
+/**
+ * @file parking_layout.c
+ * @brief 车位平面布局与最近空闲车位空间索引实现文件
+ * @details
+ * 该文件实现了 parking_layout.h 中声明的坐标哈希表、地标表，
+ * 以及记录子树空闲车位数的隐式 k-d 树。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_layout.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define LAYOUT_LOAD_NUM 7  /**< 坐标哈希表最大负载因子分子（7/10） */
+#define LAYOUT_LOAD_DEN 10 /**< 坐标哈希表最大负载因子分母 */
+
+/**
+ * @brief 一次最近邻搜索的状态。
+ */
+typedef struct {
+  const LayoutNode *nodes; /**< k-d 树。 */
+  double x;                /**< 查询点横坐标。 */
+  double y;                /**< 查询点纵坐标。 */
+  LayoutAcceptFn accept;   /**< 对候选车位的额外判断，可以为 NULL。 */
+  void *ctx;               /**< 透传给 accept 的上下文指针。 */
+  double best;             /**< 当前最优解距离的平方。 */
+  int best_id;             /**< 当前最优解的车位编号。 */
+  int found;               /**< 是否已有最优解。 */
+} NearestSearch;
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 计算车位编号的哈希值。
+ * @details 与车位编号索引相同，使用 MurmurHash3 的 32 位最终混合函数。
+ * @param slot_id 车位编号。
+ * @return 32 位哈希值。
+ */
+static unsigned long hash_slot(int slot_id) {
+  unsigned long h = (unsigned long)(unsigned int)slot_id & 0xFFFFFFFFUL;
+
+  h ^= h >> 16;
+  h = (h * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+  h ^= h >> 13;
+  h = (h * 0xC2B2AE35UL) & 0xFFFFFFFFUL;
+  h ^= h >> 16;
+  return h;
+}
+
+/**
+ * @brief (静态辅助函数) 在坐标哈希表中查找车位的槽位。
+ * @param points 哈希表。
+ * @param capacity 哈希表容量（2 的幂，大于 0）。
+ * @param slot_id 车位编号。
+ * @return 该车位的槽位；车位不在表中时返回探测到的第一个空槽位。
+ */
+static LayoutPoint *probe_point(LayoutPoint *points, size_t capacity,
+                                int slot_id) {
+  size_t mask = capacity - 1;
+  size_t i = (size_t)hash_slot(slot_id) & mask;
+
+  while (points[i].in_use && points[i].slot_id != slot_id) {
+    i = (i + 1) & mask;
+  }
+  return &points[i];
+}
+
+/**
+ * @brief (静态辅助函数) 查找车位在哈希表中的槽位。
+ * @param layout 布局。
+ * @param slot_id 车位编号。
+ * @return 该车位的槽位，从未登记过坐标时返回 NULL。
+ */
+static LayoutPoint *find_point(const ParkingLayout *layout, int slot_id) {
+  LayoutPoint *point = probe_point(layout->points, layout->point_capacity,
+                                   slot_id);
+
+  return point->in_use ? point : NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 将坐标哈希表扩容到指定容量并重新散列。
+ * @param layout 布局。
+ * @param capacity 新容量，必须为 2 的幂。
+ * @return 成功返回 0，内存不足返回 -1（此时原哈希表保持不变）。
+ */
+static int grow_points(ParkingLayout *layout, size_t capacity) {
+  LayoutPoint *points;
+  size_t i;
+
+  points = (LayoutPoint *)parking_memory_calloc(
+      layout->memory, PARKING_MEMORY_INDEX, capacity, sizeof(LayoutPoint));
+  if (points == NULL) {
+    return -1;
+  }
+  for (i = 0; i < layout->point_capacity; i++) {
+    if (layout->points[i].in_use) {
+      *probe_point(points, capacity, layout->points[i].slot_id) =
+          layout->points[i];
+    }
+  }
+  parking_memory_free(layout->memory, layout->points);
+  layout->points = points;
+  layout->point_capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 按横坐标比较两个结点，坐标相同时依次比较纵坐标与编号。
+ * @param a 第一个结点。
+ * @param b 第二个结点。
+ * @return 小于、等于或大于时分别返回负数、0 或正数。
+ */
+static int compare_by_x(const void *a, const void *b) {
+  const LayoutNode *left = (const LayoutNode *)a;
+  const LayoutNode *right = (const LayoutNode *)b;
+
+  if (left->x != right->x) {
+    return left->x < right->x ? -1 : 1;
+  }
+  if (left->y != right->y) {
+    return left->y < right->y ? -1 : 1;
+  }
+  return left->slot_id < right->slot_id ? -1 : left->slot_id > right->slot_id;
+}
+
+/**
+ * @brief (静态辅助函数) 按纵坐标比较两个结点，坐标相同时依次比较横坐标与编号。
+ * @param a 第一个结点。
+ * @param b 第二个结点。
+ * @return 小于、等于或大于时分别返回负数、0 或正数。
+ */
+static int compare_by_y(const void *a, const void *b) {
+  const LayoutNode *left = (const LayoutNode *)a;
+  const LayoutNode *right = (const LayoutNode *)b;
+
+  if (left->y != right->y) {
+    return left->y < right->y ? -1 : 1;
+  }
+  if (left->x != right->x) {
+    return left->x < right->x ? -1 : 1;
+  }
+  return left->slot_id < right->slot_id ? -1 : left->slot_id > right->slot_id;
+}
+
+/**
+ * @brief (静态辅助函数) 递归地把区间 [lo, hi) 组织成 k-d 子树。
+ * @details 偶数层按横坐标、奇数层按纵坐标切分，中点即子树的根。
+ * @param nodes 结点数组。
+ * @param lo 区间起点。
+ * @param hi 区间终点（不含）。
+ * @param depth 子树根所在的层数。
+ * @return 子树中的空闲车位数。
+ */
+static int build_subtree(LayoutNode *nodes, int lo, int hi, int depth) {
+  int mid;
+  int free_count;
+
+  if (lo >= hi) {
+    return 0;
+  }
+  qsort(&nodes[lo], (size_t)(hi - lo), sizeof(LayoutNode),
+        depth % 2 == 0 ? compare_by_x : compare_by_y);
+  mid = lo + (hi - lo) / 2;
+  free_count = build_subtree(nodes, lo, mid, depth + 1) +
+               build_subtree(nodes, mid + 1, hi, depth + 1);
+  nodes[mid].free_count = free_count + nodes[mid].is_free;
+  return nodes[mid].free_count;
+}
+
+/**
+ * @brief (静态辅助函数) 在区间 [lo, hi) 表示的子树中搜索最近的空闲车位。
+ * @details 先搜索查询点所在的一侧；另一侧只有在切分面距离不超过
+ *          当前最优解时才需要搜索。
+ * @param search 搜索状态。
+ * @param lo 区间起点。
+ * @param hi 区间终点（不含）。
+ * @param depth 子树根所在的层数。
+ */
+static void search_subtree(NearestSearch *search, int lo, int hi, int depth) {
+  const LayoutNode *node;
+  double diff;
+  int mid;
+
+  if (lo >= hi) {
+    return;
+  }
+  mid = lo + (hi - lo) / 2;
+  node = &search->nodes[mid];
+  if (node->free_count == 0) {
+    return; /* 整棵子树都没有空闲车位 */
+  }
+
+  if (node->is_free &&
+      (search->accept == NULL || search->accept(node->slot_id, search->ctx))) {
+    double dx = (double)node->x - search->x;
+    double dy = (double)node->y - search->y;
+    double distance = dx * dx + dy * dy;
+
+    if (!search->found || distance < search->best ||
+        (distance == search->best && node->slot_id < search->best_id)) {
+      search->best = distance;
+      search->best_id = node->slot_id;
+      search->found = 1;
+    }
+  }
+
+  diff = depth % 2 == 0 ? search->x - (double)node->x
+                        : search->y - (double)node->y;
+  if (diff < 0) {
+    search_subtree(search, lo, mid, depth + 1);
+    if (!search->found || diff * diff <= search->best) {
+      search_subtree(search, mid + 1, hi, depth + 1);
+    }
+  } else {
+    search_subtree(search, mid + 1, hi, depth + 1);
+    if (!search->found || diff * diff <= search->best) {
+      search_subtree(search, lo, mid, depth + 1);
+    }
+  }
+}
+
+/* ========================================================================== */
+/*                                 布局API实现                                */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个空的布局。
+ * @param memory 布局的分配来源，NULL 表示 C 堆。
+ * @return 成功返回布局，内存不足返回 NULL。
+ */
+ParkingLayout *layout_create(ParkingMemory *memory) {
+  ParkingLayout *layout;
+
+  layout = (ParkingLayout *)parking_memory_calloc(memory, PARKING_MEMORY_INDEX,
+                                                  1, sizeof(ParkingLayout));
+  if (layout == NULL) {
+    return NULL;
+  }
+  layout->memory = memory;
+  if (grow_points(layout, LAYOUT_INITIAL_POINTS) != 0) {
+    parking_memory_free(memory, layout);
+    return NULL;
+  }
+  return layout;
+}
+
+/**
+ * @brief 释放布局。
+ * @param layout 要释放的布局，可以为 NULL。
+ */
+void layout_free(ParkingLayout *layout) {
+  if (layout == NULL) {
+    return;
+  }
+  parking_memory_free(layout->memory, layout->points);
+  parking_memory_free(layout->memory, layout->nodes);
+  parking_memory_free(layout->memory, layout->landmarks);
+  parking_memory_free(layout->memory, layout);
+}
+
+/**
+ * @brief 登记或修改车位的坐标，并将索引标记为过期。
+ * @param layout 目标布局。
+ * @param slot_id 车位编号。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+int layout_set_point(ParkingLayout *layout, int slot_id, long x, long y) {
+  LayoutPoint *point = find_point(layout, slot_id);
+
+  if (point == NULL) {
+    if ((layout->point_count + 1) * LAYOUT_LOAD_DEN >
+            layout->point_capacity * LAYOUT_LOAD_NUM &&
+        grow_points(layout, layout->point_capacity * 2) != 0) {
+      return -1;
+    }
+    point = probe_point(layout->points, layout->point_capacity, slot_id);
+    point->in_use = 1;
+    point->slot_id = slot_id;
+    point->node = -1;
+    layout->point_count++;
+  }
+  point->placed = 1;
+  point->x = x;
+  point->y = y;
+  layout->stale = 1;
+  return 0;
+}
+
+/**
+ * @brief 清除车位的坐标，并将索引标记为过期。
+ * @details 槽位保留在哈希表中，车位之后重新登记坐标时复用。
+ * @param layout 目标布局。
+ * @param slot_id 车位编号。
+ * @return 清除了坐标返回 0，车位本没有坐标返回 -1。
+ */
+int layout_clear_point(ParkingLayout *layout, int slot_id) {
+  LayoutPoint *point = find_point(layout, slot_id);
+
+  if (point == NULL || !point->placed) {
+    return -1;
+  }
+  point->placed = 0;
+  layout->stale = 1;
+  return 0;
+}
+
+/**
+ * @brief 读取车位的坐标。
+ * @param layout 目标布局。
+ * @param slot_id 车位编号。
+ * @param[out] x 接收横坐标。
+ * @param[out] y 接收纵坐标。
+ * @return 成功返回 0，车位没有坐标返回 -1。
+ */
+int layout_get_point(const ParkingLayout *layout, int slot_id, long *x,
+                     long *y) {
+  const LayoutPoint *point = find_point(layout, slot_id);
+
+  if (point == NULL || !point->placed) {
+    return -1;
+  }
+  *x = point->x;
+  *y = point->y;
+  return 0;
+}
+
+/**
+ * @brief 按当前坐标与车位状态重建 k-d 树。
+ * @param layout 目标布局。
+ * @param lot 布局所属的停车场。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+int layout_rebuild(ParkingLayout *layout, ParkingLot *lot) {
+  LayoutNode *nodes = NULL;
+  int count = 0;
+  size_t i;
+
+  if (layout->point_count > 0) {
+    nodes = (LayoutNode *)parking_memory_alloc(
+        layout->memory, PARKING_MEMORY_INDEX,
+        layout->point_count * sizeof(LayoutNode));
+    if (nodes == NULL) {
+      return -1;
+    }
+  }
+
+  for (i = 0; i < layout->point_capacity; i++) {
+    LayoutPoint *point = &layout->points[i];
+    ParkingSlot *slot;
+
+    point->node = -1;
+    if (!point->placed) {
+      continue;
+    }
+    slot = find_slot_by_id(lot, point->slot_id);
+    if (slot == NULL) {
+      continue; /* 车位已被删除 */
+    }
+    nodes[count].slot_id = point->slot_id;
+    nodes[count].x = point->x;
+    nodes[count].y = point->y;
+    nodes[count].is_free = slot->status == FREE_STATUS;
+    nodes[count].free_count = 0;
+    count++;
+  }
+  build_subtree(nodes, 0, count, 0);
+
+  /* 排序打乱了结点顺序，重新记录每个车位所在的下标 */
+  for (i = 0; i < (size_t)count; i++) {
+    find_point(layout, nodes[i].slot_id)->node = (int)i;
+  }
+  parking_memory_free(layout->memory, layout->nodes);
+  layout->nodes = nodes;
+  layout->node_count = count;
+  layout->stale = 0;
+  return 0;
+}
+
+/**
+ * @brief 更新树中车位的空闲状态。
+ * @details 从根出发按下标二分走到该结点，沿途调整子树的空闲车位数。
+ * @param layout 目标布局。
+ * @param slot_id 车位编号。
+ * @param is_free 车位是否空闲。
+ */
+void layout_mark_free(ParkingLayout *layout, int slot_id, int is_free) {
+  const LayoutPoint *point;
+  int delta;
+  int lo = 0;
+  int hi;
+
+  if (layout->stale) {
+    return;
+  }
+  point = find_point(layout, slot_id);
+  if (point == NULL || point->node < 0 ||
+      layout->nodes[point->node].is_free == (is_free != 0)) {
+    return;
+  }
+
+  layout->nodes[point->node].is_free = is_free != 0;
+  delta = is_free ? 1 : -1;
+  hi = layout->node_count;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+
+    layout->nodes[mid].free_count += delta;
+    if (point->node == mid) {
+      break;
+    }
+    if (point->node < mid) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+}
+
+/**
+ * @brief 查找离某一点最近的空闲车位。
+ * @param layout 目标布局，索引必须未过期。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @param accept 对候选车位的额外判断，可以为 NULL。
+ * @param ctx 透传给 accept 的上下文指针。
+ * @param[out] slot_id 接收最近空闲车位的编号。
+ * @return 找到返回 0，没有空闲车位返回 -1。
+ */
+int layout_nearest_free(const ParkingLayout *layout, long x, long y,
+                        LayoutAcceptFn accept, void *ctx, int *slot_id) {
+  NearestSearch search;
+
+  search.nodes = layout->nodes;
+  search.x = (double)x;
+  search.y = (double)y;
+  search.accept = accept;
+  search.ctx = ctx;
+  search.best = 0.0;
+  search.best_id = 0;
+  search.found = 0;
+  search_subtree(&search, 0, layout->node_count, 0);
+  if (!search.found) {
+    return -1;
+  }
+  *slot_id = search.best_id;
+  return 0;
+}
+
+/**
+ * @brief 登记或修改一个地标。
+ * @param layout 目标布局。
+ * @param name 地标名称。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 成功返回 0，名称无效返回 -1，内存不足返回 -2。
+ */
+int layout_set_landmark(ParkingLayout *layout, const char *name, long x,
+                        long y) {
+  ParkingLandmark *landmark;
+  size_t length;
+
+  if (name == NULL) {
+    return -1;
+  }
+  length = strlen(name);
+  if (length == 0 || length >= LAYOUT_MAX_LANDMARK_NAME) {
+    return -1;
+  }
+
+  landmark = (ParkingLandmark *)layout_find_landmark(layout, name);
+  if (landmark == NULL) {
+    if (layout->landmark_count == layout->landmark_capacity) {
+      int capacity =
+          layout->landmark_capacity > 0 ? layout->landmark_capacity * 2 : 4;
+      ParkingLandmark *landmarks = (ParkingLandmark *)parking_memory_realloc(
+          layout->memory, PARKING_MEMORY_INDEX, layout->landmarks,
+          (size_t)capacity * sizeof(ParkingLandmark));
+
+      if (landmarks == NULL) {
+        return -2;
+      }
+      layout->landmarks = landmarks;
+      layout->landmark_capacity = capacity;
+    }
+    landmark = &layout->landmarks[layout->landmark_count++];
+    memcpy(landmark->name, name, length + 1);
+  }
+  landmark->x = x;
+  landmark->y = y;
+  return 0;
+}
+
+/**
+ * @brief 查找地标。
+ * @details 地标通常只有几个到几十个，按顺序比较名称。
+ * @param layout 目标布局。
+ * @param name 地标名称。
+ * @return 找到返回地标，否则返回 NULL。
+ */
+const ParkingLandmark *layout_find_landmark(const ParkingLayout *layout,
+                                            const char *name) {
+  int i;
+
+  for (i = 0; i < layout->landmark_count; i++) {
+    if (strcmp(layout->landmarks[i].name, name) == 0) {
+      return &layout->landmarks[i];
+    }
+  }
+  return NULL;
+}
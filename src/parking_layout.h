@@ -0,0 +1,199 @@
+#ifndef PARKING_LAYOUT_H
+#define PARKING_LAYOUT_H
+
+#include <stddef.h>
+
+#include "parking_data.h"
+#include "parking_memory.h"
+
+/**
+ * @file parking_layout.h
+ * @brief 车位平面布局与最近空闲车位空间索引的结构与接口声明。
+ * @details
+ * 车位的 location 只是一段文本（如 "A-01"），没有空间含义。布局为车位
+ * 另外登记平面坐标（单位由使用者约定，例如分米），并可登记入口、电梯等
+ * 命名地标，供引导屏查找离某一点最近的空闲车位。
+ *
+ * 空间索引是按坐标交替切分的平衡 k-d 树，以隐式方式存放在数组中：
+ * 区间 [lo, hi) 的根是中点 mid，左右子树分别是 [lo, mid) 与 (mid, hi)。
+ * 每个结点记录子树中的空闲车位数，入场出场时沿根到该结点的路径调整，
+ * 代价为 O(log n)；最近邻搜索跳过没有空闲车位的子树，也跳过
+ * 切分面比当前最优解更远的一侧，通常只访问对数个结点。
+ *
+ * 登记或清除坐标后索引标记为过期，在下一次查询前整体重建。
+ * 布局只保存在内存中，不写入快照与预写日志，通常在启动时由配置登记。
+ * 布局本身不加锁，由停车场的锁保护。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define LAYOUT_INITIAL_POINTS 16    /**< 坐标哈希表的初始容量（2 的幂） */
+#define LAYOUT_MAX_LANDMARK_NAME 32 /**< 地标名称的最大长度（含结尾的 '\0'） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 坐标哈希表中一个车位的坐标。
+ */
+typedef struct LayoutPoint {
+  int in_use;  /**< 该槽位是否已被某个车位使用。 */
+  int placed;  /**< 车位当前是否登记了坐标。 */
+  int slot_id; /**< 车位编号。 */
+  long x;      /**< 横坐标。 */
+  long y;      /**< 纵坐标。 */
+  int node;    /**< 在 k-d 树数组中的下标，不在树中时为 -1。 */
+} LayoutPoint;
+
+/**
+ * @brief k-d 树的一个结点（即一个车位）。
+ */
+typedef struct LayoutNode {
+  int slot_id;    /**< 车位编号。 */
+  long x;         /**< 横坐标。 */
+  long y;         /**< 纵坐标。 */
+  int is_free;    /**< 车位是否空闲。 */
+  int free_count; /**< 以该结点为根的子树中的空闲车位数。 */
+} LayoutNode;
+
+/**
+ * @brief 一个命名地标（入口、电梯等）。
+ */
+typedef struct ParkingLandmark {
+  char name[LAYOUT_MAX_LANDMARK_NAME]; /**< 地标名称。 */
+  long x;                              /**< 横坐标。 */
+  long y;                              /**< 纵坐标。 */
+} ParkingLandmark;
+
+/**
+ * @brief 判断候选车位是否可以作为结果的回调函数。
+ * @param slot_id 候选的空闲车位编号。
+ * @param ctx 调用者传入的上下文指针。
+ * @return 可以作为结果返回非 0，否则返回 0。
+ */
+typedef int (*LayoutAcceptFn)(int slot_id, void *ctx);
+
+/**
+ * @brief 停车场的平面布局。
+ */
+typedef struct ParkingLayout {
+  LayoutPoint *points;         /**< 以车位编号为键的开放寻址哈希表。 */
+  size_t point_capacity;       /**< 哈希表容量（2 的幂）。 */
+  size_t point_count;          /**< 已使用的槽位数。 */
+  LayoutNode *nodes;           /**< 隐式 k-d 树。 */
+  int node_count;              /**< 树中的结点数。 */
+  int stale;                   /**< 坐标有变化、树尚未重建时为 1。 */
+  ParkingLandmark *landmarks;  /**< 地标数组。 */
+  int landmark_count;          /**< 地标数。 */
+  int landmark_capacity;       /**< 地标数组已分配的容量。 */
+  ParkingMemory *memory;       /**< 分配来源，NULL 表示 C 堆。 */
+} ParkingLayout;
+
+/**
+ *********************************************************************************
+ *                                布局API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个空的布局。
+ * @param memory 布局的分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @return 成功返回布局，内存不足返回 NULL。
+ */
+ParkingLayout *layout_create(ParkingMemory *memory);
+
+/**
+ * @brief 释放布局。
+ * @param layout 要释放的布局，可以为 NULL。
+ */
+void layout_free(ParkingLayout *layout);
+
+/**
+ * @brief 登记或修改车位的坐标，并将索引标记为过期。
+ * @param layout 目标布局。
+ * @param slot_id 车位编号。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+int layout_set_point(ParkingLayout *layout, int slot_id, long x, long y);
+
+/**
+ * @brief 清除车位的坐标，并将索引标记为过期。
+ * @param layout 目标布局。
+ * @param slot_id 车位编号。
+ * @return 清除了坐标返回 0，车位本没有坐标返回 -1。
+ */
+int layout_clear_point(ParkingLayout *layout, int slot_id);
+
+/**
+ * @brief 读取车位的坐标。
+ * @param layout 目标布局。
+ * @param slot_id 车位编号。
+ * @param[out] x 接收横坐标。
+ * @param[out] y 接收纵坐标。
+ * @return 成功返回 0，车位没有坐标返回 -1。
+ */
+int layout_get_point(const ParkingLayout *layout, int slot_id, long *x,
+                     long *y);
+
+/**
+ * @brief 按当前坐标与车位状态重建 k-d 树。
+ * @details 登记了坐标但已不在停车场中的车位不进入树。
+ * @param layout 目标布局。
+ * @param lot 布局所属的停车场，用于读取车位状态。
+ * @return 成功返回 0，内存不足返回 -1（此时索引仍为过期）。
+ */
+int layout_rebuild(ParkingLayout *layout, ParkingLot *lot);
+
+/**
+ * @brief 更新树中车位的空闲状态。
+ * @details 索引过期或车位不在树中时什么也不做（重建时会重新读取状态）。
+ * @param layout 目标布局。
+ * @param slot_id 车位编号。
+ * @param is_free 车位是否空闲。
+ */
+void layout_mark_free(ParkingLayout *layout, int slot_id, int is_free);
+
+/**
+ * @brief 查找离某一点最近的空闲车位。
+ * @details 距离为欧氏距离，距离相同时取编号较小的车位。索引必须未过期。
+ * @param layout 目标布局。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @param accept 对候选车位的额外判断，NULL 表示接受全部空闲车位。
+ * @param ctx 透传给 accept 的上下文指针。
+ * @param[out] slot_id 接收最近空闲车位的编号。
+ * @return 找到返回 0，没有空闲车位返回 -1。
+ */
+int layout_nearest_free(const ParkingLayout *layout, long x, long y,
+                        LayoutAcceptFn accept, void *ctx, int *slot_id);
+
+/**
+ * @brief 登记或修改一个地标。
+ * @param layout 目标布局。
+ * @param name 地标名称，长度须小于 LAYOUT_MAX_LANDMARK_NAME。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 成功返回 0，名称无效返回 -1，内存不足返回 -2。
+ */
+int layout_set_landmark(ParkingLayout *layout, const char *name, long x,
+                        long y);
+
+/**
+ * @brief 查找地标。
+ * @param layout 目标布局。
+ * @param name 地标名称。
+ * @return 找到返回地标，否则返回 NULL。
+ */
+const ParkingLandmark *layout_find_landmark(const ParkingLayout *layout,
+                                            const char *name);
+
+#endif /* PARKING_LAYOUT_H */
@@ -0,0 +1,394 @@
+/**
+ * @file parking_ledger.c
+ * @brief 追加式收费台账实现文件
+ * @details
+ * 该文件实现了 parking_ledger.h 中声明的台账文件读写与月表维护。
+ * 金额按分以整数累计，避免浮点误差随记录数增长。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_calendar.h"
+#include "parking_codec.h"
+#include "parking_ledger.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define LEDGER_OFF_PAID_AT 0   /**< 记录中出场时间的偏移 */
+#define LEDGER_OFF_AMOUNT 8    /**< 记录中金额的偏移 */
+#define LEDGER_OFF_SLOT 12     /**< 记录中车位编号的偏移 */
+#define LEDGER_OFF_TYPE 16     /**< 记录中停车类型的偏移 */
+#define LEDGER_OFF_CHECKSUM 20 /**< 记录中校验和的偏移 */
+#define LEDGER_BATCH_RECORDS 64 /**< 批量追加时每次编码、写入的记录数 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 计算年月对应的月序号。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @return 月序号（年 * 12 + 月 - 1）。
+ */
+static long month_ordinal(int year, int month) {
+  return (long)year * 12 + (month - 1);
+}
+
+/**
+ * @brief (静态辅助函数) 计算某一时刻所在本地月份的月序号。
+ * @param when 时间戳。
+ * @return 月序号。
+ */
+static long month_ordinal_of(time_t when) {
+  long key;
+
+  parking_calendar_convert(when, NULL, &key);
+  return month_ordinal((int)(key / 100), (int)(key % 100));
+}
+
+/**
+ * @brief (静态辅助函数) 确保月表能容纳指定的月数。
+ * @param ledger 目标台账。
+ * @param count 需要的月数。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int months_reserve(PaymentLedger *ledger, int count) {
+  LedgerMonth *months;
+  int capacity = ledger->month_capacity ? ledger->month_capacity : 16;
+
+  if (count <= ledger->month_capacity) {
+    return 0;
+  }
+  while (capacity < count) {
+    capacity *= 2;
+  }
+  months = (LedgerMonth *)realloc(ledger->months,
+                                  (size_t)capacity * sizeof(LedgerMonth));
+  if (months == NULL) {
+    return -1;
+  }
+  ledger->months = months;
+  ledger->month_capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 把一笔金额计入月表。
+ * @details 月份落在月表之外时向前或向后补齐空月；
+ *          之后更新该月及其后各月的前缀和，计入当月时只更新最后一项。
+ * @param ledger 目标台账。
+ * @param ordinal 月序号。
+ * @param type 停车类型。
+ * @param cents 金额（分）。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int months_account(PaymentLedger *ledger, long ordinal, int type,
+                          long cents) {
+  int category = type == VISITOR_TYPE ? 1 : 0;
+  int pos;
+  int i;
+
+  if (ledger->month_count == 0) {
+    if (months_reserve(ledger, 1) != 0) {
+      return -1;
+    }
+    memset(&ledger->months[0], 0, sizeof(LedgerMonth));
+    ledger->first_month = ordinal;
+    ledger->month_count = 1;
+  } else if (ordinal < ledger->first_month) {
+    int shift = (int)(ledger->first_month - ordinal);
+
+    if (months_reserve(ledger, ledger->month_count + shift) != 0) {
+      return -1;
+    }
+    memmove(&ledger->months[shift], &ledger->months[0],
+            (size_t)ledger->month_count * sizeof(LedgerMonth));
+    memset(&ledger->months[0], 0, (size_t)shift * sizeof(LedgerMonth));
+    ledger->first_month = ordinal;
+    ledger->month_count += shift;
+  } else if (ordinal >= ledger->first_month + ledger->month_count) {
+    int needed = (int)(ordinal - ledger->first_month) + 1;
+    long carried = ledger->months[ledger->month_count - 1].cumulative_cents;
+
+    if (months_reserve(ledger, needed) != 0) {
+      return -1;
+    }
+    for (i = ledger->month_count; i < needed; i++) {
+      memset(&ledger->months[i], 0, sizeof(LedgerMonth));
+      ledger->months[i].cumulative_cents = carried;
+    }
+    ledger->month_count = needed;
+  }
+
+  pos = (int)(ordinal - ledger->first_month);
+  ledger->months[pos].cents[category] += cents;
+  for (i = pos; i < ledger->month_count; i++) {
+    ledger->months[i].cumulative_cents += cents;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 编码一条记录。
+ * @param buffer 目标缓冲区（LEDGER_RECORD_SIZE 字节）。
+ * @param record 要编码的记录。
+ */
+static void encode_record(unsigned char *buffer, const PaymentRecord *record) {
+  codec_put_time(buffer + LEDGER_OFF_PAID_AT, record->paid_at);
+  codec_put_i32(buffer + LEDGER_OFF_AMOUNT, (int)record->amount_cents);
+  codec_put_i32(buffer + LEDGER_OFF_SLOT, record->slot_id);
+  codec_put_i32(buffer + LEDGER_OFF_TYPE, (int)record->type);
+  codec_put_u32(buffer + LEDGER_OFF_CHECKSUM,
+                codec_checksum(buffer, LEDGER_OFF_CHECKSUM));
+}
+
+/**
+ * @brief (静态辅助函数) 校验并解码一条记录。
+ * @param buffer 源缓冲区（LEDGER_RECORD_SIZE 字节）。
+ * @param[out] record 解码结果。
+ * @return 校验通过返回 0，否则返回 -1。
+ */
+static int decode_record(const unsigned char *buffer, PaymentRecord *record) {
+  if (codec_get_u32(buffer + LEDGER_OFF_CHECKSUM) !=
+      codec_checksum(buffer, LEDGER_OFF_CHECKSUM)) {
+    return -1;
+  }
+  record->paid_at = codec_get_time(buffer + LEDGER_OFF_PAID_AT);
+  record->amount_cents = codec_get_i32(buffer + LEDGER_OFF_AMOUNT);
+  record->slot_id = codec_get_i32(buffer + LEDGER_OFF_SLOT);
+  record->type = (ParkingType)codec_get_i32(buffer + LEDGER_OFF_TYPE);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 顺序读取台账文件中的有效记录并计入月表。
+ * @param ledger 目标台账，file 已以读写方式打开并位于文件开头。
+ * @return 成功返回 0（文件位置停在最后一条有效记录之后）；
+ * 不是有效台账或内存不足返回 -1。
+ */
+static int load_records(PaymentLedger *ledger) {
+  unsigned char buffer[LEDGER_RECORD_SIZE];
+  PaymentRecord record;
+  long valid_end = 8;
+
+  if (fread(buffer, 1, 8, ledger->file) != 8 ||
+      memcmp(buffer, LEDGER_MAGIC, 8) != 0) {
+    return -1;
+  }
+  while (fread(buffer, 1, LEDGER_RECORD_SIZE, ledger->file) ==
+             LEDGER_RECORD_SIZE &&
+         decode_record(buffer, &record) == 0) {
+    if (months_account(ledger, month_ordinal_of(record.paid_at), record.type,
+                       record.amount_cents) != 0) {
+      return -1;
+    }
+    ledger->record_count++;
+    valid_end += LEDGER_RECORD_SIZE;
+  }
+  /* 截断或损坏的尾部由之后的追加覆盖 */
+  return fseek(ledger->file, valid_end, SEEK_SET) == 0 ? 0 : -1;
+}
+
+/* ========================================================================== */
+/*                                 台账函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 打开（必要时创建）台账文件，并读取已有记录重建月表。
+ * @param path 台账文件路径。
+ * @return 成功返回新分配的台账对象，失败返回 NULL。
+ */
+PaymentLedger *ledger_open(const char *path) {
+  PaymentLedger *ledger;
+  size_t length;
+
+  if (path == NULL || (length = strlen(path)) >= LEDGER_MAX_PATH) {
+    return NULL;
+  }
+
+  ledger = (PaymentLedger *)calloc(1, sizeof(PaymentLedger));
+  if (ledger == NULL) {
+    return NULL;
+  }
+  memcpy(ledger->path, path, length + 1);
+
+  ledger->file = fopen(path, "r+b");
+  if (ledger->file == NULL) {
+    ledger->file = fopen(path, "w+b");
+    if (ledger->file == NULL ||
+        fwrite(LEDGER_MAGIC, 1, 8, ledger->file) != 8 ||
+        fflush(ledger->file) != 0 || fseek(ledger->file, 0, SEEK_SET) != 0) {
+      ledger_close(ledger);
+      return NULL;
+    }
+  }
+  if (load_records(ledger) != 0) {
+    ledger_close(ledger); /* 不是台账文件，拒绝覆盖 */
+    return NULL;
+  }
+  return ledger;
+}
+
+/**
+ * @brief 关闭台账文件并释放台账对象。
+ * @param ledger 要关闭的台账，可以为 NULL。
+ */
+void ledger_close(PaymentLedger *ledger) {
+  if (ledger == NULL) {
+    return;
+  }
+  if (ledger->file != NULL) {
+    fclose(ledger->file);
+  }
+  free(ledger->months);
+  free(ledger);
+}
+
+/**
+ * @brief 追加一笔收费记录并计入月表。
+ * @param ledger 目标台账。
+ * @param record 要追加的记录。
+ * @return 成功返回 0，参数无效返回 -1，写入失败返回 -2，内存不足返回 -3。
+ */
+int ledger_append(PaymentLedger *ledger, const PaymentRecord *record) {
+  unsigned char buffer[LEDGER_RECORD_SIZE];
+
+  if (ledger == NULL || record == NULL || record->amount_cents <= 0) {
+    return -1;
+  }
+  if (months_account(ledger, month_ordinal_of(record->paid_at), record->type,
+                     record->amount_cents) != 0) {
+    return -3;
+  }
+  ledger->record_count++;
+
+  encode_record(buffer, record);
+  if (fwrite(buffer, 1, LEDGER_RECORD_SIZE, ledger->file) !=
+          LEDGER_RECORD_SIZE ||
+      fflush(ledger->file) != 0) {
+    ledger->error = 1;
+    return -2;
+  }
+  return 0;
+}
+
+/**
+ * @brief 一次追加多笔收费记录并计入月表。
+ * @param ledger 目标台账。
+ * @param records 要追加的记录。
+ * @param count 记录数。
+ * @return 成功返回 0，参数无效返回 -1，写入失败返回 -2，内存不足返回 -3。
+ */
+int ledger_append_batch(PaymentLedger *ledger, const PaymentRecord *records,
+                        size_t count) {
+  unsigned char buffer[LEDGER_BATCH_RECORDS * LEDGER_RECORD_SIZE];
+  size_t done = 0;
+  size_t i;
+
+  if (ledger == NULL || (records == NULL && count > 0)) {
+    return -1;
+  }
+  for (i = 0; i < count; i++) {
+    if (records[i].amount_cents <= 0) {
+      return -1;
+    }
+  }
+
+  while (done < count) {
+    size_t chunk = count - done < LEDGER_BATCH_RECORDS ? count - done
+                                                        : LEDGER_BATCH_RECORDS;
+
+    for (i = 0; i < chunk; i++) {
+      const PaymentRecord *record = &records[done + i];
+
+      if (months_account(ledger, month_ordinal_of(record->paid_at),
+                         record->type, record->amount_cents) != 0) {
+        return -3;
+      }
+      ledger->record_count++;
+      encode_record(buffer + i * LEDGER_RECORD_SIZE, record);
+    }
+    if (fwrite(buffer, LEDGER_RECORD_SIZE, chunk, ledger->file) != chunk) {
+      ledger->error = 1;
+      return -2;
+    }
+    done += chunk;
+  }
+  if (count > 0 && fflush(ledger->file) != 0) {
+    ledger->error = 1;
+    return -2;
+  }
+  return 0;
+}
+
+/**
+ * @brief 查询某个月的收费总额。
+ * @param ledger 目标台账。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @param type 停车类型；传入 -1 表示所有类型。
+ * @return 该月的收费总额（分）。
+ */
+long ledger_month_total(const PaymentLedger *ledger, int year, int month,
+                        int type) {
+  long pos;
+  const LedgerMonth *entry;
+
+  if (ledger == NULL || month < 1 || month > 12) {
+    return 0;
+  }
+  pos = month_ordinal(year, month) - ledger->first_month;
+  if (pos < 0 || pos >= ledger->month_count) {
+    return 0;
+  }
+
+  entry = &ledger->months[pos];
+  if (type == RESIDENT_TYPE) {
+    return entry->cents[0];
+  }
+  if (type == VISITOR_TYPE) {
+    return entry->cents[1];
+  }
+  return entry->cents[0] + entry->cents[1];
+}
+
+/**
+ * @brief 查询一段连续月份（含两端）的收费总额。
+ * @param ledger 目标台账。
+ * @param from_year 起始年份。
+ * @param from_month 起始月份 (1-12)。
+ * @param to_year 结束年份。
+ * @param to_month 结束月份 (1-12)。
+ * @return 区间内的收费总额（分）。
+ */
+long ledger_range_total(const PaymentLedger *ledger, int from_year,
+                        int from_month, int to_year, int to_month) {
+  long first;
+  long last;
+  long before;
+
+  if (ledger == NULL || ledger->month_count == 0 || from_month < 1 ||
+      from_month > 12 || to_month < 1 || to_month > 12) {
+    return 0;
+  }
+
+  first = month_ordinal(from_year, from_month) - ledger->first_month;
+  last = month_ordinal(to_year, to_month) - ledger->first_month;
+  if (first < 0) {
+    first = 0;
+  }
+  if (last >= ledger->month_count) {
+    last = ledger->month_count - 1;
+  }
+  if (first > last) {
+    return 0;
+  }
+
+  before = first > 0 ? ledger->months[first - 1].cumulative_cents : 0;
+  return ledger->months[last].cumulative_cents - before;
+}
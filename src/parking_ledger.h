@@ -0,0 +1,141 @@
+#ifndef PARKING_LEDGER_H
+#define PARKING_LEDGER_H
+
+#include <stdio.h>
+#include <time.h>
+
+#include "parking_data.h"
+
+/**
+ * @file parking_ledger.h
+ * @brief 追加式收费台账的结构与接口声明。
+ * @details
+ * 每次出场产生费用时，服务层向台账追加一条定长记录（出场时间、金额、类型、车位），
+ * 同时在内存中按月累加金额并维护逐月前缀和。任意月份的总额、
+ * 任意月份区间的总额都可以直接由月表读出，无需重新扫描交易记录；
+ * 只有打开台账时顺序读取一次文件以重建月表。
+ *
+ * 台账文件格式：8 字节魔数 "PARKLED1"，随后是若干条 24 字节的记录，
+ * 每条记录末尾带 4 字节校验和。读取遇到截断或校验失败的记录即视为文件末尾，
+ * 之后的追加从该位置开始覆盖。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define LEDGER_MAGIC "PARKLED1"  /**< 台账文件开头的 8 字节魔数 */
+#define LEDGER_MAX_PATH 260      /**< 台账路径的最大长度 */
+#define LEDGER_RECORD_SIZE 24    /**< 每条记录的字节数（含校验和） */
+#define LEDGER_CATEGORIES 2      /**< 按停车类型分开累计的类别数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一笔收费记录。
+ */
+typedef struct PaymentRecord {
+  int slot_id;       /**< 出场的车位编号。 */
+  ParkingType type;  /**< 停车类型。 */
+  time_t paid_at;    /**< 收费（出场）时间。 */
+  long amount_cents; /**< 金额（分）。 */
+} PaymentRecord;
+
+/**
+ * @brief 月表中的一个月。
+ */
+typedef struct LedgerMonth {
+  long cents[LEDGER_CATEGORIES]; /**< 本月各停车类型的收费总额（分）。 */
+  long cumulative_cents; /**< 从台账第一个月到本月（含）的收费总额（分）。 */
+} LedgerMonth;
+
+/**
+ * @brief 一个已打开的收费台账。
+ * @details 月表按月份连续存放，第 i 项对应第 first_month + i 个月，
+ *          因此按年月定位是一次减法。
+ */
+typedef struct PaymentLedger {
+  FILE *file;                  /**< 用于追加记录的台账文件。 */
+  char path[LEDGER_MAX_PATH];  /**< 台账文件路径。 */
+  LedgerMonth *months;         /**< 月表。 */
+  int month_count;             /**< 月表中的月数。 */
+  int month_capacity;          /**< 月表已分配的容量。 */
+  long first_month;            /**< 月表第一项的月序号（年 * 12 + 月 - 1）。 */
+  unsigned long record_count;  /**< 台账中的记录数。 */
+  int error;                   /**< 最近一次写入失败后置 1。 */
+} PaymentLedger;
+
+/**
+ *********************************************************************************
+ *                            台账操作API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 打开（必要时创建）台账文件，并读取已有记录重建月表。
+ * @param path 台账文件路径。
+ * @return 成功返回新分配的台账对象；路径过长、文件无法打开、
+ * 不是有效台账或内存不足时返回 NULL。
+ */
+PaymentLedger *ledger_open(const char *path);
+
+/**
+ * @brief 关闭台账文件并释放台账对象。
+ * @param ledger 要关闭的台账，可以为 NULL。
+ */
+void ledger_close(PaymentLedger *ledger);
+
+/**
+ * @brief 追加一笔收费记录并计入月表。
+ * @details 记录写入后立即 fflush；写入失败时置位 error，月表仍然计入。
+ * @param ledger 目标台账。
+ * @param record 要追加的记录，金额必须为正。
+ * @return 成功返回 0，参数无效返回 -1，写入失败返回 -2，内存不足返回 -3。
+ */
+int ledger_append(PaymentLedger *ledger, const PaymentRecord *record);
+
+/**
+ * @brief 一次追加多笔收费记录并计入月表。
+ * @details 记录逐块编码后连续写入，全部写完只 fflush 一次，
+ *          适合月费批量结算一次产生大量记录的场合。
+ *          写入失败时置位 error，月表仍然计入。
+ * @param ledger 目标台账。
+ * @param records 要追加的记录，金额都必须为正。
+ * @param count 记录数。
+ * @return 成功返回 0；参数无效（含任一金额不为正）返回 -1，此时不追加
+ *         任何记录；写入失败返回 -2，内存不足返回 -3。
+ */
+int ledger_append_batch(PaymentLedger *ledger, const PaymentRecord *records,
+                        size_t count);
+
+/**
+ * @brief 查询某个月的收费总额。
+ * @param ledger 目标台账。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @param type 停车类型；传入 -1 表示所有类型。
+ * @return 该月的收费总额（分）；没有记录的月份返回 0。
+ */
+long ledger_month_total(const PaymentLedger *ledger, int year, int month,
+                        int type);
+
+/**
+ * @brief 查询一段连续月份（含两端）的收费总额。
+ * @details 由逐月前缀和相减得到。
+ * @param ledger 目标台账。
+ * @param from_year 起始年份。
+ * @param from_month 起始月份 (1-12)。
+ * @param to_year 结束年份。
+ * @param to_month 结束月份 (1-12)。
+ * @return 区间内的收费总额（分）；区间无效时返回 0。
+ */
+long ledger_range_total(const PaymentLedger *ledger, int from_year,
+                        int from_month, int to_year, int to_month);
+
+#endif /* PARKING_LEDGER_H */
@@ -0,0 +1,286 @@
+/**
+ * @file parking_lot_hub.c
+ * @brief 停车场发布点实现文件
+ * @details
+ * 该文件实现了 parking_lot_hub.h 中声明的停车场替换与纪元回收。
+ * 读者只对自己的读者槽做原子写，对纪元与当前停车场指针做原子读；
+ * 替换、领取读者槽与摘取待回收的停车场在发布点的自旋锁内进行，
+ * 释放停车场（要停止它的后台线程）在锁外进行。
+ */
+
+#include <stdlib.h>
+
+#include "parking_lot_hub.h"
+#include "parking_thread.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 获取发布点的自旋锁。
+ * @param hub 目标发布点。
+ */
+static void hub_lock(LotHub *hub) {
+  while (parking_atomic_exchange_int(&hub->lock, 1) != 0) {
+    while (parking_atomic_load_int(&hub->lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放发布点的自旋锁。
+ * @param hub 目标发布点。
+ */
+static void hub_unlock(LotHub *hub) {
+  parking_atomic_store_int(&hub->lock, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 求所有钉住的纪元中最早的一个。
+ * @param hub 目标发布点（调用者持有自旋锁）。
+ * @return 最早的纪元；没有读者钉住时返回当前纪元。
+ */
+static long oldest_pin(LotHub *hub) {
+  long oldest = parking_atomic_load_long(&hub->epoch);
+  int i;
+
+  for (i = 0; i < LOT_HUB_MAX_READERS; i++) {
+    long pin;
+
+    if (!hub->attached[i]) {
+      continue;
+    }
+    pin = parking_atomic_load_long(&hub->pins[i]);
+    if (pin != 0 && pin < oldest) {
+      oldest = pin;
+    }
+  }
+  return oldest;
+}
+
+/**
+ * @brief (静态辅助函数) 从待回收链表摘下宽限期已过的停车场。
+ * @param hub 目标发布点（调用者持有自旋锁）。
+ * @return 摘下的链表，由调用者在锁外释放。
+ */
+static RetiredLot *take_expired_locked(LotHub *hub) {
+  long oldest = oldest_pin(hub);
+  RetiredLot **link = &hub->retired;
+  RetiredLot *expired = NULL;
+
+  while (*link != NULL) {
+    RetiredLot *entry = *link;
+
+    /* 钉住的纪元都晚于退役纪元时，不会再有读者持有该停车场 */
+    if (entry->retired_epoch < oldest) {
+      *link = entry->next;
+      entry->next = expired;
+      expired = entry;
+      hub->reclaimed++;
+    } else {
+      link = &entry->next;
+    }
+  }
+  return expired;
+}
+
+/**
+ * @brief (静态辅助函数) 释放一串退役的停车场。
+ * @param entry 链表头，可以为 NULL。
+ * @return 释放的停车场数。
+ */
+static int free_retired(RetiredLot *entry) {
+  int count = 0;
+
+  while (entry != NULL) {
+    RetiredLot *next = entry->next;
+
+    free_parking_lot(entry->lot);
+    free(entry);
+    entry = next;
+    count++;
+  }
+  return count;
+}
+
+/* ========================================================================== */
+/*                              停车场发布点API实现                           */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个发布点。
+ * @param lot 初始的当前停车场，可以为 NULL。
+ * @return 成功返回发布点，内存不足返回 NULL。
+ */
+LotHub *lot_hub_create(ParkingLot *lot) {
+  LotHub *hub = (LotHub *)calloc(1, sizeof(LotHub));
+
+  if (hub == NULL) {
+    return NULL;
+  }
+  hub->current = lot;
+  hub->epoch = 1;
+  return hub;
+}
+
+/**
+ * @brief 释放发布点、当前停车场与全部待回收的停车场。
+ * @param hub 要释放的发布点，可以为 NULL。
+ */
+void lot_hub_free(LotHub *hub) {
+  if (hub == NULL) {
+    return;
+  }
+  free_retired(hub->retired);
+  free_parking_lot((ParkingLot *)hub->current);
+  free(hub);
+}
+
+/**
+ * @brief 用一个已经完整加载的停车场替换当前停车场。
+ * @param hub 目标发布点。
+ * @param lot 新停车场。
+ * @return 成功返回 0；参数无效返回 -1；内存不足返回 -2。
+ */
+int lot_hub_publish(LotHub *hub, ParkingLot *lot) {
+  RetiredLot *entry;
+  RetiredLot *expired;
+  ParkingLot *old;
+  long epoch;
+
+  if (hub == NULL || lot == NULL) {
+    return -1;
+  }
+  /* 先分配退役记录，替换之后不能再失败 */
+  entry = (RetiredLot *)malloc(sizeof(RetiredLot));
+  if (entry == NULL) {
+    return -2;
+  }
+  hub_lock(hub);
+  if ((ParkingLot *)hub->current == lot) {
+    hub_unlock(hub);
+    free(entry);
+    return -1;
+  }
+  old = (ParkingLot *)parking_atomic_exchange_ptr(&hub->current, lot);
+  hub->published++;
+  if (old != NULL) {
+    /* 先退役再推进纪元：此后钉住的读者只能看到新停车场 */
+    epoch = parking_atomic_load_long(&hub->epoch);
+    entry->lot = old;
+    entry->retired_epoch = epoch;
+    entry->next = hub->retired;
+    hub->retired = entry;
+    parking_atomic_store_long(&hub->epoch, epoch + 1);
+    entry = NULL;
+  }
+  expired = take_expired_locked(hub);
+  hub_unlock(hub);
+  free(entry);
+  free_retired(expired);
+  return 0;
+}
+
+/**
+ * @brief 释放宽限期已过的旧停车场。
+ * @param hub 目标发布点。
+ * @return 本次释放的停车场数。
+ */
+int lot_hub_reclaim(LotHub *hub) {
+  RetiredLot *expired;
+
+  if (hub == NULL) {
+    return 0;
+  }
+  hub_lock(hub);
+  expired = take_expired_locked(hub);
+  hub_unlock(hub);
+  return free_retired(expired);
+}
+
+/**
+ * @brief 读取当前停车场而不钉住。
+ * @param hub 目标发布点。
+ * @return 当前停车场；hub 为 NULL 时返回 NULL。
+ */
+ParkingLot *lot_hub_current(LotHub *hub) {
+  if (hub == NULL) {
+    return NULL;
+  }
+  return (ParkingLot *)parking_atomic_load_ptr(&hub->current);
+}
+
+/**
+ * @brief 领取一个读者槽。
+ * @param hub 目标发布点。
+ * @return 读者槽下标；参数无效或槽已用完返回 -1。
+ */
+int lot_hub_attach(LotHub *hub) {
+  int i;
+
+  if (hub == NULL) {
+    return -1;
+  }
+  hub_lock(hub);
+  for (i = 0; i < LOT_HUB_MAX_READERS; i++) {
+    if (!hub->attached[i]) {
+      hub->attached[i] = 1;
+      hub->reader_count++;
+      parking_atomic_store_long(&hub->pins[i], 0);
+      hub_unlock(hub);
+      return i;
+    }
+  }
+  hub_unlock(hub);
+  return -1;
+}
+
+/**
+ * @brief 归还读者槽。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ */
+void lot_hub_detach(LotHub *hub, int reader) {
+  if (hub == NULL || reader < 0 || reader >= LOT_HUB_MAX_READERS) {
+    return;
+  }
+  hub_lock(hub);
+  if (hub->attached[reader]) {
+    parking_atomic_store_long(&hub->pins[reader], 0);
+    hub->attached[reader] = 0;
+    hub->reader_count--;
+  }
+  hub_unlock(hub);
+}
+
+/**
+ * @brief 钉住当前纪元并取得当前停车场。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ * @return 当前停车场；没有停车场或参数无效时返回 NULL。
+ */
+ParkingLot *lot_hub_pin(LotHub *hub, int reader) {
+  if (hub == NULL || reader < 0 || reader >= LOT_HUB_MAX_READERS) {
+    return NULL;
+  }
+  /*
+   * 先写入纪元再读指针：发布者替换指针之后才推进纪元并检查读者槽，
+   * 读到旧指针的读者钉住的纪元一定不晚于旧停车场的退役纪元。
+   */
+  parking_atomic_store_long(&hub->pins[reader],
+                            parking_atomic_load_long(&hub->epoch));
+  return (ParkingLot *)parking_atomic_load_ptr(&hub->current);
+}
+
+/**
+ * @brief 解除钉住。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ */
+void lot_hub_unpin(LotHub *hub, int reader) {
+  if (hub == NULL || reader < 0 || reader >= LOT_HUB_MAX_READERS) {
+    return;
+  }
+  parking_atomic_store_long(&hub->pins[reader], 0);
+}
@@ -0,0 +1,142 @@
+#ifndef PARKING_LOT_HUB_H
+#define PARKING_LOT_HUB_H
+
+#include "parking_data.h"
+
+/**
+ * @file parking_lot_hub.h
+ * @brief 整体替换停车场而不阻塞查询的发布点声明。
+ * @details
+ * 从文件重新加载数据时，原来的做法是先释放当前停车场再换上新加载的一个，
+ * 加载过程中（以及加载失败之后）没有停车场可以服务。发布点持有当前
+ * 停车场的指针：新停车场在影子对象上完整加载并建好索引之后才原子替换
+ * 指针，此前的查询照常在旧停车场上进行；加载失败时当前停车场不受影响。
+ *
+ * 被替换的停车场不能立即释放，可能还有查询线程在用。回收方式与
+ * parking_view.h 的只读视图相同：读者线程 attach 领取读者槽，每次使用
+ * 停车场前 pin 钉住当前纪元并取得指针，用完 unpin；发布者替换指针后推进
+ * 纪元，所有钉住的纪元都晚于旧停车场退役时的纪元之后才调用
+ * free_parking_lot 释放它。
+ *
+ * 替换的是整个停车场：退役之后写入旧停车场的修改不会出现在新停车场中，
+ * 需要保留修改的写者应与重新加载互相串行。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define LOT_HUB_MAX_READERS 64 /**< 同时 attach 的读者数上限 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个已被替换、等待宽限期结束的停车场。
+ */
+typedef struct RetiredLot {
+  ParkingLot *lot;         /**< 退役的停车场。 */
+  long retired_epoch;      /**< 退役时的纪元。 */
+  struct RetiredLot *next; /**< 待回收链表中的下一个。 */
+} RetiredLot;
+
+/**
+ * @brief 发布当前停车场并管理旧停车场回收的发布点。
+ */
+typedef struct LotHub {
+  void *volatile current; /**< 当前停车场（ParkingLot），可以为 NULL。 */
+  volatile long epoch;    /**< 当前纪元，从 1 起，每次替换后递增。 */
+  /** 各读者钉住的纪元，0 表示未钉住。 */
+  volatile long pins[LOT_HUB_MAX_READERS];
+  int attached[LOT_HUB_MAX_READERS]; /**< 非 0 表示读者槽已被领取。 */
+  int reader_count;        /**< 已领取的读者槽数。 */
+  volatile int lock;       /**< 保护替换、读者槽领取与待回收链表的自旋锁。 */
+  RetiredLot *retired;     /**< 已被替换、等待宽限期结束的停车场。 */
+  unsigned long published; /**< 已替换的次数。 */
+  long reclaimed;          /**< 已释放的旧停车场数。 */
+} LotHub;
+
+/**
+ *********************************************************************************
+ *                               停车场发布点API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个发布点。
+ * @param lot 初始的当前停车场，可以为 NULL；成功后归发布点所有。
+ * @return 成功返回发布点，内存不足返回 NULL（lot 仍归调用者所有）。
+ */
+LotHub *lot_hub_create(ParkingLot *lot);
+
+/**
+ * @brief 释放发布点、当前停车场与全部待回收的停车场。
+ * @details 调用者须保证已没有读者钉住停车场。
+ * @param hub 要释放的发布点，可以为 NULL。
+ */
+void lot_hub_free(LotHub *hub);
+
+/**
+ * @brief 用一个已经完整加载的停车场替换当前停车场。
+ * @details 替换之后钉住的读者只能取得新停车场；旧停车场退役，宽限期过后
+ *          由本函数或 lot_hub_reclaim 释放。
+ * @param hub 目标发布点。
+ * @param lot 新停车场，成功后归发布点所有。
+ * @return 成功返回 0；参数无效返回 -1；内存不足返回 -2，
+ *         此时当前停车场不变、lot 仍归调用者所有。
+ */
+int lot_hub_publish(LotHub *hub, ParkingLot *lot);
+
+/**
+ * @brief 释放宽限期已过的旧停车场。
+ * @param hub 目标发布点。
+ * @return 本次释放的停车场数。
+ */
+int lot_hub_reclaim(LotHub *hub);
+
+/**
+ * @brief 读取当前停车场而不钉住。
+ * @details 只供同时也是唯一发布者的线程使用（例如菜单线程），
+ *          其他线程须通过 lot_hub_pin 取得停车场。
+ * @param hub 目标发布点。
+ * @return 当前停车场；hub 为 NULL 时返回 NULL。
+ */
+ParkingLot *lot_hub_current(LotHub *hub);
+
+/**
+ * @brief 领取一个读者槽。
+ * @param hub 目标发布点。
+ * @return 读者槽下标；参数无效或槽已用完返回 -1。
+ */
+int lot_hub_attach(LotHub *hub);
+
+/**
+ * @brief 归还读者槽，钉住的停车场随之解除。
+ * @param hub 目标发布点。
+ * @param reader lot_hub_attach 返回的读者槽下标。
+ */
+void lot_hub_detach(LotHub *hub, int reader);
+
+/**
+ * @brief 钉住当前纪元并取得当前停车场。
+ * @details 不获取锁。返回的停车场在 lot_hub_unpin 之前不会被释放，
+ *          期间照常通过服务函数访问；同一读者不能嵌套钉住。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ * @return 当前停车场；没有停车场或参数无效时返回 NULL。
+ */
+ParkingLot *lot_hub_pin(LotHub *hub, int reader);
+
+/**
+ * @brief 解除钉住，此后不得再访问钉住期间取得的停车场。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ */
+void lot_hub_unpin(LotHub *hub, int reader);
+
+#endif /* PARKING_LOT_HUB_H */
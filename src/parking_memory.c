@@ -0,0 +1,290 @@
+/**
+ * @file parking_memory.c
+ * @brief 停车场内存分配钩子与按类别的内存统计实现文件
+ * @details
+ * 该文件实现了 parking_memory.h 中声明的带头部的分配函数。
+ * 头部固定占 PARKING_MEMORY_HEADER_BYTES 字节，使返回的指针保持
+ * 与 malloc 相同的对齐；计数用 parking_thread.h 的原子操作更新。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_memory.h"
+#include "parking_thread.h"
+
+/* ========================================================================== */
+/*                                 内部数据结构                               */
+/* ========================================================================== */
+
+/**
+ * @brief 放在每个内存块之前的头部。
+ */
+typedef struct MemoryHeader {
+  size_t size;  /**< 请求的字节数。 */
+  int category; /**< 统计类别。 */
+} MemoryHeader;
+
+/** 头部必须放得进预留的字节数，否则编译失败。 */
+typedef char memory_header_fits[sizeof(MemoryHeader) <=
+                                        PARKING_MEMORY_HEADER_BYTES
+                                    ? 1
+                                    : -1];
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 默认的分配函数。
+ * @param size 字节数。
+ * @param ctx 未使用。
+ * @return malloc 的结果。
+ */
+static void *default_allocate(size_t size, void *ctx) {
+  (void)ctx;
+  return malloc(size);
+}
+
+/**
+ * @brief (静态辅助函数) 默认的调整大小函数。
+ * @param ptr 原内存块。
+ * @param size 新的字节数。
+ * @param ctx 未使用。
+ * @return realloc 的结果。
+ */
+static void *default_reallocate(void *ptr, size_t size, void *ctx) {
+  (void)ctx;
+  return realloc(ptr, size);
+}
+
+/**
+ * @brief (静态辅助函数) 默认的释放函数。
+ * @param ptr 内存块。
+ * @param ctx 未使用。
+ */
+static void default_release(void *ptr, void *ctx) {
+  (void)ctx;
+  free(ptr);
+}
+
+/**
+ * @brief (静态辅助函数) 由用户指针取回头部。
+ * @param ptr parking_memory_alloc 返回的指针。
+ * @return 头部指针。
+ */
+static MemoryHeader *header_of(void *ptr) {
+  return (MemoryHeader *)(void *)((char *)ptr - PARKING_MEMORY_HEADER_BYTES);
+}
+
+/**
+ * @brief (静态辅助函数) 把一次分配或释放计入统计。
+ * @param memory 内存对象。
+ * @param category 统计类别。
+ * @param bytes 字节数的变化量。
+ * @param objects 块数的变化量。
+ */
+static void account(ParkingMemory *memory, int category, long bytes,
+                    long objects) {
+  long total;
+
+  parking_atomic_add_long(&memory->bytes[category], bytes);
+  parking_atomic_add_long(&memory->objects[category], objects);
+  parking_atomic_add_long(&memory->total_bytes, bytes);
+  total = parking_atomic_load_long(&memory->total_bytes);
+  if (bytes > 0 && total > parking_atomic_load_long(&memory->peak_bytes)) {
+    parking_atomic_store_long(&memory->peak_bytes, total);
+  }
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 初始化内存计数并设置分配函数。
+ * @param memory 目标对象。
+ * @param allocator 分配函数；为 NULL 或不完整时使用 C 标准库。
+ */
+void parking_memory_init(ParkingMemory *memory,
+                         const ParkingAllocator *allocator) {
+  memset(memory, 0, sizeof(*memory));
+  if (allocator && allocator->allocate && allocator->release) {
+    memory->allocator = *allocator;
+  } else {
+    memory->allocator.allocate = default_allocate;
+    memory->allocator.reallocate = default_reallocate;
+    memory->allocator.release = default_release;
+    memory->allocator.ctx = NULL;
+  }
+}
+
+/**
+ * @brief 分配一块内存并计入指定类别。
+ * @param memory 内存对象；为 NULL 时直接调用 malloc。
+ * @param category 统计类别。
+ * @param size 字节数。
+ * @return 成功返回内存块，失败返回 NULL。
+ */
+void *parking_memory_alloc(ParkingMemory *memory,
+                           ParkingMemoryCategory category, size_t size) {
+  MemoryHeader *header;
+
+  if (memory == NULL) {
+    return malloc(size);
+  }
+  if (size > (size_t)-1 - PARKING_MEMORY_HEADER_BYTES) {
+    parking_atomic_add_long(&memory->failures, 1);
+    return NULL;
+  }
+  header = (MemoryHeader *)memory->allocator.allocate(
+      size + PARKING_MEMORY_HEADER_BYTES, memory->allocator.ctx);
+  if (header == NULL) {
+    parking_atomic_add_long(&memory->failures, 1);
+    return NULL;
+  }
+  header->size = size;
+  header->category = (int)category;
+  account(memory, (int)category, (long)size, 1);
+  return (char *)header + PARKING_MEMORY_HEADER_BYTES;
+}
+
+/**
+ * @brief 分配一块清零的内存并计入指定类别。
+ * @param memory 内存对象；为 NULL 时直接调用 calloc。
+ * @param category 统计类别。
+ * @param count 元素个数。
+ * @param size 每个元素的字节数。
+ * @return 成功返回内存块，失败或大小溢出返回 NULL。
+ */
+void *parking_memory_calloc(ParkingMemory *memory,
+                            ParkingMemoryCategory category, size_t count,
+                            size_t size) {
+  void *ptr;
+
+  if (memory == NULL) {
+    return calloc(count, size);
+  }
+  if (size != 0 && count > (size_t)-1 / size) {
+    parking_atomic_add_long(&memory->failures, 1);
+    return NULL;
+  }
+  ptr = parking_memory_alloc(memory, category, count * size);
+  if (ptr != NULL) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+/**
+ * @brief 调整一块内存的大小。
+ * @param memory 内存对象；为 NULL 时直接调用 realloc。
+ * @param category 新分配时使用的统计类别。
+ * @param ptr 原内存块，可以为 NULL。
+ * @param size 新的字节数。
+ * @return 成功返回新的内存块，失败返回 NULL（原内存块不变）。
+ */
+void *parking_memory_realloc(ParkingMemory *memory,
+                             ParkingMemoryCategory category, void *ptr,
+                             size_t size) {
+  MemoryHeader *header;
+  MemoryHeader *moved;
+  size_t old_size;
+  int old_category;
+
+  if (memory == NULL) {
+    return realloc(ptr, size);
+  }
+  if (ptr == NULL) {
+    return parking_memory_alloc(memory, category, size);
+  }
+  if (size > (size_t)-1 - PARKING_MEMORY_HEADER_BYTES) {
+    parking_atomic_add_long(&memory->failures, 1);
+    return NULL;
+  }
+  header = header_of(ptr);
+  old_size = header->size;
+  old_category = header->category;
+
+  if (memory->allocator.reallocate) {
+    moved = (MemoryHeader *)memory->allocator.reallocate(
+        header, size + PARKING_MEMORY_HEADER_BYTES, memory->allocator.ctx);
+    if (moved == NULL) {
+      parking_atomic_add_long(&memory->failures, 1);
+      return NULL;
+    }
+  } else {
+    moved = (MemoryHeader *)memory->allocator.allocate(
+        size + PARKING_MEMORY_HEADER_BYTES, memory->allocator.ctx);
+    if (moved == NULL) {
+      parking_atomic_add_long(&memory->failures, 1);
+      return NULL;
+    }
+    memcpy((char *)moved + PARKING_MEMORY_HEADER_BYTES, ptr,
+           old_size < size ? old_size : size);
+    moved->category = old_category;
+    memory->allocator.release(header, memory->allocator.ctx);
+  }
+  moved->size = size;
+  account(memory, old_category, (long)size - (long)old_size, 0);
+  return (char *)moved + PARKING_MEMORY_HEADER_BYTES;
+}
+
+/**
+ * @brief 释放一块内存。
+ * @details 计数在交还内存之前更新，因此 memory 可以位于被释放的内存块之内。
+ * @param memory 分配时使用的内存对象；为 NULL 时直接调用 free。
+ * @param ptr 内存块，可以为 NULL。
+ */
+void parking_memory_free(ParkingMemory *memory, void *ptr) {
+  ParkingAllocator allocator;
+  MemoryHeader *header;
+
+  if (ptr == NULL) {
+    return;
+  }
+  if (memory == NULL) {
+    free(ptr);
+    return;
+  }
+  header = header_of(ptr);
+  allocator = memory->allocator;
+  account(memory, header->category, -(long)header->size, -1);
+  allocator.release(header, allocator.ctx);
+}
+
+/**
+ * @brief 读取内存统计快照。
+ * @param memory 内存对象。
+ * @param[out] stats 接收快照。
+ */
+void parking_memory_read(const ParkingMemory *memory,
+                         ParkingMemoryStats *stats) {
+  int i;
+
+  memset(stats, 0, sizeof(*stats));
+  for (i = 0; i < PARKING_MEMORY_CATEGORY_COUNT; i++) {
+    stats->bytes[i] = parking_atomic_load_long(&memory->bytes[i]);
+    stats->objects[i] = parking_atomic_load_long(&memory->objects[i]);
+    stats->total_bytes += stats->bytes[i];
+    stats->total_objects += stats->objects[i];
+  }
+  stats->overhead_bytes = stats->total_objects * PARKING_MEMORY_HEADER_BYTES;
+  stats->peak_bytes = parking_atomic_load_long(&memory->peak_bytes);
+  stats->failures = parking_atomic_load_long(&memory->failures);
+}
+
+/**
+ * @brief 获取内存类别的名称。
+ * @param category 内存类别。
+ * @return 指向静态字符串的指针；越界时返回 "unknown"。
+ */
+const char *parking_memory_category_name(ParkingMemoryCategory category) {
+  static const char *const names[PARKING_MEMORY_CATEGORY_COUNT] = {
+      "lot", "slots", "table", "index", "strings", "io"};
+
+  if ((int)category < 0 || category >= PARKING_MEMORY_CATEGORY_COUNT) {
+    return "unknown";
+  }
+  return names[category];
+}
@@ -0,0 +1,162 @@
+#ifndef PARKING_MEMORY_H
+#define PARKING_MEMORY_H
+
+/**
+ * @file parking_memory.h
+ * @brief 停车场内存分配钩子与按类别的内存统计声明。
+ * @details
+ * 每个停车场持有一个 ParkingMemory：停车场对象本身以及它内部的车位内存池、
+ * 稠密车位表、索引、文本存储和保存/加载缓冲区都经由它分配，
+ * 分配函数可以由调用者替换（例如接入专用内存池或在测试中注入失败）。
+ *
+ * 每次分配在返回的指针前放一个 PARKING_MEMORY_HEADER_BYTES 字节的头部，
+ * 记录请求的字节数与类别，释放与 realloc 时据此更新统计，调用者无需记住大小。
+ * 统计的字节数只含请求的大小，头部开销另计。
+ *
+ * 各模块的 memory 指针为 NULL 时退化为直接调用 malloc/free，不加头部、不计入统计；
+ * 交给调用者自行 free() 的查询数组与 ServiceResult 数据始终使用 C 堆。
+ */
+
+#include <stddef.h>
+
+/**
+ *********************************************************************************
+ *                                 枚举和结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 内存统计的类别。
+ */
+typedef enum {
+  PARKING_MEMORY_LOT = 0,     /**< 停车场对象本身 */
+  PARKING_MEMORY_SLOTS = 1,   /**< 车位内存池的区块 */
+  PARKING_MEMORY_TABLE = 2,   /**< 稠密车位表、热字段列与空闲位图 */
+  PARKING_MEMORY_INDEX = 3,   /**< 哈希索引、日历计数与三元组索引 */
+  PARKING_MEMORY_STRINGS = 4, /**< 位置驻留池与文本内存池 */
+  PARKING_MEMORY_IO = 5,      /**< 保存与加载时的临时缓冲区 */
+  PARKING_MEMORY_CATEGORY_COUNT = 6 /**< 类别数 */
+} ParkingMemoryCategory;
+
+/**
+ * @brief 可替换的分配函数。
+ * @details allocate 与 release 必须同时提供；reallocate 可以为 NULL，
+ *          此时以 allocate + 复制 + release 代替。三者都可能在持有
+ *          停车场写锁时被调用，不能回调停车场接口。
+ */
+typedef struct ParkingAllocator {
+  void *(*allocate)(size_t size, void *ctx);   /**< 分配，失败返回 NULL。 */
+  void *(*reallocate)(void *ptr, size_t size,
+                      void *ctx);              /**< 调整大小，可以为 NULL。 */
+  void (*release)(void *ptr, void *ctx);       /**< 释放。 */
+  void *ctx;                                   /**< 透传给上述函数的上下文。 */
+} ParkingAllocator;
+
+/**
+ * @brief 一个停车场的分配函数与内存计数。
+ * @details 计数以原子操作更新，可以在不加锁的情况下读取。
+ */
+typedef struct ParkingMemory {
+  ParkingAllocator allocator; /**< 当前使用的分配函数。 */
+  volatile long bytes[PARKING_MEMORY_CATEGORY_COUNT];   /**< 各类别在用字节数。 */
+  volatile long objects[PARKING_MEMORY_CATEGORY_COUNT]; /**< 各类别在用块数。 */
+  volatile long total_bytes; /**< 全部类别的在用字节数。 */
+  volatile long peak_bytes;  /**< total_bytes 的历史最大值（近似）。 */
+  volatile long failures;    /**< 分配失败的次数。 */
+} ParkingMemory;
+
+/**
+ * @brief 内存统计快照。
+ */
+typedef struct ParkingMemoryStats {
+  long bytes[PARKING_MEMORY_CATEGORY_COUNT];   /**< 各类别在用字节数。 */
+  long objects[PARKING_MEMORY_CATEGORY_COUNT]; /**< 各类别在用块数。 */
+  long total_bytes;    /**< 全部类别的在用字节数。 */
+  long total_objects;  /**< 全部类别的在用块数。 */
+  long overhead_bytes; /**< 分配头部占用的字节数。 */
+  long peak_bytes;     /**< 在用字节数的历史最大值（近似）。 */
+  long failures;       /**< 分配失败的次数。 */
+} ParkingMemoryStats;
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_MEMORY_HEADER_BYTES 16 /**< 每次分配的头部字节数 */
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 初始化内存计数并设置分配函数。
+ * @param memory 目标对象。
+ * @param allocator 分配函数；为 NULL 或缺少 allocate/release 时使用 C 标准库。
+ */
+void parking_memory_init(ParkingMemory *memory,
+                         const ParkingAllocator *allocator);
+
+/**
+ * @brief 分配一块内存并计入指定类别。
+ * @param memory 内存对象；为 NULL 时直接调用 malloc。
+ * @param category 统计类别。
+ * @param size 字节数。
+ * @return 成功返回内存块，失败返回 NULL。
+ */
+void *parking_memory_alloc(ParkingMemory *memory,
+                           ParkingMemoryCategory category, size_t size);
+
+/**
+ * @brief 分配一块清零的内存并计入指定类别。
+ * @param memory 内存对象；为 NULL 时直接调用 calloc。
+ * @param category 统计类别。
+ * @param count 元素个数。
+ * @param size 每个元素的字节数。
+ * @return 成功返回内存块，失败或大小溢出返回 NULL。
+ */
+void *parking_memory_calloc(ParkingMemory *memory,
+                            ParkingMemoryCategory category, size_t count,
+                            size_t size);
+
+/**
+ * @brief 调整一块内存的大小。
+ * @details ptr 为 NULL 时等同于 parking_memory_alloc；已有内存块保持原类别。
+ *          失败时原内存块保持不变。
+ * @param memory 内存对象；为 NULL 时直接调用 realloc。
+ * @param category 新分配时使用的统计类别。
+ * @param ptr 原内存块，必须由同一 memory 分配，可以为 NULL。
+ * @param size 新的字节数，必须大于 0。
+ * @return 成功返回新的内存块，失败返回 NULL。
+ */
+void *parking_memory_realloc(ParkingMemory *memory,
+                             ParkingMemoryCategory category, void *ptr,
+                             size_t size);
+
+/**
+ * @brief 释放一块内存。
+ * @param memory 分配时使用的内存对象；为 NULL 时直接调用 free。
+ * @param ptr 内存块，可以为 NULL。
+ */
+void parking_memory_free(ParkingMemory *memory, void *ptr);
+
+/**
+ * @brief 读取内存统计快照。
+ * @details 只读取原子计数，可以与分配并发进行。
+ * @param memory 内存对象。
+ * @param[out] stats 接收快照。
+ */
+void parking_memory_read(const ParkingMemory *memory,
+                         ParkingMemoryStats *stats);
+
+/**
+ * @brief 获取内存类别的名称。
+ * @param category 内存类别。
+ * @return 指向静态字符串的指针；越界时返回 "unknown"。
+ */
+const char *parking_memory_category_name(ParkingMemoryCategory category);
+
+#endif /* PARKING_MEMORY_H */
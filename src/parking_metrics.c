@@ -0,0 +1,227 @@
+/**
+ * @file parking_metrics.c
+ * @brief 调用计数与延迟直方图的采集实现文件
+ * @details
+ * 该文件实现了 parking_metrics.h 中声明的分片计数与对数线性直方图。
+ * 单调时钟需要 POSIX 的 clock_gettime，因此与 parking_thread.c 一样
+ * 在包含系统头文件前显式开启 _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <string.h>
+#include <time.h>
+
+#include "parking_metrics.h"
+#include "parking_thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/* ========================================================================== */
+/*                                 内部数据结构                               */
+/* ========================================================================== */
+
+/**
+ * @brief 一个计数分片，保存全部操作的计数。
+ */
+typedef struct MetricsStripe {
+  volatile long calls[METRICS_MAX_OPERATIONS]; /**< 各操作的调用次数。 */
+  volatile long outcomes[METRICS_MAX_OPERATIONS]
+                        [METRICS_MAX_OUTCOMES]; /**< 各操作按结果的次数。 */
+  volatile long latency[METRICS_MAX_OPERATIONS]
+                       [METRICS_LATENCY_BUCKETS]; /**< 各操作的延迟直方图。 */
+} MetricsStripe;
+
+/** 进程内全部分片，静态分配，无需初始化。 */
+static MetricsStripe metrics_stripes[METRICS_STRIPES];
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 选择当前线程使用的分片。
+ * @details 线程标识乘以黄金分割常数后取高位，使相邻的标识分散到不同分片。
+ * @return 分片指针。
+ */
+static MetricsStripe *current_stripe(void) {
+  unsigned long mixed =
+      (parking_thread_current_id() * 2654435761UL) & 0xFFFFFFFFUL;
+
+  return &metrics_stripes[(mixed >> 16) & (METRICS_STRIPES - 1)];
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 读取单调时钟。
+ * @return 当前单调时刻（纳秒）。
+ */
+unsigned long metrics_now_ns(void) {
+#ifdef _WIN32
+  LARGE_INTEGER counter;
+  LARGE_INTEGER frequency;
+
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (unsigned long)((double)counter.QuadPart * 1e9 /
+                         (double)frequency.QuadPart);
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long)ts.tv_sec * 1000000000UL + (unsigned long)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief 记录一次操作到当前线程的分片。
+ * @param operation 操作下标。
+ * @param outcome 结果下标。
+ * @param elapsed_ns 操作耗时（纳秒）。
+ */
+void metrics_record(int operation, int outcome, unsigned long elapsed_ns) {
+  MetricsStripe *stripe;
+
+  if (operation < 0 || operation >= METRICS_MAX_OPERATIONS) {
+    return;
+  }
+  if (outcome < 0 || outcome >= METRICS_MAX_OUTCOMES) {
+    outcome = METRICS_MAX_OUTCOMES - 1;
+  }
+  stripe = current_stripe();
+  parking_atomic_add_long(&stripe->calls[operation], 1);
+  parking_atomic_add_long(&stripe->outcomes[operation][outcome], 1);
+  parking_atomic_add_long(
+      &stripe->latency[operation][metrics_latency_bucket(elapsed_ns)], 1);
+}
+
+/**
+ * @brief 合并全部分片，读取一个操作的指标快照。
+ * @param operation 操作下标。
+ * @param[out] snapshot 接收快照。
+ */
+void metrics_read(int operation, MetricsSnapshot *snapshot) {
+  int s;
+  int i;
+
+  memset(snapshot, 0, sizeof(*snapshot));
+  if (operation < 0 || operation >= METRICS_MAX_OPERATIONS) {
+    return;
+  }
+  for (s = 0; s < METRICS_STRIPES; s++) {
+    const MetricsStripe *stripe = &metrics_stripes[s];
+
+    snapshot->calls += parking_atomic_load_long(&stripe->calls[operation]);
+    for (i = 0; i < METRICS_MAX_OUTCOMES; i++) {
+      snapshot->outcomes[i] +=
+          parking_atomic_load_long(&stripe->outcomes[operation][i]);
+    }
+    for (i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+      snapshot->latency[i] +=
+          parking_atomic_load_long(&stripe->latency[operation][i]);
+    }
+  }
+}
+
+/**
+ * @brief 清零全部指标。
+ */
+void metrics_reset(void) {
+  int s;
+  int op;
+  int i;
+
+  for (s = 0; s < METRICS_STRIPES; s++) {
+    MetricsStripe *stripe = &metrics_stripes[s];
+
+    for (op = 0; op < METRICS_MAX_OPERATIONS; op++) {
+      parking_atomic_store_long(&stripe->calls[op], 0);
+      for (i = 0; i < METRICS_MAX_OUTCOMES; i++) {
+        parking_atomic_store_long(&stripe->outcomes[op][i], 0);
+      }
+      for (i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+        parking_atomic_store_long(&stripe->latency[op][i], 0);
+      }
+    }
+  }
+}
+
+/**
+ * @brief 计算延迟所在的直方图桶。
+ * @details 设延迟的最高位为第 p 位（p >= 3），则区间组号为 p - 2，
+ *          组内子桶为紧随最高位之后的 3 位。
+ * @param elapsed_ns 延迟（纳秒）。
+ * @return 桶下标。
+ */
+int metrics_latency_bucket(unsigned long elapsed_ns) {
+  int shift = 0;
+
+  if (elapsed_ns < METRICS_SUB_BUCKETS) {
+    return (int)elapsed_ns;
+  }
+  while ((elapsed_ns >> shift) >= 2 * METRICS_SUB_BUCKETS) {
+    shift++;
+  }
+  if ((shift + 1) * METRICS_SUB_BUCKETS >= METRICS_LATENCY_BUCKETS) {
+    return METRICS_LATENCY_BUCKETS - 1;
+  }
+  return (shift + 1) * METRICS_SUB_BUCKETS +
+         (int)((elapsed_ns >> shift) - METRICS_SUB_BUCKETS);
+}
+
+/**
+ * @brief 计算直方图桶的上界。
+ * @param bucket 桶下标。
+ * @return 落入该桶的延迟的上界（纳秒，不含）。
+ */
+double metrics_bucket_upper_ns(int bucket) {
+  int shift = bucket / METRICS_SUB_BUCKETS - 1;
+  double upper;
+
+  if (shift < 0) {
+    return (double)(bucket + 1);
+  }
+  upper = (double)(METRICS_SUB_BUCKETS + bucket % METRICS_SUB_BUCKETS + 1);
+  while (shift-- > 0) {
+    upper *= 2.0;
+  }
+  return upper;
+}
+
+/**
+ * @brief 由快照中的直方图估算延迟分位数。
+ * @param snapshot 指标快照。
+ * @param quantile 分位点，取值 (0, 1]。
+ * @return 分位数所在桶的上界（纳秒）；没有样本时返回 0。
+ */
+double metrics_quantile_ns(const MetricsSnapshot *snapshot, double quantile) {
+  long total = 0;
+  long target;
+  long seen = 0;
+  int i;
+
+  for (i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+    total += snapshot->latency[i];
+  }
+  if (total == 0) {
+    return 0.0;
+  }
+  target = (long)(quantile * (double)total + 0.999999);
+  if (target < 1) {
+    target = 1;
+  }
+  for (i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+    seen += snapshot->latency[i];
+    if (seen >= target) {
+      return metrics_bucket_upper_ns(i);
+    }
+  }
+  return metrics_bucket_upper_ns(METRICS_LATENCY_BUCKETS - 1);
+}
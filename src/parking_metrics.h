@@ -0,0 +1,107 @@
+#ifndef PARKING_METRICS_H
+#define PARKING_METRICS_H
+
+/**
+ * @file parking_metrics.h
+ * @brief 调用计数与延迟直方图的采集声明。
+ * @details
+ * 每个被观测的操作有一个调用计数、一组按结果分类的计数和一个对数线性延迟直方图：
+ * 小于 METRICS_SUB_BUCKETS 纳秒的延迟逐纳秒分桶，更大的延迟按所在的 2 的幂区间
+ * 分组、每组再等分为 METRICS_SUB_BUCKETS 个子桶，相对误差不超过 12.5%。
+ *
+ * 计数存放在 METRICS_STRIPES 个分片中，线程按 parking_thread_current_id
+ * 选择分片并原子累加，不同线程之间几乎不争用同一缓存行；
+ * 读取时把全部分片合并为一份快照。
+ * 采集开关 PARKING_SERVICE_METRICS 在编译期决定，关闭时服务层不调用本模块。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#ifndef PARKING_SERVICE_METRICS
+#define PARKING_SERVICE_METRICS 1 /**< 为 0 时服务层不采集指标 */
+#endif
+
+#define METRICS_MAX_OPERATIONS 16  /**< 最多可观测的操作数 */
+#define METRICS_MAX_OUTCOMES 13    /**< 每个操作最多区分的结果数 */
+#define METRICS_SUB_BUCKETS 8      /**< 每个 2 的幂区间细分的子桶数 */
+#define METRICS_LATENCY_BUCKETS 240 /**< 延迟直方图的桶数，覆盖 0～2^32 纳秒 */
+#define METRICS_STRIPES 8          /**< 计数分片数，必须为 2 的幂 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个操作的指标快照。
+ */
+typedef struct MetricsSnapshot {
+  long calls;                             /**< 调用次数。 */
+  long outcomes[METRICS_MAX_OUTCOMES];    /**< 按结果分类的调用次数。 */
+  long latency[METRICS_LATENCY_BUCKETS];  /**< 各延迟桶的调用次数。 */
+} MetricsSnapshot;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 读取单调时钟，用于计算操作耗时。
+ * @details 返回值只在做差时有意义；long 为 32 位的平台上每约 4.3 秒回绕一次，
+ *          无符号做差仍能得到正确的耗时。
+ * @return 当前单调时刻（纳秒）。
+ */
+unsigned long metrics_now_ns(void);
+
+/**
+ * @brief 记录一次操作。
+ * @param operation 操作下标，0..METRICS_MAX_OPERATIONS-1，越界时忽略。
+ * @param outcome 结果下标，越界时计入最后一个结果。
+ * @param elapsed_ns 操作耗时（纳秒）。
+ */
+void metrics_record(int operation, int outcome, unsigned long elapsed_ns);
+
+/**
+ * @brief 合并全部分片，读取一个操作的指标快照。
+ * @details 读取与记录并发进行时，快照中的各项计数可能相差正在进行的几次调用。
+ * @param operation 操作下标。
+ * @param[out] snapshot 接收快照；操作下标越界时清零。
+ */
+void metrics_read(int operation, MetricsSnapshot *snapshot);
+
+/**
+ * @brief 清零全部指标。
+ * @details 与记录并发时，正在进行的调用可能在清零后仍计入一部分。
+ */
+void metrics_reset(void);
+
+/**
+ * @brief 计算延迟所在的直方图桶。
+ * @param elapsed_ns 延迟（纳秒）。
+ * @return 桶下标。
+ */
+int metrics_latency_bucket(unsigned long elapsed_ns);
+
+/**
+ * @brief 计算直方图桶的上界。
+ * @param bucket 桶下标。
+ * @return 落入该桶的延迟的上界（纳秒，不含）。
+ */
+double metrics_bucket_upper_ns(int bucket);
+
+/**
+ * @brief 由快照中的直方图估算延迟分位数。
+ * @param snapshot 指标快照。
+ * @param quantile 分位点，取值 (0, 1]。
+ * @return 分位数所在桶的上界（纳秒）；没有样本时返回 0。
+ */
+double metrics_quantile_ns(const MetricsSnapshot *snapshot, double quantile);
+
+#endif /* PARKING_METRICS_H */
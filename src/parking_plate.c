@@ -0,0 +1,229 @@
+/**
+ * @file parking_plate.c
+ * @brief 车牌号紧凑整数编码实现文件
+ * @details
+ * 该文件实现了 parking_plate.h 中声明的车牌编码与解码。
+ * 编码时逐字节扫描一遍车牌号，同时累计 FNV-1a 哈希，
+ * 一旦发现不符合标准格式，就继续用同一遍扫描算完哈希作为回退编码。
+ */
+
+#include <string.h>
+
+#include "parking_plate.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define PLATE_PROVINCE_COUNT 31  /**< 省份简称的数量 */
+#define PLATE_PROVINCE_BYTES 3   /**< 省份简称的 UTF-8 字节数 */
+#define PLATE_TAIL_MIN 5         /**< 尾部字符的最少位数（普通号牌） */
+#define PLATE_TAIL_MAX 6         /**< 尾部字符的最多位数（新能源号牌） */
+#define PLATE_TAIL_BASE 37UL     /**< 尾部编码的进制：0 表示缺位，1～36 为字符 */
+
+/**
+ * @brief 省份简称表，下标即编码中的省份序号。
+ */
+static const char plate_provinces[PLATE_PROVINCE_COUNT][PLATE_PROVINCE_BYTES +
+                                                        1] = {
+    "京", "津", "沪", "渝", "冀", "豫", "云", "辽", "黑", "湘", "皖",
+    "鲁", "新", "苏", "浙", "赣", "鄂", "桂", "甘", "晋", "蒙", "陕",
+    "吉", "闽", "贵", "粤", "青", "藏", "川", "宁", "琼"};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 将一个字节累加到 32 位 FNV-1a 哈希中。
+ * @param h 当前哈希值。
+ * @param byte 新字节。
+ * @return 更新后的哈希值。
+ */
+static unsigned long fnv_step(unsigned long h, unsigned char byte) {
+  h ^= (unsigned long)byte;
+  return (h * 16777619UL) & 0xFFFFFFFFUL;
+}
+
+/**
+ * @brief (静态辅助函数) 查找省份简称的序号。
+ * @param p 指向车牌首字节（以 NUL 结尾的字符串）。
+ * @return 省份序号，不是省份简称时返回 -1。
+ */
+static int find_province(const unsigned char *p) {
+  int i;
+
+  /* 省份简称都是三字节 UTF-8 汉字，首字节不在 0xE4..0xE9 的直接排除 */
+  if (p[0] < 0xE4 || p[0] > 0xE9 || p[1] == '\0' || p[2] == '\0') {
+    return -1;
+  }
+  for (i = 0; i < PLATE_PROVINCE_COUNT; i++) {
+    if (memcmp(p, plate_provinces[i], PLATE_PROVINCE_BYTES) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief (静态辅助函数) 将尾部字符映射为 1～36 的取值。
+ * @param c 尾部字符。
+ * @return 数字映射为 1～10，大写字母映射为 11～36，其他字符返回 0。
+ */
+static unsigned long tail_value(unsigned char c) {
+  if (c >= '0' && c <= '9') {
+    return (unsigned long)(c - '0') + 1;
+  }
+  if (c >= 'A' && c <= 'Z') {
+    return (unsigned long)(c - 'A') + 11;
+  }
+  return 0;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 将车牌号编码为整数键，只扫描字符串一遍。
+ * @param plate 车牌号字符串（UTF-8）。
+ * @param[out] code 接收编码。
+ * @return 标准车牌返回 1，非标准车牌返回 0（code 为回退编码）。
+ */
+int plate_encode(const char *plate, PlateCode *code) {
+  const unsigned char *p = (const unsigned char *)plate;
+  unsigned long hash = 2166136261UL;
+  unsigned long tail = 0;
+  int province = -1;
+  int standard = 1;
+  int length = 0;
+  int letter = 0;
+
+  if (plate == NULL) {
+    code->high = 0;
+    code->low = hash;
+    return 0;
+  }
+
+  for (; *p != '\0'; p++, length++) {
+    hash = fnv_step(hash, *p);
+    if (!standard) {
+      continue;
+    }
+    if (length == 0) {
+      province = find_province(p);
+      standard = province >= 0;
+    } else if (length < PLATE_PROVINCE_BYTES) {
+      /* 省份简称的后两个字节已由 find_province 核对 */
+    } else if (length == PLATE_PROVINCE_BYTES) {
+      standard = *p >= 'A' && *p <= 'Z';
+      letter = *p - 'A';
+    } else if (length <= PLATE_PROVINCE_BYTES + PLATE_TAIL_MAX) {
+      unsigned long value = tail_value(*p);
+      standard = value != 0;
+      tail = tail * PLATE_TAIL_BASE + value;
+    } else {
+      standard = 0;
+    }
+  }
+
+  length -= PLATE_PROVINCE_BYTES + 1; /* 尾部字符数 */
+  if (standard && length >= PLATE_TAIL_MIN) {
+    if (length == PLATE_TAIL_MIN) {
+      tail *= PLATE_TAIL_BASE; /* 缺位占据最低位 */
+    }
+    code->high = PLATE_CODE_STANDARD | ((unsigned long)province << 5) |
+                 (unsigned long)letter;
+    code->low = tail;
+    return 1;
+  }
+  code->high = 0;
+  code->low = hash;
+  return 0;
+}
+
+/**
+ * @brief 将标准车牌的编码还原为字符串。
+ * @param code 标准车牌的编码。
+ * @param[out] buffer 接收车牌号的缓冲区。
+ * @param size 缓冲区字节数。
+ * @return 成功返回车牌号的字节数；非标准编码或缓冲区过小返回 -1。
+ */
+int plate_decode(const PlateCode *code, char *buffer, size_t size) {
+  char tail[PLATE_TAIL_MAX];
+  unsigned long rest;
+  int province;
+  int count = 0;
+  int length;
+  int i;
+
+  if (code == NULL || buffer == NULL || !plate_code_is_standard(code)) {
+    return -1;
+  }
+  province = (int)((code->high >> 5) & 0x1FUL);
+  if (province >= PLATE_PROVINCE_COUNT || (code->high & 0x1FUL) > 25) {
+    return -1;
+  }
+
+  rest = code->low;
+  for (i = PLATE_TAIL_MAX - 1; i >= 0; i--) {
+    unsigned long value = rest % PLATE_TAIL_BASE;
+    rest /= PLATE_TAIL_BASE;
+    if (value == 0) {
+      if (i != PLATE_TAIL_MAX - 1) {
+        return -1; /* 只有最后一位允许缺位 */
+      }
+      tail[i] = '\0';
+      continue;
+    }
+    tail[i] = (char)(value <= 10 ? '0' + (value - 1) : 'A' + (value - 11));
+    count++;
+  }
+
+  length = PLATE_PROVINCE_BYTES + 1 + count;
+  if (size <= (size_t)length) {
+    return -1;
+  }
+  memcpy(buffer, plate_provinces[province], PLATE_PROVINCE_BYTES);
+  buffer[PLATE_PROVINCE_BYTES] = (char)('A' + (code->high & 0x1FUL));
+  memcpy(buffer + PLATE_PROVINCE_BYTES + 1, tail, (size_t)count);
+  buffer[length] = '\0';
+  return length;
+}
+
+/**
+ * @brief 判断编码是否来自标准车牌。
+ * @param code 目标编码。
+ * @return 标准车牌返回 1，否则返回 0。
+ */
+int plate_code_is_standard(const PlateCode *code) {
+  return (code->high & PLATE_CODE_STANDARD) != 0;
+}
+
+/**
+ * @brief 比较两个编码是否相同。
+ * @param a 第一个编码。
+ * @param b 第二个编码。
+ * @return 相同返回 1，否则返回 0。
+ */
+int plate_code_equal(const PlateCode *a, const PlateCode *b) {
+  return a->high == b->high && a->low == b->low;
+}
+
+/**
+ * @brief 计算编码的 32 位散列值，供哈希索引选桶。
+ * @details 将两个字混合后经 MurmurHash3 的 fmix32 打散；
+ *          非标准编码的 low 本身已是 FNV-1a 哈希，同样适用。
+ * @param code 目标编码。
+ * @return 32 位散列值。
+ */
+unsigned long plate_code_hash(const PlateCode *code) {
+  unsigned long h = (code->low ^ (code->high * 0x9E3779B1UL)) & 0xFFFFFFFFUL;
+
+  h ^= h >> 16;
+  h = (h * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+  h ^= h >> 13;
+  h = (h * 0xC2B2AE35UL) & 0xFFFFFFFFUL;
+  h ^= h >> 16;
+  return h;
+}
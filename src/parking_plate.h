@@ -0,0 +1,90 @@
+#ifndef PARKING_PLATE_H
+#define PARKING_PLATE_H
+
+#include <stddef.h>
+
+/**
+ * @file parking_plate.h
+ * @brief 车牌号的紧凑整数编码声明。
+ * @details
+ * 标准车牌由“省份简称 + 发牌机关字母 + 5 或 6 位字母数字”组成，
+ * 可以无损地压缩为两个 32 位字：
+ * - high：标准标记位、省份序号（5 位）与发牌机关字母（5 位）；
+ * - low：尾部 5～6 个字符按 37 进制排列（0 表示该位不存在）。
+ * 两个标准车牌相等当且仅当其编码相等，索引比较无需再访问字符串。
+ * 不符合该格式的车牌（如小写字母、“使”“领”“警”等特殊号牌）
+ * 编码为 high = 0、low = 字符串的 32 位哈希，调用者须回退到字符串比较。
+ * @note 编码只使用 unsigned long 的低 32 位，在 long 为 32 位的平台上同样适用。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PLATE_CODE_STANDARD 0x400UL /**< high 字中的标准车牌标记位 */
+#define PLATE_TEXT_MAX 16 /**< 解码标准车牌所需的最大缓冲区字节数（含 NUL） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个车牌号的整数编码。
+ */
+typedef struct PlateCode {
+  unsigned long high; /**< 标准标记、省份与字母；非标准车牌为 0。 */
+  unsigned long low;  /**< 尾部字符的 37 进制值；非标准车牌为字符串哈希。 */
+} PlateCode;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 将车牌号编码为整数键，只扫描字符串一遍。
+ * @param plate 车牌号字符串（UTF-8）。
+ * @param[out] code 接收编码。
+ * @return 标准车牌返回 1，非标准车牌返回 0（code 为回退编码）。
+ */
+int plate_encode(const char *plate, PlateCode *code);
+
+/**
+ * @brief 将标准车牌的编码还原为字符串。
+ * @param code 标准车牌的编码。
+ * @param[out] buffer 接收车牌号的缓冲区。
+ * @param size 缓冲区字节数，不小于 PLATE_TEXT_MAX 即可容纳任何标准车牌。
+ * @return 成功返回车牌号的字节数；非标准编码或缓冲区过小返回 -1。
+ */
+int plate_decode(const PlateCode *code, char *buffer, size_t size);
+
+/**
+ * @brief 判断编码是否来自标准车牌。
+ * @param code 目标编码。
+ * @return 标准车牌返回 1，否则返回 0。
+ */
+int plate_code_is_standard(const PlateCode *code);
+
+/**
+ * @brief 比较两个编码是否相同。
+ * @details 两个标准编码相同即车牌相同；非标准编码相同只说明哈希相同，
+ *          仍须比较字符串。
+ * @param a 第一个编码。
+ * @param b 第二个编码。
+ * @return 相同返回 1，否则返回 0。
+ */
+int plate_code_equal(const PlateCode *a, const PlateCode *b);
+
+/**
+ * @brief 计算编码的 32 位散列值，供哈希索引选桶。
+ * @param code 目标编码。
+ * @return 32 位散列值。
+ */
+unsigned long plate_code_hash(const PlateCode *code);
+
+#endif /* PARKING_PLATE_H */
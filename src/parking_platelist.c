@@ -0,0 +1,358 @@
+/**
+ * @file parking_platelist.c
+ * @brief 车牌名单实现文件
+ * @details
+ * 该文件实现了 parking_platelist.h 中声明的车牌名单。布隆过滤器采用
+ * 双重散列：第 i 个位置为 h1 + i * h2，h1 为车牌编码的散列值，h2 由
+ * h1 再混合一次得到并置为奇数，位数为 2 的幂时各位置互不重复地遍历。
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "parking_data.h"
+#include "parking_platelist.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 由第一个散列值导出布隆过滤器的步长。
+ * @param hash 车牌编码的 32 位散列值。
+ * @return 奇数步长。
+ */
+static unsigned long bloom_step(unsigned long hash) {
+  hash = (hash * 0x9E3779B1UL) & 0xFFFFFFFFUL;
+  hash ^= hash >> 15;
+  hash = (hash * 0x2C1B3C6DUL) & 0xFFFFFFFFUL;
+  hash ^= hash >> 12;
+  return hash | 1UL;
+}
+
+/**
+ * @brief (静态辅助函数) 在哈希表中查找车牌所在的槽或应放入的空槽。
+ * @param entries 哈希表。
+ * @param capacity 哈希表容量（2 的幂）。
+ * @param code 车牌编码。
+ * @param text 非标准车牌的原文，标准车牌为 NULL。
+ * @param hash 车牌编码的散列值。
+ * @return 已存放该车牌的槽，或探查到的第一个空槽的下标。
+ */
+static size_t probe_entry(const PlateListEntry *entries, size_t capacity,
+                          const PlateCode *code, const char *text,
+                          unsigned long hash) {
+  size_t at = (size_t)hash & (capacity - 1);
+
+  while (entries[at].used) {
+    if (plate_code_equal(&entries[at].code, code) &&
+        (text == NULL || strcmp(entries[at].text, text) == 0)) {
+      break;
+    }
+    at = (at + 1) & (capacity - 1);
+  }
+  return at;
+}
+
+/**
+ * @brief (静态辅助函数) 把哈希表扩容为两倍。
+ * @param list 目标名单。
+ * @return 成功返回 0，内存不足返回 -1（原表不变）。
+ */
+static int grow_entries(PlateList *list) {
+  size_t capacity = list->capacity * 2;
+  PlateListEntry *entries;
+  size_t i;
+
+  entries = (PlateListEntry *)parking_memory_calloc(
+      list->memory, PARKING_MEMORY_INDEX, capacity, sizeof(PlateListEntry));
+  if (entries == NULL) {
+    return -1;
+  }
+  for (i = 0; i < list->capacity; i++) {
+    const PlateListEntry *old = &list->entries[i];
+
+    if (old->used) {
+      entries[probe_entry(entries, capacity, &old->code, old->text,
+                          plate_code_hash(&old->code))] = *old;
+    }
+  }
+  parking_memory_free(list->memory, list->entries);
+  list->entries = entries;
+  list->capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 判断字符是否为空白。
+ * @param c 字符。
+ * @return 是空白返回 1，否则返回 0。
+ */
+static int is_blank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' ||
+         c == '\v';
+}
+
+/**
+ * @brief (静态辅助函数) 原地去掉字符串首尾的空白。
+ * @param text 可修改的字符串。
+ * @return 去掉前导空白后的起点。
+ */
+static char *trim(char *text) {
+  size_t length;
+
+  while (is_blank(*text)) {
+    text++;
+  }
+  length = strlen(text);
+  while (length > 0 && is_blank(text[length - 1])) {
+    text[--length] = '\0';
+  }
+  return text;
+}
+
+/* ========================================================================== */
+/*                              车牌名单API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一份空名单。
+ * @param memory 名单的分配来源，NULL 表示 C 堆。
+ * @return 成功返回名单，内存不足返回 NULL。
+ */
+PlateList *plate_list_create(ParkingMemory *memory) {
+  PlateList *list;
+
+  list = (PlateList *)parking_memory_calloc(memory, PARKING_MEMORY_INDEX, 1,
+                                            sizeof(PlateList));
+  if (list == NULL) {
+    return NULL;
+  }
+  list->entries = (PlateListEntry *)parking_memory_calloc(
+      memory, PARKING_MEMORY_INDEX, PLATE_LIST_INITIAL, sizeof(PlateListEntry));
+  if (list->entries == NULL) {
+    parking_memory_free(memory, list);
+    return NULL;
+  }
+  list->capacity = PLATE_LIST_INITIAL;
+  list->memory = memory;
+  return list;
+}
+
+/**
+ * @brief 释放名单。
+ * @param list 要释放的名单，可以为 NULL。
+ */
+void plate_list_free(PlateList *list) {
+  size_t i;
+
+  if (list == NULL) {
+    return;
+  }
+  for (i = 0; i < list->capacity; i++) {
+    parking_memory_free(list->memory, list->entries[i].text);
+  }
+  parking_memory_free(list->memory, list->entries);
+  parking_memory_free(list->memory, list->bloom);
+  parking_memory_free(list->memory, list);
+}
+
+/**
+ * @brief 向未封存的名单加入一个车牌。
+ * @param list 目标名单。
+ * @param plate 车牌号。
+ * @return 成功返回 0，参数无效或名单已封存返回 -1，内存不足返回 -2。
+ */
+int plate_list_add(PlateList *list, const char *plate) {
+  PlateListEntry *entry;
+  PlateCode code;
+  const char *text = NULL;
+  size_t length;
+
+  if (list == NULL || plate == NULL || list->bloom != NULL) {
+    return -1;
+  }
+  length = strlen(plate);
+  if (length == 0 || length >= MAX_LICENSE_LEN) {
+    return -1;
+  }
+  if (!plate_encode(plate, &code)) {
+    text = plate;
+  }
+  if ((list->count + 1) * 2 > list->capacity && grow_entries(list) != 0) {
+    return -2;
+  }
+
+  entry = &list->entries[probe_entry(list->entries, list->capacity, &code,
+                                     text, plate_code_hash(&code))];
+  if (entry->used) {
+    return 0; /* 重复的车牌 */
+  }
+  if (text != NULL) {
+    entry->text = (char *)parking_memory_alloc(
+        list->memory, PARKING_MEMORY_INDEX, length + 1);
+    if (entry->text == NULL) {
+      return -2;
+    }
+    memcpy(entry->text, text, length + 1);
+  }
+  entry->code = code;
+  entry->used = 1;
+  list->count++;
+  return 0;
+}
+
+/**
+ * @brief 按最终条数生成布隆过滤器并封存名单。
+ * @param list 目标名单。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -2。
+ */
+int plate_list_seal(PlateList *list) {
+  unsigned long bits = 64;
+  size_t i;
+
+  if (list == NULL) {
+    return -1;
+  }
+  if (list->bloom != NULL) {
+    return 0;
+  }
+  while (bits < (unsigned long)list->count * PLATE_LIST_BLOOM_BITS) {
+    bits <<= 1;
+  }
+  list->bloom = (unsigned char *)parking_memory_calloc(
+      list->memory, PARKING_MEMORY_INDEX, (size_t)(bits / 8), 1);
+  if (list->bloom == NULL) {
+    return -2;
+  }
+  list->bloom_mask = bits - 1;
+
+  for (i = 0; i < list->capacity; i++) {
+    unsigned long hash;
+    unsigned long step;
+    int k;
+
+    if (!list->entries[i].used) {
+      continue;
+    }
+    hash = plate_code_hash(&list->entries[i].code);
+    step = bloom_step(hash);
+    for (k = 0; k < PLATE_LIST_BLOOM_HASHES; k++) {
+      unsigned long bit = (hash + (unsigned long)k * step) & list->bloom_mask;
+
+      list->bloom[bit >> 3] |= (unsigned char)(1U << (bit & 7));
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief 从文件读取名单并封存。
+ * @param memory 名单的分配来源，NULL 表示 C 堆。
+ * @param path 名单文件路径。
+ * @param[out] list 成功时接收新名单。
+ * @param[out] error_line 出错时接收出错的行号，可以为 NULL。
+ * @return 成功返回 0；参数无效返回 -1；某行无效返回 -2；内存不足返回 -3；
+ *         无法读取文件返回 -4。
+ */
+int plate_list_load(ParkingMemory *memory, const char *path, PlateList **list,
+                    int *error_line) {
+  char line[PLATE_LIST_MAX_LINE];
+  PlateList *loaded;
+  FILE *file;
+  int number = 0;
+  int result = 0;
+
+  if (error_line) {
+    *error_line = 0;
+  }
+  if (path == NULL || list == NULL) {
+    return -1;
+  }
+  *list = NULL;
+  file = fopen(path, "r");
+  if (file == NULL) {
+    return -4;
+  }
+  loaded = plate_list_create(memory);
+  if (loaded == NULL) {
+    fclose(file);
+    return -3;
+  }
+
+  while (result == 0 && fgets(line, sizeof(line), file) != NULL) {
+    char *plate;
+
+    number++;
+    /* 没有读到换行符且未到文件末尾，说明这一行超长 */
+    if (strchr(line, '\n') == NULL && !feof(file)) {
+      result = -2;
+      break;
+    }
+    plate = trim(line);
+    if (plate[0] == '\0' || plate[0] == '#') {
+      continue;
+    }
+    switch (plate_list_add(loaded, plate)) {
+    case 0:
+      break;
+    case -2:
+      result = -3;
+      break;
+    default:
+      result = -2;
+      break;
+    }
+  }
+  if (result == 0 && ferror(file)) {
+    result = -4;
+  }
+  fclose(file);
+
+  if (result == 0 && plate_list_seal(loaded) != 0) {
+    result = -3;
+  }
+  if (result != 0) {
+    if (result == -2 && error_line) {
+      *error_line = number;
+    }
+    plate_list_free(loaded);
+    return result;
+  }
+  *list = loaded;
+  return 0;
+}
+
+/**
+ * @brief 判断车牌是否在名单中。
+ * @param list 目标名单，可以为 NULL。
+ * @param plate 车牌号。
+ * @return 在名单中返回 1，否则返回 0。
+ */
+int plate_list_contains(const PlateList *list, const char *plate) {
+  PlateCode code;
+  unsigned long hash;
+  size_t at;
+  int standard;
+
+  if (list == NULL || plate == NULL || list->count == 0) {
+    return 0;
+  }
+  standard = plate_encode(plate, &code);
+  hash = plate_code_hash(&code);
+  if (list->bloom != NULL) {
+    unsigned long step = bloom_step(hash);
+    int k;
+
+    for (k = 0; k < PLATE_LIST_BLOOM_HASHES; k++) {
+      unsigned long bit = (hash + (unsigned long)k * step) & list->bloom_mask;
+
+      if ((list->bloom[bit >> 3] & (1U << (bit & 7))) == 0) {
+        return 0;
+      }
+    }
+  }
+  at = probe_entry(list->entries, list->capacity, &code,
+                   standard ? NULL : plate, hash);
+  return list->entries[at].used;
+}
@@ -0,0 +1,129 @@
+#ifndef PARKING_PLATELIST_H
+#define PARKING_PLATELIST_H
+
+#include <stddef.h>
+
+#include "parking_memory.h"
+#include "parking_plate.h"
+
+/**
+ * @file parking_platelist.h
+ * @brief 车牌名单（禁止入场名单、VIP 名单）的结构与接口声明。
+ * @details
+ * 安保部门提供的名单往往有几十万条，而每次入场都要检查。绝大多数车辆
+ * 不在名单中，因此名单分两层：先查布隆过滤器，过滤器判定“不在名单中”
+ * 即可直接返回，只需计算 PLATE_LIST_BLOOM_HASHES 个位；过滤器判定可能
+ * 在名单中（或误判，约 1%）时，再查以车牌编码为键的开放寻址哈希表确认。
+ * 标准车牌只比较编码，非标准车牌（编码为字符串哈希）再比较字符串。
+ *
+ * 名单先逐条 plate_list_add 建好，再以 plate_list_seal 按最终条数生成
+ * 布隆过滤器；封存后即为只读对象，可以被多个读者同时查询。更新名单时
+ * 建一份新名单整体替换旧名单（见 publish_plate_list），不修改旧名单。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PLATE_LIST_INITIAL 64     /**< 哈希表的初始容量（2 的幂） */
+#define PLATE_LIST_BLOOM_BITS 10  /**< 布隆过滤器每条名单占用的位数 */
+#define PLATE_LIST_BLOOM_HASHES 7 /**< 布隆过滤器的散列函数个数 */
+#define PLATE_LIST_MAX_LINE 256   /**< 名单文件单行的最大字节数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 停车场持有的名单种类。
+ */
+typedef enum PlateListKind {
+  PLATE_LIST_BLOCKED = 0, /**< 禁止入场名单。 */
+  PLATE_LIST_VIP = 1,     /**< VIP 名单，访客入场不受时段限制。 */
+  PLATE_LIST_KINDS = 2    /**< 名单种类数。 */
+} PlateListKind;
+
+/**
+ * @brief 哈希表中的一条名单。
+ */
+typedef struct PlateListEntry {
+  PlateCode code; /**< 车牌编码。 */
+  char *text;     /**< 非标准车牌的原文，标准车牌为 NULL。 */
+  int used;       /**< 该槽是否已存放名单。 */
+} PlateListEntry;
+
+/**
+ * @brief 一份车牌名单。
+ */
+typedef struct PlateList {
+  PlateListEntry *entries;  /**< 开放寻址哈希表。 */
+  size_t capacity;          /**< 哈希表容量（2 的幂），装载率不超过 1/2。 */
+  size_t count;             /**< 名单条数（去重后）。 */
+  unsigned char *bloom;     /**< 布隆过滤器位数组，封存前为 NULL。 */
+  unsigned long bloom_mask; /**< 布隆过滤器位数减 1（位数为 2 的幂）。 */
+  ParkingMemory *memory;    /**< 分配来源，NULL 表示 C 堆。 */
+  struct PlateList *retired_next; /**< 被替换后在待回收链表中的下一项。 */
+} PlateList;
+
+/**
+ *********************************************************************************
+ *                              车牌名单API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一份空名单。
+ * @param memory 名单的分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @return 成功返回名单，内存不足返回 NULL。
+ */
+PlateList *plate_list_create(ParkingMemory *memory);
+
+/**
+ * @brief 释放名单。
+ * @param list 要释放的名单，可以为 NULL。
+ */
+void plate_list_free(PlateList *list);
+
+/**
+ * @brief 向未封存的名单加入一个车牌，重复的车牌只保留一条。
+ * @param list 目标名单。
+ * @param plate 车牌号，长度须在 1 到 MAX_LICENSE_LEN - 1 字节之间。
+ * @return 成功返回 0，参数无效或名单已封存返回 -1，内存不足返回 -2。
+ */
+int plate_list_add(PlateList *list, const char *plate);
+
+/**
+ * @brief 按最终条数生成布隆过滤器并封存名单。
+ * @details 封存后名单只读，不能再加入车牌；重复封存直接返回成功。
+ * @param list 目标名单。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -2。
+ */
+int plate_list_seal(PlateList *list);
+
+/**
+ * @brief 从文件读取名单并封存。
+ * @details 每行一个车牌号，行首行尾的空白忽略，空行与 `#` 开头的行忽略。
+ * @param memory 名单的分配来源，NULL 表示 C 堆。
+ * @param path 名单文件路径。
+ * @param[out] list 成功时接收新名单。
+ * @param[out] error_line 出错时接收出错的行号，可以为 NULL。
+ * @return 成功返回 0；参数无效返回 -1；某行超长或车牌无效返回 -2；
+ *         内存不足返回 -3；无法读取文件返回 -4。
+ */
+int plate_list_load(ParkingMemory *memory, const char *path, PlateList **list,
+                    int *error_line);
+
+/**
+ * @brief 判断车牌是否在名单中。
+ * @details 封存后的名单先查布隆过滤器，多数不在名单中的车牌不访问哈希表。
+ * @param list 目标名单，可以为 NULL（视为空名单）。
+ * @param plate 车牌号。
+ * @return 在名单中返回 1，否则返回 0。
+ */
+int plate_list_contains(const PlateList *list, const char *plate);
+
+#endif /* PARKING_PLATELIST_H */
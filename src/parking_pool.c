@@ -0,0 +1,235 @@
+/**
+ * @file parking_pool.c
+ * @brief 服务层结果数据块的空闲链表池实现文件
+ * @details
+ * 该文件实现了 parking_pool.h 中声明的分级空闲链表。空闲块的前几个字节
+ * 用来保存链表的下一个指针；分片的自旋锁只保护链表头与长度，
+ * 临界区内不调用 malloc/free。
+ */
+
+#include <stdlib.h>
+
+#include "parking_pool.h"
+#include "parking_thread.h"
+
+/* ========================================================================== */
+/*                                 内部数据结构                               */
+/* ========================================================================== */
+
+/**
+ * @brief 缓存中的一个空闲块。
+ */
+typedef struct PoolBlock {
+  struct PoolBlock *next; /**< 同一级别的下一个空闲块。 */
+} PoolBlock;
+
+/**
+ * @brief 一个分片，保存全部级别的空闲链表。
+ */
+typedef struct PoolStripe {
+  volatile int lock;              /**< 自旋锁，0 表示空闲。 */
+  PoolBlock *heads[POOL_CLASSES]; /**< 各级别的空闲链表头。 */
+  int lengths[POOL_CLASSES];      /**< 各级别的空闲块数。 */
+} PoolStripe;
+
+/** 进程内全部分片，静态分配，无需初始化。 */
+static PoolStripe pool_stripes[POOL_STRIPES];
+
+static volatile long pool_cached_blocks = 0; /**< 缓存的块数。 */
+static volatile long pool_cached_bytes = 0;  /**< 缓存的字节数。 */
+static volatile long pool_hits = 0;          /**< 命中空闲链表的分配次数。 */
+static volatile long pool_misses = 0;        /**< 调用 malloc 的分配次数。 */
+
+/** 最小的块必须能放下链表指针，否则编译失败。 */
+typedef char pool_block_fits[sizeof(PoolBlock) <= POOL_MIN_BLOCK_BYTES ? 1
+                                                                       : -1];
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 选择当前线程使用的分片。
+ * @details 与 parking_metrics.c 相同，按黄金分割常数打散线程标识。
+ * @return 分片指针。
+ */
+static PoolStripe *current_stripe(void) {
+  unsigned long mixed =
+      (parking_thread_current_id() * 2654435761UL) & 0xFFFFFFFFUL;
+
+  return &pool_stripes[(mixed >> 16) & (POOL_STRIPES - 1)];
+}
+
+/**
+ * @brief (静态辅助函数) 获取分片的自旋锁。
+ * @param stripe 目标分片。
+ */
+static void stripe_lock(PoolStripe *stripe) {
+  while (parking_atomic_exchange_int(&stripe->lock, 1) != 0) {
+    while (parking_atomic_load_int(&stripe->lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放分片的自旋锁。
+ * @param stripe 目标分片。
+ */
+static void stripe_unlock(PoolStripe *stripe) {
+  parking_atomic_store_int(&stripe->lock, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 计算能容纳 size 字节的最小级别。
+ * @param size 字节数。
+ * @return 级别下标；超过最大级别时返回 POOL_CLASSES。
+ */
+static int class_of(size_t size) {
+  size_t block = POOL_MIN_BLOCK_BYTES;
+  int index = 0;
+
+  while (index < POOL_CLASSES && block < size) {
+    block <<= 1;
+    index++;
+  }
+  return index;
+}
+
+/**
+ * @brief (静态辅助函数) 计算一个级别在每个分片中最多缓存的块数。
+ * @param index 级别下标。
+ * @return 块数，至少为 1。
+ */
+static int class_limit(int index) {
+  size_t block = (size_t)POOL_MIN_BLOCK_BYTES << index;
+  size_t limit = POOL_CLASS_BUDGET_BYTES / block;
+
+  if (limit < 1) {
+    return 1;
+  }
+  return limit > POOL_MAX_CACHED ? POOL_MAX_CACHED : (int)limit;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 从池中分配一块内存。
+ * @param size 请求的字节数。
+ * @return 至少 size 字节的内存块；失败返回 NULL。
+ */
+void *pool_alloc(size_t size) {
+  int index = class_of(size);
+  size_t block_size;
+  PoolStripe *stripe;
+  PoolBlock *block;
+
+  if (index >= POOL_CLASSES) {
+    parking_atomic_add_long(&pool_misses, 1);
+    return malloc(size);
+  }
+  block_size = (size_t)POOL_MIN_BLOCK_BYTES << index;
+
+  stripe = current_stripe();
+  stripe_lock(stripe);
+  block = stripe->heads[index];
+  if (block != NULL) {
+    stripe->heads[index] = block->next;
+    stripe->lengths[index]--;
+  }
+  stripe_unlock(stripe);
+
+  if (block != NULL) {
+    parking_atomic_add_long(&pool_hits, 1);
+    parking_atomic_add_long(&pool_cached_blocks, -1);
+    parking_atomic_add_long(&pool_cached_bytes, -(long)block_size);
+    return block;
+  }
+  parking_atomic_add_long(&pool_misses, 1);
+  return malloc(block_size);
+}
+
+/**
+ * @brief 把一块内存交还给池。
+ * @param ptr 由 pool_alloc 分配的内存块，可以为 NULL。
+ * @param size 分配时请求的字节数或更小的值。
+ */
+void pool_release(void *ptr, size_t size) {
+  int index = class_of(size);
+  PoolStripe *stripe;
+  PoolBlock *block = (PoolBlock *)ptr;
+  int cached = 0;
+
+  if (ptr == NULL) {
+    return;
+  }
+  if (index >= POOL_CLASSES) {
+    free(ptr);
+    return;
+  }
+
+  stripe = current_stripe();
+  stripe_lock(stripe);
+  if (stripe->lengths[index] < class_limit(index)) {
+    block->next = stripe->heads[index];
+    stripe->heads[index] = block;
+    stripe->lengths[index]++;
+    cached = 1;
+  }
+  stripe_unlock(stripe);
+
+  if (cached) {
+    parking_atomic_add_long(&pool_cached_blocks, 1);
+    parking_atomic_add_long(&pool_cached_bytes,
+                            (long)((size_t)POOL_MIN_BLOCK_BYTES << index));
+  } else {
+    free(ptr);
+  }
+}
+
+/**
+ * @brief 释放全部分片中缓存的空闲块。
+ */
+void pool_trim(void) {
+  int s;
+  int index;
+
+  for (s = 0; s < POOL_STRIPES; s++) {
+    PoolStripe *stripe = &pool_stripes[s];
+
+    for (index = 0; index < POOL_CLASSES; index++) {
+      PoolBlock *block;
+      int length;
+
+      stripe_lock(stripe);
+      block = stripe->heads[index];
+      length = stripe->lengths[index];
+      stripe->heads[index] = NULL;
+      stripe->lengths[index] = 0;
+      stripe_unlock(stripe);
+
+      parking_atomic_add_long(&pool_cached_blocks, -(long)length);
+      parking_atomic_add_long(
+          &pool_cached_bytes,
+          -(long)length * (long)((size_t)POOL_MIN_BLOCK_BYTES << index));
+      while (block != NULL) {
+        PoolBlock *next = block->next;
+
+        free(block);
+        block = next;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 读取池的统计快照。
+ * @param[out] stats 接收快照。
+ */
+void pool_read(PoolStats *stats) {
+  stats->cached_blocks = parking_atomic_load_long(&pool_cached_blocks);
+  stats->cached_bytes = parking_atomic_load_long(&pool_cached_bytes);
+  stats->hits = parking_atomic_load_long(&pool_hits);
+  stats->misses = parking_atomic_load_long(&pool_misses);
+}
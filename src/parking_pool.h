@@ -0,0 +1,84 @@
+#ifndef PARKING_POOL_H
+#define PARKING_POOL_H
+
+/**
+ * @file parking_pool.h
+ * @brief 服务层结果数据块的空闲链表池声明。
+ * @details
+ * 服务层交给调用者的结果数据（SlotQueryResult、ParkingStatistics、费用等）
+ * 以及车位指针数组生命周期很短，轮询时每秒会反复分配、释放成千上万次。
+ * 本模块按大小分级缓存这些内存块：第 k 级的块大小为 POOL_MIN_BLOCK_BYTES
+ * 的 2^k 倍，请求的大小向上取整到所在级别；超过最大级别的请求直接调用 malloc。
+ *
+ * 缓存的块仍是普通的 malloc 内存块，不加头部，调用者直接 free()
+ * 也不会出错，只是这个块不再回到池中。空闲链表分为 POOL_STRIPES 个分片，
+ * 线程按 parking_thread_current_id 选择分片，分片内用自旋锁保护；
+ * 每个分片的每一级最多缓存 POOL_CLASS_BUDGET_BYTES 字节，超出的块直接释放。
+ */
+
+#include <stddef.h>
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define POOL_MIN_BLOCK_BYTES 64 /**< 第 0 级的块大小，必须能放下一个指针 */
+#define POOL_CLASSES 12         /**< 大小级别数，最大级别为 128KB */
+#define POOL_STRIPES 8          /**< 空闲链表分片数，必须为 2 的幂 */
+#define POOL_MAX_CACHED 32      /**< 每个分片每一级最多缓存的块数 */
+#define POOL_CLASS_BUDGET_BYTES                                                \
+  (128 * 1024) /**< 每个分片每一级最多缓存的字节数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 池的统计快照。
+ */
+typedef struct PoolStats {
+  long cached_blocks; /**< 当前缓存在空闲链表中的块数。 */
+  long cached_bytes;  /**< 当前缓存的块的总字节数。 */
+  long hits;          /**< 由空闲链表满足的分配次数。 */
+  long misses;        /**< 需要调用 malloc 的分配次数。 */
+} PoolStats;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 从池中分配一块内存。
+ * @details 优先取当前线程分片中对应级别的空闲块，没有时调用 malloc。
+ * @param size 请求的字节数。
+ * @return 至少 size 字节的内存块；失败返回 NULL。
+ */
+void *pool_alloc(size_t size);
+
+/**
+ * @brief 把一块内存交还给池。
+ * @details size 不得大于分配时请求的字节数（可以更小，例如数组只用了一部分），
+ *          块按 size 所在的级别回收；所在分片已满或 size 超过最大级别时直接释放。
+ * @param ptr 由 pool_alloc 分配的内存块，可以为 NULL。
+ * @param size 分配时请求的字节数或更小的值。
+ */
+void pool_release(void *ptr, size_t size);
+
+/**
+ * @brief 释放全部分片中缓存的空闲块。
+ */
+void pool_trim(void);
+
+/**
+ * @brief 读取池的统计快照。
+ * @param[out] stats 接收快照。
+ */
+void pool_read(PoolStats *stats);
+
+#endif /* PARKING_POOL_H */
@@ -0,0 +1,552 @@
+/**
+ * @file parking_query.c
+ * @brief 车位组合条件查询的实现文件
+ * @details
+ * 该文件实现了 parking_query.h 中声明的查询构造与执行函数。
+ * 列扫描以 SLOT_BITMAP_WORD_BITS 行为一块，每个条件把块内命中情况
+ * 并入同一个 unsigned long 掩码；掩码为 0 时跳过其余条件和整块车位节点。
+ * 字节列的比较与计数使用 parking_column.h 的向量内核，
+ * 计数时不带位置条件的块只需对掩码求置位数。
+ */
+
+#include <string.h>
+
+#include "parking_column.h"
+#include "parking_memory.h"
+#include "parking_query.h"
+
+/**
+ * @brief 并行查询中一段行的任务参数。
+ */
+typedef struct QueryChunk {
+  ParkingLot *lot;       /**< 目标停车场。 */
+  const SlotQuery *query; /**< 查询条件。 */
+  int begin;             /**< 起始行。 */
+  int end;               /**< 结束行（不含）。 */
+  int count;             /**< 第一遍：该段的命中数。 */
+  ParkingSlot **out;     /**< 第二遍：该段命中车位的写入位置。 */
+  int capacity;          /**< 第二遍：该段最多写入的车位数。 */
+} QueryChunk;
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 检查车位节点的位置描述前缀。
+ * @param query 查询条件。
+ * @param slot 车位节点。
+ * @return 满足条件（或未启用该条件）返回 1，否则返回 0。
+ */
+static int location_matches(const SlotQuery *query, const ParkingSlot *slot) {
+  if (!(query->conditions & SLOT_QUERY_LOCATION)) {
+    return 1;
+  }
+  return slot->location != NULL &&
+         strncmp(slot->location, query->location_prefix,
+                 query->location_length) == 0;
+}
+
+/**
+ * @brief (静态辅助函数) 检查一行的热字段是否满足除位置前缀外的全部条件。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param row 稠密车位表中的行号。
+ * @return 满足返回 1，否则返回 0。
+ */
+static int row_matches(const ParkingLot *lot, const SlotQuery *query, int row) {
+  const SlotHotTable *hot = &lot->hot;
+
+  if ((query->conditions & SLOT_QUERY_STATUS) &&
+      hot->status[row] != (unsigned char)query->status) {
+    return 0;
+  }
+  if ((query->conditions & SLOT_QUERY_TYPE) &&
+      hot->type[row] != (unsigned char)query->type) {
+    return 0;
+  }
+  if ((query->conditions & SLOT_QUERY_ENTRY) &&
+      (hot->status[row] != OCCUPIED_STATUS ||
+       hot->entry_time[row] < query->entry_from ||
+       hot->entry_time[row] >= query->entry_to)) {
+    return 0;
+  }
+  if ((query->conditions & SLOT_QUERY_DUE) &&
+      (hot->due_date[row] < query->due_from ||
+       hot->due_date[row] >= query->due_to)) {
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 计算一块行的状态掩码。
+ * @details 直接取空闲位图中对应的字，已占用即取反。
+ * @param lot 目标停车场。
+ * @param word 块号，即位图字的下标。
+ * @param want_free 非 0 时要求空闲，否则要求已占用。
+ * @return 块内满足状态条件的行掩码（尚未截断到块的实际行数）。
+ */
+static unsigned long status_mask(const ParkingLot *lot, size_t word,
+                                 int want_free) {
+  unsigned long bits =
+      word < lot->free_map.word_count ? lot->free_map.words[word] : 0UL;
+
+  return want_free ? bits : ~bits;
+}
+
+/**
+ * @brief (静态辅助函数) 计算一块行中满足热字段条件的掩码。
+ * @details 不含位置前缀与入场时间条件；类型列用 column_match_u8 批量比较。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param base 块的起始行，必须是 SLOT_BITMAP_WORD_BITS 的倍数。
+ * @param rows 块的行数。
+ * @return 命中掩码。
+ */
+static unsigned long block_mask(const ParkingLot *lot, const SlotQuery *query,
+                                int base, int rows) {
+  const int block = (int)SLOT_BITMAP_WORD_BITS;
+  unsigned long mask = rows == block ? ~0UL : (1UL << rows) - 1UL;
+
+  if (query->conditions & SLOT_QUERY_STATUS) {
+    mask &= status_mask(lot, (size_t)(base / block),
+                        query->status == FREE_STATUS);
+  }
+  if (mask != 0 && (query->conditions & SLOT_QUERY_TYPE)) {
+    mask &= column_match_u8(lot->hot.type + base, (size_t)rows,
+                            (unsigned char)query->type);
+  }
+  if (mask != 0 && (query->conditions & SLOT_QUERY_DUE)) {
+    mask &= column_match_time(lot->hot.due_date + base, (size_t)rows,
+                              query->due_from, query->due_to);
+  }
+  return mask;
+}
+
+/**
+ * @brief (静态辅助函数) 按列扫描稠密车位表的一段行执行查询。
+ * @param lot 目标停车场。
+ * @param query 查询条件（不含入场时间条件）。
+ * @param begin 起始行，必须是 SLOT_BITMAP_WORD_BITS 的倍数。
+ * @param end 结束行（不含）。
+ * @param[out] slots 接收命中车位的数组。
+ * @param capacity slots 数组的容量。
+ * @return 写入的车位数。
+ */
+static int scan_columns(ParkingLot *lot, const SlotQuery *query, int begin,
+                        int end, ParkingSlot **slots, int capacity) {
+  const int block = (int)SLOT_BITMAP_WORD_BITS;
+  unsigned long mask;
+  int base;
+  int rows;
+  int i;
+  int found = 0;
+
+  for (base = begin; base < end && found < capacity; base += block) {
+    rows = end - base < block ? end - base : block;
+    mask = block_mask(lot, query, base, rows);
+    for (i = 0; mask != 0 && i < rows && found < capacity; i++) {
+      if ((mask >> i) & 1UL) {
+        ParkingSlot *slot = lot->slot_table[base + i];
+
+        mask &= ~(1UL << i);
+        if (location_matches(query, slot)) {
+          slots[found++] = slot;
+        }
+      }
+    }
+  }
+  return found;
+}
+
+/**
+ * @brief (静态辅助函数) 统计稠密车位表的一段行中满足查询条件的车位数。
+ * @details 不带位置条件时每块只对命中掩码求置位数；只有类型条件时
+ *          直接用向量内核统计类型列。
+ * @param lot 目标停车场。
+ * @param query 查询条件（不含入场时间条件）。
+ * @param begin 起始行，必须是 SLOT_BITMAP_WORD_BITS 的倍数。
+ * @param end 结束行（不含）。
+ * @return 命中的车位数。
+ */
+static int count_columns(ParkingLot *lot, const SlotQuery *query, int begin,
+                         int end) {
+  const int block = (int)SLOT_BITMAP_WORD_BITS;
+  unsigned long mask;
+  int base;
+  int rows;
+  int i;
+  int count = 0;
+
+  if (query->conditions == SLOT_QUERY_TYPE) {
+    return (int)column_count_u8(lot->hot.type + begin, (size_t)(end - begin),
+                                (unsigned char)query->type);
+  }
+  for (base = begin; base < end; base += block) {
+    rows = end - base < block ? end - base : block;
+    mask = block_mask(lot, query, base, rows);
+    if (!(query->conditions & SLOT_QUERY_LOCATION)) {
+      count += column_popcount(mask);
+      continue;
+    }
+    for (i = 0; mask != 0 && i < rows; i++) {
+      if ((mask >> i) & 1UL) {
+        mask &= ~(1UL << i);
+        count += location_matches(query, lot->slot_table[base + i]);
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief (静态辅助函数) 沿入场时间链表执行带入场时间条件的查询。
+ * @details 链表按入场时间从早到晚排列，遇到不早于区间上界的车位即停止。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param[out] slots 接收命中车位的数组。
+ * @param capacity slots 数组的容量。
+ * @return 写入的车位数。
+ */
+static int walk_entry_order(ParkingLot *lot, const SlotQuery *query,
+                            ParkingSlot **slots, int capacity) {
+  ParkingSlot *slot;
+  int found = 0;
+
+  for (slot = lot->entry_order.oldest; slot != NULL && found < capacity;
+       slot = slot->entry_next) {
+    if (slot->entry_time >= query->entry_to) {
+      break;
+    }
+    if (slot->entry_time >= query->entry_from &&
+        row_matches(lot, query, slot->table_index) &&
+        location_matches(query, slot)) {
+      slots[found++] = slot;
+    }
+  }
+  return found;
+}
+
+/**
+ * @brief (静态辅助函数) 并行查询第一遍：统计一段行的命中数。
+ * @param arg 对应的 QueryChunk 对象。
+ */
+static void count_chunk(void *arg) {
+  QueryChunk *chunk = (QueryChunk *)arg;
+
+  chunk->count =
+      count_columns(chunk->lot, chunk->query, chunk->begin, chunk->end);
+}
+
+/**
+ * @brief (静态辅助函数) 并行查询第二遍：把一段行的命中车位写到各自的位置。
+ * @param arg 对应的 QueryChunk 对象。
+ */
+static void fill_chunk(void *arg) {
+  QueryChunk *chunk = (QueryChunk *)arg;
+
+  scan_columns(chunk->lot, chunk->query, chunk->begin, chunk->end, chunk->out,
+               chunk->capacity);
+}
+
+/**
+ * @brief (静态辅助函数) 把稠密车位表切分成按位图字对齐的若干段。
+ * @details 段数约为工作线程数的 PARKING_QUERY_CHUNKS_PER_WORKER 倍，
+ *          以便工作窃取在段与段的命中密度不同时平衡负载；
+ *          每段不少于 PARKING_QUERY_MIN_CHUNK_ROWS 行。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param pool 任务池。
+ * @param[out] chunk_count 接收段数。
+ * @return 成功返回段数组（经 lot->memory 分配），内存不足返回 NULL。
+ */
+static QueryChunk *split_rows(ParkingLot *lot, const SlotQuery *query,
+                              ParkingTaskPool *pool, int *chunk_count) {
+  const int block = (int)SLOT_BITMAP_WORD_BITS;
+  ParkingTaskPoolStats stats;
+  QueryChunk *chunks;
+  int rows;
+  int count;
+  int i;
+
+  parking_task_pool_stats(pool, &stats);
+  rows = lot->slot_count / (stats.workers * PARKING_QUERY_CHUNKS_PER_WORKER);
+  if (rows < PARKING_QUERY_MIN_CHUNK_ROWS) {
+    rows = PARKING_QUERY_MIN_CHUNK_ROWS;
+  }
+  rows = (rows + block - 1) / block * block;
+  count = (lot->slot_count + rows - 1) / rows;
+  chunks = (QueryChunk *)parking_memory_alloc(
+      &lot->memory, PARKING_MEMORY_IO, (size_t)count * sizeof(QueryChunk));
+  if (chunks == NULL) {
+    return NULL;
+  }
+  for (i = 0; i < count; i++) {
+    chunks[i].lot = lot;
+    chunks[i].query = query;
+    chunks[i].begin = i * rows;
+    chunks[i].end = i == count - 1 ? lot->slot_count : (i + 1) * rows;
+    chunks[i].count = 0;
+    chunks[i].out = NULL;
+    chunks[i].capacity = 0;
+  }
+  *chunk_count = count;
+  return chunks;
+}
+
+/**
+ * @brief (静态辅助函数) 判断查询是否应当并行执行。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param pool 任务池，可以为 NULL。
+ * @return 应当并行返回 1，否则返回 0。
+ */
+static int use_parallel(const ParkingLot *lot, const SlotQuery *query,
+                        ParkingTaskPool *pool) {
+  return pool != NULL && !(query->conditions & SLOT_QUERY_ENTRY) &&
+         lot->slot_count >= PARKING_QUERY_PARALLEL_MIN_ROWS;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 把查询初始化为不带任何条件。
+ * @param query 目标查询。
+ */
+void slot_query_init(SlotQuery *query) { memset(query, 0, sizeof(*query)); }
+
+/**
+ * @brief 添加占用状态条件。
+ * @param query 目标查询。
+ * @param status 要求的占用状态。
+ */
+void slot_query_where_status(SlotQuery *query, ParkingStatus status) {
+  query->conditions |= SLOT_QUERY_STATUS;
+  query->status = status;
+}
+
+/**
+ * @brief 添加停车类型条件。
+ * @param query 目标查询。
+ * @param type 要求的停车类型。
+ */
+void slot_query_where_type(SlotQuery *query, ParkingType type) {
+  query->conditions |= SLOT_QUERY_TYPE;
+  query->type = type;
+}
+
+/**
+ * @brief 添加位置描述前缀条件。
+ * @param query 目标查询。
+ * @param prefix 位置描述前缀。
+ */
+void slot_query_where_location(SlotQuery *query, const char *prefix) {
+  if (prefix == NULL || prefix[0] == '\0') {
+    return;
+  }
+  query->conditions |= SLOT_QUERY_LOCATION;
+  query->location_prefix = prefix;
+  query->location_length = strlen(prefix);
+}
+
+/**
+ * @brief 添加入场时间区间条件。
+ * @param query 目标查询。
+ * @param from 入场时间下界（含）。
+ * @param to 入场时间上界（不含）。
+ */
+void slot_query_where_entry(SlotQuery *query, time_t from, time_t to) {
+  query->conditions |= SLOT_QUERY_ENTRY;
+  query->entry_from = from;
+  query->entry_to = to;
+}
+
+/**
+ * @brief 添加月费到期时间区间条件。
+ * @param query 目标查询。
+ * @param from 到期时间下界（含）。
+ * @param to 到期时间上界（不含）。
+ */
+void slot_query_where_due(SlotQuery *query, time_t from, time_t to) {
+  query->conditions |= SLOT_QUERY_DUE;
+  query->due_from = from;
+  query->due_to = to;
+}
+
+/**
+ * @brief 执行组合查询。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param[out] slots 接收命中车位的数组。
+ * @param capacity slots 数组的容量。
+ * @return 写入的车位数；参数无效时返回 -1。
+ */
+int query_slots(ParkingLot *lot, const SlotQuery *query, ParkingSlot **slots,
+                int capacity) {
+  if (lot == NULL || query == NULL || (slots == NULL && capacity > 0)) {
+    return -1;
+  }
+  if (capacity <= 0) {
+    return 0;
+  }
+  if (query->conditions & SLOT_QUERY_ENTRY) {
+    if ((query->conditions & SLOT_QUERY_STATUS) &&
+        query->status != OCCUPIED_STATUS) {
+      return 0;
+    }
+    return walk_entry_order(lot, query, slots, capacity);
+  }
+  return scan_columns(lot, query, 0, lot->slot_count, slots, capacity);
+}
+
+/**
+ * @brief 统计满足查询条件的车位数。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @return 命中的车位数；参数无效时返回 -1。
+ */
+int count_query_slots(ParkingLot *lot, const SlotQuery *query) {
+  ParkingSlot *slot;
+  int count = 0;
+
+  if (lot == NULL || query == NULL) {
+    return -1;
+  }
+  if (query->conditions & SLOT_QUERY_ENTRY) {
+    if ((query->conditions & SLOT_QUERY_STATUS) &&
+        query->status != OCCUPIED_STATUS) {
+      return 0;
+    }
+    for (slot = lot->entry_order.oldest;
+         slot != NULL && slot->entry_time < query->entry_to;
+         slot = slot->entry_next) {
+      count += slot->entry_time >= query->entry_from &&
+               row_matches(lot, query, slot->table_index) &&
+               location_matches(query, slot);
+    }
+    return count;
+  }
+  return count_columns(lot, query, 0, lot->slot_count);
+}
+
+/**
+ * @brief 估算查询命中数的上界。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @return 命中数的上界；参数无效时返回 0。
+ */
+int query_slots_bound(const ParkingLot *lot, const SlotQuery *query) {
+  int occupied_only;
+
+  if (lot == NULL || query == NULL) {
+    return 0;
+  }
+  occupied_only = (query->conditions & SLOT_QUERY_ENTRY) ||
+                  ((query->conditions & SLOT_QUERY_STATUS) &&
+                   query->status == OCCUPIED_STATUS);
+  if ((query->conditions & SLOT_QUERY_STATUS) &&
+      query->status == FREE_STATUS) {
+    return (query->conditions & SLOT_QUERY_ENTRY) ? 0 : lot->free_slot_count;
+  }
+  if (occupied_only && (query->conditions & SLOT_QUERY_TYPE)) {
+    return query->type == RESIDENT_TYPE ? lot->occupied_resident_count
+                                        : lot->occupied_visitor_count;
+  }
+  return occupied_only ? lot->occupied_slots : lot->slot_count;
+}
+
+/**
+ * @brief 在任务池中并行执行组合查询。
+ * @details
+ * 两遍完成：第一遍各段并行统计命中数，按段的顺序求前缀和得到每段的
+ * 写入位置；第二遍各段并行把命中车位写到 slots 中自己的区间，
+ * 写入位置已超出 capacity 的段不再扫描。结果与 query_slots 逐项相同。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param[out] slots 接收命中车位的数组。
+ * @param capacity slots 数组的容量。
+ * @param pool 任务池，可以为 NULL。
+ * @return 写入的车位数；参数无效时返回 -1，内存不足返回 -3。
+ */
+int query_slots_parallel(ParkingLot *lot, const SlotQuery *query,
+                         ParkingSlot **slots, int capacity,
+                         ParkingTaskPool *pool) {
+  ParkingTaskGroup group;
+  QueryChunk *chunks;
+  int chunk_count;
+  int written = 0;
+  int i;
+
+  if (lot == NULL || query == NULL || (slots == NULL && capacity > 0)) {
+    return -1;
+  }
+  if (capacity <= 0 || !use_parallel(lot, query, pool)) {
+    return query_slots(lot, query, slots, capacity);
+  }
+  chunks = split_rows(lot, query, pool, &chunk_count);
+  if (chunks == NULL) {
+    return -3;
+  }
+
+  parking_task_group_init(&group);
+  for (i = 0; i < chunk_count; i++) {
+    parking_task_pool_submit(pool, &group, count_chunk, &chunks[i]);
+  }
+  parking_task_group_wait(pool, &group);
+
+  parking_task_group_init(&group);
+  for (i = 0; i < chunk_count && written < capacity; i++) {
+    if (chunks[i].count == 0) {
+      continue;
+    }
+    chunks[i].out = slots + written;
+    chunks[i].capacity = capacity - written < chunks[i].count
+                             ? capacity - written
+                             : chunks[i].count;
+    written += chunks[i].capacity;
+    parking_task_pool_submit(pool, &group, fill_chunk, &chunks[i]);
+  }
+  parking_task_group_wait(pool, &group);
+  parking_memory_free(&lot->memory, chunks);
+  return written;
+}
+
+/**
+ * @brief 在任务池中并行统计满足查询条件的车位数。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param pool 任务池，可以为 NULL。
+ * @return 命中的车位数；参数无效时返回 -1，内存不足返回 -3。
+ */
+int count_query_slots_parallel(ParkingLot *lot, const SlotQuery *query,
+                               ParkingTaskPool *pool) {
+  ParkingTaskGroup group;
+  QueryChunk *chunks;
+  int chunk_count;
+  int count = 0;
+  int i;
+
+  if (lot == NULL || query == NULL) {
+    return -1;
+  }
+  if (!use_parallel(lot, query, pool)) {
+    return count_query_slots(lot, query);
+  }
+  chunks = split_rows(lot, query, pool, &chunk_count);
+  if (chunks == NULL) {
+    return -3;
+  }
+  parking_task_group_init(&group);
+  for (i = 0; i < chunk_count; i++) {
+    parking_task_pool_submit(pool, &group, count_chunk, &chunks[i]);
+  }
+  parking_task_group_wait(pool, &group);
+  for (i = 0; i < chunk_count; i++) {
+    count += chunks[i].count;
+  }
+  parking_memory_free(&lot->memory, chunks);
+  return count;
+}
@@ -0,0 +1,176 @@
+#ifndef PARKING_QUERY_H
+#define PARKING_QUERY_H
+
+#include <time.h>
+
+#include "parking_data.h"
+#include "parking_tasks.h"
+
+/**
+ * @file parking_query.h
+ * @brief 车位组合条件查询的声明。
+ * @details
+ * SlotQuery 由若干可以任意组合的条件构成：占用状态、停车类型、位置前缀、
+ * 入场时间区间与月费到期区间，全部条件同时满足的车位才算命中。
+ * 查询按热字段列逐列求值：每次取稠密车位表的一个位图字宽度的行，
+ * 状态直接取空闲位图的对应字，类型与时间戳在列上批量比较得到命中掩码，
+ * 只有掩码中仍然命中的行才访问车位节点核对位置前缀。
+ * 带入场时间条件时改由入场时间链表驱动，只走到区间上界为止。
+ *
+ * 十万车位以上的大停车场可以用 query_slots_parallel 与
+ * count_query_slots_parallel 把稠密车位表分段交给任务池（见 parking_tasks.h）
+ * 并行扫描；调用者照常持有停车场的读锁，工作线程在此期间只读停车场。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define SLOT_QUERY_STATUS 0x01U   /**< 按占用状态筛选 */
+#define SLOT_QUERY_TYPE 0x02U     /**< 按停车类型筛选 */
+#define SLOT_QUERY_LOCATION 0x04U /**< 按位置描述前缀筛选 */
+#define SLOT_QUERY_ENTRY 0x08U    /**< 按入场时间区间筛选 */
+#define SLOT_QUERY_DUE 0x10U      /**< 按月费到期时间区间筛选 */
+
+#define PARKING_QUERY_PARALLEL_MIN_ROWS 32768 /**< 并行扫描的最少车位数 */
+#define PARKING_QUERY_MIN_CHUNK_ROWS 4096     /**< 并行扫描每段的最少行数 */
+#define PARKING_QUERY_CHUNKS_PER_WORKER 4     /**< 每个工作线程平均分到的段数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一组组合查询条件。
+ * @details 用 slot_query_init 初始化后由 slot_query_where_* 逐个添加条件；
+ *          时间区间均为左闭右开 [from, to)。
+ */
+typedef struct SlotQuery {
+  unsigned int conditions;     /**< 已启用的条件（SLOT_QUERY_* 的按位或）。 */
+  ParkingStatus status;        /**< 占用状态条件。 */
+  ParkingType type;            /**< 停车类型条件。 */
+  const char *location_prefix; /**< 位置描述前缀，查询期间须保持有效。 */
+  size_t location_length;      /**< 位置描述前缀的字节数。 */
+  time_t entry_from;           /**< 入场时间下界（含）。 */
+  time_t entry_to;             /**< 入场时间上界（不含）。 */
+  time_t due_from;             /**< 月费到期时间下界（含）。 */
+  time_t due_to;               /**< 月费到期时间上界（不含）。 */
+} SlotQuery;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 把查询初始化为不带任何条件（匹配全部车位）。
+ * @param query 目标查询。
+ */
+void slot_query_init(SlotQuery *query);
+
+/**
+ * @brief 添加占用状态条件。
+ * @param query 目标查询。
+ * @param status 要求的占用状态。
+ */
+void slot_query_where_status(SlotQuery *query, ParkingStatus status);
+
+/**
+ * @brief 添加停车类型条件。
+ * @param query 目标查询。
+ * @param type 要求的停车类型。
+ */
+void slot_query_where_type(SlotQuery *query, ParkingType type);
+
+/**
+ * @brief 添加位置描述前缀条件（例如 "B-" 表示 B 区）。
+ * @param query 目标查询。
+ * @param prefix 位置描述前缀，只保存指针；为 NULL 或空串时不添加条件。
+ */
+void slot_query_where_location(SlotQuery *query, const char *prefix);
+
+/**
+ * @brief 添加入场时间区间条件。
+ * @details 只有在场车位有入场时间，因此该条件隐含“已占用”。
+ * @param query 目标查询。
+ * @param from 入场时间下界（含）。
+ * @param to 入场时间上界（不含）。
+ */
+void slot_query_where_entry(SlotQuery *query, time_t from, time_t to);
+
+/**
+ * @brief 添加月费到期时间区间条件。
+ * @param query 目标查询。
+ * @param from 到期时间下界（含）。
+ * @param to 到期时间上界（不含）。
+ */
+void slot_query_where_due(SlotQuery *query, time_t from, time_t to);
+
+/**
+ * @brief 执行组合查询。
+ * @details 不带入场时间条件时按稠密车位表顺序返回，带入场时间条件时按入场
+ *          时间从早到晚返回；写满 capacity 个后立即停止。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param[out] slots 接收命中车位的数组。
+ * @param capacity slots 数组的容量。
+ * @return 写入的车位数；参数无效时返回 -1。
+ */
+int query_slots(ParkingLot *lot, const SlotQuery *query, ParkingSlot **slots,
+                int capacity);
+
+/**
+ * @brief 统计满足查询条件的车位数。
+ * @details 与 query_slots 的执行方式相同，但不写出车位：不带位置条件时
+ *          每块只对命中掩码求置位数，不访问车位节点；只有类型条件时
+ *          直接用向量内核统计类型列。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @return 命中的车位数；参数无效时返回 -1。
+ */
+int count_query_slots(ParkingLot *lot, const SlotQuery *query);
+
+/**
+ * @brief 在任务池中并行执行组合查询。
+ * @details 结果与 query_slots 逐项相同（同样按稠密车位表顺序）。
+ *          pool 为 NULL、车位数少于 PARKING_QUERY_PARALLEL_MIN_ROWS
+ *          或带入场时间条件（由链表驱动）时退回 query_slots。
+ * @note 调用者须持有停车场的读锁，且不能在任务池的任务中调用。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param[out] slots 接收命中车位的数组。
+ * @param capacity slots 数组的容量。
+ * @param pool 任务池，可以为 NULL。
+ * @return 写入的车位数；参数无效时返回 -1，内存不足返回 -3。
+ */
+int query_slots_parallel(ParkingLot *lot, const SlotQuery *query,
+                         ParkingSlot **slots, int capacity,
+                         ParkingTaskPool *pool);
+
+/**
+ * @brief 在任务池中并行统计满足查询条件的车位数。
+ * @details 退回串行的条件与 query_slots_parallel 相同。
+ * @note 调用者须持有停车场的读锁，且不能在任务池的任务中调用。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param pool 任务池，可以为 NULL。
+ * @return 命中的车位数；参数无效时返回 -1，内存不足返回 -3。
+ */
+int count_query_slots_parallel(ParkingLot *lot, const SlotQuery *query,
+                               ParkingTaskPool *pool);
+
+/**
+ * @brief 估算查询命中数的上界。
+ * @details 只读取停车场的计数器，用于为 query_slots 分配结果数组。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @return 命中数的上界；参数无效时返回 0。
+ */
+int query_slots_bound(const ParkingLot *lot, const SlotQuery *query);
+
+#endif /* PARKING_QUERY_H */
@@ -0,0 +1,1015 @@
+/**
+ * @file parking_registry.c
+ * @brief 停车场注册表实现文件
+ * @details
+ * 该文件实现了 parking_registry.h 中声明的多停车场注册表。
+ * 站点表是按站点编号哈希的链地址表，由读写锁保护；每个站点另有一个
+ * busy 标志，由保存或关闭它的线程以原子交换占有，保证同一站点在任一
+ * 时刻只有一个线程在写快照。工作线程在读锁内占有站点，随后在锁外保存，
+ * 因此保存期间其他线程仍可查找站点。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parking_registry.h"
+#include "parking_saver.h"
+#include "parking_thread.h"
+
+#define REGISTRY_INITIAL_BUCKETS 64 /**< 站点表的初始桶数，必须为 2 的幂 */
+#define REGISTRY_BUSY_WAIT_MS 1     /**< 等待站点空闲时每次等待的毫秒数 */
+
+/**
+ * @brief 一个已打开的站点。
+ */
+typedef struct RegistrySite {
+  struct RegistrySite *next; /**< 同一桶中的下一个站点。 */
+  unsigned long hash;        /**< 站点编号的哈希值。 */
+  ParkingLot *lot;           /**< 站点的停车场。 */
+  volatile int busy;         /**< 非 0 表示有线程正在保存或关闭该站点。 */
+  volatile int pins;         /**< 以 parking_registry_acquire 借出的次数。 */
+  volatile int closing;      /**< 非 0 表示站点正在关闭，不再借出。 */
+  long saved_mutation; /**< 上次保存开始时的修改次数，-1 表示从未保存。 */
+  time_t saved_at;     /**< 上次尝试保存（或打开）的时刻。 */
+  char site_id[PARKING_REGISTRY_MAX_SITE_ID + 1]; /**< 站点编号。 */
+} RegistrySite;
+
+/**
+ * @brief parking_registry_map 中一个站点的任务参数。
+ */
+typedef struct SiteMapJob {
+  ParkingSiteMapFn fn; /**< 对站点执行的函数。 */
+  RegistrySite *site;  /**< 目标站点。 */
+  void *partial;       /**< 该站点的部分结果。 */
+  void *ctx;           /**< 调用者的上下文指针。 */
+} SiteMapJob;
+
+/**
+ * @brief 报表中一个站点的部分结果。
+ */
+typedef struct SiteReportPartial {
+  ParkingSiteReport site; /**< 站点统计。 */
+  int longest_count;      /**< longest 中的有效项数。 */
+  ParkingChainVehicle
+      longest[PARKING_REGISTRY_REPORT_TOP]; /**< 站点内停得最久的车辆。 */
+} SiteReportPartial;
+
+/**
+ * @brief 一个自动保存工作线程。
+ */
+typedef struct RegistryWorker {
+  struct ParkingRegistry *registry; /**< 所属注册表。 */
+  ParkingThread *thread;            /**< 线程句柄。 */
+  ParkingSignal *signal;            /**< 停止时触发。 */
+} RegistryWorker;
+
+/**
+ * @brief 停车场注册表。
+ */
+struct ParkingRegistry {
+  char directory[PARKING_REGISTRY_MAX_PATH]; /**< 站点快照所在目录。 */
+  ParkingAllocator allocator; /**< 各停车场共用的分配函数。 */
+  int has_allocator;          /**< 0 表示使用 C 标准库。 */
+  ParkingRwLock *lock;        /**< 保护站点表。 */
+  RegistrySite **buckets;     /**< 站点表的桶数组。 */
+  size_t bucket_count;        /**< 桶数，2 的幂。 */
+  int site_count;             /**< 已打开的站点数。 */
+  unsigned int autosave_seconds; /**< 两次自动保存的最短间隔（秒）。 */
+  volatile int stopping;      /**< 非 0 时工作线程退出。 */
+  ParkingSignal *idle;        /**< 关闭中的站点最后一次归还时触发。 */
+  int worker_count;           /**< 工作线程数。 */
+  RegistryWorker workers[PARKING_REGISTRY_MAX_WORKERS]; /**< 工作线程。 */
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 校验站点编号并计算它的哈希值。
+ * @param site_id 站点编号。
+ * @param[out] hash 接收 FNV-1a 哈希值。
+ * @return 有效返回 0；为 NULL、为空、过长或含有不允许的字符返回 -1。
+ */
+static int site_id_hash(const char *site_id, unsigned long *hash) {
+  unsigned long value = 2166136261UL;
+  size_t length = 0;
+
+  if (site_id == NULL || site_id[0] == '\0') {
+    return -1;
+  }
+  for (; site_id[length] != '\0'; length++) {
+    char c = site_id[length];
+
+    if (length >= PARKING_REGISTRY_MAX_SITE_ID ||
+        !((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+          (c >= '0' && c <= '9') || c == '-' || c == '_')) {
+      return -1;
+    }
+    value = ((value ^ (unsigned char)c) * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  *hash = value;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 在站点表中查找站点。
+ * @note 须持有站点表的锁。
+ * @param registry 注册表。
+ * @param site_id 已校验的站点编号。
+ * @param hash 站点编号的哈希值。
+ * @return 找到返回站点，否则返回 NULL。
+ */
+static RegistrySite *find_site(ParkingRegistry *registry, const char *site_id,
+                               unsigned long hash) {
+  RegistrySite *site = registry->buckets[hash & (registry->bucket_count - 1)];
+
+  while (site != NULL &&
+         (site->hash != hash || strcmp(site->site_id, site_id) != 0)) {
+    site = site->next;
+  }
+  return site;
+}
+
+/**
+ * @brief (静态辅助函数) 把站点插入站点表，站点数超过桶数时先加倍桶数。
+ * @details 扩容失败时仍插入到原有的桶中，只是链更长。
+ * @note 须持有站点表的写锁。
+ * @param registry 注册表。
+ * @param site 要插入的站点。
+ */
+static void insert_site(ParkingRegistry *registry, RegistrySite *site) {
+  RegistrySite **buckets;
+  size_t count = registry->bucket_count * 2;
+  size_t i;
+
+  if ((size_t)registry->site_count >= registry->bucket_count) {
+    buckets = (RegistrySite **)calloc(count, sizeof(RegistrySite *));
+    if (buckets != NULL) {
+      for (i = 0; i < registry->bucket_count; i++) {
+        while (registry->buckets[i] != NULL) {
+          RegistrySite *moved = registry->buckets[i];
+
+          registry->buckets[i] = moved->next;
+          moved->next = buckets[moved->hash & (count - 1)];
+          buckets[moved->hash & (count - 1)] = moved;
+        }
+      }
+      free(registry->buckets);
+      registry->buckets = buckets;
+      registry->bucket_count = count;
+    }
+  }
+  i = site->hash & (registry->bucket_count - 1);
+  site->next = registry->buckets[i];
+  registry->buckets[i] = site;
+  registry->site_count++;
+}
+
+/**
+ * @brief (静态辅助函数) 把站点从站点表中摘下。
+ * @note 须持有站点表的写锁。
+ * @param registry 注册表。
+ * @param site 站点表中的站点。
+ */
+static void unlink_site(ParkingRegistry *registry, RegistrySite *site) {
+  RegistrySite **link =
+      &registry->buckets[site->hash & (registry->bucket_count - 1)];
+
+  while (*link != site) {
+    link = &(*link)->next;
+  }
+  *link = site->next;
+  registry->site_count--;
+}
+
+/**
+ * @brief (静态辅助函数) 拼出站点的快照路径。
+ * @details 注册表创建时已确认目录加上最长的站点编号也不会超长。
+ * @param registry 注册表。
+ * @param site_id 已校验的站点编号。
+ * @param[out] path 接收路径（PARKING_REGISTRY_MAX_PATH 字节）。
+ */
+static void site_path(const ParkingRegistry *registry, const char *site_id,
+                      char *path) {
+  sprintf(path, "%s/%s%s", registry->directory, site_id,
+          PARKING_REGISTRY_SUFFIX);
+}
+
+/**
+ * @brief (静态辅助函数) 等待并占有站点。
+ * @param registry 注册表。
+ * @param site 目标站点。
+ */
+static void claim_site(ParkingRegistry *registry, RegistrySite *site) {
+  while (parking_atomic_exchange_int(&site->busy, 1) != 0) {
+    parking_signal_wait(registry->idle, REGISTRY_BUSY_WAIT_MS);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放对站点的占有。
+ * @details 释放后调用者不得再访问该站点，关闭它的线程可能随即释放它。
+ * @param site 已占有的站点。
+ */
+static void release_site(RegistrySite *site) {
+  parking_atomic_store_int(&site->busy, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 判断站点自上次保存以来是否有修改。
+ * @note 须已占有站点。
+ * @param site 目标站点。
+ * @return 有修改（或从未保存）返回 1，否则返回 0。
+ */
+static int site_dirty(const RegistrySite *site) {
+  return site->saved_mutation < 0 ||
+         parking_atomic_load_long(&site->lot->mutation_count) !=
+             site->saved_mutation;
+}
+
+/**
+ * @brief (静态辅助函数) 以写时复制快照保存已占有的站点。
+ * @details 先记下修改次数再保存，保存期间的修改留给下一次保存；
+ *          失败时同样更新 saved_at，自动保存在一个间隔后才重试。
+ * @note 须已占有站点，且不得持有该停车场的锁。
+ * @param registry 注册表。
+ * @param site 目标站点。
+ * @return 成功返回 0，文件写入失败返回 -1，内存不足返回 -2。
+ */
+static int save_site(ParkingRegistry *registry, RegistrySite *site) {
+  char path[PARKING_REGISTRY_MAX_PATH];
+  long mutation = parking_atomic_load_long(&site->lot->mutation_count);
+  int result;
+
+  site_path(registry, site->site_id, path);
+  result = parking_saver_save(site->lot, path, 1);
+  if (result == 0) {
+    site->saved_mutation = mutation;
+  }
+  site->saved_at = time(NULL);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 找出一个应当自动保存的站点并占有它。
+ * @details 在读锁内逐个尝试占有站点，占有后再判断是否到期，
+ *          未到期或无修改的站点立即释放。
+ * @param registry 注册表。
+ * @return 找到返回已占有的站点，否则返回 NULL。
+ */
+static RegistrySite *claim_due_site(ParkingRegistry *registry) {
+  RegistrySite *found = NULL;
+  time_t now = time(NULL);
+  size_t i;
+
+  parking_rwlock_read_lock(registry->lock);
+  for (i = 0; i < registry->bucket_count && found == NULL; i++) {
+    RegistrySite *site;
+
+    for (site = registry->buckets[i]; site != NULL; site = site->next) {
+      if (parking_atomic_exchange_int(&site->busy, 1) != 0) {
+        continue;
+      }
+      if (site_dirty(site) &&
+          difftime(now, site->saved_at) >= registry->autosave_seconds) {
+        found = site;
+        break;
+      }
+      release_site(site);
+    }
+  }
+  parking_rwlock_read_unlock(registry->lock);
+  return found;
+}
+
+/**
+ * @brief (静态辅助函数) 自动保存工作线程的主循环。
+ * @details 到期的站点逐个保存，没有到期的站点时等待
+ *          PARKING_REGISTRY_POLL_MS 毫秒或停止信号。
+ * @param arg 对应的 RegistryWorker 对象。
+ */
+static void registry_worker(void *arg) {
+  RegistryWorker *worker = (RegistryWorker *)arg;
+  ParkingRegistry *registry = worker->registry;
+  RegistrySite *site;
+
+  while (!parking_atomic_load_int(&registry->stopping)) {
+    site = claim_due_site(registry);
+    if (site != NULL) {
+      save_site(registry, site);
+      release_site(site);
+      continue;
+    }
+    parking_signal_wait(worker->signal, PARKING_REGISTRY_POLL_MS);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 停止并回收已启动的工作线程。
+ * @param registry 注册表。
+ */
+static void stop_workers(ParkingRegistry *registry) {
+  int i;
+
+  parking_atomic_store_int(&registry->stopping, 1);
+  for (i = 0; i < registry->worker_count; i++) {
+    parking_signal_notify(registry->workers[i].signal);
+  }
+  for (i = 0; i < registry->worker_count; i++) {
+    parking_thread_join(registry->workers[i].thread);
+    parking_signal_destroy(registry->workers[i].signal);
+  }
+  registry->worker_count = 0;
+}
+
+/**
+ * @brief (静态辅助函数) 释放注册表自身的资源（不含站点）。
+ * @param registry 注册表。
+ */
+static void free_registry(ParkingRegistry *registry) {
+  parking_signal_destroy(registry->idle);
+  parking_rwlock_destroy(registry->lock);
+  free(registry->buckets);
+  free(registry);
+}
+
+/**
+ * @brief (静态辅助函数) 加载或新建站点的停车场。
+ * @param registry 注册表。
+ * @param site_id 已校验的站点编号。
+ * @param total_slots 新建时的总容量。
+ * @param[out] created 新建时置 1，加载时置 0。
+ * @return 成功返回停车场；快照存在但无法加载或内存不足时返回 NULL。
+ */
+static ParkingLot *open_lot(ParkingRegistry *registry, const char *site_id,
+                            int total_slots, int *created) {
+  const ParkingAllocator *allocator =
+      registry->has_allocator ? &registry->allocator : NULL;
+  char path[PARKING_REGISTRY_MAX_PATH];
+  FILE *file;
+
+  site_path(registry, site_id, path);
+  file = fopen(path, "rb");
+  *created = file == NULL;
+  if (file == NULL) {
+    return init_parking_lot_with_allocator(total_slots, allocator);
+  }
+  fclose(file);
+  return load_parking_snapshot_with_allocator(path, allocator);
+}
+
+/**
+ * @brief (静态辅助函数) 任务池中执行一个站点的 map 函数。
+ * @param arg 对应的 SiteMapJob 对象。
+ */
+static void run_site_job(void *arg) {
+  SiteMapJob *job = (SiteMapJob *)arg;
+
+  job->fn(job->site->site_id, job->site->lot, job->partial, job->ctx);
+}
+
+/**
+ * @brief (静态辅助函数) 读取一个站点的统计与停得最久的车辆。
+ * @details 统计不加锁读取原子计数；车牌在读锁内复制出来，
+ *          释放锁后车位可能随即出场。
+ * @param site_id 站点编号。
+ * @param lot 该站点的停车场。
+ * @param partial 对应的 SiteReportPartial。
+ * @param ctx 未使用。
+ */
+static void report_site(const char *site_id, ParkingLot *lot, void *partial,
+                        void *ctx) {
+  SiteReportPartial *result = (SiteReportPartial *)partial;
+  ParkedVehicle parked[PARKING_REGISTRY_REPORT_TOP];
+  int i;
+
+  (void)ctx;
+  strcpy(result->site.site_id, site_id);
+  parking_service_fast_get_statistics(lot, &result->site.stats);
+  parking_lot_read_lock(lot);
+  result->longest_count =
+      get_longest_parked(lot, PARKING_REGISTRY_REPORT_TOP, parked);
+  for (i = 0; i < result->longest_count; i++) {
+    ParkingChainVehicle *vehicle = &result->longest[i];
+
+    strcpy(vehicle->site_id, site_id);
+    vehicle->slot_id = parked[i].slot->slot_id;
+    string_copy_bounded(vehicle->license_plate,
+                        parked[i].slot->license_plate, MAX_LICENSE_LEN);
+    vehicle->duration_seconds = parked[i].duration_seconds;
+  }
+  parking_lot_read_unlock(lot);
+}
+
+/**
+ * @brief (静态辅助函数) qsort 比较函数：按站点编号排序。
+ */
+static int compare_site_reports(const void *a, const void *b) {
+  return strcmp(((const ParkingSiteReport *)a)->site_id,
+                ((const ParkingSiteReport *)b)->site_id);
+}
+
+/**
+ * @brief (静态辅助函数) qsort 比较函数：按停车时长从长到短排序。
+ */
+static int compare_chain_vehicles(const void *a, const void *b) {
+  long left = ((const ParkingChainVehicle *)a)->duration_seconds;
+  long right = ((const ParkingChainVehicle *)b)->duration_seconds;
+
+  return (left < right) - (left > right);
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 创建注册表并启动自动保存工作线程。
+ * @param directory 存放站点快照的目录。
+ * @param allocator 各停车场共用的分配函数，NULL 表示 C 标准库。
+ * @param workers 自动保存工作线程数。
+ * @param autosave_seconds 同一站点两次自动保存的最短间隔（秒）。
+ * @return 成功返回句柄，失败返回 NULL。
+ */
+ParkingRegistry *parking_registry_create(const char *directory,
+                                         const ParkingAllocator *allocator,
+                                         int workers,
+                                         unsigned int autosave_seconds) {
+  ParkingRegistry *registry;
+  size_t length;
+
+  if (directory == NULL || workers < 0) {
+    return NULL;
+  }
+  length = strlen(directory);
+  if (length == 0 ||
+      length + 1 + PARKING_REGISTRY_MAX_SITE_ID +
+              sizeof(PARKING_REGISTRY_SUFFIX) >
+          PARKING_REGISTRY_MAX_PATH) {
+    return NULL;
+  }
+  if (workers > PARKING_REGISTRY_MAX_WORKERS) {
+    workers = PARKING_REGISTRY_MAX_WORKERS;
+  }
+
+  registry = (ParkingRegistry *)calloc(1, sizeof(ParkingRegistry));
+  if (registry == NULL) {
+    return NULL;
+  }
+  memcpy(registry->directory, directory, length + 1);
+  if (allocator != NULL && allocator->allocate != NULL &&
+      allocator->release != NULL) {
+    registry->allocator = *allocator;
+    registry->has_allocator = 1;
+  }
+  registry->autosave_seconds = autosave_seconds;
+  registry->bucket_count = REGISTRY_INITIAL_BUCKETS;
+  registry->buckets =
+      (RegistrySite **)calloc(registry->bucket_count, sizeof(RegistrySite *));
+  registry->lock = parking_rwlock_create();
+  registry->idle = parking_signal_create();
+  if (registry->buckets == NULL || registry->lock == NULL ||
+      registry->idle == NULL) {
+    free_registry(registry);
+    return NULL;
+  }
+
+  while (registry->worker_count < workers) {
+    RegistryWorker *worker = &registry->workers[registry->worker_count];
+
+    worker->registry = registry;
+    worker->signal = parking_signal_create();
+    worker->thread = worker->signal == NULL
+                         ? NULL
+                         : parking_thread_start(registry_worker, worker);
+    if (worker->thread == NULL) {
+      parking_signal_destroy(worker->signal);
+      stop_workers(registry);
+      free_registry(registry);
+      return NULL;
+    }
+    registry->worker_count++;
+  }
+  return registry;
+}
+
+/**
+ * @brief 打开一个站点，返回它的停车场。
+ * @details 加载快照在站点表的锁外进行；两个线程同时打开同一个未打开的
+ *          站点时，后插入的一方发现站点已存在，释放自己加载的停车场。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @param total_slots 新建停车场时的总容量。
+ * @return 成功返回停车场，失败返回 NULL。
+ */
+ParkingLot *parking_registry_open(ParkingRegistry *registry,
+                                  const char *site_id, int total_slots) {
+  RegistrySite *site;
+  RegistrySite *existing;
+  ParkingLot *lot;
+  unsigned long hash;
+  int created;
+
+  lot = parking_registry_get(registry, site_id);
+  if (lot != NULL || registry == NULL || site_id_hash(site_id, &hash) != 0) {
+    return lot;
+  }
+
+  site = (RegistrySite *)calloc(1, sizeof(RegistrySite));
+  if (site == NULL) {
+    return NULL;
+  }
+  site->lot = open_lot(registry, site_id, total_slots, &created);
+  if (site->lot == NULL) {
+    free(site);
+    return NULL;
+  }
+  site->hash = hash;
+  site->saved_mutation =
+      created ? -1 : parking_atomic_load_long(&site->lot->mutation_count);
+  site->saved_at = time(NULL);
+  strcpy(site->site_id, site_id);
+
+  parking_rwlock_write_lock(registry->lock);
+  existing = find_site(registry, site_id, hash);
+  if (existing == NULL) {
+    insert_site(registry, site);
+    lot = site->lot;
+  } else {
+    lot = existing->lot;
+  }
+  parking_rwlock_write_unlock(registry->lock);
+
+  if (existing != NULL) {
+    free_parking_lot(site->lot);
+    free(site);
+  }
+  return lot;
+}
+
+/**
+ * @brief 查找已打开的站点。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @return 成功返回停车场，否则返回 NULL。
+ */
+ParkingLot *parking_registry_get(ParkingRegistry *registry,
+                                 const char *site_id) {
+  RegistrySite *site;
+  unsigned long hash;
+
+  if (registry == NULL || site_id_hash(site_id, &hash) != 0) {
+    return NULL;
+  }
+  parking_rwlock_read_lock(registry->lock);
+  site = find_site(registry, site_id, hash);
+  parking_rwlock_read_unlock(registry->lock);
+  return site != NULL ? site->lot : NULL;
+}
+
+/**
+ * @brief 借出已打开站点的停车场，借出期间站点不会被关闭。
+ * @details 在读锁内增加借出计数；关闭站点的线程先置 closing，
+ *          再等借出计数归零后才把站点摘下并释放。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @param[out] lot 接收停车场，失败时为 NULL。
+ * @return 成功返回 0，站点未打开或参数无效返回 -1，站点正在关闭返回 -2。
+ */
+int parking_registry_acquire(ParkingRegistry *registry, const char *site_id,
+                             ParkingLot **lot) {
+  RegistrySite *site;
+  unsigned long hash;
+  int result = -1;
+
+  if (lot != NULL) {
+    *lot = NULL;
+  }
+  if (registry == NULL || lot == NULL || site_id_hash(site_id, &hash) != 0) {
+    return -1;
+  }
+  parking_rwlock_read_lock(registry->lock);
+  site = find_site(registry, site_id, hash);
+  /* closing 在写锁内置位，读锁内的检查与计数不会与之交错 */
+  if (site != NULL && site->closing) {
+    result = -2;
+  } else if (site != NULL) {
+    parking_atomic_add_int(&site->pins, 1);
+    *lot = site->lot;
+    result = 0;
+  }
+  parking_rwlock_read_unlock(registry->lock);
+  return result;
+}
+
+/**
+ * @brief 归还以 parking_registry_acquire 借出的停车场。
+ * @param registry 注册表。
+ * @param site_id 借出时的站点编号。
+ */
+void parking_registry_release(ParkingRegistry *registry, const char *site_id) {
+  RegistrySite *site;
+  unsigned long hash;
+
+  if (registry == NULL || site_id_hash(site_id, &hash) != 0) {
+    return;
+  }
+  /* 借出期间站点不会被摘下，因此一定还在站点表中 */
+  parking_rwlock_read_lock(registry->lock);
+  site = find_site(registry, site_id, hash);
+  if (site != NULL) {
+    parking_atomic_add_int(&site->pins, -1);
+    /* 最后一次归还时唤醒正在等待的关闭线程，不必等到下一次轮询 */
+    if (parking_atomic_load_int(&site->pins) == 0 &&
+        parking_atomic_load_int(&site->closing)) {
+      parking_signal_notify(registry->idle);
+    }
+  }
+  parking_rwlock_read_unlock(registry->lock);
+}
+
+/**
+ * @brief 拼出站点在注册表目录中的快照路径。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @param[out] path 接收路径（PARKING_REGISTRY_MAX_PATH 字节）。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int parking_registry_site_path(const ParkingRegistry *registry,
+                               const char *site_id, char *path) {
+  unsigned long hash;
+
+  if (registry == NULL || path == NULL || site_id_hash(site_id, &hash) != 0) {
+    return -1;
+  }
+  site_path(registry, site_id, path);
+  return 0;
+}
+
+/**
+ * @brief 立即保存一个站点。
+ * @details 在读锁内占有站点，保存期间一直持有读锁，
+ *          以免站点被关闭；查找与其他站点的保存不受影响。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @return 成功返回 0，文件写入失败返回 -1，内存不足返回 -2，
+ *         站点未打开或参数无效返回 -3。
+ */
+int parking_registry_save(ParkingRegistry *registry, const char *site_id) {
+  RegistrySite *site;
+  unsigned long hash;
+  int result = -3;
+
+  if (registry == NULL || site_id_hash(site_id, &hash) != 0) {
+    return -3;
+  }
+  parking_rwlock_read_lock(registry->lock);
+  site = find_site(registry, site_id, hash);
+  if (site != NULL) {
+    claim_site(registry, site);
+    result = save_site(registry, site);
+    release_site(site);
+  }
+  parking_rwlock_read_unlock(registry->lock);
+  return result;
+}
+
+/**
+ * @brief 保存全部有修改的站点。
+ * @param registry 注册表。
+ * @return 保存失败的站点数。
+ */
+int parking_registry_save_all(ParkingRegistry *registry) {
+  RegistrySite *site;
+  int failures = 0;
+  size_t i;
+
+  if (registry == NULL) {
+    return 0;
+  }
+  parking_rwlock_read_lock(registry->lock);
+  for (i = 0; i < registry->bucket_count; i++) {
+    for (site = registry->buckets[i]; site != NULL; site = site->next) {
+      claim_site(registry, site);
+      if (site_dirty(site) && save_site(registry, site) != 0) {
+        failures++;
+      }
+      release_site(site);
+    }
+  }
+  parking_rwlock_read_unlock(registry->lock);
+  return failures;
+}
+
+/**
+ * @brief 关闭一个站点。
+ * @details 先置 closing 使站点不再借出，等已借出的全部归还后在写锁内
+ *          摘下站点，使工作线程不再看到它，再等待正在进行的保存结束；
+ *          保存失败时把站点重新插回站点表。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @return 成功返回 0，保存失败返回 -1 或 -2，站点未打开或参数无效返回 -3。
+ */
+int parking_registry_close(ParkingRegistry *registry, const char *site_id) {
+  RegistrySite *site;
+  unsigned long hash;
+  int result = 0;
+
+  if (registry == NULL || site_id_hash(site_id, &hash) != 0) {
+    return -3;
+  }
+  parking_rwlock_write_lock(registry->lock);
+  site = find_site(registry, site_id, hash);
+  if (site != NULL && site->closing) {
+    site = NULL;
+  }
+  if (site != NULL) {
+    parking_atomic_store_int(&site->closing, 1);
+  }
+  parking_rwlock_write_unlock(registry->lock);
+  if (site == NULL) {
+    return -3;
+  }
+
+  while (parking_atomic_load_int(&site->pins) != 0) {
+    parking_signal_wait(registry->idle, REGISTRY_BUSY_WAIT_MS);
+  }
+  parking_rwlock_write_lock(registry->lock);
+  unlink_site(registry, site);
+  parking_rwlock_write_unlock(registry->lock);
+
+  claim_site(registry, site);
+  if (site_dirty(site)) {
+    result = save_site(registry, site);
+  }
+  if (result != 0) {
+    parking_atomic_store_int(&site->closing, 0);
+    parking_rwlock_write_lock(registry->lock);
+    insert_site(registry, site);
+    parking_rwlock_write_unlock(registry->lock);
+    release_site(site);
+    return result;
+  }
+  free_parking_lot(site->lot);
+  free(site);
+  return 0;
+}
+
+/**
+ * @brief 查询已打开的站点数。
+ * @param registry 注册表。
+ * @return 站点数。
+ */
+int parking_registry_count(ParkingRegistry *registry) {
+  int count;
+
+  if (registry == NULL) {
+    return 0;
+  }
+  parking_rwlock_read_lock(registry->lock);
+  count = registry->site_count;
+  parking_rwlock_read_unlock(registry->lock);
+  return count;
+}
+
+/**
+ * @brief 按任意顺序遍历已打开的站点。
+ * @param registry 注册表。
+ * @param visitor 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 遍历的站点数。
+ */
+int parking_registry_foreach(ParkingRegistry *registry,
+                             ParkingSiteVisitor visitor, void *ctx) {
+  RegistrySite *site;
+  int visited = 0;
+  int stop = 0;
+  size_t i;
+
+  if (registry == NULL || visitor == NULL) {
+    return 0;
+  }
+  parking_rwlock_read_lock(registry->lock);
+  for (i = 0; i < registry->bucket_count && !stop; i++) {
+    for (site = registry->buckets[i]; site != NULL && !stop;
+         site = site->next) {
+      visited++;
+      stop = visitor(site->site_id, site->lot, ctx);
+    }
+  }
+  parking_rwlock_read_unlock(registry->lock);
+  return visited;
+}
+
+/**
+ * @brief 对每个站点并行执行一个函数，收集各站点的部分结果。
+ * @details 任务参数与部分结果都在读锁内按站点数一次分配；
+ *          任务队列扩容失败的任务由提交线程直接执行，结果不受影响。
+ * @param registry 注册表。
+ * @param pool 任务池，可以为 NULL。
+ * @param fn 对每个站点执行的函数。
+ * @param partial_size 每个站点部分结果的字节数。
+ * @param ctx 透传给 fn 的上下文指针。
+ * @param[out] count 接收站点数。
+ * @return 成功返回部分结果数组，失败返回 NULL。
+ */
+void *parking_registry_map(ParkingRegistry *registry, ParkingTaskPool *pool,
+                           ParkingSiteMapFn fn, size_t partial_size,
+                           void *ctx, int *count) {
+  ParkingTaskGroup group;
+  SiteMapJob *jobs;
+  RegistrySite *site;
+  char *partials;
+  int n = 0;
+  size_t i;
+
+  if (count != NULL) {
+    *count = 0;
+  }
+  if (registry == NULL || fn == NULL || partial_size == 0 || count == NULL) {
+    return NULL;
+  }
+  parking_rwlock_read_lock(registry->lock);
+  partials = (char *)calloc(
+      registry->site_count > 0 ? (size_t)registry->site_count : 1,
+      partial_size);
+  jobs = (SiteMapJob *)malloc(
+      (registry->site_count > 0 ? (size_t)registry->site_count : 1) *
+      sizeof(SiteMapJob));
+  if (partials == NULL || jobs == NULL) {
+    parking_rwlock_read_unlock(registry->lock);
+    free(partials);
+    free(jobs);
+    return NULL;
+  }
+
+  parking_task_group_init(&group);
+  for (i = 0; i < registry->bucket_count; i++) {
+    for (site = registry->buckets[i]; site != NULL; site = site->next) {
+      SiteMapJob *job = &jobs[n];
+
+      job->fn = fn;
+      job->site = site;
+      job->partial = partials + (size_t)n * partial_size;
+      job->ctx = ctx;
+      n++;
+      if (pool == NULL) {
+        run_site_job(job);
+      } else {
+        parking_task_pool_submit(pool, &group, run_site_job, job);
+      }
+    }
+  }
+  parking_task_group_wait(pool, &group);
+  parking_rwlock_read_unlock(registry->lock);
+
+  free(jobs);
+  *count = n;
+  return partials;
+}
+
+/**
+ * @brief 生成全部站点的汇总报表。
+ * @details 各站点的部分结果合并为合计统计，站点内的前若干辆车
+ *          合并排序后取全连锁的前 PARKING_REGISTRY_REPORT_TOP 辆。
+ * @param registry 注册表。
+ * @param pool 任务池，可以为 NULL。
+ * @param[out] report 接收报表。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -2。
+ */
+int parking_registry_report(ParkingRegistry *registry, ParkingTaskPool *pool,
+                            ParkingChainReport *report) {
+  SiteReportPartial *partials;
+  ParkingChainVehicle *vehicles;
+  ParkingStatistics *totals;
+  int vehicle_count = 0;
+  int count;
+  int i;
+  int j;
+
+  if (report == NULL) {
+    return -1;
+  }
+  memset(report, 0, sizeof(*report));
+  if (registry == NULL) {
+    return -1;
+  }
+  partials = (SiteReportPartial *)parking_registry_map(
+      registry, pool, report_site, sizeof(SiteReportPartial), NULL, &count);
+  if (partials == NULL) {
+    return -2;
+  }
+  report->sites = (ParkingSiteReport *)malloc(
+      (count > 0 ? (size_t)count : 1) * sizeof(ParkingSiteReport));
+  vehicles = (ParkingChainVehicle *)malloc(
+      (count > 0 ? (size_t)count : 1) * PARKING_REGISTRY_REPORT_TOP *
+      sizeof(ParkingChainVehicle));
+  if (report->sites == NULL || vehicles == NULL) {
+    free(report->sites);
+    report->sites = NULL;
+    free(vehicles);
+    free(partials);
+    return -2;
+  }
+
+  totals = &report->totals;
+  for (i = 0; i < count; i++) {
+    const ParkingStatistics *stats = &partials[i].site.stats;
+
+    report->sites[i] = partials[i].site;
+    totals->total_slots += stats->total_slots;
+    totals->occupied_slots += stats->occupied_slots;
+    totals->free_slots += stats->free_slots;
+    totals->today_revenue += stats->today_revenue;
+    totals->month_revenue += stats->month_revenue;
+    for (j = 0; j < partials[i].longest_count; j++) {
+      vehicles[vehicle_count++] = partials[i].longest[j];
+    }
+  }
+  totals->occupancy_rate =
+      totals->total_slots > 0
+          ? (double)totals->occupied_slots / totals->total_slots * 100.0
+          : 0.0;
+  qsort(report->sites, (size_t)count, sizeof(ParkingSiteReport),
+        compare_site_reports);
+  qsort(vehicles, (size_t)vehicle_count, sizeof(ParkingChainVehicle),
+        compare_chain_vehicles);
+  report->site_count = count;
+  report->longest_count = vehicle_count < PARKING_REGISTRY_REPORT_TOP
+                              ? vehicle_count
+                              : PARKING_REGISTRY_REPORT_TOP;
+  memcpy(report->longest, vehicles,
+         (size_t)report->longest_count * sizeof(ParkingChainVehicle));
+  free(vehicles);
+  free(partials);
+  return 0;
+}
+
+/**
+ * @brief 汇总全部已打开站点的内存统计。
+ * @param registry 注册表。
+ * @param[out] stats 接收汇总结果。
+ */
+void parking_registry_memory(ParkingRegistry *registry,
+                             ParkingMemoryStats *stats) {
+  ParkingMemoryStats lot_stats;
+  RegistrySite *site;
+  size_t i;
+  int c;
+
+  if (stats == NULL) {
+    return;
+  }
+  memset(stats, 0, sizeof(*stats));
+  if (registry == NULL) {
+    return;
+  }
+  parking_rwlock_read_lock(registry->lock);
+  for (i = 0; i < registry->bucket_count; i++) {
+    for (site = registry->buckets[i]; site != NULL; site = site->next) {
+      get_parking_memory_stats(site->lot, &lot_stats);
+      for (c = 0; c < PARKING_MEMORY_CATEGORY_COUNT; c++) {
+        stats->bytes[c] += lot_stats.bytes[c];
+        stats->objects[c] += lot_stats.objects[c];
+      }
+      stats->total_bytes += lot_stats.total_bytes;
+      stats->total_objects += lot_stats.total_objects;
+      stats->overhead_bytes += lot_stats.overhead_bytes;
+      stats->peak_bytes += lot_stats.peak_bytes;
+      stats->failures += lot_stats.failures;
+    }
+  }
+  parking_rwlock_read_unlock(registry->lock);
+}
+
+/**
+ * @brief 停止工作线程，保存有修改的站点，释放全部停车场与注册表。
+ * @param registry 注册表，可以为 NULL。
+ * @return 最后一次保存失败的站点数。
+ */
+int parking_registry_destroy(ParkingRegistry *registry) {
+  RegistrySite *site;
+  int failures = 0;
+  size_t i;
+
+  if (registry == NULL) {
+    return 0;
+  }
+  stop_workers(registry);
+  for (i = 0; i < registry->bucket_count; i++) {
+    while (registry->buckets[i] != NULL) {
+      site = registry->buckets[i];
+      registry->buckets[i] = site->next;
+      if (site_dirty(site) && save_site(registry, site) != 0) {
+        failures++;
+      }
+      free_parking_lot(site->lot);
+      free(site);
+    }
+  }
+  free_registry(registry);
+  return failures;
+}
@@ -0,0 +1,287 @@
+#ifndef PARKING_REGISTRY_H
+#define PARKING_REGISTRY_H
+
+#include "parking_data.h"
+#include "parking_memory.h"
+#include "parking_service.h"
+#include "parking_tasks.h"
+
+/**
+ * @file parking_registry.h
+ * @brief 在一个进程中托管多个停车场的注册表接口声明。
+ * @details
+ * 注册表按站点编号管理任意多个 ParkingLot，同一进程可以同时服务几十到
+ * 几百个车库，不必每个车库各起一个进程。
+ * - 各停车场共用注册表的分配函数（见 ParkingAllocator），内存统计仍按停车场
+ *   分别记录，parking_registry_memory 给出汇总。
+ * - 每个站点的数据保存为目录下的 `<站点编号>.snap` 二进制快照；打开站点时
+ *   文件存在则加载，不存在则新建。
+ * - 自动保存由注册表的少量工作线程共同承担，而不是每个停车场一个保存线程：
+ *   工作线程每 PARKING_REGISTRY_POLL_MS 毫秒轮询一遍站点，
+ *   把修改次数（ParkingLot.mutation_count）有变化且距上次保存达到
+ *   设定秒数的停车场以写时复制快照写出（见 parking_saver_save）。
+ *
+ * 注册表本身的站点表由读写锁保护，各停车场仍由自己的锁保护，
+ * 取得停车场后照常调用数据层或服务层函数即可。
+ * 站点编号只能由字母、数字、'-' 与 '_' 组成，以便直接用作文件名。
+ *
+ * 跨站点的汇总（全连锁占用、分站点收入、全连锁停得最久的车辆）由
+ * parking_registry_map 把每个站点作为一个任务交给工作窃取任务池
+ * （见 parking_tasks.h），各任务只写自己的部分结果，全部完成后再合并。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_REGISTRY_MAX_SITE_ID 32 /**< 站点编号的最大长度 */
+#define PARKING_REGISTRY_MAX_PATH 260   /**< 快照路径的最大长度 */
+#define PARKING_REGISTRY_MAX_WORKERS 8  /**< 自动保存工作线程数的上限 */
+#define PARKING_REGISTRY_POLL_MS 200    /**< 工作线程轮询站点的间隔（毫秒） */
+#define PARKING_REGISTRY_SUFFIX ".snap" /**< 站点快照文件的扩展名 */
+#define PARKING_REGISTRY_REPORT_TOP 10  /**< 连锁报表中停得最久的车辆数 */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 不透明的停车场注册表句柄。
+ */
+typedef struct ParkingRegistry ParkingRegistry;
+
+/**
+ * @brief 遍历站点时对每个站点调用的回调函数。
+ * @details 调用时持有站点表的读锁，回调中不得打开或关闭站点。
+ * @param site_id 站点编号。
+ * @param lot 该站点的停车场。
+ * @param ctx 调用者传入的上下文指针。
+ * @return 返回 0 继续遍历，返回非 0 立即停止遍历。
+ */
+typedef int (*ParkingSiteVisitor)(const char *site_id, ParkingLot *lot,
+                                  void *ctx);
+
+/**
+ * @brief 在任务池中对每个站点执行的函数。
+ * @details 不同站点的调用可能并行进行；函数须自行加该停车场的锁，
+ *          只写 partial，不写其他共享状态。调用时持有站点表的读锁，
+ *          不得打开或关闭站点。
+ * @param site_id 站点编号。
+ * @param lot 该站点的停车场。
+ * @param partial 该站点的部分结果，已清零。
+ * @param ctx 调用者传入的上下文指针。
+ */
+typedef void (*ParkingSiteMapFn)(const char *site_id, ParkingLot *lot,
+                                 void *partial, void *ctx);
+
+/**
+ * @brief 连锁报表中一个站点的统计。
+ */
+typedef struct ParkingSiteReport {
+  char site_id[PARKING_REGISTRY_MAX_SITE_ID + 1]; /**< 站点编号。 */
+  ParkingStatistics stats;                        /**< 该站点的统计信息。 */
+} ParkingSiteReport;
+
+/**
+ * @brief 连锁报表中的一辆在场车辆。
+ */
+typedef struct ParkingChainVehicle {
+  char site_id[PARKING_REGISTRY_MAX_SITE_ID + 1]; /**< 所在站点。 */
+  int slot_id;                                    /**< 车位编号。 */
+  char license_plate[MAX_LICENSE_LEN];            /**< 车牌号。 */
+  long duration_seconds; /**< 截至查询时刻的停车时长（秒）。 */
+} ParkingChainVehicle;
+
+/**
+ * @brief 全部站点的汇总报表。
+ */
+typedef struct ParkingChainReport {
+  int site_count;           /**< 站点数。 */
+  ParkingStatistics totals; /**< 全部站点合计，使用率按合计车位计算。 */
+  int longest_count;        /**< longest 中的有效项数。 */
+  ParkingChainVehicle
+      longest[PARKING_REGISTRY_REPORT_TOP]; /**< 停得最久的车辆，从长到短。 */
+  ParkingSiteReport *sites; /**< 各站点统计，按站点编号排序；调用者 free()。 */
+} ParkingChainReport;
+
+/**
+ *********************************************************************************
+ *                              注册表API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建注册表并启动自动保存工作线程。
+ * @param directory 存放站点快照的目录，须已存在。
+ * @param allocator 各停车场共用的分配函数，NULL 表示 C 标准库；内容会被复制。
+ * @param workers 自动保存工作线程数，超过 PARKING_REGISTRY_MAX_WORKERS 时
+ *                按上限处理；0 表示不自动保存，只在显式保存、关闭站点
+ *                和销毁注册表时写出。
+ * @param autosave_seconds 同一站点两次自动保存的最短间隔（秒），
+ *                         0 表示修改后在下一轮轮询就保存。
+ * @return 成功返回句柄；参数无效、目录路径过长、内存不足或无法创建线程时
+ *         返回 NULL。
+ */
+ParkingRegistry *parking_registry_create(const char *directory,
+                                         const ParkingAllocator *allocator,
+                                         int workers,
+                                         unsigned int autosave_seconds);
+
+/**
+ * @brief 打开一个站点，返回它的停车场。
+ * @details 站点已打开时直接返回已有的停车场；否则从该站点的快照加载，
+ *          快照不存在时以 total_slots 新建一个空停车场。新建的停车场
+ *          即使没有修改，也会在下一次保存时写出快照。
+ *          快照存在但无法加载时不会新建，以免之后的保存覆盖它。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @param total_slots 新建停车场时的总容量；加载已有快照时忽略。
+ * @return 成功返回停车场，它归注册表所有，关闭站点前一直有效；
+ *         站点编号无效、快照损坏或内存不足时返回 NULL。
+ */
+ParkingLot *parking_registry_open(ParkingRegistry *registry,
+                                  const char *site_id, int total_slots);
+
+/**
+ * @brief 查找已打开的站点。
+ * @details 返回的停车场没有借出计数，其他线程可能随时关闭站点；
+ *          与关闭并发使用停车场时改用 parking_registry_acquire。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @return 成功返回停车场，站点未打开或参数无效时返回 NULL。
+ */
+ParkingLot *parking_registry_get(ParkingRegistry *registry,
+                                 const char *site_id);
+
+/**
+ * @brief 借出已打开站点的停车场，借出期间站点不会被关闭。
+ * @details 每次成功借出都须以 parking_registry_release 归还；
+ *          parking_registry_close 会等全部借出归还后才释放停车场，
+ *          等待期间新的借出返回 -2。借出不加停车场的锁。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @param[out] lot 接收停车场，失败时为 NULL。
+ * @return 成功返回 0，站点未打开或参数无效返回 -1，站点正在关闭返回 -2。
+ */
+int parking_registry_acquire(ParkingRegistry *registry, const char *site_id,
+                             ParkingLot **lot);
+
+/**
+ * @brief 归还以 parking_registry_acquire 借出的停车场。
+ * @param registry 注册表。
+ * @param site_id 借出时的站点编号。
+ */
+void parking_registry_release(ParkingRegistry *registry, const char *site_id);
+
+/**
+ * @brief 拼出站点在注册表目录中的快照路径。
+ * @details 站点不必已打开；集群迁移站点时据此在目录之间搬运快照。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @param[out] path 接收路径，至少 PARKING_REGISTRY_MAX_PATH 字节。
+ * @return 成功返回 0，站点编号无效或参数为 NULL 返回 -1。
+ */
+int parking_registry_site_path(const ParkingRegistry *registry,
+                               const char *site_id, char *path);
+
+/**
+ * @brief 立即保存一个站点（无论是否有修改）。
+ * @details 工作线程正在保存该站点时等它完成后再保存。
+ *          调用者不得持有该停车场的锁。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @return 成功返回 0，文件写入失败返回 -1，内存不足返回 -2，
+ *         站点未打开或参数无效返回 -3。
+ */
+int parking_registry_save(ParkingRegistry *registry, const char *site_id);
+
+/**
+ * @brief 保存全部有修改的站点。
+ * @details 调用者不得持有任何托管停车场的锁。
+ * @param registry 注册表。
+ * @return 保存失败的站点数，0 表示全部成功；registry 为 NULL 时返回 0。
+ */
+int parking_registry_save_all(ParkingRegistry *registry);
+
+/**
+ * @brief 关闭一个站点：有修改时先保存，然后释放它的停车场。
+ * @details 先等以 parking_registry_acquire 借出的停车场全部归还，
+ *          等待期间新的借出失败；以 parking_registry_get 取得停车场的
+ *          线程须由调用者保证已不再使用它。调用者还须保证没有其他线程
+ *          同时打开同一站点。
+ * @param registry 注册表。
+ * @param site_id 站点编号。
+ * @return 成功返回 0；保存失败时站点保持打开，返回 -1（文件写入失败）
+ *         或 -2（内存不足）；站点未打开或参数无效返回 -3。
+ */
+int parking_registry_close(ParkingRegistry *registry, const char *site_id);
+
+/**
+ * @brief 查询已打开的站点数。
+ * @param registry 注册表。
+ * @return 站点数；registry 为 NULL 时返回 0。
+ */
+int parking_registry_count(ParkingRegistry *registry);
+
+/**
+ * @brief 按任意顺序遍历已打开的站点。
+ * @param registry 注册表。
+ * @param visitor 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 遍历的站点数（含使回调返回非 0 的那个站点）。
+ */
+int parking_registry_foreach(ParkingRegistry *registry,
+                             ParkingSiteVisitor visitor, void *ctx);
+
+/**
+ * @brief 对每个站点并行执行一个函数，收集各站点的部分结果。
+ * @details 每个站点是一个任务；pool 为 NULL 时在调用线程中逐个执行。
+ *          执行期间持有站点表的读锁。
+ * @param registry 注册表。
+ * @param pool 任务池，可以为 NULL。
+ * @param fn 对每个站点执行的函数。
+ * @param partial_size 每个站点部分结果的字节数，必须大于 0。
+ * @param ctx 透传给 fn 的上下文指针。
+ * @param[out] count 接收站点数（即返回数组的项数）。
+ * @return 成功返回按任意站点顺序排列的部分结果数组（没有站点时也返回
+ *         一个可以 free() 的数组），调用者 free()；参数无效或内存不足时
+ *         返回 NULL，此时 *count 为 0。
+ */
+void *parking_registry_map(ParkingRegistry *registry, ParkingTaskPool *pool,
+                           ParkingSiteMapFn fn, size_t partial_size,
+                           void *ctx, int *count);
+
+/**
+ * @brief 生成全部站点的汇总报表。
+ * @details 各站点的统计与停得最久的车辆在任务池中并行读取，最后合并；
+ *          每个站点各自在读锁内读取，不同站点的快照时刻可能略有先后。
+ * @param registry 注册表。
+ * @param pool 任务池，可以为 NULL。
+ * @param[out] report 接收报表；成功后须 free(report->sites)。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -2。
+ */
+int parking_registry_report(ParkingRegistry *registry, ParkingTaskPool *pool,
+                            ParkingChainReport *report);
+
+/**
+ * @brief 汇总全部已打开站点的内存统计。
+ * @details 各项为逐个站点统计之和，peak_bytes 为各站点峰值之和（上界）。
+ * @param registry 注册表。
+ * @param[out] stats 接收汇总结果；registry 为 NULL 时清零。
+ */
+void parking_registry_memory(ParkingRegistry *registry,
+                             ParkingMemoryStats *stats);
+
+/**
+ * @brief 停止工作线程，保存有修改的站点，释放全部停车场与注册表。
+ * @details 调用者须保证没有其他线程仍在使用托管的停车场。
+ * @param registry 注册表，可以为 NULL。
+ * @return 最后一次保存失败的站点数，0 表示全部成功。
+ */
+int parking_registry_destroy(ParkingRegistry *registry);
+
+#endif /* PARKING_REGISTRY_H */
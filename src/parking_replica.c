@@ -0,0 +1,1318 @@
+/**
+ * @file parking_replica.c
+ * @brief 主备增量复制实现文件
+ * @details
+ * 该文件实现了 parking_replica.h 中声明的复制服务与备节点。
+ * 主节点的旁路接收者在修改所在的写锁内把记录编码成完整的帧追加到积压
+ * 缓冲区，临界区只有一次 memcpy；发送线程在锁外整帧复制、写套接字。
+ * 积压缓冲区写满时丢弃较早的一半，游标落在被丢弃部分的备节点改发快照。
+ * 备节点把一次 recv 得到的全部记录在同一次写锁内应用，
+ * 高峰期每次加锁可以应用成百上千条记录。
+ * 套接字接口需要 POSIX 声明，因此与 parking_exporter.c 一样
+ * 在包含系统头文件前显式开启 _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_codec.h"
+#include "parking_journal.h"
+#include "parking_replica.h"
+#include "parking_thread.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#ifdef _WIN32
+typedef SOCKET ReplicaSocket; /**< 平台套接字类型 */
+typedef int ReplicaSocklen;   /**< 地址长度类型 */
+#define REPLICA_INVALID_SOCKET INVALID_SOCKET /**< 无效套接字 */
+#define REPLICA_SHUTDOWN_BOTH SD_BOTH         /**< 双向关闭 */
+#define REPLICA_SEND_FLAGS 0                  /**< send 的附加标志 */
+#else
+typedef int ReplicaSocket;          /**< 平台套接字类型 */
+typedef socklen_t ReplicaSocklen;   /**< 地址长度类型 */
+#define REPLICA_INVALID_SOCKET (-1) /**< 无效套接字 */
+#define REPLICA_SHUTDOWN_BOTH SHUT_RDWR /**< 双向关闭 */
+#ifdef MSG_NOSIGNAL
+#define REPLICA_SEND_FLAGS MSG_NOSIGNAL /**< 对端关闭时不触发 SIGPIPE */
+#else
+#define REPLICA_SEND_FLAGS 0 /**< send 的附加标志 */
+#endif
+#endif
+
+#define FRAME_HEADER 5 /**< 帧头：1 字节类型加 4 字节负载长度 */
+#define SEQ_SIZE 8     /**< 序号的编码字节数 */
+#define FRAME_HELLO 'H'     /**< 备→主：epoch、已应用的序号 */
+#define FRAME_WELCOME 'W'   /**< 主→备：epoch、续传起点序号 */
+#define FRAME_SNAPSHOT 'S'  /**< 主→备：epoch、快照序号、快照内容 */
+#define FRAME_RECORD 'R'    /**< 主→备：序号、日志记录 */
+#define FRAME_HEARTBEAT 'K' /**< 主→备：最新序号 */
+#define HELLO_SIZE (4 + SEQ_SIZE) /**< HELLO 与 WELCOME 的负载字节数 */
+#define RECORD_FRAME_MAX                                                       \
+  (FRAME_HEADER + SEQ_SIZE + JOURNAL_MAX_RECORD_SIZE) /**< 记录帧的最大字节数 */
+#define REPLICA_SEND_CHUNK 65536     /**< 发送线程每次复制的最大字节数 */
+#define REPLICA_RECV_BYTES 262144    /**< 备节点接收缓冲区的字节数 */
+#define REPLICA_POLL_MS 200          /**< 等待连接时检查停止标志的间隔 */
+#define REPLICA_FILL_PAGES 16        /**< 每次持有读锁编码的快照页数 */
+#define REPLICA_SNAPSHOT_RETRY_MS 50 /**< 已有快照进行中时的重试间隔 */
+
+/**
+ * @brief 为一个备节点服务的发送线程。
+ */
+typedef struct ReplicaSender {
+  struct ParkingReplicator *owner; /**< 所属的复制服务。 */
+  ReplicaSocket socket;            /**< 与备节点的连接。 */
+  ParkingThread *thread;           /**< 发送线程。 */
+  ParkingSignal *signal;           /**< 有新记录或需要停止时触发。 */
+  int active;                      /**< 非 0 表示该位置正在使用。 */
+  volatile int finished;           /**< 非 0 表示发送线程已退出。 */
+  /* 以下字段由复制服务的自旋锁保护 */
+  int waiting;   /**< 非 0 表示发送线程正在等待新记录。 */
+  int lost;      /**< 非 0 表示游标已被积压缓冲区丢弃，需要改发快照。 */
+  size_t offset; /**< 下一次发送的积压缓冲区偏移。 */
+} ReplicaSender;
+
+/**
+ * @brief 正在运行的主节点复制服务。
+ */
+struct ParkingReplicator {
+  ParkingLot *lot;        /**< 主节点的停车场。 */
+  ReplicaSocket listener; /**< 监听套接字。 */
+  int port;               /**< 实际监听的端口。 */
+  unsigned long epoch;    /**< 本次启动的标识，备节点据此判断能否续传。 */
+  ParkingThread *thread;  /**< 接受连接的线程。 */
+  volatile int stopping;  /**< 非 0 时各线程退出。 */
+  volatile int lock;      /**< 保护积压缓冲区与发送线程游标的自旋锁。 */
+  unsigned char *backlog; /**< 积压缓冲区，按序存放完整的记录帧。 */
+  size_t backlog_used;    /**< 积压缓冲区已用的字节数。 */
+  unsigned long first_seq; /**< 积压缓冲区第一帧的序号。 */
+  unsigned long next_seq;  /**< 下一条记录的序号。 */
+  long snapshots_sent;     /**< 累计发送的快照数。 */
+  ReplicaSender senders[REPLICA_MAX_FOLLOWERS]; /**< 各备节点的发送线程。 */
+};
+
+/**
+ * @brief 正在运行的备节点。
+ */
+struct ParkingFollower {
+  char host[64];           /**< 主节点地址。 */
+  int port;                /**< 主节点端口。 */
+  ParkingThread *thread;   /**< 接收并应用复制数据的线程。 */
+  ParkingSignal *wake;     /**< 停止时唤醒重连等待。 */
+  ParkingSignal *applied;  /**< 每应用一批记录后触发。 */
+  ParkingRwLock *swap_lock; /**< 读者持有读锁，替换停车场时持有写锁。 */
+  ParkingLot *lot;         /**< 当前的停车场，尚未收到快照时为 NULL。 */
+  unsigned char *buffer;   /**< 接收缓冲区。 */
+  volatile int stopping;   /**< 非 0 时后台线程退出。 */
+  volatile int lock;       /**< 保护以下字段的自旋锁。 */
+  ReplicaSocket socket;    /**< 当前连接，未连接时为无效套接字。 */
+  unsigned long epoch;     /**< 当前状态来自的主节点 epoch。 */
+  FollowerStatus status;   /**< 对外报告的状态。 */
+  unsigned long contact_ms; /**< 最近一次收到主节点数据的时刻。 */
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 获取自旋锁。
+ * @param lock 锁变量。
+ */
+static void spin_lock(volatile int *lock) {
+  while (parking_atomic_exchange_int(lock, 1) != 0) {
+    while (parking_atomic_load_int(lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放自旋锁。
+ * @param lock 锁变量。
+ */
+static void spin_unlock(volatile int *lock) {
+  parking_atomic_store_int(lock, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 读取单调时钟的毫秒数。
+ * @return 毫秒数，只用于计算时间差。
+ */
+static unsigned long now_ms(void) {
+#ifdef _WIN32
+  return (unsigned long)GetTickCount();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long)ts.tv_sec * 1000UL +
+         (unsigned long)(ts.tv_nsec / 1000000L);
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 以 8 字节小端序写入序号。
+ * @details 高 32 位分两次移位得到，unsigned long 为 32 位时也不会越界。
+ * @param p 目标位置。
+ * @param seq 序号。
+ */
+static void put_seq(unsigned char *p, unsigned long seq) {
+  codec_put_u32(p, seq & 0xFFFFFFFFUL);
+  codec_put_u32(p + 4, (seq >> 16) >> 16);
+}
+
+/**
+ * @brief (静态辅助函数) 读取 8 字节小端序序号。
+ * @param p 源位置。
+ * @return 序号。
+ */
+static unsigned long get_seq(const unsigned char *p) {
+  return codec_get_u32(p) | ((codec_get_u32(p + 4) << 16) << 16);
+}
+
+/**
+ * @brief (静态辅助函数) 写入帧头。
+ * @param p 目标位置（至少 FRAME_HEADER 字节）。
+ * @param type 帧类型。
+ * @param length 负载字节数。
+ */
+static void put_frame_header(unsigned char *p, int type,
+                             unsigned long length) {
+  p[0] = (unsigned char)type;
+  codec_put_u32(p + 1, length);
+}
+
+/**
+ * @brief (静态辅助函数) 关闭套接字。
+ * @param socket_fd 套接字。
+ */
+static void close_socket(ReplicaSocket socket_fd) {
+#ifdef _WIN32
+  closesocket(socket_fd);
+#else
+  close(socket_fd);
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 等待套接字可读。
+ * @param socket_fd 套接字。
+ * @param timeout_ms 超时（毫秒）。
+ * @return 可读返回 1，超时或出错返回 0。
+ */
+static int wait_readable(ReplicaSocket socket_fd, int timeout_ms) {
+  fd_set readable;
+  struct timeval timeout;
+
+  FD_ZERO(&readable);
+  FD_SET(socket_fd, &readable);
+  timeout.tv_sec = timeout_ms / 1000;
+  timeout.tv_usec = (timeout_ms % 1000) * 1000;
+  return select((int)socket_fd + 1, &readable, NULL, NULL, &timeout) > 0;
+}
+
+/**
+ * @brief (静态辅助函数) 写出全部数据。
+ * @param socket_fd 套接字。
+ * @param data 数据。
+ * @param length 数据长度。
+ * @return 成功返回 0，对端关闭或出错返回 -1。
+ */
+static int send_all(ReplicaSocket socket_fd, const unsigned char *data,
+                    size_t length) {
+  while (length > 0) {
+    int chunk = length > REPLICA_SEND_CHUNK ? REPLICA_SEND_CHUNK : (int)length;
+    int sent = (int)send(socket_fd, (const char *)data, chunk,
+                         REPLICA_SEND_FLAGS);
+
+    if (sent <= 0) {
+      return -1;
+    }
+    data += sent;
+    length -= (size_t)sent;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 在超时内读满指定字节数。
+ * @param socket_fd 套接字。
+ * @param data 目标缓冲区。
+ * @param length 要读取的字节数。
+ * @param timeout_ms 每次等待数据的超时（毫秒）。
+ * @return 成功返回 0，超时、对端关闭或出错返回 -1。
+ */
+static int recv_exact(ReplicaSocket socket_fd, unsigned char *data,
+                      size_t length, int timeout_ms) {
+  while (length > 0) {
+    int chunk = length > REPLICA_SEND_CHUNK ? REPLICA_SEND_CHUNK : (int)length;
+    int got;
+
+    if (!wait_readable(socket_fd, timeout_ms)) {
+      return -1;
+    }
+    got = (int)recv(socket_fd, (char *)data, chunk, 0);
+    if (got <= 0) {
+      return -1;
+    }
+    data += got;
+    length -= (size_t)got;
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 填写 IPv4 地址。
+ * @param address 目标结构。
+ * @param host 点分十进制地址。
+ * @param port 端口。
+ * @return 成功返回 0，地址无效返回 -1。
+ */
+static int fill_address(struct sockaddr_in *address, const char *host,
+                        int port) {
+  memset(address, 0, sizeof(*address));
+  address->sin_family = AF_INET;
+  address->sin_port = htons((unsigned short)port);
+  return inet_pton(AF_INET, host, &address->sin_addr) == 1 ? 0 : -1;
+}
+
+/**
+ * @brief (静态辅助函数) 创建、绑定并监听套接字。
+ * @param host 监听地址。
+ * @param port 监听端口。
+ * @param[out] bound_port 接收实际端口。
+ * @return 成功返回监听套接字，失败返回 REPLICA_INVALID_SOCKET。
+ */
+static ReplicaSocket open_listener(const char *host, int port,
+                                   int *bound_port) {
+  struct sockaddr_in address;
+  ReplicaSocklen address_length = (ReplicaSocklen)sizeof(address);
+  ReplicaSocket listener;
+  int reuse = 1;
+
+  if (fill_address(&address, host, port) != 0) {
+    return REPLICA_INVALID_SOCKET;
+  }
+  listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener == REPLICA_INVALID_SOCKET) {
+    return REPLICA_INVALID_SOCKET;
+  }
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse,
+             sizeof(reuse));
+  if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(listener, REPLICA_MAX_FOLLOWERS) != 0 ||
+      getsockname(listener, (struct sockaddr *)&address, &address_length) !=
+          0) {
+    close_socket(listener);
+    return REPLICA_INVALID_SOCKET;
+  }
+  *bound_port = ntohs(address.sin_port);
+  return listener;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  主节点                                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 丢弃积压缓冲区中较早的一半记录。
+ * @details 按帧边界截断；游标落在被丢弃部分的发送线程标记为 lost。
+ * @note 须在复制服务的自旋锁内调用。
+ * @param replicator 复制服务。
+ */
+static void trim_backlog(ParkingReplicator *replicator) {
+  size_t cut = 0;
+  unsigned long dropped = 0;
+  int i;
+
+  while (cut < replicator->backlog_used && cut < REPLICA_BACKLOG_BYTES / 2) {
+    cut += FRAME_HEADER + codec_get_u32(replicator->backlog + cut + 1);
+    dropped++;
+  }
+  memmove(replicator->backlog, replicator->backlog + cut,
+          replicator->backlog_used - cut);
+  replicator->backlog_used -= cut;
+  replicator->first_seq += dropped;
+
+  for (i = 0; i < REPLICA_MAX_FOLLOWERS; i++) {
+    ReplicaSender *sender = &replicator->senders[i];
+
+    if (!sender->active || sender->lost) {
+      continue;
+    }
+    if (sender->offset < cut) {
+      sender->lost = 1;
+    } else {
+      sender->offset -= cut;
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 旁路接收函数：把一条记录追加到积压缓冲区。
+ * @details 在主节点修改所在的写锁内调用。只唤醒正在等待的发送线程，
+ *          持续有记录时不产生任何系统调用。
+ * @param record 刚产生的日志记录。
+ * @param ctx 复制服务。
+ */
+static void replicate_record(const JournalRecord *record, void *ctx) {
+  ParkingReplicator *replicator = (ParkingReplicator *)ctx;
+  unsigned char frame[RECORD_FRAME_MAX];
+  ParkingSignal *wake[REPLICA_MAX_FOLLOWERS];
+  size_t size;
+  int wake_count = 0;
+  int i;
+
+  size = journal_encode_record(record, frame + FRAME_HEADER + SEQ_SIZE);
+  put_frame_header(frame, FRAME_RECORD, (unsigned long)(SEQ_SIZE + size));
+  size += FRAME_HEADER + SEQ_SIZE;
+
+  spin_lock(&replicator->lock);
+  put_seq(frame + FRAME_HEADER, replicator->next_seq);
+  replicator->next_seq++;
+  if (replicator->backlog_used + size > REPLICA_BACKLOG_BYTES) {
+    trim_backlog(replicator);
+  }
+  memcpy(replicator->backlog + replicator->backlog_used, frame, size);
+  replicator->backlog_used += size;
+  for (i = 0; i < REPLICA_MAX_FOLLOWERS; i++) {
+    ReplicaSender *sender = &replicator->senders[i];
+
+    if (sender->active && sender->waiting) {
+      sender->waiting = 0;
+      wake[wake_count++] = sender->signal;
+    }
+  }
+  spin_unlock(&replicator->lock);
+
+  for (i = 0; i < wake_count; i++) {
+    parking_signal_notify(wake[i]);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 求积压缓冲区中某个序号所在帧的偏移。
+ * @note 须在复制服务的自旋锁内调用。
+ * @param replicator 复制服务。
+ * @param seq 目标序号，须在 [first_seq, next_seq] 之内。
+ * @return 帧的偏移；seq 等于 next_seq 时为缓冲区末尾。
+ */
+static size_t backlog_offset_of(const ParkingReplicator *replicator,
+                                unsigned long seq) {
+  size_t offset = 0;
+  unsigned long current = replicator->first_seq;
+
+  while (current < seq && offset < replicator->backlog_used) {
+    offset += FRAME_HEADER + codec_get_u32(replicator->backlog + offset + 1);
+    current++;
+  }
+  return offset;
+}
+
+/**
+ * @brief (静态辅助函数) 向备节点发送一份写时复制快照。
+ * @details 写锁内开始快照并记下对应的序号与积压缓冲区游标，
+ *          之后分批持有读锁编码，发送时不持锁。已有其他快照进行中时稍后重试。
+ * @param sender 发送线程。
+ * @return 成功返回 0，内存不足、连接断开或正在停止返回 -1。
+ */
+static int send_snapshot(ReplicaSender *sender) {
+  ParkingReplicator *replicator = sender->owner;
+  ParkingLot *lot = replicator->lot;
+  ParkingSnapshot snapshot;
+  unsigned char header[FRAME_HEADER + HELLO_SIZE];
+  const unsigned char *bytes;
+  unsigned long seq = 0;
+  size_t size;
+  int data_result;
+  int pages_left;
+  int sent;
+
+  for (;;) {
+    if (parking_atomic_load_int(&replicator->stopping)) {
+      return -1;
+    }
+    parking_lot_write_lock(lot);
+    data_result = begin_parking_snapshot(lot, &snapshot);
+    if (data_result == 0) {
+      spin_lock(&replicator->lock);
+      seq = replicator->next_seq - 1;
+      sender->offset = replicator->backlog_used;
+      sender->lost = 0;
+      spin_unlock(&replicator->lock);
+    }
+    parking_lot_write_unlock(lot);
+    if (data_result != -1) {
+      break;
+    }
+    parking_signal_wait(sender->signal, REPLICA_SNAPSHOT_RETRY_MS);
+  }
+  if (data_result != 0) {
+    return -1;
+  }
+
+  do {
+    parking_lot_read_lock(lot);
+    pages_left = fill_parking_snapshot(lot, &snapshot, REPLICA_FILL_PAGES);
+    parking_lot_read_unlock(lot);
+  } while (pages_left > 0);
+
+  bytes = parking_snapshot_bytes(&snapshot, &size);
+  sent = -1;
+  if (bytes != NULL) {
+    put_frame_header(header, FRAME_SNAPSHOT,
+                     (unsigned long)(HELLO_SIZE + size));
+    codec_put_u32(header + FRAME_HEADER, replicator->epoch);
+    put_seq(header + FRAME_HEADER + 4, seq);
+    sent = send_all(sender->socket, header, sizeof(header));
+    if (sent == 0) {
+      sent = send_all(sender->socket, bytes, size);
+    }
+  }
+
+  parking_lot_write_lock(lot);
+  end_parking_snapshot(lot, &snapshot);
+  parking_lot_write_unlock(lot);
+
+  if (sent == 0) {
+    spin_lock(&replicator->lock);
+    replicator->snapshots_sent++;
+    spin_unlock(&replicator->lock);
+  }
+  return sent;
+}
+
+/**
+ * @brief (静态辅助函数) 读取备节点的 HELLO，决定续传还是发送快照。
+ * @param sender 发送线程。
+ * @return 成功返回 0，连接失效或正在停止返回 -1。
+ */
+static int start_stream(ReplicaSender *sender) {
+  ParkingReplicator *replicator = sender->owner;
+  unsigned char hello[FRAME_HEADER + HELLO_SIZE];
+  unsigned long epoch;
+  unsigned long seq;
+  int resume = 0;
+
+  if (recv_exact(sender->socket, hello, sizeof(hello), REPLICA_TIMEOUT_MS) !=
+          0 ||
+      hello[0] != FRAME_HELLO ||
+      codec_get_u32(hello + 1) != HELLO_SIZE) {
+    return -1;
+  }
+  epoch = codec_get_u32(hello + FRAME_HEADER);
+  seq = get_seq(hello + FRAME_HEADER + 4);
+
+  spin_lock(&replicator->lock);
+  if (epoch == replicator->epoch && seq + 1 >= replicator->first_seq &&
+      seq < replicator->next_seq) {
+    sender->offset = backlog_offset_of(replicator, seq + 1);
+    sender->lost = 0;
+    resume = 1;
+  }
+  spin_unlock(&replicator->lock);
+
+  if (!resume) {
+    return send_snapshot(sender);
+  }
+  hello[0] = FRAME_WELCOME;
+  return send_all(sender->socket, hello, sizeof(hello));
+}
+
+/**
+ * @brief (静态辅助函数) 发送线程入口：按序推送积压缓冲区中的记录。
+ * @details 每次在自旋锁内整帧复制至多 REPLICA_SEND_CHUNK 字节，
+ *          锁外写套接字；没有新记录时等待唤醒，超过心跳间隔发送心跳。
+ * @param arg 对应的 ReplicaSender。
+ */
+static void sender_loop(void *arg) {
+  ReplicaSender *sender = (ReplicaSender *)arg;
+  ParkingReplicator *replicator = sender->owner;
+  unsigned char heartbeat[FRAME_HEADER + SEQ_SIZE];
+  unsigned char *chunk = (unsigned char *)malloc(REPLICA_SEND_CHUNK);
+  unsigned long last_send = now_ms();
+  unsigned long head;
+  size_t length;
+  size_t frame;
+  int lost;
+
+  if (chunk == NULL || start_stream(sender) != 0) {
+    free(chunk);
+    parking_atomic_store_int(&sender->finished, 1);
+    return;
+  }
+
+  while (!parking_atomic_load_int(&replicator->stopping)) {
+    spin_lock(&replicator->lock);
+    lost = sender->lost;
+    length = 0;
+    while (!lost && sender->offset + length < replicator->backlog_used) {
+      frame = FRAME_HEADER + codec_get_u32(replicator->backlog +
+                                           sender->offset + length + 1);
+      if (length + frame > REPLICA_SEND_CHUNK) {
+        break;
+      }
+      length += frame;
+    }
+    memcpy(chunk, replicator->backlog + sender->offset, length);
+    sender->offset += length;
+    head = replicator->next_seq - 1;
+    sender->waiting = !lost && length == 0;
+    spin_unlock(&replicator->lock);
+
+    if (lost) {
+      if (send_snapshot(sender) != 0) {
+        break;
+      }
+      last_send = now_ms();
+      continue;
+    }
+    if (length > 0) {
+      if (send_all(sender->socket, chunk, length) != 0) {
+        break;
+      }
+      last_send = now_ms();
+      continue;
+    }
+    if (now_ms() - last_send >= REPLICA_HEARTBEAT_MS) {
+      put_frame_header(heartbeat, FRAME_HEARTBEAT, SEQ_SIZE);
+      put_seq(heartbeat + FRAME_HEADER, head);
+      if (send_all(sender->socket, heartbeat, sizeof(heartbeat)) != 0) {
+        break;
+      }
+      last_send = now_ms();
+    }
+    parking_signal_wait(sender->signal, REPLICA_HEARTBEAT_MS);
+  }
+
+  spin_lock(&replicator->lock);
+  sender->waiting = 0;
+  spin_unlock(&replicator->lock);
+  free(chunk);
+  parking_atomic_store_int(&sender->finished, 1);
+}
+
+/**
+ * @brief (静态辅助函数) 回收一个发送线程占用的位置。
+ * @details 先关闭套接字使阻塞中的 send 返回，再等待线程退出。
+ * @param sender 发送线程。
+ */
+static void reap_sender(ReplicaSender *sender) {
+  ParkingReplicator *replicator = sender->owner;
+
+  shutdown(sender->socket, REPLICA_SHUTDOWN_BOTH);
+  parking_signal_notify(sender->signal);
+  parking_thread_join(sender->thread);
+  close_socket(sender->socket);
+  parking_signal_destroy(sender->signal);
+
+  spin_lock(&replicator->lock);
+  sender->active = 0;
+  sender->waiting = 0;
+  spin_unlock(&replicator->lock);
+  sender->thread = NULL;
+  sender->signal = NULL;
+  sender->finished = 0;
+}
+
+/**
+ * @brief (静态辅助函数) 为新连接分配发送线程。
+ * @param replicator 复制服务。
+ * @param client 新连接。
+ */
+static void accept_follower(ParkingReplicator *replicator,
+                            ReplicaSocket client) {
+  ReplicaSender *sender = NULL;
+  int i;
+
+  for (i = 0; i < REPLICA_MAX_FOLLOWERS && sender == NULL; i++) {
+    if (!replicator->senders[i].active) {
+      sender = &replicator->senders[i];
+    }
+  }
+  if (sender == NULL) {
+    close_socket(client);
+    return;
+  }
+  sender->signal = parking_signal_create();
+  if (sender->signal == NULL) {
+    close_socket(client);
+    return;
+  }
+  sender->socket = client;
+  sender->finished = 0;
+  spin_lock(&replicator->lock);
+  sender->active = 1;
+  sender->waiting = 0;
+  sender->lost = 0;
+  sender->offset = replicator->backlog_used;
+  spin_unlock(&replicator->lock);
+
+  sender->thread = parking_thread_start(sender_loop, sender);
+  if (sender->thread == NULL) {
+    spin_lock(&replicator->lock);
+    sender->active = 0;
+    spin_unlock(&replicator->lock);
+    parking_signal_destroy(sender->signal);
+    sender->signal = NULL;
+    close_socket(client);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 接受连接的线程入口，顺带回收已退出的发送线程。
+ * @param arg 复制服务。
+ */
+static void replicator_loop(void *arg) {
+  ParkingReplicator *replicator = (ParkingReplicator *)arg;
+  int i;
+
+  while (!parking_atomic_load_int(&replicator->stopping)) {
+    ReplicaSocket client;
+
+    for (i = 0; i < REPLICA_MAX_FOLLOWERS; i++) {
+      if (replicator->senders[i].active &&
+          parking_atomic_load_int(&replicator->senders[i].finished)) {
+        reap_sender(&replicator->senders[i]);
+      }
+    }
+    if (!wait_readable(replicator->listener, REPLICA_POLL_MS)) {
+      continue;
+    }
+    client = accept(replicator->listener, NULL, NULL);
+    if (client != REPLICA_INVALID_SOCKET) {
+      accept_follower(replicator, client);
+    }
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  备节点                                    */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief (静态辅助函数) 用快照内容替换备节点的停车场。
+ * @param follower 备节点。
+ * @param payload 快照帧的负载（epoch、序号与快照内容）。
+ * @param length 负载字节数。
+ * @return 成功返回 0，快照无效或内存不足返回 -1。
+ */
+static int load_snapshot(ParkingFollower *follower,
+                         const unsigned char *payload, size_t length) {
+  ParkingLot *lot;
+  ParkingLot *old;
+
+  if (length < HELLO_SIZE) {
+    return -1;
+  }
+  lot = load_parking_snapshot_memory(payload + HELLO_SIZE,
+                                     length - HELLO_SIZE);
+  if (lot == NULL) {
+    return -1;
+  }
+  parking_rwlock_write_lock(follower->swap_lock);
+  old = follower->lot;
+  follower->lot = lot;
+  parking_rwlock_write_unlock(follower->swap_lock);
+  free_parking_lot(old);
+
+  spin_lock(&follower->lock);
+  follower->epoch = codec_get_u32(payload);
+  follower->status.has_state = 1;
+  follower->status.applied_seq = get_seq(payload + 4);
+  if (follower->status.primary_seq < follower->status.applied_seq) {
+    follower->status.primary_seq = follower->status.applied_seq;
+  }
+  follower->status.snapshots_loaded++;
+  spin_unlock(&follower->lock);
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 读完一个超出接收缓冲区的快照帧并加载。
+ * @param follower 备节点。
+ * @param socket_fd 当前连接。
+ * @param buffered 缓冲区中已收到的帧字节（含帧头）。
+ * @param available buffered 的字节数。
+ * @param length 帧负载的字节数。
+ * @return 成功返回 0，连接失效、内存不足或快照无效返回 -1。
+ */
+static int receive_large_snapshot(ParkingFollower *follower,
+                                  ReplicaSocket socket_fd,
+                                  const unsigned char *buffered,
+                                  size_t available, size_t length) {
+  unsigned char *payload = (unsigned char *)malloc(length);
+  size_t have = available - FRAME_HEADER;
+  int result = -1;
+
+  if (payload == NULL) {
+    return -1;
+  }
+  memcpy(payload, buffered + FRAME_HEADER, have);
+  if (recv_exact(socket_fd, payload + have, length - have,
+                 REPLICA_TIMEOUT_MS) == 0) {
+    result = load_snapshot(follower, payload, length);
+  }
+  free(payload);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 处理接收缓冲区中的完整帧。
+ * @details 连续的记录帧在同一次写锁内应用。
+ * @param follower 备节点。
+ * @param socket_fd 当前连接（读取大快照时使用）。
+ * @param available 缓冲区中的字节数。
+ * @param[out] consumed 接收已处理的字节数。
+ * @return 成功返回 0；协议错误、序号不连续或快照无效返回 -1。
+ */
+static int process_frames(ParkingFollower *follower, ReplicaSocket socket_fd,
+                          size_t available, size_t *consumed) {
+  const unsigned char *data = follower->buffer;
+  ParkingLot *locked = NULL;
+  JournalRecord record;
+  unsigned long expected;
+  unsigned long seq;
+  size_t offset = 0;
+  size_t length;
+  int result = 0;
+
+  spin_lock(&follower->lock);
+  expected = follower->status.applied_seq + 1;
+  spin_unlock(&follower->lock);
+
+  while (result == 0 && available - offset >= FRAME_HEADER) {
+    const unsigned char *frame = data + offset;
+
+    length = codec_get_u32(frame + 1);
+    if (available - offset - FRAME_HEADER < length) {
+      if (frame[0] == FRAME_SNAPSHOT) {
+        if (locked != NULL) {
+          parking_lot_write_unlock(locked);
+          locked = NULL;
+        }
+        result = receive_large_snapshot(follower, socket_fd, frame,
+                                        available - offset, length);
+        offset = available;
+        expected = follower->status.applied_seq + 1;
+        continue;
+      }
+      if (length > REPLICA_RECV_BYTES - FRAME_HEADER) {
+        result = -1;
+      }
+      break;
+    }
+
+    switch (frame[0]) {
+    case FRAME_RECORD:
+      seq = length >= SEQ_SIZE ? get_seq(frame + FRAME_HEADER) : 0;
+      if (follower->lot == NULL || seq != expected ||
+          journal_decode_record(frame + FRAME_HEADER + SEQ_SIZE,
+                                length - SEQ_SIZE,
+                                &record) != (long)(length - SEQ_SIZE)) {
+        result = -1;
+        break;
+      }
+      if (locked == NULL) {
+        locked = follower->lot;
+        parking_lot_write_lock(locked);
+      }
+      apply_parking_journal_record(locked, &record);
+      spin_lock(&follower->lock);
+      follower->status.applied_seq = seq;
+      if (follower->status.primary_seq < seq) {
+        follower->status.primary_seq = seq;
+      }
+      spin_unlock(&follower->lock);
+      expected = seq + 1;
+      break;
+    case FRAME_HEARTBEAT:
+      if (length != SEQ_SIZE) {
+        result = -1;
+        break;
+      }
+      seq = get_seq(frame + FRAME_HEADER);
+      spin_lock(&follower->lock);
+      if (follower->status.primary_seq < seq) {
+        follower->status.primary_seq = seq;
+      }
+      spin_unlock(&follower->lock);
+      break;
+    case FRAME_WELCOME:
+      if (length != HELLO_SIZE ||
+          codec_get_u32(frame + FRAME_HEADER) != follower->epoch ||
+          get_seq(frame + FRAME_HEADER + 4) != expected - 1) {
+        result = -1;
+      }
+      break;
+    case FRAME_SNAPSHOT:
+      if (locked != NULL) {
+        parking_lot_write_unlock(locked);
+        locked = NULL;
+      }
+      result = load_snapshot(follower, frame + FRAME_HEADER, length);
+      expected = follower->status.applied_seq + 1;
+      break;
+    default:
+      result = -1;
+      break;
+    }
+    offset += FRAME_HEADER + length;
+  }
+
+  if (locked != NULL) {
+    parking_lot_write_unlock(locked);
+  }
+  parking_signal_notify(follower->applied);
+  *consumed = offset > available ? available : offset;
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 连接主节点并发送 HELLO。
+ * @param follower 备节点。
+ * @return 成功返回连接，失败返回 REPLICA_INVALID_SOCKET。
+ */
+static ReplicaSocket connect_primary(ParkingFollower *follower) {
+  struct sockaddr_in address;
+  unsigned char hello[FRAME_HEADER + HELLO_SIZE];
+  ReplicaSocket socket_fd;
+
+  if (fill_address(&address, follower->host, follower->port) != 0) {
+    return REPLICA_INVALID_SOCKET;
+  }
+  socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (socket_fd == REPLICA_INVALID_SOCKET) {
+    return REPLICA_INVALID_SOCKET;
+  }
+  if (connect(socket_fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    close_socket(socket_fd);
+    return REPLICA_INVALID_SOCKET;
+  }
+
+  put_frame_header(hello, FRAME_HELLO, HELLO_SIZE);
+  spin_lock(&follower->lock);
+  codec_put_u32(hello + FRAME_HEADER,
+                follower->status.has_state ? follower->epoch : 0);
+  put_seq(hello + FRAME_HEADER + 4, follower->status.applied_seq);
+  follower->socket = socket_fd;
+  follower->status.connected = 1;
+  follower->contact_ms = now_ms();
+  spin_unlock(&follower->lock);
+
+  if (send_all(socket_fd, hello, sizeof(hello)) != 0) {
+    return REPLICA_INVALID_SOCKET;
+  }
+  return socket_fd;
+}
+
+/**
+ * @brief (静态辅助函数) 断开当前连接。
+ * @param follower 备节点。
+ * @param socket_fd 要关闭的连接。
+ */
+static void disconnect_primary(ParkingFollower *follower,
+                               ReplicaSocket socket_fd) {
+  spin_lock(&follower->lock);
+  follower->socket = REPLICA_INVALID_SOCKET;
+  follower->status.connected = 0;
+  spin_unlock(&follower->lock);
+  close_socket(socket_fd);
+}
+
+/**
+ * @brief (静态辅助函数) 备节点线程入口：连接、接收、应用，断线后重连。
+ * @param arg 备节点。
+ */
+static void follower_loop(void *arg) {
+  ParkingFollower *follower = (ParkingFollower *)arg;
+
+  while (!parking_atomic_load_int(&follower->stopping)) {
+    ReplicaSocket socket_fd = connect_primary(follower);
+    size_t buffered = 0;
+    size_t consumed;
+    int got;
+
+    if (socket_fd == REPLICA_INVALID_SOCKET) {
+      spin_lock(&follower->lock);
+      socket_fd = follower->socket;
+      spin_unlock(&follower->lock);
+      if (socket_fd != REPLICA_INVALID_SOCKET) {
+        disconnect_primary(follower, socket_fd);
+      }
+      parking_signal_wait(follower->wake, REPLICA_RETRY_MS);
+      continue;
+    }
+
+    while (!parking_atomic_load_int(&follower->stopping) &&
+           wait_readable(socket_fd, REPLICA_TIMEOUT_MS)) {
+      got = (int)recv(socket_fd, (char *)follower->buffer + buffered,
+                      (int)(REPLICA_RECV_BYTES - buffered), 0);
+      if (got <= 0) {
+        break;
+      }
+      buffered += (size_t)got;
+      spin_lock(&follower->lock);
+      follower->contact_ms = now_ms();
+      spin_unlock(&follower->lock);
+      if (process_frames(follower, socket_fd, buffered, &consumed) != 0) {
+        break;
+      }
+      memmove(follower->buffer, follower->buffer + consumed,
+              buffered - consumed);
+      buffered -= consumed;
+    }
+    disconnect_primary(follower, socket_fd);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 停止备节点线程并释放除停车场外的全部资源。
+ * @param follower 备节点。
+ * @return 备节点的停车场，可能为 NULL。
+ */
+static ParkingLot *shutdown_follower(ParkingFollower *follower) {
+  ParkingLot *lot;
+
+  parking_atomic_store_int(&follower->stopping, 1);
+  spin_lock(&follower->lock);
+  if (follower->socket != REPLICA_INVALID_SOCKET) {
+    shutdown(follower->socket, REPLICA_SHUTDOWN_BOTH);
+  }
+  spin_unlock(&follower->lock);
+  parking_signal_notify(follower->wake);
+  parking_thread_join(follower->thread);
+
+  lot = follower->lot;
+  parking_signal_destroy(follower->wake);
+  parking_signal_destroy(follower->applied);
+  parking_rwlock_destroy(follower->swap_lock);
+  free(follower->buffer);
+  free(follower);
+#ifdef _WIN32
+  WSACleanup();
+#endif
+  return lot;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 为停车场启动复制服务并开始监听备节点连接。
+ * @param lot 主节点的停车场。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配。
+ * @return 成功返回服务句柄，失败返回 NULL。
+ */
+ParkingReplicator *parking_replicator_start(ParkingLot *lot, const char *host,
+                                            int port) {
+  ParkingReplicator *replicator;
+  int i;
+#ifdef _WIN32
+  WSADATA wsa;
+#endif
+
+  if (lot == NULL || port < 0 || port > 65535) {
+    return NULL;
+  }
+#ifdef _WIN32
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+    return NULL;
+  }
+#endif
+  replicator = (ParkingReplicator *)calloc(1, sizeof(ParkingReplicator));
+  if (replicator != NULL) {
+    replicator->lot = lot;
+    replicator->backlog = (unsigned char *)malloc(REPLICA_BACKLOG_BYTES);
+    replicator->listener =
+        open_listener(host ? host : "127.0.0.1", port, &replicator->port);
+  }
+  if (replicator == NULL || replicator->backlog == NULL ||
+      replicator->listener == REPLICA_INVALID_SOCKET) {
+    if (replicator != NULL) {
+      if (replicator->listener != REPLICA_INVALID_SOCKET) {
+        close_socket(replicator->listener);
+      }
+      free(replicator->backlog);
+      free(replicator);
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return NULL;
+  }
+  replicator->epoch =
+      ((unsigned long)time(NULL) ^ (unsigned long)(size_t)replicator) &
+      0xFFFFFFFFUL;
+  if (replicator->epoch == 0) {
+    replicator->epoch = 1;
+  }
+  replicator->first_seq = 1;
+  replicator->next_seq = 1;
+  for (i = 0; i < REPLICA_MAX_FOLLOWERS; i++) {
+    replicator->senders[i].owner = replicator;
+  }
+
+  parking_lot_write_lock(lot);
+  set_parking_mutation_tap(lot, replicate_record, replicator);
+  parking_lot_write_unlock(lot);
+
+  replicator->thread = parking_thread_start(replicator_loop, replicator);
+  if (replicator->thread == NULL) {
+    parking_lot_write_lock(lot);
+    set_parking_mutation_tap(lot, NULL, NULL);
+    parking_lot_write_unlock(lot);
+    close_socket(replicator->listener);
+    free(replicator->backlog);
+    free(replicator);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return NULL;
+  }
+  return replicator;
+}
+
+/**
+ * @brief 查询复制服务实际监听的端口。
+ * @param replicator 服务句柄。
+ * @return 端口号；replicator 为 NULL 时返回 0。
+ */
+int parking_replicator_port(const ParkingReplicator *replicator) {
+  return replicator != NULL ? replicator->port : 0;
+}
+
+/**
+ * @brief 查询复制服务的状态。
+ * @param replicator 服务句柄。
+ * @param[out] status 接收状态。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int parking_replicator_status(ParkingReplicator *replicator,
+                              ReplicatorStatus *status) {
+  int i;
+
+  if (replicator == NULL || status == NULL) {
+    return -1;
+  }
+  spin_lock(&replicator->lock);
+  status->head_seq = replicator->next_seq - 1;
+  status->backlog_seq = replicator->first_seq;
+  status->snapshots_sent = replicator->snapshots_sent;
+  status->followers = 0;
+  for (i = 0; i < REPLICA_MAX_FOLLOWERS; i++) {
+    if (replicator->senders[i].active &&
+        !parking_atomic_load_int(&replicator->senders[i].finished)) {
+      status->followers++;
+    }
+  }
+  spin_unlock(&replicator->lock);
+  return 0;
+}
+
+/**
+ * @brief 停止复制服务、断开全部备节点并释放句柄。
+ * @param replicator 服务句柄，可以为 NULL。
+ */
+void parking_replicator_stop(ParkingReplicator *replicator) {
+  int i;
+
+  if (replicator == NULL) {
+    return;
+  }
+  parking_lot_write_lock(replicator->lot);
+  set_parking_mutation_tap(replicator->lot, NULL, NULL);
+  parking_lot_write_unlock(replicator->lot);
+
+  parking_atomic_store_int(&replicator->stopping, 1);
+  parking_thread_join(replicator->thread);
+  for (i = 0; i < REPLICA_MAX_FOLLOWERS; i++) {
+    if (replicator->senders[i].active) {
+      reap_sender(&replicator->senders[i]);
+    }
+  }
+  close_socket(replicator->listener);
+  free(replicator->backlog);
+  free(replicator);
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
+
+/**
+ * @brief 启动备节点。
+ * @param host 主节点的 IPv4 地址；为 NULL 时连接 127.0.0.1。
+ * @param port 主节点复制服务的端口。
+ * @return 成功返回句柄，失败返回 NULL。
+ */
+ParkingFollower *parking_follower_start(const char *host, int port) {
+  ParkingFollower *follower;
+#ifdef _WIN32
+  WSADATA wsa;
+#endif
+
+  if (host == NULL) {
+    host = "127.0.0.1";
+  }
+  if (port <= 0 || port > 65535 || strlen(host) >= sizeof(follower->host)) {
+    return NULL;
+  }
+#ifdef _WIN32
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+    return NULL;
+  }
+#endif
+  follower = (ParkingFollower *)calloc(1, sizeof(ParkingFollower));
+  if (follower != NULL) {
+    strcpy(follower->host, host);
+    follower->port = port;
+    follower->socket = REPLICA_INVALID_SOCKET;
+    follower->buffer = (unsigned char *)malloc(REPLICA_RECV_BYTES);
+    follower->wake = parking_signal_create();
+    follower->applied = parking_signal_create();
+    follower->swap_lock = parking_rwlock_create();
+  }
+  if (follower == NULL || follower->buffer == NULL || follower->wake == NULL ||
+      follower->applied == NULL || follower->swap_lock == NULL ||
+      (follower->thread = parking_thread_start(follower_loop, follower)) ==
+          NULL) {
+    if (follower != NULL) {
+      free(follower->buffer);
+      parking_signal_destroy(follower->wake);
+      parking_signal_destroy(follower->applied);
+      parking_rwlock_destroy(follower->swap_lock);
+      free(follower);
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return NULL;
+  }
+  return follower;
+}
+
+/**
+ * @brief 取得备节点的停车场并持有其读锁。
+ * @param follower 备节点句柄。
+ * @return 停车场；尚未收到快照时返回 NULL。
+ */
+ParkingLot *parking_follower_acquire(ParkingFollower *follower) {
+  ParkingLot *lot;
+
+  if (follower == NULL) {
+    return NULL;
+  }
+  parking_rwlock_read_lock(follower->swap_lock);
+  lot = follower->lot;
+  if (lot == NULL) {
+    parking_rwlock_read_unlock(follower->swap_lock);
+    return NULL;
+  }
+  parking_lot_read_lock(lot);
+  return lot;
+}
+
+/**
+ * @brief 归还 parking_follower_acquire 取得的停车场。
+ * @param follower 备节点句柄。
+ * @param lot parking_follower_acquire 的返回值。
+ */
+void parking_follower_release(ParkingFollower *follower, ParkingLot *lot) {
+  if (follower == NULL || lot == NULL) {
+    return;
+  }
+  parking_lot_read_unlock(lot);
+  parking_rwlock_read_unlock(follower->swap_lock);
+}
+
+/**
+ * @brief 查询备节点的状态。
+ * @param follower 备节点句柄。
+ * @param[out] status 接收状态。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int parking_follower_status(ParkingFollower *follower, FollowerStatus *status) {
+  if (follower == NULL || status == NULL) {
+    return -1;
+  }
+  spin_lock(&follower->lock);
+  *status = follower->status;
+  status->lag_ms =
+      status->connected ? (long)(now_ms() - follower->contact_ms) : -1;
+  spin_unlock(&follower->lock);
+  return 0;
+}
+
+/**
+ * @brief 等待备节点应用到指定序号。
+ * @param follower 备节点句柄。
+ * @param seq 目标序号。
+ * @param timeout_ms 最长等待的毫秒数。
+ * @return 已应用到 seq 返回 1，超时返回 0。
+ */
+int parking_follower_wait(ParkingFollower *follower, unsigned long seq,
+                          unsigned long timeout_ms) {
+  unsigned long started = now_ms();
+  int reached;
+
+  if (follower == NULL) {
+    return 0;
+  }
+  for (;;) {
+    spin_lock(&follower->lock);
+    reached = follower->status.has_state && follower->status.applied_seq >= seq;
+    spin_unlock(&follower->lock);
+    if (reached) {
+      return 1;
+    }
+    if (now_ms() - started >= timeout_ms) {
+      return 0;
+    }
+    parking_signal_wait(follower->applied, REPLICA_HEARTBEAT_MS);
+  }
+}
+
+/**
+ * @brief 停止备节点并接管它的停车场。
+ * @param follower 备节点句柄。
+ * @return 备节点的停车场，可能为 NULL。
+ */
+ParkingLot *parking_follower_promote(ParkingFollower *follower) {
+  if (follower == NULL) {
+    return NULL;
+  }
+  return shutdown_follower(follower);
+}
+
+/**
+ * @brief 停止备节点并释放句柄与它的停车场。
+ * @param follower 备节点句柄，可以为 NULL。
+ */
+void parking_follower_stop(ParkingFollower *follower) {
+  if (follower != NULL) {
+    free_parking_lot(shutdown_follower(follower));
+  }
+}
@@ -0,0 +1,186 @@
+#ifndef PARKING_REPLICA_H
+#define PARKING_REPLICA_H
+
+#include <time.h>
+
+#include "parking_data.h"
+
+/**
+ * @file parking_replica.h
+ * @brief 主备之间基于日志记录的增量复制接口声明。
+ * @details
+ * 主节点以旁路接收者（set_parking_mutation_tap）取得数据层产生的每条
+ * 日志记录，编上从 1 开始的复制序号，放入内存中的积压缓冲区，
+ * 由每个备节点各自的发送线程通过 TCP 推送。备节点按序应用记录，
+ * 断线后自动重连并报告已应用的序号：
+ * - 序号之后的记录仍在积压缓冲区中时，只补发缺少的记录；
+ * - 否则（首次连接、落后过多或主节点已重启）先发送一份写时复制快照，
+ *   再从快照对应的序号继续推送记录。
+ *
+ * 连接上的每一帧为 1 字节类型、4 字节长度（小端序）与负载；
+ * 记录负载为 8 字节序号加 journal_encode_record 的编码。
+ * 主节点空闲时每 REPLICA_HEARTBEAT_MS 发送一次带最新序号的心跳，
+ * 备节点据此计算延迟，并在 REPLICA_TIMEOUT_MS 内收不到任何帧时重连。
+ *
+ * 只有经数据层日志记录表达的修改会被复制：车位增删、入场、出场、
+ * 信息修改与热字段同步。收费台账与停车记录不在复制范围内。
+ * 该模块由 CMake 选项 PARKING_REPLICATION 控制是否编入核心库。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define REPLICA_BACKLOG_BYTES (8 * 1024 * 1024) /**< 积压缓冲区的上限（字节） */
+#define REPLICA_MAX_FOLLOWERS 4  /**< 主节点同时服务的备节点数 */
+#define REPLICA_HEARTBEAT_MS 100 /**< 主节点空闲时的心跳间隔（毫秒） */
+#define REPLICA_TIMEOUT_MS 2000  /**< 备节点判定连接失效的时间（毫秒） */
+#define REPLICA_RETRY_MS 200     /**< 备节点重连的间隔（毫秒） */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 正在运行的主节点复制服务（不透明类型）。
+ */
+typedef struct ParkingReplicator ParkingReplicator;
+
+/**
+ * @brief 正在运行的备节点（不透明类型）。
+ */
+typedef struct ParkingFollower ParkingFollower;
+
+/**
+ * @brief 主节点复制服务的状态。
+ */
+typedef struct ReplicatorStatus {
+  unsigned long head_seq;    /**< 最近产生的复制序号。 */
+  unsigned long backlog_seq; /**< 积压缓冲区中最早的序号。 */
+  int followers;             /**< 当前连接的备节点数。 */
+  long snapshots_sent;       /**< 累计发送的快照数。 */
+} ReplicatorStatus;
+
+/**
+ * @brief 备节点的状态。
+ */
+typedef struct FollowerStatus {
+  int connected;             /**< 非 0 表示当前与主节点保持连接。 */
+  int has_state;             /**< 非 0 表示已收到过快照。 */
+  unsigned long applied_seq; /**< 已应用的复制序号。 */
+  unsigned long primary_seq; /**< 最近从主节点得知的最新序号。 */
+  long lag_ms;               /**< 距最近一次收到主节点数据的毫秒数。 */
+  long snapshots_loaded;     /**< 累计加载的快照数。 */
+} FollowerStatus;
+
+/**
+ *********************************************************************************
+ *                              主节点API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 为停车场启动复制服务并开始监听备节点连接。
+ * @details 函数自行加锁安装旁路接收者，调用者不得持有停车场的锁。
+ *          复制服务运行期间停车场不能再设置其他旁路接收者。
+ * @param lot 主节点的停车场，须比复制服务存活得久。
+ * @param host 监听的 IPv4 地址；为 NULL 时只监听 127.0.0.1。
+ * @param port 监听端口；为 0 时由系统分配，可用 parking_replicator_port 查询。
+ * @return 成功返回服务句柄；参数无效、地址无效、端口被占用或资源不足时
+ *         返回 NULL。
+ */
+ParkingReplicator *parking_replicator_start(ParkingLot *lot, const char *host,
+                                            int port);
+
+/**
+ * @brief 查询复制服务实际监听的端口。
+ * @param replicator 服务句柄。
+ * @return 端口号；replicator 为 NULL 时返回 0。
+ */
+int parking_replicator_port(const ParkingReplicator *replicator);
+
+/**
+ * @brief 查询复制服务的状态。
+ * @param replicator 服务句柄。
+ * @param[out] status 接收状态。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int parking_replicator_status(ParkingReplicator *replicator,
+                              ReplicatorStatus *status);
+
+/**
+ * @brief 停止复制服务、断开全部备节点并释放句柄。
+ * @details 调用者不得持有停车场的锁。
+ * @param replicator 服务句柄，可以为 NULL。
+ */
+void parking_replicator_stop(ParkingReplicator *replicator);
+
+/**
+ *********************************************************************************
+ *                              备节点API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 启动备节点，在后台连接主节点并持续应用复制数据。
+ * @param host 主节点的 IPv4 地址；为 NULL 时连接 127.0.0.1。
+ * @param port 主节点复制服务的端口。
+ * @return 成功返回句柄；参数无效或资源不足时返回 NULL。
+ *         主节点暂时不可达不算失败，备节点会按 REPLICA_RETRY_MS 重试。
+ */
+ParkingFollower *parking_follower_start(const char *host, int port);
+
+/**
+ * @brief 取得备节点的停车场并持有其读锁。
+ * @details 返回的停车场只读；必须以 parking_follower_release 归还，
+ *          归还前备节点不会替换它（应用记录会等待读锁释放）。
+ * @param follower 备节点句柄。
+ * @return 停车场；尚未收到快照时返回 NULL（此时无需归还）。
+ */
+ParkingLot *parking_follower_acquire(ParkingFollower *follower);
+
+/**
+ * @brief 归还 parking_follower_acquire 取得的停车场。
+ * @param follower 备节点句柄。
+ * @param lot parking_follower_acquire 的返回值。
+ */
+void parking_follower_release(ParkingFollower *follower, ParkingLot *lot);
+
+/**
+ * @brief 查询备节点的状态。
+ * @param follower 备节点句柄。
+ * @param[out] status 接收状态。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int parking_follower_status(ParkingFollower *follower, FollowerStatus *status);
+
+/**
+ * @brief 等待备节点应用到指定序号。
+ * @param follower 备节点句柄。
+ * @param seq 目标序号。
+ * @param timeout_ms 最长等待的毫秒数。
+ * @return 已应用到 seq 返回 1，超时返回 0。
+ */
+int parking_follower_wait(ParkingFollower *follower, unsigned long seq,
+                          unsigned long timeout_ms);
+
+/**
+ * @brief 停止备节点并接管它的停车场，用于主节点失效后的切换。
+ * @details 断开连接、停止后台线程并释放句柄；返回的停车场归调用者所有，
+ *          可以像普通停车场一样读写，或再为它启动复制服务。
+ * @param follower 备节点句柄。
+ * @return 备节点的停车场；尚未收到快照或 follower 为 NULL 时返回 NULL。
+ */
+ParkingLot *parking_follower_promote(ParkingFollower *follower);
+
+/**
+ * @brief 停止备节点并释放句柄与它的停车场。
+ * @param follower 备节点句柄，可以为 NULL。
+ */
+void parking_follower_stop(ParkingFollower *follower);
+
+#endif /* PARKING_REPLICA_H */
@@ -0,0 +1,315 @@
+/**
+ * @file parking_reservation.c
+ * @brief 车位预约簿实现文件
+ * @details
+ * 该文件实现了 parking_reservation.h 中声明的预约簿：以车位编号为键的
+ * 开放寻址哈希表，每个车位一个按开始时间排序、互不相交的预约数组。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_reservation.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define RESERVATION_LOAD_NUM 7  /**< 车位哈希表最大负载因子分子（7/10） */
+#define RESERVATION_LOAD_DEN 10 /**< 车位哈希表最大负载因子分母 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 计算车位编号的哈希值。
+ * @details 与车位编号索引相同，使用 MurmurHash3 的 32 位最终混合函数。
+ * @param slot_id 车位编号。
+ * @return 32 位哈希值。
+ */
+static unsigned long hash_slot(int slot_id) {
+  unsigned long h = (unsigned long)(unsigned int)slot_id & 0xFFFFFFFFUL;
+
+  h ^= h >> 16;
+  h = (h * 0x85EBCA6BUL) & 0xFFFFFFFFUL;
+  h ^= h >> 13;
+  h = (h * 0xC2B2AE35UL) & 0xFFFFFFFFUL;
+  h ^= h >> 16;
+  return h;
+}
+
+/**
+ * @brief (静态辅助函数) 在哈希表中查找车位的槽位。
+ * @param lists 哈希表。
+ * @param capacity 哈希表容量（2 的幂，大于 0）。
+ * @param slot_id 车位编号。
+ * @return 该车位的槽位；车位不在表中时返回探测到的第一个空槽位。
+ */
+static ReservationList *probe_list(ReservationList *lists, size_t capacity,
+                                   int slot_id) {
+  size_t mask = capacity - 1;
+  size_t i = (size_t)hash_slot(slot_id) & mask;
+
+  while (lists[i].in_use && lists[i].slot_id != slot_id) {
+    i = (i + 1) & mask;
+  }
+  return &lists[i];
+}
+
+/**
+ * @brief (静态辅助函数) 查找车位的预约数组。
+ * @param book 预约簿。
+ * @param slot_id 车位编号。
+ * @return 该车位的预约数组，车位从未有过预约时返回 NULL。
+ */
+static ReservationList *find_list(const ReservationBook *book, int slot_id) {
+  ReservationList *list;
+
+  if (book->list_capacity == 0) {
+    return NULL;
+  }
+  list = probe_list(book->lists, book->list_capacity, slot_id);
+  return list->in_use ? list : NULL;
+}
+
+/**
+ * @brief (静态辅助函数) 将哈希表扩容到指定容量并重新散列所有槽位。
+ * @param book 预约簿。
+ * @param capacity 新容量，必须为 2 的幂。
+ * @return 成功返回 0，内存不足返回 -1（此时原哈希表保持不变）。
+ */
+static int grow_lists(ReservationBook *book, size_t capacity) {
+  ReservationList *lists;
+  size_t i;
+
+  lists = (ReservationList *)parking_memory_calloc(
+      book->memory, PARKING_MEMORY_INDEX, capacity, sizeof(ReservationList));
+  if (lists == NULL) {
+    return -1;
+  }
+  for (i = 0; i < book->list_capacity; i++) {
+    if (book->lists[i].in_use) {
+      *probe_list(lists, capacity, book->lists[i].slot_id) = book->lists[i];
+    }
+  }
+  parking_memory_free(book->memory, book->lists);
+  book->lists = lists;
+  book->list_capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 取得车位的预约数组，不存在时登记一个空数组。
+ * @param book 预约簿。
+ * @param slot_id 车位编号。
+ * @return 该车位的预约数组，内存不足时返回 NULL。
+ */
+static ReservationList *ensure_list(ReservationBook *book, int slot_id) {
+  ReservationList *list = find_list(book, slot_id);
+
+  if (list != NULL) {
+    return list;
+  }
+  if ((book->list_count + 1) * RESERVATION_LOAD_DEN >
+      book->list_capacity * RESERVATION_LOAD_NUM) {
+    if (grow_lists(book, book->list_capacity * 2) != 0) {
+      return NULL;
+    }
+  }
+  list = probe_list(book->lists, book->list_capacity, slot_id);
+  list->in_use = 1;
+  list->slot_id = slot_id;
+  book->list_count++;
+  return list;
+}
+
+/**
+ * @brief (静态辅助函数) 二分查找第一个在指定时刻之后才结束的预约。
+ * @details 同一车位的预约互不相交，按开始时间排序时结束时间也有序。
+ * @param list 车位的预约数组。
+ * @param when 时刻。
+ * @return 第一个 end > when 的预约下标，没有时返回 list->count。
+ */
+static int first_ending_after(const ReservationList *list, time_t when) {
+  int low = 0;
+  int high = list->count;
+
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+
+    if (list->items[mid].end > when) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return low;
+}
+
+/**
+ * @brief (静态辅助函数) 删除预约数组中下标 [begin, end) 的预约。
+ * @param book 预约簿。
+ * @param list 车位的预约数组。
+ * @param begin 起始下标。
+ * @param end 结束下标（不含）。
+ */
+static void drop_items(ReservationBook *book, ReservationList *list, int begin,
+                       int end) {
+  if (end <= begin) {
+    return;
+  }
+  memmove(&list->items[begin], &list->items[end],
+          (size_t)(list->count - end) * sizeof(Reservation));
+  list->count -= end - begin;
+  book->reservation_count -= end - begin;
+}
+
+/* ========================================================================== */
+/*                                预约簿API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个空的预约簿。
+ * @param memory 预约簿的分配来源，NULL 表示 C 堆。
+ * @return 成功返回预约簿，内存不足返回 NULL。
+ */
+ReservationBook *reservation_book_create(ParkingMemory *memory) {
+  ReservationBook *book;
+
+  book = (ReservationBook *)parking_memory_calloc(memory, PARKING_MEMORY_INDEX,
+                                                  1, sizeof(ReservationBook));
+  if (book == NULL) {
+    return NULL;
+  }
+  book->memory = memory;
+  if (grow_lists(book, RESERVATION_BOOK_INITIAL) != 0) {
+    parking_memory_free(memory, book);
+    return NULL;
+  }
+  return book;
+}
+
+/**
+ * @brief 释放预约簿。
+ * @param book 要释放的预约簿，可以为 NULL。
+ */
+void reservation_book_free(ReservationBook *book) {
+  size_t i;
+
+  if (book == NULL) {
+    return;
+  }
+  for (i = 0; i < book->list_capacity; i++) {
+    parking_memory_free(book->memory, book->lists[i].items);
+  }
+  parking_memory_free(book->memory, book->lists);
+  parking_memory_free(book->memory, book);
+}
+
+/**
+ * @brief 新增一条预约。
+ * @param book 目标预约簿。
+ * @param reservation 要新增的预约，id 字段被忽略。
+ * @param now 当前时间。
+ * @return 成功返回新预约的编号，与已有预约重叠返回 -1，内存不足返回 -2。
+ */
+long reservation_book_add(ReservationBook *book,
+                          const Reservation *reservation, time_t now) {
+  ReservationList *list;
+  int at;
+
+  list = ensure_list(book, reservation->slot_id);
+  if (list == NULL) {
+    return -2;
+  }
+
+  drop_items(book, list, 0, first_ending_after(list, now));
+  at = first_ending_after(list, reservation->start);
+  if (at < list->count && list->items[at].start < reservation->end) {
+    return -1;
+  }
+
+  if (list->count == list->capacity) {
+    int capacity =
+        list->capacity > 0 ? list->capacity * 2 : RESERVATION_LIST_INITIAL;
+    Reservation *items = (Reservation *)parking_memory_realloc(
+        book->memory, PARKING_MEMORY_INDEX, list->items,
+        (size_t)capacity * sizeof(Reservation));
+
+    if (items == NULL) {
+      return -2;
+    }
+    list->items = items;
+    list->capacity = capacity;
+  }
+
+  memmove(&list->items[at + 1], &list->items[at],
+          (size_t)(list->count - at) * sizeof(Reservation));
+  list->items[at] = *reservation;
+  list->items[at].id = ++book->next_id;
+  list->count++;
+  book->reservation_count++;
+  return list->items[at].id;
+}
+
+/**
+ * @brief 删除车位上的一条预约。
+ * @param book 目标预约簿。
+ * @param slot_id 车位编号。
+ * @param reservation_id 预约编号。
+ * @return 成功返回 0，找不到该预约返回 -1。
+ */
+int reservation_book_remove(ReservationBook *book, int slot_id,
+                            long reservation_id) {
+  ReservationList *list = find_list(book, slot_id);
+  int i;
+
+  if (list == NULL) {
+    return -1;
+  }
+  for (i = 0; i < list->count; i++) {
+    if (list->items[i].id == reservation_id) {
+      drop_items(book, list, i, i + 1);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief 查找车位上与 [start, end) 相交的第一条预约。
+ * @param book 目标预约簿。
+ * @param slot_id 车位编号。
+ * @param start 时间窗起点（含）。
+ * @param end 时间窗终点（不含）。
+ * @return 相交的预约，没有时返回 NULL。
+ */
+const Reservation *reservation_book_overlap(const ReservationBook *book,
+                                            int slot_id, time_t start,
+                                            time_t end) {
+  const ReservationList *list = find_list(book, slot_id);
+  int at;
+
+  if (list == NULL) {
+    return NULL;
+  }
+  at = first_ending_after(list, start);
+  if (at < list->count && list->items[at].start < end) {
+    return &list->items[at];
+  }
+  return NULL;
+}
+
+/**
+ * @brief 删除车位上的全部预约。
+ * @param book 目标预约簿。
+ * @param slot_id 车位编号。
+ */
+void reservation_book_clear_slot(ReservationBook *book, int slot_id) {
+  ReservationList *list = find_list(book, slot_id);
+
+  if (list != NULL) {
+    drop_items(book, list, 0, list->count);
+  }
+}
@@ -0,0 +1,127 @@
+#ifndef PARKING_RESERVATION_H
+#define PARKING_RESERVATION_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "parking_data.h"
+#include "parking_memory.h"
+
+/**
+ * @file parking_reservation.h
+ * @brief 车位预约簿的结构与接口声明。
+ * @details
+ * 预约簿按车位编号保存预约（车位、时间区间、车牌号）。同一车位的预约
+ * 不允许重叠，因此每个车位的预约存为一个按开始时间排序、互不相交的区间数组，
+ * 结束时间也随之有序，二分查找即可定位与任一时间窗相交的预约
+ * （区间互不相交时，这就是区间树退化后的形式）。车位编号到区间数组的映射
+ * 是开放寻址哈希表。
+ *
+ * 判断一个车位在 [start, end) 内是否已被预约只需一次哈希查找与一次二分，
+ * 与该车位的预约数成对数关系；判断某个分区在某时段是否还有空位
+ * 只检查分区内的车位，不遍历全部预约。
+ *
+ * 已经结束的预约在同一车位下一次新增预约时清除。预约只保存在内存中，
+ * 不写入快照与预写日志。预约簿本身不加锁，由停车场的锁保护。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define RESERVATION_BOOK_INITIAL 16      /**< 车位哈希表的初始容量（2 的幂） */
+#define RESERVATION_LIST_INITIAL 4       /**< 每个车位预约数组的初始容量 */
+#define RESERVATION_HOLD_LEAD_SECONDS 900 /**< 预约开始前提前保留车位的秒数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个车位的全部预约。
+ */
+typedef struct ReservationList {
+  int in_use;          /**< 哈希表槽位是否已被某个车位使用。 */
+  int slot_id;         /**< 车位编号。 */
+  int count;           /**< 预约数。 */
+  int capacity;        /**< items 已分配的容量。 */
+  Reservation *items;  /**< 按开始时间排序、互不相交的预约。 */
+} ReservationList;
+
+/**
+ * @brief 停车场的预约簿。
+ */
+typedef struct ReservationBook {
+  ReservationList *lists; /**< 以车位编号为键的开放寻址哈希表。 */
+  size_t list_capacity;   /**< 哈希表容量（2 的幂）。 */
+  size_t list_count;      /**< 已使用的槽位数。 */
+  long next_id;           /**< 上一个分配的预约编号。 */
+  long reservation_count; /**< 全部车位的预约数（含尚未清除的已结束预约）。 */
+  ParkingMemory *memory;  /**< 分配来源，NULL 表示 C 堆。 */
+} ReservationBook;
+
+/**
+ *********************************************************************************
+ *                              预约簿API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个空的预约簿。
+ * @param memory 预约簿的分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @return 成功返回预约簿，内存不足返回 NULL。
+ */
+ReservationBook *reservation_book_create(ParkingMemory *memory);
+
+/**
+ * @brief 释放预约簿。
+ * @param book 要释放的预约簿，可以为 NULL。
+ */
+void reservation_book_free(ReservationBook *book);
+
+/**
+ * @brief 新增一条预约。
+ * @details 先清除该车位在 now 之前已经结束的预约，再检查与已有预约是否重叠。
+ * @param book 目标预约簿。
+ * @param reservation 要新增的预约，id 字段被忽略；调用者保证 start < end。
+ * @param now 当前时间。
+ * @return 成功返回新预约的编号（大于 0），与已有预约重叠返回 -1，
+ *         内存不足返回 -2。
+ */
+long reservation_book_add(ReservationBook *book,
+                          const Reservation *reservation, time_t now);
+
+/**
+ * @brief 删除车位上的一条预约。
+ * @param book 目标预约簿。
+ * @param slot_id 车位编号。
+ * @param reservation_id 预约编号。
+ * @return 成功返回 0，找不到该预约返回 -1。
+ */
+int reservation_book_remove(ReservationBook *book, int slot_id,
+                            long reservation_id);
+
+/**
+ * @brief 查找车位上与 [start, end) 相交的第一条预约。
+ * @param book 目标预约簿。
+ * @param slot_id 车位编号。
+ * @param start 时间窗起点（含）。
+ * @param end 时间窗终点（不含）。
+ * @return 相交的预约（下一次修改预约簿前有效），没有时返回 NULL。
+ */
+const Reservation *reservation_book_overlap(const ReservationBook *book,
+                                            int slot_id, time_t start,
+                                            time_t end);
+
+/**
+ * @brief 删除车位上的全部预约（例如车位被删除时）。
+ * @param book 目标预约簿。
+ * @param slot_id 车位编号。
+ */
+void reservation_book_clear_slot(ReservationBook *book, int slot_id);
+
+#endif /* PARKING_RESERVATION_H */
@@ -0,0 +1,200 @@
+/**
+ * @file parking_rollup.c
+ * @brief 按小时、按日滚动汇总的实现文件
+ * @details
+ * 该文件实现了 parking_rollup.h 中声明的滚动汇总。日桶的键是由本地日期
+ * 换算出的连续日序号（parking_calendar_day_number），相邻两天的桶在环中
+ * 相邻，取模即可定位，不需要调用 mktime。
+ */
+
+#include <string.h>
+
+#include "parking_calendar.h"
+#include "parking_rollup.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 求时刻所在的整小时编号。
+ * @param when 时间戳。
+ * @return 自 Unix 纪元起的小时数。
+ */
+static long hour_number(time_t when) { return (long)(when / 3600); }
+
+/**
+ * @brief (静态辅助函数) 取得键对应的桶，桶中是更早的周期时清零复用。
+ * @param buckets 环形桶数组。
+ * @param count 桶数。
+ * @param key 小时编号或日序号。
+ * @return 对应的桶；key 早于桶中保存的周期（已移出保留窗口）时返回 NULL。
+ */
+static RollupBucket *claim_bucket(RollupBucket *buckets, long count, long key) {
+  RollupBucket *bucket = &buckets[key % count];
+
+  if (bucket->key != key) {
+    if (bucket->key > key) {
+      return NULL;
+    }
+    memset(bucket, 0, sizeof(*bucket));
+    bucket->key = key;
+  }
+  return bucket;
+}
+
+/**
+ * @brief (静态辅助函数) 读取桶中某项指标的值。
+ * @param bucket 汇总桶。
+ * @param measure 指标。
+ * @param type 停车类型，-1 表示全部类型。
+ * @return 累计值。
+ */
+static long bucket_value(const RollupBucket *bucket, RollupMeasure measure,
+                         int type) {
+  if (type >= 0 && type < ROLLUP_TYPE_COUNT) {
+    return bucket->totals[measure][type];
+  }
+  return bucket->totals[measure][0] + bucket->totals[measure][1];
+}
+
+/* ========================================================================== */
+/*                              滚动汇总API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 初始化（清空）滚动汇总。
+ * @param rollup 要初始化的汇总。
+ */
+void rollup_init(RevenueRollup *rollup) { memset(rollup, 0, sizeof(*rollup)); }
+
+/**
+ * @brief 把一笔收入或一次出入场计入滚动汇总。
+ * @param rollup 目标汇总。
+ * @param when 发生时刻。
+ * @param day_key when 所在的本地日期（YYYYMMDD）。
+ * @param month_key when 所在的本地月份（YYYYMM）。
+ * @param type 停车类型。
+ * @param measure 指标。
+ * @param amount 累加量。
+ */
+void rollup_add(RevenueRollup *rollup, time_t when, long day_key,
+                long month_key, int type, RollupMeasure measure, long amount) {
+  RollupBucket *bucket;
+
+  if (rollup == NULL || when <= 0 || type < 0 || type >= ROLLUP_TYPE_COUNT ||
+      (unsigned int)measure >= ROLLUP_MEASURE_COUNT) {
+    return;
+  }
+
+  bucket = claim_bucket(rollup->days, ROLLUP_DAYS,
+                        parking_calendar_day_number(day_key));
+  if (bucket != NULL) {
+    bucket->totals[measure][type] += amount;
+  }
+
+  bucket = claim_bucket(rollup->hours, ROLLUP_HOURS, hour_number(when));
+  if (bucket == NULL) {
+    return;
+  }
+  bucket->totals[measure][type] += amount;
+  if (month_key < rollup->peak_month) {
+    return;
+  }
+  if (month_key > rollup->peak_month) {
+    memset(rollup->peaks, 0, sizeof(rollup->peaks));
+    rollup->peak_month = month_key;
+  }
+  if (bucket_value(bucket, measure, -1) > rollup->peaks[measure].value) {
+    rollup->peaks[measure].hour = bucket->key;
+    rollup->peaks[measure].value = bucket_value(bucket, measure, -1);
+  }
+}
+
+/**
+ * @brief 读取某一小时的累计值。
+ * @param rollup 目标汇总。
+ * @param when 该小时内的任一时刻。
+ * @param measure 指标。
+ * @param type 停车类型，-1 表示全部类型。
+ * @return 累计值；该小时已移出保留窗口或没有记录时返回 0。
+ */
+long rollup_hour_total(const RevenueRollup *rollup, time_t when,
+                       RollupMeasure measure, int type) {
+  long key = hour_number(when);
+  const RollupBucket *bucket;
+
+  if (rollup == NULL || when <= 0 ||
+      (unsigned int)measure >= ROLLUP_MEASURE_COUNT) {
+    return 0;
+  }
+  bucket = &rollup->hours[key % ROLLUP_HOURS];
+  return bucket->key == key ? bucket_value(bucket, measure, type) : 0;
+}
+
+/**
+ * @brief 读取截至某一天（含）的最近若干天的累计值。
+ * @param rollup 目标汇总。
+ * @param day_key 最后一天的本地日期（YYYYMMDD）。
+ * @param days 天数。
+ * @param measure 指标。
+ * @param type 停车类型，-1 表示全部类型。
+ * @return 累计值。
+ */
+long rollup_recent_days(const RevenueRollup *rollup, long day_key, int days,
+                        RollupMeasure measure, int type) {
+  long key = parking_calendar_day_number(day_key);
+  long total = 0;
+  int i;
+
+  if (rollup == NULL || (unsigned int)measure >= ROLLUP_MEASURE_COUNT) {
+    return 0;
+  }
+  if (days > ROLLUP_DAYS) {
+    days = ROLLUP_DAYS;
+  }
+  for (i = 0; i < days; i++) {
+    const RollupBucket *bucket = &rollup->days[(key - i) % ROLLUP_DAYS];
+
+    if (bucket->key == key - i) {
+      total += bucket_value(bucket, measure, type);
+    }
+  }
+  return total;
+}
+
+/**
+ * @brief 读取某月某项指标最高的一个小时。
+ * @param rollup 目标汇总。
+ * @param month_key 月份（YYYYMM）。
+ * @param measure 指标。
+ * @param[out] hour_start 接收该小时的开始时刻，可以为 NULL。
+ * @param[out] value 接收该小时的累计值，可以为 NULL。
+ * @return 找到返回 0，否则返回 -1。
+ */
+int rollup_month_peak(const RevenueRollup *rollup, long month_key,
+                      RollupMeasure measure, time_t *hour_start, long *value) {
+  const RollupPeak *peak;
+
+  if (hour_start) {
+    *hour_start = 0;
+  }
+  if (value) {
+    *value = 0;
+  }
+  if (rollup == NULL || (unsigned int)measure >= ROLLUP_MEASURE_COUNT ||
+      rollup->peak_month != month_key) {
+    return -1;
+  }
+  peak = &rollup->peaks[measure];
+  if (peak->hour == 0) {
+    return -1;
+  }
+  if (hour_start) {
+    *hour_start = (time_t)peak->hour * 3600;
+  }
+  if (value) {
+    *value = peak->value;
+  }
+  return 0;
+}
@@ -0,0 +1,137 @@
+#ifndef PARKING_ROLLUP_H
+#define PARKING_ROLLUP_H
+
+#include <time.h>
+
+/**
+ * @file parking_rollup.h
+ * @brief 按小时、按日滚动汇总的收入与出入场计数。
+ * @details
+ * 当日与当月收入在周期切换时清零，昨天的数据随之丢失。滚动汇总为最近
+ * ROLLUP_HOURS 个小时与最近 ROLLUP_DAYS 天各保留一个环形桶，按停车类型
+ * 累计收入、入场次数与出场次数：每次记账只定位一个小时桶与一个日桶，
+ * 桶中是更早的周期时先清零再复用，因此更新是 O(1) 的，不分配内存。
+ *
+ * 同时维护当月每项指标最高的一个小时（只增不减的高水位），
+ * “最近 7 天收入”“本月高峰时段”这类查询只需读取固定数量的桶。
+ *
+ * 小时桶以 Unix 时间的整小时编号为键，时区偏移为整小时时与本地整点一致；
+ * 日桶以本地日期为键。汇总本身不加锁，由停车场的锁保护。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define ROLLUP_HOURS 168    /**< 保留的小时桶数（7 天） */
+#define ROLLUP_DAYS 92      /**< 保留的日桶数（约一个季度） */
+#define ROLLUP_TYPE_COUNT 2 /**< 停车类型数（居民、访客） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 滚动汇总的指标。
+ */
+typedef enum RollupMeasure {
+  ROLLUP_REVENUE = 0,      /**< 收入（分）。 */
+  ROLLUP_ENTRIES = 1,      /**< 入场次数。 */
+  ROLLUP_EXITS = 2,        /**< 出场次数。 */
+  ROLLUP_MEASURE_COUNT = 3 /**< 指标数。 */
+} RollupMeasure;
+
+/**
+ * @brief 一个小时或一天的汇总桶。
+ */
+typedef struct RollupBucket {
+  long key; /**< 小时编号或日期序号，0 表示空桶。 */
+  long totals[ROLLUP_MEASURE_COUNT][ROLLUP_TYPE_COUNT]; /**< 累计值。 */
+} RollupBucket;
+
+/**
+ * @brief 当月某项指标最高的一个小时。
+ */
+typedef struct RollupPeak {
+  long hour;  /**< 小时编号，0 表示本月尚无记录。 */
+  long value; /**< 该小时的累计值（各类型之和）。 */
+} RollupPeak;
+
+/**
+ * @brief 停车场的滚动汇总。
+ */
+typedef struct RevenueRollup {
+  RollupBucket hours[ROLLUP_HOURS]; /**< 以小时编号取模定位的小时桶。 */
+  RollupBucket days[ROLLUP_DAYS];   /**< 以日期序号取模定位的日桶。 */
+  long peak_month;                  /**< peaks 所属月份（YYYYMM）。 */
+  RollupPeak peaks[ROLLUP_MEASURE_COUNT]; /**< 当月各指标的高峰小时。 */
+} RevenueRollup;
+
+/**
+ *********************************************************************************
+ *                              滚动汇总API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 初始化（清空）滚动汇总。
+ * @param rollup 要初始化的汇总。
+ */
+void rollup_init(RevenueRollup *rollup);
+
+/**
+ * @brief 把一笔收入或一次出入场计入滚动汇总。
+ * @details 早于小时桶（日桶）保留窗口的记录不计入该粒度；amount 为负时
+ *          撤销先前计入的值，但不降低已记录的高峰。
+ * @param rollup 目标汇总。
+ * @param when 发生时刻。
+ * @param day_key when 所在的本地日期（YYYYMMDD）。
+ * @param month_key when 所在的本地月份（YYYYMM）。
+ * @param type 停车类型（ParkingType 的值）。
+ * @param measure 指标。
+ * @param amount 累加量。
+ */
+void rollup_add(RevenueRollup *rollup, time_t when, long day_key,
+                long month_key, int type, RollupMeasure measure, long amount);
+
+/**
+ * @brief 读取某一小时的累计值。
+ * @param rollup 目标汇总。
+ * @param when 该小时内的任一时刻。
+ * @param measure 指标。
+ * @param type 停车类型，-1 表示全部类型。
+ * @return 累计值；该小时已移出保留窗口或没有记录时返回 0。
+ */
+long rollup_hour_total(const RevenueRollup *rollup, time_t when,
+                       RollupMeasure measure, int type);
+
+/**
+ * @brief 读取截至某一天（含）的最近若干天的累计值。
+ * @details 只读取 days 个日桶，与记录数无关。
+ * @param rollup 目标汇总。
+ * @param day_key 最后一天的本地日期（YYYYMMDD）。
+ * @param days 天数，超过 ROLLUP_DAYS 时按 ROLLUP_DAYS 计。
+ * @param measure 指标。
+ * @param type 停车类型，-1 表示全部类型。
+ * @return 累计值。
+ */
+long rollup_recent_days(const RevenueRollup *rollup, long day_key, int days,
+                        RollupMeasure measure, int type);
+
+/**
+ * @brief 读取某月某项指标最高的一个小时。
+ * @param rollup 目标汇总。
+ * @param month_key 月份（YYYYMM）。
+ * @param measure 指标。
+ * @param[out] hour_start 接收该小时的开始时刻，可以为 NULL。
+ * @param[out] value 接收该小时的累计值，可以为 NULL。
+ * @return 找到返回 0；该月尚无记录（或不是最近记录的月份）返回 -1。
+ */
+int rollup_month_peak(const RevenueRollup *rollup, long month_key,
+                      RollupMeasure measure, time_t *hour_start, long *value);
+
+#endif /* PARKING_ROLLUP_H */
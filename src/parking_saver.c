@@ -0,0 +1,392 @@
+/**
+ * @file parking_saver.c
+ * @brief 后台保存线程实现文件
+ * @details
+ * 该文件实现了 parking_saver.h 中声明的写时复制保存与后台保存线程。
+ * 请求与自动保存配置由自旋锁保护，临界区内只复制定长字段，
+ * 提交请求的线程最多与保存线程争用几十条指令；保存本身在锁外进行。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parking_saver.h"
+#include "parking_thread.h"
+
+/**
+ * @brief 一个保存请求。
+ */
+typedef struct SaveRequest {
+  char filename[PARKING_SAVER_MAX_PATH]; /**< 目标文件名。 */
+  int binary;                            /**< 非 0 写二进制快照。 */
+  ParkingSaveDoneFn done;                /**< 完成通知函数，可以为 NULL。 */
+  void *ctx;                             /**< 通知函数的上下文指针。 */
+} SaveRequest;
+
+/**
+ * @brief 正在运行的后台保存线程。
+ */
+struct ParkingSaver {
+  ParkingLot *lot;        /**< 要保存的停车场。 */
+  ParkingThread *thread;  /**< 保存线程。 */
+  ParkingSignal *signal;  /**< 有新请求或需要停止时触发。 */
+  volatile int lock;      /**< 保护以下字段的自旋锁。 */
+  int stopping;           /**< 非 0 时保存线程处理完排队的请求后退出。 */
+  int has_pending;        /**< 非 0 表示 pending 中有排队的请求。 */
+  SaveRequest pending;    /**< 排队的请求。 */
+  char auto_path[PARKING_SAVER_MAX_PATH]; /**< 自动保存路径，空串表示关闭。 */
+  unsigned int interval_seconds;          /**< 自动保存的时间阈值（秒）。 */
+  unsigned long every_mutations;          /**< 自动保存的修改次数阈值。 */
+  time_t auto_saved_at;     /**< 上一次自动保存（或配置）的时刻。 */
+  long auto_saved_mutation; /**< 上一次自动保存（或配置）时的修改次数。 */
+  int compacting;           /**< 非 0 表示有待完成的车位内存池整理。 */
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 获取保存线程的自旋锁。
+ * @param saver 目标保存线程。
+ */
+static void saver_lock(ParkingSaver *saver) {
+  while (parking_atomic_exchange_int(&saver->lock, 1) != 0) {
+    while (parking_atomic_load_int(&saver->lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放保存线程的自旋锁。
+ * @param saver 目标保存线程。
+ */
+static void saver_unlock(ParkingSaver *saver) {
+  parking_atomic_store_int(&saver->lock, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 判断自动保存是否到期，到期时取出请求。
+ * @note 须在自旋锁内调用。
+ * @param saver 目标保存线程。
+ * @param[out] request 到期时接收自动保存请求。
+ * @return 到期返回 1，否则返回 0。
+ */
+static int auto_save_due(ParkingSaver *saver, SaveRequest *request) {
+  long mutations;
+  int due = 0;
+
+  if (saver->auto_path[0] == '\0') {
+    return 0;
+  }
+  mutations = parking_atomic_load_long(&saver->lot->mutation_count);
+  if (saver->every_mutations > 0 &&
+      (unsigned long)(mutations - saver->auto_saved_mutation) >=
+          saver->every_mutations) {
+    due = 1;
+  }
+  if (saver->interval_seconds > 0 &&
+      time(NULL) - saver->auto_saved_at >= (time_t)saver->interval_seconds &&
+      mutations != saver->auto_saved_mutation) {
+    /* 期间没有修改时文件已是最新，不必重写 */
+    due = 1;
+  }
+  if (!due) {
+    return 0;
+  }
+  strcpy(request->filename, saver->auto_path);
+  request->binary = 1;
+  request->done = NULL;
+  request->ctx = NULL;
+  saver->auto_saved_at = time(NULL);
+  saver->auto_saved_mutation = mutations;
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 保存线程的主循环。
+ * @details 优先处理排队的请求，其次检查自动保存，再其次执行一步车位内存池
+ *          整理，都没有时等待信号；启用自动保存时按 PARKING_SAVER_POLL_MS
+ *          定期醒来。
+ * @param arg 对应的 ParkingSaver 对象。
+ */
+static void saver_loop(void *arg) {
+  ParkingSaver *saver = (ParkingSaver *)arg;
+  SaveRequest request;
+  int have_request;
+  int compacting;
+  int polling;
+  int result;
+
+  for (;;) {
+    saver_lock(saver);
+    have_request = saver->has_pending;
+    if (have_request) {
+      request = saver->pending;
+      saver->has_pending = 0;
+    } else if (saver->stopping) {
+      saver_unlock(saver);
+      break;
+    } else {
+      have_request = auto_save_due(saver, &request);
+    }
+    compacting = !have_request && saver->compacting;
+    polling = saver->auto_path[0] != '\0';
+    saver_unlock(saver);
+
+    if (have_request) {
+      result = parking_saver_save(saver->lot, request.filename,
+                                  request.binary);
+      if (request.done != NULL) {
+        request.done(request.filename, result, request.ctx);
+      }
+      continue;
+    }
+    if (compacting) {
+      parking_lot_write_lock(saver->lot);
+      result =
+          compact_parking_slots(saver->lot, PARKING_SAVER_COMPACT_BUDGET);
+      parking_lot_write_unlock(saver->lot);
+      if (result == -2) {
+        /* 快照进行中，稍后再继续 */
+        parking_signal_wait(saver->signal, PARKING_SAVER_POLL_MS);
+      } else if (result <= 0) {
+        saver_lock(saver);
+        saver->compacting = 0;
+        saver_unlock(saver);
+      }
+      continue;
+    }
+    parking_signal_wait(saver->signal, polling ? PARKING_SAVER_POLL_MS : 0);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 复制一个有长度限制的路径。
+ * @param target 目标缓冲区（PARKING_SAVER_MAX_PATH 字节）。
+ * @param path 源路径。
+ * @return 成功返回 0，路径为空或过长返回 -1。
+ */
+static int copy_path(char *target, const char *path) {
+  size_t length = strlen(path);
+
+  if (length == 0 || length >= PARKING_SAVER_MAX_PATH) {
+    return -1;
+  }
+  memcpy(target, path, length + 1);
+  return 0;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 以写时复制快照保存停车场，保存期间不阻塞写者。
+ * @details
+ * 写锁内开始快照只复制车位表指针；之后每次持有读锁编码
+ * PARKING_SAVER_FILL_PAGES 页，页与页之间写者可以继续入场、出场，
+ * 它们修改车位前会先保全所在页；最后不持锁写文件，再在写锁内结束快照。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @param binary 非 0 写二进制快照（PARKING_SAVER_COMPRESSED 时各页压缩），
+ *        0 写文本文件。
+ * @return 成功返回 0，文件写入失败返回 -1，内存不足返回 -2。
+ */
+int parking_saver_save(ParkingLot *lot, const char *filename, int binary) {
+  ParkingSnapshot snapshot;
+  int data_result;
+  int pages_left;
+
+  if (lot == NULL || filename == NULL) {
+    return -1;
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = begin_parking_snapshot(lot, &snapshot);
+  parking_lot_write_unlock(lot);
+  if (data_result == -1) {
+    parking_lot_read_lock(lot);
+    if (binary == PARKING_SAVER_COMPRESSED) {
+      data_result = save_parking_snapshot_compressed(lot, filename);
+    } else {
+      data_result = binary ? save_parking_snapshot(lot, filename)
+                           : save_parking_data(lot, filename);
+    }
+    parking_lot_read_unlock(lot);
+    return data_result;
+  }
+  if (data_result != 0) {
+    return data_result;
+  }
+
+  do {
+    parking_lot_read_lock(lot);
+    pages_left =
+        fill_parking_snapshot(lot, &snapshot, PARKING_SAVER_FILL_PAGES);
+    parking_lot_read_unlock(lot);
+  } while (pages_left > 0);
+
+  if (binary == PARKING_SAVER_COMPRESSED) {
+    data_result = write_parking_snapshot_compressed(&snapshot, filename);
+  } else {
+    data_result = binary ? write_parking_snapshot(&snapshot, filename)
+                         : write_parking_snapshot_text(&snapshot, filename);
+  }
+
+  parking_lot_write_lock(lot);
+  end_parking_snapshot(lot, &snapshot);
+  parking_lot_write_unlock(lot);
+  return data_result;
+}
+
+/**
+ * @brief 为停车场启动后台保存线程。
+ * @param lot 要保存的停车场。
+ * @return 成功返回句柄，失败返回 NULL。
+ */
+ParkingSaver *parking_saver_start(ParkingLot *lot) {
+  ParkingSaver *saver;
+
+  if (lot == NULL) {
+    return NULL;
+  }
+  saver = (ParkingSaver *)calloc(1, sizeof(ParkingSaver));
+  if (saver == NULL) {
+    return NULL;
+  }
+  saver->lot = lot;
+  saver->signal = parking_signal_create();
+  if (saver->signal == NULL) {
+    free(saver);
+    return NULL;
+  }
+  saver->thread = parking_thread_start(saver_loop, saver);
+  if (saver->thread == NULL) {
+    parking_signal_destroy(saver->signal);
+    free(saver);
+    return NULL;
+  }
+  return saver;
+}
+
+/**
+ * @brief 提交一次后台保存。
+ * @param saver 保存线程句柄。
+ * @param filename 目标文件名。
+ * @param binary 非 0 写二进制快照，0 写文本文件。
+ * @param done 完成通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 已排队返回 0，参数无效返回 -1，已有请求在排队返回 -2。
+ */
+int parking_saver_submit(ParkingSaver *saver, const char *filename,
+                         int binary, ParkingSaveDoneFn done, void *ctx) {
+  SaveRequest request;
+  int result = 0;
+
+  if (saver == NULL || filename == NULL ||
+      copy_path(request.filename, filename) != 0) {
+    return -1;
+  }
+  request.binary = binary;
+  request.done = done;
+  request.ctx = ctx;
+
+  saver_lock(saver);
+  if (saver->stopping) {
+    result = -1;
+  } else if (saver->has_pending) {
+    result = -2;
+  } else {
+    saver->pending = request;
+    saver->has_pending = 1;
+  }
+  saver_unlock(saver);
+
+  if (result == 0) {
+    parking_signal_notify(saver->signal);
+  }
+  return result;
+}
+
+/**
+ * @brief 配置自动保存。
+ * @param saver 保存线程句柄。
+ * @param filename 目标文件名，NULL 表示关闭自动保存。
+ * @param interval_seconds 时间阈值（秒），0 表示不按时间触发。
+ * @param every_mutations 修改次数阈值，0 表示不按修改次数触发。
+ * @return 成功返回 0，参数无效返回 -1。
+ */
+int parking_saver_configure_auto(ParkingSaver *saver, const char *filename,
+                                 unsigned int interval_seconds,
+                                 unsigned long every_mutations) {
+  char path[PARKING_SAVER_MAX_PATH];
+
+  if (saver == NULL) {
+    return -1;
+  }
+  path[0] = '\0';
+  if (filename != NULL &&
+      (copy_path(path, filename) != 0 ||
+       (interval_seconds == 0 && every_mutations == 0))) {
+    return -1;
+  }
+
+  saver_lock(saver);
+  strcpy(saver->auto_path, path);
+  saver->interval_seconds = interval_seconds;
+  saver->every_mutations = every_mutations;
+  saver->auto_saved_at = time(NULL);
+  saver->auto_saved_mutation =
+      parking_atomic_load_long(&saver->lot->mutation_count);
+  saver_unlock(saver);
+
+  /* 唤醒保存线程，让它按新的配置决定是否轮询 */
+  parking_signal_notify(saver->signal);
+  return 0;
+}
+
+/**
+ * @brief 请求保存线程在后台整理车位内存池。
+ * @param saver 保存线程句柄。
+ * @return 已请求返回 0，参数无效或正在停止返回 -1。
+ */
+int parking_saver_compact(ParkingSaver *saver) {
+  int result = 0;
+
+  if (saver == NULL) {
+    return -1;
+  }
+  saver_lock(saver);
+  if (saver->stopping) {
+    result = -1;
+  } else {
+    saver->compacting = 1;
+  }
+  saver_unlock(saver);
+
+  if (result == 0) {
+    parking_signal_notify(saver->signal);
+  }
+  return result;
+}
+
+/**
+ * @brief 停止后台保存线程并释放句柄。
+ * @param saver 保存线程句柄，可以为 NULL。
+ */
+void parking_saver_stop(ParkingSaver *saver) {
+  if (saver == NULL) {
+    return;
+  }
+  saver_lock(saver);
+  saver->stopping = 1;
+  saver->auto_path[0] = '\0';
+  saver_unlock(saver);
+
+  parking_signal_notify(saver->signal);
+  parking_thread_join(saver->thread);
+  parking_signal_destroy(saver->signal);
+  free(saver);
+}
@@ -0,0 +1,127 @@
+#ifndef PARKING_SAVER_H
+#define PARKING_SAVER_H
+
+#include "parking_data.h"
+
+/**
+ * @file parking_saver.h
+ * @brief 后台保存线程的接口声明。
+ * @details
+ * 保存线程以写时复制快照（见 begin_parking_snapshot）写出停车场：
+ * 写锁内只复制车位表指针，随后分批持有读锁编码记录，写文件时不持锁。
+ * 调用线程提交请求后立即返回，入场、出场等操作不会等待磁盘。
+ *
+ * 请求采用双缓冲：保存线程处理一个请求的同时，还可以再排队一个请求；
+ * 两个位置都被占用时新的请求被拒绝，由调用者决定稍后重试。
+ * 此外可以配置自动保存：距上次保存达到指定秒数，或车位修改次数
+ * （ParkingLot.mutation_count）达到指定值时，由保存线程自行发起。
+ * 修改次数在保存线程中定期轮询，不在入场、出场路径上做任何通知。
+ *
+ * 保存线程空闲时还可以分步整理车位内存池（见 compact_parking_slots）：
+ * 每步持有写锁只检查 PARKING_SAVER_COMPACT_BUDGET 个节点，
+ * 步与步之间释放写锁，排队的保存请求优先处理。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_SAVER_MAX_PATH 260  /**< 保存路径的最大长度 */
+#define PARKING_SAVER_POLL_MS 200   /**< 启用自动保存时的轮询间隔（毫秒） */
+#define PARKING_SAVER_FILL_PAGES 16 /**< 每次持有读锁编码的快照页数 */
+#define PARKING_SAVER_COMPRESSED 2  /**< binary 取该值时写各页压缩的快照 */
+#define PARKING_SAVER_COMPACT_BUDGET 256 /**< 后台整理每步检查的节点数 */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一次后台保存完成后的通知函数。
+ * @details 在保存线程中调用，不持有停车场的锁。
+ * @param filename 保存的文件名。
+ * @param result 保存结果：0 成功，-1 文件写入失败，-2 内存不足。
+ * @param ctx 提交请求时传入的上下文指针。
+ */
+typedef void (*ParkingSaveDoneFn)(const char *filename, int result,
+                                  void *ctx);
+
+/**
+ * @brief 不透明的后台保存线程句柄。
+ */
+typedef struct ParkingSaver ParkingSaver;
+
+/**
+ *********************************************************************************
+ *                            后台保存API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 以写时复制快照保存停车场，保存期间不阻塞写者。
+ * @details 函数自行加锁，调用者不得持有停车场的锁。已有其他快照
+ *          进行中时，退回到整个保存期间持有读锁的做法。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @param binary 非 0 写二进制快照（PARKING_SAVER_COMPRESSED 时各页压缩），
+ *        0 写 `LOT|` 文本文件。
+ * @return 成功返回 0，文件写入失败返回 -1，内存不足返回 -2。
+ */
+int parking_saver_save(ParkingLot *lot, const char *filename, int binary);
+
+/**
+ * @brief 为停车场启动后台保存线程。
+ * @param lot 要保存的停车场，须比保存线程存活得久。
+ * @return 成功返回句柄，内存不足或无法创建线程时返回 NULL。
+ */
+ParkingSaver *parking_saver_start(ParkingLot *lot);
+
+/**
+ * @brief 提交一次后台保存。
+ * @param saver 保存线程句柄。
+ * @param filename 目标文件名，函数返回前即复制。
+ * @param binary 取值同 parking_saver_save。
+ * @param done 完成通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 已排队返回 0；参数无效、路径过长或正在停止返回 -1；
+ *         已有请求在排队返回 -2。
+ */
+int parking_saver_submit(ParkingSaver *saver, const char *filename,
+                         int binary, ParkingSaveDoneFn done, void *ctx);
+
+/**
+ * @brief 配置自动保存。
+ * @details 自动保存总是写二进制快照，两个阈值满足其一即保存。
+ * @param saver 保存线程句柄。
+ * @param filename 目标文件名，NULL 表示关闭自动保存。
+ * @param interval_seconds 距上次保存的最长秒数，0 表示不按时间触发。
+ * @param every_mutations 距上次保存的最多修改次数，0 表示不按修改次数触发。
+ * @return 成功返回 0；参数无效或路径过长返回 -1。
+ */
+int parking_saver_configure_auto(ParkingSaver *saver, const char *filename,
+                                 unsigned int interval_seconds,
+                                 unsigned long every_mutations);
+
+/**
+ * @brief 请求保存线程在后台整理车位内存池。
+ * @details 保存线程反复执行 compact_parking_slots 直到整理完毕；遇到快照
+ *          进行中时按 PARKING_SAVER_POLL_MS 稍后重试，内存不足时放弃本次整理。
+ *          整理进行中再次请求不会重复排队。
+ * @param saver 保存线程句柄。
+ * @return 已请求返回 0；参数无效或正在停止返回 -1。
+ */
+int parking_saver_compact(ParkingSaver *saver);
+
+/**
+ * @brief 停止后台保存线程并释放句柄。
+ * @details 已排队的请求会先保存完，自动保存不再触发。
+ *          调用者不得持有停车场的锁。
+ * @param saver 保存线程句柄，可以为 NULL。
+ */
+void parking_saver_stop(ParkingSaver *saver);
+
+#endif /* PARKING_SAVER_H */
@@ -7,13 +7,18 @@
  * 如参数验证、费用计算、状态转换等，为上层提供统一、简洁的接口。
  */
 
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "parking_aggregate.h"
+#include "parking_durable_file.h"
+#include "parking_layout.h"
+#include "parking_saver.h"
 #include "parking_service.h"
+#include "parking_thread.h"
+#include "parking_trace.h"
 
 #ifdef _WIN32
 #include <locale.h>
@@ -24,11 +29,33 @@
 /*                                 内部常量定义                               */
 /* ========================================================================== */
 
-#define MAX_SLOT_ID 99999 /**< 允许的最大车位ID */
-#define MIN_LICENSE_LEN 5 /**< 车牌号最小长度 */
-#define MIN_CONTACT_LEN 8 /**< 联系方式最小长度 */
-#define SECONDS_PER_MONTH                                                      \
-  (30 * 24 * 3600) /**< 用于计算月费的秒数（按30天计） */
+#define JOURNAL_FAILED_MESSAGE                                                 \
+  "操作已生效，但写入日志失败" /**< 日志写入失败时的提示 */
+#define LEDGER_FAILED_MESSAGE                                                  \
+  "操作已生效，但写入收费台账失败" /**< 收费台账写入失败时的提示 */
+#define HISTORY_FAILED_MESSAGE                                                 \
+  "操作已生效，但写入停车记录失败" /**< 停车记录写入失败时的提示 */
+
+#if PARKING_SERVICE_METRICS || PARKING_TRACE
+#define SERVICE_METRICS_START() metrics_now_ns() /**< 记录调用开始时刻 */
+#define SERVICE_METRICS_FINISH(metric, code, started)                          \
+  service_call_finish((metric), (code), (started)) /**< 记录一次调用 */
+#else
+#define SERVICE_METRICS_START() 0UL /**< 关闭采集时不读时钟 */
+#define SERVICE_METRICS_FINISH(metric, code, started)                          \
+  ((void)(started)) /**< 关闭采集时不记录 */
+#endif
+
+/**
+ * @brief 批量处理时的排序键：车位编号与事件的原始下标。
+ */
+typedef struct {
+  int slot_id; /**< 事件的车位编号。 */
+  int index;   /**< 事件在输入数组中的下标。 */
+} BatchOrder;
+
+/** 已交给调用者、尚未经 parking_service_free_result 释放的结果数据块数。 */
+static volatile long outstanding_payloads = 0;
 
 /* ========================================================================== */
 /*                                内部辅助函数声明 */
@@ -38,9 +65,49 @@ static ServiceResult create_service_result(ParkingServiceResultCode code,
                                            const char *message, void *data);
 static int validate_slot_id(int slot_id);
 static int validate_license_plate(const char *license);
-static int validate_contact(const char *contact);
+static int check_gate_event(const GateEvent *event, ValidationIssue *issue);
 static const char *get_error_message(ParkingServiceResultCode code);
-static void update_revenue_cycle(ParkingLot *lot);
+static void record_revenue(ParkingLot *lot, ParkingType type, long cents,
+                           time_t now);
+static void tally_invoice(const ResidentInvoice *invoice, void *ctx);
+static void tally_visitor_checkout(const VisitorCheckout *checkout, void *ctx);
+static void read_revenue(const ParkingLot *lot, time_t now, long *today_cents,
+                         long *month_cents);
+static ServiceResult map_allocate_result(ParkingLot *lot, int data_result,
+                                         void *data);
+static ServiceResult note_journal_pending(ParkingLot *lot,
+                                          ServiceResult result);
+static ServiceResult release_slot_and_charge(ParkingLot *lot, int slot_id,
+                                             ExitReceipt *receipt);
+static ParkingServiceResultCode allocate_code(int data_result);
+static void charge_exit(ParkingLot *lot, ParkingSlot *slot, time_t now,
+                        ExitReceipt *receipt);
+static ServiceResult finish_config_publish(ParkingLot *lot, int data_result);
+static ServiceResult finish_plate_list_publish(ParkingLot *lot,
+                                               PlateListKind kind,
+                                               PlateList *list);
+static ServiceResult map_save_result(int data_result, const char *message);
+static ParkingSaver *ensure_saver(ParkingLot *lot);
+static void finish_async_save(const char *filename, int data_result,
+                              void *ctx);
+static int compare_batch_order(const void *a, const void *b);
+static ParkingServiceResultCode release_slot_code(ParkingLot *lot, int slot_id,
+                                                  time_t now,
+                                                  ExitReceipt *receipt);
+static void fill_statistics(const ParkingLot *lot, ParkingStatistics *stats);
+static const char *exit_write_failure(const ParkingLot *lot);
+static void *alloc_result_payload(size_t size);
+static ParkingSlot **alloc_slot_array(int capacity);
+static ParkingSlot **collect_result_slots(ParkingLot *lot, SlotFilter filter,
+                                          int *count, int *out_of_memory);
+static ServiceResult make_page_result(ParkingSlot **slots, int count);
+static int valid_page_request(const ParkingLot *lot, SlotFilter filter,
+                              int limit);
+#if PARKING_SERVICE_METRICS || PARKING_TRACE
+static void service_call_finish(ServiceMetric metric,
+                                ParkingServiceResultCode code,
+                                unsigned long started);
+#endif
 
 /* ========================================================================== */
 /*                                内部辅助函数实现 */
@@ -56,62 +123,97 @@ static void update_revenue_cycle(ParkingLot *lot);
 static ServiceResult create_service_result(ParkingServiceResultCode code,
                                            const char *message, void *data) {
   ServiceResult result;
+  size_t length;
+
   result.code = code;
   result.data = data;
 
-  if (message) {
-    strncpy(result.message, message, sizeof(result.message) - 1);
-    result.message[sizeof(result.message) - 1] = '\0';
-  } else {
-    strncpy(result.message, get_error_message(code),
-            sizeof(result.message) - 1);
-    result.message[sizeof(result.message) - 1] = '\0';
+  /* 只复制消息本身，不像 strncpy 那样把缓冲区剩余部分逐字节填零 */
+  if (!message) {
+    message = get_error_message(code);
+  }
+  length = strlen(message);
+  if (length > sizeof(result.message) - 1) {
+    length = sizeof(result.message) - 1;
   }
+  memcpy(result.message, message, length);
+  result.message[length] = '\0';
 
   return result;
 }
 
+/**
+ * @brief (静态辅助函数) 为交给调用者的结果数据分配内存并计数。
+ * @details 数据块取自结果池，由 parking_service_free_result 回收并递减计数；
+ *          调用者直接 free() 的数据块会一直计为未释放。
+ * @param size 字节数。
+ * @return 成功返回内存块，失败返回 NULL。
+ */
+static void *alloc_result_payload(size_t size) {
+  void *payload = pool_alloc(size);
+
+  if (payload) {
+    parking_atomic_add_long(&outstanding_payloads, 1);
+  }
+  return payload;
+}
+
+/**
+ * @brief (静态辅助函数) 从结果池分配车位指针数组。
+ * @param capacity 数组元素个数，必须大于 0。
+ * @return 成功返回数组，失败返回 NULL。
+ */
+static ParkingSlot **alloc_slot_array(int capacity) {
+  return (ParkingSlot **)pool_alloc((size_t)capacity * sizeof(ParkingSlot *));
+}
+
+/**
+ * @brief (静态辅助函数) 把满足筛选条件的车位收集到结果池分配的数组中。
+ * @details 与数据层的 get_free_slots 等函数相同，先按计数器确定大小再用
+ *          get_slots_page 填充，但数组取自结果池，可由
+ *          parking_service_free_result 回收。
+ *          调用者需持有停车场的读锁。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param[out] count 接收车位数量。
+ * @param[out] out_of_memory 分配失败时置 1，否则置 0。
+ * @return 指针数组；没有匹配车位或分配失败时返回 NULL。
+ */
+static ParkingSlot **collect_result_slots(ParkingLot *lot, SlotFilter filter,
+                                          int *count, int *out_of_memory) {
+  ParkingSlot **slots;
+  int expected = count_slots(lot, filter);
+
+  *count = 0;
+  *out_of_memory = 0;
+  if (expected <= 0) {
+    return NULL;
+  }
+  slots = alloc_slot_array(expected);
+  if (slots == NULL) {
+    *out_of_memory = 1;
+    return NULL;
+  }
+  *count = get_slots_page(lot, filter, 0, slots, expected);
+  return slots;
+}
+
 /**
  * @brief 验证车位ID是否在有效范围内。
  * @param slot_id 要验证的车位ID。
  * @return 如果有效返回1，否则返回0。
  */
 static int validate_slot_id(int slot_id) {
-  return (slot_id > 0 && slot_id <= MAX_SLOT_ID);
+  return validate_slot_id_value(slot_id) == VALIDATION_OK;
 }
 
 /**
- * @brief 验证车牌号格式是否基本合规。
- * @details 简单检查长度，并确认包含中文字符和字母/数字。
+ * @brief 验证车牌号的长度与字符是否合规。
  * @param license 要验证的车牌号字符串。
  * @return 如果有效返回1，否则返回0。
  */
 static int validate_license_plate(const char *license) {
-  if (!license || strlen(license) < MIN_LICENSE_LEN ||
-      strlen(license) >= MAX_LICENSE_LEN) {
-    return 0;
-  }
-  /* TODO: 更完备的验证 */
-  return 1;
-}
-
-/**
- * @brief 验证联系方式是否为纯数字且长度合规。
- * @param contact 要验证的联系方式字符串。
- * @return 如果有效返回1，否则返回0。
- */
-static int validate_contact(const char *contact) {
-  size_t i;
-  if (!contact || strlen(contact) < MIN_CONTACT_LEN ||
-      strlen(contact) >= MAX_CONTACT_LEN) {
-    return 0;
-  }
-  for (i = 0; i < strlen(contact); i++) {
-    if (contact[i] < '0' || contact[i] > '9') {
-      return 0;
-    }
-  }
-  return 1;
+  return validate_plate_text(license) == VALIDATION_OK;
 }
 
 /**
@@ -143,449 +245,5031 @@ static const char *get_error_message(ParkingServiceResultCode code) {
     return "文件读写操作错误";
   case PARKING_SERVICE_SYSTEM_ERROR:
     return "其他系统级错误";
+  case PARKING_SERVICE_PLATE_BLOCKED:
+    return "车牌在禁止入场名单中";
+  case PARKING_SERVICE_BUSY:
+    return "服务繁忙，请稍后重试";
   default:
     return "未知错误";
   }
 }
 
 /**
- * @brief 检查并根据需要更新停车场的收入统计周期。
- * @details 如果当前时间进入了新的月份或新的一天，则重置相应的收入计数器。
- * @param lot 目标停车场。
+ * @brief 把一笔费用计入当日与当月收入及滚动汇总。
+ * @details 由出场路径在写锁内调用，因此写者之间无需再同步。
+ *          先由 update_revenue_cycle 切换到 now 所在的周期，再累加金额；
+ *          日切定时器通常已在 0 点完成切换。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param type 付费车辆的停车类型。
+ * @param cents 费用（分）。
+ * @param now 当前时间。
  */
-static void update_revenue_cycle(ParkingLot *lot) {
-  if (lot == NULL) {
-    return;
-  }
+static void record_revenue(ParkingLot *lot, ParkingType type, long cents,
+                           time_t now) {
+  update_revenue_cycle(lot, now);
+  parking_atomic_add_long(&lot->today_revenue_cents, cents);
+  parking_atomic_add_long(&lot->month_revenue_cents, cents);
+  record_revenue_rollup(lot, type, now, cents);
+  sync_parking_aggregate(lot);
+}
 
-  time_t now = time(NULL);
-  if (lot->last_update_time == 0) {
-    lot->last_update_time = now;
-    return;
-  }
+/**
+ * @brief 月费结算的回调：把账单累加到结算汇总。
+ * @param invoice 刚开出的账单。
+ * @param ctx 指向 ResidentBillingSummary 的指针。
+ */
+static void tally_invoice(const ResidentInvoice *invoice, void *ctx) {
+  ResidentBillingSummary *summary = (ResidentBillingSummary *)ctx;
 
-  struct tm *tm_now = localtime(&now);
-  struct tm *tm_last = localtime(&lot->last_update_time);
+  summary->invoices++;
+  summary->periods += invoice->periods;
+  summary->amount_cents += invoice->amount_cents;
+}
 
-  if (tm_now->tm_year > tm_last->tm_year || tm_now->tm_mon > tm_last->tm_mon) {
-    lot->month_revenue = 0.0;
-    lot->today_revenue = 0.0;
-  } else if (tm_now->tm_mday > tm_last->tm_mday) {
-    lot->today_revenue = 0.0;
-  }
+/**
+ * @brief 访客清场的回调：把出场结算累加到清场汇总。
+ * @param checkout 刚完成的出场结算。
+ * @param ctx 指向 VisitorSweepSummary 的指针。
+ */
+static void tally_visitor_checkout(const VisitorCheckout *checkout,
+                                   void *ctx) {
+  VisitorSweepSummary *summary = (VisitorSweepSummary *)ctx;
 
-  lot->last_update_time = now;
+  summary->released++;
+  summary->billed_hours += checkout->billed_hours;
+  summary->amount_cents += checkout->amount_cents;
 }
 
-/* ========================================================================== */
-/*                            核心业务服务函数实现                            */
-/* ========================================================================== */
-
 /**
- * @brief 添加一个新的停车位。
- * @details 验证参数后，创建一个新的停车位并将其添加到停车场。
+ * @brief 不加锁地读取当前周期的收入。
+ * @details 记录的日期（月份）不是当前日期（月份）时，说明本周期尚无收入，返回 0。
  * @param lot 目标停车场。
- * @param slot_id 新车位的ID。
- * @param location 新车位的位置描述。
- * @return 返回一个 ServiceResult 结构，包含操作结果。
+ * @param now 当前时间。
+ * @param[out] today_cents 当日收入（分）。
+ * @param[out] month_cents 当月收入（分）。
  */
-ServiceResult parking_service_add_slot(ParkingLot *lot, int slot_id,
-                                       const char *location) {
-  ParkingSlot *slot;
+static void read_revenue(const ParkingLot *lot, time_t now, long *today_cents,
+                         long *month_cents) {
+  long day;
+  long month;
 
-  if (!lot || !location || !validate_slot_id(slot_id) ||
-      strlen(location) == 0) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
-  }
+  /* 不加锁读取，不能修改停车场的日历缓存 */
+  parking_calendar_convert(now, &day, &month);
+  *today_cents = parking_atomic_load_long(&lot->revenue_day) == day
+                     ? parking_atomic_load_long(&lot->today_revenue_cents)
+                     : 0;
+  *month_cents = parking_atomic_load_long(&lot->revenue_month) == month
+                     ? parking_atomic_load_long(&lot->month_revenue_cents)
+                     : 0;
+}
 
-  if (find_slot_by_id(lot, slot_id) != NULL) {
-    return create_service_result(PARKING_SERVICE_SLOT_EXISTS, NULL, NULL);
-  }
+/**
+ * @brief 将数据层 allocate_slot 的返回码转换为 ServiceResult。
+ * @details 分配已生效但预写日志写入失败时报告文件错误。
+ * @param lot 执行分配的停车场。
+ * @param data_result allocate_slot 的返回码。
+ * @param data 成功时放入结果的数据指针。
+ * @return 对应的 ServiceResult 结构体。
+ */
+static ServiceResult map_allocate_result(ParkingLot *lot, int data_result,
+                                         void *data) {
+  ParkingServiceResultCode code = allocate_code(data_result);
 
-  slot = create_parking_slot(slot_id, location);
-  if (!slot) {
-    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  if (data_result == -7) {
+    return create_service_result(code, "车位已被预约", NULL);
   }
-
-  if (add_parking_slot(lot, slot) != 0) {
-    free_parking_slot(slot);
-    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
-                                 "添加车位到链表失败", NULL);
+  if (data_result == -9) {
+    return create_service_result(code, "车位为其他车辆专用", NULL);
   }
-
-  return create_service_result(PARKING_SERVICE_SUCCESS, "车位添加成功", NULL);
+  if (code != PARKING_SERVICE_SUCCESS) {
+    return create_service_result(
+        code, code == PARKING_SERVICE_SYSTEM_ERROR ? "未知的数据层错误" : NULL,
+        NULL);
+  }
+  if (parking_journal_failed(lot)) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 JOURNAL_FAILED_MESSAGE, NULL);
+  }
+  return note_journal_pending(
+      lot, create_service_result(PARKING_SERVICE_SUCCESS, "车位分配成功", data));
 }
 
 /**
- * @brief 为指定车位分配车辆（车辆入场）。
- * @details 验证参数后，调用数据层函数为车位分配车辆信息。
- *          处理并返回数据层可能出现的各种错误。
- * @param lot 目标停车场。
- * @param slot_id 要分配的车位ID。
- * @param owner_name 车主姓名。
- * @param license_plate 车牌号。
- * @param contact 联系方式。
- * @param type 停车类型 (居民/访客)。
- * @return 返回一个 ServiceResult 结构，包含操作结果。
+ * @brief 将数据层 allocate_slot 的返回码转换为服务层状态码。
+ * @param data_result allocate_slot 的返回码。
+ * @return 对应的状态码。
  */
-ServiceResult parking_service_allocate_slot(ParkingLot *lot, int slot_id,
-                                            const char *owner_name,
-                                            const char *license_plate,
-                                            const char *contact,
-                                            ParkingType type) {
-  int data_result;
-
-  if (!lot || !owner_name || !license_plate || !contact ||
-      !validate_slot_id(slot_id) || !validate_license_plate(license_plate) ||
-      !validate_contact(contact)) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
-  }
-
-  data_result =
-      allocate_slot(lot, slot_id, owner_name, license_plate, contact, type);
-
+static ParkingServiceResultCode allocate_code(int data_result) {
   switch (data_result) {
   case 0:
-    return create_service_result(PARKING_SERVICE_SUCCESS, "车位分配成功", NULL);
+    return PARKING_SERVICE_SUCCESS;
   case -2:
-    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+    return PARKING_SERVICE_SLOT_NOT_FOUND;
   case -3:
-    return create_service_result(PARKING_SERVICE_SLOT_OCCUPIED, NULL, NULL);
+    return PARKING_SERVICE_SLOT_OCCUPIED;
   case -4:
-    return create_service_result(PARKING_SERVICE_LICENSE_EXISTS, NULL, NULL);
+    return PARKING_SERVICE_LICENSE_EXISTS;
   case -5:
-    return create_service_result(PARKING_SERVICE_TIME_INVALID, NULL, NULL);
+    return PARKING_SERVICE_TIME_INVALID;
+  case -6:
+    return PARKING_SERVICE_MEMORY_ERROR;
+  case -7:
+    return PARKING_SERVICE_SLOT_OCCUPIED;
+  case -8:
+    return PARKING_SERVICE_PLATE_BLOCKED;
+  case -9:
+    return PARKING_SERVICE_SLOT_OCCUPIED;
   default:
-    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
-                                 "未知的数据层错误", NULL);
+    return PARKING_SERVICE_SYSTEM_ERROR;
   }
 }
 
 /**
- * @brief 释放一个停车位（车辆出场），并计算费用。
- * @details 验证车位存在且被占用。根据停车类型（居民/访客）计算停车费用，
- *          更新收入统计，然后调用数据层函数释放车位。
- * @param lot 目标停车场。
- * @param slot_id 要释放的车位ID。
- * @return 返回一个 ServiceResult 结构。成功时，如果产生费用，
- *         其 data 字段会指向一个包含费用值的 double 类型指针。
+ * @brief 按费率表求一次出场的计费明细，不修改任何状态。
+ * @details 出场计费与出场报价共用。居民月费已逾期时 receipt 中的
+ *          resident_due_date 是补缴后的新到期时间。
+ * @param fees 费率表。
+ * @param calendar 求入场小时用的日历缓存，由调用者独占。
+ * @param slot 已占用的车位。
+ * @param now 出场时间。
+ * @param[out] receipt 接收计费明细。
  */
-ServiceResult parking_service_deallocate_slot(ParkingLot *lot, int slot_id) {
-  ParkingSlot *slot;
-  double fee = 0.0;
-  double *fee_data;
-  time_t now = time(NULL);
-
-  if (!lot || !validate_slot_id(slot_id)) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
-  }
-
-  slot = find_slot_by_id(lot, slot_id);
-  if (!slot) {
-    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
-  }
-  if (slot->status == FREE_STATUS) {
-    return create_service_result(PARKING_SERVICE_SLOT_FREE, NULL, NULL);
+static void price_exit(const ParkingTariff *fees, ParkingCalendar *calendar,
+                       const ParkingSlot *slot, time_t now,
+                       ExitReceipt *receipt) {
+  memset(receipt, 0, sizeof(*receipt));
+  receipt->slot_id = slot->slot_id;
+  receipt->type = slot->type;
+  receipt->entry_time = slot->entry_time;
+  receipt->exit_time = now;
+  if (now > slot->entry_time) {
+    receipt->duration_seconds = (long)(now - slot->entry_time);
   }
 
   if (slot->type == RESIDENT_TYPE) {
+    receipt->resident_due_date = slot->resident_due_date;
     if (slot->resident_due_date > 0 && now > slot->resident_due_date) {
-      int overdue_months =
-          (int)ceil(difftime(now, slot->resident_due_date) / SECONDS_PER_MONTH);
-      fee = overdue_months * RESIDENT_MONTHLY_FEE;
-      slot->resident_due_date += (time_t)overdue_months * SECONDS_PER_MONTH;
+      receipt->amount_cents = tariff_resident_charge(
+          fees, slot->resident_due_date, now, &receipt->overdue_months,
+          &receipt->resident_due_date);
     }
   } else {
-    fee = calculate_visitor_fee(slot->entry_time, now);
+    receipt->amount_cents = tariff_visitor_fee(
+        fees, parking_calendar_hour(calendar, slot->entry_time),
+        receipt->duration_seconds, &receipt->billed_hours);
   }
+  receipt->amount = receipt->amount_cents / 100.0;
+}
 
-  if (fee > 0.0) {
-    update_revenue_cycle(lot);
-    lot->today_revenue += fee;
-    lot->month_revenue += fee;
-  }
+/**
+ * @brief 计算出场费用，顺延居民月费到期时间并计入收入。
+ * @details 按当前运行时配置的费率表计费。启用收费台账与停车记录存储时同时追加收费记录和停车记录，
+ *          写入失败由 exit_write_failure 报告。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param slot 将要出场的已占用车位。
+ * @param now 出场时间。
+ * @param[out] receipt 接收本次出场的计费明细。
+ */
+static void charge_exit(ParkingLot *lot, ParkingSlot *slot, time_t now,
+                        ExitReceipt *receipt) {
+  /* 整个计费过程只读取一次配置，并发发布新配置也不会前后不一致 */
+  const ParkingTariff *fees = &parking_lot_config(lot)->fees;
 
-  int data_result = deallocate_slot(lot, slot_id);
-  if (data_result != 0) {
-    // 假设数据层返回非0值表示错误，将其映射到服务层错误码
-    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
-                                 "数据层释放车位失败", NULL);
+  price_exit(fees, &lot->calendar, slot, now, receipt);
+  if (receipt->resident_due_date != slot->resident_due_date) {
+    preserve_slot_snapshot(lot, slot);
+    slot->resident_due_date = receipt->resident_due_date;
+    sync_slot_hot_fields(lot, slot);
   }
 
-  if (fee > 0) {
-    double *fee_ptr = (double *)malloc(sizeof(double));
-    if (!fee_ptr) {
-      return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
-    }
-    *fee_ptr = fee;
-    return create_service_result(PARKING_SERVICE_SUCCESS,
-                                 "车辆出场成功，请缴费", fee_ptr);
+  if (receipt->amount_cents > 0) {
+    record_revenue(lot, slot->type, receipt->amount_cents, now);
+    record_parking_payment(lot, slot->slot_id, slot->type, now,
+                           receipt->amount_cents);
   }
-  return create_service_result(PARKING_SERVICE_SUCCESS,
-                               "车辆出场成功，无费用产生", NULL);
+  record_parking_session(lot, slot, now, receipt->amount_cents);
 }
 
 /**
- * @brief 根据车位ID查找停车位。
- * @param lot 目标停车场。
- * @param slot_id 要查找的车位ID。
- * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向找到的
- * ParkingSlot 对象。
+ * @brief 校验单个出入场事件的参数。
+ * @param event 要校验的事件。
+ * @param[out] issue 接收第一个失败的字段与原因，可以为 NULL。
+ * @return 参数有效返回 1，否则返回 0。
  */
-ServiceResult parking_service_find_slot_by_id(ParkingLot *lot, int slot_id) {
-  ParkingSlot *slot;
-  if (!lot || !validate_slot_id(slot_id)) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+static int check_gate_event(const GateEvent *event, ValidationIssue *issue) {
+  ValidationIssue local;
+
+  if (issue == NULL) {
+    issue = &local;
   }
-  slot = find_slot_by_id(lot, slot_id);
-  if (!slot) {
-    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  issue->field = VALIDATION_FIELD_NONE;
+  issue->reason = validate_slot_id_value(event->slot_id);
+  if (issue->reason != VALIDATION_OK) {
+    issue->field = VALIDATION_FIELD_SLOT_ID;
+    return 0;
   }
-  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", slot);
+  if (event->kind == GATE_EVENT_EXIT) {
+    return 1;
+  }
+  if (event->kind != GATE_EVENT_ENTRY) {
+    issue->field = VALIDATION_FIELD_KIND;
+    issue->reason = VALIDATION_OUT_OF_RANGE;
+    return 0;
+  }
+  return validate_entry_fields(event->owner_name, event->license_plate,
+                               event->contact, issue);
 }
 
 /**
- * @brief 根据车牌号查找停车位。
- * @param lot 目标停车场。
- * @param license_plate 要查找的车牌号。
- * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向找到的
- * ParkingSlot 对象。
+ * @brief qsort 比较函数：按车位编号排序，编号相同时按原始下标排序。
+ * @param a 指向第一个 BatchOrder 的指针。
+ * @param b 指向第二个 BatchOrder 的指针。
+ * @return 比较结果。
  */
-ServiceResult parking_service_find_slot_by_license(ParkingLot *lot,
-                                                   const char *license_plate) {
-  ParkingSlot *slot;
-  if (!lot || !validate_license_plate(license_plate)) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
-  }
-  slot = find_slot_by_license(lot, license_plate);
-  if (!slot) {
-    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+static int compare_batch_order(const void *a, const void *b) {
+  const BatchOrder *left = (const BatchOrder *)a;
+  const BatchOrder *right = (const BatchOrder *)b;
+
+  if (left->slot_id != right->slot_id) {
+    return left->slot_id < right->slot_id ? -1 : 1;
   }
-  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", slot);
+  return left->index < right->index ? -1 : (left->index > right->index);
 }
 
 /**
- * @brief 根据车主姓名查找停车位。
- * @param lot 目标停车场。
- * @param owner_name 要查找的车主姓名。
- * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向找到的
- * ParkingSlot 对象。
+ * @brief 在成功结果的消息后注明尚未落盘的日志序号。
+ * @details 批量提交时，操作返回与记录落盘之间存在时间差；调用者可凭该序号
+ *          对照 configure 时注册的落盘通知。逐条同步时消息保持不变。
+ * @param lot 执行操作的停车场。
+ * @param result 已生成的成功结果。
+ * @return 补充消息后的结果。
  */
-ServiceResult parking_service_find_slot_by_owner(ParkingLot *lot,
-                                                 const char *owner_name) {
-  ParkingSlot *slot;
-  if (!lot || !owner_name || strlen(owner_name) == 0) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
-  }
-  slot = find_slot_by_owner(lot, owner_name);
-  if (!slot) {
-    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+static ServiceResult note_journal_pending(ParkingLot *lot,
+                                          ServiceResult result) {
+  unsigned long appended;
+  unsigned long durable;
+  size_t length = strlen(result.message);
+
+  if (parking_journal_progress(lot, &appended, &durable) != 0 ||
+      appended == durable || length + 64 > sizeof(result.message)) {
+    return result;
   }
-  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", slot);
+  sprintf(result.message + length, "（日志序号 %lu 待落盘）", appended);
+  return result;
 }
 
 /**
- * @brief 获取所有空闲车位的列表。
- * @param lot 目标停车场。
- * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
- * SlotQueryResult 对象， 其中包含了空闲车位的列表和数量。
+ * @brief 在已持有写锁的前提下释放车位并计费，只返回状态码。
+ * @details 验证车位存在且被占用，按停车类型计费、更新收入统计，
+ *          再调用数据层函数释放车位。不检查日志状态，由调用者处理。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param slot_id 要释放的车位ID。
+ * @param now 出场时间。
+ * @param[out] receipt 接收本次出场的计费明细，失败时清零。
+ * @return 对应的状态码。
  */
-ServiceResult parking_service_get_free_slots(ParkingLot *lot) {
-  int count = 0;
-  ParkingSlot **slots;
-  SlotQueryResult *result_data;
+static ParkingServiceResultCode release_slot_code(ParkingLot *lot, int slot_id,
+                                                  time_t now,
+                                                  ExitReceipt *receipt) {
+  ParkingSlot *slot;
+  TraceSpan span;
+  int released;
 
-  if (!lot) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
-  }
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "lookup");
+  slot = find_slot_by_id(lot, slot_id);
+  PARKING_TRACE_END(span);
 
-  slots = get_free_slots(lot, &count);
-  result_data = (SlotQueryResult *)malloc(sizeof(SlotQueryResult));
-  if (!result_data) {
-    free(slots); /* 如果 slots 不为 NULL */
-    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  memset(receipt, 0, sizeof(*receipt));
+  if (!slot) {
+    return PARKING_SERVICE_SLOT_NOT_FOUND;
   }
-  result_data->slot_list = slots;
-  result_data->total_found = count;
+  if (slot->status == FREE_STATUS) {
+    return PARKING_SERVICE_SLOT_FREE;
+  }
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "fee");
+  charge_exit(lot, slot, now, receipt);
+  PARKING_TRACE_END(span);
 
-  return create_service_result(PARKING_SERVICE_SUCCESS, "获取空闲车位列表成功",
-                               result_data);
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "release");
+  released = deallocate_slot_at(lot, slot_id, now);
+  PARKING_TRACE_END(span);
+  if (released != 0) {
+    return PARKING_SERVICE_SYSTEM_ERROR;
+  }
+  return PARKING_SERVICE_SUCCESS;
 }
 
 /**
- * @brief 获取所有已占用车位的列表。
- * @param lot 目标停车场。
- * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
- * SlotQueryResult 对象， 其中包含了已占用车位的列表和数量。
+ * @brief 检查出场附带的收费台账与停车记录是否写入失败。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @return 有写入失败时返回对应的提示消息，否则返回 NULL。
  */
-ServiceResult parking_service_get_occupied_slots(ParkingLot *lot) {
-  int count = 0;
-  ParkingSlot **slots;
-  SlotQueryResult *result_data;
-
-  if (!lot) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+static const char *exit_write_failure(const ParkingLot *lot) {
+  if (parking_ledger_failed(lot)) {
+    return LEDGER_FAILED_MESSAGE;
   }
-
-  slots = get_occupied_slots(lot, &count);
-  result_data = (SlotQueryResult *)malloc(sizeof(SlotQueryResult));
-  if (!result_data) {
-    free(slots); /* 如果slots不为NULL */
-    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  if (parking_history_failed(lot)) {
+    return HISTORY_FAILED_MESSAGE;
   }
-  result_data->slot_list = slots;
-  result_data->total_found = count;
-
-  return create_service_result(PARKING_SERVICE_SUCCESS,
-                               "获取已占用车位列表成功", result_data);
+  return NULL;
 }
 
 /**
- * @brief 获取停车场中所有车位的列表。
- * @details 手动遍历停车场链表来构建车位列表，而不是调用数据层函数。
+ * @brief 汇总停车场的统计信息（不加锁）。
  * @param lot 目标停车场。
- * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
- * SlotQueryResult 对象， 其中包含了所有车位的列表和数量。
+ * @param[out] stats 接收统计信息的结构体。
  */
-ServiceResult parking_service_get_all_slots(ParkingLot *lot) {
-  int count = 0;
-  ParkingSlot *current;
-  ParkingSlot **slots;
-  SlotQueryResult *result_data;
+static void fill_statistics(const ParkingLot *lot, ParkingStatistics *stats) {
+  long today_cents;
+  long month_cents;
+  int total = parking_atomic_load_int(&lot->total_slots);
+  int occupied = parking_atomic_load_int(&lot->occupied_slots);
 
-  if (!lot) {
-    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
-  }
+  read_revenue(lot, parking_lot_now(lot), &today_cents, &month_cents);
+  stats->total_slots = total;
+  stats->occupied_slots = occupied;
+  stats->free_slots = total - occupied;
+  stats->occupancy_rate =
+      (total > 0) ? ((double)occupied / total) * 100.0 : 0.0;
+  stats->today_revenue = today_cents / 100.0;
+  stats->month_revenue = month_cents / 100.0;
+}
 
-  /* 第一次遍历：计算总数 */
-  current = lot->slot_head;
-  while (current != NULL) {
-    count++;
-    current = current->next;
-  }
+/**
+ * @brief 在已持有写锁的前提下释放车位并计算费用。
+ * @details 由 release_slot_code 完成释放与计费，再补充消息；
+ *          结果的 data 字段始终为 NULL，计费明细写入 receipt。
+ * @param lot 目标停车场（调用者已持有写锁）。
+ * @param slot_id 要释放的车位ID。
+ * @param[out] receipt 接收本次出场的计费明细。
+ * @return 与 parking_service_checkout_slot 相同的 ServiceResult。
+ */
+static ServiceResult release_slot_and_charge(ParkingLot *lot, int slot_id,
+                                             ExitReceipt *receipt) {
+  ParkingServiceResultCode code;
+  const char *failure;
 
-  if (count == 0) {
-    /* 处理停车场为空的情况 */
-    result_data = (SlotQueryResult *)calloc(1, sizeof(SlotQueryResult));
-    if (!result_data) {
-      return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
-    }
-    return create_service_result(PARKING_SERVICE_SUCCESS,
-                                 "获取所有车位列表成功", result_data);
+  code = release_slot_code(lot, slot_id, parking_lot_now(lot), receipt);
+  if (code == PARKING_SERVICE_SYSTEM_ERROR) {
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "数据层释放车位失败", NULL);
   }
-
-  /* 分配指针数组 */
-  slots = (ParkingSlot **)malloc(sizeof(ParkingSlot *) * count);
-  if (!slots) {
-    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  if (code != PARKING_SERVICE_SUCCESS) {
+    return create_service_result(code, NULL, NULL);
   }
-
-  /* 第二次遍历：填充指针 */
-  int i = 0;
-  current = lot->slot_head;
-  while (current != NULL) {
-    slots[i++] = current;
-    current = current->next;
+  if (parking_journal_failed(lot)) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 JOURNAL_FAILED_MESSAGE, NULL);
+  }
+  failure = exit_write_failure(lot);
+  if (failure) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, failure, NULL);
   }
 
-  /* 创建并填充结果结构体 */
-  result_data = (SlotQueryResult *)malloc(sizeof(SlotQueryResult));
-  if (!result_data) {
-    free(slots);
+  if (receipt->amount > 0) {
+    return note_journal_pending(
+        lot, create_service_result(PARKING_SERVICE_SUCCESS,
+                                   "车辆出场成功，请缴费", NULL));
+  }
+  return note_journal_pending(
+      lot, create_service_result(PARKING_SERVICE_SUCCESS,
+                                 "车辆出场成功，无费用产生", NULL));
+}
+
+/* ========================================================================== */
+/*                            核心业务服务函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief 添加一个新的停车位。
+ * @details 验证参数后，在停车场自有的内存池中创建车位并将其添加到停车场。
+ *          重复ID检查由数据层的车位编号索引一次完成。
+ * @param lot 目标停车场。
+ * @param slot_id 新车位的ID。
+ * @param location 新车位的位置描述。
+ * @return 返回一个 ServiceResult 结构，包含操作结果。
+ */
+static ServiceResult unmetered_add_slot(ParkingLot *lot, int slot_id,
+                                        const char *location) {
+  int data_result;
+  int journal_failed;
+
+  if (!lot || !location || !validate_slot_id(slot_id) ||
+      strlen(location) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = create_and_add_slot(lot, slot_id, location);
+  journal_failed = parking_journal_failed(lot);
+  parking_lot_write_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    break;
+  case -2:
+    return create_service_result(PARKING_SERVICE_SLOT_EXISTS, NULL, NULL);
+  case -3:
     return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "添加车位到链表失败", NULL);
   }
-  result_data->slot_list = slots;
-  result_data->total_found = count;
 
-  return create_service_result(PARKING_SERVICE_SUCCESS, "获取所有车位列表成功",
-                               result_data);
+  if (journal_failed) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 JOURNAL_FAILED_MESSAGE, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "车位添加成功", NULL);
 }
 
 /**
- * @brief 获取停车场的统计信息。
- * @details 在获取信息前，会先调用 update_revenue_cycle
- * 确保收入数据是基于当前时间的。 然后将停车场的统计数据打包成 ParkingStatistics
- * 结构体返回。
+ * @brief parking_service_add_slot 的公共入口。
+ * @details 调用 unmetered_add_slot 并记录服务指标。
+ */
+ServiceResult parking_service_add_slot(ParkingLot *lot, int slot_id,
+                                       const char *location) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_add_slot(lot, slot_id, location);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ADD_SLOT, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 批量添加停车位。
+ * @details 逐项验证参数后，在一次写锁内交给数据层批量创建：
+ *          查重与车位表、索引扩容都只做一次。
  * @param lot 目标停车场。
- * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
- * ParkingStatistics 对象。
+ * @param slot_ids 新车位的ID数组。
+ * @param locations 与ID一一对应的位置描述数组。
+ * @param count 车位个数。
+ * @return 返回一个 ServiceResult 结构，包含操作结果。
  */
-ServiceResult parking_service_get_statistics(ParkingLot *lot) {
-  ParkingStatistics *stats;
+static ServiceResult unmetered_add_slots_bulk(ParkingLot *lot,
+                                              const int *slot_ids,
+                                              const char *const *locations,
+                                              int count) {
+  char message[128];
+  int conflict_id = 0;
+  int data_result;
+  int journal_failed;
+  int i;
 
-  if (!lot) {
+  if (!lot || !slot_ids || !locations || count <= 0) {
     return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
   }
+  for (i = 0; i < count; i++) {
+    if (!validate_slot_id(slot_ids[i]) || !locations[i] ||
+        strlen(locations[i]) == 0) {
+      sprintf(message, "第 %d 个车位的编号或位置无效", i + 1);
+      return create_service_result(PARKING_SERVICE_INVALID_PARAM, message,
+                                   NULL);
+    }
+  }
 
-  update_revenue_cycle(lot);
+  parking_lot_write_lock(lot);
+  data_result =
+      create_and_add_slots(lot, slot_ids, locations, count, &conflict_id);
+  journal_failed = parking_journal_failed(lot);
+  parking_lot_write_unlock(lot);
 
-  stats = (ParkingStatistics *)malloc(sizeof(ParkingStatistics));
-  if (!stats) {
+  switch (data_result) {
+  case 0:
+    break;
+  case -2:
+    sprintf(message, "车位 %d 已存在或在本批中重复，未添加任何车位",
+            conflict_id);
+    return create_service_result(PARKING_SERVICE_SLOT_EXISTS, message, NULL);
+  case -3:
     return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "批量添加车位失败", NULL);
   }
 
-  stats->total_slots = lot->total_slots;
-  stats->occupied_slots = lot->occupied_slots;
-  stats->free_slots = lot->total_slots - lot->occupied_slots;
-  stats->occupancy_rate =
-      (lot->total_slots > 0)
-          ? ((double)lot->occupied_slots / lot->total_slots) * 100.0
-          : 0.0;
-  stats->today_revenue = lot->today_revenue;
-  stats->month_revenue = lot->month_revenue;
-
-  return create_service_result(PARKING_SERVICE_SUCCESS, "获取统计信息成功",
-                               stats);
+  if (journal_failed) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 JOURNAL_FAILED_MESSAGE, NULL);
+  }
+  sprintf(message, "已添加 %d 个车位", count);
+  return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
 }
 
-/* ========================================================================== */
-/*                            数据持久化服务函数实现                          */
-/* ========================================================================== */
+/**
+ * @brief parking_service_add_slots_bulk 的公共入口。
+ * @details 调用 unmetered_add_slots_bulk，整批计为一次添加车位操作。
+ */
+ServiceResult parking_service_add_slots_bulk(ParkingLot *lot,
+                                             const int *slot_ids,
+                                             const char *const *locations,
+                                             int count) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result =
+      unmetered_add_slots_bulk(lot, slot_ids, locations, count);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ADD_SLOT, result.code, started);
+  return result;
+}
 
 /**
- * @brief 将停车场数据保存到文件。
- * @details 验证参数后，调用数据层的 save_parking_data
- * 函数执行实际的文件写入操作。
- * @param lot 要保存的停车场对象。
- * @param filename 目标文件的路径。
- * @return 返回一个 ServiceResult 结构，指示操作是否成功。
+ * @brief 从 CSV 车位清单文件导入车位。
+ * @details 先不持锁解析整个文件，全部行有效后才取写锁加入车位。
+ * @param lot 目标停车场。
+ * @param filename 清单文件名。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
  */
-ServiceResult parking_service_save_data(ParkingLot *lot, const char *filename) {
+static ServiceResult unmetered_import_slots(ParkingLot *lot,
+                                            const char *filename) {
+  SlotImport import;
+  char message[160];
+  long conflict_line = 0;
+  FILE *file;
+  int data_result;
+  int journal_failed;
+  int count;
+
   if (!lot || !filename || strlen(filename) == 0) {
     return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
   }
-
-  if (save_parking_data(lot, filename) != 0) {
+  file = fopen(filename, "rb");
+  if (!file) {
     return create_service_result(PARKING_SERVICE_FILE_ERROR, NULL, NULL);
   }
+  slot_import_init(&import);
+  data_result = slot_import_parse(&import, file);
+  fclose(file);
+
+  if (data_result == -3) {
+    sprintf(message, "第 %ld 行%s，共 %ld 行有误，未导入任何车位",
+            import.issues[0].line,
+            slot_import_error_text(import.issues[0].error),
+            import.error_count);
+    slot_import_free(&import);
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, message,
+                                 NULL);
+  }
+  if (data_result != 0) {
+    slot_import_free(&import);
+    return create_service_result(data_result == -2
+                                     ? PARKING_SERVICE_MEMORY_ERROR
+                                     : PARKING_SERVICE_FILE_ERROR,
+                                 NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = slot_import_commit(lot, &import, &conflict_line);
+  journal_failed = parking_journal_failed(lot);
+  parking_lot_write_unlock(lot);
+  count = import.count;
+  slot_import_free(&import);
+
+  switch (data_result) {
+  case 0:
+    break;
+  case -2:
+    sprintf(message, "第 %ld 行的车位编号已存在或在文件中重复，未导入任何车位",
+            conflict_line);
+    return create_service_result(PARKING_SERVICE_SLOT_EXISTS, message, NULL);
+  case -3:
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "导入车位失败", NULL);
+  }
 
-  return create_service_result(PARKING_SERVICE_SUCCESS, "数据保存成功", NULL);
+  if (journal_failed) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 JOURNAL_FAILED_MESSAGE, NULL);
+  }
+  sprintf(message, "已导入 %d 个车位", count);
+  return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
 }
 
 /**
- * @brief 从文件加载停车场数据。
- * @details 验证参数后，调用数据层的 load_parking_data
- * 函数执行实际的文件读取和解析。
- * @param filename 源文件的路径。
- * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向新创建的
- * ParkingLot 对象。
+ * @brief parking_service_import_slots 的公共入口。
+ * @details 调用 unmetered_import_slots，整批计为一次添加车位操作。
  */
-ServiceResult parking_service_load_data(const char *filename) {
-  ParkingLot *lot;
+ServiceResult parking_service_import_slots(ParkingLot *lot,
+                                           const char *filename) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_import_slots(lot, filename);
 
-  if (!filename || strlen(filename) == 0) {
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ADD_SLOT, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 为指定车位分配车辆（车辆入场）。
+ * @details 验证参数后，调用数据层函数为车位分配车辆信息。
+ *          处理并返回数据层可能出现的各种错误。
+ * @param lot 目标停车场。
+ * @param slot_id 要分配的车位ID。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 返回一个 ServiceResult 结构，包含操作结果。
+ */
+static ServiceResult unmetered_allocate_slot(ParkingLot *lot, int slot_id,
+                                             const char *owner_name,
+                                             const char *license_plate,
+                                             const char *contact,
+                                             ParkingType type) {
+  ServiceResult result;
+  TraceSpan span;
+  int data_result;
+  int valid;
+
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "validate");
+  valid = lot && validate_slot_id(slot_id) &&
+          validate_entry_fields(owner_name, license_plate, contact, NULL);
+  PARKING_TRACE_END(span);
+  if (!valid) {
     return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
   }
 
-  lot = load_parking_data(filename);
+  parking_lot_write_lock(lot);
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "allocate");
+  data_result =
+      allocate_slot(lot, slot_id, owner_name, license_plate, contact, type);
+  PARKING_TRACE_END(span);
+  result = map_allocate_result(lot, data_result, NULL);
+  parking_lot_write_unlock(lot);
+
+  return result;
+}
+
+/**
+ * @brief parking_service_allocate_slot 的公共入口。
+ * @details 调用 unmetered_allocate_slot 并记录服务指标。
+ */
+ServiceResult parking_service_allocate_slot(ParkingLot *lot, int slot_id,
+                                            const char *owner_name,
+                                            const char *license_plate,
+                                            const char *contact,
+                                            ParkingType type) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_allocate_slot(lot, slot_id, owner_name,
+                                                 license_plate, contact, type);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ALLOCATE_SLOT, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 自动选择一个空闲车位并分配给车辆（车辆入场）。
+ * @details 验证参数后，由数据层通过空闲车位位图取得第一个空闲车位，
+ *          再按 parking_service_allocate_slot 相同的规则完成分配。
+ * @param lot 目标停车场。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向被分配的车位。
+ */
+static ServiceResult unmetered_allocate_any_slot(ParkingLot *lot,
+                                                 const char *owner_name,
+                                                 const char *license_plate,
+                                                 const char *contact,
+                                                 ParkingType type) {
+  ServiceResult result;
+  ParkingSlot *slot;
+  TraceSpan span;
+  int valid;
+
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "validate");
+  valid = lot && validate_entry_fields(owner_name, license_plate, contact, NULL);
+  PARKING_TRACE_END(span);
+  if (!valid) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  /* 查找与分配在同一把写锁内完成，避免两个入口抢到同一个空闲车位 */
+  parking_lot_write_lock(lot);
+  PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "lookup");
+  slot = find_free_slot_for(lot, type, license_plate);
+  PARKING_TRACE_END(span);
+  if (slot == NULL) {
+    result = create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                   "没有空闲车位", NULL);
+  } else {
+    int data_result;
+
+    PARKING_TRACE_BEGIN(span, TRACE_CATEGORY_PHASE, "allocate");
+    data_result = allocate_slot(lot, slot->slot_id, owner_name, license_plate,
+                                contact, type);
+    PARKING_TRACE_END(span);
+    result = map_allocate_result(lot, data_result, slot);
+  }
+  parking_lot_write_unlock(lot);
+
+  return result;
+}
+
+/**
+ * @brief parking_service_allocate_any_slot 的公共入口。
+ * @details 调用 unmetered_allocate_any_slot 并记录服务指标。
+ */
+ServiceResult parking_service_allocate_any_slot(ParkingLot *lot,
+                                                const char *owner_name,
+                                                const char *license_plate,
+                                                const char *contact,
+                                                ParkingType type) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result =
+      unmetered_allocate_any_slot(lot, owner_name, license_plate, contact,
+                                  type);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ALLOCATE_ANY_SLOT, result.code,
+                         started);
+  return result;
+}
+
+/**
+ * @brief 只凭车牌号为常客车辆分配车位（车辆入场）。
+ * @details 车主资料取自车辆上一次出场时记下的缓存，已在当时校验过，
+ *          这里只校验车牌号本身。
+ * @param lot 目标停车场。
+ * @param license_plate 车牌号。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向被分配的车位。
+ */
+static ServiceResult
+unmetered_allocate_returning_vehicle(ParkingLot *lot,
+                                     const char *license_plate) {
+  ServiceResult result;
+  int data_result;
+  int slot_id = 0;
+
+  if (!lot || !validate_license_plate(license_plate)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = allocate_returning_vehicle(lot, license_plate, &slot_id);
+  if (data_result == -2) {
+    result = create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                   "没有该车辆的资料", NULL);
+  } else if (data_result == -3) {
+    result = create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                   "没有空闲车位", NULL);
+  } else {
+    result = map_allocate_result(
+        lot, data_result,
+        data_result == 0 ? find_slot_by_id(lot, slot_id) : NULL);
+  }
+  parking_lot_write_unlock(lot);
+
+  return result;
+}
+
+/**
+ * @brief parking_service_allocate_returning_vehicle 的公共入口。
+ * @details 调用 unmetered_allocate_returning_vehicle 并记录服务指标，
+ *          与 parking_service_allocate_any_slot 记入同一项指标。
+ */
+ServiceResult
+parking_service_allocate_returning_vehicle(ParkingLot *lot,
+                                           const char *license_plate) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result =
+      unmetered_allocate_returning_vehicle(lot, license_plate);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ALLOCATE_ANY_SLOT, result.code,
+                         started);
+  return result;
+}
+
+/**
+ * @brief 读取缓存中某辆车的资料。
+ * @param lot 目标停车场。
+ * @param license_plate 车牌号。
+ * @param[out] session 接收车辆资料。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_find_vehicle_session(ParkingLot *lot,
+                                                   const char *license_plate,
+                                                   VehicleSession *session) {
+  int data_result;
+
+  if (!lot || !session || !validate_license_plate(license_plate)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  data_result = find_vehicle_session(lot, license_plate, session);
+  parking_lot_read_unlock(lot);
+
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                 "没有该车辆的资料", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取车辆资料成功",
+                               NULL);
+}
+
+/**
+ * @brief 设置车辆资料缓存的容量。
+ * @param lot 目标停车场。
+ * @param capacity 最多缓存的车牌数，0 表示不再缓存。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_configure_session_cache(ParkingLot *lot,
+                                                      int capacity) {
+  int data_result;
+
   if (!lot) {
-    return create_service_result(PARKING_SERVICE_FILE_ERROR,
-                                 "从文件加载数据失败", NULL);
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
   }
 
-  return create_service_result(PARKING_SERVICE_SUCCESS, "数据加载成功", lot);
+  parking_lot_write_lock(lot);
+  data_result = configure_session_cache(lot, capacity);
+  parking_lot_write_unlock(lot);
+
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "车辆资料缓存已设置",
+                               NULL);
+}
+
+/**
+ * @brief 设置网络服务的请求去重表容量。
+ * @param lot 目标停车场。
+ * @param capacity 记住的请求数，0 表示不再去重。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_configure_request_log(ParkingLot *lot,
+                                                    int capacity) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = configure_request_log(lot, capacity);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -3) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "请求去重表已设置",
+                               NULL);
 }
 
+/**
+ * @brief 启用或停用只读视图。
+ * @param lot 目标停车场。
+ * @param enabled 非 0 表示启用。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_configure_read_view(ParkingLot *lot,
+                                                  int enabled) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = configure_read_view(lot, enabled);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -2) {
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "仍有读者在使用只读视图", NULL);
+  }
+  if (data_result == -3) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               enabled ? "只读视图已启用" : "只读视图已停用",
+                               NULL);
+}
+
+/**
+ * @brief 把停车场的当前状态发布为新的只读视图。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_refresh_read_view(ParkingLot *lot) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  data_result = refresh_read_view(lot);
+  parking_lot_read_unlock(lot);
+
+  if (data_result == -3) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (data_result < 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "未启用只读视图", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               data_result == 0 ? "只读视图已刷新"
+                                                : "只读视图已是最新",
+                               NULL);
+}
+
+/**
+ * @brief 启用或停用共享内存发布。
+ * @param lot 目标停车场。
+ * @param path 共享内存文件的路径，NULL 表示停用。
+ * @param capacity 行数上限，0 表示按车位数确定。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_configure_shared_memory(ParkingLot *lot,
+                                                      const char *path,
+                                                      int capacity) {
+  int data_result;
+
+  if (!lot || capacity < 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = configure_shared_memory(lot, path, capacity);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -2) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "无法创建共享内存文件", NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               path ? "共享内存发布已启用"
+                                    : "共享内存发布已停用",
+                               NULL);
+}
+
+/**
+ * @brief 把停车场的当前状态发布到共享内存。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_publish_shared_memory(ParkingLot *lot) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  data_result = refresh_shared_memory(lot);
+  parking_lot_read_unlock(lot);
+
+  if (data_result < 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "未启用共享内存发布", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               data_result == 0 ? "共享内存已发布"
+                                                : "共享内存已是最新",
+                               NULL);
+}
+
+/**
+ * @brief 把停车场挂接到汇总树的一个站点。
+ * @param lot 目标停车场。
+ * @param tree 汇总树，NULL 表示解除挂接。
+ * @param site 站点节点编号。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_attach_aggregate(ParkingLot *lot,
+                                               ParkingAggregate *tree,
+                                               int site) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = attach_parking_aggregate(lot, tree, site);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -2) {
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "该站点已挂接其他停车场", NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               tree != NULL ? "已挂接汇总树" : "已解除挂接",
+                               NULL);
+}
+
+/**
+ * @brief 读取汇总树中一个节点的统计信息。
+ * @param tree 汇总树。
+ * @param node 节点编号。
+ * @param now 读取时刻。
+ * @param[out] stats 接收统计信息的结构体。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode
+parking_service_aggregate_statistics(ParkingAggregate *tree, int node,
+                                     time_t now, ParkingStatistics *stats) {
+  AggregateReading reading;
+
+  if (!stats || aggregate_read(tree, node, now, &reading) != 0) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  stats->total_slots = (int)reading.total_slots;
+  stats->occupied_slots = (int)reading.occupied_slots;
+  stats->free_slots = (int)(reading.total_slots - reading.occupied_slots);
+  stats->occupancy_rate =
+      reading.total_slots > 0
+          ? ((double)reading.occupied_slots / reading.total_slots) * 100.0
+          : 0.0;
+  stats->today_revenue = reading.today_cents / 100.0;
+  stats->month_revenue = reading.month_cents / 100.0;
+  return PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief 启用、调整或关闭时间线。
+ * @param lot 目标停车场。
+ * @param segment_records 每个检查点之后最多的记录数，0 表示关闭。
+ * @param max_segments 最多保留的检查点数。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_configure_timeline(ParkingLot *lot,
+                                                 int segment_records,
+                                                 int max_segments) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = configure_parking_timeline(lot, segment_records, max_segments);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -2) {
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "快照正在进行，请稍后重试", NULL);
+  }
+  if (data_result == -3) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "时间线已设置", NULL);
+}
+
+/**
+ * @brief 查询某个车位在过去某一时刻的状态。
+ * @param lot 已启用时间线的停车场。
+ * @param slot_id 车位编号。
+ * @param when 回溯的时刻。
+ * @param[out] slot 成功时接收车位当时的状态。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_find_slot_at(ParkingLot *lot, int slot_id,
+                                           time_t when, HistoricalSlot *slot) {
+  int data_result;
+
+  if (!lot || !slot || !validate_slot_id(slot_id)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  data_result = find_slot_at(lot, slot_id, when, slot);
+  parking_lot_read_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, "查询历史状态成功",
+                                 NULL);
+  case -2:
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                 "该时刻早于保留的历史", NULL);
+  case -3:
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  case -4:
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                 "该时刻没有此车位", NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "未启用时间线", NULL);
+  }
+}
+
+/**
+ * @brief 为车牌预约一个车位的一段时间。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param license_plate 预约的车牌号。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @param[out] reservation 接收新预约，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_reserve_slot(ParkingLot *lot, int slot_id,
+                                           const char *license_plate,
+                                           time_t start, time_t end,
+                                           Reservation *reservation) {
+  int data_result;
+
+  if (!lot || !validate_slot_id(slot_id) ||
+      !validate_license_plate(license_plate)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result =
+      reserve_slot(lot, slot_id, license_plate, start, end, reservation);
+  parking_lot_write_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, "预约成功", NULL);
+  case -2:
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  case -3:
+    return create_service_result(PARKING_SERVICE_SLOT_OCCUPIED,
+                                 "该时段车位已被预约或占用", NULL);
+  case -6:
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "预约时段无效", NULL);
+  }
+}
+
+/**
+ * @brief 在一个分区内预约任意一个该时段空闲的车位。
+ * @details 查找与登记在同一把写锁内完成，两个预约不会选中同一车位的同一时段。
+ * @param lot 目标停车场。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param license_plate 预约的车牌号。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @param[out] reservation 接收新预约，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_reserve_zone(ParkingLot *lot, const char *zone,
+                                           const char *license_plate,
+                                           time_t start, time_t end,
+                                           Reservation *reservation) {
+  int data_result;
+
+  if (!lot || !validate_license_plate(license_plate)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result =
+      reserve_zone_slot(lot, zone, license_plate, start, end, reservation);
+  parking_lot_write_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, "预约成功", NULL);
+  case -2:
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                 "该时段没有可预约的车位", NULL);
+  case -6:
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "预约时段无效", NULL);
+  }
+}
+
+/**
+ * @brief 取消一条预约。
+ * @param lot 目标停车场。
+ * @param slot_id 预约的车位编号。
+ * @param reservation_id 预约编号。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_cancel_reservation(ParkingLot *lot, int slot_id,
+                                                 long reservation_id) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = cancel_reservation(lot, slot_id, reservation_id);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -2) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, "预约不存在",
+                                 NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "预约已取消", NULL);
+}
+
+/**
+ * @brief 查询分区在某时段内还有没有可预约的车位。
+ * @param lot 目标停车场。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @param[out] slot_id 接收第一个可用车位的编号，可以为 NULL。
+ * @param[out] available 接收可用车位数，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_check_availability(ParkingLot *lot,
+                                                 const char *zone,
+                                                 time_t start, time_t end,
+                                                 int *slot_id, int *available) {
+  ParkingSlot *slot;
+  int first = 0;
+  int count = 0;
+
+  if (slot_id) {
+    *slot_id = 0;
+  }
+  if (available) {
+    *available = 0;
+  }
+  if (!lot || start >= end) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  slot = find_available_slot(lot, zone, start, end);
+  if (slot) {
+    first = slot->slot_id;
+    count = available ? count_available_slots(lot, zone, start, end) : 1;
+  }
+  parking_lot_read_unlock(lot);
+
+  if (slot_id) {
+    *slot_id = first;
+  }
+  if (available) {
+    *available = count;
+  }
+  if (!slot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                 "该时段没有可预约的车位", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "该时段有可预约的车位",
+                               NULL);
+}
+
+/**
+ * @brief 把车位划入居民专用池、访客专用池或共享池。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param pool 分配池。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_set_slot_pool(ParkingLot *lot, int slot_id,
+                                            SlotPool pool) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = set_slot_pool(lot, slot_id, pool);
+  parking_lot_write_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, "车位分配池已设置",
+                                 NULL);
+  case -2:
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  case -3:
+    return create_service_result(PARKING_SERVICE_SLOT_OCCUPIED,
+                                 "固定车位只能属于居民池", NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+}
+
+/**
+ * @brief 为居民车牌登记固定车位。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @param slot_id 车位编号。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_assign_home_slot(ParkingLot *lot,
+                                               const char *license_plate,
+                                               int slot_id) {
+  int data_result;
+
+  if (!lot || !validate_license_plate(license_plate)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = assign_home_slot(lot, license_plate, slot_id);
+  parking_lot_write_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, "固定车位已登记",
+                                 NULL);
+  case -2:
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  case -3:
+    return create_service_result(PARKING_SERVICE_SLOT_OCCUPIED,
+                                 "车位已为其他车辆专用", NULL);
+  case -6:
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+}
+
+/**
+ * @brief 撤销居民车牌的固定车位。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @param[out] slot_id 接收原固定车位的编号，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_release_home_slot(ParkingLot *lot,
+                                                const char *license_plate,
+                                                int *slot_id) {
+  int released;
+
+  if (slot_id) {
+    *slot_id = 0;
+  }
+  if (!lot || !license_plate) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  released = release_home_slot(lot, license_plate);
+  parking_lot_write_unlock(lot);
+
+  if (slot_id) {
+    *slot_id = released;
+  }
+  if (released == 0) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                 "该车牌没有固定车位", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "固定车位已撤销",
+                               NULL);
+}
+
+/**
+ * @brief 登记或修改车位的平面坐标。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_set_slot_position(ParkingLot *lot, int slot_id,
+                                                long x, long y) {
+  int data_result;
+
+  if (!lot || !validate_slot_id(slot_id)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = set_slot_position(lot, slot_id, x, y);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -2) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, "车位不存在",
+                                 NULL);
+  }
+  if (data_result == -3) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "车位坐标已登记", NULL);
+}
+
+/**
+ * @brief 登记或修改一个命名地标的坐标。
+ * @param lot 目标停车场。
+ * @param name 地标名称。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_set_landmark(ParkingLot *lot, const char *name,
+                                           long x, long y) {
+  int data_result;
+
+  if (!lot || !name || !*name) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = set_parking_landmark(lot, name, x, y);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -3) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, "地标名称无效",
+                                 NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "地标已登记", NULL);
+}
+
+/**
+ * @brief (静态辅助函数) 在读锁内查找最近的空闲车位。
+ * @details 空间索引过期时先释放读锁、在写锁内重建，再重新取得读锁检查，
+ *          直到持有读锁时索引是最新的，查找本身不修改停车场。
+ * @param lot 目标停车场。
+ * @param landmark 地标名称；为 NULL 时使用 x、y。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @param[out] slot_id 接收车位编号，没有时写入 0。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+static ServiceResult find_nearest_free(ParkingLot *lot, const char *landmark,
+                                       long x, long y, int *slot_id) {
+  ParkingSlot *slot = NULL;
+  int known = 1;
+  int found = 0;
+
+  parking_lot_read_lock(lot);
+  while (slot_layout_stale(lot)) {
+    int rebuilt;
+
+    parking_lot_read_unlock(lot);
+    parking_lot_write_lock(lot);
+    rebuilt = refresh_slot_layout(lot);
+    parking_lot_write_unlock(lot);
+    if (rebuilt != 0) {
+      return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+    }
+    parking_lot_read_lock(lot);
+  }
+
+  if (landmark) {
+    known = lot->layout != NULL &&
+            layout_find_landmark(lot->layout, landmark) != NULL;
+    slot = known ? find_nearest_free_slot_to(lot, landmark) : NULL;
+  } else {
+    slot = find_nearest_free_slot(lot, x, y);
+  }
+  if (slot) {
+    found = slot->slot_id;
+  }
+  parking_lot_read_unlock(lot);
+
+  if (slot_id) {
+    *slot_id = found;
+  }
+  if (!known) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, "地标不存在",
+                                 NULL);
+  }
+  if (!found) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                 "附近没有空闲车位", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "已找到最近的空闲车位",
+                               NULL);
+}
+
+/**
+ * @brief 查找离某一点最近的空闲车位。
+ * @param lot 目标停车场。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @param[out] slot_id 接收车位编号，没有时写入 0。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_find_nearest_free_slot(ParkingLot *lot, long x,
+                                                     long y, int *slot_id) {
+  if (slot_id) {
+    *slot_id = 0;
+  }
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return find_nearest_free(lot, NULL, x, y, slot_id);
+}
+
+/**
+ * @brief 查找离命名地标最近的空闲车位。
+ * @param lot 目标停车场。
+ * @param landmark 地标名称。
+ * @param[out] slot_id 接收车位编号，没有时写入 0。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_find_nearest_free_slot_to(ParkingLot *lot,
+                                                        const char *landmark,
+                                                        int *slot_id) {
+  if (slot_id) {
+    *slot_id = 0;
+  }
+  if (!lot || !landmark) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return find_nearest_free(lot, landmark, 0, 0, slot_id);
+}
+
+/**
+ * @brief 登记一个分区，此后增量维护其空位计数。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_add_zone(ParkingLot *lot, const char *prefix) {
+  int data_result;
+
+  if (!lot || !prefix || !*prefix) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = add_parking_zone(lot, prefix);
+  parking_lot_write_unlock(lot);
+
+  if (data_result == -3) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, "分区前缀无效",
+                                 NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "分区已登记", NULL);
+}
+
+/**
+ * @brief 撤销一个分区。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_remove_zone(ParkingLot *lot, const char *prefix) {
+  int data_result;
+
+  if (!lot || !prefix) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = remove_parking_zone(lot, prefix);
+  parking_lot_write_unlock(lot);
+
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, "分区未登记",
+                                 NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "分区已撤销", NULL);
+}
+
+/**
+ * @brief 读取一个分区的车位总数、空闲数与占用数。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @param[out] stats 接收分区计数。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_get_zone_stats(ParkingLot *lot,
+                                             const char *prefix,
+                                             ParkingZoneStats *stats) {
+  int data_result;
+
+  if (!lot || !prefix || !stats) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  data_result = get_parking_zone_stats(lot, prefix, stats);
+  parking_lot_read_unlock(lot);
+
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, "分区未登记",
+                                 NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取分区统计成功",
+                               NULL);
+}
+
+/**
+ * @brief 按登记顺序读取全部分区的计数。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收分区计数的数组。
+ * @param max 数组容量。
+ * @param[out] count 接收已登记的分区数，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_list_zone_stats(ParkingLot *lot,
+                                              ParkingZoneStats *stats, int max,
+                                              int *count) {
+  int zones;
+
+  if (count) {
+    *count = 0;
+  }
+  if (!lot || max < 0 || (!stats && max > 0)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  zones = list_parking_zone_stats(lot, stats, max);
+  parking_lot_read_unlock(lot);
+
+  if (count) {
+    *count = zones;
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取分区统计成功",
+                               NULL);
+}
+
+/**
+ * @brief 读取一个分区（或整个停车场）的短时占用预测。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀，NULL 或空串表示整个停车场。
+ * @param[out] forecast 接收预测结果。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult
+parking_service_get_occupancy_forecast(ParkingLot *lot, const char *prefix,
+                                       ParkingForecast *forecast) {
+  int data_result;
+
+  if (!lot || !forecast) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  data_result = get_parking_forecast(lot, prefix, forecast);
+  parking_lot_read_unlock(lot);
+
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, "分区未登记",
+                                 NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取占用预测成功",
+                               NULL);
+}
+
+/**
+ * @brief 注册分区计数变化的处理函数。
+ * @param lot 目标停车场。
+ * @param handler 处理函数，NULL 表示不再通知。
+ * @param ctx 透传给处理函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_set_zone_handler(ParkingLot *lot,
+                                               ParkingZoneHandler handler,
+                                               void *ctx) {
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  set_parking_zone_handler(lot, handler, ctx);
+  parking_lot_write_unlock(lot);
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               "分区处理函数已设置", NULL);
+}
+
+/**
+ * @brief 订阅车位变更。
+ * @param lot 目标停车场。
+ * @param capacity 队列至少能容纳的事件数，0 表示默认容量。
+ * @param[out] subscription 接收订阅者句柄。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_subscribe_changes(
+    ParkingLot *lot, size_t capacity,
+    struct ChangeSubscription **subscription) {
+  struct ChangeSubscription *created;
+
+  if (subscription) {
+    *subscription = NULL;
+  }
+  if (!lot || !subscription) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  created = subscribe_slot_changes(lot, capacity);
+  parking_lot_write_unlock(lot);
+
+  if (!created) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  *subscription = created;
+  return create_service_result(PARKING_SERVICE_SUCCESS, "订阅成功", NULL);
+}
+
+/**
+ * @brief 撤销订阅并释放其队列。
+ * @param lot 目标停车场。
+ * @param subscription 订阅者句柄。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_unsubscribe_changes(
+    ParkingLot *lot, struct ChangeSubscription *subscription) {
+  int data_result;
+
+  if (!lot || !subscription) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = unsubscribe_slot_changes(lot, subscription);
+  parking_lot_write_unlock(lot);
+
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, "订阅不存在",
+                                 NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "已取消订阅", NULL);
+}
+
+/**
+ * @brief 取出订阅者队列中的事件。
+ * @param subscription 订阅者句柄。
+ * @param[out] changes 接收事件的数组。
+ * @param max 数组容量。
+ * @param[out] count 接收取出的事件数。
+ * @param[out] dropped 接收丢弃的事件数，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_poll_changes(
+    struct ChangeSubscription *subscription, ParkingChange *changes, int max,
+    int *count, int *dropped) {
+  int polled;
+
+  if (count) {
+    *count = 0;
+  }
+  if (dropped) {
+    *dropped = 0;
+  }
+  if (!subscription || !changes || !count || max < 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  polled = poll_slot_changes(subscription, changes, max);
+  *count = polled;
+  if (dropped) {
+    *dropped = take_dropped_slot_changes(subscription);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取变更成功", NULL);
+}
+
+/**
+ * @brief 释放一个停车位（车辆出场），并计算费用。
+ * @details 验证车位存在且被占用。根据停车类型（居民/访客）计算停车费用，
+ *          更新收入统计，然后调用数据层函数释放车位。
+ * @param lot 目标停车场。
+ * @param slot_id 要释放的车位ID。
+ * @return 返回一个 ServiceResult 结构。成功时，如果产生费用，
+ *         其 data 字段会指向一个包含费用值的 double 类型指针。
+ */
+ServiceResult parking_service_deallocate_slot(ParkingLot *lot, int slot_id) {
+  ServiceResult result;
+  ExitReceipt receipt;
+  double *fee_ptr;
+
+  result = parking_service_checkout_slot(lot, slot_id, &receipt);
+  if (result.code != PARKING_SERVICE_SUCCESS || receipt.amount <= 0) {
+    return result;
+  }
+
+  /* 兼容旧接口：费用以堆上的 double 返回 */
+  fee_ptr = (double *)alloc_result_payload(sizeof(double));
+  if (!fee_ptr) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  *fee_ptr = receipt.amount;
+  result.data = fee_ptr;
+  return result;
+}
+
+/**
+ * @brief 释放一个停车位（车辆出场），并把计费明细写入调用者的缓冲区。
+ * @details 与 parking_service_deallocate_slot 的计费规则相同，但不分配堆内存。
+ * @param lot 目标停车场。
+ * @param slot_id 要释放的车位ID。
+ * @param[out] receipt 接收计费明细，不能为 NULL；失败时清零。
+ * @return 返回一个 ServiceResult 结构，其 data 字段始终为 NULL。
+ */
+static ServiceResult unmetered_checkout_slot(ParkingLot *lot, int slot_id,
+                                             ExitReceipt *receipt) {
+  ServiceResult result;
+
+  if (!receipt) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  memset(receipt, 0, sizeof(*receipt));
+  if (!lot || !validate_slot_id(slot_id)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  result = release_slot_and_charge(lot, slot_id, receipt);
+  parking_lot_write_unlock(lot);
+  return result;
+}
+
+/**
+ * @brief parking_service_checkout_slot 的公共入口。
+ * @details 调用 unmetered_checkout_slot 并记录服务指标。
+ */
+ServiceResult parking_service_checkout_slot(ParkingLot *lot, int slot_id,
+                                            ExitReceipt *receipt) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_checkout_slot(lot, slot_id, receipt);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_CHECKOUT_SLOT, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 报出一辆在场车辆现在出场应缴的费用，不修改任何状态。
+ * @details 只持有读锁；入场小时用栈上的日历求得，不触碰停车场在写锁内
+ *          使用的日历缓存，多个报价可以并行进行。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号，0 表示按车牌查找。
+ * @param license_plate slot_id 为 0 时的车牌号。
+ * @param when 假定的出场时间，0 表示业务时钟的当前时间。
+ * @param[out] quote 接收计费明细，失败时清零。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_quote_exit(ParkingLot *lot, int slot_id,
+                                         const char *license_plate,
+                                         time_t when, ExitReceipt *quote) {
+  ParkingCalendar calendar;
+  const ParkingConfig *config;
+  ParkingSlot *slot;
+  ParkingServiceResultCode code = PARKING_SERVICE_SUCCESS;
+
+  if (quote) {
+    memset(quote, 0, sizeof(*quote));
+  }
+  if (!lot || !quote ||
+      (slot_id == 0 && !validate_license_plate(license_plate)) ||
+      (slot_id != 0 && !validate_slot_id(slot_id))) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  if (when == 0) {
+    when = parking_lot_now(lot);
+  }
+  slot = slot_id != 0 ? find_slot_by_id(lot, slot_id)
+                      : find_slot_by_license(lot, license_plate);
+  if (!slot) {
+    code = PARKING_SERVICE_SLOT_NOT_FOUND;
+  } else if (slot->status == FREE_STATUS) {
+    code = PARKING_SERVICE_SLOT_FREE;
+  } else {
+    config = parking_lot_config(lot);
+    parking_calendar_init(&calendar, config->visitor_start_hour,
+                          config->visitor_end_hour);
+    price_exit(&config->fees, &calendar, slot, when, quote);
+  }
+  parking_lot_read_unlock(lot);
+
+  return create_service_result(
+      code, code == PARKING_SERVICE_SUCCESS ? "报价成功" : NULL, NULL);
+}
+
+/**
+ * @brief 校验一组出入场事件的参数，不访问停车场。
+ * @param events 事件数组。
+ * @param count 事件个数。
+ * @param[out] issues 接收每个事件校验结果的数组，可以为 NULL。
+ * @return 校验失败的事件个数；参数无效返回 -1。
+ */
+int parking_service_validate_batch(const GateEvent *events, int count,
+                                   ValidationIssue *issues) {
+  int invalid = 0;
+  int i;
+
+  if (count < 0 || (count > 0 && !events)) {
+    return -1;
+  }
+  for (i = 0; i < count; i++) {
+    if (!check_gate_event(&events[i], issues ? &issues[i] : NULL)) {
+      invalid++;
+    }
+  }
+  return invalid;
+}
+
+/**
+ * @brief 批量处理一组出入场事件。
+ * @details 校验、排序在锁外完成；执行阶段只获取一次写锁，
+ *          并把期间的日志记录合并为一次同步。
+ * @param lot 目标停车场。
+ * @param events 事件数组。
+ * @param count 事件个数。
+ * @param[out] results 接收每个事件状态码的数组。
+ * @return 返回一个 ServiceResult 结构，消息中给出成功与失败的条数。
+ */
+static ServiceResult unmetered_apply_batch(ParkingLot *lot,
+                                           const GateEvent *events, int count,
+                                           ParkingServiceResultCode *results) {
+  char message[96];
+  BatchOrder *order;
+  int succeeded = 0;
+  int journal_result;
+  const char *failure;
+  int i;
+  time_t now = parking_lot_now(lot);
+
+  if (!lot || count < 0 || (count > 0 && (!events || !results))) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  if (count == 0) {
+    return create_service_result(PARKING_SERVICE_SUCCESS, "批量处理完成", NULL);
+  }
+
+  order = (BatchOrder *)malloc((size_t)count * sizeof(BatchOrder));
+  if (!order) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  for (i = 0; i < count; i++) {
+    order[i].slot_id = events[i].slot_id;
+    order[i].index = i;
+    results[i] = check_gate_event(&events[i], NULL)
+                     ? PARKING_SERVICE_SUCCESS
+                     : PARKING_SERVICE_INVALID_PARAM;
+  }
+
+  qsort(order, (size_t)count, sizeof(BatchOrder), compare_batch_order);
+
+  parking_lot_write_lock(lot);
+  begin_parking_journal_batch(lot);
+  for (i = 0; i < count; i++) {
+    const GateEvent *event = &events[order[i].index];
+    ParkingServiceResultCode *code = &results[order[i].index];
+    ExitReceipt receipt;
+
+    if (*code != PARKING_SERVICE_SUCCESS) {
+      continue;
+    }
+    if (event->kind == GATE_EVENT_ENTRY) {
+      *code = allocate_code(allocate_slot(lot, event->slot_id,
+                                          event->owner_name,
+                                          event->license_plate,
+                                          event->contact, event->type));
+    } else {
+      *code = release_slot_code(lot, event->slot_id, now, &receipt);
+    }
+    if (*code == PARKING_SERVICE_SUCCESS) {
+      succeeded++;
+    }
+  }
+  journal_result = end_parking_journal_batch(lot);
+  if (parking_journal_failed(lot)) {
+    journal_result = -2;
+  }
+  failure = exit_write_failure(lot);
+  if (lot->view != NULL) {
+    refresh_read_view(lot); /* 复制失败时报表继续读上一份视图 */
+  }
+  if (lot->shm != NULL) {
+    refresh_shared_memory(lot);
+  }
+  parking_lot_write_unlock(lot);
+  free(order);
+
+  if (journal_result != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 JOURNAL_FAILED_MESSAGE, NULL);
+  }
+  if (failure) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, failure, NULL);
+  }
+  sprintf(message, "批量处理完成：成功 %d 条，失败 %d 条", succeeded,
+          count - succeeded);
+  return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
+}
+
+/**
+ * @brief parking_service_apply_batch 的公共入口。
+ * @details 调用 unmetered_apply_batch 并记录服务指标。
+ */
+ServiceResult parking_service_apply_batch(ParkingLot *lot,
+                                          const GateEvent *events, int count,
+                                          ParkingServiceResultCode *results) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_apply_batch(lot, events, count, results);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_APPLY_BATCH, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 根据车位ID查找停车位。
+ * @param lot 目标停车场。
+ * @param slot_id 要查找的车位ID。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向找到的
+ * ParkingSlot 对象。
+ */
+static ServiceResult unmetered_find_slot_by_id(ParkingLot *lot, int slot_id) {
+  ParkingSlot *slot;
+  if (!lot || !validate_slot_id(slot_id)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  parking_lot_read_lock(lot);
+  slot = find_slot_by_id(lot, slot_id);
+  parking_lot_read_unlock(lot);
+  if (!slot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", slot);
+}
+
+/**
+ * @brief parking_service_find_slot_by_id 的公共入口。
+ * @details 调用 unmetered_find_slot_by_id 并记录服务指标。
+ */
+ServiceResult parking_service_find_slot_by_id(ParkingLot *lot, int slot_id) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_find_slot_by_id(lot, slot_id);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_ID, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 取车位的带代号句柄。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param[out] handle 接收句柄。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+static ServiceResult unmetered_get_slot_handle(ParkingLot *lot, int slot_id,
+                                               SlotHandle *handle) {
+  ParkingSlot *slot;
+
+  if (!lot || !handle || !validate_slot_id(slot_id)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  parking_lot_read_lock(lot);
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot) {
+    *handle = get_slot_handle(lot, slot);
+  }
+  parking_lot_read_unlock(lot);
+  if (!slot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", NULL);
+}
+
+/**
+ * @brief parking_service_get_slot_handle 的公共入口。
+ * @details 调用 unmetered_get_slot_handle 并记入按编号查找的指标。
+ */
+ServiceResult parking_service_get_slot_handle(ParkingLot *lot, int slot_id,
+                                              SlotHandle *handle) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_slot_handle(lot, slot_id, handle);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_ID, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 在读锁内把句柄指向的车位交给回调函数。
+ * @param lot 目标停车场。
+ * @param handle 车位句柄。
+ * @param visitor 回调函数，返回值被忽略。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+static ServiceResult unmetered_visit_slot_handle(ParkingLot *lot,
+                                                 SlotHandle handle,
+                                                 SlotVisitor visitor,
+                                                 void *ctx) {
+  ParkingSlot *slot;
+
+  if (!lot || !visitor) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  parking_lot_read_lock(lot);
+  slot = find_slot_by_handle(lot, handle);
+  if (slot) {
+    visitor(slot, ctx);
+  }
+  parking_lot_read_unlock(lot);
+  if (!slot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND,
+                                 "车位句柄已失效", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", NULL);
+}
+
+/**
+ * @brief parking_service_visit_slot_handle 的公共入口。
+ * @details 调用 unmetered_visit_slot_handle 并记入按编号查找的指标。
+ */
+ServiceResult parking_service_visit_slot_handle(ParkingLot *lot,
+                                                SlotHandle handle,
+                                                SlotVisitor visitor,
+                                                void *ctx) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_visit_slot_handle(lot, handle, visitor, ctx);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_ID, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 根据车牌号查找停车位。
+ * @param lot 目标停车场。
+ * @param license_plate 要查找的车牌号。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向找到的
+ * ParkingSlot 对象。
+ */
+static ServiceResult unmetered_find_slot_by_license(ParkingLot *lot,
+                                                    const char *license_plate) {
+  ParkingSlot *slot;
+  if (!lot || !validate_license_plate(license_plate)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  parking_lot_read_lock(lot);
+  slot = find_slot_by_license(lot, license_plate);
+  parking_lot_read_unlock(lot);
+  if (!slot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", slot);
+}
+
+/**
+ * @brief parking_service_find_slot_by_license 的公共入口。
+ * @details 调用 unmetered_find_slot_by_license 并记录服务指标。
+ */
+ServiceResult parking_service_find_slot_by_license(ParkingLot *lot,
+                                                   const char *license_plate) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_find_slot_by_license(lot, license_plate);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_LICENSE, result.code,
+                         started);
+  return result;
+}
+
+/**
+ * @brief 根据车主姓名查找停车位。
+ * @param lot 目标停车场。
+ * @param owner_name 要查找的车主姓名。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向找到的
+ * ParkingSlot 对象。
+ */
+static ServiceResult unmetered_find_slot_by_owner(ParkingLot *lot,
+                                                  const char *owner_name) {
+  ParkingSlot *slot;
+  if (!lot || !owner_name || strlen(owner_name) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  parking_lot_read_lock(lot);
+  slot = find_slot_by_owner(lot, owner_name);
+  parking_lot_read_unlock(lot);
+  if (!slot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", slot);
+}
+
+/**
+ * @brief parking_service_find_slot_by_owner 的公共入口。
+ * @details 调用 unmetered_find_slot_by_owner 并记录服务指标。
+ */
+ServiceResult parking_service_find_slot_by_owner(ParkingLot *lot,
+                                                 const char *owner_name) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_find_slot_by_owner(lot, owner_name);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_OWNER, result.code,
+                         started);
+  return result;
+}
+
+/**
+ * @brief 按车牌号或车主姓名的部分内容检索全部在场车辆。
+ * @details 在读锁内调用数据层的 search_slots，结果数组按在场车辆数一次分配。
+ * @param lot 目标停车场。
+ * @param field 检索的字段。
+ * @param query 要查找的子串。
+ * @return 返回一个 ServiceResult 结构，其 data 字段指向 SlotQueryResult。
+ */
+static ServiceResult unmetered_search_slots(ParkingLot *lot,
+                                            SlotSearchField field,
+                                            const char *query) {
+  ParkingSlot **slots = NULL;
+  SlotQueryResult *result_data;
+  int capacity;
+  int count = 0;
+
+  if (!lot || !query || query[0] == '\0' ||
+      (field != SLOT_SEARCH_PLATE && field != SLOT_SEARCH_OWNER)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  capacity = parking_atomic_load_int(&lot->occupied_slots);
+  if (capacity > 0) {
+    slots = alloc_slot_array(capacity);
+  }
+  if (capacity > 0 && !slots) {
+    parking_lot_read_unlock(lot);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (slots) {
+    count = search_slots(lot, field, query, slots, capacity);
+  }
+  parking_lot_read_unlock(lot);
+
+  result_data =
+      (SlotQueryResult *)alloc_result_payload(sizeof(SlotQueryResult));
+  if (!result_data) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data->slot_list = slots;
+  result_data->total_found = count < capacity ? count : capacity;
+
+  return create_service_result(PARKING_SERVICE_SUCCESS, "检索车位列表成功",
+                               result_data);
+}
+
+/**
+ * @brief parking_service_search_slots 的公共入口。
+ * @details 调用 unmetered_search_slots 并记录服务指标。
+ */
+ServiceResult parking_service_search_slots(ParkingLot *lot,
+                                           SlotSearchField field,
+                                           const char *query) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_search_slots(lot, field, query);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_SEARCH_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 获取所有空闲车位的列表。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
+ * SlotQueryResult 对象， 其中包含了空闲车位的列表和数量。
+ */
+static ServiceResult unmetered_get_free_slots(ParkingLot *lot) {
+  int count = 0;
+  int out_of_memory;
+  ParkingSlot **slots;
+  SlotQueryResult *result_data;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  slots = collect_result_slots(lot, SLOT_FILTER_FREE, &count, &out_of_memory);
+  parking_lot_read_unlock(lot);
+  if (out_of_memory) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data =
+      (SlotQueryResult *)alloc_result_payload(sizeof(SlotQueryResult));
+  if (!result_data) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data->slot_list = slots;
+  result_data->total_found = count;
+
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取空闲车位列表成功",
+                               result_data);
+}
+
+/**
+ * @brief parking_service_get_free_slots 的公共入口。
+ * @details 调用 unmetered_get_free_slots 并记录服务指标。
+ */
+ServiceResult parking_service_get_free_slots(ParkingLot *lot) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_free_slots(lot);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 获取所有已占用车位的列表。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
+ * SlotQueryResult 对象， 其中包含了已占用车位的列表和数量。
+ */
+static ServiceResult unmetered_get_occupied_slots(ParkingLot *lot) {
+  int count = 0;
+  int out_of_memory;
+  ParkingSlot **slots;
+  SlotQueryResult *result_data;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  slots =
+      collect_result_slots(lot, SLOT_FILTER_OCCUPIED, &count, &out_of_memory);
+  parking_lot_read_unlock(lot);
+  if (out_of_memory) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data =
+      (SlotQueryResult *)alloc_result_payload(sizeof(SlotQueryResult));
+  if (!result_data) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data->slot_list = slots;
+  result_data->total_found = count;
+
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               "获取已占用车位列表成功", result_data);
+}
+
+/**
+ * @brief parking_service_get_occupied_slots 的公共入口。
+ * @details 调用 unmetered_get_occupied_slots 并记录服务指标。
+ */
+ServiceResult parking_service_get_occupied_slots(ParkingLot *lot) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_occupied_slots(lot);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 获取停车场中所有车位的列表。
+ * @details 用 collect_result_slots 按车位游标复制全部车位指针。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
+ * SlotQueryResult 对象， 其中包含了所有车位的列表和数量。
+ */
+static ServiceResult unmetered_get_all_slots(ParkingLot *lot) {
+  int count = 0;
+  int out_of_memory;
+  ParkingSlot **slots;
+  SlotQueryResult *result_data;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  slots = collect_result_slots(lot, SLOT_FILTER_ALL, &count, &out_of_memory);
+  parking_lot_read_unlock(lot);
+  if (out_of_memory) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+
+  /* 创建并填充结果结构体（停车场为空时列表为 NULL、数量为 0） */
+  result_data =
+      (SlotQueryResult *)alloc_result_payload(sizeof(SlotQueryResult));
+  if (!result_data) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data->slot_list = slots;
+  result_data->total_found = count;
+
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取所有车位列表成功",
+                               result_data);
+}
+
+/**
+ * @brief parking_service_get_all_slots 的公共入口。
+ * @details 调用 unmetered_get_all_slots 并记录服务指标。
+ */
+ServiceResult parking_service_get_all_slots(ParkingLot *lot) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_all_slots(lot);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 把一页车位包装为列表结果。
+ * @param slots 车位数组，可以为 NULL。
+ * @param count 数组中的车位数。
+ * @return 返回一个 ServiceResult 结构；失败时回收 slots。
+ */
+static ServiceResult make_page_result(ParkingSlot **slots, int count) {
+  SlotQueryResult *result_data =
+      (SlotQueryResult *)alloc_result_payload(sizeof(SlotQueryResult));
+
+  if (!result_data) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data->slot_list = slots;
+  result_data->total_found = count;
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               "获取车位分页列表成功", result_data);
+}
+
+/**
+ * @brief (静态辅助函数) 校验分页参数。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param limit 每页最多返回的车位数。
+ * @return 参数有效返回 1，否则返回 0。
+ */
+static int valid_page_request(const ParkingLot *lot, SlotFilter filter,
+                              int limit) {
+  return lot != NULL && filter >= SLOT_FILTER_ALL &&
+         filter <= SLOT_FILTER_OCCUPIED && limit > 0;
+}
+
+/**
+ * @brief 分页获取满足筛选条件的车位列表。
+ * @details 在读锁内用数据层的 get_slots_page 定位并复制一页。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param offset 跳过的匹配车位数。
+ * @param limit 每页最多返回的车位数。
+ * @return 返回一个 ServiceResult 结构，其 data 字段指向 SlotQueryResult。
+ */
+static ServiceResult unmetered_get_slots_page(ParkingLot *lot,
+                                              SlotFilter filter, int offset,
+                                              int limit) {
+  ParkingSlot **slots = NULL;
+  int remaining;
+  int count = 0;
+  int out_of_memory = 0;
+
+  if (!valid_page_request(lot, filter, limit) || offset < 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  remaining = count_slots(lot, filter) - offset;
+  if (remaining > 0) {
+    if (limit > remaining) {
+      limit = remaining;
+    }
+    slots = alloc_slot_array(limit);
+    if (slots) {
+      count = get_slots_page(lot, filter, offset, slots, limit);
+    } else {
+      out_of_memory = 1;
+    }
+  }
+  parking_lot_read_unlock(lot);
+  if (out_of_memory) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  return make_page_result(slots, count);
+}
+
+/**
+ * @brief parking_service_get_slots_page 的公共入口。
+ * @details 调用 unmetered_get_slots_page 并记录服务指标。
+ */
+ServiceResult parking_service_get_slots_page(ParkingLot *lot, SlotFilter filter,
+                                             int offset, int limit) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_slots_page(lot, filter, offset, limit);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 从续读标记处继续获取车位列表。
+ * @details 标记直接作为游标的起始行，读满一页后把游标位置写回标记。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param token 续读标记。
+ * @param limit 每页最多返回的车位数。
+ * @return 返回一个 ServiceResult 结构，其 data 字段指向 SlotQueryResult。
+ */
+static ServiceResult unmetered_get_slots_after(ParkingLot *lot,
+                                               SlotFilter filter, int *token,
+                                               int limit) {
+  ParkingSlot **slots = NULL;
+  SlotCursor cursor;
+  ParkingSlot *slot;
+  int count = 0;
+  int out_of_memory = 0;
+
+  if (!valid_page_request(lot, filter, limit) || !token || *token < -1) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  if (*token >= 0 && *token < lot->slot_count &&
+      count_slots(lot, filter) > 0) {
+    if (limit > lot->slot_count - *token) {
+      limit = lot->slot_count - *token;
+    }
+    slots = alloc_slot_array(limit);
+    if (slots) {
+      slot_cursor_init(&cursor, lot, filter);
+      cursor.next_row = *token;
+      while (count < limit && (slot = slot_cursor_next(&cursor)) != NULL) {
+        slots[count++] = slot;
+      }
+      *token = cursor.next_row < lot->slot_count ? cursor.next_row : -1;
+    } else {
+      out_of_memory = 1;
+    }
+  } else {
+    *token = -1;
+  }
+  parking_lot_read_unlock(lot);
+  if (out_of_memory) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (count == 0 && slots) {
+    pool_release(slots, 0);
+    slots = NULL;
+  }
+  return make_page_result(slots, count);
+}
+
+/**
+ * @brief parking_service_get_slots_after 的公共入口。
+ * @details 调用 unmetered_get_slots_after 并记录服务指标。
+ */
+ServiceResult parking_service_get_slots_after(ParkingLot *lot,
+                                              SlotFilter filter, int *token,
+                                              int limit) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_slots_after(lot, filter, token, limit);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 按组合条件查询车位列表。
+ * @details 在读锁内按计数器估算的上界分配数组，再由 query_slots_parallel
+ *          填充；停车场未配置并行查询时与 query_slots 相同。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param limit 最多返回的车位数，小于等于 0 表示不限。
+ * @return 返回一个 ServiceResult 结构，其 data 字段指向 SlotQueryResult。
+ */
+static ServiceResult unmetered_query_slots(ParkingLot *lot,
+                                           const SlotQuery *query, int limit) {
+  ParkingSlot **slots = NULL;
+  SlotQueryResult *result_data;
+  int capacity;
+  int count = 0;
+  int out_of_memory = 0;
+
+  if (!lot || !query) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  capacity = query_slots_bound(lot, query);
+  if (limit > 0 && limit < capacity) {
+    capacity = limit;
+  }
+  if (capacity > 0) {
+    slots = alloc_slot_array(capacity);
+    if (slots) {
+      count = query_slots_parallel(lot, query, slots, capacity,
+                                   lot->query_pool);
+    }
+    out_of_memory = slots == NULL || count < 0;
+  }
+  parking_lot_read_unlock(lot);
+  if (out_of_memory) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+
+  result_data =
+      (SlotQueryResult *)alloc_result_payload(sizeof(SlotQueryResult));
+  if (!result_data) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data->slot_list = slots;
+  result_data->total_found = count;
+
+  return create_service_result(PARKING_SERVICE_SUCCESS, "条件查询车位列表成功",
+                               result_data);
+}
+
+/**
+ * @brief parking_service_query_slots 的公共入口。
+ * @details 调用 unmetered_query_slots 并记录服务指标。
+ */
+ServiceResult parking_service_query_slots(ParkingLot *lot,
+                                          const SlotQuery *query, int limit) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_query_slots(lot, query, limit);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 统计满足组合条件的车位数。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param[out] count 接收命中的车位数。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode parking_service_count_slots(ParkingLot *lot,
+                                                     const SlotQuery *query,
+                                                     int *count) {
+  if (!lot || !query || !count) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  parking_lot_read_lock(lot);
+  *count = count_query_slots_parallel(lot, query, lot->query_pool);
+  parking_lot_read_unlock(lot);
+  return *count < 0 ? PARKING_SERVICE_MEMORY_ERROR : PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief 获取停车时长排行。
+ * @details 在读锁内按入场时间链表复制前 limit 个在场车位。
+ * @param lot 目标停车场。
+ * @param limit 最多返回的车位数，小于等于 0 表示返回全部在场车位。
+ * @param longest_first 非 0 时按停车时长从长到短，否则从短到长。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
+ * SlotQueryResult 对象。
+ */
+static ServiceResult unmetered_get_slots_by_duration(ParkingLot *lot, int limit,
+                                                     int longest_first) {
+  ParkingSlot **slots = NULL;
+  SlotQueryResult *result_data;
+  int count = 0;
+  int out_of_memory = 0;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  if (limit <= 0 || (size_t)limit > lot->entry_order.count) {
+    limit = (int)lot->entry_order.count;
+  }
+  if (limit > 0) {
+    slots = alloc_slot_array(limit);
+    if (slots) {
+      count = get_slots_by_entry_order(lot, slots, limit, longest_first);
+    } else {
+      out_of_memory = 1;
+    }
+  }
+  parking_lot_read_unlock(lot);
+  if (out_of_memory) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+
+  result_data =
+      (SlotQueryResult *)alloc_result_payload(sizeof(SlotQueryResult));
+  if (!result_data) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data->slot_list = slots;
+  result_data->total_found = count;
+
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               "获取停车时长排行列表成功", result_data);
+}
+
+/**
+ * @brief parking_service_get_slots_by_duration 的公共入口。
+ * @details 调用 unmetered_get_slots_by_duration 并记录服务指标。
+ */
+ServiceResult parking_service_get_slots_by_duration(ParkingLot *lot, int limit,
+                                                    int longest_first) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result =
+      unmetered_get_slots_by_duration(lot, limit, longest_first);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 获取停车时长最长的前 k 辆车。
+ * @details 在读锁内从入场时间链表最早一端读取 k 项，结果写入调用者的数组。
+ * @param lot 目标停车场。
+ * @param k 最多返回的车辆数。
+ * @param[out] out 调用者提供的数组。
+ * @param[out] found 接收实际写入的项数。
+ * @return 返回一个 ServiceResult 结构，其 data 字段始终为 NULL。
+ */
+static ServiceResult unmetered_get_longest_parked(ParkingLot *lot, int k,
+                                                  ParkedVehicle *out,
+                                                  int *found) {
+  if (!found) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  *found = 0;
+  if (!lot || !out || k <= 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  *found = get_longest_parked(lot, k, out);
+  parking_lot_read_unlock(lot);
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", NULL);
+}
+
+/**
+ * @brief parking_service_get_longest_parked 的公共入口。
+ * @details 调用 unmetered_get_longest_parked 并记录服务指标。
+ */
+ServiceResult parking_service_get_longest_parked(ParkingLot *lot, int k,
+                                                 ParkedVehicle *out,
+                                                 int *found) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_longest_parked(lot, k, out, found);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 按月费到期时间获取居民车位。
+ * @details 在读锁内按登记在堆中的车位数分配数组，再由 get_slots_by_due_date
+ *          按到期时间顺序填充。
+ * @param lot 目标停车场。
+ * @param from 到期时间下界（含）。
+ * @param to 到期时间上界（不含），小于等于 0 表示不设上界。
+ * @param limit 最多返回的车位数，小于等于 0 表示不限。
+ * @return 返回一个 ServiceResult 结构，其 data 字段指向 SlotQueryResult。
+ */
+static ServiceResult unmetered_get_slots_by_due_date(ParkingLot *lot,
+                                                     time_t from, time_t to,
+                                                     int limit) {
+  ParkingSlot **slots = NULL;
+  SlotQueryResult *result_data;
+  int capacity;
+  int count = 0;
+  int out_of_memory = 0;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  capacity = count_due_slots(lot);
+  if (limit > 0 && limit < capacity) {
+    capacity = limit;
+  }
+  if (capacity > 0) {
+    slots = alloc_slot_array(capacity);
+    count = slots ? get_slots_by_due_date(lot, from, to, slots, capacity) : -3;
+    if (count < 0) {
+      out_of_memory = 1;
+    }
+  }
+  parking_lot_read_unlock(lot);
+  if (out_of_memory) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+
+  result_data =
+      (SlotQueryResult *)alloc_result_payload(sizeof(SlotQueryResult));
+  if (!result_data) {
+    pool_release(slots, 0);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  result_data->slot_list = slots;
+  result_data->total_found = count;
+
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               "获取月费到期列表成功", result_data);
+}
+
+/**
+ * @brief parking_service_get_slots_by_due_date 的公共入口。
+ * @details 调用 unmetered_get_slots_by_due_date 并记录服务指标。
+ */
+ServiceResult parking_service_get_slots_by_due_date(ParkingLot *lot,
+                                                    time_t from, time_t to,
+                                                    int limit) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_slots_by_due_date(lot, from, to, limit);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LIST_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 按筛选条件逐个访问车位，不分配任何内存。
+ * @details 直接转调数据层的 parking_lot_foreach，结果消息中给出访问的车位数。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件。
+ * @param visitor 回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+ServiceResult parking_service_foreach_slot(ParkingLot *lot, SlotFilter filter,
+                                           SlotVisitor visitor, void *ctx) {
+  char message[64];
+  int visited;
+
+  if (!lot || !visitor || filter < SLOT_FILTER_ALL ||
+      filter > SLOT_FILTER_OCCUPIED) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  visited = parking_lot_foreach(lot, filter, visitor, ctx);
+  parking_lot_read_unlock(lot);
+  sprintf(message, "遍历完成，共访问 %d 个车位", visited);
+  return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
+}
+
+/**
+ * @brief 获取停车场的统计信息。
+ * @details 计数器与收入均为原子字段，本函数不获取任何锁，
+ *          可与入场、出场并发频繁调用；各字段分别读取，彼此间可能相差
+ *          一次正在进行的状态变化。收入按当前日期和月份换算，跨周期后自动归零。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
+ * ParkingStatistics 对象。
+ */
+static ServiceResult unmetered_get_statistics(ParkingLot *lot) {
+  ParkingStatistics *stats;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  stats = (ParkingStatistics *)alloc_result_payload(sizeof(ParkingStatistics));
+  if (!stats) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  fill_statistics(lot, stats);
+
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取统计信息成功",
+                               stats);
+}
+
+/**
+ * @brief parking_service_get_statistics 的公共入口。
+ * @details 调用 unmetered_get_statistics 并记录服务指标。
+ */
+ServiceResult parking_service_get_statistics(ParkingLot *lot) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_get_statistics(lot);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_GET_STATISTICS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 获取指定月份的收费总额。
+ * @details 在读锁内读取收费台账的月度汇总。
+ * @param lot 目标停车场。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @param[out] total 接收当月收费总额（元）。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+ServiceResult parking_service_get_monthly_payment_total(ParkingLot *lot,
+                                                        int year, int month,
+                                                        double *total) {
+  if (!total) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  *total = 0.0;
+  if (!lot || month < 1 || month > 12) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  *total = get_monthly_payment_total(lot, year, month);
+  parking_lot_read_unlock(lot);
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", NULL);
+}
+
+/**
+ * @brief 读取近期收入与车流的滚动汇总。
+ * @details 在读锁内读取，日期以不使用缓存的换算求得，不修改停车场。
+ * @param lot 目标停车场。
+ * @param[out] report 接收汇总结果。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+ServiceResult parking_service_get_revenue_report(ParkingLot *lot,
+                                                 RevenueReport *report) {
+  const RevenueRollup *rollup;
+  time_t now;
+  long day;
+  long month;
+  long value;
+  int type;
+
+  if (!report) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  memset(report, 0, sizeof(*report));
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  rollup = &lot->rollup;
+  now = parking_lot_now(lot);
+  parking_calendar_convert(now, &day, &month);
+  report->hour_revenue =
+      rollup_hour_total(rollup, now, ROLLUP_REVENUE, -1) / 100.0;
+  for (type = 0; type < ROLLUP_TYPE_COUNT; type++) {
+    report->week_type_revenue[type] =
+        rollup_recent_days(rollup, day, 7, ROLLUP_REVENUE, type) / 100.0;
+    report->week_revenue += report->week_type_revenue[type];
+  }
+  report->week_entries = rollup_recent_days(rollup, day, 7, ROLLUP_ENTRIES, -1);
+  report->week_exits = rollup_recent_days(rollup, day, 7, ROLLUP_EXITS, -1);
+  if (rollup_month_peak(rollup, month, ROLLUP_REVENUE,
+                        &report->peak_revenue_hour, &value) == 0) {
+    report->peak_hour_revenue = value / 100.0;
+  }
+  rollup_month_peak(rollup, month, ROLLUP_ENTRIES, &report->peak_entry_hour,
+                    &report->peak_hour_entries);
+  parking_lot_read_unlock(lot);
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", NULL);
+}
+
+/**
+ * @brief (静态辅助函数) 在读锁内把停车场的不同车辆草图合并进 into。
+ * @param lot 目标停车场。
+ * @param period 周期。
+ * @param[in,out] into 接收合并结果的草图。
+ */
+static void merge_lot_vehicles(ParkingLot *lot, DistinctPeriod period,
+                               HyperLogLog *into) {
+  parking_lot_read_lock(lot);
+  merge_distinct_vehicles(lot, period, parking_lot_now(lot), into);
+  parking_lot_read_unlock(lot);
+}
+
+/**
+ * @brief 估计一个或多个停车场在某个周期内来过的不同车辆数。
+ * @param lots 停车场数组。
+ * @param count 停车场个数。
+ * @param period 周期。
+ * @param[out] estimate 接收估计值。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+ServiceResult parking_service_count_distinct_vehicles(ParkingLot *const *lots,
+                                                      int count,
+                                                      DistinctPeriod period,
+                                                      long *estimate) {
+  HyperLogLog merged;
+  int i;
+
+  if (!estimate) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  *estimate = 0;
+  if (!lots || count <= 0 || (unsigned int)period > DISTINCT_LAST_MONTH) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  for (i = 0; i < count; i++) {
+    if (!lots[i]) {
+      return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+    }
+  }
+
+  hll_clear(&merged);
+  for (i = 0; i < count; i++) {
+    merge_lot_vehicles(lots[i], period, &merged);
+  }
+  *estimate = (long)(hll_estimate(&merged) + 0.5);
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", NULL);
+}
+
+/**
+ * @brief 汇总一段时间内已完成的停车。
+ * @details 在读锁内扫描停车记录存储，追加与扫描互斥。
+ * @param lot 已启用停车记录存储的停车场。
+ * @param from 出场时间区间起点（含）。
+ * @param to 出场时间区间终点（不含）。
+ * @param[out] summary 接收汇总结果。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+ServiceResult parking_service_summarize_sessions(ParkingLot *lot, time_t from,
+                                                 time_t to,
+                                                 SessionSummary *summary) {
+  int data_result;
+
+  if (!lot || !summary || from > to) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  data_result = lot->history ? summarize_parking_sessions(lot, from, to, summary)
+                             : -2;
+  parking_lot_read_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", NULL);
+  case -2:
+    memset(summary, 0, sizeof(*summary));
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "未启用停车记录存储", NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "读取停车记录失败", NULL);
+  }
+}
+
+/**
+ * @brief 对月费已到期的全部居民车位批量结算。
+ * @details 在写锁内以一个日志批次完成结算，账单总额一次计入收入。
+ * @param lot 目标停车场。
+ * @param[out] summary 接收结算汇总，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+ServiceResult parking_service_run_resident_billing(
+    ParkingLot *lot, ResidentBillingSummary *summary) {
+  ResidentBillingSummary local;
+  char message[96];
+  const char *failure;
+  int journal_result;
+  time_t now;
+
+  if (summary == NULL) {
+    summary = &local;
+  }
+  memset(summary, 0, sizeof(*summary));
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  now = parking_lot_now(lot);
+  begin_parking_journal_batch(lot);
+  bill_resident_subscriptions(lot, now, tally_invoice, summary);
+  if (summary->amount_cents > 0) {
+    record_revenue(lot, RESIDENT_TYPE, summary->amount_cents, now);
+  }
+  journal_result = end_parking_journal_batch(lot);
+  if (parking_journal_failed(lot)) {
+    journal_result = -2;
+  }
+  failure = parking_ledger_failed(lot) ? LEDGER_FAILED_MESSAGE : NULL;
+  parking_lot_write_unlock(lot);
+  summary->amount = summary->amount_cents / 100.0;
+
+  if (journal_result != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 JOURNAL_FAILED_MESSAGE, NULL);
+  }
+  if (failure) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, failure, NULL);
+  }
+  sprintf(message, "月费结算完成：开出 %d 张账单，共 %.2f 元",
+          summary->invoices, summary->amount);
+  return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
+}
+
+/**
+ * @brief 闭场时为全部在场访客车辆批量出场。
+ * @details 在写锁内以一个日志批次完成清场，收费总额一次计入收入。
+ * @param lot 目标停车场。
+ * @param[out] summary 接收清场汇总，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+ServiceResult parking_service_sweep_visitors(ParkingLot *lot,
+                                             VisitorSweepSummary *summary) {
+  VisitorSweepSummary local;
+  char message[96];
+  const char *failure;
+  int journal_result;
+  time_t now;
+
+  if (summary == NULL) {
+    summary = &local;
+  }
+  memset(summary, 0, sizeof(*summary));
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  now = parking_lot_now(lot);
+  begin_parking_journal_batch(lot);
+  sweep_visitor_slots(lot, now, tally_visitor_checkout, summary);
+  if (summary->amount_cents > 0) {
+    record_revenue(lot, VISITOR_TYPE, summary->amount_cents, now);
+  }
+  journal_result = end_parking_journal_batch(lot);
+  if (parking_journal_failed(lot)) {
+    journal_result = -2;
+  }
+  failure = exit_write_failure(lot);
+  if (lot->view != NULL) {
+    refresh_read_view(lot); /* 复制失败时报表继续读上一份视图 */
+  }
+  if (lot->shm != NULL) {
+    refresh_shared_memory(lot);
+  }
+  parking_lot_write_unlock(lot);
+  summary->amount = summary->amount_cents / 100.0;
+
+  if (journal_result != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 JOURNAL_FAILED_MESSAGE, NULL);
+  }
+  if (failure) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, failure, NULL);
+  }
+  sprintf(message, "访客清场完成：释放 %d 个车位，共收费 %.2f 元",
+          summary->released, summary->amount);
+  return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
+}
+
+/* ========================================================================== */
+/*                            分区停车场服务函数实现                          */
+/* ========================================================================== */
+
+/**
+ * @brief 向分区停车场添加车位。
+ * @details 持有布局锁完成跨分区的编号唯一性检查与插入，
+ *          入场、出场不获取布局锁，因此不受影响。
+ * @param sharded 目标容器。
+ * @param zone_id 目标分区编号，负数表示按位置前缀确定。
+ * @param slot_id 新车位的ID。
+ * @param location 新车位的位置描述。
+ * @return 返回一个 ServiceResult 结构，包含操作结果。
+ */
+ServiceResult parking_service_zone_add_slot(ShardedParkingLot *sharded,
+                                            int zone_id, int slot_id,
+                                            const char *location) {
+  ServiceResult result;
+  ParkingLot *lot;
+
+  if (!sharded || !location) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  if (zone_id < 0) {
+    zone_id = sharded_lot_zone_of_location(sharded, location);
+  }
+  lot = sharded_lot_zone_lot(sharded, zone_id);
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, "分区不存在",
+                                 NULL);
+  }
+
+  parking_rwlock_write_lock(sharded->layout_lock);
+  if (sharded_lot_zone_of_slot(sharded, slot_id) >= 0) {
+    result = create_service_result(PARKING_SERVICE_SLOT_EXISTS, NULL, NULL);
+  } else {
+    result = parking_service_add_slot(lot, slot_id, location);
+  }
+  parking_rwlock_write_unlock(sharded->layout_lock);
+  return result;
+}
+
+/**
+ * @brief 为分区停车场中的指定车位分配车辆（车辆入场）。
+ * @param sharded 目标容器。
+ * @param slot_id 要分配的车位ID。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 返回一个 ServiceResult 结构，包含操作结果。
+ */
+ServiceResult parking_service_zone_allocate_slot(ShardedParkingLot *sharded,
+                                                 int slot_id,
+                                                 const char *owner_name,
+                                                 const char *license_plate,
+                                                 const char *contact,
+                                                 ParkingType type) {
+  ParkingLot *lot;
+
+  if (!sharded || !license_plate) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  lot = sharded_lot_zone_lot(sharded,
+                             sharded_lot_zone_of_slot(sharded, slot_id));
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  }
+  if (sharded_lot_zone_of_plate(sharded, license_plate) >= 0) {
+    return create_service_result(PARKING_SERVICE_LICENSE_EXISTS, NULL, NULL);
+  }
+  return parking_service_allocate_slot(lot, slot_id, owner_name, license_plate,
+                                       contact, type);
+}
+
+/**
+ * @brief 在指定分区中自动选择一个空闲车位并分配给车辆。
+ * @param sharded 目标容器。
+ * @param zone_id 分区编号。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向被分配的车位。
+ */
+ServiceResult parking_service_zone_allocate_any_slot(
+    ShardedParkingLot *sharded, int zone_id, const char *owner_name,
+    const char *license_plate, const char *contact, ParkingType type) {
+  ParkingLot *lot;
+
+  if (!sharded || !license_plate) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  lot = sharded_lot_zone_lot(sharded, zone_id);
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, "分区不存在",
+                                 NULL);
+  }
+  if (sharded_lot_zone_of_plate(sharded, license_plate) >= 0) {
+    return create_service_result(PARKING_SERVICE_LICENSE_EXISTS, NULL, NULL);
+  }
+  return parking_service_allocate_any_slot(lot, owner_name, license_plate,
+                                           contact, type);
+}
+
+/**
+ * @brief 按分配策略选择分区，再在其中自动选择空闲车位分配给车辆。
+ * @param sharded 目标容器。
+ * @param policy 分配策略。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @param[out] zone_id 接收选中的分区编号，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向被分配的车位。
+ */
+ServiceResult parking_service_zone_allocate_by_policy(
+    ShardedParkingLot *sharded, ZoneAllocationPolicy policy,
+    const char *owner_name, const char *license_plate, const char *contact,
+    ParkingType type, int *zone_id) {
+  unsigned long excluded = 0;
+  ServiceResult result;
+  int zone;
+
+  if (zone_id) {
+    *zone_id = -1;
+  }
+  if (!sharded || !license_plate ||
+      (policy != ZONE_POLICY_LEAST_OCCUPIED &&
+       policy != ZONE_POLICY_ROUND_ROBIN &&
+       policy != ZONE_POLICY_NEAREST_ENTRANCE)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  if (sharded_lot_zone_of_plate(sharded, license_plate) >= 0) {
+    return create_service_result(PARKING_SERVICE_LICENSE_EXISTS, NULL, NULL);
+  }
+
+  /* 每个分区至多尝试一次：选出后被占满的分区排除在下一次选择之外 */
+  while ((zone = sharded_lot_pick_zone(sharded, policy, excluded)) >= 0) {
+    result = parking_service_allocate_any_slot(
+        sharded_lot_zone_lot(sharded, zone), owner_name, license_plate,
+        contact, type);
+    if (result.code != PARKING_SERVICE_SLOT_NOT_FOUND) {
+      if (zone_id && result.code == PARKING_SERVICE_SUCCESS) {
+        *zone_id = zone;
+      }
+      return result;
+    }
+    excluded |= 1UL << zone;
+  }
+  return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, "没有空闲车位",
+                               NULL);
+}
+
+/**
+ * @brief 释放分区停车场中的一个车位（车辆出场），并计算费用。
+ * @param sharded 目标容器。
+ * @param slot_id 要释放的车位ID。
+ * @return 与 parking_service_deallocate_slot 相同。
+ */
+ServiceResult parking_service_zone_deallocate_slot(ShardedParkingLot *sharded,
+                                                   int slot_id) {
+  ParkingLot *lot;
+
+  if (!sharded) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  lot = sharded_lot_zone_lot(sharded,
+                             sharded_lot_zone_of_slot(sharded, slot_id));
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  }
+  return parking_service_deallocate_slot(lot, slot_id);
+}
+
+/**
+ * @brief 在所有分区中按车牌号查找停车位。
+ * @param sharded 目标容器。
+ * @param license_plate 要查找的车牌号。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向找到的
+ * ParkingSlot 对象。
+ */
+ServiceResult parking_service_zone_find_slot_by_license(
+    ShardedParkingLot *sharded, const char *license_plate) {
+  ParkingLot *lot;
+
+  if (!sharded || !validate_license_plate(license_plate)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  lot = sharded_lot_zone_lot(sharded,
+                             sharded_lot_zone_of_plate(sharded, license_plate));
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_SLOT_NOT_FOUND, NULL, NULL);
+  }
+  return parking_service_find_slot_by_license(lot, license_plate);
+}
+
+/**
+ * @brief 汇总所有分区的统计信息。
+ * @param sharded 目标容器。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向一个
+ * ParkingStatistics 对象。
+ */
+ServiceResult parking_service_zone_get_statistics(ShardedParkingLot *sharded) {
+  ParkingStatistics *stats;
+  long today_cents = 0;
+  long month_cents = 0;
+  long zone_today;
+  long zone_month;
+  int count;
+  int i;
+
+  if (!sharded) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  stats = (ParkingStatistics *)alloc_result_payload(sizeof(ParkingStatistics));
+  if (!stats) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  stats->total_slots = 0;
+  stats->occupied_slots = 0;
+
+  count = parking_atomic_load_int(&sharded->zone_count);
+  for (i = 0; i < count; i++) {
+    ParkingLot *lot = sharded->zones[i].lot;
+
+    stats->total_slots += parking_atomic_load_int(&lot->total_slots);
+    stats->occupied_slots += parking_atomic_load_int(&lot->occupied_slots);
+    read_revenue(lot, parking_lot_now(lot), &zone_today, &zone_month);
+    today_cents += zone_today;
+    month_cents += zone_month;
+  }
+
+  stats->free_slots = stats->total_slots - stats->occupied_slots;
+  stats->occupancy_rate =
+      (stats->total_slots > 0)
+          ? ((double)stats->occupied_slots / stats->total_slots) * 100.0
+          : 0.0;
+  stats->today_revenue = today_cents / 100.0;
+  stats->month_revenue = month_cents / 100.0;
+
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取统计信息成功",
+                               stats);
+}
+
+/**
+ * @brief 估计所有分区合计在某个周期内来过的不同车辆数。
+ * @details 逐个分区在该分区的读锁内合并草图。
+ * @param sharded 目标容器。
+ * @param period 周期。
+ * @param[out] estimate 接收估计值。
+ * @return 返回一个 ServiceResult 结构，data 字段为 NULL。
+ */
+ServiceResult parking_service_zone_count_distinct_vehicles(
+    ShardedParkingLot *sharded, DistinctPeriod period, long *estimate) {
+  HyperLogLog merged;
+  int count;
+  int i;
+
+  if (!estimate) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  *estimate = 0;
+  if (!sharded || (unsigned int)period > DISTINCT_LAST_MONTH) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  hll_clear(&merged);
+  count = parking_atomic_load_int(&sharded->zone_count);
+  for (i = 0; i < count; i++) {
+    merge_lot_vehicles(sharded->zones[i].lot, period, &merged);
+  }
+  *estimate = (long)(hll_estimate(&merged) + 0.5);
+  return create_service_result(PARKING_SERVICE_SUCCESS, "查询成功", NULL);
+}
+
+/* ========================================================================== */
+/*                            数据持久化服务函数实现                          */
+/* ========================================================================== */
+
+/**
+ * @brief 异步保存请求的回调与上下文，在保存完成时释放。
+ */
+typedef struct AsyncSaveJob {
+  ServiceSaveCallback callback; /**< 调用者的通知函数。 */
+  void *ctx;                    /**< 调用者的上下文指针。 */
+} AsyncSaveJob;
+
+/**
+ * @brief (静态辅助函数) 将数据层的保存结果映射为服务层结果。
+ * @param data_result parking_saver_save 的返回值。
+ * @param message 成功时的消息。
+ * @return ServiceResult 结构。
+ */
+static ServiceResult map_save_result(int data_result, const char *message) {
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
+  case -2:
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, NULL, NULL);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 取得停车场的后台保存线程，首次调用时启动。
+ * @param lot 目标停车场。
+ * @return 保存线程句柄，无法启动时返回 NULL。
+ */
+static ParkingSaver *ensure_saver(ParkingLot *lot) {
+  ParkingSaver *saver;
+
+  parking_lot_write_lock(lot);
+  if (lot->saver == NULL) {
+    lot->saver = parking_saver_start(lot);
+  }
+  saver = lot->saver;
+  parking_lot_write_unlock(lot);
+  return saver;
+}
+
+/**
+ * @brief (静态辅助函数) 后台保存完成后转调调用者的通知函数。
+ * @param filename 保存的文件名。
+ * @param data_result parking_saver_save 的返回值。
+ * @param ctx 对应的 AsyncSaveJob，在此释放。
+ */
+static void finish_async_save(const char *filename, int data_result,
+                              void *ctx) {
+  AsyncSaveJob *job = (AsyncSaveJob *)ctx;
+
+  if (job->callback) {
+    job->callback(filename, map_save_result(data_result, "数据保存成功"),
+                  job->ctx);
+  }
+  free(job);
+}
+
+/**
+ * @brief 将停车场数据保存到文件。
+ * @details 验证参数后调用 parking_saver_save 写出文本文件，保存期间入场、
+ * 出场等操作可以继续进行，文件内容是开始保存那一刻的停车场。
+ * @param lot 要保存的停车场对象。
+ * @param filename 目标文件的路径。
+ * @return 返回一个 ServiceResult 结构，指示操作是否成功。
+ */
+static ServiceResult unmetered_save_data(ParkingLot *lot,
+                                         const char *filename) {
+  if (!lot || !filename || strlen(filename) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  return map_save_result(parking_saver_save(lot, filename, 0), "数据保存成功");
+}
+
+/**
+ * @brief parking_service_save_data 的公共入口。
+ * @details 调用 unmetered_save_data 并记录服务指标。
+ */
+ServiceResult parking_service_save_data(ParkingLot *lot, const char *filename) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_save_data(lot, filename);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_SAVE_DATA, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 将停车场数据保存为二进制快照文件。
+ * @details 验证参数后以写时复制快照写出，保存期间不阻塞写者。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件的路径。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+static ServiceResult unmetered_save_snapshot(ParkingLot *lot,
+                                             const char *filename) {
+  if (!lot || !filename || strlen(filename) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  return map_save_result(parking_saver_save(lot, filename, 1), "快照保存成功");
+}
+
+/**
+ * @brief parking_service_save_snapshot 的公共入口。
+ * @details 调用 unmetered_save_snapshot 并记录服务指标。
+ */
+ServiceResult parking_service_save_snapshot(ParkingLot *lot,
+                                            const char *filename) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_save_snapshot(lot, filename);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_SAVE_SNAPSHOT, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 将停车场数据保存为各页压缩的二进制快照文件。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件的路径。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+static ServiceResult unmetered_save_compressed_snapshot(ParkingLot *lot,
+                                                        const char *filename) {
+  if (!lot || !filename || strlen(filename) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  return map_save_result(
+      parking_saver_save(lot, filename, PARKING_SAVER_COMPRESSED),
+      "压缩快照保存成功");
+}
+
+/**
+ * @brief parking_service_save_compressed_snapshot 的公共入口。
+ * @details 调用 unmetered_save_compressed_snapshot 并记入快照保存的指标。
+ */
+ServiceResult parking_service_save_compressed_snapshot(ParkingLot *lot,
+                                                       const char *filename) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_save_compressed_snapshot(lot, filename);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_SAVE_SNAPSHOT, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 写出增量检查点。
+ * @details 写锁内调用 save_parking_checkpoint；增量只含脏页，持锁时间很短。
+ * @param lot 要保存的停车场。
+ * @param base_path 完整快照的路径。
+ * @param delta_path 增量文件的路径。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+static ServiceResult unmetered_save_checkpoint(ParkingLot *lot,
+                                               const char *base_path,
+                                               const char *delta_path) {
+  int data_result;
+
+  if (!lot || !base_path || !delta_path || strlen(base_path) == 0 ||
+      strlen(delta_path) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = save_parking_checkpoint(lot, base_path, delta_path);
+  parking_lot_write_unlock(lot);
+  if (data_result == 1) {
+    return create_service_result(PARKING_SERVICE_SUCCESS,
+                                 "增量检查点保存成功", NULL);
+  }
+  return map_save_result(data_result, "完整检查点保存成功");
+}
+
+/**
+ * @brief parking_service_save_checkpoint 的公共入口。
+ * @details 调用 unmetered_save_checkpoint 并记入快照保存的指标。
+ */
+ServiceResult parking_service_save_checkpoint(ParkingLot *lot,
+                                              const char *base_path,
+                                              const char *delta_path) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result =
+      unmetered_save_checkpoint(lot, base_path, delta_path);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_SAVE_SNAPSHOT, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 把满足筛选条件的车位导出为 CSV 或 NDJSON 文件。
+ * @details 读锁内把车位流式写入临时文件，释放读锁后再落盘替换目标文件。
+ * @param lot 要导出的停车场。
+ * @param filename 目标文件的路径。
+ * @param filter 筛选条件。
+ * @param format 导出格式。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+static ServiceResult unmetered_export_slots(ParkingLot *lot,
+                                            const char *filename,
+                                            SlotFilter filter,
+                                            SlotExportFormat format) {
+  DurableFile file;
+  char message[64];
+  long exported;
+
+  if (!lot || !filename || strlen(filename) == 0 ||
+      (format != SLOT_EXPORT_CSV && format != SLOT_EXPORT_NDJSON)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  if (durable_file_open(&file, filename, "wb") != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  exported = export_parking_slots(lot, filter, format, file.stream);
+  parking_lot_read_unlock(lot);
+
+  if (exported < 0) {
+    durable_file_abort(&file);
+    return create_service_result(exported == -2 ? PARKING_SERVICE_MEMORY_ERROR
+                                                : PARKING_SERVICE_FILE_ERROR,
+                                 NULL, NULL);
+  }
+  if (durable_file_commit(&file) != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, NULL, NULL);
+  }
+  sprintf(message, "已导出 %ld 个车位", exported);
+  return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
+}
+
+/**
+ * @brief parking_service_export_slots 的公共入口。
+ * @details 调用 unmetered_export_slots 并记录服务指标。
+ */
+ServiceResult parking_service_export_slots(ParkingLot *lot,
+                                           const char *filename,
+                                           SlotFilter filter,
+                                           SlotExportFormat format) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_export_slots(lot, filename, filter, format);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_EXPORT_SLOTS, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 在后台保存停车场数据，立即返回。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @param callback 保存完成后的通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构，表示请求是否已排队。
+ */
+ServiceResult parking_service_save_data_async(ParkingLot *lot,
+                                              const char *filename,
+                                              ServiceSaveCallback callback,
+                                              void *ctx) {
+  ParkingSaver *saver;
+  AsyncSaveJob *job;
+  int data_result;
+
+  if (!lot || !filename || strlen(filename) == 0 ||
+      strlen(filename) >= PARKING_SAVER_MAX_PATH) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  saver = ensure_saver(lot);
+  if (!saver) {
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "无法启动后台保存线程", NULL);
+  }
+  job = (AsyncSaveJob *)malloc(sizeof(AsyncSaveJob));
+  if (!job) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  job->callback = callback;
+  job->ctx = ctx;
+
+  data_result =
+      parking_saver_submit(saver, filename, 0, finish_async_save, job);
+  if (data_result != 0) {
+    free(job);
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 data_result == -2 ? "已有保存请求在排队"
+                                                   : "后台保存线程正在停止",
+                                 NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "已提交后台保存",
+                               NULL);
+}
+
+/**
+ * @brief 配置后台自动保存。
+ * @param lot 目标停车场。
+ * @param filename 快照文件名，NULL 表示关闭自动保存。
+ * @param interval_seconds 时间阈值（秒），0 表示不按时间触发。
+ * @param every_mutations 修改次数阈值，0 表示不按修改次数触发。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_configure_autosave(
+    ParkingLot *lot, const char *filename, unsigned int interval_seconds,
+    unsigned long every_mutations) {
+  ParkingSaver *saver;
+
+  if (!lot || (filename && (strlen(filename) == 0 ||
+                            strlen(filename) >= PARKING_SAVER_MAX_PATH ||
+                            (interval_seconds == 0 && every_mutations == 0)))) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  saver = ensure_saver(lot);
+  if (!saver) {
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "无法启动后台保存线程", NULL);
+  }
+  parking_saver_configure_auto(saver, filename, interval_seconds,
+                               every_mutations);
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               filename ? "自动保存已启用" : "自动保存已关闭",
+                               NULL);
+}
+
+/**
+ * @brief 在后台整理车位内存池，立即返回。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构，表示整理是否已开始。
+ */
+ServiceResult parking_service_compact_slots(ParkingLot *lot) {
+  ParkingSaver *saver;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  saver = ensure_saver(lot);
+  if (!saver) {
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "无法启动后台保存线程", NULL);
+  }
+  if (parking_saver_compact(saver) != 0) {
+    return create_service_result(PARKING_SERVICE_SYSTEM_ERROR,
+                                 "后台保存线程正在停止", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               "已开始在后台整理车位内存", NULL);
+}
+
+/**
+ * @brief 为停车场启用预写日志。
+ * @details 先写出一份快照作为重放起点，随后每次修改都追加到日志文件。
+ * @param lot 目标停车场。
+ * @param snapshot_path 快照文件路径。
+ * @param journal_path 日志文件路径。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_enable_journal(ParkingLot *lot,
+                                             const char *snapshot_path,
+                                             const char *journal_path) {
+  int data_result;
+
+  if (!lot || !snapshot_path || !journal_path || strlen(snapshot_path) == 0 ||
+      strlen(journal_path) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = enable_parking_journal(lot, snapshot_path, journal_path);
+  parking_lot_write_unlock(lot);
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "启用预写日志失败", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "预写日志已启用",
+                               NULL);
+}
+
+/**
+ * @brief 将预写日志压缩进快照。
+ * @param lot 已启用日志的停车场。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+static ServiceResult unmetered_compact_journal(ParkingLot *lot) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = compact_parking_journal(lot);
+  parking_lot_write_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, "日志压缩完成",
+                                 NULL);
+  case -1:
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "未启用预写日志", NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, NULL, NULL);
+  }
+}
+
+/**
+ * @brief parking_service_compact_journal 的公共入口。
+ * @details 调用 unmetered_compact_journal 并记录服务指标。
+ */
+ServiceResult parking_service_compact_journal(ParkingLot *lot) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_compact_journal(lot);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_JOURNAL, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 配置预写日志的批量提交策略。
+ * @param lot 已启用日志的停车场。
+ * @param max_records 每批最多记录数，0 表示不按数量触发。
+ * @param window_seconds 每批最长等待秒数，0 表示不按时间触发。
+ * @param on_durable 每批落盘后的通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_configure_group_commit(
+    ParkingLot *lot, unsigned long max_records, unsigned int window_seconds,
+    JournalDurableFn on_durable, void *ctx) {
+  int data_result;
+  int journal_enabled;
+
+  if (!lot || (max_records == 0 && window_seconds == 0)) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  journal_enabled = lot->journal != NULL;
+  data_result = configure_parking_journal_batch(lot, max_records,
+                                                window_seconds, on_durable, ctx);
+  parking_lot_write_unlock(lot);
+
+  if (!journal_enabled) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "未启用预写日志", NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "批量提交策略已更新",
+                               NULL);
+}
+
+/**
+ * @brief 立即同步预写日志中尚未落盘的记录。
+ * @param lot 已启用日志的停车场。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+static ServiceResult unmetered_flush_journal(ParkingLot *lot) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = flush_parking_journal(lot);
+  parking_lot_write_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return create_service_result(PARKING_SERVICE_SUCCESS, "日志已落盘", NULL);
+  case -1:
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "未启用预写日志", NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_FILE_ERROR, NULL, NULL);
+  }
+}
+
+/**
+ * @brief parking_service_flush_journal 的公共入口。
+ * @details 调用 unmetered_flush_journal 并记录服务指标。
+ */
+ServiceResult parking_service_flush_journal(ParkingLot *lot) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_flush_journal(lot);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_JOURNAL, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 从快照和预写日志恢复停车场。
+ * @param snapshot_path 快照文件路径。
+ * @param journal_path 日志文件路径。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向新创建的
+ * ParkingLot 对象，该对象继续使用同一日志记录修改。
+ */
+static ServiceResult unmetered_load_journaled(const char *snapshot_path,
+                                              const char *journal_path) {
+  ParkingLot *lot;
+
+  if (!snapshot_path || !journal_path || strlen(snapshot_path) == 0 ||
+      strlen(journal_path) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  lot = load_parking_journaled(snapshot_path, journal_path);
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "从快照和日志恢复数据失败", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "数据恢复成功", lot);
+}
+
+/**
+ * @brief parking_service_load_journaled 的公共入口。
+ * @details 调用 unmetered_load_journaled 并记录服务指标。
+ */
+ServiceResult parking_service_load_journaled(const char *snapshot_path,
+                                             const char *journal_path) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_load_journaled(snapshot_path, journal_path);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LOAD_DATA, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 为停车场启用收费台账。
+ * @param lot 目标停车场。
+ * @param path 台账文件路径。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_enable_payment_ledger(ParkingLot *lot,
+                                                    const char *path) {
+  int data_result;
+
+  if (!lot || !path || strlen(path) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = enable_payment_ledger(lot, path);
+  parking_lot_write_unlock(lot);
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "启用收费台账失败", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "收费台账已启用",
+                               NULL);
+}
+
+/**
+ * @brief 为停车场启用停车记录存储。
+ * @param lot 目标停车场。
+ * @param prefix 列文件路径前缀。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_enable_session_history(ParkingLot *lot,
+                                                     const char *prefix) {
+  int data_result;
+
+  if (!lot || !prefix || strlen(prefix) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = enable_session_history(lot, prefix);
+  parking_lot_write_unlock(lot);
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "启用停车记录存储失败", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "停车记录存储已启用",
+                               NULL);
+}
+
+/**
+ * @brief 切换停车场的业务时间源。
+ * @param lot 目标停车场。
+ * @param mode 新的工作方式。
+ * @param start 虚拟时钟的起始时刻。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_configure_clock(ParkingLot *lot,
+                                              ParkingClockMode mode,
+                                              time_t start) {
+  int data_result;
+
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = configure_parking_clock(lot, mode, start);
+  parking_lot_write_unlock(lot);
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "时间源已切换", NULL);
+}
+
+/**
+ * @brief 为大停车场的组合查询指定并行执行的任务池。
+ * @param lot 目标停车场。
+ * @param pool 任务池，NULL 表示恢复串行查询。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_configure_parallel_queries(
+    ParkingLot *lot, ParkingTaskPool *pool) {
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  lot->query_pool = pool;
+  parking_lot_write_unlock(lot);
+  return create_service_result(PARKING_SERVICE_SUCCESS,
+                               pool ? "并行查询已启用" : "并行查询已关闭",
+                               NULL);
+}
+
+/**
+ * @brief (静态辅助函数) 把数据层发布配置的返回码转换为 ServiceResult。
+ * @details 发布成功后短暂获取写锁回收旧配置：拿到写锁即说明
+ *          此前读到旧配置的操作都已结束。
+ * @param lot 目标停车场（调用者未持有锁）。
+ * @param data_result publish_parking_config 的返回码。
+ * @return 对应的 ServiceResult 结构体。
+ */
+static ServiceResult finish_config_publish(ParkingLot *lot, int data_result) {
+  if (data_result == -2) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, "配置无效",
+                                 NULL);
+  }
+  parking_lot_write_lock(lot);
+  reclaim_parking_configs(lot);
+  parking_lot_write_unlock(lot);
+  return create_service_result(PARKING_SERVICE_SUCCESS, "配置已生效", NULL);
+}
+
+/**
+ * @brief 配置停车场的费率表。
+ * @param lot 目标停车场。
+ * @param config 费率配置，NULL 表示恢复默认费率。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_configure_tariff(ParkingLot *lot,
+                                               const TariffConfig *config) {
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return finish_config_publish(lot, configure_parking_tariff(lot, config));
+}
+
+/**
+ * @brief 发布一份新的运行时配置。
+ * @param lot 目标停车场。
+ * @param config 新配置。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_apply_config(ParkingLot *lot,
+                                           const ParkingConfig *config) {
+  if (!lot || !config) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  return finish_config_publish(lot, publish_parking_config(lot, config));
+}
+
+/**
+ * @brief 从配置文件读取并发布运行时配置。
+ * @param lot 目标停车场。
+ * @param path 配置文件路径。
+ * @param[out] error_line 出错时接收行号，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_load_config(ParkingLot *lot, const char *path,
+                                          int *error_line) {
+  ParkingConfig config;
+  int data_result;
+
+  if (error_line) {
+    *error_line = 0;
+  }
+  if (!lot || !path) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  data_result = parking_config_load(&config, path, error_line);
+  if (data_result == -4) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "无法读取配置文件", NULL);
+  }
+  if (data_result != 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 data_result == -2 ? "配置文件存在无法解析的行"
+                                                   : "配置无效",
+                                 NULL);
+  }
+  return finish_config_publish(lot, publish_parking_config(lot, &config));
+}
+
+/**
+ * @brief 复制停车场当前的运行时配置。
+ * @param lot 目标停车场。
+ * @param[out] config 接收配置副本。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_get_config(ParkingLot *lot,
+                                         ParkingConfig *config) {
+  if (!lot || !config) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  *config = *parking_lot_config(lot);
+  parking_lot_read_unlock(lot);
+  config->retired_next = NULL;
+  return create_service_result(PARKING_SERVICE_SUCCESS, "获取配置成功", NULL);
+}
+
+/**
+ * @brief (静态辅助函数) 发布建好的车牌名单并回收旧名单。
+ * @details 发布失败时释放新名单；成功后短暂获取写锁回收旧名单，
+ *          理由同 finish_config_publish。
+ * @param lot 目标停车场（调用者未持有锁）。
+ * @param kind 名单种类。
+ * @param list 新名单，NULL 表示清空。
+ * @return 对应的 ServiceResult 结构体。
+ */
+static ServiceResult finish_plate_list_publish(ParkingLot *lot,
+                                               PlateListKind kind,
+                                               PlateList *list) {
+  char message[64];
+  long count = list != NULL ? (long)list->count : 0;
+
+  if (publish_plate_list(lot, kind, list) != 0) {
+    plate_list_free(list);
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  parking_lot_write_lock(lot);
+  reclaim_plate_lists(lot);
+  parking_lot_write_unlock(lot);
+  sprintf(message, "名单已生效，共 %ld 个车牌", count);
+  return create_service_result(PARKING_SERVICE_SUCCESS, message, NULL);
+}
+
+/**
+ * @brief 从文件读取并替换停车场的某种车牌名单。
+ * @param lot 目标停车场。
+ * @param kind 名单种类。
+ * @param path 名单文件路径。
+ * @param[out] error_line 出错时接收行号，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_load_plate_list(ParkingLot *lot,
+                                              PlateListKind kind,
+                                              const char *path,
+                                              int *error_line) {
+  PlateList *list;
+  int data_result;
+
+  if (error_line) {
+    *error_line = 0;
+  }
+  if (!lot || !path || (unsigned int)kind >= PLATE_LIST_KINDS) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  data_result = plate_list_load(&lot->memory, path, &list, error_line);
+  switch (data_result) {
+  case 0:
+    break;
+  case -3:
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  case -4:
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "无法读取名单文件", NULL);
+  default:
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                 "名单文件存在无效的车牌", NULL);
+  }
+  return finish_plate_list_publish(lot, kind, list);
+}
+
+/**
+ * @brief 以给定的车牌数组替换停车场的某种车牌名单。
+ * @param lot 目标停车场。
+ * @param kind 名单种类。
+ * @param plates 车牌号数组。
+ * @param count 车牌数。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_set_plate_list(ParkingLot *lot,
+                                             PlateListKind kind,
+                                             const char *const *plates,
+                                             int count) {
+  PlateList *list;
+  int i;
+
+  if (!lot || count < 0 || (!plates && count > 0) ||
+      (unsigned int)kind >= PLATE_LIST_KINDS) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+  if (count == 0) {
+    return finish_plate_list_publish(lot, kind, NULL);
+  }
+  list = plate_list_create(&lot->memory);
+  if (list == NULL) {
+    return create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL, NULL);
+  }
+  for (i = 0; i < count; i++) {
+    int data_result = plate_list_add(list, plates[i]);
+
+    if (data_result != 0) {
+      plate_list_free(list);
+      return data_result == -2
+                 ? create_service_result(PARKING_SERVICE_MEMORY_ERROR, NULL,
+                                         NULL)
+                 : create_service_result(PARKING_SERVICE_INVALID_PARAM,
+                                         "名单中存在无效的车牌", NULL);
+    }
+  }
+  return finish_plate_list_publish(lot, kind, list);
+}
+
+/**
+ * @brief 查询车牌是否在禁止入场名单与 VIP 名单中。
+ * @param lot 目标停车场。
+ * @param plate 车牌号。
+ * @param[out] blocked 接收是否在禁止入场名单中，可以为 NULL。
+ * @param[out] vip 接收是否在 VIP 名单中，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_check_plate(ParkingLot *lot, const char *plate,
+                                          int *blocked, int *vip) {
+  int in_blocked;
+  int in_vip;
+
+  if (blocked) {
+    *blocked = 0;
+  }
+  if (vip) {
+    *vip = 0;
+  }
+  if (!lot || !plate) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_read_lock(lot);
+  in_blocked = parking_lot_plate_listed(lot, PLATE_LIST_BLOCKED, plate);
+  in_vip = parking_lot_plate_listed(lot, PLATE_LIST_VIP, plate);
+  parking_lot_read_unlock(lot);
+
+  if (blocked) {
+    *blocked = in_blocked;
+  }
+  if (vip) {
+    *vip = in_vip;
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "名单查询成功", NULL);
+}
+
+/**
+ * @brief 注册定时器事件的处理函数。
+ * @param lot 目标停车场。
+ * @param handler 处理函数，NULL 表示不再通知。
+ * @param ctx 透传给处理函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构，表示操作结果。
+ */
+ServiceResult parking_service_set_event_handler(ParkingLot *lot,
+                                                ParkingEventHandler handler,
+                                                void *ctx) {
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  set_parking_event_handler(lot, handler, ctx);
+  parking_lot_write_unlock(lot);
+  return create_service_result(PARKING_SERVICE_SUCCESS, "事件处理函数已设置",
+                               NULL);
+}
+
+/**
+ * @brief 在写锁内推进定时器。
+ * @param lot 目标停车场。
+ * @param[out] fired 接收触发的定时器数，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_run_timers(ParkingLot *lot, int *fired) {
+  int count;
+
+  if (fired) {
+    *fired = 0;
+  }
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  parking_lot_write_lock(lot);
+  count = run_parking_timers(lot);
+  parking_lot_write_unlock(lot);
+  if (fired) {
+    *fired = count;
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "定时器已推进", NULL);
+}
+
+/**
+ * @brief 从文件加载停车场数据。
+ * @details 验证参数后，调用数据层的 load_parking_data
+ * 函数执行实际的文件读取和解析。
+ * @param filename 源文件的路径。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向新创建的
+ * ParkingLot 对象。
+ */
+static ServiceResult unmetered_load_data(const char *filename) {
+  ParkingLot *lot;
+
+  if (!filename || strlen(filename) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  lot = load_parking_data(filename);
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "从文件加载数据失败", NULL);
+  }
+
+  return create_service_result(PARKING_SERVICE_SUCCESS, "数据加载成功", lot);
+}
+
+/**
+ * @brief parking_service_load_data 的公共入口。
+ * @details 调用 unmetered_load_data 并记录服务指标。
+ */
+ServiceResult parking_service_load_data(const char *filename) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_load_data(filename);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LOAD_DATA, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 把文件加载到影子停车场，再替换发布点的当前停车场。
+ * @param hub 目标发布点。
+ * @param filename 源文件的路径。
+ * @return 返回一个 ServiceResult 结构体，data 恒为 NULL。
+ */
+static ServiceResult unmetered_reload_data(LotHub *hub, const char *filename) {
+  ParkingLot *lot;
+  int rc;
+
+  if (!hub || !filename || strlen(filename) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  /* 影子停车场加载、建索引期间读者仍在当前停车场上查询 */
+  lot = load_parking_data(filename);
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "从文件加载数据失败，当前数据保持不变",
+                                 NULL);
+  }
+
+  rc = lot_hub_publish(hub, lot);
+  if (rc != 0) {
+    free_parking_lot(lot);
+    return create_service_result(rc == -2 ? PARKING_SERVICE_MEMORY_ERROR
+                                          : PARKING_SERVICE_INVALID_PARAM,
+                                 "替换停车场失败，当前数据保持不变", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "数据加载成功", NULL);
+}
+
+/**
+ * @brief parking_service_reload_data 的公共入口。
+ * @details 调用 unmetered_reload_data 并记录服务指标。
+ */
+ServiceResult parking_service_reload_data(LotHub *hub, const char *filename) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_reload_data(hub, filename);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LOAD_DATA, result.code, started);
+  return result;
+}
+
+/**
+ * @brief 从完整快照与增量文件加载停车场数据。
+ * @param base_path 完整快照的路径。
+ * @param delta_path 增量文件的路径。
+ * @return 返回一个 ServiceResult 结构。成功时，其 data 字段指向新创建的
+ * ParkingLot 对象。
+ */
+static ServiceResult unmetered_load_checkpoint(const char *base_path,
+                                               const char *delta_path) {
+  ParkingLot *lot;
+
+  if (!base_path || !delta_path || strlen(base_path) == 0 ||
+      strlen(delta_path) == 0) {
+    return create_service_result(PARKING_SERVICE_INVALID_PARAM, NULL, NULL);
+  }
+
+  lot = load_parking_checkpoint(base_path, delta_path);
+  if (!lot) {
+    return create_service_result(PARKING_SERVICE_FILE_ERROR,
+                                 "从检查点加载数据失败", NULL);
+  }
+  return create_service_result(PARKING_SERVICE_SUCCESS, "数据加载成功", lot);
+}
+
+/**
+ * @brief parking_service_load_checkpoint 的公共入口。
+ * @details 调用 unmetered_load_checkpoint 并记录服务指标。
+ */
+ServiceResult parking_service_load_checkpoint(const char *base_path,
+                                              const char *delta_path) {
+  unsigned long started = SERVICE_METRICS_START();
+  ServiceResult result = unmetered_load_checkpoint(base_path, delta_path);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_LOAD_DATA, result.code, started);
+  return result;
+}
+
+/* ========================================================================== */
+/*                            快速服务函数实现                                */
+/* ========================================================================== */
+
+/**
+ * @brief 添加一个新的停车位，只返回状态码。
+ * @param lot 目标停车场。
+ * @param slot_id 新车位的ID。
+ * @param location 新车位的位置描述。
+ * @return 操作的状态码。
+ */
+static ParkingServiceResultCode unmetered_fast_add_slot(ParkingLot *lot,
+                                                        int slot_id,
+                                                        const char *location) {
+  int data_result;
+  int journal_failed;
+
+  if (!lot || !location || !validate_slot_id(slot_id) || location[0] == '\0') {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+
+  parking_lot_write_lock(lot);
+  data_result = create_and_add_slot(lot, slot_id, location);
+  journal_failed = parking_journal_failed(lot);
+  parking_lot_write_unlock(lot);
+
+  switch (data_result) {
+  case 0:
+    return journal_failed ? PARKING_SERVICE_FILE_ERROR
+                          : PARKING_SERVICE_SUCCESS;
+  case -2:
+    return PARKING_SERVICE_SLOT_EXISTS;
+  case -3:
+    return PARKING_SERVICE_MEMORY_ERROR;
+  default:
+    return PARKING_SERVICE_SYSTEM_ERROR;
+  }
+}
+
+/**
+ * @brief parking_service_fast_add_slot 的公共入口。
+ * @details 调用 unmetered_fast_add_slot 并记录服务指标。
+ */
+ParkingServiceResultCode parking_service_fast_add_slot(ParkingLot *lot,
+                                                       int slot_id,
+                                                       const char *location) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code =
+      unmetered_fast_add_slot(lot, slot_id, location);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ADD_SLOT, code, started);
+  return code;
+}
+
+/**
+ * @brief 为指定车位分配车辆，只返回状态码。
+ * @param lot 目标停车场。
+ * @param slot_id 要分配的车位ID。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 操作的状态码。
+ */
+static ParkingServiceResultCode
+unmetered_fast_allocate_slot(ParkingLot *lot, int slot_id,
+                             const char *owner_name, const char *license_plate,
+                             const char *contact, ParkingType type) {
+  ParkingServiceResultCode code;
+
+  if (!lot || !validate_slot_id(slot_id) ||
+      !validate_entry_fields(owner_name, license_plate, contact, NULL)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+
+  parking_lot_write_lock(lot);
+  code = allocate_code(
+      allocate_slot(lot, slot_id, owner_name, license_plate, contact, type));
+  if (code == PARKING_SERVICE_SUCCESS && parking_journal_failed(lot)) {
+    code = PARKING_SERVICE_FILE_ERROR;
+  }
+  parking_lot_write_unlock(lot);
+  return code;
+}
+
+/**
+ * @brief parking_service_fast_allocate_slot 的公共入口。
+ * @details 调用 unmetered_fast_allocate_slot 并记录服务指标。
+ */
+ParkingServiceResultCode
+parking_service_fast_allocate_slot(ParkingLot *lot, int slot_id,
+                                   const char *owner_name,
+                                   const char *license_plate,
+                                   const char *contact, ParkingType type) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code =
+      unmetered_fast_allocate_slot(lot, slot_id, owner_name, license_plate,
+                                   contact, type);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ALLOCATE_SLOT, code, started);
+  return code;
+}
+
+/**
+ * @brief 自动选择空闲车位并分配给车辆，只返回状态码。
+ * @param lot 目标停车场。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @param[out] slot_id 接收被分配的车位编号，可以为 NULL；失败时写入 0。
+ * @return 操作的状态码；没有空闲车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+static ParkingServiceResultCode
+unmetered_fast_allocate_any_slot(ParkingLot *lot, const char *owner_name,
+                                 const char *license_plate, const char *contact,
+                                 ParkingType type, int *slot_id) {
+  ParkingServiceResultCode code = PARKING_SERVICE_SLOT_NOT_FOUND;
+  ParkingSlot *slot;
+  int chosen = 0;
+
+  if (slot_id) {
+    *slot_id = 0;
+  }
+  if (!lot || !validate_entry_fields(owner_name, license_plate, contact, NULL)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+
+  parking_lot_write_lock(lot);
+  slot = find_free_slot_for(lot, type, license_plate);
+  if (slot) {
+    chosen = slot->slot_id;
+    code = allocate_code(
+        allocate_slot(lot, chosen, owner_name, license_plate, contact, type));
+    if (code == PARKING_SERVICE_SUCCESS && parking_journal_failed(lot)) {
+      code = PARKING_SERVICE_FILE_ERROR;
+    }
+  }
+  parking_lot_write_unlock(lot);
+
+  if (slot_id && code == PARKING_SERVICE_SUCCESS) {
+    *slot_id = chosen;
+  }
+  return code;
+}
+
+/**
+ * @brief parking_service_fast_allocate_any_slot 的公共入口。
+ * @details 调用 unmetered_fast_allocate_any_slot 并记录服务指标。
+ */
+ParkingServiceResultCode
+parking_service_fast_allocate_any_slot(ParkingLot *lot, const char *owner_name,
+                                       const char *license_plate,
+                                       const char *contact, ParkingType type,
+                                       int *slot_id) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code =
+      unmetered_fast_allocate_any_slot(lot, owner_name, license_plate, contact,
+                                       type, slot_id);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_ALLOCATE_ANY_SLOT, code, started);
+  return code;
+}
+
+/**
+ * @brief 释放一个停车位并计算费用，只返回状态码。
+ * @param lot 目标停车场。
+ * @param slot_id 要释放的车位ID。
+ * @param[out] receipt 接收计费明细，可以为 NULL；失败时清零。
+ * @return 操作的状态码。
+ */
+static ParkingServiceResultCode
+unmetered_fast_deallocate_slot(ParkingLot *lot, int slot_id,
+                               ExitReceipt *receipt) {
+  ParkingServiceResultCode code;
+  ExitReceipt local;
+
+  if (!receipt) {
+    receipt = &local;
+  }
+  memset(receipt, 0, sizeof(*receipt));
+  if (!lot || !validate_slot_id(slot_id)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+
+  parking_lot_write_lock(lot);
+  code = release_slot_code(lot, slot_id, parking_lot_now(lot), receipt);
+  if (code == PARKING_SERVICE_SUCCESS &&
+      (parking_journal_failed(lot) || exit_write_failure(lot))) {
+    code = PARKING_SERVICE_FILE_ERROR;
+  }
+  parking_lot_write_unlock(lot);
+  return code;
+}
+
+/**
+ * @brief parking_service_fast_deallocate_slot 的公共入口。
+ * @details 调用 unmetered_fast_deallocate_slot 并记录服务指标。
+ */
+ParkingServiceResultCode
+parking_service_fast_deallocate_slot(ParkingLot *lot, int slot_id,
+                                     ExitReceipt *receipt) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code =
+      unmetered_fast_deallocate_slot(lot, slot_id, receipt);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_CHECKOUT_SLOT, code, started);
+  return code;
+}
+
+/**
+ * @brief (静态辅助函数) 把找到的车位指针写回调用者。
+ * @param slot 找到的车位。
+ * @param ctx 指向 ParkingSlot * 的指针。
+ * @return 始终返回 0。
+ */
+static int capture_slot(ParkingSlot *slot, void *ctx) {
+  *(ParkingSlot **)ctx = slot;
+  return 0;
+}
+
+/**
+ * @brief 根据车位ID查找停车位，在读锁内对其调用回调函数。
+ * @param lot 目标停车场。
+ * @param slot_id 要查找的车位ID。
+ * @param visitor 对找到的车位调用的回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 操作的状态码。
+ */
+static ParkingServiceResultCode
+unmetered_fast_visit_slot_by_id(ParkingLot *lot, int slot_id,
+                                SlotVisitor visitor, void *ctx) {
+  ParkingSlot *slot;
+
+  if (!lot || !visitor || !validate_slot_id(slot_id)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  parking_lot_read_lock(lot);
+  slot = find_slot_by_id(lot, slot_id);
+  if (slot) {
+    visitor(slot, ctx);
+  }
+  parking_lot_read_unlock(lot);
+  return slot ? PARKING_SERVICE_SUCCESS : PARKING_SERVICE_SLOT_NOT_FOUND;
+}
+
+/**
+ * @brief 根据车位ID查找停车位，只返回状态码。
+ * @param lot 目标停车场。
+ * @param slot_id 要查找的车位ID。
+ * @param[out] slot 接收找到的车位指针，未找到时写入 NULL。
+ * @return 操作的状态码。
+ */
+static ParkingServiceResultCode
+unmetered_fast_find_slot_by_id(ParkingLot *lot, int slot_id,
+                               ParkingSlot **slot) {
+  if (!slot) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  *slot = NULL;
+  return unmetered_fast_visit_slot_by_id(lot, slot_id, capture_slot, slot);
+}
+
+/**
+ * @brief parking_service_fast_find_slot_by_id 的公共入口。
+ * @details 调用 unmetered_fast_find_slot_by_id 并记录服务指标。
+ */
+ParkingServiceResultCode
+parking_service_fast_find_slot_by_id(ParkingLot *lot, int slot_id,
+                                     ParkingSlot **slot) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code =
+      unmetered_fast_find_slot_by_id(lot, slot_id, slot);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_ID, code, started);
+  return code;
+}
+
+/**
+ * @brief 根据车牌号查找停车位，在读锁内对其调用回调函数。
+ * @param lot 目标停车场。
+ * @param license_plate 要查找的车牌号。
+ * @param visitor 对找到的车位调用的回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 操作的状态码。
+ */
+static ParkingServiceResultCode
+unmetered_fast_visit_slot_by_license(ParkingLot *lot,
+                                     const char *license_plate,
+                                     SlotVisitor visitor, void *ctx) {
+  ParkingSlot *slot;
+
+  if (!lot || !visitor || !validate_license_plate(license_plate)) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  parking_lot_read_lock(lot);
+  slot = find_slot_by_license(lot, license_plate);
+  if (slot) {
+    visitor(slot, ctx);
+  }
+  parking_lot_read_unlock(lot);
+  return slot ? PARKING_SERVICE_SUCCESS : PARKING_SERVICE_SLOT_NOT_FOUND;
+}
+
+/**
+ * @brief 根据车牌号查找停车位，只返回状态码。
+ * @param lot 目标停车场。
+ * @param license_plate 要查找的车牌号。
+ * @param[out] slot 接收找到的车位指针，未找到时写入 NULL。
+ * @return 操作的状态码。
+ */
+static ParkingServiceResultCode
+unmetered_fast_find_slot_by_license(ParkingLot *lot, const char *license_plate,
+                                    ParkingSlot **slot) {
+  if (!slot) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  *slot = NULL;
+  return unmetered_fast_visit_slot_by_license(lot, license_plate,
+                                              capture_slot, slot);
+}
+
+/**
+ * @brief parking_service_fast_find_slot_by_license 的公共入口。
+ * @details 调用 unmetered_fast_find_slot_by_license 并记录服务指标。
+ */
+ParkingServiceResultCode
+parking_service_fast_find_slot_by_license(ParkingLot *lot,
+                                          const char *license_plate,
+                                          ParkingSlot **slot) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code =
+      unmetered_fast_find_slot_by_license(lot, license_plate, slot);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_LICENSE, code, started);
+  return code;
+}
+
+/**
+ * @brief parking_service_fast_visit_slot_by_id 的公共入口。
+ * @details 调用 unmetered_fast_visit_slot_by_id，按车位编号查找记录服务指标。
+ */
+ParkingServiceResultCode
+parking_service_fast_visit_slot_by_id(ParkingLot *lot, int slot_id,
+                                      SlotVisitor visitor, void *ctx) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code =
+      unmetered_fast_visit_slot_by_id(lot, slot_id, visitor, ctx);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_ID, code, started);
+  return code;
+}
+
+/**
+ * @brief parking_service_fast_visit_slot_by_license 的公共入口。
+ * @details 调用 unmetered_fast_visit_slot_by_license，按车牌查找记录服务指标。
+ */
+ParkingServiceResultCode
+parking_service_fast_visit_slot_by_license(ParkingLot *lot,
+                                           const char *license_plate,
+                                           SlotVisitor visitor, void *ctx) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code =
+      unmetered_fast_visit_slot_by_license(lot, license_plate, visitor, ctx);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_FIND_SLOT_BY_LICENSE, code, started);
+  return code;
+}
+
+/**
+ * @brief 获取停车场统计信息，写入调用者提供的结构体。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收统计信息的结构体。
+ * @return 操作的状态码。
+ */
+static ParkingServiceResultCode
+unmetered_fast_get_statistics(const ParkingLot *lot, ParkingStatistics *stats) {
+  if (!lot || !stats) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  fill_statistics(lot, stats);
+  return PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief parking_service_fast_get_statistics 的公共入口。
+ * @details 调用 unmetered_fast_get_statistics 并记录服务指标。
+ */
+ParkingServiceResultCode
+parking_service_fast_get_statistics(const ParkingLot *lot,
+                                    ParkingStatistics *stats) {
+  unsigned long started = SERVICE_METRICS_START();
+  ParkingServiceResultCode code = unmetered_fast_get_statistics(lot, stats);
+
+  SERVICE_METRICS_FINISH(SERVICE_METRIC_GET_STATISTICS, code, started);
+  return code;
+}
+
+/**
+ * @brief 获取状态码对应的可读消息。
+ * @param code 状态码。
+ * @return 指向静态消息字符串的指针，无需释放。
+ */
+const char *parking_service_code_message(ParkingServiceResultCode code) {
+  return get_error_message(code);
+}
+
+/* ========================================================================== */
+/*                              服务指标函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 读取全部服务操作的调用指标。
+ * @details 编译期关闭采集时只清零输出并把 enabled 置 0。
+ * @param[out] metrics 接收指标快照。
+ * @return 成功返回 PARKING_SERVICE_SUCCESS；metrics 为 NULL 时返回
+ *         PARKING_SERVICE_INVALID_PARAM。
+ */
+ParkingServiceResultCode parking_service_get_metrics(ServiceMetrics *metrics) {
+  int i;
+
+  if (!metrics) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  memset(metrics, 0, sizeof(*metrics));
+  metrics->enabled = PARKING_SERVICE_METRICS;
+  if (metrics->enabled) {
+    for (i = 0; i < SERVICE_METRIC_COUNT; i++) {
+      metrics_read(i, &metrics->operations[i]);
+    }
+  }
+  return PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief 清零全部服务操作的调用指标。
+ */
+void parking_service_reset_metrics(void) { metrics_reset(); }
+
+/**
+ * @brief 获取服务操作的名称。
+ * @param metric 服务操作。
+ * @return 指向静态字符串的指针；越界时返回 "unknown"。
+ */
+const char *parking_service_metric_name(ServiceMetric metric) {
+  static const char *const names[SERVICE_METRIC_COUNT] = {
+      "add_slot",
+      "allocate_slot",
+      "allocate_any_slot",
+      "checkout_slot",
+      "apply_batch",
+      "find_slot_by_id",
+      "find_slot_by_license",
+      "find_slot_by_owner",
+      "search_slots",
+      "list_slots",
+      "get_statistics",
+      "save_data",
+      "save_snapshot",
+      "load_data",
+      "journal",
+      "export_slots"};
+
+  if ((int)metric < 0 || metric >= SERVICE_METRIC_COUNT) {
+    return "unknown";
+  }
+  return names[metric];
+}
+
+#if PARKING_SERVICE_METRICS || PARKING_TRACE
+/**
+ * @brief (静态辅助函数) 记录一次服务调用的指标与追踪区间。
+ * @param metric 服务操作。
+ * @param code 调用结果。
+ * @param started SERVICE_METRICS_START 读到的开始时刻。
+ */
+static void service_call_finish(ServiceMetric metric,
+                                ParkingServiceResultCode code,
+                                unsigned long started) {
+  unsigned long elapsed = metrics_now_ns() - started;
+
+#if PARKING_SERVICE_METRICS
+  metrics_record(metric, -(int)code, elapsed);
+#else
+  (void)code;
+#endif
+#if PARKING_TRACE
+  parking_trace_complete(TRACE_CATEGORY_SERVICE,
+                         parking_service_metric_name(metric), elapsed);
+#endif
+}
+#endif
+
+/* ========================================================================== */
+/*                              内存统计函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 读取停车场按类别的内存占用。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收统计快照。
+ * @return 成功返回 PARKING_SERVICE_SUCCESS；参数为 NULL 时返回
+ *         PARKING_SERVICE_INVALID_PARAM。
+ */
+ParkingServiceResultCode
+parking_service_get_memory_stats(const ParkingLot *lot,
+                                 ParkingMemoryStats *stats) {
+  if (!lot || !stats) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  get_parking_memory_stats(lot, stats);
+  return PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief 统计已经交给调用者、尚未释放的结果数据块数。
+ * @return 未释放的数据块数。
+ */
+long parking_service_outstanding_results(void) {
+  return parking_atomic_load_long(&outstanding_payloads);
+}
+
+/**
+ * @brief 读取结果数据块池的统计。
+ * @param[out] stats 接收统计快照。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode parking_service_get_pool_stats(PoolStats *stats) {
+  if (!stats) {
+    return PARKING_SERVICE_INVALID_PARAM;
+  }
+  pool_read(stats);
+  return PARKING_SERVICE_SUCCESS;
+}
+
+/**
+ * @brief 释放结果数据块池中缓存的全部空闲块。
+ */
+void parking_service_trim_result_pool(void) { pool_trim(); }
+
 /* ========================================================================== */
 /*                                公共辅助函数实现 */
 /* ========================================================================== */
@@ -593,8 +5277,9 @@ ServiceResult parking_service_load_data(const char *filename) {
 /**
  * @brief 释放由服务层函数返回的 ServiceResult 中动态分配的内存。
  * @details
- * 特别处理了返回列表（SlotQueryResult）的情况，会先释放内部的指针数组，
- * 然后再释放整个 data 指针。
+ * 特别处理了返回列表（SlotQueryResult）的情况，会先回收内部的指针数组，
+ * 然后再回收整个 data 指针。两者都交还结果池：数组按 total_found 所在的
+ * 级别回收（不大于分配时的容量），数据块都不小于池的最小级别，按最小级别回收。
  * @param result 指向要释放内存的 ServiceResult 结构的指针。
  */
 void parking_service_free_result(ServiceResult *result) {
@@ -604,11 +5289,14 @@ void parking_service_free_result(ServiceResult *result) {
         (strstr(result->message, "列表") != NULL)) {
       SlotQueryResult *query_result = (SlotQueryResult *)result->data;
       if (query_result && query_result->slot_list) {
-        free(query_result->slot_list);
+        pool_release(query_result->slot_list,
+                     (size_t)query_result->total_found *
+                         sizeof(ParkingSlot *));
       }
     }
-    free(result->data);
+    pool_release(result->data, POOL_MIN_BLOCK_BYTES);
     result->data = NULL;
+    parking_atomic_add_long(&outstanding_payloads, -1);
   }
 }
 
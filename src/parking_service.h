@@ -2,6 +2,14 @@
 #define PARKING_SERVICE_H
 
 #include "parking_data.h"
+#include "parking_lot_hub.h"
+#include "parking_metrics.h"
+#include "parking_pool.h"
+#include "parking_query.h"
+#include "parking_shard.h"
+#include "parking_slot_export.h"
+#include "parking_slot_import.h"
+#include "parking_validate.h"
 
 /**
  * @file parking_service.h
@@ -9,7 +17,13 @@
  * @details
  * 定义了停车场管理系统的核心业务逻辑接口。
  * 服务层封装了数据层的具体操作，为UI层提供统一、简洁的调用接口。
- * 所有服务函数都返回一个 ServiceResult 结构体，用于表示操作结果和返回数据。
+ * 服务函数返回一个 ServiceResult 结构体，用于表示操作结果和返回数据；
+ * 另有一组只返回状态码的快速服务函数，供不需要消息文本的程序调用方使用。
+ *
+ * 服务函数会按需获取停车场的读锁或写锁，多个入口线程与查询线程可以
+ * 并发调用同一停车场上的服务函数：查找、列表和保存并行执行，
+ * 入场、出场等修改互斥执行。返回的车位指针在锁外使用，
+ * 若其他线程可能同时删除该车位，调用者需自行协调。
  */
 
 /**
@@ -32,7 +46,9 @@ typedef enum {
   PARKING_SERVICE_TIME_INVALID = -7,   /**< 访客入场时间不合规 */
   PARKING_SERVICE_MEMORY_ERROR = -8,   /**< 内存分配失败 */
   PARKING_SERVICE_FILE_ERROR = -9,     /**< 文件读写操作错误 */
-  PARKING_SERVICE_SYSTEM_ERROR = -10   /**< 其他系统级错误 */
+  PARKING_SERVICE_SYSTEM_ERROR = -10,  /**< 其他系统级错误 */
+  PARKING_SERVICE_PLATE_BLOCKED = -11, /**< 车牌在禁止入场名单中 */
+  PARKING_SERVICE_BUSY = -12           /**< 服务繁忙，请稍后重试 */
 } ParkingServiceResultCode;
 
 /**
@@ -51,6 +67,16 @@ typedef struct {
                                   */
 } ServiceResult;
 
+/**
+ * @brief 后台保存完成后的通知函数。
+ * @details 在后台保存线程中调用；result 中没有需要释放的数据。
+ * @param filename 保存的文件名。
+ * @param result 保存结果。
+ * @param ctx 提交保存时传入的上下文指针。
+ */
+typedef void (*ServiceSaveCallback)(const char *filename, ServiceResult result,
+                                    void *ctx);
+
 /**
  * @brief 车位列表查询的结果结构体
  * @details 当查询函数返回多个车位时，此结构体作为 ServiceResult.data 的内容。
@@ -73,6 +99,115 @@ typedef struct ParkingStatistics {
   double month_revenue;  /**< 当月总收入 */
 } ParkingStatistics;
 
+/**
+ * @brief 车辆出场的计费明细。
+ * @details 由出场接口写入调用者提供的缓冲区，不涉及堆内存分配。
+ */
+typedef struct ExitReceipt {
+  int slot_id;              /**< 出场的车位编号。 */
+  ParkingType type;         /**< 停车类型。 */
+  time_t entry_time;        /**< 入场时间。 */
+  time_t exit_time;         /**< 出场时间。 */
+  long duration_seconds;    /**< 停车时长（秒）。 */
+  int billed_hours;         /**< 访客计费小时数（不足 1 小时按 1 小时计）。 */
+  int overdue_months;       /**< 居民补缴的月数。 */
+  time_t resident_due_date; /**< 居民补缴后的月费到期时间，访客为 0。 */
+  long amount_cents;        /**< 本次应缴费用（分）。 */
+  double amount;            /**< 本次应缴费用（元），由 amount_cents 换算。 */
+} ExitReceipt;
+
+/**
+ * @brief 居民月费批量结算的汇总。
+ */
+typedef struct ResidentBillingSummary {
+  int invoices;       /**< 开出的账单数。 */
+  int periods;        /**< 各账单计费周期数之和。 */
+  long amount_cents;  /**< 账单总额（分）。 */
+  double amount;      /**< 账单总额（元），由 amount_cents 换算。 */
+} ResidentBillingSummary;
+
+/**
+ * @brief 闭场访客清场的汇总。
+ */
+typedef struct VisitorSweepSummary {
+  int released;       /**< 释放的访客车位数。 */
+  int billed_hours;   /**< 各车辆计费小时数之和。 */
+  long amount_cents;  /**< 收费总额（分）。 */
+  double amount;      /**< 收费总额（元），由 amount_cents 换算。 */
+} VisitorSweepSummary;
+
+/**
+ * @brief 由滚动汇总得到的近期收入与车流。
+ * @details 各项均读取固定数量的汇总桶，与停车记录数无关。
+ */
+typedef struct RevenueReport {
+  double hour_revenue;      /**< 当前小时的收入（元）。 */
+  double week_revenue;      /**< 最近 7 天（含今日）的收入（元）。 */
+  double week_type_revenue[ROLLUP_TYPE_COUNT]; /**< 按类型的 7 天收入。 */
+  long week_entries;        /**< 最近 7 天的入场次数。 */
+  long week_exits;          /**< 最近 7 天的出场次数。 */
+  time_t peak_revenue_hour; /**< 本月收入最高的小时，0 表示尚无。 */
+  double peak_hour_revenue; /**< 该小时的收入（元）。 */
+  time_t peak_entry_hour;   /**< 本月入场最多的小时，0 表示尚无。 */
+  long peak_hour_entries;   /**< 该小时的入场次数。 */
+} RevenueReport;
+
+/**
+ * @brief 批量处理中单个出入场事件的类型。
+ */
+typedef enum {
+  GATE_EVENT_ENTRY = 0, /**< 车辆入场 */
+  GATE_EVENT_EXIT = 1   /**< 车辆出场 */
+} GateEventKind;
+
+/**
+ * @brief 批量处理中的一个出入场事件。
+ * @details 出场事件只使用 slot_id，其余字段可以为 NULL。
+ */
+typedef struct GateEvent {
+  GateEventKind kind;        /**< 事件类型。 */
+  int slot_id;               /**< 车位编号。 */
+  const char *owner_name;    /**< 车主姓名（入场）。 */
+  const char *license_plate; /**< 车牌号（入场）。 */
+  const char *contact;       /**< 联系方式（入场）。 */
+  ParkingType type;          /**< 停车类型（入场）。 */
+} GateEvent;
+
+/**
+ * @brief 服务层采集指标的操作。
+ * @details 快速服务与对应的 ServiceResult 版本计入同一项；
+ *          分区服务委托给所在分区的服务函数，不单独计数。
+ */
+typedef enum {
+  SERVICE_METRIC_ADD_SLOT = 0,             /**< 添加车位。 */
+  SERVICE_METRIC_ALLOCATE_SLOT = 1,        /**< 指定车位入场。 */
+  SERVICE_METRIC_ALLOCATE_ANY_SLOT = 2,    /**< 自动选位入场。 */
+  SERVICE_METRIC_CHECKOUT_SLOT = 3,        /**< 出场计费。 */
+  SERVICE_METRIC_APPLY_BATCH = 4,          /**< 批量出入场。 */
+  SERVICE_METRIC_FIND_SLOT_BY_ID = 5,      /**< 按编号查找。 */
+  SERVICE_METRIC_FIND_SLOT_BY_LICENSE = 6, /**< 按车牌查找。 */
+  SERVICE_METRIC_FIND_SLOT_BY_OWNER = 7,   /**< 按车主查找。 */
+  SERVICE_METRIC_SEARCH_SLOTS = 8,         /**< 部分匹配检索。 */
+  SERVICE_METRIC_LIST_SLOTS = 9,           /**< 各类车位列表。 */
+  SERVICE_METRIC_GET_STATISTICS = 10,      /**< 统计信息。 */
+  SERVICE_METRIC_SAVE_DATA = 11,           /**< 保存文本数据。 */
+  SERVICE_METRIC_SAVE_SNAPSHOT = 12,       /**< 保存二进制快照。 */
+  SERVICE_METRIC_LOAD_DATA = 13,           /**< 加载数据（含带日志加载）。 */
+  SERVICE_METRIC_JOURNAL = 14,             /**< 日志刷盘与压缩。 */
+  SERVICE_METRIC_EXPORT_SLOTS = 15,        /**< CSV / NDJSON 导出。 */
+  SERVICE_METRIC_COUNT = 16                /**< 操作数。 */
+} ServiceMetric;
+
+/**
+ * @brief 服务层指标的一份快照。
+ * @details operations[m].outcomes[-code] 为操作 m 返回状态码 code 的次数，
+ *          latency 为按 metrics_latency_bucket 分桶的耗时直方图。
+ */
+typedef struct ServiceMetrics {
+  int enabled; /**< 编译时是否开启了指标采集（PARKING_SERVICE_METRICS）。 */
+  MetricsSnapshot operations[SERVICE_METRIC_COUNT]; /**< 各操作的指标。 */
+} ServiceMetrics;
+
 /**
  *********************************************************************************
  *                            核心业务服务API声明
@@ -80,7 +215,7 @@ typedef struct ParkingStatistics {
  */
 
 /** @name 车位管理服务 */
-///@{
+/** @{ */
 
 /**
  * @brief 添加一个新的停车位。
@@ -92,10 +227,38 @@ typedef struct ParkingStatistics {
 ServiceResult parking_service_add_slot(ParkingLot *lot, int slot_id,
                                        const char *location);
 
-///@}
+/**
+ * @brief 批量添加停车位，用于新建停车场或扩建分区。
+ * @details 整批在一次写锁内完成：编号排序一次查出批内重复和与已有车位
+ *          重复的编号，车位表与索引一次扩容到位。要么全部添加，
+ *          要么一个也不添加；失败消息指出第一个无效项或重复的编号。
+ * @param lot 目标停车场。
+ * @param slot_ids 车位编号数组。
+ * @param locations 与编号一一对应的位置描述数组。
+ * @param count 车位个数，必须为正。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_add_slots_bulk(ParkingLot *lot,
+                                             const int *slot_ids,
+                                             const char *const *locations,
+                                             int count);
+
+/**
+ * @brief 从 CSV 车位清单文件导入车位。
+ * @details 格式见 parking_slot_import.h。解析文件时不持锁，解析完成后
+ *          在写锁内一次加入全部车位；任何一行有误或编号重复时一个也不加入，
+ *          消息中给出第一个问题所在的行号。整批计为一次添加车位操作。
+ * @param lot 目标停车场。
+ * @param filename 清单文件名。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_import_slots(ParkingLot *lot,
+                                           const char *filename);
+
+/** @} */
 
 /** @name 车辆出入场服务 */
-///@{
+/** @{ */
 
 /**
  * @brief 为车辆分配一个停车位（车辆入场）。
@@ -113,19 +276,541 @@ ServiceResult parking_service_allocate_slot(ParkingLot *lot, int slot_id,
                                             const char *contact,
                                             ParkingType type);
 
+/**
+ * @brief 自动选择一个空闲车位并分配给车辆（车辆入场）。
+ * @details 通过分配池的空闲位图查找（见 find_free_slot_for），无需先获取
+ *          空闲车位列表：居民优先回到固定车位，访客不占用居民池。
+ * @param lot 目标停车场。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向被分配的 ParkingSlot 对象（无需释放）；
+ *         没有空闲车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_allocate_any_slot(ParkingLot *lot,
+                                                const char *owner_name,
+                                                const char *license_plate,
+                                                const char *contact,
+                                                ParkingType type);
+
+/**
+ * @brief 只凭车牌号为常客车辆分配车位（车辆入场）。
+ * @details 沿用车辆上一次出场时缓存的车主姓名、联系方式与停车类型，
+ *          优先分配上次所在分区的空闲车位（见 allocate_returning_vehicle）。
+ * @param lot 目标停车场。
+ * @param license_plate 车牌号。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向被分配的 ParkingSlot 对象（无需释放）；
+ *         缓存中没有该车牌或没有空闲车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult
+parking_service_allocate_returning_vehicle(ParkingLot *lot,
+                                           const char *license_plate);
+
+/**
+ * @brief 读取缓存中某辆车的资料。
+ * @param lot 目标停车场。
+ * @param license_plate 车牌号。
+ * @param[out] session 接收车辆资料。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         缓存中没有该车牌时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_find_vehicle_session(ParkingLot *lot,
+                                                   const char *license_plate,
+                                                   VehicleSession *session);
+
+/**
+ * @brief 设置车辆资料缓存的容量（默认 SESSION_CACHE_DEFAULT_CAPACITY）。
+ * @details 容量改变时丢弃已缓存的资料。
+ * @param lot 目标停车场。
+ * @param capacity 最多缓存的车牌数，0 表示不再缓存。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_configure_session_cache(ParkingLot *lot,
+                                                      int capacity);
+
+/**
+ * @brief 设置网络服务的请求去重表容量（见 parking_dedup.h），默认不去重。
+ * @details 启用后，网络服务对修改类命令按请求 id 记住结果，同一 id 的重发
+ *          直接返回第一次的结果。容量改变时丢弃已记住的请求。
+ *          须在网络服务启动之前或停止之后调用。
+ * @param lot 目标停车场。
+ * @param capacity 记住的请求数（如 REQUEST_LOG_DEFAULT_CAPACITY），
+ *                 0 表示不再去重。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_configure_request_log(ParkingLot *lot,
+                                                    int capacity);
+
+/**
+ * @brief 启用或停用供报表线程无锁读取的只读视图（见 parking_view.h）。
+ * @details 启用后，parking_service_apply_batch 与异步属主线程每执行完
+ *          一批修改就刷新视图；其余写入之后的修改要等下一次刷新才可见，
+ *          可以调用 parking_service_refresh_read_view 主动刷新。
+ *          停用时须已没有读者 attach。
+ * @param lot 目标停车场。
+ * @param enabled 非 0 表示启用，0 表示停用。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         停用时仍有读者返回 PARKING_SERVICE_SYSTEM_ERROR。
+ */
+ServiceResult parking_service_configure_read_view(ParkingLot *lot,
+                                                  int enabled);
+
+/**
+ * @brief 把停车场的当前状态发布为新的只读视图。
+ * @details 只在读锁内复制车位表，不阻塞其他读者；
+ *          自上次发布以来没有修改时不复制。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         未启用视图返回 PARKING_SERVICE_INVALID_PARAM。
+ */
+ServiceResult parking_service_refresh_read_view(ParkingLot *lot);
+
+/**
+ * @brief 启用或停用供同机其他进程读取的共享内存发布（见 parking_shm.h）。
+ * @details 启用后，发布时机与只读视图相同：parking_service_apply_batch 与
+ *          异步属主线程每执行完一批修改就发布一次；其余写入之后可以调用
+ *          parking_service_publish_shared_memory 主动发布。
+ * @param lot 目标停车场。
+ * @param path 共享内存文件的路径（如 /dev/shm/parking），NULL 表示停用。
+ * @param capacity 行数上限，0 表示取设计车位数与当前车位数中的较大者。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         无法创建或映射文件返回 PARKING_SERVICE_FILE_ERROR。
+ */
+ServiceResult parking_service_configure_shared_memory(ParkingLot *lot,
+                                                      const char *path,
+                                                      int capacity);
+
+/**
+ * @brief 把停车场的当前状态发布到共享内存。
+ * @details 只在读锁内复制热字段列；自上次发布以来没有修改时不复制。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         未启用共享内存发布返回 PARKING_SERVICE_INVALID_PARAM。
+ */
+ServiceResult parking_service_publish_shared_memory(ParkingLot *lot);
+
+/**
+ * @brief 把停车场挂接到汇总树的一个站点（见 parking_aggregate.h）。
+ * @details 挂接后该停车场的车位数、占用与收入变化在写锁内逐级同步到
+ *          区域与公司，读取任一节点的合计不再访问各停车场。
+ * @param lot 目标停车场。
+ * @param tree 汇总树，NULL 表示解除挂接。
+ * @param site 站点节点编号。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         站点已挂接其他停车场返回 PARKING_SERVICE_SYSTEM_ERROR。
+ */
+ServiceResult parking_service_attach_aggregate(ParkingLot *lot,
+                                               struct ParkingAggregate *tree,
+                                               int site);
+
+/**
+ * @brief 读取汇总树中一个节点（站点、区域或公司）的统计信息。
+ * @details 只读取该节点缓存的小计，不加任何停车场的锁。
+ * @param tree 汇总树。
+ * @param node 节点编号。
+ * @param now 读取时刻，决定当日与当月收入所属的周期。
+ * @param[out] stats 接收统计信息的结构体。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode
+parking_service_aggregate_statistics(struct ParkingAggregate *tree, int node,
+                                     time_t now, ParkingStatistics *stats);
+
+/**
+ * @brief 启用、调整或关闭按时间回溯的时间线（见 parking_timeline.h）。
+ * @details 启用后可以用 parking_service_find_slot_at 查询保留范围内任一
+ *          时刻的车位状态。重新配置时丢弃已有的历史。
+ * @param lot 目标停车场。
+ * @param segment_records 每个检查点之后最多的记录数
+ *                        （如 TIMELINE_DEFAULT_SEGMENT_RECORDS），0 表示关闭。
+ * @param max_segments 最多保留的检查点数（如 TIMELINE_DEFAULT_SEGMENTS）。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         保存线程的快照正在进行时返回 PARKING_SERVICE_SYSTEM_ERROR。
+ */
+ServiceResult parking_service_configure_timeline(ParkingLot *lot,
+                                                 int segment_records,
+                                                 int max_segments);
+
+/**
+ * @brief 查询某个车位在过去某一时刻的状态，例如当时停的是哪辆车。
+ * @details 从该时刻之前最近的检查点重建停车场并重放到该时刻，只持有读锁；
+ *          重放的记录数不超过一个分段的上限。
+ * @param lot 已启用时间线的停车场。
+ * @param slot_id 车位编号。
+ * @param when 回溯的时刻。
+ * @param[out] slot 成功时接收车位当时的状态。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         时刻早于保留的历史或当时没有该车位时返回
+ *         PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_find_slot_at(ParkingLot *lot, int slot_id,
+                                           time_t when, HistoricalSlot *slot);
+
 /**
  * @brief 释放一个停车位（车辆出场），并计算费用。
  * @param lot 目标停车场。
  * @param slot_id 要释放的车位编号。
  * @return 返回一个 ServiceResult 结构体。
  *         成功时，其 data 字段可能指向一个 double 类型的费用值，使用后需释放。
+ * @note 新代码请使用 parking_service_checkout_slot()，它不分配堆内存。
  */
 ServiceResult parking_service_deallocate_slot(ParkingLot *lot, int slot_id);
 
-///@}
+/**
+ * @brief 释放一个停车位（车辆出场），并返回计费明细。
+ * @param lot 目标停车场。
+ * @param slot_id 要释放的车位编号。
+ * @param[out] receipt 调用者提供的缓冲区，接收金额、停车时长、
+ *                     计费小时数与补缴月数；失败时清零。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_checkout_slot(ParkingLot *lot, int slot_id,
+                                            ExitReceipt *receipt);
+
+/**
+ * @brief 报出一辆在场车辆在某一时刻出场应缴的费用（只读）。
+ * @details 供缴费机反复轮询：与出场使用同一套计费逻辑与当前费率表，
+ *          但不计入收入、不顺延居民月费、不释放车位；只持有读锁，
+ *          不阻塞其他读者。quote.resident_due_date 是补缴后的到期时间。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号，0 表示按车牌查找。
+ * @param license_plate slot_id 为 0 时的车牌号，否则忽略。
+ * @param when 假定的出场时间，0 表示业务时钟的当前时间。
+ * @param[out] quote 调用者提供的缓冲区，接收计费明细；失败时清零。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         车位不存在或车牌不在场返回 PARKING_SERVICE_SLOT_NOT_FOUND，
+ *         车位空闲返回 PARKING_SERVICE_SLOT_FREE。
+ */
+ServiceResult parking_service_quote_exit(ParkingLot *lot, int slot_id,
+                                         const char *license_plate,
+                                         time_t when, ExitReceipt *quote);
+
+/**
+ * @brief 批量处理一组出入场事件。
+ * @details 适用于入口控制器断线重连后集中补报事件的场景：
+ *          先在锁外逐条校验参数，再按车位编号稳定排序（同一车位的事件保持原顺序），
+ *          最后在一次写锁内依次执行，全部日志记录只同步一次。
+ *          每个事件的结果只写入状态码，不生成消息文本。
+ * @param lot 目标停车场。
+ * @param events 事件数组。
+ * @param count 事件个数。
+ * @param[out] results 与 events 等长的数组，接收每个事件的状态码。
+ * @return 返回一个 ServiceResult 结构体，消息中给出成功与失败的条数；
+ *         日志同步失败时返回 PARKING_SERVICE_FILE_ERROR（内存中的修改保留）。
+ */
+ServiceResult parking_service_apply_batch(ParkingLot *lot,
+                                          const GateEvent *events, int count,
+                                          ParkingServiceResultCode *results);
+
+/**
+ * @brief 校验一组出入场事件的参数，不访问停车场。
+ * @details 规则与 parking_service_apply_batch 执行前的校验相同，
+ *          每个字段只扫描一遍；适合在排队补报前先筛掉格式错误的事件。
+ * @param events 事件数组。
+ * @param count 事件个数。
+ * @param[out] issues 与 events 等长的数组，接收每个事件第一个失败的字段与原因，
+ *                    可以为 NULL（只统计个数）。
+ * @return 校验失败的事件个数；参数无效（count 为负或数组为 NULL）返回 -1。
+ */
+int parking_service_validate_batch(const GateEvent *events, int count,
+                                   ValidationIssue *issues);
+
+/** @} */
+
+/** @name 车位预约服务 */
+/** @{ */
+
+/**
+ * @brief 为车牌预约一个车位的一段时间。
+ * @details 预约开始前 RESERVATION_HOLD_LEAD_SECONDS 秒起到结束为止，
+ *          其他车辆不能占用该车位，自动选位也会跳过它；
+ *          预约的车辆入场即兑现预约。预约只保存在内存中。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param license_plate 预约的车牌号。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含），必须晚于 start 与当前时间。
+ * @param[out] reservation 接收新预约（含预约编号），可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         该时段已被预约或车位正被占用时返回 PARKING_SERVICE_SLOT_OCCUPIED。
+ */
+ServiceResult parking_service_reserve_slot(ParkingLot *lot, int slot_id,
+                                           const char *license_plate,
+                                           time_t start, time_t end,
+                                           Reservation *reservation);
+
+/**
+ * @brief 在一个分区内预约任意一个该时段空闲的车位。
+ * @param lot 目标停车场。
+ * @param zone 位置描述前缀（如 "C-"），NULL 或空串表示整个停车场。
+ * @param license_plate 预约的车牌号。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含），必须晚于 start 与当前时间。
+ * @param[out] reservation 接收新预约（含选中的车位编号），可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         分区内没有可用车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_reserve_zone(ParkingLot *lot, const char *zone,
+                                           const char *license_plate,
+                                           time_t start, time_t end,
+                                           Reservation *reservation);
+
+/**
+ * @brief 取消一条预约。
+ * @param lot 目标停车场。
+ * @param slot_id 预约的车位编号。
+ * @param reservation_id 预约编号。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         预约不存在（或已兑现、已结束）时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_cancel_reservation(ParkingLot *lot, int slot_id,
+                                                 long reservation_id);
+
+/**
+ * @brief 查询分区在某时段内还有没有可预约的车位。
+ * @details 只检查分区内的车位，每个车位查一次自己的预约，
+ *          不遍历整个停车场的预约。
+ * @param lot 目标停车场。
+ * @param zone 位置描述前缀，NULL 或空串表示整个停车场。
+ * @param start 开始时间（含）。
+ * @param end 结束时间（不含）。
+ * @param[out] slot_id 接收第一个可用车位的编号，没有时写入 0；可以为 NULL。
+ * @param[out] available 接收可用车位数，可以为 NULL（此时找到一个即停止）。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         没有可用车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_check_availability(ParkingLot *lot,
+                                                 const char *zone,
+                                                 time_t start, time_t end,
+                                                 int *slot_id, int *available);
+
+/** @} */
+
+/** @name 分配池与固定车位服务 */
+/** @{ */
+
+/**
+ * @brief 把车位划入居民专用池、访客专用池或共享池。
+ * @details 自动选位（parking_service_allocate_any_slot 等）时访客只取访客池
+ *          与共享池，访客再多也占不到居民池；指定车位入场时专用池的车位
+ *          拒绝其他类型的车辆。分配池只保存在内存中。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param pool 分配池。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         车位不存在时返回 PARKING_SERVICE_SLOT_NOT_FOUND，车位是固定车位
+ *         而 pool 不是居民池时返回 PARKING_SERVICE_SLOT_OCCUPIED。
+ */
+ServiceResult parking_service_set_slot_pool(ParkingLot *lot, int slot_id,
+                                            SlotPool pool);
+
+/**
+ * @brief 为居民车牌登记固定车位。
+ * @details 固定车位只接纳登记的车牌，该车辆自动选位时优先回到固定车位。
+ *          只保存在内存中。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @param slot_id 车位编号。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         车位不存在时返回 PARKING_SERVICE_SLOT_NOT_FOUND，车位已是其他车牌的
+ *         固定车位或正被其他车辆占用时返回 PARKING_SERVICE_SLOT_OCCUPIED。
+ */
+ServiceResult parking_service_assign_home_slot(ParkingLot *lot,
+                                               const char *license_plate,
+                                               int slot_id);
+
+/**
+ * @brief 撤销居民车牌的固定车位，车位留在居民池。
+ * @param lot 目标停车场。
+ * @param license_plate 居民车牌号。
+ * @param[out] slot_id 接收原固定车位的编号，未登记时写入 0；可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         车牌没有固定车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_release_home_slot(ParkingLot *lot,
+                                                const char *license_plate,
+                                                int *slot_id);
+
+/** @} */
+
+/** @name 车位引导服务 */
+/** @{ */
+
+/**
+ * @brief 登记或修改车位的平面坐标。
+ * @details 坐标单位由使用者约定（例如分米），只保存在内存中，
+ *          通常在启动时按车库平面图登记。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_set_slot_position(ParkingLot *lot, int slot_id,
+                                                long x, long y);
+
+/**
+ * @brief 登记或修改一个命名地标（入口、电梯等）的坐标。
+ * @param lot 目标停车场。
+ * @param name 地标名称。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_set_landmark(ParkingLot *lot, const char *name,
+                                           long x, long y);
+
+/**
+ * @brief 查找离某一点最近的空闲车位（只考虑登记了坐标的车位）。
+ * @details 坐标有变化时先在写锁内重建空间索引，查找本身只持有读锁。
+ * @param lot 目标停车场。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @param[out] slot_id 接收车位编号，没有时写入 0。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         没有空闲车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_find_nearest_free_slot(ParkingLot *lot, long x,
+                                                     long y, int *slot_id);
+
+/**
+ * @brief 查找离命名地标最近的空闲车位。
+ * @param lot 目标停车场。
+ * @param landmark 地标名称。
+ * @param[out] slot_id 接收车位编号，没有时写入 0。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         地标不存在时返回 PARKING_SERVICE_INVALID_PARAM，
+ *         没有空闲车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_find_nearest_free_slot_to(ParkingLot *lot,
+                                                        const char *landmark,
+                                                        int *slot_id);
+
+/** @} */
+
+/** @name 分区空位服务 */
+/** @{ */
+
+/**
+ * @brief 登记一个分区（按位置前缀划分），此后增量维护其空位计数。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀（如 "B1-"）。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_add_zone(ParkingLot *lot, const char *prefix);
+
+/**
+ * @brief 撤销一个分区。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         分区未登记时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_remove_zone(ParkingLot *lot, const char *prefix);
+
+/**
+ * @brief 读取一个分区的车位总数、空闲数与占用数。
+ * @details 计数由数据层随入场、出场增量维护，本函数只查表，不遍历车位，
+ *          适合引导屏频繁刷新。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀。
+ * @param[out] stats 接收分区计数。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         分区未登记时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_get_zone_stats(ParkingLot *lot,
+                                             const char *prefix,
+                                             ParkingZoneStats *stats);
+
+/**
+ * @brief 按登记顺序读取全部分区的计数。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收分区计数的数组。
+ * @param max 数组容量，分区更多时只写入前 max 个。
+ * @param[out] count 接收已登记的分区数，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_list_zone_stats(ParkingLot *lot,
+                                              ParkingZoneStats *stats, int max,
+                                              int *count);
+
+/**
+ * @brief 读取一个分区（或整个停车场）15、30、60 分钟后的预测占用数，
+ *        供引导屏与动态定价使用。
+ * @details 预测依据按星期几与刻钟划分的占用画像，画像与预测缓存只在
+ *          刻钟切换时更新；本函数在读锁内只做一次乘加，不扫描车位。
+ *          画像还没有历史数据时预测值等于当前占用数。
+ * @param lot 目标停车场。
+ * @param prefix 分区的位置前缀，NULL 或空串表示整个停车场。
+ * @param[out] forecast 接收预测结果。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放；
+ *         分区未登记时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_get_occupancy_forecast(ParkingLot *lot,
+                                                     const char *prefix,
+                                                     ParkingForecast *forecast);
+
+/**
+ * @brief 注册分区计数变化的处理函数，引导屏可随每次变化刷新而不必轮询。
+ * @details 处理函数在引起变化的服务层函数持有写锁期间调用，
+ *          不能再调用本模块中会加锁的函数。
+ * @param lot 目标停车场。
+ * @param handler 处理函数，NULL 表示不再通知。
+ * @param ctx 透传给处理函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_set_zone_handler(ParkingLot *lot,
+                                               ParkingZoneHandler handler,
+                                               void *ctx);
+
+/** @} */
+
+/** @name 变更订阅服务 */
+/** @{ */
+
+/**
+ * @brief 订阅车位变更，此后每次入场、出场、增删车位与修改信息都产生一条事件。
+ * @details 每个订阅者有自己的环形队列，由 parking_service_poll_changes
+ *          在订阅者自己的线程中无锁取出；队列满时新事件被丢弃并计数。
+ * @param lot 目标停车场。
+ * @param capacity 队列至少能容纳的事件数，0 表示默认容量。
+ * @param[out] subscription 接收订阅者句柄。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_subscribe_changes(
+    ParkingLot *lot, size_t capacity,
+    struct ChangeSubscription **subscription);
+
+/**
+ * @brief 撤销订阅并释放其队列；调用前须停止对该订阅者取事件。
+ * @param lot 目标停车场。
+ * @param subscription 订阅者句柄。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_unsubscribe_changes(
+    ParkingLot *lot, struct ChangeSubscription *subscription);
+
+/**
+ * @brief 取出订阅者队列中的事件，不加停车场的锁。
+ * @param subscription 订阅者句柄。
+ * @param[out] changes 接收事件的数组。
+ * @param max 数组容量。
+ * @param[out] count 接收取出的事件数。
+ * @param[out] dropped 接收上次调用以来因队列满丢弃的事件数，可以为 NULL；
+ *             大于 0 时应重新读取一次完整列表。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_poll_changes(
+    struct ChangeSubscription *subscription, ParkingChange *changes, int max,
+    int *count, int *dropped);
+
+/** @} */
 
 /** @name 查询服务 */
-///@{
+/** @{ */
 
 /**
  * @brief 根据车位编号查找停车位。
@@ -136,6 +821,34 @@ ServiceResult parking_service_deallocate_slot(ParkingLot *lot, int slot_id);
  */
 ServiceResult parking_service_find_slot_by_id(ParkingLot *lot, int slot_id);
 
+/**
+ * @brief 取车位的带代号句柄。
+ * @details data 字段中的 ParkingSlot 指针在车位被删除或停车场被替换后即悬空；
+ *          句柄则可以长期保存、跨线程传递，失效时能被识别出来。
+ * @param lot 目标停车场。
+ * @param slot_id 车位编号。
+ * @param[out] handle 接收句柄。
+ * @return 返回一个 ServiceResult 结构体，data 字段为 NULL。
+ */
+ServiceResult parking_service_get_slot_handle(ParkingLot *lot, int slot_id,
+                                              SlotHandle *handle);
+
+/**
+ * @brief 在读锁内把句柄指向的车位交给回调函数。
+ * @details 回调期间车位不会被修改或删除；回调不得保存车位指针，
+ *          也不得调用会加锁的服务层函数。
+ * @param lot 目标停车场。
+ * @param handle 由 parking_service_get_slot_handle 取得的句柄。
+ * @param visitor 回调函数，返回值被忽略。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构体，data 字段为 NULL；
+ *         句柄已失效时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_visit_slot_handle(ParkingLot *lot,
+                                                SlotHandle handle,
+                                                SlotVisitor visitor,
+                                                void *ctx);
+
 /**
  * @brief 根据车牌号查找停车位。
  * @param lot 目标停车场。
@@ -156,10 +869,25 @@ ServiceResult parking_service_find_slot_by_license(ParkingLot *lot,
 ServiceResult parking_service_find_slot_by_owner(ParkingLot *lot,
                                                  const char *owner_name);
 
-///@}
+/**
+ * @brief 按车牌号或车主姓名的部分内容检索全部在场车辆。
+ * @details 例如以 "粤B12" 检索所有车牌中含有该子串的车辆。
+ *          查询串不少于三个字节时走三元组索引，不扫描全部车位。
+ * @param lot 目标停车场。
+ * @param field 检索的字段（车牌号或车主姓名）。
+ * @param query 要查找的子串，不能为空串。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向一个 SlotQueryResult 结构体（可能为空列表），
+ *         使用后需释放。
+ */
+ServiceResult parking_service_search_slots(ParkingLot *lot,
+                                           SlotSearchField field,
+                                           const char *query);
+
+/** @} */
 
 /** @name 列表查询服务 */
-///@{
+/** @{ */
 
 /**
  * @brief 获取所有空闲车位的列表。
@@ -185,48 +913,922 @@ ServiceResult parking_service_get_occupied_slots(ParkingLot *lot);
  */
 ServiceResult parking_service_get_all_slots(ParkingLot *lot);
 
-///@}
-
-/** @name 统计分析服务 */
-///@{
+/**
+ * @brief 分页获取满足筛选条件的车位列表。
+ * @details 直接定位到第 offset 个匹配车位，只复制一页，不遍历整个停车场。
+ *          两次调用之间若有车位增删，页与页之间可能重复或遗漏车位。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件（全部/空闲/已占用）。
+ * @param offset 跳过的匹配车位数，不能为负数。
+ * @param limit 每页最多返回的车位数，必须大于 0。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向一个 SlotQueryResult 结构体，使用后需释放；
+ *         offset 超出范围时返回空列表。
+ */
+ServiceResult parking_service_get_slots_page(ParkingLot *lot, SlotFilter filter,
+                                             int offset, int limit);
 
 /**
- * @brief 获取停车场的整体统计信息。
+ * @brief 从续读标记处继续获取车位列表。
+ * @details 标记是稠密车位表中的行号，续读时不需要重新数过前面的车位。
+ *          首次调用时传入 0；返回后标记更新为下一页的起点，遍历结束时置为 -1。
+ *          两次调用之间若有车位被删除，行号会因表尾车位填补空位而失效，
+ *          可能重复或遗漏车位；入场、出场不影响标记。
  * @param lot 目标停车场。
+ * @param filter 筛选条件（全部/空闲/已占用）。
+ * @param[in,out] token 续读标记，不能为 NULL；为 -1 时返回空列表。
+ * @param limit 每页最多返回的车位数，必须大于 0。
  * @return 返回一个 ServiceResult 结构体。
- *         成功时，其 data 字段指向一个 ParkingStatistics 结构体，使用后需释放。
+ *         成功时，其 data 字段指向一个 SlotQueryResult 结构体，使用后需释放。
  */
-ServiceResult parking_service_get_statistics(ParkingLot *lot);
+ServiceResult parking_service_get_slots_after(ParkingLot *lot,
+                                              SlotFilter filter, int *token,
+                                              int limit);
 
-///@}
+/**
+ * @brief 按组合条件查询车位列表。
+ * @details 条件见 parking_query.h（状态、类型、位置前缀、入场与到期时间区间），
+ *          在读锁内按列求值，不必先取出全部已占用车位再在调用方筛选；
+ *          例如“B 区上午 10 点前入场的访客车位”。
+ * @param lot 目标停车场。
+ * @param query 查询条件，不能为 NULL。
+ * @param limit 最多返回的车位数，小于等于 0 表示不限。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向一个 SlotQueryResult 结构体，使用后需释放。
+ */
+ServiceResult parking_service_query_slots(ParkingLot *lot,
+                                          const SlotQuery *query, int limit);
 
 /**
- *********************************************************************************
- *                            数据持久化服务API声明
- *********************************************************************************
+ * @brief 统计满足组合条件的车位数。
+ * @details 在读锁内调用 count_query_slots，不分配内存；
+ *          不带位置条件时只扫描热字段列。
+ * @param lot 目标停车场。
+ * @param query 查询条件。
+ * @param[out] count 接收命中的车位数。
+ * @return 操作的状态码；任一参数为 NULL 时返回 PARKING_SERVICE_INVALID_PARAM。
  */
+ParkingServiceResultCode parking_service_count_slots(ParkingLot *lot,
+                                                     const SlotQuery *query,
+                                                     int *count);
 
-/** @name 数据持久化服务 */
-///@{
+/**
+ * @brief 获取停车时长排行（停得最久或最近入场的前若干辆车）。
+ * @details 直接读取数据层维护的入场时间链表，只复制前 limit 个车位，不排序。
+ * @param lot 目标停车场。
+ * @param limit 最多返回的车位数，小于等于 0 表示返回全部在场车位。
+ * @param longest_first 非 0 时按停车时长从长到短，否则从短到长。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向一个 SlotQueryResult 结构体，使用后需释放。
+ */
+ServiceResult parking_service_get_slots_by_duration(ParkingLot *lot, int limit,
+                                                    int longest_first);
 
 /**
- * @brief 将停车场数据保存到文件。
- * @param lot 要保存的停车场。
- * @param filename 目标文件名。
- * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ * @brief 获取停车时长最长的前 k 辆车（例如巡查用的前 20 名）。
+ * @param lot 目标停车场。
+ * @param k 最多返回的车辆数。
+ * @param[out] out 调用者提供的数组，至少能容纳 k 项，接收车位与停车时长。
+ * @param[out] found 接收实际写入的项数，不能为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
  */
-ServiceResult parking_service_save_data(ParkingLot *lot, const char *filename);
+ServiceResult parking_service_get_longest_parked(ParkingLot *lot, int k,
+                                                 ParkedVehicle *out,
+                                                 int *found);
 
 /**
- * @brief 从文件加载停车场数据。
- * @param filename 源文件名。
+ * @brief 按月费到期时间从早到晚获取居民车位（例如每日的逾期居民清单）。
+ * @details 读取数据层维护的月费到期最小堆，不逐个车位比较到期时间：
+ *          “截至 T 已逾期的全部居民”传 from = 0、to = T；
+ *          “从现在起最近的 N 个到期日”传 from = 当前时间、to = 0、limit = N。
+ * @param lot 目标停车场。
+ * @param from 到期时间下界（含）。
+ * @param to 到期时间上界（不含），小于等于 0 表示不设上界。
+ * @param limit 最多返回的车位数，小于等于 0 表示不限。
  * @return 返回一个 ServiceResult 结构体。
- *         成功时，其 data 字段指向新创建的 ParkingLot 对象，
- *         调用者负责在后续操作中管理其生命周期，并在程序结束时释放。
+ *         成功时，其 data 字段指向一个 SlotQueryResult 结构体，使用后需释放。
  */
-ServiceResult parking_service_load_data(const char *filename);
+ServiceResult parking_service_get_slots_by_due_date(ParkingLot *lot,
+                                                    time_t from, time_t to,
+                                                    int limit);
+
+/**
+ * @brief 按筛选条件逐个访问车位，不分配任何内存。
+ * @details 适用于需要频繁刷新列表的场景，替代获取数组再释放的列表查询。
+ *          回调返回非 0 时提前停止；回调中不得增删车位。
+ * @param lot 目标停车场。
+ * @param filter 筛选条件（全部/空闲/已占用）。
+ * @param visitor 对每个匹配车位调用的回调函数。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构体，data 字段始终为 NULL。
+ */
+ServiceResult parking_service_foreach_slot(ParkingLot *lot, SlotFilter filter,
+                                           SlotVisitor visitor, void *ctx);
+
+/** @} */
+
+/** @name 统计分析服务 */
+/** @{ */
+
+/**
+ * @brief 获取停车场的整体统计信息。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向一个 ParkingStatistics 结构体，使用后需释放。
+ */
+ServiceResult parking_service_get_statistics(ParkingLot *lot);
+
+/**
+ * @brief 获取指定月份的收费总额。
+ * @details 读取收费台账的月度汇总，未启用台账时总额为 0。
+ * @param lot 目标停车场。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @param[out] total 接收当月收费总额（元），不能为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_get_monthly_payment_total(ParkingLot *lot,
+                                                        int year, int month,
+                                                        double *total);
+
+/**
+ * @brief 读取近期收入与车流的滚动汇总。
+ * @details 当日与当月收入在周期切换时清零，滚动汇总则保留最近 7 天的小时桶
+ *          与最近约一个季度的日桶，出场与月费结算时以 O(1) 更新；
+ *          本函数在读锁内以业务时钟的当前时刻读取固定数量的桶。
+ * @param lot 目标停车场。
+ * @param[out] report 接收汇总结果，不能为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_get_revenue_report(ParkingLot *lot,
+                                                 RevenueReport *report);
+
+/**
+ * @brief 估计一个或多个停车场在某个周期内来过的不同车辆数。
+ * @details 各停车场入场时把车牌计入当周与当月的 HyperLogLog 草图（每个
+ *          草图 4KB，每次入场 O(1)），本函数逐个在读锁内合并草图后估计，
+ *          同一辆车去过多个停车场只计一次；相对误差约 1.6%。
+ *          “本周”“本月”以各停车场业务时钟的当前时刻为准。
+ * @param lots 停车场数组。
+ * @param count 停车场个数（大于 0）。
+ * @param period 周期。
+ * @param[out] estimate 接收不同车辆数的估计值，不能为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_count_distinct_vehicles(ParkingLot *const *lots,
+                                                      int count,
+                                                      DistinctPeriod period,
+                                                      long *estimate);
+
+/**
+ * @brief 汇总出场时间落在 [from, to) 内的已完成停车。
+ * @details 只读取所需的列，并跳过与区间不相交的记录区块。
+ * @param lot 已启用停车记录存储的停车场。
+ * @param from 区间起点（含）。
+ * @param to 区间终点（不含）。
+ * @param[out] summary 接收停车次数、费用与时长合计。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_summarize_sessions(ParkingLot *lot, time_t from,
+                                                 time_t to,
+                                                 SessionSummary *summary);
+
+/**
+ * @brief 对月费已到期的全部居民车位批量结算。
+ * @details 以业务时钟的当前时刻为结算时刻，在一次写锁内为到期的居民车位
+ *          开出账单（在场与否都结算），到期时间按自然月顺延到当前时刻之后；
+ *          账单金额计入当日与当月收入，启用收费台账时批量写入台账。
+ *          适合在每月的计费日或每天的日切之后调用一次；已结算的周期
+ *          在车辆出场时不再重复收取。
+ * @param lot 目标停车场。
+ * @param[out] summary 接收结算汇总，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         结算已生效但日志或台账写入失败时返回 PARKING_SERVICE_FILE_ERROR。
+ */
+ServiceResult parking_service_run_resident_billing(
+    ParkingLot *lot, ResidentBillingSummary *summary);
+
+/**
+ * @brief 闭场时为全部在场访客车辆批量出场。
+ * @details 访客只在 VISITOR_END_HOUR 之前入场，闭场时剩下的访客不必逐个
+ *          调用 parking_service_checkout_slot：在一次写锁内按热字段列找出
+ *          全部在场访客，按块计费、批量写入收费台账后一并释放车位
+ *          （见 sweep_visitor_slots），收费总额一次计入当日与当月收入，
+ *          全部日志记录只同步一次。每辆车的计费与单独出场相同，
+ *          出场时间取业务时钟的当前时刻。
+ * @param lot 目标停车场。
+ * @param[out] summary 接收清场汇总，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         清场已生效但日志、台账或停车记录写入失败时返回
+ *         PARKING_SERVICE_FILE_ERROR。
+ */
+ServiceResult parking_service_sweep_visitors(ParkingLot *lot,
+                                             VisitorSweepSummary *summary);
+
+/** @} */
+
+/** @name 分区停车场服务 */
+/** @{ */
+
+/**
+ * @brief 向分区停车场添加车位。
+ * @details 车位编号在所有分区中唯一。
+ * @param sharded 目标容器。
+ * @param zone_id 目标分区编号；传入负数时按位置描述的前缀确定分区。
+ * @param slot_id 要添加的车位编号。
+ * @param location 车位的位置描述。
+ * @return 返回一个 ServiceResult 结构体；分区不存在时返回
+ *         PARKING_SERVICE_INVALID_PARAM，编号已在任一分区存在时返回
+ *         PARKING_SERVICE_SLOT_EXISTS。
+ */
+ServiceResult parking_service_zone_add_slot(ShardedParkingLot *sharded,
+                                            int zone_id, int slot_id,
+                                            const char *location);
+
+/**
+ * @brief 为分区停车场中的指定车位分配车辆（车辆入场）。
+ * @details 只锁定车位所在的分区。跨分区的车牌唯一性在入场前检查，
+ *          不同分区的两个入口同时放行同一车牌时无法完全排除。
+ * @param sharded 目标容器。
+ * @param slot_id 要分配的车位编号。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_zone_allocate_slot(ShardedParkingLot *sharded,
+                                                 int slot_id,
+                                                 const char *owner_name,
+                                                 const char *license_plate,
+                                                 const char *contact,
+                                                 ParkingType type);
+
+/**
+ * @brief 在指定分区中自动选择一个空闲车位并分配给车辆。
+ * @param sharded 目标容器。
+ * @param zone_id 分区编号。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向被分配的 ParkingSlot 对象（无需释放）。
+ */
+ServiceResult parking_service_zone_allocate_any_slot(
+    ShardedParkingLot *sharded, int zone_id, const char *owner_name,
+    const char *license_plate, const char *contact, ParkingType type);
+
+/**
+ * @brief 按分配策略选择分区，再在其中自动选择空闲车位分配给车辆。
+ * @details 分区由 sharded_lot_pick_zone 按各分区的计数器选出，分区内的
+ *          车位由空闲车位位图给出，都不需要列出空闲车位；选中的分区
+ *          恰好被并发入场占满（或空位都为其他车牌保留）时换下一个分区。
+ * @param sharded 目标容器。
+ * @param policy 分配策略。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @param[out] zone_id 接收选中的分区编号，可以为 NULL；失败时写入 -1。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向被分配的 ParkingSlot 对象（无需释放）；
+ *         所有分区都没有可用车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ServiceResult parking_service_zone_allocate_by_policy(
+    ShardedParkingLot *sharded, ZoneAllocationPolicy policy,
+    const char *owner_name, const char *license_plate, const char *contact,
+    ParkingType type, int *zone_id);
+
+/**
+ * @brief 释放分区停车场中的一个车位（车辆出场），并计算费用。
+ * @param sharded 目标容器。
+ * @param slot_id 要释放的车位编号。
+ * @return 与 parking_service_deallocate_slot 相同。
+ */
+ServiceResult parking_service_zone_deallocate_slot(ShardedParkingLot *sharded,
+                                                   int slot_id);
+
+/**
+ * @brief 在所有分区中按车牌号查找停车位。
+ * @param sharded 目标容器。
+ * @param license_plate 要查找的车牌号。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向找到的 ParkingSlot 对象（无需释放）。
+ */
+ServiceResult parking_service_zone_find_slot_by_license(
+    ShardedParkingLot *sharded, const char *license_plate);
+
+/**
+ * @brief 汇总所有分区的统计信息。
+ * @details 逐个分区无锁读取计数器与收入后相加。
+ * @param sharded 目标容器。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向一个 ParkingStatistics 结构体，使用后需释放。
+ */
+ServiceResult parking_service_zone_get_statistics(ShardedParkingLot *sharded);
+
+/**
+ * @brief 估计所有分区合计在某个周期内来过的不同车辆数。
+ * @details 合并各分区的草图后估计，同一辆车先后停在不同分区只计一次。
+ * @param sharded 目标容器。
+ * @param period 周期。
+ * @param[out] estimate 接收不同车辆数的估计值，不能为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL，无需释放。
+ */
+ServiceResult parking_service_zone_count_distinct_vehicles(
+    ShardedParkingLot *sharded, DistinctPeriod period, long *estimate);
+
+/** @} */
+
+/**
+ *********************************************************************************
+ *                            数据持久化服务API声明
+ *********************************************************************************
+ */
+
+/** @name 数据持久化服务 */
+/** @{ */
+
+/**
+ * @brief 将停车场数据保存到文件。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_save_data(ParkingLot *lot, const char *filename);
+
+/**
+ * @brief 将停车场数据保存为二进制快照文件。
+ * @details 快照可由 parking_service_load_data 直接加载（自动识别格式），
+ *          适合大规模停车场的快速重启；文本格式仍可用于导出和人工查看。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_save_snapshot(ParkingLot *lot,
+                                            const char *filename);
+
+/**
+ * @brief 将停车场数据保存为各页压缩的二进制快照文件。
+ * @details 格式见 save_parking_snapshot_compressed，体积通常只有未压缩快照的
+ *          几分之一，适合定期传到异地备份；parking_service_load_data 同样可以
+ *          直接加载。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_save_compressed_snapshot(ParkingLot *lot,
+                                                       const char *filename);
+
+/**
+ * @brief 写出增量检查点，只保存自上次完整检查点以来修改过的页。
+ * @details 格式与规则见 save_parking_checkpoint：脏页不多时只写 delta_path，
+ *          否则把完整快照写到 base_path 并删除 delta_path。
+ *          成功时消息注明写出的是完整检查点还是增量。
+ * @param lot 要保存的停车场。
+ * @param base_path 完整快照的路径。
+ * @param delta_path 增量文件的路径。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_save_checkpoint(ParkingLot *lot,
+                                              const char *base_path,
+                                              const char *delta_path);
+
+/**
+ * @brief 把满足筛选条件的车位导出为 CSV 或 NDJSON 文件。
+ * @details 格式见 parking_slot_export.h。导出期间持有读锁；
+ *          先写临时文件，成功后才替换目标文件。
+ * @param lot 要导出的停车场。
+ * @param filename 目标文件名。
+ * @param filter 筛选条件。
+ * @param format 导出格式。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_export_slots(ParkingLot *lot,
+                                           const char *filename,
+                                           SlotFilter filter,
+                                           SlotExportFormat format);
+
+/**
+ * @brief 在后台保存停车场数据，立即返回。
+ * @details 首次调用时为停车场启动后台保存线程（随停车场一起停止）。
+ *          文件格式与 parking_service_save_data 相同，内容是保存线程
+ *          开始保存那一刻的停车场。保存线程正在保存时还可以再排队一个请求，
+ *          已有请求在排队时返回 PARKING_SERVICE_SYSTEM_ERROR，可稍后重试。
+ * @param lot 要保存的停车场。
+ * @param filename 目标文件名。
+ * @param callback 保存完成后的通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构体，表示请求是否已排队。
+ */
+ServiceResult parking_service_save_data_async(ParkingLot *lot,
+                                              const char *filename,
+                                              ServiceSaveCallback callback,
+                                              void *ctx);
+
+/**
+ * @brief 配置后台自动保存。
+ * @details 距上次自动保存达到 interval_seconds 秒（期间有修改），或修改次数
+ *          达到 every_mutations 时，由后台保存线程写出二进制快照；
+ *          入场、出场等操作不会因此等待。
+ * @param lot 目标停车场。
+ * @param filename 快照文件名，NULL 表示关闭自动保存。
+ * @param interval_seconds 时间阈值（秒），0 表示不按时间触发。
+ * @param every_mutations 修改次数阈值，0 表示不按修改次数触发。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_configure_autosave(
+    ParkingLot *lot, const char *filename, unsigned int interval_seconds,
+    unsigned long every_mutations);
+
+/**
+ * @brief 在后台整理车位内存池，立即返回。
+ * @details 大批删除车位后调用：后台保存线程分步把稀疏区块中的车位迁走并
+ *          释放这些区块，每步只短暂持有写锁，入场、出场不会明显变慢。
+ *          整理期间车位节点的地址可能改变，需要长期引用车位时应使用
+ *          parking_service_get_slot_handle 取得的句柄。
+ * @param lot 目标停车场。
+ * @return 返回一个 ServiceResult 结构体，表示整理是否已开始。
+ */
+ServiceResult parking_service_compact_slots(ParkingLot *lot);
+
+/**
+ * @brief 从文件加载停车场数据。
+ * @param filename 源文件名。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向新创建的 ParkingLot 对象，
+ *         调用者负责在后续操作中管理其生命周期，并在程序结束时释放。
+ */
+ServiceResult parking_service_load_data(const char *filename);
+
+/**
+ * @brief 从完整快照与增量文件加载停车场数据。
+ * @details 见 load_parking_checkpoint；增量文件不存在时只加载完整快照。
+ * @param base_path 完整快照的路径。
+ * @param delta_path 增量文件的路径。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向新创建的 ParkingLot 对象，调用者负责释放。
+ */
+ServiceResult parking_service_load_checkpoint(const char *base_path,
+                                              const char *delta_path);
+
+/**
+ * @brief 把文件加载到影子停车场，完整建好后替换发布点的当前停车场。
+ * @details 加载与建索引期间不持有任何锁，已钉住或之后钉住的读者照常在
+ *          当前停车场上查询；加载成功后才原子替换，旧停车场在所有读者
+ *          解除钉住之后释放（见 parking_lot_hub.h）。加载失败时当前停车场
+ *          保持不变。调用者须是该发布点唯一的发布者。
+ * @param hub 目标发布点。
+ * @param filename 源文件名。
+ * @return 返回一个 ServiceResult 结构体，data 恒为 NULL；
+ *         新停车场通过 lot_hub_pin 或 lot_hub_current 取得。
+ */
+ServiceResult parking_service_reload_data(LotHub *hub, const char *filename);
+
+/**
+ * @brief 为停车场启用预写日志。
+ * @details 启用时先写出快照，之后的增删车位、入场、出场都会追加到日志，
+ *          进程意外退出后可通过 parking_service_load_journaled 恢复。
+ *          日志写入失败时相应操作仍生效，但返回 PARKING_SERVICE_FILE_ERROR。
+ * @param lot 目标停车场。
+ * @param snapshot_path 快照文件路径。
+ * @param journal_path 日志文件路径。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_enable_journal(ParkingLot *lot,
+                                             const char *snapshot_path,
+                                             const char *journal_path);
+
+/**
+ * @brief 将预写日志压缩进快照，并清空日志文件。
+ * @param lot 已启用日志的停车场。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_compact_journal(ParkingLot *lot);
+
+/**
+ * @brief 配置预写日志的批量提交（group commit）策略。
+ * @details 高峰期多次入场、出场的日志记录合并为一次磁盘同步：
+ *          累计 max_records 条或等待超过 window_seconds 秒时同步一批，
+ *          并以序号区间调用 on_durable。批次未落盘时，入场与出场结果的
+ *          消息会注明对应的日志序号。
+ * @param lot 已启用日志的停车场。
+ * @param max_records 每批最多记录数，0 表示不按数量触发。
+ * @param window_seconds 每批最长等待秒数，0 表示不按时间触发。
+ * @param on_durable 每批落盘后的通知函数，可以为 NULL。
+ * @param ctx 透传给通知函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_configure_group_commit(
+    ParkingLot *lot, unsigned long max_records, unsigned int window_seconds,
+    JournalDurableFn on_durable, void *ctx);
+
+/**
+ * @brief 立即同步预写日志中尚未落盘的记录。
+ * @param lot 已启用日志的停车场。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_flush_journal(ParkingLot *lot);
+
+/**
+ * @brief 从快照和预写日志恢复停车场。
+ * @param snapshot_path 快照文件路径。
+ * @param journal_path 日志文件路径。
+ * @return 返回一个 ServiceResult 结构体。
+ *         成功时，其 data 字段指向新创建的 ParkingLot 对象，
+ *         该对象已重新启用同一日志，调用者负责释放。
+ */
+ServiceResult parking_service_load_journaled(const char *snapshot_path,
+                                             const char *journal_path);
+
+/**
+ * @brief 为停车场启用收费台账。
+ * @details 打开（必要时创建）台账文件，此后每笔出场收费都追加一条记录，
+ *          并用于 parking_service_get_monthly_payment_total 的月度汇总。
+ *          台账写入失败时出场仍生效，但返回 PARKING_SERVICE_FILE_ERROR。
+ * @param lot 目标停车场。
+ * @param path 台账文件路径。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_enable_payment_ledger(ParkingLot *lot,
+                                                    const char *path);
+
+/**
+ * @brief 为停车场启用停车记录存储。
+ * @details 打开（必要时创建）以 prefix 为前缀的一组列文件，此后每次出场
+ *          都追加一条已完成停车的记录，供 parking_service_summarize_sessions
+ *          等报表查询使用。写入失败时出场仍生效，但返回 PARKING_SERVICE_FILE_ERROR。
+ * @param lot 目标停车场。
+ * @param prefix 列文件路径前缀。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_enable_session_history(ParkingLot *lot,
+                                                     const char *prefix);
+
+/**
+ * @brief 为大停车场的组合查询指定并行执行的任务池。
+ * @details 之后 parking_service_query_slots 与 parking_service_count_slots
+ *          在车位数达到 PARKING_QUERY_PARALLEL_MIN_ROWS 时把车位表分段
+ *          交给任务池并行扫描，结果与串行执行逐项相同。
+ *          统计信息与停车时长排行由增量维护的计数器和入场时间链表给出，
+ *          本身不扫描车位表，不受此设置影响。
+ *          任务池须比停车场存活得久，或在销毁前先以 NULL 关闭；
+ *          不能在该任务池的任务中调用并行查询。
+ * @param lot 目标停车场。
+ * @param pool 任务池，NULL 表示恢复串行查询。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_configure_parallel_queries(
+    ParkingLot *lot, ParkingTaskPool *pool);
+
+/**
+ * @brief 切换停车场的业务时间源。
+ * @details 缓存时钟由调用者的事件循环每轮调用 tick_parking_clock 刷新；
+ *          虚拟时钟由 set_parking_clock / advance_parking_clock 推进，
+ *          用于回放与模拟。两者的刷新都是原子写入，无需加锁。
+ * @param lot 目标停车场。
+ * @param mode 新的工作方式。
+ * @param start 虚拟时钟的起始时刻，其他方式忽略。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_configure_clock(ParkingLot *lot,
+                                              ParkingClockMode mode,
+                                              time_t start);
+
+/**
+ * @brief 配置停车场的费率表。
+ * @details 以当前运行时配置为基础只替换费率表，发布方式同
+ *          parking_service_apply_config，只影响之后的出场计费。
+ * @param lot 目标停车场。
+ * @param config 费率配置，NULL 表示恢复默认费率。
+ * @return 返回一个 ServiceResult 结构体；配置无效时返回
+ *         PARKING_SERVICE_INVALID_PARAM，原费率表不变。
+ */
+ServiceResult parking_service_configure_tariff(ParkingLot *lot,
+                                               const TariffConfig *config);
+
+/**
+ * @brief 发布一份新的运行时配置（访客时段与费率表）。
+ * @details 新配置整体原子替换旧配置，发布本身不获取停车场的读写锁，
+ *          正在进行的入场、出场不会被阻塞，每次操作使用同一份配置完成；
+ *          发布后短暂获取写锁，等此前的操作结束再释放旧配置。
+ *          不能在事件处理函数等已持有停车场锁的上下文中调用。
+ * @param lot 目标停车场。
+ * @param config 新配置，函数内部复制。
+ * @return 返回一个 ServiceResult 结构体；配置无效时返回
+ *         PARKING_SERVICE_INVALID_PARAM，内存不足时返回
+ *         PARKING_SERVICE_MEMORY_ERROR，原配置不变。
+ */
+ServiceResult parking_service_apply_config(ParkingLot *lot,
+                                           const ParkingConfig *config);
+
+/**
+ * @brief 从配置文件读取运行时配置并发布。
+ * @details 文件格式见 parking_config.h，未出现的键取默认值。
+ * @param lot 目标停车场。
+ * @param path 配置文件路径。
+ * @param[out] error_line 某一行无法解析时接收行号（1 起），可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体；文件无法读取时返回
+ *         PARKING_SERVICE_FILE_ERROR，内容无效时返回
+ *         PARKING_SERVICE_INVALID_PARAM，原配置不变。
+ */
+ServiceResult parking_service_load_config(ParkingLot *lot, const char *path,
+                                          int *error_line);
+
+/**
+ * @brief 复制停车场当前的运行时配置。
+ * @param lot 目标停车场。
+ * @param[out] config 接收配置副本，可修改后交给 parking_service_apply_config。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_get_config(ParkingLot *lot,
+                                         ParkingConfig *config);
+
+/**
+ * @brief 从文件读取并替换停车场的某种车牌名单（禁止入场名单或 VIP 名单）。
+ * @details 名单在锁外读取并建好布隆过滤器与哈希表，再以一次指针交换
+ *          整体替换旧名单，读取几十万条名单期间入场与出场照常进行；
+ *          替换后只短暂获取写锁回收旧名单。之后的每次入场都检查名单：
+ *          禁止入场名单中的车牌返回 PARKING_SERVICE_PLATE_BLOCKED，
+ *          VIP 名单中的访客车辆不受访客入场时段限制。
+ *          名单只保存在内存中，不写入快照与日志。
+ * @param lot 目标停车场。
+ * @param kind 名单种类。
+ * @param path 名单文件路径，每行一个车牌号，`#` 开头的行与空行忽略。
+ * @param[out] error_line 某一行无效时接收行号（1 起），可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体；文件无法读取时返回
+ *         PARKING_SERVICE_FILE_ERROR，内容无效时返回
+ *         PARKING_SERVICE_INVALID_PARAM，原名单不变。
+ */
+ServiceResult parking_service_load_plate_list(ParkingLot *lot,
+                                              PlateListKind kind,
+                                              const char *path,
+                                              int *error_line);
+
+/**
+ * @brief 以给定的车牌数组替换停车场的某种车牌名单。
+ * @details 替换方式同 parking_service_load_plate_list；count 为 0 时清空名单。
+ * @param lot 目标停车场。
+ * @param kind 名单种类。
+ * @param plates 车牌号数组，count 为 0 时可以为 NULL。
+ * @param count 车牌数。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL；
+ *         有无效车牌时返回 PARKING_SERVICE_INVALID_PARAM，原名单不变。
+ */
+ServiceResult parking_service_set_plate_list(ParkingLot *lot,
+                                             PlateListKind kind,
+                                             const char *const *plates,
+                                             int count);
+
+/**
+ * @brief 查询车牌是否在禁止入场名单与 VIP 名单中，供道闸提前提示。
+ * @param lot 目标停车场。
+ * @param plate 车牌号。
+ * @param[out] blocked 在禁止入场名单中时接收 1，否则接收 0，可以为 NULL。
+ * @param[out] vip 在 VIP 名单中时接收 1，否则接收 0，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_check_plate(ParkingLot *lot, const char *plate,
+                                          int *blocked, int *vip);
+
+/**
+ * @brief 注册定时器事件（访客超时、月费到期、日切）的处理函数。
+ * @details 处理函数在 parking_service_run_timers 持有写锁期间调用，
+ *          不能再调用本模块中会加锁的函数。
+ * @param lot 目标停车场。
+ * @param handler 处理函数，NULL 表示不再通知。
+ * @param ctx 透传给处理函数的上下文指针。
+ * @return 返回一个 ServiceResult 结构体，表示操作结果。
+ */
+ServiceResult parking_service_set_event_handler(ParkingLot *lot,
+                                                ParkingEventHandler handler,
+                                                void *ctx);
+
+/**
+ * @brief 把定时器推进到业务时间的当前时刻，触发其间到期的事件。
+ * @details 事件循环每轮在刷新时钟后调用一次；每个事件 O(1)，不扫描车位。
+ * @param lot 目标停车场。
+ * @param[out] fired 接收触发的定时器数，可以为 NULL。
+ * @return 返回一个 ServiceResult 结构体，其 data 字段始终为 NULL。
+ */
+ServiceResult parking_service_run_timers(ParkingLot *lot, int *fired);
+
+/** @} */
+
+/**
+ *********************************************************************************
+ *                                快速服务API声明
+ *********************************************************************************
+ */
+
+/**
+ * @name 快速服务
+ * @details 面向程序调用方（闸机控制器、批处理任务等）的并行接口：
+ *          只返回状态码，输出通过指针参数写回，不格式化消息文本，
+ *          也不为返回值分配堆内存。加锁与校验规则与对应的 ServiceResult
+ *          版本相同。需要展示给用户时再调用 parking_service_code_message()。
+ */
+/** @{ */
+
+/**
+ * @brief 添加一个新的停车位。
+ * @param lot 目标停车场。
+ * @param slot_id 要添加的车位编号。
+ * @param location 车位的位置描述。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode parking_service_fast_add_slot(ParkingLot *lot,
+                                                       int slot_id,
+                                                       const char *location);
+
+/**
+ * @brief 为车辆分配指定的停车位（车辆入场）。
+ * @param lot 目标停车场。
+ * @param slot_id 要分配的车位编号。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @return 操作的状态码；修改已生效但日志写入失败时返回
+ *         PARKING_SERVICE_FILE_ERROR。
+ */
+ParkingServiceResultCode
+parking_service_fast_allocate_slot(ParkingLot *lot, int slot_id,
+                                   const char *owner_name,
+                                   const char *license_plate,
+                                   const char *contact, ParkingType type);
+
+/**
+ * @brief 自动选择一个空闲车位并分配给车辆（车辆入场）。
+ * @param lot 目标停车场。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param type 停车类型 (居民/访客)。
+ * @param[out] slot_id 接收被分配的车位编号，可以为 NULL；失败时写入 0。
+ * @return 操作的状态码；没有空闲车位时返回 PARKING_SERVICE_SLOT_NOT_FOUND。
+ */
+ParkingServiceResultCode parking_service_fast_allocate_any_slot(
+    ParkingLot *lot, const char *owner_name, const char *license_plate,
+    const char *contact, ParkingType type, int *slot_id);
+
+/**
+ * @brief 释放一个停车位（车辆出场），并计算费用。
+ * @param lot 目标停车场。
+ * @param slot_id 要释放的车位编号。
+ * @param[out] receipt 接收计费明细，可以为 NULL；失败时清零。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode
+parking_service_fast_deallocate_slot(ParkingLot *lot, int slot_id,
+                                     ExitReceipt *receipt);
+
+/**
+ * @brief 根据车位编号查找停车位。
+ * @param lot 目标停车场。
+ * @param slot_id 要查找的车位编号。
+ * @param[out] slot 接收找到的车位指针（无需释放），未找到时写入 NULL。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode parking_service_fast_find_slot_by_id(
+    ParkingLot *lot, int slot_id, ParkingSlot **slot);
+
+/**
+ * @brief 根据车牌号查找停车位。
+ * @param lot 目标停车场。
+ * @param license_plate 要查找的车牌号。
+ * @param[out] slot 接收找到的车位指针（无需释放），未找到时写入 NULL。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode parking_service_fast_find_slot_by_license(
+    ParkingLot *lot, const char *license_plate, ParkingSlot **slot);
+
+/**
+ * @brief 根据车位编号查找停车位，并在同一次读锁内对其调用回调函数。
+ * @details 需要读取车位内容（如按网络协议序列化）时使用：查找与读取在
+ *          同一次加锁内完成，不必先取指针再加锁重新查找。
+ *          回调的返回值被忽略；回调中不得修改停车场或再获取它的锁。
+ * @param lot 目标停车场。
+ * @param slot_id 要查找的车位编号。
+ * @param visitor 对找到的车位调用的回调函数，未找到时不调用。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode parking_service_fast_visit_slot_by_id(
+    ParkingLot *lot, int slot_id, SlotVisitor visitor, void *ctx);
+
+/**
+ * @brief 根据车牌号查找停车位，并在同一次读锁内对其调用回调函数。
+ * @details 规则同 parking_service_fast_visit_slot_by_id。
+ * @param lot 目标停车场。
+ * @param license_plate 要查找的车牌号。
+ * @param visitor 对找到的车位调用的回调函数，未找到时不调用。
+ * @param ctx 透传给回调函数的上下文指针。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode parking_service_fast_visit_slot_by_license(
+    ParkingLot *lot, const char *license_plate, SlotVisitor visitor,
+    void *ctx);
+
+/**
+ * @brief 获取停车场的统计信息（不加锁）。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收统计信息的结构体，由调用者提供。
+ * @return 操作的状态码。
+ */
+ParkingServiceResultCode
+parking_service_fast_get_statistics(const ParkingLot *lot,
+                                    ParkingStatistics *stats);
+
+/**
+ * @brief 获取状态码对应的默认可读消息。
+ * @param code 状态码。
+ * @return 指向静态消息字符串的指针，无需释放。
+ */
+const char *parking_service_code_message(ParkingServiceResultCode code);
+
+/** @} */
+
+/**
+ *********************************************************************************
+ *                                服务指标API声明
+ *********************************************************************************
+ */
+
+/** @name 服务指标 */
+/** @{ */
+
+/**
+ * @brief 读取服务层的调用计数、状态码计数与延迟直方图。
+ * @details 指标在进程内全局累计，与停车场无关；读取时合并各线程分片，
+ *          不阻塞正在进行的服务调用。未开启采集时 enabled 为 0，其余全部为 0。
+ * @param[out] metrics 接收快照，由调用者提供。
+ * @return 操作的状态码；metrics 为 NULL 时返回 PARKING_SERVICE_INVALID_PARAM。
+ */
+ParkingServiceResultCode parking_service_get_metrics(ServiceMetrics *metrics);
+
+/**
+ * @brief 清零服务层指标。
+ */
+void parking_service_reset_metrics(void);
+
+/**
+ * @brief 获取指标操作的名称，如 "allocate_slot"。
+ * @param metric 指标操作。
+ * @return 指向静态字符串的指针；越界时返回 "unknown"。
+ */
+const char *parking_service_metric_name(ServiceMetric metric);
+
+/** @} */
+
+/**
+ *********************************************************************************
+ *                                内存统计API声明
+ *********************************************************************************
+ */
+
+/** @name 内存统计 */
+/** @{ */
+
+/**
+ * @brief 读取停车场按类别的内存占用。
+ * @details 只读取原子计数，不获取停车场的锁；类别见 ParkingMemoryCategory。
+ * @param lot 目标停车场。
+ * @param[out] stats 接收统计快照，由调用者提供。
+ * @return 操作的状态码；lot 或 stats 为 NULL 时返回
+ *         PARKING_SERVICE_INVALID_PARAM。
+ */
+ParkingServiceResultCode
+parking_service_get_memory_stats(const ParkingLot *lot,
+                                 ParkingMemoryStats *stats);
+
+/**
+ * @brief 统计已经交给调用者、尚未释放的结果数据块数。
+ * @details 车位列表、统计信息与出场费用等需要释放的 ServiceResult.data
+ *          分配时加一，经 parking_service_free_result 释放时减一，
+ *          用于在测试或长期运行中发现漏掉的释放。直接 free() 的数据块不会减一。
+ *          计数在进程内全局累计。
+ * @return 未释放的数据块数。
+ */
+long parking_service_outstanding_results(void);
+
+/**
+ * @brief 读取结果数据块池的统计。
+ * @details 车位列表、统计信息与出场费用的数据块以及车位指针数组分配自
+ *          parking_pool.h 的分级空闲链表，由 parking_service_free_result 回收。
+ * @param[out] stats 接收统计快照，由调用者提供。
+ * @return 操作的状态码；stats 为 NULL 时返回 PARKING_SERVICE_INVALID_PARAM。
+ */
+ParkingServiceResultCode parking_service_get_pool_stats(PoolStats *stats);
+
+/**
+ * @brief 释放结果数据块池中缓存的全部空闲块。
+ * @details 用于峰值过后归还内存，或在退出前让内存检查工具看到干净的堆。
+ */
+void parking_service_trim_result_pool(void);
 
-///@}
+/** @} */
 
 /**
  *********************************************************************************
@@ -235,7 +1837,7 @@ ServiceResult parking_service_load_data(const char *filename);
  */
 
 /** @name 公共辅助函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 释放由服务层函数动态分配在 ServiceResult.data 中的内存。
@@ -258,6 +1860,6 @@ void parking_service_print_error(ServiceResult result);
  */
 int parking_service_is_success(ServiceResult result);
 
-///@}
+/** @} */
 
 #endif /* PARKING_SERVICE_H */
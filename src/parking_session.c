@@ -0,0 +1,232 @@
+/**
+ * @file parking_session.c
+ * @brief 车辆资料缓存实现文件
+ * @details
+ * 该文件实现了 parking_session.h 中声明的 LRU 缓存。条目之间以数组下标
+ * 相连，淘汰时原地复用最久未使用的条目，缓存运行期间不再分配内存。
+ */
+
+#include <string.h>
+
+#include "parking_plate.h"
+#include "parking_session.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 求车牌所在的哈希桶。
+ * @param cache 目标缓存。
+ * @param license_plate 车牌号。
+ * @return 哈希桶下标。
+ */
+static int bucket_of(const SessionCache *cache, const char *license_plate) {
+  PlateCode code;
+
+  plate_encode(license_plate, &code);
+  return (int)(plate_code_hash(&code) & (unsigned long)cache->bucket_mask);
+}
+
+/**
+ * @brief (静态辅助函数) 按车牌查找条目下标。
+ * @param cache 目标缓存。
+ * @param license_plate 车牌号。
+ * @return 条目下标，没有时返回 -1。
+ */
+static int find_entry(const SessionCache *cache, const char *license_plate) {
+  int at = cache->buckets[bucket_of(cache, license_plate)];
+
+  while (at >= 0 &&
+         strcmp(cache->entries[at].session.license_plate, license_plate) != 0) {
+    at = cache->entries[at].bucket_next;
+  }
+  return at;
+}
+
+/**
+ * @brief (静态辅助函数) 把条目从使用顺序链表中摘下。
+ * @param cache 目标缓存。
+ * @param at 条目下标。
+ */
+static void unlink_recent(SessionCache *cache, int at) {
+  SessionEntry *entry = &cache->entries[at];
+
+  if (entry->newer >= 0) {
+    cache->entries[entry->newer].older = entry->older;
+  } else {
+    cache->newest = entry->older;
+  }
+  if (entry->older >= 0) {
+    cache->entries[entry->older].newer = entry->newer;
+  } else {
+    cache->oldest = entry->newer;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 把条目放到使用顺序链表的最前面。
+ * @param cache 目标缓存。
+ * @param at 条目下标（不在链表中）。
+ */
+static void push_recent(SessionCache *cache, int at) {
+  SessionEntry *entry = &cache->entries[at];
+
+  entry->newer = -1;
+  entry->older = cache->newest;
+  if (cache->newest >= 0) {
+    cache->entries[cache->newest].newer = at;
+  } else {
+    cache->oldest = at;
+  }
+  cache->newest = at;
+}
+
+/**
+ * @brief (静态辅助函数) 把条目从所在的哈希桶中摘下。
+ * @param cache 目标缓存。
+ * @param at 条目下标。
+ */
+static void unlink_bucket(SessionCache *cache, int at) {
+  const char *plate = cache->entries[at].session.license_plate;
+  int *link = &cache->buckets[bucket_of(cache, plate)];
+
+  while (*link != at) {
+    link = &cache->entries[*link].bucket_next;
+  }
+  *link = cache->entries[at].bucket_next;
+}
+
+/* ========================================================================== */
+/*                            车辆资料缓存API实现                             */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个空缓存。
+ * @param memory 缓存的分配来源，NULL 表示 C 堆。
+ * @param capacity 最多缓存的车牌数。
+ * @return 成功返回缓存；参数无效或内存不足返回 NULL。
+ */
+SessionCache *session_cache_create(ParkingMemory *memory, int capacity) {
+  SessionCache *cache;
+  int buckets = 1;
+  int i;
+
+  if (capacity <= 0) {
+    return NULL;
+  }
+  while (buckets < capacity) {
+    buckets <<= 1;
+  }
+  cache = (SessionCache *)parking_memory_calloc(memory, PARKING_MEMORY_INDEX,
+                                                1, sizeof(SessionCache));
+  if (cache == NULL) {
+    return NULL;
+  }
+  cache->entries = (SessionEntry *)parking_memory_alloc(
+      memory, PARKING_MEMORY_INDEX, (size_t)capacity * sizeof(SessionEntry));
+  cache->buckets = (int *)parking_memory_alloc(
+      memory, PARKING_MEMORY_INDEX, (size_t)buckets * sizeof(int));
+  if (cache->entries == NULL || cache->buckets == NULL) {
+    parking_memory_free(memory, cache->entries);
+    parking_memory_free(memory, cache->buckets);
+    parking_memory_free(memory, cache);
+    return NULL;
+  }
+  for (i = 0; i < buckets; i++) {
+    cache->buckets[i] = -1;
+  }
+  cache->capacity = capacity;
+  cache->bucket_mask = buckets - 1;
+  cache->newest = -1;
+  cache->oldest = -1;
+  cache->memory = memory;
+  return cache;
+}
+
+/**
+ * @brief 释放缓存。
+ * @param cache 要释放的缓存，可以为 NULL。
+ */
+void session_cache_free(SessionCache *cache) {
+  if (cache == NULL) {
+    return;
+  }
+  parking_memory_free(cache->memory, cache->entries);
+  parking_memory_free(cache->memory, cache->buckets);
+  parking_memory_free(cache->memory, cache);
+}
+
+/**
+ * @brief 写入（或更新）一辆车的资料，并标记为最近使用。
+ * @param cache 目标缓存。
+ * @param session 车辆资料。
+ */
+void session_cache_put(SessionCache *cache, const VehicleSession *session) {
+  int bucket;
+  int at;
+
+  if (cache == NULL || session == NULL || session->license_plate[0] == '\0') {
+    return;
+  }
+  at = find_entry(cache, session->license_plate);
+  if (at >= 0) {
+    cache->entries[at].session = *session;
+    unlink_recent(cache, at);
+    push_recent(cache, at);
+    return;
+  }
+
+  if (cache->count < cache->capacity) {
+    at = cache->count++;
+  } else {
+    /* 缓存已满，原地复用最久未使用的条目 */
+    at = cache->oldest;
+    unlink_bucket(cache, at);
+    unlink_recent(cache, at);
+  }
+  cache->entries[at].session = *session;
+  bucket = bucket_of(cache, session->license_plate);
+  cache->entries[at].bucket_next = cache->buckets[bucket];
+  cache->buckets[bucket] = at;
+  push_recent(cache, at);
+}
+
+/**
+ * @brief 按车牌查找车辆资料，不改变使用顺序。
+ * @param cache 目标缓存，可以为 NULL。
+ * @param license_plate 车牌号。
+ * @return 找到返回车辆资料，否则返回 NULL。
+ */
+const VehicleSession *session_cache_find(const SessionCache *cache,
+                                         const char *license_plate) {
+  int at;
+
+  if (cache == NULL || license_plate == NULL) {
+    return NULL;
+  }
+  at = find_entry(cache, license_plate);
+  return at >= 0 ? &cache->entries[at].session : NULL;
+}
+
+/**
+ * @brief 按车牌查找车辆资料，并标记为最近使用。
+ * @param cache 目标缓存，可以为 NULL。
+ * @param license_plate 车牌号。
+ * @return 找到返回车辆资料，否则返回 NULL。
+ */
+const VehicleSession *session_cache_use(SessionCache *cache,
+                                        const char *license_plate) {
+  int at;
+
+  if (cache == NULL || license_plate == NULL) {
+    return NULL;
+  }
+  at = find_entry(cache, license_plate);
+  if (at < 0) {
+    return NULL;
+  }
+  unlink_recent(cache, at);
+  push_recent(cache, at);
+  return &cache->entries[at].session;
+}
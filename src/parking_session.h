@@ -0,0 +1,105 @@
+#ifndef PARKING_SESSION_H
+#define PARKING_SESSION_H
+
+#include "parking_data.h"
+#include "parking_memory.h"
+
+/**
+ * @file parking_session.h
+ * @brief 按车牌缓存近期车辆资料的 LRU 缓存声明。
+ * @details
+ * 常客（如居民的访客）几乎每天都来，每次入场都要重新录入车主姓名与
+ * 联系方式并重新校验。缓存在车辆出场时按车牌记下已校验过的车主姓名、
+ * 联系方式、停车类型与所在分区，再次入场时只需读到车牌即可分配车位。
+ *
+ * 缓存容量固定：条目数组在创建时一次分配，以链式哈希表按车牌查找，
+ * 以双向链表维护最近使用的顺序，满了以后淘汰最久未使用的条目。
+ * 查找、写入与淘汰都是 O(1) 的。缓存只保存在内存中，不写入快照；
+ * 缓存本身不加锁，由停车场的锁保护。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define SESSION_CACHE_DEFAULT_CAPACITY 1024 /**< 默认缓存的车牌数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 缓存中的一个条目。
+ */
+typedef struct SessionEntry {
+  VehicleSession session; /**< 车辆资料。 */
+  int bucket_next;        /**< 同一哈希桶中的下一个条目，-1 表示没有。 */
+  int newer;              /**< 更近使用的条目，-1 表示这是最近的。 */
+  int older;              /**< 更久未使用的条目，-1 表示这是最久的。 */
+} SessionEntry;
+
+/**
+ * @brief 按车牌缓存近期车辆资料的 LRU 缓存。
+ */
+typedef struct SessionCache {
+  SessionEntry *entries; /**< 条目数组，前 count 个已使用。 */
+  int *buckets;          /**< 哈希桶中第一个条目的下标，-1 表示空桶。 */
+  int capacity;          /**< 最多缓存的条目数。 */
+  int bucket_mask;       /**< 哈希桶数减 1（桶数为 2 的幂）。 */
+  int count;             /**< 已使用的条目数。 */
+  int newest;            /**< 最近使用的条目，-1 表示缓存为空。 */
+  int oldest;            /**< 最久未使用的条目，-1 表示缓存为空。 */
+  ParkingMemory *memory; /**< 分配来源，NULL 表示 C 堆。 */
+} SessionCache;
+
+/**
+ *********************************************************************************
+ *                              车辆资料缓存API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个空缓存。
+ * @param memory 缓存的分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @param capacity 最多缓存的车牌数，必须大于 0。
+ * @return 成功返回缓存；参数无效或内存不足返回 NULL。
+ */
+SessionCache *session_cache_create(ParkingMemory *memory, int capacity);
+
+/**
+ * @brief 释放缓存。
+ * @param cache 要释放的缓存，可以为 NULL。
+ */
+void session_cache_free(SessionCache *cache);
+
+/**
+ * @brief 写入（或更新）一辆车的资料，并标记为最近使用。
+ * @details 缓存已满时淘汰最久未使用的条目。
+ * @param cache 目标缓存。
+ * @param session 车辆资料，license_plate 为键。
+ */
+void session_cache_put(SessionCache *cache, const VehicleSession *session);
+
+/**
+ * @brief 按车牌查找车辆资料，不改变使用顺序（可以在读锁内调用）。
+ * @param cache 目标缓存，可以为 NULL。
+ * @param license_plate 车牌号。
+ * @return 找到返回车辆资料（下一次修改缓存前有效），否则返回 NULL。
+ */
+const VehicleSession *session_cache_find(const SessionCache *cache,
+                                         const char *license_plate);
+
+/**
+ * @brief 按车牌查找车辆资料，并标记为最近使用。
+ * @param cache 目标缓存，可以为 NULL。
+ * @param license_plate 车牌号。
+ * @return 找到返回车辆资料（下一次修改缓存前有效），否则返回 NULL。
+ */
+const VehicleSession *session_cache_use(SessionCache *cache,
+                                        const char *license_plate);
+
+#endif /* PARKING_SESSION_H */
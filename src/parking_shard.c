@@ -0,0 +1,391 @@
+/**
+ * @file parking_shard.c
+ * @brief 分区停车场容器实现文件
+ * @details
+ * 该文件实现了 parking_shard.h 中声明的分区管理与路由函数。
+ * 分区表只追加：新分区先完整初始化，再通过原子递增 zone_count 发布，
+ * 因此路由函数可以在不持有布局锁的情况下读取分区表。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_shard.h"
+#include "parking_thread.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 按名称查找分区（名称以长度给出）。
+ * @param sharded 目标容器。
+ * @param name 名称起始地址，不要求以 NUL 结尾。
+ * @param length 名称长度。
+ * @return 找到时返回分区编号，否则返回 -1。
+ */
+static int find_zone_n(const ShardedParkingLot *sharded, const char *name,
+                       size_t length) {
+  int count = parking_atomic_load_int(&sharded->zone_count);
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (strlen(sharded->zones[i].name) == length &&
+        memcmp(sharded->zones[i].name, name, length) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief (静态辅助函数) 读取分区的空闲车位数与占用数。
+ * @param zone 目标分区。
+ * @param[out] occupied 接收占用数。
+ * @return 空闲车位数。
+ */
+static int zone_free_slots(const ParkingZone *zone, int *occupied) {
+  *occupied = parking_atomic_load_int(&zone->lot->occupied_slots);
+  return parking_atomic_load_int(&zone->lot->free_slot_count);
+}
+
+/**
+ * @brief (静态辅助函数) 选出占用率最低的有空位分区。
+ * @param sharded 目标容器。
+ * @param count 已发布的分区数。
+ * @param excluded 不参与选择的分区掩码。
+ * @return 分区编号，没有时返回 -1。
+ */
+static int pick_least_occupied(const ShardedParkingLot *sharded, int count,
+                               unsigned long excluded) {
+  long best_occupied = 0;
+  long best_total = 1;
+  int best = -1;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    int occupied;
+    int free_slots;
+
+    if (excluded & (1UL << i)) {
+      continue;
+    }
+    free_slots = zone_free_slots(&sharded->zones[i], &occupied);
+    if (free_slots <= 0) {
+      continue;
+    }
+    /* 交叉相乘比较占用率，避免浮点运算 */
+    if (best < 0 ||
+        (long)occupied * best_total <
+            best_occupied * ((long)occupied + free_slots)) {
+      best = i;
+      best_occupied = occupied;
+      best_total = (long)occupied + free_slots;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief (静态辅助函数) 从轮流游标起选出下一个有空位的分区，并推进游标。
+ * @details 游标的读取与推进不是一个原子操作，并发选择偶尔会选中同一个
+ *          分区，只影响均衡程度。
+ * @param sharded 目标容器。
+ * @param count 已发布的分区数。
+ * @param excluded 不参与选择的分区掩码。
+ * @return 分区编号，没有时返回 -1。
+ */
+static int pick_round_robin(ShardedParkingLot *sharded, int count,
+                            unsigned long excluded) {
+  int start = parking_atomic_load_int(&sharded->next_zone);
+  int step;
+
+  for (step = 0; step < count; step++) {
+    int i = (start + step) % count;
+    int occupied;
+
+    if (excluded & (1UL << i)) {
+      continue;
+    }
+    if (zone_free_slots(&sharded->zones[i], &occupied) > 0) {
+      parking_atomic_store_int(&sharded->next_zone, (i + 1) % count);
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief (静态辅助函数) 选出离入口最近的有空位分区。
+ * @param sharded 目标容器。
+ * @param count 已发布的分区数。
+ * @param excluded 不参与选择的分区掩码。
+ * @return 分区编号，没有时返回 -1。
+ */
+static int pick_nearest_entrance(const ShardedParkingLot *sharded, int count,
+                                 unsigned long excluded) {
+  int best_distance = 0;
+  int best = -1;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    int distance;
+    int occupied;
+
+    if (excluded & (1UL << i)) {
+      continue;
+    }
+    distance = parking_atomic_load_int(&sharded->zones[i].entrance_distance);
+    if (best >= 0 && distance >= best_distance) {
+      continue;
+    }
+    if (zone_free_slots(&sharded->zones[i], &occupied) > 0) {
+      best = i;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+/* ========================================================================== */
+/*                              容器管理函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个不含分区的空容器。
+ * @return 成功返回新容器，内存不足返回 NULL。
+ */
+ShardedParkingLot *init_sharded_lot(void) {
+  ShardedParkingLot *sharded =
+      (ShardedParkingLot *)malloc(sizeof(ShardedParkingLot));
+
+  if (sharded == NULL) {
+    return NULL;
+  }
+  memset(sharded->zones, 0, sizeof(sharded->zones));
+  sharded->zone_count = 0;
+  sharded->next_zone = 0;
+  sharded->layout_lock = parking_rwlock_create();
+  if (sharded->layout_lock == NULL) {
+    free(sharded);
+    return NULL;
+  }
+  return sharded;
+}
+
+/**
+ * @brief 释放容器及其全部分区。
+ * @param sharded 要释放的容器，可以为 NULL。
+ */
+void free_sharded_lot(ShardedParkingLot *sharded) {
+  int i;
+
+  if (sharded == NULL) {
+    return;
+  }
+  for (i = 0; i < sharded->zone_count; i++) {
+    free_parking_lot(sharded->zones[i].lot);
+  }
+  parking_rwlock_destroy(sharded->layout_lock);
+  free(sharded);
+}
+
+/**
+ * @brief 新建一个分区。
+ * @param sharded 目标容器。
+ * @param name 分区名称。
+ * @param total_slots 分区的设计车位数。
+ * @return 成功返回分区编号；参数无效返回 -1，同名分区已存在返回 -2，
+ * 分区已满或内存不足返回 -3。
+ */
+int sharded_lot_add_zone(ShardedParkingLot *sharded, const char *name,
+                         int total_slots) {
+  size_t length;
+  int zone_id;
+  ParkingLot *lot;
+
+  if (sharded == NULL || name == NULL || total_slots < 0) {
+    return -1;
+  }
+  length = strlen(name);
+  if (length == 0 || length >= MAX_ZONE_NAME_LEN ||
+      strchr(name, ZONE_DELIMITER) != NULL) {
+    return -1;
+  }
+
+  parking_rwlock_write_lock(sharded->layout_lock);
+  if (find_zone_n(sharded, name, length) >= 0) {
+    parking_rwlock_write_unlock(sharded->layout_lock);
+    return -2;
+  }
+  zone_id = sharded->zone_count;
+  lot = zone_id < MAX_ZONES ? init_parking_lot(total_slots) : NULL;
+  if (lot == NULL) {
+    parking_rwlock_write_unlock(sharded->layout_lock);
+    return -3;
+  }
+  memcpy(sharded->zones[zone_id].name, name, length + 1);
+  sharded->zones[zone_id].lot = lot;
+  sharded->zones[zone_id].entrance_distance = zone_id;
+  /* 分区完整初始化后再发布，无锁读者只会看到完整的分区 */
+  parking_atomic_add_int(&sharded->zone_count, 1);
+  parking_rwlock_write_unlock(sharded->layout_lock);
+  return zone_id;
+}
+
+/* ========================================================================== */
+/*                              分区路由函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 返回分区编号对应的停车场。
+ * @param sharded 目标容器。
+ * @param zone_id 分区编号。
+ * @return 分区存在时返回其停车场，否则返回 NULL。
+ */
+ParkingLot *sharded_lot_zone_lot(const ShardedParkingLot *sharded,
+                                 int zone_id) {
+  if (sharded == NULL || zone_id < 0 ||
+      zone_id >= parking_atomic_load_int(&sharded->zone_count)) {
+    return NULL;
+  }
+  return sharded->zones[zone_id].lot;
+}
+
+/**
+ * @brief 按名称查找分区。
+ * @param sharded 目标容器。
+ * @param name 分区名称。
+ * @return 找到时返回分区编号，否则返回 -1。
+ */
+int sharded_lot_find_zone(const ShardedParkingLot *sharded, const char *name) {
+  if (sharded == NULL || name == NULL) {
+    return -1;
+  }
+  return find_zone_n(sharded, name, strlen(name));
+}
+
+/**
+ * @brief 按位置描述的前缀确定分区。
+ * @param sharded 目标容器。
+ * @param location 位置描述。
+ * @return 前缀对应的分区编号；无分隔符或分区不存在时返回 -1。
+ */
+int sharded_lot_zone_of_location(const ShardedParkingLot *sharded,
+                                 const char *location) {
+  const char *delimiter;
+
+  if (sharded == NULL || location == NULL) {
+    return -1;
+  }
+  delimiter = strchr(location, ZONE_DELIMITER);
+  if (delimiter == NULL || delimiter == location) {
+    return -1;
+  }
+  return find_zone_n(sharded, location, (size_t)(delimiter - location));
+}
+
+/**
+ * @brief 查找车位编号所在的分区。
+ * @param sharded 目标容器。
+ * @param slot_id 车位编号。
+ * @return 找到时返回分区编号，否则返回 -1。
+ */
+int sharded_lot_zone_of_slot(const ShardedParkingLot *sharded, int slot_id) {
+  int count;
+  int found;
+  int i;
+
+  if (sharded == NULL) {
+    return -1;
+  }
+  count = parking_atomic_load_int(&sharded->zone_count);
+  for (i = 0; i < count; i++) {
+    ParkingLot *lot = sharded->zones[i].lot;
+
+    parking_lot_read_lock(lot);
+    found = find_slot_by_id(lot, slot_id) != NULL;
+    parking_lot_read_unlock(lot);
+    if (found) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief 查找车牌号当前停放的分区。
+ * @param sharded 目标容器。
+ * @param license_plate 车牌号。
+ * @return 找到时返回分区编号，否则返回 -1。
+ */
+int sharded_lot_zone_of_plate(const ShardedParkingLot *sharded,
+                              const char *license_plate) {
+  int count;
+  int found;
+  int i;
+
+  if (sharded == NULL || license_plate == NULL) {
+    return -1;
+  }
+  count = parking_atomic_load_int(&sharded->zone_count);
+  for (i = 0; i < count; i++) {
+    ParkingLot *lot = sharded->zones[i].lot;
+
+    parking_lot_read_lock(lot);
+    found = find_slot_by_license(lot, license_plate) != NULL;
+    parking_lot_read_unlock(lot);
+    if (found) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* ========================================================================== */
+/*                              分配策略函数实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 设置分区离入口的距离。
+ * @param sharded 目标容器。
+ * @param zone_id 分区编号。
+ * @param distance 距离，不能为负。
+ * @return 成功返回 0，参数无效或分区不存在返回 -1。
+ */
+int sharded_lot_set_entrance_distance(ShardedParkingLot *sharded, int zone_id,
+                                      int distance) {
+  if (sharded_lot_zone_lot(sharded, zone_id) == NULL || distance < 0) {
+    return -1;
+  }
+  parking_atomic_store_int(&sharded->zones[zone_id].entrance_distance,
+                           distance);
+  return 0;
+}
+
+/**
+ * @brief 按分配策略选择一个有空闲车位的分区。
+ * @param sharded 目标容器。
+ * @param policy 分配策略。
+ * @param excluded 不参与选择的分区掩码。
+ * @return 选中的分区编号；参数无效或没有空闲车位的分区时返回 -1。
+ */
+int sharded_lot_pick_zone(ShardedParkingLot *sharded,
+                          ZoneAllocationPolicy policy, unsigned long excluded) {
+  int count;
+
+  if (sharded == NULL) {
+    return -1;
+  }
+  count = parking_atomic_load_int(&sharded->zone_count);
+  switch (policy) {
+  case ZONE_POLICY_LEAST_OCCUPIED:
+    return pick_least_occupied(sharded, count, excluded);
+  case ZONE_POLICY_ROUND_ROBIN:
+    return pick_round_robin(sharded, count, excluded);
+  case ZONE_POLICY_NEAREST_ENTRANCE:
+    return pick_nearest_entrance(sharded, count, excluded);
+  default:
+    return -1;
+  }
+}
@@ -0,0 +1,186 @@
+#ifndef PARKING_SHARD_H
+#define PARKING_SHARD_H
+
+#include "parking_data.h"
+
+/**
+ * @file parking_shard.h
+ * @brief 按分区（楼层/区域）分片的停车场容器。
+ * @details
+ * 每个分区是一个完整的 ParkingLot，拥有各自的索引、读写锁和计数器；
+ * 不同分区上的入场、出场互不竞争任何共享结构。车位按位置描述的前缀
+ * （第一个 '-' 之前的部分，例如 "B2-017" 属于分区 "B2"）或显式的分区编号
+ * 归属到分区。分区只增不减，创建后编号保持不变。
+ *
+ * 自动选位可以按分配策略先选分区：占用率最低的分区优先、轮流使用各分区，
+ * 或离入口最近的有空位分区优先。选择只读取各分区停车场的空闲数与占用数
+ * 原子计数器，不获取任何锁，也不列出车位；分区内的车位再由该分区的
+ * 空闲车位位图给出。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define MAX_ZONES 32          /**< 一个容器最多容纳的分区数 */
+#define MAX_ZONE_NAME_LEN 16  /**< 分区名称的最大长度（含结尾 NUL） */
+#define ZONE_DELIMITER '-'    /**< 位置描述中分区前缀的分隔符 */
+
+/**
+ *********************************************************************************
+ *                                 枚举定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 自动选位时选择分区的策略。
+ */
+typedef enum {
+  ZONE_POLICY_LEAST_OCCUPIED = 0,  /**< 占用率最低的分区优先。 */
+  ZONE_POLICY_ROUND_ROBIN = 1,     /**< 从上次选中的下一个分区起轮流使用。 */
+  ZONE_POLICY_NEAREST_ENTRANCE = 2 /**< 离入口距离最小的分区优先。 */
+} ZoneAllocationPolicy;
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+struct ParkingRwLock;
+
+/**
+ * @brief 容器中的一个分区。
+ */
+typedef struct ParkingZone {
+  char name[MAX_ZONE_NAME_LEN]; /**< 分区名称（位置描述前缀）。 */
+  ParkingLot *lot;              /**< 分区自己的停车场。 */
+  /** 离入口的距离，原子读写；新分区取其编号，即按创建顺序由近及远。 */
+  volatile int entrance_distance;
+} ParkingZone;
+
+/**
+ * @brief 由多个分区组成的停车场容器。
+ * @details zones[0..zone_count) 一经发布便不再改变，读取分区表无需加锁；
+ *          layout_lock 只串行化新建分区和添加车位（跨分区的编号唯一性检查）。
+ */
+typedef struct ShardedParkingLot {
+  ParkingZone zones[MAX_ZONES];       /**< 分区表。 */
+  int zone_count;                     /**< 已发布的分区数，原子读写。 */
+  struct ParkingRwLock *layout_lock;  /**< 分区布局锁。 */
+  volatile int next_zone;             /**< 轮流策略下一次开始查看的分区。 */
+} ShardedParkingLot;
+
+/**
+ *********************************************************************************
+ *                            分区容器API声明
+ *********************************************************************************
+ */
+
+/** @name 容器管理 */
+/** @{ */
+
+/**
+ * @brief 创建一个不含分区的空容器。
+ * @return 成功返回新容器，内存不足返回 NULL。
+ */
+ShardedParkingLot *init_sharded_lot(void);
+
+/**
+ * @brief 释放容器及其全部分区。
+ * @param sharded 要释放的容器，可以为 NULL。
+ */
+void free_sharded_lot(ShardedParkingLot *sharded);
+
+/**
+ * @brief 新建一个分区。
+ * @param sharded 目标容器。
+ * @param name 分区名称，不能为空、不能包含分隔符。
+ * @param total_slots 分区的设计车位数。
+ * @return 成功返回分区编号（从 0 开始）；参数无效返回 -1，
+ * 同名分区已存在返回 -2，分区已满或内存不足返回 -3。
+ */
+int sharded_lot_add_zone(ShardedParkingLot *sharded, const char *name,
+                         int total_slots);
+
+/** @} */
+
+/** @name 分区路由 */
+/** @{ */
+
+/**
+ * @brief 返回分区编号对应的停车场。
+ * @param sharded 目标容器。
+ * @param zone_id 分区编号。
+ * @return 分区存在时返回其停车场，否则返回 NULL。
+ */
+ParkingLot *sharded_lot_zone_lot(const ShardedParkingLot *sharded, int zone_id);
+
+/**
+ * @brief 按名称查找分区。
+ * @param sharded 目标容器。
+ * @param name 分区名称。
+ * @return 找到时返回分区编号，否则返回 -1。
+ */
+int sharded_lot_find_zone(const ShardedParkingLot *sharded, const char *name);
+
+/**
+ * @brief 按位置描述的前缀确定分区。
+ * @param sharded 目标容器。
+ * @param location 位置描述，例如 "B2-017"。
+ * @return 前缀对应的分区编号；无分隔符或分区不存在时返回 -1。
+ */
+int sharded_lot_zone_of_location(const ShardedParkingLot *sharded,
+                                 const char *location);
+
+/**
+ * @brief 查找车位编号所在的分区。
+ * @details 依次在各分区的读锁内查询编号索引。
+ * @param sharded 目标容器。
+ * @param slot_id 车位编号。
+ * @return 找到时返回分区编号，否则返回 -1。
+ */
+int sharded_lot_zone_of_slot(const ShardedParkingLot *sharded, int slot_id);
+
+/**
+ * @brief 查找车牌号当前停放的分区。
+ * @param sharded 目标容器。
+ * @param license_plate 车牌号。
+ * @return 找到时返回分区编号，否则返回 -1。
+ */
+int sharded_lot_zone_of_plate(const ShardedParkingLot *sharded,
+                              const char *license_plate);
+
+/** @} */
+
+/** @name 分配策略 */
+/** @{ */
+
+/**
+ * @brief 设置分区离入口的距离，供 ZONE_POLICY_NEAREST_ENTRANCE 使用。
+ * @param sharded 目标容器。
+ * @param zone_id 分区编号。
+ * @param distance 距离，不能为负；单位由调用者约定（例如坡道的层数）。
+ * @return 成功返回 0，参数无效或分区不存在返回 -1。
+ */
+int sharded_lot_set_entrance_distance(ShardedParkingLot *sharded, int zone_id,
+                                      int distance);
+
+/**
+ * @brief 按分配策略选择一个有空闲车位的分区。
+ * @details 只读取各分区的原子计数器（至多 MAX_ZONES 个），不加锁；
+ *          并发入场可能在选出之后占满该分区，调用者应把它加入 excluded
+ *          后重选。占用率与距离相同时取编号较小的分区。
+ * @param sharded 目标容器。
+ * @param policy 分配策略。
+ * @param excluded 不参与选择的分区掩码，第 i 位对应分区 i。
+ * @return 选中的分区编号；参数无效或没有空闲车位的分区时返回 -1。
+ */
+int sharded_lot_pick_zone(ShardedParkingLot *sharded,
+                          ZoneAllocationPolicy policy, unsigned long excluded);
+
+/** @} */
+
+#endif /* PARKING_SHARD_H */
@@ -0,0 +1,383 @@
+/**
+ * @file parking_shm.c
+ * @brief 共享内存发布实现文件
+ * @details
+ * 该文件实现了 parking_shm.h 中声明的顺序锁发布与读取。发布者在把序号
+ * 改为奇数之后、写入内容之前放一道内存屏障，保证读者看到内容变化时
+ * 一定也看到了奇数序号；读者在复制内容之后、第二次读序号之前同样放一道
+ * 屏障，保证复制不会被推迟到复核之后。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_file_map.h"
+#include "parking_shm.h"
+#include "parking_thread.h"
+
+/**
+ * @brief 正在发布的共享内存（停车场进程一侧）。
+ */
+struct ParkingShmPublisher {
+  FileMapping map;          /**< 可写的共享映射。 */
+  ShmHeader *header;        /**< 映射中的文件头。 */
+  ShmSlotRow *rows;         /**< 映射中的行。 */
+  volatile int lock;        /**< 串行化并发发布的自旋锁。 */
+  int has_published;        /**< 是否已发布过。 */
+  long published_mutations; /**< 上次发布时停车场的修改次数。 */
+  ParkingMemory *memory;    /**< 分配来源，NULL 表示 C 堆。 */
+};
+
+/**
+ * @brief 映射的共享内存（其他进程一侧）。
+ */
+struct ParkingShmReader {
+  FileMapping map;         /**< 只读的共享映射。 */
+  const ShmHeader *header; /**< 映射中的文件头。 */
+  const ShmSlotRow *rows;  /**< 映射中的行。 */
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 计算容纳 capacity 行的映射字节数。
+ * @param capacity 行数上限。
+ * @return 字节数。
+ */
+static size_t shm_size(int capacity) {
+  return sizeof(ShmHeader) + (size_t)capacity * sizeof(ShmSlotRow);
+}
+
+/**
+ * @brief (静态辅助函数) 读者开始一次读取：读取序号并确认没有发布进行中。
+ * @param header 共享内存的文件头。
+ * @param[out] sequence 接收序号。
+ * @return 可以读取返回 1，发布进行中返回 0。
+ */
+static int read_begin(const ShmHeader *header, int *sequence) {
+  *sequence = parking_atomic_load_int(&header->sequence);
+  return (*sequence & 1) == 0;
+}
+
+/**
+ * @brief (静态辅助函数) 读者结束一次读取：确认期间没有发布。
+ * @param header 共享内存的文件头。
+ * @param sequence read_begin 读到的序号。
+ * @return 读到的内容一致返回 1，否则返回 0。
+ */
+static int read_end(const ShmHeader *header, int sequence) {
+  parking_atomic_fence();
+  return parking_atomic_load_int(&header->sequence) == sequence;
+}
+
+/**
+ * @brief (静态辅助函数) 读者取得已发布的行数，不超过行数上限。
+ * @param header 共享内存的文件头。
+ * @return 行数。
+ */
+static int published_rows(const ShmHeader *header) {
+  int count = header->slot_count;
+
+  if (count < 0) {
+    return 0;
+  }
+  return count < header->capacity ? count : header->capacity;
+}
+
+/* ========================================================================== */
+/*                              发布者API实现                                 */
+/* ========================================================================== */
+
+/**
+ * @brief 创建（或覆盖）共享内存文件并建立发布者。
+ * @param memory 发布者自身的分配来源，NULL 表示 C 堆。
+ * @param path 共享内存文件的路径。
+ * @param capacity 行数上限。
+ * @return 成功返回发布者，失败返回 NULL。
+ */
+ParkingShmPublisher *shm_publisher_create(ParkingMemory *memory,
+                                          const char *path, int capacity) {
+  ParkingShmPublisher *publisher;
+  size_t size;
+
+  if (path == NULL || capacity <= 0 ||
+      (size_t)capacity >
+          ((size_t)-1 - sizeof(ShmHeader)) / sizeof(ShmSlotRow)) {
+    return NULL;
+  }
+  publisher = (ParkingShmPublisher *)parking_memory_calloc(
+      memory, PARKING_MEMORY_INDEX, 1, sizeof(ParkingShmPublisher));
+  if (publisher == NULL) {
+    return NULL;
+  }
+  size = shm_size(capacity);
+  if (file_mapping_open_shared(&publisher->map, path, size) != 0) {
+    parking_memory_free(memory, publisher);
+    return NULL;
+  }
+  publisher->memory = memory;
+  publisher->header = (ShmHeader *)publisher->map.data;
+  publisher->rows = (ShmSlotRow *)(publisher->header + 1);
+
+  /* 覆盖旧文件时，旧读者在序号为奇数期间不会采用半新半旧的内容 */
+  parking_atomic_store_int(&publisher->header->sequence,
+                           publisher->header->sequence | 1);
+  parking_atomic_fence();
+  memset((unsigned char *)publisher->header + sizeof(ShmHeader), 0,
+         size - sizeof(ShmHeader));
+  publisher->header->magic = PARKING_SHM_MAGIC;
+  publisher->header->version = PARKING_SHM_VERSION;
+  publisher->header->row_size = (int)sizeof(ShmSlotRow);
+  publisher->header->capacity = capacity;
+  publisher->header->total_slots = 0;
+  publisher->header->slot_count = 0;
+  publisher->header->occupied_slots = 0;
+  publisher->header->free_slot_count = 0;
+  publisher->header->occupied_resident_count = 0;
+  publisher->header->occupied_visitor_count = 0;
+  publisher->header->truncated = 0;
+  publisher->header->reserved = 0;
+  publisher->header->mutation_count = 0;
+  publisher->header->published_at = 0;
+  parking_atomic_store_int(&publisher->header->sequence,
+                           publisher->header->sequence + 1);
+  return publisher;
+}
+
+/**
+ * @brief 解除映射并释放发布者。
+ * @param publisher 要释放的发布者，可以为 NULL。
+ */
+void shm_publisher_free(ParkingShmPublisher *publisher) {
+  if (publisher == NULL) {
+    return;
+  }
+  file_mapping_close(&publisher->map);
+  parking_memory_free(publisher->memory, publisher);
+}
+
+/**
+ * @brief 把停车场的热字段列与计数器复制到共享内存。
+ * @param publisher 目标发布者。
+ * @param lot 数据来源的停车场。
+ * @return 已发布返回 0，没有修改返回 1，参数无效返回 -1。
+ */
+int shm_publisher_publish(ParkingShmPublisher *publisher,
+                          const ParkingLot *lot) {
+  ShmHeader *header;
+  long mutations;
+  int sequence;
+  int count;
+  int i;
+
+  if (publisher == NULL || lot == NULL) {
+    return -1;
+  }
+  while (parking_atomic_exchange_int(&publisher->lock, 1) != 0) {
+  }
+  mutations = parking_atomic_load_long(&lot->mutation_count);
+  if (publisher->has_published && publisher->published_mutations == mutations) {
+    parking_atomic_store_int(&publisher->lock, 0);
+    return 1;
+  }
+
+  header = publisher->header;
+  count = lot->slot_count < header->capacity ? lot->slot_count
+                                             : header->capacity;
+  sequence = header->sequence;
+  parking_atomic_store_int(&header->sequence, sequence + 1);
+  parking_atomic_fence();
+  header->total_slots = parking_atomic_load_int(&lot->total_slots);
+  header->slot_count = count;
+  header->occupied_slots = parking_atomic_load_int(&lot->occupied_slots);
+  header->free_slot_count = parking_atomic_load_int(&lot->free_slot_count);
+  header->occupied_resident_count =
+      parking_atomic_load_int(&lot->occupied_resident_count);
+  header->occupied_visitor_count =
+      parking_atomic_load_int(&lot->occupied_visitor_count);
+  header->truncated = lot->slot_count > count;
+  header->mutation_count = mutations;
+  header->published_at = parking_lot_now(lot);
+  for (i = 0; i < count; i++) {
+    ShmSlotRow *row = &publisher->rows[i];
+
+    row->slot_id = lot->hot.slot_id[i];
+    row->status = lot->hot.status[i];
+    row->type = lot->hot.type[i];
+    row->reserved = 0;
+    row->entry_time = lot->hot.entry_time[i];
+    row->due_date = lot->hot.due_date[i];
+  }
+  parking_atomic_store_int(&header->sequence, sequence + 2);
+
+  publisher->has_published = 1;
+  publisher->published_mutations = mutations;
+  parking_atomic_store_int(&publisher->lock, 0);
+  return 0;
+}
+
+/* ========================================================================== */
+/*                               读者API实现                                  */
+/* ========================================================================== */
+
+/**
+ * @brief 以只读方式映射共享内存文件。
+ * @param path 共享内存文件的路径。
+ * @return 成功返回读者，失败返回 NULL。
+ */
+ParkingShmReader *parking_shm_open(const char *path) {
+  ParkingShmReader *reader;
+  const ShmHeader *header;
+
+  if (path == NULL) {
+    return NULL;
+  }
+  reader = (ParkingShmReader *)calloc(1, sizeof(ParkingShmReader));
+  if (reader == NULL) {
+    return NULL;
+  }
+  if (file_mapping_open_shared(&reader->map, path, 0) != 0) {
+    free(reader);
+    return NULL;
+  }
+  header = (const ShmHeader *)reader->map.data;
+  if (reader->map.size < sizeof(ShmHeader) ||
+      header->magic != PARKING_SHM_MAGIC ||
+      header->version != PARKING_SHM_VERSION ||
+      header->row_size != (int)sizeof(ShmSlotRow) || header->capacity <= 0 ||
+      reader->map.size < shm_size(header->capacity)) {
+    parking_shm_close(reader);
+    return NULL;
+  }
+  reader->header = header;
+  reader->rows = (const ShmSlotRow *)(header + 1);
+  return reader;
+}
+
+/**
+ * @brief 解除映射并释放读者。
+ * @param reader 要释放的读者，可以为 NULL。
+ */
+void parking_shm_close(ParkingShmReader *reader) {
+  if (reader == NULL) {
+    return;
+  }
+  file_mapping_close(&reader->map);
+  free(reader);
+}
+
+/**
+ * @brief 读取一份一致的计数器。
+ * @param reader 目标读者。
+ * @param[out] counters 接收计数器。
+ * @return 成功返回 0，参数无效返回 -1，发布进行中返回 -2。
+ */
+int parking_shm_read_counters(ParkingShmReader *reader, ShmCounters *counters) {
+  const ShmHeader *header;
+  int attempt;
+
+  if (reader == NULL || counters == NULL) {
+    return -1;
+  }
+  header = reader->header;
+  for (attempt = 0; attempt < PARKING_SHM_READ_ATTEMPTS; attempt++) {
+    int sequence;
+
+    if (!read_begin(header, &sequence)) {
+      continue;
+    }
+    counters->total_slots = header->total_slots;
+    counters->slot_count = published_rows(header);
+    counters->occupied_slots = header->occupied_slots;
+    counters->free_slot_count = header->free_slot_count;
+    counters->occupied_resident_count = header->occupied_resident_count;
+    counters->occupied_visitor_count = header->occupied_visitor_count;
+    counters->truncated = header->truncated;
+    counters->mutation_count = header->mutation_count;
+    counters->published_at = header->published_at;
+    if (read_end(header, sequence)) {
+      return 0;
+    }
+  }
+  return -2;
+}
+
+/**
+ * @brief 按编号读取一个车位的热字段。
+ * @param reader 目标读者。
+ * @param slot_id 车位编号。
+ * @param[out] row 接收该行。
+ * @return 成功返回 0，参数无效返回 -1，发布进行中返回 -2，没有该车位返回 -3。
+ */
+int parking_shm_read_slot(ParkingShmReader *reader, int slot_id,
+                          ShmSlotRow *row) {
+  const ShmHeader *header;
+  int attempt;
+
+  if (reader == NULL || row == NULL) {
+    return -1;
+  }
+  header = reader->header;
+  for (attempt = 0; attempt < PARKING_SHM_READ_ATTEMPTS; attempt++) {
+    int sequence;
+    int count;
+    int found = -1;
+    int i;
+
+    if (!read_begin(header, &sequence)) {
+      continue;
+    }
+    count = published_rows(header);
+    for (i = 0; i < count; i++) {
+      if (reader->rows[i].slot_id == slot_id) {
+        *row = reader->rows[i];
+        found = i;
+        break;
+      }
+    }
+    if (read_end(header, sequence)) {
+      return found >= 0 ? 0 : -3;
+    }
+  }
+  return -2;
+}
+
+/**
+ * @brief 读取一份一致的全部行。
+ * @param reader 目标读者。
+ * @param[out] rows 接收行的数组。
+ * @param max rows 的容量。
+ * @param[out] count 接收复制的行数。
+ * @return 成功返回 0，参数无效返回 -1，发布进行中返回 -2。
+ */
+int parking_shm_read_rows(ParkingShmReader *reader, ShmSlotRow *rows, int max,
+                          int *count) {
+  const ShmHeader *header;
+  int attempt;
+
+  if (reader == NULL || rows == NULL || max < 0 || count == NULL) {
+    return -1;
+  }
+  *count = 0;
+  header = reader->header;
+  for (attempt = 0; attempt < PARKING_SHM_READ_ATTEMPTS; attempt++) {
+    int sequence;
+    int copied;
+
+    if (!read_begin(header, &sequence)) {
+      continue;
+    }
+    copied = published_rows(header);
+    if (copied > max) {
+      copied = max;
+    }
+    memcpy(rows, reader->rows, (size_t)copied * sizeof(ShmSlotRow));
+    if (read_end(header, sequence)) {
+      *count = copied;
+      return 0;
+    }
+  }
+  return -2;
+}
@@ -0,0 +1,188 @@
+#ifndef PARKING_SHM_H
+#define PARKING_SHM_H
+
+#include <time.h>
+
+#include "parking_data.h"
+
+/**
+ * @file parking_shm.h
+ * @brief 供同机其他进程零拷贝读取的共享内存发布声明。
+ * @details
+ * 诱导屏、缴费机与报表进程只关心各车位的占用状态和总体计数，为此重新
+ * 加载数据文件或走一次网络请求都嫌太重。停车场进程把热字段列与计数器
+ * 发布到一段共享映射的文件中（放在 /dev/shm 等内存文件系统上即纯内存），
+ * 其他进程映射同一文件后直接读取，每次读取不进入内核。
+ *
+ * 发布用顺序锁（seqlock）保护：发布者先把序号加成奇数，写入计数器与
+ * 各行，再把序号加成偶数。读者读取前后各读一次序号，两次相同且为偶数
+ * 才采用读到的内容，否则重试；读者从不写共享内存，也不会阻塞发布者。
+ * 发布是整表复制，在写入批次之后进行（时机与只读视图相同，见
+ * parking_service_configure_shared_memory），自上次发布以来没有修改时跳过。
+ *
+ * 共享内存中的结构按本机的 int、long 与 time_t 布局，只供同一台机器上
+ * 以相同方式编译的进程读取；文件头记录了行的字节数，布局不符时拒绝打开。
+ * 行按稠密车位表的顺序存放，不按编号排序。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_SHM_MAGIC 0x4D534B50UL /**< 文件头魔数（"PKSM"） */
+#define PARKING_SHM_VERSION 1          /**< 共享内存布局版本 */
+#define PARKING_SHM_READ_ATTEMPTS 64   /**< 读者遇到发布进行中时的重试次数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 共享内存中的一行车位热字段。
+ */
+typedef struct ShmSlotRow {
+  int slot_id;       /**< 车位编号。 */
+  int status;        /**< 占用状态（ParkingStatus）。 */
+  int type;          /**< 停车类型（ParkingType）。 */
+  int reserved;      /**< 保留，始终为 0。 */
+  time_t entry_time; /**< 入场时间。 */
+  time_t due_date;   /**< 居民月费到期时间。 */
+} ShmSlotRow;
+
+/**
+ * @brief 共享内存的文件头，后面紧跟 capacity 行 ShmSlotRow。
+ */
+typedef struct ShmHeader {
+  unsigned long magic;         /**< PARKING_SHM_MAGIC。 */
+  int version;                 /**< PARKING_SHM_VERSION。 */
+  int row_size;                /**< sizeof(ShmSlotRow)，用于识别布局不符。 */
+  int capacity;                /**< 行数上限。 */
+  volatile int sequence;       /**< 顺序锁序号，奇数表示发布进行中。 */
+  int total_slots;             /**< 设计的总车位数。 */
+  int slot_count;              /**< 已发布的行数。 */
+  int occupied_slots;          /**< 已占用车位数。 */
+  int free_slot_count;         /**< 空闲车位数。 */
+  int occupied_resident_count; /**< 居民占用数。 */
+  int occupied_visitor_count;  /**< 访客占用数。 */
+  int truncated;               /**< 车位数超过行数上限时为 1。 */
+  int reserved;                /**< 保留，始终为 0。 */
+  long mutation_count;         /**< 发布时停车场的修改次数。 */
+  time_t published_at;         /**< 发布时的业务时间。 */
+} ShmHeader;
+
+/**
+ * @brief 读者读到的一份计数器。
+ */
+typedef struct ShmCounters {
+  int total_slots;             /**< 设计的总车位数。 */
+  int slot_count;              /**< 已发布的行数。 */
+  int occupied_slots;          /**< 已占用车位数。 */
+  int free_slot_count;         /**< 空闲车位数。 */
+  int occupied_resident_count; /**< 居民占用数。 */
+  int occupied_visitor_count;  /**< 访客占用数。 */
+  int truncated;               /**< 行是否被截断。 */
+  long mutation_count;         /**< 发布时停车场的修改次数。 */
+  time_t published_at;         /**< 发布时的业务时间。 */
+} ShmCounters;
+
+/**
+ * @brief 不透明的发布者（停车场进程一侧）。
+ */
+typedef struct ParkingShmPublisher ParkingShmPublisher;
+
+/**
+ * @brief 不透明的读者（其他进程一侧）。
+ */
+typedef struct ParkingShmReader ParkingShmReader;
+
+/**
+ *********************************************************************************
+ *                              发布者API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建（或覆盖）共享内存文件并建立发布者。
+ * @details 新文件的计数器与行全部为 0，直到第一次发布。
+ * @param memory 发布者自身的分配来源，NULL 表示 C 堆；
+ *        计入 PARKING_MEMORY_INDEX。
+ * @param path 共享内存文件的路径。
+ * @param capacity 行数上限，必须大于 0。
+ * @return 成功返回发布者；参数无效、内存不足或无法映射文件返回 NULL。
+ */
+ParkingShmPublisher *shm_publisher_create(ParkingMemory *memory,
+                                          const char *path, int capacity);
+
+/**
+ * @brief 解除映射并释放发布者，文件保留最后一次发布的内容。
+ * @param publisher 要释放的发布者，可以为 NULL。
+ */
+void shm_publisher_free(ParkingShmPublisher *publisher);
+
+/**
+ * @brief 把停车场的热字段列与计数器复制到共享内存。
+ * @details 多个线程（例如都持有读锁）同时发布时由发布者内部的自旋锁
+ *          串行化，顺序锁始终只有一个写者。
+ * @note 须在读锁或写锁内调用。
+ * @param publisher 目标发布者。
+ * @param lot 数据来源的停车场。
+ * @return 已发布返回 0，自上次发布以来没有修改返回 1，参数无效返回 -1。
+ */
+int shm_publisher_publish(ParkingShmPublisher *publisher,
+                          const ParkingLot *lot);
+
+/**
+ *********************************************************************************
+ *                               读者API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 以只读方式映射共享内存文件。
+ * @param path 共享内存文件的路径。
+ * @return 成功返回读者；文件不存在、过短或布局不符时返回 NULL。
+ */
+ParkingShmReader *parking_shm_open(const char *path);
+
+/**
+ * @brief 解除映射并释放读者。
+ * @param reader 要释放的读者，可以为 NULL。
+ */
+void parking_shm_close(ParkingShmReader *reader);
+
+/**
+ * @brief 读取一份一致的计数器。
+ * @param reader 目标读者。
+ * @param[out] counters 接收计数器。
+ * @return 成功返回 0；参数无效返回 -1；重试 PARKING_SHM_READ_ATTEMPTS 次
+ *         仍遇到发布进行中返回 -2，稍后再读即可。
+ */
+int parking_shm_read_counters(ParkingShmReader *reader, ShmCounters *counters);
+
+/**
+ * @brief 按编号读取一个车位的热字段。
+ * @details 在已发布的行中顺序查找。
+ * @param reader 目标读者。
+ * @param slot_id 车位编号。
+ * @param[out] row 接收该行。
+ * @return 成功返回 0；参数无效返回 -1；发布进行中返回 -2；没有该车位返回 -3。
+ */
+int parking_shm_read_slot(ParkingShmReader *reader, int slot_id,
+                          ShmSlotRow *row);
+
+/**
+ * @brief 读取一份一致的全部行。
+ * @param reader 目标读者。
+ * @param[out] rows 接收行的数组。
+ * @param max rows 的容量；已发布的行更多时只复制前 max 行。
+ * @param[out] count 接收复制的行数。
+ * @return 成功返回 0；参数无效返回 -1；发布进行中返回 -2。
+ */
+int parking_shm_read_rows(ParkingShmReader *reader, ShmSlotRow *rows, int max,
+                          int *count);
+
+#endif /* PARKING_SHM_H */
@@ -0,0 +1,309 @@
+/**
+ * @file parking_slot_export.c
+ * @brief 车位数据流式导出实现文件
+ * @details
+ * 该文件实现了 parking_slot_export.h 中声明的 CSV / NDJSON 导出。
+ * 每个车位格式化之前先保证缓冲区至少剩余 EXPORT_ROW_MAX 字节，
+ * 一行之内的写入因此不再逐字节检查边界。
+ * 表头与每行的编码器都由 parking_slot_schema.h 的导出字段表展开生成。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_slot_export.h"
+#include "parking_slot_schema.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define EXPORT_ROW_MAX 4096 /**< 单个车位格式化后的最大字节数 */
+
+/** 全部文本字段按 JSON 最坏情况（\u00XX，6 倍）转义后的字节数。 */
+#define EXPORT_TEXT_WORST (PARKING_SLOT_TEXT_WIDTH * 6)
+
+/** 编译期检查：再加上字段名与数字，一行也不会超过 EXPORT_ROW_MAX。 */
+typedef char export_row_check[EXPORT_TEXT_WORST + 512 <= EXPORT_ROW_MAX ? 1
+                                                                        : -1];
+
+/** (展开辅助宏) 表头中的一个字段名及其后的逗号。 */
+#define CSV_HEADER_NAME(member, kind, width, tag, occupant) #member ","
+
+/** CSV 的表头行，末尾多出的一个逗号在写出时以行尾替换。 */
+static const char csv_header[] = PARKING_SLOT_EXPORT_FIELDS(CSV_HEADER_NAME);
+
+/**
+ * @brief 一次导出使用的输出缓冲区。
+ */
+typedef struct ExportBuffer {
+  FILE *out;   /**< 输出流。 */
+  char *data;  /**< 缓冲区。 */
+  size_t used; /**< 已写入缓冲区的字节数。 */
+  int failed;  /**< 非 0 表示 fwrite 已失败。 */
+} ExportBuffer;
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 把缓冲区内容整块写入输出流。
+ * @param buffer 目标缓冲区。
+ */
+static void export_flush(ExportBuffer *buffer) {
+  if (buffer->used > 0 && !buffer->failed &&
+      fwrite(buffer->data, 1, buffer->used, buffer->out) != buffer->used) {
+    buffer->failed = 1;
+  }
+  buffer->used = 0;
+}
+
+/**
+ * @brief (静态辅助函数) 保证缓冲区能再容纳一个完整的车位。
+ * @param buffer 目标缓冲区。
+ */
+static void export_reserve_row(ExportBuffer *buffer) {
+  if (buffer->used + EXPORT_ROW_MAX > SLOT_EXPORT_BUFFER_BYTES) {
+    export_flush(buffer);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 追加一段字节。
+ * @param buffer 目标缓冲区。
+ * @param text 源字节。
+ * @param length 字节数。
+ */
+static void export_put(ExportBuffer *buffer, const char *text, size_t length) {
+  memcpy(buffer->data + buffer->used, text, length);
+  buffer->used += length;
+}
+
+/**
+ * @brief (静态辅助函数) 追加一个以 NUL 结尾的字符串常量。
+ * @param buffer 目标缓冲区。
+ * @param text 源字符串。
+ */
+static void export_puts(ExportBuffer *buffer, const char *text) {
+  export_put(buffer, text, strlen(text));
+}
+
+/**
+ * @brief (静态辅助函数) 以十进制追加一个时间戳。
+ * @details 直接对 time_t 逐位取余，time_t 为 32 位或 64 位时都不会截断；
+ *          负数按每一位的余数取绝对值，最小值也不会溢出。
+ * @param buffer 目标缓冲区。
+ * @param value 要写出的值。
+ */
+static void export_put_time(ExportBuffer *buffer, time_t value) {
+  char digits[24];
+  int count = 0;
+  int negative = value < 0;
+
+  do {
+    int digit = (int)(value % 10);
+
+    digits[count++] = (char)('0' + (digit < 0 ? -digit : digit));
+    value /= 10;
+  } while (value != 0);
+  if (negative) {
+    buffer->data[buffer->used++] = '-';
+  }
+  while (count > 0) {
+    buffer->data[buffer->used++] = digits[--count];
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 以十进制追加一个整数。
+ * @param buffer 目标缓冲区。
+ * @param value 要写出的值。
+ */
+static void export_put_int(ExportBuffer *buffer, int value) {
+  export_put_time(buffer, (time_t)value);
+}
+
+/**
+ * @brief (静态辅助函数) 按 RFC 4180 追加一个 CSV 字段。
+ * @details 只有含逗号、引号或换行的字段才加引号，字段内的引号写两次。
+ * @param buffer 目标缓冲区。
+ * @param text 字段文本。
+ */
+static void export_put_csv_field(ExportBuffer *buffer, const char *text) {
+  const char *p;
+
+  if (strpbrk(text, ",\"\r\n") == NULL) {
+    export_puts(buffer, text);
+    return;
+  }
+  buffer->data[buffer->used++] = '"';
+  for (p = text; *p != '\0'; p++) {
+    if (*p == '"') {
+      buffer->data[buffer->used++] = '"';
+    }
+    buffer->data[buffer->used++] = *p;
+  }
+  buffer->data[buffer->used++] = '"';
+}
+
+/**
+ * @brief (静态辅助函数) 追加一个带引号并转义的 JSON 字符串。
+ * @details 引号、反斜杠与控制字符转义，其余字节（含 UTF-8 多字节序列）原样写出。
+ * @param buffer 目标缓冲区。
+ * @param text 字符串文本。
+ */
+static void export_put_json_string(ExportBuffer *buffer, const char *text) {
+  static const char hex[] = "0123456789abcdef";
+  const unsigned char *p;
+
+  buffer->data[buffer->used++] = '"';
+  for (p = (const unsigned char *)text; *p != '\0'; p++) {
+    if (*p == '"' || *p == '\\') {
+      buffer->data[buffer->used++] = '\\';
+      buffer->data[buffer->used++] = (char)*p;
+    } else if (*p < 0x20) {
+      export_put(buffer, "\\u00", 4);
+      buffer->data[buffer->used++] = hex[*p >> 4];
+      buffer->data[buffer->used++] = hex[*p & 0x0F];
+    } else {
+      buffer->data[buffer->used++] = (char)*p;
+    }
+  }
+  buffer->data[buffer->used++] = '"';
+}
+
+/**
+ * @brief (静态辅助函数) 取车位状态的导出名称。
+ * @param slot 目标车位。
+ * @return "occupied" 或 "free"。
+ */
+static const char *status_name(const ParkingSlot *slot) {
+  return slot->status == OCCUPIED_STATUS ? "occupied" : "free";
+}
+
+/**
+ * @brief (静态辅助函数) 取停车类型的导出名称。
+ * @param slot 目标车位。
+ * @return "visitor" 或 "resident"。
+ */
+static const char *type_name(const ParkingSlot *slot) {
+  return slot->type == VISITOR_TYPE ? "visitor" : "resident";
+}
+
+/* CSV 各种类字段的输出：名称与数字不含需要加引号的字符 */
+#define CSV_PUT_INT(buffer, slot, member) export_put_int(buffer, (slot)->member)
+#define CSV_PUT_TIME(buffer, slot, member)                                     \
+  export_put_time(buffer, (slot)->member)
+#define CSV_PUT_STATUS(buffer, slot, member)                                   \
+  export_puts(buffer, status_name(slot))
+#define CSV_PUT_TYPE(buffer, slot, member) export_puts(buffer, type_name(slot))
+#define CSV_PUT_LOCATION(buffer, slot, member)                                 \
+  export_put_csv_field(buffer, (slot)->member)
+#define CSV_PUT_TEXT(buffer, slot, member)                                     \
+  export_put_csv_field(buffer, (slot)->member)
+
+/** (展开辅助宏) 写出一个字段及其后的逗号。 */
+#define CSV_PUT_FIELD(member, kind, width, tag, occupant)                      \
+  CSV_PUT_##kind(buffer, slot, member);                                        \
+  buffer->data[buffer->used++] = ',';
+
+/**
+ * @brief (静态辅助函数) 把一个车位写成一行 CSV。
+ * @details 每个字段之后都写一个逗号，最后一个逗号改写为行尾。
+ * @param buffer 目标缓冲区（已保证剩余 EXPORT_ROW_MAX 字节）。
+ * @param slot 要写出的车位。
+ */
+static void export_csv_row(ExportBuffer *buffer, const ParkingSlot *slot) {
+  PARKING_SLOT_EXPORT_FIELDS(CSV_PUT_FIELD)
+  buffer->used--;
+  export_put(buffer, "\r\n", 2);
+}
+
+/* JSON 各种类字段的输出：状态与类型写成字符串 */
+#define JSON_PUT_INT(buffer, slot, member)                                     \
+  export_put_int(buffer, (slot)->member)
+#define JSON_PUT_TIME(buffer, slot, member)                                    \
+  export_put_time(buffer, (slot)->member)
+#define JSON_PUT_STATUS(buffer, slot, member)                                  \
+  export_put_json_string(buffer, status_name(slot))
+#define JSON_PUT_TYPE(buffer, slot, member)                                    \
+  export_put_json_string(buffer, type_name(slot))
+#define JSON_PUT_LOCATION(buffer, slot, member)                                \
+  export_put_json_string(buffer, (slot)->member)
+#define JSON_PUT_TEXT(buffer, slot, member)                                    \
+  export_put_json_string(buffer, (slot)->member)
+
+/** (展开辅助宏) 写出逗号、带引号的字段名与字段值。 */
+#define JSON_PUT_FIELD(member, kind, width, tag, occupant)                     \
+  export_put(buffer, ",\"" #member "\":", sizeof(",\"" #member "\":") - 1);   \
+  JSON_PUT_##kind(buffer, slot, member);
+
+/**
+ * @brief (静态辅助函数) 把一个车位写成一行 JSON 对象。
+ * @details 每个字段之前都写一个逗号，第一个逗号改写为左花括号。
+ * @param buffer 目标缓冲区（已保证剩余 EXPORT_ROW_MAX 字节）。
+ * @param slot 要写出的车位。
+ */
+static void export_json_row(ExportBuffer *buffer, const ParkingSlot *slot) {
+  size_t start = buffer->used;
+
+  PARKING_SLOT_EXPORT_FIELDS(JSON_PUT_FIELD)
+  buffer->data[start] = '{';
+  export_put(buffer, "}\n", 2);
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 按稠密车位表顺序把满足筛选条件的车位导出到流。
+ * @param lot 要导出的停车场。
+ * @param filter 筛选条件。
+ * @param format 导出格式。
+ * @param out 已打开的输出流。
+ * @return 导出的车位数；参数无效或写入失败返回 -1，内存不足返回 -2。
+ */
+long export_parking_slots(ParkingLot *lot, SlotFilter filter,
+                          SlotExportFormat format, FILE *out) {
+  ExportBuffer buffer;
+  SlotCursor cursor;
+  ParkingSlot *slot;
+  long count = 0;
+
+  if (lot == NULL || out == NULL ||
+      (format != SLOT_EXPORT_CSV && format != SLOT_EXPORT_NDJSON)) {
+    return -1;
+  }
+  buffer.data = (char *)parking_memory_alloc(&lot->memory, PARKING_MEMORY_IO,
+                                             SLOT_EXPORT_BUFFER_BYTES);
+  if (buffer.data == NULL) {
+    return -2;
+  }
+  buffer.out = out;
+  buffer.used = 0;
+  buffer.failed = 0;
+
+  if (format == SLOT_EXPORT_CSV) {
+    export_put(&buffer, csv_header, sizeof(csv_header) - 2);
+    export_put(&buffer, "\r\n", 2);
+  }
+  slot_cursor_init(&cursor, lot, filter);
+  while ((slot = slot_cursor_next(&cursor)) != NULL && !buffer.failed) {
+    export_reserve_row(&buffer);
+    if (format == SLOT_EXPORT_CSV) {
+      export_csv_row(&buffer, slot);
+    } else {
+      export_json_row(&buffer, slot);
+    }
+    count++;
+  }
+  export_flush(&buffer);
+  parking_memory_free(&lot->memory, buffer.data);
+
+  if (buffer.failed || fflush(out) != 0) {
+    return -1;
+  }
+  return count;
+}
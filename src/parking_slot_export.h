@@ -0,0 +1,66 @@
+#ifndef PARKING_SLOT_EXPORT_H
+#define PARKING_SLOT_EXPORT_H
+
+#include <stdio.h>
+
+#include "parking_data.h"
+
+/**
+ * @file parking_slot_export.h
+ * @brief 车位数据的流式 CSV / NDJSON 导出接口声明。
+ * @details
+ * 导出由 SlotCursor 驱动，逐个车位格式化进一块 SLOT_EXPORT_BUFFER_BYTES
+ * 字节的输出缓冲区，写满后整块 fwrite；不建立车位指针数组，
+ * 也不经过 printf，数字与转义都在缓冲区中直接生成。
+ *
+ * 两种格式的字段相同，依次为：
+ * slot_id, location, status, type, owner_name, license_plate, contact,
+ * entry_time, exit_time, resident_due_date。
+ * status 为 "free" 或 "occupied"，type 为 "resident" 或 "visitor"，
+ * 时间为 Unix 时间戳（秒），未设置时为 0。
+ * - CSV：首行为字段名，之后每个车位一行（RFC 4180，含逗号、引号或换行的
+ *   字段加引号，引号写两次），行尾为 "\r\n"。
+ * - NDJSON：每个车位一个 JSON 对象占一行，行尾为 "\n"。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define SLOT_EXPORT_BUFFER_BYTES 1048576 /**< 导出输出缓冲区的字节数 */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 导出格式。
+ */
+typedef enum {
+  SLOT_EXPORT_CSV = 0,   /**< 带表头的 CSV。 */
+  SLOT_EXPORT_NDJSON = 1 /**< 每行一个 JSON 对象。 */
+} SlotExportFormat;
+
+/**
+ *********************************************************************************
+ *                              车位导出API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 按稠密车位表顺序把满足筛选条件的车位导出到流。
+ * @note 须在读锁（或写锁）内调用；遍历期间的限制与 SlotCursor 相同。
+ * @param lot 要导出的停车场。
+ * @param filter 筛选条件。
+ * @param format 导出格式。
+ * @param out 已打开的输出流，函数返回前缓冲区已全部写入 out。
+ * @return 导出的车位数；参数无效或写入失败返回 -1，内存不足返回 -2。
+ */
+long export_parking_slots(ParkingLot *lot, SlotFilter filter,
+                          SlotExportFormat format, FILE *out);
+
+#endif /* PARKING_SLOT_EXPORT_H */
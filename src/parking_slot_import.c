@@ -0,0 +1,426 @@
+/**
+ * @file parking_slot_import.c
+ * @brief 车位清单流式导入实现文件
+ * @details
+ * 该文件实现了 parking_slot_import.h 中声明的 CSV 导入。
+ * 读入的块中用 memchr 找行尾，跨块的半行移到缓冲区开头与下一块拼接；
+ * 行内同样用 memchr 找逗号与引号，字段直接解码进位置文本缓冲区。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_slot_import.h"
+#include "parking_validate.h"
+
+#define IMPORT_INITIAL_ROWS 1024 /**< 车位数组的初始容量 */
+#define IMPORT_ID_FIELD_MAX 16   /**< 编号字段的缓冲区字节数 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 记录当前行的错误。
+ * @param import 解析结果。
+ * @param error 错误原因。
+ */
+static void record_issue(SlotImport *import, SlotImportError error) {
+  if (import->error_count < SLOT_IMPORT_MAX_ERRORS) {
+    import->issues[import->error_count].line = import->line_count;
+    import->issues[import->error_count].error = error;
+  }
+  import->error_count++;
+}
+
+/**
+ * @brief (静态辅助函数) 读取一个字段并解码到 out。
+ * @details 带引号的字段去掉引号，把写两次的引号还原为一个。
+ *          超出 capacity - 1 的部分不写入，但仍计入 *length，
+ *          调用者据此判断字段是否过长。
+ * @param[in,out] cursor 字段起点，返回时指向字段后的逗号或行尾。
+ * @param end 行尾（不含）。
+ * @param out 接收解码结果的缓冲区。
+ * @param capacity out 的字节数。
+ * @param[out] length 解码后的字段长度。
+ * @return SLOT_IMPORT_OK 或 SLOT_IMPORT_BAD_QUOTE。
+ */
+static SlotImportError read_field(const char **cursor, const char *end,
+                                  char *out, size_t capacity,
+                                  size_t *length) {
+  const char *p = *cursor;
+  const char *stop;
+  size_t used = 0;
+  size_t span;
+
+  if (p < end && *p == '"') {
+    p++;
+    for (;;) {
+      stop = (const char *)memchr(p, '"', (size_t)(end - p));
+      if (stop == NULL) {
+        return SLOT_IMPORT_BAD_QUOTE;
+      }
+      span = (size_t)(stop - p);
+      if (used + span < capacity) {
+        memcpy(out + used, p, span);
+      }
+      used += span;
+      if (stop + 1 < end && stop[1] == '"') {
+        if (used + 1 < capacity) {
+          out[used] = '"';
+        }
+        used++;
+        p = stop + 2;
+        continue;
+      }
+      p = stop + 1;
+      break;
+    }
+    if (p < end && *p != ',') {
+      return SLOT_IMPORT_BAD_QUOTE;
+    }
+  } else {
+    stop = (const char *)memchr(p, ',', (size_t)(end - p));
+    if (stop == NULL) {
+      stop = end;
+    }
+    used = (size_t)(stop - p);
+    if (used < capacity) {
+      memcpy(out, p, used);
+    }
+    p = stop;
+  }
+  if (used < capacity) {
+    out[used] = '\0';
+  }
+  *cursor = p;
+  *length = used;
+  return SLOT_IMPORT_OK;
+}
+
+/**
+ * @brief (静态辅助函数) 把十进制编号字段转换为整数。
+ * @param text 字段文本。
+ * @param length 字段长度。
+ * @param[out] slot_id 接收编号。
+ * @return 是 1..VALIDATE_MAX_SLOT_ID 之内的整数返回 1，否则返回 0。
+ */
+static int parse_slot_id(const char *text, size_t length, int *slot_id) {
+  long value = 0;
+  size_t i;
+
+  if (length == 0 || length > 9) {
+    return 0;
+  }
+  for (i = 0; i < length; i++) {
+    if (text[i] < '0' || text[i] > '9') {
+      return 0;
+    }
+    value = value * 10 + (text[i] - '0');
+  }
+  if (validate_slot_id_value((int)value) != VALIDATION_OK) {
+    return 0;
+  }
+  *slot_id = (int)value;
+  return 1;
+}
+
+/**
+ * @brief (静态辅助函数) 保证还能再追加一个车位。
+ * @param import 解析结果。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int reserve_row(SlotImport *import) {
+  int capacity;
+  int *slot_ids;
+  long *lines;
+  size_t *offsets;
+  char *text;
+
+  if (import->text_capacity - import->text_used < MAX_LOCATION_LEN) {
+    size_t text_capacity = import->text_capacity == 0
+                               ? (size_t)IMPORT_INITIAL_ROWS * 16
+                               : import->text_capacity * 2;
+
+    text = (char *)realloc(import->text, text_capacity);
+    if (text == NULL) {
+      return -1;
+    }
+    import->text = text;
+    import->text_capacity = text_capacity;
+  }
+  if (import->count < import->capacity) {
+    return 0;
+  }
+  capacity = import->capacity == 0 ? IMPORT_INITIAL_ROWS : import->capacity * 2;
+  slot_ids = (int *)realloc(import->slot_ids, capacity * sizeof(int));
+  if (slot_ids == NULL) {
+    return -1;
+  }
+  import->slot_ids = slot_ids;
+  lines = (long *)realloc(import->lines, capacity * sizeof(long));
+  if (lines == NULL) {
+    return -1;
+  }
+  import->lines = lines;
+  offsets = (size_t *)realloc(import->location_offsets,
+                              capacity * sizeof(size_t));
+  if (offsets == NULL) {
+    return -1;
+  }
+  import->location_offsets = offsets;
+  import->capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 解析一行并追加结果。
+ * @param import 解析结果。
+ * @param line 行首。
+ * @param length 行长（不含 "\n"）。
+ * @return 成功（含有误被记录的行）返回 0，内存不足返回 -1。
+ */
+static int import_line(SlotImport *import, const char *line, size_t length) {
+  char id_text[IMPORT_ID_FIELD_MAX];
+  const char *cursor = line;
+  const char *end;
+  char *location;
+  size_t id_length;
+  size_t location_length;
+  SlotImportError error;
+  int slot_id;
+
+  import->line_count++;
+  if (length > 0 && line[length - 1] == '\r') {
+    length--;
+  }
+  if (length == 0) {
+    return 0;
+  }
+  if (length > SLOT_IMPORT_MAX_LINE) {
+    record_issue(import, SLOT_IMPORT_LINE_TOO_LONG);
+    return 0;
+  }
+  end = line + length;
+
+  error = read_field(&cursor, end, id_text, sizeof(id_text), &id_length);
+  if (error != SLOT_IMPORT_OK) {
+    record_issue(import, error);
+    return 0;
+  }
+  if (import->line_count == 1 && id_length == 7 &&
+      memcmp(id_text, "slot_id", 7) == 0) {
+    return 0;
+  }
+  if (cursor == end) {
+    record_issue(import, SLOT_IMPORT_MISSING_FIELD);
+    return 0;
+  }
+  cursor++;
+
+  if (reserve_row(import) != 0) {
+    return -1;
+  }
+  location = import->text + import->text_used;
+  error = read_field(&cursor, end, location, MAX_LOCATION_LEN,
+                     &location_length);
+  if (error == SLOT_IMPORT_OK &&
+      !parse_slot_id(id_text, id_length, &slot_id)) {
+    error = SLOT_IMPORT_BAD_ID;
+  }
+  if (error == SLOT_IMPORT_OK &&
+      (location_length >= MAX_LOCATION_LEN ||
+       validate_location_text(location) != VALIDATION_OK)) {
+    error = SLOT_IMPORT_BAD_LOCATION;
+  }
+  if (error != SLOT_IMPORT_OK) {
+    record_issue(import, error);
+    return 0;
+  }
+
+  import->slot_ids[import->count] = slot_id;
+  import->lines[import->count] = import->line_count;
+  import->location_offsets[import->count] = import->text_used;
+  import->text_used += location_length + 1;
+  import->count++;
+  return 0;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 把解析结果初始化为空。
+ * @param import 目标结构。
+ */
+void slot_import_init(SlotImport *import) {
+  if (import != NULL) {
+    memset(import, 0, sizeof(SlotImport));
+  }
+}
+
+/**
+ * @brief 读取并解析整个输入流。
+ * @details 每读入一块，先处理其中所有完整的行，再把末尾的半行移到
+ *          缓冲区开头；半行已超过 SLOT_IMPORT_MAX_LINE 时记为一行过长，
+ *          并丢弃到下一个行尾为止。
+ * @param import 解析结果。
+ * @param in 输入流。
+ * @return 0 全部有效，-1 参数无效或读取失败，-2 内存不足，-3 有格式错误。
+ */
+int slot_import_parse(SlotImport *import, FILE *in) {
+  char *buffer;
+  const char *p;
+  const char *end;
+  const char *newline;
+  size_t carry = 0;
+  size_t got;
+  int skipping = 0;
+  int eof = 0;
+  int result = 0;
+
+  if (import == NULL || in == NULL) {
+    return -1;
+  }
+  buffer = (char *)malloc(SLOT_IMPORT_CHUNK_BYTES);
+  if (buffer == NULL) {
+    return -2;
+  }
+
+  while (!eof && result == 0) {
+    got = fread(buffer + carry, 1, SLOT_IMPORT_CHUNK_BYTES - carry, in);
+    if (got < SLOT_IMPORT_CHUNK_BYTES - carry) {
+      if (ferror(in)) {
+        result = -1;
+        break;
+      }
+      eof = 1;
+    }
+    p = buffer;
+    end = buffer + carry + got;
+    while (result == 0 && (newline = (const char *)memchr(
+                               p, '\n', (size_t)(end - p))) != NULL) {
+      if (skipping) {
+        skipping = 0;
+      } else if (import_line(import, p, (size_t)(newline - p)) != 0) {
+        result = -2;
+      }
+      p = newline + 1;
+    }
+
+    carry = (size_t)(end - p);
+    if (result != 0 || skipping) {
+      carry = 0;
+    } else if (eof) {
+      if (carry > 0 && import_line(import, p, carry) != 0) {
+        result = -2;
+      }
+    } else if (carry > SLOT_IMPORT_MAX_LINE) {
+      import->line_count++;
+      record_issue(import, SLOT_IMPORT_LINE_TOO_LONG);
+      skipping = 1;
+      carry = 0;
+    } else {
+      memmove(buffer, p, carry);
+    }
+  }
+  free(buffer);
+
+  if (result != 0) {
+    return result;
+  }
+  return import->error_count > 0 ? -3 : 0;
+}
+
+/**
+ * @brief 把解析出的车位一次加入停车场。
+ * @param lot 目标停车场。
+ * @param import 解析结果，须没有格式错误。
+ * @param[out] conflict_line 返回 -2 时接收重复编号所在的行号，可以为 NULL。
+ * @return 成功返回 0，参数无效或解析有错误返回 -1，编号重复返回 -2，
+ *         内存不足返回 -3。
+ */
+int slot_import_commit(ParkingLot *lot, SlotImport *import,
+                       long *conflict_line) {
+  const char **locations;
+  int conflict_id = 0;
+  int first = -1;
+  int second = -1;
+  int result;
+  int i;
+
+  if (lot == NULL || import == NULL || import->error_count > 0) {
+    return -1;
+  }
+  if (import->count == 0) {
+    return 0;
+  }
+  locations = (const char **)malloc((size_t)import->count * sizeof(char *));
+  if (locations == NULL) {
+    return -3;
+  }
+  for (i = 0; i < import->count; i++) {
+    locations[i] = import->text + import->location_offsets[i];
+  }
+  result = create_and_add_slots(lot, import->slot_ids, locations,
+                                import->count, &conflict_id);
+  free(locations);
+
+  if (result == -2 && conflict_line != NULL) {
+    for (i = 0; i < import->count && second < 0; i++) {
+      if (import->slot_ids[i] != conflict_id) {
+        continue;
+      }
+      if (first < 0) {
+        first = i;
+      } else {
+        second = i;
+      }
+    }
+    if (second < 0 || find_slot_by_id(lot, conflict_id) != NULL) {
+      second = first;
+    }
+    *conflict_line = second >= 0 ? import->lines[second] : 0;
+  }
+  return result;
+}
+
+/**
+ * @brief 释放解析结果持有的内存。
+ * @param import 目标结构，可以为 NULL。
+ */
+void slot_import_free(SlotImport *import) {
+  if (import == NULL) {
+    return;
+  }
+  free(import->slot_ids);
+  free(import->lines);
+  free(import->location_offsets);
+  free(import->text);
+  slot_import_init(import);
+}
+
+/**
+ * @brief 取错误原因的中文描述。
+ * @param error 错误原因。
+ * @return 指向静态字符串的指针。
+ */
+const char *slot_import_error_text(SlotImportError error) {
+  switch (error) {
+  case SLOT_IMPORT_OK:
+    return "无错误";
+  case SLOT_IMPORT_BAD_ID:
+    return "车位编号无效";
+  case SLOT_IMPORT_BAD_LOCATION:
+    return "车位位置无效";
+  case SLOT_IMPORT_MISSING_FIELD:
+    return "缺少位置字段";
+  case SLOT_IMPORT_BAD_QUOTE:
+    return "引号不匹配";
+  case SLOT_IMPORT_LINE_TOO_LONG:
+    return "行过长";
+  default:
+    return "未知错误";
+  }
+}
@@ -0,0 +1,131 @@
+#ifndef PARKING_SLOT_IMPORT_H
+#define PARKING_SLOT_IMPORT_H
+
+#include <stdio.h>
+
+#include "parking_data.h"
+
+/**
+ * @file parking_slot_import.h
+ * @brief 从外部系统的 CSV 车位清单流式导入车位的接口声明。
+ * @details
+ * 导入分两步：slot_import_parse 不持锁读取并解析整个输入，
+ * slot_import_commit 在写锁内把解析结果一次交给 create_and_add_slots，
+ * 解析文件期间入场、出场不受影响。
+ *
+ * 输入每行一个车位，前两个字段依次为 slot_id 与 location，其余字段忽略，
+ * 因此 export_parking_slots 写出的 CSV 可以直接导入。
+ * - 字段按 RFC 4180 以逗号分隔，可以加引号，引号内的引号写两次；
+ * - 行尾可以是 "\n" 或 "\r\n"，最后一行可以没有行尾；空行忽略；
+ * - 第一行的第一个字段为 "slot_id" 时视为表头跳过。
+ *
+ * 输入按 SLOT_IMPORT_CHUNK_BYTES 大块读取，行尾与分隔符用 memchr 定位，
+ * 不逐行调用 fgets。格式有误的行不会中断解析：全部行读完后统一报告，
+ * 前 SLOT_IMPORT_MAX_ERRORS 个错误附带行号。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define SLOT_IMPORT_CHUNK_BYTES 1048576 /**< 每次读取的字节数 */
+#define SLOT_IMPORT_MAX_LINE 4096       /**< 一行的最大字节数（不含行尾） */
+#define SLOT_IMPORT_MAX_ERRORS 8        /**< 附带行号记录的错误数 */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一行被拒绝的原因。
+ */
+typedef enum {
+  SLOT_IMPORT_OK = 0,            /**< 没有错误。 */
+  SLOT_IMPORT_BAD_ID = 1,        /**< 车位编号不是 1..99999 的整数。 */
+  SLOT_IMPORT_BAD_LOCATION = 2,  /**< 位置为空、过长或含有不允许的字符。 */
+  SLOT_IMPORT_MISSING_FIELD = 3, /**< 少于两个字段。 */
+  SLOT_IMPORT_BAD_QUOTE = 4,     /**< 引号未闭合或闭合后紧跟其他字符。 */
+  SLOT_IMPORT_LINE_TOO_LONG = 5  /**< 一行超过 SLOT_IMPORT_MAX_LINE 字节。 */
+} SlotImportError;
+
+/**
+ * @brief 一个有误的行。
+ */
+typedef struct SlotImportIssue {
+  long line;             /**< 行号，从 1 开始。 */
+  SlotImportError error; /**< 被拒绝的原因。 */
+} SlotImportIssue;
+
+/**
+ * @brief 一次导入的解析结果。
+ * @details 由 slot_import_init 初始化，使用后以 slot_import_free 释放。
+ */
+typedef struct SlotImport {
+  int *slot_ids;            /**< 解析出的车位编号。 */
+  long *lines;              /**< 每个车位所在的行号。 */
+  size_t *location_offsets; /**< 每个车位的位置在 text 中的偏移。 */
+  char *text;               /**< 以 NUL 分隔的位置文本。 */
+  size_t text_used;         /**< text 已用的字节数。 */
+  size_t text_capacity;     /**< text 的容量。 */
+  int count;                /**< 解析出的车位数。 */
+  int capacity;             /**< 车位数组的容量。 */
+  long line_count;          /**< 读取的总行数。 */
+  long error_count;         /**< 有误的行数。 */
+  SlotImportIssue issues[SLOT_IMPORT_MAX_ERRORS]; /**< 前几个有误的行。 */
+} SlotImport;
+
+/**
+ *********************************************************************************
+ *                              车位导入API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 把解析结果初始化为空。
+ * @param import 目标结构。
+ */
+void slot_import_init(SlotImport *import);
+
+/**
+ * @brief 读取并解析整个输入流，追加到解析结果中。
+ * @note 不访问任何停车场，调用时不需要持锁。
+ * @param import 由 slot_import_init 初始化的解析结果。
+ * @param in 已打开的输入流。
+ * @return 全部行有效返回 0；参数无效或读取失败返回 -1；内存不足返回 -2；
+ *         有格式错误的行返回 -3（解析仍会读完输入，详情见 error_count
+ *         与 issues）。
+ */
+int slot_import_parse(SlotImport *import, FILE *in);
+
+/**
+ * @brief 把解析出的车位一次加入停车场，要么全部加入，要么一个也不加入。
+ * @note 须在写锁内调用。
+ * @param lot 目标停车场。
+ * @param import 解析结果，须没有格式错误（error_count 为 0）。
+ * @param[out] conflict_line 返回 -2 时接收重复编号所在的行号，可以为 NULL。
+ *             编号已在停车场中时为它在输入中第一次出现的行，
+ *             在输入中重复时为第二次出现的行。
+ * @return 成功（含没有车位）返回 0，参数无效或解析有错误返回 -1，
+ *         编号重复返回 -2，内存不足返回 -3。
+ */
+int slot_import_commit(ParkingLot *lot, SlotImport *import,
+                       long *conflict_line);
+
+/**
+ * @brief 释放解析结果持有的内存，并重新初始化为空。
+ * @param import 目标结构，可以为 NULL。
+ */
+void slot_import_free(SlotImport *import);
+
+/**
+ * @brief 取错误原因的中文描述。
+ * @param error 错误原因。
+ * @return 指向静态字符串的指针。
+ */
+const char *slot_import_error_text(SlotImportError error);
+
+#endif /* PARKING_SLOT_IMPORT_H */
@@ -0,0 +1,108 @@
+#ifndef PARKING_SLOT_SCHEMA_H
+#define PARKING_SLOT_SCHEMA_H
+
+#include "parking_data.h"
+
+/**
+ * @file parking_slot_schema.h
+ * @brief 车位字段描述表（X-macro）。
+ * @details
+ * 车位的每个持久化字段在这里只描述一次，文本数据文件、定长快照记录与
+ * CSV / NDJSON 导出的编解码器都由同一张表展开生成：每个编解码器为每种
+ * 字段种类定义一个宏，再对字段列表展开，得到逐字段展开的专用代码，
+ * 加载循环中不再按字段下标 switch。
+ *
+ * 每个字段描述宏接受一个参数 X，以如下实参调用它：
+ * X(成员名, 种类, 文本宽度, 快照偏移标记, 仅在场有效)
+ * - 成员名：ParkingSlot 的成员，同时作为导出的字段名；
+ * - 种类：INT、LOCATION、TEXT、TYPE、STATUS、TIME 之一，
+ *   编解码器据此拼接出 <前缀>_<种类> 形式的宏名；
+ * - 文本宽度：文本字段的长度上限（含结尾 NUL），其他字段为 0；
+ * - 快照偏移标记：与 SNAP_OFF_ 拼接得到快照记录中的偏移；
+ * - 仅在场有效：为 1 的字段在空闲车位上一律保存为空串或 0。
+ *
+ * 文本文件与导出格式的字段顺序不同，且都是已经发布的格式，因此另有两个
+ * 只列出字段描述宏的顺序表。新增字段时在这里加一个描述宏并列入两个顺序表，
+ * 再为 ParkingSlot 加成员、为快照记录分配偏移，各编解码器无需改动。
+ */
+
+/**
+ *********************************************************************************
+ *                                 字段描述
+ *********************************************************************************
+ */
+
+#define SLOT_FIELD_SLOT_ID(X) X(slot_id, INT, 0, SLOT_ID, 0)
+#define SLOT_FIELD_LOCATION(X)                                                 \
+  X(location, LOCATION, MAX_LOCATION_LEN, LOCATION, 0)
+#define SLOT_FIELD_OWNER_NAME(X) X(owner_name, TEXT, MAX_NAME_LEN, OWNER, 1)
+#define SLOT_FIELD_LICENSE_PLATE(X)                                            \
+  X(license_plate, TEXT, MAX_LICENSE_LEN, LICENSE, 1)
+#define SLOT_FIELD_CONTACT(X) X(contact, TEXT, MAX_CONTACT_LEN, CONTACT, 1)
+#define SLOT_FIELD_TYPE(X) X(type, TYPE, 0, TYPE, 0)
+#define SLOT_FIELD_ENTRY_TIME(X) X(entry_time, TIME, 0, ENTRY, 1)
+#define SLOT_FIELD_EXIT_TIME(X) X(exit_time, TIME, 0, EXIT, 1)
+#define SLOT_FIELD_STATUS(X) X(status, STATUS, 0, STATUS, 0)
+#define SLOT_FIELD_DUE_DATE(X) X(resident_due_date, TIME, 0, DUE, 1)
+
+/**
+ *********************************************************************************
+ *                                  顺序表
+ *********************************************************************************
+ */
+
+/** 文本数据文件 `SLOT|` 行的字段顺序。 */
+#define PARKING_SLOT_FIELDS(X)                                                 \
+  SLOT_FIELD_SLOT_ID(X)                                                        \
+  SLOT_FIELD_LOCATION(X)                                                       \
+  SLOT_FIELD_OWNER_NAME(X)                                                     \
+  SLOT_FIELD_LICENSE_PLATE(X)                                                  \
+  SLOT_FIELD_CONTACT(X)                                                        \
+  SLOT_FIELD_TYPE(X)                                                           \
+  SLOT_FIELD_ENTRY_TIME(X)                                                     \
+  SLOT_FIELD_EXIT_TIME(X)                                                      \
+  SLOT_FIELD_STATUS(X)                                                         \
+  SLOT_FIELD_DUE_DATE(X)
+
+/** CSV / NDJSON 导出的字段顺序。 */
+#define PARKING_SLOT_EXPORT_FIELDS(X)                                          \
+  SLOT_FIELD_SLOT_ID(X)                                                        \
+  SLOT_FIELD_LOCATION(X)                                                       \
+  SLOT_FIELD_STATUS(X)                                                         \
+  SLOT_FIELD_TYPE(X)                                                           \
+  SLOT_FIELD_OWNER_NAME(X)                                                     \
+  SLOT_FIELD_LICENSE_PLATE(X)                                                  \
+  SLOT_FIELD_CONTACT(X)                                                        \
+  SLOT_FIELD_ENTRY_TIME(X)                                                     \
+  SLOT_FIELD_EXIT_TIME(X)                                                      \
+  SLOT_FIELD_DUE_DATE(X)
+
+/**
+ *********************************************************************************
+ *                                 派生常量
+ *********************************************************************************
+ */
+
+/** (展开辅助宏) 每个字段计 1。 */
+#define SLOT_SCHEMA_ONE(member, kind, width, tag, occupant) +1
+/** (展开辅助宏) 累加文本宽度。 */
+#define SLOT_SCHEMA_WIDTH(member, kind, width, tag, occupant) +(width)
+
+/** 持久化字段的个数。 */
+#define PARKING_SLOT_FIELD_COUNT (0 PARKING_SLOT_FIELDS(SLOT_SCHEMA_ONE))
+
+/** 全部文本字段的长度上限之和（含各自的结尾 NUL）。 */
+#define PARKING_SLOT_TEXT_WIDTH (0 PARKING_SLOT_FIELDS(SLOT_SCHEMA_WIDTH))
+
+/**
+ * @brief 编译期检查：两个顺序表列出的字段个数与文本宽度必须一致。
+ */
+typedef char slot_schema_order_check
+    [((0 PARKING_SLOT_EXPORT_FIELDS(SLOT_SCHEMA_ONE)) ==
+          PARKING_SLOT_FIELD_COUNT &&
+      (0 PARKING_SLOT_EXPORT_FIELDS(SLOT_SCHEMA_WIDTH)) ==
+          PARKING_SLOT_TEXT_WIDTH)
+         ? 1
+         : -1];
+
+#endif /* PARKING_SLOT_SCHEMA_H */
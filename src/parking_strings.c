@@ -0,0 +1,538 @@
+/**
+ * @file parking_strings.c
+ * @brief 车位文本字段紧凑存储实现文件
+ * @details
+ * 该文件实现了 parking_strings.h 中声明的位置描述驻留池和分级文本内存池。
+ * 存储由 ParkingLot 持有，车位节点的文本字段只保存指向其中的指针；
+ * 尚未加入停车场的车位以 NULL 存储调用，退化为逐个 malloc/free。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_strings.h"
+
+/* ========================================================================== */
+/*                                 内部常量定义                               */
+/* ========================================================================== */
+
+#define STRING_POOL_MIN_CAPACITY 16 /**< 驻留池首次分配时的桶数组容量 */
+#define STRING_POOL_LOAD_NUM 7      /**< 最大负载因子分子（7/10） */
+#define STRING_POOL_LOAD_DEN 10     /**< 最大负载因子分母 */
+#define STRING_ARENA_MIN_BLOCK 16   /**< 最小级别的文本块字节数 */
+
+const char string_store_empty[] = "";
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 计算截断后的文本长度。
+ * @param text 源文本。
+ * @param max_len 字段长度上限（含结尾 NUL）。
+ * @return 不超过 max_len - 1 的文本字节数。
+ */
+static size_t bounded_length(const char *text, size_t max_len) {
+  size_t len = 0;
+
+  while (len + 1 < max_len && text[len] != '\0') {
+    len++;
+  }
+  return len;
+}
+
+/**
+ * @brief (静态辅助函数) 计算一段文本的 32 位 FNV-1a 哈希值。
+ * @param text 文本起始地址。
+ * @param len 文本字节数。
+ * @return 32 位哈希值。
+ */
+static unsigned long hash_text(const char *text, size_t len) {
+  const unsigned char *p = (const unsigned char *)text;
+  unsigned long h = 2166136261UL;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    h ^= (unsigned long)p[i];
+    h = (h * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  return h;
+}
+
+/**
+ * @brief (静态辅助函数) 单独分配一份截断后的副本。
+ * @param memory 分配来源，NULL 表示 C 堆。
+ * @param text 源文本。
+ * @param len 要复制的字节数。
+ * @return 新副本，内存不足返回 NULL。
+ */
+static char *heap_copy(ParkingMemory *memory, const char *text, size_t len) {
+  char *copy = (char *)parking_memory_alloc(memory, PARKING_MEMORY_STRINGS,
+                                            len + 1);
+
+  if (copy != NULL) {
+    memcpy(copy, text, len);
+    copy[len] = '\0';
+  }
+  return copy;
+}
+
+/**
+ * @brief (静态辅助函数) 由驻留文本的地址取回其头部。
+ * @param text 驻留池返回的文本。
+ * @return 所属的驻留条目。
+ */
+static InternedString *interned_header(const char *text) {
+  return (InternedString *)(void *)(text - offsetof(InternedString, text));
+}
+
+/**
+ * @brief (静态辅助函数) 将驻留池扩容到指定桶数并重新散列。
+ * @param memory 分配来源。
+ * @param pool 目标驻留池。
+ * @param capacity 新容量（2 的幂）。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int pool_resize(ParkingMemory *memory, StringPool *pool,
+                       size_t capacity) {
+  InternedString **entries;
+  size_t mask = capacity - 1;
+  size_t i;
+
+  entries = (InternedString **)parking_memory_calloc(
+      memory, PARKING_MEMORY_STRINGS, capacity, sizeof(InternedString *));
+  if (entries == NULL) {
+    return -1;
+  }
+  for (i = 0; i < pool->capacity; i++) {
+    InternedString *entry = pool->entries[i];
+    size_t pos;
+
+    if (entry == NULL) {
+      continue;
+    }
+    pos = (size_t)entry->hash & mask;
+    while (entries[pos] != NULL) {
+      pos = (pos + 1) & mask;
+    }
+    entries[pos] = entry;
+  }
+  parking_memory_free(memory, pool->entries);
+  pool->entries = entries;
+  pool->capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 从驻留池中删除一个条目。
+ * @details 删除后将同一探测链上的后续条目前移回填空位（backward shift）。
+ * @param pool 目标驻留池。
+ * @param entry 要删除的条目（必须在池中）。
+ */
+static void pool_remove(StringPool *pool, const InternedString *entry) {
+  size_t mask = pool->capacity - 1;
+  size_t pos = (size_t)entry->hash & mask;
+  size_t next;
+
+  while (pool->entries[pos] != entry) {
+    pos = (pos + 1) & mask;
+  }
+
+  next = (pos + 1) & mask;
+  while (pool->entries[next] != NULL) {
+    size_t home = (size_t)pool->entries[next]->hash & mask;
+    /* 若 home 不在 (pos, next] 的循环区间内，则该条目可以前移到 pos */
+    if (((next - home) & mask) >= ((next - pos) & mask)) {
+      pool->entries[pos] = pool->entries[next];
+      pos = next;
+    }
+    next = (next + 1) & mask;
+  }
+  pool->entries[pos] = NULL;
+  pool->count--;
+}
+
+/**
+ * @brief (静态辅助函数) 计算文本块所属的级别。
+ * @param size 文本块需要的字节数（含结尾 NUL）。
+ * @return 级别下标；超过最大级别返回 -1。
+ */
+static int arena_class(size_t size) {
+  int cls = 0;
+  size_t block = STRING_ARENA_MIN_BLOCK;
+
+  while (cls < STRING_ARENA_CLASS_COUNT) {
+    if (size <= block) {
+      return cls;
+    }
+    block <<= 1;
+    cls++;
+  }
+  return -1;
+}
+
+/**
+ * @brief (静态辅助函数) 从文本内存池中取出指定级别的一个块。
+ * @details 优先复用同级别的空闲块，其次从当前区块切分，区块用尽时分配新区块。
+ *          空闲块的首字节存放下一个空闲块的地址（以 memcpy 读写，不要求对齐）。
+ * @param memory 区块的分配来源。
+ * @param arena 目标内存池。
+ * @param cls 级别下标。
+ * @return 文本块，内存不足返回 NULL。
+ */
+static char *arena_alloc(ParkingMemory *memory, StringArena *arena, int cls) {
+  size_t block = (size_t)STRING_ARENA_MIN_BLOCK << cls;
+  StringArenaChunk *chunk;
+  char *result;
+
+  if (arena->free_lists[cls] != NULL) {
+    result = arena->free_lists[cls];
+    memcpy(&arena->free_lists[cls], result, sizeof(char *));
+    arena->live_blocks++;
+    return result;
+  }
+
+  chunk = arena->chunks;
+  if (chunk == NULL || chunk->used + block > STRING_ARENA_CHUNK_BYTES) {
+    chunk = (StringArenaChunk *)parking_memory_alloc(
+        memory, PARKING_MEMORY_STRINGS, sizeof(StringArenaChunk));
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->used = 0;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->chunk_count++;
+  }
+  result = chunk->data + chunk->used;
+  chunk->used += block;
+  arena->live_blocks++;
+  return result;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 初始化一个空的文本存储。
+ * @param store 目标存储。
+ * @param memory 之后分配驻留池与区块使用的内存对象，NULL 表示 C 堆。
+ */
+void string_store_init(StringStore *store, ParkingMemory *memory) {
+  int i;
+
+  store->locations.entries = NULL;
+  store->locations.capacity = 0;
+  store->locations.count = 0;
+  store->text.chunks = NULL;
+  for (i = 0; i < STRING_ARENA_CLASS_COUNT; i++) {
+    store->text.free_lists[i] = NULL;
+  }
+  store->text.chunk_count = 0;
+  store->text.live_blocks = 0;
+  store->memory = memory;
+  store->borrowed = NULL;
+  store->borrowed_size = 0;
+}
+
+/**
+ * @brief 释放文本存储持有的全部内存。
+ * @param store 目标存储。
+ */
+void string_store_free(StringStore *store) {
+  StringArenaChunk *chunk;
+  size_t i;
+
+  if (store == NULL) {
+    return;
+  }
+  for (i = 0; i < store->locations.capacity; i++) {
+    parking_memory_free(store->memory, store->locations.entries[i]);
+  }
+  parking_memory_free(store->memory, store->locations.entries);
+
+  chunk = store->text.chunks;
+  while (chunk != NULL) {
+    StringArenaChunk *next = chunk->next;
+    parking_memory_free(store->memory, chunk);
+    chunk = next;
+  }
+  string_store_init(store, store->memory);
+}
+
+/**
+ * @brief 驻留一段文本并增加其引用计数。
+ * @param store 目标存储；为 NULL 时单独 malloc 一份副本。
+ * @param text 源文本。
+ * @param max_len 目标字段的长度上限（含结尾 NUL），超出部分截断。
+ * @return 驻留后的文本；空文本返回 string_store_empty；内存不足返回 NULL。
+ */
+const char *string_store_intern(StringStore *store, const char *text,
+                                size_t max_len) {
+  if (text == NULL || max_len == 0) {
+    return NULL;
+  }
+  return string_store_intern_span(store, text, bounded_length(text, max_len),
+                                  max_len);
+}
+
+/**
+ * @brief 按给定长度驻留一段文本，源文本不必以 NUL 结尾。
+ * @param store 目标存储；为 NULL 时单独 malloc 一份副本。
+ * @param text 源文本起始地址，前 len 字节中不得含有 NUL。
+ * @param len 源文本的字节数。
+ * @param max_len 目标字段的长度上限（含结尾 NUL），超出部分截断。
+ * @return 驻留后的文本；空文本返回 string_store_empty；内存不足返回 NULL。
+ */
+const char *string_store_intern_span(StringStore *store, const char *text,
+                                     size_t len, size_t max_len) {
+  StringPool *pool;
+  InternedString *entry;
+  unsigned long hash;
+  size_t mask;
+  size_t pos;
+
+  if (text == NULL || max_len == 0) {
+    return NULL;
+  }
+  if (len > max_len - 1) {
+    len = max_len - 1;
+  }
+  if (len == 0) {
+    return string_store_empty;
+  }
+  if (store == NULL) {
+    return heap_copy(NULL, text, len);
+  }
+
+  pool = &store->locations;
+  hash = hash_text(text, len);
+  if (pool->capacity > 0) {
+    mask = pool->capacity - 1;
+    pos = (size_t)hash & mask;
+    while (pool->entries[pos] != NULL) {
+      entry = pool->entries[pos];
+      if (entry->hash == hash && strncmp(entry->text, text, len) == 0 &&
+          entry->text[len] == '\0') {
+        entry->refs++;
+        return entry->text;
+      }
+      pos = (pos + 1) & mask;
+    }
+  }
+
+  if ((pool->count + 1) * STRING_POOL_LOAD_DEN >
+      pool->capacity * STRING_POOL_LOAD_NUM) {
+    size_t capacity = pool->capacity == 0 ? STRING_POOL_MIN_CAPACITY
+                                          : pool->capacity * 2;
+    if (pool_resize(store->memory, pool, capacity) != 0) {
+      return NULL;
+    }
+  }
+
+  entry = (InternedString *)parking_memory_alloc(
+      store->memory, PARKING_MEMORY_STRINGS,
+      offsetof(InternedString, text) + len + 1);
+  if (entry == NULL) {
+    return NULL;
+  }
+  entry->hash = hash;
+  entry->refs = 1;
+  memcpy(entry->text, text, len);
+  entry->text[len] = '\0';
+
+  mask = pool->capacity - 1;
+  pos = (size_t)hash & mask;
+  while (pool->entries[pos] != NULL) {
+    pos = (pos + 1) & mask;
+  }
+  pool->entries[pos] = entry;
+  pool->count++;
+  return entry->text;
+}
+
+/**
+ * @brief 释放一次由 string_store_intern 得到的引用。
+ * @details 引用计数归零时条目从驻留池删除并释放。
+ * @param store 驻留时使用的存储（可以为 NULL）。
+ * @param text 驻留得到的文本，string_store_empty 与 NULL 会被忽略。
+ */
+void string_store_release_interned(StringStore *store, const char *text) {
+  InternedString *entry;
+
+  if (text == NULL || text == string_store_empty ||
+      string_store_is_borrowed(store, text)) {
+    return;
+  }
+  if (store == NULL) {
+    free((void *)text);
+    return;
+  }
+
+  entry = interned_header(text);
+  if (--entry->refs == 0) {
+    pool_remove(&store->locations, entry);
+    parking_memory_free(store->memory, entry);
+  }
+}
+
+/**
+ * @brief 从文本内存池复制一段文本。
+ * @param store 目标存储；为 NULL 时单独 malloc 一份副本。
+ * @param text 源文本。
+ * @param max_len 目标字段的长度上限（含结尾 NUL），超出部分截断。
+ * @return 复制得到的文本；空文本返回 string_store_empty；内存不足返回 NULL。
+ */
+const char *string_store_copy(StringStore *store, const char *text,
+                              size_t max_len) {
+  if (text == NULL || max_len == 0) {
+    return NULL;
+  }
+  return string_store_copy_span(store, text, bounded_length(text, max_len),
+                                max_len);
+}
+
+/**
+ * @brief 按给定长度从文本内存池复制一段文本，源文本不必以 NUL 结尾。
+ * @param store 目标存储；为 NULL 时单独 malloc 一份副本。
+ * @param text 源文本起始地址，前 len 字节中不得含有 NUL。
+ * @param len 源文本的字节数。
+ * @param max_len 目标字段的长度上限（含结尾 NUL），超出部分截断。
+ * @return 复制得到的文本；空文本返回 string_store_empty；内存不足返回 NULL。
+ */
+const char *string_store_copy_span(StringStore *store, const char *text,
+                                   size_t len, size_t max_len) {
+  char *block;
+  int cls;
+
+  if (text == NULL || max_len == 0) {
+    return NULL;
+  }
+  if (len > max_len - 1) {
+    len = max_len - 1;
+  }
+  if (len == 0) {
+    return string_store_empty;
+  }
+  cls = arena_class(len + 1);
+  if (store == NULL || cls < 0) {
+    return heap_copy(store ? store->memory : NULL, text, len);
+  }
+
+  block = arena_alloc(store->memory, &store->text, cls);
+  if (block == NULL) {
+    return NULL;
+  }
+  memcpy(block, text, len);
+  block[len] = '\0';
+  return block;
+}
+
+/**
+ * @brief 将 string_store_copy 得到的文本归还内存池。
+ * @details 块的级别由 strlen + 1 推出，与复制时的计算一致。
+ * @param store 复制时使用的存储（可以为 NULL）。
+ * @param text 复制得到的文本，string_store_empty 与 NULL 会被忽略。
+ */
+void string_store_release_copy(StringStore *store, const char *text) {
+  char *block = (char *)text;
+  int cls;
+
+  if (text == NULL || text == string_store_empty ||
+      string_store_is_borrowed(store, text)) {
+    return;
+  }
+  cls = arena_class(strlen(text) + 1);
+  if (store == NULL || cls < 0) {
+    parking_memory_free(store ? store->memory : NULL, block);
+    return;
+  }
+
+  memcpy(block, &store->text.free_lists[cls], sizeof(char *));
+  store->text.free_lists[cls] = block;
+  store->text.live_blocks--;
+}
+
+/**
+ * @brief 登记一段借用的只读内存。
+ * @param store 目标存储。
+ * @param base 区间起始地址，NULL 表示取消借用。
+ * @param size 区间字节数。
+ */
+void string_store_borrow(StringStore *store, const char *base, size_t size) {
+  store->borrowed = base;
+  store->borrowed_size = base != NULL ? size : 0;
+}
+
+/**
+ * @brief 判断文本是否位于存储的借用区间内。
+ * @param store 目标存储（可以为 NULL）。
+ * @param text 要判断的文本。
+ * @return 位于借用区间内返回 1，否则返回 0。
+ */
+int string_store_is_borrowed(const StringStore *store, const char *text) {
+  return store != NULL && store->borrowed != NULL &&
+         text >= store->borrowed &&
+         text < store->borrowed + store->borrowed_size;
+}
+
+/**
+ * @brief 把另一个存储的文本内存池整体并入目标存储。
+ * @details 源存储的区块接在目标当前区块之后，目标继续从原来的区块切分；
+ *          源存储最后一个区块的剩余空间不再使用。空闲块逐个转入目标。
+ * @param target 目标存储。
+ * @param source 源存储，返回后恢复为空。
+ */
+void string_store_adopt_text(StringStore *target, StringStore *source) {
+  StringArenaChunk *tail;
+  char *block;
+  int cls;
+
+  if (target == NULL || source == NULL || target == source) {
+    return;
+  }
+  tail = source->text.chunks;
+  if (tail != NULL) {
+    while (tail->next != NULL) {
+      tail = tail->next;
+    }
+    if (target->text.chunks == NULL) {
+      target->text.chunks = source->text.chunks;
+    } else {
+      tail->next = target->text.chunks->next;
+      target->text.chunks->next = source->text.chunks;
+    }
+  }
+  for (cls = 0; cls < STRING_ARENA_CLASS_COUNT; cls++) {
+    while (source->text.free_lists[cls] != NULL) {
+      block = source->text.free_lists[cls];
+      memcpy(&source->text.free_lists[cls], block, sizeof(char *));
+      memcpy(block, &target->text.free_lists[cls], sizeof(char *));
+      target->text.free_lists[cls] = block;
+    }
+  }
+  target->text.chunk_count += source->text.chunk_count;
+  target->text.live_blocks += source->text.live_blocks;
+  source->text.chunks = NULL;
+  source->text.chunk_count = 0;
+  source->text.live_blocks = 0;
+}
+
+/**
+ * @brief 把文本复制到定长缓冲区，截断到 size - 1 字节并以 NUL 结尾。
+ * @param dest 目标缓冲区。
+ * @param src 源文本，NULL 视为空串。
+ * @param size 目标缓冲区的字节数，必须大于 0。
+ * @return 复制的字节数（不含结尾 NUL）。
+ */
+size_t string_copy_bounded(char *dest, const char *src, size_t size) {
+  size_t len = src != NULL ? bounded_length(src, size) : 0;
+
+  if (len > 0) {
+    memcpy(dest, src, len);
+  }
+  dest[len] = '\0';
+  return len;
+}
@@ -0,0 +1,211 @@
+#ifndef PARKING_STRINGS_H
+#define PARKING_STRINGS_H
+
+#include <stddef.h>
+
+#include "parking_memory.h"
+
+/**
+ * @file parking_strings.h
+ * @brief 车位文本字段的紧凑存储结构声明。
+ * @details
+ * 车位节点不再内嵌定长字符数组，而是只保存指向文本的指针：
+ * 位置描述在停车场内大量重复，经驻留池（intern pool）去重并引用计数；
+ * 车主姓名、车牌号、联系方式随车辆进出频繁替换，
+ * 从按 16/32/64 字节分级的文本内存池中切分，释放后按级别复用。
+ * 空字符串一律指向共享的 string_store_empty，不占用任何存储。
+ * 延迟加载的快照让冷文本直接指向文件映射，这段"借用"区间内的文本
+ * 不属于内存池，归还时被忽略。
+ * @note 存储本身不加锁，与车位节点一样在停车场写锁内修改。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define STRING_ARENA_CLASS_COUNT 3      /**< 文本内存池的块大小级别数 */
+#define STRING_ARENA_CHUNK_BYTES 4096   /**< 文本内存池每个区块的字节数 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 驻留池中的一个字符串，文本紧随头部存放。
+ */
+typedef struct InternedString {
+  unsigned long hash; /**< 文本的 32 位 FNV-1a 哈希值。 */
+  unsigned long refs; /**< 引用该文本的车位数。 */
+  char text[1];       /**< 以 NUL 结尾的文本（按实际长度分配）。 */
+} InternedString;
+
+/**
+ * @brief 以文本内容为键的开放寻址（线性探测）驻留池。
+ * @details 容量始终为 2 的幂，负载因子超过 0.7 时扩容一倍；
+ *          引用计数归零的条目立即删除并后移回填，不留墓碑。
+ */
+typedef struct StringPool {
+  InternedString **entries; /**< 桶数组，NULL 表示空桶。 */
+  size_t capacity;          /**< 桶数组容量。 */
+  size_t count;             /**< 驻留的不同文本数。 */
+} StringPool;
+
+/**
+ * @brief 文本内存池中的一个区块。
+ */
+typedef struct StringArenaChunk {
+  struct StringArenaChunk *next;         /**< 下一个区块。 */
+  size_t used;                           /**< 已切分出去的字节数。 */
+  char data[STRING_ARENA_CHUNK_BYTES];   /**< 文本块存储。 */
+} StringArenaChunk;
+
+/**
+ * @brief 按块大小分级的文本内存池。
+ * @details 文本块的级别由 strlen + 1 推出，因此释放时无需记录块大小；
+ *          超过最大级别的文本退回 malloc/free。
+ */
+typedef struct StringArena {
+  StringArenaChunk *chunks;                     /**< 区块链表。 */
+  char *free_lists[STRING_ARENA_CLASS_COUNT];   /**< 各级别的空闲块链表。 */
+  size_t chunk_count;                           /**< 已分配的区块数。 */
+  size_t live_blocks;                           /**< 当前在用的文本块数。 */
+} StringArena;
+
+/**
+ * @brief 停车场持有的车位文本存储。
+ */
+typedef struct StringStore {
+  StringPool locations; /**< 位置描述驻留池。 */
+  StringArena text;     /**< 车主、车牌、联系方式的文本内存池。 */
+  ParkingMemory *memory; /**< 驻留池与内存池的分配来源，NULL 表示 C 堆。 */
+  const char *borrowed;  /**< 借用区间的起始地址，NULL 表示没有借用。 */
+  size_t borrowed_size;  /**< 借用区间的字节数。 */
+} StringStore;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/** 所有空文本字段共享的空字符串。 */
+extern const char string_store_empty[];
+
+/**
+ * @brief 初始化一个空的文本存储。
+ * @param store 目标存储。
+ * @param memory 之后分配驻留池与区块使用的内存对象，NULL 表示 C 堆。
+ */
+void string_store_init(StringStore *store, ParkingMemory *memory);
+
+/**
+ * @brief 释放文本存储持有的全部内存。
+ * @details 仍被车位引用的文本一并释放，调用者须保证之后不再访问这些车位。
+ * @param store 目标存储。
+ */
+void string_store_free(StringStore *store);
+
+/**
+ * @brief 驻留一段文本并增加其引用计数。
+ * @param store 目标存储；为 NULL 时单独 malloc 一份副本。
+ * @param text 源文本。
+ * @param max_len 目标字段的长度上限（含结尾 NUL），超出部分截断。
+ * @return 驻留后的文本；空文本返回 string_store_empty；内存不足返回 NULL。
+ */
+const char *string_store_intern(StringStore *store, const char *text,
+                                size_t max_len);
+
+/**
+ * @brief 按给定长度驻留一段文本，源文本不必以 NUL 结尾。
+ * @details 供加载器直接驻留行缓冲区中两个分隔符之间的字段，
+ *          不必先把分隔符改写为 NUL 再重新测量长度。
+ * @param store 目标存储；为 NULL 时单独 malloc 一份副本。
+ * @param text 源文本起始地址，前 len 字节中不得含有 NUL。
+ * @param len 源文本的字节数。
+ * @param max_len 目标字段的长度上限（含结尾 NUL），超出部分截断。
+ * @return 同 string_store_intern。
+ */
+const char *string_store_intern_span(StringStore *store, const char *text,
+                                     size_t len, size_t max_len);
+
+/**
+ * @brief 释放一次由 string_store_intern 得到的引用。
+ * @param store 驻留时使用的存储（可以为 NULL）。
+ * @param text 驻留得到的文本，string_store_empty 与 NULL 会被忽略。
+ */
+void string_store_release_interned(StringStore *store, const char *text);
+
+/**
+ * @brief 从文本内存池复制一段文本。
+ * @param store 目标存储；为 NULL 时单独 malloc 一份副本。
+ * @param text 源文本。
+ * @param max_len 目标字段的长度上限（含结尾 NUL），超出部分截断。
+ * @return 复制得到的文本；空文本返回 string_store_empty；内存不足返回 NULL。
+ */
+const char *string_store_copy(StringStore *store, const char *text,
+                              size_t max_len);
+
+/**
+ * @brief 按给定长度从文本内存池复制一段文本，源文本不必以 NUL 结尾。
+ * @param store 目标存储；为 NULL 时单独 malloc 一份副本。
+ * @param text 源文本起始地址，前 len 字节中不得含有 NUL。
+ * @param len 源文本的字节数。
+ * @param max_len 目标字段的长度上限（含结尾 NUL），超出部分截断。
+ * @return 同 string_store_copy。
+ */
+const char *string_store_copy_span(StringStore *store, const char *text,
+                                   size_t len, size_t max_len);
+
+/**
+ * @brief 将 string_store_copy 得到的文本归还内存池。
+ * @param store 复制时使用的存储（可以为 NULL）。
+ * @param text 复制得到的文本，string_store_empty 与 NULL 会被忽略。
+ */
+void string_store_release_copy(StringStore *store, const char *text);
+
+/**
+ * @brief 登记一段借用的只读内存，其中的文本可以直接作为车位字段。
+ * @details 指向借用区间的文本不由存储分配，string_store_release_copy
+ *          与 string_store_release_interned 遇到时直接忽略；
+ *          调用者须保证区间在存储释放之前一直有效。每个存储只能借用一段。
+ * @param store 目标存储。
+ * @param base 区间起始地址，NULL 表示取消借用。
+ * @param size 区间字节数。
+ */
+void string_store_borrow(StringStore *store, const char *base, size_t size);
+
+/**
+ * @brief 判断文本是否位于存储的借用区间内。
+ * @param store 目标存储（可以为 NULL）。
+ * @param text 要判断的文本。
+ * @return 位于借用区间内返回 1，否则返回 0。
+ */
+int string_store_is_borrowed(const StringStore *store, const char *text);
+
+/**
+ * @brief 把另一个存储的文本内存池整体并入目标存储。
+ * @details 用于多线程加载：每个线程先在私有存储中复制文本，
+ *          汇合后并入停车场的存储，之后这些文本照常由目标存储释放。
+ *          只转移文本内存池，源存储的位置描述驻留池不受影响。
+ * @param target 目标存储。
+ * @param source 源存储，须与目标使用同一个内存对象；返回后文本内存池为空。
+ */
+void string_store_adopt_text(StringStore *target, StringStore *source);
+
+/**
+ * @brief 把文本复制到定长缓冲区，截断到 size - 1 字节并以 NUL 结尾。
+ * @details 与 strncpy 不同，只写入文本本身和一个 NUL，
+ *          不把缓冲区的剩余部分逐字节填零；需要定长零填充的记录
+ *          （例如快照）应先整体清零。
+ * @param dest 目标缓冲区。
+ * @param src 源文本，NULL 视为空串。
+ * @param size 目标缓冲区的字节数，必须大于 0。
+ * @return 复制的字节数（不含结尾 NUL）。
+ */
+size_t string_copy_bounded(char *dest, const char *src, size_t size);
+
+#endif /* PARKING_STRINGS_H */
@@ -0,0 +1,262 @@
+/**
+ * @file parking_tariff.c
+ * @brief 以整数分计价的费率表实现文件
+ * @details
+ * 该文件实现了 parking_tariff.h 中声明的费率编译与计费函数。
+ * 编译时按 24 个入场小时展开累计价格表，计费时按计费日拆分：
+ * 首个计费日含首小时价格，其后的完整计费日价格与入场小时无关，
+ * 最后不足一日的部分再查一次累计价格表并封顶。
+ */
+
+#include <stddef.h>
+
+#include "parking_calendar.h"
+#include "parking_tariff.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 判断本地小时是否处于夜间时段。
+ * @param config 费率配置。
+ * @param hour 本地小时（0-23）。
+ * @return 处于夜间时段返回 1，否则返回 0。
+ */
+static int is_night_hour(const TariffConfig *config, int hour) {
+  if (config->night_start_hour == config->night_end_hour) {
+    return 0;
+  }
+  if (config->night_start_hour < config->night_end_hour) {
+    return hour >= config->night_start_hour && hour < config->night_end_hour;
+  }
+  return hour >= config->night_start_hour || hour < config->night_end_hour;
+}
+
+/**
+ * @brief (静态辅助函数) 按计费日封顶。
+ * @param tariff 费率表。
+ * @param cents 一个计费日内的累计价格。
+ * @return 封顶后的价格。
+ */
+static long apply_cap(const ParkingTariff *tariff, long cents) {
+  if (tariff->daily_cap_cents > 0 && cents > tariff->daily_cap_cents) {
+    return tariff->daily_cap_cents;
+  }
+  return cents;
+}
+
+/**
+ * @brief (静态辅助函数) 计算首个计费日中前 hours 个小时的价格（已封顶）。
+ * @param tariff 费率表。
+ * @param entry_hour 入场时的本地小时。
+ * @param hours 小时数（1 到 TARIFF_HOURS_PER_DAY）。
+ * @return 价格（分）。
+ */
+static long first_day_fee(const ParkingTariff *tariff, int entry_hour,
+                          int hours) {
+  int next_hour = (entry_hour + 1) % TARIFF_HOURS_PER_DAY;
+
+  return apply_cap(tariff, tariff->first_hour_cents +
+                               tariff->prefix[next_hour][hours - 1]);
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 把费率配置设为默认值。
+ * @param config 目标配置。
+ */
+void tariff_config_default(TariffConfig *config) {
+  if (config == NULL) {
+    return;
+  }
+  config->first_hour_cents = TARIFF_DEFAULT_HOURLY_CENTS;
+  config->hourly_cents = TARIFF_DEFAULT_HOURLY_CENTS;
+  config->night_hourly_cents = TARIFF_DEFAULT_HOURLY_CENTS;
+  config->night_start_hour = 0;
+  config->night_end_hour = 0;
+  config->daily_cap_cents = 0;
+  config->resident_monthly_cents = TARIFF_DEFAULT_RESIDENT_MONTHLY_CENTS;
+  config->resident_period_seconds = TARIFF_DEFAULT_PERIOD_SECONDS;
+  config->resident_calendar_months = 1;
+}
+
+/**
+ * @brief 把费率配置编译为查找表。
+ * @param tariff 接收编译结果。
+ * @param config 费率配置。
+ * @return 成功返回 0，配置无效返回 -1。
+ */
+int tariff_compile(ParkingTariff *tariff, const TariffConfig *config) {
+  long hour_cents[TARIFF_HOURS_PER_DAY];
+  int start;
+  int k;
+
+  if (tariff == NULL || config == NULL || config->first_hour_cents < 0 ||
+      config->hourly_cents < 0 || config->night_hourly_cents < 0 ||
+      config->daily_cap_cents < 0 || config->resident_monthly_cents < 0 ||
+      config->resident_period_seconds <= 0 || config->night_start_hour < 0 ||
+      config->night_start_hour >= TARIFF_HOURS_PER_DAY ||
+      config->night_end_hour < 0 ||
+      config->night_end_hour >= TARIFF_HOURS_PER_DAY) {
+    return -1;
+  }
+
+  for (k = 0; k < TARIFF_HOURS_PER_DAY; k++) {
+    hour_cents[k] =
+        is_night_hour(config, k) ? config->night_hourly_cents
+                                 : config->hourly_cents;
+  }
+  for (start = 0; start < TARIFF_HOURS_PER_DAY; start++) {
+    tariff->prefix[start][0] = 0;
+    for (k = 1; k <= TARIFF_HOURS_PER_DAY; k++) {
+      tariff->prefix[start][k] =
+          tariff->prefix[start][k - 1] +
+          hour_cents[(start + k - 1) % TARIFF_HOURS_PER_DAY];
+    }
+  }
+
+  tariff->first_hour_cents = config->first_hour_cents;
+  tariff->daily_cap_cents = config->daily_cap_cents;
+  tariff->resident_monthly_cents = config->resident_monthly_cents;
+  tariff->resident_period_seconds = config->resident_period_seconds;
+  tariff->resident_calendar_months = config->resident_calendar_months != 0;
+  tariff->full_day_cents =
+      apply_cap(tariff, tariff->prefix[0][TARIFF_HOURS_PER_DAY]);
+  for (start = 0; start < TARIFF_HOURS_PER_DAY; start++) {
+    tariff->first_day_cents[start] =
+        first_day_fee(tariff, start, TARIFF_HOURS_PER_DAY);
+  }
+  return 0;
+}
+
+/**
+ * @brief 计算访客停车费用。
+ * @param tariff 编译后的费率表。
+ * @param entry_hour 入场时的本地小时（0-23）。
+ * @param duration_seconds 停车时长（秒）。
+ * @param[out] billed_hours 接收计费小时数，可以为 NULL。
+ * @return 费用（分）。
+ */
+long tariff_visitor_fee(const ParkingTariff *tariff, int entry_hour,
+                        long duration_seconds, int *billed_hours) {
+  long hours;
+  long days;
+  int rest;
+  long cents;
+
+  if (billed_hours) {
+    *billed_hours = 0;
+  }
+  if (tariff == NULL || duration_seconds <= 0) {
+    return 0;
+  }
+  if (entry_hour < 0 || entry_hour >= TARIFF_HOURS_PER_DAY) {
+    entry_hour = 0;
+  }
+
+  /* 不足 1 小时按 1 小时计 */
+  hours = (duration_seconds + 3599) / 3600;
+  if (billed_hours) {
+    *billed_hours = (int)hours;
+  }
+  days = hours / TARIFF_HOURS_PER_DAY;
+  rest = (int)(hours % TARIFF_HOURS_PER_DAY);
+
+  if (days == 0) {
+    return first_day_fee(tariff, entry_hour, rest);
+  }
+  /* 之后的计费日都从入场的同一本地小时开始 */
+  cents = tariff->first_day_cents[entry_hour] +
+          (days - 1) * tariff->full_day_cents;
+  return cents + apply_cap(tariff, tariff->prefix[entry_hour][rest]);
+}
+
+/**
+ * @brief 计算居民补缴的月费。
+ * @param tariff 编译后的费率表。
+ * @param overdue_seconds 逾期时长（秒）。
+ * @param[out] periods 接收补缴的周期数，可以为 NULL。
+ * @return 费用（分）。
+ */
+long tariff_resident_fee(const ParkingTariff *tariff, long overdue_seconds,
+                         int *periods) {
+  long count;
+
+  if (periods) {
+    *periods = 0;
+  }
+  if (tariff == NULL || overdue_seconds <= 0) {
+    return 0;
+  }
+  count = (overdue_seconds + tariff->resident_period_seconds - 1) /
+          tariff->resident_period_seconds;
+  if (periods) {
+    *periods = (int)count;
+  }
+  return count * tariff->resident_monthly_cents;
+}
+
+/**
+ * @brief 计算居民从到期时间到 now 需要补缴的月费与顺延后的到期时间。
+ * @details 按自然月计费时先由两个本地月份之差估计周期数，再逐月校正，
+ *          通常只调用两三次 mktime。
+ * @param tariff 编译后的费率表。
+ * @param due_date 当前的到期时间。
+ * @param now 当前时刻。
+ * @param[out] periods 接收补缴的周期数，可以为 NULL。
+ * @param[out] next_due 接收顺延后的到期时间，可以为 NULL。
+ * @return 费用（分）。
+ */
+long tariff_resident_charge(const ParkingTariff *tariff, time_t due_date,
+                            time_t now, int *periods, time_t *next_due) {
+  time_t advanced;
+  long due_month;
+  long now_month;
+  int count;
+
+  if (periods) {
+    *periods = 0;
+  }
+  if (next_due) {
+    *next_due = due_date;
+  }
+  if (tariff == NULL || now <= due_date) {
+    return 0;
+  }
+  if (!tariff->resident_calendar_months) {
+    long cents = tariff_resident_fee(tariff, (long)(now - due_date), &count);
+
+    if (periods) {
+      *periods = count;
+    }
+    if (next_due) {
+      *next_due =
+          due_date + (time_t)count * (time_t)tariff->resident_period_seconds;
+    }
+    return cents;
+  }
+
+  parking_calendar_convert(due_date, NULL, &due_month);
+  parking_calendar_convert(now, NULL, &now_month);
+  count = (int)((now_month / 100 - due_month / 100) * 12 +
+                (now_month % 100 - due_month % 100));
+  count = count > 1 ? count - 1 : 1;
+  advanced = parking_calendar_add_months(due_date, count);
+  while (advanced != (time_t)-1 && advanced < now) {
+    advanced = parking_calendar_add_months(due_date, ++count);
+  }
+  if (advanced == (time_t)-1) {
+    return 0;
+  }
+  if (periods) {
+    *periods = count;
+  }
+  if (next_due) {
+    *next_due = advanced;
+  }
+  return (long)count * tariff->resident_monthly_cents;
+}
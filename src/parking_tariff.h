@@ -0,0 +1,137 @@
+#ifndef PARKING_TARIFF_H
+#define PARKING_TARIFF_H
+
+#include <time.h>
+
+/**
+ * @file parking_tariff.h
+ * @brief 以整数分计价的费率表声明。
+ * @details
+ * 费率配置（TariffConfig）描述访客的首小时价格、日间与夜间小时价格、
+ * 每 24 小时封顶价，以及居民月费与计费周期。配置经 tariff_compile
+ * 编译为 ParkingTariff：按入场时所在的本地小时预先算好连续 k 小时的
+ * 累计价格与首个 24 小时的封顶价格，出场计费只需几次查表与整数运算，
+ * 不做浮点除法，也不调用 ceil，金额累计不会产生舍入漂移。
+ *
+ * 访客计费规则：停车时长按小时向上取整；第 i 个计费小时（从 0 起）
+ * 在 i = 0 时按首小时价格计，否则按它开始时所在本地小时的日间或夜间价格计；
+ * 从入场起每 24 个计费小时为一个计费日，每个计费日分别封顶。
+ *
+ * 居民月费默认按自然月计费：到期时间每次顺延一个自然月（保持本地日期
+ * 中的日，月末按该月最后一天）；也可以改为固定秒数的计费周期。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define TARIFF_HOURS_PER_DAY 24 /**< 一个计费日的小时数 */
+#define TARIFF_DEFAULT_HOURLY_CENTS 1000L /**< 默认访客小时价格（分） */
+#define TARIFF_DEFAULT_RESIDENT_MONTHLY_CENTS 20000L /**< 默认居民月费（分） */
+#define TARIFF_DEFAULT_PERIOD_SECONDS                                          \
+  (30L * 24 * 3600) /**< 默认居民月费计费周期（按 30 天计） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 费率配置。
+ * @details 夜间时段为 [night_start_hour, night_end_hour)，开始小时大于结束小时时
+ *          跨越 0 点（例如 22 点到次日 7 点）；两者相等表示没有夜间时段。
+ */
+typedef struct TariffConfig {
+  long first_hour_cents;        /**< 访客第一个计费小时的价格（分）。 */
+  long hourly_cents;            /**< 日间每小时价格（分）。 */
+  long night_hourly_cents;      /**< 夜间每小时价格（分）。 */
+  int night_start_hour;         /**< 夜间时段开始小时（含）。 */
+  int night_end_hour;           /**< 夜间时段结束小时（不含）。 */
+  long daily_cap_cents;         /**< 每个计费日的封顶价格（分），0 表示不封顶。 */
+  long resident_monthly_cents;  /**< 居民每个计费周期的月费（分）。 */
+  long resident_period_seconds; /**< 居民月费的计费周期（秒）。 */
+  int resident_calendar_months; /**< 非 0 时按自然月计费，忽略计费周期秒数。 */
+} TariffConfig;
+
+/**
+ * @brief 编译后的费率表。
+ */
+typedef struct ParkingTariff {
+  /** prefix[e][k]：从本地 e 点开始连续 k 个小时的小时价格之和（不封顶）。 */
+  long prefix[TARIFF_HOURS_PER_DAY][TARIFF_HOURS_PER_DAY + 1];
+  long first_day_cents[TARIFF_HOURS_PER_DAY]; /**< 在 e 点入场时首个完整计费日的价格（已封顶）。 */
+  long full_day_cents;         /**< 之后每个完整计费日的价格（已封顶）。 */
+  long first_hour_cents;       /**< 首小时价格。 */
+  long daily_cap_cents;        /**< 每个计费日的封顶价格，0 表示不封顶。 */
+  long resident_monthly_cents; /**< 居民月费。 */
+  long resident_period_seconds; /**< 居民月费的计费周期（秒）。 */
+  int resident_calendar_months; /**< 非 0 时按自然月计费。 */
+} ParkingTariff;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 把费率配置设为默认值。
+ * @details 访客每小时 TARIFF_DEFAULT_HOURLY_CENTS 分、不分昼夜、不封顶；
+ *          居民每个自然月 TARIFF_DEFAULT_RESIDENT_MONTHLY_CENTS 分
+ *          （改为固定周期时周期为 30 天）。
+ * @param config 目标配置。
+ */
+void tariff_config_default(TariffConfig *config);
+
+/**
+ * @brief 把费率配置编译为查找表。
+ * @param tariff 接收编译结果。
+ * @param config 费率配置。
+ * @return 成功返回 0；价格为负、小时越界或计费周期不为正时返回 -1，
+ *         此时 tariff 保持不变。
+ */
+int tariff_compile(ParkingTariff *tariff, const TariffConfig *config);
+
+/**
+ * @brief 计算访客停车费用。
+ * @param tariff 编译后的费率表。
+ * @param entry_hour 入场时的本地小时（0-23）。
+ * @param duration_seconds 停车时长（秒），不为正时费用为 0。
+ * @param[out] billed_hours 接收计费小时数，可以为 NULL。
+ * @return 费用（分）。
+ */
+long tariff_visitor_fee(const ParkingTariff *tariff, int entry_hour,
+                        long duration_seconds, int *billed_hours);
+
+/**
+ * @brief 计算居民补缴的月费。
+ * @details 逾期时长按计费周期向上取整。
+ * @param tariff 编译后的费率表。
+ * @param overdue_seconds 逾期时长（秒），不为正时无需补缴。
+ * @param[out] periods 接收补缴的周期数，可以为 NULL。
+ * @return 费用（分）。
+ */
+long tariff_resident_fee(const ParkingTariff *tariff, long overdue_seconds,
+                         int *periods);
+
+/**
+ * @brief 计算居民从到期时间到 now 需要补缴的月费与顺延后的到期时间。
+ * @details 补缴的周期数是使顺延后的到期时间不早于 now 的最小周期数；
+ *          按自然月计费时顺延由 parking_calendar_add_months 计算，
+ *          否则每个周期 resident_period_seconds 秒（与 tariff_resident_fee
+ *          相同）。
+ * @param tariff 编译后的费率表。
+ * @param due_date 当前的到期时间。
+ * @param now 当前时刻，不晚于 due_date 时无需补缴。
+ * @param[out] periods 接收补缴的周期数，可以为 NULL。
+ * @param[out] next_due 接收顺延后的到期时间，可以为 NULL；无需补缴时
+ *             写入 due_date。
+ * @return 费用（分）。
+ */
+long tariff_resident_charge(const ParkingTariff *tariff, time_t due_date,
+                            time_t now, int *periods, time_t *next_due);
+
+#endif /* PARKING_TARIFF_H */
@@ -0,0 +1,397 @@
+/**
+ * @file parking_tasks.c
+ * @brief 工作窃取任务池实现文件
+ * @details
+ * 该文件实现了 parking_tasks.h 中声明的任务池。每个任务队列是一个按 2 的幂
+ * 扩容的环形数组，由自旋锁保护：所属线程从尾端取、其他线程从头端窃取，
+ * 两端各自只做几条指令，锁的持有时间极短。
+ * 任务完成时先递减任务组计数，之后不再访问任务组（等待者可能随即返回），
+ * 再触发任务池的完成信号唤醒等待者。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_tasks.h"
+#include "parking_thread.h"
+
+#define TASK_WAIT_MS 1 /**< 等待者每次等待完成信号的最长毫秒数 */
+
+/**
+ * @brief 一个排队的任务。
+ */
+typedef struct PoolTask {
+  ParkingTaskFn fn;        /**< 任务函数。 */
+  void *arg;               /**< 任务参数。 */
+  ParkingTaskGroup *group; /**< 所属任务组。 */
+} PoolTask;
+
+/**
+ * @brief 一个工作线程的双端任务队列。
+ */
+typedef struct TaskQueue {
+  volatile int lock; /**< 保护以下字段的自旋锁。 */
+  PoolTask *tasks;   /**< 环形数组。 */
+  size_t capacity;   /**< 数组容量，2 的幂。 */
+  size_t head;       /**< 窃取端（最早的任务）的序号。 */
+  size_t tail;       /**< 所属线程一端的下一个序号。 */
+} TaskQueue;
+
+/**
+ * @brief 一个工作线程。
+ */
+typedef struct TaskWorker {
+  struct ParkingTaskPool *pool; /**< 所属任务池。 */
+  int index;                    /**< 在 workers 中的下标。 */
+  ParkingThread *thread;        /**< 线程句柄。 */
+  ParkingSignal *signal;        /**< 有新任务或需要停止时触发。 */
+  TaskQueue queue;              /**< 该线程的任务队列。 */
+} TaskWorker;
+
+/**
+ * @brief 任务池。
+ */
+struct ParkingTaskPool {
+  int worker_count;          /**< 工作线程数。 */
+  TaskWorker *workers;       /**< 工作线程数组。 */
+  volatile int stopping;     /**< 非 0 时工作线程退出。 */
+  volatile long next_queue;  /**< 轮流选择提交队列的计数。 */
+  volatile long queued;      /**< 全部队列中的任务数。 */
+  volatile long executed;    /**< 已执行的任务数。 */
+  volatile long stolen;      /**< 窃取的任务数。 */
+  ParkingSignal *done;       /**< 每个任务完成时触发。 */
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 获取任务队列的自旋锁。
+ * @param queue 目标队列。
+ */
+static void queue_lock(TaskQueue *queue) {
+  while (parking_atomic_exchange_int(&queue->lock, 1) != 0) {
+    while (parking_atomic_load_int(&queue->lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放任务队列的自旋锁。
+ * @param queue 目标队列。
+ */
+static void queue_unlock(TaskQueue *queue) {
+  parking_atomic_store_int(&queue->lock, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 把任务放到队列尾端，队列满时容量加倍。
+ * @param queue 目标队列。
+ * @param task 要放入的任务。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int queue_push(TaskQueue *queue, const PoolTask *task) {
+  PoolTask *tasks;
+  size_t capacity;
+  size_t i;
+  int result = 0;
+
+  queue_lock(queue);
+  if (queue->tail - queue->head == queue->capacity) {
+    capacity = queue->capacity * 2;
+    tasks = (PoolTask *)malloc(capacity * sizeof(PoolTask));
+    if (tasks == NULL) {
+      result = -1;
+    } else {
+      for (i = queue->head; i != queue->tail; i++) {
+        tasks[i & (capacity - 1)] = queue->tasks[i & (queue->capacity - 1)];
+      }
+      free(queue->tasks);
+      queue->tasks = tasks;
+      queue->capacity = capacity;
+    }
+  }
+  if (result == 0) {
+    queue->tasks[queue->tail & (queue->capacity - 1)] = *task;
+    queue->tail++;
+  }
+  queue_unlock(queue);
+  return result;
+}
+
+/**
+ * @brief (静态辅助函数) 从队列的一端取出一个任务。
+ * @param queue 目标队列。
+ * @param from_tail 非 0 从尾端（最新的任务）取，0 从头端（最早的任务）取。
+ * @param[out] task 接收任务。
+ * @return 取到返回 1，队列为空返回 0。
+ */
+static int queue_take(TaskQueue *queue, int from_tail, PoolTask *task) {
+  int taken = 0;
+
+  queue_lock(queue);
+  if (queue->tail != queue->head) {
+    if (from_tail) {
+      queue->tail--;
+      *task = queue->tasks[queue->tail & (queue->capacity - 1)];
+    } else {
+      *task = queue->tasks[queue->head & (queue->capacity - 1)];
+      queue->head++;
+    }
+    taken = 1;
+  }
+  queue_unlock(queue);
+  return taken;
+}
+
+/**
+ * @brief (静态辅助函数) 取一个任务：先取自己的队列，再依次窃取其他队列。
+ * @param pool 任务池。
+ * @param own 自己的队列下标，-1 表示不是工作线程（只窃取）。
+ * @param start 开始窃取的队列下标。
+ * @param[out] task 接收任务。
+ * @return 取到返回 1，所有队列都为空返回 0。
+ */
+static int take_task(ParkingTaskPool *pool, int own, int start,
+                     PoolTask *task) {
+  int i;
+
+  if (parking_atomic_load_long(&pool->queued) == 0) {
+    return 0;
+  }
+  if (own >= 0 && queue_take(&pool->workers[own].queue, 1, task)) {
+    parking_atomic_add_long(&pool->queued, -1);
+    return 1;
+  }
+  for (i = 0; i < pool->worker_count; i++) {
+    int victim = (start + i) % pool->worker_count;
+
+    if (victim != own && queue_take(&pool->workers[victim].queue, 0, task)) {
+      parking_atomic_add_long(&pool->queued, -1);
+      if (own >= 0) {
+        parking_atomic_add_long(&pool->stolen, 1);
+      }
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 执行一个任务并通知等待者。
+ * @param pool 任务池。
+ * @param task 要执行的任务。
+ */
+static void run_task(ParkingTaskPool *pool, const PoolTask *task) {
+  task->fn(task->arg);
+  parking_atomic_add_long(&pool->executed, 1);
+  /* 递减之后任务组可能已随等待者返回而失效，不能再访问 */
+  parking_atomic_add_long(&task->group->pending, -1);
+  parking_signal_notify(pool->done);
+}
+
+/**
+ * @brief (静态辅助函数) 工作线程的主循环。
+ * @details 取到任务后如果队列中还有任务，先唤醒下一个线程再执行，
+ *          使积压的任务尽快分散到空闲线程上。
+ * @param arg 对应的 TaskWorker 对象。
+ */
+static void task_worker_loop(void *arg) {
+  TaskWorker *worker = (TaskWorker *)arg;
+  ParkingTaskPool *pool = worker->pool;
+  PoolTask task;
+
+  while (!parking_atomic_load_int(&pool->stopping)) {
+    if (take_task(pool, worker->index, worker->index + 1, &task)) {
+      if (parking_atomic_load_long(&pool->queued) > 0) {
+        parking_signal_notify(
+            pool->workers[(worker->index + 1) % pool->worker_count].signal);
+      }
+      run_task(pool, &task);
+      continue;
+    }
+    parking_signal_wait(worker->signal, 0);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 停止已启动的工作线程并释放任务池。
+ * @param pool 任务池。
+ * @param started 已启动的线程数。
+ */
+static void shutdown_pool(ParkingTaskPool *pool, int started) {
+  int i;
+
+  parking_atomic_store_int(&pool->stopping, 1);
+  for (i = 0; i < started; i++) {
+    parking_signal_notify(pool->workers[i].signal);
+  }
+  for (i = 0; i < started; i++) {
+    parking_thread_join(pool->workers[i].thread);
+  }
+  for (i = 0; i < pool->worker_count; i++) {
+    parking_signal_destroy(pool->workers[i].signal);
+    free(pool->workers[i].queue.tasks);
+  }
+  parking_signal_destroy(pool->done);
+  free(pool->workers);
+  free(pool);
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 创建任务池并启动工作线程。
+ * @param workers 工作线程数，0 表示处理器数。
+ * @return 成功返回句柄，失败返回 NULL。
+ */
+ParkingTaskPool *parking_task_pool_create(int workers) {
+  ParkingTaskPool *pool;
+  int i;
+
+  if (workers < 0) {
+    return NULL;
+  }
+  if (workers == 0) {
+    workers = parking_cpu_count();
+  }
+  if (workers > PARKING_TASK_POOL_MAX_WORKERS) {
+    workers = PARKING_TASK_POOL_MAX_WORKERS;
+  }
+
+  pool = (ParkingTaskPool *)calloc(1, sizeof(ParkingTaskPool));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pool->workers = (TaskWorker *)calloc((size_t)workers, sizeof(TaskWorker));
+  pool->done = parking_signal_create();
+  if (pool->workers == NULL || pool->done == NULL) {
+    parking_signal_destroy(pool->done);
+    free(pool->workers);
+    free(pool);
+    return NULL;
+  }
+  pool->worker_count = workers;
+  for (i = 0; i < workers; i++) {
+    TaskWorker *worker = &pool->workers[i];
+
+    worker->pool = pool;
+    worker->index = i;
+    worker->queue.capacity = PARKING_TASK_QUEUE_INITIAL;
+    worker->queue.tasks =
+        (PoolTask *)malloc(PARKING_TASK_QUEUE_INITIAL * sizeof(PoolTask));
+    worker->signal = parking_signal_create();
+    if (worker->queue.tasks == NULL || worker->signal == NULL) {
+      shutdown_pool(pool, 0);
+      return NULL;
+    }
+  }
+  for (i = 0; i < workers; i++) {
+    pool->workers[i].thread =
+        parking_thread_start(task_worker_loop, &pool->workers[i]);
+    if (pool->workers[i].thread == NULL) {
+      shutdown_pool(pool, i);
+      return NULL;
+    }
+  }
+  return pool;
+}
+
+/**
+ * @brief 初始化任务组。
+ * @param group 目标任务组。
+ */
+void parking_task_group_init(ParkingTaskGroup *group) {
+  if (group != NULL) {
+    group->pending = 0;
+  }
+}
+
+/**
+ * @brief 提交一个任务。
+ * @details 计数先于入队递增，等待者不会在任务入队前误以为任务组已完成。
+ * @param pool 任务池。
+ * @param group 任务所属的任务组。
+ * @param fn 任务函数。
+ * @param arg 透传给任务函数的参数。
+ * @return 已排队返回 0，已在调用线程中执行返回 1，参数无效返回 -1。
+ */
+int parking_task_pool_submit(ParkingTaskPool *pool, ParkingTaskGroup *group,
+                             ParkingTaskFn fn, void *arg) {
+  PoolTask task;
+  int target;
+
+  if (pool == NULL || group == NULL || fn == NULL) {
+    return -1;
+  }
+  task.fn = fn;
+  task.arg = arg;
+  task.group = group;
+  target = (int)((unsigned long)parking_atomic_load_long(&pool->next_queue) %
+                 (unsigned long)pool->worker_count);
+  parking_atomic_add_long(&pool->next_queue, 1);
+
+  parking_atomic_add_long(&group->pending, 1);
+  parking_atomic_add_long(&pool->queued, 1);
+  if (queue_push(&pool->workers[target].queue, &task) != 0) {
+    parking_atomic_add_long(&pool->queued, -1);
+    run_task(pool, &task);
+    return 1;
+  }
+  parking_signal_notify(pool->workers[target].signal);
+  return 0;
+}
+
+/**
+ * @brief 等待任务组的全部任务完成，等待期间帮忙执行排队的任务。
+ * @param pool 任务池。
+ * @param group 目标任务组。
+ */
+void parking_task_group_wait(ParkingTaskPool *pool, ParkingTaskGroup *group) {
+  PoolTask task;
+  int start = 0;
+
+  if (pool == NULL || group == NULL) {
+    return;
+  }
+  while (parking_atomic_load_long(&group->pending) > 0) {
+    if (take_task(pool, -1, start, &task)) {
+      run_task(pool, &task);
+      start = (start + 1) % pool->worker_count;
+      continue;
+    }
+    parking_signal_wait(pool->done, TASK_WAIT_MS);
+  }
+}
+
+/**
+ * @brief 读取任务池的统计快照。
+ * @param pool 任务池。
+ * @param[out] stats 接收快照。
+ */
+void parking_task_pool_stats(ParkingTaskPool *pool,
+                             ParkingTaskPoolStats *stats) {
+  if (stats == NULL) {
+    return;
+  }
+  memset(stats, 0, sizeof(*stats));
+  if (pool == NULL) {
+    return;
+  }
+  stats->workers = pool->worker_count;
+  stats->executed = parking_atomic_load_long(&pool->executed);
+  stats->stolen = parking_atomic_load_long(&pool->stolen);
+}
+
+/**
+ * @brief 停止工作线程并释放任务池。
+ * @param pool 任务池，可以为 NULL。
+ */
+void parking_task_pool_destroy(ParkingTaskPool *pool) {
+  if (pool != NULL) {
+    shutdown_pool(pool, pool->worker_count);
+  }
+}
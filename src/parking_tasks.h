@@ -0,0 +1,120 @@
+#ifndef PARKING_TASKS_H
+#define PARKING_TASKS_H
+
+#include <stddef.h>
+
+/**
+ * @file parking_tasks.h
+ * @brief 工作窃取任务池的接口声明。
+ * @details
+ * 任务池持有固定数量的工作线程，每个线程有自己的双端任务队列：
+ * 提交的任务轮流放入各线程的队列，线程从自己队列的尾端取任务，
+ * 自己的队列空了就从其他线程队列的头端窃取。单个任务耗时差别很大时
+ * （例如一个千车位的大车库与几百个十几车位的小车库），先忙完的线程
+ * 会接过其他线程积压的任务，总耗时随核数近似线性下降。
+ *
+ * 任务按任务组等待：提交时指定任务组，parking_task_group_wait 在组内
+ * 全部任务完成前也会取任务来执行，因此等待的线程同样参与计算，
+ * 任务池只有一个线程时也不会因等待而空转。
+ * 任务不能在任务中等待另一个任务组。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_TASK_POOL_MAX_WORKERS 64 /**< 工作线程数的上限 */
+#define PARKING_TASK_QUEUE_INITIAL 64    /**< 每个任务队列的初始容量 */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 任务函数。
+ * @param arg 提交任务时传入的参数。
+ */
+typedef void (*ParkingTaskFn)(void *arg);
+
+/**
+ * @brief 不透明的任务池句柄。
+ */
+typedef struct ParkingTaskPool ParkingTaskPool;
+
+/**
+ * @brief 一组可以一起等待的任务。
+ * @details 可直接在栈上声明，使用前以 parking_task_group_init 初始化。
+ */
+typedef struct ParkingTaskGroup {
+  volatile long pending; /**< 尚未完成的任务数，以原子操作更新。 */
+} ParkingTaskGroup;
+
+/**
+ * @brief 任务池的统计快照。
+ */
+typedef struct ParkingTaskPoolStats {
+  int workers;   /**< 工作线程数。 */
+  long executed; /**< 已执行的任务数（含等待线程执行的）。 */
+  long stolen;   /**< 从其他线程队列窃取的任务数。 */
+} ParkingTaskPoolStats;
+
+/**
+ *********************************************************************************
+ *                              任务池API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建任务池并启动工作线程。
+ * @param workers 工作线程数；0 表示处理器数，超过
+ *                PARKING_TASK_POOL_MAX_WORKERS 时按上限处理。
+ * @return 成功返回句柄；参数无效、内存不足或无法创建线程时返回 NULL。
+ */
+ParkingTaskPool *parking_task_pool_create(int workers);
+
+/**
+ * @brief 初始化任务组。
+ * @param group 目标任务组。
+ */
+void parking_task_group_init(ParkingTaskGroup *group);
+
+/**
+ * @brief 提交一个任务。
+ * @details 任务队列扩容失败时在调用线程中立即执行该任务。
+ * @param pool 任务池。
+ * @param group 任务所属的任务组。
+ * @param fn 任务函数。
+ * @param arg 透传给任务函数的参数。
+ * @return 已排队返回 0，已在调用线程中执行返回 1，参数无效返回 -1。
+ */
+int parking_task_pool_submit(ParkingTaskPool *pool, ParkingTaskGroup *group,
+                             ParkingTaskFn fn, void *arg);
+
+/**
+ * @brief 等待任务组的全部任务完成，等待期间帮忙执行排队的任务。
+ * @details 帮忙执行的可能是其他任务组的任务。
+ * @param pool 任务池。
+ * @param group 目标任务组。
+ */
+void parking_task_group_wait(ParkingTaskPool *pool, ParkingTaskGroup *group);
+
+/**
+ * @brief 读取任务池的统计快照。
+ * @param pool 任务池。
+ * @param[out] stats 接收快照；pool 为 NULL 时清零。
+ */
+void parking_task_pool_stats(ParkingTaskPool *pool,
+                             ParkingTaskPoolStats *stats);
+
+/**
+ * @brief 停止工作线程并释放任务池。
+ * @details 调用者须先等待已提交的任务组完成。
+ * @param pool 任务池，可以为 NULL。
+ */
+void parking_task_pool_destroy(ParkingTaskPool *pool);
+
+#endif /* PARKING_TASKS_H */
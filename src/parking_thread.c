@@ -0,0 +1,630 @@
+/**
+ * @file parking_thread.c
+ * @brief 读写锁、原子计数与线程的跨平台实现文件
+ * @details
+ * 该文件实现了 parking_thread.h 中声明的读写锁、原子计数、信号、线程与
+ * 线程私有数据封装。
+ * 原子操作均使用顺序一致的内存序，调用方可以依赖写入的先后顺序。
+ * 由于核心库按 C90 编译，pthread 读写锁需要在包含系统头文件前
+ * 显式开启 _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdlib.h>
+
+#include "parking_thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PARKING_ATOMIC_BUILTINS 1
+#endif
+
+/**
+ * @brief 读写锁的平台实现。
+ */
+struct ParkingRwLock {
+#ifdef _WIN32
+  SRWLOCK lock; /**< Windows 精简读写锁。 */
+#else
+  pthread_rwlock_t lock; /**< POSIX 读写锁。 */
+#endif
+};
+
+/**
+ * @brief 信号的平台实现。
+ */
+struct ParkingSignal {
+#ifdef _WIN32
+  HANDLE event; /**< Windows 自动复位事件。 */
+#else
+  pthread_mutex_t mutex; /**< 保护 raised 的互斥量。 */
+  pthread_cond_t cond;   /**< 等待 raised 的条件变量。 */
+  int raised;            /**< 非 0 表示已触发、尚未被等待者取走。 */
+#endif
+};
+
+/**
+ * @brief 线程句柄的平台实现。
+ */
+struct ParkingThread {
+#ifdef _WIN32
+  HANDLE handle; /**< Windows 线程句柄。 */
+#else
+  pthread_t handle; /**< POSIX 线程标识。 */
+#endif
+  ParkingThreadFn fn; /**< 线程入口函数。 */
+  void *arg;          /**< 入口函数参数。 */
+};
+
+/**
+ * @brief 线程私有数据键的平台实现。
+ * @details Windows 使用纤程局部存储（FLS），与 TLS 不同，它能在线程结束时
+ *          调用析构函数；32 位 Windows 上 FLS 回调为 stdcall，
+ *          与 ParkingThreadKeyFn 不同，因此只在 64 位上注册析构函数。
+ */
+struct ParkingThreadKey {
+#ifdef _WIN32
+  DWORD index; /**< FLS 下标。 */
+#else
+  pthread_key_t key; /**< POSIX 线程私有数据键。 */
+#endif
+};
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 平台线程入口，转调用户的入口函数。
+ * @param param 对应的 ParkingThread 对象。
+ * @return 始终返回 0。
+ */
+#ifdef _WIN32
+static DWORD WINAPI thread_trampoline(LPVOID param) {
+  ParkingThread *thread = (ParkingThread *)param;
+  thread->fn(thread->arg);
+  return 0;
+}
+#else
+static void *thread_trampoline(void *param) {
+  ParkingThread *thread = (ParkingThread *)param;
+  thread->fn(thread->arg);
+  return NULL;
+}
+#endif
+
+/* ========================================================================== */
+/*                              读写锁函数实现                                */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个读写锁。
+ * @return 成功返回新锁，失败返回 NULL。
+ */
+ParkingRwLock *parking_rwlock_create(void) {
+  ParkingRwLock *lock = (ParkingRwLock *)malloc(sizeof(ParkingRwLock));
+
+  if (lock == NULL) {
+    return NULL;
+  }
+#ifdef _WIN32
+  InitializeSRWLock(&lock->lock);
+#else
+  if (pthread_rwlock_init(&lock->lock, NULL) != 0) {
+    free(lock);
+    return NULL;
+  }
+#endif
+  return lock;
+}
+
+/**
+ * @brief 销毁读写锁。
+ * @param lock 要销毁的锁，可以为 NULL。
+ */
+void parking_rwlock_destroy(ParkingRwLock *lock) {
+  if (lock == NULL) {
+    return;
+  }
+#ifndef _WIN32
+  pthread_rwlock_destroy(&lock->lock);
+#endif
+  free(lock);
+}
+
+/**
+ * @brief 以共享（读）方式获取锁。
+ * @param lock 目标锁。
+ */
+void parking_rwlock_read_lock(ParkingRwLock *lock) {
+#ifdef _WIN32
+  AcquireSRWLockShared(&lock->lock);
+#else
+  pthread_rwlock_rdlock(&lock->lock);
+#endif
+}
+
+/**
+ * @brief 释放共享（读）锁。
+ * @param lock 目标锁。
+ */
+void parking_rwlock_read_unlock(ParkingRwLock *lock) {
+#ifdef _WIN32
+  ReleaseSRWLockShared(&lock->lock);
+#else
+  pthread_rwlock_unlock(&lock->lock);
+#endif
+}
+
+/**
+ * @brief 以独占（写）方式获取锁。
+ * @param lock 目标锁。
+ */
+void parking_rwlock_write_lock(ParkingRwLock *lock) {
+#ifdef _WIN32
+  AcquireSRWLockExclusive(&lock->lock);
+#else
+  pthread_rwlock_wrlock(&lock->lock);
+#endif
+}
+
+/**
+ * @brief 释放独占（写）锁。
+ * @param lock 目标锁。
+ */
+void parking_rwlock_write_unlock(ParkingRwLock *lock) {
+#ifdef _WIN32
+  ReleaseSRWLockExclusive(&lock->lock);
+#else
+  pthread_rwlock_unlock(&lock->lock);
+#endif
+}
+
+/* ========================================================================== */
+/*                              原子计数函数实现                              */
+/* ========================================================================== */
+
+/*
+ * Windows 上 int 与 long 均为 32 位，与 Interlocked 系列使用的 LONG 一致。
+ * 既无 __atomic 也非 Windows 的编译器退化为普通读写，此时只在单线程下正确。
+ */
+
+/**
+ * @brief 原子地读取一个 int 计数器。
+ * @param value 计数器地址。
+ * @return 读取到的值。
+ */
+int parking_atomic_load_int(const volatile int *value) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  return (int)InterlockedCompareExchange((volatile LONG *)value, 0, 0);
+#else
+  return *value;
+#endif
+}
+
+/**
+ * @brief 原子地给一个 int 计数器加上增量。
+ * @param value 计数器地址。
+ * @param delta 增量，可以为负数。
+ */
+void parking_atomic_add_int(volatile int *value, int delta) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  __atomic_fetch_add(value, delta, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  InterlockedExchangeAdd((volatile LONG *)value, (LONG)delta);
+#else
+  *value += delta;
+#endif
+}
+
+/**
+ * @brief 原子地写入一个 int 值。
+ * @param value 目标地址。
+ * @param new_value 要写入的值。
+ */
+void parking_atomic_store_int(volatile int *value, int new_value) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  __atomic_store_n(value, new_value, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  InterlockedExchange((volatile LONG *)value, (LONG)new_value);
+#else
+  *value = new_value;
+#endif
+}
+
+/**
+ * @brief 原子地写入一个 int 值并返回原值。
+ * @param value 目标地址。
+ * @param new_value 要写入的值。
+ * @return 写入前的值。
+ */
+int parking_atomic_exchange_int(volatile int *value, int new_value) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  return __atomic_exchange_n(value, new_value, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  return (int)InterlockedExchange((volatile LONG *)value, (LONG)new_value);
+#else
+  int old_value = *value;
+
+  *value = new_value;
+  return old_value;
+#endif
+}
+
+/**
+ * @brief 原子地读取一个 long 计数器。
+ * @param value 计数器地址。
+ * @return 读取到的值。
+ */
+long parking_atomic_load_long(const volatile long *value) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  return (long)InterlockedCompareExchange((volatile LONG *)value, 0, 0);
+#else
+  return *value;
+#endif
+}
+
+/**
+ * @brief 原子地给一个 long 计数器加上增量。
+ * @param value 计数器地址。
+ * @param delta 增量，可以为负数。
+ */
+void parking_atomic_add_long(volatile long *value, long delta) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  __atomic_fetch_add(value, delta, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  InterlockedExchangeAdd((volatile LONG *)value, (LONG)delta);
+#else
+  *value += delta;
+#endif
+}
+
+/**
+ * @brief 原子地写入一个 long 计数器。
+ * @param value 计数器地址。
+ * @param new_value 要写入的值。
+ */
+void parking_atomic_store_long(volatile long *value, long new_value) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  __atomic_store_n(value, new_value, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  InterlockedExchange((volatile LONG *)value, (LONG)new_value);
+#else
+  *value = new_value;
+#endif
+}
+
+/**
+ * @brief 原子地读取一个指针。
+ * @param value 指针变量的地址。
+ * @return 读取到的指针。
+ */
+void *parking_atomic_load_ptr(void *const volatile *value) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  return InterlockedCompareExchangePointer((PVOID volatile *)value, NULL,
+                                           NULL);
+#else
+  return *value;
+#endif
+}
+
+/**
+ * @brief 原子地写入一个指针并返回原值。
+ * @param value 指针变量的地址。
+ * @param new_value 要写入的指针。
+ * @return 写入前的指针。
+ */
+void *parking_atomic_exchange_ptr(void *volatile *value, void *new_value) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  return __atomic_exchange_n(value, new_value, __ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  return InterlockedExchangePointer((PVOID volatile *)value, new_value);
+#else
+  void *old_value = *value;
+
+  *value = new_value;
+  return old_value;
+#endif
+}
+
+/**
+ * @brief 完整的内存屏障。
+ */
+void parking_atomic_fence(void) {
+#if defined(PARKING_ATOMIC_BUILTINS)
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#elif defined(_WIN32)
+  MemoryBarrier();
+#endif
+}
+
+/* ========================================================================== */
+/*                              信号函数实现                                  */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个未触发的信号。
+ * @return 成功返回新信号，失败返回 NULL。
+ */
+ParkingSignal *parking_signal_create(void) {
+  ParkingSignal *signal = (ParkingSignal *)malloc(sizeof(ParkingSignal));
+
+  if (signal == NULL) {
+    return NULL;
+  }
+#ifdef _WIN32
+  signal->event = CreateEvent(NULL, FALSE, FALSE, NULL);
+  if (signal->event == NULL) {
+    free(signal);
+    return NULL;
+  }
+#else
+  signal->raised = 0;
+  if (pthread_mutex_init(&signal->mutex, NULL) != 0) {
+    free(signal);
+    return NULL;
+  }
+  if (pthread_cond_init(&signal->cond, NULL) != 0) {
+    pthread_mutex_destroy(&signal->mutex);
+    free(signal);
+    return NULL;
+  }
+#endif
+  return signal;
+}
+
+/**
+ * @brief 销毁信号。
+ * @param signal 要销毁的信号，可以为 NULL。
+ */
+void parking_signal_destroy(ParkingSignal *signal) {
+  if (signal == NULL) {
+    return;
+  }
+#ifdef _WIN32
+  CloseHandle(signal->event);
+#else
+  pthread_cond_destroy(&signal->cond);
+  pthread_mutex_destroy(&signal->mutex);
+#endif
+  free(signal);
+}
+
+/**
+ * @brief 触发信号，唤醒一个等待者。
+ * @param signal 目标信号。
+ */
+void parking_signal_notify(ParkingSignal *signal) {
+#ifdef _WIN32
+  SetEvent(signal->event);
+#else
+  pthread_mutex_lock(&signal->mutex);
+  signal->raised = 1;
+  pthread_cond_signal(&signal->cond);
+  pthread_mutex_unlock(&signal->mutex);
+#endif
+}
+
+/**
+ * @brief 等待信号被触发，返回时信号复位。
+ * @param signal 目标信号。
+ * @param timeout_ms 最长等待的毫秒数，0 表示一直等待。
+ * @return 被触发返回 1，超时返回 0。
+ */
+int parking_signal_wait(ParkingSignal *signal, unsigned long timeout_ms) {
+#ifdef _WIN32
+  return WaitForSingleObject(signal->event,
+                             timeout_ms == 0 ? INFINITE : (DWORD)timeout_ms) ==
+         WAIT_OBJECT_0;
+#else
+  struct timespec deadline;
+  int raised;
+  int status = 0;
+
+  if (timeout_ms > 0) {
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t)(timeout_ms / 1000);
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+  }
+
+  pthread_mutex_lock(&signal->mutex);
+  /* 条件变量允许虚假唤醒，以 raised 为准 */
+  while (!signal->raised && status != ETIMEDOUT) {
+    status = timeout_ms == 0
+                 ? pthread_cond_wait(&signal->cond, &signal->mutex)
+                 : pthread_cond_timedwait(&signal->cond, &signal->mutex,
+                                          &deadline);
+  }
+  raised = signal->raised;
+  signal->raised = 0;
+  pthread_mutex_unlock(&signal->mutex);
+  return raised;
+#endif
+}
+
+/* ========================================================================== */
+/*                              线程函数实现                                  */
+/* ========================================================================== */
+
+/**
+ * @brief 创建并启动一个线程。
+ * @param fn 线程入口函数。
+ * @param arg 透传给入口函数的参数。
+ * @return 成功返回线程句柄，失败返回 NULL。
+ */
+ParkingThread *parking_thread_start(ParkingThreadFn fn, void *arg) {
+  ParkingThread *thread;
+
+  if (fn == NULL) {
+    return NULL;
+  }
+  thread = (ParkingThread *)malloc(sizeof(ParkingThread));
+  if (thread == NULL) {
+    return NULL;
+  }
+  thread->fn = fn;
+  thread->arg = arg;
+#ifdef _WIN32
+  thread->handle = CreateThread(NULL, 0, thread_trampoline, thread, 0, NULL);
+  if (thread->handle == NULL) {
+    free(thread);
+    return NULL;
+  }
+#else
+  if (pthread_create(&thread->handle, NULL, thread_trampoline, thread) != 0) {
+    free(thread);
+    return NULL;
+  }
+#endif
+  return thread;
+}
+
+/**
+ * @brief 等待线程结束并释放线程句柄。
+ * @param thread 由 parking_thread_start 返回的句柄，可以为 NULL。
+ */
+void parking_thread_join(ParkingThread *thread) {
+  if (thread == NULL) {
+    return;
+  }
+#ifdef _WIN32
+  WaitForSingleObject(thread->handle, INFINITE);
+  CloseHandle(thread->handle);
+#else
+  pthread_join(thread->handle, NULL);
+#endif
+  free(thread);
+}
+
+/**
+ * @brief 取得当前线程的标识值。
+ * @details POSIX 下 pthread_t 的表示由实现决定，因此按字节做 FNV-1a 哈希。
+ * @return 当前线程的标识值。
+ */
+unsigned long parking_thread_current_id(void) {
+#ifdef _WIN32
+  return (unsigned long)GetCurrentThreadId();
+#else
+  pthread_t self = pthread_self();
+  const unsigned char *bytes = (const unsigned char *)&self;
+  unsigned long hash = 2166136261UL;
+  size_t i;
+
+  for (i = 0; i < sizeof(self); i++) {
+    hash = ((hash ^ bytes[i]) * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  return hash;
+#endif
+}
+
+/**
+ * @brief 取得当前可用的处理器数。
+ * @return 处理器数；无法确定时返回 1。
+ */
+int parking_cpu_count(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return count > 0 ? (int)count : 1;
+#endif
+}
+
+/**
+ * @brief 创建一个线程私有数据键。
+ * @param destructor 线程结束时对其非 NULL 值调用的函数，可以为 NULL。
+ * @return 成功返回新键，系统资源不足时返回 NULL。
+ */
+ParkingThreadKey *parking_thread_key_create(ParkingThreadKeyFn destructor) {
+  ParkingThreadKey *key = (ParkingThreadKey *)malloc(sizeof(ParkingThreadKey));
+
+  if (key == NULL) {
+    return NULL;
+  }
+#ifdef _WIN32
+#if defined(_WIN64)
+  key->index = FlsAlloc((PFLS_CALLBACK_FUNCTION)destructor);
+#else
+  (void)destructor; /* x86 上 FLS 回调为 stdcall，不能直接注册 */
+  key->index = FlsAlloc(NULL);
+#endif
+  if (key->index == FLS_OUT_OF_INDEXES) {
+    free(key);
+    return NULL;
+  }
+#else
+  if (pthread_key_create(&key->key, destructor) != 0) {
+    free(key);
+    return NULL;
+  }
+#endif
+  return key;
+}
+
+/**
+ * @brief 销毁线程私有数据键，不调用析构函数。
+ * @param key 要销毁的键，可以为 NULL。
+ */
+void parking_thread_key_destroy(ParkingThreadKey *key) {
+  if (key == NULL) {
+    return;
+  }
+#ifdef _WIN32
+  FlsFree(key->index);
+#else
+  pthread_key_delete(key->key);
+#endif
+  free(key);
+}
+
+/**
+ * @brief 读取当前线程在键下保存的指针。
+ * @param key 目标键。
+ * @return 保存的指针，从未设置时返回 NULL。
+ */
+void *parking_thread_key_get(ParkingThreadKey *key) {
+#ifdef _WIN32
+  return FlsGetValue(key->index);
+#else
+  return pthread_getspecific(key->key);
+#endif
+}
+
+/**
+ * @brief 设置当前线程在键下保存的指针。
+ * @param key 目标键。
+ * @param value 要保存的指针。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int parking_thread_key_set(ParkingThreadKey *key, void *value) {
+#ifdef _WIN32
+  return FlsSetValue(key->index, value) ? 0 : -1;
+#else
+  return pthread_setspecific(key->key, value) == 0 ? 0 : -1;
+#endif
+}
@@ -0,0 +1,279 @@
+#ifndef PARKING_THREAD_H
+#define PARKING_THREAD_H
+
+/**
+ * @file parking_thread.h
+ * @brief 读写锁、原子计数、信号、线程与线程私有数据的跨平台封装。
+ * @details
+ * POSIX 平台使用 pthread_rwlock/pthread_create，Windows 平台使用
+ * SRWLOCK/CreateThread；原子操作使用 GCC/Clang 的 __atomic 内建函数
+ * 或 Windows 的 Interlocked 系列函数。核心库按 C90 编译，平台类型不能出现在公共头文件中，
+ * 因此锁与线程都以不透明指针的形式创建和释放。
+ */
+
+/**
+ *********************************************************************************
+ *                                 类型定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 不透明的读写锁。
+ * @details 允许多个读者同时持有，写者独占；锁不可重入。
+ */
+typedef struct ParkingRwLock ParkingRwLock;
+
+/**
+ * @brief 不透明的线程句柄。
+ */
+typedef struct ParkingThread ParkingThread;
+
+/**
+ * @brief 不透明的自动复位信号。
+ * @details 通知在没有线程等待时会保留到下一次等待，多次通知合并为一次。
+ */
+typedef struct ParkingSignal ParkingSignal;
+
+/**
+ * @brief 不透明的线程私有数据键。
+ * @details 每个线程在同一个键下各自保存一个指针，初始为 NULL。
+ */
+typedef struct ParkingThreadKey ParkingThreadKey;
+
+/**
+ * @brief 线程入口函数。
+ * @param arg 创建线程时传入的参数。
+ */
+typedef void (*ParkingThreadFn)(void *arg);
+
+/**
+ * @brief 线程结束时对其私有数据调用的析构函数。
+ * @param value 该线程在键下保存的非 NULL 指针。
+ */
+typedef void (*ParkingThreadKeyFn)(void *value);
+
+/**
+ *********************************************************************************
+ *                            读写锁与线程API声明
+ *********************************************************************************
+ */
+
+/** @name 读写锁 */
+/** @{ */
+
+/**
+ * @brief 创建一个读写锁。
+ * @return 成功返回新锁，内存不足或系统资源不足时返回 NULL。
+ */
+ParkingRwLock *parking_rwlock_create(void);
+
+/**
+ * @brief 销毁读写锁。
+ * @param lock 要销毁的锁，可以为 NULL；调用时不得被任何线程持有。
+ */
+void parking_rwlock_destroy(ParkingRwLock *lock);
+
+/**
+ * @brief 以共享（读）方式获取锁。
+ * @param lock 目标锁。
+ */
+void parking_rwlock_read_lock(ParkingRwLock *lock);
+
+/**
+ * @brief 释放共享（读）锁。
+ * @param lock 目标锁。
+ */
+void parking_rwlock_read_unlock(ParkingRwLock *lock);
+
+/**
+ * @brief 以独占（写）方式获取锁。
+ * @param lock 目标锁。
+ */
+void parking_rwlock_write_lock(ParkingRwLock *lock);
+
+/**
+ * @brief 释放独占（写）锁。
+ * @param lock 目标锁。
+ */
+void parking_rwlock_write_unlock(ParkingRwLock *lock);
+
+/** @} */
+
+/** @name 原子计数 */
+/** @{ */
+
+/**
+ * @brief 原子地读取一个 int 计数器。
+ * @param value 计数器地址。
+ * @return 读取到的值。
+ */
+int parking_atomic_load_int(const volatile int *value);
+
+/**
+ * @brief 原子地给一个 int 计数器加上增量。
+ * @param value 计数器地址。
+ * @param delta 增量，可以为负数。
+ */
+void parking_atomic_add_int(volatile int *value, int delta);
+
+/**
+ * @brief 原子地写入一个 int 值。
+ * @param value 目标地址。
+ * @param new_value 要写入的值。
+ */
+void parking_atomic_store_int(volatile int *value, int new_value);
+
+/**
+ * @brief 原子地写入一个 int 值并返回原值。
+ * @details 可用作自旋锁的测试并设置操作。
+ * @param value 目标地址。
+ * @param new_value 要写入的值。
+ * @return 写入前的值。
+ */
+int parking_atomic_exchange_int(volatile int *value, int new_value);
+
+/**
+ * @brief 原子地读取一个 long 计数器。
+ * @param value 计数器地址。
+ * @return 读取到的值。
+ */
+long parking_atomic_load_long(const volatile long *value);
+
+/**
+ * @brief 原子地给一个 long 计数器加上增量。
+ * @param value 计数器地址。
+ * @param delta 增量，可以为负数。
+ */
+void parking_atomic_add_long(volatile long *value, long delta);
+
+/**
+ * @brief 原子地写入一个 long 计数器。
+ * @param value 计数器地址。
+ * @param new_value 要写入的值。
+ */
+void parking_atomic_store_long(volatile long *value, long new_value);
+
+/**
+ * @brief 原子地读取一个指针。
+ * @param value 指针变量的地址。
+ * @return 读取到的指针。
+ */
+void *parking_atomic_load_ptr(void *const volatile *value);
+
+/**
+ * @brief 原子地写入一个指针并返回原值。
+ * @details 写入之前对新指针所指对象的修改，对读到该指针的线程可见。
+ * @param value 指针变量的地址。
+ * @param new_value 要写入的指针。
+ * @return 写入前的指针。
+ */
+void *parking_atomic_exchange_ptr(void *volatile *value, void *new_value);
+
+/**
+ * @brief 完整的内存屏障。
+ * @details 屏障之前的读写不会被编译器或处理器移到屏障之后，反之亦然；
+ *          用于保护普通读写与原子操作之间的顺序（如顺序锁的读者）。
+ */
+void parking_atomic_fence(void);
+
+/** @} */
+
+/** @name 信号 */
+/** @{ */
+
+/**
+ * @brief 创建一个未触发的信号。
+ * @return 成功返回新信号，内存不足或系统资源不足时返回 NULL。
+ */
+ParkingSignal *parking_signal_create(void);
+
+/**
+ * @brief 销毁信号。
+ * @param signal 要销毁的信号，可以为 NULL；调用时不得有线程在等待。
+ */
+void parking_signal_destroy(ParkingSignal *signal);
+
+/**
+ * @brief 触发信号，唤醒一个等待者。
+ * @param signal 目标信号。
+ */
+void parking_signal_notify(ParkingSignal *signal);
+
+/**
+ * @brief 等待信号被触发，返回时信号复位。
+ * @param signal 目标信号。
+ * @param timeout_ms 最长等待的毫秒数，0 表示一直等待。
+ * @return 被触发返回 1，超时返回 0。
+ */
+int parking_signal_wait(ParkingSignal *signal, unsigned long timeout_ms);
+
+/** @} */
+
+/** @name 线程 */
+/** @{ */
+
+/**
+ * @brief 创建并启动一个线程。
+ * @param fn 线程入口函数。
+ * @param arg 透传给入口函数的参数。
+ * @return 成功返回线程句柄，失败返回 NULL。
+ */
+ParkingThread *parking_thread_start(ParkingThreadFn fn, void *arg);
+
+/**
+ * @brief 等待线程结束并释放线程句柄。
+ * @param thread 由 parking_thread_start 返回的句柄，可以为 NULL。
+ */
+void parking_thread_join(ParkingThread *thread);
+
+/**
+ * @brief 取得当前线程的标识值。
+ * @details 同一线程多次调用返回相同的值，不同的存活线程通常返回不同的值，
+ *          用于把计数分散到按线程划分的分片上；不保证唯一，不能用于同步。
+ * @return 当前线程的标识值。
+ */
+unsigned long parking_thread_current_id(void);
+
+/**
+ * @brief 取得当前可用的处理器数。
+ * @return 处理器数；无法确定时返回 1。
+ */
+int parking_cpu_count(void);
+
+/** @} */
+
+/** @name 线程私有数据 */
+/** @{ */
+
+/**
+ * @brief 创建一个线程私有数据键。
+ * @param destructor 线程结束时对其非 NULL 值调用的函数，可以为 NULL；
+ *        32 位 Windows 下不注册（FLS 回调的调用约定不同），线程结束时不调用。
+ * @return 成功返回新键，系统资源不足时返回 NULL。
+ */
+ParkingThreadKey *parking_thread_key_create(ParkingThreadKeyFn destructor);
+
+/**
+ * @brief 销毁线程私有数据键，不调用析构函数。
+ * @param key 要销毁的键，可以为 NULL。
+ */
+void parking_thread_key_destroy(ParkingThreadKey *key);
+
+/**
+ * @brief 读取当前线程在键下保存的指针。
+ * @param key 目标键。
+ * @return 保存的指针，从未设置时返回 NULL。
+ */
+void *parking_thread_key_get(ParkingThreadKey *key);
+
+/**
+ * @brief 设置当前线程在键下保存的指针。
+ * @param key 目标键。
+ * @param value 要保存的指针。
+ * @return 成功返回 0，失败返回 -1。
+ */
+int parking_thread_key_set(ParkingThreadKey *key, void *value);
+
+/** @} */
+
+#endif /* PARKING_THREAD_H */
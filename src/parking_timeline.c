@@ -0,0 +1,319 @@
+/**
+ * @file parking_timeline.c
+ * @brief 时间线实现文件
+ * @details
+ * 该文件实现了 parking_timeline.h 中声明的分段存储与按时间重放。
+ * 分段放在环形数组中，丢弃最早的一段只需推进 first；记录区与稀疏索引
+ * 按倍增扩容。
+ */
+
+#include <string.h>
+
+#include "parking_codec.h"
+#include "parking_timeline.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 取得按时间顺序的第 index 段。
+ * @param timeline 目标时间线。
+ * @param index 0 表示最早的一段。
+ * @return 分段。
+ */
+static TimelineSegment *segment_at(const ParkingTimeline *timeline,
+                                   int index) {
+  return &timeline->segments[(timeline->first + index) %
+                             timeline->max_segments];
+}
+
+/**
+ * @brief (静态辅助函数) 释放分段的全部内存并清零。
+ * @param timeline 分段所属的时间线。
+ * @param segment 目标分段。
+ */
+static void segment_clear(ParkingTimeline *timeline, TimelineSegment *segment) {
+  parking_memory_free(timeline->memory, segment->snapshot);
+  parking_memory_free(timeline->memory, segment->records);
+  parking_memory_free(timeline->memory, segment->marks);
+  memset(segment, 0, sizeof(*segment));
+}
+
+/**
+ * @brief (静态辅助函数) 确保记录区还能放下 extra 字节。
+ * @param timeline 分段所属的时间线。
+ * @param segment 目标分段。
+ * @param extra 需要追加的字节数。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int reserve_records(ParkingTimeline *timeline, TimelineSegment *segment,
+                           size_t extra) {
+  size_t capacity = segment->capacity > 0 ? segment->capacity : 4096;
+  unsigned char *records;
+
+  if (segment->size + extra <= segment->capacity) {
+    return 0;
+  }
+  while (capacity < segment->size + extra) {
+    capacity *= 2;
+  }
+  records = (unsigned char *)parking_memory_realloc(
+      timeline->memory, PARKING_MEMORY_INDEX, segment->records, capacity);
+  if (records == NULL) {
+    return -1;
+  }
+  segment->records = records;
+  segment->capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief (静态辅助函数) 在稀疏时间索引末尾追加一项。
+ * @param timeline 分段所属的时间线。
+ * @param segment 目标分段。
+ * @param when 记录的业务时间。
+ * @param offset 记录在记录区中的偏移。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+static int push_mark(ParkingTimeline *timeline, TimelineSegment *segment,
+                     time_t when, size_t offset) {
+  if (segment->mark_count == segment->mark_capacity) {
+    int capacity = segment->mark_capacity > 0 ? segment->mark_capacity * 2 : 16;
+    TimelineMark *marks = (TimelineMark *)parking_memory_realloc(
+        timeline->memory, PARKING_MEMORY_INDEX, segment->marks,
+        (size_t)capacity * sizeof(TimelineMark));
+
+    if (marks == NULL) {
+      return -1;
+    }
+    segment->marks = marks;
+    segment->mark_capacity = capacity;
+  }
+  segment->marks[segment->mark_count].when = when;
+  segment->marks[segment->mark_count].offset = offset;
+  segment->mark_count++;
+  return 0;
+}
+
+/* ========================================================================== */
+/*                                时间线API实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一条没有分段的时间线。
+ * @param memory 分配来源，NULL 表示 C 堆。
+ * @param segment_records 每段的记录数上限。
+ * @param max_segments 最多保留的分段数。
+ * @return 成功返回时间线；参数无效或内存不足返回 NULL。
+ */
+ParkingTimeline *timeline_create(ParkingMemory *memory, int segment_records,
+                                 int max_segments) {
+  ParkingTimeline *timeline;
+
+  if (segment_records <= 0 || max_segments <= 0) {
+    return NULL;
+  }
+  timeline = (ParkingTimeline *)parking_memory_calloc(
+      memory, PARKING_MEMORY_INDEX, 1, sizeof(ParkingTimeline));
+  if (timeline == NULL) {
+    return NULL;
+  }
+  timeline->segments = (TimelineSegment *)parking_memory_calloc(
+      memory, PARKING_MEMORY_INDEX, (size_t)max_segments,
+      sizeof(TimelineSegment));
+  if (timeline->segments == NULL) {
+    parking_memory_free(memory, timeline);
+    return NULL;
+  }
+  timeline->max_segments = max_segments;
+  timeline->segment_records = segment_records;
+  timeline->memory = memory;
+  return timeline;
+}
+
+/**
+ * @brief 释放时间线与全部分段。
+ * @param timeline 要释放的时间线，可以为 NULL。
+ */
+void timeline_free(ParkingTimeline *timeline) {
+  int i;
+
+  if (timeline == NULL) {
+    return;
+  }
+  for (i = 0; i < timeline->count; i++) {
+    segment_clear(timeline, segment_at(timeline, i));
+  }
+  parking_memory_free(timeline->memory, timeline->segments);
+  parking_memory_free(timeline->memory, timeline);
+}
+
+/**
+ * @brief 以一份快照开始新的分段。
+ * @param timeline 目标时间线。
+ * @param when 检查点的业务时间。
+ * @param snapshot 二进制快照内容。
+ * @param size 快照的字节数。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int timeline_begin_segment(ParkingTimeline *timeline, time_t when,
+                           const unsigned char *snapshot, size_t size) {
+  TimelineSegment *segment;
+  unsigned char *copy;
+
+  if (timeline == NULL || snapshot == NULL || size == 0) {
+    return -1;
+  }
+  copy = (unsigned char *)parking_memory_alloc(timeline->memory,
+                                               PARKING_MEMORY_INDEX, size);
+  if (copy == NULL) {
+    return -3;
+  }
+  memcpy(copy, snapshot, size);
+
+  if (timeline->count > 0 &&
+      when < segment_at(timeline, timeline->count - 1)->last_time) {
+    when = segment_at(timeline, timeline->count - 1)->last_time;
+  }
+  if (timeline->count == timeline->max_segments) {
+    /* 满额时复用最早一段的位置 */
+    segment_clear(timeline, segment_at(timeline, 0));
+    timeline->first = (timeline->first + 1) % timeline->max_segments;
+    timeline->count--;
+  }
+  segment = segment_at(timeline, timeline->count);
+  timeline->count++;
+  segment->start_time = when;
+  segment->last_time = when;
+  segment->snapshot = copy;
+  segment->snapshot_size = size;
+  return 0;
+}
+
+/**
+ * @brief 把一条记录追加到最新的分段。
+ * @param timeline 目标时间线。
+ * @param when 记录的业务时间。
+ * @param record 日志记录。
+ * @return 成功返回 0，尚无分段或参数无效返回 -1，内存不足返回 -3。
+ */
+int timeline_append(ParkingTimeline *timeline, time_t when,
+                    const JournalRecord *record) {
+  TimelineSegment *segment;
+  size_t length;
+
+  if (timeline == NULL || record == NULL || timeline->count == 0) {
+    return -1;
+  }
+  segment = segment_at(timeline, timeline->count - 1);
+  if (when < segment->last_time) {
+    when = segment->last_time;
+  }
+  if (reserve_records(timeline, segment, 8 + JOURNAL_MAX_RECORD_SIZE) != 0) {
+    return -3;
+  }
+  if (segment->record_count % TIMELINE_MARK_STRIDE == 0 &&
+      push_mark(timeline, segment, when, segment->size) != 0) {
+    return -3;
+  }
+  codec_put_time(segment->records + segment->size, when);
+  length = journal_encode_record(record, segment->records + segment->size + 8);
+  segment->size += 8 + length;
+  segment->record_count++;
+  segment->last_time = when;
+  return 0;
+}
+
+/**
+ * @brief 判断最新的分段是否已达到记录数上限。
+ * @param timeline 目标时间线。
+ * @return 已满返回 1，否则返回 0。
+ */
+int timeline_segment_full(const ParkingTimeline *timeline) {
+  return timeline != NULL && timeline->count > 0 &&
+         segment_at(timeline, timeline->count - 1)->record_count >=
+             timeline->segment_records;
+}
+
+/**
+ * @brief 找到起始时间不晚于 when 的最近一段。
+ * @param timeline 目标时间线。
+ * @param when 回溯的时刻。
+ * @return 分段；when 早于保留的最早检查点时返回 NULL。
+ */
+const TimelineSegment *timeline_find_segment(const ParkingTimeline *timeline,
+                                             time_t when) {
+  int low = 0;
+  int high;
+
+  if (timeline == NULL || timeline->count == 0 ||
+      segment_at(timeline, 0)->start_time > when) {
+    return NULL;
+  }
+  /* 找最后一个 start_time <= when 的分段 */
+  high = timeline->count - 1;
+  while (low < high) {
+    int middle = low + (high - low + 1) / 2;
+
+    if (segment_at(timeline, middle)->start_time <= when) {
+      low = middle;
+    } else {
+      high = middle - 1;
+    }
+  }
+  return segment_at(timeline, low);
+}
+
+/**
+ * @brief 按时间顺序重放分段中业务时间不晚于 when 的记录。
+ * @param segment 目标分段。
+ * @param when 回溯的时刻。
+ * @param replay 对每条记录调用的回调。
+ * @param ctx 透传给回调的上下文指针。
+ * @return 重放的记录数；参数无效或记录损坏返回 -1。
+ */
+long timeline_replay(const TimelineSegment *segment, time_t when,
+                     JournalReplayFn replay, void *ctx) {
+  JournalRecord record;
+  size_t offset = 0;
+  size_t end = 0;
+  long count = 0;
+  int low = 0;
+  int high;
+
+  if (segment == NULL || replay == NULL) {
+    return -1;
+  }
+  /* 在稀疏索引中找到第一个晚于 when 的索引项，终点在它之前的一跨内 */
+  high = segment->mark_count;
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+
+    if (segment->marks[middle].when <= when) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  end = low < segment->mark_count ? segment->marks[low].offset : segment->size;
+
+  while (offset < end) {
+    long used;
+
+    if (codec_get_time(segment->records + offset) > when) {
+      break;
+    }
+    used = journal_decode_record(segment->records + offset + 8,
+                                 end - offset - 8, &record);
+    if (used <= 0) {
+      return -1;
+    }
+    offset += 8 + (size_t)used;
+    count++;
+    if (replay(&record, ctx) != 0) {
+      break;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,152 @@
+#ifndef PARKING_TIMELINE_H
+#define PARKING_TIMELINE_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "parking_journal.h"
+#include "parking_memory.h"
+
+/**
+ * @file parking_timeline.h
+ * @brief 按时间回溯停车场状态的检查点与变更记录声明。
+ * @details
+ * 审计时常要回答“某天 14:05 谁停在 1203 号车位”。预写日志压缩后即被
+ * 清空，当前状态也只反映现在；时间线在内存中保留最近一段时间的历史：
+ * 若干个分段，每段以一份快照（检查点）开头，后面按时间顺序追加此后的
+ * 日志记录，每条记录带上业务时间。
+ *
+ * 回溯到时刻 T 时，先按各段起始时间二分找到 T 之前最近的检查点，从快照
+ * 重建停车场，再只重放该段中时间不晚于 T 的记录。每段的记录数有上限，
+ * 重放长度因此有界；段内另有每 TIMELINE_MARK_STRIDE 条一个的稀疏时间
+ * 索引，按时间直接定位重放的终点。超过 max_segments 段后丢弃最早的一段。
+ *
+ * 时间线本身不加锁，由停车场的锁保护。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define TIMELINE_DEFAULT_SEGMENT_RECORDS 4096 /**< 默认每段的记录数上限 */
+#define TIMELINE_DEFAULT_SEGMENTS 24          /**< 默认保留的分段数 */
+#define TIMELINE_MARK_STRIDE 64 /**< 稀疏时间索引每隔多少条记录一项 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 稀疏时间索引中的一项。
+ */
+typedef struct TimelineMark {
+  time_t when;   /**< 该条记录的业务时间。 */
+  size_t offset; /**< 该条记录在记录区中的偏移。 */
+} TimelineMark;
+
+/**
+ * @brief 以一个检查点开头的一段历史。
+ * @details 记录区中每条记录是 8 字节业务时间加日志编码，时间不递减。
+ */
+typedef struct TimelineSegment {
+  time_t start_time;        /**< 检查点的业务时间。 */
+  unsigned char *snapshot;  /**< 检查点的二进制快照内容。 */
+  size_t snapshot_size;     /**< 快照的字节数。 */
+  unsigned char *records;   /**< 检查点之后的记录。 */
+  size_t size;              /**< 记录区已用的字节数。 */
+  size_t capacity;          /**< 记录区已分配的字节数。 */
+  int record_count;         /**< 记录条数。 */
+  time_t last_time;         /**< 最后一条记录的业务时间。 */
+  TimelineMark *marks;      /**< 稀疏时间索引。 */
+  int mark_count;           /**< 索引项数。 */
+  int mark_capacity;        /**< 索引已分配的项数。 */
+} TimelineSegment;
+
+/**
+ * @brief 若干个分段组成的时间线。
+ */
+typedef struct ParkingTimeline {
+  TimelineSegment *segments; /**< 分段的环形数组。 */
+  int first;                 /**< 最早一段在环形数组中的下标。 */
+  int count;                 /**< 已有的分段数。 */
+  int max_segments;          /**< 最多保留的分段数。 */
+  int segment_records;       /**< 每段的记录数上限。 */
+  ParkingMemory *memory;     /**< 分配来源，NULL 表示 C 堆。 */
+} ParkingTimeline;
+
+/**
+ *********************************************************************************
+ *                               时间线API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一条没有分段的时间线。
+ * @param memory 分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @param segment_records 每段的记录数上限，必须大于 0。
+ * @param max_segments 最多保留的分段数，必须大于 0。
+ * @return 成功返回时间线；参数无效或内存不足返回 NULL。
+ */
+ParkingTimeline *timeline_create(ParkingMemory *memory, int segment_records,
+                                 int max_segments);
+
+/**
+ * @brief 释放时间线与全部分段。
+ * @param timeline 要释放的时间线，可以为 NULL。
+ */
+void timeline_free(ParkingTimeline *timeline);
+
+/**
+ * @brief 以一份快照开始新的分段，分段已满额时丢弃最早的一段。
+ * @param timeline 目标时间线。
+ * @param when 检查点的业务时间。
+ * @param snapshot 二进制快照内容（复制保存）。
+ * @param size 快照的字节数。
+ * @return 成功返回 0，参数无效返回 -1，内存不足返回 -3。
+ */
+int timeline_begin_segment(ParkingTimeline *timeline, time_t when,
+                           const unsigned char *snapshot, size_t size);
+
+/**
+ * @brief 把一条记录追加到最新的分段。
+ * @details 早于上一条记录的时间按上一条记录的时间计，保持时间不递减。
+ * @param timeline 目标时间线。
+ * @param when 记录的业务时间。
+ * @param record 日志记录。
+ * @return 成功返回 0，尚无分段或参数无效返回 -1，内存不足返回 -3。
+ */
+int timeline_append(ParkingTimeline *timeline, time_t when,
+                    const JournalRecord *record);
+
+/**
+ * @brief 判断最新的分段是否已达到记录数上限，应开始新的检查点。
+ * @param timeline 目标时间线。
+ * @return 已满返回 1，否则返回 0。
+ */
+int timeline_segment_full(const ParkingTimeline *timeline);
+
+/**
+ * @brief 找到起始时间不晚于 when 的最近一段。
+ * @param timeline 目标时间线。
+ * @param when 回溯的时刻。
+ * @return 分段；when 早于保留的最早检查点时返回 NULL。
+ */
+const TimelineSegment *timeline_find_segment(const ParkingTimeline *timeline,
+                                             time_t when);
+
+/**
+ * @brief 按时间顺序重放分段中业务时间不晚于 when 的记录。
+ * @param segment 目标分段。
+ * @param when 回溯的时刻。
+ * @param replay 对每条记录调用的回调，返回非 0 时停止。
+ * @param ctx 透传给回调的上下文指针。
+ * @return 重放的记录数；参数无效或记录损坏返回 -1。
+ */
+long timeline_replay(const TimelineSegment *segment, time_t when,
+                     JournalReplayFn replay, void *ctx);
+
+#endif /* PARKING_TIMELINE_H */
@@ -0,0 +1,302 @@
+/**
+ * @file parking_timer.c
+ * @brief 分层时间轮实现文件
+ * @details
+ * 该文件实现了 parking_timer.h 中声明的时间轮。
+ * 桶是以 pprev 串联的单向链表，撤销定时器时不需要知道它在哪个桶里。
+ * 层与桶下标只取时间戳的低 24 位，time_t 为 32 位或 64 位时结果相同。
+ */
+
+#include <stddef.h>
+
+#include "parking_timer.h"
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SIZE - 1) /**< 桶下标掩码 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 取时刻在某一层的桶下标。
+ * @param when 时刻。
+ * @param level 层。
+ * @return 桶下标。
+ */
+static int bucket_index(time_t when, int level) {
+  return (int)(((unsigned long)when >> (TIMER_WHEEL_BITS * level)) &
+               TIMER_WHEEL_MASK);
+}
+
+/**
+ * @brief (静态辅助函数) 把定时器挂到某一层某个桶的表头。
+ * @param wheel 目标时间轮。
+ * @param timer 未登记的定时器。
+ * @param level 层。
+ * @param index 桶下标。
+ */
+static void bucket_push(TimerWheel *wheel, ParkingTimer *timer, int level,
+                        int index) {
+  ParkingTimer **head = &wheel->buckets[level][index];
+
+  timer->next = *head;
+  if (*head != NULL) {
+    (*head)->pprev = &timer->next;
+  }
+  *head = timer;
+  timer->pprev = head;
+  timer->level = level;
+  wheel->level_counts[level]++;
+  wheel->count++;
+}
+
+/**
+ * @brief (静态辅助函数) 按距到期的时间选择层与桶并登记定时器。
+ * @param wheel 目标时间轮。
+ * @param timer 未登记、已设置 expires 的定时器。
+ */
+static void wheel_place(TimerWheel *wheel, ParkingTimer *timer) {
+  time_t when = timer->expires;
+  long delta;
+  int level;
+
+  if (when < wheel->current) {
+    bucket_push(wheel, timer, 0, bucket_index(wheel->current, 0));
+    return;
+  }
+  delta = (long)(when - wheel->current);
+  if (delta >= TIMER_WHEEL_SPAN) {
+    /* 超出覆盖范围时先放在最远的桶，下放时再按真实到期时刻归位 */
+    delta = TIMER_WHEEL_SPAN - 1;
+    when = wheel->current + (time_t)delta;
+  }
+  for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+    if (delta < (1L << (TIMER_WHEEL_BITS * (level + 1)))) {
+      break;
+    }
+  }
+  bucket_push(wheel, timer, level, bucket_index(when, level));
+}
+
+/**
+ * @brief (静态辅助函数) 把某一层的一个桶整体摘下，逐个按当前位置重新归位。
+ * @param wheel 目标时间轮。
+ * @param level 层。
+ * @param index 桶下标。
+ */
+static void wheel_cascade(TimerWheel *wheel, int level, int index) {
+  ParkingTimer *timer = wheel->buckets[level][index];
+
+  wheel->buckets[level][index] = NULL;
+  while (timer != NULL) {
+    ParkingTimer *next = timer->next;
+
+    wheel->level_counts[level]--;
+    wheel->count--;
+    wheel_place(wheel, timer);
+    timer = next;
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 计算下一个需要处理的秒。
+ * @details 低层为空时其中的秒都不会触发任何定时器，
+ *          直接跳到最低非空层的下一个下放边界。
+ * @param wheel 目标时间轮。
+ * @return 下一个需要处理的秒。
+ */
+static time_t wheel_next_stop(const TimerWheel *wheel) {
+  unsigned long step;
+  int level = 0;
+
+  while (level < TIMER_WHEEL_LEVELS && wheel->level_counts[level] == 0) {
+    level++;
+  }
+  if (level == 0) {
+    return wheel->current;
+  }
+  if (level == TIMER_WHEEL_LEVELS) {
+    level = TIMER_WHEEL_LEVELS - 1;
+  }
+  step = 1UL << (TIMER_WHEEL_BITS * level);
+  if (((unsigned long)wheel->current & (step - 1)) == 0) {
+    return wheel->current;
+  }
+  return wheel->current + (time_t)(step - ((unsigned long)wheel->current &
+                                           (step - 1)));
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 把定时器节点初始化为未登记状态。
+ * @param timer 目标定时器。
+ */
+void timer_init(ParkingTimer *timer) {
+  if (timer == NULL) {
+    return;
+  }
+  timer->next = NULL;
+  timer->pprev = NULL;
+  timer->expires = 0;
+  timer->level = 0;
+}
+
+/**
+ * @brief 判断定时器是否已登记在时间轮中。
+ * @param timer 目标定时器。
+ * @return 已登记返回 1，否则返回 0。
+ */
+int timer_pending(const ParkingTimer *timer) {
+  return timer != NULL && timer->pprev != NULL;
+}
+
+/**
+ * @brief 把时间轮初始化为空，并把当前位置设为 now。
+ * @param wheel 目标时间轮。
+ * @param now 当前时刻。
+ */
+void timer_wheel_init(TimerWheel *wheel, time_t now) {
+  int level;
+  int index;
+
+  if (wheel == NULL) {
+    return;
+  }
+  for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    for (index = 0; index < TIMER_WHEEL_SIZE; index++) {
+      wheel->buckets[level][index] = NULL;
+    }
+    wheel->level_counts[level] = 0;
+  }
+  wheel->count = 0;
+  wheel->current = now;
+}
+
+/**
+ * @brief 登记定时器；已登记的定时器改为新的到期时刻。
+ * @param wheel 目标时间轮。
+ * @param timer 定时器节点。
+ * @param expires 到期时刻。
+ */
+void timer_wheel_add(TimerWheel *wheel, ParkingTimer *timer, time_t expires) {
+  if (wheel == NULL || timer == NULL) {
+    return;
+  }
+  timer_wheel_cancel(wheel, timer);
+  timer->expires = expires;
+  wheel_place(wheel, timer);
+}
+
+/**
+ * @brief 撤销定时器；未登记的定时器不受影响。
+ * @param wheel 目标时间轮。
+ * @param timer 定时器节点。
+ */
+void timer_wheel_cancel(TimerWheel *wheel, ParkingTimer *timer) {
+  if (wheel == NULL || timer == NULL || timer->pprev == NULL) {
+    return;
+  }
+  *timer->pprev = timer->next;
+  if (timer->next != NULL) {
+    timer->next->pprev = timer->pprev;
+  }
+  timer->next = NULL;
+  timer->pprev = NULL;
+  wheel->level_counts[timer->level]--;
+  wheel->count--;
+}
+
+/**
+ * @brief 把全部定时器按当前位置 now 重新归位。
+ * @details 先把所有桶串成一条链表，再逐个登记，避免边摘边放时重复处理。
+ * @param wheel 目标时间轮。
+ * @param now 新的当前位置。
+ */
+void timer_wheel_rebase(TimerWheel *wheel, time_t now) {
+  ParkingTimer *all = NULL;
+  ParkingTimer *timer;
+  int level;
+  int index;
+
+  if (wheel == NULL) {
+    return;
+  }
+  for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    for (index = 0; index < TIMER_WHEEL_SIZE; index++) {
+      timer = wheel->buckets[level][index];
+      while (timer != NULL) {
+        ParkingTimer *next = timer->next;
+
+        timer->next = all;
+        all = timer;
+        timer = next;
+      }
+      wheel->buckets[level][index] = NULL;
+    }
+    wheel->level_counts[level] = 0;
+  }
+  wheel->count = 0;
+  wheel->current = now;
+
+  while (all != NULL) {
+    timer = all;
+    all = all->next;
+    wheel_place(wheel, timer);
+  }
+}
+
+/**
+ * @brief 把时间轮推进到 now（含），依次触发到期的定时器。
+ * @details 每处理一秒：若到达高层桶的边界先下放该桶，然后逐个摘下第 0 层
+ *          对应桶中的定时器并回调；回调中登记到当前秒的定时器同样在本秒触发。
+ * @param wheel 目标时间轮。
+ * @param now 推进到的时刻。
+ * @param fire 到期回调，不能为 NULL。
+ * @param ctx 透传给回调的上下文指针。
+ * @return 触发的定时器数。
+ */
+int timer_wheel_advance(TimerWheel *wheel, time_t now, TimerCallback fire,
+                        void *ctx) {
+  int fired = 0;
+
+  if (wheel == NULL || fire == NULL || now < wheel->current) {
+    return 0;
+  }
+  if ((long)(now - wheel->current) >= TIMER_WHEEL_SPAN) {
+    timer_wheel_rebase(wheel, now);
+  }
+
+  while (wheel->current <= now) {
+    int index;
+    int level;
+
+    if (wheel->count == 0) {
+      wheel->current = now + 1;
+      break;
+    }
+    wheel->current = wheel_next_stop(wheel);
+    if (wheel->current > now) {
+      break;
+    }
+
+    index = bucket_index(wheel->current, 0);
+    for (level = 1; index == 0 && level < TIMER_WHEEL_LEVELS; level++) {
+      index = bucket_index(wheel->current, level);
+      wheel_cascade(wheel, level, index);
+    }
+
+    index = bucket_index(wheel->current, 0);
+    while (wheel->buckets[0][index] != NULL) {
+      ParkingTimer *timer = wheel->buckets[0][index];
+
+      timer_wheel_cancel(wheel, timer);
+      fire(timer, ctx);
+      fired++;
+    }
+    wheel->current++;
+  }
+  return fired;
+}
@@ -0,0 +1,136 @@
+#ifndef PARKING_TIMER_H
+#define PARKING_TIMER_H
+
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * @file parking_timer.h
+ * @brief 以秒为刻度的分层时间轮声明。
+ * @details
+ * 时间轮由 TIMER_WHEEL_LEVELS 层、每层 TIMER_WHEEL_SIZE 个桶组成：
+ * 第 0 层每桶 1 秒，第 k 层每桶 64^k 秒，整个时间轮覆盖 TIMER_WHEEL_SPAN 秒。
+ * 定时器按距到期的时间放入对应层的桶，登记与撤销都是 O(1)；
+ * 时间推进到高层桶的边界时，该桶的定时器整体下放（cascade）到低层。
+ * 推进时低层为空会直接跳到下一个下放边界，因此时钟长时间没有推进、
+ * 或虚拟时钟一次跳过很久时，耗时与经过的秒数无关。
+ *
+ * 定时器节点嵌入在使用者的结构体中（例如车位节点），时间轮不分配内存；
+ * 到期回调通过节点地址找回所属结构。时间轮本身不加锁，由持有者负责同步。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define TIMER_WHEEL_BITS 6 /**< 每层桶数的二进制位数 */
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS) /**< 每层的桶数 */
+#define TIMER_WHEEL_LEVELS 4 /**< 层数 */
+#define TIMER_WHEEL_SPAN                                                       \
+  (1L << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) /**< 覆盖的秒数（约 194 天） */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 嵌入在使用者结构体中的定时器节点。
+ * @details 超过 TIMER_WHEEL_SPAN 的定时器先放在最高层最远的桶里，
+ *          每次下放时按真实的到期时间重新归位，不会提前触发。
+ */
+typedef struct ParkingTimer {
+  struct ParkingTimer *next;   /**< 同一个桶中的下一个定时器。 */
+  struct ParkingTimer **pprev; /**< 指向前一项 next 的指针，NULL 表示未登记。 */
+  time_t expires;              /**< 到期时刻。 */
+  int level;                   /**< 所在的层。 */
+} ParkingTimer;
+
+/**
+ * @brief 分层时间轮。
+ */
+typedef struct TimerWheel {
+  ParkingTimer *buckets[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE]; /**< 各层的桶。 */
+  size_t level_counts[TIMER_WHEEL_LEVELS]; /**< 各层登记的定时器数。 */
+  size_t count;   /**< 登记的定时器总数。 */
+  time_t current; /**< 下一个待处理的秒；早于它的定时器都已触发。 */
+} TimerWheel;
+
+/**
+ * @brief 定时器到期时调用的回调函数。
+ * @details 调用前定时器已从时间轮中摘下，回调中可以重新登记它，
+ *          也可以登记或撤销其他定时器。
+ * @param timer 到期的定时器。
+ * @param ctx 调用者传入的上下文指针。
+ */
+typedef void (*TimerCallback)(ParkingTimer *timer, void *ctx);
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 把定时器节点初始化为未登记状态。
+ * @param timer 目标定时器。
+ */
+void timer_init(ParkingTimer *timer);
+
+/**
+ * @brief 判断定时器是否已登记在时间轮中。
+ * @param timer 目标定时器。
+ * @return 已登记返回 1，否则返回 0。
+ */
+int timer_pending(const ParkingTimer *timer);
+
+/**
+ * @brief 把时间轮初始化为空，并把当前位置设为 now。
+ * @param wheel 目标时间轮。
+ * @param now 当前时刻。
+ */
+void timer_wheel_init(TimerWheel *wheel, time_t now);
+
+/**
+ * @brief 登记定时器；已登记的定时器改为新的到期时刻。
+ * @details 到期时刻早于当前位置的定时器在下一次推进时立即触发。
+ * @param wheel 目标时间轮。
+ * @param timer 定时器节点。
+ * @param expires 到期时刻。
+ */
+void timer_wheel_add(TimerWheel *wheel, ParkingTimer *timer, time_t expires);
+
+/**
+ * @brief 撤销定时器；未登记的定时器不受影响。
+ * @param wheel 目标时间轮。
+ * @param timer 定时器节点。
+ */
+void timer_wheel_cancel(TimerWheel *wheel, ParkingTimer *timer);
+
+/**
+ * @brief 把全部定时器按当前位置 now 重新归位。
+ * @details 用于时钟回拨：到期时刻早于 now 的定时器在下一次推进时触发。
+ *          耗时与登记的定时器数成正比。
+ * @param wheel 目标时间轮。
+ * @param now 新的当前位置。
+ */
+void timer_wheel_rebase(TimerWheel *wheel, time_t now);
+
+/**
+ * @brief 把时间轮推进到 now（含），依次触发到期的定时器。
+ * @details 同一秒内到期的定时器触发顺序不确定。now 早于当前位置时不做任何事；
+ *          一次推进超过 TIMER_WHEEL_SPAN 时先按 now 重新归位，
+ *          期间到期的定时器一并触发。
+ * @param wheel 目标时间轮。
+ * @param now 推进到的时刻。
+ * @param fire 到期回调，不能为 NULL。
+ * @param ctx 透传给回调的上下文指针。
+ * @return 触发的定时器数。
+ */
+int timer_wheel_advance(TimerWheel *wheel, time_t now, TimerCallback fire,
+                        void *ctx);
+
+#endif /* PARKING_TIMER_H */
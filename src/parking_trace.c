@@ -0,0 +1,396 @@
+/**
+ * @file parking_trace.c
+ * @brief 服务操作区间追踪的实现文件
+ * @details
+ * 该文件实现了 parking_trace.h 中声明的按线程划分的区间环与 Chrome 追踪
+ * 事件导出。每个环只有领取它的线程写入 head、只有导出方写入 tail，
+ * 两者都在 [0, 2 * capacity) 内循环，差值即环中的区间数，满与空不会混淆。
+ * 单调时钟需要 POSIX 的 clock_gettime，因此与 parking_metrics.c 一样
+ * 在包含系统头文件前显式开启 _POSIX_C_SOURCE。
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "parking_thread.h"
+#include "parking_trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/* ========================================================================== */
+/*                                 内部数据结构                               */
+/* ========================================================================== */
+
+#define TRACE_RING_FREE 0    /**< 环未被领取 */
+#define TRACE_RING_ACTIVE 1  /**< 环属于一个存活的线程 */
+#define TRACE_RING_RETIRED 2 /**< 领取环的线程已结束，清空后回收 */
+
+/**
+ * @brief 环中的一个区间。
+ */
+typedef struct TraceEvent {
+  const char *category; /**< 区间类别。 */
+  const char *name;     /**< 区间名称。 */
+  double start_us;      /**< 开始时刻（微秒）。 */
+  double duration_us;   /**< 持续时间（微秒）。 */
+} TraceEvent;
+
+/**
+ * @brief 一个线程独占的区间环。
+ */
+typedef struct TraceRing {
+  volatile int state;    /**< TRACE_RING_FREE / ACTIVE / RETIRED。 */
+  volatile int head;     /**< 下一个写入位置，只由领取环的线程修改。 */
+  volatile int tail;     /**< 下一个导出位置，只由导出方修改。 */
+  volatile long recorded; /**< 已写入的区间数。 */
+  volatile long dropped;  /**< 环已满时丢弃的区间数。 */
+  int capacity;           /**< 区间数，2 的幂。 */
+  int tid;                /**< 导出时使用的线程编号。 */
+  TraceEvent *events;     /**< 区间数组。 */
+} TraceRing;
+
+/** 全部线程环，静态分配。 */
+static TraceRing trace_rings[TRACE_MAX_THREADS];
+
+/** 领不到环的线程在线程私有数据中保存的标记，不存放区间。 */
+static TraceRing trace_no_ring;
+
+static volatile int trace_enabled = 0;    /**< 非 0 表示追踪打开 */
+static volatile int trace_lock = 0;       /**< 保护领取、回收与打开的自旋锁 */
+static volatile int trace_flush_lock = 0; /**< 串行化导出方的自旋锁 */
+static volatile long trace_lost = 0;      /**< 领不到环而丢弃的区间数 */
+static volatile long trace_retired = 0;   /**< 已回收的环中写入过的区间数 */
+static ParkingThreadKey *trace_key = NULL; /**< 线程到其环的映射 */
+static int trace_capacity = TRACE_DEFAULT_EVENTS; /**< 新领取的环的容量 */
+static int trace_serial = 0;              /**< 已分配的线程编号 */
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 获取自旋锁。
+ * @param lock 目标锁。
+ */
+static void trace_spin_lock(volatile int *lock) {
+  while (parking_atomic_exchange_int(lock, 1) != 0) {
+    while (parking_atomic_load_int(lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 读取单调时钟。
+ * @details 以 double 表示微秒，32 位 long 的平台上也不会回绕。
+ * @return 当前单调时刻（微秒）。
+ */
+static double trace_now_us(void) {
+#ifdef _WIN32
+  LARGE_INTEGER counter;
+  LARGE_INTEGER frequency;
+
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (double)counter.QuadPart * 1e6 / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 线程结束时把它的环标记为待回收。
+ * @param value 线程私有数据中保存的环。
+ */
+static void trace_retire_ring(void *value) {
+  TraceRing *ring = (TraceRing *)value;
+
+  if (ring != &trace_no_ring) {
+    parking_atomic_store_int(&ring->state, TRACE_RING_RETIRED);
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 为当前线程领取一个空闲的环。
+ * @details 没有空闲的环或内存不足时记下 trace_no_ring，
+ *          该线程之后的区间直接计为丢弃，不再反复加锁尝试。
+ * @return 领取到的环或 trace_no_ring；无法保存到线程私有数据时返回 NULL。
+ */
+static TraceRing *trace_claim_ring(void) {
+  TraceRing *ring = &trace_no_ring;
+  int i;
+
+  trace_spin_lock(&trace_lock);
+  for (i = 0; i < TRACE_MAX_THREADS; i++) {
+    TraceRing *candidate = &trace_rings[i];
+
+    if (parking_atomic_load_int(&candidate->state) != TRACE_RING_FREE) {
+      continue;
+    }
+    candidate->events = (TraceEvent *)malloc((size_t)trace_capacity *
+                                             sizeof(TraceEvent));
+    if (candidate->events != NULL) {
+      candidate->capacity = trace_capacity;
+      candidate->tid = ++trace_serial;
+      candidate->head = 0;
+      candidate->tail = 0;
+      candidate->recorded = 0;
+      candidate->dropped = 0;
+      parking_atomic_store_int(&candidate->state, TRACE_RING_ACTIVE);
+      ring = candidate;
+    }
+    break;
+  }
+  parking_atomic_store_int(&trace_lock, 0);
+
+  if (parking_thread_key_set(trace_key, ring) != 0) {
+    if (ring != &trace_no_ring) {
+      parking_atomic_store_int(&ring->state, TRACE_RING_RETIRED);
+    }
+    return NULL;
+  }
+  return ring;
+}
+
+/**
+ * @brief (静态辅助函数) 把一个区间写入当前线程的环。
+ * @param category 区间类别。
+ * @param name 区间名称。
+ * @param start_us 开始时刻（微秒）。
+ * @param duration_us 持续时间（微秒）。
+ */
+static void trace_push(const char *category, const char *name,
+                       double start_us, double duration_us) {
+  TraceRing *ring = (TraceRing *)parking_thread_key_get(trace_key);
+  TraceEvent *event;
+  int head;
+  int tail;
+  int span;
+
+  if (ring == NULL) {
+    ring = trace_claim_ring();
+  }
+  if (ring == NULL || ring == &trace_no_ring) {
+    parking_atomic_add_long(&trace_lost, 1);
+    return;
+  }
+
+  span = ring->capacity * 2;
+  head = ring->head;
+  tail = parking_atomic_load_int(&ring->tail);
+  if ((head - tail + span) % span >= ring->capacity) {
+    parking_atomic_add_long(&ring->dropped, 1);
+    return;
+  }
+  event = &ring->events[head & (ring->capacity - 1)];
+  event->category = category;
+  event->name = name;
+  event->start_us = start_us;
+  event->duration_us = duration_us < 0.0 ? 0.0 : duration_us;
+  parking_atomic_store_int(&ring->head, (head + 1) & (span - 1));
+  parking_atomic_add_long(&ring->recorded, 1);
+}
+
+/**
+ * @brief (静态辅助函数) 导出一个环中的区间，线程已结束时回收该环。
+ * @param ring 目标环（调用者持有导出锁）。
+ * @param out 输出流。
+ * @param[in,out] written 已写出的区间数，用于决定是否写逗号。
+ */
+static void trace_drain_ring(TraceRing *ring, FILE *out, long *written) {
+  int state = parking_atomic_load_int(&ring->state);
+  int span;
+  int head;
+  int tail;
+
+  if (state == TRACE_RING_FREE) {
+    return;
+  }
+  span = ring->capacity * 2;
+  head = parking_atomic_load_int(&ring->head);
+  tail = ring->tail;
+  while (tail != head) {
+    const TraceEvent *event = &ring->events[tail & (ring->capacity - 1)];
+
+    fprintf(out,
+            "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+            "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+            *written > 0 ? "," : "", event->name, event->category,
+            event->start_us, event->duration_us, ring->tid);
+    (*written)++;
+    tail = (tail + 1) & (span - 1);
+  }
+  parking_atomic_store_int(&ring->tail, tail);
+
+  /* 线程结束后 head 不再变化，此时读到的 head 之前已全部导出 */
+  if (state == TRACE_RING_RETIRED) {
+    trace_spin_lock(&trace_lock);
+    parking_atomic_add_long(&trace_retired, ring->recorded);
+    parking_atomic_add_long(&trace_lost, ring->dropped);
+    free(ring->events);
+    ring->events = NULL;
+    parking_atomic_store_int(&ring->state, TRACE_RING_FREE);
+    parking_atomic_store_int(&trace_lock, 0);
+  }
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 打开追踪。
+ * @param events_per_thread 每个线程环的区间数，0 表示 TRACE_DEFAULT_EVENTS。
+ * @return 成功返回 0；参数无效返回 -1；无法创建线程私有数据键返回 -2。
+ */
+int parking_trace_enable(int events_per_thread) {
+  int capacity = 1;
+  int result = 0;
+
+  if (events_per_thread < 0 || events_per_thread > TRACE_MAX_EVENTS) {
+    return -1;
+  }
+  if (events_per_thread == 0) {
+    events_per_thread = TRACE_DEFAULT_EVENTS;
+  }
+  while (capacity < events_per_thread) {
+    capacity *= 2;
+  }
+
+  trace_spin_lock(&trace_lock);
+  if (trace_key == NULL) {
+    trace_key = parking_thread_key_create(trace_retire_ring);
+  }
+  if (trace_key == NULL) {
+    result = -2;
+  } else {
+    trace_capacity = capacity;
+    parking_atomic_store_int(&trace_enabled, 1);
+  }
+  parking_atomic_store_int(&trace_lock, 0);
+  return result;
+}
+
+/**
+ * @brief 关闭追踪，已记录的区间仍可导出。
+ */
+void parking_trace_disable(void) {
+  parking_atomic_store_int(&trace_enabled, 0);
+}
+
+/**
+ * @brief 查询追踪是否打开。
+ * @return 打开返回 1，否则返回 0。
+ */
+int parking_trace_is_enabled(void) {
+  return parking_atomic_load_int(&trace_enabled) != 0;
+}
+
+/**
+ * @brief 开始一个区间。
+ * @param span 接收区间的开始时刻。
+ * @param category 区间类别。
+ * @param name 区间名称。
+ */
+void parking_trace_begin(TraceSpan *span, const char *category,
+                         const char *name) {
+  if (!parking_atomic_load_int(&trace_enabled)) {
+    span->name = NULL;
+    return;
+  }
+  span->category = category;
+  span->name = name;
+  span->start_us = trace_now_us();
+}
+
+/**
+ * @brief 结束一个区间并记录到当前线程的环。
+ * @param span parking_trace_begin 开始的区间。
+ */
+void parking_trace_end(const TraceSpan *span) {
+  if (span->name != NULL) {
+    trace_push(span->category, span->name, span->start_us,
+               trace_now_us() - span->start_us);
+  }
+}
+
+/**
+ * @brief 记录一个刚刚结束、已知耗时的区间。
+ * @param category 区间类别。
+ * @param name 区间名称。
+ * @param elapsed_ns 区间耗时（纳秒）。
+ */
+void parking_trace_complete(const char *category, const char *name,
+                            unsigned long elapsed_ns) {
+  double duration_us;
+
+  if (!parking_atomic_load_int(&trace_enabled)) {
+    return;
+  }
+  duration_us = (double)elapsed_ns / 1e3;
+  trace_push(category, name, trace_now_us() - duration_us, duration_us);
+}
+
+/**
+ * @brief 把各线程环中尚未导出的区间以 Chrome 追踪事件格式写到流。
+ * @param out 已打开的输出流。
+ * @return 导出的区间数；参数无效或写入失败返回 -1。
+ */
+long parking_trace_flush(FILE *out) {
+  TraceStats stats;
+  long written = 0;
+  int i;
+
+  if (out == NULL) {
+    return -1;
+  }
+  trace_spin_lock(&trace_flush_lock);
+  fputs("{\"traceEvents\":[", out);
+  for (i = 0; i < TRACE_MAX_THREADS; i++) {
+    trace_drain_ring(&trace_rings[i], out, &written);
+  }
+  parking_trace_stats(&stats);
+  fprintf(out, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":"
+               "{\"dropped\":%ld}}\n",
+          stats.dropped);
+  parking_atomic_store_int(&trace_flush_lock, 0);
+
+  if (fflush(out) != 0 || ferror(out)) {
+    return -1;
+  }
+  return written;
+}
+
+/**
+ * @brief 读取追踪的累计统计。
+ * @details 与回收并发时，正在回收的环可能被计入两次。
+ * @param[out] stats 接收统计。
+ */
+void parking_trace_stats(TraceStats *stats) {
+  int i;
+
+  if (stats == NULL) {
+    return;
+  }
+  stats->recorded = parking_atomic_load_long(&trace_retired);
+  stats->dropped = parking_atomic_load_long(&trace_lost);
+  stats->threads = 0;
+  for (i = 0; i < TRACE_MAX_THREADS; i++) {
+    TraceRing *ring = &trace_rings[i];
+
+    if (parking_atomic_load_int(&ring->state) == TRACE_RING_FREE) {
+      continue;
+    }
+    stats->recorded += parking_atomic_load_long(&ring->recorded);
+    stats->dropped += parking_atomic_load_long(&ring->dropped);
+    stats->threads++;
+  }
+}
@@ -0,0 +1,150 @@
+#ifndef PARKING_TRACE_H
+#define PARKING_TRACE_H
+
+#include <stdio.h>
+
+/**
+ * @file parking_trace.h
+ * @brief 服务操作内部各阶段的区间追踪声明。
+ * @details
+ * 调用指标只给出一次操作的总耗时；排查高峰期的延迟尖刺时，还需要看到一次
+ * 操作内部的校验、等锁、查找、计费、写日志与 fsync 各占多少。追踪打开后，
+ * 服务层与持久化路径在这些阶段的首尾各读一次单调时钟，把区间记录到
+ * 当前线程独占的环形缓冲区：每个线程第一次记录时领取一个环，之后只有
+ * 该线程写入、只有导出方读取，记录不加锁、不争用共享计数器。
+ * 环写满后新的区间被丢弃并计数，不会阻塞业务线程。
+ *
+ * parking_trace_flush 把各环中尚未导出的区间写成 Chrome 追踪事件格式
+ * （trace event format）的 JSON，可以直接在 chrome://tracing 或 Perfetto
+ * 中打开：每个区间是一个 "ph":"X" 完整事件，同一线程内的区间按时间
+ * 自然嵌套。线程结束后其环在下一次导出清空后回收。
+ *
+ * 追踪默认关闭，关闭时每个区间只多一次原子读取；编译期开关 PARKING_TRACE
+ * 为 0 时区间宏不生成任何代码。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#ifndef PARKING_TRACE
+#define PARKING_TRACE 1 /**< 为 0 时服务层与持久化路径不记录区间 */
+#endif
+
+#define TRACE_MAX_THREADS 64         /**< 可同时领取环的线程数上限 */
+#define TRACE_DEFAULT_EVENTS 16384   /**< 默认每个线程环的区间数 */
+#define TRACE_MAX_EVENTS 1048576     /**< 每个线程环的区间数上限 */
+
+#define TRACE_CATEGORY_SERVICE "service" /**< 服务层公共入口 */
+#define TRACE_CATEGORY_PHASE "phase"     /**< 服务操作内部的阶段 */
+#define TRACE_CATEGORY_IO "io"           /**< 持久化与落盘 */
+
+#if PARKING_TRACE
+/** 开始一个区间；span 为 TraceSpan 变量。 */
+#define PARKING_TRACE_BEGIN(span, category, name)                              \
+  parking_trace_begin(&(span), (category), (name))
+/** 结束 PARKING_TRACE_BEGIN 开始的区间。 */
+#define PARKING_TRACE_END(span) parking_trace_end(&(span))
+#else
+#define PARKING_TRACE_BEGIN(span, category, name) ((void)&(span))
+#define PARKING_TRACE_END(span) ((void)&(span))
+#endif
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一个进行中的区间，通常是调用者栈上的局部变量。
+ * @details 名称与类别须为不含引号和反斜杠的静态字符串，导出时原样写出。
+ */
+typedef struct TraceSpan {
+  const char *category; /**< 区间类别。 */
+  const char *name;     /**< 区间名称，NULL 表示开始时追踪处于关闭状态。 */
+  double start_us;      /**< 开始时刻（单调时钟，微秒）。 */
+} TraceSpan;
+
+/**
+ * @brief 追踪的累计统计。
+ */
+typedef struct TraceStats {
+  long recorded; /**< 已写入环的区间数（含已导出的）。 */
+  long dropped;  /**< 因环已满或领不到环而丢弃的区间数。 */
+  int threads;   /**< 当前持有环的线程数（含已结束、尚未回收的）。 */
+} TraceStats;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 打开追踪。
+ * @details 之后第一次记录区间的线程各领取一个 events_per_thread 个区间的环；
+ *          已领取的环保持原来的容量。
+ * @param events_per_thread 每个线程环的区间数，0 表示 TRACE_DEFAULT_EVENTS；
+ *        向上取整为 2 的幂。
+ * @return 成功返回 0；参数无效（负数或超过 TRACE_MAX_EVENTS）返回 -1；
+ *         无法创建线程私有数据键返回 -2。
+ */
+int parking_trace_enable(int events_per_thread);
+
+/**
+ * @brief 关闭追踪，已记录的区间仍可导出。
+ */
+void parking_trace_disable(void);
+
+/**
+ * @brief 查询追踪是否打开。
+ * @return 打开返回 1，否则返回 0。
+ */
+int parking_trace_is_enabled(void);
+
+/**
+ * @brief 开始一个区间。
+ * @param span 接收区间的开始时刻。
+ * @param category 区间类别。
+ * @param name 区间名称。
+ */
+void parking_trace_begin(TraceSpan *span, const char *category,
+                         const char *name);
+
+/**
+ * @brief 结束一个区间并记录到当前线程的环。
+ * @details 开始时追踪处于关闭状态的区间不记录。
+ * @param span parking_trace_begin 开始的区间。
+ */
+void parking_trace_end(const TraceSpan *span);
+
+/**
+ * @brief 记录一个刚刚结束、已知耗时的区间。
+ * @details 供已经自行计时的调用者（例如服务指标）使用，不必再读一次开始时刻。
+ * @param category 区间类别。
+ * @param name 区间名称。
+ * @param elapsed_ns 区间耗时（纳秒），区间的结束时刻取调用时刻。
+ */
+void parking_trace_complete(const char *category, const char *name,
+                            unsigned long elapsed_ns);
+
+/**
+ * @brief 把各线程环中尚未导出的区间以 Chrome 追踪事件格式写到流。
+ * @details 输出是一个完整的 JSON 对象；导出过的区间从环中移除，
+ *          多次导出得到的是彼此衔接的几份追踪。可以与记录并发调用，
+ *          多个导出方之间互相串行。
+ * @param out 已打开的输出流。
+ * @return 导出的区间数；参数无效或写入失败返回 -1。
+ */
+long parking_trace_flush(FILE *out);
+
+/**
+ * @brief 读取追踪的累计统计。
+ * @param[out] stats 接收统计。
+ */
+void parking_trace_stats(TraceStats *stats);
+
+#endif /* PARKING_TRACE_H */
@@ -1,14 +1,26 @@
+/* 实时看板等待输入用的 select 属于 POSIX 接口，需要在包含系统头文件前开启。 */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <locale.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "parking_thread.h"
 #include "parking_ui.h"
 
 #ifdef _WIN32
-#include <locale.h>
+#include <conio.h>
 #include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004 /* 旧版 SDK 未定义 */
+#endif
 #else
+#include <sys/select.h>
+#include <sys/time.h>
 #include <unistd.h>
 #endif
 
@@ -29,6 +41,16 @@
 #define GBK_CODE_PAGE 936            /**< Windows GBK 代码页 */
 #define DEFAULT_PARKING_CAPACITY 100 /**< 默认停车场容量 */
 #define SECONDS_PER_HOUR 3600.0      /**< 每小时的秒数 */
+#define UI_LIST_PAGE_SIZE 20         /**< 车位列表每页显示的车位数 */
+#define UI_LIST_BULK_PAGE 256        /**< 一次显示全部时每次读取的车位数 */
+#define UI_LIST_FLUSH_BYTES 65536    /**< 一次显示全部时缓冲区的写出阈值 */
+#define UI_BUFFER_INITIAL 4096       /**< 文本缓冲区的初始容量 */
+#define UI_DASHBOARD_BATCH 64        /**< 看板每次取出的变化事件数 */
+#define UI_SEPARATOR "----------------------------------------------------\n"
+
+/** 单个车位格式化后的最大字节数（固定文字与各字段上限之和，留有余量）。 */
+#define UI_SLOT_TEXT_MAX                                                       \
+  (256 + MAX_LOCATION_LEN + MAX_NAME_LEN + MAX_LICENSE_LEN + MAX_CONTACT_LEN)
 
 /**
  * @brief 全局停车场管理对象
@@ -37,6 +59,31 @@
  */
 static ParkingLot *ui_parking_lot = NULL;
 
+/**
+ * @brief 持有 `ui_parking_lot` 的发布点
+ * @details 重新加载数据时在影子停车场上完成加载再替换，
+ *          旧停车场交给发布点回收；菜单线程是唯一的发布者。
+ */
+static LotHub *ui_lot_hub = NULL;
+
+/**
+ * @brief 最近一次后台保存的结果
+ * @details 0 表示没有待报告的结果，1 表示成功，-1 表示失败。
+ *          由后台保存线程写入、菜单线程读取，因此以原子操作访问。
+ */
+static volatile int ui_save_outcome = 0;
+
+/**
+ * @brief 控制台是否支持 ANSI 转义序列。
+ * @details 类 Unix 终端默认支持；Windows 在 ui_setup_console_encoding
+ *          成功开启虚拟终端处理后置为 1，否则清屏退回 system("cls")。
+ */
+#ifdef _WIN32
+static int ui_ansi_console = 0;
+#else
+static int ui_ansi_console = 1;
+#endif
+
 /* ========================================================================== */
 /*                        系统初始化和主程序入口                              */
 /* ========================================================================== */
@@ -87,7 +134,12 @@ void ui_run_parking_system(void) {
 void ui_initialize_parking_system(int total_slots) {
   if (ui_parking_lot == NULL) {
     ui_parking_lot = init_parking_lot(total_slots);
-    if (ui_parking_lot == NULL) {
+    if (ui_parking_lot != NULL) {
+      ui_lot_hub = lot_hub_create(ui_parking_lot);
+    }
+    if (ui_lot_hub == NULL) {
+      free_parking_lot(ui_parking_lot);
+      ui_parking_lot = NULL;
       ui_show_error("系统初始化失败，无法分配内存！");
       exit(EXIT_FAILURE);
     }
@@ -100,15 +152,16 @@ void ui_initialize_parking_system(int total_slots) {
  * @brief 清理资源并准备退出系统。
  * @details
  * 在程序退出前，此函数负责将当前停车场数据自动备份到
- * "parking_data_backup.txt" 文件中，然后调用 `free_parking_lot`
- * 释放所有相关的动态分配内存，防止内存泄漏。
+ * "parking_data_backup.txt" 文件中，然后释放发布点及其持有的停车场，
+ * 防止内存泄漏。
  */
 void ui_cleanup_and_exit(void) {
   printf("\n正在保存数据并退出系统...\n");
 
   if (ui_parking_lot) {
     parking_service_save_data(ui_parking_lot, "parking_data_backup.txt");
-    free_parking_lot(ui_parking_lot);
+    lot_hub_free(ui_lot_hub);
+    ui_lot_hub = NULL;
     ui_parking_lot = NULL;
   }
 
@@ -121,8 +174,15 @@ void ui_cleanup_and_exit(void) {
 
 /**
  * @brief (跨平台) 清除控制台屏幕。
+ * @details 控制台支持 ANSI 转义序列时直接写出光标归位与清屏序列，
+ *          不再为每次清屏启动一个 shell 子进程。
  */
 void ui_clear_screen(void) {
+  if (ui_ansi_console) {
+    fputs("\033[H\033[2J", stdout);
+    fflush(stdout);
+    return;
+  }
 #ifdef _WIN32
   system("cls");
 #else
@@ -136,6 +196,13 @@ void ui_clear_screen(void) {
  */
 void ui_setup_console_encoding(void) {
 #ifdef _WIN32
+  HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+  DWORD mode;
+
+  if (output != INVALID_HANDLE_VALUE && GetConsoleMode(output, &mode) &&
+      SetConsoleMode(output, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING)) {
+    ui_ansi_console = 1;
+  }
   SetConsoleOutputCP(CP_UTF8);
   SetConsoleCP(CP_UTF8);
   setlocale(LC_ALL, "zh_CN.UTF-8");
@@ -371,12 +438,13 @@ void ui_allocate_slot_menu(void) {
  * @brief 显示并处理“车辆出场”（释放车位）的交互流程。
  * @details
  * 引导用户输入要出场的车位编号，然后调用服务层函数
- * `parking_service_deallocate_slot` 来执行出场操作。
- * 如果操作成功且产生费用，将显示费用金额。
+ * `parking_service_checkout_slot` 来执行出场操作。
+ * 如果操作成功，将显示计费明细与费用金额。
  */
 void ui_deallocate_slot_menu(void) {
   int slot_id;
   ServiceResult result;
+  ExitReceipt receipt;
 
   printf("\n========== 车辆出场 ==========\n");
   printf("请输入要出场的车位编号: ");
@@ -385,17 +453,21 @@ void ui_deallocate_slot_menu(void) {
     return;
   }
 
-  result = parking_service_deallocate_slot(ui_parking_lot, slot_id);
+  result = parking_service_checkout_slot(ui_parking_lot, slot_id, &receipt);
   if (parking_service_is_success(result)) {
-    double fee = result.data ? *((double *)result.data) : 0.0;
     printf("✓ %s\n", result.message);
-    if (fee > 0) {
-      printf("  本次停车费用为: %.2f 元\n", fee);
+    if (receipt.type == VISITOR_TYPE) {
+      printf("  停车时长: %ld 分钟，计费 %d 小时\n",
+             receipt.duration_seconds / 60, receipt.billed_hours);
+    } else if (receipt.overdue_months > 0) {
+      printf("  补缴月费: %d 个月\n", receipt.overdue_months);
+    }
+    if (receipt.amount > 0) {
+      printf("  本次停车费用为: %.2f 元\n", receipt.amount);
     }
   } else {
     parking_service_print_error(result);
   }
-  parking_service_free_result(&result);
 }
 
 /**
@@ -429,14 +501,22 @@ void ui_query_slot_menu(void) {
  * @brief 显示并处理“显示车位列表”的交互流程。
  * @details
  * 允许用户选择查看所有、空闲或已占用的车位列表。
- * 根据用户的选择，调用相应的服务层函数获取车位列表，
- * 然后遍历并显示每个车位的状态。
+ * 通过服务层的续读接口每次只取一页（UI_LIST_PAGE_SIZE 个车位）显示，
+ * 用户按回车继续下一页，输入 a 一次显示剩余全部，输入 q 提前返回，
+ * 不必一次取出全部车位。每页先排进文本缓冲区再一次写出；显示全部时
+ * 缓冲区累积到 UI_LIST_FLUSH_BYTES 才写出一次。
  */
 void ui_list_slots_menu(void) {
   int choice;
-  int count;
+  int count = 0;
+  int token = 0;
+  int show_all = 0;
+  int i;
+  char answer[8];
+  SlotFilter filter;
   ServiceResult result;
-  SlotQueryResult *query_result;
+  SlotQueryResult *page;
+  UiTextBuffer buffer;
 
   printf("\n========== 车位列表 ==========\n");
   printf("1. 显示所有车位\n2. 显示空闲车位\n3. 显示已占用车位\n请选择 (1-3): ");
@@ -447,33 +527,63 @@ void ui_list_slots_menu(void) {
 
   switch (choice) {
   case 1:
-    result = parking_service_get_all_slots(ui_parking_lot);
+    filter = SLOT_FILTER_ALL;
     break;
   case 2:
-    result = parking_service_get_free_slots(ui_parking_lot);
+    filter = SLOT_FILTER_FREE;
     break;
   case 3:
-    result = parking_service_get_occupied_slots(ui_parking_lot);
+    filter = SLOT_FILTER_OCCUPIED;
     break;
   default:
     ui_show_error("无效选择！");
     return;
   }
 
-  if (parking_service_is_success(result)) {
-    query_result = (SlotQueryResult *)result.data;
-    count = query_result ? query_result->total_found : 0;
-    printf("\n查询到 %d 个车位:\n", count);
-    ui_show_separator();
-    int i = 0;
-    for (i = 0; i < count; i++) {
-      ui_show_slot_status(query_result->slot_list[i]);
-      ui_show_separator();
+  printf("\n");
+  ui_show_separator();
+  ui_buffer_init(&buffer);
+  while (token != -1) {
+    result = parking_service_get_slots_after(
+        ui_parking_lot, filter, &token,
+        show_all ? UI_LIST_BULK_PAGE : UI_LIST_PAGE_SIZE);
+    if (!parking_service_is_success(result)) {
+      ui_buffer_flush(&buffer, stdout);
+      ui_buffer_free(&buffer);
+      parking_service_print_error(result);
+      return;
+    }
+    page = (SlotQueryResult *)result.data;
+    for (i = 0; i < page->total_found; i++) {
+      if (ui_buffer_append_slot(&buffer, page->slot_list[i]) != 0 ||
+          ui_buffer_append(&buffer, UI_SEPARATOR) != 0) {
+        /* 内存不足时先写出已排好的部分，再逐行输出。 */
+        ui_buffer_flush(&buffer, stdout);
+        ui_show_slot_status(page->slot_list[i]);
+        ui_show_separator();
+      }
+    }
+    count += page->total_found;
+    parking_service_free_result(&result);
+
+    if (!show_all || buffer.length >= UI_LIST_FLUSH_BYTES) {
+      ui_buffer_flush(&buffer, stdout);
+    }
+    if (token != -1 && !show_all) {
+      printf("已显示 %d 个车位，按回车显示下一页，输入 a 显示全部，"
+             "输入 q 返回: ",
+             count);
+      if (ui_safe_read_string(answer, sizeof(answer)) != 0 ||
+          answer[0] == 'q' || answer[0] == 'Q') {
+        ui_buffer_free(&buffer);
+        return;
+      }
+      show_all = answer[0] == 'a' || answer[0] == 'A';
     }
-  } else {
-    parking_service_print_error(result);
   }
-  parking_service_free_result(&result);
+  ui_buffer_flush(&buffer, stdout);
+  ui_buffer_free(&buffer);
+  printf("查询到 %d 个车位\n", count);
 }
 
 /* ========================================================================== */
@@ -485,11 +595,13 @@ void ui_list_slots_menu(void) {
  * @details
  * 调用服务层函数 `parking_service_get_statistics` 获取停车场的统计数据，
  * 包括总车位数、占用数、空闲数、使用率以及今日和本月收入，
- * 然后将这些信息格式化并显示给用户。
+ * 然后将这些信息格式化并显示给用户。显示后可输入 d 进入实时看板，
+ * 不必反复回车刷新。
  */
 void ui_statistics_menu(void) {
   ServiceResult result;
   ParkingStatistics *stats;
+  char answer[8];
 
   printf("\n========== 统计信息 ==========\n");
   result = parking_service_get_statistics(ui_parking_lot);
@@ -505,34 +617,305 @@ void ui_statistics_menu(void) {
     printf("==========================\n");
   } else {
     parking_service_print_error(result);
+    parking_service_free_result(&result);
+    return;
+  }
+  parking_service_free_result(&result);
+
+  printf("输入 d 进入实时看板，直接回车返回: ");
+  if (ui_safe_read_string(answer, sizeof(answer)) == 0 &&
+      (answer[0] == 'd' || answer[0] == 'D')) {
+    ui_dashboard_menu();
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 等待标准输入可读，最多等待指定的毫秒数。
+ * @details 类 Unix 下以 select 阻塞等待，Windows 下休眠后检查键盘缓冲区；
+ *          等待期间不占用 CPU，同时充当看板的帧间隔。
+ * @param milliseconds 最长等待时间。
+ * @return 标准输入可读（或已到文件结尾）返回 1，超时返回 0。
+ */
+static int ui_wait_for_input(int milliseconds) {
+#ifdef _WIN32
+  Sleep((DWORD)milliseconds);
+  return _kbhit() ? 1 : 0;
+#else
+  fd_set readable;
+  struct timeval timeout;
+
+  FD_ZERO(&readable);
+  FD_SET(STDIN_FILENO, &readable);
+  timeout.tv_sec = milliseconds / 1000;
+  timeout.tv_usec = (milliseconds % 1000) * 1000L;
+  return select(STDIN_FILENO + 1, &readable, NULL, NULL, &timeout) > 0;
+#endif
+}
+
+/**
+ * @brief (静态辅助函数) 排版看板的某一行。
+ * @param board 目标看板。
+ * @param row 行号，从 0 开始。
+ * @param[out] line 接收该行文本，至少 UI_DASHBOARD_LINE 字节。
+ */
+static void ui_dashboard_row(const UiDashboard *board, int row, char *line) {
+  int zone_rows = UI_DASHBOARD_ZONES;
+  int index;
+
+  line[0] = '\0';
+  if (row == 0) {
+    strcpy(line, "================ 实时看板 ================");
+  } else if (row == 1) {
+    sprintf(line, "总车位: %d  已占用: %d  空闲: %d  使用率: %.1f%%",
+            board->stats.total_slots, board->stats.occupied_slots,
+            board->stats.free_slots, board->stats.occupancy_rate);
+  } else if (row == 2) {
+    sprintf(line, "今日收入: %.2f元  本月收入: %.2f元",
+            board->stats.today_revenue, board->stats.month_revenue);
+  } else if (row == 3) {
+    strcpy(line, "---------------- 分区空位 ----------------");
+  } else if (row < 4 + zone_rows) {
+    index = row - 4;
+    if (board->zone_count > UI_DASHBOARD_ZONES &&
+        index == UI_DASHBOARD_ZONES - 1) {
+      sprintf(line, "  （另有 %d 个分区未显示）",
+              board->zone_count - (UI_DASHBOARD_ZONES - 1));
+    } else if (index < board->zone_count) {
+      sprintf(line, "  %-20.*s 总数 %-5d 占用 %-5d 空闲 %d",
+              MAX_LOCATION_LEN, board->zones[index].zone,
+              board->zones[index].total_slots,
+              board->zones[index].occupied_slots,
+              board->zones[index].free_slots);
+    } else if (index == 0) {
+      strcpy(line, "  （未登记分区）");
+    }
+  } else if (row == 4 + zone_rows) {
+    strcpy(line, "---------------- 最近入场 ----------------");
+  } else if (row < UI_DASHBOARD_ROWS - 1) {
+    index = row - 5 - zone_rows;
+    if (index < board->recent_count) {
+      char time_buffer[16];
+
+      strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S",
+               localtime(&board->recent[index].when));
+      sprintf(line, "  %s  车位 %-5d  %s", time_buffer,
+              board->recent[index].slot_id,
+              board->recent[index].type == RESIDENT_TYPE ? "居民" : "访客");
+    }
+  } else {
+    sprintf(line, "每 %d 毫秒刷新，按回车返回", UI_DASHBOARD_FRAME_MS);
+  }
+}
+
+/**
+ * @brief 初始化一个空的看板。
+ * @param board 目标看板。
+ */
+void ui_dashboard_init(UiDashboard *board) {
+  memset(board, 0, sizeof(*board));
+}
+
+/**
+ * @brief 重新读取停车场统计信息与分区计数。
+ * @details 统计信息与分区计数都由计数器增量维护，读取代价与车位数无关。
+ * @param board 目标看板。
+ * @param lot 目标停车场。
+ * @return 成功返回 0，读取失败返回 -1。
+ */
+int ui_dashboard_reload(UiDashboard *board, ParkingLot *lot) {
+  ServiceResult result;
+  int zone_count = 0;
+
+  result = parking_service_get_statistics(lot);
+  if (!parking_service_is_success(result)) {
+    parking_service_free_result(&result);
+    return -1;
   }
+  board->stats = *(ParkingStatistics *)result.data;
   parking_service_free_result(&result);
+
+  result = parking_service_list_zone_stats(lot, board->zones,
+                                           UI_DASHBOARD_ZONES, &zone_count);
+  if (!parking_service_is_success(result)) {
+    return -1;
+  }
+  board->zone_count = zone_count;
+  return 0;
+}
+
+/**
+ * @brief 把一批车位变化事件记入看板的最近入场记录。
+ * @param board 目标看板。
+ * @param changes 事件数组，按发生顺序排列。
+ * @param count 事件数。
+ */
+void ui_dashboard_apply(UiDashboard *board, const ParkingChange *changes,
+                        int count) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (changes[i].kind != PARKING_CHANGE_ALLOCATE) {
+      continue;
+    }
+    if (board->recent_count < UI_DASHBOARD_RECENT) {
+      board->recent_count++;
+    }
+    memmove(&board->recent[1], &board->recent[0],
+            (size_t)(board->recent_count - 1) * sizeof(ParkingChange));
+    board->recent[0] = changes[i];
+  }
+}
+
+/**
+ * @brief 把看板排版进文本缓冲区。
+ * @param board 目标看板。
+ * @param out 目标缓冲区。
+ * @param full 非 0 时按顺序输出全部行，为 0 时只输出变化的行。
+ * @return 输出的行数；内存不足返回 -1。
+ */
+int ui_dashboard_render(UiDashboard *board, UiTextBuffer *out, int full) {
+  char line[UI_DASHBOARD_LINE];
+  char cursor[32];
+  int drawn = 0;
+  int row;
+
+  for (row = 0; row < UI_DASHBOARD_ROWS; row++) {
+    ui_dashboard_row(board, row, line);
+    if (!full && strcmp(line, board->shown[row]) == 0) {
+      continue;
+    }
+    if (full) {
+      if (ui_buffer_append(out, line) != 0 ||
+          ui_buffer_append(out, "\n") != 0) {
+        return -1;
+      }
+    } else {
+      sprintf(cursor, "\033[%d;1H", row + 1);
+      if (ui_buffer_append(out, cursor) != 0 ||
+          ui_buffer_append(out, line) != 0 ||
+          ui_buffer_append(out, "\033[K") != 0) {
+        return -1;
+      }
+    }
+    strcpy(board->shown[row], line);
+    drawn++;
+  }
+  if (!full && drawn > 0) {
+    sprintf(cursor, "\033[%d;1H", UI_DASHBOARD_ROWS + 1);
+    if (ui_buffer_append(out, cursor) != 0) {
+      return -1;
+    }
+  }
+  return drawn;
+}
+
+/**
+ * @brief 进入实时看板，随车位变化刷新统计信息，按回车返回。
+ * @details
+ * 订阅车位变化事件后，每帧最多等待 UI_DASHBOARD_FRAME_MS 毫秒的输入；
+ * 一帧内收到的事件合并为一次重绘，没有事件的帧什么也不读、不写。
+ * 支持 ANSI 转义序列的控制台只重写变化的行，否则清屏后整屏重绘。
+ * 事件队列溢出只会丢失最近入场记录，统计与分区计数每次都重新读取。
+ */
+void ui_dashboard_menu(void) {
+  struct ChangeSubscription *subscription = NULL;
+  ParkingChange changes[UI_DASHBOARD_BATCH];
+  UiDashboard board;
+  UiTextBuffer buffer;
+  ServiceResult result;
+  int count;
+  int dropped;
+  int changed;
+
+  result = parking_service_subscribe_changes(ui_parking_lot, 0, &subscription);
+  if (!parking_service_is_success(result)) {
+    parking_service_print_error(result);
+    return;
+  }
+
+  ui_dashboard_init(&board);
+  ui_buffer_init(&buffer);
+  ui_dashboard_reload(&board, ui_parking_lot);
+  ui_clear_screen();
+  ui_dashboard_render(&board, &buffer, 1);
+  ui_buffer_flush(&buffer, stdout);
+
+  while (!ui_wait_for_input(UI_DASHBOARD_FRAME_MS)) {
+    changed = 0;
+    do {
+      count = 0;
+      dropped = 0;
+      parking_service_poll_changes(subscription, changes, UI_DASHBOARD_BATCH,
+                                   &count, &dropped);
+      ui_dashboard_apply(&board, changes, count);
+      changed = changed || count > 0 || dropped > 0;
+    } while (count == UI_DASHBOARD_BATCH);
+
+    if (!changed || ui_dashboard_reload(&board, ui_parking_lot) != 0) {
+      continue;
+    }
+    if (ui_ansi_console) {
+      ui_dashboard_render(&board, &buffer, 0);
+    } else {
+      ui_clear_screen();
+      ui_dashboard_render(&board, &buffer, 1);
+    }
+    ui_buffer_flush(&buffer, stdout);
+  }
+
+  ui_clear_input_buffer();
+  ui_buffer_free(&buffer);
+  parking_service_unsubscribe_changes(ui_parking_lot, subscription);
 }
 
 /* ========================================================================== */
 /*                            数据管理菜单函数                                */
 /* ========================================================================== */
 
+/**
+ * @brief (静态辅助函数) 后台保存完成后记录结果，留待下次进入保存菜单时报告。
+ * @details 在后台保存线程中调用，不直接输出，避免打断正在进行的输入。
+ * @param filename 保存的文件名（未使用）。
+ * @param result 保存结果。
+ * @param ctx 上下文指针（未使用）。
+ */
+static void ui_on_save_done(const char *filename, ServiceResult result,
+                            void *ctx) {
+  (void)filename;
+  (void)ctx;
+  parking_atomic_store_int(&ui_save_outcome,
+                           parking_service_is_success(result) ? 1 : -1);
+}
+
 /**
  * @brief 显示并处理“保存数据到文件”的交互流程。
  * @details
- * 引导用户输入要保存数据的文件名（提供默认值），然后调用服务层函数
- * `parking_service_save_data` 将当前停车场的所有数据持久化到文本文件。
+ * 先报告上一次后台保存的结果，再引导用户输入要保存数据的文件名
+ * （提供默认值），然后调用服务层函数 `parking_service_save_data_async`
+ * 在后台把当前停车场的所有数据持久化到文本文件，菜单立即返回。
  */
 void ui_save_data_menu(void) {
   char filename[FILENAME_MAX_LEN];
   ServiceResult result;
+  int outcome;
 
   printf("\n========== 保存数据 ==========\n");
+  outcome = parking_atomic_exchange_int(&ui_save_outcome, 0);
+  if (outcome > 0) {
+    printf("上一次后台保存已完成。\n");
+  } else if (outcome < 0) {
+    ui_show_error("上一次后台保存失败！");
+  }
   printf("请输入文件名 (默认: parking_data.txt): ");
   ui_safe_read_string(filename, sizeof(filename));
   if (strlen(filename) == 0) {
     strcpy(filename, "parking_data.txt");
   }
 
-  result = parking_service_save_data(ui_parking_lot, filename);
+  result = parking_service_save_data_async(ui_parking_lot, filename,
+                                           ui_on_save_done, NULL);
   if (parking_service_is_success(result)) {
-    printf("数据保存成功！文件：%s\n", filename);
+    printf("已提交后台保存，文件：%s\n", filename);
   } else {
     parking_service_print_error(result);
   }
@@ -543,9 +926,9 @@ void ui_save_data_menu(void) {
  * @brief 显示并处理“从文件加载数据”的交互流程。
  * @details
  * 引导用户输入要加载数据的文件名（提供默认值）。
- * 调用服务层函数 `parking_service_load_data` 从文件加载数据。
- * 加载成功后，会释放旧的停车场内存，并用新加载的数据替换全局的
- * `ui_parking_lot` 对象。
+ * 调用服务层函数 `parking_service_reload_data` 在影子停车场上加载数据，
+ * 加载成功后才替换全局的 `ui_parking_lot` 对象，旧停车场由发布点回收；
+ * 加载失败时继续使用当前数据。
  */
 void ui_load_data_menu(void) {
   char filename[FILENAME_MAX_LEN];
@@ -558,16 +941,11 @@ void ui_load_data_menu(void) {
     strcpy(filename, "parking_data.txt");
   }
 
-  result = parking_service_load_data(filename);
+  result = parking_service_reload_data(ui_lot_hub, filename);
   if (parking_service_is_success(result)) {
-    if (ui_parking_lot) {
-      free_parking_lot(ui_parking_lot);
-    }
-    ui_parking_lot = (ParkingLot *)result.data;
+    ui_parking_lot = lot_hub_current(ui_lot_hub);
     printf("数据加载成功！总车位数: %d, 已占用: %d\n",
            ui_parking_lot->total_slots, ui_parking_lot->occupied_slots);
-    /* 防止重复释放 result.data */
-    result.data = NULL;
   } else {
     parking_service_print_error(result);
   }
@@ -621,6 +999,36 @@ void ui_show_system_title(void) {
   printf("====================================================\n\n");
 }
 
+/**
+ * @brief (静态辅助函数) 把单个车位按标准格式排版到字符数组中。
+ * @details 各字段以精度限定长度，输出不超过 UI_SLOT_TEXT_MAX 字节。
+ * @param text 目标数组，至少 UI_SLOT_TEXT_MAX 字节。
+ * @param slot 要排版的车位。
+ * @return 写入的字节数（不含结尾的 '\0'）。
+ */
+static size_t ui_format_slot(char *text, const ParkingSlot *slot) {
+  size_t length;
+
+  length = (size_t)sprintf(
+      text, "车位编号: %-5d | 位置: %-20.*s | 状态: %s\n", slot->slot_id,
+      MAX_LOCATION_LEN, slot->location,
+      slot->status == OCCUPIED_STATUS ? "已占用" : "空闲");
+
+  if (slot->status == OCCUPIED_STATUS) {
+    char time_buffer[30];
+    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S",
+             localtime(&slot->entry_time));
+    length += (size_t)sprintf(
+        text + length, "  -> 车主: %.*s, 车牌: %.*s, 联系方式: %.*s\n",
+        MAX_NAME_LEN, slot->owner_name, MAX_LICENSE_LEN, slot->license_plate,
+        MAX_CONTACT_LEN, slot->contact);
+    length += (size_t)sprintf(text + length, "  -> 类型: %s, 入场时间: %s\n",
+                              slot->type == RESIDENT_TYPE ? "居民" : "访客",
+                              time_buffer);
+  }
+  return length;
+}
+
 /**
  * @brief 以标准格式显示单个停车位的详细信息。
  * @details
@@ -628,22 +1036,14 @@ void ui_show_system_title(void) {
  * @param slot 指向要显示的 ParkingSlot 对象的指针。
  */
 void ui_show_slot_status(const ParkingSlot *slot) {
+  char text[UI_SLOT_TEXT_MAX];
+
   if (slot == NULL) {
     ui_show_error("车位信息为空");
     return;
   }
-  printf("车位编号: %-5d | 位置: %-20s | 状态: %s\n", slot->slot_id,
-         slot->location, slot->status == OCCUPIED_STATUS ? "已占用" : "空闲");
-
-  if (slot->status == OCCUPIED_STATUS) {
-    char time_buffer[30];
-    strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S",
-             localtime(&slot->entry_time));
-    printf("  -> 车主: %s, 车牌: %s, 联系方式: %s\n", slot->owner_name,
-           slot->license_plate, slot->contact);
-    printf("  -> 类型: %s, 入场时间: %s\n",
-           slot->type == RESIDENT_TYPE ? "居民" : "访客", time_buffer);
-  }
+  ui_format_slot(text, slot);
+  fputs(text, stdout);
 }
 
 /**
@@ -669,8 +1069,100 @@ void ui_show_success(const char *message) {
 /**
  * @brief 打印一条分隔线，用于美化界面布局。
  */
-void ui_show_separator(void) {
-  printf("----------------------------------------------------\n");
+void ui_show_separator(void) { fputs(UI_SEPARATOR, stdout); }
+
+/* ========================================================================== */
+/*                               输出缓冲函数                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 保证缓冲区还能再写入指定字节数。
+ * @param buffer 目标缓冲区。
+ * @param extra 需要追加的字节数。
+ * @return 成功返回 0，内存不足返回 -1（缓冲区内容不变）。
+ */
+static int ui_buffer_reserve(UiTextBuffer *buffer, size_t extra) {
+  size_t capacity;
+  char *data;
+
+  if (buffer->length + extra <= buffer->capacity) {
+    return 0;
+  }
+  capacity = buffer->capacity > 0 ? buffer->capacity : UI_BUFFER_INITIAL;
+  while (capacity < buffer->length + extra) {
+    capacity *= 2;
+  }
+  data = (char *)realloc(buffer->data, capacity);
+  if (data == NULL) {
+    return -1;
+  }
+  buffer->data = data;
+  buffer->capacity = capacity;
+  return 0;
+}
+
+/**
+ * @brief 初始化一个空的文本缓冲区。
+ * @param buffer 目标缓冲区。
+ */
+void ui_buffer_init(UiTextBuffer *buffer) {
+  buffer->data = NULL;
+  buffer->length = 0;
+  buffer->capacity = 0;
+}
+
+/**
+ * @brief 释放文本缓冲区的内存。
+ * @param buffer 目标缓冲区。
+ */
+void ui_buffer_free(UiTextBuffer *buffer) {
+  free(buffer->data);
+  ui_buffer_init(buffer);
+}
+
+/**
+ * @brief 向缓冲区追加一段文本。
+ * @param buffer 目标缓冲区。
+ * @param text 要追加的文本。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+int ui_buffer_append(UiTextBuffer *buffer, const char *text) {
+  size_t length = strlen(text);
+
+  if (ui_buffer_reserve(buffer, length) != 0) {
+    return -1;
+  }
+  memcpy(buffer->data + buffer->length, text, length);
+  buffer->length += length;
+  return 0;
+}
+
+/**
+ * @brief 以 ui_show_slot_status 的格式向缓冲区追加一个车位。
+ * @details 直接排版到缓冲区末尾，预留 UI_SLOT_TEXT_MAX 字节（含 '\0'）。
+ * @param buffer 目标缓冲区。
+ * @param slot 要追加的车位。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+int ui_buffer_append_slot(UiTextBuffer *buffer, const ParkingSlot *slot) {
+  if (ui_buffer_reserve(buffer, UI_SLOT_TEXT_MAX) != 0) {
+    return -1;
+  }
+  buffer->length += ui_format_slot(buffer->data + buffer->length, slot);
+  return 0;
+}
+
+/**
+ * @brief 把缓冲区内容一次写到输出流并清空缓冲区。
+ * @param buffer 目标缓冲区。
+ * @param stream 输出流。
+ */
+void ui_buffer_flush(UiTextBuffer *buffer, FILE *stream) {
+  if (buffer->length > 0) {
+    fwrite(buffer->data, 1, buffer->length, stream);
+    fflush(stream);
+    buffer->length = 0;
+  }
 }
 
 /* ========================================================================== */
@@ -2,6 +2,7 @@
 #define PARKING_UI_H
 
 #include <stddef.h>
+#include <stdio.h>
 
 #include "parking_data.h"
 #include "parking_service.h"
@@ -23,7 +24,7 @@
  */
 
 /** @name 系统生命周期函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 运行停车管理系统的主程序。
@@ -44,7 +45,7 @@ void ui_initialize_parking_system(int total_slots);
  */
 void ui_cleanup_and_exit(void);
 
-///@}
+/** @} */
 
 /**
  *********************************************************************************
@@ -53,7 +54,7 @@ void ui_cleanup_and_exit(void);
  */
 
 /** @name 基础交互函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 设置控制台编码以支持中文字符的正确显示。
@@ -96,7 +97,7 @@ void ui_clear_screen(void);
  */
 void ui_wait_for_continue(void);
 
-///@}
+/** @} */
 
 /**
  *********************************************************************************
@@ -105,7 +106,7 @@ void ui_wait_for_continue(void);
  */
 
 /** @name 主菜单及分发函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 显示系统的主菜单选项。
@@ -118,10 +119,10 @@ void ui_show_main_menu(void);
  */
 void ui_handle_menu_choice(int choice);
 
-///@}
+/** @} */
 
 /** @name 业务功能菜单 */
-///@{
+/** @{ */
 
 /**
  * @brief 显示并处理“添加停车位”的交互流程。
@@ -153,10 +154,15 @@ void ui_list_slots_menu(void);
  */
 void ui_statistics_menu(void);
 
-///@}
+/**
+ * @brief 进入实时看板，随车位变化刷新统计信息，按回车返回。
+ */
+void ui_dashboard_menu(void);
+
+/** @} */
 
 /** @name 数据管理菜单 */
-///@{
+/** @{ */
 
 /**
  * @brief 显示并处理“保存数据到文件”的交互流程。
@@ -168,7 +174,7 @@ void ui_save_data_menu(void);
  */
 void ui_load_data_menu(void);
 
-///@}
+/** @} */
 
 /**
  *********************************************************************************
@@ -177,7 +183,7 @@ void ui_load_data_menu(void);
  */
 
 /** @name 信息显示函数 */
-///@{
+/** @{ */
 
 /**
  * @brief 显示系统的欢迎标题。
@@ -207,7 +213,121 @@ void ui_show_success(const char *message);
  */
 void ui_show_separator(void);
 
-///@}
+/** @} */
+
+/** @name 输出缓冲函数 */
+/** @{ */
+
+/**
+ * @brief 先在内存中排版、再一次写出的文本缓冲区。
+ * @details 大列表逐行 printf 时，每行都可能触发一次终端写入，经 SSH 时尤其慢；
+ *          先把整页排进缓冲区，再以一次 fwrite 输出。
+ */
+typedef struct UiTextBuffer {
+  char *data;      /**< 文本内容，不以 '\0' 结尾。 */
+  size_t length;   /**< 已写入的字节数。 */
+  size_t capacity; /**< data 已分配的字节数。 */
+} UiTextBuffer;
+
+/**
+ * @brief 初始化一个空的文本缓冲区。
+ * @param buffer 目标缓冲区。
+ */
+void ui_buffer_init(UiTextBuffer *buffer);
+
+/**
+ * @brief 释放文本缓冲区的内存。
+ * @param buffer 目标缓冲区。
+ */
+void ui_buffer_free(UiTextBuffer *buffer);
+
+/**
+ * @brief 向缓冲区追加一段文本。
+ * @param buffer 目标缓冲区。
+ * @param text 要追加的文本。
+ * @return 成功返回 0，内存不足返回 -1（缓冲区内容不变）。
+ */
+int ui_buffer_append(UiTextBuffer *buffer, const char *text);
+
+/**
+ * @brief 以 ui_show_slot_status 的格式向缓冲区追加一个车位。
+ * @param buffer 目标缓冲区。
+ * @param slot 要追加的车位。
+ * @return 成功返回 0，内存不足返回 -1。
+ */
+int ui_buffer_append_slot(UiTextBuffer *buffer, const ParkingSlot *slot);
+
+/**
+ * @brief 把缓冲区内容一次写到输出流并清空缓冲区（保留已分配的内存）。
+ * @param buffer 目标缓冲区。
+ * @param stream 输出流。
+ */
+void ui_buffer_flush(UiTextBuffer *buffer, FILE *stream);
+
+/** @} */
+
+/** @name 实时看板函数 */
+/** @{ */
+
+#define UI_DASHBOARD_ZONES 8       /**< 看板最多显示的分区行数 */
+#define UI_DASHBOARD_RECENT 5      /**< 看板显示的最近入场记录数 */
+#define UI_DASHBOARD_LINE 160      /**< 看板每行文本的最大字节数 */
+#define UI_DASHBOARD_FRAME_MS 250  /**< 看板两次重绘之间的最短间隔（毫秒） */
+
+/** 看板的总行数：标题、两行统计、分区标题与分区行、入场标题与入场行、提示。 */
+#define UI_DASHBOARD_ROWS (UI_DASHBOARD_ZONES + UI_DASHBOARD_RECENT + 6)
+
+/**
+ * @brief 实时看板的数据与上一次绘制的内容。
+ * @details 看板订阅车位变化事件，只在一帧内收到事件时重新读取统计与分区计数
+ *          （两者都由计数器维护，不遍历车位）；绘制时逐行与上一次的内容比较，
+ *          只重写变化的行。
+ */
+typedef struct UiDashboard {
+  ParkingStatistics stats;                    /**< 停车场统计信息。 */
+  ParkingZoneStats zones[UI_DASHBOARD_ZONES]; /**< 前若干个分区的计数。 */
+  int zone_count;                             /**< 已登记的分区总数。 */
+  ParkingChange recent[UI_DASHBOARD_RECENT];  /**< 最近的入场事件，新的在前。 */
+  int recent_count;                           /**< recent 中的事件数。 */
+  /** 上一次绘制的各行。 */
+  char shown[UI_DASHBOARD_ROWS][UI_DASHBOARD_LINE];
+} UiDashboard;
+
+/**
+ * @brief 初始化一个空的看板。
+ * @param board 目标看板。
+ */
+void ui_dashboard_init(UiDashboard *board);
+
+/**
+ * @brief 重新读取停车场统计信息与分区计数。
+ * @param board 目标看板。
+ * @param lot 目标停车场。
+ * @return 成功返回 0，读取失败返回 -1（看板保留原数据）。
+ */
+int ui_dashboard_reload(UiDashboard *board, ParkingLot *lot);
+
+/**
+ * @brief 把一批车位变化事件记入看板的最近入场记录。
+ * @param board 目标看板。
+ * @param changes 事件数组，按发生顺序排列。
+ * @param count 事件数。
+ */
+void ui_dashboard_apply(UiDashboard *board, const ParkingChange *changes,
+                        int count);
+
+/**
+ * @brief 把看板排版进文本缓冲区。
+ * @param board 目标看板。
+ * @param out 目标缓冲区。
+ * @param full 非 0 时从光标处按顺序输出全部行（用于清屏后的首次绘制，
+ *             或不支持 ANSI 转义序列的控制台）；为 0 时只输出与上一次绘制
+ *             不同的行，每行以光标定位序列开头，最后把光标移到提示行之后。
+ * @return 输出的行数；内存不足返回 -1。
+ */
+int ui_dashboard_render(UiDashboard *board, UiTextBuffer *out, int full);
+
+/** @} */
 
 /**
  *********************************************************************************
@@ -216,7 +336,7 @@ void ui_show_separator(void);
  */
 
 /** @name 演示及内部接口 */
-///@{
+/** @{ */
 
 /**
  * @brief 运行一个内置的演示程序，展示系统的核心功能。
@@ -231,6 +351,6 @@ void ui_run_demo_program(void);
  */
 ParkingLot *ui_get_parking_lot(void);
 
-///@}
+/** @} */
 
 #endif /* PARKING_UI_H */
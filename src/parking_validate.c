@@ -0,0 +1,147 @@
+/**
+ * @file parking_validate.c
+ * @brief 服务层输入字段校验实现文件
+ * @details
+ * 该文件实现了 parking_validate.h 中声明的字段校验函数。
+ * 所有文本字段都在一次扫描中同时得出长度与字符合法性，
+ * 不调用 strlen，也不会在超过存储上限之后继续读取。
+ */
+
+#include <stddef.h>
+
+#include "parking_data.h"
+#include "parking_validate.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 判断字节能否出现在会写入数据文件的文本字段中。
+ * @details 控制字符会破坏按行存储的文本格式，'|' 是字段分隔符。
+ * @param c 待检查的字节。
+ * @return 允许返回 1，否则返回 0。
+ */
+static int is_storable_byte(unsigned char c) {
+  return c >= 0x20 && c != 0x7F && c != '|';
+}
+
+/**
+ * @brief (静态辅助函数) 一次扫描校验可存储文本的长度与字符。
+ * @details 字符错误优先于长度错误报告，但一旦达到上限立即停止扫描。
+ * @param text 待校验的文本。
+ * @param min_len 最小长度（字节）。
+ * @param max_len 存储上限（含结尾 NUL），长度必须小于它。
+ * @param digits_only 为非 0 时只允许 ASCII 数字。
+ * @return 校验原因码。
+ */
+static ValidationReason scan_text(const char *text, size_t min_len,
+                                  size_t max_len, int digits_only) {
+  const unsigned char *p = (const unsigned char *)text;
+  size_t len = 0;
+
+  if (text == NULL) {
+    return VALIDATION_MISSING;
+  }
+  for (; p[len] != '\0'; len++) {
+    if (len + 1 >= max_len) {
+      return VALIDATION_TOO_LONG;
+    }
+    if (digits_only ? (p[len] < '0' || p[len] > '9')
+                    : !is_storable_byte(p[len])) {
+      return VALIDATION_BAD_CHARACTER;
+    }
+  }
+  return len < min_len ? VALIDATION_TOO_SHORT : VALIDATION_OK;
+}
+
+/**
+ * @brief (静态辅助函数) 记录校验结果。
+ * @param issue 目标结构，可以为 NULL。
+ * @param field 失败的字段。
+ * @param reason 失败原因。
+ * @return reason 为 VALIDATION_OK 时返回 1，否则返回 0。
+ */
+static int report_issue(ValidationIssue *issue, ValidationField field,
+                        ValidationReason reason) {
+  if (issue != NULL) {
+    issue->field = reason == VALIDATION_OK ? VALIDATION_FIELD_NONE : field;
+    issue->reason = reason;
+  }
+  return reason == VALIDATION_OK;
+}
+
+/* ========================================================================== */
+/*                                 公共函数实现                               */
+/* ========================================================================== */
+
+/**
+ * @brief 校验车位编号是否在 1..VALIDATE_MAX_SLOT_ID 之内。
+ * @param slot_id 车位编号。
+ * @return VALIDATION_OK 或 VALIDATION_OUT_OF_RANGE。
+ */
+ValidationReason validate_slot_id_value(int slot_id) {
+  return slot_id > 0 && slot_id <= VALIDATE_MAX_SLOT_ID
+             ? VALIDATION_OK
+             : VALIDATION_OUT_OF_RANGE;
+}
+
+/**
+ * @brief 校验车位位置的长度与字符。
+ * @param location 车位位置描述。
+ * @return 校验原因码。
+ */
+ValidationReason validate_location_text(const char *location) {
+  return scan_text(location, 1, MAX_LOCATION_LEN, 0);
+}
+
+/**
+ * @brief 校验车牌号的长度与字符。
+ * @param plate 车牌号。
+ * @return 校验原因码。
+ */
+ValidationReason validate_plate_text(const char *plate) {
+  return scan_text(plate, VALIDATE_MIN_LICENSE_LEN, MAX_LICENSE_LEN, 0);
+}
+
+/**
+ * @brief 校验联系方式的长度，并确认全为数字。
+ * @param contact 联系方式。
+ * @return 校验原因码。
+ */
+ValidationReason validate_contact_text(const char *contact) {
+  return scan_text(contact, VALIDATE_MIN_CONTACT_LEN, MAX_CONTACT_LEN, 1);
+}
+
+/**
+ * @brief 校验车主姓名的长度与字符。
+ * @param owner_name 车主姓名。
+ * @return 校验原因码。
+ */
+ValidationReason validate_owner_text(const char *owner_name) {
+  return scan_text(owner_name, 0, MAX_NAME_LEN, 0);
+}
+
+/**
+ * @brief 依次校验入场所需的全部字段，返回第一个失败项。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param[out] issue 接收校验结果，可以为 NULL。
+ * @return 全部通过返回 1，否则返回 0。
+ */
+int validate_entry_fields(const char *owner_name, const char *license_plate,
+                          const char *contact, ValidationIssue *issue) {
+  ValidationReason reason;
+
+  reason = validate_owner_text(owner_name);
+  if (reason != VALIDATION_OK) {
+    return report_issue(issue, VALIDATION_FIELD_OWNER, reason);
+  }
+  reason = validate_plate_text(license_plate);
+  if (reason != VALIDATION_OK) {
+    return report_issue(issue, VALIDATION_FIELD_PLATE, reason);
+  }
+  return report_issue(issue, VALIDATION_FIELD_CONTACT,
+                      validate_contact_text(contact));
+}
@@ -0,0 +1,123 @@
+#ifndef PARKING_VALIDATE_H
+#define PARKING_VALIDATE_H
+
+/**
+ * @file parking_validate.h
+ * @brief 服务层输入字段校验声明。
+ * @details
+ * 每个校验函数只扫描字段一遍，在同一遍中完成长度与字符检查，
+ * 并返回结构化的原因码，便于批量接口逐条报告失败原因。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define VALIDATE_MAX_SLOT_ID 99999 /**< 允许的最大车位ID */
+#define VALIDATE_MIN_LICENSE_LEN 5 /**< 车牌号最小长度（字节） */
+#define VALIDATE_MIN_CONTACT_LEN 8 /**< 联系方式最小长度（字节） */
+
+/**
+ *********************************************************************************
+ *                                 枚举类型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 字段校验失败的原因。
+ */
+typedef enum {
+  VALIDATION_OK = 0,            /**< 校验通过。 */
+  VALIDATION_MISSING = 1,       /**< 字段为 NULL。 */
+  VALIDATION_TOO_SHORT = 2,     /**< 字段短于下限。 */
+  VALIDATION_TOO_LONG = 3,      /**< 字段达到或超过存储上限。 */
+  VALIDATION_BAD_CHARACTER = 4, /**< 字段含有不允许的字符。 */
+  VALIDATION_OUT_OF_RANGE = 5   /**< 数值或枚举超出允许范围。 */
+} ValidationReason;
+
+/**
+ * @brief 校验失败的字段。
+ */
+typedef enum {
+  VALIDATION_FIELD_NONE = 0,    /**< 没有字段失败。 */
+  VALIDATION_FIELD_SLOT_ID = 1, /**< 车位编号。 */
+  VALIDATION_FIELD_KIND = 2,    /**< 事件类型。 */
+  VALIDATION_FIELD_OWNER = 3,   /**< 车主姓名。 */
+  VALIDATION_FIELD_PLATE = 4,   /**< 车牌号。 */
+  VALIDATION_FIELD_CONTACT = 5  /**< 联系方式。 */
+} ValidationField;
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 一条记录的校验结果：第一个失败的字段及其原因。
+ */
+typedef struct ValidationIssue {
+  ValidationField field;   /**< 失败的字段，通过时为 VALIDATION_FIELD_NONE。 */
+  ValidationReason reason; /**< 失败原因，通过时为 VALIDATION_OK。 */
+} ValidationIssue;
+
+/**
+ *********************************************************************************
+ *                                 函数原型
+ *********************************************************************************
+ */
+
+/**
+ * @brief 校验车位编号是否在 1..VALIDATE_MAX_SLOT_ID 之内。
+ * @param slot_id 车位编号。
+ * @return VALIDATION_OK 或 VALIDATION_OUT_OF_RANGE。
+ */
+ValidationReason validate_slot_id_value(int slot_id);
+
+/**
+ * @brief 校验车位位置：长度在 [1, MAX_LOCATION_LEN) 内，
+ *        且不含控制字符与数据文件的字段分隔符 '|'。
+ * @param location 车位位置描述。
+ * @return 校验原因码。
+ */
+ValidationReason validate_location_text(const char *location);
+
+/**
+ * @brief 校验车牌号：长度在 [VALIDATE_MIN_LICENSE_LEN, MAX_LICENSE_LEN) 内，
+ *        且不含控制字符与数据文件的字段分隔符 '|'。
+ * @details 扫描在超过上限时立即停止，不会读完超长字符串。
+ * @param plate 车牌号。
+ * @return 校验原因码。
+ */
+ValidationReason validate_plate_text(const char *plate);
+
+/**
+ * @brief 校验联系方式：长度在 [VALIDATE_MIN_CONTACT_LEN, MAX_CONTACT_LEN) 内且全为数字。
+ * @param contact 联系方式。
+ * @return 校验原因码。
+ */
+ValidationReason validate_contact_text(const char *contact);
+
+/**
+ * @brief 校验车主姓名：不为 NULL、长度小于 MAX_NAME_LEN，
+ *        且不含控制字符与字段分隔符 '|'。
+ * @details 空姓名仍然允许，与既有接口保持一致。
+ * @param owner_name 车主姓名。
+ * @return 校验原因码。
+ */
+ValidationReason validate_owner_text(const char *owner_name);
+
+/**
+ * @brief 依次校验入场所需的全部字段，返回第一个失败项。
+ * @param owner_name 车主姓名。
+ * @param license_plate 车牌号。
+ * @param contact 联系方式。
+ * @param[out] issue 接收校验结果，可以为 NULL。
+ * @return 全部通过返回 1，否则返回 0。
+ */
+int validate_entry_fields(const char *owner_name, const char *license_plate,
+                          const char *contact, ValidationIssue *issue);
+
+#endif /* PARKING_VALIDATE_H */
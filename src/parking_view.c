@@ -0,0 +1,418 @@
+/**
+ * @file parking_view.c
+ * @brief 停车场只读视图实现文件
+ * @details
+ * 该文件实现了 parking_view.h 中声明的视图复制、发布与纪元回收。
+ * 读者只对自己的读者槽做原子写，对纪元与当前视图指针做原子读；
+ * 发布、领取读者槽与回收在发布点的自旋锁内进行。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parking_thread.h"
+#include "parking_view.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 获取发布点的自旋锁。
+ * @param hub 目标发布点。
+ */
+static void hub_lock(ViewHub *hub) {
+  while (parking_atomic_exchange_int(&hub->lock, 1) != 0) {
+    while (parking_atomic_load_int(&hub->lock) != 0) {
+    }
+  }
+}
+
+/**
+ * @brief (静态辅助函数) 释放发布点的自旋锁。
+ * @param hub 目标发布点。
+ */
+static void hub_unlock(ViewHub *hub) {
+  parking_atomic_store_int(&hub->lock, 0);
+}
+
+/**
+ * @brief (静态辅助函数) 释放一份视图。
+ * @param memory 视图的分配来源。
+ * @param view 要释放的视图，可以为 NULL。
+ */
+static void view_free(ParkingMemory *memory, ParkingView *view) {
+  if (view == NULL) {
+    return;
+  }
+  parking_memory_free(memory, view->slots);
+  parking_memory_free(memory, view->text);
+  parking_memory_free(memory, view);
+}
+
+/**
+ * @brief (静态辅助函数) 把字符串复制到文本区，NULL 视为空串。
+ * @param[in,out] cursor 文本区的写入位置，复制后后移。
+ * @param text 要复制的字符串。
+ * @return 文本区中的副本。
+ */
+static const char *copy_text(char **cursor, const char *text) {
+  char *copy = *cursor;
+  size_t length = text != NULL ? strlen(text) : 0;
+
+  memcpy(copy, text != NULL ? text : "", length);
+  copy[length] = '\0';
+  *cursor += length + 1;
+  return copy;
+}
+
+/**
+ * @brief (静态辅助函数) 求字符串在文本区中占用的字节数。
+ * @param text 字符串，NULL 视为空串。
+ * @return 字节数（含结尾的 NUL）。
+ */
+static size_t text_size(const char *text) {
+  return (text != NULL ? strlen(text) : 0) + 1;
+}
+
+/**
+ * @brief (静态辅助函数) qsort 比较函数：按车位编号升序。
+ */
+static int compare_view_slots(const void *a, const void *b) {
+  int left = ((const ViewSlot *)a)->slot_id;
+  int right = ((const ViewSlot *)b)->slot_id;
+
+  return (left > right) - (left < right);
+}
+
+/**
+ * @brief (静态辅助函数) 求所有钉住的纪元中最早的一个。
+ * @param hub 目标发布点（调用者持有自旋锁）。
+ * @return 最早的纪元；没有读者钉住时返回当前纪元。
+ */
+static long oldest_pin(ViewHub *hub) {
+  long oldest = parking_atomic_load_long(&hub->epoch);
+  int i;
+
+  for (i = 0; i < PARKING_VIEW_MAX_READERS; i++) {
+    long pin;
+
+    if (!hub->attached[i]) {
+      continue;
+    }
+    pin = parking_atomic_load_long(&hub->pins[i]);
+    if (pin != 0 && pin < oldest) {
+      oldest = pin;
+    }
+  }
+  return oldest;
+}
+
+/**
+ * @brief (静态辅助函数) 回收宽限期已过的旧视图。
+ * @param hub 目标发布点（调用者持有自旋锁）。
+ * @return 回收的视图数。
+ */
+static int reclaim_locked(ViewHub *hub) {
+  long oldest = oldest_pin(hub);
+  ParkingView **link = &hub->retired;
+  int count = 0;
+
+  while (*link != NULL) {
+    ParkingView *view = *link;
+
+    /* 钉住的纪元都晚于退役纪元时，不会再有读者持有该视图 */
+    if (view->retired_epoch < oldest) {
+      *link = view->retired_next;
+      view_free(hub->memory, view);
+      count++;
+    } else {
+      link = &view->retired_next;
+    }
+  }
+  hub->reclaimed += count;
+  return count;
+}
+
+/* ========================================================================== */
+/*                               只读视图API实现                              */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个尚未发布视图的发布点。
+ * @param memory 分配来源，NULL 表示 C 堆。
+ * @return 成功返回发布点，内存不足返回 NULL。
+ */
+ViewHub *view_hub_create(ParkingMemory *memory) {
+  ViewHub *hub = (ViewHub *)parking_memory_calloc(memory, PARKING_MEMORY_TABLE,
+                                                  1, sizeof(ViewHub));
+
+  if (hub == NULL) {
+    return NULL;
+  }
+  hub->epoch = 1;
+  hub->mutations = -1;
+  hub->memory = memory;
+  return hub;
+}
+
+/**
+ * @brief 释放发布点与它的全部视图。
+ * @param hub 要释放的发布点，可以为 NULL。
+ */
+void view_hub_free(ViewHub *hub) {
+  ParkingView *view;
+
+  if (hub == NULL) {
+    return;
+  }
+  view = hub->retired;
+  while (view != NULL) {
+    ParkingView *next = view->retired_next;
+
+    view_free(hub->memory, view);
+    view = next;
+  }
+  view_free(hub->memory, (ParkingView *)hub->current);
+  parking_memory_free(hub->memory, hub);
+}
+
+/**
+ * @brief 把停车场复制成一份新视图。
+ * @param lot 目标停车场（调用者持有读锁或写锁）。
+ * @param memory 视图的分配来源。
+ * @return 成功返回视图，参数无效或内存不足返回 NULL。
+ */
+ParkingView *parking_view_build(const ParkingLot *lot, ParkingMemory *memory) {
+  ParkingView *view;
+  size_t text_bytes = 0;
+  char *cursor;
+  int i;
+
+  if (lot == NULL) {
+    return NULL;
+  }
+  for (i = 0; i < lot->slot_count; i++) {
+    const ParkingSlot *slot = lot->slot_table[i];
+
+    text_bytes += text_size(slot->location) + text_size(slot->owner_name) +
+                  text_size(slot->license_plate) + text_size(slot->contact);
+  }
+  view = (ParkingView *)parking_memory_calloc(memory, PARKING_MEMORY_TABLE, 1,
+                                              sizeof(ParkingView));
+  if (view == NULL) {
+    return NULL;
+  }
+  /* 多分配 1 个，空停车场也得到非 NULL 的数组与文本区 */
+  view->slots = (ViewSlot *)parking_memory_alloc(
+      memory, PARKING_MEMORY_TABLE,
+      ((size_t)lot->slot_count + 1) * sizeof(ViewSlot));
+  view->text = (char *)parking_memory_alloc(memory, PARKING_MEMORY_TABLE,
+                                            text_bytes + 1);
+  if (view->slots == NULL || view->text == NULL) {
+    view_free(memory, view);
+    return NULL;
+  }
+
+  cursor = view->text;
+  for (i = 0; i < lot->slot_count; i++) {
+    const ParkingSlot *slot = lot->slot_table[i];
+    ViewSlot *copy = &view->slots[i];
+
+    copy->slot_id = slot->slot_id;
+    copy->status = slot->status;
+    copy->type = slot->type;
+    copy->entry_time = slot->entry_time;
+    copy->resident_due_date = slot->resident_due_date;
+    copy->location = copy_text(&cursor, slot->location);
+    copy->owner_name = copy_text(&cursor, slot->owner_name);
+    copy->license_plate = copy_text(&cursor, slot->license_plate);
+    copy->contact = copy_text(&cursor, slot->contact);
+  }
+  view->slot_count = lot->slot_count;
+  qsort(view->slots, (size_t)view->slot_count, sizeof(ViewSlot),
+        compare_view_slots);
+
+  view->mutation_count = parking_atomic_load_long(&lot->mutation_count);
+  view->published_at = parking_lot_now(lot);
+  view->total_slots = parking_atomic_load_int(&lot->total_slots);
+  view->occupied_slots = parking_atomic_load_int(&lot->occupied_slots);
+  view->free_slots = view->total_slots - view->occupied_slots;
+  view->occupied_resident_count =
+      parking_atomic_load_int(&lot->occupied_resident_count);
+  view->occupied_visitor_count =
+      parking_atomic_load_int(&lot->occupied_visitor_count);
+  view->today_revenue_cents =
+      parking_atomic_load_long(&lot->today_revenue_cents);
+  view->month_revenue_cents =
+      parking_atomic_load_long(&lot->month_revenue_cents);
+  view->revenue_day = lot->revenue_day;
+  view->revenue_month = lot->revenue_month;
+  return view;
+}
+
+/**
+ * @brief 发布一份视图，替换当前视图并回收宽限期已过的旧视图。
+ * @param hub 目标发布点。
+ * @param view 新视图。
+ * @return 已发布返回 0，视图过时被丢弃返回 1，参数无效返回 -1。
+ */
+int view_hub_publish(ViewHub *hub, ParkingView *view) {
+  ParkingView *old;
+  long epoch;
+
+  if (hub == NULL || view == NULL) {
+    return -1;
+  }
+  hub_lock(hub);
+  old = (ParkingView *)hub->current;
+  if (old != NULL && view->mutation_count <= old->mutation_count) {
+    hub_unlock(hub);
+    view_free(hub->memory, view);
+    return 1;
+  }
+  view->version = ++hub->published;
+  parking_atomic_exchange_ptr(&hub->current, view);
+  parking_atomic_store_long(&hub->mutations, view->mutation_count);
+  if (old != NULL) {
+    /* 先退役再推进纪元：此后钉住的读者只能看到新视图 */
+    epoch = parking_atomic_load_long(&hub->epoch);
+    old->retired_epoch = epoch;
+    old->retired_next = hub->retired;
+    hub->retired = old;
+    parking_atomic_store_long(&hub->epoch, epoch + 1);
+  }
+  reclaim_locked(hub);
+  hub_unlock(hub);
+  return 0;
+}
+
+/**
+ * @brief 读取当前视图复制时停车场的修改次数。
+ * @param hub 目标发布点。
+ * @return 修改次数；尚未发布或 hub 为 NULL 时返回 -1。
+ */
+long view_hub_mutations(ViewHub *hub) {
+  return hub != NULL ? parking_atomic_load_long(&hub->mutations) : -1;
+}
+
+/**
+ * @brief 回收宽限期已过的旧视图。
+ * @param hub 目标发布点。
+ * @return 本次回收的视图数。
+ */
+int view_hub_reclaim(ViewHub *hub) {
+  int count;
+
+  if (hub == NULL) {
+    return 0;
+  }
+  hub_lock(hub);
+  count = reclaim_locked(hub);
+  hub_unlock(hub);
+  return count;
+}
+
+/**
+ * @brief 领取一个读者槽。
+ * @param hub 目标发布点。
+ * @return 读者槽下标；参数无效或槽已用完返回 -1。
+ */
+int view_hub_attach(ViewHub *hub) {
+  int i;
+
+  if (hub == NULL) {
+    return -1;
+  }
+  hub_lock(hub);
+  for (i = 0; i < PARKING_VIEW_MAX_READERS; i++) {
+    if (!hub->attached[i]) {
+      hub->attached[i] = 1;
+      hub->reader_count++;
+      parking_atomic_store_long(&hub->pins[i], 0);
+      hub_unlock(hub);
+      return i;
+    }
+  }
+  hub_unlock(hub);
+  return -1;
+}
+
+/**
+ * @brief 归还读者槽。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ */
+void view_hub_detach(ViewHub *hub, int reader) {
+  if (hub == NULL || reader < 0 || reader >= PARKING_VIEW_MAX_READERS) {
+    return;
+  }
+  hub_lock(hub);
+  if (hub->attached[reader]) {
+    parking_atomic_store_long(&hub->pins[reader], 0);
+    hub->attached[reader] = 0;
+    hub->reader_count--;
+  }
+  hub_unlock(hub);
+}
+
+/**
+ * @brief 钉住当前纪元并取得当前视图。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ * @return 当前视图；尚未发布或参数无效时返回 NULL。
+ */
+const ParkingView *view_hub_pin(ViewHub *hub, int reader) {
+  if (hub == NULL || reader < 0 || reader >= PARKING_VIEW_MAX_READERS) {
+    return NULL;
+  }
+  /*
+   * 先写入纪元再读视图指针：发布者替换指针之后才推进纪元并检查读者槽，
+   * 读到旧指针的读者钉住的纪元一定不晚于旧视图的退役纪元。
+   */
+  parking_atomic_store_long(&hub->pins[reader],
+                            parking_atomic_load_long(&hub->epoch));
+  return (const ParkingView *)parking_atomic_load_ptr(&hub->current);
+}
+
+/**
+ * @brief 解除钉住。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ */
+void view_hub_unpin(ViewHub *hub, int reader) {
+  if (hub == NULL || reader < 0 || reader >= PARKING_VIEW_MAX_READERS) {
+    return;
+  }
+  parking_atomic_store_long(&hub->pins[reader], 0);
+}
+
+/**
+ * @brief 在视图中按编号查找车位。
+ * @param view 目标视图。
+ * @param slot_id 车位编号。
+ * @return 找到返回车位，否则返回 NULL。
+ */
+const ViewSlot *parking_view_find(const ParkingView *view, int slot_id) {
+  int low = 0;
+  int high;
+
+  if (view == NULL) {
+    return NULL;
+  }
+  high = view->slot_count - 1;
+  while (low <= high) {
+    int middle = low + (high - low) / 2;
+    int id = view->slots[middle].slot_id;
+
+    if (id == slot_id) {
+      return &view->slots[middle];
+    }
+    if (id < slot_id) {
+      low = middle + 1;
+    } else {
+      high = middle - 1;
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,193 @@
+#ifndef PARKING_VIEW_H
+#define PARKING_VIEW_H
+
+#include <time.h>
+
+#include "parking_data.h"
+#include "parking_memory.h"
+
+/**
+ * @file parking_view.h
+ * @brief 供报表线程无锁读取的停车场只读视图声明。
+ * @details
+ * 全部车位列表、统计与导出要在停车场读锁内遍历整个车位表；大停车场上
+ * 一次遍历要几十毫秒，期间闸机的入场、出场只能等待写锁。只读视图按
+ * 读-复制-更新（RCU）的方式发布：写者在一批修改之后把车位表复制成一份
+ * 不可变的视图并原子替换当前视图，读者钉住一个纪元后直接读取当前视图，
+ * 不获取任何锁，也不会阻塞写者。
+ *
+ * 被替换的视图不能立即释放，可能还有读者在读。每个读者在 attach 时领取
+ * 一个读者槽，pin 时把当前纪元写入自己的槽再读取视图指针；发布者替换
+ * 视图后推进纪元，只有当所有钉住的纪元都晚于视图退役时的纪元（宽限期
+ * 已过）时才释放它。读者 pin、unpin 各只有一两次原子读写。
+ *
+ * 视图是发布时刻的副本，之后的修改要等下一次发布才可见；车位按编号
+ * 升序排列，文本字段与视图一起分配，钉住期间一直有效。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define PARKING_VIEW_MAX_READERS 64 /**< 同时 attach 的读者数上限 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 视图中的一个车位。
+ * @details 字符串字段指向视图自带的文本区，从不为 NULL（没有时为空串）。
+ */
+typedef struct ViewSlot {
+  int slot_id;              /**< 车位编号。 */
+  ParkingStatus status;     /**< 车位状态。 */
+  ParkingType type;         /**< 停车类型。 */
+  time_t entry_time;        /**< 入场时间。 */
+  time_t resident_due_date; /**< 居民月费的到期时间。 */
+  const char *location;     /**< 位置描述。 */
+  const char *owner_name;   /**< 车主姓名。 */
+  const char *license_plate; /**< 车牌号。 */
+  const char *contact;      /**< 联系方式。 */
+} ViewSlot;
+
+/**
+ * @brief 一份发布后不再修改的停车场视图。
+ */
+typedef struct ParkingView {
+  unsigned long version; /**< 发布序号，从 1 起递增。 */
+  long mutation_count;   /**< 复制时停车场的修改次数。 */
+  time_t published_at;   /**< 复制时的业务时间。 */
+  int total_slots;       /**< 总车位数。 */
+  int occupied_slots;    /**< 已占用车位数。 */
+  int free_slots;        /**< 空闲车位数。 */
+  int occupied_resident_count; /**< 居民车辆占用的车位数。 */
+  int occupied_visitor_count;  /**< 访客车辆占用的车位数。 */
+  long today_revenue_cents;    /**< 当日收入（分）。 */
+  long month_revenue_cents;    /**< 当月收入（分）。 */
+  long revenue_day;   /**< 当日收入所属日期（YYYYMMDD），0 表示尚无收入。 */
+  long revenue_month; /**< 当月收入所属月份（YYYYMM），0 表示尚无收入。 */
+  int slot_count;     /**< slots 中的车位数。 */
+  ViewSlot *slots;    /**< 按编号升序排列的车位。 */
+  char *text;         /**< 车位文本字段所在的文本区。 */
+  long retired_epoch; /**< 内部使用：视图退役时的纪元。 */
+  struct ParkingView *retired_next; /**< 内部使用：待回收链表中的下一个。 */
+} ParkingView;
+
+/**
+ * @brief 发布只读视图并管理其回收的发布点。
+ */
+typedef struct ViewHub {
+  void *volatile current; /**< 当前视图（ParkingView），NULL 表示尚未发布。 */
+  volatile long epoch;    /**< 当前纪元，从 1 起，每次发布后递增。 */
+  /** 各读者钉住的纪元，0 表示未钉住。 */
+  volatile long pins[PARKING_VIEW_MAX_READERS];
+  int attached[PARKING_VIEW_MAX_READERS]; /**< 非 0 表示读者槽已被领取。 */
+  int reader_count;       /**< 已领取的读者槽数。 */
+  volatile int lock;      /**< 保护发布、读者槽领取与待回收链表的自旋锁。 */
+  ParkingView *retired;   /**< 已被替换、等待宽限期结束的视图。 */
+  unsigned long published; /**< 已发布的视图数。 */
+  volatile long mutations; /**< 当前视图复制时停车场的修改次数，-1 表示没有。 */
+  long reclaimed;         /**< 已回收的视图数。 */
+  ParkingMemory *memory;  /**< 分配来源，NULL 表示 C 堆。 */
+} ViewHub;
+
+/**
+ *********************************************************************************
+ *                               只读视图API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个尚未发布视图的发布点。
+ * @param memory 发布点与视图的分配来源，NULL 表示 C 堆；
+ *               计入 PARKING_MEMORY_TABLE。
+ * @return 成功返回发布点，内存不足返回 NULL。
+ */
+ViewHub *view_hub_create(ParkingMemory *memory);
+
+/**
+ * @brief 释放发布点与它的全部视图。
+ * @details 调用者须保证已没有读者钉住视图。
+ * @param hub 要释放的发布点，可以为 NULL。
+ */
+void view_hub_free(ViewHub *hub);
+
+/**
+ * @brief 把停车场复制成一份新视图（尚未发布）。
+ * @param lot 目标停车场（调用者持有读锁或写锁）。
+ * @param memory 视图的分配来源，NULL 表示 C 堆。
+ * @return 成功返回视图，参数无效或内存不足返回 NULL。
+ */
+ParkingView *parking_view_build(const ParkingLot *lot, ParkingMemory *memory);
+
+/**
+ * @brief 发布一份视图，替换当前视图并回收宽限期已过的旧视图。
+ * @details 视图的 mutation_count 不晚于当前视图时说明它已经过时
+ *          （并发复制的另一份先发布了），直接释放而不发布。
+ * @param hub 目标发布点。
+ * @param view 由 parking_view_build 复制、由同一发布点分配的视图。
+ * @return 已发布返回 0，视图过时被丢弃返回 1，参数无效返回 -1。
+ */
+int view_hub_publish(ViewHub *hub, ParkingView *view);
+
+/**
+ * @brief 读取当前视图复制时停车场的修改次数。
+ * @details 不获取锁，供发布者判断是否需要重新复制。
+ * @param hub 目标发布点。
+ * @return 修改次数；尚未发布或 hub 为 NULL 时返回 -1。
+ */
+long view_hub_mutations(ViewHub *hub);
+
+/**
+ * @brief 回收宽限期已过的旧视图。
+ * @param hub 目标发布点。
+ * @return 本次回收的视图数。
+ */
+int view_hub_reclaim(ViewHub *hub);
+
+/**
+ * @brief 领取一个读者槽。
+ * @details 每个读者线程领取一次，此后反复 pin、unpin。
+ * @param hub 目标发布点。
+ * @return 读者槽下标；参数无效或槽已用完返回 -1。
+ */
+int view_hub_attach(ViewHub *hub);
+
+/**
+ * @brief 归还读者槽，钉住的视图随之解除。
+ * @param hub 目标发布点。
+ * @param reader view_hub_attach 返回的读者槽下标。
+ */
+void view_hub_detach(ViewHub *hub, int reader);
+
+/**
+ * @brief 钉住当前纪元并取得当前视图。
+ * @details 不获取锁。返回的视图在 view_hub_unpin 之前不会被释放；
+ *          同一读者不能嵌套钉住。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ * @return 当前视图；尚未发布或参数无效时返回 NULL。
+ */
+const ParkingView *view_hub_pin(ViewHub *hub, int reader);
+
+/**
+ * @brief 解除钉住，此后不得再访问钉住期间取得的视图。
+ * @param hub 目标发布点。
+ * @param reader 读者槽下标。
+ */
+void view_hub_unpin(ViewHub *hub, int reader);
+
+/**
+ * @brief 在视图中按编号查找车位（二分查找）。
+ * @param view 目标视图。
+ * @param slot_id 车位编号。
+ * @return 找到返回车位，否则返回 NULL。
+ */
+const ViewSlot *parking_view_find(const ParkingView *view, int slot_id);
+
+#endif /* PARKING_VIEW_H */
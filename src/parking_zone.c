@@ -0,0 +1,274 @@
+/**
+ * @file parking_zone.c
+ * @brief 分区空位计数表实现文件
+ * @details
+ * 该文件实现了 parking_zone.h 中声明的分区计数表：按登记顺序存放的
+ * 分区数组，每个分区以位置前缀匹配车位。
+ */
+
+#include <string.h>
+
+#include "parking_zone.h"
+
+/* ========================================================================== */
+/*                                内部辅助函数实现                            */
+/* ========================================================================== */
+
+/**
+ * @brief (静态辅助函数) 查找分区在数组中的下标。
+ * @param table 计数表。
+ * @param prefix 分区前缀。
+ * @return 分区下标，未登记时返回 -1。
+ */
+static int find_zone(const ZoneTable *table, const char *prefix) {
+  int i;
+
+  for (i = 0; i < table->count; i++) {
+    if (strcmp(table->zones[i].stats.zone, prefix) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief (静态辅助函数) 判断车位的位置是否属于分区。
+ * @param zone 分区。
+ * @param location 车位的位置描述，可以为 NULL。
+ * @return 属于返回 1，否则返回 0。
+ */
+static int zone_contains(const ZoneEntry *zone, const char *location) {
+  return location != NULL &&
+         strncmp(location, zone->stats.zone, zone->length) == 0;
+}
+
+/* ========================================================================== */
+/*                               计数表API实现                                */
+/* ========================================================================== */
+
+/**
+ * @brief 创建一个空的分区计数表。
+ * @param memory 计数表的分配来源，NULL 表示 C 堆。
+ * @return 成功返回计数表，内存不足返回 NULL。
+ */
+ZoneTable *zone_table_create(ParkingMemory *memory) {
+  ZoneTable *table;
+
+  table = (ZoneTable *)parking_memory_calloc(memory, PARKING_MEMORY_INDEX, 1,
+                                             sizeof(ZoneTable));
+  if (table == NULL) {
+    return NULL;
+  }
+  table->memory = memory;
+  return table;
+}
+
+/**
+ * @brief 释放分区计数表。
+ * @param table 要释放的计数表，可以为 NULL。
+ */
+void zone_table_free(ZoneTable *table) {
+  if (table == NULL) {
+    return;
+  }
+  parking_memory_free(table->memory, table->zones);
+  parking_memory_free(table->memory, table);
+}
+
+/**
+ * @brief 登记一个分区，并按停车场的现有车位计算初始计数。
+ * @param table 目标计数表。
+ * @param lot 计数表所属的停车场。
+ * @param prefix 分区前缀。
+ * @return 成功返回 0，前缀无效返回 -1，内存不足返回 -2。
+ */
+int zone_table_add(ZoneTable *table, const ParkingLot *lot,
+                   const char *prefix) {
+  ZoneEntry *zone;
+  size_t length;
+  int i;
+
+  if (prefix == NULL) {
+    return -1;
+  }
+  length = strlen(prefix);
+  if (length == 0 || length >= MAX_LOCATION_LEN) {
+    return -1;
+  }
+  if (find_zone(table, prefix) >= 0) {
+    return 0;
+  }
+
+  if (table->count == table->capacity) {
+    int capacity = table->capacity > 0 ? table->capacity * 2
+                                       : ZONE_TABLE_INITIAL;
+    ZoneEntry *zones = (ZoneEntry *)parking_memory_realloc(
+        table->memory, PARKING_MEMORY_INDEX, table->zones,
+        (size_t)capacity * sizeof(ZoneEntry));
+
+    if (zones == NULL) {
+      return -2;
+    }
+    table->zones = zones;
+    table->capacity = capacity;
+  }
+
+  zone = &table->zones[table->count];
+  memset(zone, 0, sizeof(ZoneEntry));
+  memcpy(zone->stats.zone, prefix, length + 1);
+  zone->length = length;
+  for (i = 0; i < lot->slot_count; i++) {
+    if (zone_contains(zone, lot->slot_table[i]->location)) {
+      zone->stats.total_slots++;
+      if (lot->hot.status[i] == FREE_STATUS) {
+        zone->stats.free_slots++;
+      }
+    }
+  }
+  zone->stats.occupied_slots = zone->stats.total_slots - zone->stats.free_slots;
+  table->count++;
+  return 0;
+}
+
+/**
+ * @brief 撤销一个分区。
+ * @param table 目标计数表。
+ * @param prefix 分区前缀。
+ * @return 成功返回 0，分区未登记返回 -1。
+ */
+int zone_table_remove(ZoneTable *table, const char *prefix) {
+  int at = prefix != NULL ? find_zone(table, prefix) : -1;
+
+  if (at < 0) {
+    return -1;
+  }
+  memmove(&table->zones[at], &table->zones[at + 1],
+          (size_t)(table->count - at - 1) * sizeof(ZoneEntry));
+  table->count--;
+  return 0;
+}
+
+/**
+ * @brief 查找分区的计数。
+ * @param table 目标计数表。
+ * @param prefix 分区前缀。
+ * @return 找到返回分区计数，否则返回 NULL。
+ */
+const ParkingZoneStats *zone_table_find(const ZoneTable *table,
+                                        const char *prefix) {
+  int at = prefix != NULL ? find_zone(table, prefix) : -1;
+
+  return at >= 0 ? &table->zones[at].stats : NULL;
+}
+
+/**
+ * @brief 按一个车位的变化调整所有包含它的分区，并通知分区处理函数。
+ * @param table 目标计数表。
+ * @param lot 计数表所属的停车场。
+ * @param location 车位的位置描述。
+ * @param total_delta 车位总数的调整量。
+ * @param free_delta 空闲车位数的调整量。
+ */
+void zone_table_apply(ZoneTable *table, ParkingLot *lot, const char *location,
+                      int total_delta, int free_delta) {
+  int i;
+
+  for (i = 0; i < table->count; i++) {
+    ParkingZoneStats *stats = &table->zones[i].stats;
+
+    if (!zone_contains(&table->zones[i], location)) {
+      continue;
+    }
+    stats->total_slots += total_delta;
+    stats->free_slots += free_delta;
+    stats->occupied_slots = stats->total_slots - stats->free_slots;
+    if (lot->zone_handler != NULL) {
+      lot->zone_handler(lot, stats, lot->zone_ctx);
+    }
+  }
+}
+
+/**
+ * @brief 车位位置改变后，把它从不再包含它的分区移到新包含它的分区。
+ * @param table 目标计数表。
+ * @param lot 计数表所属的停车场。
+ * @param old_location 车位原来的位置描述。
+ * @param new_location 车位新的位置描述。
+ * @param is_free 车位是否空闲。
+ */
+void zone_table_move(ZoneTable *table, ParkingLot *lot,
+                     const char *old_location, const char *new_location,
+                     int is_free) {
+  int i;
+
+  for (i = 0; i < table->count; i++) {
+    ParkingZoneStats *stats = &table->zones[i].stats;
+    int was_in = zone_contains(&table->zones[i], old_location);
+    int delta = zone_contains(&table->zones[i], new_location) - was_in;
+
+    if (delta == 0) {
+      continue;
+    }
+    stats->total_slots += delta;
+    if (is_free) {
+      stats->free_slots += delta;
+    }
+    stats->occupied_slots = stats->total_slots - stats->free_slots;
+    if (lot->zone_handler != NULL) {
+      lot->zone_handler(lot, stats, lot->zone_ctx);
+    }
+  }
+}
+
+/**
+ * @brief 查找分区的占用画像。
+ * @param table 目标计数表。
+ * @param prefix 分区前缀。
+ * @return 找到返回占用画像，否则返回 NULL。
+ */
+const OccupancyForecast *zone_table_forecast(const ZoneTable *table,
+                                             const char *prefix) {
+  int at = prefix != NULL ? find_zone(table, prefix) : -1;
+
+  return at >= 0 ? &table->zones[at].forecast : NULL;
+}
+
+/**
+ * @brief 把各分区当前的占用数记入其占用画像。
+ * @param table 目标计数表。
+ * @param when 观测所在的刻钟。
+ */
+void zone_table_observe(ZoneTable *table, const ForecastTime *when) {
+  int i;
+
+  for (i = 0; i < table->count; i++) {
+    const ParkingZoneStats *stats = &table->zones[i].stats;
+
+    forecast_observe(&table->zones[i].forecast, when, stats->occupied_slots,
+                     stats->total_slots);
+  }
+}
+
+/**
+ * @brief 查找包含某个位置的最具体的分区。
+ * @param table 目标计数表，可以为 NULL。
+ * @param location 位置描述。
+ * @return 找到返回前缀最长的分区名（下一次修改计数表前有效），否则返回 NULL。
+ */
+const char *zone_table_match(const ZoneTable *table, const char *location) {
+  const ZoneEntry *best = NULL;
+  int i;
+
+  if (table == NULL) {
+    return NULL;
+  }
+  for (i = 0; i < table->count; i++) {
+    const ZoneEntry *zone = &table->zones[i];
+
+    if (zone_contains(zone, location) &&
+        (best == NULL || zone->length > best->length)) {
+      best = zone;
+    }
+  }
+  return best != NULL ? best->stats.zone : NULL;
+}
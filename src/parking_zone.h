@@ -0,0 +1,154 @@
+#ifndef PARKING_ZONE_H
+#define PARKING_ZONE_H
+
+#include <stddef.h>
+
+#include "parking_data.h"
+#include "parking_forecast.h"
+#include "parking_memory.h"
+
+/**
+ * @file parking_zone.h
+ * @brief 分区空位计数表的结构与接口声明。
+ * @details
+ * 分区以车位位置描述的前缀登记（如 "B1-" 表示地下一层），与预约的分区
+ * 含义相同。每个分区保存车位总数与空闲数，由数据层在车位加入、删除、
+ * 入场、出场与修改位置时增量调整，查询分区空位只需一次查表，
+ * 不必列出车位再按前缀统计。
+ *
+ * 一次状态变化需要与每个已登记的分区比较前缀，代价与分区数成正比；
+ * 引导屏的分区通常只有几个到几十个。计数有变化的分区会通知
+ * 停车场的分区处理函数，引导屏可以随事件刷新而不必轮询。
+ * 每个分区还带有一份占用画像，用于短时占用预测。
+ * 计数表本身不加锁，由停车场的锁保护。
+ */
+
+/**
+ *********************************************************************************
+ *                                 常量定义
+ *********************************************************************************
+ */
+
+#define ZONE_TABLE_INITIAL 8 /**< 分区数组的初始容量 */
+
+/**
+ *********************************************************************************
+ *                                 结构体定义
+ *********************************************************************************
+ */
+
+/**
+ * @brief 计数表中的一个分区。
+ */
+typedef struct ZoneEntry {
+  ParkingZoneStats stats; /**< 分区名称与计数。 */
+  size_t length;          /**< 分区前缀的长度。 */
+  OccupancyForecast forecast; /**< 分区的占用画像与预测缓存。 */
+} ZoneEntry;
+
+/**
+ * @brief 停车场的分区计数表。
+ */
+typedef struct ZoneTable {
+  ZoneEntry *zones;      /**< 按登记顺序存放的分区。 */
+  int count;             /**< 分区数。 */
+  int capacity;          /**< zones 已分配的容量。 */
+  ParkingMemory *memory; /**< 分配来源，NULL 表示 C 堆。 */
+} ZoneTable;
+
+/**
+ *********************************************************************************
+ *                              计数表API声明
+ *********************************************************************************
+ */
+
+/**
+ * @brief 创建一个空的分区计数表。
+ * @param memory 计数表的分配来源，NULL 表示 C 堆；计入 PARKING_MEMORY_INDEX。
+ * @return 成功返回计数表，内存不足返回 NULL。
+ */
+ZoneTable *zone_table_create(ParkingMemory *memory);
+
+/**
+ * @brief 释放分区计数表。
+ * @param table 要释放的计数表，可以为 NULL。
+ */
+void zone_table_free(ZoneTable *table);
+
+/**
+ * @brief 登记一个分区，并按停车场的现有车位计算初始计数。
+ * @details 分区已登记时什么也不做。初始计数需要扫描一遍车位表。
+ * @param table 目标计数表。
+ * @param lot 计数表所属的停车场。
+ * @param prefix 分区前缀，非空且长度小于 MAX_LOCATION_LEN。
+ * @return 成功返回 0，前缀无效返回 -1，内存不足返回 -2。
+ */
+int zone_table_add(ZoneTable *table, const ParkingLot *lot,
+                   const char *prefix);
+
+/**
+ * @brief 撤销一个分区。
+ * @param table 目标计数表。
+ * @param prefix 分区前缀。
+ * @return 成功返回 0，分区未登记返回 -1。
+ */
+int zone_table_remove(ZoneTable *table, const char *prefix);
+
+/**
+ * @brief 查找分区的计数。
+ * @param table 目标计数表。
+ * @param prefix 分区前缀。
+ * @return 找到返回分区计数（下一次修改计数表前有效），否则返回 NULL。
+ */
+const ParkingZoneStats *zone_table_find(const ZoneTable *table,
+                                        const char *prefix);
+
+/**
+ * @brief 按一个车位的变化调整所有包含它的分区，并通知分区处理函数。
+ * @param table 目标计数表。
+ * @param lot 计数表所属的停车场，处理函数取自 lot->zone_handler。
+ * @param location 车位的位置描述。
+ * @param total_delta 车位总数的调整量。
+ * @param free_delta 空闲车位数的调整量。
+ */
+void zone_table_apply(ZoneTable *table, ParkingLot *lot, const char *location,
+                      int total_delta, int free_delta);
+
+/**
+ * @brief 车位位置改变后，把它从不再包含它的分区移到新包含它的分区。
+ * @details 新旧位置都属于的分区计数不变，也不通知。
+ * @param table 目标计数表。
+ * @param lot 计数表所属的停车场。
+ * @param old_location 车位原来的位置描述。
+ * @param new_location 车位新的位置描述。
+ * @param is_free 车位是否空闲。
+ */
+void zone_table_move(ZoneTable *table, ParkingLot *lot,
+                     const char *old_location, const char *new_location,
+                     int is_free);
+
+/**
+ * @brief 查找分区的占用画像。
+ * @param table 目标计数表。
+ * @param prefix 分区前缀。
+ * @return 找到返回占用画像（下一次修改计数表前有效），否则返回 NULL。
+ */
+const OccupancyForecast *zone_table_forecast(const ZoneTable *table,
+                                             const char *prefix);
+
+/**
+ * @brief 把各分区当前的占用数记入其占用画像。
+ * @param table 目标计数表。
+ * @param when 观测所在的刻钟。
+ */
+void zone_table_observe(ZoneTable *table, const ForecastTime *when);
+
+/**
+ * @brief 查找包含某个位置的最具体（前缀最长）的分区。
+ * @param table 目标计数表，可以为 NULL。
+ * @param location 位置描述。
+ * @return 找到返回分区名（下一次修改计数表前有效），否则返回 NULL。
+ */
+const char *zone_table_match(const ZoneTable *table, const char *location);
+
+#endif /* PARKING_ZONE_H */
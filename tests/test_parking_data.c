@@ -15,13 +15,45 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../src/parking_aggregate.h"
+#include "../src/parking_calendar.h"
+#include "../src/parking_codec.h"
+#include "../src/parking_column.h"
 #include "../src/parking_data.h"
+#include "../src/parking_forecast.h"
+#include "../src/parking_history.h"
+#include "../src/parking_hll.h"
+#include "../src/parking_journal.h"
+#include "../src/parking_ledger.h"
+#include "../src/parking_plate.h"
+#include "../src/parking_platelist.h"
+#include "../src/parking_query.h"
+#include "../src/parking_registry.h"
+#include "../src/parking_session.h"
+#include "../src/parking_strings.h"
+#include "../src/parking_tasks.h"
+#include "../src/parking_thread.h"
+#include "../src/parking_timeline.h"
+#include "../src/parking_view.h"
 #include "cmocka.h"
 
 /* ========================================================================== */
 /*                                 测试用例实现                               */
 /* ========================================================================== */
 
+/**
+ * @brief 删除二进制快照及其配对的索引映像。
+ * @param filename 快照文件名。
+ */
+static void remove_snapshot_files(const char *filename) {
+  char image_path[256];
+
+  snprintf(image_path, sizeof(image_path), "%s%s", filename,
+           INDEX_IMAGE_SUFFIX);
+  remove(image_path);
+  remove(filename);
+}
+
 /**
  * @brief 测试 `init_parking_lot` 函数的功能。
  * @details 验证停车场初始化后，总车位数、已占用车位数和链表头指针是否正确。
@@ -110,66 +142,4249 @@ static void test_find_functions(void **state) {
 }
 
 /**
- * @brief 测试 `save_parking_data` 和 `load_parking_data` 的数据持久化功能。
+ * @brief 测试车位编号索引在大量增删下的正确性。
  * @details
- * 验证停车场数据能否被成功保存到文件，并能从文件正确加载回来，同时保持数据的一致性。
+ * 添加足以触发多次扩容的车位，删除其中一半后验证剩余车位仍可查到、
+ * 已删除车位查不到，并且被删除的编号可以重新添加。
  * @param state cmocka 框架的测试状态指针。
  */
-static void test_data_persistence(void **state) {
+static void test_slot_id_index(void **state) {
   (void)state; /* not used */
-  const char *test_file = "persistence_test.txt";
-  ParkingLot *lot_to_save = init_parking_lot(5);
-  add_parking_slot(lot_to_save, create_parking_slot(1, "P-1"));
-  add_parking_slot(lot_to_save, create_parking_slot(2, "P-2")); // 一个空闲车位
-  allocate_slot(lot_to_save, 1, "PersistentUser", "沪A12123", "12312341234",
-                RESIDENT_TYPE);
+  ParkingLot *lot = init_parking_lot(1000);
+  int i;
 
-  /* 1. 测试保存 */
-  int save_result = save_parking_data(lot_to_save, test_file);
-  assert_int_equal(save_result, 0);
+  for (i = 1; i <= 1000; i++) {
+    assert_int_equal(add_parking_slot(lot, create_parking_slot(i, "IDX")), 0);
+  }
+  assert_int_equal((int)lot->id_index.count, 1000);
 
-  /* 2. 测试加载 */
-  ParkingLot *loaded_lot = load_parking_data(test_file);
+  for (i = 2; i <= 1000; i += 2) {
+    assert_int_equal(delete_slot(lot, i), 0);
+  }
+  assert_int_equal(delete_slot(lot, 2), -3);
+
+  for (i = 1; i <= 1000; i++) {
+    ParkingSlot *found = find_slot_by_id(lot, i);
+    if (i % 2 == 1) {
+      assert_non_null(found);
+      assert_int_equal(found->slot_id, i);
+    } else {
+      assert_null(found);
+    }
+  }
+
+  assert_int_equal(add_parking_slot(lot, create_parking_slot(500, "IDX")), 0);
+  assert_non_null(find_slot_by_id(lot, 500));
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试编号索引与车牌号索引的渐进扩容。
+ * @details
+ * 扩容后旧桶数组逐步迁移：迁移期间新旧桶数组中的条目都能查到、删除与
+ * 改写，重复键仍被拒绝；继续写入若干次后旧桶数组被释放。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_index_incremental_growth(void **state) {
+  (void)state; /* not used */
+  ParkingSlot *slots = (ParkingSlot *)calloc(200, sizeof(ParkingSlot));
+  char plates[200][16];
+  SlotIdIndex ids;
+  PlateIndex plates_index;
+  size_t capacity;
+  int i;
+
+  assert_non_null(slots);
+  slot_id_index_init(&ids, NULL);
+  plate_index_init(&plates_index, NULL);
+  for (i = 0; i < 200; i++) {
+    sprintf(plates[i], "测A%05d", i);
+    slots[i].slot_id = i + 1;
+    slots[i].license_plate = plates[i];
+  }
+  /* 16 个桶在第 12 次登记时扩容，旧桶数组随后迁移 */
+  for (i = 0; i < 12; i++) {
+    assert_int_equal(slot_id_index_insert(&ids, i + 1, &slots[i]), 0);
+    assert_int_equal(plate_index_insert(&plates_index, &slots[i]), 0);
+  }
+  assert_int_equal((int)ids.capacity, 32);
+  assert_non_null(ids.old_entries);
+  assert_non_null(plates_index.old_entries);
+  for (i = 0; i < 12; i++) {
+    assert_ptr_equal(slot_id_index_find(&ids, i + 1), &slots[i]);
+    assert_ptr_equal(plate_index_find(&plates_index, plates[i]), &slots[i]);
+  }
+  assert_int_equal(slot_id_index_insert(&ids, 3, &slots[2]), -2);
+  assert_int_equal(slot_id_index_relocate(&ids, 5, &slots[150]), 0);
+  assert_ptr_equal(slot_id_index_find(&ids, 5), &slots[150]);
+
+  /* 之后的写入顺带迁移，一次扩容的代价分摊到多次操作 */
+  for (i = 12; i < 200; i++) {
+    capacity = ids.capacity;
+    assert_int_equal(slot_id_index_insert(&ids, i + 1, &slots[i]), 0);
+    assert_int_equal(plate_index_insert(&plates_index, &slots[i]), 0);
+    if (ids.capacity != capacity) {
+      assert_non_null(ids.old_entries);
+    }
+  }
+  for (i = 0; i < 200; i += 2) {
+    assert_int_equal(slot_id_index_remove(&ids, i + 1), 0);
+    assert_int_equal(plate_index_remove(&plates_index, &slots[i]), 0);
+  }
+  assert_null(ids.old_entries);
+  assert_null(plates_index.old_entries);
+  assert_int_equal((int)ids.count, 100);
+  assert_int_equal((int)plates_index.count, 100);
+  for (i = 0; i < 200; i++) {
+    if (i % 2 == 0) {
+      assert_null(slot_id_index_find(&ids, i + 1));
+      assert_null(plate_index_find(&plates_index, plates[i]));
+    } else {
+      assert_non_null(slot_id_index_find(&ids, i + 1));
+      assert_ptr_equal(plate_index_find(&plates_index, plates[i]), &slots[i]);
+    }
+  }
+  slot_id_index_free(&ids);
+  plate_index_free(&plates_index);
+  free(slots);
+}
+
+/**
+ * @brief 测试停车场内存池与稠密车位表。
+ * @details
+ * 验证 `create_and_add_slot` 创建的车位来自内存池且跨越多个区块，
+ * 删除后节点被复用，`get_all_slots` 返回完整列表，
+ * 并且内存池车位与单独分配的车位可以混合存在、一并释放。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_arena(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(600);
+  ParkingSlot *deleted;
+  ParkingSlot **all;
+  int count = 0;
+  int i;
+
+  for (i = 1; i <= 600; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "ARENA"), 0);
+  }
+  assert_int_equal(create_and_add_slot(lot, 1, "ARENA"), -2);
+  assert_int_equal(lot->slot_count, 600);
+  assert_int_equal(find_slot_by_id(lot, 1)->storage, SLOT_STORAGE_ARENA);
+
+  deleted = find_slot_by_id(lot, 300);
+  assert_int_equal(delete_slot(lot, 300), 0);
+  assert_int_equal(lot->slot_count, 599);
+  assert_int_equal(create_and_add_slot(lot, 9000, "REUSED"), 0);
+  assert_ptr_equal(find_slot_by_id(lot, 9000), deleted);
+
+  assert_int_equal(add_parking_slot(lot, create_parking_slot(9001, "HEAP")), 0);
+  all = get_all_slots(lot, &count);
+  assert_non_null(all);
+  assert_int_equal(count, 601);
+  for (i = 0; i < count; i++) {
+    assert_int_equal(all[i]->table_index, i);
+  }
+  free(all);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试车牌号的整数编码与非标准车牌的回退路径。
+ * @details 验证标准车牌（含六位新能源号牌）可以无损往返、不同车牌编码不同，
+ *          非标准车牌退回哈希编码后仍能通过索引精确区分。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_plate_codec(void **state) {
+  (void)state; /* not used */
+  const char *standard[] = {"京A12345", "粤BD12345", "琼Z0000A", "新A9ZZZZ"};
+  ParkingLot *lot = init_parking_lot(4);
+  PlateCode a;
+  PlateCode b;
+  char text[PLATE_TEXT_MAX];
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    assert_int_equal(plate_encode(standard[i], &a), 1);
+    assert_int_equal(plate_decode(&a, text, sizeof(text)),
+                     (int)strlen(standard[i]));
+    assert_string_equal(text, standard[i]);
+  }
+
+  plate_encode("粤B12345", &a);
+  plate_encode("粤B12346", &b);
+  assert_false(plate_code_equal(&a, &b));
+  plate_encode("粤B1234", &b); /* 只有四位尾号，不是标准车牌 */
+  assert_false(plate_code_is_standard(&b));
+  assert_int_equal(plate_encode("粤B123450", &b), 1);
+  assert_false(plate_code_equal(&a, &b));
+  assert_int_equal(plate_encode("粤b12345", &b), 0);
+  assert_int_equal(plate_encode("使12345", &b), 0);
+  assert_int_equal(plate_encode("\xE4", &b), 0);
+  assert_int_equal(plate_decode(&b, text, sizeof(text)), -1);
+
+  /* 标准与非标准车牌混合登记，互不干扰 */
+  for (i = 1; i <= 4; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "P"), 0);
+  }
+  assert_int_equal(
+      allocate_slot(lot, 1, "甲", "粤B12345", "13800000000", RESIDENT_TYPE), 0);
+  assert_int_equal(
+      allocate_slot(lot, 2, "乙", "粤b12345", "13800000000", RESIDENT_TYPE), 0);
+  assert_int_equal(
+      allocate_slot(lot, 3, "丙", "WJ01234", "13800000000", RESIDENT_TYPE), 0);
+  assert_int_equal(
+      allocate_slot(lot, 4, "丁", "粤b12345", "13800000000", RESIDENT_TYPE),
+      -4);
+  assert_int_equal(find_slot_by_license(lot, "粤B12345")->slot_id, 1);
+  assert_int_equal(find_slot_by_license(lot, "粤b12345")->slot_id, 2);
+  assert_int_equal(find_slot_by_license(lot, "WJ01234")->slot_id, 3);
+  assert_null(find_slot_by_license(lot, "粤B1234"));
+  assert_int_equal(deallocate_slot(lot, 2), 0);
+  assert_null(find_slot_by_license(lot, "粤b12345"));
+  assert_int_equal(find_slot_by_license(lot, "粤B12345")->slot_id, 1);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试带代号的车位句柄。
+ * @details
+ * 句柄在车位换位（删除其他车位）后仍指向原车位；车位被删除后旧句柄失效，
+ * 复用同一项的新车位得到不同的代号；全零句柄与重新加载后的旧句柄都不可解析。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_handles(void **state) {
+  (void)state; /* not used */
+  const char *file = "handle_test_snapshot.bin";
+  ParkingLot *lot = init_parking_lot(100);
+  ParkingLot *loaded_lot;
+  SlotHandle handles[50];
+  SlotHandle none = {0, 0};
+  SlotHandle reused;
+  int i;
+
+  for (i = 0; i < 50; i++) {
+    assert_int_equal(create_and_add_slot(lot, i + 1, "南区"), 0);
+    handles[i] = get_slot_handle(lot, find_slot_by_id(lot, i + 1));
+    assert_int_not_equal(handles[i].generation, 0);
+  }
+  assert_null(find_slot_by_handle(lot, none));
+
+  /* 删除第 10 号车位后表尾的 50 号车位换到它的位置，句柄不受影响 */
+  assert_int_equal(delete_slot(lot, 10), 0);
+  assert_null(find_slot_by_handle(lot, handles[9]));
+  assert_int_equal(find_slot_by_handle(lot, handles[49])->slot_id, 50);
+  for (i = 0; i < 50; i++) {
+    if (i != 9) {
+      assert_int_equal(find_slot_by_handle(lot, handles[i])->slot_id, i + 1);
+    }
+  }
+
+  assert_int_equal(create_and_add_slot(lot, 99, "南区"), 0);
+  reused = get_slot_handle(lot, find_slot_by_id(lot, 99));
+  assert_int_equal(reused.index, handles[9].index);
+  assert_int_not_equal(reused.generation, handles[9].generation);
+  assert_null(find_slot_by_handle(lot, handles[9]));
+  assert_int_equal(find_slot_by_handle(lot, reused)->slot_id, 99);
+
+  assert_int_equal(save_parking_snapshot(lot, file), 0);
+  loaded_lot = load_parking_data(file);
   assert_non_null(loaded_lot);
+  assert_null(find_slot_by_handle(loaded_lot, handles[0]));
+  assert_null(find_slot_by_handle(loaded_lot, reused));
+  free_parking_lot(loaded_lot);
+  free_parking_lot(lot);
+  remove_snapshot_files(file);
+}
 
-  /* 3. 验证加载后的数据 */
-  if (loaded_lot) {
-    assert_int_equal(loaded_lot->total_slots, 5);
-    assert_int_equal(loaded_lot->occupied_slots, 1);
+/**
+ * @brief 测试大批删除车位后的内存池在线整理。
+ * @details
+ * 2000 个车位只留下每第 50 个，分步整理后区块被释放、车位表收缩；
+ * 迁移后的车位仍能按编号、句柄、车牌与子串查到，车位链表、入场时间链表
+ * 与定时器保持完整。整理中途删除进度所在的车位不影响结果，
+ * 快照进行中时整理暂停。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_compaction(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(2000);
+  ParkingMemoryStats before;
+  ParkingMemoryStats after;
+  ParkingSnapshot snapshot;
+  ParkingSlot *found[4];
+  ParkingSlot *slot;
+  SlotHandle handle;
+  char plate[MAX_LICENSE_LEN];
+  size_t timers_before;
+  int deleted_mid = 0;
+  int steps = 0;
+  int result;
+  int count;
+  int i;
 
-    ParkingSlot *loaded_slot_1 = find_slot_by_id(loaded_lot, 1);
-    assert_non_null(loaded_slot_1);
-    assert_int_equal(loaded_slot_1->status, OCCUPIED_STATUS);
-    assert_string_equal(loaded_slot_1->owner_name, "PersistentUser");
+  for (i = 1; i <= 2000; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "B2"), 0);
+  }
+  for (i = 100; i <= 2000; i += 100) {
+    sprintf(plate, "沪C%05d", i);
+    assert_int_equal(
+        allocate_slot(lot, i, "Zhao", plate, "13800000000", RESIDENT_TYPE), 0);
+  }
+  for (i = 1; i <= 2000; i++) {
+    if (i % 50 != 0) {
+      assert_int_equal(delete_slot(lot, i), 0);
+    }
+  }
+  handle = get_slot_handle(lot, find_slot_by_id(lot, 1000));
+  timers_before = lot->timers.count;
+  get_parking_memory_stats(lot, &before);
 
-    ParkingSlot *loaded_slot_2 = find_slot_by_id(loaded_lot, 2);
-    assert_non_null(loaded_slot_2);
-    assert_int_equal(loaded_slot_2->status, FREE_STATUS);
+  assert_int_equal(begin_parking_snapshot(lot, &snapshot), 0);
+  assert_int_equal(compact_parking_slots(lot, 16), -2);
+  end_parking_snapshot(lot, &snapshot);
+
+  do {
+    result = compact_parking_slots(lot, 1);
+    slot = lot->compaction.cursor;
+    if (deleted_mid == 0 && lot->compaction.phase == SLOT_COMPACT_MOVE &&
+        slot != NULL && slot->status == FREE_STATUS) {
+      deleted_mid = slot->slot_id;
+      assert_int_equal(delete_slot(lot, deleted_mid), 0);
+    }
+    steps++;
+  } while (result == 1 && steps < 100000);
+  assert_int_equal(result, 0);
+  assert_int_not_equal(deleted_mid, 0);
+  assert_true(lot->compaction.moved_slots > 0);
+  assert_true(lot->compaction.freed_chunks > 0);
+
+  get_parking_memory_stats(lot, &after);
+  assert_true(after.bytes[PARKING_MEMORY_SLOTS] <
+              before.bytes[PARKING_MEMORY_SLOTS] / 2);
+  assert_true(after.bytes[PARKING_MEMORY_TABLE] <
+              before.bytes[PARKING_MEMORY_TABLE]);
+  assert_true(lot->slot_capacity <= 2 * SLOT_COMPACT_MIN_TABLE);
+
+  for (i = 50; i <= 2000; i += 50) {
+    slot = find_slot_by_id(lot, i);
+    if (i == deleted_mid) {
+      assert_null(slot);
+      continue;
+    }
+    assert_non_null(slot);
+    assert_int_equal(slot->slot_id, i);
+    assert_ptr_equal(lot->slot_table[slot->table_index], slot);
+    if (i % 100 == 0) {
+      sprintf(plate, "沪C%05d", i);
+      assert_ptr_equal(find_slot_by_license(lot, plate), slot);
+    }
   }
+  assert_int_equal(find_slot_by_handle(lot, handle)->slot_id, 1000);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "C01000", found, 4),
+                   1);
+  assert_int_equal(found[0]->slot_id, 1000);
+  assert_int_equal(lot->timers.count, timers_before);
 
-  free_parking_lot(lot_to_save);
-  if (loaded_lot) {
-    free_parking_lot(loaded_lot);
+  count = 0;
+  for (slot = lot->slot_head; slot != NULL; slot = slot->next) {
+    count++;
+  }
+  assert_int_equal(count, lot->slot_count);
+  count = 0;
+  for (slot = lot->entry_order.oldest; slot != NULL; slot = slot->entry_next) {
+    assert_int_equal(slot->status, OCCUPIED_STATUS);
+    count++;
+  }
+  assert_int_equal(count, 20);
+  assert_ptr_equal(lot->entry_order.newest->entry_next, NULL);
+
+  assert_int_equal(deallocate_slot(lot, 1000), 0);
+  assert_null(find_slot_by_license(lot, "沪C01000"));
+  assert_int_equal(create_and_add_slot(lot, 5000, "B2"), 0);
+  assert_int_equal(compact_parking_slots(lot, 16), 0);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试车牌号索引随车辆入场/出场的同步维护。
+ * @details
+ * 验证重复车牌入场被拒绝、出场后车牌从索引中消失并可在其他车位重新入场，
+ * 以及大量车牌同时在场时仍能逐一查到。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_plate_index(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(200);
+  char plate[MAX_LICENSE_LEN];
+  int i;
+
+  for (i = 1; i <= 200; i++) {
+    add_parking_slot(lot, create_parking_slot(i, "PLT"));
+  }
+
+  assert_int_equal(allocate_slot(lot, 1, "Li Si", "沪B00001", "12312341234",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(allocate_slot(lot, 2, "Li Si", "沪B00001", "12312341234",
+                                 RESIDENT_TYPE),
+                   -4);
+  assert_ptr_equal(find_slot_by_license(lot, "沪B00001"),
+                   find_slot_by_id(lot, 1));
+
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_null(find_slot_by_license(lot, "沪B00001"));
+  assert_int_equal(allocate_slot(lot, 2, "Li Si", "沪B00001", "12312341234",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_ptr_equal(find_slot_by_license(lot, "沪B00001"),
+                   find_slot_by_id(lot, 2));
+
+  for (i = 3; i <= 200; i++) {
+    sprintf(plate, "沪C%05d", i);
+    assert_int_equal(
+        allocate_slot(lot, i, "Bulk", plate, "12312341234", RESIDENT_TYPE), 0);
+  }
+  for (i = 3; i <= 200; i += 3) {
+    deallocate_slot(lot, i);
+  }
+  for (i = 3; i <= 200; i++) {
+    ParkingSlot *found;
+    sprintf(plate, "沪C%05d", i);
+    found = find_slot_by_license(lot, plate);
+    if (i % 3 == 0) {
+      assert_null(found);
+    } else {
+      assert_non_null(found);
+      assert_int_equal(found->slot_id, i);
+    }
+  }
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试稠密车位表的热字段列。
+ * @details 验证入场、出场、删除车位（swap-remove）后热字段列与车位节点一致，
+ * 以及外部直接修改车位节点后可通过 `sync_slot_hot_fields` 同步。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_hot_table(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(100);
+  ParkingSlot *slot;
+  ParkingSlot **occupied;
+  int count = 0;
+  int i;
+
+  for (i = 1; i <= 100; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "HOT"), 0);
+  }
+  assert_int_equal(allocate_slot(lot, 10, "甲", "沪H00010", "1", RESIDENT_TYPE),
+                   0);
+  assert_int_equal(allocate_slot(lot, 100, "乙", "沪H00100", "2", RESIDENT_TYPE),
+                   0);
+
+  /* 删除第一个车位后，表尾车位被挪到下标 0，其热字段也应随之移动 */
+  assert_int_equal(delete_slot(lot, 1), 0);
+  slot = find_slot_by_id(lot, 100);
+  assert_int_equal(slot->table_index, 0);
+  assert_int_equal(lot->hot.slot_id[0], 100);
+  assert_int_equal(lot->hot.status[0], OCCUPIED_STATUS);
+  assert_true(lot->hot.entry_time[0] == slot->entry_time);
+
+  occupied = get_occupied_slots(lot, &count);
+  assert_int_equal(count, 2);
+  free(occupied);
+  assert_int_equal(count_daily_parking(lot, time(NULL), RESIDENT_TYPE), 2);
+
+  assert_int_equal(deallocate_slot(lot, 10), 0);
+  slot = find_slot_by_id(lot, 10);
+  assert_int_equal(lot->hot.status[slot->table_index], FREE_STATUS);
+
+  /* 外部直接修改车位节点后需显式同步 */
+  slot->resident_due_date = 12345;
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  assert_true(lot->hot.due_date[slot->table_index] == 12345);
+  assert_int_equal(sync_slot_hot_fields(lot, NULL), -1);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试停车场计数器的增量维护。
+ * @details
+ * 验证入场、出场、删除车位、外部修改后同步以及保存/加载之后，
+ * 空闲数、占用数和按类型的占用数始终与车位实际状态一致。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_counters(void **state) {
+  (void)state; /* not used */
+  const char *test_file = "counters_test.txt";
+  ParkingLot *lot = init_parking_lot(5);
+  ParkingLot *loaded_lot;
+  ParkingSlot *slot;
+  ParkingSlot **list;
+  int count = 0;
+  int i;
+
+  for (i = 1; i <= 5; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "CNT"), 0);
+  }
+  assert_int_equal(lot->free_slot_count, 5);
+
+  assert_int_equal(allocate_slot(lot, 1, "甲", "沪K00001", "1", RESIDENT_TYPE),
+                   0);
+  assert_int_equal(allocate_slot(lot, 2, "乙", "沪K00002", "2", RESIDENT_TYPE),
+                   0);
+
+  /* 绕过访客时段检查，直接改写车位后同步 */
+  slot = find_slot_by_id(lot, 3);
+  slot->status = OCCUPIED_STATUS;
+  slot->type = VISITOR_TYPE;
+  slot->entry_time = time(NULL);
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+
+  assert_int_equal(lot->free_slot_count, 2);
+  assert_int_equal(lot->occupied_slots, 3);
+  assert_int_equal(lot->occupied_resident_count, 2);
+  assert_int_equal(lot->occupied_visitor_count, 1);
+
+  list = get_free_slots(lot, &count);
+  assert_int_equal(count, 2);
+  for (i = 0; i < count; i++) {
+    assert_int_equal(list[i]->status, FREE_STATUS);
   }
+  free(list);
+
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_int_equal(delete_slot(lot, 1), 0);
+  assert_int_equal(lot->free_slot_count, 2);
+  assert_int_equal(lot->occupied_resident_count, 1);
+
+  assert_int_equal(save_parking_data(lot, test_file), 0);
+  loaded_lot = load_parking_data(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->free_slot_count, 2);
+  assert_int_equal(loaded_lot->occupied_slots, 2);
+  assert_int_equal(loaded_lot->occupied_resident_count, 1);
+  assert_int_equal(loaded_lot->occupied_visitor_count, 1);
+
+  free_parking_lot(loaded_lot);
+  free_parking_lot(lot);
   remove(test_file);
 }
 
-/* ========================================================================== */
-/*                                 主测试函数                                 */
-/* ========================================================================== */
+/**
+ * @brief 测试按入场时间排列的在场车位链表。
+ * @details
+ * 验证乱序入场时链表仍按入场时间排列、修改入场时间并同步后重新定位、
+ * 出场时摘除节点，以及 get_slots_by_duration 的两种顺序。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_entry_order(void **state) {
+  (void)state; /* not used */
+  static const time_t entries[5] = {5000, 1000, 3000, 4000, 2000};
+  ParkingLot *lot = init_parking_lot(5);
+  ParkingSlot *top[5];
+  ParkingSlot **list;
+  ParkingSlot *slot;
+  int count = 0;
+  int i;
+
+  for (i = 1; i <= 5; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "ORD"), 0);
+    slot = find_slot_by_id(lot, i);
+    slot->status = OCCUPIED_STATUS;
+    slot->entry_time = entries[i - 1];
+    assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  }
+
+  /* 停得最久的依次为 2、5、3 */
+  assert_int_equal(get_slots_by_entry_order(lot, top, 3, 1), 3);
+  assert_int_equal(top[0]->slot_id, 2);
+  assert_int_equal(top[1]->slot_id, 5);
+  assert_int_equal(top[2]->slot_id, 3);
+
+  /* 最近入场的为 1 */
+  assert_int_equal(get_slots_by_entry_order(lot, top, 1, 0), 1);
+  assert_int_equal(top[0]->slot_id, 1);
+
+  /* 修改入场时间后重新定位 */
+  slot = find_slot_by_id(lot, 1);
+  slot->entry_time = 500;
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  assert_int_equal(get_slots_by_entry_order(lot, top, 1, 1), 1);
+  assert_int_equal(top[0]->slot_id, 1);
+
+  /* 出场会摘除节点，之后删除空闲车位不影响链表 */
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_int_equal(deallocate_slot(lot, 4), 0);
+  assert_int_equal(delete_slot(lot, 4), 0);
+  assert_int_equal(lot->entry_order.count, 3);
+
+  list = get_slots_by_duration(lot, &count, 1);
+  assert_int_equal(count, 3);
+  assert_int_equal(list[0]->slot_id, 3);
+  assert_int_equal(list[1]->slot_id, 5);
+  assert_int_equal(list[2]->slot_id, 2);
+  free(list);
+
+  list = get_slots_by_duration(lot, &count, 0);
+  assert_int_equal(count, 3);
+  assert_int_equal(list[0]->slot_id, 2);
+  assert_int_equal(list[2]->slot_id, 3);
+  free(list);
+
+  free_parking_lot(lot);
+}
 
 /**
- * @brief 测试程序的主入口。
- * @details 注册所有单元测试用例并使用 cmocka 框架运行它们。
- * @return 返回 cmocka 测试组的执行结果。
+ * @brief 测试按日、按月累计的入场计数。
+ * @details
+ * 验证出场后入场计数保留、按类型分别计数，
+ * 以及修正已占用车位的入场时间后计数移到新的日期。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_entry_histogram(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(4);
+  ParkingSlot *slot;
+  time_t now = time(NULL);
+  time_t earlier = now - 40 * 24 * 3600;
+  struct tm *local;
+  int year;
+  int month;
+  int i;
+
+  for (i = 1; i <= 3; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "HIS"), 0);
+  }
+  assert_int_equal(allocate_slot(lot, 1, "甲", "沪M00001", "1", RESIDENT_TYPE),
+                   0);
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_int_equal(allocate_slot(lot, 1, "乙", "沪M00002", "2", RESIDENT_TYPE),
+                   0);
+
+  slot = find_slot_by_id(lot, 2);
+  slot->status = OCCUPIED_STATUS;
+  slot->type = VISITOR_TYPE;
+  slot->entry_time = now;
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+
+  assert_int_equal(count_daily_parking(lot, now, RESIDENT_TYPE), 2);
+  assert_int_equal(count_daily_parking(lot, now, VISITOR_TYPE), 1);
+
+  /* 修正入场时间后，计数从今天移到 40 天前 */
+  slot->entry_time = earlier;
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  assert_int_equal(count_daily_parking(lot, now, VISITOR_TYPE), 0);
+  assert_int_equal(count_daily_parking(lot, earlier, VISITOR_TYPE), 1);
+
+  local = localtime(&earlier);
+  year = local->tm_year + 1900;
+  month = local->tm_mon + 1;
+  assert_int_equal(count_monthly_parking(lot, year, month, VISITOR_TYPE), 1);
+  assert_int_equal(count_monthly_parking(lot, year, 13, VISITOR_TYPE), -1);
+  assert_int_equal(count_daily_parking(NULL, now, VISITOR_TYPE), -1);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试日历缓存的日期换算与访客时段判断。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_calendar_cache(void **state) {
+  (void)state; /* not used */
+  ParkingCalendar calendar;
+  struct tm moment;
+  time_t now = time(NULL);
+  time_t open_time;
+  time_t close_time;
+  long day;
+  long month;
+  long expected_day;
+  long expected_month;
+
+  parking_calendar_init(&calendar, VISITOR_START_HOUR, VISITOR_END_HOUR);
+  parking_calendar_lookup(&calendar, now, &day, &month);
+  parking_calendar_convert(now, &expected_day, &expected_month);
+  assert_true(day == expected_day);
+  assert_true(month == expected_month);
+  assert_true(calendar.day_start <= now && now < calendar.day_end);
+
+  /* 早于缓存日期的查询不替换缓存 */
+  parking_calendar_lookup(&calendar, now - 3 * 24 * 3600, &day, NULL);
+  parking_calendar_convert(now - 3 * 24 * 3600, &expected_day, NULL);
+  assert_true(day == expected_day);
+  assert_true(calendar.day_start <= now && now < calendar.day_end);
+
+  moment = *localtime(&now);
+  moment.tm_hour = VISITOR_START_HOUR;
+  moment.tm_min = 0;
+  moment.tm_sec = 0;
+  moment.tm_isdst = -1;
+  open_time = mktime(&moment);
+  moment = *localtime(&now);
+  moment.tm_hour = VISITOR_END_HOUR;
+  moment.tm_min = 0;
+  moment.tm_sec = 0;
+  moment.tm_isdst = -1;
+  close_time = mktime(&moment);
+  assert_false(parking_calendar_in_window(&calendar, open_time - 1));
+  assert_true(parking_calendar_in_window(&calendar, open_time));
+  assert_true(parking_calendar_in_window(&calendar, close_time - 1));
+  assert_false(parking_calendar_in_window(&calendar, close_time));
+
+  /* 定时器使用的边界：当日允许时段结束后顺延到次日 */
+  assert_true(parking_calendar_next_window_end(&calendar, open_time) ==
+              close_time);
+  assert_true(parking_calendar_next_window_end(&calendar, close_time) >
+              close_time + 23 * 3600);
+  assert_true(parking_calendar_next_day(&calendar, open_time) ==
+              calendar.day_end);
+}
+
+/**
+ * @brief `test_slot_iteration` 使用的遍历回调，累计车位编号之和。
+ * @param slot 当前车位。
+ * @param ctx 指向累计值（int）的指针。
+ * @return 编号之和超过 100 后返回 1 以停止遍历。
+ */
+static int sum_slot_ids(ParkingSlot *slot, void *ctx) {
+  int *sum = (int *)ctx;
+  *sum += slot->slot_id;
+  return *sum > 100;
+}
+
+/**
+ * @brief 测试车位游标与 `parking_lot_foreach` 遍历接口。
+ * @details
+ * 验证游标按筛选条件返回正确的车位、计数与计数器一致，
+ * 以及回调返回非 0 时遍历提前停止。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_iteration(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(20);
+  SlotCursor cursor;
+  ParkingSlot *slot;
+  int seen = 0;
+  int sum = 0;
+  int i;
+
+  for (i = 1; i <= 20; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "ITER"), 0);
+  }
+  for (i = 2; i <= 20; i += 2) {
+    char plate[16];
+    sprintf(plate, "沪I%05d", i);
+    assert_int_equal(allocate_slot(lot, i, "偶数", plate, "1", RESIDENT_TYPE),
+                     0);
+  }
+
+  slot_cursor_init(&cursor, lot, SLOT_FILTER_OCCUPIED);
+  while ((slot = slot_cursor_next(&cursor)) != NULL) {
+    assert_int_equal(slot->slot_id % 2, 0);
+    seen++;
+  }
+  assert_int_equal(seen, count_slots(lot, SLOT_FILTER_OCCUPIED));
+  assert_null(slot_cursor_next(&cursor));
+
+  assert_int_equal(parking_lot_foreach(lot, SLOT_FILTER_FREE, sum_slot_ids,
+                                       &sum),
+                   10);
+  assert_int_equal(sum, 100); /* 1+3+...+19 */
+
+  sum = 0;
+  assert_true(parking_lot_foreach(lot, SLOT_FILTER_ALL, sum_slot_ids, &sum) <
+              20);
+  assert_true(sum > 100);
+  assert_int_equal(parking_lot_foreach(lot, SLOT_FILTER_ALL, NULL, NULL), -1);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试分页读取与游标定位。
+ * @details
+ * 车位数跨过多个位图字，逐页读取的结果应与游标完整遍历的顺序一致，
+ * 超出范围的 offset 返回 0。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_paging(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(150);
+  ParkingSlot *expected[151];
+  ParkingSlot *page[7];
+  SlotCursor cursor;
+  SlotFilter filter;
+  int total;
+  int offset;
+  int count;
+  int i;
+
+  for (i = 1; i <= 150; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "PAGE"), 0);
+  }
+  for (i = 3; i <= 150; i += 3) {
+    char plate[16];
+    sprintf(plate, "沪P%05d", i);
+    assert_int_equal(allocate_slot(lot, i, "分页", plate, "1", RESIDENT_TYPE),
+                     0);
+  }
+
+  for (filter = SLOT_FILTER_ALL; filter <= SLOT_FILTER_OCCUPIED; filter++) {
+    total = 0;
+    slot_cursor_init(&cursor, lot, filter);
+    while ((expected[total] = slot_cursor_next(&cursor)) != NULL) {
+      total++;
+    }
+    for (offset = 0; offset < total; offset += 7) {
+      count = get_slots_page(lot, filter, offset, page, 7);
+      assert_int_equal(count, total - offset < 7 ? total - offset : 7);
+      for (i = 0; i < count; i++) {
+        assert_ptr_equal(page[i], expected[offset + i]);
+      }
+    }
+    assert_int_equal(get_slots_page(lot, filter, total, page, 7), 0);
+    assert_int_equal(get_slots_page(lot, filter, -1, page, 7), 0);
+  }
+  assert_int_equal(count_slots(lot, SLOT_FILTER_OCCUPIED), 50);
+
+  slot_cursor_init(&cursor, lot, SLOT_FILTER_OCCUPIED);
+  assert_int_equal(slot_cursor_seek(&cursor, 49), 0);
+  assert_int_equal(slot_cursor_next(&cursor)->slot_id, 150);
+  assert_int_equal(slot_cursor_seek(&cursor, 50), -1);
+  assert_null(slot_cursor_next(&cursor));
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试大停车场的并行组合查询。
+ * @details 七万个车位分成 A、B 两区，每 3 个车位占用一个，其中编号为
+ *          5 的倍数的是访客。对几种条件组合比较并行与串行执行的结果，
+ *          要求命中数、车位与顺序完全相同，包括结果数组装不下的情况。
+ * @param state cmocka 框架的测试状态指针。
  */
+static void test_parallel_query(void **state) {
+  const int total = 70000;
+  ParkingLot *lot = init_parking_lot(total);
+  ParkingTaskPool *pool = parking_task_pool_create(3);
+  ParkingSlot **serial;
+  ParkingSlot **parallel;
+  SlotQuery queries[4];
+  ParkingSlot *slot;
+  char plate[16];
+  int expected;
+  int q;
+  int i;
+
+  (void)state; /* not used */
+  assert_non_null(pool);
+  for (i = 1; i <= total; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, i % 2 ? "A-区" : "B-区"), 0);
+    if (i % 3 == 0) {
+      sprintf(plate, "粤B%05d", i);
+      assert_int_equal(
+          allocate_slot(lot, i, "并行", plate, "13700000000", RESIDENT_TYPE),
+          0);
+      if (i % 5 == 0) {
+        /* 绕过访客时段检查，直接改写车位后同步 */
+        slot = find_slot_by_id(lot, i);
+        slot->type = VISITOR_TYPE;
+        assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+      }
+    }
+  }
+  for (q = 0; q < 4; q++) {
+    slot_query_init(&queries[q]);
+  }
+  slot_query_where_status(&queries[0], OCCUPIED_STATUS);
+  slot_query_where_type(&queries[1], VISITOR_TYPE);
+  slot_query_where_status(&queries[2], FREE_STATUS);
+  slot_query_where_location(&queries[2], "B-");
+  slot_query_where_location(&queries[3], "A-");
+
+  serial = (ParkingSlot **)malloc((size_t)total * sizeof(ParkingSlot *));
+  parallel = (ParkingSlot **)malloc((size_t)total * sizeof(ParkingSlot *));
+  assert_non_null(serial);
+  assert_non_null(parallel);
+  for (q = 0; q < 4; q++) {
+    expected = query_slots(lot, &queries[q], serial, total);
+    assert_true(expected > 0);
+    assert_int_equal(count_query_slots_parallel(lot, &queries[q], pool),
+                     expected);
+    assert_int_equal(
+        query_slots_parallel(lot, &queries[q], parallel, total, pool),
+        expected);
+    assert_memory_equal(parallel, serial,
+                        (size_t)expected * sizeof(ParkingSlot *));
+    /* 容量不足时截断，保留的仍是前面那些车位 */
+    assert_int_equal(
+        query_slots_parallel(lot, &queries[q], parallel, expected / 2, pool),
+        expected / 2);
+    assert_memory_equal(parallel, serial,
+                        (size_t)(expected / 2) * sizeof(ParkingSlot *));
+  }
+  assert_int_equal(count_query_slots_parallel(lot, &queries[0], NULL),
+                   total / 3);
+  assert_int_equal(count_query_slots_parallel(NULL, &queries[0], pool), -1);
+
+  free(serial);
+  free(parallel);
+  parking_task_pool_destroy(pool);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试车位预约与按时段查询空位。
+ * @details C 区为 1、2 号车位，D 区为 3 号车位，时间源为虚拟时钟。
+ *          验证同一车位的预约不能重叠、分区查询跳过已预约车位、
+ *          预约开始前的保留期内其他车辆不能入场而自动选位会跳过，
+ *          以及预约的车辆入场后预约即兑现。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_reservations(void **state) {
+  ParkingLot *lot = init_parking_lot(10);
+  const time_t base = 1700000000;
+  Reservation first;
+  Reservation zone;
+
+  (void)state; /* not used */
+  assert_int_equal(configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, base),
+                   0);
+  assert_int_equal(create_and_add_slot(lot, 1, "C-01"), 0);
+  assert_int_equal(create_and_add_slot(lot, 2, "C-02"), 0);
+  assert_int_equal(create_and_add_slot(lot, 3, "D-01"), 0);
+
+  assert_int_equal(
+      reserve_slot(lot, 1, "粤B00001", base + 3600, base + 7200, &first), 0);
+  assert_true(first.id > 0);
+  assert_int_equal(first.slot_id, 1);
+  assert_int_equal(reserve_slot(lot, 1, "粤B00002", base + 5000, base + 9000,
+                                NULL),
+                   -3);
+  assert_int_equal(reserve_slot(lot, 1, "粤B00002", base + 7200, base + 9000,
+                                NULL),
+                   0);
+  assert_int_equal(reserve_slot(lot, 1, "粤B00002", base + 10, base + 10, NULL),
+                   -1);
+  assert_int_equal(reserve_slot(lot, 1, "粤B00002", base - 60, base, NULL), -1);
+  assert_int_equal(reserve_slot(lot, 99, "粤B00002", base + 10, base + 20,
+                                NULL),
+                   -2);
+
+  /* 分区查询跳过已预约的车位 */
+  assert_ptr_equal(find_available_slot(lot, "C-", base + 3600, base + 7200),
+                   find_slot_by_id(lot, 2));
+  assert_int_equal(count_available_slots(lot, "C-", base + 3600, base + 7200),
+                   1);
+  assert_int_equal(count_available_slots(lot, NULL, base, base + 60), 3);
+  assert_int_equal(reserve_zone_slot(lot, "C-", "粤B00003", base + 3000,
+                                     base + 4000, &zone),
+                   0);
+  assert_int_equal(zone.slot_id, 2);
+  assert_null(find_available_slot(lot, "C-", base + 3600, base + 7200));
+  assert_int_equal(reserve_zone_slot(lot, "C-", "粤B00004", base + 3600,
+                                     base + 3700, NULL),
+                   -2);
+  assert_ptr_equal(find_available_slot(lot, "D-", base + 3600, base + 7200),
+                   find_slot_by_id(lot, 3));
+
+  /* 保留期之前可以照常停车 */
+  assert_int_equal(
+      allocate_slot(lot, 1, "路人", "粤B00009", "13700000000", RESIDENT_TYPE),
+      0);
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+
+  /* 进入保留期后只有预约的车辆能停入，自动选位跳过保留的车位 */
+  assert_int_equal(set_parking_clock(lot, base + 3000), 0);
+  assert_int_equal(
+      allocate_slot(lot, 1, "路人", "粤B00009", "13700000000", RESIDENT_TYPE),
+      -7);
+  assert_ptr_equal(find_first_free_slot(lot), find_slot_by_id(lot, 3));
+  assert_int_equal(
+      allocate_slot(lot, 1, "车主", "粤B00001", "13700000000", RESIDENT_TYPE),
+      0);
+  assert_int_equal(cancel_reservation(lot, 1, first.id), -2);
+
+  /* 时段已经开始的占用车位不能预约，之后的时段可以 */
+  assert_int_equal(reserve_slot(lot, 1, "粤B00005", base + 3000, base + 3500,
+                                NULL),
+                   -3);
+  assert_int_equal(reserve_slot(lot, 1, "粤B00005", base + 20000,
+                                base + 21000, NULL),
+                   0);
+
+  assert_int_equal(cancel_reservation(lot, zone.slot_id, zone.id), 0);
+  assert_int_equal(cancel_reservation(lot, zone.slot_id, zone.id), -2);
+  assert_int_equal(
+      allocate_slot(lot, 2, "路人", "粤B00009", "13700000000", RESIDENT_TYPE),
+      0);
+  assert_int_equal(delete_slot(lot, 3), 0);
+  assert_null(find_available_slot(NULL, "C-", base, base + 60));
+  assert_int_equal(count_available_slots(lot, "C-", base + 60, base), -1);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief (测试辅助函数) 逐个比较，找出离某一点最近的空闲车位。
+ * @param lot 目标停车场，车位编号为 1..count。
+ * @param count 车位数。
+ * @param x 横坐标。
+ * @param y 纵坐标。
+ * @return 最近空闲车位的编号（距离相同取编号较小者），没有时返回 0。
+ */
+static int brute_nearest_free(ParkingLot *lot, int count, long x, long y) {
+  long best = -1;
+  int best_id = 0;
+  int id;
+
+  for (id = 1; id <= count; id++) {
+    ParkingSlot *slot = find_slot_by_id(lot, id);
+    long px;
+    long py;
+    long d;
+
+    if (slot == NULL || slot->status != FREE_STATUS ||
+        get_slot_position(lot, id, &px, &py) != 0) {
+      continue;
+    }
+    d = (px - x) * (px - x) + (py - y) * (py - y);
+    if (best < 0 || d < best) {
+      best = d;
+      best_id = id;
+    }
+  }
+  return best_id;
+}
+
+/**
+ * @brief 测试按平面坐标查找最近的空闲车位。
+ * @details 400 个车位排成间距 10 的 20×20 网格，在占用、释放、删除车位
+ *          与清除坐标之后，与逐个比较的结果对照；并验证地标查找
+ *          与预约保留期内的车位被跳过。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_layout(void **state) {
+  ParkingLot *lot = init_parking_lot(400);
+  const time_t base = 1700000000;
+  char location[16];
+  char plate[16];
+  Reservation reservation;
+  long x;
+  long y;
+  int i;
+
+  (void)state; /* not used */
+  assert_int_equal(configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, base),
+                   0);
+  assert_null(find_nearest_free_slot(lot, 0, 0));
+  for (i = 1; i <= 400; i++) {
+    sprintf(location, "A-%03d", i);
+    assert_int_equal(create_and_add_slot(lot, i, location), 0);
+    assert_int_equal(set_slot_position(lot, i, (long)((i - 1) % 20) * 10,
+                                       (long)((i - 1) / 20) * 10),
+                     0);
+  }
+  assert_int_equal(set_slot_position(lot, 999, 0, 0), -2);
+  assert_int_equal(set_slot_position(NULL, 1, 0, 0), -1);
+  assert_int_equal(get_slot_position(lot, 21, &x, &y), 0);
+  assert_true(x == 0 && y == 10);
+  assert_true(slot_layout_stale(lot));
+  assert_int_equal(refresh_slot_layout(lot), 0);
+  assert_false(slot_layout_stale(lot));
+
+  assert_ptr_equal(find_nearest_free_slot(lot, 0, 0), find_slot_by_id(lot, 1));
+  assert_ptr_equal(find_nearest_free_slot(lot, 192, 188),
+                   find_slot_by_id(lot, 400));
+
+  /* 占用约三分之二的车位后逐点对照 */
+  for (i = 1; i <= 400; i++) {
+    if (i % 3 != 0) {
+      sprintf(plate, "粤B%05d", i);
+      assert_int_equal(allocate_slot(lot, i, "车主", plate, "13700000000",
+                                     RESIDENT_TYPE),
+                       0);
+    }
+  }
+  assert_false(slot_layout_stale(lot));
+  for (i = 0; i < 50; i++) {
+    long px = (long)((i * 37) % 211) - 5;
+    long py = (long)((i * 53) % 207) - 3;
+    ParkingSlot *slot = find_nearest_free_slot(lot, px, py);
+
+    assert_non_null(slot);
+    assert_int_equal(slot->slot_id, brute_nearest_free(lot, 400, px, py));
+  }
+
+  /* 释放车位后结果随之变化 */
+  assert_ptr_equal(find_nearest_free_slot(lot, 0, 0), find_slot_by_id(lot, 21));
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_ptr_equal(find_nearest_free_slot(lot, 0, 0), find_slot_by_id(lot, 1));
+
+  /* 地标 */
+  assert_int_equal(set_parking_landmark(lot, "电梯", 100, 100), 0);
+  assert_int_equal(set_parking_landmark(lot, "", 0, 0), -1);
+  assert_int_equal(find_nearest_free_slot_to(lot, "电梯")->slot_id,
+                   brute_nearest_free(lot, 400, 100, 100));
+  assert_null(find_nearest_free_slot_to(lot, "入口"));
+
+  /* 预约保留期内的车位被跳过 */
+  assert_int_equal(reserve_slot(lot, 1, "粤B99999", base + 600, base + 3600,
+                                &reservation),
+                   0);
+  assert_ptr_equal(find_nearest_free_slot(lot, 0, 0), find_slot_by_id(lot, 21));
+  assert_int_equal(cancel_reservation(lot, 1, reservation.id), 0);
+  assert_ptr_equal(find_nearest_free_slot(lot, 0, 0), find_slot_by_id(lot, 1));
+
+  /* 删除车位与清除坐标 */
+  assert_int_equal(delete_slot(lot, 21), 0);
+  assert_int_equal(get_slot_position(lot, 21, &x, &y), -2);
+  assert_int_equal(clear_slot_position(lot, 1), 0);
+  assert_int_equal(clear_slot_position(lot, 1), -2);
+  assert_ptr_equal(find_nearest_free_slot(lot, 0, 0), find_slot_by_id(lot, 3));
+  assert_int_equal(set_slot_position(lot, 1, 0, 0), 0);
+  assert_ptr_equal(find_nearest_free_slot(lot, 0, 0), find_slot_by_id(lot, 1));
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief (测试辅助函数) 记录分区计数变化的通知。
+ */
+typedef struct {
+  int calls;             /**< 收到的通知数。 */
+  ParkingZoneStats last; /**< 最后一次通知的计数。 */
+} ZoneNotices;
+
+/**
+ * @brief (测试辅助函数) 分区处理函数，把通知记入 ZoneNotices。
+ * @param lot 计数变化的停车场。
+ * @param stats 变化后的分区计数。
+ * @param ctx 指向 ZoneNotices 的指针。
+ */
+static void record_zone_notice(ParkingLot *lot, const ParkingZoneStats *stats,
+                               void *ctx) {
+  ZoneNotices *notices = (ZoneNotices *)ctx;
+
+  (void)lot;
+  notices->calls++;
+  notices->last = *stats;
+}
+
+/**
+ * @brief 测试按位置前缀增量维护的分区空位计数。
+ * @details A 区 3 个车位、B1 区 2 个车位。验证登记时的初始计数、
+ *          入场出场、车位加入删除与修改位置后的计数，以及变化通知。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_zone_stats(void **state) {
+  ParkingLot *lot = init_parking_lot(10);
+  ZoneNotices notices;
+  ParkingZoneStats stats;
+  ParkingZoneStats all[4];
+
+  (void)state; /* not used */
+  memset(&notices, 0, sizeof(notices));
+  assert_int_equal(create_and_add_slot(lot, 1, "A-01"), 0);
+  assert_int_equal(create_and_add_slot(lot, 2, "A-02"), 0);
+  assert_int_equal(create_and_add_slot(lot, 3, "A-03"), 0);
+  assert_int_equal(create_and_add_slot(lot, 4, "B1-01"), 0);
+  assert_int_equal(
+      allocate_slot(lot, 1, "车主", "粤B00001", "13700000000", RESIDENT_TYPE),
+      0);
+
+  assert_int_equal(get_parking_zone_stats(lot, "A-", &stats), -2);
+  assert_int_equal(add_parking_zone(lot, "A-"), 0);
+  assert_int_equal(add_parking_zone(lot, "B1-"), 0);
+  assert_int_equal(add_parking_zone(lot, "A-"), 0);
+  assert_int_equal(add_parking_zone(lot, ""), -1);
+  assert_int_equal(get_parking_zone_stats(lot, "A-", &stats), 0);
+  assert_string_equal(stats.zone, "A-");
+  assert_int_equal(stats.total_slots, 3);
+  assert_int_equal(stats.free_slots, 2);
+  assert_int_equal(stats.occupied_slots, 1);
+
+  /* 入场出场与车位加入都会通知所在分区 */
+  set_parking_zone_handler(lot, record_zone_notice, &notices);
+  assert_int_equal(
+      allocate_slot(lot, 2, "车主", "粤B00002", "13700000000", RESIDENT_TYPE),
+      0);
+  assert_int_equal(notices.calls, 1);
+  assert_string_equal(notices.last.zone, "A-");
+  assert_int_equal(notices.last.free_slots, 1);
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_int_equal(notices.calls, 2);
+  assert_int_equal(notices.last.free_slots, 2);
+  assert_int_equal(create_and_add_slot(lot, 5, "B1-02"), 0);
+  assert_int_equal(notices.calls, 3);
+  assert_string_equal(notices.last.zone, "B1-");
+  assert_int_equal(notices.last.total_slots, 2);
+
+  /* 修改位置时车位换到新分区，同一分区内改名不通知 */
+  assert_int_equal(update_slot_info_in_lot(lot, 3, "A-09", NULL, NULL), 0);
+  assert_int_equal(notices.calls, 3);
+  assert_int_equal(update_slot_info_in_lot(lot, 3, "B1-03", NULL, NULL), 0);
+  assert_int_equal(notices.calls, 5);
+  assert_int_equal(get_parking_zone_stats(lot, "A-", &stats), 0);
+  assert_int_equal(stats.total_slots, 2);
+  assert_int_equal(stats.free_slots, 1);
+  assert_int_equal(get_parking_zone_stats(lot, "B1-", &stats), 0);
+  assert_int_equal(stats.total_slots, 3);
+  assert_int_equal(stats.free_slots, 3);
+
+  assert_int_equal(delete_slot(lot, 4), 0);
+  assert_int_equal(list_parking_zone_stats(lot, all, 4), 2);
+  assert_string_equal(all[1].zone, "B1-");
+  assert_int_equal(all[1].total_slots, 2);
+  assert_int_equal(all[1].free_slots, 2);
+  assert_int_equal(all[0].occupied_slots, 1);
+  assert_int_equal(list_parking_zone_stats(lot, NULL, 0), 2);
+
+  assert_int_equal(remove_parking_zone(lot, "A-"), 0);
+  assert_int_equal(remove_parking_zone(lot, "A-"), -2);
+  assert_int_equal(list_parking_zone_stats(lot, all, 4), 1);
+  assert_string_equal(all[0].zone, "B1-");
+  set_parking_zone_handler(lot, NULL, NULL);
+  assert_int_equal(
+      allocate_slot(lot, 5, "车主", "粤B00005", "13700000000", RESIDENT_TYPE),
+      0);
+  assert_int_equal(notices.calls, 6);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试车位变更订阅。
+ * @details 两个订阅者分别以大、小队列订阅。验证各类修改按顺序产生
+ *          连续编号的事件，小队列满时丢弃新事件并计数，
+ *          撤销订阅后不再投递。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_change_feed(void **state) {
+  ParkingLot *lot = init_parking_lot(10);
+  const time_t base = 1700000000;
+  struct ChangeSubscription *all;
+  struct ChangeSubscription *tiny;
+  ParkingChange changes[16];
+  int count;
+
+  (void)state; /* not used */
+  assert_int_equal(configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, base),
+                   0);
+  assert_int_equal(create_and_add_slot(lot, 1, "A-01"), 0);
+  all = subscribe_slot_changes(lot, 0);
+  tiny = subscribe_slot_changes(lot, 2);
+  assert_non_null(all);
+  assert_non_null(tiny);
+  assert_int_equal(poll_slot_changes(all, changes, 16), 0);
+
+  assert_int_equal(create_and_add_slot(lot, 2, "A-02"), 0);
+  assert_int_equal(
+      allocate_slot(lot, 2, "车主", "粤B00001", "13700000000", RESIDENT_TYPE),
+      0);
+  assert_int_equal(update_slot_info_in_lot(lot, 2, NULL, "新车主", NULL), 0);
+  assert_int_equal(set_parking_clock(lot, base + 600), 0);
+  assert_int_equal(deallocate_slot(lot, 2), 0);
+  assert_int_equal(delete_slot(lot, 1), 0);
+
+  count = poll_slot_changes(all, changes, 3);
+  assert_int_equal(count, 3);
+  assert_int_equal(changes[0].kind, PARKING_CHANGE_ADD_SLOT);
+  assert_int_equal(changes[0].slot_id, 2);
+  assert_int_equal(changes[0].status, FREE_STATUS);
+  assert_int_equal(changes[1].kind, PARKING_CHANGE_ALLOCATE);
+  assert_int_equal(changes[1].status, OCCUPIED_STATUS);
+  assert_int_equal(changes[1].type, RESIDENT_TYPE);
+  assert_true(changes[1].when == base);
+  assert_int_equal(changes[2].kind, PARKING_CHANGE_UPDATE_INFO);
+  assert_true(changes[1].seq + 1 == changes[2].seq);
+  count = poll_slot_changes(all, changes, 16);
+  assert_int_equal(count, 2);
+  assert_int_equal(changes[0].kind, PARKING_CHANGE_DEALLOCATE);
+  assert_int_equal(changes[0].status, FREE_STATUS);
+  assert_true(changes[0].when == base + 600);
+  assert_int_equal(changes[1].kind, PARKING_CHANGE_DELETE_SLOT);
+  assert_int_equal(changes[1].slot_id, 1);
+  assert_int_equal(take_dropped_slot_changes(all), 0);
+
+  /* 容量 2 的队列向上取整为 4 格，可存放 3 个事件 */
+  assert_int_equal(poll_slot_changes(tiny, changes, 16), 3);
+  assert_int_equal(changes[2].kind, PARKING_CHANGE_UPDATE_INFO);
+  assert_int_equal(take_dropped_slot_changes(tiny), 2);
+  assert_int_equal(take_dropped_slot_changes(tiny), 0);
+
+  assert_int_equal(unsubscribe_slot_changes(lot, tiny), 0);
+  assert_int_equal(unsubscribe_slot_changes(lot, tiny), -2);
+  assert_int_equal(create_and_add_slot(lot, 3, "A-03"), 0);
+  assert_int_equal(poll_slot_changes(all, changes, 16), 1);
+  assert_int_equal(changes[0].slot_id, 3);
+  assert_int_equal(poll_slot_changes(NULL, changes, 16), -1);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试组合条件查询。
+ * @details
+ * A 区为 1～50 号、B 区为 51～100 号车位，每 4 个车位占用一个，
+ * 其中编号为 8 的倍数的是访客，其余是带到期时间的居民。
+ * 分别验证列扫描与入场时间链表两种执行方式的结果与顺序。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_query(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(100);
+  ParkingSlot *found[100];
+  ParkingSlot *slot;
+  SlotQuery query;
+  char location[16];
+  int i;
+
+  for (i = 1; i <= 100; i++) {
+    sprintf(location, "%c-%02d", i <= 50 ? 'A' : 'B', i);
+    assert_int_equal(create_and_add_slot(lot, i, location), 0);
+    if (i % 4 == 0) {
+      slot = find_slot_by_id(lot, i);
+      slot->status = OCCUPIED_STATUS;
+      slot->type = i % 8 == 0 ? VISITOR_TYPE : RESIDENT_TYPE;
+      slot->entry_time = (time_t)(1000 * i);
+      slot->resident_due_date = i % 8 == 0 ? 0 : (time_t)(100 * i);
+      assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+    }
+  }
+
+  /* B 区 80000 之前入场的访客：56、64、72，按入场时间排列 */
+  slot_query_init(&query);
+  slot_query_where_status(&query, OCCUPIED_STATUS);
+  slot_query_where_type(&query, VISITOR_TYPE);
+  slot_query_where_location(&query, "B-");
+  slot_query_where_entry(&query, 0, 80000);
+  assert_int_equal(query_slots_bound(lot, &query), 12);
+  assert_int_equal(query_slots(lot, &query, found, 100), 3);
+  assert_int_equal(found[0]->slot_id, 56);
+  assert_int_equal(found[1]->slot_id, 64);
+  assert_int_equal(found[2]->slot_id, 72);
+
+  /* A 区的空闲车位 */
+  slot_query_init(&query);
+  slot_query_where_status(&query, FREE_STATUS);
+  slot_query_where_location(&query, "A-");
+  assert_int_equal(query_slots(lot, &query, found, 100), 38);
+  assert_int_equal(found[0]->slot_id, 1);
+
+  /* 到期时间在 [2000, 5000) 的居民：20、28、36、44 */
+  slot_query_init(&query);
+  slot_query_where_type(&query, RESIDENT_TYPE);
+  slot_query_where_due(&query, 2000, 5000);
+  assert_int_equal(query_slots(lot, &query, found, 100), 4);
+  assert_int_equal(found[3]->slot_id, 44);
+
+  /* 计数与查询结果一致：已占用访客 12 个，其中 B 区 6 个 */
+  slot_query_init(&query);
+  slot_query_where_status(&query, OCCUPIED_STATUS);
+  slot_query_where_type(&query, VISITOR_TYPE);
+  assert_int_equal(count_query_slots(lot, &query), 12);
+  slot_query_where_location(&query, "B-");
+  assert_int_equal(count_query_slots(lot, &query), 6);
+  slot_query_where_entry(&query, 0, 80000);
+  assert_int_equal(count_query_slots(lot, &query), 3);
+  slot_query_init(&query);
+  slot_query_where_type(&query, VISITOR_TYPE);
+  assert_int_equal(count_query_slots(lot, &query), 12);
+
+  /* 写满容量即停止；空闲与入场时间条件互斥 */
+  slot_query_init(&query);
+  assert_int_equal(query_slots(lot, &query, found, 3), 3);
+  assert_int_equal(found[2]->slot_id, 3);
+  slot_query_where_status(&query, FREE_STATUS);
+  slot_query_where_entry(&query, 0, 100000);
+  assert_int_equal(query_slots(lot, &query, found, 100), 0);
+  assert_int_equal(query_slots(NULL, &query, found, 100), -1);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试月费到期堆：逾期清单与最近到期日按到期时间排序，并随修改更新。
+ */
+static void test_due_date_index(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(40);
+  ParkingSlot *found[40];
+  ParkingSlot *slot;
+  int i;
+
+  /* 居民车位 i 的到期时间为 (41 - i) * 100，编号越大越早到期；
+   * 编号为 5 的倍数的车位是访客，不登记 */
+  for (i = 1; i <= 40; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "A"), 0);
+    slot = find_slot_by_id(lot, i);
+    slot->type = i % 5 == 0 ? VISITOR_TYPE : RESIDENT_TYPE;
+    slot->resident_due_date = (time_t)((41 - i) * 100);
+    assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  }
+  assert_int_equal(count_due_slots(lot), 32);
+
+  /* 截至 500 已逾期：到期 100..400 的 40、39、38、37 中去掉访客 40 */
+  assert_int_equal(get_slots_by_due_date(lot, 0, 500, found, 40), 3);
+  assert_int_equal(found[0]->slot_id, 39);
+  assert_int_equal(found[1]->slot_id, 38);
+  assert_int_equal(found[2]->slot_id, 37);
+
+  /* 从 1000 起最近的 3 个到期日：31、29、28（30 为访客） */
+  assert_int_equal(get_slots_by_due_date(lot, 1000, 0, found, 3), 3);
+  assert_int_equal(found[0]->slot_id, 31);
+  assert_int_equal(found[1]->slot_id, 29);
+  assert_int_equal(found[2]->slot_id, 28);
+
+  /* 缴费顺延到期时间后离开逾期清单，改为访客或删除车位同样移出 */
+  slot = find_slot_by_id(lot, 39);
+  slot->resident_due_date = 5000;
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  slot = find_slot_by_id(lot, 38);
+  slot->type = VISITOR_TYPE;
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  assert_int_equal(delete_slot(lot, 37), 0);
+  assert_int_equal(get_slots_by_due_date(lot, 0, 500, found, 40), 0);
+  assert_int_equal(count_due_slots(lot), 30);
+
+  /* 全部取出时严格按到期时间排列，39 排在最后 */
+  assert_int_equal(get_slots_by_due_date(lot, 0, 0, found, 40), 30);
+  for (i = 1; i < 30; i++) {
+    assert_true(found[i - 1]->resident_due_date <= found[i]->resident_due_date);
+  }
+  assert_int_equal(found[29]->slot_id, 39);
+  assert_int_equal(get_slots_by_due_date(NULL, 0, 0, found, 40), -1);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief `test_timer_wheel` 的到期回调上下文。
+ */
+typedef struct {
+  time_t after;  /**< 本次推进之前的时刻（不含）。 */
+  time_t now;    /**< 本次推进到的时刻（含）。 */
+  int fired;     /**< 已触发的定时器数。 */
+  int early;     /**< 在到期之前或推进区间之外触发的次数。 */
+} WheelProbe;
+
+/**
+ * @brief `test_timer_wheel` 的到期回调，检查触发时刻落在本次推进区间内。
+ * @param timer 到期的定时器。
+ * @param ctx 指向 WheelProbe 的指针。
+ */
+static void probe_timer(ParkingTimer *timer, void *ctx) {
+  WheelProbe *probe = (WheelProbe *)ctx;
+
+  probe->fired++;
+  if (timer->expires > probe->now || timer->expires <= probe->after) {
+    probe->early++;
+  }
+}
+
+/**
+ * @brief 测试分层时间轮：跨层下放、超出覆盖范围、撤销与时钟回拨。
+ */
+static void test_timer_wheel(void **state) {
+  (void)state; /* not used */
+  static ParkingTimer timers[200];
+  TimerWheel wheel;
+  WheelProbe probe;
+  time_t base = 1700000000;
+  time_t step;
+  int i;
+
+  timer_wheel_init(&wheel, base);
+  for (i = 0; i < 200; i++) {
+    timer_init(&timers[i]);
+    /* 到期时刻从 1 秒到约 300 天不等，覆盖全部层与溢出 */
+    timer_wheel_add(&wheel, &timers[i],
+                    base + 1 + (time_t)i * (time_t)i * (time_t)i * 3);
+  }
+  timer_wheel_cancel(&wheel, &timers[7]);
+  assert_false(timer_pending(&timers[7]));
+  assert_int_equal(wheel.count, 199);
+
+  memset(&probe, 0, sizeof(probe));
+  probe.after = base;
+  for (step = 1; probe.after < base + 30000000; step = step * 3 + 1) {
+    probe.now = probe.after + step;
+    timer_wheel_advance(&wheel, probe.now, probe_timer, &probe);
+    probe.after = probe.now;
+  }
+  assert_int_equal(probe.fired, 199);
+  assert_int_equal(probe.early, 0);
+  assert_int_equal(wheel.count, 0);
+
+  /* 回拨后重新归位：早于新时刻的定时器在下一次推进时立即触发 */
+  timer_wheel_add(&wheel, &timers[0], base + 50);
+  timer_wheel_add(&wheel, &timers[1], base + 500);
+  timer_wheel_rebase(&wheel, base + 100);
+  memset(&probe, 0, sizeof(probe));
+  probe.after = 0;
+  probe.now = base + 100;
+  assert_int_equal(timer_wheel_advance(&wheel, base + 100, probe_timer, &probe),
+                   1);
+  assert_true(timer_pending(&timers[1]));
+}
+
+/**
+ * @brief `test_parking_events` 的事件处理函数，按类型累计事件数。
+ * @param lot 触发事件的停车场。
+ * @param event 事件内容。
+ * @param ctx 指向 int[3] 计数数组的指针。
+ */
+static void count_parking_event(ParkingLot *lot, const ParkingEvent *event,
+                                void *ctx) {
+  int *counts = (int *)ctx;
+
+  (void)lot;
+  counts[event->type]++;
+}
+
+/**
+ * @brief 测试停车场定时器：访客超时提醒、月费到期提醒与日切清零收入。
+ */
+static void test_parking_events(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(10);
+  ParkingSlot *slot;
+  struct tm moment;
+  time_t morning;
+  int counts[3] = {0, 0, 0};
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 2;
+  moment.tm_mday = 2;
+  moment.tm_hour = 10;
+  moment.tm_isdst = -1;
+  morning = mktime(&moment);
+  assert_int_equal(configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, morning),
+                   0);
+  set_parking_event_handler(lot, count_parking_event, counts);
+  assert_int_equal(run_parking_timers(lot), 0);
+
+  assert_int_equal(create_and_add_slot(lot, 1, "A-01"), 0);
+  assert_int_equal(create_and_add_slot(lot, 2, "A-02"), 0);
+  assert_int_equal(create_and_add_slot(lot, 3, "A-03"), 0);
+  assert_int_equal(allocate_slot(lot, 1, "访客甲", "京A12345", "", VISITOR_TYPE),
+                   0);
+  assert_int_equal(allocate_slot(lot, 2, "访客乙", "京B12345", "", VISITOR_TYPE),
+                   0);
+  slot = find_slot_by_id(lot, 3);
+  slot->resident_due_date = morning + 36 * 3600;
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+
+  /* 访客 2 在允许时段内离开，只有访客 1 在 17 点仍在场 */
+  assert_int_equal(advance_parking_clock(lot, 3600), 0);
+  assert_int_equal(deallocate_slot(lot, 2), 0);
+  assert_int_equal(advance_parking_clock(lot, 7 * 3600), 0);
+  run_parking_timers(lot);
+  assert_int_equal(counts[PARKING_EVENT_VISITOR_OVERSTAY], 1);
+
+  /* 0 点日切清零当日收入；次日 17 点访客 1 仍在场再次提醒 */
+  lot->today_revenue_cents = 500;
+  lot->revenue_day = 20260302;
+  assert_int_equal(advance_parking_clock(lot, 7 * 3600), 0);
+  run_parking_timers(lot);
+  assert_int_equal(counts[PARKING_EVENT_DAY_ROLLOVER], 1);
+  assert_int_equal(lot->today_revenue_cents, 0);
+  assert_int_equal(lot->revenue_day, 20260303);
+  assert_int_equal(counts[PARKING_EVENT_RESIDENT_DUE], 0);
+
+  /* 次日 22 点：月费到期（22 点）与第二次访客提醒（17 点） */
+  assert_int_equal(advance_parking_clock(lot, 22 * 3600), 0);
+  run_parking_timers(lot);
+  assert_int_equal(counts[PARKING_EVENT_RESIDENT_DUE], 1);
+  assert_int_equal(counts[PARKING_EVENT_VISITOR_OVERSTAY], 2);
+
+  /* 访客离开、到期时间顺延后不再提醒 */
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  slot->resident_due_date += 30 * 24 * 3600;
+  assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  assert_int_equal(advance_parking_clock(lot, 20 * 3600), 0);
+  run_parking_timers(lot);
+  assert_int_equal(counts[PARKING_EVENT_VISITOR_OVERSTAY], 2);
+  assert_int_equal(counts[PARKING_EVENT_RESIDENT_DUE], 1);
+  assert_int_equal(counts[PARKING_EVENT_DAY_ROLLOVER], 2);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试滚动汇总：跨月的日桶、保留窗口、月内高峰与出入场计数。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_revenue_rollup(void **state) {
+  (void)state; /* not used */
+  RevenueRollup rollup;
+  ParkingLot *lot;
+  struct tm moment;
+  time_t start;
+  time_t peak;
+  long value;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 0;
+  moment.tm_mday = 30;
+  moment.tm_hour = 12;
+  moment.tm_isdst = -1;
+  start = mktime(&moment);
+
+  /* 1 月 30 日至 2 月 1 日连续三天，日序号跨月仍然相邻 */
+  rollup_init(&rollup);
+  rollup_add(&rollup, start, 20260130, 202601, VISITOR_TYPE, ROLLUP_REVENUE,
+             500);
+  rollup_add(&rollup, start + 3600, 20260130, 202601, VISITOR_TYPE,
+             ROLLUP_REVENUE, 700);
+  rollup_add(&rollup, start + 24 * 3600, 20260131, 202601, RESIDENT_TYPE,
+             ROLLUP_REVENUE, 20000);
+  rollup_add(&rollup, start + 48 * 3600, 20260201, 202602, VISITOR_TYPE,
+             ROLLUP_REVENUE, 300);
+  assert_int_equal(
+      rollup_recent_days(&rollup, 20260201, 7, ROLLUP_REVENUE, -1), 21500);
+  assert_int_equal(
+      rollup_recent_days(&rollup, 20260201, 2, ROLLUP_REVENUE, -1), 20300);
+  assert_int_equal(rollup_recent_days(&rollup, 20260201, 7, ROLLUP_REVENUE,
+                                      VISITOR_TYPE),
+                   1500);
+  assert_int_equal(
+      rollup_hour_total(&rollup, start + 3600 + 59, ROLLUP_REVENUE, -1), 700);
+
+  /* 进入 2 月后高峰只统计 2 月；1 月的高峰不再可查 */
+  assert_int_equal(rollup_month_peak(&rollup, 202602, ROLLUP_REVENUE, &peak,
+                                     &value),
+                   0);
+  assert_true(peak == (start + 48 * 3600) / 3600 * 3600);
+  assert_int_equal(value, 300);
+  assert_int_equal(
+      rollup_month_peak(&rollup, 202601, ROLLUP_REVENUE, NULL, NULL), -1);
+
+  /* 8 天后同一小时桶被复用，已移出窗口的记录不再计入 */
+  rollup_add(&rollup, start + ROLLUP_HOURS * 3600L, 20260206, 202602,
+             VISITOR_TYPE, ROLLUP_REVENUE, 100);
+  assert_int_equal(rollup_hour_total(&rollup, start, ROLLUP_REVENUE, -1), 0);
+  rollup_add(&rollup, start, 20260130, 202601, VISITOR_TYPE, ROLLUP_REVENUE,
+             900);
+  assert_int_equal(rollup_hour_total(&rollup, start + ROLLUP_HOURS * 3600L,
+                                     ROLLUP_REVENUE, -1),
+                   100);
+
+  /* 数据层在入场、出场时自动计入次数 */
+  lot = init_parking_lot(10);
+  assert_int_equal(configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, start),
+                   0);
+  assert_int_equal(create_and_add_slot(lot, 1, "A-01"), 0);
+  assert_int_equal(create_and_add_slot(lot, 2, "A-02"), 0);
+  assert_int_equal(allocate_slot(lot, 1, "甲", "京A00001", "", VISITOR_TYPE),
+                   0);
+  assert_int_equal(allocate_slot(lot, 2, "乙", "京A00002", "", RESIDENT_TYPE),
+                   0);
+  assert_int_equal(advance_parking_clock(lot, 24 * 3600), 0);
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_int_equal(rollup_recent_days(&lot->rollup, 20260131, 1,
+                                      ROLLUP_ENTRIES, -1),
+                   0);
+  assert_int_equal(rollup_recent_days(&lot->rollup, 20260131, 2,
+                                      ROLLUP_ENTRIES, RESIDENT_TYPE),
+                   1);
+  assert_int_equal(rollup_recent_days(&lot->rollup, 20260131, 7,
+                                      ROLLUP_EXITS, VISITOR_TYPE),
+                   1);
+  assert_int_equal(rollup_month_peak(&lot->rollup, 202601, ROLLUP_ENTRIES,
+                                     &peak, &value),
+                   0);
+  assert_true(peak == start / 3600 * 3600);
+  assert_int_equal(value, 2);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试 HyperLogLog 草图：估计误差、重复元素、合并与按周换桶。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_distinct_vehicle_sketch(void **state) {
+  (void)state; /* not used */
+  HyperLogLog a;
+  HyperLogLog b;
+  DistinctCounter counter;
+  PlateCode code;
+  char plate[16];
+  double estimate;
+  int i;
+
+  hll_clear(&a);
+  hll_clear(&b);
+  assert_true(hll_estimate(&a) == 0.0);
+  /* a 为第 0-19999 辆，b 为第 10000-39999 辆，并集 40000 辆 */
+  for (i = 0; i < 40000; i++) {
+    if (i < 20000) {
+      sprintf(plate, "京A%05d", i);
+    } else {
+      sprintf(plate, "沪B%05d", i - 20000);
+    }
+    plate_encode(plate, &code);
+    if (i < 20000) {
+      hll_add(&a, plate_code_hash(&code));
+      hll_add(&a, plate_code_hash(&code)); /* 重复入场不改变估计 */
+    }
+    if (i >= 10000) {
+      hll_add(&b, plate_code_hash(&code));
+    }
+  }
+  estimate = hll_estimate(&a);
+  assert_true(estimate > 20000 * 0.95 && estimate < 20000 * 1.05);
+  hll_merge(&a, &b);
+  estimate = hll_estimate(&a);
+  assert_true(estimate > 40000 * 0.95 && estimate < 40000 * 1.05);
+
+  /* 小基数走线性计数，几乎精确 */
+  hll_clear(&b);
+  for (i = 0; i < 50; i++) {
+    sprintf(plate, "粤C%05d", i);
+    plate_encode(plate, &code);
+    hll_add(&b, plate_code_hash(&code));
+  }
+  estimate = hll_estimate(&b);
+  assert_true(estimate > 48.5 && estimate < 51.5);
+
+  /* 2026-10-18 为周日、10-19 为周一：跨周后本周草图换新，上周仍可查 */
+  assert_int_equal(parking_calendar_week_number(20261012),
+                   parking_calendar_week_number(20261018));
+  assert_int_equal(parking_calendar_week_number(20261019),
+                   parking_calendar_week_number(20261018) + 1);
+  assert_int_equal(parking_calendar_day_number(20260301),
+                   parking_calendar_day_number(20260228) + 1);
+  distinct_counter_init(&counter);
+  distinct_counter_add(&counter, 20261018, 202610, 0x12345678UL);
+  distinct_counter_add(&counter, 20261019, 202610, 0x9ABCDEF0UL);
+  distinct_counter_add(&counter, 20261019, 202610, 0x12345678UL);
+  estimate = hll_estimate(
+      distinct_counter_sketch(&counter, DISTINCT_THIS_WEEK, 20261020));
+  assert_true(estimate > 1.5 && estimate < 2.5);
+  estimate = hll_estimate(
+      distinct_counter_sketch(&counter, DISTINCT_LAST_WEEK, 20261020));
+  assert_true(estimate > 0.5 && estimate < 1.5);
+  estimate = hll_estimate(
+      distinct_counter_sketch(&counter, DISTINCT_THIS_MONTH, 20261020));
+  assert_true(estimate > 1.5 && estimate < 2.5);
+  assert_null(distinct_counter_sketch(&counter, DISTINCT_LAST_MONTH, 20261020));
+  /* 两周之前的入场已移出保留范围 */
+  distinct_counter_add(&counter, 20261005, 202610, 0x55555555UL);
+  assert_null(distinct_counter_sketch(&counter, DISTINCT_THIS_WEEK, 20261005));
+}
+
+/**
+ * @brief 测试车牌名单：布隆过滤器之后的精确确认、文件读取与入场检查。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_plate_lists(void **state) {
+  (void)state; /* not used */
+  const char *list_file = "plate_list_test.txt";
+  ParkingLot *lot = init_parking_lot(5);
+  PlateList *list = plate_list_create(NULL);
+  char plate[16];
+  FILE *file;
+  int line;
+  int i;
+
+  assert_non_null(list);
+  /* 2 万个标准车牌，哈希表随之扩容；另有一个非标准车牌 */
+  for (i = 0; i < 20000; i++) {
+    sprintf(plate, "京B%05d", i * 2);
+    assert_int_equal(plate_list_add(list, plate), 0);
+  }
+  assert_int_equal(plate_list_add(list, "京B00000"), 0); /* 重复 */
+  assert_int_equal(plate_list_add(list, "使馆001"), 0);
+  assert_int_equal(plate_list_add(list, ""), -1);
+  assert_int_equal(list->count, 20001);
+  assert_int_equal(plate_list_contains(list, "京B00002"), 1); /* 封存前 */
+  assert_int_equal(plate_list_seal(list), 0);
+  assert_int_equal(plate_list_add(list, "京B99999"), -1);
+  for (i = 0; i < 20000; i++) {
+    sprintf(plate, "京B%05d", i * 2);
+    assert_int_equal(plate_list_contains(list, plate), 1);
+    sprintf(plate, "京B%05d", i * 2 + 1); /* 过滤器误判时由哈希表否定 */
+    assert_int_equal(plate_list_contains(list, plate), 0);
+  }
+  assert_int_equal(plate_list_contains(list, "使馆001"), 1);
+  assert_int_equal(plate_list_contains(list, "使馆002"), 0);
+  assert_int_equal(plate_list_contains(NULL, "京B00000"), 0);
+  plate_list_free(list);
+
+  /* 文件：跳过空行与注释，无效的行报告行号 */
+  file = fopen(list_file, "w");
+  assert_non_null(file);
+  fputs("# 禁止入场\n沪C00001\n\n  沪C00002  \r\n", file);
+  fclose(file);
+  assert_int_equal(plate_list_load(NULL, list_file, &list, &line), 0);
+  assert_int_equal(list->count, 2);
+  assert_int_equal(plate_list_contains(list, "沪C00002"), 1);
+  plate_list_free(list);
+  file = fopen(list_file, "a");
+  assert_non_null(file);
+  fputs("沪C00003\n0123456789012345678901234567890123456789012345678901\n",
+        file);
+  fclose(file);
+  assert_int_equal(plate_list_load(NULL, list_file, &list, &line), -2);
+  assert_null(list);
+  assert_int_equal(line, 6);
+  remove(list_file);
+  assert_int_equal(plate_list_load(NULL, list_file, &list, &line), -4);
+
+  /* 发布到停车场后，入场检查禁止入场名单 */
+  assert_non_null(lot);
+  add_parking_slot(lot, create_parking_slot(1, "A-01"));
+  list = plate_list_create(&lot->memory);
+  assert_non_null(list);
+  assert_int_equal(plate_list_add(list, "沪C00001"), 0);
+  assert_int_equal(publish_plate_list(lot, (PlateListKind)7, list), -1);
+  assert_int_equal(publish_plate_list(lot, PLATE_LIST_BLOCKED, list), 0);
+  assert_int_equal(parking_lot_plate_list_size(lot, PLATE_LIST_BLOCKED), 1);
+  assert_int_equal(parking_lot_plate_listed(lot, PLATE_LIST_VIP, "沪C00001"),
+                   0);
+  assert_int_equal(allocate_slot(lot, 1, "车主", "沪C00001", NULL,
+                                 RESIDENT_TYPE),
+                   -8);
+  assert_int_equal(publish_plate_list(lot, PLATE_LIST_BLOCKED, NULL), 0);
+  assert_int_equal(reclaim_plate_lists(lot), 1);
+  assert_int_equal(allocate_slot(lot, 1, "车主", "沪C00001", NULL,
+                                 RESIDENT_TYPE),
+                   0);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试车辆资料缓存：LRU 淘汰、出场记录与常客按分区入场。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_session_cache(void **state) {
+  (void)state; /* not used */
+  SessionCache *cache = session_cache_create(NULL, 2);
+  ParkingLot *lot = init_parking_lot(5);
+  VehicleSession session;
+  int slot_id = 0;
+
+  /* 容量为 2：find 不改变顺序，use 与更新会，满了淘汰最久未使用的 */
+  assert_non_null(cache);
+  assert_null(session_cache_create(NULL, 0));
+  memset(&session, 0, sizeof(session));
+  strcpy(session.license_plate, "苏A00001");
+  session_cache_put(cache, &session);
+  strcpy(session.license_plate, "苏A00002");
+  session_cache_put(cache, &session);
+  assert_non_null(session_cache_find(cache, "苏A00001"));
+  strcpy(session.license_plate, "苏A00003");
+  session_cache_put(cache, &session);
+  assert_null(session_cache_find(cache, "苏A00001"));
+  assert_non_null(session_cache_use(cache, "苏A00002"));
+  strcpy(session.license_plate, "苏A00004");
+  session_cache_put(cache, &session);
+  assert_null(session_cache_find(cache, "苏A00003"));
+  strcpy(session.license_plate, "苏A00002");
+  strcpy(session.owner_name, "新车主");
+  session_cache_put(cache, &session);
+  assert_string_equal(session_cache_find(cache, "苏A00002")->owner_name,
+                      "新车主");
+  assert_int_equal(cache->count, 2);
+  session_cache_free(cache);
+
+  /* 出场时记下资料与分区，再次入场优先分配同一分区的空闲车位 */
+  assert_non_null(lot);
+  add_parking_slot(lot, create_parking_slot(1, "A-01"));
+  add_parking_slot(lot, create_parking_slot(2, "B-01"));
+  add_parking_slot(lot, create_parking_slot(3, "B-02"));
+  assert_int_equal(add_parking_zone(lot, "B-"), 0);
+  assert_int_equal(allocate_returning_vehicle(lot, "苏A00005", &slot_id), -2);
+  assert_int_equal(allocate_slot(lot, 2, "常客", "苏A00005", "13900000005",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(deallocate_slot(lot, 2), 0);
+  assert_int_equal(find_vehicle_session(lot, "苏A00005", &session), 0);
+  assert_string_equal(session.owner_name, "常客");
+  assert_string_equal(session.contact, "13900000005");
+  assert_string_equal(session.zone, "B-");
+  assert_int_equal(allocate_slot(lot, 2, "他人", "苏A00006", NULL,
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(allocate_returning_vehicle(lot, "苏A00005", &slot_id), 0);
+  assert_int_equal(slot_id, 3);
+  assert_string_equal(find_slot_by_id(lot, 3)->owner_name, "常客");
+  assert_int_equal(allocate_returning_vehicle(lot, "苏A00005", &slot_id), -4);
+
+  /* 关闭缓存后不再记录 */
+  assert_int_equal(configure_session_cache(lot, -1), -1);
+  assert_int_equal(configure_session_cache(lot, 0), 0);
+  assert_int_equal(deallocate_slot(lot, 3), 0);
+  assert_int_equal(find_vehicle_session(lot, "苏A00005", &session), -2);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试时间线：回溯任一时刻的车位状态与按分段数丢弃最早的历史。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_parking_timeline(void **state) {
+  ParkingLot *lot = init_parking_lot(5);
+  const time_t base = 1700000000;
+  HistoricalSlot past;
+  ParkingLot *rebuilt;
+  int i;
+
+  (void)state; /* not used */
+  assert_int_equal(configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, base),
+                   0);
+  assert_int_equal(create_and_add_slot(lot, 1, "T-01"), 0);
+  assert_int_equal(create_and_add_slot(lot, 2, "T-02"), 0);
+  assert_int_equal(find_slot_at(lot, 1, base, &past), -1);
+  assert_int_equal(configure_parking_timeline(lot, 4, 0), -1);
+  /* 每 4 条记录一个检查点，只保留 2 段 */
+  assert_int_equal(configure_parking_timeline(lot, 4, 2), 0);
+
+  assert_int_equal(set_parking_clock(lot, base + 100), 0);
+  assert_int_equal(allocate_slot(lot, 1, "甲", "闽D00001", NULL,
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(set_parking_clock(lot, base + 200), 0);
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_int_equal(set_parking_clock(lot, base + 300), 0);
+  assert_int_equal(allocate_slot(lot, 1, "乙", "闽D00002", NULL,
+                                 RESIDENT_TYPE),
+                   0);
+
+  assert_int_equal(find_slot_at(lot, 1, base + 150, &past), 0);
+  assert_int_equal(past.status, OCCUPIED_STATUS);
+  assert_string_equal(past.license_plate, "闽D00001");
+  assert_int_equal(past.entry_time, base + 100);
+  assert_int_equal(find_slot_at(lot, 1, base + 250, &past), 0);
+  assert_int_equal(past.status, FREE_STATUS);
+  assert_int_equal(find_slot_at(lot, 1, base + 350, &past), 0);
+  assert_string_equal(past.owner_name, "乙");
+  assert_int_equal(find_slot_at(lot, 1, base - 1, &past), -2);
+  assert_int_equal(find_slot_at(lot, 9, base + 150, &past), -4);
+
+  /* 第 4、8 条记录之后各写一个检查点，最早的一段被丢弃 */
+  for (i = 4; i <= 8; i++) {
+    assert_int_equal(set_parking_clock(lot, base + 100 * i), 0);
+    if (i % 2 == 0) {
+      assert_int_equal(allocate_slot(lot, 2, "丙", "闽D00003", NULL,
+                                     RESIDENT_TYPE),
+                       0);
+    } else {
+      assert_int_equal(deallocate_slot(lot, 2), 0);
+    }
+  }
+  assert_int_equal(lot->timeline->count, 2);
+  assert_int_equal(find_slot_at(lot, 1, base + 150, &past), -2);
+  assert_int_equal(find_slot_at(lot, 2, base + 450, &past), 0);
+  assert_string_equal(past.license_plate, "闽D00003");
+  assert_int_equal(find_slot_at(lot, 2, base + 550, &past), 0);
+  assert_int_equal(past.status, FREE_STATUS);
+  assert_int_equal(load_parking_at(lot, base + 850, &rebuilt), 0);
+  assert_int_equal(rebuilt->occupied_slots, 2);
+  free_parking_lot(rebuilt);
+
+  assert_int_equal(configure_parking_timeline(lot, 0, 0), 0);
+  assert_null(lot->timeline);
+  assert_int_equal(load_parking_at(lot, base + 850, &rebuilt), -1);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试只读视图：按编号排序的副本、按需刷新与宽限期后回收。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_parking_aggregate(void **state) {
+  (void)state; /* not used */
+  ParkingAggregate *tree = aggregate_create(NULL, "集团", 8);
+  ParkingLot *east_lot = init_parking_lot(10);
+  ParkingLot *west_lot = init_parking_lot(20);
+  AggregateReading reading;
+  time_t now = time(NULL);
+  time_t tomorrow = now + 24 * 3600;
+  long day;
+  long month;
+  long next_day;
+  long next_month;
+  int region;
+  int east;
+  int west;
+
+  assert_non_null(tree);
+  region = aggregate_add_region(tree, "华东");
+  assert_true(region > 0);
+  assert_int_equal(aggregate_add_region(tree, "华东"), -1);
+  assert_int_equal(aggregate_add_site(tree, AGGREGATE_ROOT, "A"), -1);
+  east = aggregate_add_site(tree, region, "东站");
+  west = aggregate_add_site(tree, region, "西站");
+  assert_int_equal(aggregate_find(tree, "西站"), west);
+  add_parking_slot(east_lot, create_parking_slot(1, "E-01"));
+  add_parking_slot(west_lot, create_parking_slot(1, "W-01"));
+  add_parking_slot(west_lot, create_parking_slot(2, "W-02"));
+  assert_int_equal(attach_parking_aggregate(east_lot, tree, region), -1);
+  assert_int_equal(attach_parking_aggregate(east_lot, tree, east), 0);
+  assert_int_equal(attach_parking_aggregate(west_lot, tree, east), -2);
+  assert_int_equal(attach_parking_aggregate(west_lot, tree, west), 0);
+
+  /* 挂接时计入当前值，此后的入场、出场与删除逐级同步 */
+  aggregate_read(tree, AGGREGATE_ROOT, now, &reading);
+  assert_int_equal(reading.total_slots, 30);
+  assert_int_equal(reading.occupied_slots, 0);
+  assert_int_equal(reading.site_count, 2);
+  allocate_slot(east_lot, 1, "车主", "浙A10001", NULL, RESIDENT_TYPE);
+  allocate_slot(west_lot, 2, "车主", "浙A10002", NULL, RESIDENT_TYPE);
+  deallocate_slot(west_lot, 2);
+  allocate_slot(west_lot, 1, "车主", "浙A10003", NULL, RESIDENT_TYPE);
+  delete_slot(west_lot, 2);
+  aggregate_read(tree, region, now, &reading);
+  assert_int_equal(reading.total_slots, 29);
+  assert_int_equal(reading.occupied_slots, 2);
+  aggregate_read(tree, west, now, &reading);
+  assert_int_equal(reading.occupied_slots, 1);
+
+  /* 收入按日期分周期：进入新一天的站点使合计切换到新一天 */
+  parking_calendar_convert(now, &day, &month);
+  parking_calendar_convert(tomorrow, &next_day, &next_month);
+  east_lot->revenue_day = day;
+  east_lot->revenue_month = month;
+  east_lot->today_revenue_cents = 500;
+  east_lot->month_revenue_cents = 500;
+  sync_parking_aggregate(east_lot);
+  west_lot->revenue_day = day;
+  west_lot->revenue_month = month;
+  west_lot->today_revenue_cents = 300;
+  west_lot->month_revenue_cents = 300;
+  sync_parking_aggregate(west_lot);
+  aggregate_read(tree, AGGREGATE_ROOT, now, &reading);
+  assert_int_equal(reading.today_cents, 800);
+  assert_int_equal(reading.month_cents, 800);
+  east_lot->revenue_day = next_day;
+  east_lot->today_revenue_cents = 200;
+  sync_parking_aggregate(east_lot);
+  aggregate_read(tree, AGGREGATE_ROOT, tomorrow, &reading);
+  assert_int_equal(reading.today_cents, 200);
+  aggregate_read(tree, AGGREGATE_ROOT, now, &reading);
+  assert_int_equal(reading.today_cents, 0);
+
+  /* 释放停车场时自动解除挂接并扣除它的值 */
+  free_parking_lot(west_lot);
+  aggregate_read(tree, region, now, &reading);
+  assert_int_equal(reading.total_slots, 10);
+  assert_int_equal(reading.occupied_slots, 1);
+  assert_int_equal(attach_parking_aggregate(east_lot, NULL, 0), 0);
+  aggregate_read(tree, AGGREGATE_ROOT, now, &reading);
+  assert_int_equal(reading.total_slots, 0);
+  free_parking_lot(east_lot);
+  aggregate_free(tree);
+}
+
+static void test_read_view(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(5);
+  const ParkingView *pinned;
+  const ParkingView *view;
+  int reader;
+
+  assert_non_null(lot);
+  add_parking_slot(lot, create_parking_slot(3, "V-03"));
+  add_parking_slot(lot, create_parking_slot(1, "V-01"));
+  assert_int_equal(refresh_read_view(lot), -1);
+  assert_int_equal(configure_read_view(lot, 1), 0);
+  reader = view_hub_attach(lot->view);
+  assert_true(reader >= 0);
+
+  /* 钉住的视图是复制时的副本，之后的修改要等刷新才可见 */
+  pinned = view_hub_pin(lot->view, reader);
+  assert_non_null(pinned);
+  assert_int_equal(pinned->slot_count, 2);
+  assert_int_equal(pinned->slots[0].slot_id, 1);
+  assert_string_equal(parking_view_find(pinned, 3)->location, "V-03");
+  assert_string_equal(parking_view_find(pinned, 3)->license_plate, "");
+  assert_null(parking_view_find(pinned, 2));
+  assert_int_equal(refresh_read_view(lot), 1);
+  assert_int_equal(allocate_slot(lot, 3, "车主", "浙A00001", NULL,
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(refresh_read_view(lot), 0);
+  assert_int_equal(parking_view_find(pinned, 3)->status, FREE_STATUS);
+  assert_int_equal(configure_read_view(lot, 0), -2);
+
+  /* 读者仍钉着旧纪元，旧视图要等解除钉住后才回收 */
+  assert_int_equal(view_hub_reclaim(lot->view), 0);
+  view_hub_unpin(lot->view, reader);
+  assert_int_equal(view_hub_reclaim(lot->view), 1);
+  view = view_hub_pin(lot->view, reader);
+  assert_int_equal(view->version, 2);
+  assert_int_equal(view->occupied_slots, 1);
+  assert_string_equal(parking_view_find(view, 3)->license_plate, "浙A00001");
+  view_hub_unpin(lot->view, reader);
+
+  view_hub_detach(lot->view, reader);
+  assert_int_equal(configure_read_view(lot, 0), 0);
+  assert_null(lot->view);
+  assert_int_equal(configure_read_view(lot, 1), 0);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试占用画像：刻钟切换时计入画像并缓存预测的占用率变化。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_occupancy_forecast(void **state) {
+  (void)state; /* not used */
+  OccupancyForecast forecast;
+  ForecastTime at;
+
+  assert_int_equal(forecast_horizon_minutes(0), 15);
+  assert_int_equal(forecast_horizon_minutes(2), 60);
+  assert_int_equal(forecast_horizon_minutes(3), 0);
+  forecast_init(&forecast);
+  assert_int_equal(forecast_predict(&forecast, 2, 3, 10), 3);
+
+  /* 第一周：格 0 起每刻钟占用 0、2、4、4、8 个，随后清空 */
+  at.quarter = 1000;
+  at.cell = 0;
+  forecast_observe(&forecast, &at, 0, 10);
+  at.quarter = 1001;
+  at.cell = 1;
+  forecast_observe(&forecast, &at, 2, 10);
+  at.quarter = 1002;
+  at.cell = 2;
+  forecast_observe(&forecast, &at, 4, 10);
+  at.quarter = 1004; /* 格 3 没有变化，按 4 个计入 */
+  at.cell = 4;
+  forecast_observe(&forecast, &at, 8, 10);
+  at.quarter = 1005;
+  at.cell = 5;
+  forecast_observe(&forecast, &at, 0, 10);
+
+  /* 一周后回到格 0：其间的刻钟都按空场计入 */
+  at.quarter = 1000 + FORECAST_PROFILE_CELLS;
+  at.cell = 0;
+  forecast_observe(&forecast, &at, 0, 20);
+  assert_int_equal(forecast_predict(&forecast, 0, 0, 10), 0);
+  assert_int_equal(forecast_predict(&forecast, 1, 0, 10), 2);
+  assert_int_equal(forecast_predict(&forecast, 2, 0, 10), 4);
+  assert_int_equal(forecast_predict(&forecast, 2, 0, 20), 8);
+
+  /* 进入格 1 后缓存随之更新，预测值不超过车位总数 */
+  at.quarter++;
+  at.cell = 1;
+  forecast_observe(&forecast, &at, 4, 10);
+  assert_int_equal(forecast_predict(&forecast, 0, 4, 10), 6);
+  assert_int_equal(forecast_predict(&forecast, 1, 4, 10), 8);
+  assert_int_equal(forecast_predict(&forecast, 2, 4, 10), 10);
+
+  /* 时间倒退只重新对齐，不改动画像 */
+  at.quarter = 1001;
+  at.cell = 1;
+  forecast_observe(&forecast, &at, 0, 10);
+  assert_int_equal(forecast_predict(&forecast, 1, 0, 10), 4);
+  assert_int_equal(forecast_predict(&forecast, -1, 5, 10), 5);
+}
+
+/**
+ * @brief 测试整数分费率表：默认费率、首小时、夜间时段与每日封顶。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_tariff_engine(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(10);
+  TariffConfig config;
+  struct tm moment;
+  time_t evening;
+  int hours;
+  int periods;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 2;
+  moment.tm_mday = 2;
+  moment.tm_hour = 20;
+  moment.tm_isdst = -1;
+  evening = mktime(&moment);
+
+  /* 默认费率与旧的浮点计费一致 */
+  assert_int_equal(
+      calculate_visitor_fee_cents(lot, evening, evening + 9000, &hours), 3000);
+  assert_int_equal(hours, 3);
+  assert_true(calculate_visitor_fee(evening, evening + 9000) == 30.0);
+  assert_int_equal(calculate_visitor_fee_cents(lot, evening, evening, &hours),
+                   0);
+  assert_int_equal(hours, 0);
+  /* 月费默认按自然月计：3 月 2 日到期，4 月 2 日同一时刻之前只欠一期 */
+  assert_int_equal(calculate_resident_fee_cents(
+                       lot, evening, parking_calendar_add_months(evening, 1),
+                       &periods),
+                   20000);
+  assert_int_equal(periods, 1);
+  assert_int_equal(calculate_resident_fee_cents(
+                       lot, evening,
+                       parking_calendar_add_months(evening, 1) + 1, &periods),
+                   40000);
+  assert_int_equal(periods, 2);
+  assert_int_equal(
+      calculate_resident_fee_cents(lot, evening, evening, &periods), 0);
+
+  /* 关闭自然月后按固定的 30 天周期计，31 天算两期 */
+  tariff_config_default(&config);
+  config.resident_calendar_months = 0;
+  assert_int_equal(configure_parking_tariff(lot, &config), 0);
+  assert_int_equal(calculate_resident_fee_cents(lot, evening,
+                                                evening + 31L * 24 * 3600,
+                                                &periods),
+                   40000);
+  assert_int_equal(periods, 2);
+
+  /* 首小时 15 元，日间 8 元，22 点到 7 点 3 元，每日封顶 60 元 */
+  tariff_config_default(&config);
+  config.first_hour_cents = 1500;
+  config.hourly_cents = 800;
+  config.night_hourly_cents = 300;
+  config.night_start_hour = 22;
+  config.night_end_hour = 7;
+  config.daily_cap_cents = 6000;
+  assert_int_equal(configure_parking_tariff(lot, &config), 0);
+  assert_int_equal(calculate_visitor_fee_cents(lot, evening, evening + 3 * 3600,
+                                               &hours),
+                   1500 + 800 + 300);
+  /* 30 小时：首日封顶，其余 6 小时为 20、21 点日间与 22-1 点夜间 */
+  assert_int_equal(calculate_visitor_fee_cents(lot, evening,
+                                               evening + 30 * 3600, &hours),
+                   6000 + 2 * 800 + 4 * 300);
+  assert_int_equal(hours, 30);
+  /* 三个完整计费日各自封顶 */
+  assert_int_equal(calculate_visitor_fee_cents(lot, evening,
+                                               evening + 72 * 3600, NULL),
+                   3 * 6000);
+
+  /* 无效配置不改变当前费率表 */
+  config.night_start_hour = 24;
+  assert_int_equal(configure_parking_tariff(lot, &config), -1);
+  config.night_start_hour = 22;
+  config.resident_period_seconds = 0;
+  assert_int_equal(configure_parking_tariff(lot, &config), -1);
+  assert_int_equal(calculate_visitor_fee_cents(lot, evening, evening + 3600,
+                                               NULL),
+                   1500);
+
+  assert_int_equal(configure_parking_tariff(lot, NULL), 0);
+  assert_int_equal(calculate_visitor_fee_cents(lot, evening, evening + 3600,
+                                               NULL),
+                   1000);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试运行时配置：文本解析、配置文件、发布与回收。
+ * @details 发布新的访客时段后，原先被拒绝的晚间访客入场变为允许。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_runtime_config(void **state) {
+  (void)state; /* not used */
+  const char *config_file = "parking_config_test.conf";
+  ParkingLot *lot = init_parking_lot(10);
+  const ParkingConfig *initial = parking_lot_config(lot);
+  ParkingConfig config;
+  struct tm moment;
+  time_t evening;
+  FILE *file;
+  int line;
+
+  assert_int_equal(initial->visitor_start_hour, VISITOR_START_HOUR);
+  assert_int_equal(initial->visitor_end_hour, VISITOR_END_HOUR);
+  assert_int_equal(initial->fees.resident_monthly_cents,
+                   TARIFF_DEFAULT_RESIDENT_MONTHLY_CENTS);
+
+  parking_config_default(&config);
+  assert_int_equal(parking_config_parse(&config,
+                                        "# 夜间开放\n"
+                                        "visitor_end_hour = 23\n"
+                                        "\n"
+                                        "  hourly_cents=600  \n"
+                                        "resident_period_days = 31",
+                                        &line),
+                   0);
+  assert_int_equal(config.visitor_end_hour, 23);
+  assert_int_equal(config.fees.prefix[0][2], 1200);
+  assert_int_equal(config.fees.resident_period_seconds, 31L * 24 * 3600);
+  assert_int_equal(config.fees.resident_calendar_months, 0);
+  assert_int_equal(
+      parking_config_parse(&config, "\nvisitor_end_hour 20", &line), -2);
+  assert_int_equal(line, 2);
+  assert_int_equal(parking_config_parse(&config, "unknown_key = 1", &line), -2);
+  assert_int_equal(parking_config_parse(&config, "hourly_cents = -5", &line),
+                   -2);
+  assert_int_equal(parking_config_parse(&config, "visitor_start_hour = 23",
+                                        &line),
+                   -3); /* 开始小时不早于结束小时 */
+  assert_int_equal(parking_config_set(&config, "visitor_start_hour", "9"), 0);
+
+  /* 配置文件从默认值出发，只覆盖出现的键 */
+  remove(config_file);
+  assert_int_equal(parking_config_load(&config, config_file, &line), -4);
+  file = fopen(config_file, "w");
+  assert_non_null(file);
+  fputs("visitor_start_hour = 6\nvisitor_end_hour = 22\n", file);
+  fclose(file);
+  assert_int_equal(parking_config_load(&config, config_file, &line), 0);
+  assert_int_equal(config.visitor_start_hour, 6);
+  assert_int_equal(config.visitor_end_hour, 22);
+  assert_int_equal(config.tariff.hourly_cents, TARIFF_DEFAULT_HOURLY_CENTS);
+  remove(config_file);
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 2;
+  moment.tm_mday = 2;
+  moment.tm_hour = 20;
+  moment.tm_isdst = -1;
+  evening = mktime(&moment);
+  assert_int_equal(configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, evening),
+                   0);
+  assert_int_equal(create_and_add_slot(lot, 1, "A-01"), 0);
+  assert_int_equal(allocate_slot(lot, 1, "访客甲", "京A12345", "", VISITOR_TYPE),
+                   -5);
+
+  assert_int_equal(publish_parking_config(lot, &config), 0);
+  assert_ptr_not_equal(parking_lot_config(lot), initial);
+  assert_int_equal(allocate_slot(lot, 1, "访客甲", "京A12345", "", VISITOR_TYPE),
+                   0);
+
+  /* 无效配置不发布 */
+  config.visitor_end_hour = config.visitor_start_hour;
+  assert_int_equal(publish_parking_config(lot, &config), -1);
+  assert_int_equal(parking_lot_config(lot)->visitor_end_hour, 22);
+
+  /* 只替换费率表时保留访客时段 */
+  assert_int_equal(configure_parking_tariff(lot, NULL), 0);
+  assert_int_equal(parking_lot_config(lot)->visitor_end_hour, 22);
+  assert_int_equal(reclaim_parking_configs(lot), 2);
+  assert_int_equal(reclaim_parking_configs(lot), 0);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试字节列扫描内核。
+ * @details 对各种长度与起点，向量内核的结果必须与逐字节比较一致。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_column_kernels(void **state) {
+  (void)state; /* not used */
+  unsigned char column[1200];
+  unsigned long expected_mask;
+  size_t expected;
+  size_t rows;
+  size_t from;
+  size_t i;
+
+  for (i = 0; i < sizeof(column); i++) {
+    column[i] = (unsigned char)((i * 7 + i / 13) % 3);
+  }
+  for (rows = 0; rows <= sizeof(column); rows += 37) {
+    expected = 0;
+    for (i = 0; i < rows; i++) {
+      expected += column[i] == 2;
+    }
+    assert_int_equal(column_count_u8(column, rows, 2), expected);
+  }
+  memset(column + 600, 1, 600);
+  assert_int_equal(column_count_u8(column + 600, 600, 1), 600);
+
+  for (from = 0; from < 64; from += 5) {
+    expected_mask = 0;
+    for (i = 0; i < 64 - from; i++) {
+      expected_mask |= (unsigned long)(column[from + i] == 0) << i;
+    }
+    assert_true(column_match_u8(column + from, 64 - from, 0) == expected_mask);
+  }
+
+  memset(column, 0, sizeof(column));
+  assert_int_equal(column_find_u8(column, 0, sizeof(column), 1),
+                   sizeof(column));
+  column[1000] = 1;
+  column[17] = 1;
+  assert_int_equal(column_find_u8(column, 0, sizeof(column), 1), 17);
+  assert_int_equal(column_find_u8(column, 18, sizeof(column), 1), 1000);
+  assert_int_equal(column_find_u8(column, 18, 1000, 1), 1000);
+  assert_int_equal(column_popcount(0xF0F0UL), 8);
+}
+
+/**
+ * @brief 测试二进制快照的保存与加载。
+ * @details
+ * 验证快照可以完整还原车位、车牌索引和计数器，`load_parking_data`
+ * 能自动识别快照格式，且文件内容被篡改后加载会失败。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_binary_snapshot(void **state) {
+  (void)state; /* not used */
+  const char *test_file = "snapshot_test.bin";
+  ParkingLot *lot = init_parking_lot(300);
+  ParkingLot *loaded_lot;
+  ParkingSlot *slot;
+  FILE *file;
+  int i;
+
+  for (i = 1; i <= 300; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "SNAP"), 0);
+  }
+  assert_int_equal(allocate_slot(lot, 7, "张三", "沪S00007", "13900000007",
+                                 RESIDENT_TYPE),
+                   0);
+  find_slot_by_id(lot, 7)->resident_due_date = 1700000000;
+  sync_slot_hot_fields(lot, find_slot_by_id(lot, 7));
+  assert_int_equal(delete_slot(lot, 300), 0);
+
+  assert_int_equal(save_parking_snapshot(lot, test_file), 0);
+
+  loaded_lot = load_parking_snapshot(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->total_slots, lot->total_slots);
+  assert_int_equal(loaded_lot->slot_count, 299);
+  assert_int_equal(loaded_lot->occupied_slots, 1);
+  assert_int_equal(loaded_lot->free_slot_count, 298);
+  assert_null(find_slot_by_id(loaded_lot, 300));
+  slot = find_slot_by_license(loaded_lot, "沪S00007");
+  assert_non_null(slot);
+  assert_int_equal(slot->slot_id, 7);
+  assert_string_equal(slot->owner_name, "张三");
+  assert_string_equal(slot->contact, "13900000007");
+  assert_true(slot->entry_time == find_slot_by_id(lot, 7)->entry_time);
+  assert_true(slot->resident_due_date == 1700000000);
+  assert_string_equal(find_slot_by_id(loaded_lot, 42)->location, "SNAP");
+  free_parking_lot(loaded_lot);
+
+  /* 通用加载入口能识别快照格式 */
+  loaded_lot = load_parking_data(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->slot_count, 299);
+  free_parking_lot(loaded_lot);
+
+  /* 内存映射加载与普通读取结果一致 */
+  loaded_lot = load_parking_snapshot_mapped(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->slot_count, 299);
+  assert_int_equal(loaded_lot->occupied_slots, 1);
+  assert_string_equal(find_slot_by_license(loaded_lot, "沪S00007")->owner_name,
+                      "张三");
+  free_parking_lot(loaded_lot);
+
+  /* 篡改记录区的一个字节后校验失败 */
+  file = fopen(test_file, "r+b");
+  assert_non_null(file);
+  fseek(file, SNAPSHOT_HEADER_SIZE + 40, SEEK_SET);
+  fputc('X', file);
+  fclose(file);
+  assert_null(load_parking_snapshot(test_file));
+  assert_null(load_parking_snapshot_mapped(test_file));
+  assert_null(load_parking_snapshot_mapped("no_such_snapshot.bin"));
+
+  free_parking_lot(lot);
+  remove_snapshot_files(test_file);
+}
+
+/**
+ * @brief 测试总车位数不为正的停车场的保存与加载。
+ * @details 删除的车位多于初始总车位数时总车位数降到 0 以下；
+ *          文本、二进制、压缩快照与增量检查点都照原值保存，
+ *          各加载入口也都能加载回来。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_snapshot_nonpositive_total(void **state) {
+  const char *text_file = "negative_total.txt";
+  const char *snap_file = "negative_total.bin";
+  const char *packed_file = "negative_total_packed.bin";
+  const char *base_file = "negative_total_base.bin";
+  const char *delta_file = "negative_total_delta.bin";
+  const char *files[5];
+  ParkingLot *lot = init_parking_lot(2);
+  ParkingLot *loaded[7];
+  int i;
+
+  (void)state; /* not used */
+  files[0] = text_file;
+  files[1] = snap_file;
+  files[2] = packed_file;
+  files[3] = base_file;
+  files[4] = delta_file;
+  for (i = 1; i <= 1000; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "负"), 0);
+  }
+  for (i = 1; i <= 3; i++) {
+    assert_int_equal(delete_slot(lot, i), 0);
+  }
+  assert_int_equal(lot->total_slots, -1);
+
+  assert_int_equal(save_parking_data(lot, text_file), 0);
+  assert_int_equal(save_parking_snapshot(lot, snap_file), 0);
+  assert_int_equal(save_parking_snapshot_compressed(lot, packed_file), 0);
+  remove(base_file);
+  remove(delta_file);
+  assert_int_equal(save_parking_checkpoint(lot, base_file, delta_file), 0);
+  assert_int_equal(allocate_slot(lot, 500, "丁", "粤N00500", "13800000500",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(save_parking_checkpoint(lot, base_file, delta_file), 1);
+
+  loaded[0] = load_parking_data(text_file);
+  loaded[1] = load_parking_snapshot(snap_file);
+  loaded[2] = load_parking_snapshot_mapped(snap_file);
+  loaded[3] = load_parking_snapshot_lazy(snap_file);
+  loaded[4] = load_parking_snapshot(packed_file);
+  loaded[5] = load_parking_snapshot_lazy(packed_file);
+  loaded[6] = load_parking_checkpoint(base_file, delta_file);
+  assert_non_null(loaded[6]);
+  assert_string_equal(
+      find_slot_by_license(loaded[6], "粤N00500")->owner_name, "丁");
+  for (i = 0; i < 7; i++) {
+    assert_non_null(loaded[i]);
+    assert_int_equal(loaded[i]->total_slots, -1);
+    assert_int_equal(loaded[i]->slot_count, 997);
+    assert_null(find_slot_by_id(loaded[i], 3));
+    free_parking_lot(loaded[i]);
+  }
+
+  free_parking_lot(lot);
+  for (i = 0; i < 5; i++) {
+    remove_snapshot_files(files[i]);
+  }
+}
+
+/**
+ * @brief 测试按页分块的快照加载。
+ * @details
+ * 车位数足以分给多个加载线程；车辆按编号倒序入场，记录顺序与入场顺序相反，
+ * 验证加载后入场时间链表仍然有序。随后验证最后一页被篡改时加载失败，
+ * 以及没有页表的旧版本快照仍可加载。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_paged_snapshot_load(void **state) {
+  (void)state; /* not used */
+  const char *test_file = "paged_snapshot_test.bin";
+  const int slots = 40000;
+  int page_count = (slots + SNAPSHOT_PAGE_ROWS - 1) / SNAPSHOT_PAGE_ROWS;
+  size_t table_size = (size_t)page_count * 4;
+  size_t records_size = (size_t)slots * SNAPSHOT_RECORD_SIZE;
+  ParkingLot *lot = init_parking_lot(slots);
+  ParkingLot *loaded_lot;
+  ParkingSlot *slot;
+  unsigned char *image;
+  char plate[MAX_LICENSE_LEN];
+  size_t count = 0;
+  FILE *file;
+  int i;
+
+  configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, 1700000000);
+  for (i = 1; i <= slots; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, i % 2 ? "东区" : "西区"), 0);
+  }
+  for (i = slots; i >= 1; i -= 7) {
+    set_parking_clock(lot, 1700000000 + (time_t)(slots - i));
+    snprintf(plate, sizeof(plate), "粤B%05d", i);
+    assert_int_equal(
+        allocate_slot(lot, i, "车主", plate, "13800000000", RESIDENT_TYPE), 0);
+  }
+  assert_int_equal(save_parking_snapshot(lot, test_file), 0);
+
+  loaded_lot = load_parking_snapshot_mapped(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->slot_count, slots);
+  assert_int_equal(loaded_lot->occupied_slots, lot->occupied_slots);
+  assert_string_equal(find_slot_by_id(loaded_lot, 12345)->location, "东区");
+  assert_int_equal(find_slot_by_license(loaded_lot, "粤B00002")->slot_id, 2);
+  for (slot = loaded_lot->entry_order.oldest; slot != NULL;
+       slot = slot->entry_next) {
+    if (slot->entry_next != NULL) {
+      assert_true(slot->entry_time <= slot->entry_next->entry_time);
+    }
+    count++;
+  }
+  assert_int_equal(count, (size_t)loaded_lot->occupied_slots);
+  assert_int_equal(loaded_lot->entry_order.newest->slot_id, 2);
+  free_parking_lot(loaded_lot);
+
+  image = (unsigned char *)malloc(SNAPSHOT_HEADER_SIZE + table_size +
+                                  records_size);
+  assert_non_null(image);
+  file = fopen(test_file, "rb");
+  assert_non_null(file);
+  assert_int_equal(fread(image, 1, SNAPSHOT_HEADER_SIZE + table_size +
+                                       records_size, file),
+                   SNAPSHOT_HEADER_SIZE + table_size + records_size);
+  fclose(file);
+
+  /* 篡改最后一页的一个字节：页表本身完好，由该页的校验和发现 */
+  file = fopen(test_file, "r+b");
+  assert_non_null(file);
+  fseek(file, (long)(SNAPSHOT_HEADER_SIZE + table_size + records_size - 1),
+        SEEK_SET);
+  fputc('X', file);
+  fclose(file);
+  assert_null(load_parking_snapshot(test_file));
+  assert_null(load_parking_snapshot_mapped(test_file));
+
+  /* 去掉页表、整个记录区一个校验和的版本 1 快照 */
+  memmove(image + SNAPSHOT_HEADER_SIZE,
+          image + SNAPSHOT_HEADER_SIZE + table_size, records_size);
+  codec_put_u32(image + 8, 1);
+  codec_put_u32(image + 28,
+                codec_checksum(image + SNAPSHOT_HEADER_SIZE, records_size));
+  codec_put_u32(image + 32, codec_checksum(image, 32));
+  file = fopen(test_file, "wb");
+  assert_non_null(file);
+  fwrite(image, 1, SNAPSHOT_HEADER_SIZE + records_size, file);
+  fclose(file);
+  free(image);
+  loaded_lot = load_parking_snapshot(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->occupied_slots, lot->occupied_slots);
+  assert_int_equal(find_slot_by_license(loaded_lot, "粤B40000")->slot_id,
+                   40000);
+  free_parking_lot(loaded_lot);
+
+  free_parking_lot(lot);
+  remove_snapshot_files(test_file);
+}
+
+/**
+ * @brief 测试随快照保存的索引映像。
+ * @details
+ * 车辆按编号倒序入场、部分入场时刻相同，映像加载的编号、车牌查找与
+ * 入场时间链表须与删除映像后重建的结果逐一相同。随后验证映像被截断、
+ * 或换成另一份快照的映像时被弃用，停车场照常重建。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_index_image_load(void **state) {
+  (void)state; /* not used */
+  const char *test_file = "index_image_test.bin";
+  const char *other_file = "index_image_other.bin";
+  char image_path[64];
+  char other_image[64];
+  char plate[MAX_LICENSE_LEN];
+  ParkingLot *lot = init_parking_lot(3000);
+  ParkingLot *rebuilt;
+  ParkingLot *loaded_lot;
+  ParkingSlot *a;
+  ParkingSlot *b;
+  unsigned char *bytes;
+  long size;
+  FILE *file;
+  int i;
+
+  snprintf(image_path, sizeof(image_path), "%s%s", test_file,
+           INDEX_IMAGE_SUFFIX);
+  snprintf(other_image, sizeof(other_image), "%s%s", other_file,
+           INDEX_IMAGE_SUFFIX);
+  configure_parking_clock(lot, PARKING_CLOCK_VIRTUAL, 1700000000);
+  for (i = 1; i <= 3000; i++) {
+    assert_int_equal(create_and_add_slot(lot, i * 7, "映像"), 0);
+  }
+  for (i = 3000; i >= 1; i -= 3) {
+    set_parking_clock(lot, 1700000000 + (time_t)((3000 - i) / 6));
+    snprintf(plate, sizeof(plate), "苏E%05d", i);
+    assert_int_equal(
+        allocate_slot(lot, i * 7, "车主", plate, "13800000000", RESIDENT_TYPE),
+        0);
+  }
+  assert_int_equal(delete_slot(lot, 700), 0);
+  assert_int_equal(save_parking_snapshot(lot, test_file), 0);
+
+  loaded_lot = load_parking_data(test_file);
+  assert_non_null(loaded_lot);
+  file = fopen(image_path, "rb");
+  assert_non_null(file);
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  rewind(file);
+  assert_true(size > INDEX_IMAGE_HEADER_SIZE);
+  bytes = (unsigned char *)malloc((size_t)size);
+  assert_non_null(bytes);
+  assert_int_equal(fread(bytes, 1, (size_t)size, file), (size_t)size);
+  fclose(file);
+  remove(image_path);
+  rebuilt = load_parking_snapshot(test_file);
+  assert_non_null(rebuilt);
+
+  assert_int_equal(loaded_lot->slot_count, rebuilt->slot_count);
+  assert_int_equal(loaded_lot->occupied_slots, lot->occupied_slots);
+  assert_null(find_slot_by_id(loaded_lot, 700));
+  for (i = 1; i <= 3000; i++) {
+    a = find_slot_by_id(loaded_lot, i * 7);
+    b = find_slot_by_id(rebuilt, i * 7);
+    assert_true((a == NULL) == (b == NULL));
+    if (a != NULL) {
+      assert_int_equal(a->table_index, b->table_index);
+    }
+    snprintf(plate, sizeof(plate), "苏E%05d", i);
+    a = find_slot_by_license(loaded_lot, plate);
+    b = find_slot_by_license(rebuilt, plate);
+    assert_true((a == NULL) == (b == NULL));
+    if (a != NULL) {
+      assert_int_equal(a->slot_id, b->slot_id);
+    }
+  }
+  assert_int_equal(loaded_lot->entry_order.count, rebuilt->entry_order.count);
+  for (a = loaded_lot->entry_order.oldest, b = rebuilt->entry_order.oldest;
+       a != NULL && b != NULL; a = a->entry_next, b = b->entry_next) {
+    assert_int_equal(a->slot_id, b->slot_id);
+  }
+  assert_null(a);
+  assert_null(b);
+  assert_int_equal(deallocate_slot(loaded_lot, 21), 0);
+  assert_null(find_slot_by_license(loaded_lot, "苏E00003"));
+  assert_int_equal(create_and_add_slot(loaded_lot, 700, "映像"), 0);
+  assert_int_equal(find_slot_by_id(loaded_lot, 700)->slot_id, 700);
+  free_parking_lot(rebuilt);
+  free_parking_lot(loaded_lot);
+
+  /* 截断的映像被弃用 */
+  file = fopen(image_path, "wb");
+  assert_non_null(file);
+  fwrite(bytes, 1, (size_t)size - 4, file);
+  fclose(file);
+  loaded_lot = load_parking_snapshot_mapped(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(find_slot_by_license(loaded_lot, "苏E03000")->slot_id,
+                   21000);
+  free_parking_lot(loaded_lot);
+
+  /* 另一份快照的映像代号不符，被弃用 */
+  assert_int_equal(deallocate_slot(lot, 21000), 0);
+  assert_int_equal(save_parking_snapshot(lot, other_file), 0);
+  remove(image_path);
+  assert_int_equal(rename(other_image, image_path), 0);
+  loaded_lot = load_parking_snapshot(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(find_slot_by_license(loaded_lot, "苏E03000")->slot_id,
+                   21000);
+  free_parking_lot(loaded_lot);
+
+  free(bytes);
+  free_parking_lot(lot);
+  remove_snapshot_files(other_file);
+  remove_snapshot_files(test_file);
+}
+
+/**
+ * @brief 测试延迟加载的快照。
+ * @details 冷文本直接引用文件映射，不占用文本内存池；修改与出场后
+ *          新文本照常从内存池分配，被替换的映射文本不会归还内存池。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_lazy_snapshot_load(void **state) {
+  (void)state; /* not used */
+  const char *test_file = "lazy_snapshot_test.bin";
+  ParkingLot *lot = init_parking_lot(10);
+  ParkingLot *loaded_lot;
+  ParkingSlot *slot;
+
+  assert_int_equal(create_and_add_slot(lot, 1, "东区"), 0);
+  assert_int_equal(create_and_add_slot(lot, 2, "东区"), 0);
+  assert_int_equal(allocate_slot(lot, 1, "李四", "京A12345", "13900000000",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(save_parking_snapshot(lot, test_file), 0);
+  free_parking_lot(lot);
+
+  loaded_lot = load_parking_snapshot_lazy(test_file);
+  assert_non_null(loaded_lot);
+  assert_non_null(loaded_lot->text_mapping);
+  assert_int_equal(loaded_lot->strings.text.live_blocks, 0);
+  slot = find_slot_by_license(loaded_lot, "京A12345");
+  assert_non_null(slot);
+  assert_true(string_store_is_borrowed(&loaded_lot->strings, slot->contact));
+  assert_string_equal(slot->contact, "13900000000");
+  assert_ptr_equal(find_slot_by_id(loaded_lot, 2)->owner_name,
+                   string_store_empty);
+
+  assert_int_equal(
+      update_slot_info_in_lot(loaded_lot, 1, NULL, NULL, "13700000000"), 0);
+  assert_false(string_store_is_borrowed(&loaded_lot->strings, slot->contact));
+  assert_int_equal(loaded_lot->strings.text.live_blocks, 1);
+  assert_int_equal(deallocate_slot(loaded_lot, 1), 0);
+  assert_int_equal(loaded_lot->strings.text.live_blocks, 0);
+  assert_int_equal(
+      allocate_slot(loaded_lot, 2, "王五", "京B00001", "", RESIDENT_TYPE), 0);
+  assert_int_equal(find_slot_by_license(loaded_lot, "京B00001")->slot_id, 2);
+  free_parking_lot(loaded_lot);
+
+  assert_null(load_parking_snapshot_lazy("no_such_snapshot.bin"));
+  remove_snapshot_files(test_file);
+}
+
+/**
+ * @brief 测试写时复制快照。
+ * @details
+ * 开始快照后继续入场、出场、修改信息、删除和新增车位，
+ * 验证写出的二进制与文本文件都是开始快照那一刻的停车场。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_copy_on_write_snapshot(void **state) {
+  (void)state; /* not used */
+  const char *binary_file = "cow_snapshot_test.bin";
+  const char *text_file = "cow_snapshot_test.txt";
+  ParkingLot *lot = init_parking_lot(700);
+  ParkingLot *loaded_lot;
+  ParkingSnapshot snapshot;
+  ParkingSnapshot other;
+  ParkingSlot *slot;
+  int pass;
+  int i;
+
+  for (i = 1; i <= 600; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "COW"), 0);
+  }
+  assert_int_equal(
+      allocate_slot(lot, 5, "张三", "沪C00005", "139", RESIDENT_TYPE), 0);
+
+  assert_int_equal(begin_parking_snapshot(lot, &snapshot), 0);
+  assert_int_equal(snapshot.page_count, 3);
+  assert_int_equal(begin_parking_snapshot(lot, &other), -1);
+  assert_int_equal(fill_parking_snapshot(lot, &snapshot, 1), 2);
+  assert_int_equal(write_parking_snapshot(&snapshot, binary_file), -1);
+
+  /* 快照开始之后的修改都不应出现在文件中 */
+  assert_int_equal(deallocate_slot(lot, 5), 0);
+  assert_int_equal(
+      allocate_slot(lot, 400, "李四", "沪C00400", "138", RESIDENT_TYPE), 0);
+  assert_int_equal(update_slot_info_in_lot(lot, 550, "B2", NULL, NULL), 0);
+  assert_int_equal(delete_slot(lot, 10), 0);
+  assert_int_equal(create_and_add_slot(lot, 601, "NEW"), 0);
+  assert_int_equal(snapshot.pages_left, 0);
+
+  assert_int_equal(fill_parking_snapshot(lot, &snapshot, 0), 0);
+  assert_int_equal(write_parking_snapshot(&snapshot, binary_file), 0);
+  assert_int_equal(write_parking_snapshot_text(&snapshot, text_file), 0);
+  end_parking_snapshot(lot, &snapshot);
+  assert_null(lot->snapshot);
+
+  for (pass = 0; pass < 2; pass++) {
+    loaded_lot = load_parking_data(pass == 0 ? binary_file : text_file);
+    assert_non_null(loaded_lot);
+    assert_int_equal(loaded_lot->slot_count, 600);
+    assert_int_equal(loaded_lot->occupied_slots, 1);
+    slot = find_slot_by_license(loaded_lot, "沪C00005");
+    assert_non_null(slot);
+    assert_int_equal(slot->slot_id, 5);
+    assert_string_equal(slot->owner_name, "张三");
+    assert_null(find_slot_by_license(loaded_lot, "沪C00400"));
+    assert_string_equal(find_slot_by_id(loaded_lot, 550)->location, "COW");
+    assert_non_null(find_slot_by_id(loaded_lot, 10));
+    assert_non_null(find_slot_by_id(loaded_lot, 600));
+    assert_null(find_slot_by_id(loaded_lot, 601));
+    free_parking_lot(loaded_lot);
+  }
+
+  free_parking_lot(lot);
+  remove(binary_file);
+  remove(text_file);
+}
+
+/**
+ * @brief 测试预写日志的记录与恢复。
+ * @details
+ * 启用日志后执行一系列修改，不压缩直接丢弃停车场，再从快照和日志恢复，
+ * 验证状态与计数器一致；日志末尾的残缺记录在恢复时被忽略。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_write_ahead_journal(void **state) {
+  (void)state; /* not used */
+  const char *snapshot_file = "journal_test.bin";
+  const char *journal_file = "journal_test.wal";
+  ParkingLot *lot = init_parking_lot(10);
+  ParkingLot *recovered;
+  ParkingSlot *slot;
+  FILE *file;
+  int i;
+
+  for (i = 1; i <= 4; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "WAL-A"), 0);
+  }
+  assert_int_equal(enable_parking_journal(lot, snapshot_file, journal_file), 0);
+
+  assert_int_equal(create_and_add_slot(lot, 5, "WAL-B"), 0);
+  assert_int_equal(delete_slot(lot, 2), 0);
+  assert_int_equal(allocate_slot(lot, 3, "李四", "京J00003", "13800000003",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(allocate_slot(lot, 4, "王五", "京J00004", "13800000004",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(deallocate_slot(lot, 4), 0);
+  find_slot_by_id(lot, 3)->resident_due_date = 1800000000;
+  assert_int_equal(sync_slot_hot_fields(lot, find_slot_by_id(lot, 3)), 0);
+  assert_int_equal(update_slot_info_in_lot(lot, 1, "WAL-C", NULL, NULL), 0);
+  assert_int_equal(update_slot_info_in_lot(lot, 99, "WAL-C", NULL, NULL), -2);
+  assert_false(parking_journal_failed(lot));
+  free_parking_lot(lot);
+
+  /* 日志尾部写入一半的记录应被忽略 */
+  file = fopen(journal_file, "ab");
+  assert_non_null(file);
+  fputc(JOURNAL_OP_DELETE_SLOT, file);
+  fputc(0, file);
+  fclose(file);
+
+  recovered = load_parking_journaled(snapshot_file, journal_file);
+  assert_non_null(recovered);
+  assert_int_equal(recovered->slot_count, 4);
+  assert_null(find_slot_by_id(recovered, 2));
+  assert_string_equal(find_slot_by_id(recovered, 5)->location, "WAL-B");
+  assert_string_equal(find_slot_by_id(recovered, 1)->location, "WAL-C");
+  assert_int_equal(recovered->occupied_slots, 1);
+  assert_int_equal(recovered->free_slot_count, 3);
+  assert_int_equal(find_slot_by_id(recovered, 4)->status, FREE_STATUS);
+  assert_null(find_slot_by_license(recovered, "京J00004"));
+  slot = find_slot_by_license(recovered, "京J00003");
+  assert_non_null(slot);
+  assert_int_equal(slot->slot_id, 3);
+  assert_string_equal(slot->owner_name, "李四");
+  assert_true(slot->resident_due_date == 1800000000);
+
+  /* 恢复后继续记录，压缩后日志清空但状态不变 */
+  assert_int_equal(deallocate_slot(recovered, 3), 0);
+  assert_int_equal(compact_parking_journal(recovered), 0);
+  assert_int_equal(recovered->journal->record_count, 0);
+  free_parking_lot(recovered);
+
+  recovered = load_parking_journaled(snapshot_file, journal_file);
+  assert_non_null(recovered);
+  assert_int_equal(recovered->occupied_slots, 0);
+  assert_int_equal(recovered->slot_count, 4);
+  disable_parking_journal(recovered);
+  assert_int_equal(compact_parking_journal(recovered), -1);
+  free_parking_lot(recovered);
+
+  remove_snapshot_files(snapshot_file);
+  remove(journal_file);
+}
+
+/**
+ * @brief 记录批量落盘通知的测试上下文。
+ */
+typedef struct {
+  int batches;              /**< 收到的通知次数。 */
+  unsigned long first_seq;  /**< 最近一批的第一条序号。 */
+  unsigned long last_seq;   /**< 最近一批的最后一条序号。 */
+} DurableLog;
+
+/**
+ * @brief 批量落盘通知回调，记录最近一批的序号区间。
+ */
+static void record_durable(unsigned long first_seq, unsigned long last_seq,
+                           time_t durable_at, void *ctx) {
+  DurableLog *log = (DurableLog *)ctx;
+  (void)durable_at;
+  log->batches++;
+  log->first_seq = first_seq;
+  log->last_seq = last_seq;
+}
+
+/**
+ * @brief 测试预写日志的批量提交。
+ * @details
+ * 验证记录按批次同步并报告序号区间，显式刷新会同步不足一批的尾部，
+ * 且批量模式下写入的记录同样可以完整恢复。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_journal_group_commit(void **state) {
+  (void)state; /* not used */
+  const char *snapshot_file = "group_commit_test.bin";
+  const char *journal_file = "group_commit_test.wal";
+  ParkingLot *lot = init_parking_lot(10);
+  ParkingLot *recovered;
+  DurableLog log = {0, 0, 0};
+  unsigned long appended;
+  unsigned long durable;
+
+  assert_int_equal(configure_parking_journal_batch(lot, 3, 0, NULL, NULL), -1);
+  assert_int_equal(enable_parking_journal(lot, snapshot_file, journal_file), 0);
+  assert_int_equal(configure_parking_journal_batch(lot, 0, 0, NULL, NULL), -1);
+  assert_int_equal(
+      configure_parking_journal_batch(lot, 3, 60, record_durable, &log), 0);
+
+  assert_int_equal(create_and_add_slot(lot, 1, "GC"), 0);
+  assert_int_equal(create_and_add_slot(lot, 2, "GC"), 0);
+  assert_int_equal(parking_journal_progress(lot, &appended, &durable), 0);
+  assert_true(appended == 2 && durable == 0);
+  assert_int_equal(log.batches, 0);
+
+  /* 第三条记录凑满一批，一次同步覆盖序号 1..3 */
+  assert_int_equal(allocate_slot(lot, 1, "赵六", "粤B00001", "13700000001",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(log.batches, 1);
+  assert_true(log.first_seq == 1 && log.last_seq == 3);
+
+  /* 不足一批的尾部由显式刷新同步 */
+  assert_int_equal(create_and_add_slot(lot, 3, "GC"), 0);
+  assert_int_equal(log.batches, 1);
+  assert_int_equal(poll_parking_journal(lot), 0); /* 时间窗口未到 */
+  assert_int_equal(log.batches, 1);
+  assert_int_equal(flush_parking_journal(lot), 0);
+  assert_int_equal(log.batches, 2);
+  assert_true(log.first_seq == 4 && log.last_seq == 4);
+  assert_int_equal(flush_parking_journal(lot), 0); /* 无待同步记录 */
+  assert_int_equal(log.batches, 2);
+  free_parking_lot(lot);
+
+  recovered = load_parking_journaled(snapshot_file, journal_file);
+  assert_non_null(recovered);
+  assert_int_equal(recovered->slot_count, 3);
+  assert_int_equal(recovered->occupied_slots, 1);
+  assert_non_null(find_slot_by_license(recovered, "粤B00001"));
+  assert_int_equal(parking_journal_progress(recovered, &appended, &durable), 0);
+  assert_true(appended == 0 && durable == 0);
+  free_parking_lot(recovered);
+
+  remove_snapshot_files(snapshot_file);
+  remove(journal_file);
+}
+
+/**
+ * @brief 生成本地时间某月 15 日中午的时间戳。
+ * @param year 年份。
+ * @param month 月份 (1-12)。
+ * @return 对应的时间戳。
+ */
+static time_t mid_month(int year, int month) {
+  struct tm parts;
+
+  memset(&parts, 0, sizeof(parts));
+  parts.tm_year = year - 1900;
+  parts.tm_mon = month - 1;
+  parts.tm_mday = 15;
+  parts.tm_hour = 12;
+  parts.tm_isdst = -1;
+  return mktime(&parts);
+}
+
+/**
+ * @brief 测试收费台账的月度汇总与持久化。
+ * @details
+ * 验证逐月总额与区间总额（含中间的空月和更早月份的补录），
+ * 重新打开后月表由文件重建、截断的尾部被忽略，且拒绝打开非台账文件。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_payment_ledger(void **state) {
+  (void)state; /* not used */
+  const char *ledger_file = "payment_ledger_test.led";
+  ParkingLot *lot = init_parking_lot(10);
+  FILE *file;
+
+  remove(ledger_file);
+  assert_double_equal(get_monthly_payment_total(lot, 2026, 3), 0.0, 0.001);
+  assert_int_equal(record_parking_payment(lot, 1, VISITOR_TYPE,
+                                          mid_month(2026, 3), 500),
+                   0); /* 未启用台账，不记录 */
+  assert_int_equal(enable_payment_ledger(lot, ledger_file), 0);
+
+  assert_int_equal(record_parking_payment(lot, 1, VISITOR_TYPE,
+                                          mid_month(2026, 3), 750),
+                   0);
+  assert_int_equal(record_parking_payment(lot, 2, RESIDENT_TYPE,
+                                          mid_month(2026, 3), 20000),
+                   0);
+  assert_int_equal(record_parking_payment(lot, 1, VISITOR_TYPE,
+                                          mid_month(2026, 5), 250),
+                   0);
+  assert_int_equal(record_parking_payment(lot, 3, VISITOR_TYPE,
+                                          mid_month(2025, 12), 1000),
+                   0); /* 早于月表第一个月 */
+  assert_int_equal(record_parking_payment(lot, 3, VISITOR_TYPE,
+                                          mid_month(2026, 4), 0),
+                   0); /* 零金额不记录 */
+
+  assert_double_equal(get_monthly_payment_total(lot, 2026, 3), 207.5, 0.001);
+  assert_double_equal(get_monthly_payment_total(lot, 2026, 4), 0.0, 0.001);
+  assert_double_equal(get_monthly_payment_total(lot, 2025, 12), 10.0, 0.001);
+  assert_double_equal(get_monthly_payment_total(lot, 2026, 13), -1.0, 0.001);
+  assert_int_equal(ledger_month_total(lot->ledger, 2026, 3, VISITOR_TYPE), 750);
+  assert_int_equal(ledger_range_total(lot->ledger, 2026, 1, 2026, 12), 21000);
+  assert_int_equal(ledger_range_total(lot->ledger, 2020, 1, 2030, 1), 22000);
+  assert_int_equal(lot->ledger->record_count, 4);
+  free_parking_lot(lot);
+
+  /* 追加半条记录模拟写入中断 */
+  file = fopen(ledger_file, "ab");
+  assert_non_null(file);
+  fwrite("PART", 1, 4, file);
+  fclose(file);
+
+  lot = init_parking_lot(10);
+  assert_int_equal(enable_payment_ledger(lot, ledger_file), 0);
+  assert_int_equal(lot->ledger->record_count, 4);
+  assert_double_equal(get_monthly_payment_total(lot, 2026, 3), 207.5, 0.001);
+  assert_int_equal(record_parking_payment(lot, 4, VISITOR_TYPE,
+                                          mid_month(2026, 5), 100),
+                   0);
+  free_parking_lot(lot);
+
+  lot = init_parking_lot(10);
+  assert_int_equal(enable_payment_ledger(lot, ledger_file), 0);
+  assert_int_equal(lot->ledger->record_count, 5);
+  assert_double_equal(get_monthly_payment_total(lot, 2026, 5), 3.5, 0.001);
+  assert_int_equal(parking_ledger_failed(lot), 0);
+  free_parking_lot(lot);
+
+  /* 不是台账的文件不会被覆盖 */
+  file = fopen(ledger_file, "wb");
+  assert_non_null(file);
+  fputs("not a ledger", file);
+  fclose(file);
+  lot = init_parking_lot(10);
+  assert_int_equal(enable_payment_ledger(lot, ledger_file), -2);
+  assert_null(lot->ledger);
+  free_parking_lot(lot);
+  remove(ledger_file);
+}
+
+/**
+ * @brief 累加月费结算开出的账单。
+ */
+typedef struct {
+  int invoices;      /**< 账单数。 */
+  int periods;       /**< 周期数之和。 */
+  long amount_cents; /**< 金额之和（分）。 */
+} InvoiceTally;
+
+/**
+ * @brief bill_resident_subscriptions 的回调：累加账单。
+ */
+static void tally_resident_invoice(const ResidentInvoice *invoice, void *ctx) {
+  InvoiceTally *tally = (InvoiceTally *)ctx;
+
+  assert_true(invoice->period_end > invoice->period_start);
+  tally->invoices++;
+  tally->periods += invoice->periods;
+  tally->amount_cents += invoice->amount_cents;
+}
+
+/**
+ * @brief 测试居民月费批量结算：自然月顺延、按列筛选与台账批量追加。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_resident_billing(void **state) {
+  (void)state; /* not used */
+  const char *ledger_file = "resident_billing_test.led";
+  ParkingLot *lot = init_parking_lot(100);
+  InvoiceTally tally = {0, 0, 0};
+  time_t due[4] = {0, 100, 200, 300};
+  struct tm moment;
+  time_t jan31;
+  time_t now;
+  int i;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mday = 31;
+  moment.tm_hour = 9;
+  moment.tm_isdst = -1;
+  jan31 = mktime(&moment);
+
+  /* 月末到期顺延到下月最后一天，之后仍从原日期推算 */
+  moment.tm_mon = 1;
+  moment.tm_mday = 28;
+  moment.tm_isdst = -1;
+  assert_true(parking_calendar_add_months(jan31, 1) == mktime(&moment));
+  moment.tm_mon = 2;
+  moment.tm_mday = 31;
+  moment.tm_isdst = -1;
+  assert_true(parking_calendar_add_months(jan31, 2) == mktime(&moment));
+  assert_int_equal(column_match_time(due, 4, 100, 300), 0x6UL);
+  assert_int_equal(column_match_time(due, 4, 1, 1), 0UL);
+
+  remove(ledger_file);
+  assert_int_equal(enable_payment_ledger(lot, ledger_file), 0);
+  /* 70 个车位跨过一个位图字：1-69 为居民、70 为访客 */
+  for (i = 1; i <= 70; i++) {
+    char plate[16];
+    ParkingSlot *slot;
+
+    sprintf(plate, "京A%05d", i);
+    assert_int_equal(create_and_add_slot(lot, i, "B"), 0);
+    assert_int_equal(allocate_slot(lot, i, "车主", plate, "13800000000",
+                                   i == 70 ? VISITOR_TYPE : RESIDENT_TYPE),
+                     0);
+    slot = find_slot_by_id(lot, i);
+    slot->resident_due_date = jan31;
+    assert_int_equal(sync_slot_hot_fields(lot, slot), 0);
+  }
+  /* 居民 5 离场后仍需按月缴费；居民 6 已预缴到 4 月 */
+  assert_int_equal(deallocate_slot(lot, 5), 0);
+  find_slot_by_id(lot, 6)->resident_due_date =
+      parking_calendar_add_months(jan31, 3);
+  assert_int_equal(sync_slot_hot_fields(lot, find_slot_by_id(lot, 6)), 0);
+
+  /* 3 月 1 日：1 月 31 日到期的居民欠两期，顺延到 3 月 31 日 */
+  moment.tm_mon = 2;
+  moment.tm_mday = 1;
+  moment.tm_isdst = -1;
+  now = mktime(&moment);
+  assert_int_equal(
+      bill_resident_subscriptions(lot, now, tally_resident_invoice, &tally),
+      68);
+  assert_int_equal(tally.invoices, 68);
+  assert_int_equal(tally.periods, 2 * 68);
+  assert_int_equal(tally.amount_cents, 2 * 68 * 20000L);
+  assert_true(find_slot_by_id(lot, 5)->resident_due_date ==
+              parking_calendar_add_months(jan31, 2));
+  assert_true(find_slot_by_id(lot, 69)->resident_due_date ==
+              parking_calendar_add_months(jan31, 2));
+  assert_true(find_slot_by_id(lot, 6)->resident_due_date ==
+              parking_calendar_add_months(jan31, 3));
+  assert_true(find_slot_by_id(lot, 70)->resident_due_date == jan31);
+  assert_int_equal(lot->ledger->record_count, 68);
+  assert_int_equal(ledger_month_total(lot->ledger, 2026, 3, RESIDENT_TYPE),
+                   2 * 68 * 20000L);
+
+  /* 同一时刻再结算不会重复开账单；台账重新打开后记录仍完整 */
+  assert_int_equal(bill_resident_subscriptions(lot, now, NULL, NULL), 0);
+  free_parking_lot(lot);
+  lot = init_parking_lot(10);
+  assert_int_equal(enable_payment_ledger(lot, ledger_file), 0);
+  assert_int_equal(lot->ledger->record_count, 68);
+  free_parking_lot(lot);
+  remove(ledger_file);
+}
+
+/**
+ * @brief 按车牌哈希统计扫描到的停车记录。
+ */
+typedef struct {
+  unsigned long plate_hash; /**< 要统计的车牌哈希。 */
+  long matches;             /**< 匹配的记录数。 */
+  long unexpected_columns;  /**< 读取了未请求列的记录数。 */
+} PlateSessionCount;
+
+/**
+ * @brief 停车记录扫描回调：统计指定车牌的记录。
+ * @param record 当前记录。
+ * @param ctx 指向 PlateSessionCount 的指针。
+ * @return 始终返回 0。
+ */
+static int count_plate_sessions(const SessionRecord *record, void *ctx) {
+  PlateSessionCount *count = (PlateSessionCount *)ctx;
+
+  if (record->plate_hash == count->plate_hash) {
+    count->matches++;
+  }
+  if (record->entry_time != 0 || record->fee_cents != 0) {
+    count->unexpected_columns++;
+  }
+  return 0;
+}
+
+/**
+ * @brief 测试列式停车记录存储。
+ * @details
+ * 跨越多个区块写入停车记录，验证按出场时间区间的扫描与汇总、
+ * 只读取请求的列、重新打开后记录数保持不变，以及某一列多写的尾部被忽略。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_session_history(void **state) {
+  (void)state; /* not used */
+  const char *prefix = "session_history_test";
+  const char *suffixes[] = {".plate", ".slot", ".type",
+                            ".entry", ".exit", ".fee"};
+  const time_t base = 1700000000;
+  ParkingLot *lot = init_parking_lot(10);
+  ParkingSlot *slot;
+  SessionSummary summary;
+  PlateSessionCount count;
+  char path[64];
+  FILE *file;
+  int i;
+
+  for (i = 0; i < 6; i++) {
+    sprintf(path, "%s%s", prefix, suffixes[i]);
+    remove(path);
+  }
+  assert_int_equal(summarize_parking_sessions(lot, 0, base, &summary), -1);
+  assert_int_equal(enable_session_history(lot, prefix), 0);
+  assert_int_equal(create_and_add_slot(lot, 1, "H-1"), 0);
+  assert_int_equal(allocate_slot(lot, 1, "历史", "粤B00001", "13700000001",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(create_and_add_slot(lot, 2, "H-2"), 0);
+  assert_int_equal(allocate_slot(lot, 2, "历史", "粤B00002", "13700000002",
+                                 RESIDENT_TYPE),
+                   0);
+
+  /* 1200 次停车跨越三个区块，第 i 次在 base + i * 60 出场、停车 30 秒 */
+  for (i = 0; i < 1200; i++) {
+    slot = find_slot_by_id(lot, i % 3 == 0 ? 1 : 2);
+    slot->type = i % 2 == 0 ? RESIDENT_TYPE : VISITOR_TYPE;
+    slot->entry_time = base + i * 60 - 30;
+    assert_int_equal(
+        record_parking_session(lot, slot, base + i * 60, i % 2 ? 500 : 0), 0);
+  }
+  assert_int_equal(lot->history->record_count, 1200);
+  assert_int_equal(lot->history->block_count, 3);
+
+  /* 区间 [100, 700) 分钟跨越前两个区块 */
+  assert_int_equal(summarize_parking_sessions(lot, base + 100 * 60,
+                                              base + 700 * 60, &summary),
+                   0);
+  assert_int_equal(summary.sessions, 600);
+  assert_int_equal(summary.visitor_sessions, 300);
+  assert_int_equal(summary.resident_sessions, 300);
+  assert_double_equal(summary.total_fee, 1500.0, 0.001);
+  assert_double_equal(summary.total_duration_seconds, 600 * 30.0, 0.001);
+
+  /* 只请求车牌列时，其他列不被读取 */
+  count.plate_hash = history_plate_hash("粤B00001");
+  count.matches = 0;
+  count.unexpected_columns = 0;
+  assert_int_equal(scan_parking_sessions(lot, base, base + 1200 * 60,
+                                         HISTORY_COLUMN_BIT(HISTORY_COL_PLATE),
+                                         count_plate_sessions, &count),
+                   1200);
+  assert_int_equal(count.matches, 400);
+  assert_int_equal(count.unexpected_columns, 0);
+  free_parking_lot(lot);
+
+  /* 模拟崩溃时只写完了一列 */
+  sprintf(path, "%s%s", prefix, ".slot");
+  file = fopen(path, "ab");
+  assert_non_null(file);
+  fwrite("\1\0\0\0", 1, 4, file);
+  fclose(file);
+
+  lot = init_parking_lot(10);
+  assert_int_equal(enable_session_history(lot, prefix), 0);
+  assert_int_equal(lot->history->record_count, 1200);
+  assert_int_equal(summarize_parking_sessions(lot, base + 1199 * 60,
+                                              base + 1200 * 60, &summary),
+                   0);
+  assert_int_equal(summary.sessions, 1);
+  assert_int_equal(parking_history_failed(lot), 0);
+  free_parking_lot(lot);
+
+  for (i = 0; i < 6; i++) {
+    sprintf(path, "%s%s", prefix, suffixes[i]);
+    remove(path);
+  }
+}
+
+/**
+ * @brief 测试压缩的快照与停车记录。
+ * @details
+ * 压缩快照明显小于未压缩快照，两条加载路径都能还原；篡改压缩数据后加载失败。
+ * 压缩模式的停车记录写满区块后封存到帧文件，扫描结果与普通模式一致，
+ * 重新打开后记录数与汇总不变。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_compressed_persistence(void **state) {
+  (void)state; /* not used */
+  const char *plain_file = "compressed_test_plain.bin";
+  const char *packed_file = "compressed_test_packed.bin";
+  const char *prefix = "compressed_history_test";
+  const char *suffixes[] = {".plate", ".slot", ".type",
+                            ".entry", ".exit", ".fee"};
+  const time_t base = 1700000000;
+  ParkingLot *lot = init_parking_lot(2000);
+  ParkingLot *loaded_lot;
+  ParkingSlot *slot;
+  SessionSummary summary;
+  char path[64];
+  char plate[MAX_LICENSE_LEN];
+  long plain_size;
+  long packed_size;
+  FILE *file;
+  int i;
+
+  for (i = 1; i <= 1500; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, i % 2 ? "东区" : "西区"), 0);
+  }
+  for (i = 1; i <= 1500; i += 3) {
+    snprintf(plate, sizeof(plate), "粤C%05d", i);
+    assert_int_equal(
+        allocate_slot(lot, i, "车主", plate, "13800000000", RESIDENT_TYPE), 0);
+  }
+  assert_int_equal(save_parking_snapshot(lot, plain_file), 0);
+  assert_int_equal(save_parking_snapshot_compressed(lot, packed_file), 0);
+
+  file = fopen(plain_file, "rb");
+  assert_non_null(file);
+  fseek(file, 0, SEEK_END);
+  plain_size = ftell(file);
+  fclose(file);
+  file = fopen(packed_file, "rb");
+  assert_non_null(file);
+  fseek(file, 0, SEEK_END);
+  packed_size = ftell(file);
+  fclose(file);
+  assert_true(packed_size * 4 < plain_size);
+
+  loaded_lot = load_parking_snapshot(packed_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->slot_count, 1500);
+  assert_int_equal(loaded_lot->occupied_slots, lot->occupied_slots);
+  assert_int_equal(find_slot_by_license(loaded_lot, "粤C01000")->slot_id, 1000);
+  free_parking_lot(loaded_lot);
+  loaded_lot = load_parking_data(packed_file);
+  assert_non_null(loaded_lot);
+  assert_string_equal(find_slot_by_id(loaded_lot, 1498)->location, "西区");
+  free_parking_lot(loaded_lot);
+  loaded_lot = load_parking_snapshot_lazy(packed_file);
+  assert_non_null(loaded_lot);
+  assert_null(loaded_lot->text_mapping);
+  free_parking_lot(loaded_lot);
+
+  /* 篡改最后一页的压缩数据 */
+  file = fopen(packed_file, "r+b");
+  assert_non_null(file);
+  fseek(file, packed_size - 20, SEEK_SET);
+  fputc(fgetc(file) ^ 0x5A, file);
+  fclose(file);
+  assert_null(load_parking_snapshot(packed_file));
+  assert_null(load_parking_snapshot_mapped(packed_file));
+  remove_snapshot_files(plain_file);
+  remove(packed_file);
+  free_parking_lot(lot);
+
+  for (i = 0; i < 6; i++) {
+    sprintf(path, "%s%s", prefix, suffixes[i]);
+    remove(path);
+    strcat(path, HISTORY_FRAME_SUFFIX);
+    remove(path);
+  }
+  lot = init_parking_lot(10);
+  assert_int_equal(enable_compressed_session_history(lot, prefix), 0);
+  assert_true(lot->history->compressed);
+  assert_int_equal(create_and_add_slot(lot, 1, "H-1"), 0);
+  assert_int_equal(allocate_slot(lot, 1, "历史", "粤B00001", "13700000001",
+                                 RESIDENT_TYPE),
+                   0);
+  slot = find_slot_by_id(lot, 1);
+  for (i = 0; i < 1200; i++) {
+    slot->type = i % 2 == 0 ? RESIDENT_TYPE : VISITOR_TYPE;
+    slot->entry_time = base + i * 60 - 30;
+    assert_int_equal(
+        record_parking_session(lot, slot, base + i * 60, i % 2 ? 500 : 0), 0);
+  }
+  assert_int_equal(lot->history->sealed_blocks, 2);
+  assert_int_equal(parking_history_failed(lot), 0);
+  assert_int_equal(summarize_parking_sessions(lot, base + 100 * 60,
+                                              base + 1100 * 60, &summary),
+                   0);
+  assert_int_equal(summary.sessions, 1000);
+  assert_int_equal(summary.visitor_sessions, 500);
+  assert_double_equal(summary.total_fee, 2500.0, 0.001);
+  disable_session_history(lot);
+
+  /* 已存在的压缩列文件按原格式打开 */
+  assert_int_equal(enable_session_history(lot, prefix), 0);
+  assert_true(lot->history->compressed);
+  assert_int_equal(lot->history->record_count, 1200);
+  assert_int_equal(lot->history->sealed_blocks, 2);
+  assert_int_equal(summarize_parking_sessions(lot, base + 100 * 60,
+                                              base + 1100 * 60, &summary),
+                   0);
+  assert_int_equal(summary.sessions, 1000);
+  assert_double_equal(summary.total_duration_seconds, 1000 * 30.0, 0.001);
+  free_parking_lot(lot);
+
+  for (i = 0; i < 6; i++) {
+    sprintf(path, "%s%s", prefix, suffixes[i]);
+    remove(path);
+    strcat(path, HISTORY_FRAME_SUFFIX);
+    remove(path);
+  }
+}
+
+/**
+ * @brief (测试辅助函数) 取文件的字节数。
+ * @param filename 文件名。
+ * @return 文件字节数，文件不存在时返回 -1。
+ */
+static long file_size_of(const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  long size;
+
+  if (file == NULL) {
+    return -1;
+  }
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+/**
+ * @brief 测试增量检查点。
+ * @details
+ * 第一次检查点写完整快照；之后只写脏页，增量大小只与修改过的页有关。
+ * 由检查点加载的停车场继续以同一基准写增量，删除车位造成的换位与末页缩短
+ * 也能还原。增量损坏时加载失败；脏页过多时改写完整快照并删除增量。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_incremental_checkpoint(void **state) {
+  (void)state; /* not used */
+  const char *base_file = "checkpoint_test_base.bin";
+  const char *delta_file = "checkpoint_test_delta.bin";
+  ParkingLot *lot = init_parking_lot(2000);
+  ParkingLot *loaded_lot;
+  char plate[MAX_LICENSE_LEN];
+  FILE *file;
+  long size;
+  int i;
+
+  remove(base_file);
+  remove(delta_file);
+  for (i = 1; i <= 1500; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "北区"), 0);
+  }
+  assert_int_equal(save_parking_checkpoint(lot, base_file, delta_file), 0);
+  assert_int_equal(file_size_of(delta_file), -1);
+
+  /* 第 0 页与第 5 页（末页 220 行）被修改 */
+  assert_int_equal(allocate_slot(lot, 1, "甲", "粤D00001", "13800000001",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(allocate_slot(lot, 2, "乙", "粤D00002", "13800000002",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(allocate_slot(lot, 1400, "丙", "粤D01400", "13800001400",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(save_parking_checkpoint(lot, base_file, delta_file), 1);
+  assert_int_equal(file_size_of(delta_file),
+                   SNAPSHOT_DELTA_HEADER_SIZE + 2 * 8 +
+                       (SNAPSHOT_PAGE_ROWS + 220) * SNAPSHOT_RECORD_SIZE);
+  free_parking_lot(lot);
+
+  lot = load_parking_checkpoint(base_file, delta_file);
+  assert_non_null(lot);
+  assert_int_equal(lot->slot_count, 1500);
+  assert_int_equal(lot->occupied_slots, 3);
+  assert_int_equal(find_slot_by_license(lot, "粤D01400")->slot_id, 1400);
+
+  /* 删除第 0 页的车位：表尾车位换到它的位置，末页少一行 */
+  assert_int_equal(delete_slot(lot, 5), 0);
+  assert_int_equal(save_parking_checkpoint(lot, base_file, delta_file), 1);
+  loaded_lot = load_parking_checkpoint(base_file, delta_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->slot_count, 1499);
+  assert_null(find_slot_by_id(loaded_lot, 5));
+  assert_non_null(find_slot_by_id(loaded_lot, 1500));
+  assert_string_equal(find_slot_by_license(loaded_lot, "粤D00002")->owner_name,
+                      "乙");
+  free_parking_lot(loaded_lot);
+
+  size = file_size_of(delta_file);
+  file = fopen(delta_file, "r+b");
+  assert_non_null(file);
+  fseek(file, size - 100, SEEK_SET);
+  fputc(fgetc(file) ^ 0x5A, file);
+  fclose(file);
+  assert_null(load_parking_checkpoint(base_file, delta_file));
+
+  for (i = 10; i <= 1500; i += SNAPSHOT_PAGE_ROWS) {
+    snprintf(plate, sizeof(plate), "粤E%05d", i);
+    assert_int_equal(
+        allocate_slot(lot, i, "丁", plate, "13900000000", RESIDENT_TYPE), 0);
+  }
+  assert_int_equal(save_parking_checkpoint(lot, base_file, delta_file), 0);
+  assert_int_equal(file_size_of(delta_file), -1);
+  assert_int_equal(lot->checkpoint.dirty_count, 0);
+  free_parking_lot(lot);
+
+  lot = load_parking_checkpoint(base_file, delta_file);
+  assert_non_null(lot);
+  assert_int_equal(lot->occupied_slots, 9);
+  free_parking_lot(lot);
+  remove(base_file);
+}
+
+/**
+ * @brief 测试车牌号与车主姓名的三元组子串检索。
+ * @details
+ * 验证子串检索返回全部匹配、短查询串退化为扫描且结果一致、
+ * 出场与修改车主姓名后索引同步，以及大量进出场触发重建后
+ * 结果不重复、删除车位后不残留指向已释放节点的项。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_search_index(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(300);
+  ParkingSlot *found[300];
+  char plate[MAX_LICENSE_LEN];
+  char owner[MAX_NAME_LEN];
+  int i;
+
+  for (i = 1; i <= 200; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, "S"), 0);
+    sprintf(plate, "粤B%05d", i);
+    sprintf(owner, "%s%d", i % 2 ? "张三" : "李四", i);
+    assert_int_equal(
+        allocate_slot(lot, i, owner, plate, "13800000000", RESIDENT_TYPE), 0);
+  }
+
+  /* 粤B0010x 与 粤B00100 共 10 辆 */
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "粤B0010", found, 300),
+                   10);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "B00199", found, 300),
+                   1);
+  assert_int_equal(found[0]->slot_id, 199);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "粤A", found, 300), 0);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_OWNER, "张三", found, 300),
+                   100);
+  /* 不足三个字节的查询串与索引查询结果一致 */
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "99", found, 300), 2);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "199", found, 300), 1);
+  /* 只写入 capacity 个，但返回总数 */
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_OWNER, "李四", found, 3), 100);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_OWNER, "李四", NULL, 0),
+                   100);
+
+  /* 出场与修改姓名后同步 */
+  assert_int_equal(deallocate_slot(lot, 199), 0);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "B00199", found, 300),
+                   0);
+  assert_int_equal(update_slot_info_in_lot(lot, 1, NULL, "王五", NULL), 0);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_OWNER, "王五", found, 300), 1);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_OWNER, "张三1", found, 300),
+                   54); /* 张三11..19 与张三101..197 中的奇数 */
+  assert_ptr_equal(find_slot_by_owner(lot, "王五"), find_slot_by_id(lot, 1));
+
+  /* 同一辆车反复进出场，足以多次触发重建 */
+  for (i = 0; i < 1500; i++) {
+    assert_int_equal(allocate_slot(lot, 199, "赵六", "粤B00199", "13800000000",
+                                   RESIDENT_TYPE),
+                     0);
+    assert_int_equal(deallocate_slot(lot, 199), 0);
+  }
+  assert_true(lot->search_index.stale_entries <=
+              lot->search_index.live_entries + 4096);
+  assert_int_equal(allocate_slot(lot, 199, "赵六", "粤B00199", "13800000000",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "B00199", found, 300),
+                   1);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "粤B0010", found, 300),
+                   10);
+
+  /* 删除曾经有车的车位后，检索不会访问已释放的节点 */
+  assert_int_equal(deallocate_slot(lot, 199), 0);
+  assert_int_equal(delete_slot(lot, 199), 0);
+  assert_int_equal(lot->search_index.stale_entries, 0);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "B00199", found, 300),
+                   0);
+  assert_int_equal(search_slots(lot, SLOT_SEARCH_PLATE, "粤B", found, 300),
+                   199);
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试车位文本字段的驻留与文本内存池复用。
+ * @details 验证相同位置描述共享同一份文本、引用归零后释放，
+ *          车辆反复进出场时文本块被复用而不再分配新区块，
+ *          单独创建的车位加入停车场后文本迁入停车场的存储。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_slot_strings(void **state) {
+  (void)state; /* not used */
+  ParkingLot *lot = init_parking_lot(600);
+  ParkingSlot *slot;
+  char text[MAX_LOCATION_LEN + 20];
+  size_t chunks;
+  int i;
+
+  for (i = 1; i <= 500; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, i % 2 ? "A区" : "B区"), 0);
+  }
+  assert_int_equal(lot->strings.locations.count, 2);
+  assert_ptr_equal(find_slot_by_id(lot, 1)->location,
+                   find_slot_by_id(lot, 499)->location);
+  assert_ptr_equal(find_slot_by_id(lot, 1)->owner_name, string_store_empty);
+
+  /* 反复进出场只复用同级别的文本块 */
+  assert_int_equal(
+      allocate_slot(lot, 1, "张三", "粤B12345", "13800000000", RESIDENT_TYPE),
+      0);
+  chunks = lot->strings.text.chunk_count;
+  assert_int_equal(lot->strings.text.live_blocks, 3);
+  for (i = 0; i < 1000; i++) {
+    assert_int_equal(deallocate_slot(lot, 1), 0);
+    assert_int_equal(allocate_slot(lot, 1, "李四", "粤B54321", "13900000000",
+                                   RESIDENT_TYPE),
+                     0);
+  }
+  assert_int_equal(lot->strings.text.chunk_count, chunks);
+  assert_string_equal(find_slot_by_id(lot, 1)->owner_name, "李四");
+  assert_int_equal(deallocate_slot(lot, 1), 0);
+  assert_int_equal(lot->strings.text.live_blocks, 0);
+
+  /* 超长文本按字段上限截断 */
+  memset(text, 'x', sizeof(text) - 1);
+  text[sizeof(text) - 1] = '\0';
+  assert_int_equal(update_slot_info_in_lot(lot, 2, text, NULL, NULL), 0);
+  assert_int_equal(strlen(find_slot_by_id(lot, 2)->location),
+                   MAX_LOCATION_LEN - 1);
+  assert_int_equal(lot->strings.locations.count, 3);
+
+  /* 删除车位与改名都会释放旧引用 */
+  for (i = 1; i <= 500; i += 2) {
+    assert_int_equal(delete_slot(lot, i), 0);
+  }
+  assert_int_equal(lot->strings.locations.count, 2);
+  assert_int_equal(update_slot_info_in_lot(lot, 2, "B区", NULL, NULL), 0);
+  assert_int_equal(lot->strings.locations.count, 1);
+
+  /* 单独创建的车位加入停车场后与已有车位共享位置文本 */
+  slot = create_parking_slot(501, "B区");
+  assert_non_null(slot);
+  assert_null(slot->strings);
+  assert_int_equal(add_parking_slot(lot, slot), 0);
+  assert_ptr_equal(slot->strings, &lot->strings);
+  assert_ptr_equal(slot->location, find_slot_by_id(lot, 4)->location);
+  assert_int_equal(lot->strings.locations.count, 1);
+
+  free_parking_lot(lot);
+}
+
+/**
+ * @brief 测试用的分配函数上下文：统计在用块数，并可在指定次数后注入失败。
+ */
+typedef struct CountingAllocator {
+  long live;       /**< 尚未释放的块数。 */
+  long calls;      /**< allocate 被调用的次数。 */
+  long fail_after; /**< 第几次 allocate 开始失败，0 表示从不失败。 */
+} CountingAllocator;
+
+/**
+ * @brief 测试用的分配函数。
+ */
+static void *counting_allocate(size_t size, void *ctx) {
+  CountingAllocator *counter = (CountingAllocator *)ctx;
+  void *ptr;
+
+  counter->calls++;
+  if (counter->fail_after > 0 && counter->calls >= counter->fail_after) {
+    return NULL;
+  }
+  ptr = malloc(size);
+  if (ptr) {
+    counter->live++;
+  }
+  return ptr;
+}
+
+/**
+ * @brief 测试用的释放函数。
+ */
+static void counting_release(void *ptr, void *ctx) {
+  ((CountingAllocator *)ctx)->live--;
+  free(ptr);
+}
+
+/**
+ * @brief 测试可替换的分配函数与按类别的内存统计。
+ * @details 未提供 reallocate，扩容走 allocate + 复制 + release 的路径。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_memory_accounting(void **state) {
+  CountingAllocator counter = {0, 0, 0};
+  ParkingAllocator allocator;
+  ParkingMemoryStats stats;
+  ParkingLot *lot;
+  int i;
+
+  (void)state; /* not used */
+  allocator.allocate = counting_allocate;
+  allocator.reallocate = NULL;
+  allocator.release = counting_release;
+  allocator.ctx = &counter;
+
+  lot = init_parking_lot_with_allocator(200, &allocator);
+  assert_non_null(lot);
+  get_parking_memory_stats(lot, &stats);
+  assert_int_equal(stats.objects[PARKING_MEMORY_LOT], 1);
+  assert_int_equal(stats.bytes[PARKING_MEMORY_LOT], (long)sizeof(ParkingLot));
+
+  for (i = 1; i <= 100; i++) {
+    assert_int_equal(create_and_add_slot(lot, i, i % 2 ? "A区" : "B区"), 0);
+  }
+  assert_int_equal(
+      allocate_slot(lot, 1, "张三", "粤B12345", "13800000000", RESIDENT_TYPE),
+      0);
+  get_parking_memory_stats(lot, &stats);
+  assert_true(stats.bytes[PARKING_MEMORY_SLOTS] > 0);
+  assert_true(stats.bytes[PARKING_MEMORY_TABLE] >=
+              100 * (long)sizeof(ParkingSlot *));
+  assert_true(stats.bytes[PARKING_MEMORY_INDEX] > 0);
+  assert_true(stats.bytes[PARKING_MEMORY_STRINGS] > 0);
+  assert_int_equal(stats.bytes[PARKING_MEMORY_IO], 0);
+  assert_int_equal(stats.total_objects, counter.live);
+  assert_int_equal(stats.overhead_bytes,
+                   stats.total_objects * PARKING_MEMORY_HEADER_BYTES);
+  assert_true(stats.peak_bytes >= stats.total_bytes);
+  assert_int_equal(stats.failures, 0);
+  assert_string_equal(parking_memory_category_name(PARKING_MEMORY_INDEX),
+                      "index");
+
+  /* 释放停车场后分配函数分出的内存全部归还 */
+  free_parking_lot(lot);
+  assert_int_equal(counter.live, 0);
+
+  /* 分配失败时报告错误并计数，已分配的部分仍能完整释放 */
+  counter.calls = 0;
+  lot = init_parking_lot_with_allocator(200, &allocator);
+  assert_non_null(lot);
+  /* 建立时已按设计容量预分配车位表与索引，让其后的下一次分配失败 */
+  counter.fail_after = counter.calls + 1;
+  for (i = 1; i <= 200 && create_and_add_slot(lot, i, "C区") == 0; i++) {
+  }
+  assert_true(i <= 200);
+  get_parking_memory_stats(lot, &stats);
+  assert_true(stats.failures > 0);
+  free_parking_lot(lot);
+  assert_int_equal(counter.live, 0);
+
+  counter.calls = 0;
+  counter.fail_after = 1;
+  assert_null(init_parking_lot_with_allocator(200, &allocator));
+  assert_int_equal(counter.live, 0);
+}
+
+/**
+ * @brief 测试 `save_parking_data` 和 `load_parking_data` 的数据持久化功能。
+ * @details
+ * 验证停车场数据能否被成功保存到文件，并能从文件正确加载回来，同时保持数据的一致性。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_data_persistence(void **state) {
+  (void)state; /* not used */
+  const char *test_file = "persistence_test.txt";
+  ParkingLot *lot_to_save = init_parking_lot(5);
+  add_parking_slot(lot_to_save, create_parking_slot(1, "P-1"));
+  add_parking_slot(lot_to_save, create_parking_slot(2, "P-2")); /* 一个空闲车位 */
+  allocate_slot(lot_to_save, 1, "PersistentUser", "沪A12123", "12312341234",
+                RESIDENT_TYPE);
+
+  /* 1. 测试保存 */
+  int save_result = save_parking_data(lot_to_save, test_file);
+  assert_int_equal(save_result, 0);
+
+  /* 2. 测试加载 */
+  ParkingLot *loaded_lot = load_parking_data(test_file);
+  assert_non_null(loaded_lot);
+
+  /* 3. 验证加载后的数据 */
+  if (loaded_lot) {
+    assert_int_equal(loaded_lot->total_slots, 5);
+    assert_int_equal(loaded_lot->occupied_slots, 1);
+
+    ParkingSlot *loaded_slot_1 = find_slot_by_id(loaded_lot, 1);
+    assert_non_null(loaded_slot_1);
+    assert_int_equal(loaded_slot_1->status, OCCUPIED_STATUS);
+    assert_string_equal(loaded_slot_1->owner_name, "PersistentUser");
+    assert_ptr_equal(find_slot_by_license(loaded_lot, "沪A12123"),
+                     loaded_slot_1);
+
+    ParkingSlot *loaded_slot_2 = find_slot_by_id(loaded_lot, 2);
+    assert_non_null(loaded_slot_2);
+    assert_int_equal(loaded_slot_2->status, FREE_STATUS);
+  }
+
+  free_parking_lot(lot_to_save);
+  if (loaded_lot) {
+    free_parking_lot(loaded_lot);
+  }
+  remove(test_file);
+}
+
+/**
+ * @brief 把字符串写成文件。
+ * @param filename 文件名。
+ * @param text 文件内容。
+ */
+static void write_text_file(const char *filename, const char *text) {
+  FILE *file = fopen(filename, "wb");
+  assert_non_null(file);
+  fputs(text, file);
+  fclose(file);
+}
+
+/**
+ * @brief 测试文本文件的原子替换与尾行校验。
+ * @details
+ * 保存后不留下临时文件；截断、篡改的文件加载失败，旧格式与 CRLF 换行的
+ * 文件照常加载；无法创建临时文件时保存失败。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_crash_safe_save(void **state) {
+  (void)state; /* not used */
+  const char *test_file = "crash_safe_test.txt";
+  ParkingLot *lot = init_parking_lot(5);
+  ParkingLot *loaded_lot;
+  char content[1024];
+  char *end_line;
+  char *crlf;
+  size_t length;
+  size_t i;
+  FILE *file;
+
+  create_and_add_slot(lot, 1, "A-1");
+  create_and_add_slot(lot, 2, "A-2");
+  allocate_slot(lot, 2, "王五", "沪A55555", "13355555555", RESIDENT_TYPE);
+  assert_int_equal(save_parking_data(lot, test_file), 0);
+  assert_null(fopen("crash_safe_test.txt.tmp", "r"));
+
+  file = fopen(test_file, "rb");
+  assert_non_null(file);
+  length = fread(content, 1, sizeof(content) - 1, file);
+  fclose(file);
+  content[length] = '\0';
+  assert_int_equal(strncmp(content, "LOT|5|", 6), 0);
+  end_line = strstr(content, "END|2|");
+  assert_non_null(end_line);
+
+  /* 换行改为 CRLF 后校验和不变 */
+  crlf = (char *)malloc(length * 2 + 1);
+  assert_non_null(crlf);
+  for (i = 0, length = 0; content[i] != '\0'; i++) {
+    if (content[i] == '\n') {
+      crlf[length++] = '\r';
+    }
+    crlf[length++] = content[i];
+  }
+  crlf[length] = '\0';
+  write_text_file(test_file, crlf);
+  free(crlf);
+  loaded_lot = load_parking_data(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->occupied_slots, 1);
+  free_parking_lot(loaded_lot);
+
+  /* 篡改一个字节 */
+  strstr(content, "A-1")[2] = '9';
+  write_text_file(test_file, content);
+  assert_null(load_parking_data(test_file));
+  strstr(content, "A-9")[2] = '1';
+
+  /* 写到一半被截断：缺少尾行 */
+  *end_line = '\0';
+  write_text_file(test_file, content);
+  assert_null(load_parking_data(test_file));
+
+  /* 没有格式版本的旧文件不要求尾行 */
+  write_text_file(test_file, "LOT|5\nSLOT|1|A-1||||0|0|0|0|0\n");
+  loaded_lot = load_parking_data(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->slot_count, 1);
+  free_parking_lot(loaded_lot);
+
+  /* 字段按分隔符之间的长度复制，超长字段截断且不影响后续字段 */
+  memset(content, 'x', 120);
+  content[120] = '\0';
+  {
+    char line[256];
+    ParkingSlot *slot;
+
+    sprintf(line, "LOT|5\nSLOT|3|B-3|%s|PLATE|139|1|100|0|1|0\n", content);
+    write_text_file(test_file, line);
+    loaded_lot = load_parking_data(test_file);
+    assert_non_null(loaded_lot);
+    slot = find_slot_by_id(loaded_lot, 3);
+    assert_non_null(slot);
+    assert_string_equal(slot->location, "B-3");
+    assert_int_equal(strlen(slot->owner_name), MAX_NAME_LEN - 1);
+    assert_string_equal(slot->license_plate, "PLATE");
+    assert_string_equal(slot->contact, "139");
+    assert_int_equal(slot->entry_time, 100);
+    free_parking_lot(loaded_lot);
+  }
+
+  /* 无法创建临时文件时保存失败 */
+  assert_int_equal(save_parking_data(lot, "no_such_dir/crash_safe.txt"), -1);
+  assert_int_equal(save_parking_snapshot(lot, "no_such_dir/crash_safe.bin"),
+                   -1);
+
+  free_parking_lot(lot);
+  remove(test_file);
+}
+
+/* ========================================================================== */
+/*                                 主测试函数                                 */
+/* ========================================================================== */
+
+/**
+ * @brief 测试程序的主入口。
+ * @details 注册所有单元测试用例并使用 cmocka 框架运行它们。
+ * @return 返回 cmocka 测试组的执行结果。
+ */
+/**
+ * @brief (测试辅助函数) 累加遍历到的各站点的车位数。
+ */
+static int count_site_slots(const char *site_id, ParkingLot *lot, void *ctx) {
+  (void)site_id;
+  *(int *)ctx += lot->slot_count;
+  return 0;
+}
+
+/**
+ * @brief 测试在一个进程中托管多个停车场的注册表。
+ * @details 验证站点编号校验、各站点共用分配函数（包括从快照加载的站点）、
+ *          小停车场按容量截短的车位内存池、关闭后重新打开时数据保持不变，
+ *          以及工作线程对有修改的站点的自动保存。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_parking_registry(void **state) {
+  const char *sites[] = {"reg-north", "reg-south", "reg_east"};
+  CountingAllocator counter = {0, 0, 0};
+  ParkingAllocator allocator;
+  ParkingMemoryStats stats;
+  ParkingRegistry *registry;
+  ParkingSignal *pause;
+  ParkingLot *lot;
+  char path[64];
+  FILE *file = NULL;
+  int slots = 0;
+  int i;
+
+  (void)state; /* not used */
+  for (i = 0; i < 3; i++) {
+    sprintf(path, "./%s%s", sites[i], PARKING_REGISTRY_SUFFIX);
+    remove(path);
+  }
+  allocator.allocate = counting_allocate;
+  allocator.reallocate = NULL;
+  allocator.release = counting_release;
+  allocator.ctx = &counter;
+
+  /* 不启动工作线程，计数分配函数只在本线程中调用 */
+  registry = parking_registry_create(".", &allocator, 0, 0);
+  assert_non_null(registry);
+  assert_null(parking_registry_open(registry, "../escape", 10));
+  assert_null(parking_registry_open(registry, "", 10));
+  for (i = 0; i < 3; i++) {
+    lot = parking_registry_open(registry, sites[i], 10);
+    assert_non_null(lot);
+    assert_ptr_equal(parking_registry_open(registry, sites[i], 99), lot);
+    assert_ptr_equal(parking_registry_get(registry, sites[i]), lot);
+    assert_int_equal(create_and_add_slot(lot, 1, "R-1"), 0);
+    assert_int_equal(create_and_add_slot(lot, 2, "R-2"), 0);
+  }
+  assert_int_equal(parking_registry_count(registry), 3);
+  assert_null(parking_registry_get(registry, "reg-west"));
+  assert_int_equal(parking_registry_close(registry, "reg-west"), -3);
+
+  /* 10 个车位的停车场的内存池区块只容纳 10 个车位，而不是一整块 */
+  parking_registry_memory(registry, &stats);
+  assert_int_equal(stats.objects[PARKING_MEMORY_SLOTS], 3);
+  assert_true(stats.bytes[PARKING_MEMORY_SLOTS] <
+              3 * 11 * (long)sizeof(ParkingSlot));
+  assert_int_equal(stats.total_objects, counter.live);
+  assert_int_equal(parking_registry_foreach(registry, count_site_slots, &slots),
+                   3);
+  assert_int_equal(slots, 6);
+
+  /* 关闭时保存，重新打开时从快照加载，仍使用共用的分配函数 */
+  lot = parking_registry_get(registry, "reg-south");
+  assert_int_equal(allocate_slot(lot, 2, "南库", "粤B20002", "13700000002",
+                                 RESIDENT_TYPE),
+                   0);
+  assert_int_equal(parking_registry_close(registry, "reg-south"), 0);
+  assert_int_equal(parking_registry_count(registry), 2);
+  lot = parking_registry_open(registry, "reg-south", 10);
+  assert_non_null(lot);
+  assert_int_equal(lot->slot_count, 2);
+  assert_string_equal(find_slot_by_license(lot, "粤B20002")->owner_name,
+                      "南库");
+  parking_registry_memory(registry, &stats);
+  assert_int_equal(stats.total_objects, counter.live);
+  assert_int_equal(parking_registry_save_all(registry), 0);
+  assert_int_equal(parking_registry_destroy(registry), 0);
+  assert_int_equal(counter.live, 0);
+
+  /* 工作线程在下一轮轮询时保存有修改的站点 */
+  registry = parking_registry_create(".", NULL, 2, 0);
+  assert_non_null(registry);
+  lot = parking_registry_open(registry, "reg-north", 10);
+  assert_non_null(lot);
+  assert_int_equal(lot->slot_count, 2);
+  sprintf(path, "./reg-north%s", PARKING_REGISTRY_SUFFIX);
+  remove(path);
+  parking_lot_write_lock(lot);
+  assert_int_equal(create_and_add_slot(lot, 3, "R-3"), 0);
+  parking_lot_write_unlock(lot);
+  pause = parking_signal_create();
+  for (i = 0; i < 200 && (file = fopen(path, "rb")) == NULL; i++) {
+    parking_signal_wait(pause, 25);
+  }
+  parking_signal_destroy(pause);
+  assert_non_null(file);
+  fclose(file);
+  assert_int_equal(parking_registry_destroy(registry), 0);
+
+  registry = parking_registry_create(".", NULL, 0, 0);
+  lot = parking_registry_open(registry, "reg-north", 10);
+  assert_non_null(lot);
+  assert_int_equal(lot->slot_count, 3);
+  assert_int_equal(parking_registry_destroy(registry), 0);
+  for (i = 0; i < 3; i++) {
+    sprintf(path, "./%s%s", sites[i], PARKING_REGISTRY_SUFFIX);
+    remove(path);
+  }
+}
+
+/**
+ * @brief (测试辅助函数) 关闭站点的线程参数。
+ */
+typedef struct PinCloseArgs {
+  ParkingRegistry *registry; /**< 注册表。 */
+  volatile int result;       /**< parking_registry_close 的返回值。 */
+  volatile int done;         /**< 关闭返回后置 1。 */
+} PinCloseArgs;
+
+/**
+ * @brief (测试辅助函数) 在另一个线程中关闭 pin-site。
+ */
+static void close_pinned_site(void *arg) {
+  PinCloseArgs *args = (PinCloseArgs *)arg;
+
+  args->result = parking_registry_close(args->registry, "pin-site");
+  parking_atomic_store_int(&args->done, 1);
+}
+
+/**
+ * @brief 测试注册表站点的借出计数。
+ * @details 站点借出期间关闭站点的线程一直等待，停车场保持有效；
+ *          等待期间新的借出返回 -2，归还后关闭才完成。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_parking_registry_pins(void **state) {
+  PinCloseArgs args = {NULL, -1, 0};
+  ParkingRegistry *registry;
+  ParkingThread *closer;
+  ParkingSignal *pause;
+  ParkingLot *lot;
+  ParkingLot *pinned;
+  char path[64];
+  int result;
+  int i;
+
+  (void)state; /* not used */
+  sprintf(path, "./pin-site%s", PARKING_REGISTRY_SUFFIX);
+  remove(path);
+  registry = parking_registry_create(".", NULL, 0, 0);
+  assert_non_null(registry);
+  lot = parking_registry_open(registry, "pin-site", 4);
+  assert_non_null(lot);
+  assert_int_equal(parking_registry_acquire(registry, "pin-west", &pinned),
+                   -1);
+  assert_null(pinned);
+  assert_int_equal(parking_registry_acquire(registry, "pin-site", &pinned), 0);
+  assert_ptr_equal(pinned, lot);
+
+  args.registry = registry;
+  closer = parking_thread_start(close_pinned_site, &args);
+  assert_non_null(closer);
+  pause = parking_signal_create();
+  result = 0;
+  for (i = 0; i < 400 && result == 0; i++) {
+    result = parking_registry_acquire(registry, "pin-site", &pinned);
+    if (result == 0) {
+      parking_registry_release(registry, "pin-site");
+      parking_signal_wait(pause, 5);
+    }
+  }
+  assert_int_equal(result, -2);
+  assert_null(pinned);
+
+  /* 借出未归还时关闭不会完成，停车场仍可使用 */
+  parking_signal_wait(pause, 50);
+  assert_int_equal(parking_atomic_load_int(&args.done), 0);
+  assert_int_equal(create_and_add_slot(lot, 1, "P-1"), 0);
+  parking_registry_release(registry, "pin-site");
+  parking_thread_join(closer);
+  parking_signal_destroy(pause);
+  assert_int_equal(args.result, 0);
+  assert_int_equal(parking_registry_acquire(registry, "pin-site", &pinned),
+                   -1);
+
+  lot = parking_registry_open(registry, "pin-site", 4);
+  assert_non_null(lot);
+  assert_int_equal(lot->slot_count, 1);
+  assert_int_equal(parking_registry_destroy(registry), 0);
+  remove(path);
+}
+
 int main(void) {
   const struct CMUnitTest tests[] = {
       cmocka_unit_test(test_init_parking_lot),
       cmocka_unit_test(test_create_and_add_slot),
       cmocka_unit_test(test_allocate_and_deallocate_slot),
       cmocka_unit_test(test_find_functions),
+      cmocka_unit_test(test_slot_id_index),
+      cmocka_unit_test(test_index_incremental_growth),
+      cmocka_unit_test(test_slot_handles),
+      cmocka_unit_test(test_slot_compaction),
+      cmocka_unit_test(test_plate_index),
+      cmocka_unit_test(test_plate_codec),
+      cmocka_unit_test(test_slot_arena),
+      cmocka_unit_test(test_slot_hot_table),
+      cmocka_unit_test(test_slot_counters),
+      cmocka_unit_test(test_entry_order),
+      cmocka_unit_test(test_search_index),
+      cmocka_unit_test(test_slot_strings),
+      cmocka_unit_test(test_memory_accounting),
+      cmocka_unit_test(test_entry_histogram),
+      cmocka_unit_test(test_calendar_cache),
+      cmocka_unit_test(test_slot_iteration),
+      cmocka_unit_test(test_slot_paging),
+      cmocka_unit_test(test_slot_query),
+      cmocka_unit_test(test_parallel_query),
+      cmocka_unit_test(test_slot_reservations),
+      cmocka_unit_test(test_slot_layout),
+      cmocka_unit_test(test_zone_stats),
+      cmocka_unit_test(test_slot_change_feed),
+      cmocka_unit_test(test_due_date_index),
+      cmocka_unit_test(test_timer_wheel),
+      cmocka_unit_test(test_parking_events),
+      cmocka_unit_test(test_revenue_rollup),
+      cmocka_unit_test(test_distinct_vehicle_sketch),
+      cmocka_unit_test(test_occupancy_forecast),
+      cmocka_unit_test(test_plate_lists),
+      cmocka_unit_test(test_session_cache),
+      cmocka_unit_test(test_read_view),
+      cmocka_unit_test(test_parking_timeline),
+      cmocka_unit_test(test_parking_aggregate),
+      cmocka_unit_test(test_tariff_engine),
+      cmocka_unit_test(test_runtime_config),
+      cmocka_unit_test(test_column_kernels),
       cmocka_unit_test(test_data_persistence),
+      cmocka_unit_test(test_crash_safe_save),
+      cmocka_unit_test(test_binary_snapshot),
+      cmocka_unit_test(test_snapshot_nonpositive_total),
+      cmocka_unit_test(test_paged_snapshot_load),
+      cmocka_unit_test(test_index_image_load),
+      cmocka_unit_test(test_lazy_snapshot_load),
+      cmocka_unit_test(test_copy_on_write_snapshot),
+      cmocka_unit_test(test_write_ahead_journal),
+      cmocka_unit_test(test_journal_group_commit),
+      cmocka_unit_test(test_payment_ledger),
+      cmocka_unit_test(test_resident_billing),
+      cmocka_unit_test(test_session_history),
+      cmocka_unit_test(test_compressed_persistence),
+      cmocka_unit_test(test_incremental_checkpoint),
+      cmocka_unit_test(test_parking_registry),
+      cmocka_unit_test(test_parking_registry_pins),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);
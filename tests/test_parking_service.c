@@ -7,6 +7,10 @@
  * 检查其返回值、错误处理和对停车场状态的正确影响。
  */
 
+#if defined(PARKING_DAEMON) && !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L /* 网络服务测试使用的套接字接口 */
+#endif
+
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stddef.h>
@@ -16,7 +20,41 @@
 #include <string.h>
 #include <time.h>
 
+#include "../src/parking_aggregate.h"
+#include "../src/parking_anpr.h"
+#include "../src/parking_async.h"
+#include "../src/parking_ingest.h"
+#include "../src/parking_registry.h"
+#include "../src/parking_saver.h"
 #include "../src/parking_service.h"
+#include "../src/parking_shm.h"
+#include "../src/parking_tasks.h"
+#include "../src/parking_thread.h"
+#include "../src/parking_timeline.h"
+#include "../src/parking_trace.h"
+#include "../src/parking_view.h"
+#ifdef PARKING_EXPORTER
+#include "../src/parking_exporter.h"
+#endif
+#ifdef PARKING_REPLICATION
+#include "../src/parking_replica.h"
+#endif
+#ifdef PARKING_DAEMON
+#include "../src/parking_daemon.h"
+#include "../src/parking_dedup.h"
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#endif
+#ifdef PARKING_CLUSTER
+#include "../src/parking_cluster.h"
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+#endif
 #include "cmocka.h"
 
 /* ========================================================================== */
@@ -86,6 +124,59 @@ static void test_service_add_slot(void **state) {
   assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
 }
 
+/**
+ * @brief 测试 `parking_service_add_slots_bulk` 函数的功能。
+ * @details
+ * 验证整批添加成功后车位与位置一一对应；批内重复、与已有车位重复
+ * 或含有无效项时整批都不添加，并在消息中指出问题所在。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_add_slots_bulk(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  static int ids[2000];
+  static char names[2000][16];
+  static const char *locations[2000];
+  ServiceResult result;
+  int i;
+
+  for (i = 0; i < 2000; i++) {
+    ids[i] = 2000 - i; /* 倒序编号，查重不依赖输入顺序 */
+    sprintf(names[i], "B-%04d", ids[i]);
+    locations[i] = names[i];
+  }
+  result = parking_service_add_slots_bulk(lot, ids, locations, 2000);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(lot->slot_count, 2000);
+  assert_int_equal(lot->free_slot_count, 2000);
+  assert_string_equal(find_slot_by_id(lot, 1234)->location, "B-1234");
+
+  /* 批内重复：一个也不添加 */
+  ids[0] = 3001;
+  ids[1] = 3002;
+  ids[2] = 3001;
+  result = parking_service_add_slots_bulk(lot, ids, locations, 3);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_EXISTS);
+  assert_non_null(strstr(result.message, "3001"));
+  assert_null(find_slot_by_id(lot, 3002));
+
+  /* 与已有车位重复 */
+  ids[2] = 17;
+  result = parking_service_add_slots_bulk(lot, ids, locations, 3);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_EXISTS);
+  assert_non_null(strstr(result.message, "17"));
+  assert_null(find_slot_by_id(lot, 3001));
+
+  /* 无效项 */
+  ids[2] = 3003;
+  locations[1] = "";
+  result = parking_service_add_slots_bulk(lot, ids, locations, 3);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  assert_null(find_slot_by_id(lot, 3001));
+  result = parking_service_add_slots_bulk(lot, ids, locations, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  assert_int_equal(lot->slot_count, 2000);
+}
+
 /**
  * @brief 测试 `parking_service_allocate_slot` 和
  * `parking_service_deallocate_slot` 的功能。
@@ -102,6 +193,9 @@ static void test_service_allocate_and_deallocate_slot(void **state) {
   ParkingLot *lot = (ParkingLot *)*state;
   parking_service_add_slot(lot, 101, "B-101");
   ServiceResult result;
+  ExitReceipt receipt;
+  TariffConfig config;
+  ParkingConfig runtime;
 
   /* 1. 成功分配车辆 */
   result = parking_service_allocate_slot(lot, 101, "TestUser", "粤B12345",
@@ -125,104 +219,3677 @@ static void test_service_allocate_and_deallocate_slot(void **state) {
   /* 3. 测试对空闲车位执行出场 */
   result = parking_service_deallocate_slot(lot, 101);
   assert_int_equal(result.code, PARKING_SERVICE_SLOT_FREE);
+
+  /* 4. 计费明细写入调用者的缓冲区，不返回堆数据 */
+  result = parking_service_allocate_slot(lot, 101, "TestUser", "粤B12345",
+                                         "13800138000", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  slot->entry_time = time(NULL) - 9000; /* 模拟停车2.5小时 */
+  sync_slot_hot_fields(lot, slot);
+  result = parking_service_checkout_slot(lot, 101, &receipt);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_null(result.data);
+  assert_int_equal(receipt.slot_id, 101);
+  assert_int_equal(receipt.type, VISITOR_TYPE);
+  assert_true(receipt.duration_seconds >= 9000);
+  assert_int_equal(receipt.billed_hours, 3);
+  assert_true(receipt.amount == 3 * VISITOR_HOURLY_FEE);
+  assert_int_equal(receipt.amount_cents, 3 * TARIFF_DEFAULT_HOURLY_CENTS);
+  result = parking_service_checkout_slot(lot, 101, &receipt);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_FREE);
+  assert_true(receipt.amount == 0.0);
+
+  /* 5. 换用首小时 15 元、之后每小时 5 元的费率表 */
+  tariff_config_default(&config);
+  config.first_hour_cents = 1500;
+  config.hourly_cents = 500;
+  config.night_hourly_cents = 500;
+  config.daily_cap_cents = -1;
+  result = parking_service_configure_tariff(lot, &config);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  config.daily_cap_cents = 0;
+  result = parking_service_configure_tariff(lot, &config);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 101, "TestUser", "粤B12345",
+                                         "13800138000", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  slot->entry_time = time(NULL) - 9000;
+  sync_slot_hot_fields(lot, slot);
+  result = parking_service_checkout_slot(lot, 101, &receipt);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(receipt.amount_cents, 1500 + 2 * 500);
+  assert_true(receipt.amount == 25.0);
+  result = parking_service_configure_tariff(lot, NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  /* 6. 运行时配置的读取、修改与发布 */
+  result = parking_service_get_config(lot, &runtime);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(runtime.tariff.first_hour_cents,
+                   TARIFF_DEFAULT_HOURLY_CENTS);
+  runtime.visitor_start_hour = 0;
+  runtime.visitor_end_hour = 24;
+  result = parking_service_apply_config(lot, &runtime);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_lot_config(lot)->visitor_end_hour, 24);
+  assert_null(lot->retired_configs);
+  result = parking_service_load_config(lot, "missing_parking_test.conf", NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_FILE_ERROR);
+  assert_int_equal(parking_lot_config(lot)->visitor_end_hour, 24);
 }
 
 /**
- * @brief 测试 `parking_service_get_statistics` 函数的功能。
+ * @brief 测试 `parking_service_allocate_any_slot` 的自动分配功能。
  * @details
- * 验证统计信息服务是否能返回正确的数据。
- * 1. 在空停车场中获取统计信息。
- * 2. 分配一个车位后，再次获取统计信息并验证占用数和使用率是否更新。
+ * 验证自动分配依次占满所有空闲车位、车位已满时返回 SLOT_NOT_FOUND，
+ * 以及车辆出场后空出的车位可以再次被自动分配。
  * @param state cmocka 框架的测试状态指针。
  */
-static void test_service_get_statistics(void **state) {
+static void test_service_allocate_any_slot(void **state) {
   ParkingLot *lot = (ParkingLot *)*state;
   ServiceResult result;
+  ParkingSlot *first;
+  ParkingSlot *second;
+
+  parking_service_add_slot(lot, 201, "C-201");
+  parking_service_add_slot(lot, 202, "C-202");
+
+  result = parking_service_allocate_any_slot(lot, "甲", "沪A20001",
+                                             "13800000001", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  first = (ParkingSlot *)result.data;
+  assert_non_null(first);
+  assert_int_equal(first->status, OCCUPIED_STATUS);
+
+  result = parking_service_allocate_any_slot(lot, "乙", "沪A20002",
+                                             "13800000002", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  second = (ParkingSlot *)result.data;
+  assert_non_null(second);
+  assert_true(first != second);
+
+  /* 车位已满 */
+  result = parking_service_allocate_any_slot(lot, "丙", "沪A20003",
+                                             "13800000003", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+
+  /* 同一车牌不能重复入场 */
+  result = parking_service_deallocate_slot(lot, first->slot_id);
+  parking_service_free_result(&result);
+  result = parking_service_allocate_any_slot(lot, "乙", "沪A20002",
+                                             "13800000002", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_LICENSE_EXISTS);
+
+  /* 出场后空出的车位被再次分配 */
+  result = parking_service_allocate_any_slot(lot, "丙", "沪A20003",
+                                             "13800000003", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_ptr_equal(result.data, first);
+  assert_int_equal(lot->occupied_slots, 2);
+}
+
+/**
+ * @brief 并发测试中单个线程的参数与结果。
+ */
+typedef struct {
+  ParkingLot *lot; /**< 共享的停车场。 */
+  int first_slot;  /**< 入口线程负责的第一个车位编号。 */
+  int failures;    /**< 线程内观察到的异常次数。 */
+} GateWorker;
+
+#define GATE_THREADS 4       /**< 并发入口线程数 */
+#define SLOTS_PER_GATE 16    /**< 每个入口负责的车位数 */
+#define GATE_ROUNDS 50       /**< 每个入口重复进出场的轮数 */
+
+/**
+ * @brief 入口线程：在自己负责的车位上反复入场、出场。
+ */
+static void gate_worker(void *arg) {
+  GateWorker *worker = (GateWorker *)arg;
+  ServiceResult result;
+  char plate[16];
+  int round;
+  int k;
+
+  for (round = 0; round < GATE_ROUNDS; round++) {
+    for (k = 0; k < SLOTS_PER_GATE; k++) {
+      sprintf(plate, "沪T%05d", worker->first_slot + k);
+      result = parking_service_allocate_slot(worker->lot,
+                                             worker->first_slot + k, "并发",
+                                             plate, "13800000000",
+                                             RESIDENT_TYPE);
+      if (result.code != PARKING_SERVICE_SUCCESS) {
+        worker->failures++;
+      }
+    }
+    for (k = 0; k < SLOTS_PER_GATE; k++) {
+      result = parking_service_deallocate_slot(worker->lot,
+                                               worker->first_slot + k);
+      if (result.code != PARKING_SERVICE_SUCCESS) {
+        worker->failures++;
+      }
+      parking_service_free_result(&result);
+    }
+  }
+}
+
+/**
+ * @brief 查询线程：反复读取列表与统计，检查计数始终自洽。
+ */
+static void report_worker(void *arg) {
+  GateWorker *worker = (GateWorker *)arg;
+  ServiceResult result;
   ParkingStatistics *stats;
+  int round;
 
-  /* 1. 空停车场统计 */
-  result = parking_service_get_statistics(lot);
+  for (round = 0; round < GATE_ROUNDS * 4; round++) {
+    result = parking_service_get_all_slots(worker->lot);
+    if (result.code != PARKING_SERVICE_SUCCESS ||
+        ((SlotQueryResult *)result.data)->total_found !=
+            GATE_THREADS * SLOTS_PER_GATE) {
+      worker->failures++;
+    }
+    parking_service_free_result(&result);
+
+    result = parking_service_get_statistics(worker->lot);
+    stats = (ParkingStatistics *)result.data;
+    if (result.code != PARKING_SERVICE_SUCCESS || stats->occupied_slots < 0 ||
+        stats->occupied_slots > GATE_THREADS * SLOTS_PER_GATE) {
+      worker->failures++;
+    }
+    parking_service_free_result(&result);
+
+    result = parking_service_find_slot_by_id(worker->lot, 1 + round % 64);
+    if (result.code != PARKING_SERVICE_SUCCESS) {
+      worker->failures++;
+    }
+  }
+}
+
+/**
+ * @brief 测试多个入口线程与查询线程并发使用同一停车场。
+ * @details
+ * 入口线程在互不重叠的车位上进出场，查询线程同时读取列表和统计；
+ * 结束后所有车位应为空闲，计数器与车位表一致。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_concurrent_gates(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  GateWorker workers[GATE_THREADS + 2];
+  ParkingThread *threads[GATE_THREADS + 2];
+  ServiceResult result;
+  int i;
+
+  for (i = 1; i <= GATE_THREADS * SLOTS_PER_GATE; i++) {
+    char location[16];
+    sprintf(location, "G-%d", i);
+    result = parking_service_add_slot(lot, i, location);
+    assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  }
+
+  for (i = 0; i < GATE_THREADS + 2; i++) {
+    workers[i].lot = lot;
+    workers[i].first_slot = 1 + i * SLOTS_PER_GATE;
+    workers[i].failures = 0;
+    threads[i] = parking_thread_start(
+        i < GATE_THREADS ? gate_worker : report_worker, &workers[i]);
+    assert_non_null(threads[i]);
+  }
+  for (i = 0; i < GATE_THREADS + 2; i++) {
+    parking_thread_join(threads[i]);
+    assert_int_equal(workers[i].failures, 0);
+  }
+
+  assert_int_equal(lot->occupied_slots, 0);
+  assert_int_equal(lot->free_slot_count, GATE_THREADS * SLOTS_PER_GATE);
+  assert_int_equal(lot->plate_index.count, 0);
+}
+
+/**
+ * @brief 接入队列测试中单个闸机线程的参数。
+ */
+typedef struct {
+  ParkingIngest *ingest; /**< 共享的接入队列。 */
+  int first_slot;        /**< 闸机负责的第一个车位编号。 */
+  int failures;          /**< 提交失败的次数。 */
+} IngestGate;
+
+/**
+ * @brief (测试辅助函数) 指令完成通知：统计成功与失败的指令数。
+ * @param event 应用的指令。
+ * @param code 指令的结果。
+ * @param ctx 指向两个计数器（成功、失败）的数组。
+ */
+static void count_ingest_result(const GateEvent *event,
+                                ParkingServiceResultCode code, void *ctx) {
+  volatile int *counts = (volatile int *)ctx;
+
+  (void)event;
+  parking_atomic_add_int(&counts[code == PARKING_SERVICE_SUCCESS ? 0 : 1], 1);
+}
+
+/** 接入队列测试的指令计数：[0] 为成功数，[1] 为失败数。 */
+static volatile int ingest_counts[2];
+
+/**
+ * @brief (测试辅助函数) 闸机线程：为自己的车位逐个提交入场，再逐个提交出场。
+ * @param arg 指向 IngestGate 的指针。
+ */
+static void ingest_gate_worker(void *arg) {
+  IngestGate *gate = (IngestGate *)arg;
+  char plate[16];
+  GateEvent event;
+  int i;
+
+  memset(&event, 0, sizeof(event));
+  event.owner_name = "闸机";
+  event.contact = "13800138000";
+  event.type = RESIDENT_TYPE;
+  for (i = 0; i < SLOTS_PER_GATE * 2; i++) {
+    event.slot_id = gate->first_slot + i % SLOTS_PER_GATE;
+    event.kind = i < SLOTS_PER_GATE ? GATE_EVENT_ENTRY : GATE_EVENT_EXIT;
+    sprintf(plate, "京Q%05d", event.slot_id);
+    event.license_plate = plate;
+    if (parking_ingest_submit(gate->ingest, &event, count_ingest_result,
+                              (void *)ingest_counts) != 0) {
+      gate->failures++;
+    }
+  }
+}
+
+/**
+ * @brief 测试多个闸机线程经无锁接入队列提交出入场指令。
+ * @details 每个闸机的指令按提交顺序应用；停止接入队列时排队的指令全部完成，
+ *          此后所有车位应为空闲，每条指令都收到一次成功通知。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_ingest_queue(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  IngestGate gates[GATE_THREADS];
+  ParkingThread *threads[GATE_THREADS];
+  ParkingIngestStats stats;
+  ParkingIngest *ingest;
+  GateEvent bad;
+  char long_plate[MAX_LICENSE_LEN + 8];
+  int i;
+
+  for (i = 1; i <= GATE_THREADS * SLOTS_PER_GATE; i++) {
+    char location[16];
+    sprintf(location, "Q-%d", i);
+    assert_int_equal(parking_service_fast_add_slot(lot, i, location),
+                     PARKING_SERVICE_SUCCESS);
+  }
+  ingest_counts[0] = 0;
+  ingest_counts[1] = 0;
+  ingest = parking_ingest_start(lot, 8);
+  assert_non_null(ingest);
+
+  memset(&bad, 0, sizeof(bad));
+  memset(long_plate, 'A', sizeof(long_plate) - 1);
+  long_plate[sizeof(long_plate) - 1] = '\0';
+  bad.kind = GATE_EVENT_ENTRY;
+  bad.slot_id = 1;
+  bad.license_plate = long_plate;
+  assert_int_equal(parking_ingest_submit(ingest, &bad, NULL, NULL), -1);
+  assert_int_equal(parking_ingest_submit(NULL, &bad, NULL, NULL), -1);
+
+  for (i = 0; i < GATE_THREADS; i++) {
+    gates[i].ingest = ingest;
+    gates[i].first_slot = 1 + i * SLOTS_PER_GATE;
+    gates[i].failures = 0;
+    threads[i] = parking_thread_start(ingest_gate_worker, &gates[i]);
+    assert_non_null(threads[i]);
+  }
+  for (i = 0; i < GATE_THREADS; i++) {
+    parking_thread_join(threads[i]);
+    assert_int_equal(gates[i].failures, 0);
+  }
+
+  /* 车位编号为 0 的出场指令校验失败，同样会收到通知 */
+  bad.kind = GATE_EVENT_EXIT;
+  bad.slot_id = 0;
+  bad.license_plate = NULL;
+  assert_int_equal(parking_ingest_submit(ingest, &bad, count_ingest_result,
+                                         (void *)ingest_counts),
+                   0);
+  parking_ingest_stats(ingest, &stats);
+  assert_true(stats.submitted == GATE_THREADS * SLOTS_PER_GATE * 2 + 1);
+  parking_ingest_stop(ingest);
+
+  assert_int_equal(ingest_counts[0], GATE_THREADS * SLOTS_PER_GATE * 2);
+  assert_int_equal(ingest_counts[1], 1);
+  assert_int_equal(lot->occupied_slots, 0);
+  assert_int_equal(lot->free_slot_count, GATE_THREADS * SLOTS_PER_GATE);
+}
+
+/**
+ * @brief 测试停车时长排行查询。
+ * @details 验证前 k 名按停车时长从长到短返回，时长相对同一时刻计算，
+ *          以及列表形式的排行可以按两种顺序返回。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_longest_parked(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  static const long ages[3] = {600, 7200, 3600};
+  ParkedVehicle top[3];
+  SlotQueryResult *list;
+  ServiceResult result;
+  char plate[16];
+  time_t base = time(NULL);
+  int found = -1;
+  int i;
+
+  for (i = 0; i < 3; i++) {
+    ParkingSlot *slot;
+    parking_service_add_slot(lot, i + 1, "L-1");
+    sprintf(plate, "沪L0000%d", i + 1);
+    result = parking_service_allocate_slot(lot, i + 1, "巡查", plate,
+                                           "13800000000", RESIDENT_TYPE);
+    assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+    slot = find_slot_by_id(lot, i + 1);
+    slot->entry_time = base - ages[i];
+    sync_slot_hot_fields(lot, slot);
+  }
+
+  result = parking_service_get_longest_parked(lot, 2, top, &found);
   assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
-  stats = (ParkingStatistics *)result.data;
-  assert_non_null(stats);
-  assert_int_equal(stats->total_slots, 10);
-  assert_int_equal(stats->occupied_slots, 0);
+  assert_int_equal(found, 2);
+  assert_int_equal(top[0].slot->slot_id, 2);
+  assert_int_equal(top[1].slot->slot_id, 3);
+  assert_true(top[0].duration_seconds >= 7200);
+  assert_true(top[0].duration_seconds - top[1].duration_seconds == 3600);
+
+  result = parking_service_get_slots_by_duration(lot, 0, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  list = (SlotQueryResult *)result.data;
+  assert_int_equal(list->total_found, 3);
+  assert_int_equal(list->slot_list[0]->slot_id, 1);
+  assert_int_equal(list->slot_list[2]->slot_id, 2);
   parking_service_free_result(&result);
 
-  /* 2. 分配一个车位后统计 */
-  parking_service_add_slot(lot, 1, "C-1");
-  parking_service_allocate_slot(lot, 1, "StatUser", "粤BSTAT1", "13912391239",
+  result = parking_service_get_longest_parked(lot, 0, top, &found);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+}
+
+/**
+ * @brief 测试 `parking_service_search_slots` 的子串检索。
+ * @details 验证按车牌号片段返回全部匹配、无匹配时返回空列表，以及空查询串被拒绝。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_search_slots(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ServiceResult result;
+  SlotQueryResult *list;
+
+  parking_service_add_slot(lot, 1, "S-1");
+  parking_service_add_slot(lot, 2, "S-2");
+  parking_service_add_slot(lot, 3, "S-3");
+  parking_service_allocate_slot(lot, 1, "张三", "粤B12001", "13800000001",
+                                RESIDENT_TYPE);
+  parking_service_allocate_slot(lot, 2, "李四", "粤B12002", "13800000002",
+                                RESIDENT_TYPE);
+  parking_service_allocate_slot(lot, 3, "王五", "粤C99999", "13800000003",
                                 RESIDENT_TYPE);
 
-  result = parking_service_get_statistics(lot);
+  result = parking_service_search_slots(lot, SLOT_SEARCH_PLATE, "粤B12");
   assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
-  stats = (ParkingStatistics *)result.data;
-  assert_non_null(stats);
-  assert_int_equal(stats->occupied_slots, 1);
-  assert_float_equal(stats->occupancy_rate, 10.0, 0.01);
+  list = (SlotQueryResult *)result.data;
+  assert_non_null(list);
+  assert_int_equal(list->total_found, 2);
+  assert_true(list->slot_list[0]->slot_id + list->slot_list[1]->slot_id == 3);
   parking_service_free_result(&result);
+
+  result = parking_service_search_slots(lot, SLOT_SEARCH_OWNER, "赵");
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(((SlotQueryResult *)result.data)->total_found, 0);
+  parking_service_free_result(&result);
+
+  result = parking_service_search_slots(lot, SLOT_SEARCH_OWNER, "");
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
 }
 
 /**
- * @brief 测试 `parking_service_save_data` 和 `parking_service_load_data`
- * 的功能。
- * @details
- * 验证服务层的数据持久化功能。
- * 1. 创建并填充一个停车场。
- * 2. 调用保存服务将数据写入文件。
- * 3. 调用加载服务从文件恢复数据到一个新实例。
- * 4. 验证加载后的数据与保存前一致。
+ * @brief (测试辅助函数) 车位访问函数：记下访问到的车位编号。
+ * @param slot 找到的车位。
+ * @param ctx 指向 int 的指针。
+ * @return 始终返回 0。
+ */
+static int remember_slot_id(ParkingSlot *slot, void *ctx) {
+  *(int *)ctx = slot->slot_id;
+  return 0;
+}
+
+/**
+ * @brief 测试只返回状态码的快速服务接口。
  * @param state cmocka 框架的测试状态指针。
  */
-static void test_service_data_persistence(void **state) {
-  const char *test_file = "service_persistence_test.txt";
-  ParkingLot *lot_to_save = init_parking_lot(5);
-  parking_service_add_slot(lot_to_save, 1, "P-1");
-  parking_service_allocate_slot(lot_to_save, 1, "SvcUser", "沪ASVC01",
-                                "12312341234", RESIDENT_TYPE);
+static void test_service_fast_api(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingStatistics stats;
+  ParkingSlot *slot = NULL;
+  ExitReceipt receipt;
+  int slot_id = -1;
 
-  /* 1. 测试保存 */
-  ServiceResult save_result = parking_service_save_data(lot_to_save, test_file);
-  assert_int_equal(save_result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "F-1"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "F-1"),
+                   PARKING_SERVICE_SLOT_EXISTS);
+  assert_int_equal(parking_service_fast_allocate_any_slot(
+                       lot, "快速", "沪F00001", "13800000001", RESIDENT_TYPE,
+                       &slot_id),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 1);
+  assert_int_equal(parking_service_fast_allocate_any_slot(
+                       lot, "快速", "沪F00002", "13800000002", RESIDENT_TYPE,
+                       &slot_id),
+                   PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_int_equal(slot_id, 0);
 
-  /* 2. 测试加载 */
-  ServiceResult load_result = parking_service_load_data(test_file);
-  assert_int_equal(load_result.code, PARKING_SERVICE_SUCCESS);
-  assert_non_null(load_result.data);
-  ParkingLot *loaded_lot = (ParkingLot *)load_result.data;
+  assert_int_equal(
+      parking_service_fast_find_slot_by_license(lot, "沪F00001", &slot),
+      PARKING_SERVICE_SUCCESS);
+  assert_non_null(slot);
+  assert_int_equal(slot->slot_id, 1);
+  assert_int_equal(parking_service_fast_find_slot_by_id(lot, 2, &slot),
+                   PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_null(slot);
+  slot_id = 0;
+  assert_int_equal(parking_service_fast_visit_slot_by_license(
+                       lot, "沪F00001", remember_slot_id, &slot_id),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 1);
+  slot_id = 0;
+  assert_int_equal(
+      parking_service_fast_visit_slot_by_id(lot, 2, remember_slot_id, &slot_id),
+      PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_int_equal(slot_id, 0);
+  assert_int_equal(parking_service_fast_visit_slot_by_id(lot, 1, NULL, NULL),
+                   PARKING_SERVICE_INVALID_PARAM);
 
-  /* 3. 验证数据 */
-  assert_int_equal(loaded_lot->total_slots, 5);
-  assert_int_equal(loaded_lot->occupied_slots, 1);
-  ParkingSlot *loaded_slot = find_slot_by_id(loaded_lot, 1);
-  assert_non_null(loaded_slot);
-  assert_string_equal(loaded_slot->owner_name, "SvcUser");
+  assert_int_equal(parking_service_fast_get_statistics(lot, &stats),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(stats.free_slots, stats.total_slots - 1);
+  assert_int_equal(stats.occupied_slots, 1);
 
-  /* 清理 */
-  free_parking_lot(lot_to_save);
-  free_parking_lot(loaded_lot);
-  remove(test_file);
+  assert_int_equal(parking_service_fast_deallocate_slot(lot, 1, &receipt),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(receipt.slot_id, 1);
+  assert_true(receipt.amount == 0.0);
+  assert_int_equal(parking_service_fast_deallocate_slot(lot, 1, &receipt),
+                   PARKING_SERVICE_SLOT_FREE);
+  assert_int_equal(receipt.slot_id, 0);
+  assert_int_equal(parking_service_fast_deallocate_slot(NULL, 1, NULL),
+                   PARKING_SERVICE_INVALID_PARAM);
+
+  assert_string_equal(
+      parking_service_code_message(PARKING_SERVICE_SLOT_FREE),
+      "车位当前为空闲状态");
 }
 
-/* ========================================================================== */
-/*                                 主测试函数                                 */
-/* ========================================================================== */
+/**
+ * @brief 测试服务层的调用计数、结果分类与延迟直方图。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_metrics(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ServiceMetrics *metrics = (ServiceMetrics *)malloc(sizeof(ServiceMetrics));
+  const MetricsSnapshot *add;
+  ParkingStatistics stats;
+  ParkingSlot *slot = NULL;
+  long bucket_sum = 0;
+  int slot_id = -1;
+  int i;
+
+  assert_non_null(metrics);
+  assert_int_equal(metrics_latency_bucket(0), 0);
+  assert_int_equal(metrics_latency_bucket(7), 7);
+  assert_int_equal(metrics_latency_bucket(8), 8);
+  assert_int_equal(metrics_latency_bucket(15), 15);
+  assert_int_equal(metrics_latency_bucket(16), 16);
+  assert_int_equal(metrics_latency_bucket(17), 16);
+  assert_int_equal(metrics_latency_bucket(18), 17);
+  assert_true(metrics_bucket_upper_ns(metrics_latency_bucket(1000)) > 1000.0);
+  assert_true(metrics_bucket_upper_ns(metrics_latency_bucket(1000)) <= 1125.0);
+  assert_int_equal(metrics_latency_bucket(~0UL), METRICS_LATENCY_BUCKETS - 1);
+  assert_string_equal(parking_service_metric_name(SERVICE_METRIC_ADD_SLOT),
+                      "add_slot");
+  assert_string_equal(parking_service_metric_name(SERVICE_METRIC_COUNT),
+                      "unknown");
+  assert_int_equal(parking_service_get_metrics(NULL),
+                   PARKING_SERVICE_INVALID_PARAM);
+
+  parking_service_reset_metrics();
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "M-1"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "M-1"),
+                   PARKING_SERVICE_SLOT_EXISTS);
+  assert_int_equal(parking_service_fast_allocate_any_slot(
+                       lot, "指标", "沪M00001", "13800000001", RESIDENT_TYPE,
+                       &slot_id),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_find_slot_by_id(lot, 1, &slot),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_get_statistics(lot, &stats),
+                   PARKING_SERVICE_SUCCESS);
+
+  assert_int_equal(parking_service_get_metrics(metrics),
+                   PARKING_SERVICE_SUCCESS);
+  if (!metrics->enabled) {
+    assert_int_equal(metrics->operations[SERVICE_METRIC_ADD_SLOT].calls, 0);
+    free(metrics);
+    return;
+  }
+  add = &metrics->operations[SERVICE_METRIC_ADD_SLOT];
+  assert_int_equal(add->calls, 2);
+  assert_int_equal(add->outcomes[-PARKING_SERVICE_SUCCESS], 1);
+  assert_int_equal(add->outcomes[-PARKING_SERVICE_SLOT_EXISTS], 1);
+  for (i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+    bucket_sum += add->latency[i];
+  }
+  assert_int_equal(bucket_sum, add->calls);
+  assert_true(metrics_quantile_ns(add, 1.0) > 0.0);
+  assert_int_equal(
+      metrics->operations[SERVICE_METRIC_ALLOCATE_ANY_SLOT].calls, 1);
+  assert_int_equal(metrics->operations[SERVICE_METRIC_FIND_SLOT_BY_ID].calls,
+                   1);
+  assert_int_equal(metrics->operations[SERVICE_METRIC_GET_STATISTICS].calls,
+                   1);
+  assert_int_equal(metrics->operations[SERVICE_METRIC_CHECKOUT_SLOT].calls, 0);
+
+  parking_service_reset_metrics();
+  assert_int_equal(parking_service_get_metrics(metrics),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(metrics->operations[SERVICE_METRIC_ADD_SLOT].calls, 0);
+  free(metrics);
+}
 
 /**
- * @brief 测试程序的主入口。
- * @details
- * 注册所有服务层的单元测试用例，并使用 cmocka 框架统一运行它们。
- * 每个测试组使用 setup 和 teardown 函数来管理测试环境的生命周期。
- * @return 返回 cmocka 测试组的执行结果。
+ * @brief 测试区间追踪记录服务调用与内部阶段并导出 Chrome 追踪事件。
+ * @param state cmocka 框架的测试状态指针。
  */
-int main(void) {
-  const struct CMUnitTest tests[] = {
-      cmocka_unit_test_setup_teardown(test_service_add_slot, setup, teardown),
-      cmocka_unit_test_setup_teardown(test_service_allocate_and_deallocate_slot,
-                                      setup, teardown),
-      cmocka_unit_test_setup_teardown(test_service_get_statistics, setup,
-                                      teardown),
-      cmocka_unit_test(test_service_data_persistence),
+static void test_service_trace(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  const char *path = "test_service_trace.json";
+  char buffer[8192];
+  ExitReceipt receipt;
+  TraceStats stats;
+  FILE *file;
+  size_t length;
+  int slot_id = -1;
+
+  assert_int_equal(parking_trace_enable(-1), -1);
+  assert_int_equal(parking_trace_enable(TRACE_MAX_EVENTS + 1), -1);
+  assert_int_equal(parking_trace_flush(NULL), -1);
+  assert_int_equal(parking_trace_enable(0), 0);
+  assert_int_equal(parking_trace_is_enabled(), 1);
+
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "T-1"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_allocate_any_slot(
+                       lot, "追踪", "沪T00001", "13800000002", RESIDENT_TYPE,
+                       &slot_id),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(
+      parking_service_fast_deallocate_slot(lot, slot_id, &receipt),
+      PARKING_SERVICE_SUCCESS);
+  parking_trace_disable();
+  assert_int_equal(parking_trace_is_enabled(), 0);
+
+  parking_trace_stats(&stats);
+  if (!PARKING_TRACE) {
+    assert_int_equal(stats.recorded, 0);
+    return;
+  }
+  assert_true(stats.recorded >= 4);
+  assert_int_equal(stats.dropped, 0);
+  assert_true(stats.threads >= 1);
+
+  file = fopen(path, "w+");
+  assert_non_null(file);
+  assert_true(parking_trace_flush(file) >= 4);
+  rewind(file);
+  length = fread(buffer, 1, sizeof(buffer) - 1, file);
+  buffer[length] = '\0';
+  fclose(file);
+  remove(path);
+
+  assert_non_null(strstr(buffer, "{\"traceEvents\":["));
+  assert_non_null(strstr(buffer, "\"name\":\"allocate_any_slot\""));
+  assert_non_null(strstr(buffer, "\"name\":\"checkout_slot\""));
+  assert_non_null(strstr(buffer, "\"name\":\"fee\""));
+  assert_non_null(strstr(buffer, "\"ph\":\"X\""));
+
+  /* 已导出的区间从环中移除，关闭后不再记录新区间 */
+  file = fopen(path, "w+");
+  assert_non_null(file);
+  assert_int_equal(parking_trace_flush(file), 0);
+  fclose(file);
+  remove(path);
+}
+
+/**
+ * @brief 测试内存统计与未释放结果数据的计数。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_memory_stats(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingMemoryStats stats;
+  ServiceResult list;
+  ServiceResult summary;
+  long outstanding = parking_service_outstanding_results();
+
+  assert_int_equal(parking_service_get_memory_stats(NULL, &stats),
+                   PARKING_SERVICE_INVALID_PARAM);
+  assert_int_equal(parking_service_get_memory_stats(lot, NULL),
+                   PARKING_SERVICE_INVALID_PARAM);
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "M-1"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_get_memory_stats(lot, &stats),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(stats.objects[PARKING_MEMORY_LOT], 1);
+  assert_true(stats.total_bytes > (long)sizeof(ParkingLot));
+
+  list = parking_service_get_all_slots(lot);
+  summary = parking_service_get_statistics(lot);
+  assert_int_equal(list.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(summary.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_outstanding_results(), outstanding + 2);
+  parking_service_free_result(&list);
+  assert_int_equal(parking_service_outstanding_results(), outstanding + 1);
+  parking_service_free_result(&summary);
+  assert_int_equal(parking_service_outstanding_results(), outstanding);
+}
+
+/**
+ * @brief 测试分页与续读标记两种车位列表接口。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_slot_pages(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ServiceResult result;
+  SlotQueryResult *page;
+  int token = 0;
+  int seen = 0;
+  int pages = 0;
+  int i;
+
+  for (i = 1; i <= 10; i++) {
+    assert_int_equal(parking_service_fast_add_slot(lot, i, "PG"),
+                     PARKING_SERVICE_SUCCESS);
+  }
+
+  result = parking_service_get_slots_page(lot, SLOT_FILTER_FREE, 8, 4);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  page = (SlotQueryResult *)result.data;
+  assert_int_equal(page->total_found, 2);
+  parking_service_free_result(&result);
+
+  result = parking_service_get_slots_page(lot, SLOT_FILTER_ALL, 10, 4);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(((SlotQueryResult *)result.data)->total_found, 0);
+  parking_service_free_result(&result);
+  result = parking_service_get_slots_page(lot, SLOT_FILTER_ALL, 0, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  while (token != -1) {
+    result = parking_service_get_slots_after(lot, SLOT_FILTER_ALL, &token, 3);
+    assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+    seen += ((SlotQueryResult *)result.data)->total_found;
+    pages++;
+    parking_service_free_result(&result);
+  }
+  assert_int_equal(seen, 10);
+  assert_int_equal(pages, 4);
+  result = parking_service_get_slots_after(lot, SLOT_FILTER_ALL, NULL, 3);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+}
+
+/**
+ * @brief 测试服务层的组合条件查询。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_query_slots(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingTaskPool *pool;
+  ServiceResult result;
+  SlotQuery query;
+
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "A-01"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 2, "B-01"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 3, "B-02"),
+                   PARKING_SERVICE_SUCCESS);
+
+  slot_query_init(&query);
+  slot_query_where_status(&query, FREE_STATUS);
+  slot_query_where_location(&query, "B-");
+  result = parking_service_query_slots(lot, &query, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(((SlotQueryResult *)result.data)->total_found, 2);
+  parking_service_free_result(&result);
+
+  result = parking_service_query_slots(lot, &query, 1);
+  assert_int_equal(((SlotQueryResult *)result.data)->total_found, 1);
+  parking_service_free_result(&result);
+  result = parking_service_query_slots(lot, NULL, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  /* 指定任务池后小停车场仍串行执行，结果不变 */
+  pool = parking_task_pool_create(2);
+  assert_non_null(pool);
+  result = parking_service_configure_parallel_queries(lot, pool);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_query_slots(lot, &query, 0);
+  assert_int_equal(((SlotQueryResult *)result.data)->total_found, 2);
+  parking_service_free_result(&result);
+  result = parking_service_configure_parallel_queries(lot, NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  parking_task_pool_destroy(pool);
+  result = parking_service_configure_parallel_queries(NULL, NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+}
+
+/**
+ * @brief 测试服务层的车位预约与时段空位查询。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_reservations(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  time_t now = time(NULL);
+  Reservation reservation;
+  ServiceResult result;
+  int slot_id;
+  int available;
+
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "C-01"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 2, "C-02"),
+                   PARKING_SERVICE_SUCCESS);
+
+  result = parking_service_reserve_zone(lot, "C-", "京A12345", now + 60,
+                                        now + 3600, &reservation);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(reservation.slot_id, 1);
+  result = parking_service_reserve_slot(lot, 1, "京A54321", now + 600,
+                                        now + 1200, NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_OCCUPIED);
+  result = parking_service_reserve_slot(lot, 1, "京A54321", now + 600, now,
+                                        NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  result = parking_service_check_availability(lot, "C-", now + 60, now + 3600,
+                                              &slot_id, &available);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 2);
+  assert_int_equal(available, 1);
+
+  /* 预约即将开始，车位只留给预约的车辆 */
+  result = parking_service_allocate_slot(lot, 1, "张三", "京A54321",
+                                         "13800138000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_OCCUPIED);
+  result = parking_service_allocate_any_slot(lot, "张三", "京A54321",
+                                             "13800138000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(((ParkingSlot *)result.data)->slot_id, 2);
+
+  result = parking_service_check_availability(lot, "C-", now, now + 3600,
+                                              &slot_id, NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_int_equal(slot_id, 0);
+
+  result = parking_service_cancel_reservation(lot, 1, reservation.id);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_cancel_reservation(lot, 1, reservation.id);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  result = parking_service_allocate_slot(lot, 1, "李四", "京A11111",
+                                         "13800138000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+}
+
+/**
+ * @brief 测试居民固定车位与按类型划分的分配池。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_slot_pools(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ServiceResult result;
+  struct tm moment;
+  int slot_id;
+  int i;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 5;
+  moment.tm_mday = 3;
+  moment.tm_hour = 10;
+  moment.tm_isdst = -1;
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL,
+                                           mktime(&moment));
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  for (i = 1; i <= 4; i++) {
+    char location[8];
+
+    sprintf(location, "R-%d", i);
+    assert_int_equal(parking_service_fast_add_slot(lot, i, location),
+                     PARKING_SERVICE_SUCCESS);
+  }
+  /* 1、2 号为居民专用，3 号是京A00001 的固定车位，4 号共享 */
+  assert_int_equal(
+      parking_service_set_slot_pool(lot, 1, SLOT_POOL_RESIDENT).code,
+      PARKING_SERVICE_SUCCESS);
+  assert_int_equal(
+      parking_service_set_slot_pool(lot, 2, SLOT_POOL_RESIDENT).code,
+      PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_set_slot_pool(lot, 9, SLOT_POOL_SHARED).code,
+                   PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_int_equal(parking_service_assign_home_slot(lot, "京A00001", 3).code,
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_assign_home_slot(lot, "京A00002", 3).code,
+                   PARKING_SERVICE_SLOT_OCCUPIED);
+  assert_int_equal(parking_service_set_slot_pool(lot, 3, SLOT_POOL_SHARED).code,
+                   PARKING_SERVICE_SLOT_OCCUPIED);
+
+  /* 访客只能取共享池，取完之后居民池与固定车位仍留给居民 */
+  result = parking_service_allocate_any_slot(lot, "访客甲", "沪C00001",
+                                             "13800000001", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(((ParkingSlot *)result.data)->slot_id, 4);
+  assert_int_equal(parking_service_fast_allocate_any_slot(
+                       lot, "访客乙", "沪C00002", "13800000002",
+                       VISITOR_TYPE, &slot_id),
+                   PARKING_SERVICE_SLOT_NOT_FOUND);
+  result = parking_service_allocate_slot(lot, 1, "访客乙", "沪C00002",
+                                         "13800000002", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_OCCUPIED);
+
+  /* 居民优先回到固定车位；其他居民不能停入别人的固定车位 */
+  result = parking_service_allocate_slot(lot, 3, "居民乙", "京A00002",
+                                         "13900000002", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_OCCUPIED);
+  assert_int_equal(parking_service_fast_allocate_any_slot(
+                       lot, "居民甲", "京A00001", "13900000001",
+                       RESIDENT_TYPE, &slot_id),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 3);
+  assert_int_equal(parking_service_fast_allocate_any_slot(
+                       lot, "居民乙", "京A00002", "13900000002",
+                       RESIDENT_TYPE, &slot_id),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 1);
+
+  /* 撤销后车位留在居民池，可以分给其他居民 */
+  assert_int_equal(parking_service_deallocate_slot(lot, 3).code,
+                   PARKING_SERVICE_SUCCESS);
+  result = parking_service_release_home_slot(lot, "京A00001", &slot_id);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 3);
+  assert_int_equal(
+      parking_service_release_home_slot(lot, "京A00001", &slot_id).code,
+      PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_int_equal(find_home_slot(lot, "京A00001"), 0);
+  assert_int_equal(
+      parking_service_set_slot_pool(lot, 2, SLOT_POOL_VISITOR).code,
+      PARKING_SERVICE_SUCCESS);
+  assert_true(find_free_slot_for(lot, RESIDENT_TYPE, "京A00003") ==
+              find_slot_by_id(lot, 3));
+  assert_true(find_free_slot_for(lot, VISITOR_TYPE, "沪C00002") ==
+              find_slot_by_id(lot, 2));
+  assert_int_equal(delete_slot(lot, 2), 0);
+  assert_null(find_free_slot_for(lot, VISITOR_TYPE, "沪C00002"));
+}
+
+/**
+ * @brief 测试服务层按坐标与地标查找最近的空闲车位。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_nearest_free_slot(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ServiceResult result;
+  int slot_id;
+  int i;
+
+  for (i = 1; i <= 3; i++) {
+    char location[8];
+
+    sprintf(location, "E-%02d", i);
+    assert_int_equal(parking_service_fast_add_slot(lot, i, location),
+                     PARKING_SERVICE_SUCCESS);
+    result = parking_service_set_slot_position(lot, i, (long)i * 100, 0);
+    assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  }
+  result = parking_service_set_slot_position(lot, 9, 0, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  result = parking_service_set_landmark(lot, "西门", 320, 40);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  result = parking_service_find_nearest_free_slot(lot, 0, 0, &slot_id);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 1);
+  result = parking_service_find_nearest_free_slot_to(lot, "西门", &slot_id);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 3);
+  result = parking_service_find_nearest_free_slot_to(lot, "东门", &slot_id);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  result = parking_service_allocate_slot(lot, 3, "张三", "京A12345",
+                                         "13800138000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_find_nearest_free_slot_to(lot, "西门", &slot_id);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(slot_id, 2);
+
+  result = parking_service_allocate_slot(lot, 1, "李四", "京A11111",
+                                         "13800138000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 2, "王五", "京A22222",
+                                         "13800138000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_find_nearest_free_slot(lot, 0, 0, &slot_id);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_int_equal(slot_id, 0);
+}
+
+/**
+ * @brief (测试辅助函数) 分区处理函数，统计收到的通知数。
+ * @param lot 计数变化的停车场。
+ * @param stats 变化后的分区计数。
+ * @param ctx 指向计数器的指针。
+ */
+static void count_zone_change(ParkingLot *lot, const ParkingZoneStats *stats,
+                              void *ctx) {
+  (void)lot;
+  (void)stats;
+  (*(int *)ctx)++;
+}
+
+/**
+ * @brief 测试服务层的分区空位统计与变化通知。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_zone_stats(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingZoneStats stats[2];
+  ServiceResult result;
+  int changes = 0;
+  int count;
+
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "F1-01"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 2, "F1-02"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 3, "F2-01"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_add_zone(lot, "F1-").code,
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_add_zone(lot, "F2-").code,
+                   PARKING_SERVICE_SUCCESS);
+  result = parking_service_set_zone_handler(lot, count_zone_change, &changes);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  result = parking_service_allocate_slot(lot, 2, "张三", "京A12345",
+                                         "13800138000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(changes, 1);
+  result = parking_service_get_zone_stats(lot, "F1-", &stats[0]);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(stats[0].total_slots, 2);
+  assert_int_equal(stats[0].free_slots, 1);
+  assert_int_equal(stats[0].occupied_slots, 1);
+  result = parking_service_get_zone_stats(lot, "F3-", &stats[0]);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+
+  result = parking_service_list_zone_stats(lot, stats, 2, &count);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(count, 2);
+  assert_string_equal(stats[1].zone, "F2-");
+  assert_int_equal(stats[1].free_slots, 1);
+
+  assert_int_equal(parking_service_remove_zone(lot, "F2-").code,
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_remove_zone(lot, "F2-").code,
+                   PARKING_SERVICE_SLOT_NOT_FOUND);
+  parking_service_set_zone_handler(lot, NULL, NULL);
+}
+
+/**
+ * @brief 测试服务层的车位变更订阅。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_change_feed(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  struct ChangeSubscription *subscription;
+  ParkingChange changes[8];
+  ServiceResult result;
+  int count;
+  int dropped;
+
+  result = parking_service_subscribe_changes(lot, 16, &subscription);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "G-01"),
+                   PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 1, "张三", "京A12345",
+                                         "13800138000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  result = parking_service_poll_changes(subscription, changes, 8, &count,
+                                        &dropped);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(count, 2);
+  assert_int_equal(dropped, 0);
+  assert_int_equal(changes[0].kind, PARKING_CHANGE_ADD_SLOT);
+  assert_int_equal(changes[1].kind, PARKING_CHANGE_ALLOCATE);
+  assert_int_equal(changes[1].slot_id, 1);
+
+  result = parking_service_unsubscribe_changes(lot, subscription);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_poll_changes(NULL, changes, 8, &count, NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+}
+
+/**
+ * @brief 测试结果数据块池对列表与统计信息的回收。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_result_pool(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ServiceResult list;
+  ServiceResult again;
+  PoolStats stats;
+  void *payload;
+  void *array;
+
+  assert_int_equal(parking_service_get_pool_stats(NULL),
+                   PARKING_SERVICE_INVALID_PARAM);
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "P-1"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 2, "P-2"),
+                   PARKING_SERVICE_SUCCESS);
+
+  /* 同一线程释放后立即再次查询，应复用刚回收的两个块（数据块与两元素的数组
+   * 同属最小级别，复用时可能互换） */
+  list = parking_service_get_all_slots(lot);
+  assert_int_equal(list.code, PARKING_SERVICE_SUCCESS);
+  payload = list.data;
+  array = ((SlotQueryResult *)list.data)->slot_list;
+  parking_service_free_result(&list);
+  again = parking_service_get_all_slots(lot);
+  assert_int_equal(again.code, PARKING_SERVICE_SUCCESS);
+  assert_true(again.data == payload || again.data == array);
+  assert_true(((SlotQueryResult *)again.data)->slot_list == payload ||
+              ((SlotQueryResult *)again.data)->slot_list == array);
+  assert_int_equal(((SlotQueryResult *)again.data)->total_found, 2);
+  parking_service_free_result(&again);
+
+  assert_int_equal(parking_service_get_pool_stats(&stats),
+                   PARKING_SERVICE_SUCCESS);
+  assert_true(stats.cached_blocks >= 2);
+  assert_true(stats.hits >= 2);
+  parking_service_trim_result_pool();
+  parking_service_get_pool_stats(&stats);
+  assert_int_equal(stats.cached_blocks, 0);
+  assert_int_equal(stats.cached_bytes, 0);
+}
+
+#ifdef PARKING_EXPORTER
+/**
+ * @brief 测试 OpenMetrics 文本的渲染。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_exporter_render(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  char *text = (char *)malloc(PARKING_EXPORTER_BUFFER_SIZE);
+  char small[64];
+  int length;
+
+  assert_non_null(text);
+  parking_service_reset_metrics();
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "E-1"),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_add_slot(lot, 1, "E-1"),
+                   PARKING_SERVICE_SLOT_EXISTS);
+
+  length = parking_exporter_render(lot, text, PARKING_EXPORTER_BUFFER_SIZE);
+  assert_true(length > 0);
+  assert_int_equal((int)strlen(text), length);
+  sprintf(small, "parking_lot_slots{state=\"total\"} %d\n", lot->total_slots);
+  assert_non_null(strstr(text, small));
+  assert_non_null(strstr(text, "parking_lot_occupancy_ratio 0.000000\n"));
+  assert_string_equal(text + length - 6, "# EOF\n");
+  if (strstr(text, "parking_service_calls")) {
+    assert_non_null(strstr(text, "parking_service_calls_total{"
+                                 "operation=\"add_slot\","
+                                 "code=\"slot_exists\"} 1\n"));
+    assert_non_null(strstr(text, "parking_service_latency_seconds_bucket{"
+                                 "operation=\"add_slot\",le=\"+Inf\"} 2\n"));
+    assert_null(strstr(text, "operation=\"checkout_slot\""));
+  }
+
+  assert_int_equal(parking_exporter_render(lot, small, sizeof(small)), -1);
+  assert_string_equal(small, "");
+  assert_int_equal(parking_exporter_render(NULL, text, 16), -1);
+  free(text);
+}
+#endif
+
+/**
+ * @brief 测试可切换的业务时间源。
+ * @details 虚拟时钟下访客在任意真实时刻都按设定的时刻入场与计费，
+ *          入场、出场与统计读到的都是同一个虚拟时刻；缓存时钟只在 tick 时前进。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_clock(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ExitReceipt receipt;
+  ServiceResult result;
+  struct tm moment;
+  time_t start;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 2;
+  moment.tm_mday = 10;
+  moment.tm_hour = 10;
+  moment.tm_isdst = -1;
+  start = mktime(&moment);
+
+  assert_int_equal(
+      parking_service_configure_clock(lot, (ParkingClockMode)9, 0).code,
+      PARKING_SERVICE_INVALID_PARAM);
+  assert_int_equal(set_parking_clock(lot, start), -1); /* 仍是实时时钟 */
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL, start);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_true(parking_lot_now(lot) == start);
+
+  parking_service_add_slot(lot, 1, "C-1");
+  result = parking_service_allocate_slot(lot, 1, "访客", "沪C00001",
+                                         "13800000001", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_true(find_slot_by_id(lot, 1)->entry_time == start);
+
+  assert_int_equal(advance_parking_clock(lot, -1), -1);
+  assert_int_equal(advance_parking_clock(lot, 2 * 3600 + 1800), 0);
+  assert_int_equal(parking_service_fast_deallocate_slot(lot, 1, &receipt),
+                   PARKING_SERVICE_SUCCESS);
+  assert_true(receipt.exit_time == start + 9000);
+  assert_int_equal(receipt.duration_seconds, 9000);
+  assert_int_equal(receipt.billed_hours, 3);
+  assert_true(find_slot_by_id(lot, 1)->exit_time == start + 9000);
+
+  /* 虚拟时钟在访客时段之外：访客入场被拒绝 */
+  assert_int_equal(set_parking_clock(lot, start + 12 * 3600), 0);
+  result = parking_service_allocate_slot(lot, 1, "访客", "沪C00001",
+                                         "13800000001", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_TIME_INVALID);
+
+  /* 缓存时钟只在 tick 时刷新 */
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_CACHED, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_true(parking_lot_now(lot) >= start);
+  assert_int_equal(advance_parking_clock(lot, 10), -1);
+  assert_true(tick_parking_clock(lot) == parking_lot_now(lot));
+}
+
+/**
+ * @brief 统计日志落盘通知次数的回调。
+ */
+static void count_durable_batches(unsigned long first_seq,
+                                  unsigned long last_seq, time_t durable_at,
+                                  void *ctx) {
+  (void)first_seq;
+  (void)last_seq;
+  (void)durable_at;
+  (*(int *)ctx)++;
+}
+
+/**
+ * @brief 测试 `parking_service_apply_batch` 批量处理出入场事件。
+ * @details
+ * 验证同一车位的事件按原始顺序执行、各事件的状态码独立返回，
+ * 且整批事件的日志记录只同步一次。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_apply_batch(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  const char *snapshot_file = "batch_test.bin";
+  const char *image_file = "batch_test.bin" INDEX_IMAGE_SUFFIX;
+  const char *journal_file = "batch_test.wal";
+  GateEvent events[7];
+  ParkingServiceResultCode codes[7];
+  ValidationIssue issues[7];
+  ServiceResult result;
+  int syncs = 0;
+
+  parking_service_add_slot(lot, 1, "B-1");
+  parking_service_add_slot(lot, 2, "B-2");
+  parking_service_add_slot(lot, 3, "B-3");
+  result = parking_service_enable_journal(lot, snapshot_file, journal_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_configure_group_commit(lot, 1, 0,
+                                                  count_durable_batches, &syncs);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  memset(events, 0, sizeof(events));
+  events[0].kind = GATE_EVENT_ENTRY;
+  events[0].slot_id = 2;
+  events[0].owner_name = "批量";
+  events[0].license_plate = "沪B00002";
+  events[0].contact = "13800000002";
+  events[0].type = RESIDENT_TYPE;
+  events[1].kind = GATE_EVENT_EXIT; /* 车位 1 尚未占用 */
+  events[1].slot_id = 1;
+  events[2] = events[0];
+  events[2].slot_id = 1;
+  events[2].license_plate = "沪B00001";
+  events[3].kind = GATE_EVENT_EXIT; /* 在同一车位入场之后执行 */
+  events[3].slot_id = 1;
+  events[4].kind = GATE_EVENT_EXIT; /* 编号非法 */
+  events[4].slot_id = 0;
+  events[5] = events[0]; /* 车位 2 已被本批前一事件占用 */
+  events[5].license_plate = "沪B00005";
+  events[6] = events[0]; /* 车牌已在场 */
+  events[6].slot_id = 3;
+
+  result = parking_service_apply_batch(lot, events, 7, codes);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(codes[0], PARKING_SERVICE_SUCCESS);
+  assert_int_equal(codes[1], PARKING_SERVICE_SLOT_FREE);
+  assert_int_equal(codes[2], PARKING_SERVICE_SUCCESS);
+  assert_int_equal(codes[3], PARKING_SERVICE_SUCCESS);
+  assert_int_equal(codes[4], PARKING_SERVICE_INVALID_PARAM);
+  assert_int_equal(codes[5], PARKING_SERVICE_SLOT_OCCUPIED);
+  assert_int_equal(codes[6], PARKING_SERVICE_LICENSE_EXISTS);
+  assert_int_equal(syncs, 1);
+  assert_int_equal(lot->occupied_slots, 1);
+  assert_int_equal(find_slot_by_id(lot, 1)->status, FREE_STATUS);
+
+  result = parking_service_apply_batch(lot, NULL, 3, codes);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  /* 只校验不执行：报告每个事件第一个失败的字段与原因 */
+  events[1].kind = GATE_EVENT_ENTRY;
+  events[1].owner_name = "批量";
+  events[1].license_plate = "B1";
+  events[1].contact = "13800000001";
+  events[2].contact = "1380000000x";
+  events[3].kind = (GateEventKind)7;
+  events[5].owner_name = "换行\n";
+  assert_int_equal(parking_service_validate_batch(events, 7, issues), 5);
+  assert_int_equal(issues[0].field, VALIDATION_FIELD_NONE);
+  assert_int_equal(issues[1].field, VALIDATION_FIELD_PLATE);
+  assert_int_equal(issues[1].reason, VALIDATION_TOO_SHORT);
+  assert_int_equal(issues[2].field, VALIDATION_FIELD_CONTACT);
+  assert_int_equal(issues[2].reason, VALIDATION_BAD_CHARACTER);
+  assert_int_equal(issues[3].field, VALIDATION_FIELD_KIND);
+  assert_int_equal(issues[4].field, VALIDATION_FIELD_SLOT_ID);
+  assert_int_equal(issues[4].reason, VALIDATION_OUT_OF_RANGE);
+  assert_int_equal(issues[5].field, VALIDATION_FIELD_OWNER);
+  assert_int_equal(issues[6].reason, VALIDATION_OK);
+  assert_int_equal(parking_service_validate_batch(events, 7, NULL), 5);
+  assert_int_equal(parking_service_validate_batch(NULL, 1, NULL), -1);
+
+  disable_parking_journal(lot);
+  remove(snapshot_file);
+  remove(image_file);
+  remove(journal_file);
+}
+
+/**
+ * @brief 测试分区停车场的路由、跨分区唯一性、统计汇总与不同车辆数。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_zone_lots(void **state) {
+  ShardedParkingLot *sharded = init_sharded_lot();
+  ServiceResult result;
+  ParkingStatistics *stats;
+  ParkingLot *lots[2];
+  long distinct;
+  int a1;
+  int b2;
+
+  (void)state; /* not used */
+  assert_non_null(sharded);
+  a1 = sharded_lot_add_zone(sharded, "A1", 10);
+  b2 = sharded_lot_add_zone(sharded, "B2", 20);
+  assert_int_equal(a1, 0);
+  assert_int_equal(b2, 1);
+  assert_int_equal(sharded_lot_add_zone(sharded, "A1", 5), -2);
+  assert_int_equal(sharded_lot_add_zone(sharded, "C-3", 5), -1);
+
+  /* 按位置前缀或显式分区编号添加，编号在所有分区中唯一 */
+  result = parking_service_zone_add_slot(sharded, -1, 1, "A1-001");
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_zone_add_slot(sharded, b2, 2, "East");
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_zone_add_slot(sharded, -1, 1, "B2-001");
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_EXISTS);
+  result = parking_service_zone_add_slot(sharded, -1, 3, "C3-001");
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  assert_int_equal(sharded_lot_zone_of_slot(sharded, 2), b2);
+  assert_int_equal(sharded_lot_zone_lot(sharded, a1)->slot_count, 1);
+
+  result = parking_service_zone_allocate_slot(sharded, 2, "分区", "沪Z00002",
+                                              "13800000002", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_zone_allocate_any_slot(
+      sharded, a1, "分区", "沪Z00002", "13800000002", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_LICENSE_EXISTS);
+  result = parking_service_zone_find_slot_by_license(sharded, "沪Z00002");
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(((ParkingSlot *)result.data)->slot_id, 2);
+
+  result = parking_service_zone_get_statistics(sharded);
+  stats = (ParkingStatistics *)result.data;
+  assert_int_equal(stats->total_slots, 30);
+  assert_int_equal(stats->occupied_slots, 1);
+  parking_service_free_result(&result);
+
+  result = parking_service_zone_deallocate_slot(sharded, 2);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  parking_service_free_result(&result);
+  result = parking_service_zone_deallocate_slot(sharded, 99);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_int_equal(sharded_lot_zone_lot(sharded, b2)->occupied_slots, 0);
+
+  /* 同一辆车先后停在两个分区，合并草图后只计一辆 */
+  result = parking_service_zone_allocate_slot(sharded, 1, "分区", "沪Z00002",
+                                              "13800000002", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_zone_count_distinct_vehicles(
+      sharded, DISTINCT_THIS_WEEK, &distinct);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(distinct, 1);
+  lots[0] = sharded_lot_zone_lot(sharded, a1);
+  lots[1] = sharded_lot_zone_lot(sharded, b2);
+  result = parking_service_count_distinct_vehicles(lots, 2,
+                                                   DISTINCT_THIS_MONTH,
+                                                   &distinct);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(distinct, 1);
+  result = parking_service_count_distinct_vehicles(lots, 1,
+                                                   DISTINCT_LAST_MONTH,
+                                                   &distinct);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(distinct, 0);
+  result = parking_service_count_distinct_vehicles(lots, 0, DISTINCT_THIS_WEEK,
+                                                   &distinct);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  free_sharded_lot(sharded);
+}
+
+/**
+ * @brief 按分配策略入场，返回选中的分区编号。
+ */
+static int allocate_by_policy(ShardedParkingLot *sharded,
+                              ZoneAllocationPolicy policy, int car) {
+  char plate[16];
+  ServiceResult result;
+  int zone = -2;
+
+  sprintf(plate, "沪P%05d", car);
+  result = parking_service_zone_allocate_by_policy(
+      sharded, policy, "策略", plate, "13800000000", RESIDENT_TYPE, &zone);
+  if (result.code != PARKING_SERVICE_SUCCESS) {
+    assert_int_equal(zone, -1);
+    return -1;
+  }
+  return zone;
+}
+
+/**
+ * @brief 测试 `parking_service_zone_allocate_by_policy` 的三种分配策略。
+ * @details 三个分区 A、B、C 依次有 3、2、1 个车位。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_zone_policies(void **state) {
+  static const int capacity[3] = {3, 2, 1};
+  static const char *names[3] = {"A", "B", "C"};
+  ShardedParkingLot *lots[3];
+  int car = 0;
+  int p;
+  int z;
+  int i;
+
+  (void)state; /* not used */
+  for (p = 0; p < 3; p++) {
+    lots[p] = init_sharded_lot();
+    assert_non_null(lots[p]);
+    for (z = 0; z < 3; z++) {
+      assert_int_equal(sharded_lot_add_zone(lots[p], names[z], 5), z);
+      for (i = 0; i < capacity[z]; i++) {
+        char location[16];
+
+        sprintf(location, "%s-%d", names[z], i);
+        assert_int_equal(parking_service_zone_add_slot(lots[p], z,
+                                                       z * 10 + i + 1,
+                                                       location)
+                             .code,
+                         PARKING_SERVICE_SUCCESS);
+      }
+    }
+  }
+
+  /* 占用率最低优先：平局取编号小的，占满的 C 不再参与 */
+  assert_int_equal(allocate_by_policy(lots[0], ZONE_POLICY_LEAST_OCCUPIED,
+                                      ++car), 0);
+  assert_int_equal(allocate_by_policy(lots[0], ZONE_POLICY_LEAST_OCCUPIED,
+                                      ++car), 1);
+  assert_int_equal(allocate_by_policy(lots[0], ZONE_POLICY_LEAST_OCCUPIED,
+                                      ++car), 2);
+  assert_int_equal(allocate_by_policy(lots[0], ZONE_POLICY_LEAST_OCCUPIED,
+                                      ++car), 0);
+  assert_int_equal(allocate_by_policy(lots[0], ZONE_POLICY_LEAST_OCCUPIED,
+                                      ++car), 1);
+  assert_int_equal(allocate_by_policy(lots[0], ZONE_POLICY_LEAST_OCCUPIED,
+                                      ++car), 0);
+  assert_int_equal(allocate_by_policy(lots[0], ZONE_POLICY_LEAST_OCCUPIED,
+                                      ++car), -1);
+
+  /* 轮流：A、B、C、A、B，之后只剩 A */
+  assert_int_equal(allocate_by_policy(lots[1], ZONE_POLICY_ROUND_ROBIN, ++car),
+                   0);
+  assert_int_equal(allocate_by_policy(lots[1], ZONE_POLICY_ROUND_ROBIN, ++car),
+                   1);
+  assert_int_equal(allocate_by_policy(lots[1], ZONE_POLICY_ROUND_ROBIN, ++car),
+                   2);
+  assert_int_equal(allocate_by_policy(lots[1], ZONE_POLICY_ROUND_ROBIN, ++car),
+                   0);
+  assert_int_equal(allocate_by_policy(lots[1], ZONE_POLICY_ROUND_ROBIN, ++car),
+                   1);
+  assert_int_equal(allocate_by_policy(lots[1], ZONE_POLICY_ROUND_ROBIN, ++car),
+                   0);
+
+  /* 离入口最近：C 最近、A 最远，先占满 C 再占 B */
+  assert_int_equal(sharded_lot_set_entrance_distance(lots[2], 0, 9), 0);
+  assert_int_equal(sharded_lot_set_entrance_distance(lots[2], 2, 0), 0);
+  assert_int_equal(sharded_lot_set_entrance_distance(lots[2], 3, 0), -1);
+  assert_int_equal(sharded_lot_set_entrance_distance(lots[2], 1, -1), -1);
+  assert_int_equal(allocate_by_policy(lots[2], ZONE_POLICY_NEAREST_ENTRANCE,
+                                      ++car), 2);
+  assert_int_equal(allocate_by_policy(lots[2], ZONE_POLICY_NEAREST_ENTRANCE,
+                                      ++car), 1);
+  assert_int_equal(allocate_by_policy(lots[2], ZONE_POLICY_NEAREST_ENTRANCE,
+                                      ++car), 1);
+  assert_int_equal(allocate_by_policy(lots[2], ZONE_POLICY_NEAREST_ENTRANCE,
+                                      ++car), 0);
+  assert_int_equal(
+      parking_service_zone_allocate_by_policy(lots[2], (ZoneAllocationPolicy)7,
+                                              "策略", "沪P99999",
+                                              "13800000000", RESIDENT_TYPE,
+                                              NULL)
+          .code,
+      PARKING_SERVICE_INVALID_PARAM);
+
+  for (p = 0; p < 3; p++) {
+    free_sharded_lot(lots[p]);
+  }
+}
+
+/**
+ * @brief 测试 `parking_service_get_statistics` 函数的功能。
+ * @details
+ * 验证统计信息服务是否能返回正确的数据。
+ * 1. 在空停车场中获取统计信息。
+ * 2. 分配一个车位后，再次获取统计信息并验证占用数和使用率是否更新。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_get_statistics(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ServiceResult result;
+  ParkingStatistics *stats;
+  const char *ledger_file = "service_ledger_test.led";
+  const char *history_prefix = "service_history_test";
+  const char *history_suffixes[] = {".plate", ".slot", ".type",
+                                    ".entry", ".exit", ".fee"};
+  SessionSummary summary;
+  char path[64];
+  int i;
+  double monthly_total;
+  long month_key;
+
+  /* 1. 空停车场统计 */
+  result = parking_service_get_statistics(lot);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  stats = (ParkingStatistics *)result.data;
+  assert_non_null(stats);
+  assert_int_equal(stats->total_slots, 10);
+  assert_int_equal(stats->occupied_slots, 0);
+  parking_service_free_result(&result);
+
+  /* 2. 分配一个车位后统计 */
+  parking_service_add_slot(lot, 1, "C-1");
+  parking_service_allocate_slot(lot, 1, "StatUser", "粤BSTAT1", "13912391239",
+                                RESIDENT_TYPE);
+
+  result = parking_service_get_statistics(lot);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  stats = (ParkingStatistics *)result.data;
+  assert_non_null(stats);
+  assert_int_equal(stats->occupied_slots, 1);
+  assert_float_equal(stats->occupancy_rate, 10.0, 0.01);
+  assert_float_equal(stats->today_revenue, 0.0, 0.001);
+  parking_service_free_result(&result);
+
+  remove(ledger_file);
+  result = parking_service_enable_payment_ledger(lot, ledger_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_summarize_sessions(lot, 0, time(NULL), &summary);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  for (i = 0; i < 6; i++) {
+    sprintf(path, "%s%s", history_prefix, history_suffixes[i]);
+    remove(path);
+  }
+  result = parking_service_enable_session_history(lot, history_prefix);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  /* 3. 居民月费逾期一天出场，补缴一个月费用并计入当日与当月收入及收费台账 */
+  find_slot_by_id(lot, 1)->resident_due_date = time(NULL) - 24 * 3600;
+  sync_slot_hot_fields(lot, find_slot_by_id(lot, 1));
+  result = parking_service_get_slots_by_due_date(lot, 0, time(NULL), 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(((SlotQueryResult *)result.data)->total_found, 1);
+  parking_service_free_result(&result);
+  result = parking_service_deallocate_slot(lot, 1);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  parking_service_free_result(&result);
+  /* 补缴后到期时间顺延，不再出现在逾期清单中 */
+  result = parking_service_get_slots_by_due_date(lot, 0, time(NULL), 0);
+  assert_int_equal(((SlotQueryResult *)result.data)->total_found, 0);
+  parking_service_free_result(&result);
+  assert_int_equal(lot->today_revenue_cents, 20000);
+
+  result = parking_service_get_statistics(lot);
+  stats = (ParkingStatistics *)result.data;
+  assert_int_equal(stats->occupied_slots, 0);
+  assert_float_equal(stats->today_revenue, RESIDENT_MONTHLY_FEE, 0.001);
+  assert_float_equal(stats->month_revenue, RESIDENT_MONTHLY_FEE, 0.001);
+  parking_service_free_result(&result);
+  parking_calendar_convert(time(NULL), NULL, &month_key);
+  result = parking_service_get_monthly_payment_total(
+      lot, (int)(month_key / 100), (int)(month_key % 100), &monthly_total);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_float_equal(monthly_total, RESIDENT_MONTHLY_FEE, 0.001);
+  result = parking_service_summarize_sessions(lot, 0, time(NULL) + 1,
+                                              &summary);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(summary.sessions, 1);
+  assert_int_equal(summary.resident_sessions, 1);
+  assert_float_equal(summary.total_fee, RESIDENT_MONTHLY_FEE, 0.001);
+  result = parking_service_get_monthly_payment_total(lot, 2026, 0,
+                                                     &monthly_total);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  /* 4. 记录的日期不是今天时，统计视为新周期而不修改停车场 */
+  lot->revenue_day = 19700101;
+  result = parking_service_get_statistics(lot);
+  stats = (ParkingStatistics *)result.data;
+  assert_float_equal(stats->today_revenue, 0.0, 0.001);
+  assert_float_equal(stats->month_revenue, RESIDENT_MONTHLY_FEE, 0.001);
+  parking_service_free_result(&result);
+  assert_int_equal(lot->today_revenue_cents, 20000);
+  disable_payment_ledger(lot);
+  disable_session_history(lot);
+  remove(ledger_file);
+  for (i = 0; i < 6; i++) {
+    sprintf(path, "%s%s", history_prefix, history_suffixes[i]);
+    remove(path);
+  }
+}
+
+/**
+ * @brief 测试 `parking_service_run_resident_billing` 批量结算居民月费。
+ * @details
+ * 验证到期的居民按自然月开出账单并计入收入与收费台账，
+ * 未到期的居民与访客不受影响，已结算的周期出场时不再重复收取。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_resident_billing(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  const char *ledger_file = "service_billing_test.led";
+  ResidentBillingSummary summary;
+  ExitReceipt receipt;
+  ServiceResult result;
+  struct tm moment;
+  double monthly_total;
+  time_t due;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 2;
+  moment.tm_mday = 1;
+  moment.tm_hour = 8;
+  moment.tm_isdst = -1;
+  due = mktime(&moment);
+
+  assert_int_equal(parking_service_run_resident_billing(NULL, &summary).code,
+                   PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL,
+                                           due + 9 * 24 * 3600);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  remove(ledger_file);
+  result = parking_service_enable_payment_ledger(lot, ledger_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  parking_service_add_slot(lot, 1, "R-1");
+  parking_service_add_slot(lot, 2, "R-2");
+  parking_service_add_slot(lot, 3, "V-1");
+  parking_service_allocate_slot(lot, 1, "居民甲", "沪R00001", "13800000001",
+                                RESIDENT_TYPE);
+  parking_service_allocate_slot(lot, 2, "居民乙", "沪R00002", "13800000002",
+                                RESIDENT_TYPE);
+  parking_service_allocate_slot(lot, 3, "访客", "沪V00001", "13800000003",
+                                VISITOR_TYPE);
+  find_slot_by_id(lot, 1)->resident_due_date = due;
+  sync_slot_hot_fields(lot, find_slot_by_id(lot, 1));
+  find_slot_by_id(lot, 2)->resident_due_date = due + 30 * 24 * 3600;
+  sync_slot_hot_fields(lot, find_slot_by_id(lot, 2));
+
+  /* 3 月 10 日结算：只有居民甲到期，到期时间顺延到 4 月 1 日 */
+  result = parking_service_run_resident_billing(lot, &summary);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(summary.invoices, 1);
+  assert_int_equal(summary.periods, 1);
+  assert_int_equal(summary.amount_cents, 20000);
+  assert_float_equal(summary.amount, RESIDENT_MONTHLY_FEE, 0.001);
+  assert_true(find_slot_by_id(lot, 1)->resident_due_date ==
+              parking_calendar_add_months(due, 1));
+  assert_true(find_slot_by_id(lot, 2)->resident_due_date ==
+              due + 30 * 24 * 3600);
+  assert_int_equal(lot->today_revenue_cents, 20000);
+  result = parking_service_get_monthly_payment_total(lot, 2026, 3,
+                                                     &monthly_total);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_float_equal(monthly_total, RESIDENT_MONTHLY_FEE, 0.001);
+
+  /* 再次结算没有新账单；居民甲出场不再补缴 */
+  result = parking_service_run_resident_billing(lot, &summary);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(summary.invoices, 0);
+  assert_int_equal(parking_service_fast_deallocate_slot(lot, 1, &receipt),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(receipt.overdue_months, 0);
+  assert_int_equal(receipt.amount_cents, 0);
+  assert_int_equal(lot->today_revenue_cents, 20000);
+
+  disable_payment_ledger(lot);
+  remove(ledger_file);
+}
+
+/**
+ * @brief 测试 `parking_service_sweep_visitors` 闭场批量出场。
+ * @details
+ * 验证在场访客按单独出场的费率计费、一并释放并计入收入与收费台账，
+ * 居民车辆与空闲车位不受影响。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_sweep_visitors(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  const char *ledger_file = "service_sweep_test.led";
+  VisitorSweepSummary summary;
+  ServiceResult result;
+  struct tm moment;
+  double monthly_total;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 5;
+  moment.tm_mday = 3;
+  moment.tm_hour = 9;
+  moment.tm_isdst = -1;
+
+  assert_int_equal(parking_service_sweep_visitors(NULL, &summary).code,
+                   PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL,
+                                           mktime(&moment));
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  remove(ledger_file);
+  result = parking_service_enable_payment_ledger(lot, ledger_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  parking_service_add_slot(lot, 1, "S-1");
+  parking_service_add_slot(lot, 2, "S-2");
+  parking_service_add_slot(lot, 3, "S-3");
+  parking_service_add_slot(lot, 4, "S-4");
+  parking_service_allocate_slot(lot, 1, "访客甲", "沪S00001", "13800000001",
+                                VISITOR_TYPE);
+  parking_service_allocate_slot(lot, 2, "居民", "沪S00002", "13800000002",
+                                RESIDENT_TYPE);
+  parking_service_allocate_slot(lot, 4, "访客乙", "沪S00004", "13800000004",
+                                VISITOR_TYPE);
+  assert_int_equal(advance_parking_clock(lot, 3 * 3600 - 60), 0);
+
+  result = parking_service_sweep_visitors(lot, &summary);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(summary.released, 2);
+  assert_int_equal(summary.billed_hours, 6);
+  assert_int_equal(summary.amount_cents, 6000);
+  assert_float_equal(summary.amount, 60.0, 0.001);
+  assert_int_equal(find_slot_by_id(lot, 1)->status, FREE_STATUS);
+  assert_int_equal(find_slot_by_id(lot, 4)->status, FREE_STATUS);
+  assert_int_equal(find_slot_by_id(lot, 2)->status, OCCUPIED_STATUS);
+  assert_null(find_slot_by_license(lot, "沪S00001"));
+  assert_int_equal(lot->occupied_slots, 1);
+  assert_int_equal(lot->today_revenue_cents, 6000);
+  result = parking_service_get_monthly_payment_total(lot, 2026, 6,
+                                                     &monthly_total);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_float_equal(monthly_total, 60.0, 0.001);
+
+  /* 没有在场访客时清场不产生任何出场 */
+  result = parking_service_sweep_visitors(lot, &summary);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(summary.released, 0);
+  assert_int_equal(lot->today_revenue_cents, 6000);
+
+  disable_payment_ledger(lot);
+  remove(ledger_file);
+}
+
+/**
+ * @brief 测试 `parking_service_get_revenue_report` 读取滚动汇总。
+ * @details
+ * 验证日切清零当日收入后，最近 7 天的收入仍包含前几天的出场费用，
+ * 且本月高峰小时与按类型的收入正确。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_revenue_report(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  RevenueReport report;
+  ExitReceipt receipt;
+  ServiceResult result;
+  struct tm moment;
+  time_t start;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 4;
+  moment.tm_mday = 11;
+  moment.tm_hour = 9;
+  moment.tm_isdst = -1;
+  start = mktime(&moment);
+
+  assert_int_equal(parking_service_get_revenue_report(lot, NULL).code,
+                   PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL, start);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  parking_service_add_slot(lot, 1, "C-1");
+  parking_service_add_slot(lot, 2, "C-2");
+
+  /* 5 月 11 日：两辆访客各停 3 小时，同一小时出场 */
+  parking_service_allocate_slot(lot, 1, "访客甲", "沪D00001", "13800000001",
+                                VISITOR_TYPE);
+  parking_service_allocate_slot(lot, 2, "访客乙", "沪D00002", "13800000002",
+                                VISITOR_TYPE);
+  assert_int_equal(advance_parking_clock(lot, 3 * 3600 - 60), 0);
+  assert_int_equal(parking_service_fast_deallocate_slot(lot, 1, &receipt),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_fast_deallocate_slot(lot, 2, &receipt),
+                   PARKING_SERVICE_SUCCESS);
+
+  /* 两天后再停 1 小时：当日收入只有这一笔，7 天收入包含两天 */
+  assert_int_equal(advance_parking_clock(lot, 2 * 24 * 3600), 0);
+  parking_service_allocate_slot(lot, 1, "访客甲", "沪D00001", "13800000001",
+                                VISITOR_TYPE);
+  assert_int_equal(advance_parking_clock(lot, 1800), 0);
+  assert_int_equal(parking_service_fast_deallocate_slot(lot, 1, &receipt),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(receipt.amount_cents, 1000);
+
+  result = parking_service_get_revenue_report(lot, &report);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_float_equal(report.hour_revenue, 10.0, 0.001);
+  assert_float_equal(report.week_revenue, 70.0, 0.001);
+  assert_float_equal(report.week_type_revenue[VISITOR_TYPE], 70.0, 0.001);
+  assert_float_equal(report.week_type_revenue[RESIDENT_TYPE], 0.0, 0.001);
+  assert_int_equal(report.week_entries, 3);
+  assert_int_equal(report.week_exits, 3);
+  assert_true(report.peak_revenue_hour == (start + 2 * 3600) / 3600 * 3600);
+  assert_float_equal(report.peak_hour_revenue, 60.0, 0.001);
+  assert_true(report.peak_entry_hour == start / 3600 * 3600);
+  assert_int_equal(report.peak_hour_entries, 2);
+}
+
+/**
+ * @brief 测试禁止入场名单与 VIP 名单在入场时的检查与整体替换。
+ * @details
+ * 禁止入场名单中的车牌入场返回 PARKING_SERVICE_PLATE_BLOCKED；
+ * VIP 访客在允许时段之外也能入场；名单从文件重新载入后旧名单失效。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_plate_lists(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  const char *list_file = "service_plate_list_test.txt";
+  const char *blocked[] = {"沪F00001", "沪F00002"};
+  const char *vip[] = {"沪F00009"};
+  ServiceResult result;
+  struct tm moment;
+  FILE *file;
+  int in_blocked;
+  int in_vip;
+  int line;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 9;
+  moment.tm_mday = 14;
+  moment.tm_hour = 20; /* 访客允许入场时段之外 */
+  moment.tm_isdst = -1;
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL,
+                                           mktime(&moment));
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  parking_service_add_slot(lot, 1, "J-1");
+  parking_service_add_slot(lot, 2, "J-2");
+
+  result = parking_service_set_plate_list(lot, PLATE_LIST_BLOCKED, blocked, 2);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_set_plate_list(lot, PLATE_LIST_VIP, vip, 1);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_check_plate(lot, "沪F00002", &in_blocked, &in_vip);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(in_blocked, 1);
+  assert_int_equal(in_vip, 0);
+
+  result = parking_service_allocate_slot(lot, 1, "车主甲", "沪F00001",
+                                         "13800000001", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_PLATE_BLOCKED);
+  result = parking_service_allocate_slot(lot, 1, "车主乙", "沪F00008",
+                                         "13800000008", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_TIME_INVALID);
+  result = parking_service_allocate_slot(lot, 1, "车主丙", "沪F00009",
+                                         "13800000009", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  /* 新名单整体替换旧名单：沪F00001 可以入场，沪F00003 不能 */
+  file = fopen(list_file, "w");
+  assert_non_null(file);
+  fputs("# 新名单\n沪F00003\n", file);
+  fclose(file);
+  result = parking_service_load_plate_list(lot, PLATE_LIST_BLOCKED, list_file,
+                                           &line);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 2, "车主甲", "沪F00003",
+                                         "13800000003", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_PLATE_BLOCKED);
+  result = parking_service_allocate_slot(lot, 2, "车主甲", "沪F00001",
+                                         "13800000001", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  remove(list_file);
+
+  result = parking_service_load_plate_list(lot, PLATE_LIST_BLOCKED, list_file,
+                                           &line);
+  assert_int_equal(result.code, PARKING_SERVICE_FILE_ERROR);
+  result = parking_service_set_plate_list(lot, PLATE_LIST_KINDS, blocked, 2);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_set_plate_list(lot, PLATE_LIST_BLOCKED, NULL, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  parking_service_check_plate(lot, "沪F00003", &in_blocked, NULL);
+  assert_int_equal(in_blocked, 0);
+}
+
+/**
+ * @brief (测试辅助函数) 异步操作的完成通知：累计完成数与成功数。
+ * @param op 完成的操作。
+ * @param ctx 两个 int 计数：[0] 完成数，[1] 成功数。
+ */
+static void count_async_done(ParkingAsyncOp *op, void *ctx) {
+  int *counts = (int *)ctx;
+
+  counts[0]++;
+  if (op->code == PARKING_SERVICE_SUCCESS) {
+    counts[1]++;
+  }
+}
+
+/**
+ * @brief 测试异步提交：完成通知、完成队列与按提交顺序执行。
+ * @details 先提交添加车位（以通知完成），紧接着提交入场与统计（从完成
+ *          队列取回），入场一定在车位添加之后执行；停止时排队的出场执行完。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_async_operations(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingAsync *async = parking_async_start(lot);
+  ParkingAsyncOp adds[8];
+  ParkingAsyncOp entries[8];
+  ParkingAsyncOp exits[8];
+  ParkingAsyncOp stats;
+  ParkingAsyncOp *completed[4];
+  char plates[8][16];
+  int counts[2] = {0, 0};
+  int seen = 0;
+  int received = 0;
+  int i;
+
+  assert_non_null(async);
+  assert_null(parking_async_start(NULL));
+  parking_async_op_init(&stats, PARKING_ASYNC_KINDS);
+  assert_int_equal(parking_async_submit(async, &stats), -1);
+
+  for (i = 0; i < 8; i++) {
+    parking_async_op_init(&adds[i], PARKING_ASYNC_ADD_SLOT);
+    adds[i].slot_id = i + 1;
+    adds[i].location = "AS-1";
+    adds[i].done = count_async_done;
+    adds[i].ctx = counts;
+    assert_int_equal(parking_async_submit(async, &adds[i]), 0);
+  }
+  for (i = 0; i < 8; i++) {
+    sprintf(plates[i], "闽A0000%d", i);
+    parking_async_op_init(&entries[i], PARKING_ASYNC_ALLOCATE_ANY_SLOT);
+    entries[i].owner_name = "车主";
+    entries[i].license_plate = plates[i];
+    entries[i].contact = "13600000000";
+    entries[i].type = RESIDENT_TYPE;
+    assert_int_equal(parking_async_submit(async, &entries[i]), 0);
+  }
+  parking_async_op_init(&stats, PARKING_ASYNC_GET_STATISTICS);
+  assert_int_equal(parking_async_submit(async, &stats), 0);
+
+  while (received < 9) {
+    int got = parking_async_poll(async, completed, 4, 1000);
+
+    assert_true(got >= 0);
+    for (i = 0; i < got; i++) {
+      if (completed[i] == &stats) {
+        assert_int_equal(received, 8); /* 按提交顺序完成 */
+      } else {
+        assert_int_equal(completed[i]->code, PARKING_SERVICE_SUCCESS);
+        seen |= 1 << (completed[i]->slot_id - 1);
+      }
+      received++;
+    }
+  }
+  assert_int_equal(seen, 0xFF);
+  assert_int_equal(stats.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(stats.stats.occupied_slots, 8);
+  assert_int_equal(parking_async_poll(async, completed, 4, 0), 0);
+  assert_int_equal(parking_async_poll(async, NULL, 4, 0), -1);
+
+  for (i = 0; i < 8; i++) {
+    parking_async_op_init(&exits[i], PARKING_ASYNC_DEALLOCATE_SLOT);
+    exits[i].slot_id = entries[i].slot_id;
+    exits[i].done = count_async_done;
+    exits[i].ctx = counts;
+    assert_int_equal(parking_async_submit(async, &exits[i]), 0);
+  }
+  parking_async_stop(async);
+  assert_int_equal(counts[0], 16);
+  assert_int_equal(counts[1], 16);
+  assert_int_equal(lot->occupied_slots, 0);
+  assert_int_equal(exits[0].receipt.slot_id, entries[0].slot_id);
+}
+
+/**
+ * @brief (测试辅助函数) 异步操作的完成通知：按完成顺序记下操作种类。
+ * @param op 完成的操作。
+ * @param ctx int 数组：[0] 完成数，之后依次是各操作的种类。
+ */
+static void record_async_kind(ParkingAsyncOp *op, void *ctx) {
+  int *order = (int *)ctx;
+
+  order[1 + order[0]++] = (int)op->kind;
+}
+
+/**
+ * @brief 测试异步提交的准入控制：队列满时返回繁忙，出场优先于查询。
+ * @details 持有停车场写锁，使属主线程卡在第一个添加车位上，之后提交的
+ *          查询与出场都留在队列中；释放写锁后出场先于查询完成。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_async_admission(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingAsync *async = parking_async_start(lot);
+  ParkingAsyncOp blocker;
+  ParkingAsyncOp lookups[4];
+  ParkingAsyncOp exits[2];
+  ParkingAsyncStats stats;
+  int order[8] = {0};
+  int i;
+
+  assert_non_null(async);
+  assert_int_equal(parking_async_priority(PARKING_ASYNC_DEALLOCATE_SLOT),
+                   PARKING_ASYNC_PRIORITY_EXIT);
+  assert_int_equal(
+      parking_async_set_limit(async, PARKING_ASYNC_PRIORITY_LOOKUP, 0), -1);
+  assert_int_equal(
+      parking_async_set_limit(async, PARKING_ASYNC_PRIORITY_LOOKUP, 3), 0);
+
+  parking_lot_write_lock(lot);
+  parking_async_op_init(&blocker, PARKING_ASYNC_ADD_SLOT);
+  blocker.slot_id = 1;
+  blocker.location = "AD-1";
+  blocker.done = record_async_kind;
+  blocker.ctx = order;
+  assert_int_equal(parking_async_submit(async, &blocker), 0);
+  do {
+    parking_async_stats(async, &stats);
+  } while (stats.queued[PARKING_ASYNC_PRIORITY_ENTRY] != 0);
+
+  for (i = 0; i < 4; i++) {
+    parking_async_op_init(&lookups[i], PARKING_ASYNC_GET_STATISTICS);
+    lookups[i].done = record_async_kind;
+    lookups[i].ctx = order;
+    assert_int_equal(parking_async_submit(async, &lookups[i]), i < 3 ? 0 : -3);
+  }
+  assert_int_equal(lookups[3].code, PARKING_SERVICE_BUSY);
+  for (i = 0; i < 2; i++) {
+    parking_async_op_init(&exits[i], PARKING_ASYNC_DEALLOCATE_SLOT);
+    exits[i].slot_id = 1;
+    exits[i].done = record_async_kind;
+    exits[i].ctx = order;
+    assert_int_equal(parking_async_submit(async, &exits[i]), 0);
+  }
+  parking_async_stats(async, &stats);
+  assert_int_equal(stats.queued[PARKING_ASYNC_PRIORITY_EXIT], 2);
+  assert_int_equal(stats.queued[PARKING_ASYNC_PRIORITY_LOOKUP], 3);
+  assert_int_equal(stats.limits[PARKING_ASYNC_PRIORITY_LOOKUP], 3);
+  assert_int_equal(stats.rejected[PARKING_ASYNC_PRIORITY_LOOKUP], 1);
+  assert_int_equal(stats.limits[PARKING_ASYNC_PRIORITY_EXIT],
+                   PARKING_ASYNC_DEFAULT_LIMIT);
+  parking_lot_write_unlock(lot);
+  parking_async_stop(async);
+
+  assert_int_equal(order[0], 6);
+  assert_int_equal(order[1], PARKING_ASYNC_ADD_SLOT);
+  assert_int_equal(order[2], PARKING_ASYNC_DEALLOCATE_SLOT);
+  assert_int_equal(order[3], PARKING_ASYNC_DEALLOCATE_SLOT);
+  for (i = 4; i <= 6; i++) {
+    assert_int_equal(order[i], PARKING_ASYNC_GET_STATISTICS);
+  }
+  assert_string_equal(parking_service_code_message(PARKING_SERVICE_BUSY),
+                      "服务繁忙，请稍后重试");
+}
+
+/**
+ * @brief 测试只读视图随批量处理刷新，报表读者不加锁读取。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_read_view(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  GateEvent events[2];
+  ParkingServiceResultCode codes[2];
+  const ParkingView *view;
+  ServiceResult result;
+  int reader;
+
+  parking_service_add_slot(lot, 1, "RV-1");
+  parking_service_add_slot(lot, 2, "RV-2");
+  result = parking_service_refresh_read_view(lot);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_read_view(lot, 1);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  reader = view_hub_attach(lot->view);
+
+  memset(events, 0, sizeof(events));
+  events[0].kind = GATE_EVENT_ENTRY;
+  events[0].slot_id = 2;
+  events[0].owner_name = "报表";
+  events[0].license_plate = "粤B00001";
+  events[0].contact = "13700000000";
+  events[0].type = RESIDENT_TYPE;
+  events[1] = events[0];
+  events[1].slot_id = 1;
+  events[1].license_plate = "粤B00002";
+  result = parking_service_apply_batch(lot, events, 2, codes);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  view = view_hub_pin(lot->view, reader);
+  assert_int_equal(view->occupied_slots, 2);
+  assert_string_equal(parking_view_find(view, 2)->license_plate, "粤B00001");
+  view_hub_unpin(lot->view, reader);
+
+  /* 单笔出场不刷新，主动刷新后才可见 */
+  result = parking_service_deallocate_slot(lot, 1);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  parking_service_free_result(&result);
+  view = view_hub_pin(lot->view, reader);
+  assert_int_equal(view->occupied_slots, 2);
+  view_hub_unpin(lot->view, reader);
+  result = parking_service_refresh_read_view(lot);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  view = view_hub_pin(lot->view, reader);
+  assert_int_equal(view->occupied_slots, 1);
+  view_hub_unpin(lot->view, reader);
+
+  result = parking_service_configure_read_view(lot, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SYSTEM_ERROR);
+  view_hub_detach(lot->view, reader);
+  result = parking_service_configure_read_view(lot, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+}
+
+/**
+ * @brief 测试 `parking_service_quote_exit` 只报价、不改变状态。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_quote_exit(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ExitReceipt quote;
+  ExitReceipt again;
+  ExitReceipt receipt;
+  ServiceResult result;
+  time_t due;
+
+  parking_service_add_slot(lot, 1, "Q-1");
+  parking_service_add_slot(lot, 2, "Q-2");
+  result = parking_service_allocate_slot(lot, 1, "报价", "赣A00001",
+                                         "13500000000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  find_slot_by_id(lot, 1)->resident_due_date = time(NULL) - 24 * 3600;
+  sync_slot_hot_fields(lot, find_slot_by_id(lot, 1));
+  due = find_slot_by_id(lot, 1)->resident_due_date;
+
+  /* 反复报价结果相同，且不计收入、不顺延到期时间、不释放车位 */
+  result = parking_service_quote_exit(lot, 0, "赣A00001", 0, &quote);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(quote.slot_id, 1);
+  assert_int_equal(quote.overdue_months, 1);
+  assert_true(quote.resident_due_date > due);
+  result = parking_service_quote_exit(lot, 1, NULL, quote.exit_time, &again);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(again.amount_cents, quote.amount_cents);
+  assert_int_equal(lot->today_revenue_cents, 0);
+  assert_int_equal(find_slot_by_id(lot, 1)->resident_due_date, due);
+  assert_int_equal(find_slot_by_id(lot, 1)->status, OCCUPIED_STATUS);
+
+  result = parking_service_checkout_slot(lot, 1, &receipt);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(receipt.amount_cents, quote.amount_cents);
+  assert_int_equal(receipt.resident_due_date, quote.resident_due_date);
+
+  result = parking_service_quote_exit(lot, 0, "赣A00001", 0, &quote);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  result = parking_service_quote_exit(lot, 2, NULL, 0, &quote);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_FREE);
+  result = parking_service_quote_exit(lot, 0, NULL, 0, &quote);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+}
+
+/** 车牌识别流水线测试收到的通知。 */
+typedef struct AnprLog {
+  AnprAction actions[8];           /**< 按通知顺序的处理结果。 */
+  char plates[8][MAX_LICENSE_LEN]; /**< 按通知顺序的规范化车牌。 */
+  int count;                       /**< 通知数。 */
+} AnprLog;
+
+/**
+ * @brief (测试辅助函数) 记录车牌识别流水线的通知。
+ * @param outcome 读数及其结果。
+ * @param ctx 指向 AnprLog 的指针。
+ */
+static void record_anpr_outcome(const AnprOutcome *outcome, void *ctx) {
+  AnprLog *log = (AnprLog *)ctx;
+
+  if (log->count < 8) {
+    log->actions[log->count] = outcome->action;
+    strcpy(log->plates[log->count], outcome->license_plate);
+    log->count++;
+  }
+}
+
+/**
+ * @brief 测试车牌识别流水线的解析、规范化、去重与入场出场路由。
+ * @details 停止流水线会等所有读数处理完，因此第二轮的出场读数一定在
+ *          第一轮的入场之后查表。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_anpr_pipeline(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  AnprConfig config;
+  AnprStats stats;
+  AnprLog log;
+  ParkingAnpr *anpr;
+
+  parking_service_add_slot(lot, 1, "ANPR-1");
+  parking_anpr_default_config(&config);
+  config.entry_type = RESIDENT_TYPE;
+  config.queue_capacity = 3;
+  memset(&log, 0, sizeof(log));
+  config.contact = "12";
+  assert_null(parking_anpr_start(lot, &config, record_anpr_outcome, &log));
+  config.contact = "13900000000";
+
+  anpr = parking_anpr_start(lot, &config, record_anpr_outcome, &log);
+  assert_non_null(anpr);
+  assert_int_equal(parking_anpr_submit(anpr, "gate-1,赣a 12345,95,1000"), 0);
+  assert_int_equal(parking_anpr_submit(anpr, "gate-2,赣A-12345,97,1010"),
+                   0);
+  assert_int_equal(parking_anpr_submit(anpr, "gate-1,赣B00002,40,1010"), 0);
+  assert_int_equal(parking_anpr_submit(anpr, "gate-1,赣B00002,95"), 0);
+  parking_anpr_stop(anpr);
+  assert_int_equal(log.count, 4);
+  assert_int_equal(log.actions[0], ANPR_ACTION_ENTRY);
+  assert_string_equal(log.plates[0], "赣A12345");
+  assert_int_equal(log.actions[1], ANPR_ACTION_DUPLICATE);
+  assert_int_equal(log.actions[2], ANPR_ACTION_LOW_CONFIDENCE);
+  assert_int_equal(log.actions[3], ANPR_ACTION_MALFORMED);
+  assert_int_equal(find_slot_by_id(lot, 1)->status, OCCUPIED_STATUS);
+  assert_string_equal(find_slot_by_id(lot, 1)->contact, "13900000000");
+
+  /* 场内车辆的读数按出场处理 */
+  memset(&log, 0, sizeof(log));
+  anpr = parking_anpr_start(lot, &config, record_anpr_outcome, &log);
+  assert_non_null(anpr);
+  assert_int_equal(parking_anpr_submit(anpr, "gate-3,赣A12345,99,1100\r\n"),
+                   0);
+  assert_int_equal(parking_anpr_submit(NULL, "x"), -1);
+  parking_anpr_stats(anpr, &stats);
+  parking_anpr_stop(anpr);
+  assert_int_equal(stats.submitted, 1);
+  assert_int_equal(log.count, 1);
+  assert_int_equal(log.actions[0], ANPR_ACTION_EXIT);
+  assert_int_equal(find_slot_by_id(lot, 1)->status, FREE_STATUS);
+}
+
+/**
+ * @brief 测试共享内存发布：读者映射文件后读到批量出入场之后的状态。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_shared_memory(void **state) {
+  const char *path = "test_parking_shm.bin";
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingShmReader *reader;
+  ShmCounters counters;
+  ShmSlotRow rows[4];
+  ShmSlotRow row;
+  GateEvent event;
+  ParkingServiceResultCode code;
+  ServiceResult result;
+  int count;
+
+  parking_service_add_slot(lot, 1, "SHM-1");
+  parking_service_add_slot(lot, 2, "SHM-2");
+  result = parking_service_publish_shared_memory(lot);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_shared_memory(lot, path, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  reader = parking_shm_open(path);
+  assert_non_null(reader);
+  assert_int_equal(parking_shm_read_counters(reader, &counters), 0);
+  assert_int_equal(counters.slot_count, 2);
+  assert_int_equal(counters.occupied_slots, 0);
+
+  /* 批量入场之后自动发布 */
+  memset(&event, 0, sizeof(event));
+  event.kind = GATE_EVENT_ENTRY;
+  event.slot_id = 2;
+  event.owner_name = "共享";
+  event.license_plate = "粤S00002";
+  event.contact = "13700000000";
+  event.type = RESIDENT_TYPE;
+  result = parking_service_apply_batch(lot, &event, 1, &code);
+  assert_int_equal(code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_shm_read_counters(reader, &counters), 0);
+  assert_int_equal(counters.occupied_slots, 1);
+  assert_int_equal(counters.occupied_resident_count, 1);
+  assert_int_equal(parking_shm_read_slot(reader, 2, &row), 0);
+  assert_int_equal(row.status, OCCUPIED_STATUS);
+  assert_int_equal(parking_shm_read_slot(reader, 9, &row), -3);
+
+  /* 单条写入之后要主动发布 */
+  result = parking_service_deallocate_slot(lot, 2);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_publish_shared_memory(lot);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_shm_read_rows(reader, rows, 4, &count), 0);
+  assert_int_equal(count, 2);
+  assert_int_equal(rows[0].status + rows[1].status, 0);
+
+  parking_shm_close(reader);
+  result = parking_service_configure_shared_memory(lot, NULL, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  remove(path);
+}
+
+/**
+ * @brief 测试 `parking_service_aggregate_statistics` 读取区域与公司的合计。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_aggregate_statistics(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingAggregate *tree = aggregate_create(NULL, "集团", 4);
+  ParkingStatistics stats;
+  ServiceResult result;
+  int site;
+
+  assert_non_null(tree);
+  site = aggregate_add_site(tree, aggregate_add_region(tree, "华南"), "一号");
+  parking_service_add_slot(lot, 1, "AG-1");
+  result = parking_service_attach_aggregate(lot, tree, AGGREGATE_ROOT);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_attach_aggregate(lot, tree, site);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 1, "区域", "粤A00001",
+                                         "13500000000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  assert_int_equal(parking_service_aggregate_statistics(tree, AGGREGATE_ROOT,
+                                                        time(NULL), &stats),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(stats.total_slots, lot->total_slots);
+  assert_int_equal(stats.occupied_slots, 1);
+  assert_int_equal(parking_service_aggregate_statistics(tree, 9, time(NULL),
+                                                        &stats),
+                   PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_attach_aggregate(lot, NULL, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  aggregate_free(tree);
+}
+
+/**
+ * @brief 测试 `parking_service_find_slot_at` 回溯车位在某一时刻的状态。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_find_slot_at(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  HistoricalSlot past;
+  ServiceResult result;
+  time_t now = parking_lot_now(lot);
+
+  parking_service_add_slot(lot, 1, "TL-1");
+  result = parking_service_find_slot_at(lot, 1, now, &past);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_timeline(
+      lot, TIMELINE_DEFAULT_SEGMENT_RECORDS, TIMELINE_DEFAULT_SEGMENTS);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 1, "审计", "湘A00001",
+                                         "13500000000", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  result = parking_service_find_slot_at(lot, 1, parking_lot_now(lot), &past);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_string_equal(past.license_plate, "湘A00001");
+  result = parking_service_find_slot_at(lot, 1, now - 3600, &past);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  result = parking_service_find_slot_at(lot, 2, parking_lot_now(lot), &past);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+}
+
+/**
+ * @brief 测试 `parking_service_allocate_returning_vehicle` 只凭车牌入场。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_returning_vehicle(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  VehicleSession session;
+  ServiceResult result;
+
+  parking_service_add_slot(lot, 1, "K-1");
+  parking_service_add_slot(lot, 2, "M-1");
+  result = parking_service_add_zone(lot, "M-");
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  result = parking_service_allocate_returning_vehicle(lot, "浙A00001");
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  result = parking_service_allocate_slot(lot, 2, "常客", "浙A00001",
+                                         "13700000001", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_deallocate_slot(lot, 2);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  parking_service_free_result(&result);
+
+  result = parking_service_find_vehicle_session(lot, "浙A00001", &session);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_string_equal(session.zone, "M-");
+  result = parking_service_allocate_returning_vehicle(lot, "浙A00001");
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(((ParkingSlot *)result.data)->slot_id, 2);
+  assert_string_equal(((ParkingSlot *)result.data)->contact, "13700000001");
+
+  result = parking_service_allocate_returning_vehicle(lot, "");
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_session_cache(lot, -1);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_session_cache(lot, 16);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_find_vehicle_session(lot, "浙A00001", &session);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+}
+
+/**
+ * @brief 测试 `parking_service_get_occupancy_forecast` 按上周同一时段预测。
+ * @details
+ * 周一上午分区在 10:15 与 10:30 各进两辆车、11:05 全部离场；一周后的
+ * 周一 10:00，30 分钟与 60 分钟的预测反映上周的变化，且不超过车位数。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_occupancy_forecast(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingForecast forecast;
+  ServiceResult result;
+  struct tm moment;
+  time_t start;
+  int i;
+
+  memset(&moment, 0, sizeof(moment));
+  moment.tm_year = 2026 - 1900;
+  moment.tm_mon = 9;
+  moment.tm_mday = 12; /* 周一 */
+  moment.tm_hour = 10;
+  moment.tm_isdst = -1;
+  start = mktime(&moment);
+
+  result = parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL, start);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  for (i = 1; i <= 4; i++) {
+    char location[16];
+
+    sprintf(location, "G1-%02d", i);
+    parking_service_add_slot(lot, i, location);
+  }
+  parking_service_add_slot(lot, 5, "H-01");
+  assert_int_equal(parking_service_add_zone(lot, "G1-").code,
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_run_timers(lot, NULL).code,
+                   PARKING_SERVICE_SUCCESS);
+
+  assert_int_equal(advance_parking_clock(lot, 900), 0);
+  parking_service_allocate_slot(lot, 1, "车主甲", "沪E00001", "13800000001",
+                                VISITOR_TYPE);
+  parking_service_allocate_slot(lot, 2, "车主乙", "沪E00002", "13800000002",
+                                VISITOR_TYPE);
+  assert_int_equal(advance_parking_clock(lot, 900), 0);
+  parking_service_allocate_slot(lot, 3, "车主丙", "沪E00003", "13800000003",
+                                VISITOR_TYPE);
+  parking_service_allocate_slot(lot, 4, "车主丁", "沪E00004", "13800000004",
+                                VISITOR_TYPE);
+  assert_int_equal(advance_parking_clock(lot, 35 * 60), 0);
+  for (i = 1; i <= 4; i++) {
+    result = parking_service_deallocate_slot(lot, i);
+    assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+    parking_service_free_result(&result);
+  }
+
+  /* 一周后的周一 10:00，没有出入场的时段由定时器推进计入画像 */
+  assert_int_equal(set_parking_clock(lot, start + 7 * 24 * 3600), 0);
+  assert_int_equal(parking_service_run_timers(lot, NULL).code,
+                   PARKING_SERVICE_SUCCESS);
+  result = parking_service_get_occupancy_forecast(lot, "G1-", &forecast);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(forecast.total_slots, 4);
+  assert_int_equal(forecast.occupied_slots, 0);
+  assert_int_equal(forecast.predicted_occupied[0], 0);
+  assert_int_equal(forecast.predicted_occupied[1], 2);
+  assert_int_equal(forecast.predicted_occupied[2], 4);
+  result = parking_service_get_occupancy_forecast(lot, NULL, &forecast);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(forecast.total_slots, 5);
+  assert_int_equal(forecast.predicted_occupied[2], 4);
+
+  parking_service_allocate_slot(lot, 1, "车主甲", "沪E00001", "13800000001",
+                                VISITOR_TYPE);
+  result = parking_service_get_occupancy_forecast(lot, "G1-", &forecast);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(forecast.predicted_occupied[1], 3);
+  assert_int_equal(forecast.predicted_occupied[2], 4);
+
+  result = parking_service_get_occupancy_forecast(lot, "G9-", &forecast);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_NOT_FOUND);
+  result = parking_service_get_occupancy_forecast(lot, "G1-", NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+}
+
+/**
+ * @brief 测试 `parking_service_save_data` 和 `parking_service_load_data`
+ * 的功能。
+ * @details
+ * 验证服务层的数据持久化功能。
+ * 1. 创建并填充一个停车场。
+ * 2. 调用保存服务将数据写入文件。
+ * 3. 调用加载服务从文件恢复数据到一个新实例。
+ * 4. 验证加载后的数据与保存前一致。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_data_persistence(void **state) {
+  const char *test_file = "service_persistence_test.txt";
+  ParkingLot *lot_to_save = init_parking_lot(5);
+  parking_service_add_slot(lot_to_save, 1, "P-1");
+  parking_service_allocate_slot(lot_to_save, 1, "SvcUser", "沪ASVC01",
+                                "12312341234", RESIDENT_TYPE);
+
+  /* 1. 测试保存 */
+  ServiceResult save_result = parking_service_save_data(lot_to_save, test_file);
+  assert_int_equal(save_result.code, PARKING_SERVICE_SUCCESS);
+
+  /* 2. 测试加载 */
+  ServiceResult load_result = parking_service_load_data(test_file);
+  assert_int_equal(load_result.code, PARKING_SERVICE_SUCCESS);
+  assert_non_null(load_result.data);
+  ParkingLot *loaded_lot = (ParkingLot *)load_result.data;
+
+  /* 3. 验证数据 */
+  assert_int_equal(loaded_lot->total_slots, 5);
+  assert_int_equal(loaded_lot->occupied_slots, 1);
+  ParkingSlot *loaded_slot = find_slot_by_id(loaded_lot, 1);
+  assert_non_null(loaded_slot);
+  assert_string_equal(loaded_slot->owner_name, "SvcUser");
+
+  /* 清理 */
+  free_parking_lot(lot_to_save);
+  free_parking_lot(loaded_lot);
+  remove(test_file);
+}
+
+/**
+ * @brief 测试 `parking_service_reload_data` 的影子加载与延迟回收。
+ * @details 钉住旧停车场的读者在替换后仍能访问它，解除钉住后才回收；
+ *          加载失败时当前停车场保持不变。
+ */
+static void test_service_reload_data(void **state) {
+  const char *test_file = "service_reload_test.txt";
+  ParkingLot *saved = init_parking_lot(7);
+  ParkingLot *old = init_parking_lot(3);
+  LotHub *hub = lot_hub_create(old);
+  ParkingLot *pinned;
+  ParkingLot *current;
+  ServiceResult result;
+  int reader;
+
+  (void)state;
+  assert_non_null(hub);
+  parking_service_add_slot(saved, 1, "R-1");
+  parking_service_add_slot(old, 9, "O-9");
+  result = parking_service_save_data(saved, test_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  free_parking_lot(saved);
+
+  reader = lot_hub_attach(hub);
+  assert_true(reader >= 0);
+  pinned = lot_hub_pin(hub, reader);
+  assert_ptr_equal(pinned, old);
+
+  /* 加载失败：当前停车场不变 */
+  result = parking_service_reload_data(hub, "service_reload_missing.txt");
+  assert_int_equal(result.code, PARKING_SERVICE_FILE_ERROR);
+  assert_ptr_equal(lot_hub_current(hub), old);
+  result = parking_service_reload_data(NULL, test_file);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  result = parking_service_reload_data(hub, test_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_null(result.data);
+  current = lot_hub_current(hub);
+  assert_ptr_not_equal(current, old);
+  assert_int_equal(current->total_slots, 7);
+  assert_non_null(find_slot_by_id(current, 1));
+
+  /* 读者仍钉住旧停车场，不能回收 */
+  assert_int_equal(lot_hub_reclaim(hub), 0);
+  assert_non_null(find_slot_by_id(pinned, 9));
+  lot_hub_unpin(hub, reader);
+  assert_int_equal(lot_hub_reclaim(hub), 1);
+  assert_ptr_equal(lot_hub_pin(hub, reader), current);
+  lot_hub_unpin(hub, reader);
+
+  lot_hub_detach(hub, reader);
+  lot_hub_free(hub);
+  remove(test_file);
+}
+
+/**
+ * @brief 读出整个文本文件，返回的缓冲区需由调用者释放。
+ */
+static char *read_whole_file(const char *path) {
+  FILE *file = fopen(path, "rb");
+  char *text;
+  long size;
+
+  assert_non_null(file);
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  text = (char *)malloc((size_t)size + 1);
+  assert_non_null(text);
+  assert_int_equal(fread(text, 1, (size_t)size, file), (size_t)size);
+  text[size] = '\0';
+  fclose(file);
+  return text;
+}
+
+/**
+ * @brief 测试 `parking_service_export_slots` 的 CSV 与 NDJSON 导出。
+ * @details
+ * 含逗号、引号的字段在 CSV 中加引号、引号写两次，在 NDJSON 中转义；
+ * 筛选条件生效，每个车位恰好一行。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_export_slots(void **state) {
+  const char *csv_file = "service_export_test.csv";
+  const char *json_file = "service_export_test.ndjson";
+  ParkingLot *lot = (ParkingLot *)*state;
+  ServiceResult result;
+  char *text;
+  char *p;
+  int lines;
+
+  parking_service_add_slot(lot, 1, "东区,1层");
+  parking_service_add_slot(lot, 2, "B-2");
+  parking_service_add_slot(lot, 3, "C-3");
+  result = parking_service_allocate_slot(lot, 2, "王\"小\"明", "沪A12345",
+                                         "13800000000", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  result = parking_service_export_slots(lot, csv_file, SLOT_FILTER_ALL,
+                                        SLOT_EXPORT_CSV);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_string_equal(result.message, "已导出 3 个车位");
+  text = read_whole_file(csv_file);
+  assert_true(strncmp(text,
+                      "slot_id,location,status,type,owner_name,"
+                      "license_plate,contact,entry_time,exit_time,"
+                      "resident_due_date\r\n",
+                      strlen("slot_id,location,status,type,owner_name,"
+                             "license_plate,contact,entry_time,exit_time,"
+                             "resident_due_date\r\n")) == 0);
+  assert_non_null(
+      strstr(text, "\r\n1,\"东区,1层\",free,resident,,,,0,0,0\r\n"));
+  assert_non_null(strstr(text, "\r\n2,B-2,occupied,visitor,\"王\"\"小\"\"明\","
+                               "沪A12345,13800000000,"));
+  for (lines = 0, p = text; (p = strstr(p, "\r\n")) != NULL; p += 2) {
+    lines++;
+  }
+  assert_int_equal(lines, 4);
+  free(text);
+
+  result = parking_service_export_slots(lot, json_file, SLOT_FILTER_OCCUPIED,
+                                        SLOT_EXPORT_NDJSON);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_string_equal(result.message, "已导出 1 个车位");
+  text = read_whole_file(json_file);
+  assert_true(strncmp(text,
+                      "{\"slot_id\":2,\"location\":\"B-2\",\"status\":"
+                      "\"occupied\",\"type\":\"visitor\",\"owner_name\":"
+                      "\"王\\\"小\\\"明\",\"license_plate\":\"沪A12345\",",
+                      strlen("{\"slot_id\":2,\"location\":\"B-2\",\"status\":"
+                             "\"occupied\",\"type\":\"visitor\","
+                             "\"owner_name\":\"王\\\"小\\\"明\","
+                             "\"license_plate\":\"沪A12345\",")) == 0);
+  assert_non_null(strstr(text, ",\"resident_due_date\":0}\n"));
+  p = strchr(text, '\n');
+  assert_non_null(p);
+  assert_int_equal(p[1], '\0');
+  free(text);
+
+  result = parking_service_export_slots(lot, "", SLOT_FILTER_ALL,
+                                        SLOT_EXPORT_CSV);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_export_slots(lot, csv_file, SLOT_FILTER_ALL,
+                                        (SlotExportFormat)7);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  remove(csv_file);
+  remove(json_file);
+}
+
+/**
+ * @brief 把文本整体写入文件。
+ */
+static void write_whole_file(const char *path, const char *text) {
+  FILE *file = fopen(path, "wb");
+
+  assert_non_null(file);
+  assert_int_equal(fwrite(text, 1, strlen(text), file), strlen(text));
+  fclose(file);
+}
+
+/**
+ * @brief 测试 `parking_service_import_slots` 的 CSV 导入。
+ * @details
+ * 验证表头、引号、"\r\n" 与末行无行尾均能解析；有误的行报告行号且
+ * 一个车位也不加入；编号重复时报告所在行；导出的 CSV 可以原样导入；
+ * 跨越多个读取块的大文件逐行无误。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_import_slots(void **state) {
+  const char *csv_file = "service_import_test.csv";
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingLot *copy;
+  ServiceResult result;
+  FILE *file;
+  int i;
+
+  write_whole_file(csv_file, "slot_id,location\r\n"
+                             "1,A-1\r\n"
+                             "\r\n"
+                             "\"2\",\"东区,\"\"南\"\"门\"\r\n"
+                             "3,C-3,ignored");
+  result = parking_service_import_slots(lot, csv_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_string_equal(result.message, "已导入 3 个车位");
+  assert_string_equal(find_slot_by_id(lot, 1)->location, "A-1");
+  assert_string_equal(find_slot_by_id(lot, 2)->location, "东区,\"南\"门");
+  assert_string_equal(find_slot_by_id(lot, 3)->location, "C-3");
+
+  /* 有误的行：整批拒绝并给出第一个错误的行号 */
+  write_whole_file(csv_file, "4,D-4\n"
+                             "x5,E-5\n"
+                             "6\n"
+                             "7,\"G-7\n");
+  result = parking_service_import_slots(lot, csv_file);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  assert_string_equal(result.message,
+                      "第 2 行车位编号无效，共 3 行有误，未导入任何车位");
+  assert_null(find_slot_by_id(lot, 4));
+
+  write_whole_file(csv_file, "8,H-8\n9,I-9\n8,H-8b\n");
+  result = parking_service_import_slots(lot, csv_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SLOT_EXISTS);
+  assert_non_null(strstr(result.message, "第 3 行"));
+  assert_null(find_slot_by_id(lot, 9));
+
+  result = parking_service_import_slots(lot, "no_such_import_file.csv");
+  assert_int_equal(result.code, PARKING_SERVICE_FILE_ERROR);
+
+  /* 导出的 CSV 原样导入另一个停车场 */
+  result = parking_service_export_slots(lot, csv_file, SLOT_FILTER_ALL,
+                                        SLOT_EXPORT_CSV);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  copy = init_parking_lot(10);
+  assert_non_null(copy);
+  result = parking_service_import_slots(copy, csv_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(copy->slot_count, 3);
+  assert_string_equal(find_slot_by_id(copy, 2)->location, "东区,\"南\"门");
+  free_parking_lot(copy);
+
+  /* 约 2.6 MB，跨越多个读取块 */
+  file = fopen(csv_file, "wb");
+  assert_non_null(file);
+  for (i = 1; i <= 90000; i++) {
+    fprintf(file, "%d,IMPORT-ZONE-%05d-LEVEL\n", i, i);
+  }
+  fclose(file);
+  copy = init_parking_lot(90000);
+  assert_non_null(copy);
+  result = parking_service_import_slots(copy, csv_file);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(copy->slot_count, 90000);
+  assert_string_equal(find_slot_by_id(copy, 45678)->location,
+                      "IMPORT-ZONE-45678-LEVEL");
+  assert_string_equal(find_slot_by_id(copy, 90000)->location,
+                      "IMPORT-ZONE-90000-LEVEL");
+  free_parking_lot(copy);
+
+  remove(csv_file);
+}
+
+#ifdef PARKING_DAEMON
+/**
+ * @brief (测试辅助函数) 执行一行请求并返回以 NUL 结尾的响应。
+ * @param lot 目标停车场。
+ * @param request 请求行。
+ * @param reply 接收响应的缓冲区（PARKING_DAEMON_MAX_REPLY + 1 字节）。
+ * @return reply。
+ */
+static const char *daemon_call(ParkingLot *lot, const char *request,
+                               char *reply) {
+  char line[PARKING_DAEMON_MAX_LINE + 1];
+  size_t length;
+
+  strcpy(line, request);
+  length = parking_daemon_execute(lot, line, reply);
+  reply[length] = '\0';
+  return reply;
+}
+
+/**
+ * @brief 测试网络服务的行协议。
+ * @details 验证每个命令映射到对应的快速服务接口、状态码与结果字段的格式，
+ *          以及未知命令、参数个数不符与缺少 id 时的响应。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_daemon_execute(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  char reply[PARKING_DAEMON_MAX_REPLY + 1];
+
+  assert_string_equal(daemon_call(lot, "1\tping", reply), "1\t0\n");
+  assert_string_equal(daemon_call(lot, "2\tadd_slot\t5\tD-5\r", reply),
+                      "2\t0\n");
+  assert_string_equal(daemon_call(lot, "3\tadd_slot\t5\tD-5", reply),
+                      "3\t-2\n");
+  assert_string_equal(daemon_call(lot,
+                                  "4\tallocate_any_slot\tTestUser\t粤B12345"
+                                  "\t13800138000\tresident",
+                                  reply),
+                      "4\t0\t5\n");
+  daemon_call(lot, "5\tfind_slot_by_license\t粤B12345", reply);
+  assert_memory_equal(reply,
+                      "5\t0\t5\tD-5\toccupied\tresident\tTestUser\t"
+                      "粤B12345\t13800138000\t",
+                      strlen("5\t0\t5\tD-5\toccupied\tresident\tTestUser\t"
+                             "粤B12345\t13800138000\t"));
+  assert_string_equal(daemon_call(lot, "6\tfind_slot_by_id\t6", reply),
+                      "6\t-3\n");
+  daemon_call(lot, "7\tget_statistics", reply);
+  assert_memory_equal(reply, "7\t0\t10\t1\t", 9);
+  daemon_call(lot, "8\tdeallocate_slot\t5", reply);
+  assert_memory_equal(reply, "8\t0\t", 4);
+  assert_string_equal(daemon_call(lot, "9\tdeallocate_slot\t5", reply),
+                      "9\t-5\n");
+
+  assert_string_equal(daemon_call(lot, "a\tbogus", reply), "a\t-1\n");
+  assert_string_equal(daemon_call(lot, "b\tadd_slot\t6", reply), "b\t-1\n");
+  assert_string_equal(daemon_call(lot, "c\tadd_slot\tx6\tD-6", reply),
+                      "c\t-1\n");
+  assert_string_equal(daemon_call(lot, "", reply), "-\t-1\n");
+  assert_string_equal(daemon_call(lot, "\tping", reply), "-\t0\n");
+  assert_null(find_slot_by_id(lot, 6));
+}
+
+/**
+ * @brief 测试网络服务按请求 id 去重。
+ * @details 以同一 id 重发的入场、出场与新增车位返回第一次的结果；
+ *          同一 id 换了请求内容时按新请求执行；去重表只记住最近的请求。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_daemon_idempotent(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  char reply[PARKING_DAEMON_MAX_REPLY + 1];
+  char first[PARKING_DAEMON_MAX_REPLY + 1];
+
+  assert_int_equal(parking_service_configure_request_log(lot, -1).code,
+                   PARKING_SERVICE_INVALID_PARAM);
+  assert_int_equal(parking_service_configure_request_log(lot, 3).code,
+                   PARKING_SERVICE_SUCCESS);
+  assert_string_equal(daemon_call(lot, "g1\tadd_slot\t5\tD-5", reply),
+                      "g1\t0\n");
+  assert_string_equal(daemon_call(lot, "g1\tadd_slot\t5\tD-5", reply),
+                      "g1\t0\n");
+  assert_string_equal(daemon_call(lot,
+                                  "g2\tallocate_any_slot\tTestUser\t粤B12345"
+                                  "\t13800138000\tresident",
+                                  reply),
+                      "g2\t0\t5\n");
+  assert_string_equal(daemon_call(lot,
+                                  "g2\tallocate_any_slot\tTestUser\t粤B12345"
+                                  "\t13800138000\tresident",
+                                  reply),
+                      "g2\t0\t5\n");
+  strcpy(first, daemon_call(lot, "g3\tdeallocate_slot\t5", reply));
+  assert_memory_equal(first, "g3\t0\t", 5);
+  assert_string_equal(daemon_call(lot, "g3\tdeallocate_slot\t5", reply),
+                      first);
+  assert_int_equal(lot->request_log->replays, 3);
+
+  /* 同一 id 换了内容：按新请求执行 */
+  assert_string_equal(daemon_call(lot, "g3\tadd_slot\t6\tD-6", reply),
+                      "g3\t0\n");
+  assert_non_null(find_slot_by_id(lot, 6));
+  /* 去重表容量为 3：g1 已被 g4 覆盖，重发时重新执行 */
+  assert_string_equal(daemon_call(lot, "g4\tadd_slot\t7\tD-7", reply),
+                      "g4\t0\n");
+  assert_string_equal(daemon_call(lot, "g1\tadd_slot\t5\tD-5", reply),
+                      "g1\t-2\n");
+  assert_string_equal(daemon_call(lot, "g5\tdeallocate_slot\t5", reply),
+                      "g5\t-5\n");
+  assert_string_equal(daemon_call(lot, "g5\tdeallocate_slot\t5", reply),
+                      "g5\t-5\n");
+  assert_int_equal(lot->request_log->replays, 4);
+}
+
+#ifndef _WIN32
+/**
+ * @brief 测试网络服务的流水线请求。
+ * @details 一次写入多个请求（最后一行跨两次写入），响应按请求顺序返回。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_daemon_pipeline(void **state) {
+  static const char expected[] = "1\t0\n"
+                                 "2\t0\n"
+                                 "3\t0\t2\tP-2\tfree\tresident\t\t\t\t0\n"
+                                 "4\t0\n";
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingDaemon *daemon = parking_daemon_start(lot, NULL, 0);
+  struct sockaddr_in address;
+  char received[256];
+  size_t used = 0;
+  int socket_fd;
+
+  assert_non_null(daemon);
+  socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+  assert_true(socket_fd >= 0);
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons((unsigned short)parking_daemon_port(daemon));
+  inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+  assert_int_equal(
+      connect(socket_fd, (struct sockaddr *)&address, sizeof(address)), 0);
+
+  const char *first = "1\tadd_slot\t1\tP-1\n"
+                      "2\tadd_slot\t2\tP-2\n"
+                      "3\tfind_slot_by_id\t2\n"
+                      "4\tpi";
+  assert_int_equal(send(socket_fd, first, strlen(first), 0),
+                   (int)strlen(first));
+  assert_int_equal(send(socket_fd, "ng\n", 3, 0), 3);
+  while (used < strlen(expected)) {
+    ssize_t got = recv(socket_fd, received + used, sizeof(received) - 1 - used,
+                       0);
+
+    assert_true(got > 0);
+    used += (size_t)got;
+  }
+  received[used] = '\0';
+  assert_string_equal(received, expected);
+  assert_int_equal(parking_daemon_clients(daemon), 1);
+
+  /* 关闭写方向后，已发出的请求仍全部得到回复，随后服务端关闭连接 */
+  const char *second = "5\tallocate_slot\t1\tTestUser\t粤B12345"
+                       "\t13800138000\tresident\n"
+                       "6\tfind_slot_by_license\t粤B12345\n";
+  assert_int_equal(send(socket_fd, second, strlen(second), 0),
+                   (int)strlen(second));
+  shutdown(socket_fd, SHUT_WR);
+  used = 0;
+  for (;;) {
+    ssize_t got = recv(socket_fd, received + used, sizeof(received) - 1 - used,
+                       0);
+
+    assert_true(got >= 0);
+    if (got == 0) {
+      break;
+    }
+    used += (size_t)got;
+  }
+  received[used] = '\0';
+  assert_non_null(strstr(received, "5\t0\n6\t0\t1\tP-1\toccupied\t"));
+
+  close(socket_fd);
+  parking_daemon_stop(daemon);
+  assert_int_equal(lot->slot_count, 2);
+  assert_null(parking_daemon_start(NULL, NULL, 0));
+}
+#endif
+#endif
+
+#if defined(PARKING_CLUSTER) && !defined(_WIN32)
+/**
+ * @brief 测试一致性哈希环的站点分布。
+ * @details 三个节点各自分到相当数量的站点；加入第四个节点时只有站点从
+ *          旧节点移到新节点，没有站点在旧节点之间换主；移除后恢复原状，
+ *          离开中的节点不再拥有站点。
+ * @param state cmocka 框架的测试状态指针（未使用）。
+ */
+static void test_service_cluster_ring(void **state) {
+  static char owners[300][CLUSTER_MAX_NODE_NAME + 1];
+  ClusterRing *ring = cluster_ring_create();
+  char site_id[32];
+  int counts[3] = {0, 0, 0};
+  int moved = 0;
+  int i;
+
+  (void)state;
+  assert_non_null(ring);
+  assert_null(cluster_ring_owner(ring, "lot-0"));
+  assert_int_equal(cluster_ring_add_node(ring, "node-a", NULL, 7001, 0), 0);
+  assert_int_equal(cluster_ring_add_node(ring, "node-b", NULL, 7002, 0), 0);
+  assert_int_equal(cluster_ring_add_node(ring, "node-c", NULL, 7003, 0), 0);
+  assert_int_equal(cluster_ring_add_node(ring, "node-a", NULL, 7004, 0), -1);
+  assert_int_equal(cluster_ring_add_node(ring, "node-x", NULL, 0, 0), -1);
+  assert_int_equal(cluster_ring_add_node(ring, "", NULL, 7005, 0), -1);
+  assert_null(cluster_ring_find(ring, "node-x"));
+  assert_string_equal(cluster_ring_find(ring, "node-b")->host, "127.0.0.1");
+  assert_int_equal(ring->point_count, 3 * CLUSTER_DEFAULT_VNODES);
+
+  for (i = 0; i < 300; i++) {
+    sprintf(site_id, "lot-%d", i);
+    strcpy(owners[i], cluster_ring_owner(ring, site_id)->name);
+    counts[owners[i][5] - 'a']++;
+  }
+  for (i = 0; i < 3; i++) {
+    assert_true(counts[i] > 50);
+  }
+
+  assert_int_equal(cluster_ring_add_node(ring, "node-d", NULL, 7004, 0), 0);
+  for (i = 0; i < 300; i++) {
+    const char *owner;
+
+    sprintf(site_id, "lot-%d", i);
+    owner = cluster_ring_owner(ring, site_id)->name;
+    if (strcmp(owner, owners[i]) != 0) {
+      assert_string_equal(owner, "node-d");
+      moved++;
+    }
+  }
+  assert_true(moved > 30 && moved < 150);
+
+  assert_int_equal(cluster_ring_remove_node(ring, "node-d"), 0);
+  assert_int_equal(cluster_ring_remove_node(ring, "node-d"), -1);
+  assert_int_equal(cluster_ring_drain_node(ring, "node-a"), 0);
+  for (i = 0; i < 300; i++) {
+    const char *owner;
+
+    sprintf(site_id, "lot-%d", i);
+    owner = cluster_ring_owner(ring, site_id)->name;
+    assert_string_not_equal(owner, "node-a");
+    if (strcmp(owners[i], "node-a") != 0) {
+      assert_string_equal(owner, owners[i]);
+    }
+  }
+  cluster_ring_free(ring);
+}
+
+/**
+ * @brief (静态辅助函数) 删除目录中某个站点的快照与索引映像。
+ * @param registry 该目录的注册表。
+ * @param site_id 站点编号。
+ */
+static void remove_cluster_site(ParkingRegistry *registry,
+                                const char *site_id) {
+  char path[PARKING_REGISTRY_MAX_PATH + 8];
+
+  assert_int_equal(parking_registry_site_path(registry, site_id, path), 0);
+  remove(path);
+  strcat(path, INDEX_IMAGE_SUFFIX);
+  remove(path);
+}
+
+/**
+ * @brief 测试集群客户端路由与加入节点后的重新均衡。
+ * @details
+ * 两个节点各用一个目录托管站点。先只有 node-a，经客户端打开站点并停入
+ * 车辆；node-b 加入后重新均衡，新主节点为 node-b 的站点连同车辆一起迁到
+ * node-b 的目录，客户端按新的环仍能访问全部站点；节点停止后返回
+ * PARKING_SERVICE_BUSY。
+ * @param state cmocka 框架的测试状态指针（未使用）。
+ */
+static void test_service_cluster_rebalance(void **state) {
+  ClusterRebalanceSummary summary;
+  ParkingRegistry *registry_a;
+  ParkingRegistry *registry_b;
+  ParkingDaemon *daemon_a;
+  ParkingDaemon *daemon_b;
+  ParkingStatistics stats;
+  ClusterClient *client;
+  ClusterRing *ring;
+  char site_id[32];
+  char moved_site[32];
+  char plate[32];
+  int slots[12];
+  long amount;
+  int expected = 0;
+  int i;
+
+  (void)state;
+  mkdir("cluster-a", 0755);
+  mkdir("cluster-b", 0755);
+  registry_a = parking_registry_create("cluster-a", NULL, 0, 0);
+  registry_b = parking_registry_create("cluster-b", NULL, 0, 0);
+  assert_non_null(registry_a);
+  assert_non_null(registry_b);
+  for (i = 0; i < 12; i++) {
+    sprintf(site_id, "site-%d", i);
+    remove_cluster_site(registry_a, site_id);
+    remove_cluster_site(registry_b, site_id);
+  }
+  daemon_a = parking_daemon_start_registry(registry_a, NULL, 0);
+  daemon_b = parking_daemon_start_registry(registry_b, NULL, 0);
+  assert_non_null(daemon_a);
+  assert_non_null(daemon_b);
+  assert_null(parking_daemon_start_registry(NULL, NULL, 0));
+
+  ring = cluster_ring_create();
+  assert_int_equal(cluster_ring_add_node(ring, "node-a", NULL,
+                                         parking_daemon_port(daemon_a), 0),
+                   0);
+  assert_int_equal(cluster_ring_bind_registry(ring, "node-a", registry_a), 0);
+  client = cluster_client_create(ring);
+  assert_non_null(client);
+
+  for (i = 0; i < 12; i++) {
+    sprintf(site_id, "site-%d", i);
+    sprintf(plate, "粤C%05d", i);
+    assert_int_equal(cluster_client_open_site(client, site_id, 4),
+                     PARKING_SERVICE_SUCCESS);
+    assert_int_equal(cluster_client_add_slot(client, site_id, 1, "K-1"),
+                     PARKING_SERVICE_SUCCESS);
+    assert_int_equal(cluster_client_add_slot(client, site_id, 2, "K-2"),
+                     PARKING_SERVICE_SUCCESS);
+    assert_int_equal(cluster_client_allocate_any_slot(client, site_id, "丁",
+                                                      plate, "13700000004",
+                                                      RESIDENT_TYPE, &slots[i]),
+                     PARKING_SERVICE_SUCCESS);
+    assert_true(slots[i] == 1 || slots[i] == 2);
+  }
+  assert_int_equal(cluster_client_get_statistics(client, "site-99", &stats),
+                   PARKING_SERVICE_SLOT_NOT_FOUND);
+  assert_int_equal(cluster_client_add_slot(client, "site-0", 3, "K\t3"),
+                   PARKING_SERVICE_INVALID_PARAM);
+
+  /* node-b 加入后，主节点变为 node-b 的站点迁到 registry_b */
+  assert_int_equal(cluster_ring_add_node(ring, "node-b", NULL,
+                                         parking_daemon_port(daemon_b), 0),
+                   0);
+  assert_int_equal(cluster_ring_bind_registry(ring, "node-b", registry_b), 0);
+  for (i = 0; i < 12; i++) {
+    sprintf(site_id, "site-%d", i);
+    if (strcmp(cluster_ring_owner(ring, site_id)->name, "node-b") == 0) {
+      strcpy(moved_site, site_id);
+      expected++;
+    }
+  }
+  assert_true(expected > 0 && expected < 12);
+  assert_int_equal(cluster_rebalance(ring, &summary), 0);
+  assert_int_equal(summary.checked, 12);
+  assert_int_equal(summary.moved, expected);
+  assert_int_equal(summary.stranded, 0);
+  assert_int_equal(summary.failed, 0);
+  assert_int_equal(cluster_rebalance(ring, &summary), 0);
+  assert_int_equal(summary.moved, 0);
+
+  for (i = 0; i < 12; i++) {
+    int on_b;
+
+    sprintf(site_id, "site-%d", i);
+    on_b = strcmp(cluster_ring_owner(ring, site_id)->name, "node-b") == 0;
+    assert_true((parking_registry_get(registry_b, site_id) != NULL) == on_b);
+    assert_true((parking_registry_get(registry_a, site_id) != NULL) == !on_b);
+    assert_int_equal(cluster_client_get_statistics(client, site_id, &stats),
+                     PARKING_SERVICE_SUCCESS);
+    assert_int_equal(stats.total_slots, 4);
+    assert_int_equal(stats.occupied_slots, 1);
+    assert_int_equal(stats.free_slots, 3);
+    assert_double_equal(stats.occupancy_rate, 25.0, 0.001);
+    assert_int_equal(
+        cluster_client_deallocate_slot(client, site_id, slots[i], &amount),
+        PARKING_SERVICE_SUCCESS);
+    assert_true(amount >= 0);
+  }
+
+  parking_daemon_stop(daemon_b);
+  assert_int_equal(cluster_client_get_statistics(client, moved_site, &stats),
+                   PARKING_SERVICE_BUSY);
+  cluster_client_free(client);
+  cluster_ring_free(ring);
+  parking_daemon_stop(daemon_a);
+  assert_int_equal(parking_registry_destroy(registry_a), 0);
+  assert_int_equal(parking_registry_destroy(registry_b), 0);
+  registry_a = parking_registry_create("cluster-a", NULL, 0, 0);
+  registry_b = parking_registry_create("cluster-b", NULL, 0, 0);
+  for (i = 0; i < 12; i++) {
+    sprintf(site_id, "site-%d", i);
+    remove_cluster_site(registry_a, site_id);
+    remove_cluster_site(registry_b, site_id);
+  }
+  parking_registry_destroy(registry_a);
+  parking_registry_destroy(registry_b);
+  rmdir("cluster-a");
+  rmdir("cluster-b");
+}
+#endif
+
+#ifdef PARKING_REPLICATION
+/**
+ * @brief 测试主备增量复制。
+ * @details
+ * 验证备节点首次连接时以快照取得已有数据，之后的入场、出场与新增车位
+ * 只以日志记录推送；后加入的备节点同样先收到快照；
+ * 升级后的备节点可以像普通停车场一样继续写入。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_replication(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingReplicator *replicator;
+  ParkingFollower *follower;
+  ParkingFollower *late;
+  ParkingLot *replica;
+  ReplicatorStatus primary;
+  FollowerStatus status;
+  ServiceResult result;
+  ExitReceipt receipt;
+
+  assert_int_equal(parking_service_add_slot(lot, 1, "R-1").code,
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_add_slot(lot, 2, "R-2").code,
+                   PARKING_SERVICE_SUCCESS);
+  replicator = parking_replicator_start(lot, NULL, 0);
+  assert_non_null(replicator);
+  assert_true(parking_replicator_port(replicator) > 0);
+  result = parking_service_allocate_slot(lot, 1, "TestUser", "粤B12345",
+                                         "13800138000", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  follower = parking_follower_start(NULL, parking_replicator_port(replicator));
+  assert_non_null(follower);
+  assert_int_equal(parking_replicator_status(replicator, &primary), 0);
+  assert_int_equal(primary.head_seq, 1);
+  assert_int_equal(parking_follower_wait(follower, primary.head_seq, 5000), 1);
+  replica = parking_follower_acquire(follower);
+  assert_non_null(replica);
+  assert_int_equal(replica->slot_count, 2);
+  assert_int_equal(replica->occupied_slots, 1);
+  assert_int_equal(find_slot_by_license(replica, "粤B12345")->slot_id, 1);
+  parking_follower_release(follower, replica);
+
+  /* 之后的修改只推送日志记录 */
+  result = parking_service_checkout_slot(lot, 1, &receipt);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 2, "TestUser", "粤B54321",
+                                         "13800138000", VISITOR_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_service_add_slot(lot, 3, "R-3").code,
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_replicator_status(replicator, &primary), 0);
+  assert_int_equal(parking_follower_wait(follower, primary.head_seq, 5000), 1);
+  replica = parking_follower_acquire(follower);
+  assert_non_null(replica);
+  assert_int_equal(replica->slot_count, 3);
+  assert_int_equal(replica->occupied_slots, 1);
+  assert_null(find_slot_by_license(replica, "粤B12345"));
+  assert_int_equal(find_slot_by_license(replica, "粤B54321")->slot_id, 2);
+  assert_string_equal(find_slot_by_id(replica, 3)->location, "R-3");
+  parking_follower_release(follower, replica);
+  assert_int_equal(parking_follower_status(follower, &status), 0);
+  assert_true(status.connected);
+  assert_int_equal(status.applied_seq, primary.head_seq);
+  assert_int_equal(status.snapshots_loaded, 1);
+
+  /* 后加入的备节点同样先收到快照 */
+  late = parking_follower_start(NULL, parking_replicator_port(replicator));
+  assert_non_null(late);
+  assert_int_equal(parking_follower_wait(late, primary.head_seq, 5000), 1);
+  assert_int_equal(parking_replicator_status(replicator, &primary), 0);
+  assert_int_equal(primary.snapshots_sent, 2);
+  parking_follower_stop(late);
+
+  /* 升级后的备节点可以继续写入 */
+  replica = parking_follower_promote(follower);
+  assert_non_null(replica);
+  assert_int_equal(parking_service_add_slot(replica, 4, "R-4").code,
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(replica->slot_count, 4);
+  free_parking_lot(replica);
+  parking_replicator_stop(replicator);
+
+  assert_null(parking_replicator_start(NULL, NULL, 0));
+  assert_null(parking_follower_start(NULL, 0));
+  assert_null(parking_follower_acquire(NULL));
+}
+#endif
+
+/**
+ * @brief 后台保存测试的通知上下文。
+ */
+typedef struct {
+  ParkingSignal *signal; /**< 保存完成时触发。 */
+  int code;              /**< 保存结果的状态码。 */
+} AsyncSaveProbe;
+
+/**
+ * @brief 记录后台保存结果并唤醒测试线程。
+ */
+static void on_async_saved(const char *filename, ServiceResult result,
+                           void *ctx) {
+  AsyncSaveProbe *probe = (AsyncSaveProbe *)ctx;
+  (void)filename;
+  probe->code = result.code;
+  parking_signal_notify(probe->signal);
+}
+
+/**
+ * @brief 测试后台保存与自动保存。
+ * @details
+ * 提交异步保存后继续入场，完成通知到达后文件内容是提交时的停车场；
+ * 按修改次数配置自动保存后，达到次数即在后台写出快照。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_async_save(void **state) {
+  const char *test_file = "service_async_test.txt";
+  const char *auto_file = "service_autosave_test.bin";
+  ParkingLot *lot = (ParkingLot *)*state;
+  AsyncSaveProbe probe;
+  ServiceResult result;
+  ParkingLot *loaded_lot;
+  FILE *file = NULL;
+  int i;
+
+  probe.signal = parking_signal_create();
+  probe.code = PARKING_SERVICE_SYSTEM_ERROR;
+  assert_non_null(probe.signal);
+  assert_int_equal(parking_signal_wait(probe.signal, 1), 0);
+
+  for (i = 1; i <= 4; i++) {
+    parking_service_add_slot(lot, i, "ASYNC");
+  }
+  result = parking_service_save_data_async(lot, test_file, on_async_saved,
+                                           &probe);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  assert_int_equal(parking_signal_wait(probe.signal, 10000), 1);
+  assert_int_equal(probe.code, PARKING_SERVICE_SUCCESS);
+  loaded_lot = load_parking_data(test_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->slot_count, 4);
+  free_parking_lot(loaded_lot);
+
+  result = parking_service_save_data_async(lot, "", NULL, NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_configure_autosave(lot, auto_file, 0, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+
+  /* 3 次修改后自动写出快照 */
+  remove(auto_file);
+  result = parking_service_configure_autosave(lot, auto_file, 0, 3);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 1, "甲", "沪A00001",
+                                         "13800000001", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 2, "乙", "沪A00002",
+                                         "13800000002", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  result = parking_service_allocate_slot(lot, 3, "丙", "沪A00003",
+                                         "13800000003", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  for (i = 0; i < 100 && file == NULL; i++) {
+    parking_signal_wait(probe.signal, 50);
+    file = fopen(auto_file, "rb");
+  }
+  assert_non_null(file);
+  fclose(file);
+  result = parking_service_configure_autosave(lot, NULL, 0, 0);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+
+  /* 停止保存线程，确保自动保存已写完再检查内容 */
+  parking_saver_stop(lot->saver);
+  lot->saver = NULL;
+  loaded_lot = load_parking_data(auto_file);
+  assert_non_null(loaded_lot);
+  assert_int_equal(loaded_lot->occupied_slots, 3);
+  free_parking_lot(loaded_lot);
+
+  parking_signal_destroy(probe.signal);
+  remove(test_file);
+  remove(auto_file);
+}
+
+/**
+ * @brief 测试后台整理车位内存池。
+ * @details 大批删除车位后请求整理，保存线程分步释放稀疏区块，
+ *          留下的车位仍可按编号查到并正常入场。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_compact_slots(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  ParkingSignal *signal = parking_signal_create();
+  ServiceResult result;
+  long freed = 0;
+  int i;
+
+  assert_non_null(signal);
+  for (i = 1; i <= 600; i++) {
+    parking_service_add_slot(lot, i, "COMPACT");
+  }
+  for (i = 1; i <= 600; i++) {
+    if (i % 30 != 0) {
+      assert_int_equal(delete_slot(lot, i), 0);
+    }
+  }
+
+  result = parking_service_compact_slots(NULL);
+  assert_int_equal(result.code, PARKING_SERVICE_INVALID_PARAM);
+  result = parking_service_compact_slots(lot);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  for (i = 0; i < 200 && freed == 0; i++) {
+    parking_signal_wait(signal, 50);
+    parking_lot_read_lock(lot);
+    if (lot->compaction.phase == SLOT_COMPACT_IDLE) {
+      freed = lot->compaction.freed_chunks;
+    }
+    parking_lot_read_unlock(lot);
+  }
+  assert_true(freed > 0);
+
+  result = parking_service_allocate_slot(lot, 300, "丁", "沪A00300",
+                                         "13800000300", RESIDENT_TYPE);
+  assert_int_equal(result.code, PARKING_SERVICE_SUCCESS);
+  for (i = 30; i <= 600; i += 30) {
+    assert_non_null(find_slot_by_id(lot, i));
+  }
+  parking_signal_destroy(signal);
+}
+
+/* ========================================================================== */
+/*                                 主测试函数                                 */
+/* ========================================================================== */
+
+/**
+ * @brief (测试辅助函数) 任务池测试中的一个任务：做 arg 指定次数的累加。
+ */
+static void sum_task(void *arg) {
+  long *cell = (long *)arg;
+  long rounds = *cell;
+  long total = 0;
+  long i;
+
+  for (i = 1; i <= rounds; i++) {
+    total += i;
+  }
+  *cell = total;
+}
+
+/**
+ * @brief 测试工作窃取任务池与跨站点的连锁报表。
+ * @details 任务池部分验证耗时悬殊的任务全部执行且结果正确；
+ *          报表部分验证合计统计、按站点编号排序的分站点统计、
+ *          跨站点合并的停车时长排行，以及不用任务池时结果相同。
+ * @param state cmocka 框架的测试状态指针。
+ */
+static void test_service_chain_report(void **state) {
+  const char *sites[] = {"chain-b", "chain-a", "chain-c"};
+  const int capacity[] = {3, 5, 4};
+  const time_t start = 1700000000;
+  ParkingTaskPoolStats pool_stats;
+  ParkingChainReport report;
+  ParkingChainReport serial;
+  ParkingTaskGroup group;
+  ParkingTaskPool *pool;
+  ParkingRegistry *registry;
+  ParkingLot *lot;
+  long cells[200];
+  char path[64];
+  int i;
+
+  (void)state; /* not used */
+  pool = parking_task_pool_create(3);
+  assert_non_null(pool);
+  parking_task_group_init(&group);
+  for (i = 0; i < 200; i++) {
+    cells[i] = i % 20 == 0 ? 200000 : i;
+    assert_true(parking_task_pool_submit(pool, &group, sum_task, &cells[i]) >=
+                0);
+  }
+  parking_task_group_wait(pool, &group);
+  for (i = 0; i < 200; i++) {
+    long n = i % 20 == 0 ? 200000 : i;
+
+    assert_true(cells[i] == n * (n + 1) / 2);
+  }
+  parking_task_pool_stats(pool, &pool_stats);
+  assert_int_equal(pool_stats.workers, 3);
+  assert_int_equal(pool_stats.executed, 200);
+  assert_int_equal(parking_task_pool_submit(pool, NULL, sum_task, cells), -1);
+
+  /* chain-a 的 1 号车最早入场，其次是 chain-b 的 1 号车和 chain-a 的 2 号车 */
+  registry = parking_registry_create(".", NULL, 0, 0);
+  assert_non_null(registry);
+  for (i = 0; i < 3; i++) {
+    sprintf(path, "./%s%s", sites[i], PARKING_REGISTRY_SUFFIX);
+    remove(path);
+    lot = parking_registry_open(registry, sites[i], capacity[i]);
+    assert_non_null(lot);
+    parking_service_configure_clock(lot, PARKING_CLOCK_VIRTUAL, start);
+    parking_service_add_slot(lot, 1, "C-1");
+    parking_service_add_slot(lot, 2, "C-2");
+  }
+  lot = parking_registry_get(registry, "chain-a");
+  assert_int_equal(parking_service_fast_allocate_slot(lot, 1, "甲", "粤A00001",
+                                                      "13700000001",
+                                                      RESIDENT_TYPE),
+                   PARKING_SERVICE_SUCCESS);
+  set_parking_clock(lot, start + 100);
+  assert_int_equal(parking_service_fast_allocate_slot(lot, 2, "乙", "粤A00002",
+                                                      "13700000002",
+                                                      RESIDENT_TYPE),
+                   PARKING_SERVICE_SUCCESS);
+  lot = parking_registry_get(registry, "chain-b");
+  set_parking_clock(lot, start + 50);
+  assert_int_equal(parking_service_fast_allocate_slot(lot, 1, "丙", "粤B00001",
+                                                      "13700000003",
+                                                      RESIDENT_TYPE),
+                   PARKING_SERVICE_SUCCESS);
+  for (i = 0; i < 3; i++) {
+    set_parking_clock(parking_registry_get(registry, sites[i]), start + 1000);
+  }
+
+  assert_int_equal(parking_registry_report(registry, pool, &report), 0);
+  assert_int_equal(report.site_count, 3);
+  assert_int_equal(report.totals.total_slots, 12);
+  assert_int_equal(report.totals.occupied_slots, 3);
+  assert_int_equal(report.totals.free_slots, 9);
+  assert_double_equal(report.totals.occupancy_rate, 25.0, 0.001);
+  assert_string_equal(report.sites[0].site_id, "chain-a");
+  assert_int_equal(report.sites[0].stats.occupied_slots, 2);
+  assert_string_equal(report.sites[1].site_id, "chain-b");
+  assert_string_equal(report.sites[2].site_id, "chain-c");
+  assert_int_equal(report.sites[2].stats.occupied_slots, 0);
+  assert_int_equal(report.longest_count, 3);
+  assert_string_equal(report.longest[0].site_id, "chain-a");
+  assert_string_equal(report.longest[0].license_plate, "粤A00001");
+  assert_int_equal(report.longest[0].duration_seconds, 1000);
+  assert_string_equal(report.longest[1].site_id, "chain-b");
+  assert_int_equal(report.longest[1].duration_seconds, 950);
+  assert_int_equal(report.longest[2].slot_id, 2);
+  assert_int_equal(report.longest[2].duration_seconds, 900);
+
+  assert_int_equal(parking_registry_report(registry, NULL, &serial), 0);
+  assert_int_equal(serial.totals.occupied_slots, report.totals.occupied_slots);
+  assert_int_equal(serial.longest_count, report.longest_count);
+  assert_memory_equal(serial.longest, report.longest,
+                      sizeof(ParkingChainVehicle) * 3);
+  free(serial.sites);
+  free(report.sites);
+
+  assert_int_equal(parking_registry_destroy(registry), 0);
+  parking_task_pool_destroy(pool);
+  for (i = 0; i < 3; i++) {
+    sprintf(path, "./%s%s", sites[i], PARKING_REGISTRY_SUFFIX);
+    remove(path);
+  }
+}
+
+/**
+ * @brief 测试程序的主入口。
+ * @details
+ * 注册所有服务层的单元测试用例，并使用 cmocka 框架统一运行它们。
+ * 每个测试组使用 setup 和 teardown 函数来管理测试环境的生命周期。
+ * @return 返回 cmocka 测试组的执行结果。
+ */
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test_setup_teardown(test_service_add_slot, setup, teardown),
+      cmocka_unit_test_setup_teardown(test_service_add_slots_bulk, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_allocate_and_deallocate_slot,
+                                      setup, teardown),
+      cmocka_unit_test_setup_teardown(test_service_allocate_any_slot, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_concurrent_gates, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_ingest_queue, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_apply_batch, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_clock, setup, teardown),
+      cmocka_unit_test_setup_teardown(test_service_fast_api, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_metrics, setup, teardown),
+      cmocka_unit_test_setup_teardown(test_service_trace, setup, teardown),
+      cmocka_unit_test_setup_teardown(test_service_memory_stats, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_slot_pages, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_query_slots, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_reservations, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_slot_pools, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_nearest_free_slot, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_zone_stats, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_change_feed, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_result_pool, setup,
+                                      teardown),
+#ifdef PARKING_EXPORTER
+      cmocka_unit_test_setup_teardown(test_service_exporter_render, setup,
+                                      teardown),
+#endif
+      cmocka_unit_test_setup_teardown(test_service_longest_parked, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_search_slots, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_get_statistics, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_resident_billing, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_sweep_visitors, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_revenue_report, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_occupancy_forecast, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_plate_lists, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_returning_vehicle, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_async_operations, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_async_admission, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_read_view, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_find_slot_at, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_aggregate_statistics, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_quote_exit, setup, teardown),
+      cmocka_unit_test_setup_teardown(test_service_anpr_pipeline, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_shared_memory, setup,
+                                      teardown),
+      cmocka_unit_test(test_service_data_persistence),
+      cmocka_unit_test(test_service_reload_data),
+      cmocka_unit_test_setup_teardown(test_service_async_save, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_compact_slots, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_export_slots, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_import_slots, setup,
+                                      teardown),
+#ifdef PARKING_REPLICATION
+      cmocka_unit_test_setup_teardown(test_service_replication, setup,
+                                      teardown),
+#endif
+#ifdef PARKING_DAEMON
+      cmocka_unit_test_setup_teardown(test_service_daemon_execute, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_service_daemon_idempotent, setup,
+                                      teardown),
+#ifndef _WIN32
+      cmocka_unit_test_setup_teardown(test_service_daemon_pipeline, setup,
+                                      teardown),
+#endif
+#endif
+#if defined(PARKING_CLUSTER) && !defined(_WIN32)
+      cmocka_unit_test(test_service_cluster_ring),
+      cmocka_unit_test(test_service_cluster_rebalance),
+#endif
+      cmocka_unit_test(test_service_zone_lots),
+      cmocka_unit_test(test_service_zone_policies),
+      cmocka_unit_test(test_service_chain_report),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);
@@ -11,7 +11,10 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
+#include "../src/parking_cli.h"
 #include "../src/parking_service.h"
 #include "../src/parking_ui.h"
 #include "cmocka.h"
@@ -99,6 +102,163 @@ static void test_ui_add_slot_logic(void **state) {
   assert_string_equal(found->location, "Test-Location");
 }
 
+/**
+ * @brief 测试车位列表的文本缓冲区。
+ * @details
+ * 缓冲区中的车位文本应与 `ui_show_slot_status` 的格式一致：空闲车位一行，
+ * 占用车位另有车主与类型两行；写出后缓冲区清空但保留已分配的内存。
+ * @param state 包含由 `setup` 函数初始化的停车场对象的指针。
+ */
+static void test_ui_buffer_slot_text(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  UiTextBuffer buffer;
+
+  assert_true(parking_service_is_success(
+      parking_service_add_slot(lot, 1, "A-01")));
+  assert_true(parking_service_is_success(
+      parking_service_add_slot(lot, 2, "A-02")));
+  assert_true(parking_service_is_success(parking_service_allocate_slot(
+      lot, 2, "Zhang", "JING-A123", "13800000000", RESIDENT_TYPE)));
+
+  ui_buffer_init(&buffer);
+  assert_int_equal(ui_buffer_append_slot(&buffer, find_slot_by_id(lot, 1)), 0);
+  assert_int_equal(ui_buffer_append(&buffer, "--\n"), 0);
+  assert_int_equal(ui_buffer_append_slot(&buffer, find_slot_by_id(lot, 2)), 0);
+  assert_int_equal(ui_buffer_append(&buffer, ""), 0);
+
+  const char *free_line = "车位编号: 1     | 位置: A-01                 | "
+                          "状态: 空闲\n--\n";
+  assert_true(buffer.length > strlen(free_line));
+  assert_memory_equal(buffer.data, free_line, strlen(free_line));
+
+  const char *owner_line =
+      "  -> 车主: Zhang, 车牌: JING-A123, 联系方式: 13800000000\n"
+      "  -> 类型: 居民, 入场时间: ";
+  const char *rest = buffer.data + strlen(free_line);
+  size_t rest_length = buffer.length - strlen(free_line);
+  const char *second = memchr(rest, '\n', rest_length);
+  assert_non_null(second);
+  assert_memory_equal(second + 1, owner_line, strlen(owner_line));
+  assert_int_equal(buffer.data[buffer.length - 1], '\n');
+
+  size_t capacity = buffer.capacity;
+  ui_buffer_flush(&buffer, stdout);
+  assert_int_equal(buffer.length, 0);
+  assert_int_equal(buffer.capacity, capacity);
+  ui_buffer_free(&buffer);
+  assert_null(buffer.data);
+}
+
+/**
+ * @brief 测试实时看板只重绘变化的行。
+ * @details
+ * 首次完整绘制输出全部行，数据不变时增量绘制不输出任何内容；
+ * 一次入场后，经变化事件刷新的看板只重写统计、分区和入场记录所在的行。
+ * @param state 包含由 `setup` 函数初始化的停车场对象的指针。
+ */
+static void test_ui_dashboard_redraw(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  struct ChangeSubscription *subscription = NULL;
+  ParkingChange changes[8];
+  UiDashboard board;
+  UiTextBuffer buffer;
+  int count = 0;
+
+  assert_true(parking_service_is_success(
+      parking_service_add_slot(lot, 1, "A-01")));
+  assert_true(parking_service_is_success(
+      parking_service_add_slot(lot, 2, "B-01")));
+  assert_true(parking_service_is_success(parking_service_add_zone(lot, "A-")));
+  assert_true(parking_service_is_success(
+      parking_service_subscribe_changes(lot, 0, &subscription)));
+
+  ui_dashboard_init(&board);
+  ui_buffer_init(&buffer);
+  assert_int_equal(ui_dashboard_reload(&board, lot), 0);
+  assert_int_equal(ui_dashboard_render(&board, &buffer, 1), UI_DASHBOARD_ROWS);
+  buffer.length = 0;
+  assert_int_equal(ui_dashboard_render(&board, &buffer, 0), 0);
+  assert_int_equal(buffer.length, 0);
+
+  assert_true(parking_service_is_success(parking_service_allocate_slot(
+      lot, 1, "Li", "JING-B456", "13900000000", RESIDENT_TYPE)));
+  assert_true(parking_service_is_success(parking_service_poll_changes(
+      subscription, changes, 8, &count, NULL)));
+  assert_int_equal(count, 1);
+  ui_dashboard_apply(&board, changes, count);
+  assert_int_equal(board.recent_count, 1);
+  assert_int_equal(board.recent[0].slot_id, 1);
+  assert_int_equal(ui_dashboard_reload(&board, lot), 0);
+  assert_int_equal(board.stats.occupied_slots, 1);
+  assert_int_equal(board.zones[0].occupied_slots, 1);
+
+  /* 统计行、分区行与第一条入场记录。 */
+  assert_int_equal(ui_dashboard_render(&board, &buffer, 0), 3);
+  assert_int_equal(buffer.data[0], '\033');
+  buffer.length = 0;
+  assert_int_equal(ui_dashboard_render(&board, &buffer, 0), 0);
+
+  ui_buffer_free(&buffer);
+  assert_true(parking_service_is_success(
+      parking_service_unsubscribe_changes(lot, subscription)));
+}
+
+/**
+ * @brief 测试非交互命令模式的脚本执行。
+ * @details
+ * 脚本中的注释与空行被跳过；每条命令输出一行以状态码开头的结果，
+ * 失败的命令不影响后续命令，只有修改停车场的命令才标记需要保存。
+ * @param state 包含由 `setup` 函数初始化的停车场对象的指针。
+ */
+static void test_cli_script(void **state) {
+  ParkingLot *lot = (ParkingLot *)*state;
+  FILE *script = tmpfile();
+  FILE *out = tmpfile();
+  char text[512];
+  int modified = 0;
+
+  assert_non_null(script);
+  assert_non_null(out);
+  fputs("# 批量维护\n"
+        "\n"
+        "add 1 A-01\n"
+        "add\t2  A-02\n"
+        "allocate 1 Wang JING-C789 13700000000 resident\n"
+        "find_plate JING-C789\n"
+        "allocate 2 Wang JING-D000 13700000000 nobody\n"
+        "bogus\n"
+        "stats\n",
+        script);
+  rewind(script);
+
+  assert_int_equal(parking_cli_run_script(lot, script, out, &modified), 2);
+  assert_int_equal(modified, 1);
+  rewind(out);
+
+  size_t length = fread(text, 1, sizeof(text) - 1, out);
+  text[length] = '\0';
+
+  /* 入场时间随当前时间变化，只比较它前后的内容 */
+  const char *head = "0\n0\n0\n"
+                     "0\t1\tA-01\toccupied\tresident\tWang\tJING-C789\t"
+                     "13700000000\t";
+  const char *tail = "\n-1\n-1\n0\t10\t1\t9\t0.00\t0.00\n";
+  assert_memory_equal(text, head, strlen(head));
+  assert_true(length > strlen(head) + strlen(tail));
+  assert_string_equal(text + length - strlen(tail), tail);
+
+  /* 只读命令不标记修改 */
+  char *args[] = {"stats"};
+  modified = 0;
+  fseek(out, 0, SEEK_END);
+  assert_int_equal(parking_cli_execute(lot, 1, args, out, &modified),
+                   PARKING_SERVICE_SUCCESS);
+  assert_int_equal(modified, 0);
+
+  fclose(script);
+  fclose(out);
+}
+
 /* ========================================================================== */
 /*                                 主测试函数                                 */
 /* ========================================================================== */
@@ -115,6 +275,11 @@ int main(void) {
   const struct CMUnitTest tests[] = {
       cmocka_unit_test_setup_teardown(test_ui_lifecycle, setup, teardown),
       cmocka_unit_test_setup_teardown(test_ui_add_slot_logic, setup, teardown),
+      cmocka_unit_test_setup_teardown(test_ui_buffer_slot_text, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_ui_dashboard_redraw, setup,
+                                      teardown),
+      cmocka_unit_test_setup_teardown(test_cli_script, setup, teardown),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);